@@ -9,17 +9,58 @@ namespace DetectVR
 {
     class Arduino
     {
+        // Setpoint frame understood by PWM.ino: start byte, target duty, slew, checksum
+        public const byte FrameStart = 0xA5;
+
+        // Speed frame understood by PWM.ino: start byte, speed (mm/s, little-endian), slew, checksum
+        public const byte SpeedFrameStart = 0xA6;
+
+        // Must match BAUD in PWM.ino
+        public const int BaudRate = 115200;
+
+        // Duty counts per 100 ms the belt ramps by when no slew is given
+        public const byte DefaultSlew = 10;
+
+        // mm/s per 100 ms the belt speed ramps by when no slew is given, about 0.5 m/s²
+        public const byte DefaultSpeedSlew = 50;
+
         public Arduino()
         {
             Port = new SerialPort();
-            Data = new byte[1];
-            Port.BaudRate = 9600;
+            Data = new byte[4];
+            SpeedData = new byte[5];
+            Port.BaudRate = BaudRate;
             Console.WriteLine("Write down the COM port that your arduino is connected to (space sensitive): ");
             Port.PortName = Console.ReadLine();
             Port.Open();
         }
 
+        // Sends a new target duty cycle; the firmware ramps to it on its own
+        public void SendSetpoint(byte target, byte slew = DefaultSlew)
+        {
+            Data[0] = FrameStart;
+            Data[1] = target;
+            Data[2] = slew;
+            Data[3] = (byte)(target ^ slew);
+            Port.Write(Data, 0, 4);
+        }
+
+        // Sends a target belt speed in mm/s, which the firmware holds from the belt encoder.
+        // slew is in mm/s per 100 ms.
+        public void SendSpeed(ushort millimetersPerSecond, byte slew = DefaultSpeedSlew)
+        {
+            byte low = (byte)(millimetersPerSecond & 0xFF);
+            byte high = (byte)(millimetersPerSecond >> 8);
+            SpeedData[0] = SpeedFrameStart;
+            SpeedData[1] = low;
+            SpeedData[2] = high;
+            SpeedData[3] = slew;
+            SpeedData[4] = (byte)(low ^ high ^ slew);
+            Port.Write(SpeedData, 0, 5);
+        }
+
         public SerialPort Port { get; set; }
         public byte[] Data { get; set; }
+        public byte[] SpeedData { get; set; }
     }
 }
@@ -0,0 +1,203 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO.Ports;
+using System.Linq;
+using System.Threading;
+
+namespace DetectVR
+{
+    // Host side of the Uduino echo benchmark (examples/EchoBenchmark on the board).
+    // Sweeps baud rate, frame size and command rate, and reports the round trip
+    // percentiles together with the time the board spent parsing and dispatching.
+    class ArduinoBenchmark
+    {
+        const byte FrameStart = 0xA5;
+        const byte PingId = 3;
+        const byte ProfileId = 4;
+        const byte EchoId = 0xFD;
+        const int EchoHeader = 13;
+        const int Samples = 200;
+
+        // Indices match UduinoProfile on the board
+        static readonly int[] Bauds = { 9600, 115200, 500000, 1000000 };
+        static readonly int[] MaxPayloads = { 32, 64, 127, 127 };
+        static readonly int[] FrameSizes = { 1, 8, 32, 100 };
+        static readonly int[] Rates = { 50, 200, 500 };
+
+        readonly SerialPort port;
+        readonly byte[] frame = new byte[260];
+        readonly List<byte> received = new List<byte>();
+
+        public ArduinoBenchmark(string portName)
+        {
+            port = new SerialPort(portName, Bauds[0]);
+            port.ReadTimeout = 1000;
+        }
+
+        public void Run()
+        {
+            port.Open();
+            Thread.Sleep(2000); // Most boards reset when the port opens
+
+            for (int profile = 0; profile < Bauds.Length; profile++)
+            {
+                if (!SwitchProfile(profile))
+                {
+                    Console.WriteLine(Bauds[profile] + " baud: board did not answer, stopping");
+                    break;
+                }
+
+                foreach (int size in FrameSizes)
+                {
+                    if (size + EchoHeader > MaxPayloads[profile])
+                        continue;
+
+                    foreach (int rate in Rates)
+                        Measure(Bauds[profile], size, rate);
+                }
+            }
+
+            SwitchProfile(0);
+            port.Close();
+        }
+
+        // The board acknowledges at the current speed, then changes 20 ms later
+        bool SwitchProfile(int profile)
+        {
+            if (port.BaudRate != Bauds[profile])
+            {
+                SendFrame(ProfileId, new byte[] { (byte)profile }, 1);
+                ReadEcho();
+                Thread.Sleep(50);
+                port.BaudRate = Bauds[profile];
+                port.DiscardInBuffer();
+                received.Clear();
+            }
+
+            SendFrame(PingId, new byte[1], 1);
+            return ReadEcho() != null;
+        }
+
+        void Measure(int baud, int size, int rate)
+        {
+            byte[] payload = new byte[size];
+            double[] roundTrips = new double[Samples];
+            double parse = 0, dispatch = 0;
+            int replies = 0;
+            double period = 1000.0 / rate;
+            Stopwatch clock = Stopwatch.StartNew();
+
+            for (int i = 0; i < Samples; i++)
+            {
+                // Pace the requests, but never keep more than one in flight
+                while (clock.Elapsed.TotalMilliseconds < i * period) { }
+
+                payload[0] = (byte)i;
+                double sent = clock.Elapsed.TotalMilliseconds;
+                SendFrame(PingId, payload, size);
+                byte[] echo = ReadEcho();
+                if (echo == null || echo[EchoHeader] != payload[0])
+                {
+                    roundTrips[i] = double.NaN;
+                    continue;
+                }
+
+                roundTrips[i] = clock.Elapsed.TotalMilliseconds - sent;
+                uint receivedAt = BitConverter.ToUInt32(echo, 1);
+                uint parsedAt = BitConverter.ToUInt32(echo, 5);
+                uint dispatchedAt = BitConverter.ToUInt32(echo, 9);
+                parse += unchecked(parsedAt - receivedAt);
+                dispatch += unchecked(dispatchedAt - parsedAt);
+                replies++;
+            }
+
+            double[] sorted = roundTrips.Where(t => !double.IsNaN(t)).OrderBy(t => t).ToArray();
+            if (sorted.Length == 0)
+            {
+                Console.WriteLine(string.Format("{0,7} baud {1,3} B {2,3} Hz: no reply", baud, size, rate));
+                return;
+            }
+
+            Console.WriteLine(string.Format(
+                "{0,7} baud {1,3} B {2,3} Hz: p50 {3,7:F2} ms  p99 {4,7:F2} ms  board parse {5,6:F0} us  dispatch {6,6:F0} us  {7}/{8} ok",
+                baud, size, rate, Percentile(sorted, 0.50), Percentile(sorted, 0.99),
+                parse / replies, dispatch / replies, replies, Samples));
+        }
+
+        static double Percentile(double[] sorted, double p)
+        {
+            int index = (int)Math.Ceiling(p * sorted.Length) - 1;
+            return sorted[Math.Max(0, Math.Min(sorted.Length - 1, index))];
+        }
+
+        // START | LEN | ID | PAYLOAD | CHECKSUM, checksum is the XOR of LEN, ID and the payload
+        void SendFrame(byte id, byte[] payload, int length)
+        {
+            byte checksum = (byte)(length ^ id);
+            frame[0] = FrameStart;
+            frame[1] = (byte)length;
+            frame[2] = id;
+            for (int i = 0; i < length; i++)
+            {
+                frame[3 + i] = payload[i];
+                checksum ^= payload[i];
+            }
+            frame[3 + length] = checksum;
+            port.Write(frame, 0, length + 4);
+        }
+
+        // Returns the payload of the next echo frame, or null on timeout
+        byte[] ReadEcho()
+        {
+            Stopwatch timeout = Stopwatch.StartNew();
+            while (timeout.ElapsedMilliseconds < port.ReadTimeout)
+            {
+                int available = port.BytesToRead;
+                if (available == 0)
+                {
+                    Thread.SpinWait(100);
+                    continue;
+                }
+
+                byte[] chunk = new byte[available];
+                int read = port.Read(chunk, 0, available);
+                received.AddRange(chunk.Take(read));
+
+                byte[] payload = ParseEcho();
+                if (payload != null)
+                    return payload;
+            }
+            return null;
+        }
+
+        byte[] ParseEcho()
+        {
+            while (received.Count >= 4)
+            {
+                if (received[0] != FrameStart)
+                {
+                    received.RemoveAt(0);
+                    continue;
+                }
+
+                int length = received[1];
+                if (received.Count < length + 4)
+                    return null;
+
+                byte checksum = (byte)(length ^ received[2]);
+                for (int i = 0; i < length; i++)
+                    checksum ^= received[3 + i];
+
+                byte id = received[2];
+                byte[] payload = received.GetRange(3, length).ToArray();
+                bool valid = checksum == received[3 + length];
+                received.RemoveRange(0, valid ? length + 4 : 1);
+
+                if (valid && id == EchoId && length >= EchoHeader)
+                    return payload;
+            }
+            return null;
+        }
+    }
+}
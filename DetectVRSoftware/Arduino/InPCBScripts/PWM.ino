@@ -1,20 +1,145 @@
-byte Csharp;
+#include <avr/interrupt.h>
+#include <Uduino.h>
+
+// Setpoint frames sent by the host:
+//   Duty:  DUTY_START | target | slew | target ^ slew
+//          target is the duty cycle (0-255), slew the ramp rate in duty counts per 100 ms.
+//   Speed: SPEED_START | speedLo | speedHi | slew | speedLo ^ speedHi ^ slew
+//          speed is the belt speed in mm/s, held from the encoder by UduinoSpeedControl,
+//          slew the ramp rate in mm/s per 100 ms.
+// A slew of 0 jumps straight to the target. The last frame received picks the mode.
+#define DUTY_START 0xA5
+#define SPEED_START 0xA6
+#define TICK_HZ 1000
+#define CONTROL_HZ 50 // Speed loop rate, low enough that each update sees several encoder counts
+#define BAUD 115200 // Must match Arduino.BaudRate on the host
+
+// Encoder on the belt roller, channel A on an external interrupt pin.
+// COUNTS_PER_METER is rising edges per meter of belt: measure it for your treadmill.
+#define ENCODER_PIN 2
+#define COUNTS_PER_METER 400
+
 int Pin = 3;
 
+// Ramp state, 8.8 fixed point, shared with the timer interrupt
+volatile uint16_t duty = 0;
+volatile uint16_t target = 0;
+volatile uint16_t step = 0;
+volatile uint8_t written = 0;
+
+volatile bool closedLoop = false;
+volatile long encoderCount = 0;
+UduinoSpeedControl belt(CONTROL_HZ);
+
+byte frame[4];
+byte frameLength = 0;
+byte framePos = 0;
+byte frameStart = 0;
+
+void countEdge() {
+ encoderCount++;
+}
+
 void setup() {
- Serial.begin(9600);      // opens serial port, sets data rate to 9600 bps
+ Serial.begin(BAUD);      // opens serial port, sets data rate to BAUD bps
  pinMode(Pin, OUTPUT);
+ analogWrite(Pin, 0);
+
+ pinMode(ENCODER_PIN, INPUT_PULLUP);
+ attachInterrupt(digitalPinToInterrupt(ENCODER_PIN), countEdge, RISING);
+
+ // Timer1 in CTC mode, prescaler 64: 16 MHz / 64 / 250 = 1 kHz ramp tick
+ noInterrupts();
+ TCCR1A = 0;
+ TCCR1B = _BV(WGM12) | _BV(CS11) | _BV(CS10);
+ TCNT1 = 0;
+ OCR1A = (F_CPU / 64 / TICK_HZ) - 1;
+ TIMSK1 |= _BV(OCIE1A);
+ interrupts();
+}
+
+void writeDuty(uint8_t out) {
+ if (out != written) {
+   written = out;
+   analogWrite(Pin, out);
+ }
+}
+
+// Open loop, moves the duty cycle one step towards the target. Closed loop, writes what the
+// speed controller gives every TICK_HZ / CONTROL_HZ ticks. Either only touches the pin when
+// the integer duty actually changes.
+ISR(TIMER1_COMPA_vect) {
+ static uint8_t controlTicks = 0;
+
+ // The controller also runs open loop, stopped, so it knows the belt's speed on a switch
+ if (++controlTicks >= TICK_HZ / CONTROL_HZ) {
+   controlTicks = 0;
+   uint8_t out = belt.update(encoderCount);
+   if (closedLoop) writeDuty(out);
+ }
+ if (closedLoop) return;
+
+ uint16_t d = duty;
+ if (d < target) {
+   d = (target - d > step) ? d + step : target;
+ } else if (d > target) {
+   d = (d - target > step) ? d - step : target;
+ }
+ duty = d;
+
+ writeDuty(d >> 8);
+}
+
+void setSetpoint(byte targetDuty, byte slew) {
+ // slew counts per 100 ms -> 8.8 increment per tick
+ uint16_t increment = slew == 0 ? 0xFFFF : (uint16_t)(((uint32_t)slew << 8) * 10 / TICK_HZ);
+ if (increment == 0) increment = 1;
+
+ noInterrupts();
+ if (closedLoop) {
+   // Ramp on from wherever the speed loop left the belt
+   duty = (uint16_t)belt.getDuty() << 8;
+   closedLoop = false;
+ }
+ target = (uint16_t)targetDuty << 8;
+ step = increment;
+ interrupts();
+
+ belt.stop();
+}
+
+void setSpeed(uint16_t speed, byte slew) {
+ // mm/s to encoder counts/s, and mm/s per 100 ms to counts/s per second
+ uint32_t counts = (uint32_t)speed * COUNTS_PER_METER / 1000;
+ uint32_t countsSlew = (uint32_t)slew * 10 * COUNTS_PER_METER / 1000;
+ if (slew != 0 && countsSlew == 0) countsSlew = 1;
+
+ belt.setTarget(counts > 0xFFFF ? 0xFFFF : (uint16_t)counts,
+                countsSlew > 0xFFFF ? 0xFFFF : (uint16_t)countsSlew);
+ closedLoop = true;
 }
 
 void loop() {
 
- if (Serial.available() > 0) {
-   
-   Csharp = Serial.read();
+ while (Serial.available() > 0) {
+   byte c = Serial.read();
 
-   Serial.println(Csharp,DEC);
- 
-   analogWrite(Pin, int(Csharp));
+   if (frameLength == 0) {
+     if (c == DUTY_START || c == SPEED_START) {
+       frameStart = c;
+       frameLength = c == DUTY_START ? 3 : 4;
+       framePos = 0;
+     }
+     continue;
+   }
 
+   frame[framePos++] = c;
+   if (framePos == frameLength) {
+     frameLength = 0;
+     if (frameStart == DUTY_START && (frame[0] ^ frame[1]) == frame[2])
+       setSetpoint(frame[0], frame[1]);
+     else if (frameStart == SPEED_START && (frame[0] ^ frame[1] ^ frame[2]) == frame[3])
+       setSpeed(frame[0] | ((uint16_t)frame[1] << 8), frame[2]);
+   }
  }
 }
@@ -20,31 +20,72 @@ Uduino * Uduino::_instance = NULL;
 // Constructor makes sure some things are set. 
 Uduino::Uduino(const char* identity)
 {
- Init(identity," ");
+ Init(identity," ",UDUINO_MODE_TEXT,UDUINO_PROFILE_9600);
 }
 
 Uduino::Uduino(const char* identity, const char* customDelimitier)
 {
- Init(identity, customDelimitier);  // strtok_r needs a null-terminated string
+ Init(identity, customDelimitier, UDUINO_MODE_TEXT, UDUINO_PROFILE_9600);
+}
+
+Uduino::Uduino(const char* identity, UduinoMode mode)
+{
+ Init(identity," ",mode,UDUINO_PROFILE_9600);
+}
+
+Uduino::Uduino(const char* identity, UduinoMode mode, UduinoProfile profile)
+{
+ Init(identity," ",mode,profile);
 }
 
 
-void Uduino::Init(const char* identity, const char* customDelimitier)
+void Uduino::Init(const char* identity, const char* customDelimitier, UduinoMode mode, UduinoProfile profile)
 {
   Uduino::_instance = this;
   init = false;
+  this->mode = mode;
+  #ifndef UDUINO_NATIVEUSB
+  if (profile == UDUINO_PROFILE_NATIVEUSB)
+    profile = UDUINO_PROFILE_1M;
+  #endif
+  this->profile = profile;
+  transport = getTransport(profile);
+  echoMode = false;
+  ackMode = false;
+  commandSequence = 0;
+  receivedAt = 0;
+  parsedAt = 0;
+  frameState = FRAME_START;
+  frameId = 0;
+  frameLength = 0;
+  frameChecksum = 0;
+  discardLine = false;
+  rxHead = 0;
+  rxTail = 0;
+  overflowCount = 0;
+  for (int i=0; i<UDUINO_MAXTASKS; i++)
+    tasks[i].function = NULL;
+  numChannels = 0;
+  telemetrySequence = 0;
+  telemetryTask = -1;
 
   #ifndef UDUINO_HARDWAREONLY
   usingSoftwareSerial=0;
   #endif
 
-  strncpy(delim,customDelimitier,MAXDELIMETER);  // strtok_r needs a null-terminated string
+  strncpy(delim,customDelimitier,MAXDELIMETER);
 
   //TODO !!!! Bundle pas par défault " ,"
 
-  strncpy(delimBundle," ,",MAXDELIMETER);  // strtok_r needs a null-terminated string
+  strncpy(delimBundle," ,",MAXDELIMETER);
   term='\r';   // return character, default terminator for commands
   numCommand=0;    // Number of callback handlers installed
+  progmemCommands = NULL;
+  numProgmemCommands = 0;
+  token = NULL;
+  numParameters = 0;
+  parameterCursor = 0;
+  parameterBase = buffer;
   clearBuffer(); 
 
   Uduino::_identity = (char*)identity;
@@ -62,11 +103,139 @@ Uduino::Uduino(SoftwareSerial &_SoftSer,char* identity)
 {
   usingSoftwareSerial=1; 
   SoftSerial = &_SoftSer;
-  Init(identity," ");
+  Init(identity," ",UDUINO_MODE_TEXT,UDUINO_PROFILE_9600);
 }
 #endif
 
 
+UduinoTransport Uduino::getTransport(UduinoProfile profile)
+{
+  UduinoTransport t;
+  switch (profile) {
+    case UDUINO_PROFILE_115200:   t.baud = 115200;  t.maxPayload = 64; break;
+    case UDUINO_PROFILE_500K:     t.baud = 500000;  t.maxPayload = UDUINO_FRAME_MAXPAYLOAD; break;
+    case UDUINO_PROFILE_1M:       t.baud = 1000000; t.maxPayload = UDUINO_FRAME_MAXPAYLOAD; break;
+    case UDUINO_PROFILE_2M:       t.baud = 2000000; t.maxPayload = UDUINO_FRAME_MAXPAYLOAD; break;
+    case UDUINO_PROFILE_NATIVEUSB: t.baud = 2000000; t.maxPayload = UDUINO_FRAME_MAXPAYLOAD; break;
+    default:                      t.baud = 9600;    t.maxPayload = 32; break;   // ~35 ms per full frame
+  }
+  if (t.maxPayload > UDUINO_FRAME_MAXPAYLOAD)
+    t.maxPayload = UDUINO_FRAME_MAXPAYLOAD;
+  return t;
+}
+
+UduinoProfile Uduino::getProfile()
+{
+  return profile;
+}
+
+void Uduino::setProfile(UduinoProfile profile)
+{
+  #ifndef UDUINO_NATIVEUSB
+  if (profile == UDUINO_PROFILE_NATIVEUSB)
+    profile = UDUINO_PROFILE_1M;
+  #endif
+  this->profile = profile;
+  transport = getTransport(profile);
+  Serial.flush();   // Let the reply sent at the previous speed go out first
+  Serial.end();
+  begin();
+}
+
+void Uduino::setEchoMode(bool enabled)
+{
+  echoMode = enabled;
+}
+
+// Replies to every command with its sequence number, see sendAck
+void Uduino::setAckMode(bool enabled)
+{
+  ackMode = enabled;
+}
+
+uint8_t Uduino::getSequence()
+{
+  return commandSequence;
+}
+
+void Uduino::sendAck(uint8_t id)
+{
+  if (mode == UDUINO_MODE_TEXT) {
+    Serial.print(F("uduinoAck "));
+    Serial.println(commandSequence);
+    return;
+  }
+
+  uint8_t payload[2] = { commandSequence, id };
+  sendFrame(UDUINO_ID_ACK, payload, 2);
+}
+
+// Answers straight from the parser, without the scheduler or UDUINO_INITDELAY: the reply is
+// already queued ahead of anything the init function prints
+void Uduino::discover(uint8_t nonce)
+{
+  if (mode == UDUINO_MODE_TEXT) {
+    Serial.print(F("uduinoIdentity "));
+    Serial.print(Uduino::_identity);
+    Serial.print(F(" "));
+    Serial.print(nonce);
+    Serial.print(F(" "));
+    Serial.println(commandSequence);
+  } else {
+    uint8_t payload[UDUINO_FRAME_MAXPAYLOAD];
+    uint8_t length = 0;
+    payload[length++] = nonce;
+    payload[length++] = commandSequence;
+    for (const char *c = Uduino::_identity; *c != '\0' && length < transport.maxPayload; c++)
+      payload[length++] = (uint8_t)*c;
+    sendFrame(UDUINO_ID_DISCOVER, payload, length);
+  }
+
+  init = true;
+  if (initFunctionPreset)
+    addTimeout(0, customInit);
+}
+
+// Called after the handler returned: sends the stage timestamps of the command with
+// its payload (binary) or its name (text), for the host to split the round trip.
+void Uduino::sendEcho(uint8_t id, unsigned long dispatchedAt)
+{
+  if (mode == UDUINO_MODE_TEXT) {
+    Serial.print(F("uduinoEcho "));
+    Serial.print(token);
+    Serial.print(F(" "));
+    Serial.print(receivedAt);
+    Serial.print(F(" "));
+    Serial.print(parsedAt);
+    Serial.print(F(" "));
+    Serial.println(dispatchedAt);
+    return;
+  }
+
+  uint8_t payload[UDUINO_FRAME_MAXPAYLOAD];
+  uint8_t length = 0;
+  unsigned long stages[3] = { receivedAt, parsedAt, dispatchedAt };
+  payload[length++] = id;
+  for (uint8_t i=0; i<3; i++) {
+    for (uint8_t b=0; b<4; b++)
+      payload[length++] = (uint8_t)(stages[i] >> (8 * b));
+  }
+  for (uint8_t i=0; i<frameLength && length < transport.maxPayload; i++)
+    payload[length++] = (uint8_t)buffer[i];
+  sendFrame(UDUINO_ID_ECHO, payload, length);
+}
+
+void Uduino::begin()
+{
+  Serial.begin(transport.baud);
+
+  #ifdef UDUINO_NATIVEUSB
+  // USB-CDC: give the host up to two seconds to open the port
+  unsigned long start = millis();
+  while (!Serial && millis() - start < 2000) {}
+  #endif
+}
+
 char * Uduino::getPrintedIdentity() {
   char* additionnal = (char*)"uduinoIdentity "; //TODO here use custom bundle
   char* full_text;
@@ -76,22 +245,28 @@ char * Uduino::getPrintedIdentity() {
   return full_text;
 }
 
+// The reply is deferred to the scheduler so that the handler returns immediately
 void Uduino::printIdentity() { 
+  Uduino::_instance->addTimeout(0, Uduino::sendIdentity);
+}
+
+void Uduino::sendIdentity() { 
+  char *identity = Uduino::_instance->getPrintedIdentity();
+  if (identity == NULL) return;
   if(Uduino::_instance->customPrint != nullptr) {
-    (*Uduino::_instance->customPrint)( Uduino::_instance->getPrintedIdentity());
+    (*Uduino::_instance->customPrint)(identity);
   } else {
     #ifdef UDUINO_DEBUG
       Serial.println(F("printing identity"));
     #endif
-    Serial.println ( Uduino::_instance->getPrintedIdentity());
+    Serial.println(identity);
   }
-    
-  delayMicroseconds(30000); // Give sme time before executing the action
+  free(identity);
 }
 
+// Runs the init function once the host had some time to process the identity
 void Uduino::launchInit() {
-  delayMicroseconds(30000); // Give sme time before executing the action
-  (*customInit)();
+  addTimeout(UDUINO_INITDELAY, customInit);
 } 
 
 void Uduino::arduinoDisconnected() { 
@@ -130,16 +305,16 @@ void Uduino::clearBuffer()
     buffer[i]='\0';
   }
   bufPos=0; 
+  numParameters=0;
+  parameterCursor=0;
 }
 
 // Retrieve the next token ("word" or "argument") from the Command buffer.  
 // returns a NULL if no more tokens exist.   
 char *Uduino::nextParameter() 
 {
-  char *nextToken;
- // nextToken = strtok_r(NULL, delim, &last); 
-  nextToken = strtok_r(NULL, delimBundle, &last); 
-  return nextToken; 
+  if (parameterCursor >= numParameters) return NULL;
+  return parameterBase + parameterOffsets[parameterCursor++]; 
 }
 
 char *Uduino::next() 
@@ -148,81 +323,162 @@ char *Uduino::next()
 }
 
 int Uduino::getNumberOfParameters() {
-  size_t count = 0;
-  size_t i = 0;
-
-  if(last == NULL) return count; 
-  for(i = 0; i != strlen(last); i++) {
-     if(last[i] == delim[0] || last[i] == delim[1])
-       count++;
-  }
-  return count + 1;
+  return numParameters;
 }
 
+// Returns the parameter at index, or an empty string if there is no such parameter.
+// The pointer stays valid until the next command is received.
 char* Uduino::getParameter(unsigned short index) 
 {
-  size_t len = strlen(last); 
-  char *lastCopy = new char[len+1];
-  strcpy(lastCopy, last); 
-  lastCopy[len] = '\0';   
+  if (index >= numParameters) return (char*)"";
+  return parameterBase + parameterOffsets[index];
+}
 
-  char *token = strtok(lastCopy, delim);
- // parameterBuffer = {0};
-  for (int i=0; i<20; i++) 
-  {
-    parameterBuffer[i]='\0';
+bool Uduino::isDelimiter(char c)
+{
+  for (int i=0; i<MAXDELIMETER; i++) {
+    if (c == delim[i] || c == delimBundle[i])
+      return c != '\0';
   }
- // char buffer[20];
+  return false;
+}
 
-  byte i=0;
-  while (token != NULL)
-  {
-    if(i == index) {
-      strcpy(parameterBuffer, token);
-      break;
+// Splits input in place: the command token and each parameter are null-terminated
+// and the parameter offsets are recorded, so accessing them later never copies.
+// Returns the command token, or NULL if the input only holds delimiters.
+char *Uduino::tokenizeCommand(char *input)
+{
+  numParameters = 0;
+  parameterCursor = 0;
+  parameterBase = input;
+  if (input == NULL) return NULL;
+
+  char *command = NULL;
+  char *c = input;
+  while (*c != '\0') {
+    if (isDelimiter(*c)) {
+      *c++ = '\0';
+      continue;
+    }
+    if (command == NULL) {
+      command = c;
+      parameterBase = c;
+    } else if (numParameters < UDUINO_MAXPARAMETERS) {
+      parameterOffsets[numParameters++] = (uint8_t)(c - parameterBase);
     }
-    token = strtok(NULL, delim);
-    i++;
+    while (*c != '\0' && !isDelimiter(*c)) c++;
   }
-  free(lastCopy);
- // parameterBuffer[strlen(token)]  = '\0';
-  return parameterBuffer;
+  return command;
 }
 
 // Launch a command
 void Uduino::launchCommand(char * command) {
   char * t = NULL;
 
-  t = strtok_r(command,delimBundle,&last);
+  t = tokenizeCommand(command);
 
   if (t == NULL) return; 
-    for (int i=0; i<numCommand; i++) {
-        #ifdef UDUINO_DEBUG
-        Serial.print(F("Comparing [")); 
-        Serial.print(token); 
-        Serial.print(F("] to ["));
-        Serial.print(CommandList[i].command);
-        Serial.println(F("]"));
-        #endif
+  int index = findCommand(t);
+  if (index != -1) {
+    #ifdef UDUINO_DEBUG
+    Serial.print(F("Matched Command: ")); 
+    Serial.println(t);
+    #endif
+    // Execute the stored handler function for the command
+    (*getCommandFunction(index))(); 
+  }
+}
 
-      if (strncmp(t,CommandList[i].command,UDUINOBUFFER) == 0) 
-      {
-        #ifdef UDUINO_DEBUG
-        Serial.print(F("Matched Command: ")); 
-        Serial.println(t);
-        #endif
-        // Execute the stored handler function for the command
-        (*CommandList[i].function)(); 
-        break; 
-      }
-    }
+int Uduino::findCommand(const char *command)
+{
+  int index = findRuntimeCommand(command);
+  if (index == -1)
+    index = findProgmemCommand(command);
+  return index;
+}
+
+// Binary search over the command names, kept sorted by addCommand()
+int Uduino::findRuntimeCommand(const char *command)
+{
+  int low = 0;
+  int high = numCommand - 1;
+  while (low <= high) {
+    int middle = (low + high) >> 1;
+    int index = sortedCommands[middle];
+    int cmp = strncmp(command, CommandList[index].command, COMMANDMAXNAME);
+    if (cmp == 0)
+      return index;
+    if (cmp < 0)
+      high = middle - 1;
+    else
+      low = middle + 1;
+  }
+  return -1;
+}
+
+// Binary search over the flash table, whose order is checked at compile time
+int Uduino::findProgmemCommand(const char *command)
+{
+  int low = 0;
+  int high = numProgmemCommands - 1;
+  while (low <= high) {
+    int middle = (low + high) >> 1;
+    const char *name = (const char *)pgm_read_ptr(&progmemCommands[middle].command);
+    int cmp = strcmp_P(command, name);
+    if (cmp == 0)
+      return UDUINO_ID_PROGMEM + middle;
+    if (cmp < 0)
+      high = middle - 1;
+    else
+      low = middle + 1;
+  }
+  return -1;
+}
+
+void (*Uduino::getCommandFunction(int index))()
+{
+  if (index >= UDUINO_ID_PROGMEM)
+    return (void (*)())pgm_read_ptr(&progmemCommands[index - UDUINO_ID_PROGMEM].function);
+  return CommandList[index].function;
+}
+
+void Uduino::setCommandTable(const UduinoProgmemCommand *table, uint8_t count)
+{
+  progmemCommands = table;
+  numProgmemCommands = table == NULL ? 0 : count;
+}
+
+// Runs the handler at index, then the custom hooks tied to the built-in commands
+void Uduino::dispatchCommand(int index)
+{
+  // Execute the stored handler function for the command
+  (*getCommandFunction(index))();
+  commandSequence++;
+  if (ackMode)
+    sendAck((uint8_t)index);
+
+  if(disconnectFunctionPreset && index == UDUINO_ID_DISCONNECTED) {
+    (*customDisconnected)();
+  }
+  else if(initFunctionPreset && index == UDUINO_ID_IDENTITY) {
+    launchInit();
+  }
 }
 
 void Uduino::update(char inputChar) 
 {
+  if (mode == UDUINO_MODE_BINARY) {
+    updateFrame((uint8_t)inputChar);
+    return;
+  }
+
     inChar = inputChar;
-    int i; 
-    boolean matched; 
+    int index; 
+
+  if (discardLine) {
+    if (inChar==term) discardLine = false;   // Resume with the next command
+    return;
+  }
 
   if (inChar==term) {     // Check for the terminator (default '\r') meaning end of command
       #ifdef UDUINO_DEBUG
@@ -230,77 +486,217 @@ void Uduino::update(char inputChar)
       Serial.println(buffer);
         #endif
       bufPos=0;           // Reset to start of buffer
-      token = strtok_r(buffer,delimBundle,&last);   // Search for command at start of buffer
+      token = tokenizeCommand(buffer);   // Search for command at start of buffer
       if (token == NULL) return; 
-      matched=false; 
-      for (i=0; i<numCommand; i++) {
+      if (strcmp(token, "uduinoDiscover") == 0) {
+        char *nonce = nextParameter();
+        discover(nonce != NULL ? (uint8_t)atoi(nonce) : 0);
+        clearBuffer();
+        return;
+      }
+      index = findCommand(token);
+      parsedAt = micros();
+      if (index != -1) {
         #ifdef UDUINO_DEBUG
-        Serial.print(F("Comparing [")); 
-        Serial.print(token); 
-        Serial.print(F("] to ["));
-        Serial.print(CommandList[i].command);
-        Serial.println(F("]"));
+        Serial.print(F("Matched Command: ")); 
+        Serial.println(token);
         #endif
-        // Compare the found command against the list of known commands for a match
-        if (strncmp(token,CommandList[i].command,UDUINOBUFFER) == 0) 
-        {
-          #ifdef UDUINO_DEBUG
-          Serial.print(F("Matched Command: ")); 
-          Serial.println(token);
-          #endif
-
-          // Execute the stored handler function for the command
-          (*CommandList[i].function)();
-
-          if(disconnectFunctionPreset &&  strcmp(token, "disconnected") == 0) {
-            (*customDisconnected)();
-          } 
-          else if(initFunctionPreset && strcmp(token, "identity") == 0 ) {
-           (*customInit)();
-          }
-          clearBuffer(); 
-          matched=true; 
-          break; 
-        }
-      }
-      if (matched==false) {
-        if(defaultFunctionPreset)
-          (*defaultHandler)(); 
-        clearBuffer(); 
+        dispatchCommand(index);
+      } else if(defaultFunctionPreset) {
+        (*defaultHandler)(); 
       }
+      if (echoMode)
+        sendEcho(0, micros());
+      clearBuffer(); 
     }
     if (isprint(inChar))   // Only printable characters into the buffer
     {
+      if (bufPos >= UDUINOBUFFER-1) {   // Command too long: drop it rather than wrapping into garbage
+        overflowCount++;
+        discardLine = true;
+        clearBuffer();
+        return;
+      }
+      if (bufPos == 0) receivedAt = micros();
       buffer[bufPos++]=inChar;   // Put character into buffer
       buffer[bufPos]='\0';  // Null terminate
-      if (bufPos > UDUINOBUFFER-1) bufPos=0; // wrap buffer around if full  
     }
 }
 
-// This checks the Serial stream for characters, and assembles them into a buffer.  
-// When the terminator character (default '\r') is seen, it starts parsing the 
-// buffer for a prefix command, and calls handlers setup by addCommand() member
-void Uduino::update() 
+// Binary mode: assembles START | LEN | ID | PAYLOAD | CHECKSUM frames byte by byte.
+// A frame with a bad checksum is dropped and the parser resynchronises on the next START byte.
+void Uduino::updateFrame(uint8_t inputByte)
+{
+  switch (frameState) {
+    case FRAME_START:
+      if (inputByte == UDUINO_FRAME_START) {
+        frameState = FRAME_LENGTH;
+        receivedAt = micros();
+      }
+      break;
+    case FRAME_LENGTH:
+      if (inputByte > transport.maxPayload) {
+        frameState = FRAME_START;
+        break;
+      }
+      frameLength = inputByte;
+      frameChecksum = inputByte;
+      frameState = FRAME_ID;
+      break;
+    case FRAME_ID:
+      frameId = inputByte;
+      frameChecksum ^= inputByte;
+      bufPos = 0;
+      frameState = frameLength > 0 ? FRAME_PAYLOAD : FRAME_CHECKSUM;
+      break;
+    case FRAME_PAYLOAD:
+      buffer[bufPos++] = (char)inputByte;
+      frameChecksum ^= inputByte;
+      if (bufPos >= frameLength)
+        frameState = FRAME_CHECKSUM;
+      break;
+    case FRAME_CHECKSUM:
+      frameState = FRAME_START;
+      if (inputByte == frameChecksum) {
+        buffer[bufPos] = '\0';
+        parsedAt = micros();
+        dispatchFrame();
+        if (echoMode)
+          sendEcho(frameId, micros());
+      }
+      #ifdef UDUINO_DEBUG
+      else {
+        Serial.println(F("Frame checksum mismatch"));
+      }
+      #endif
+      bufPos = 0;
+      break;
+  }
+}
+
+// Frame ids follow the order of addCommand(); the built-in identity, connected
+// and disconnected commands take ids 0, 1 and 2. Flash table entries start at
+// UDUINO_ID_PROGMEM.
+void Uduino::dispatchFrame()
+{
+  if (frameId == UDUINO_ID_DISCOVER) {
+    discover(frameLength > 0 ? (uint8_t)buffer[0] : 0);
+    return;
+  }
+
+  bool known = frameId < UDUINO_ID_PROGMEM ? frameId < numCommand : frameId - UDUINO_ID_PROGMEM < numProgmemCommands;
+  if (!known) {
+    if(defaultFunctionPreset)
+      (*defaultHandler)();
+    return;
+  }
+
+  dispatchCommand(frameId);
+}
+
+uint8_t *Uduino::getFrameData()
+{
+  return (uint8_t *)buffer;
+}
+
+uint8_t Uduino::getFrameLength()
+{
+  return frameLength;
+}
+
+UduinoMode Uduino::getMode()
+{
+  return mode;
+}
+
+void Uduino::sendFrame(uint8_t id, const uint8_t *data, uint8_t length)
+{
+  if (length > transport.maxPayload) return;
+
+  uint8_t checksum = length ^ id;
+  for (uint8_t i = 0; i < length; i++)
+    checksum ^= data[i];
+
+  Serial.write((uint8_t)UDUINO_FRAME_START);
+  Serial.write(length);
+  Serial.write(id);
+  if (length > 0)
+    Serial.write(data, length);
+  Serial.write(checksum);
+}
+
+// Pushes a received byte into the ring. Only the producer touches rxHead, so this
+// is safe to call from an interrupt while update() drains the ring in loop().
+bool Uduino::ingest(uint8_t inputByte)
 {
+  uint8_t head = rxHead;
+  uint8_t next = (uint8_t)((head + 1) & (UDUINO_RXRING - 1));
+  if (next == rxTail) {
+    overflowCount++;
+    return false;
+  }
+  rxRing[head] = inputByte;
+  rxHead = next;
+  return true;
+}
+
+// Moves what the serial driver holds into the ring, leaving the rest in the driver
+// once the ring is full. Call it from serialEvent() or from long running code so
+// that bytes are not lost while update() is not reached.
+void Uduino::ingest()
+{
+  while (((rxHead + 1) & (UDUINO_RXRING - 1)) != rxTail)
+  {
   // If we're using the Hardware port, check it.   Otherwise check the user-created SoftwareSerial Port
   #ifdef UDUINO_HARDWAREONLY
-  while (Serial.available() > 0) 
+    if (Serial.available() <= 0) break;
+    ingest((uint8_t)Serial.read());
   #else
-  while ((usingSoftwareSerial==0 && Serial.available() > 0) || (usingSoftwareSerial==1 && SoftSerial->available() > 0) )
+    if (usingSoftwareSerial==1) {
+      if (SoftSerial->available() <= 0) break;
+      ingest((uint8_t)SoftSerial->read());
+    } else {
+      if (Serial.available() <= 0) break;
+      ingest((uint8_t)Serial.read());
+    }
   #endif
+  }
+}
+
+uint16_t Uduino::getOverflowCount()
+{
+  return overflowCount;
+}
+
+// This checks the Serial stream for characters, and assembles them into a buffer.  
+// When the terminator character (default '\r') is seen, it starts parsing the 
+// buffer for a prefix command, and calls handlers setup by addCommand() member.
+// Never blocks: only the bytes already received are processed.
+void Uduino::update() 
+{
+  ingest();
+
+  // Snapshot the head so that bytes arriving meanwhile wait for the next call
+  uint8_t head = rxHead;
+  while (rxTail != head)
   {
-    #ifndef UDUINO_HARDWAREONLY
-    // SoftwareSerial port
-    //  inChar = ();   // Read single available character, there may be more waiting
-      update(SoftSerial->read());
-    #else 
-      update(Serial.read());
-    #endif
+    uint8_t tail = rxTail;
+    char c = (char)rxRing[tail];
+    rxTail = (uint8_t)((tail + 1) & (UDUINO_RXRING - 1));
+    update(c);
 
     #ifdef UDUINO_DEBUG
     Serial.print(inChar);   // Echo back to serial stream
     #endif
+
+    // Refill once the snapshot is drained, so bursts larger than the ring are handled in one call
+    if (rxTail == head) {
+      ingest();
+      head = rxHead;
+    }
   }
+
+  runTasks();
 }
 
 
@@ -318,29 +714,37 @@ void Uduino::readSerial(char inputChar) {
 // to the handler function to deal with it. 
 void Uduino::addCommand(const char *command, void (*function)())
 {
+  int existing = findRuntimeCommand(command);
+  if (existing != -1) {
+     #ifdef UDUINO_DEBUG
+      Serial.print(existing); 
+      Serial.print(F("-")); 
+      Serial.print(F("Command ")); 
+      Serial.print(command); 
+      Serial.println(F(" exists")); 
+     #endif
+      CommandList[existing].function = function; 
+      return;
+  }
+
   if (numCommand < UDUINO_MAXCOMMANDS) {
-    for (int i=0; i<numCommand; i++) {
-      if (strncmp(command,CommandList[i].command,UDUINOBUFFER) == 0) 
-      {
-         #ifdef UDUINO_DEBUG
-          Serial.print(i); 
-          Serial.print(F("-")); 
-          Serial.print(F("Command ")); 
-          Serial.print(command); 
-          Serial.println(F(" exists")); 
-         #endif
-          CommandList[i].function = function; 
-          return;
-      }
-    }
     #ifdef UDUINO_DEBUG
       Serial.print(numCommand); 
       Serial.print(F("-")); 
       Serial.print(F("Adding command for ")); 
       Serial.println(command); 
     #endif
-    strncpy(CommandList[numCommand].command,command,UDUINOBUFFER); 
+    strncpy(CommandList[numCommand].command,command,COMMANDMAXNAME-1); 
+    CommandList[numCommand].command[COMMANDMAXNAME-1] = '\0';
     CommandList[numCommand].function = function; 
+
+    // Insert the new index into the sorted table, shifting greater names up
+    int position = numCommand;
+    while (position > 0 && strncmp(command, CommandList[sortedCommands[position-1]].command, COMMANDMAXNAME) < 0) {
+      sortedCommands[position] = sortedCommands[position-1];
+      position--;
+    }
+    sortedCommands[position] = numCommand;
     numCommand++; 
   } else {
     // In this case, you tried to push more commands into the buffer than it is compiled to hold.  
@@ -387,9 +791,249 @@ int Uduino::charToInt(char * arg) {
 void Uduino::Empty() {}
 
 
+int8_t Uduino::scheduleTask(unsigned long delay, unsigned long period, void (*function)())
+{
+  if (function == NULL) return -1;
+  for (int8_t i=0; i<UDUINO_MAXTASKS; i++) {
+    if (tasks[i].function == NULL) {
+      tasks[i].function = function;
+      tasks[i].period = period;
+      tasks[i].due = millis() + delay;
+      return i;
+    }
+  }
+  #ifdef UDUINO_DEBUG
+  Serial.println(F("Too many tasks - recompile changing UDUINO_MAXTASKS")); 
+  #endif 
+  return -1;
+}
+
+int8_t Uduino::addTask(unsigned long period, void (*function)())
+{
+  return scheduleTask(period, period, function);
+}
+
+int8_t Uduino::addTimeout(unsigned long duration, void (*function)())
+{
+  return scheduleTask(duration, 0, function);
+}
+
+void Uduino::cancelTask(int8_t id)
+{
+  if (id >= 0 && id < UDUINO_MAXTASKS)
+    tasks[id].function = NULL;
+}
+
+// Calls every task that is due. The comparison is done on the difference so
+// that it keeps working when millis() wraps around.
+void Uduino::runTasks()
+{
+  unsigned long now = millis();
+  for (int8_t i=0; i<UDUINO_MAXTASKS; i++) {
+    void (*function)() = tasks[i].function;
+    if (function == NULL || (long)(now - tasks[i].due) < 0)
+      continue;
+    if (tasks[i].period == 0) {
+      tasks[i].function = NULL;   // Free the slot first, the function may schedule again
+    } else {
+      tasks[i].due += tasks[i].period;
+      if ((long)(now - tasks[i].due) >= 0)   // Fell behind: skip the missed runs
+        tasks[i].due = now + tasks[i].period;
+    }
+    (*function)();
+  }
+}
+
+int8_t Uduino::addTelemetryChannel(int16_t (*read)())
+{
+  if (read == NULL || numChannels >= UDUINO_MAXCHANNELS) return -1;
+  channels[numChannels] = read;
+  return numChannels++;
+}
+
+bool Uduino::startTelemetry(unsigned long period)
+{
+  stopTelemetry();
+  telemetryTask = addTask(period, Uduino::publishTelemetry);
+  return telemetryTask != -1;
+}
+
+void Uduino::stopTelemetry()
+{
+  cancelTask(telemetryTask);
+  telemetryTask = -1;
+}
+
+// Samples every channel and sends them together, so the host gets all values with one read
+void Uduino::publishTelemetry()
+{
+  Uduino *u = Uduino::_instance;
+  if (!Uduino::init || u->numChannels == 0) return;
+
+  uint8_t payload[1 + 2 * UDUINO_MAXCHANNELS];
+  uint8_t length = 0;
+  payload[length++] = u->telemetrySequence++;
+  for (uint8_t i=0; i<u->numChannels; i++) {
+    int16_t value = (*u->channels[i])();
+    payload[length++] = (uint8_t)(value & 0xFF);
+    payload[length++] = (uint8_t)((uint16_t)value >> 8);
+  }
+  u->sendFrame(UDUINO_ID_TELEMETRY, payload, length);
+}
+
 void Uduino::delay(unsigned int duration) {
    unsigned long time_now = millis();
-    while(millis() < time_now + duration){
+    while(millis() - time_now < duration){
           Uduino::update();
     }
-}
\ No newline at end of file
+}
+
+UduinoSpeedControl::UduinoSpeedControl(uint16_t rate)
+{
+  this->rate = rate ? rate : 1;
+  kp = 4;
+  ki = 16;
+  kd = 0;
+  maxDuty = 255;
+  stallDuty = 64;
+  finalTarget = 0;
+  slewStep = 0;
+  restart = false;
+  target = 0;
+  lastPosition = 0;
+  havePosition = false;
+  speed = 0;
+  lastSpeed = 0;
+  integral = 0;
+  stillUpdates = 0;
+  duty = 0;
+  stalled = false;
+}
+
+void UduinoSpeedControl::setGains(int16_t kp, int16_t ki, int16_t kd)
+{
+  noInterrupts();
+  this->kp = kp;
+  this->ki = ki;
+  this->kd = kd;
+  interrupts();
+}
+
+// A stallDuty of 0 disables the stall check
+void UduinoSpeedControl::setLimits(uint8_t maxDuty, uint8_t stallDuty)
+{
+  noInterrupts();
+  this->maxDuty = maxDuty;
+  this->stallDuty = stallDuty;
+  interrupts();
+}
+
+void UduinoSpeedControl::setTarget(uint16_t countsPerSecond, uint16_t slew)
+{
+  uint32_t step = slew == 0 ? 0 : ((uint32_t)slew << 8) / rate;
+  if (slew != 0 && step == 0) step = 1;
+  if (step > 0xFFFF) step = 0xFFFF;
+
+  noInterrupts();
+  finalTarget = countsPerSecond;
+  slewStep = (uint16_t)step;
+  restart = true;
+  interrupts();
+}
+
+void UduinoSpeedControl::stop()
+{
+  setTarget(0, 0);
+}
+
+uint8_t UduinoSpeedControl::update(long position)
+{
+  if (restart) {
+    restart = false;
+    stalled = false;
+    stillUpdates = 0;
+  }
+
+  // The belt only runs one way, so either encoder direction counts as motion
+  int32_t delta = havePosition ? (int32_t)(position - lastPosition) : 0;
+  if (delta < 0) delta = -delta;
+  lastPosition = position;
+  havePosition = true;
+
+  int32_t measured = delta * rate;
+  if (measured > 0xFFFF) measured = 0xFFFF;
+  speed += ((measured << 8) - speed) / 4;
+
+  // Ramp the target towards the last setpoint
+  uint32_t final = (uint32_t)finalTarget << 8;
+  uint16_t step = slewStep;
+  if (step == 0) {
+    target = final;
+  } else if (target < final) {
+    target = (final - target > step) ? target + step : final;
+  } else if (target > final) {
+    target = (target - final > step) ? target - step : final;
+  }
+
+  // Stopped, the ramp follows the belt, so that a new target ramps from where it is
+  if (final == 0 || stalled) {
+    target = speed;
+    integral = 0;
+    duty = 0;
+    lastSpeed = speed;
+    return 0;
+  }
+
+  // Errors are clamped so that each term fits in 30 bits and their sum can't overflow
+  int32_t error = (int32_t)(target >> 8) - (speed >> 8);
+  error = constrain(error, -16383, 16383);
+  int32_t derivative = -((speed - lastSpeed) * (int32_t)rate) / 256;
+  derivative = constrain(derivative, -16383, 16383);
+  lastSpeed = speed;
+
+  integral += ((int32_t)ki * error) / (int32_t)rate;
+  integral = constrain(integral, 0, (int32_t)maxDuty << 8);
+
+  int32_t output = (int32_t)kp * error + integral + (int32_t)kd * derivative;
+  output = constrain(output / 256, 0, (int32_t)maxDuty);
+  duty = (uint8_t)output;
+
+  // Driven hard with nothing moving: the encoder or the belt has failed
+  if (stallDuty != 0 && duty >= stallDuty && delta == 0) {
+    if (++stillUpdates >= rate) {
+      stalled = true;
+      integral = 0;
+      duty = 0;
+    }
+  } else {
+    stillUpdates = 0;
+  }
+
+  return duty;
+}
+
+uint16_t UduinoSpeedControl::getTarget()
+{
+  noInterrupts();
+  uint32_t t = target;
+  interrupts();
+  return (uint16_t)(t >> 8);
+}
+
+uint16_t UduinoSpeedControl::getSpeed()
+{
+  noInterrupts();
+  int32_t s = speed;
+  interrupts();
+  return (uint16_t)(s >> 8);
+}
+
+uint8_t UduinoSpeedControl::getDuty()
+{
+  return duty;
+}
+
+bool UduinoSpeedControl::isStalled()
+{
+  return stalled;
+}
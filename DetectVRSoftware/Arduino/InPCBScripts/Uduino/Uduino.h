@@ -42,16 +42,124 @@ Copyright (C) 2011-2013 Steven Cogswell  <steven.cogswell@gmail.com>
 #define UDUINOBUFFER 128 // Max length of bundle
 #define COMMANDMAXNAME 16 // Max length of a command
 
-#ifdef UDUINO_HARDWAREONLY
-#define UDUINO_MAXCOMMANDS 12
+#ifndef UDUINO_MAXCOMMANDS
+#define UDUINO_MAXCOMMANDS 12 // Commands added at runtime, 3 are built-in. Use a build flag (-D) to change it for the whole build
 #endif
 
 #define MAXDELIMETER 2
 
+// Boards with a native USB-CDC Serial (32u4, SAMD) receive much faster than a UART
+#if defined(USBCON) || defined(ARDUINO_ARCH_SAMD)
+#define UDUINO_NATIVEUSB 1
+#endif
+
+#ifndef UDUINO_RXRING
+#ifdef UDUINO_NATIVEUSB
+#define UDUINO_RXRING 128 // Size of the receive ring, must be a power of two no larger than 256
+#else
+#define UDUINO_RXRING 64 // Size of the receive ring, must be a power of two no larger than 256
+#endif
+#endif
+
+#ifndef UDUINO_MAXTASKS
+#define UDUINO_MAXTASKS 6 // Max number of periodic tasks and pending timeouts
+#endif
+
+#ifndef UDUINO_MAXCHANNELS
+#define UDUINO_MAXCHANNELS 8 // Max number of telemetry channels packed in one frame
+#endif
+
+#define UDUINO_INITDELAY 30 // Milliseconds between the identity reply and the init function
+
+#ifndef UDUINO_MAXPARAMETERS
+#define UDUINO_MAXPARAMETERS 16 // Max number of parameters indexed per command
+#endif
+
+// Binary frame layout: START | LEN | ID | PAYLOAD[LEN] | CHECKSUM
+// CHECKSUM is the XOR of LEN, ID and every payload byte.
+#define UDUINO_FRAME_START 0xA5
+#define UDUINO_FRAME_MAXPAYLOAD (UDUINOBUFFER - 1)
+
+// Ids of the built-in commands registered by Init()
+#define UDUINO_ID_IDENTITY 0
+#define UDUINO_ID_CONNECTED 1
+#define UDUINO_ID_DISCONNECTED 2
+
+// Commands of a PROGMEM table (setCommandTable) take ids from UDUINO_ID_PROGMEM, in table order
+#define UDUINO_ID_PROGMEM 0x80
+
+// Id of the frames published by the board: SEQUENCE | CHANNEL0 | CHANNEL1 ...
+// where every channel is a little-endian int16_t in registration order.
+#define UDUINO_ID_TELEMETRY 0xFE
+
+// Id of the replies sent in echo mode: ID | RECEIVED | PARSED | DISPATCHED | PAYLOAD
+// where the three stages are little-endian uint32_t micros() values, followed by as
+// much of the request payload as fits. Text commands get "uduinoEcho name r p d" lines.
+#define UDUINO_ID_ECHO 0xFD
+
+// Fast discovery, handled by the parser itself so it never shifts the command ids.
+// The host sends DISCOVER with a one byte NONCE (text: "uduinoDiscover nonce") and the
+// board answers at once with NONCE | SEQUENCE | IDENTITY (text: "uduinoIdentity name
+// nonce sequence"). It also counts as "connected", and runs the init function right away.
+#define UDUINO_ID_DISCOVER 0xFC
+
+// Id of the replies sent in ack mode: SEQUENCE | ID, once each command is dispatched.
+// SEQUENCE counts the commands the board has dispatched, wrapping at 256, so a host driving
+// several boards can tell each board's replies apart and spot a lost command.
+// Text commands get "uduinoAck sequence" lines.
+#define UDUINO_ID_ACK 0xFB
+
+// Transport profiles: serial speed and the largest frame worth sending at that speed.
+// UDUINO_PROFILE_NATIVEUSB falls back to UDUINO_PROFILE_1M on boards without USB-CDC.
+enum UduinoProfile {
+  UDUINO_PROFILE_9600,       // Default, what every Uduino host expects
+  UDUINO_PROFILE_115200,
+  UDUINO_PROFILE_500K,
+  UDUINO_PROFILE_1M,
+  UDUINO_PROFILE_2M,
+  UDUINO_PROFILE_NATIVEUSB,
+  UDUINO_PROFILE_COUNT
+};
+
+typedef struct _transport {
+  unsigned long baud;        // Ignored by USB-CDC, which always runs at USB speed
+  uint8_t maxPayload;        // Largest binary frame payload accepted and sent
+} UduinoTransport;
+
+enum UduinoMode {
+  UDUINO_MODE_TEXT,    // Terminated, delimited text commands (default)
+  UDUINO_MODE_BINARY   // Length-prefixed frames, dispatched by command id
+};
+
 #define UDUINO_DEBUG 1
 #undef UDUINO_DEBUG      // Comment for Debug Mode
 
 
+// Command stored in flash. Declare the names and the table with the macros below,
+// sorted by name, and pass the table to Uduino::setCommandTable():
+//
+//   UDUINO_COMMAND_NAME(offName, "off");
+//   UDUINO_COMMAND_NAME(turnLeftName, "turnLeft");
+//   UDUINO_COMMAND_TABLE(commands) = { { offName, disable }, { turnLeftName, turnLeft } };
+//   UDUINO_ASSERT_SORTED(commands);
+typedef struct _progmemCallback {
+  const char *command;           // Points to flash
+  void (*function)();
+} UduinoProgmemCommand;
+
+#define UDUINO_COMMAND_NAME(id, text) constexpr char id[] PROGMEM = text
+#define UDUINO_COMMAND_TABLE(table) constexpr UduinoProgmemCommand table[] PROGMEM
+#define UDUINO_TABLE_SIZE(table) (sizeof(table) / sizeof(table[0]))
+#define UDUINO_ASSERT_SORTED(table) static_assert(uduinoIsSorted(table, UDUINO_TABLE_SIZE(table)), #table " must be sorted by command name")
+
+// Compile time helpers behind UDUINO_ASSERT_SORTED, never evaluated at runtime
+constexpr int uduinoCompare(const char *a, const char *b) {
+  return (*a != *b || *a == '\0') ? (int)(unsigned char)*a - (int)(unsigned char)*b : uduinoCompare(a + 1, b + 1);
+}
+constexpr bool uduinoIsSorted(const UduinoProgmemCommand *table, unsigned int count, unsigned int i = 1) {
+  return i >= count || (uduinoCompare(table[i - 1].command, table[i].command) < 0 && uduinoIsSorted(table, count, i + 1));
+}
+
 class Uduino
 {
   public:
@@ -60,6 +168,16 @@ class Uduino
 
     Uduino(const char* identity);                             // Constructor
     Uduino(const char* identity, const char* customDelimitier );                             // Constructor
+    Uduino(const char* identity, UduinoMode mode);            // Constructor selecting the framing mode
+    Uduino(const char* identity, UduinoMode mode, UduinoProfile profile);   // Constructor selecting framing and transport
+
+    void begin();         // Opens the serial port with the transport profile, call it from setup()
+    static UduinoTransport getTransport(UduinoProfile profile);
+    UduinoProfile getProfile();
+    void setProfile(UduinoProfile profile);   // Switches the transport profile and reopens the port
+    void setEchoMode(bool enabled);   // Replies to every command with the micros() timestamps of its stages
+    void setAckMode(bool enabled);    // Replies to every command with its sequence number
+    uint8_t getSequence();            // Commands dispatched so far, wrapping at 256
   //  Uduino(const char* identity, const char* separator);      // Constructor
     #ifndef UDUINO_HARDWAREONLY
     Uduino(SoftwareSerial &SoftSer,char* identity);  // Constructor for using SoftwareSerial objects
@@ -71,26 +189,49 @@ class Uduino
     char *getParameter(unsigned short index);         // returns pointer to secific pointer index found in buffer (for getting arguments to commands)
     int getNumberOfParameters();
 
+   //Binary frames
+    uint8_t *getFrameData();         // returns pointer to the payload of the frame being dispatched
+    uint8_t getFrameLength();        // returns the payload length of the frame being dispatched
+    void sendFrame(uint8_t id, const uint8_t *data, uint8_t length);   // Writes a binary frame to the serial port
+    UduinoMode getMode();
+
    //Update and loop
     void update();    // Main entry point.  
     void update(char inputChar);    // Main entry point with input parametev
+    void ingest();    // Moves pending serial bytes into the receive ring, call from serialEvent() or blocking code
+    bool ingest(uint8_t inputByte);    // Pushes one byte into the receive ring, safe to call from an ISR
+    uint16_t getOverflowCount();    // Bytes dropped because the ring or the command buffer was full
     void readSerial();    // Main entry point with input parametev
     void readSerial(char inputChar);    // Main entry point with input parametev
    
    //Commands
     void addCommand(const char *, void(*)());   // Add commands to processing dictionary
+    void setCommandTable(const UduinoProgmemCommand *table, uint8_t count);   // Uses a sorted flash table, searched after the runtime commands
     void addDefaultHandler(void (*function)());    // A handler to call when no valid command received. 
     void addDisconnectedFunction(void (*function)());    // A handler to call when no valid command received. 
     void addInitFunction(void (*function)());    // A handler to call when no valid command received. 
     void addPrintFunction(void (*function)(char[]));    // A handler to call when no valid command received. 
     void launchCommand(char * command);
     
+    //Scheduler, run from update()
+    int8_t addTask(unsigned long period, void (*function)());    // Calls function every period ms, returns a task id or -1
+    int8_t addTimeout(unsigned long duration, void (*function)());    // Calls function once after duration ms, returns a task id or -1
+    void cancelTask(int8_t id);
+    void runTasks();    // Runs the tasks that are due, without waiting for the others
+
+    //Telemetry
+    int8_t addTelemetryChannel(int16_t (*read)());    // Adds a value to the telemetry frame, returns its channel index or -1
+    bool startTelemetry(unsigned long period);    // Publishes every channel in a single frame every period ms
+    void stopTelemetry();
+    static void publishTelemetry();
+
     //Helpers
     int charToInt(char * arg); //Converts char to int
-    void delay(unsigned int duration);    // Main entry point.  
+    void delay(unsigned int duration);    // Keeps receiving and running tasks for duration ms
 
     // Uduino specific commands
     static void printIdentity();   
+    static void sendIdentity();   
     static void arduinoFound(); 
     static void arduinoDisconnected();   
     bool isInit(); 
@@ -103,13 +244,40 @@ class Uduino
 
     char inChar;                     // A character read from the serial stream 
     char buffer[UDUINOBUFFER];       // Buffer of stored characters while waiting for terminator character
-    char parameterBuffer[20];        // Buffer of the parameter
     uint8_t  bufPos;                // Current position in the buffer
+    bool discardLine;                // Set when a text command overflowed the buffer, cleared on the next terminator
+
+    // Single producer (serialEvent/ISR), single consumer (update) receive ring
+    uint8_t rxRing[UDUINO_RXRING];
+    volatile uint8_t rxHead;         // Written by the producer only
+    volatile uint8_t rxTail;         // Written by the consumer only
+    volatile uint16_t overflowCount;
+
+    typedef struct _task {
+      void (*function)();
+      unsigned long period;          // 0 for a one-shot timeout
+      unsigned long due;             // millis() value of the next run
+    } UduinoTask;
+    UduinoTask tasks[UDUINO_MAXTASKS];   // Free slots have a NULL function
+    int8_t scheduleTask(unsigned long delay, unsigned long period, void (*function)());
+
+    // Telemetry
+    int16_t (*channels[UDUINO_MAXCHANNELS])();
+    uint8_t numChannels;
+    uint8_t telemetrySequence;       // Incremented per frame so the host can detect drops
+    int8_t telemetryTask;            // Scheduler slot of publishTelemetry, -1 when stopped
     char delim[MAXDELIMETER];        // null-terminated list of character to be used as delimeters for tokenizing (default " ")
     char delimBundle[MAXDELIMETER];  // null-terminated list of character to be used as delimeters for tokenizing (default " ")
     char term;                       // Character that signalsc end of command (default '\r')
-    char *token;                     // Returned token from the command buffer as returned by strtok_r
-    char *last;                      // State variable used by strtok_r during processing
+    char *token;                     // Command token found at the start of the command buffer
+
+    // Parameter index, built once per command by tokenizeCommand()
+    char *parameterBase;                            // Start of the parameters, in buffer or in the launched command
+    uint8_t parameterOffsets[UDUINO_MAXPARAMETERS]; // Offset of each null-terminated parameter from parameterBase
+    uint8_t numParameters;
+    uint8_t parameterCursor;                        // Next parameter returned by nextParameter()
+    bool isDelimiter(char c);
+    char *tokenizeCommand(char *input);
     
     typedef struct _callback {
       char command[COMMANDMAXNAME];
@@ -119,13 +287,46 @@ class Uduino
    // Commands
     int numCommand;
     UduinoCallback CommandList[UDUINO_MAXCOMMANDS];   // Actual definition for command/handler array
+    uint8_t sortedCommands[UDUINO_MAXCOMMANDS];       // Indices into CommandList, ordered by command name
+    int findCommand(const char *command);             // Runtime commands first, then the flash table. Returns -1 on a miss
+    int findRuntimeCommand(const char *command);      // Binary search of sortedCommands
+    int findProgmemCommand(const char *command);      // Binary search of progmemCommands
+    void (*getCommandFunction(int index))();
+    const UduinoProgmemCommand *progmemCommands;      // Flash table, may be NULL
+    uint8_t numProgmemCommands;
+    void dispatchCommand(int index);
     void (*defaultHandler)();           // Pointer to the default handler function 
     void (*customDisconnected)();           // Pointer to the default disconnected function 
     void (*customInit)();           // Pointer to the default init function 
     void (*customPrint)(char data[]);           // Pointer to the default init function 
     static void Empty();
 
-    void Init(const char* identity, const char* customDelimitier);
+    void Init(const char* identity, const char* customDelimitier, UduinoMode mode, UduinoProfile profile);
+
+    UduinoProfile profile;
+    UduinoTransport transport;
+
+    // Echo mode
+    bool echoMode;
+    unsigned long receivedAt;        // First byte of the command taken from the ring
+    unsigned long parsedAt;          // Command complete and looked up, just before its handler
+    void sendEcho(uint8_t id, unsigned long dispatchedAt);
+
+    // Discovery and ack mode
+    bool ackMode;
+    uint8_t commandSequence;
+    void discover(uint8_t nonce);
+    void sendAck(uint8_t id);
+
+    // Binary frame parser
+    enum FrameState { FRAME_START, FRAME_LENGTH, FRAME_ID, FRAME_PAYLOAD, FRAME_CHECKSUM };
+    void updateFrame(uint8_t inputByte);
+    void dispatchFrame();
+    UduinoMode mode;
+    FrameState frameState;
+    uint8_t frameId;
+    uint8_t frameLength;
+    uint8_t frameChecksum;
 
     bool defaultFunctionPreset = false;
     bool initFunctionPreset = false;
@@ -138,4 +339,59 @@ class Uduino
     #endif
 };
 
+// Closed-loop speed control of a PWM driven motor from an encoder position, e.g. an Encoder
+// library read() or a counter incremented by an attachInterrupt() handler. Call update() at a
+// fixed rate, typically from a timer interrupt, and write the duty it returns to the pin:
+//
+//   UduinoSpeedControl belt(50);             // update() is called 50 times a second
+//   belt.setTarget(1200, 600);               // 1200 counts/s, ramped at 600 counts/s per second
+//   ISR(TIMER1_COMPA_vect) { analogWrite(3, belt.update(encoderCount)); }
+//
+// Integer-only, so it is cheap enough for an ISR. Gains are in 1/256 duty per count/s of
+// error (kp), per count/s every second (ki) and per count/s per second (kd). The integral is
+// clamped to the duty range so it doesn't wind up while the motor is saturated, and the
+// derivative acts on the measured speed so a new target doesn't kick the output.
+//
+// A target of 0 stops the output at once. If the duty reaches the stall duty while the
+// encoder reports no motion for a second, the controller stops the output and reports
+// isStalled() until the next setTarget(), so a broken encoder can't run the motor flat out.
+class UduinoSpeedControl
+{
+  public:
+    UduinoSpeedControl(uint16_t rate);      // Calls to update() per second
+
+    void setGains(int16_t kp, int16_t ki, int16_t kd);
+    void setLimits(uint8_t maxDuty, uint8_t stallDuty);
+    void setTarget(uint16_t countsPerSecond, uint16_t slew);   // slew in counts/s per second, 0 to jump
+    void stop();
+
+    uint8_t update(long position);          // Returns the duty cycle to write
+    uint16_t getTarget();                   // Where the ramp currently is
+    uint16_t getSpeed();                    // Measured, counts/s
+    uint8_t getDuty();
+    bool isStalled();
+
+  private:
+    uint16_t rate;
+    int16_t kp, ki, kd;
+    uint8_t maxDuty;
+    uint8_t stallDuty;
+
+    // Written by setTarget() with interrupts disabled, read by update()
+    volatile uint16_t finalTarget;
+    volatile uint16_t slewStep;              // Counts/s the ramp moves per update, 8.8 fixed point
+    volatile bool restart;                   // Set by setTarget() and stop(), cleared by update()
+
+    // update() state
+    uint32_t target;                         // Ramped target, 8.8 fixed point
+    long lastPosition;
+    bool havePosition;
+    int32_t speed;                           // Filtered measured speed, 8.8 fixed point
+    int32_t lastSpeed;
+    int32_t integral;                        // Duty, 8.8 fixed point
+    uint16_t stillUpdates;                   // Consecutive updates at or above stallDuty without motion
+    uint8_t duty;
+    volatile bool stalled;
+};
+
 #endif //Uduino_h
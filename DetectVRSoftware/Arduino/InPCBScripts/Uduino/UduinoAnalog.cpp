@@ -0,0 +1,156 @@
+#include "UduinoAnalog.h"
+
+// In its own file so that ISR(ADC_vect) is only linked into sketches that use UduinoAnalog
+#if defined(__AVR__) && defined(ADCSRA)
+#include <avr/interrupt.h>
+#define UDUINO_ANALOG_SUPPORTED 1
+#endif
+
+#define UDUINO_ANALOG_RINGMASK (UDUINO_ANALOG_RING - 1)
+
+UduinoAnalog::UduinoAnalogChannel UduinoAnalog::channels[UDUINO_ANALOG_MAXCHANNELS];
+uint8_t UduinoAnalog::numChannels = 0;
+uint8_t UduinoAnalog::bits = 10;
+uint16_t UduinoAnalog::samplesPerValue = 1;
+uint8_t UduinoAnalog::converting = 0;
+uint8_t UduinoAnalog::selected = 0;
+volatile uint16_t UduinoAnalog::overflowCount = 0;
+
+bool UduinoAnalog::begin(const uint8_t *pins, uint8_t count, uint8_t prescaler, uint8_t oversampleBits)
+{
+#ifdef UDUINO_ANALOG_SUPPORTED
+  // 4^6 samples of 1023 still fit the 32 bit sum, and the 16 bit results
+  if (pins == NULL || count == 0 || count > UDUINO_ANALOG_MAXCHANNELS || oversampleBits > 6) return false;
+  end();
+
+  // ADPS selects a division of 2^ADPS, from 2 to 128
+  uint8_t adps = 1;
+  while ((1 << adps) < prescaler && adps < 7) adps++;
+
+  for (uint8_t i=0; i<count; i++) {
+    UduinoAnalogChannel &c = channels[i];
+    c.mux = pins[i] >= A0 ? pins[i] - A0 : pins[i];
+    c.sum = 0;
+    c.count = 0;
+    c.latest = 0;
+    c.head = 0;
+    c.tail = 0;
+  }
+  numChannels = count;
+  bits = 10 + oversampleBits;
+  samplesPerValue = 1 << (2 * oversampleBits);
+  overflowCount = 0;
+
+  // Free running: each conversion starts as the last completes, with the pin ADMUX selected
+  // by then. The first two both convert pins[0], then the interrupt moves ADMUX on a pin ahead.
+  noInterrupts();
+  converting = 0;
+  selected = 0;
+  selectChannel(0);
+  ADCSRB &= ~(_BV(ADTS2) | _BV(ADTS1) | _BV(ADTS0));
+  ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADIF) | adps;
+  ADCSRA |= _BV(ADSC);
+  interrupts();
+  return true;
+#else
+  return false;
+#endif
+}
+
+void UduinoAnalog::end()
+{
+#ifdef UDUINO_ANALOG_SUPPORTED
+  noInterrupts();
+  // Back to what analogRead() expects after init(): enabled, single conversions, F_CPU / 128
+  ADCSRA = _BV(ADEN) | _BV(ADIF) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  numChannels = 0;
+  interrupts();
+#endif
+}
+
+// AVcc reference, the same as analogRead() with the DEFAULT reference
+void UduinoAnalog::selectChannel(uint8_t index)
+{
+#ifdef UDUINO_ANALOG_SUPPORTED
+  uint8_t mux = channels[index].mux;
+  ADMUX = _BV(REFS0) | (mux & 0x07);
+#ifdef MUX5
+  ADCSRB = (ADCSRB & ~_BV(MUX5)) | ((mux & 0x08) ? _BV(MUX5) : 0);
+#endif
+#endif
+}
+
+void UduinoAnalog::onConversion(uint16_t sample)
+{
+  if (numChannels == 0) return;
+
+  UduinoAnalogChannel &c = channels[converting];
+  c.sum += sample;
+  if (++c.count >= samplesPerValue) {
+    uint16_t value = (uint16_t)(c.sum >> (bits - 10));
+    c.sum = 0;
+    c.count = 0;
+    c.latest = value;
+
+    uint8_t next = (c.head + 1) & UDUINO_ANALOG_RINGMASK;
+    if (next == c.tail) {
+      overflowCount++;
+    } else {
+      c.ring[c.head] = value;
+      c.head = next;
+    }
+  }
+
+  // The conversion now running started with the pin selected last time. ADMUX is buffered,
+  // so the pin selected here is the one after it, and it is written last so that at least
+  // one ADC clock has gone by since the conversion started.
+  converting = selected;
+  selected = (selected + 1 >= numChannels) ? 0 : selected + 1;
+  selectChannel(selected);
+}
+
+uint16_t UduinoAnalog::read(uint8_t index)
+{
+  if (index >= numChannels) return 0;
+  noInterrupts();
+  uint16_t value = channels[index].latest;
+  interrupts();
+  return value;
+}
+
+bool UduinoAnalog::pop(uint8_t index, uint16_t &value)
+{
+  if (index >= numChannels) return false;
+  UduinoAnalogChannel &c = channels[index];
+  uint8_t tail = c.tail;
+  if (tail == c.head) return false;
+  value = c.ring[tail];
+  c.tail = (tail + 1) & UDUINO_ANALOG_RINGMASK;
+  return true;
+}
+
+uint8_t UduinoAnalog::available(uint8_t index)
+{
+  if (index >= numChannels) return 0;
+  return (channels[index].head - channels[index].tail) & UDUINO_ANALOG_RINGMASK;
+}
+
+uint16_t UduinoAnalog::getOverflowCount()
+{
+  noInterrupts();
+  uint16_t count = overflowCount;
+  interrupts();
+  return count;
+}
+
+uint8_t UduinoAnalog::getBits()
+{
+  return bits;
+}
+
+#ifdef UDUINO_ANALOG_SUPPORTED
+ISR(ADC_vect)
+{
+  UduinoAnalog::onConversion(ADC);
+}
+#endif
@@ -0,0 +1,75 @@
+/*******************************************************************************
+Uduino - Uduino — Simple and robust Arduino-Unity communication
+Uduino - Copyright (C) 2016-2017 Marc Teyssier  <marc.teys@gmail.com>
+http://marcteyssier.com
+***********************************************************************************/
+#ifndef UduinoAnalog_h
+#define UduinoAnalog_h
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+#ifndef UDUINO_ANALOG_MAXCHANNELS
+#define UDUINO_ANALOG_MAXCHANNELS 4 // Max number of analog pins sampled
+#endif
+
+#ifndef UDUINO_ANALOG_RING
+#define UDUINO_ANALOG_RING 16 // Decimated samples kept per pin, must be a power of two no larger than 256
+#endif
+
+// Samples analog pins in the background with the ADC free running, instead of analogRead()
+// blocking for each conversion (about 100 us at the default prescaler of 128). Every
+// conversion raises the ADC interrupt, which adds the sample to its pin's accumulator and
+// selects the next pin. Once a pin has 4^oversampleBits samples the sum is decimated to a
+// (10 + oversampleBits) bit value, which is both kept as the pin's latest value and pushed
+// into its ring, so the host gets fewer, cleaner samples without polling for each one.
+//
+//   const uint8_t pins[] = { A0, A1 };
+//   UduinoAnalog::begin(pins, 2, 32, 2);     // ADC clock F_CPU / 32, 12 bit results
+//   int16_t readSensor() { return UduinoAnalog::read(0); }   // e.g. a telemetry channel
+//
+// Each pin gets an equal share of the conversions, at roughly F_CPU / prescaler / 13.
+// Full 10 bit accuracy needs an ADC clock of 50-200 kHz, which at 16 MHz is prescaler 128,
+// the analogRead() rate. 64 (250 kHz) doubles the rate for about 9 good bits, 32 about 8;
+// oversampling only makes up for that where the input carries some noise. AVR only, and
+// analogRead() must not be used on any pin between begin() and end().
+class UduinoAnalog
+{
+  public:
+    static bool begin(const uint8_t *pins, uint8_t count, uint8_t prescaler = 64, uint8_t oversampleBits = 2);
+    static void end();
+
+    static uint16_t read(uint8_t index);                  // Latest decimated value of pins[index]
+    static bool pop(uint8_t index, uint16_t &value);       // Oldest decimated value not yet popped
+    static uint8_t available(uint8_t index);
+    static uint16_t getOverflowCount();                    // Decimated values dropped with a ring full
+    static uint8_t getBits();                              // Bits in each decimated value
+
+    static void onConversion(uint16_t sample);             // Called by the ADC interrupt
+
+  private:
+    typedef struct _channel {
+      uint8_t mux;                   // ADC channel of the pin
+      uint32_t sum;                  // Accumulated samples of the current decimation
+      uint16_t count;
+      volatile uint16_t latest;
+      volatile uint16_t ring[UDUINO_ANALOG_RING]; // Volatile so reads stay between head and tail accesses
+      volatile uint8_t head;         // Written by the ISR only
+      volatile uint8_t tail;         // Written by pop() only
+    } UduinoAnalogChannel;
+
+    static void selectChannel(uint8_t index);
+
+    static UduinoAnalogChannel channels[UDUINO_ANALOG_MAXCHANNELS];
+    static uint8_t numChannels;
+    static uint8_t bits;
+    static uint16_t samplesPerValue;
+    static uint8_t converting;       // Index of the pin being converted when the interrupt fires
+    static uint8_t selected;         // Index of the pin ADMUX selects for the conversion after
+    static volatile uint16_t overflowCount;
+};
+
+#endif //UduinoAnalog_h
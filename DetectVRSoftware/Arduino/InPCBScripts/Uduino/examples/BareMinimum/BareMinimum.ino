@@ -26,6 +26,11 @@ void doSomething() {
   // ... do something with the values, or get other parameters
 }
 
+// Called between two loop() iterations: keeps receiving while your code is busy
+void serialEvent() {
+  uduino.ingest();
+}
+
 void loop()
 {
   uduino.update();
@@ -0,0 +1,39 @@
+// Uduino echo benchmark, board side
+// Every binary frame is answered with an UDUINO_ID_ECHO frame holding the micros()
+// timestamps of its receive, parse and dispatch stages. Pair it with the host
+// benchmark: XboxControllerReader.exe benchmark COM3
+#include<Uduino.h>
+Uduino uduino("echoBoard", UDUINO_MODE_BINARY); // Declare and name your object
+
+#define PING_ID 3     // First command after the built-in ones
+#define PROFILE_ID 4
+
+UduinoProfile nextProfile;
+
+void setup()
+{
+  uduino.begin();
+  uduino.addCommand("ping", Ping);
+  uduino.addCommand("profile", SetProfile);
+  uduino.setEchoMode(true);
+}
+
+void Ping() {
+  // Nothing to do, the echo reply carries the payload back
+}
+
+void SetProfile() {
+  if (uduino.getFrameLength() < 1 || uduino.getFrameData()[0] >= UDUINO_PROFILE_COUNT)
+    return;
+  nextProfile = (UduinoProfile)uduino.getFrameData()[0];
+  uduino.addTimeout(20, ApplyProfile); // The echo still goes out at the current speed
+}
+
+void ApplyProfile() {
+  uduino.setProfile(nextProfile);
+}
+
+void loop()
+{
+  uduino.update();
+}
@@ -0,0 +1,98 @@
+// Uduino transport benchmark
+// Measures the round trip of a binary frame for every transport profile.
+// Needs a board with a second hardware serial port (Mega, Leonardo, Micro...):
+// wire TX1 to RX1, open the Serial monitor at 115200 and read the report.
+#include<Uduino.h>
+
+#define RUNS 50
+
+const uint8_t frameSizes[] = { 1, 8, 32, UDUINO_FRAME_MAXPAYLOAD };
+uint8_t frame[UDUINO_FRAME_MAXPAYLOAD + 4];
+
+void setup()
+{
+  Serial.begin(115200);
+  while (!Serial) {}
+
+#ifndef HAVE_HWSERIAL1
+  Serial.println(F("This board has no Serial1 to loop back on"));
+#else
+  for (int p = UDUINO_PROFILE_9600; p < UDUINO_PROFILE_NATIVEUSB; p++) {
+    UduinoTransport transport = Uduino::getTransport((UduinoProfile)p);
+    Serial1.begin(transport.baud);
+
+    for (uint8_t s = 0; s < sizeof(frameSizes); s++) {
+      uint8_t payload = frameSizes[s];
+      if (payload > transport.maxPayload) continue;
+
+      unsigned long best = 0xFFFFFFFF, worst = 0, total = 0;
+      uint8_t received = 0;
+      for (int run = 0; run < RUNS; run++) {
+        received += measure(payload, best, worst, total) ? 1 : 0;
+      }
+      report(transport.baud, payload, received, best, worst, total);
+    }
+    Serial1.end();
+  }
+#endif
+  Serial.println(F("Done"));
+}
+
+#ifdef HAVE_HWSERIAL1
+// Sends one START | LEN | ID | PAYLOAD | CHECKSUM frame and waits for it to come back
+bool measure(uint8_t payload, unsigned long &best, unsigned long &worst, unsigned long &total)
+{
+  uint8_t length = payload + 4;
+  frame[0] = UDUINO_FRAME_START;
+  frame[1] = payload;
+  frame[2] = 0;
+  uint8_t checksum = payload;
+  for (uint8_t i = 0; i < payload; i++) {
+    frame[3 + i] = i;
+    checksum ^= i;
+  }
+  frame[3 + payload] = checksum;
+
+  while (Serial1.available() > 0) Serial1.read();
+
+  unsigned long start = micros();
+  Serial1.write(frame, length);
+  uint8_t count = 0;
+  while (count < length) {
+    if (micros() - start > 1000000UL) return false;   // Not wired, or bytes lost
+    if (Serial1.available() > 0 && Serial1.read() == frame[count]) count++;
+  }
+  unsigned long elapsed = micros() - start;
+
+  if (elapsed < best) best = elapsed;
+  if (elapsed > worst) worst = elapsed;
+  total += elapsed;
+  return true;
+}
+#endif
+
+void report(unsigned long baud, uint8_t payload, uint8_t received, unsigned long best, unsigned long worst, unsigned long total)
+{
+  Serial.print(baud);
+  Serial.print(F(" baud, "));
+  Serial.print(payload);
+  Serial.print(F(" bytes: "));
+  if (received == 0) {
+    Serial.println(F("no reply"));
+    return;
+  }
+  Serial.print(F("min "));
+  Serial.print(best);
+  Serial.print(F(" us, avg "));
+  Serial.print(total / received);
+  Serial.print(F(" us, max "));
+  Serial.print(worst);
+  Serial.print(F(" us, "));
+  Serial.print(received);
+  Serial.print(F("/"));
+  Serial.println(RUNS);
+}
+
+void loop()
+{
+}
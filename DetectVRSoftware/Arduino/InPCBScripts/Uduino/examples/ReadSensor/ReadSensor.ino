@@ -1,14 +1,20 @@
 #include<Uduino.h>
+#include<UduinoAnalog.h>
 Uduino uduino("myArduinoName"); // Declare and name your object
 
+// A0 is sampled in the background and averaged over 16 conversions into a 12 bit value
+// (0-4095), so the command below answers at once instead of waiting for the ADC.
+const uint8_t sensorPins[] = { A0 };
+
 void setup()
 {
   Serial.begin(9600);
+  UduinoAnalog::begin(sensorPins, 1, 64, 2); // ADC clock F_CPU / 64, 2 extra bits
   uduino.addCommand("mySensor", GetVariable); // Link your sensor reading (called "mySensor") to a function
 }
 
 void GetVariable() {
-  Serial.println(analogRead(A0));
+  Serial.println(UduinoAnalog::read(0));
 }
 void loop()
 {
@@ -1,11 +1,23 @@
 #include<Uduino.h>
 Uduino uduino("advancedBoard");
 
+void turnLeft();
+void disable();
+
+// The commands live in flash instead of SRAM. Keep the table sorted by name,
+// the build fails otherwise.
+UDUINO_COMMAND_NAME(offName, "off");
+UDUINO_COMMAND_NAME(turnLeftName, "turnLeft");
+UDUINO_COMMAND_TABLE(commands) = {
+  { offName, disable },
+  { turnLeftName, turnLeft }
+};
+UDUINO_ASSERT_SORTED(commands);
+
 void setup()
 {
   Serial.begin(9600);
-  uduino.addCommand("turnLeft", turnLeft);
-  uduino.addCommand("off", disable);
+  uduino.setCommandTable(commands, UDUINO_TABLE_SIZE(commands));
 }
 
 void turnLeft() {
@@ -0,0 +1,36 @@
+// Uduino telemetry
+// Publishes two channels in one UDUINO_ID_TELEMETRY frame every 5 ms. Telemetry frames are
+// binary, so the board runs in UDUINO_MODE_BINARY: in text mode they would be interleaved with
+// the text commands. The 9 byte frames at 200 Hz need about 1800 B/s, more than 9600 baud
+// carries, hence the 115200 profile; the host must open the port at the same speed.
+#include<Uduino.h>
+#include<UduinoAnalog.h>
+Uduino uduino("telemetryBoard", UDUINO_MODE_BINARY, UDUINO_PROFILE_115200); // Declare and name your object
+
+const uint8_t sensorPins[] = { A0 };
+
+// Sampled in the background, 12 bit, so reading it doesn't hold up the frame
+int16_t readSensor() {
+  return UduinoAnalog::read(0);
+}
+
+int16_t readButton() {
+  return digitalRead(12);
+}
+
+void setup()
+{
+  uduino.begin(); // Opens Serial at the profile's baud rate
+  pinMode(12, INPUT_PULLUP);
+  UduinoAnalog::begin(sensorPins, 1, 64, 2);
+
+  // Both values are sent together in one binary frame (id UDUINO_ID_TELEMETRY)
+  uduino.addTelemetryChannel(readSensor);
+  uduino.addTelemetryChannel(readButton);
+  uduino.startTelemetry(5); // Every 5 ms, 200 Hz
+}
+
+void loop()
+{
+  uduino.update(); // Also publishes the telemetry frames once connected
+}
@@ -0,0 +1,293 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO.Ports;
+using System.Linq;
+using System.Text;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace DetectVR
+{
+    // One Uduino board found by UduinoSession.Discover, in binary or text mode.
+    // Sequence follows the board's own count of dispatched commands, so with ack mode on
+    // (setAckMode on the board) every ack can be checked against the command it answers.
+    class UduinoBoard : IDisposable
+    {
+        public const byte FrameStart = 0xA5;
+        public const byte DiscoverId = 0xFC;
+        public const byte AckId = 0xFB;
+
+        public readonly string PortName;
+        public readonly SerialPort Port;
+        public string Identity { get; internal set; }
+        public bool Binary { get; internal set; }
+
+        // Commands the board had dispatched at its last reply; the next command is acked with Sequence + 1
+        public byte Sequence { get; private set; }
+
+        // Commands whose ack never came, or came out of order
+        public int LostCommands { get; private set; }
+
+        readonly byte[] frame = new byte[260];
+        readonly List<byte> received = new List<byte>();
+
+        internal UduinoBoard(SerialPort port)
+        {
+            PortName = port.PortName;
+            Port = port;
+        }
+
+        internal void SetSequence(byte sequence)
+        {
+            Sequence = sequence;
+        }
+
+        // START | LEN | ID | PAYLOAD | CHECKSUM, checksum is the XOR of LEN, ID and the payload
+        public void SendFrame(byte id, byte[] payload, int length)
+        {
+            byte checksum = (byte)(length ^ id);
+            frame[0] = FrameStart;
+            frame[1] = (byte)length;
+            frame[2] = id;
+            for (int i = 0; i < length; i++)
+            {
+                frame[3 + i] = payload[i];
+                checksum ^= payload[i];
+            }
+            frame[3 + length] = checksum;
+            Port.Write(frame, 0, length + 4);
+        }
+
+        // Sends a text command, e.g. "setSpeed 1100"
+        public void SendCommand(string command)
+        {
+            Port.Write(command + "\r");
+        }
+
+        // Waits for the ack of the oldest command not yet acked. An ack further on than
+        // expected means the commands in between were lost; they are counted and skipped.
+        public bool ReadAck(int timeoutMs)
+        {
+            Stopwatch timeout = Stopwatch.StartNew();
+            while (timeout.ElapsedMilliseconds < timeoutMs)
+            {
+                int ack = Binary ? ParseFrame(AckId, 1) : ParseLine("uduinoAck", 2);
+                if (ack >= 0)
+                {
+                    byte sequence = Binary ? received[0] : (byte)ack;
+                    if (Binary)
+                        received.RemoveRange(0, ack);
+
+                    // Acks carry the count after the command ran
+                    byte expected = unchecked((byte)(Sequence + 1));
+                    LostCommands += unchecked((byte)(sequence - expected));
+                    Sequence = sequence;
+                    return true;
+                }
+
+                if (!Fill(timeout, timeoutMs))
+                    break;
+            }
+
+            LostCommands++;
+            Sequence = unchecked((byte)(Sequence + 1));
+            return false;
+        }
+
+        // Reads what arrived into the receive buffer, false once the timeout has passed
+        internal bool Fill(Stopwatch timeout, int timeoutMs)
+        {
+            while (Port.BytesToRead == 0)
+            {
+                if (timeout.ElapsedMilliseconds >= timeoutMs)
+                    return false;
+                Thread.Sleep(1);
+            }
+
+            byte[] chunk = new byte[Port.BytesToRead];
+            int read = Port.Read(chunk, 0, chunk.Length);
+            received.AddRange(chunk.Take(read));
+            return true;
+        }
+
+        // Finds the next valid frame with the given id and at least minLength payload bytes.
+        // Everything before it is dropped and its payload moved to the front of the buffer;
+        // returns the payload length, or -1 if no complete frame is buffered yet.
+        internal int ParseFrame(byte id, int minLength)
+        {
+            int start = 0;
+            while (start + 4 <= received.Count)
+            {
+                if (received[start] != FrameStart)
+                {
+                    start++;
+                    continue;
+                }
+
+                int length = received[start + 1];
+                if (start + length + 4 > received.Count)
+                    return -1;
+
+                byte checksum = (byte)(length ^ received[start + 2]);
+                for (int i = 0; i < length; i++)
+                    checksum ^= received[start + 3 + i];
+
+                if (checksum == received[start + 3 + length] && received[start + 2] == id && length >= minLength)
+                {
+                    received.RemoveRange(0, start + 3);
+                    received.RemoveAt(length);
+                    return length;
+                }
+                start++;
+            }
+            return -1;
+        }
+
+        internal byte[] TakePayload(int length)
+        {
+            byte[] payload = received.GetRange(0, length).ToArray();
+            received.RemoveRange(0, length);
+            return payload;
+        }
+
+        // Finds the next "prefix arg..." line with at least the given number of words, and
+        // returns its last number. Lines before it are dropped; -1 if none is complete yet.
+        internal int ParseLine(string prefix, int words)
+        {
+            string[] parts = ReadLine(prefix, words);
+            int value;
+            return parts != null && int.TryParse(parts[parts.Length - 1], out value) ? value : -1;
+        }
+
+        internal string[] ReadLine(string prefix, int words)
+        {
+            while (true)
+            {
+                int end = received.IndexOf((byte)'\n');
+                if (end < 0)
+                    return null;
+
+                string line = Encoding.ASCII.GetString(received.GetRange(0, end).ToArray()).Trim();
+                received.RemoveRange(0, end + 1);
+
+                string[] parts = line.Split(new[] { ' ' }, StringSplitOptions.RemoveEmptyEntries);
+                if (parts.Length >= words && parts[0] == prefix)
+                    return parts;
+            }
+        }
+
+        public void Dispose()
+        {
+            Port.Close();
+        }
+    }
+
+    // Opens, identifies and drives several Uduino boards at once. Discovery sends a single
+    // identity query to every port in parallel and takes the board's immediate answer, instead
+    // of opening the ports one after another and waiting for the usual connection handshake.
+    class UduinoSession : IDisposable
+    {
+        public readonly List<UduinoBoard> Boards = new List<UduinoBoard>();
+
+        public static UduinoSession Discover(int baud, int timeoutMs = 500)
+        {
+            return Discover(SerialPort.GetPortNames(), baud, timeoutMs);
+        }
+
+        // Ports that don't answer within timeoutMs are closed again. DTR stays low so that boards
+        // which reset on it keep running; one that resets anyway must boot first, so give it a
+        // longer timeout.
+        public static UduinoSession Discover(IEnumerable<string> portNames, int baud, int timeoutMs = 500)
+        {
+            byte first = (byte)new Random().Next(256);
+            Task<UduinoBoard>[] probes = portNames
+                .Select((name, index) => Task.Run(() => Probe(name, baud, unchecked((byte)(first + index)), timeoutMs)))
+                .ToArray();
+            Task.WaitAll(probes);
+
+            UduinoSession session = new UduinoSession();
+            session.Boards.AddRange(probes.Select(p => p.Result).Where(b => b != null));
+            return session;
+        }
+
+        // The board answers in the mode it was built with, so both queries are sent: the binary
+        // frame, then a terminator in case a text board took the frame for the start of a command,
+        // then the text query. Each port gets its own nonce, so a stale or looped back reply
+        // can't be mistaken for an answer.
+        static UduinoBoard Probe(string portName, int baud, byte nonce, int timeoutMs)
+        {
+            SerialPort port = new SerialPort(portName, baud);
+            port.DtrEnable = false;
+            try
+            {
+                port.Open();
+                port.DiscardInBuffer();
+            }
+            catch (Exception)
+            {
+                port.Dispose();
+                return null;
+            }
+
+            UduinoBoard board = new UduinoBoard(port);
+            try
+            {
+                board.SendFrame(UduinoBoard.DiscoverId, new[] { nonce }, 1);
+                port.Write("\r");
+                board.SendCommand("uduinoDiscover " + nonce);
+
+                Stopwatch timeout = Stopwatch.StartNew();
+                do
+                {
+                    int length = board.ParseFrame(UduinoBoard.DiscoverId, 2);
+                    if (length >= 0)
+                    {
+                        byte[] payload = board.TakePayload(length);
+                        if (payload[0] == nonce)
+                        {
+                            board.Binary = true;
+                            board.Identity = Encoding.ASCII.GetString(payload, 2, length - 2);
+                            board.SetSequence(payload[1]);
+                            return board;
+                        }
+                        continue;
+                    }
+
+                    string[] reply = board.ReadLine("uduinoIdentity", 4);
+                    if (reply != null && reply[2] == nonce.ToString())
+                    {
+                        board.Binary = false;
+                        board.Identity = reply[1];
+                        board.SetSequence(byte.Parse(reply[3]));
+                        return board;
+                    }
+                } while (board.Fill(timeout, timeoutMs));
+            }
+            catch (Exception)
+            {
+            }
+
+            board.Dispose();
+            return null;
+        }
+
+        public UduinoBoard Find(string identity)
+        {
+            return Boards.FirstOrDefault(b => b.Identity == identity);
+        }
+
+        // Runs action on every board at once, each on its own task
+        public void ForEach(Action<UduinoBoard> action)
+        {
+            Task.WaitAll(Boards.Select(b => Task.Run(() => action(b))).ToArray());
+        }
+
+        public void Dispose()
+        {
+            foreach (UduinoBoard board in Boards)
+                board.Dispose();
+            Boards.Clear();
+        }
+    }
+}
@@ -12,8 +12,33 @@ namespace DetectVR
         public static Arduino arduino;
         public static PlayerProperties player = PlayerProperties.PlayerOne;
 
+        // Belt speeds in mm/s, held by the firmware's speed loop
+        public const ushort WalkSpeed = 1100;
+        public const ushort JogSpeed = 2200;
+
         static void Main(string[] args)
         {
+            // "benchmark COM3" measures the serial control path against examples/EchoBenchmark
+            if (args.Length >= 2 && args[0] == "benchmark")
+            {
+                new ArduinoBenchmark(args[1]).Run();
+                return;
+            }
+
+            // "discover" lists the Uduino boards on every serial port, "discover 115200" at another baud rate
+            if (args.Length >= 1 && args[0] == "discover")
+            {
+                int baud = args.Length >= 2 ? int.Parse(args[1]) : Arduino.BaudRate;
+                using (UduinoSession session = UduinoSession.Discover(baud))
+                {
+                    foreach (UduinoBoard board in session.Boards)
+                        Console.WriteLine(board.PortName + ": " + board.Identity + (board.Binary ? " (binary)" : " (text)"));
+                    if (session.Boards.Count == 0)
+                        Console.WriteLine("No Uduino board answered at " + baud + " baud");
+                }
+                return;
+            }
+
             while (true)
             {
                 if (controller.connected)
@@ -72,7 +97,7 @@ namespace DetectVR
         public static void SendCommandsToArduino()
         {
             float y = controller.leftThumb.y;
-            float voltage = 0f;
+            ushort speed = 0;
 
             if (arduino == null)
             {
@@ -81,42 +106,39 @@ namespace DetectVR
 
             if (y <= 40f && !player.IsNotMoving)
             {
-                arduino.Data[0] = Convert.ToByte(4);
-                arduino.Port.Write(arduino.Data, 0, 1);
-                voltage = 4f / 255f;
+                speed = 0;
+                arduino.SendSpeed(speed);
 
                 player.IsNotMoving = true;
                 player.IsWalking = false;
                 player.IsJogging = false;
                 player.IsSprinting = false;
 
-                Console.WriteLine(voltage + " volts sent to port." + arduino.Port.PortName);
+                Console.WriteLine(speed + " mm/s sent to port " + arduino.Port.PortName);
             }
             if (y < 70f && y > 40f && !player.IsWalking)
             {
-                arduino.Data[0] = Convert.ToByte(20);
-                arduino.Port.Write(arduino.Data, 0, 1);
-                voltage = 20f / 255f;
+                speed = WalkSpeed;
+                arduino.SendSpeed(speed);
 
                 player.IsNotMoving = false;
                 player.IsWalking = true;
                 player.IsJogging = false;
                 player.IsSprinting = false;
 
-                Console.WriteLine(voltage + " volts sent to port." + arduino.Port.PortName);
+                Console.WriteLine(speed + " mm/s sent to port " + arduino.Port.PortName);
             }
             if (y > 70f && !player.IsJogging)
             {
-                arduino.Data[0] = Convert.ToByte(50);
-                arduino.Port.Write(arduino.Data, 0, 1);
-                voltage = 50f / 255f;
+                speed = JogSpeed;
+                arduino.SendSpeed(speed);
 
                 player.IsNotMoving = false;
                 player.IsWalking = false;
                 player.IsJogging = true;
                 player.IsSprinting = false;
 
-                Console.WriteLine(voltage + " volts sent to port." + arduino.Port.PortName);
+                Console.WriteLine(speed + " mm/s sent to port " + arduino.Port.PortName);
             }
 
             // TODO Sprint
@@ -30,6 +30,18 @@
 #endif
 #endif
 
+// OVR_MATH_SSE2 and OVR_MATH_NEON select the SIMD versions of the hot float Matrix4 and Quat
+// functions. Define OVR_MATH_DISABLE_SIMD to use the scalar versions everywhere.
+#if !defined(OVR_MATH_DISABLE_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define OVR_MATH_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define OVR_MATH_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
 #if defined(_MSC_VER)
 #define OVRMath_sprintf sprintf_s
 #else
@@ -95,6 +107,21 @@
 #endif
 #endif
 
+//-------------------------------------------------------------------------------------
+// ***** OVR_MATH_CONSTEXPR
+//
+// Marks the constructors and simple operations of the vector, quaternion, matrix and pose
+// types, so that constants built from them are folded at compile time and need no dynamic
+// initialization. Only C++11 constexpr forms are used.
+
+#if !defined(OVR_MATH_CONSTEXPR)
+#if (defined(_MSC_VER) && (_MSC_VER >= 1900)) || (!defined(_MSC_VER) && (__cplusplus >= 201103L))
+#define OVR_MATH_CONSTEXPR constexpr
+#else
+#define OVR_MATH_CONSTEXPR
+#endif
+#endif
+
 namespace OVR {
 
 template <class T>
@@ -498,20 +525,20 @@ class Vector2 {
 
   T x, y;
 
-  Vector2() : x(0), y(0) {}
-  Vector2(T x_, T y_) : x(x_), y(y_) {}
-  explicit Vector2(T s) : x(s), y(s) {}
-  explicit Vector2(const Vector2<typename Math<T>::OtherFloatType>& src)
+  OVR_MATH_CONSTEXPR Vector2() : x(0), y(0) {}
+  OVR_MATH_CONSTEXPR Vector2(T x_, T y_) : x(x_), y(y_) {}
+  OVR_MATH_CONSTEXPR explicit Vector2(T s) : x(s), y(s) {}
+  OVR_MATH_CONSTEXPR explicit Vector2(const Vector2<typename Math<T>::OtherFloatType>& src)
       : x((T)src.x), y((T)src.y) {}
 
-  static Vector2 Zero() {
+  OVR_MATH_CONSTEXPR static Vector2 Zero() {
     return Vector2(0, 0);
   }
 
   // C-interop support.
   typedef typename CompatibleTypes<Vector2<T>>::Type CompatibleType;
 
-  Vector2(const CompatibleType& s) : x(s.x), y(s.y) {}
+  OVR_MATH_CONSTEXPR Vector2(const CompatibleType& s) : x(s.x), y(s.y) {}
 
   operator const CompatibleType&() const {
     OVR_MATH_STATIC_ASSERT(
@@ -519,14 +546,14 @@ class Vector2 {
     return reinterpret_cast<const CompatibleType&>(*this);
   }
 
-  bool operator==(const Vector2& b) const {
+  OVR_MATH_CONSTEXPR bool operator==(const Vector2& b) const {
     return x == b.x && y == b.y;
   }
-  bool operator!=(const Vector2& b) const {
+  OVR_MATH_CONSTEXPR bool operator!=(const Vector2& b) const {
     return x != b.x || y != b.y;
   }
 
-  Vector2 operator+(const Vector2& b) const {
+  OVR_MATH_CONSTEXPR Vector2 operator+(const Vector2& b) const {
     return Vector2(x + b.x, y + b.y);
   }
   Vector2& operator+=(const Vector2& b) {
@@ -534,7 +561,7 @@ class Vector2 {
     y += b.y;
     return *this;
   }
-  Vector2 operator-(const Vector2& b) const {
+  OVR_MATH_CONSTEXPR Vector2 operator-(const Vector2& b) const {
     return Vector2(x - b.x, y - b.y);
   }
   Vector2& operator-=(const Vector2& b) {
@@ -542,12 +569,12 @@ class Vector2 {
     y -= b.y;
     return *this;
   }
-  Vector2 operator-() const {
+  OVR_MATH_CONSTEXPR Vector2 operator-() const {
     return Vector2(-x, -y);
   }
 
   // Scalar multiplication/division scales vector.
-  Vector2 operator*(T s) const {
+  OVR_MATH_CONSTEXPR Vector2 operator*(T s) const {
     return Vector2(x * s, y * s);
   }
   Vector2& operator*=(T s) {
@@ -567,10 +594,10 @@ class Vector2 {
     return *this;
   }
 
-  static Vector2 Min(const Vector2& a, const Vector2& b) {
+  OVR_MATH_CONSTEXPR static Vector2 Min(const Vector2& a, const Vector2& b) {
     return Vector2((a.x < b.x) ? a.x : b.x, (a.y < b.y) ? a.y : b.y);
   }
-  static Vector2 Max(const Vector2& a, const Vector2& b) {
+  OVR_MATH_CONSTEXPR static Vector2 Max(const Vector2& a, const Vector2& b) {
     return Vector2((a.x > b.x) ? a.x : b.x, (a.y > b.y) ? a.y : b.y);
   }
 
@@ -602,12 +629,12 @@ class Vector2 {
   }
 
   // Entry-wise product of two vectors
-  Vector2 EntrywiseMultiply(const Vector2& b) const {
+  OVR_MATH_CONSTEXPR Vector2 EntrywiseMultiply(const Vector2& b) const {
     return Vector2(x * b.x, y * b.y);
   }
 
   // Multiply and divide operators do entry-wise math. Used Dot() for dot product.
-  Vector2 operator*(const Vector2& b) const {
+  OVR_MATH_CONSTEXPR Vector2 operator*(const Vector2& b) const {
     return Vector2(x * b.x, y * b.y);
   }
   Vector2 operator/(const Vector2& b) const {
@@ -617,7 +644,7 @@ class Vector2 {
   // Dot product
   // Used to calculate angle q between two vectors among other things,
   // as (A dot B) = |a||b|cos(q).
-  T Dot(const Vector2& b) const {
+  OVR_MATH_CONSTEXPR T Dot(const Vector2& b) const {
     return x * b.x + y * b.y;
   }
 
@@ -630,7 +657,7 @@ class Vector2 {
   }
 
   // Return Length of the vector squared.
-  T LengthSq() const {
+  OVR_MATH_CONSTEXPR T LengthSq() const {
     return (x * x + y * y);
   }
 
@@ -672,7 +699,7 @@ class Vector2 {
 
   // Linearly interpolates from this vector to another.
   // Factor should be between 0.0 and 1.0, with 0 giving full value to this.
-  Vector2 Lerp(const Vector2& b, T f) const {
+  OVR_MATH_CONSTEXPR Vector2 Lerp(const Vector2& b, T f) const {
     return *this * (T(1) - f) + b * f;
   }
 
@@ -716,20 +743,20 @@ class Vector3 {
   // FIXME: default initialization of a vector class can be very expensive in a full-blown
   // application.  A few hundred thousand vector constructions is not unlikely and can add
   // up to milliseconds of time on processors like the PS3 PPU.
-  Vector3() : x(0), y(0), z(0) {}
-  Vector3(T x_, T y_, T z_ = 0) : x(x_), y(y_), z(z_) {}
-  explicit Vector3(T s) : x(s), y(s), z(s) {}
-  explicit Vector3(const Vector3<typename Math<T>::OtherFloatType>& src)
+  OVR_MATH_CONSTEXPR Vector3() : x(0), y(0), z(0) {}
+  OVR_MATH_CONSTEXPR Vector3(T x_, T y_, T z_ = 0) : x(x_), y(y_), z(z_) {}
+  OVR_MATH_CONSTEXPR explicit Vector3(T s) : x(s), y(s), z(s) {}
+  OVR_MATH_CONSTEXPR explicit Vector3(const Vector3<typename Math<T>::OtherFloatType>& src)
       : x((T)src.x), y((T)src.y), z((T)src.z) {}
 
-  static Vector3 Zero() {
+  OVR_MATH_CONSTEXPR static Vector3 Zero() {
     return Vector3(0, 0, 0);
   }
 
   // C-interop support.
   typedef typename CompatibleTypes<Vector3<T>>::Type CompatibleType;
 
-  Vector3(const CompatibleType& s) : x(s.x), y(s.y), z(s.z) {}
+  OVR_MATH_CONSTEXPR Vector3(const CompatibleType& s) : x(s.x), y(s.y), z(s.z) {}
 
   operator const CompatibleType&() const {
     OVR_MATH_STATIC_ASSERT(
@@ -737,14 +764,14 @@ class Vector3 {
     return reinterpret_cast<const CompatibleType&>(*this);
   }
 
-  bool operator==(const Vector3& b) const {
+  OVR_MATH_CONSTEXPR bool operator==(const Vector3& b) const {
     return x == b.x && y == b.y && z == b.z;
   }
-  bool operator!=(const Vector3& b) const {
+  OVR_MATH_CONSTEXPR bool operator!=(const Vector3& b) const {
     return x != b.x || y != b.y || z != b.z;
   }
 
-  Vector3 operator+(const Vector3& b) const {
+  OVR_MATH_CONSTEXPR Vector3 operator+(const Vector3& b) const {
     return Vector3(x + b.x, y + b.y, z + b.z);
   }
   Vector3& operator+=(const Vector3& b) {
@@ -753,7 +780,7 @@ class Vector3 {
     z += b.z;
     return *this;
   }
-  Vector3 operator-(const Vector3& b) const {
+  OVR_MATH_CONSTEXPR Vector3 operator-(const Vector3& b) const {
     return Vector3(x - b.x, y - b.y, z - b.z);
   }
   Vector3& operator-=(const Vector3& b) {
@@ -762,12 +789,12 @@ class Vector3 {
     z -= b.z;
     return *this;
   }
-  Vector3 operator-() const {
+  OVR_MATH_CONSTEXPR Vector3 operator-() const {
     return Vector3(-x, -y, -z);
   }
 
   // Scalar multiplication/division scales vector.
-  Vector3 operator*(T s) const {
+  OVR_MATH_CONSTEXPR Vector3 operator*(T s) const {
     return Vector3(x * s, y * s, z * s);
   }
   Vector3& operator*=(T s) {
@@ -789,10 +816,10 @@ class Vector3 {
     return *this;
   }
 
-  static Vector3 Min(const Vector3& a, const Vector3& b) {
+  OVR_MATH_CONSTEXPR static Vector3 Min(const Vector3& a, const Vector3& b) {
     return Vector3((a.x < b.x) ? a.x : b.x, (a.y < b.y) ? a.y : b.y, (a.z < b.z) ? a.z : b.z);
   }
-  static Vector3 Max(const Vector3& a, const Vector3& b) {
+  OVR_MATH_CONSTEXPR static Vector3 Max(const Vector3& a, const Vector3& b) {
     return Vector3((a.x > b.x) ? a.x : b.x, (a.y > b.y) ? a.y : b.y, (a.z > b.z) ? a.z : b.z);
   }
 
@@ -825,12 +852,12 @@ class Vector3 {
   }
 
   // Entrywise product of two vectors
-  Vector3 EntrywiseMultiply(const Vector3& b) const {
+  OVR_MATH_CONSTEXPR Vector3 EntrywiseMultiply(const Vector3& b) const {
     return Vector3(x * b.x, y * b.y, z * b.z);
   }
 
   // Multiply and divide operators do entry-wise math
-  Vector3 operator*(const Vector3& b) const {
+  OVR_MATH_CONSTEXPR Vector3 operator*(const Vector3& b) const {
     return Vector3(x * b.x, y * b.y, z * b.z);
   }
 
@@ -841,14 +868,14 @@ class Vector3 {
   // Dot product
   // Used to calculate angle q between two vectors among other things,
   // as (A dot B) = |a||b|cos(q).
-  T Dot(const Vector3& b) const {
+  OVR_MATH_CONSTEXPR T Dot(const Vector3& b) const {
     return x * b.x + y * b.y + z * b.z;
   }
 
   // Compute cross product, which generates a normal vector.
   // Direction vector can be determined by right-hand rule: Pointing index finder in
   // direction a and middle finger in direction b, thumb will point in a.Cross(b).
-  Vector3 Cross(const Vector3& b) const {
+  OVR_MATH_CONSTEXPR Vector3 Cross(const Vector3& b) const {
     return Vector3(y * b.z - z * b.y, z * b.x - x * b.z, x * b.y - y * b.x);
   }
 
@@ -861,7 +888,7 @@ class Vector3 {
   }
 
   // Return Length of the vector squared.
-  T LengthSq() const {
+  OVR_MATH_CONSTEXPR T LengthSq() const {
     return (x * x + y * y + z * z);
   }
 
@@ -902,7 +929,7 @@ class Vector3 {
 
   // Linearly interpolates from this vector to another.
   // Factor should be between 0.0 and 1.0, with 0 giving full value to this.
-  Vector3 Lerp(const Vector3& b, T f) const {
+  OVR_MATH_CONSTEXPR Vector3 Lerp(const Vector3& b, T f) const {
     return *this * (T(1) - f) + b * f;
   }
 
@@ -957,21 +984,22 @@ class Vector4 {
   // FIXME: default initialization of a vector class can be very expensive in a full-blown
   // application.  A few hundred thousand vector constructions is not unlikely and can add
   // up to milliseconds of time on processors like the PS3 PPU.
-  Vector4() : x(0), y(0), z(0), w(0) {}
-  Vector4(T x_, T y_, T z_, T w_) : x(x_), y(y_), z(z_), w(w_) {}
-  explicit Vector4(T s) : x(s), y(s), z(s), w(s) {}
-  explicit Vector4(const Vector3<T>& v, const T w_ = T(1)) : x(v.x), y(v.y), z(v.z), w(w_) {}
-  explicit Vector4(const Vector4<typename Math<T>::OtherFloatType>& src)
+  OVR_MATH_CONSTEXPR Vector4() : x(0), y(0), z(0), w(0) {}
+  OVR_MATH_CONSTEXPR Vector4(T x_, T y_, T z_, T w_) : x(x_), y(y_), z(z_), w(w_) {}
+  OVR_MATH_CONSTEXPR explicit Vector4(T s) : x(s), y(s), z(s), w(s) {}
+  OVR_MATH_CONSTEXPR explicit Vector4(const Vector3<T>& v, const T w_ = T(1))
+      : x(v.x), y(v.y), z(v.z), w(w_) {}
+  OVR_MATH_CONSTEXPR explicit Vector4(const Vector4<typename Math<T>::OtherFloatType>& src)
       : x((T)src.x), y((T)src.y), z((T)src.z), w((T)src.w) {}
 
-  static Vector4 Zero() {
+  OVR_MATH_CONSTEXPR static Vector4 Zero() {
     return Vector4(0, 0, 0, 0);
   }
 
   // C-interop support.
   typedef typename CompatibleTypes<Vector4<T>>::Type CompatibleType;
 
-  Vector4(const CompatibleType& s) : x(s.x), y(s.y), z(s.z), w(s.w) {}
+  OVR_MATH_CONSTEXPR Vector4(const CompatibleType& s) : x(s.x), y(s.y), z(s.z), w(s.w) {}
 
   operator const CompatibleType&() const {
     OVR_MATH_STATIC_ASSERT(
@@ -986,14 +1014,14 @@ class Vector4 {
     w = 1;
     return *this;
   }
-  bool operator==(const Vector4& b) const {
+  OVR_MATH_CONSTEXPR bool operator==(const Vector4& b) const {
     return x == b.x && y == b.y && z == b.z && w == b.w;
   }
-  bool operator!=(const Vector4& b) const {
+  OVR_MATH_CONSTEXPR bool operator!=(const Vector4& b) const {
     return x != b.x || y != b.y || z != b.z || w != b.w;
   }
 
-  Vector4 operator+(const Vector4& b) const {
+  OVR_MATH_CONSTEXPR Vector4 operator+(const Vector4& b) const {
     return Vector4(x + b.x, y + b.y, z + b.z, w + b.w);
   }
   Vector4& operator+=(const Vector4& b) {
@@ -1003,7 +1031,7 @@ class Vector4 {
     w += b.w;
     return *this;
   }
-  Vector4 operator-(const Vector4& b) const {
+  OVR_MATH_CONSTEXPR Vector4 operator-(const Vector4& b) const {
     return Vector4(x - b.x, y - b.y, z - b.z, w - b.w);
   }
   Vector4& operator-=(const Vector4& b) {
@@ -1013,12 +1041,12 @@ class Vector4 {
     w -= b.w;
     return *this;
   }
-  Vector4 operator-() const {
+  OVR_MATH_CONSTEXPR Vector4 operator-() const {
     return Vector4(-x, -y, -z, -w);
   }
 
   // Scalar multiplication/division scales vector.
-  Vector4 operator*(T s) const {
+  OVR_MATH_CONSTEXPR Vector4 operator*(T s) const {
     return Vector4(x * s, y * s, z * s, w * s);
   }
   Vector4& operator*=(T s) {
@@ -1042,14 +1070,14 @@ class Vector4 {
     return *this;
   }
 
-  static Vector4 Min(const Vector4& a, const Vector4& b) {
+  OVR_MATH_CONSTEXPR static Vector4 Min(const Vector4& a, const Vector4& b) {
     return Vector4(
         (a.x < b.x) ? a.x : b.x,
         (a.y < b.y) ? a.y : b.y,
         (a.z < b.z) ? a.z : b.z,
         (a.w < b.w) ? a.w : b.w);
   }
-  static Vector4 Max(const Vector4& a, const Vector4& b) {
+  OVR_MATH_CONSTEXPR static Vector4 Max(const Vector4& a, const Vector4& b) {
     return Vector4(
         (a.x > b.x) ? a.x : b.x,
         (a.y > b.y) ? a.y : b.y,
@@ -1091,7 +1119,7 @@ class Vector4 {
   }
 
   // Multiply and divide operators do entry-wise math
-  Vector4 operator*(const Vector4& b) const {
+  OVR_MATH_CONSTEXPR Vector4 operator*(const Vector4& b) const {
     return Vector4(x * b.x, y * b.y, z * b.z, w * b.w);
   }
 
@@ -1100,12 +1128,12 @@ class Vector4 {
   }
 
   // Dot product
-  T Dot(const Vector4& b) const {
+  OVR_MATH_CONSTEXPR T Dot(const Vector4& b) const {
     return x * b.x + y * b.y + z * b.z + w * b.w;
   }
 
   // Return Length of the vector squared.
-  T LengthSq() const {
+  OVR_MATH_CONSTEXPR T LengthSq() const {
     return (x * x + y * y + z * z + w * w);
   }
 
@@ -1136,7 +1164,7 @@ class Vector4 {
 
   // Linearly interpolates from this vector to another.
   // Factor should be between 0.0 and 1.0, with 0 giving full value to this.
-  Vector4 Lerp(const Vector4& b, T f) const {
+  OVR_MATH_CONSTEXPR Vector4 Lerp(const Vector4& b, T f) const {
     return *this * (T(1) - f) + b * f;
   }
 };
@@ -1513,9 +1541,9 @@ class Quat {
   // x,y,z = axis*sin(angle), w = cos(angle)
   T x, y, z, w;
 
-  Quat() : x(0), y(0), z(0), w(1) {}
-  Quat(T x_, T y_, T z_, T w_) : x(x_), y(y_), z(z_), w(w_) {}
-  explicit Quat(const Quat<typename Math<T>::OtherFloatType>& src)
+  OVR_MATH_CONSTEXPR Quat() : x(0), y(0), z(0), w(1) {}
+  OVR_MATH_CONSTEXPR Quat(T x_, T y_, T z_, T w_) : x(x_), y(y_), z(z_), w(w_) {}
+  OVR_MATH_CONSTEXPR explicit Quat(const Quat<typename Math<T>::OtherFloatType>& src)
       : x((T)src.x), y((T)src.y), z((T)src.z), w((T)src.w) {
     // NOTE: Converting a normalized Quat<float> to Quat<double>
     // will generally result in an un-normalized quaternion.
@@ -1526,7 +1554,7 @@ class Quat {
   typedef typename CompatibleTypes<Quat<T>>::Type CompatibleType;
 
   // C-interop support.
-  Quat(const CompatibleType& s) : x(s.x), y(s.y), z(s.z), w(s.w) {}
+  OVR_MATH_CONSTEXPR Quat(const CompatibleType& s) : x(s.x), y(s.y), z(s.z), w(s.w) {}
 
   operator CompatibleType() const {
     CompatibleType result;
@@ -1570,11 +1598,11 @@ class Quat {
     z = v[2];
   }
 
-  Quat operator-() {
+  OVR_MATH_CONSTEXPR Quat operator-() const {
     return Quat(-x, -y, -z, -w);
   } // unary minus
 
-  static Quat Identity() {
+  OVR_MATH_CONSTEXPR static Quat Identity() {
     return Quat(0, 0, 0, 1);
   }
 
@@ -1786,14 +1814,14 @@ class Quat {
   }
   // MERGE_MOBILE_SDK
 
-  bool operator==(const Quat& b) const {
+  OVR_MATH_CONSTEXPR bool operator==(const Quat& b) const {
     return x == b.x && y == b.y && z == b.z && w == b.w;
   }
-  bool operator!=(const Quat& b) const {
+  OVR_MATH_CONSTEXPR bool operator!=(const Quat& b) const {
     return x != b.x || y != b.y || z != b.z || w != b.w;
   }
 
-  Quat operator+(const Quat& b) const {
+  OVR_MATH_CONSTEXPR Quat operator+(const Quat& b) const {
     return Quat(x + b.x, y + b.y, z + b.z, w + b.w);
   }
   Quat& operator+=(const Quat& b) {
@@ -1803,7 +1831,7 @@ class Quat {
     z += b.z;
     return *this;
   }
-  Quat operator-(const Quat& b) const {
+  OVR_MATH_CONSTEXPR Quat operator-(const Quat& b) const {
     return Quat(x - b.x, y - b.y, z - b.z, w - b.w);
   }
   Quat& operator-=(const Quat& b) {
@@ -1814,7 +1842,7 @@ class Quat {
     return *this;
   }
 
-  Quat operator*(T s) const {
+  OVR_MATH_CONSTEXPR Quat operator*(T s) const {
     return Quat(x * s, y * s, z * s, w * s);
   }
   Quat& operator*=(T s) {
@@ -1855,12 +1883,12 @@ class Quat {
     return Abs(Dot(b)) >= T(1) - tolerance;
   }
 
-  static T Abs(const T v) {
+  OVR_MATH_CONSTEXPR static T Abs(const T v) {
     return (v >= 0) ? v : -v;
   }
 
   // Get Imaginary part vector
-  Vector3<T> Imag() const {
+  OVR_MATH_CONSTEXPR Vector3<T> Imag() const {
     return Vector3<T>(x, y, z);
   }
 
@@ -1870,7 +1898,7 @@ class Quat {
   }
 
   // Get quaternion length squared.
-  T LengthSq() const {
+  OVR_MATH_CONSTEXPR T LengthSq() const {
     return (x * x + y * y + z * z + w * w);
   }
 
@@ -1887,7 +1915,7 @@ class Quat {
     return (d1 < d2) ? d1 : d2;
   }
 
-  T Dot(const Quat& q) const {
+  OVR_MATH_CONSTEXPR T Dot(const Quat& q) const {
     return x * q.x + y * q.y + z * q.z + w * q.w;
   }
 
@@ -1930,13 +1958,13 @@ class Quat {
   }
 
   // Returns conjugate of the quaternion. Produces inverse rotation if quaternion is normalized.
-  Quat Conj() const {
+  OVR_MATH_CONSTEXPR Quat Conj() const {
     return Quat(-x, -y, -z, w);
   }
 
   // Quaternion multiplication. Combines quaternion rotations, performing the one on the
   // right hand side first.
-  Quat operator*(const Quat& b) const {
+  OVR_MATH_CONSTEXPR Quat operator*(const Quat& b) const {
     return Quat(
         w * b.x + x * b.w + y * b.z - z * b.y,
         w * b.y - x * b.z + y * b.w + z * b.x,
@@ -2029,6 +2057,111 @@ class Quat {
     return (FastFromRotationVector(delta * s, false) * *this).Normalized();
   }
 
+  // Spherical linear interpolation by a polynomial in the cosine of the angle between the
+  // rotations, with no trigonometric functions and one square root (D. Eberly, "A Fast and
+  // Accurate Algorithm for Computing SLERP"). The series is truncated after terms terms, and the
+  // last term is scaled to minimize the maximum error. The largest error in any component of the
+  // float result compared with exact slerp, over all pairs of rotations, is:
+  //
+  //     terms   1       2       3       4       5       6       7       8
+  //     error   9.1e-3  3.0e-3  1.0e-3  3.7e-4  1.4e-4  5.4e-5  2.2e-5  8.8e-6
+  //     terms   9       10      11      12      13      14      15      16
+  //     error   3.6e-6  1.5e-6  6.7e-7  3.5e-7  2.2e-7  1.8e-7  1.8e-7  1.8e-7
+  //
+  // The error is largest when the rotations are 180 degrees apart, and falls quickly with the
+  // angle: for rotations within 20 degrees of each other, 3 terms are as accurate as float allows.
+  // PolySlerpTerms picks the number of terms for a tolerance. Like Slerp, the result follows the
+  // shorter path and is normalized.
+  static const int PolySlerpMaxTerms = 16;
+  static const int PolySlerpDefaultTerms = 8;
+
+  // Returns the fewest terms whose error above is within tolerance, or PolySlerpMaxTerms.
+  static int PolySlerpTerms(T tolerance) {
+    static const double MaxError[PolySlerpMaxTerms] = {9.1e-3,
+                                                       3.0e-3,
+                                                       1.0e-3,
+                                                       3.7e-4,
+                                                       1.4e-4,
+                                                       5.4e-5,
+                                                       2.2e-5,
+                                                       8.8e-6,
+                                                       3.6e-6,
+                                                       1.5e-6,
+                                                       6.7e-7,
+                                                       3.5e-7,
+                                                       2.2e-7,
+                                                       1.8e-7,
+                                                       1.8e-7,
+                                                       1.8e-7};
+    for (int terms = 1; terms < PolySlerpMaxTerms; ++terms) {
+      if (MaxError[terms - 1] <= tolerance)
+        return terms;
+    }
+    return PolySlerpMaxTerms;
+  }
+
+  // The coefficients of term i (1 based) of the PolySlerp series, where term i multiplies the
+  // sum of the later terms by (u * s * s - v) * (cosAngle - 1). The last term used is scaled by
+  // PolySlerpLastTermScale.
+  static void GetPolySlerpTerm(int i, T* u, T* v) {
+    static const T U[PolySlerpMaxTerms] = {
+        T(1.0 / 3),   T(1.0 / 10),  T(1.0 / 21),  T(1.0 / 36),  T(1.0 / 55),  T(1.0 / 78),
+        T(1.0 / 105), T(1.0 / 136), T(1.0 / 171), T(1.0 / 210), T(1.0 / 253), T(1.0 / 300),
+        T(1.0 / 351), T(1.0 / 406), T(1.0 / 465), T(1.0 / 528)};
+    static const T V[PolySlerpMaxTerms] = {
+        T(1.0 / 3),   T(2.0 / 5),   T(3.0 / 7),   T(4.0 / 9),   T(5.0 / 11),  T(6.0 / 13),
+        T(7.0 / 15),  T(8.0 / 17),  T(9.0 / 19),  T(10.0 / 21), T(11.0 / 23), T(12.0 / 25),
+        T(13.0 / 27), T(14.0 / 29), T(15.0 / 31), T(16.0 / 33)};
+    *u = U[i - 1];
+    *v = V[i - 1];
+  }
+
+  static T PolySlerpLastTermScale() {
+    return T(1.90110745351730037);
+  }
+
+  // Returns sin(s * angle) / sin(angle), for cosAngleMinus1 = cos(angle) - 1 and angle in
+  // [0, pi/2], by the PolySlerp series.
+  static T PolySlerpWeight(T cosAngleMinus1, T s, int terms) {
+    const T sqrS = s * s;
+    T u, v;
+    GetPolySlerpTerm(terms, &u, &v);
+    T sum = T(1) + (u * sqrS - v) * PolySlerpLastTermScale() * cosAngleMinus1;
+    for (int i = terms - 1; i >= 1; --i) {
+      GetPolySlerpTerm(i, &u, &v);
+      sum = T(1) + (u * sqrS - v) * cosAngleMinus1 * sum;
+    }
+    return s * sum;
+  }
+
+  Quat PolySlerp(const Quat& b, T s, int terms = PolySlerpDefaultTerms) const {
+    OVR_MATH_ASSERT((terms >= 1) && (terms <= PolySlerpMaxTerms));
+    T cosAngle = Dot(b);
+    T sign = T(1);
+    if (cosAngle < T(0)) {
+      cosAngle = -cosAngle;
+      sign = T(-1);
+    }
+
+    const T weightThis = PolySlerpWeight(cosAngle - T(1), T(1) - s, terms);
+    const T weightB = PolySlerpWeight(cosAngle - T(1), s, terms) * sign;
+    return (*this * weightThis + b * weightB).Normalized();
+  }
+
+  // PolySlerp of count pairs: out[i] = a[i].PolySlerp(b[i], s[i], terms). out may be a or b. The
+  // float version interpolates several pairs at a time with SIMD, and may differ from PolySlerp
+  // in the last bit.
+  static void PolySlerpBatch(
+      const Quat* a,
+      const Quat* b,
+      const T* s,
+      Quat* out,
+      size_t count,
+      int terms = PolySlerpDefaultTerms) {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = a[i].PolySlerp(b[i], s[i], terms);
+  }
+
   // MERGE_MOBILE_SDK
   // FIXME: This is opposite of Lerp for some reason.  It goes from 1 to 0 instead of 0 to 1.
   // Leaving it as a gift for future generations to deal with.
@@ -2078,6 +2211,13 @@ class Quat {
         v.z - w * uvz + x * uvy - y * uvx);
   }
 
+  // Rotates count vectors from in to out, which may be the same array. The float version
+  // rotates several vectors at a time with SIMD, with results identical to Rotate.
+  void RotateBatch(const Vector3<T>* in, Vector3<T>* out, size_t count) const {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = Rotate(in[i]);
+  }
+
   // Inversed quaternion rotates in the opposite direction.
   Quat Inverted() const {
     return Quat(-x, -y, -z, w);
@@ -2256,6 +2396,272 @@ class Quat {
   }
 };
 
+#if defined(OVR_MATH_SSE2)
+// Same operations in the same order as the scalar version, so results are identical.
+template <>
+inline Vector3<float> Quat<float>::Rotate(const Vector3<float>& v) const {
+  OVR_MATH_ASSERT(IsNormalized());
+
+  const __m128 q = _mm_loadu_ps(&x); // x y z w
+  const __m128 vv = _mm_setr_ps(v.x, v.y, v.z, 0.0f);
+  const __m128 qYZX = _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 0, 2, 1));
+  const __m128 qZXY = _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 1, 0, 2));
+  const __m128 qW = _mm_shuffle_ps(q, q, _MM_SHUFFLE(3, 3, 3, 3));
+
+  // uv = 2 * Imag().Cross(v);
+  const __m128 vZXY = _mm_shuffle_ps(vv, vv, _MM_SHUFFLE(3, 1, 0, 2));
+  const __m128 vYZX = _mm_shuffle_ps(vv, vv, _MM_SHUFFLE(3, 0, 2, 1));
+  const __m128 uv = _mm_mul_ps(
+      _mm_set1_ps(2.0f), _mm_sub_ps(_mm_mul_ps(qYZX, vZXY), _mm_mul_ps(qZXY, vYZX)));
+
+  // return v + Real()*uv + Imag().Cross(uv);
+  const __m128 uvZXY = _mm_shuffle_ps(uv, uv, _MM_SHUFFLE(3, 1, 0, 2));
+  const __m128 uvYZX = _mm_shuffle_ps(uv, uv, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 r = _mm_add_ps(vv, _mm_mul_ps(qW, uv));
+  r = _mm_add_ps(r, _mm_mul_ps(qYZX, uvZXY));
+  r = _mm_sub_ps(r, _mm_mul_ps(qZXY, uvYZX));
+
+  float out[4];
+  _mm_storeu_ps(out, r);
+  return Vector3<float>(out[0], out[1], out[2]);
+}
+#endif
+
+#if defined(OVR_MATH_SSE2) || defined(OVR_MATH_NEON)
+// Rotates count vectors by q, then adds translation if it isn't null, four vectors at a time
+// with the vectors' x, y and z in separate SIMD registers. The operations are those of
+// Quat<float>::Rotate, in the same order.
+inline void OVRMath_RotateBatch(
+    const Quat<float>& q,
+    const Vector3<float>* translation,
+    const Vector3<float>* in,
+    Vector3<float>* out,
+    size_t count) {
+  OVR_MATH_ASSERT(q.IsNormalized());
+  size_t i = 0;
+
+#if defined(OVR_MATH_SSE2)
+  typedef __m128 V;
+#define OVR_MATH_SPLAT(f) _mm_set1_ps(f)
+#define OVR_MATH_ADD(a, b) _mm_add_ps((a), (b))
+#define OVR_MATH_SUB(a, b) _mm_sub_ps((a), (b))
+#define OVR_MATH_MUL(a, b) _mm_mul_ps((a), (b))
+#else
+  typedef float32x4_t V;
+#define OVR_MATH_SPLAT(f) vdupq_n_f32(f)
+#define OVR_MATH_ADD(a, b) vaddq_f32((a), (b))
+#define OVR_MATH_SUB(a, b) vsubq_f32((a), (b))
+#define OVR_MATH_MUL(a, b) vmulq_f32((a), (b))
+#endif
+
+  const V qx = OVR_MATH_SPLAT(q.x), qy = OVR_MATH_SPLAT(q.y), qz = OVR_MATH_SPLAT(q.z);
+  const V qw = OVR_MATH_SPLAT(q.w), two = OVR_MATH_SPLAT(2.0f);
+
+  for (; i + 4 <= count; i += 4) {
+#if defined(OVR_MATH_SSE2)
+    const V vx = _mm_setr_ps(in[i].x, in[i + 1].x, in[i + 2].x, in[i + 3].x);
+    const V vy = _mm_setr_ps(in[i].y, in[i + 1].y, in[i + 2].y, in[i + 3].y);
+    const V vz = _mm_setr_ps(in[i].z, in[i + 1].z, in[i + 2].z, in[i + 3].z);
+#else
+    const float32x4x3_t vin = vld3q_f32(&in[i].x);
+    const V vx = vin.val[0], vy = vin.val[1], vz = vin.val[2];
+#endif
+
+    const V uvx = OVR_MATH_MUL(two, OVR_MATH_SUB(OVR_MATH_MUL(qy, vz), OVR_MATH_MUL(qz, vy)));
+    const V uvy = OVR_MATH_MUL(two, OVR_MATH_SUB(OVR_MATH_MUL(qz, vx), OVR_MATH_MUL(qx, vz)));
+    const V uvz = OVR_MATH_MUL(two, OVR_MATH_SUB(OVR_MATH_MUL(qx, vy), OVR_MATH_MUL(qy, vx)));
+
+    V rx = OVR_MATH_ADD(vx, OVR_MATH_MUL(qw, uvx));
+    V ry = OVR_MATH_ADD(vy, OVR_MATH_MUL(qw, uvy));
+    V rz = OVR_MATH_ADD(vz, OVR_MATH_MUL(qw, uvz));
+    rx = OVR_MATH_SUB(OVR_MATH_ADD(rx, OVR_MATH_MUL(qy, uvz)), OVR_MATH_MUL(qz, uvy));
+    ry = OVR_MATH_SUB(OVR_MATH_ADD(ry, OVR_MATH_MUL(qz, uvx)), OVR_MATH_MUL(qx, uvz));
+    rz = OVR_MATH_SUB(OVR_MATH_ADD(rz, OVR_MATH_MUL(qx, uvy)), OVR_MATH_MUL(qy, uvx));
+
+    if (translation) {
+      rx = OVR_MATH_ADD(rx, OVR_MATH_SPLAT(translation->x));
+      ry = OVR_MATH_ADD(ry, OVR_MATH_SPLAT(translation->y));
+      rz = OVR_MATH_ADD(rz, OVR_MATH_SPLAT(translation->z));
+    }
+
+#if defined(OVR_MATH_SSE2)
+    float x[4], y[4], z[4];
+    _mm_storeu_ps(x, rx);
+    _mm_storeu_ps(y, ry);
+    _mm_storeu_ps(z, rz);
+    for (int j = 0; j < 4; ++j)
+      out[i + j] = Vector3<float>(x[j], y[j], z[j]);
+#else
+    float32x4x3_t vout;
+    vout.val[0] = rx;
+    vout.val[1] = ry;
+    vout.val[2] = rz;
+    vst3q_f32(&out[i].x, vout);
+#endif
+  }
+
+#undef OVR_MATH_SPLAT
+#undef OVR_MATH_ADD
+#undef OVR_MATH_SUB
+#undef OVR_MATH_MUL
+
+  for (; i < count; ++i)
+    out[i] = translation ? (q.Rotate(in[i]) + *translation) : q.Rotate(in[i]);
+}
+
+template <>
+inline void
+Quat<float>::RotateBatch(const Vector3<float>* in, Vector3<float>* out, size_t count) const {
+  OVRMath_RotateBatch(*this, nullptr, in, out, count);
+}
+#endif
+
+// Four pairs at a time, with the quaternions' x, y, z and w in separate SIMD registers. vsqrtq
+// and vdivq need AArch64, so 32-bit ARM uses the scalar version.
+#if defined(OVR_MATH_SSE2) || \
+    (defined(OVR_MATH_NEON) && (defined(__aarch64__) || defined(_M_ARM64)))
+template <>
+inline void Quat<float>::PolySlerpBatch(
+    const Quat<float>* a,
+    const Quat<float>* b,
+    const float* s,
+    Quat<float>* out,
+    size_t count,
+    int terms) {
+  OVR_MATH_ASSERT((terms >= 1) && (terms <= PolySlerpMaxTerms));
+
+#if defined(OVR_MATH_SSE2)
+  typedef __m128 V;
+#define OVR_MATH_SPLAT(f) _mm_set1_ps(f)
+#define OVR_MATH_ADD(a, b) _mm_add_ps((a), (b))
+#define OVR_MATH_SUB(a, b) _mm_sub_ps((a), (b))
+#define OVR_MATH_MUL(a, b) _mm_mul_ps((a), (b))
+#define OVR_MATH_DIV(a, b) _mm_div_ps((a), (b))
+#else
+  typedef float32x4_t V;
+#define OVR_MATH_SPLAT(f) vdupq_n_f32(f)
+#define OVR_MATH_ADD(a, b) vaddq_f32((a), (b))
+#define OVR_MATH_SUB(a, b) vsubq_f32((a), (b))
+#define OVR_MATH_MUL(a, b) vmulq_f32((a), (b))
+#define OVR_MATH_DIV(a, b) vdivq_f32((a), (b))
+#endif
+
+  V u[PolySlerpMaxTerms], v[PolySlerpMaxTerms];
+  for (int t = 1; t <= terms; ++t) {
+    float uf, vf;
+    GetPolySlerpTerm(t, &uf, &vf);
+    if (t == terms) {
+      uf *= PolySlerpLastTermScale();
+      vf *= PolySlerpLastTermScale();
+    }
+    u[t - 1] = OVR_MATH_SPLAT(uf);
+    v[t - 1] = OVR_MATH_SPLAT(vf);
+  }
+
+  const V one = OVR_MATH_SPLAT(1.0f);
+  size_t i = 0;
+
+  for (; i + 4 <= count; i += 4) {
+#if defined(OVR_MATH_SSE2)
+    const V ax = _mm_setr_ps(a[i].x, a[i + 1].x, a[i + 2].x, a[i + 3].x);
+    const V ay = _mm_setr_ps(a[i].y, a[i + 1].y, a[i + 2].y, a[i + 3].y);
+    const V az = _mm_setr_ps(a[i].z, a[i + 1].z, a[i + 2].z, a[i + 3].z);
+    const V aw = _mm_setr_ps(a[i].w, a[i + 1].w, a[i + 2].w, a[i + 3].w);
+    const V bx = _mm_setr_ps(b[i].x, b[i + 1].x, b[i + 2].x, b[i + 3].x);
+    const V by = _mm_setr_ps(b[i].y, b[i + 1].y, b[i + 2].y, b[i + 3].y);
+    const V bz = _mm_setr_ps(b[i].z, b[i + 1].z, b[i + 2].z, b[i + 3].z);
+    const V bw = _mm_setr_ps(b[i].w, b[i + 1].w, b[i + 2].w, b[i + 3].w);
+    const V st = _mm_loadu_ps(s + i);
+#else
+    const float32x4x4_t va = vld4q_f32(&a[i].x);
+    const float32x4x4_t vb = vld4q_f32(&b[i].x);
+    const V ax = va.val[0], ay = va.val[1], az = va.val[2], aw = va.val[3];
+    const V bx = vb.val[0], by = vb.val[1], bz = vb.val[2], bw = vb.val[3];
+    const V st = vld1q_f32(s + i);
+#endif
+
+    V cosAngle = OVR_MATH_ADD(
+        OVR_MATH_ADD(OVR_MATH_MUL(ax, bx), OVR_MATH_MUL(ay, by)),
+        OVR_MATH_ADD(OVR_MATH_MUL(az, bz), OVR_MATH_MUL(aw, bw)));
+
+    // Take the shorter path: use |cosAngle|, and negate b's weight where cosAngle < 0.
+#if defined(OVR_MATH_SSE2)
+    const V signBit = _mm_and_ps(cosAngle, _mm_set1_ps(-0.0f));
+    cosAngle = _mm_xor_ps(cosAngle, signBit);
+#else
+    const uint32x4_t signBit =
+        vandq_u32(vreinterpretq_u32_f32(cosAngle), vdupq_n_u32(0x80000000u));
+    cosAngle = vabsq_f32(cosAngle);
+#endif
+
+    const V cosAngleMinus1 = OVR_MATH_SUB(cosAngle, one);
+    const V sa = OVR_MATH_SUB(one, st);
+    const V sqrA = OVR_MATH_MUL(sa, sa);
+    const V sqrB = OVR_MATH_MUL(st, st);
+
+    V sumA = one, sumB = one;
+    for (int t = terms - 1; t >= 0; --t) {
+      const V termA = OVR_MATH_MUL(OVR_MATH_SUB(OVR_MATH_MUL(u[t], sqrA), v[t]), cosAngleMinus1);
+      const V termB = OVR_MATH_MUL(OVR_MATH_SUB(OVR_MATH_MUL(u[t], sqrB), v[t]), cosAngleMinus1);
+      sumA = OVR_MATH_ADD(one, OVR_MATH_MUL(termA, sumA));
+      sumB = OVR_MATH_ADD(one, OVR_MATH_MUL(termB, sumB));
+    }
+
+    const V weightA = OVR_MATH_MUL(sa, sumA);
+#if defined(OVR_MATH_SSE2)
+    const V weightB = _mm_xor_ps(OVR_MATH_MUL(st, sumB), signBit);
+#else
+    const V weightB =
+        vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(OVR_MATH_MUL(st, sumB)), signBit));
+#endif
+
+    V rx = OVR_MATH_ADD(OVR_MATH_MUL(ax, weightA), OVR_MATH_MUL(bx, weightB));
+    V ry = OVR_MATH_ADD(OVR_MATH_MUL(ay, weightA), OVR_MATH_MUL(by, weightB));
+    V rz = OVR_MATH_ADD(OVR_MATH_MUL(az, weightA), OVR_MATH_MUL(bz, weightB));
+    V rw = OVR_MATH_ADD(OVR_MATH_MUL(aw, weightA), OVR_MATH_MUL(bw, weightB));
+
+    const V lengthSq = OVR_MATH_ADD(
+        OVR_MATH_ADD(OVR_MATH_MUL(rx, rx), OVR_MATH_MUL(ry, ry)),
+        OVR_MATH_ADD(OVR_MATH_MUL(rz, rz), OVR_MATH_MUL(rw, rw)));
+#if defined(OVR_MATH_SSE2)
+    const V invLength = OVR_MATH_DIV(one, _mm_sqrt_ps(lengthSq));
+#else
+    const V invLength = OVR_MATH_DIV(one, vsqrtq_f32(lengthSq));
+#endif
+    rx = OVR_MATH_MUL(rx, invLength);
+    ry = OVR_MATH_MUL(ry, invLength);
+    rz = OVR_MATH_MUL(rz, invLength);
+    rw = OVR_MATH_MUL(rw, invLength);
+
+#if defined(OVR_MATH_SSE2)
+    float x[4], y[4], z[4], w[4];
+    _mm_storeu_ps(x, rx);
+    _mm_storeu_ps(y, ry);
+    _mm_storeu_ps(z, rz);
+    _mm_storeu_ps(w, rw);
+    for (int j = 0; j < 4; ++j)
+      out[i + j] = Quat<float>(x[j], y[j], z[j], w[j]);
+#else
+    float32x4x4_t vout;
+    vout.val[0] = rx;
+    vout.val[1] = ry;
+    vout.val[2] = rz;
+    vout.val[3] = rw;
+    vst4q_f32(&out[i].x, vout);
+#endif
+  }
+
+#undef OVR_MATH_SPLAT
+#undef OVR_MATH_ADD
+#undef OVR_MATH_SUB
+#undef OVR_MATH_MUL
+#undef OVR_MATH_DIV
+
+  for (; i < count; ++i)
+    out[i] = a[i].PolySlerp(b[i], s[i], terms);
+}
+#endif
+
 typedef Quat<float> Quatf;
 typedef Quat<double> Quatd;
 
@@ -2274,12 +2680,13 @@ class Pose {
  public:
   typedef typename CompatibleTypes<Pose<T>>::Type CompatibleType;
 
-  Pose() {}
-  Pose(const Quat<T>& orientation, const Vector3<T>& pos)
+  OVR_MATH_CONSTEXPR Pose() : Rotation(), Translation() {}
+  OVR_MATH_CONSTEXPR Pose(const Quat<T>& orientation, const Vector3<T>& pos)
       : Rotation(orientation), Translation(pos) {}
-  Pose(const Pose& s) : Rotation(s.Rotation), Translation(s.Translation) {}
+  OVR_MATH_CONSTEXPR Pose(const Pose& s) : Rotation(s.Rotation), Translation(s.Translation) {}
   Pose(const Matrix3<T>& R, const Vector3<T>& t) : Rotation((Quat<T>)R), Translation(t) {}
-  Pose(const CompatibleType& s) : Rotation(s.Orientation), Translation(s.Position) {}
+  OVR_MATH_CONSTEXPR Pose(const CompatibleType& s)
+      : Rotation(s.Orientation), Translation(s.Position) {}
 
   explicit Pose(const Pose<typename Math<T>::OtherFloatType>& s)
       : Rotation(s.Rotation), Translation(s.Translation) {
@@ -2288,7 +2695,7 @@ class Pose {
       Rotation.Normalize();
   }
 
-  static Pose Identity() {
+  static OVR_MATH_CONSTEXPR Pose Identity() {
     return Pose(Quat<T>(0, 0, 0, 1), Vector3<T>(0, 0, 0));
   }
 
@@ -2378,6 +2785,13 @@ class Pose {
     return Transform(v);
   }
 
+  // Applies the pose to count points from in to out, which may be the same array. The float
+  // version transforms several points at a time with SIMD, with results identical to Apply.
+  void ApplyBatch(const Vector3<T>* in, Vector3<T>* out, size_t count) const {
+    for (size_t i = 0; i < count; ++i)
+      out[i] = Apply(in[i]);
+  }
+
   Pose operator*(const Pose& other) const {
     return Pose(Rotation * other.Rotation, Apply(other.Translation));
   }
@@ -2399,6 +2813,11 @@ class Pose {
     return Pose(Rotation.FastSlerp(b.Rotation, s), Translation.Lerp(b.Translation, s));
   }
 
+  // Similar to Lerp above, with rotations interpolated by Quat<T>::PolySlerp.
+  Pose PolyLerp(const Pose& b, T s, int terms = Quat<T>::PolySlerpDefaultTerms) const {
+    return Pose(Rotation.PolySlerp(b.Rotation, s, terms), Translation.Lerp(b.Translation, s));
+  }
+
   Pose TimeIntegrate(const Vector3<T>& linearVelocity, const Vector3<T>& angularVelocity, T dt)
       const {
     return Pose(
@@ -2432,6 +2851,14 @@ class Pose {
   }
 };
 
+#if defined(OVR_MATH_SSE2) || defined(OVR_MATH_NEON)
+template <>
+inline void
+Pose<float>::ApplyBatch(const Vector3<float>* in, Vector3<float>* out, size_t count) const {
+  OVRMath_RotateBatch(Rotation, &Translation, in, out, count);
+}
+#endif
+
 typedef Pose<float> Posef;
 typedef Pose<double> Posed;
 
@@ -2484,14 +2911,13 @@ class Matrix4 {
   Matrix4(NoInitType) {}
 
   // By default, we construct identity matrix.
-  Matrix4() {
-    M[0][0] = M[1][1] = M[2][2] = M[3][3] = T(1);
-    M[0][1] = M[1][0] = M[2][3] = M[3][1] = T(0);
-    M[0][2] = M[1][2] = M[2][0] = M[3][2] = T(0);
-    M[0][3] = M[1][3] = M[2][1] = M[3][0] = T(0);
-  }
+  OVR_MATH_CONSTEXPR Matrix4()
+      : M{{T(1), T(0), T(0), T(0)},
+          {T(0), T(1), T(0), T(0)},
+          {T(0), T(0), T(1), T(0)},
+          {T(0), T(0), T(0), T(1)}} {}
 
-  Matrix4(
+  OVR_MATH_CONSTEXPR Matrix4(
       T m11,
       T m12,
       T m13,
@@ -2507,43 +2933,15 @@ class Matrix4 {
       T m41,
       T m42,
       T m43,
-      T m44) {
-    M[0][0] = m11;
-    M[0][1] = m12;
-    M[0][2] = m13;
-    M[0][3] = m14;
-    M[1][0] = m21;
-    M[1][1] = m22;
-    M[1][2] = m23;
-    M[1][3] = m24;
-    M[2][0] = m31;
-    M[2][1] = m32;
-    M[2][2] = m33;
-    M[2][3] = m34;
-    M[3][0] = m41;
-    M[3][1] = m42;
-    M[3][2] = m43;
-    M[3][3] = m44;
-  }
-
-  Matrix4(T m11, T m12, T m13, T m21, T m22, T m23, T m31, T m32, T m33) {
-    M[0][0] = m11;
-    M[0][1] = m12;
-    M[0][2] = m13;
-    M[0][3] = T(0);
-    M[1][0] = m21;
-    M[1][1] = m22;
-    M[1][2] = m23;
-    M[1][3] = T(0);
-    M[2][0] = m31;
-    M[2][1] = m32;
-    M[2][2] = m33;
-    M[2][3] = T(0);
-    M[3][0] = T(0);
-    M[3][1] = T(0);
-    M[3][2] = T(0);
-    M[3][3] = T(1);
-  }
+      T m44)
+      : M{{m11, m12, m13, m14}, {m21, m22, m23, m24}, {m31, m32, m33, m34}, {m41, m42, m43, m44}} {}
+
+  OVR_MATH_CONSTEXPR
+  Matrix4(T m11, T m12, T m13, T m21, T m22, T m23, T m31, T m32, T m33)
+      : M{{m11, m12, m13, T(0)},
+          {m21, m22, m23, T(0)},
+          {m31, m32, m33, T(0)},
+          {T(0), T(0), T(0), T(1)}} {}
 
   explicit Matrix4(const Matrix3<T>& m) {
     M[0][0] = m.M[0][0];
@@ -2642,7 +3040,7 @@ class Matrix4 {
     return result;
   }
 
-  static Matrix4 Identity() {
+  static OVR_MATH_CONSTEXPR Matrix4 Identity() {
     return Matrix4();
   }
 
@@ -2975,21 +3373,14 @@ class Matrix4 {
   }
 
   // Creates a matrix for translation by vector
-  static Matrix4 Translation(const Vector3<T>& v) {
-    Matrix4 t;
-    t.M[0][3] = v.x;
-    t.M[1][3] = v.y;
-    t.M[2][3] = v.z;
-    return t;
+  static OVR_MATH_CONSTEXPR Matrix4 Translation(const Vector3<T>& v) {
+    return Translation(v.x, v.y, v.z);
   }
 
   // Creates a matrix for translation by vector
-  static Matrix4 Translation(T x, T y, T z = T(0)) {
-    Matrix4 t;
-    t.M[0][3] = x;
-    t.M[1][3] = y;
-    t.M[2][3] = z;
-    return t;
+  static OVR_MATH_CONSTEXPR Matrix4 Translation(T x, T y, T z = T(0)) {
+    return Matrix4(
+        T(1), T(0), T(0), x, T(0), T(1), T(0), y, T(0), T(0), T(1), z, T(0), T(0), T(0), T(1));
   }
 
   // Sets the translation part
@@ -2999,35 +3390,23 @@ class Matrix4 {
     M[2][3] = v.z;
   }
 
-  Vector3<T> GetTranslation() const {
+  OVR_MATH_CONSTEXPR Vector3<T> GetTranslation() const {
     return Vector3<T>(M[0][3], M[1][3], M[2][3]);
   }
 
   // Creates a matrix for scaling by vector
-  static Matrix4 Scaling(const Vector3<T>& v) {
-    Matrix4 t;
-    t.M[0][0] = v.x;
-    t.M[1][1] = v.y;
-    t.M[2][2] = v.z;
-    return t;
+  static OVR_MATH_CONSTEXPR Matrix4 Scaling(const Vector3<T>& v) {
+    return Scaling(v.x, v.y, v.z);
   }
 
   // Creates a matrix for scaling by vector
-  static Matrix4 Scaling(T x, T y, T z) {
-    Matrix4 t;
-    t.M[0][0] = x;
-    t.M[1][1] = y;
-    t.M[2][2] = z;
-    return t;
+  static OVR_MATH_CONSTEXPR Matrix4 Scaling(T x, T y, T z) {
+    return Matrix4(x, T(0), T(0), T(0), y, T(0), T(0), T(0), z);
   }
 
   // Creates a matrix for scaling by constant
-  static Matrix4 Scaling(T s) {
-    Matrix4 t;
-    t.M[0][0] = s;
-    t.M[1][1] = s;
-    t.M[2][2] = s;
-    return t;
+  static OVR_MATH_CONSTEXPR Matrix4 Scaling(T s) {
+    return Scaling(s, s, s);
   }
 
   // Simple L1 distance in R^12
@@ -3219,9 +3598,245 @@ class Matrix4 {
   }
 };
 
+// SIMD versions of the float Matrix4 functions which dominate per-frame transform work. The rows
+// of M are loaded unaligned, as Matrix4f has the alignment of ovrMatrix4f. Multiply and
+// Transposed give results identical to the scalar versions; Inverted uses a different (block
+// 2x2) expansion, so it can differ from the scalar result in the last bits.
+#if defined(OVR_MATH_SSE2)
+template <>
+inline Matrix4<float>&
+Matrix4<float>::Multiply(Matrix4<float>* d, const Matrix4<float>& a, const Matrix4<float>& b) {
+  OVR_MATH_ASSERT((d != &a) && (d != &b));
+  const __m128 b0 = _mm_loadu_ps(b.M[0]);
+  const __m128 b1 = _mm_loadu_ps(b.M[1]);
+  const __m128 b2 = _mm_loadu_ps(b.M[2]);
+  const __m128 b3 = _mm_loadu_ps(b.M[3]);
+
+  for (int i = 0; i < 4; i++) {
+    __m128 r = _mm_mul_ps(_mm_set1_ps(a.M[i][0]), b0);
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.M[i][1]), b1));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.M[i][2]), b2));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.M[i][3]), b3));
+    _mm_storeu_ps(d->M[i], r);
+  }
+
+  return *d;
+}
+
+template <>
+inline Matrix4<float> Matrix4<float>::Transposed() const {
+  __m128 r0 = _mm_loadu_ps(M[0]);
+  __m128 r1 = _mm_loadu_ps(M[1]);
+  __m128 r2 = _mm_loadu_ps(M[2]);
+  __m128 r3 = _mm_loadu_ps(M[3]);
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+  Matrix4<float> result(NoInit);
+  _mm_storeu_ps(result.M[0], r0);
+  _mm_storeu_ps(result.M[1], r1);
+  _mm_storeu_ps(result.M[2], r2);
+  _mm_storeu_ps(result.M[3], r3);
+  return result;
+}
+
+// 2x2 matrix helpers for Inverted, on row-major 2x2 matrices packed as (m00 m01 m10 m11).
+#define OVR_MATH_SHUFFLE(a, b, x, y, z, w) _mm_shuffle_ps((a), (b), _MM_SHUFFLE(w, z, y, x))
+
+// a * b
+inline __m128 OVRMath_Mat2Mul(__m128 a, __m128 b) {
+  return _mm_add_ps(
+      _mm_mul_ps(a, OVR_MATH_SHUFFLE(b, b, 0, 3, 0, 3)),
+      _mm_mul_ps(OVR_MATH_SHUFFLE(a, a, 1, 0, 3, 2), OVR_MATH_SHUFFLE(b, b, 2, 1, 2, 1)));
+}
+
+// Adjugate(a) * b
+inline __m128 OVRMath_Mat2AdjMul(__m128 a, __m128 b) {
+  return _mm_sub_ps(
+      _mm_mul_ps(OVR_MATH_SHUFFLE(a, a, 3, 3, 0, 0), b),
+      _mm_mul_ps(OVR_MATH_SHUFFLE(a, a, 1, 1, 2, 2), OVR_MATH_SHUFFLE(b, b, 2, 3, 0, 1)));
+}
+
+// a * Adjugate(b)
+inline __m128 OVRMath_Mat2MulAdj(__m128 a, __m128 b) {
+  return _mm_sub_ps(
+      _mm_mul_ps(a, OVR_MATH_SHUFFLE(b, b, 3, 0, 3, 0)),
+      _mm_mul_ps(OVR_MATH_SHUFFLE(a, a, 1, 0, 3, 2), OVR_MATH_SHUFFLE(b, b, 2, 1, 2, 1)));
+}
+
+template <>
+inline Matrix4<float> Matrix4<float>::Inverted() const {
+  const __m128 r0 = _mm_loadu_ps(M[0]);
+  const __m128 r1 = _mm_loadu_ps(M[1]);
+  const __m128 r2 = _mm_loadu_ps(M[2]);
+  const __m128 r3 = _mm_loadu_ps(M[3]);
+
+  // The 2x2 blocks of the matrix:  | A B |
+  //                                | C D |
+  const __m128 A = _mm_movelh_ps(r0, r1);
+  const __m128 B = _mm_movehl_ps(r1, r0);
+  const __m128 C = _mm_movelh_ps(r2, r3);
+  const __m128 D = _mm_movehl_ps(r3, r2);
+
+  // Determinants of A, B, C and D.
+  const __m128 detSub = _mm_sub_ps(
+      _mm_mul_ps(OVR_MATH_SHUFFLE(r0, r2, 0, 2, 0, 2), OVR_MATH_SHUFFLE(r1, r3, 1, 3, 1, 3)),
+      _mm_mul_ps(OVR_MATH_SHUFFLE(r0, r2, 1, 3, 1, 3), OVR_MATH_SHUFFLE(r1, r3, 0, 2, 0, 2)));
+  const __m128 detA = OVR_MATH_SHUFFLE(detSub, detSub, 0, 0, 0, 0);
+  const __m128 detB = OVR_MATH_SHUFFLE(detSub, detSub, 1, 1, 1, 1);
+  const __m128 detC = OVR_MATH_SHUFFLE(detSub, detSub, 2, 2, 2, 2);
+  const __m128 detD = OVR_MATH_SHUFFLE(detSub, detSub, 3, 3, 3, 3);
+
+  const __m128 DC = OVRMath_Mat2AdjMul(D, C);
+  const __m128 AB = OVRMath_Mat2AdjMul(A, B);
+  __m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), OVRMath_Mat2Mul(B, DC));
+  __m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), OVRMath_Mat2Mul(C, AB));
+  __m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), OVRMath_Mat2MulAdj(D, AB));
+  __m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), OVRMath_Mat2MulAdj(A, DC));
+
+  // det(M) = det(A) * det(D) + det(B) * det(C) - trace(Adjugate(A) * B * Adjugate(D) * C)
+  __m128 tr = _mm_mul_ps(AB, OVR_MATH_SHUFFLE(DC, DC, 0, 2, 1, 3));
+  tr = _mm_add_ps(tr, OVR_MATH_SHUFFLE(tr, tr, 2, 3, 0, 1));
+  tr = _mm_add_ps(tr, OVR_MATH_SHUFFLE(tr, tr, 1, 0, 3, 2));
+  const __m128 detM =
+      _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+  OVR_MATH_ASSERT(_mm_cvtss_f32(detM) != 0);
+
+  const __m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+  X = _mm_mul_ps(X, rDetM);
+  Y = _mm_mul_ps(Y, rDetM);
+  Z = _mm_mul_ps(Z, rDetM);
+  W = _mm_mul_ps(W, rDetM);
+
+  Matrix4<float> result(NoInit);
+  _mm_storeu_ps(result.M[0], OVR_MATH_SHUFFLE(X, Y, 3, 1, 3, 1));
+  _mm_storeu_ps(result.M[1], OVR_MATH_SHUFFLE(X, Y, 2, 0, 2, 0));
+  _mm_storeu_ps(result.M[2], OVR_MATH_SHUFFLE(Z, W, 3, 1, 3, 1));
+  _mm_storeu_ps(result.M[3], OVR_MATH_SHUFFLE(Z, W, 2, 0, 2, 0));
+  return result;
+}
+
+#undef OVR_MATH_SHUFFLE
+
+#elif defined(OVR_MATH_NEON)
+template <>
+inline Matrix4<float>&
+Matrix4<float>::Multiply(Matrix4<float>* d, const Matrix4<float>& a, const Matrix4<float>& b) {
+  OVR_MATH_ASSERT((d != &a) && (d != &b));
+  const float32x4_t b0 = vld1q_f32(b.M[0]);
+  const float32x4_t b1 = vld1q_f32(b.M[1]);
+  const float32x4_t b2 = vld1q_f32(b.M[2]);
+  const float32x4_t b3 = vld1q_f32(b.M[3]);
+
+  // Separate multiplies and adds rather than vmlaq/vfmaq, to round as the scalar version does.
+  for (int i = 0; i < 4; i++) {
+    float32x4_t r = vmulq_n_f32(b0, a.M[i][0]);
+    r = vaddq_f32(r, vmulq_n_f32(b1, a.M[i][1]));
+    r = vaddq_f32(r, vmulq_n_f32(b2, a.M[i][2]));
+    r = vaddq_f32(r, vmulq_n_f32(b3, a.M[i][3]));
+    vst1q_f32(d->M[i], r);
+  }
+
+  return *d;
+}
+
+template <>
+inline Matrix4<float> Matrix4<float>::Transposed() const {
+  // vld4q de-interleaves every fourth element, which loads the columns.
+  const float32x4x4_t columns = vld4q_f32(&M[0][0]);
+
+  Matrix4<float> result(NoInit);
+  vst1q_f32(result.M[0], columns.val[0]);
+  vst1q_f32(result.M[1], columns.val[1]);
+  vst1q_f32(result.M[2], columns.val[2]);
+  vst1q_f32(result.M[3], columns.val[3]);
+  return result;
+}
+#endif
+
 typedef Matrix4<float> Matrix4f;
 typedef Matrix4<double> Matrix4d;
 
+// Transforms count points from in to out, which may be the same array, as Matrix4::Transform
+// does. The float version transforms several points at a time with SIMD, with identical results.
+template <class T>
+void TransformPoints(const Matrix4<T>& m, const Vector3<T>* in, Vector3<T>* out, size_t count) {
+  for (size_t i = 0; i < count; ++i)
+    out[i] = m.Transform(in[i]);
+}
+
+// vdivq_f32 needs AArch64, so 32-bit ARM uses the scalar version.
+#if defined(OVR_MATH_SSE2) || \
+    (defined(OVR_MATH_NEON) && (defined(__aarch64__) || defined(_M_ARM64)))
+inline void
+TransformPoints(const Matrix4f& m, const Vector3f* in, Vector3f* out, size_t count) {
+#if defined(OVR_MATH_SSE2)
+  typedef __m128 V;
+#define OVR_MATH_SPLAT(f) _mm_set1_ps(f)
+#define OVR_MATH_ADD(a, b) _mm_add_ps((a), (b))
+#define OVR_MATH_MUL(a, b) _mm_mul_ps((a), (b))
+#else
+  typedef float32x4_t V;
+#define OVR_MATH_SPLAT(f) vdupq_n_f32(f)
+#define OVR_MATH_ADD(a, b) vaddq_f32((a), (b))
+#define OVR_MATH_MUL(a, b) vmulq_f32((a), (b))
+#endif
+
+  V mm[4][4];
+  for (int r = 0; r < 4; ++r)
+    for (int c = 0; c < 4; ++c)
+      mm[r][c] = OVR_MATH_SPLAT(m.M[r][c]);
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+#if defined(OVR_MATH_SSE2)
+    const V vx = _mm_setr_ps(in[i].x, in[i + 1].x, in[i + 2].x, in[i + 3].x);
+    const V vy = _mm_setr_ps(in[i].y, in[i + 1].y, in[i + 2].y, in[i + 3].y);
+    const V vz = _mm_setr_ps(in[i].z, in[i + 1].z, in[i + 2].z, in[i + 3].z);
+#else
+    const float32x4x3_t vin = vld3q_f32(&in[i].x);
+    const V vx = vin.val[0], vy = vin.val[1], vz = vin.val[2];
+#endif
+
+    // Row r of the matrix dotted with (v, 1), summed left to right as the scalar version does.
+    V rows[4];
+    for (int r = 0; r < 4; ++r)
+      rows[r] = OVR_MATH_ADD(
+          OVR_MATH_ADD(
+              OVR_MATH_ADD(OVR_MATH_MUL(mm[r][0], vx), OVR_MATH_MUL(mm[r][1], vy)),
+              OVR_MATH_MUL(mm[r][2], vz)),
+          mm[r][3]);
+
+#if defined(OVR_MATH_SSE2)
+    const V rcpW = _mm_div_ps(_mm_set1_ps(1.0f), rows[3]);
+#else
+    const V rcpW = vdivq_f32(vdupq_n_f32(1.0f), rows[3]);
+#endif
+
+#if defined(OVR_MATH_SSE2)
+    float x[4], y[4], z[4];
+    _mm_storeu_ps(x, OVR_MATH_MUL(rows[0], rcpW));
+    _mm_storeu_ps(y, OVR_MATH_MUL(rows[1], rcpW));
+    _mm_storeu_ps(z, OVR_MATH_MUL(rows[2], rcpW));
+    for (int j = 0; j < 4; ++j)
+      out[i + j] = Vector3f(x[j], y[j], z[j]);
+#else
+    float32x4x3_t vout;
+    vout.val[0] = OVR_MATH_MUL(rows[0], rcpW);
+    vout.val[1] = OVR_MATH_MUL(rows[1], rcpW);
+    vout.val[2] = OVR_MATH_MUL(rows[2], rcpW);
+    vst3q_f32(&out[i].x, vout);
+#endif
+  }
+
+#undef OVR_MATH_SPLAT
+#undef OVR_MATH_ADD
+#undef OVR_MATH_MUL
+
+  for (; i < count; ++i)
+    out[i] = m.Transform(in[i]);
+}
+#endif
+
 //-------------------------------------------------------------------------------------
 // ***** Matrix3
 //
@@ -3256,36 +3871,17 @@ class Matrix3 {
   Matrix3(NoInitType) {}
 
   // By default, we construct identity matrix.
-  Matrix3() {
-    M[0][0] = M[1][1] = M[2][2] = T(1);
-    M[0][1] = M[1][0] = M[2][0] = T(0);
-    M[0][2] = M[1][2] = M[2][1] = T(0);
-  }
+  OVR_MATH_CONSTEXPR Matrix3() : M{{T(1), T(0), T(0)}, {T(0), T(1), T(0)}, {T(0), T(0), T(1)}} {}
 
-  Matrix3(T m11, T m12, T m13, T m21, T m22, T m23, T m31, T m32, T m33) {
-    M[0][0] = m11;
-    M[0][1] = m12;
-    M[0][2] = m13;
-    M[1][0] = m21;
-    M[1][1] = m22;
-    M[1][2] = m23;
-    M[2][0] = m31;
-    M[2][1] = m32;
-    M[2][2] = m33;
-  }
+  OVR_MATH_CONSTEXPR Matrix3(T m11, T m12, T m13, T m21, T m22, T m23, T m31, T m32, T m33)
+      : M{{m11, m12, m13}, {m21, m22, m23}, {m31, m32, m33}} {}
 
   // Construction from X, Y, Z basis vectors
-  Matrix3(const Vector3<T>& xBasis, const Vector3<T>& yBasis, const Vector3<T>& zBasis) {
-    M[0][0] = xBasis.x;
-    M[0][1] = yBasis.x;
-    M[0][2] = zBasis.x;
-    M[1][0] = xBasis.y;
-    M[1][1] = yBasis.y;
-    M[1][2] = zBasis.y;
-    M[2][0] = xBasis.z;
-    M[2][1] = yBasis.z;
-    M[2][2] = zBasis.z;
-  }
+  OVR_MATH_CONSTEXPR
+  Matrix3(const Vector3<T>& xBasis, const Vector3<T>& yBasis, const Vector3<T>& zBasis)
+      : M{{xBasis.x, yBasis.x, zBasis.x},
+          {xBasis.y, yBasis.y, zBasis.y},
+          {xBasis.z, yBasis.z, zBasis.z}} {}
 
   explicit Matrix3(const Quat<T>& q) {
     OVR_MATH_ASSERT(q.IsNormalized()); // If this fires, caller has a quat math bug
@@ -3304,22 +3900,11 @@ class Matrix3 {
     M[2][2] = T(1) - (txx + tyy);
   }
 
-  inline explicit Matrix3(T s) {
-    M[0][0] = M[1][1] = M[2][2] = s;
-    M[0][1] = M[0][2] = M[1][0] = M[1][2] = M[2][0] = M[2][1] = T(0);
-  }
+  OVR_MATH_CONSTEXPR explicit Matrix3(T s)
+      : M{{s, T(0), T(0)}, {T(0), s, T(0)}, {T(0), T(0), s}} {}
 
-  Matrix3(T m11, T m22, T m33) {
-    M[0][0] = m11;
-    M[0][1] = T(0);
-    M[0][2] = T(0);
-    M[1][0] = T(0);
-    M[1][1] = m22;
-    M[1][2] = T(0);
-    M[2][0] = T(0);
-    M[2][1] = T(0);
-    M[2][2] = m33;
-  }
+  OVR_MATH_CONSTEXPR Matrix3(T m11, T m22, T m33)
+      : M{{m11, T(0), T(0)}, {T(0), m22, T(0)}, {T(0), T(0), m33}} {}
 
   explicit Matrix3(const Matrix3<typename Math<T>::OtherFloatType>& src) {
     for (int i = 0; i < 3; i++)
@@ -68,6 +68,60 @@ Matrix4f CreateOrthoSubProjection(
 
 ScaleAndOffset2D CreateNDCScaleAndOffsetFromFov(FovPort fov);
 
+// The projection values timewarp needs, as in ovrTimewarpProjectionDesc. They are always in the
+// D3D clip range of [0,+w]; isOpenGL says whether projection uses the OpenGL one of [-w,+w].
+struct TimewarpProjection {
+  float Projection22;
+  float Projection23;
+  float Projection32;
+};
+
+TimewarpProjection CreateTimewarpProjection(Matrix4f const& projection, bool isOpenGL);
+
+//-----------------------------------------------------------------------------------
+// ***** CachedProjection
+//
+// Keeps the CreateProjection result for one FOV and depth range, and rebuilds it only when Update
+// is given different inputs. An app building projections per layer per frame can keep one of
+// these per layer, as the FOV seldom changes.
+//
+class CachedProjection {
+ public:
+  CachedProjection();
+
+  // Returns CreateProjection(leftHanded, isOpenGL, fov, StereoEye_Center, ...).
+  const Matrix4f& Update(
+      bool leftHanded,
+      bool isOpenGL,
+      FovPort fov,
+      float zNear,
+      float zFar,
+      bool flipZ = false,
+      bool farAtInfinity = false);
+
+  // Both are those of the last Update.
+  const Matrix4f& GetProjection() const {
+    return Projection;
+  }
+  const TimewarpProjection& GetTimewarpProjection() const {
+    return Timewarp;
+  }
+
+  // Makes the next Update rebuild.
+  void Invalidate() {
+    Valid = false;
+  }
+
+ private:
+  bool Valid;
+  FovPort Fov;
+  float ZNear;
+  float ZFar;
+  unsigned Flags;
+  Matrix4f Projection;
+  TimewarpProjection Timewarp;
+};
+
 } // namespace OVR
 
 #endif // OVR_StereoProjection_h
@@ -1495,6 +1495,16 @@ extern "C" {
 ///
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_Initialize(const ovrInitParams* params);
 
+/// Starts finding, verifying and loading the LibOVRRT shared library on a background thread,
+/// so that it overlaps with the application's other initialization instead of being done by
+/// ovr_Initialize. Optional; ovr_Initialize waits for it to finish. Call it from the thread that
+/// calls ovr_Initialize, before it. Implemented by the CAPI shim, and currently does nothing on
+/// platforms other than Windows.
+///
+/// \see ovr_Initialize
+///
+OVR_PUBLIC_FUNCTION(void) ovr_PrepareInitialize();
+
 /// Shuts down LibOVR
 ///
 /// A successful call to ovr_Initialize must be eventually matched by a call to ovr_Shutdown.
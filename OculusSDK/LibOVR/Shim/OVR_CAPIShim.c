@@ -595,6 +595,30 @@ static BOOL OVR_Win32_SignCheck(FilePathCharType* fullPath, HANDLE hFile) {
   return verified;
 }
 
+// The runtime file OVR_OpenLibrary last verified. It stays open, without write or delete sharing,
+// for the rest of the process, so the file can't change and loading it again (e.g. after an
+// ovr_Shutdown) needn't repeat the signature check. This isn't saved across processes, as then
+// anything able to write the saved result could skip the check.
+static struct {
+  FilePathCharType Path[MAX_PATH];
+  HANDLE hFile; // NULL until a file is verified.
+  BY_HANDLE_FILE_INFORMATION Info;
+} VerifiedLibrary;
+
+static BOOL OVR_Win32_IsVerifiedLibrary(
+    const FilePathCharType* fullPath,
+    const BY_HANDLE_FILE_INFORMATION* info) {
+  const BY_HANDLE_FILE_INFORMATION* verified = &VerifiedLibrary.Info;
+
+  return VerifiedLibrary.hFile && (wcscmp(fullPath, VerifiedLibrary.Path) == 0) &&
+      (info->dwVolumeSerialNumber == verified->dwVolumeSerialNumber) &&
+      (info->nFileIndexHigh == verified->nFileIndexHigh) &&
+      (info->nFileIndexLow == verified->nFileIndexLow) &&
+      (info->nFileSizeHigh == verified->nFileSizeHigh) &&
+      (info->nFileSizeLow == verified->nFileSizeLow) &&
+      (CompareFileTime(&info->ftLastWriteTime, &verified->ftLastWriteTime) == 0);
+}
+
 #endif // #if defined(_WIN32)
 
 static ModuleHandleType OVR_OpenLibrary(const FilePathCharType* libraryPath, ovrResult* result) {
@@ -602,6 +626,8 @@ static ModuleHandleType OVR_OpenLibrary(const FilePathCharType* libraryPath, ovr
   DWORD fullPathNameLen = 0;
   FilePathCharType fullPath[MAX_PATH] = {0};
   HANDLE hFilePinned = INVALID_HANDLE_VALUE;
+  BY_HANDLE_FILE_INFORMATION fileInfo;
+  BOOL haveFileInfo;
   ModuleHandleType hModule = 0;
 
   *result = ovrSuccess;
@@ -620,15 +646,30 @@ static ModuleHandleType OVR_OpenLibrary(const FilePathCharType* libraryPath, ovr
     return NULL;
   }
 
-  if (!OVR_Win32_SignCheck(fullPath, hFilePinned)) {
-    *result = ovrError_LibSignCheck;
-    CloseHandle(hFilePinned);
-    return NULL;
+  haveFileInfo = GetFileInformationByHandle(hFilePinned, &fileInfo);
+
+  if (!haveFileInfo || !OVR_Win32_IsVerifiedLibrary(fullPath, &fileInfo)) {
+    if (!OVR_Win32_SignCheck(fullPath, hFilePinned)) {
+      *result = ovrError_LibSignCheck;
+      CloseHandle(hFilePinned);
+      return NULL;
+    }
+
+    if (haveFileInfo) {
+      // Keep this file pinned, in place of any verified before it.
+      if (VerifiedLibrary.hFile)
+        CloseHandle(VerifiedLibrary.hFile);
+      memcpy(VerifiedLibrary.Path, fullPath, (fullPathNameLen + 1) * sizeof(FilePathCharType));
+      VerifiedLibrary.Info = fileInfo;
+      VerifiedLibrary.hFile = hFilePinned;
+      hFilePinned = INVALID_HANDLE_VALUE;
+    }
   }
 
   hModule = LoadLibraryW(fullPath);
 
-  CloseHandle(hFilePinned);
+  if (hFilePinned != INVALID_HANDLE_VALUE)
+    CloseHandle(hFilePinned);
 
   if (hModule == NULL) {
     *result = ovrError_LibLoad;
@@ -1091,8 +1132,62 @@ ModuleHandleType ovr_GetLibOVRRTHandle() {
 
 static struct { OVR_LIST_APIS(OVR_DECLARE_IMPORT, OVR_IGNORE_IMPORT) } API = {{NULL}};
 
+//-----------------------------------------------------------------------------------
+// ***** OVR_RESOLVE
+//
+// Most apps call a few dozen of the entry points, so rather than looking them all up when the
+// library loads, each is looked up on its first call. OVR_RESOLVE(FunctionName) is nonzero once
+// API.FunctionName holds the entry point, and zero if the library isn't loaded or lacks it.
+// Threads making a first call at once may each look it up. The entry point is published before
+// the looked up flag, so a thread which finds the flag already set also finds the entry point.
+//
+
+#define OVR_DECLARE_SYMBOL_NAME(ReturnValue, FunctionName, OptionalVersion, Arguments) \
+  const char* FunctionName;
+#define OVR_DEFINE_SYMBOL_NAME(ReturnValue, FunctionName, OptionalVersion, Arguments) \
+  #FunctionName #OptionalVersion,
+#define OVR_DECLARE_LOOKED_UP(ReturnValue, FunctionName, OptionalVersion, Arguments) \
+  long FunctionName;
+
+// The catenated FunctionName and OptionalVersion of each entry point
+static const struct { OVR_LIST_APIS(OVR_DECLARE_SYMBOL_NAME, OVR_IGNORE_IMPORT) } APISymbolNames = {
+    OVR_LIST_APIS(OVR_DEFINE_SYMBOL_NAME, OVR_IGNORE_IMPORT)};
+
+// Set once an entry point was looked up, so that a missing one isn't looked up on every call
+static struct { OVR_LIST_APIS(OVR_DECLARE_LOOKED_UP, OVR_IGNORE_IMPORT) } APILookedUp;
+
+static int OVR_LookUpSymbol(ModuleFunctionType* symbol, long* lookedUp, const char* symbolName) {
+  ModuleFunctionType value;
+
+  if (!hLibOVR)
+    return 0;
+
+#if defined(_WIN32)
+  if (InterlockedCompareExchange((LONG volatile*)lookedUp, 0, 0))
+    return *symbol != ModuleFunctionTypeNull;
+  value = OVR_DLSYM(hLibOVR, symbolName);
+  InterlockedExchangePointer((PVOID volatile*)symbol, *(PVOID*)&value);
+  InterlockedExchange((LONG volatile*)lookedUp, 1);
+#else
+  if (__atomic_load_n(lookedUp, __ATOMIC_ACQUIRE))
+    return __atomic_load_n(symbol, __ATOMIC_ACQUIRE) != ModuleFunctionTypeNull;
+  value = OVR_DLSYM(hLibOVR, symbolName);
+  __atomic_store_n(symbol, value, __ATOMIC_RELEASE);
+  __atomic_store_n(lookedUp, 1, __ATOMIC_RELEASE);
+#endif
+  return value != ModuleFunctionTypeNull;
+}
+
+#define OVR_RESOLVE(FunctionName)    \
+  (API.FunctionName.Symbol ||        \
+   OVR_LookUpSymbol(                 \
+       &API.FunctionName.Symbol,     \
+       &APILookedUp.FunctionName,    \
+       APISymbolNames.FunctionName))
+
 static void OVR_UnloadSharedLibrary() {
   memset(&API, 0, sizeof(API));
+  memset(&APILookedUp, 0, sizeof(APILookedUp));
   if (hLibOVR)
     OVR_CloseLibrary(hLibOVR);
   hLibOVR = NULL;
@@ -1128,12 +1223,12 @@ static ovrResult OVR_LoadSharedLibrary(int requestedProductVersion, int requeste
 
   // Zero the API table just to be paranoid
   memset(&API, 0, sizeof(API));
+  memset(&APILookedUp, 0, sizeof(APILookedUp));
 
 // Load the current API entrypoint using the catenated FunctionName and OptionalVersion
-#define OVR_GETFUNCTION(ReturnValue, FunctionName, OptionalVersion, Arguments) \
-  SymbolName = #FunctionName #OptionalVersion;                                 \
-  API.FunctionName.Symbol = OVR_DLSYM(hLibOVR, SymbolName);                    \
-  if (!API.FunctionName.Symbol) {                                              \
+#define OVR_GETFUNCTION(FunctionName)                                          \
+  SymbolName = APISymbolNames.FunctionName;                                    \
+  if (!OVR_RESOLVE(FunctionName)) {                                            \
     LastInitializeErrorInfo.Result = result = ovrError_LibSymbols;             \
     OVR_strlcpy(                                                               \
         LastInitializeErrorInfo.ErrorString,                                   \
@@ -1146,7 +1241,11 @@ static ovrResult OVR_LoadSharedLibrary(int requestedProductVersion, int requeste
     goto FailedToLoadSymbol;                                                   \
   }
 
-  OVR_LIST_APIS(OVR_GETFUNCTION, OVR_IGNORE_IMPORT)
+  // Only the entry points the shim calls itself are needed up front; see OVR_RESOLVE
+  OVR_GETFUNCTION(ovr_Initialize)
+  OVR_GETFUNCTION(ovr_Shutdown)
+  OVR_GETFUNCTION(ovr_GetLastErrorInfo)
+  OVR_GETFUNCTION(ovr_GetVersionString)
 
 #undef OVR_GETFUNCTION
 
@@ -1158,6 +1257,34 @@ FailedToLoadSymbol:
   return result;
 }
 
+#if defined(_WIN32)
+// ovr_PrepareInitialize's thread, which runs OVR_LoadSharedLibrary ahead of ovr_Initialize.
+static HANDLE hPrepareThread = NULL;
+
+static DWORD WINAPI OVR_PrepareThreadProc(LPVOID param) {
+  (void)param;
+  OVR_LoadSharedLibrary(OVR_PRODUCT_VERSION, OVR_MAJOR_VERSION);
+  return 0;
+}
+#endif
+
+static void OVR_WaitForPrepare() {
+#if defined(_WIN32)
+  if (hPrepareThread) {
+    WaitForSingleObject(hPrepareThread, INFINITE);
+    CloseHandle(hPrepareThread);
+    hPrepareThread = NULL;
+  }
+#endif
+}
+
+OVR_PUBLIC_FUNCTION(void) ovr_PrepareInitialize() {
+#if defined(_WIN32)
+  if (!hPrepareThread && !hLibOVR)
+    hPrepareThread = CreateThread(NULL, 0, OVR_PrepareThreadProc, NULL, 0, NULL);
+#endif
+}
+
 // These defaults are also in CAPI.cpp
 static const ovrInitParams DefaultParams = {
     ovrInit_RequestVersion, // Flags
@@ -1227,7 +1354,9 @@ OVR_PUBLIC_FUNCTION(ovrResult) ovr_Initialize(const ovrInitParams* inputParams)
     return result;
   }
 
-  // By design we ignore the build version in the library search.
+  // By design we ignore the build version in the library search. If ovr_PrepareInitialize
+  // already loaded the library, this finds it loaded; if that failed, this tries again.
+  OVR_WaitForPrepare();
   result = OVR_LoadSharedLibrary(OVR_PRODUCT_VERSION, OVR_MAJOR_VERSION);
   if (result != ovrSuccess)
     return result;
@@ -1237,7 +1366,7 @@ OVR_PUBLIC_FUNCTION(ovrResult) ovr_Initialize(const ovrInitParams* inputParams)
   if (result != ovrSuccess) {
     // Stash the last initialization error for the shim to return if
     // ovr_GetLastErrorInfo is called after we unload the dll below
-    if (API.ovr_GetLastErrorInfo.Ptr) {
+    if (OVR_RESOLVE(ovr_GetLastErrorInfo)) {
       API.ovr_GetLastErrorInfo.Ptr(&LastInitializeErrorInfo);
     }
     OVR_UnloadSharedLibrary();
@@ -1265,7 +1394,8 @@ OVR_PUBLIC_FUNCTION(ovrResult) ovr_Initialize(const ovrInitParams* inputParams)
 }
 
 OVR_PUBLIC_FUNCTION(void) ovr_Shutdown() {
-  if (!API.ovr_Shutdown.Ptr)
+  OVR_WaitForPrepare();
+  if (!OVR_RESOLVE(ovr_Shutdown))
     return;
   API.ovr_Shutdown.Ptr();
   OVR_UnloadSharedLibrary();
@@ -1279,7 +1409,7 @@ OVR_PUBLIC_FUNCTION(const char*) ovr_GetVersionString() {
   static char dllVersionStringLocal[32];
   const char* dllVersionString;
 
-  if (!API.ovr_GetVersionString.Ptr)
+  if (!OVR_RESOLVE(ovr_GetVersionString))
     return "(Unable to load LibOVR)";
 
   dllVersionString = API.ovr_GetVersionString.Ptr(); // Guaranteed to always be valid.
@@ -1290,14 +1420,14 @@ OVR_PUBLIC_FUNCTION(const char*) ovr_GetVersionString() {
 }
 
 OVR_PUBLIC_FUNCTION(void) ovr_GetLastErrorInfo(ovrErrorInfo* errorInfo) {
-  if (!API.ovr_GetLastErrorInfo.Ptr) {
+  if (!OVR_RESOLVE(ovr_GetLastErrorInfo)) {
     *errorInfo = LastInitializeErrorInfo;
   } else
     API.ovr_GetLastErrorInfo.Ptr(errorInfo);
 }
 
 OVR_PUBLIC_FUNCTION(ovrHmdDesc) ovr_GetHmdDesc(ovrSession session) {
-  if (!API.ovr_GetHmdDesc.Ptr) {
+  if (!OVR_RESOLVE(ovr_GetHmdDesc)) {
     ovrHmdDesc hmdDesc;
     memset(&hmdDesc, 0, sizeof(hmdDesc));
     hmdDesc.Type = ovrHmd_None;
@@ -1308,7 +1438,7 @@ OVR_PUBLIC_FUNCTION(ovrHmdDesc) ovr_GetHmdDesc(ovrSession session) {
 }
 
 OVR_PUBLIC_FUNCTION(unsigned int) ovr_GetTrackerCount(ovrSession session) {
-  if (!API.ovr_GetTrackerCount.Ptr) {
+  if (!OVR_RESOLVE(ovr_GetTrackerCount)) {
     return 0;
   }
 
@@ -1317,7 +1447,7 @@ OVR_PUBLIC_FUNCTION(unsigned int) ovr_GetTrackerCount(ovrSession session) {
 
 OVR_PUBLIC_FUNCTION(ovrTrackerDesc)
 ovr_GetTrackerDesc(ovrSession session, unsigned int trackerDescIndex) {
-  if (!API.ovr_GetTrackerDesc.Ptr) {
+  if (!OVR_RESOLVE(ovr_GetTrackerDesc)) {
     ovrTrackerDesc trackerDesc;
     memset(&trackerDesc, 0, sizeof(trackerDesc));
     return trackerDesc;
@@ -1327,20 +1457,20 @@ ovr_GetTrackerDesc(ovrSession session, unsigned int trackerDescIndex) {
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_Create(ovrSession* pSession, ovrGraphicsLuid* pLuid) {
-  if (!API.ovr_Create.Ptr)
+  if (!OVR_RESOLVE(ovr_Create))
     return ovrError_NotInitialized;
   return API.ovr_Create.Ptr(pSession, pLuid);
 }
 
 OVR_PUBLIC_FUNCTION(void) ovr_Destroy(ovrSession session) {
-  if (!API.ovr_Destroy.Ptr)
+  if (!OVR_RESOLVE(ovr_Destroy))
     return;
   API.ovr_Destroy.Ptr(session);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_InitDesktopWindow(ovrSession session, ovrDesktopWindowHandle* outWindowHandle) {
-  if (!API.ovr_InitDesktopWindow.Ptr) {
+  if (!OVR_RESOLVE(ovr_InitDesktopWindow)) {
     return ovrError_ServiceError;
   }
   return API.ovr_InitDesktopWindow.Ptr(session, outWindowHandle);
@@ -1348,7 +1478,7 @@ ovr_InitDesktopWindow(ovrSession session, ovrDesktopWindowHandle* outWindowHandl
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_ShowDesktopWindow(ovrSession session, const ovrDesktopWindowDesc* windowDesc) {
-  if (!API.ovr_ShowDesktopWindow.Ptr) {
+  if (!OVR_RESOLVE(ovr_ShowDesktopWindow)) {
     return ovrError_ServiceError;
   }
   return API.ovr_ShowDesktopWindow.Ptr(session, windowDesc);
@@ -1356,7 +1486,7 @@ ovr_ShowDesktopWindow(ovrSession session, const ovrDesktopWindowDesc* windowDesc
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_HideDesktopWindow(ovrSession session, ovrDesktopWindowHandle windowHandle) {
-  if (!API.ovr_HideDesktopWindow.Ptr) {
+  if (!OVR_RESOLVE(ovr_HideDesktopWindow)) {
     return ovrError_ServiceError;
   }
   return API.ovr_HideDesktopWindow.Ptr(session, windowHandle);
@@ -1367,7 +1497,7 @@ ovr_GetHybridInputFocus(
     ovrSession session,
     ovrControllerType controllerType,
     ovrHybridInputFocusState* outState) {
-  if (!API.ovr_GetHybridInputFocus.Ptr) {
+  if (!OVR_RESOLVE(ovr_GetHybridInputFocus)) {
     return ovrError_ServiceError;
   }
   return API.ovr_GetHybridInputFocus.Ptr(session, controllerType, outState);
@@ -1375,7 +1505,7 @@ ovr_GetHybridInputFocus(
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_ShowAvatarHands(ovrSession session, ovrBool showHands) {
-  if (!API.ovr_ShowAvatarHands.Ptr) {
+  if (!OVR_RESOLVE(ovr_ShowAvatarHands)) {
     return ovrError_ServiceError;
   }
   return API.ovr_ShowAvatarHands.Ptr(session, showHands);
@@ -1383,7 +1513,7 @@ ovr_ShowAvatarHands(ovrSession session, ovrBool showHands) {
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_GetSessionStatus(ovrSession session, ovrSessionStatus* sessionStatus) {
-  if (!API.ovr_GetSessionStatus.Ptr) {
+  if (!OVR_RESOLVE(ovr_GetSessionStatus)) {
     if (sessionStatus) {
       sessionStatus->IsVisible = ovrFalse;
       sessionStatus->HmdPresent = ovrFalse;
@@ -1405,52 +1535,52 @@ ovr_GetSessionStatus(ovrSession session, ovrSessionStatus* sessionStatus) {
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_IsExtensionSupported(ovrSession session, ovrExtensions extension, ovrBool* extensionSupported) {
-  if (!API.ovr_IsExtensionSupported.Ptr)
+  if (!OVR_RESOLVE(ovr_IsExtensionSupported))
     return ovrError_NotInitialized;
   return API.ovr_IsExtensionSupported.Ptr(session, extension, extensionSupported);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_EnableExtension(ovrSession session, ovrExtensions extension) {
-  if (!API.ovr_EnableExtension.Ptr)
+  if (!OVR_RESOLVE(ovr_EnableExtension))
     return ovrError_NotInitialized;
   return API.ovr_EnableExtension.Ptr(session, extension);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_SetTrackingOriginType(ovrSession session, ovrTrackingOrigin origin) {
-  if (!API.ovr_SetTrackingOriginType.Ptr)
+  if (!OVR_RESOLVE(ovr_SetTrackingOriginType))
     return ovrError_NotInitialized;
   return API.ovr_SetTrackingOriginType.Ptr(session, origin);
 }
 
 OVR_PUBLIC_FUNCTION(ovrTrackingOrigin) ovr_GetTrackingOriginType(ovrSession session) {
-  if (!API.ovr_GetTrackingOriginType.Ptr)
+  if (!OVR_RESOLVE(ovr_GetTrackingOriginType))
     return ovrTrackingOrigin_EyeLevel;
   return API.ovr_GetTrackingOriginType.Ptr(session);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_RecenterTrackingOrigin(ovrSession session) {
-  if (!API.ovr_RecenterTrackingOrigin.Ptr)
+  if (!OVR_RESOLVE(ovr_RecenterTrackingOrigin))
     return ovrError_NotInitialized;
   return API.ovr_RecenterTrackingOrigin.Ptr(session);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_SpecifyTrackingOrigin(ovrSession session, ovrPosef originPose) {
-  if (!API.ovr_SpecifyTrackingOrigin.Ptr)
+  if (!OVR_RESOLVE(ovr_SpecifyTrackingOrigin))
     return ovrError_NotInitialized;
   return API.ovr_SpecifyTrackingOrigin.Ptr(session, originPose);
 }
 
 OVR_PUBLIC_FUNCTION(void) ovr_ClearShouldRecenterFlag(ovrSession session) {
-  if (!API.ovr_ClearShouldRecenterFlag.Ptr)
+  if (!OVR_RESOLVE(ovr_ClearShouldRecenterFlag))
     return;
   API.ovr_ClearShouldRecenterFlag.Ptr(session);
 }
 
 OVR_PUBLIC_FUNCTION(ovrTrackingState)
 ovr_GetTrackingState(ovrSession session, double absTime, ovrBool latencyMarker) {
-  if (!API.ovr_GetTrackingState.Ptr) {
+  if (!OVR_RESOLVE(ovr_GetTrackingState)) {
     ovrTrackingState nullTrackingState;
     memset(&nullTrackingState, 0, sizeof(nullTrackingState));
     return nullTrackingState;
@@ -1466,7 +1596,7 @@ ovr_GetDevicePoses(
     int deviceCount,
     double absTime,
     ovrPoseStatef* outDevicePoses) {
-  if (!API.ovr_GetDevicePoses.Ptr)
+  if (!OVR_RESOLVE(ovr_GetDevicePoses))
     return ovrError_NotInitialized;
   return API.ovr_GetDevicePoses.Ptr(session, deviceTypes, deviceCount, absTime, outDevicePoses);
 }
@@ -1477,7 +1607,7 @@ ovr_GetTrackingStateWithSensorData(
     double absTime,
     ovrBool latencyMarker,
     ovrSensorData* sensorData) {
-  if (!API.ovr_GetTrackingStateWithSensorData.Ptr) {
+  if (!OVR_RESOLVE(ovr_GetTrackingStateWithSensorData)) {
     ovrTrackingState nullTrackingState;
     memset(&nullTrackingState, 0, sizeof(nullTrackingState));
     if (sensorData)
@@ -1490,7 +1620,7 @@ ovr_GetTrackingStateWithSensorData(
 
 OVR_PUBLIC_FUNCTION(ovrTrackerPose)
 ovr_GetTrackerPose(ovrSession session, unsigned int trackerPoseIndex) {
-  if (!API.ovr_GetTrackerPose.Ptr) {
+  if (!OVR_RESOLVE(ovr_GetTrackerPose)) {
     ovrTrackerPose nullTrackerPose;
     memset(&nullTrackerPose, 0, sizeof(nullTrackerPose));
     return nullTrackerPose;
@@ -1501,7 +1631,7 @@ ovr_GetTrackerPose(ovrSession session, unsigned int trackerPoseIndex) {
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_GetInputState(ovrSession session, ovrControllerType controllerType, ovrInputState* inputState) {
-  if (!API.ovr_GetInputState.Ptr) {
+  if (!OVR_RESOLVE(ovr_GetInputState)) {
     if (inputState)
       memset(inputState, 0, sizeof(ovrInputState));
     return ovrError_NotInitialized;
@@ -1510,7 +1640,7 @@ ovr_GetInputState(ovrSession session, ovrControllerType controllerType, ovrInput
 }
 
 OVR_PUBLIC_FUNCTION(unsigned int) ovr_GetConnectedControllerTypes(ovrSession session) {
-  if (!API.ovr_GetConnectedControllerTypes.Ptr) {
+  if (!OVR_RESOLVE(ovr_GetConnectedControllerTypes)) {
     return 0;
   }
   return API.ovr_GetConnectedControllerTypes.Ptr(session);
@@ -1518,7 +1648,7 @@ OVR_PUBLIC_FUNCTION(unsigned int) ovr_GetConnectedControllerTypes(ovrSession ses
 
 OVR_PUBLIC_FUNCTION(ovrTouchHapticsDesc)
 ovr_GetTouchHapticsDesc(ovrSession session, ovrControllerType controllerType) {
-  if (!API.ovr_GetTouchHapticsDesc.Ptr) {
+  if (!OVR_RESOLVE(ovr_GetTouchHapticsDesc)) {
     ovrTouchHapticsDesc nullDesc;
     memset(&nullDesc, 0, sizeof(nullDesc));
     return nullDesc;
@@ -1533,7 +1663,7 @@ ovr_SetControllerVibration(
     ovrControllerType controllerType,
     float frequency,
     float amplitude) {
-  if (!API.ovr_SetControllerVibration.Ptr)
+  if (!OVR_RESOLVE(ovr_SetControllerVibration))
     return ovrError_NotInitialized;
 
   return API.ovr_SetControllerVibration.Ptr(session, controllerType, frequency, amplitude);
@@ -1544,7 +1674,7 @@ ovr_SubmitControllerVibration(
     ovrSession session,
     ovrControllerType controllerType,
     const ovrHapticsBuffer* buffer) {
-  if (!API.ovr_SubmitControllerVibration.Ptr)
+  if (!OVR_RESOLVE(ovr_SubmitControllerVibration))
     return ovrError_NotInitialized;
 
   return API.ovr_SubmitControllerVibration.Ptr(session, controllerType, buffer);
@@ -1555,7 +1685,7 @@ ovr_GetControllerVibrationState(
     ovrSession session,
     ovrControllerType controllerType,
     ovrHapticsPlaybackState* outState) {
-  if (!API.ovr_GetControllerVibrationState.Ptr)
+  if (!OVR_RESOLVE(ovr_GetControllerVibrationState))
     return ovrError_NotInitialized;
 
   return API.ovr_GetControllerVibrationState.Ptr(session, controllerType, outState);
@@ -1567,7 +1697,7 @@ ovr_TestBoundary(
     ovrTrackedDeviceType deviceBitmask,
     ovrBoundaryType singleBoundaryType,
     ovrBoundaryTestResult* outTestResult) {
-  if (!API.ovr_TestBoundary.Ptr)
+  if (!OVR_RESOLVE(ovr_TestBoundary))
     return ovrError_NotInitialized;
 
   return API.ovr_TestBoundary.Ptr(session, deviceBitmask, singleBoundaryType, outTestResult);
@@ -1579,7 +1709,7 @@ ovr_TestBoundaryPoint(
     const ovrVector3f* point,
     ovrBoundaryType singleBoundaryType,
     ovrBoundaryTestResult* outTestResult) {
-  if (!API.ovr_TestBoundaryPoint.Ptr)
+  if (!OVR_RESOLVE(ovr_TestBoundaryPoint))
     return ovrError_NotInitialized;
 
   return API.ovr_TestBoundaryPoint.Ptr(session, point, singleBoundaryType, outTestResult);
@@ -1587,14 +1717,14 @@ ovr_TestBoundaryPoint(
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_SetBoundaryLookAndFeel(ovrSession session, const ovrBoundaryLookAndFeel* lookAndFeel) {
-  if (!API.ovr_SetBoundaryLookAndFeel.Ptr)
+  if (!OVR_RESOLVE(ovr_SetBoundaryLookAndFeel))
     return ovrError_NotInitialized;
 
   return API.ovr_SetBoundaryLookAndFeel.Ptr(session, lookAndFeel);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_ResetBoundaryLookAndFeel(ovrSession session) {
-  if (!API.ovr_ResetBoundaryLookAndFeel.Ptr)
+  if (!OVR_RESOLVE(ovr_ResetBoundaryLookAndFeel))
     return ovrError_NotInitialized;
 
   return API.ovr_ResetBoundaryLookAndFeel.Ptr(session);
@@ -1606,7 +1736,7 @@ ovr_GetBoundaryGeometry(
     ovrBoundaryType singleBoundaryType,
     ovrVector3f* outFloorPoints,
     int* outFloorPointsCount) {
-  if (!API.ovr_GetBoundaryGeometry.Ptr)
+  if (!OVR_RESOLVE(ovr_GetBoundaryGeometry))
     return ovrError_NotInitialized;
 
   return API.ovr_GetBoundaryGeometry.Ptr(
@@ -1618,21 +1748,21 @@ ovr_GetBoundaryDimensions(
     ovrSession session,
     ovrBoundaryType singleBoundaryType,
     ovrVector3f* outDimensions) {
-  if (!API.ovr_GetBoundaryDimensions.Ptr)
+  if (!OVR_RESOLVE(ovr_GetBoundaryDimensions))
     return ovrError_NotInitialized;
 
   return API.ovr_GetBoundaryDimensions.Ptr(session, singleBoundaryType, outDimensions);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_GetBoundaryVisible(ovrSession session, ovrBool* outIsVisible) {
-  if (!API.ovr_GetBoundaryVisible.Ptr)
+  if (!OVR_RESOLVE(ovr_GetBoundaryVisible))
     return ovrError_NotInitialized;
 
   return API.ovr_GetBoundaryVisible.Ptr(session, outIsVisible);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_RequestBoundaryVisible(ovrSession session, ovrBool visible) {
-  if (!API.ovr_RequestBoundaryVisible.Ptr)
+  if (!OVR_RESOLVE(ovr_RequestBoundaryVisible))
     return ovrError_NotInitialized;
 
   return API.ovr_RequestBoundaryVisible.Ptr(session, visible);
@@ -1644,7 +1774,7 @@ ovr_GetFovTextureSize(
     ovrEyeType eye,
     ovrFovPort fov,
     float pixelsPerDisplayPixel) {
-  if (!API.ovr_GetFovTextureSize.Ptr) {
+  if (!OVR_RESOLVE(ovr_GetFovTextureSize)) {
     ovrSizei nullSize;
     memset(&nullSize, 0, sizeof(nullSize));
     return nullSize;
@@ -1660,7 +1790,7 @@ ovr_CreateTextureSwapChainDX(
     IUnknown* d3dPtr,
     const ovrTextureSwapChainDesc* desc,
     ovrTextureSwapChain* outTextureSet) {
-  if (!API.ovr_CreateTextureSwapChainDX.Ptr)
+  if (!OVR_RESOLVE(ovr_CreateTextureSwapChainDX))
     return ovrError_NotInitialized;
 
   return API.ovr_CreateTextureSwapChainDX.Ptr(session, d3dPtr, desc, outTextureSet);
@@ -1672,7 +1802,7 @@ ovr_CreateMirrorTextureDX(
     IUnknown* d3dPtr,
     const ovrMirrorTextureDesc* desc,
     ovrMirrorTexture* outMirrorTexture) {
-  if (!API.ovr_CreateMirrorTextureDX.Ptr)
+  if (!OVR_RESOLVE(ovr_CreateMirrorTextureDX))
     return ovrError_NotInitialized;
 
   return API.ovr_CreateMirrorTextureDX.Ptr(session, d3dPtr, desc, outMirrorTexture);
@@ -1684,7 +1814,7 @@ ovr_CreateMirrorTextureWithOptionsDX(
     IUnknown* d3dPtr,
     const ovrMirrorTextureDesc* desc,
     ovrMirrorTexture* outMirrorTexture) {
-  if (!API.ovr_CreateMirrorTextureWithOptionsDX.Ptr)
+  if (!OVR_RESOLVE(ovr_CreateMirrorTextureWithOptionsDX))
     return ovrError_NotInitialized;
 
   return API.ovr_CreateMirrorTextureWithOptionsDX.Ptr(session, d3dPtr, desc, outMirrorTexture);
@@ -1697,7 +1827,7 @@ ovr_GetTextureSwapChainBufferDX(
     int index,
     IID iid,
     void** ppObject) {
-  if (!API.ovr_GetTextureSwapChainBufferDX.Ptr)
+  if (!OVR_RESOLVE(ovr_GetTextureSwapChainBufferDX))
     return ovrError_NotInitialized;
 
   return API.ovr_GetTextureSwapChainBufferDX.Ptr(session, chain, index, iid, ppObject);
@@ -1709,49 +1839,49 @@ ovr_GetMirrorTextureBufferDX(
     ovrMirrorTexture mirror,
     IID iid,
     void** ppObject) {
-  if (!API.ovr_GetMirrorTextureBufferDX.Ptr)
+  if (!OVR_RESOLVE(ovr_GetMirrorTextureBufferDX))
     return ovrError_NotInitialized;
 
   return API.ovr_GetMirrorTextureBufferDX.Ptr(session, mirror, iid, ppObject);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_GetAudioDeviceOutWaveId(unsigned int* deviceOutId) {
-  if (!API.ovr_GetAudioDeviceOutWaveId.Ptr)
+  if (!OVR_RESOLVE(ovr_GetAudioDeviceOutWaveId))
     return ovrError_NotInitialized;
 
   return API.ovr_GetAudioDeviceOutWaveId.Ptr(deviceOutId);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_GetAudioDeviceInWaveId(unsigned int* deviceInId) {
-  if (!API.ovr_GetAudioDeviceInWaveId.Ptr)
+  if (!OVR_RESOLVE(ovr_GetAudioDeviceInWaveId))
     return ovrError_NotInitialized;
 
   return API.ovr_GetAudioDeviceInWaveId.Ptr(deviceInId);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_GetAudioDeviceOutGuidStr(WCHAR* deviceOutStrBuffer) {
-  if (!API.ovr_GetAudioDeviceOutGuidStr.Ptr)
+  if (!OVR_RESOLVE(ovr_GetAudioDeviceOutGuidStr))
     return ovrError_NotInitialized;
 
   return API.ovr_GetAudioDeviceOutGuidStr.Ptr(deviceOutStrBuffer);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_GetAudioDeviceOutGuid(GUID* deviceOutGuid) {
-  if (!API.ovr_GetAudioDeviceOutGuid.Ptr)
+  if (!OVR_RESOLVE(ovr_GetAudioDeviceOutGuid))
     return ovrError_NotInitialized;
 
   return API.ovr_GetAudioDeviceOutGuid.Ptr(deviceOutGuid);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_GetAudioDeviceInGuidStr(WCHAR* deviceInStrBuffer) {
-  if (!API.ovr_GetAudioDeviceInGuidStr.Ptr)
+  if (!OVR_RESOLVE(ovr_GetAudioDeviceInGuidStr))
     return ovrError_NotInitialized;
 
   return API.ovr_GetAudioDeviceInGuidStr.Ptr(deviceInStrBuffer);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_GetAudioDeviceInGuid(GUID* deviceInGuid) {
-  if (!API.ovr_GetAudioDeviceInGuid.Ptr)
+  if (!OVR_RESOLVE(ovr_GetAudioDeviceInGuid))
     return ovrError_NotInitialized;
 
   return API.ovr_GetAudioDeviceInGuid.Ptr(deviceInGuid);
@@ -1764,7 +1894,7 @@ ovr_CreateTextureSwapChainGL(
     ovrSession session,
     const ovrTextureSwapChainDesc* desc,
     ovrTextureSwapChain* outTextureSet) {
-  if (!API.ovr_CreateTextureSwapChainGL.Ptr)
+  if (!OVR_RESOLVE(ovr_CreateTextureSwapChainGL))
     return ovrError_NotInitialized;
 
   return API.ovr_CreateTextureSwapChainGL.Ptr(session, desc, outTextureSet);
@@ -1775,7 +1905,7 @@ ovr_CreateMirrorTextureGL(
     ovrSession session,
     const ovrMirrorTextureDesc* desc,
     ovrMirrorTexture* outMirrorTexture) {
-  if (!API.ovr_CreateMirrorTextureGL.Ptr)
+  if (!OVR_RESOLVE(ovr_CreateMirrorTextureGL))
     return ovrError_NotInitialized;
 
   return API.ovr_CreateMirrorTextureGL.Ptr(session, desc, outMirrorTexture);
@@ -1786,7 +1916,7 @@ ovr_CreateMirrorTextureWithOptionsGL(
     ovrSession session,
     const ovrMirrorTextureDesc* desc,
     ovrMirrorTexture* outMirrorTexture) {
-  if (!API.ovr_CreateMirrorTextureWithOptionsGL.Ptr)
+  if (!OVR_RESOLVE(ovr_CreateMirrorTextureWithOptionsGL))
     return ovrError_NotInitialized;
 
   return API.ovr_CreateMirrorTextureWithOptionsGL.Ptr(session, desc, outMirrorTexture);
@@ -1798,7 +1928,7 @@ ovr_GetTextureSwapChainBufferGL(
     ovrTextureSwapChain chain,
     int index,
     unsigned int* texId) {
-  if (!API.ovr_GetTextureSwapChainBufferGL.Ptr)
+  if (!OVR_RESOLVE(ovr_GetTextureSwapChainBufferGL))
     return ovrError_NotInitialized;
 
   return API.ovr_GetTextureSwapChainBufferGL.Ptr(session, chain, index, texId);
@@ -1806,7 +1936,7 @@ ovr_GetTextureSwapChainBufferGL(
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_GetMirrorTextureBufferGL(ovrSession session, ovrMirrorTexture mirror, unsigned int* texId) {
-  if (!API.ovr_GetMirrorTextureBufferGL.Ptr)
+  if (!OVR_RESOLVE(ovr_GetMirrorTextureBufferGL))
     return ovrError_NotInitialized;
 
   return API.ovr_GetMirrorTextureBufferGL.Ptr(session, mirror, texId);
@@ -1818,7 +1948,7 @@ ovr_GetInstanceExtensionsVk(
     ovrGraphicsLuid luid,
     char* extensionNames,
     uint32_t* inoutExtensionNamesSize) {
-  if (!API.ovr_GetInstanceExtensionsVk.Ptr)
+  if (!OVR_RESOLVE(ovr_GetInstanceExtensionsVk))
     return ovrError_NotInitialized;
 
   return API.ovr_GetInstanceExtensionsVk.Ptr(luid, extensionNames, inoutExtensionNamesSize);
@@ -1829,7 +1959,7 @@ ovr_GetDeviceExtensionsVk(
     ovrGraphicsLuid luid,
     char* extensionNames,
     uint32_t* inoutExtensionNamesSize) {
-  if (!API.ovr_GetDeviceExtensionsVk.Ptr)
+  if (!OVR_RESOLVE(ovr_GetDeviceExtensionsVk))
     return ovrError_NotInitialized;
 
   return API.ovr_GetDeviceExtensionsVk.Ptr(luid, extensionNames, inoutExtensionNamesSize);
@@ -1841,14 +1971,14 @@ ovr_GetSessionPhysicalDeviceVk(
     ovrGraphicsLuid luid,
     VkInstance instance,
     VkPhysicalDevice* out_physicalDevice) {
-  if (!API.ovr_GetSessionPhysicalDeviceVk.Ptr)
+  if (!OVR_RESOLVE(ovr_GetSessionPhysicalDeviceVk))
     return ovrError_NotInitialized;
 
   return API.ovr_GetSessionPhysicalDeviceVk.Ptr(session, luid, instance, out_physicalDevice);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_SetSynchronizationQueueVk(ovrSession session, VkQueue queue) {
-  if (!API.ovr_SetSynchronizationQueueVk.Ptr)
+  if (!OVR_RESOLVE(ovr_SetSynchronizationQueueVk))
     return ovrError_NotInitialized;
 
   return API.ovr_SetSynchronizationQueueVk.Ptr(session, queue);
@@ -1860,7 +1990,7 @@ ovr_CreateTextureSwapChainVk(
     VkDevice device,
     const ovrTextureSwapChainDesc* desc,
     ovrTextureSwapChain* out_TextureSwapChain) {
-  if (!API.ovr_CreateTextureSwapChainVk.Ptr)
+  if (!OVR_RESOLVE(ovr_CreateTextureSwapChainVk))
     return ovrError_NotInitialized;
 
   return API.ovr_CreateTextureSwapChainVk.Ptr(session, device, desc, out_TextureSwapChain);
@@ -1872,7 +2002,7 @@ ovr_GetTextureSwapChainBufferVk(
     ovrTextureSwapChain chain,
     int index,
     VkImage* out_Image) {
-  if (!API.ovr_GetTextureSwapChainBufferVk.Ptr)
+  if (!OVR_RESOLVE(ovr_GetTextureSwapChainBufferVk))
     return ovrError_NotInitialized;
 
   return API.ovr_GetTextureSwapChainBufferVk.Ptr(session, chain, index, out_Image);
@@ -1884,7 +2014,7 @@ ovr_CreateMirrorTextureWithOptionsVk(
     VkDevice device,
     const ovrMirrorTextureDesc* desc,
     ovrMirrorTexture* out_MirrorTexture) {
-  if (!API.ovr_CreateMirrorTextureWithOptionsVk.Ptr)
+  if (!OVR_RESOLVE(ovr_CreateMirrorTextureWithOptionsVk))
     return ovrError_NotInitialized;
 
   return API.ovr_CreateMirrorTextureWithOptionsVk.Ptr(session, device, desc, out_MirrorTexture);
@@ -1895,7 +2025,7 @@ ovr_GetMirrorTextureBufferVk(
     ovrSession session,
     ovrMirrorTexture mirrorTexture,
     VkImage* out_Image) {
-  if (!API.ovr_GetMirrorTextureBufferVk.Ptr)
+  if (!OVR_RESOLVE(ovr_GetMirrorTextureBufferVk))
     return ovrError_NotInitialized;
 
   return API.ovr_GetMirrorTextureBufferVk.Ptr(session, mirrorTexture, out_Image);
@@ -1904,7 +2034,7 @@ ovr_GetMirrorTextureBufferVk(
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_GetTextureSwapChainLength(ovrSession session, ovrTextureSwapChain chain, int* length) {
-  if (!API.ovr_GetTextureSwapChainLength.Ptr)
+  if (!OVR_RESOLVE(ovr_GetTextureSwapChainLength))
     return ovrError_NotInitialized;
 
   return API.ovr_GetTextureSwapChainLength.Ptr(session, chain, length);
@@ -1915,7 +2045,7 @@ ovr_GetTextureSwapChainCurrentIndex(
     ovrSession session,
     ovrTextureSwapChain chain,
     int* currentIndex) {
-  if (!API.ovr_GetTextureSwapChainCurrentIndex.Ptr)
+  if (!OVR_RESOLVE(ovr_GetTextureSwapChainCurrentIndex))
     return ovrError_NotInitialized;
 
   return API.ovr_GetTextureSwapChainCurrentIndex.Ptr(session, chain, currentIndex);
@@ -1926,7 +2056,7 @@ ovr_GetTextureSwapChainDesc(
     ovrSession session,
     ovrTextureSwapChain chain,
     ovrTextureSwapChainDesc* desc) {
-  if (!API.ovr_GetTextureSwapChainDesc.Ptr)
+  if (!OVR_RESOLVE(ovr_GetTextureSwapChainDesc))
     return ovrError_NotInitialized;
 
   return API.ovr_GetTextureSwapChainDesc.Ptr(session, chain, desc);
@@ -1934,7 +2064,7 @@ ovr_GetTextureSwapChainDesc(
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_CommitTextureSwapChain(ovrSession session, ovrTextureSwapChain chain) {
-  if (!API.ovr_CommitTextureSwapChain.Ptr)
+  if (!OVR_RESOLVE(ovr_CommitTextureSwapChain))
     return ovrError_NotInitialized;
 
   return API.ovr_CommitTextureSwapChain.Ptr(session, chain);
@@ -1942,7 +2072,7 @@ ovr_CommitTextureSwapChain(ovrSession session, ovrTextureSwapChain chain) {
 
 OVR_PUBLIC_FUNCTION(void)
 ovr_DestroyTextureSwapChain(ovrSession session, ovrTextureSwapChain chain) {
-  if (!API.ovr_DestroyTextureSwapChain.Ptr)
+  if (!OVR_RESOLVE(ovr_DestroyTextureSwapChain))
     return;
 
   API.ovr_DestroyTextureSwapChain.Ptr(session, chain);
@@ -1950,7 +2080,7 @@ ovr_DestroyTextureSwapChain(ovrSession session, ovrTextureSwapChain chain) {
 
 OVR_PUBLIC_FUNCTION(void)
 ovr_DestroyMirrorTexture(ovrSession session, ovrMirrorTexture mirrorTexture) {
-  if (!API.ovr_DestroyMirrorTexture.Ptr)
+  if (!OVR_RESOLVE(ovr_DestroyMirrorTexture))
     return;
 
   API.ovr_DestroyMirrorTexture.Ptr(session, mirrorTexture);
@@ -1961,7 +2091,7 @@ ovr_GetFovStencil(
     ovrSession session,
     const ovrFovStencilDesc* fovStencilDesc,
     ovrFovStencilMeshBuffer* meshBuffer) {
-  if (!API.ovr_GetFovStencil.Ptr)
+  if (!OVR_RESOLVE(ovr_GetFovStencil))
     return ovrError_NotInitialized;
 
   return API.ovr_GetFovStencil.Ptr(session, fovStencilDesc, meshBuffer);
@@ -1969,7 +2099,7 @@ ovr_GetFovStencil(
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_WaitToBeginFrame(ovrSession session, long long frameIndex) {
-  if (!API.ovr_WaitToBeginFrame.Ptr)
+  if (!OVR_RESOLVE(ovr_WaitToBeginFrame))
     return ovrError_NotInitialized;
 
   return API.ovr_WaitToBeginFrame.Ptr(session, frameIndex);
@@ -1977,7 +2107,7 @@ ovr_WaitToBeginFrame(ovrSession session, long long frameIndex) {
 
 OVR_PUBLIC_FUNCTION(ovrResult)
 ovr_BeginFrame(ovrSession session, long long frameIndex) {
-  if (!API.ovr_BeginFrame.Ptr)
+  if (!OVR_RESOLVE(ovr_BeginFrame))
     return ovrError_NotInitialized;
 
   return API.ovr_BeginFrame.Ptr(session, frameIndex);
@@ -1990,7 +2120,7 @@ ovr_EndFrame(
     const ovrViewScaleDesc* viewScaleDesc,
     ovrLayerHeader const* const* layerPtrList,
     unsigned int layerCount) {
-  if (!API.ovr_EndFrame.Ptr)
+  if (!OVR_RESOLVE(ovr_EndFrame))
     return ovrError_NotInitialized;
 
   return API.ovr_EndFrame.Ptr(session, frameIndex, viewScaleDesc, layerPtrList, layerCount);
@@ -2003,7 +2133,7 @@ ovr_SubmitFrame(
     const ovrViewScaleDesc* viewScaleDesc,
     ovrLayerHeader const* const* layerPtrList,
     unsigned int layerCount) {
-  if (!API.ovr_SubmitFrame.Ptr)
+  if (!OVR_RESOLVE(ovr_SubmitFrame))
     return ovrError_NotInitialized;
 
   return API.ovr_SubmitFrame.Ptr(session, frameIndex, viewScaleDesc, layerPtrList, layerCount);
@@ -2012,7 +2142,7 @@ ovr_SubmitFrame(
 
 OVR_PUBLIC_FUNCTION(ovrEyeRenderDesc)
 ovr_GetRenderDesc(ovrSession session, ovrEyeType eyeType, ovrFovPort fov) {
-  if (!API.ovr_GetRenderDesc.Ptr) {
+  if (!OVR_RESOLVE(ovr_GetRenderDesc)) {
     ovrEyeRenderDesc nullEyeRenderDesc;
     memset(&nullEyeRenderDesc, 0, sizeof(nullEyeRenderDesc));
     return nullEyeRenderDesc;
@@ -2021,68 +2151,68 @@ ovr_GetRenderDesc(ovrSession session, ovrEyeType eyeType, ovrFovPort fov) {
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_GetPerfStats(ovrSession session, ovrPerfStats* outPerfStats) {
-  if (!API.ovr_GetPerfStats.Ptr)
+  if (!OVR_RESOLVE(ovr_GetPerfStats))
     return ovrError_NotInitialized;
 
   return API.ovr_GetPerfStats.Ptr(session, outPerfStats);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_ResetPerfStats(ovrSession session) {
-  if (!API.ovr_ResetPerfStats.Ptr)
+  if (!OVR_RESOLVE(ovr_ResetPerfStats))
     return ovrError_NotInitialized;
 
   return API.ovr_ResetPerfStats.Ptr(session);
 }
 
 OVR_PUBLIC_FUNCTION(double) ovr_GetPredictedDisplayTime(ovrSession session, long long frameIndex) {
-  if (!API.ovr_GetPredictedDisplayTime.Ptr)
+  if (!OVR_RESOLVE(ovr_GetPredictedDisplayTime))
     return 0.0;
 
   return API.ovr_GetPredictedDisplayTime.Ptr(session, frameIndex);
 }
 
 OVR_PUBLIC_FUNCTION(double) ovr_GetTimeInSeconds() {
-  if (!API.ovr_GetTimeInSeconds.Ptr)
+  if (!OVR_RESOLVE(ovr_GetTimeInSeconds))
     return 0.;
   return API.ovr_GetTimeInSeconds.Ptr();
 }
 
 OVR_PUBLIC_FUNCTION(ovrBool)
 ovr_GetBool(ovrSession session, const char* propertyName, ovrBool defaultVal) {
-  if (!API.ovr_GetBool.Ptr)
+  if (!OVR_RESOLVE(ovr_GetBool))
     return ovrFalse;
   return API.ovr_GetBool.Ptr(session, propertyName, defaultVal);
 }
 
 OVR_PUBLIC_FUNCTION(ovrBool)
 ovr_SetBool(ovrSession session, const char* propertyName, ovrBool value) {
-  if (!API.ovr_SetBool.Ptr)
+  if (!OVR_RESOLVE(ovr_SetBool))
     return ovrFalse;
   return API.ovr_SetBool.Ptr(session, propertyName, value);
 }
 
 OVR_PUBLIC_FUNCTION(int) ovr_GetInt(ovrSession session, const char* propertyName, int defaultVal) {
-  if (!API.ovr_GetInt.Ptr)
+  if (!OVR_RESOLVE(ovr_GetInt))
     return 0;
   return API.ovr_GetInt.Ptr(session, propertyName, defaultVal);
 }
 
 OVR_PUBLIC_FUNCTION(ovrBool) ovr_SetInt(ovrSession session, const char* propertyName, int value) {
-  if (!API.ovr_SetInt.Ptr)
+  if (!OVR_RESOLVE(ovr_SetInt))
     return ovrFalse;
   return API.ovr_SetInt.Ptr(session, propertyName, value);
 }
 
 OVR_PUBLIC_FUNCTION(float)
 ovr_GetFloat(ovrSession session, const char* propertyName, float defaultVal) {
-  if (!API.ovr_GetFloat.Ptr)
+  if (!OVR_RESOLVE(ovr_GetFloat))
     return 0.f;
   return API.ovr_GetFloat.Ptr(session, propertyName, defaultVal);
 }
 
 OVR_PUBLIC_FUNCTION(ovrBool)
 ovr_SetFloat(ovrSession session, const char* propertyName, float value) {
-  if (!API.ovr_SetFloat.Ptr)
+  if (!OVR_RESOLVE(ovr_SetFloat))
     return ovrFalse;
   return API.ovr_SetFloat.Ptr(session, propertyName, value);
 }
@@ -2093,7 +2223,7 @@ ovr_GetFloatArray(
     const char* propertyName,
     float values[],
     unsigned int arraySize) {
-  if (!API.ovr_GetFloatArray.Ptr)
+  if (!OVR_RESOLVE(ovr_GetFloatArray))
     return 0;
   return API.ovr_GetFloatArray.Ptr(session, propertyName, values, arraySize);
 }
@@ -2104,41 +2234,41 @@ ovr_SetFloatArray(
     const char* propertyName,
     const float values[],
     unsigned int arraySize) {
-  if (!API.ovr_SetFloatArray.Ptr)
+  if (!OVR_RESOLVE(ovr_SetFloatArray))
     return ovrFalse;
   return API.ovr_SetFloatArray.Ptr(session, propertyName, values, arraySize);
 }
 
 OVR_PUBLIC_FUNCTION(const char*)
 ovr_GetString(ovrSession session, const char* propertyName, const char* defaultVal) {
-  if (!API.ovr_GetString.Ptr)
+  if (!OVR_RESOLVE(ovr_GetString))
     return "(Unable to load LibOVR)";
   return API.ovr_GetString.Ptr(session, propertyName, defaultVal);
 }
 
 OVR_PUBLIC_FUNCTION(ovrBool)
 ovr_SetString(ovrSession session, const char* propertyName, const char* value) {
-  if (!API.ovr_SetString.Ptr)
+  if (!OVR_RESOLVE(ovr_SetString))
     return ovrFalse;
   return API.ovr_SetString.Ptr(session, propertyName, value);
 }
 
 OVR_PUBLIC_FUNCTION(int) ovr_TraceMessage(int level, const char* message) {
-  if (!API.ovr_TraceMessage.Ptr)
+  if (!OVR_RESOLVE(ovr_TraceMessage))
     return -1;
 
   return API.ovr_TraceMessage.Ptr(level, message);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_IdentifyClient(const char* identity) {
-  if (!API.ovr_IdentifyClient.Ptr)
+  if (!OVR_RESOLVE(ovr_IdentifyClient))
     return ovrError_NotInitialized;
 
   return API.ovr_IdentifyClient.Ptr(identity);
 }
 
 OVR_PUBLIC_FUNCTION(ovrResult) ovr_Lookup(const char* name, void** data) {
-  if (!API.ovr_Lookup.Ptr)
+  if (!OVR_RESOLVE(ovr_Lookup))
     return ovrError_NotInitialized;
   return API.ovr_Lookup.Ptr(name, data);
 }
@@ -2148,7 +2278,7 @@ ovr_GetExternalCameras(
     ovrSession session,
     ovrExternalCamera* outCameras,
     unsigned int* outCameraCount) {
-  if (!API.ovr_GetExternalCameras.Ptr)
+  if (!OVR_RESOLVE(ovr_GetExternalCameras))
     return ovrError_NotInitialized;
   if (!outCameras || !outCameraCount)
     return ovrError_InvalidParameter;
@@ -2162,7 +2292,7 @@ ovr_SetExternalCameraProperties(
     const char* name,
     const ovrCameraIntrinsics* const intrinsics,
     const ovrCameraExtrinsics* const extrinsics) {
-  if (!API.ovr_SetExternalCameraProperties.Ptr)
+  if (!OVR_RESOLVE(ovr_SetExternalCameraProperties))
     return ovrError_NotInitialized;
   if (!name || (!intrinsics && !extrinsics))
     return ovrError_InvalidParameter;
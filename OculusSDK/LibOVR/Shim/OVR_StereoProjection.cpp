@@ -118,6 +118,68 @@ Matrix4f CreateProjection(
   return projection;
 }
 
+TimewarpProjection CreateTimewarpProjection(Matrix4f const& projection, bool isOpenGL) {
+  TimewarpProjection result;
+  result.Projection22 = projection.M[2][2];
+  result.Projection23 = projection.M[2][3];
+  result.Projection32 = projection.M[3][2];
+
+  if (isOpenGL) {
+    // Internally we use the D3D range of [0,+w] not the OGL one of [-w,+w], so we need to convert
+    // one to the other.
+    // Note that the values in the depth buffer, and the actual linear depth we want is the same for
+    // both APIs,
+    // the difference is purely in the values inside the projection matrix.
+
+    // D3D does this:
+    // depthBuffer =             ( ProjD3D.M[2][2] * linearDepth + ProjD3D.M[2][3] ) / ( linearDepth
+    // * ProjD3D.M[3][2] );
+    // OGL does this:
+    // depthBuffer = 0.5 + 0.5 * ( ProjOGL.M[2][2] * linearDepth + ProjOGL.M[2][3] ) / ( linearDepth
+    // * ProjOGL.M[3][2] );
+
+    // Therefore:
+    // ProjD3D.M[2][2] = 0.5 * ( ProjOGL.M[2][2] + ProjOGL.M[3][2] );
+    // ProjD3D.M[2][3] = 0.5 *   ProjOGL.M[2][3];
+    // ProjD3D.M[3][2] =         ProjOGL.M[3][2];
+
+    result.Projection22 = 0.5f * (projection.M[2][2] + projection.M[3][2]);
+    result.Projection23 = 0.5f * projection.M[2][3];
+  }
+
+  return result;
+}
+
+CachedProjection::CachedProjection()
+    : Valid(false), Fov(), ZNear(0.0f), ZFar(0.0f), Flags(0), Projection(), Timewarp() {}
+
+const Matrix4f& CachedProjection::Update(
+    bool leftHanded,
+    bool isOpenGL,
+    FovPort fov,
+    float zNear,
+    float zFar,
+    bool flipZ /*= false*/,
+    bool farAtInfinity /*= false*/) {
+  const unsigned flags = (leftHanded ? 1u : 0u) | (isOpenGL ? 2u : 0u) | (flipZ ? 4u : 0u) |
+      (farAtInfinity ? 8u : 0u);
+
+  if (!Valid || (fov.UpTan != Fov.UpTan) || (fov.DownTan != Fov.DownTan) ||
+      (fov.LeftTan != Fov.LeftTan) || (fov.RightTan != Fov.RightTan) || (zNear != ZNear) ||
+      (zFar != ZFar) || (flags != Flags)) {
+    Projection = CreateProjection(
+        leftHanded, isOpenGL, fov, StereoEye_Center, zNear, zFar, flipZ, farAtInfinity);
+    Timewarp = CreateTimewarpProjection(Projection, isOpenGL);
+    Fov = fov;
+    ZNear = zNear;
+    ZFar = zFar;
+    Flags = flags;
+    Valid = true;
+  }
+
+  return Projection;
+}
+
 Matrix4f CreateOrthoSubProjection(
     bool /*rightHanded*/,
     StereoEye eyeType,
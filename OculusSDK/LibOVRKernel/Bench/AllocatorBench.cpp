@@ -0,0 +1,560 @@
+/************************************************************************************
+
+Filename    :   AllocatorBench.cpp
+Content     :   Throughput, latency and memory use benchmark for the OVR::Allocator heaps
+Created     :   October 14, 2026
+Notes       :
+    Usage: AllocatorBench [-heap <name>|all] [-workload <name>|all] [-threads <count>]
+                          [-seconds <seconds>] [-csv]
+
+    Heaps are default, os, pool, largepage, debugpage and allocator. The last of these is
+    the default OVR::Allocator instance, which measures Allocator overhead (tracking,
+    sampling, stats) on top of whichever heap it has selected.
+
+    Workloads:
+        storm     Each thread frees and reallocates random slots of a set of live blocks.
+        handoff   Producer threads allocate blocks which paired consumer threads free.
+        aligned   Same as storm, but via AllocAligned/FreeAligned with 16 to 4096 alignment.
+        realloc   Arrays grow by one element at a time the way ArrayBase::Resize grows them.
+
+    Latency is sampled on one of every LatencySampleInterval operations per thread and is
+    subject to the resolution of the system's high resolution clock.
+    RSS is the process working set, sampled during the run. It reads as 0 on platforms
+    where Util::GetCurrentProcessMemoryInfo isn't implemented.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "Kernel/OVR_Allocator.h"
+#include "Util/Util_SystemInfo.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using namespace OVR;
+
+namespace {
+
+//-----------------------------------------------------------------------------------
+// ***** Settings
+//
+const size_t LiveSlotCount = 1024; // Live blocks per storm/aligned thread.
+const size_t MaxBlockSize = 8192; // Block sizes are log-distributed in [8, MaxBlockSize].
+const size_t MaxArrayElements = 16384; // Largest array grown by the realloc workload.
+const size_t HandoffCapacity = 4096; // Blocks in flight per producer/consumer pair.
+const uint32_t LatencySampleInterval = 8;
+const size_t MaxLatencySamples = 1 << 20; // Per thread, reserved before the run.
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//-----------------------------------------------------------------------------------
+// ***** AllocatorHeap
+//
+// Presents the default Allocator as a Heap, so that it can be measured like the others.
+//
+class AllocatorHeap : public Heap {
+ public:
+  virtual bool Init() {
+    return (Allocator::GetInstance() != nullptr);
+  }
+  virtual void Shutdown() {}
+
+  virtual void* Alloc(size_t size) {
+    return Allocator::GetInstance()->Alloc(size, "AllocatorBench");
+  }
+  virtual void* AllocAligned(size_t size, size_t align) {
+    return Allocator::GetInstance()->AllocAligned(size, align, "AllocatorBench");
+  }
+  virtual size_t GetAllocSize(const void* p) const {
+    return Allocator::GetInstance()->GetAllocSize(p);
+  }
+  virtual size_t GetAllocAlignedSize(const void* p, size_t align) const {
+    return Allocator::GetInstance()->GetAllocAlignedSize(p, align);
+  }
+  virtual void Free(void* p) {
+    Allocator::GetInstance()->Free(p);
+  }
+  virtual void FreeAligned(void* p) {
+    Allocator::GetInstance()->FreeAligned(p);
+  }
+  virtual void* Realloc(void* p, size_t newSize) {
+    return Allocator::GetInstance()->Realloc(p, newSize);
+  }
+  virtual void* ReallocAligned(void* p, size_t newSize, size_t newAlign) {
+    return Allocator::GetInstance()->ReallocAligned(p, newSize, newAlign);
+  }
+};
+
+struct HeapDesc {
+  const char* Name;
+  Heap* (*Create)();
+  bool AlignedSupported; // False if the heap fails AllocAligned, as OSHeap does with Windows.
+};
+
+template <class H>
+Heap* CreateHeap() {
+  return new H;
+}
+
+#if defined(_WIN32)
+const bool OSHeapAlignedSupported = false;
+#else
+const bool OSHeapAlignedSupported = true;
+#endif
+
+const HeapDesc HeapDescs[] = {{"default", CreateHeap<DefaultHeap>, true},
+                              {"os", CreateHeap<OSHeap>, OSHeapAlignedSupported},
+                              {"pool", CreateHeap<PoolHeap>, true},
+                              {"largepage", CreateHeap<LargePageHeap>, OSHeapAlignedSupported},
+                              {"debugpage", CreateHeap<DebugPageHeap>, true},
+                              {"allocator", CreateHeap<AllocatorHeap>, true}};
+
+//-----------------------------------------------------------------------------------
+// ***** HandoffQueue
+//
+// Single producer, single consumer ring of blocks, for the handoff workload.
+//
+struct HandoffQueue {
+  std::atomic<size_t> Head; // Next slot to pop. Written only by the consumer.
+  char Padding0[64];
+  std::atomic<size_t> Tail; // Next slot to push. Written only by the producer.
+  char Padding1[64];
+  std::atomic<bool> ProducerDone;
+  void* Slots[HandoffCapacity];
+
+  HandoffQueue() : Head(0), Tail(0), ProducerDone(false) {}
+};
+
+//-----------------------------------------------------------------------------------
+// ***** WorkerState
+//
+struct WorkerState {
+  Heap* TestHeap;
+  size_t ThreadIndex;
+  const std::atomic<bool>* Stop;
+  HandoffQueue* Queue; // Used by the handoff workload only.
+  uint64_t RandomState;
+  uint64_t OpCount;
+  uint32_t OpsUntilSample;
+  std::vector<uint32_t> Latencies; // In nanoseconds.
+
+  uint32_t Random() {
+    RandomState ^= RandomState << 13;
+    RandomState ^= RandomState >> 7;
+    RandomState ^= RandomState << 17;
+    return (uint32_t)(RandomState >> 32);
+  }
+
+  // Returns a size in [8, MaxBlockSize], with each power of two range being equally likely.
+  size_t RandomSize() {
+    size_t base = (size_t)8 << (Random() % 10);
+    return std::min(base + (Random() & (base - 1)), MaxBlockSize);
+  }
+
+  // Returns true if the next operation should be timed.
+  bool BeginOp() {
+    OpCount++;
+    if (--OpsUntilSample)
+      return false;
+    OpsUntilSample = LatencySampleInterval;
+    return (Latencies.size() < Latencies.capacity());
+  }
+
+  void EndOp(const Clock::time_point& start) {
+    Latencies.push_back((uint32_t)std::min<int64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count(),
+        UINT32_MAX));
+  }
+};
+
+// Wraps a heap operation, timing it if it's due to be sampled.
+template <class Op>
+inline auto TimedOp(WorkerState& state, Op op) -> decltype(op()) {
+  if (state.BeginOp()) {
+    Clock::time_point start = Clock::now();
+    auto result = op();
+    state.EndOp(start);
+    return result;
+  }
+  return op();
+}
+
+// Touches the block, as callers would, so that the cost of faulting in its pages is counted.
+inline void TouchBlock(void* p, size_t size) {
+  if (p) {
+    static_cast<uint8_t*>(p)[0] = 1;
+    static_cast<uint8_t*>(p)[size - 1] = 1;
+  }
+}
+
+//-----------------------------------------------------------------------------------
+// ***** Workloads
+//
+void RunStorm(WorkerState& state, bool aligned) {
+  void* slots[LiveSlotCount] = {};
+  Heap* heap = state.TestHeap;
+
+  while (!state.Stop->load(std::memory_order_relaxed)) {
+    void*& slot = slots[state.Random() % LiveSlotCount];
+
+    if (slot) {
+      void* p = slot;
+      TimedOp(state, [&] {
+        aligned ? heap->FreeAligned(p) : heap->Free(p);
+        return 0;
+      });
+    }
+
+    size_t size = state.RandomSize();
+    size_t align = (size_t)16 << (state.Random() % 9);
+    slot = TimedOp(
+        state, [&] { return aligned ? heap->AllocAligned(size, align) : heap->Alloc(size); });
+    TouchBlock(slot, size);
+  }
+
+  for (void* p : slots) {
+    if (p)
+      aligned ? heap->FreeAligned(p) : heap->Free(p);
+  }
+}
+
+void RunHandoffProducer(WorkerState& state) {
+  HandoffQueue& queue = *state.Queue;
+  size_t tail = queue.Tail.load(std::memory_order_relaxed);
+
+  while (!state.Stop->load(std::memory_order_relaxed)) {
+    if ((tail - queue.Head.load(std::memory_order_acquire)) == HandoffCapacity) {
+      std::this_thread::yield(); // The consumer is behind.
+      continue;
+    }
+
+    size_t size = state.RandomSize();
+    void* p = TimedOp(state, [&] { return state.TestHeap->Alloc(size); });
+    TouchBlock(p, size);
+
+    queue.Slots[tail % HandoffCapacity] = p;
+    queue.Tail.store(++tail, std::memory_order_release);
+  }
+
+  queue.ProducerDone.store(true, std::memory_order_release);
+}
+
+void RunHandoffConsumer(WorkerState& state) {
+  HandoffQueue& queue = *state.Queue;
+  size_t head = queue.Head.load(std::memory_order_relaxed);
+
+  for (;;) {
+    bool done = queue.ProducerDone.load(std::memory_order_acquire);
+
+    if (head == queue.Tail.load(std::memory_order_acquire)) {
+      if (done)
+        break;
+      std::this_thread::yield(); // The producer is behind.
+      continue;
+    }
+
+    void* p = queue.Slots[head % HandoffCapacity];
+    TimedOp(state, [&] {
+      state.TestHeap->Free(p);
+      return 0;
+    });
+    queue.Head.store(++head, std::memory_order_release);
+  }
+}
+
+void RunHandoff(WorkerState& state) {
+  if (state.ThreadIndex & 1)
+    RunHandoffConsumer(state);
+  else
+    RunHandoffProducer(state);
+}
+
+void RunRealloc(WorkerState& state) {
+  Heap* heap = state.TestHeap;
+
+  while (!state.Stop->load(std::memory_order_relaxed)) {
+    size_t targetSize = 1 + (state.Random() % MaxArrayElements);
+    uint64_t* data = nullptr;
+    size_t capacity = 0;
+
+    // Mimic ArrayBase::ResizeNoConstruct and Reserve with the default granularity of 4.
+    for (size_t size = 1; size <= targetSize; ++size) {
+      if (size >= capacity) {
+        capacity = ((size + (size >> 2)) + 3) / 4 * 4;
+        uint64_t* newData = static_cast<uint64_t*>(
+            TimedOp(state, [&] { return heap->Realloc(data, capacity * sizeof(uint64_t)); }));
+        if (!newData)
+          break;
+        data = newData;
+      }
+      data[size - 1] = size;
+    }
+
+    TimedOp(state, [&] {
+      heap->Free(data);
+      return 0;
+    });
+  }
+}
+
+struct WorkloadDesc {
+  const char* Name;
+  void (*Run)(WorkerState& state);
+  bool NeedsThreadPairs;
+  bool NeedsAligned;
+};
+
+const WorkloadDesc WorkloadDescs[] = {
+    {"storm", [](WorkerState& state) { RunStorm(state, false); }, false, false},
+    {"handoff", RunHandoff, true, false},
+    {"aligned", [](WorkerState& state) { RunStorm(state, true); }, false, true},
+    {"realloc", RunRealloc, false, false}};
+
+//-----------------------------------------------------------------------------------
+// ***** Running and reporting
+//
+struct BenchResult {
+  size_t ThreadCount;
+  double OpsPerSecond;
+  uint32_t P50Ns;
+  uint32_t P99Ns;
+  uint32_t MaxNs;
+  uint64_t PeakRSS; // Bytes.
+  int64_t RSSDelta; // Bytes, from before the heap was created to the peak.
+};
+
+uint64_t GetRSS() {
+  return OVR::Util::GetCurrentProcessMemoryInfo().UsedMemory;
+}
+
+bool RunBench(
+    const HeapDesc& heapDesc,
+    const WorkloadDesc& workload,
+    size_t threadCount,
+    double seconds,
+    BenchResult& result) {
+  if (workload.NeedsThreadPairs)
+    threadCount = std::max<size_t>(2, threadCount & ~(size_t)1);
+
+  const uint64_t startRSS = GetRSS();
+
+  Heap* heap = heapDesc.Create();
+  if (!heap->Init()) {
+    delete heap;
+    return false;
+  }
+
+  std::atomic<bool> stop(false);
+  std::vector<HandoffQueue*> queues;
+  std::vector<WorkerState> states(threadCount);
+
+  for (size_t i = 0; i < threadCount; ++i) {
+    WorkerState& state = states[i];
+    state.TestHeap = heap;
+    state.ThreadIndex = i;
+    state.Stop = &stop;
+    if (workload.NeedsThreadPairs && !(i & 1))
+      queues.push_back(new HandoffQueue);
+    state.Queue = workload.NeedsThreadPairs ? queues.back() : nullptr;
+    state.RandomState = UINT64_C(0x9E3779B97F4A7C15) * (i + 1);
+    state.OpCount = 0;
+    state.OpsUntilSample = LatencySampleInterval;
+    state.Latencies.reserve(MaxLatencySamples);
+  }
+
+  std::vector<std::thread> threads;
+  const Clock::time_point startTime = Clock::now();
+
+  for (WorkerState& state : states)
+    threads.emplace_back([&workload, &state] { workload.Run(state); });
+
+  // Sample RSS periodically while the workload runs. It costs about 1ms per call on Windows.
+  uint64_t peakRSS = GetRSS();
+  const Clock::time_point endTime =
+      startTime + std::chrono::microseconds((int64_t)(seconds * 1000000));
+
+  while (Clock::now() < endTime) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    peakRSS = std::max(peakRSS, GetRSS());
+  }
+
+  stop.store(true);
+  for (std::thread& thread : threads)
+    thread.join();
+
+  const double elapsed = std::chrono::duration<double>(Clock::now() - startTime).count();
+
+  heap->Shutdown();
+  delete heap;
+  for (HandoffQueue* queue : queues)
+    delete queue;
+
+  std::vector<uint32_t> latencies;
+  uint64_t opCount = 0;
+
+  for (WorkerState& state : states) {
+    opCount += state.OpCount;
+    latencies.insert(latencies.end(), state.Latencies.begin(), state.Latencies.end());
+    std::vector<uint32_t>().swap(state.Latencies);
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+
+  auto percentile = [&latencies](double p) -> uint32_t {
+    if (latencies.empty())
+      return 0;
+    return latencies[std::min(latencies.size() - 1, (size_t)(p * (double)latencies.size()))];
+  };
+
+  result.ThreadCount = threadCount;
+  result.OpsPerSecond = (elapsed > 0) ? ((double)opCount / elapsed) : 0;
+  result.P50Ns = percentile(0.50);
+  result.P99Ns = percentile(0.99);
+  result.MaxNs = latencies.empty() ? 0 : latencies.back();
+  result.PeakRSS = peakRSS;
+  result.RSSDelta = (int64_t)peakRSS - (int64_t)startRSS;
+
+  return true;
+}
+
+void PrintUsage() {
+  printf(
+      "Usage: AllocatorBench [-heap <name>|all] [-workload <name>|all] [-threads <count>]\n"
+      "                      [-seconds <seconds>] [-csv]\n");
+  printf("Heaps:");
+  for (const HeapDesc& desc : HeapDescs)
+    printf(" %s", desc.Name);
+  printf("\nWorkloads:");
+  for (const WorkloadDesc& desc : WorkloadDescs)
+    printf(" %s", desc.Name);
+  printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const char* heapName = "all";
+  const char* workloadName = "all";
+  size_t threadCount = std::max(1u, std::min(8u, std::thread::hardware_concurrency()));
+  double seconds = 2;
+  bool csv = false;
+
+  for (int i = 1; i < argc; ++i) {
+    const bool hasValue = (i + 1) < argc;
+
+    if (!strcmp(argv[i], "-heap") && hasValue)
+      heapName = argv[++i];
+    else if (!strcmp(argv[i], "-workload") && hasValue)
+      workloadName = argv[++i];
+    else if (!strcmp(argv[i], "-threads") && hasValue)
+      threadCount = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-seconds") && hasValue)
+      seconds = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-csv"))
+      csv = true;
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  if (csv)
+    printf(
+        "heap,workload,threads,ops_per_sec,p50_ns,p99_ns,max_ns,peak_rss_bytes,"
+        "rss_delta_bytes\n");
+  else
+    printf(
+        "%-10s %-8s %7s %12s %8s %8s %10s %9s %9s\n",
+        "Heap",
+        "Workload",
+        "Threads",
+        "Ops/s",
+        "p50 ns",
+        "p99 ns",
+        "max ns",
+        "RSS MiB",
+        "+RSS MiB");
+
+  bool found = false;
+
+  for (const HeapDesc& heapDesc : HeapDescs) {
+    if (strcmp(heapName, "all") && strcmp(heapName, heapDesc.Name))
+      continue;
+
+    for (const WorkloadDesc& workload : WorkloadDescs) {
+      if (strcmp(workloadName, "all") && strcmp(workloadName, workload.Name))
+        continue;
+
+      found = true;
+
+      if (workload.NeedsAligned && !heapDesc.AlignedSupported) {
+        if (!csv)
+          printf("%-10s %-8s (unsupported by this heap)\n", heapDesc.Name, workload.Name);
+        continue;
+      }
+      BenchResult result;
+
+      if (!RunBench(heapDesc, workload, threadCount, seconds, result)) {
+        fprintf(stderr, "Failed to initialize the %s heap.\n", heapDesc.Name);
+        continue;
+      }
+
+      if (csv) {
+        printf(
+            "%s,%s,%u,%.0f,%u,%u,%u,%llu,%lld\n",
+            heapDesc.Name,
+            workload.Name,
+            (unsigned)result.ThreadCount,
+            result.OpsPerSecond,
+            result.P50Ns,
+            result.P99Ns,
+            result.MaxNs,
+            (unsigned long long)result.PeakRSS,
+            (long long)result.RSSDelta);
+      } else {
+        printf(
+            "%-10s %-8s %7u %12.0f %8u %8u %10u %9.1f %9.1f\n",
+            heapDesc.Name,
+            workload.Name,
+            (unsigned)result.ThreadCount,
+            result.OpsPerSecond,
+            result.P50Ns,
+            result.P99Ns,
+            result.MaxNs,
+            (double)result.PeakRSS / (1024 * 1024),
+            (double)result.RSSDelta / (1024 * 1024));
+      }
+
+      fflush(stdout);
+    }
+  }
+
+  if (!found) {
+    PrintUsage();
+    return 1;
+  }
+
+  return 0;
+}
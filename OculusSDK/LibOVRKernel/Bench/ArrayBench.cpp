@@ -0,0 +1,303 @@
+/************************************************************************************
+
+Filename    :   ArrayBench.cpp
+Content     :   Append benchmark comparing OVR::Array growth policies with std::vector
+Created     :   October 14, 2026
+Notes       :
+    Usage: ArrayBench [-type <name>|all] [-size <count>|all] [-seconds <seconds>] [-csv]
+
+    Types:
+        vertex    A 32 byte trivially copyable struct, in Array.
+        string    OVR::String, in Array (ContainerAllocator, relocated by Realloc).
+        stdstring std::string, in ArrayCPP (relocated by move construction).
+
+    Each builds an array of size elements from empty, and is timed for:
+        Array     The default policy, via PushBack of a constructed element.
+        Geometric ArrayGeometricPolicy<>, via EmplaceBack.
+        vector    std::vector, via emplace_back.
+
+    Each type/size combination is repeated until it has run for at least the given
+    number of seconds, and the mean time per appended element is reported.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_String.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace OVR;
+
+namespace {
+
+//-----------------------------------------------------------------------------------
+// ***** Settings
+//
+const size_t ArraySizes[] = {16, 1024, 65536, 1048576};
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//-----------------------------------------------------------------------------------
+// ***** Elements
+//
+struct Vertex {
+  float Pos[3];
+  float UV[2];
+  float Normal[2];
+  uint32_t Color;
+
+  Vertex() {}
+  Vertex(float x, float y, float z, uint32_t color) : Color(color) {
+    Pos[0] = x;
+    Pos[1] = y;
+    Pos[2] = z;
+    UV[0] = UV[1] = 0;
+    Normal[0] = Normal[1] = 0;
+  }
+};
+
+// Built outside the timed loop. The strings are longer than std::string's small string buffer.
+struct Sources {
+  std::vector<std::string> Strings;
+
+  explicit Sources(size_t size) {
+    char buffer[64];
+    for (size_t i = 0; i < size; ++i) {
+      snprintf(
+          buffer, sizeof(buffer), "Scene/Objects/Mesh_%08x/Name", (unsigned)(i * 2654435761u));
+      Strings.push_back(buffer);
+    }
+  }
+};
+
+inline float ToFloat(size_t i) {
+  return (float)(i & 1023);
+}
+
+// Appends element i, constructed as the benchmark being run does it.
+template <class T>
+struct Appender;
+
+template <>
+struct Appender<Vertex> {
+  template <class A>
+  static void PushBack(A& a, const Sources&, size_t i) {
+    a.PushBack(Vertex(ToFloat(i), 1.0f, 2.0f, (uint32_t)i));
+  }
+  template <class A>
+  static void EmplaceBack(A& a, const Sources&, size_t i) {
+    a.EmplaceBack(ToFloat(i), 1.0f, 2.0f, (uint32_t)i);
+  }
+  template <class A>
+  static void EmplaceBackStd(A& a, const Sources&, size_t i) {
+    a.emplace_back(ToFloat(i), 1.0f, 2.0f, (uint32_t)i);
+  }
+};
+
+template <>
+struct Appender<String> {
+  template <class A>
+  static void PushBack(A& a, const Sources& s, size_t i) {
+    a.PushBack(String(s.Strings[i].c_str()));
+  }
+  template <class A>
+  static void EmplaceBack(A& a, const Sources& s, size_t i) {
+    a.EmplaceBack(s.Strings[i].c_str());
+  }
+  template <class A>
+  static void EmplaceBackStd(A& a, const Sources& s, size_t i) {
+    a.emplace_back(s.Strings[i].c_str());
+  }
+};
+
+template <>
+struct Appender<std::string> {
+  template <class A>
+  static void PushBack(A& a, const Sources& s, size_t i) {
+    a.PushBack(std::string(s.Strings[i]));
+  }
+  template <class A>
+  static void EmplaceBack(A& a, const Sources& s, size_t i) {
+    a.EmplaceBack(s.Strings[i]);
+  }
+  template <class A>
+  static void EmplaceBackStd(A& a, const Sources& s, size_t i) {
+    a.emplace_back(s.Strings[i]);
+  }
+};
+
+//-----------------------------------------------------------------------------------
+// ***** Workloads
+//
+// Each builds one array from empty and returns the number of elements appended. Sink keeps
+// the array from being optimized out.
+//
+volatile size_t Sink;
+
+template <class A, class T>
+size_t RunPushBack(const Sources& sources, size_t size) {
+  A a;
+  for (size_t i = 0; i < size; ++i)
+    Appender<T>::PushBack(a, sources, i);
+  Sink = a.GetSize();
+  return size;
+}
+
+template <class A, class T>
+size_t RunEmplaceBack(const Sources& sources, size_t size) {
+  A a;
+  for (size_t i = 0; i < size; ++i)
+    Appender<T>::EmplaceBack(a, sources, i);
+  Sink = a.GetSize();
+  return size;
+}
+
+template <class T>
+size_t RunVector(const Sources& sources, size_t size) {
+  std::vector<T> a;
+  for (size_t i = 0; i < size; ++i)
+    Appender<T>::EmplaceBackStd(a, sources, i);
+  Sink = a.size();
+  return size;
+}
+
+//-----------------------------------------------------------------------------------
+// ***** RunBench
+//
+// Returns the mean nanoseconds per element.
+//
+template <class Run>
+double RunBench(Run run, double seconds) {
+  uint64_t opCount = 0;
+  const Clock::time_point startTime = Clock::now();
+  double elapsed = 0;
+
+  do {
+    opCount += run();
+    elapsed = std::chrono::duration<double>(Clock::now() - startTime).count();
+  } while (elapsed < seconds);
+
+  return (elapsed * 1e9) / (double)opCount;
+}
+
+struct Options {
+  size_t Size; // 0 for all of ArraySizes.
+  double Seconds;
+  bool Csv;
+};
+
+template <class T, class ArrayType, class GeometricArrayType>
+void RunType(const char* typeName, const Options& options) {
+  for (size_t size : ArraySizes) {
+    if (options.Size)
+      size = options.Size;
+
+    const Sources sources(std::is_same<T, Vertex>::value ? 0 : size);
+
+    const double arrayNs =
+        RunBench([&] { return RunPushBack<ArrayType, T>(sources, size); }, options.Seconds);
+    const double geometricNs = RunBench(
+        [&] { return RunEmplaceBack<GeometricArrayType, T>(sources, size); }, options.Seconds);
+    const double vectorNs = RunBench([&] { return RunVector<T>(sources, size); }, options.Seconds);
+
+    if (options.Csv)
+      printf("%s,%u,%.2f,%.2f,%.2f\n", typeName, (unsigned)size, arrayNs, geometricNs, vectorNs);
+    else
+      printf(
+          "%-10s %8u %10.2f %10.2f %10.2f\n",
+          typeName,
+          (unsigned)size,
+          arrayNs,
+          geometricNs,
+          vectorNs);
+
+    fflush(stdout);
+
+    if (options.Size)
+      break;
+  }
+}
+
+void PrintUsage() {
+  printf("Usage: ArrayBench [-type <name>|all] [-size <count>|all] [-seconds <seconds>] [-csv]\n");
+  printf("Types: vertex string stdstring\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const char* typeName = "all";
+  Options options = {0, 0.5, false};
+
+  for (int i = 1; i < argc; ++i) {
+    const bool hasValue = (i + 1) < argc;
+
+    if (!strcmp(argv[i], "-type") && hasValue)
+      typeName = argv[++i];
+    else if (!strcmp(argv[i], "-size") && hasValue) {
+      ++i;
+      options.Size = strcmp(argv[i], "all") ? (size_t)std::max(1, atoi(argv[i])) : 0;
+    } else if (!strcmp(argv[i], "-seconds") && hasValue)
+      options.Seconds = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-csv"))
+      options.Csv = true;
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  if (options.Csv)
+    printf("type,size,array_ns_per_element,geometric_ns_per_element,vector_ns_per_element\n");
+  else
+    printf("%-10s %8s %10s %10s %10s\n", "Type", "Size", "Array ns", "Geom ns", "vector ns");
+
+  bool found = false;
+
+  if (!strcmp(typeName, "all") || !strcmp(typeName, "vertex")) {
+    RunType<Vertex, Array<Vertex>, Array<Vertex, ArrayGeometricPolicy<>>>("vertex", options);
+    found = true;
+  }
+
+  if (!strcmp(typeName, "all") || !strcmp(typeName, "string")) {
+    RunType<String, Array<String>, Array<String, ArrayGeometricPolicy<>>>("string", options);
+    found = true;
+  }
+
+  if (!strcmp(typeName, "all") || !strcmp(typeName, "stdstring")) {
+    RunType<std::string, ArrayCPP<std::string>, ArrayCPP<std::string, ArrayGeometricPolicy<>>>(
+        "stdstring", options);
+    found = true;
+  }
+
+  if (!found) {
+    PrintUsage();
+    return 1;
+  }
+
+  return 0;
+}
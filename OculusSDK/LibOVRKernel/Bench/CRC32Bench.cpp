@@ -0,0 +1,271 @@
+/************************************************************************************
+
+Filename    :   CRC32Bench.cpp
+Content     :   Throughput benchmark for the OVR_CRC32 functions
+Created     :   October 14, 2026
+Notes       :
+    Usage: CRC32Bench [-crc <name>|all] [-size <bytes>|all] [-seconds <seconds>] [-csv]
+
+    CRCs are standard (Standard_CRC32), castagnoli (Castagnoli_CRC32) and camera
+    (OculusCamera_CRC32). Each is timed over buffers of the given size, and compared with a
+    byte-at-a-time table loop, which is what the functions did before they had accelerated
+    paths. Results are checked against that loop too, and a mismatch fails the run.
+
+    Each CRC/size combination is repeated until it has run for at least the given number of
+    seconds, and the throughput is reported in GB/s.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "Kernel/OVR_CRC32.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace OVR;
+
+namespace {
+
+//-----------------------------------------------------------------------------------
+// ***** Settings
+//
+// Sizes cover a small message, a serialized blob, and a shared memory frame.
+//
+const size_t BufferSizes[] = {64, 4096, 1048576};
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//-----------------------------------------------------------------------------------
+// ***** Reference loops
+//
+// Byte-at-a-time table CRCs, used as the baseline and to check results.
+//
+uint32_t ReferenceReflected(const uint32_t* table, const uint8_t* p, size_t bytes) {
+  uint32_t crc = ~0u;
+  while (bytes--)
+    crc = (crc >> 8) ^ table[(crc ^ *p++) & 0xFF];
+  return ~crc;
+}
+
+uint32_t CameraTable[256];
+
+void MakeCameraTable() {
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t value = i << 24;
+    for (int bit = 0; bit < 8; ++bit)
+      value = (value & 0x80000000) ? ((value << 1) ^ 0x04C11DB7) : (value << 1);
+    CameraTable[i] = value;
+  }
+}
+
+uint32_t ReferenceCamera(const uint8_t* p, size_t bytes) {
+  uint32_t crc = 0;
+  while (bytes--)
+    crc = (crc << 8) ^ CameraTable[(crc >> 24) ^ *p++];
+  return ~crc;
+}
+
+enum CRC { CRCStandard, CRCCastagnoli, CRCCamera, CRCCount };
+
+const char* const CRCNames[CRCCount] = {"standard", "castagnoli", "camera"};
+
+uint32_t RunCRC(CRC crc, const uint8_t* p, size_t bytes) {
+  switch (crc) {
+    case CRCStandard:
+      return Standard_CRC32(p, (int)bytes);
+    case CRCCastagnoli:
+      return Castagnoli_CRC32(p, (int)bytes);
+    default:
+      return OculusCamera_CRC32(p, (int)bytes);
+  }
+}
+
+uint32_t RunReference(CRC crc, const uint8_t* p, size_t bytes) {
+  switch (crc) {
+    case CRCStandard:
+      return ReferenceReflected(CRC32_Table_CRC32, p, bytes);
+    case CRCCastagnoli:
+      return ReferenceReflected(CRC32_Table_CRC32_C, p, bytes);
+    default:
+      return ReferenceCamera(p, bytes);
+  }
+}
+
+//-----------------------------------------------------------------------------------
+// ***** RunBench
+//
+// Returns GB/s. Sink keeps the CRCs from being optimized out.
+//
+volatile uint32_t Sink;
+
+double RunBench(CRC crc, bool reference, const std::vector<uint8_t>& buffer, double seconds) {
+  uint64_t byteCount = 0;
+  uint32_t sum = 0;
+  const Clock::time_point startTime = Clock::now();
+  double elapsed = 0;
+
+  do {
+    for (int i = 0; i < 16; ++i) {
+      sum ^= reference ? RunReference(crc, buffer.data(), buffer.size())
+                       : RunCRC(crc, buffer.data(), buffer.size());
+      byteCount += buffer.size();
+    }
+
+    elapsed = std::chrono::duration<double>(Clock::now() - startTime).count();
+  } while (elapsed < seconds);
+
+  Sink = sum;
+  return ((double)byteCount / 1e9) / elapsed;
+}
+
+// Compares the CRC with the reference for every length up to 300 bytes, at each alignment, so
+// that the head and tail handling of each path is covered.
+bool CheckCRC(CRC crc, const std::vector<uint8_t>& buffer) {
+  for (size_t offset = 0; offset < 16; ++offset) {
+    for (size_t bytes = 0; bytes <= 300; ++bytes) {
+      const uint8_t* p = buffer.data() + offset;
+      if (RunCRC(crc, p, bytes) != RunReference(crc, p, bytes)) {
+        printf(
+            "%s mismatch at offset %u length %u\n",
+            CRCNames[crc],
+            (unsigned)offset,
+            (unsigned)bytes);
+        return false;
+      }
+    }
+  }
+
+  // Continuing a CRC must give the same result as computing it in one go.
+  if ((crc != CRCCamera) && (buffer.size() > 1000)) {
+    const uint32_t whole = RunCRC(crc, buffer.data(), 1000);
+    uint32_t part = (crc == CRCStandard) ? Standard_CRC32(buffer.data(), 333)
+                                         : Castagnoli_CRC32(buffer.data(), 333);
+    part = (crc == CRCStandard) ? Standard_CRC32(buffer.data() + 333, 667, part)
+                                : Castagnoli_CRC32(buffer.data() + 333, 667, part);
+    if (part != whole) {
+      printf("%s mismatch when continued\n", CRCNames[crc]);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+struct Options {
+  const char* CRCName;
+  size_t Size; // 0 for all of BufferSizes.
+  double Seconds;
+  bool Csv;
+};
+
+void PrintUsage() {
+  printf("Usage: CRC32Bench [-crc <name>|all] [-size <bytes>|all] [-seconds <seconds>] [-csv]\n");
+  printf("CRCs:");
+  for (const char* name : CRCNames)
+    printf(" %s", name);
+  printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options options = {"all", 0, 0.5, false};
+
+  for (int i = 1; i < argc; ++i) {
+    const bool hasValue = (i + 1) < argc;
+
+    if (!strcmp(argv[i], "-crc") && hasValue)
+      options.CRCName = argv[++i];
+    else if (!strcmp(argv[i], "-size") && hasValue) {
+      ++i;
+      options.Size = strcmp(argv[i], "all") ? (size_t)std::max(1, atoi(argv[i])) : 0;
+    } else if (!strcmp(argv[i], "-seconds") && hasValue)
+      options.Seconds = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-csv"))
+      options.Csv = true;
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  MakeCameraTable();
+
+  std::vector<uint8_t> checkBuffer(4096);
+  uint32_t state = 0x9E3779B9;
+  for (uint8_t& byte : checkBuffer) {
+    state = (state * 1664525) + 1013904223;
+    byte = (uint8_t)(state >> 24);
+  }
+
+  if (options.Csv)
+    printf("crc,size,reference_gbps,gbps\n");
+  else
+    printf("%-10s %8s %12s %12s %9s\n", "CRC", "Size", "Table GB/s", "GB/s", "Speedup");
+
+  bool found = false;
+
+  for (int c = 0; c < CRCCount; ++c) {
+    if (strcmp(options.CRCName, "all") && strcmp(options.CRCName, CRCNames[c]))
+      continue;
+
+    found = true;
+    if (!CheckCRC((CRC)c, checkBuffer))
+      return 2;
+
+    for (size_t size : BufferSizes) {
+      if (options.Size)
+        size = options.Size;
+
+      std::vector<uint8_t> buffer(size);
+      for (size_t i = 0; i < size; ++i)
+        buffer[i] = checkBuffer[i % checkBuffer.size()];
+
+      const double referenceGBps = RunBench((CRC)c, true, buffer, options.Seconds);
+      const double GBps = RunBench((CRC)c, false, buffer, options.Seconds);
+
+      if (options.Csv)
+        printf("%s,%u,%.3f,%.3f\n", CRCNames[c], (unsigned)size, referenceGBps, GBps);
+      else
+        printf(
+            "%-10s %8u %12.3f %12.3f %8.2fx\n",
+            CRCNames[c],
+            (unsigned)size,
+            referenceGBps,
+            GBps,
+            (referenceGBps > 0) ? (GBps / referenceGBps) : 0);
+
+      fflush(stdout);
+
+      if (options.Size)
+        break;
+    }
+  }
+
+  if (!found) {
+    PrintUsage();
+    return 1;
+  }
+
+  return 0;
+}
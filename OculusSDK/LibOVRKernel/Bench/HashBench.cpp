@@ -0,0 +1,332 @@
+/************************************************************************************
+
+Filename    :   HashBench.cpp
+Content     :   Lookup and update benchmark comparing OVR::FlatHash with OVR::Hash
+Created     :   October 14, 2026
+Notes       :
+    Usage: HashBench [-key <name>|all] [-workload <name>|all] [-size <count>|all]
+                     [-seconds <seconds>] [-csv]
+
+    Keys are uint32 (FixedSizeHash) and string (OVR::String with String::HashFunctor,
+    as StringHash uses for its keys).
+
+    Workloads:
+        insert    Builds a table of size entries from empty, via Set.
+        hit       Get of keys which are present, in random order.
+        miss      Get of keys which are absent, in random order.
+        churn     Remove of a present key followed by Set of a new one, at constant size.
+
+    Each table/workload/size combination is repeated until it has run for at least the
+    given number of seconds, and the mean time per operation is reported.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "Kernel/OVR_FlatHash.h"
+#include "Kernel/OVR_Hash.h"
+#include "Kernel/OVR_String.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace OVR;
+
+namespace {
+
+//-----------------------------------------------------------------------------------
+// ***** Settings
+//
+const size_t TableSizes[] = {64, 4096, 262144};
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//-----------------------------------------------------------------------------------
+// ***** Keys
+//
+// Each key set holds 2 * size distinct keys in random order. The first half is inserted into
+// the table and the second half is used for misses and for churn insertions.
+//
+struct KeyRandom {
+  uint64_t State;
+
+  explicit KeyRandom(uint64_t seed) : State(seed) {}
+
+  uint32_t Next() { // xorshift64*
+    State ^= State >> 12;
+    State ^= State << 25;
+    State ^= State >> 27;
+    return (uint32_t)((State * UINT64_C(2685821657736338717)) >> 32);
+  }
+};
+
+template <class K>
+K MakeKey(uint32_t n);
+
+template <>
+uint32_t MakeKey<uint32_t>(uint32_t n) {
+  return n;
+}
+
+template <>
+String MakeKey<String>(uint32_t n) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "Setting/%08x", n);
+  return String(buffer);
+}
+
+template <class K>
+void MakeKeys(size_t size, std::vector<K>& keys) {
+  std::vector<uint32_t> values;
+  KeyRandom random(UINT64_C(0x9E3779B97F4A7C15) ^ size);
+
+  while (values.size() < (2 * size)) {
+    values.push_back(random.Next());
+
+    if (values.size() == (2 * size)) { // Drop duplicates and fill back up to size.
+      std::sort(values.begin(), values.end());
+      values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+  }
+
+  for (size_t i = values.size() - 1; i > 0; --i)
+    std::swap(values[i], values[random.Next() % (i + 1)]);
+
+  keys.clear();
+  for (uint32_t value : values)
+    keys.push_back(MakeKey<K>(value));
+}
+
+//-----------------------------------------------------------------------------------
+// ***** Workloads
+//
+// Each returns the number of operations it did. Sink keeps lookups from being optimized out.
+//
+volatile uint32_t Sink;
+
+template <class Table, class K>
+size_t RunInsert(const std::vector<K>& keys, size_t size) {
+  Table table;
+  for (size_t i = 0; i < size; ++i)
+    table.Set(keys[i], (uint32_t)i);
+  Sink = (uint32_t)table.GetSize();
+  return size;
+}
+
+template <class Table, class K>
+size_t RunHit(Table& table, const std::vector<K>& keys, size_t size) {
+  uint32_t sum = 0;
+  for (size_t i = 0; i < size; ++i) {
+    const uint32_t* value = table.Get(keys[(i * 7919) % size]);
+    sum += value ? *value : 0;
+  }
+  Sink = sum;
+  return size;
+}
+
+template <class Table, class K>
+size_t RunMiss(Table& table, const std::vector<K>& keys, size_t size) {
+  uint32_t count = 0;
+  for (size_t i = 0; i < size; ++i)
+    count += table.Get(keys[size + i]) ? 1 : 0;
+  Sink = count;
+  return size;
+}
+
+// Cycles a window of size keys through the key set, so the table stays at size entries.
+template <class Table, class K>
+size_t RunChurn(Table& table, const std::vector<K>& keys, size_t size, size_t& cursor) {
+  const size_t keyCount = keys.size();
+  for (size_t i = 0; i < size; ++i) {
+    table.Remove(keys[cursor % keyCount]);
+    table.Set(keys[(cursor + size) % keyCount], (uint32_t)i);
+    cursor++;
+  }
+  return 2 * size;
+}
+
+enum Workload { WorkloadInsert, WorkloadHit, WorkloadMiss, WorkloadChurn, WorkloadCount };
+
+const char* const WorkloadNames[WorkloadCount] = {"insert", "hit", "miss", "churn"};
+
+//-----------------------------------------------------------------------------------
+// ***** RunBench
+//
+// Returns the mean nanoseconds per operation.
+//
+template <class Table, class K>
+double RunBench(Workload workload, const std::vector<K>& keys, size_t size, double seconds) {
+  Table table;
+  if (workload != WorkloadInsert) {
+    for (size_t i = 0; i < size; ++i)
+      table.Set(keys[i], (uint32_t)i);
+  }
+
+  size_t cursor = 0;
+  uint64_t opCount = 0;
+  const Clock::time_point startTime = Clock::now();
+  double elapsed = 0;
+
+  do {
+    switch (workload) {
+      case WorkloadInsert:
+        opCount += RunInsert<Table>(keys, size);
+        break;
+      case WorkloadHit:
+        opCount += RunHit(table, keys, size);
+        break;
+      case WorkloadMiss:
+        opCount += RunMiss(table, keys, size);
+        break;
+      default:
+        opCount += RunChurn(table, keys, size, cursor);
+        break;
+    }
+
+    elapsed = std::chrono::duration<double>(Clock::now() - startTime).count();
+  } while (elapsed < seconds);
+
+  return (elapsed * 1e9) / (double)opCount;
+}
+
+struct Options {
+  const char* WorkloadName;
+  size_t Size; // 0 for all of TableSizes.
+  double Seconds;
+  bool Csv;
+};
+
+template <class K, class HashType, class FlatHashType>
+bool RunKey(const char* keyName, const Options& options) {
+  bool found = false;
+
+  for (size_t size : TableSizes) {
+    if (options.Size)
+      size = options.Size;
+
+    std::vector<K> keys;
+    MakeKeys(size, keys);
+
+    for (int w = 0; w < WorkloadCount; ++w) {
+      if (strcmp(options.WorkloadName, "all") && strcmp(options.WorkloadName, WorkloadNames[w]))
+        continue;
+
+      found = true;
+
+      const double hashNs = RunBench<HashType>((Workload)w, keys, size, options.Seconds);
+      const double flatHashNs = RunBench<FlatHashType>((Workload)w, keys, size, options.Seconds);
+
+      if (options.Csv)
+        printf(
+            "%s,%s,%u,%.2f,%.2f\n",
+            keyName,
+            WorkloadNames[w],
+            (unsigned)size,
+            hashNs,
+            flatHashNs);
+      else
+        printf(
+            "%-8s %-8s %8u %10.2f %10.2f %8.2fx\n",
+            keyName,
+            WorkloadNames[w],
+            (unsigned)size,
+            hashNs,
+            flatHashNs,
+            (flatHashNs > 0) ? (hashNs / flatHashNs) : 0);
+
+      fflush(stdout);
+    }
+
+    if (options.Size)
+      break;
+  }
+
+  return found;
+}
+
+void PrintUsage() {
+  printf(
+      "Usage: HashBench [-key <name>|all] [-workload <name>|all] [-size <count>|all]\n"
+      "                 [-seconds <seconds>] [-csv]\n");
+  printf("Keys: uint32 string\nWorkloads:");
+  for (const char* name : WorkloadNames)
+    printf(" %s", name);
+  printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const char* keyName = "all";
+  Options options = {"all", 0, 0.5, false};
+
+  for (int i = 1; i < argc; ++i) {
+    const bool hasValue = (i + 1) < argc;
+
+    if (!strcmp(argv[i], "-key") && hasValue)
+      keyName = argv[++i];
+    else if (!strcmp(argv[i], "-workload") && hasValue)
+      options.WorkloadName = argv[++i];
+    else if (!strcmp(argv[i], "-size") && hasValue) {
+      ++i;
+      options.Size = strcmp(argv[i], "all") ? (size_t)std::max(1, atoi(argv[i])) : 0;
+    } else if (!strcmp(argv[i], "-seconds") && hasValue)
+      options.Seconds = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-csv"))
+      options.Csv = true;
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  if (options.Csv)
+    printf("key,workload,size,hash_ns_per_op,flathash_ns_per_op\n");
+  else
+    printf(
+        "%-8s %-8s %8s %10s %10s %9s\n",
+        "Key",
+        "Workload",
+        "Size",
+        "Hash ns",
+        "Flat ns",
+        "Speedup");
+
+  bool found = false;
+
+  if (!strcmp(keyName, "all") || !strcmp(keyName, "uint32"))
+    found |= RunKey<uint32_t, Hash<uint32_t, uint32_t>, FlatHash<uint32_t, uint32_t>>(
+        "uint32", options);
+
+  if (!strcmp(keyName, "all") || !strcmp(keyName, "string"))
+    found |= RunKey<
+        String,
+        Hash<String, uint32_t, String::HashFunctor>,
+        FlatHash<String, uint32_t, String::HashFunctor>>("string", options);
+
+  if (!found) {
+    PrintUsage();
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,1250 @@
+/************************************************************************************
+
+Filename    :   KernelBench.cpp
+Content     :   Benchmark suite covering the kernel primitives, with results for regression checks
+Created     :   October 14, 2026
+Notes       :
+    Usage: KernelBench [-filter <text>] [-seconds <seconds>] [-repetitions <count>]
+                       [-format console|csv|json] [-out <path>]
+                       [-baseline <results.json>] [-threshold <percent>]
+                       [-scene <scene.xml>] [-json <file.json>] [-capture <file.opc>] [-list]
+
+    Runs each benchmark whose name contains the filter text (all of them by default). A
+    benchmark is a loop over BenchState::KeepRunning, which is timed as a whole; its iteration
+    count grows until one run of the loop takes at least the given number of seconds, and then
+    the run is repeated. The median time per iteration is reported, with the fastest, and the
+    items and bytes per second the benchmark declares. The standalone benchmarks next to this
+    one (HashBench, LogBench...) sweep their primitive's options in more depth; this suite
+    runs a fixed set of cases quickly enough to run for every change.
+
+    Datasets:
+        scene     A scene XML. By default Samples/OculusWorldDemo/Assets/Tuscany/Tuscany.xml,
+                  looked for from the current directory and its parents.
+        json      A JSON document. By default a generated profile trace of 40000 events.
+        capture   A PerfCapture version 2 file. By default a generated capture of 4096 records.
+    Generated datasets use a fixed seed, so they are the same on every run. The name, size and
+    CRC of each dataset are part of the results, and a missing file skips the benchmarks which
+    use it.
+
+    -format json writes results which -baseline can read back. With a baseline, each benchmark
+    it has with the same name and datasets is compared, and the run fails if any median is
+    more than the threshold (10% by default) slower.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "Extras/OVR_Math.h"
+#include "Kernel/OVR_Array.h"
+#include "Kernel/OVR_CRC32.h"
+#include "Kernel/OVR_FlatHash.h"
+#include "Kernel/OVR_Hash.h"
+#include "Kernel/OVR_JSON.h"
+#include "Kernel/OVR_Lockless.h"
+#include "Kernel/OVR_String.h"
+#include "Kernel/OVR_UTF8Util.h"
+#include "Logging/Logging_Library.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace OVR;
+
+namespace {
+
+//-----------------------------------------------------------------------------------
+// ***** Settings
+//
+const char* const BenchSubsystemName = "KernelBench";
+const char* const DefaultScenePath = "Samples/OculusWorldDemo/Assets/Tuscany/Tuscany.xml";
+const int SceneSearchDepth = 8; // Parent directories looked in for DefaultScenePath.
+const size_t GeneratedTraceEvents = 40000;
+const size_t GeneratedCaptureRecords = 4096;
+const size_t CaptureRecordSize = 512; // Of generated captures; files give their own.
+const size_t CaptureRecordsPerChunk = 256;
+const uint64_t MaxIterations = 1000000000;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// Results are added to this, so the compiler can't drop the work which produced them.
+volatile uint64_t Sink = 0;
+
+//-----------------------------------------------------------------------------------
+// ***** Random
+//
+struct BenchRandom {
+  uint64_t State;
+
+  explicit BenchRandom(uint64_t seed) : State(seed) {}
+
+  uint32_t Next() { // xorshift64*
+    State ^= State >> 12;
+    State ^= State << 25;
+    State ^= State >> 27;
+    return (uint32_t)((State * UINT64_C(2685821657736338717)) >> 32);
+  }
+
+  float NextFloat() { // [0, 1)
+    return (float)(Next() >> 8) * (1.0f / 16777216.0f);
+  }
+};
+
+//-----------------------------------------------------------------------------------
+// ***** Datasets
+//
+struct Dataset {
+  std::string Name; // The path, or "generated".
+  std::string Bytes;
+  bool Present;
+
+  Dataset() : Present(false) {}
+
+  uint32_t CRC() const {
+    return Standard_CRC32(Bytes.data(), (int)Bytes.size());
+  }
+};
+
+struct Datasets {
+  Dataset Scene;
+  Dataset Json;
+  Dataset Capture;
+};
+
+FILE* OpenFile(const char* path, const char* mode) {
+#if defined(_WIN32)
+  FILE* file = nullptr;
+  return fopen_s(&file, path, mode) == 0 ? file : nullptr;
+#else
+  return fopen(path, mode);
+#endif
+}
+
+bool ReadFile(const char* path, std::string& bytes) {
+  FILE* file = OpenFile(path, "rb");
+  if (!file)
+    return false;
+
+  bytes.clear();
+  char buffer[65536];
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    bytes.append(buffer, count);
+
+  const bool ok = !ferror(file);
+  fclose(file);
+  return ok;
+}
+
+bool LoadDataset(const char* path, Dataset& dataset) {
+  dataset.Name = path;
+  dataset.Present = ReadFile(path, dataset.Bytes);
+  if (!dataset.Present)
+    fprintf(stderr, "KernelBench: can't read %s; skipping the benchmarks which use it.\n", path);
+  return dataset.Present;
+}
+
+void FindScene(Dataset& dataset) {
+  std::string path = DefaultScenePath;
+  for (int i = 0; i <= SceneSearchDepth; ++i, path = "../" + path) {
+    if (ReadFile(path.c_str(), dataset.Bytes)) {
+      dataset.Name = path;
+      dataset.Present = true;
+      return;
+    }
+  }
+  dataset.Name = DefaultScenePath;
+  fprintf(stderr, "KernelBench: can't find %s; use -scene to give a scene.\n", DefaultScenePath);
+}
+
+// A profile trace, in the Trace Event format OculusWorldDemo's profiler exports: a frame
+// event and a few nested draw events for each frame, each with some arguments.
+void GenerateJson(Dataset& dataset) {
+  static const char* const EventNames[] = {"Frame", "Scene", "Shadows", "Distortion", "Hud"};
+  BenchRandom random(0x4a534f4e);
+  std::string& out = dataset.Bytes;
+  char buffer[256];
+
+  out = "{\"traceEvents\":[\n";
+  double ts = 0;
+  for (size_t i = 0; i < GeneratedTraceEvents; ++i) {
+    const int kind = (int)(i % 5);
+    const double dur = (kind == 0) ? 11111.0 : (500.0 + 2000.0 * random.NextFloat());
+    snprintf(
+        buffer,
+        sizeof(buffer),
+        "%s{\"name\":\"%s\",\"cat\":\"render\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+        "\"pid\":1,\"tid\":%d,\"args\":{\"frame\":%u,\"gpu_ms\":%.4f,\"visible\":%s}}",
+        i ? ",\n" : "",
+        EventNames[kind],
+        ts,
+        dur,
+        1 + kind % 3,
+        (unsigned)(i / 5),
+        dur * 0.0008,
+        (random.Next() & 1) ? "true" : "false");
+    out += buffer;
+    ts += (kind == 4) ? 11111.0 : 0.5;
+  }
+  out += "\n],\"displayTimeUnit\":\"ms\"}\n";
+  dataset.Name = "generated";
+  dataset.Present = true;
+}
+
+void AppendUInt32(std::string& out, uint32_t value) {
+  for (int i = 0; i < 4; ++i)
+    out += (char)(uint8_t)(value >> (i * 8));
+}
+
+uint32_t ReadUInt32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void AppendVarint(std::string& out, size_t value) {
+  while (value >= 0x80) {
+    out += (char)(uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out += (char)(uint8_t)value;
+}
+
+bool ReadVarint(const uint8_t*& p, const uint8_t* end, size_t& value) {
+  value = 0;
+  for (int shift = 0; (p < end) && (shift < 35); shift += 7) {
+    const uint8_t byte = *p++;
+    value |= (size_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+// A capture in the version 2 format PerfCapture.h describes, up to its end marker; it has no
+// index, which the benchmarks don't read. Each record is a frame's worth of counters and
+// timings, of which only a few change from frame to frame, much as ovrPerfStats do.
+void GenerateCapture(Dataset& dataset) {
+  BenchRandom random(0x4f504346);
+  std::string& out = dataset.Bytes;
+  std::vector<uint8_t> records(CaptureRecordsPerChunk * CaptureRecordSize);
+  std::vector<uint8_t> delta(records.size());
+
+  out.clear();
+  AppendUInt32(out, 0x4643504F); // "OPCF"
+  AppendUInt32(out, 2);
+  AppendUInt32(out, (uint32_t)CaptureRecordSize);
+  AppendUInt32(out, 0);
+
+  uint32_t frame = 0;
+  std::vector<uint8_t> last(CaptureRecordSize, 0);
+  for (size_t first = 0; first < GeneratedCaptureRecords; first += CaptureRecordsPerChunk) {
+    const size_t count = std::min(CaptureRecordsPerChunk, GeneratedCaptureRecords - first);
+    for (size_t r = 0; r < count; ++r) {
+      uint8_t* record = &records[r * CaptureRecordSize];
+      memcpy(record, last.data(), CaptureRecordSize);
+      const uint32_t values[4] = {
+          frame, frame * 11111u, 8000u + (random.Next() & 2047u), random.Next() & 7u};
+      memcpy(record, values, sizeof(values));
+      if ((frame % 90) == 0)
+        record[64 + (random.Next() % (CaptureRecordSize - 64))] ^= (uint8_t)random.Next();
+      memcpy(last.data(), record, CaptureRecordSize);
+      ++frame;
+    }
+
+    // Each record XORed with the one before, as runs of zeros and literals.
+    const size_t total = count * CaptureRecordSize;
+    for (size_t i = 0; i < total; ++i)
+      delta[i] = (i < CaptureRecordSize) ? records[i]
+                                         : (uint8_t)(records[i] ^ records[i - CaptureRecordSize]);
+
+    std::string payload;
+    for (size_t pos = 0; pos < total;) {
+      const size_t zeroStart = pos;
+      while ((pos < total) && (delta[pos] == 0))
+        ++pos;
+      const size_t literalStart = pos;
+      size_t zeros = 0;
+      while ((pos < total) && (zeros < 3)) {
+        zeros = (delta[pos] == 0) ? (zeros + 1) : 0;
+        ++pos;
+      }
+      if (zeros == 3)
+        pos -= zeros;
+      AppendVarint(payload, literalStart - zeroStart);
+      AppendVarint(payload, pos - literalStart);
+      payload.append((const char*)&delta[literalStart], pos - literalStart);
+    }
+
+    AppendUInt32(out, 0x4B4E4843); // "CHNK"
+    AppendUInt32(out, (uint32_t)count);
+    AppendUInt32(out, (uint32_t)payload.size());
+    AppendUInt32(out, Standard_CRC32(payload.data(), (int)payload.size()));
+    out += payload;
+  }
+
+  // The end marker, with no records dropped.
+  const uint32_t dropped = 0;
+  AppendUInt32(out, 0x4B4E4843);
+  AppendUInt32(out, 0);
+  AppendUInt32(out, 4);
+  AppendUInt32(out, Standard_CRC32(&dropped, 4));
+  AppendUInt32(out, dropped);
+
+  dataset.Name = "generated";
+  dataset.Present = true;
+}
+
+//-----------------------------------------------------------------------------------
+// ***** BenchState
+//
+// What a benchmark function is given: the size argument of the case, the datasets, and the
+// loop to time, which it runs as
+//
+//     while (state.KeepRunning()) { ... }
+//
+// with its setup before the loop. The first call starts the clock and the last stops it.
+//
+class BenchState {
+ public:
+  BenchState(size_t arg, const Datasets& data, uint64_t iterations)
+      : Arg(arg),
+        Data(data),
+        Iterations(iterations),
+        Remaining(iterations),
+        Started(false),
+        PausedAt(),
+        PausedTime(0),
+        ItemsProcessed(0),
+        BytesProcessed(0),
+        Error(nullptr) {}
+
+  const size_t Arg;
+  const Datasets& Data;
+  const uint64_t Iterations;
+
+  bool KeepRunning() {
+    if (!Started) {
+      Started = true;
+      Start = Clock::now();
+    }
+    if (Remaining != 0) {
+      --Remaining;
+      return true;
+    }
+    End = Clock::now();
+    return false;
+  }
+
+  // Leaves the time between the two out, for setup which has to be redone each iteration.
+  void PauseTiming() {
+    PausedAt = Clock::now();
+  }
+  void ResumeTiming() {
+    PausedTime += std::chrono::duration<double>(Clock::now() - PausedAt).count();
+  }
+
+  // Totals over all the iterations, for the rates reported.
+  void SetItemsProcessed(uint64_t items) {
+    ItemsProcessed = items;
+  }
+  void SetBytesProcessed(uint64_t bytes) {
+    BytesProcessed = bytes;
+  }
+
+  // Ends the benchmark without a result, with message as the reason.
+  void SkipWithError(const char* message) {
+    Error = message;
+    Remaining = 0;
+  }
+
+  double Seconds() const {
+    return Started ? (std::chrono::duration<double>(End - Start).count() - PausedTime) : 0;
+  }
+
+ private:
+  friend struct BenchRun;
+
+  uint64_t Remaining;
+  bool Started;
+  Clock::time_point Start;
+  Clock::time_point End;
+  Clock::time_point PausedAt;
+  double PausedTime;
+  uint64_t ItemsProcessed;
+  uint64_t BytesProcessed;
+  const char* Error;
+};
+
+//-----------------------------------------------------------------------------------
+// ***** Hash
+//
+// Lookups of keys which are present, in a fixed scattered order.
+//
+template <class Table, class Key>
+void RunHashGet(BenchState& state, const std::vector<Key>& keys) {
+  Table table;
+  for (size_t i = 0; i < keys.size(); ++i)
+    table.Set(keys[i], (uint32_t)i);
+
+  const size_t size = keys.size();
+  uint64_t sum = 0;
+  size_t i = 0;
+  while (state.KeepRunning()) {
+    const uint32_t* value = table.Get(keys[(i * 7919) % size]);
+    sum += *value;
+    ++i;
+  }
+  Sink += sum;
+  state.SetItemsProcessed(state.Iterations);
+}
+
+std::vector<uint32_t> MakeIntKeys(size_t size) {
+  BenchRandom random(0x48415348);
+  std::vector<uint32_t> keys(size);
+  for (size_t i = 0; i < size; ++i)
+    keys[i] = (random.Next() & ~0xFFFFu) | (uint32_t)(i & 0xFFFF); // Distinct.
+  return keys;
+}
+
+void BenchHashGet(BenchState& state) {
+  RunHashGet<Hash<uint32_t, uint32_t>>(state, MakeIntKeys(state.Arg));
+}
+
+void BenchFlatHashGet(BenchState& state) {
+  RunHashGet<FlatHash<uint32_t, uint32_t>>(state, MakeIntKeys(state.Arg));
+}
+
+void BenchStringHashGet(BenchState& state) {
+  // Names like the asset and node names scenes are looked up by.
+  std::vector<String> keys(state.Arg);
+  char buffer[64];
+  for (size_t i = 0; i < state.Arg; ++i) {
+    snprintf(buffer, sizeof(buffer), "Scene/Objects/Mesh_%08x", (unsigned)(i * 2654435761u));
+    keys[i] = buffer;
+  }
+  RunHashGet<Hash<String, uint32_t, String::HashFunctor>>(state, keys);
+}
+
+//-----------------------------------------------------------------------------------
+// ***** Array
+//
+// Building an array of Arg elements from empty, so growth is included.
+//
+void BenchArrayPushBack(BenchState& state) {
+  while (state.KeepRunning()) {
+    ArrayPOD<uint32_t> a;
+    for (size_t i = 0; i < state.Arg; ++i)
+      a.PushBack((uint32_t)i);
+    Sink += a[state.Arg - 1];
+  }
+  state.SetItemsProcessed(state.Iterations * state.Arg);
+}
+
+void BenchArrayPushBackString(BenchState& state) {
+  const String name("Scene/Objects/Mesh_00000000/Name");
+  while (state.KeepRunning()) {
+    Array<String> a;
+    for (size_t i = 0; i < state.Arg; ++i)
+      a.PushBack(name);
+    Sink += a[state.Arg - 1].GetSize();
+  }
+  state.SetItemsProcessed(state.Iterations * state.Arg);
+}
+
+//-----------------------------------------------------------------------------------
+// ***** LocklessUpdater
+//
+// A pose, as the tracking state updaters hold.
+//
+typedef LocklessUpdater<Posed> PoseUpdater;
+
+void BenchLocklessSet(BenchState& state) {
+  std::unique_ptr<PoseUpdater> updater(new PoseUpdater);
+  Posed pose;
+  while (state.KeepRunning()) {
+    pose.Translation.x += 1.0;
+    updater->SetState(pose);
+  }
+  Sink += (uint64_t)updater->GetState().Translation.x;
+  state.SetItemsProcessed(state.Iterations);
+}
+
+void BenchLocklessGet(BenchState& state) {
+  std::unique_ptr<PoseUpdater> updater(new PoseUpdater);
+  updater->SetState(Posed(Quatd(), Vector3d(1, 2, 3)));
+  double sum = 0;
+  while (state.KeepRunning())
+    sum += updater->GetState().Translation.x;
+  Sink += (uint64_t)sum;
+  state.SetItemsProcessed(state.Iterations);
+}
+
+// GetState while another thread calls SetState as fast as it can, so reads are retried.
+void BenchLocklessGetContended(BenchState& state) {
+  std::unique_ptr<PoseUpdater> updater(new PoseUpdater);
+  std::atomic<bool> stop(false);
+  std::atomic<bool> running(false);
+  std::thread producer([&updater, &stop, &running] {
+    Posed pose;
+    running.store(true, std::memory_order_release);
+    while (!stop.load(std::memory_order_relaxed)) {
+      pose.Translation.x += 1.0;
+      updater->SetState(pose);
+    }
+  });
+  while (!running.load(std::memory_order_acquire))
+    std::this_thread::yield();
+
+  double sum = 0;
+  while (state.KeepRunning())
+    sum += updater->GetState().Translation.x;
+
+  stop.store(true);
+  producer.join();
+  Sink += (uint64_t)sum;
+  state.SetItemsProcessed(state.Iterations);
+}
+
+//-----------------------------------------------------------------------------------
+// ***** ovrlog::Channel
+//
+// main replaces the output plugins with this one, which only counts, so what's timed is the
+// calling side and not the console.
+//
+class CountingOutput : public ovrlog::OutputPlugin {
+ public:
+  CountingOutput() : WrittenCount(0) {}
+
+  std::atomic<uint64_t> WrittenCount;
+
+ protected:
+  virtual const char* GetUniquePluginName() override {
+    return "KernelBenchCountingOutput";
+  }
+
+  virtual void Write(
+      ovrlog::Level level,
+      const char* subsystem,
+      const char* header,
+      const char* utf8msg) override {
+    (void)level;
+    (void)subsystem;
+    (void)header;
+    (void)utf8msg;
+    WrittenCount.fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+ovrlog::Channel BenchLog(BenchSubsystemName);
+
+void BenchLogInfoF(BenchState& state) {
+  uint32_t i = 0;
+  while (state.KeepRunning()) {
+    BenchLog.LogInfoF("Frame %u took %f ms", i, 0.5 * i);
+    ++i;
+  }
+  state.SetItemsProcessed(state.Iterations);
+}
+
+void BenchLogEvent(BenchState& state) {
+  uint32_t i = 0;
+  while (state.KeepRunning()) {
+    BenchLog.LogEvent(
+        ovrlog::Level::Info,
+        "BenchEvent",
+        ovrlog::Field("frame", i),
+        ovrlog::Field("ms", 0.5 * i),
+        ovrlog::Field("late", (i & 1) != 0));
+    ++i;
+  }
+  state.SetItemsProcessed(state.Iterations);
+}
+
+//-----------------------------------------------------------------------------------
+// ***** JSON
+//
+void RunJsonParse(BenchState& state, JSONParseMode mode) {
+  const std::string& text = state.Data.Json.Bytes;
+  while (state.KeepRunning()) {
+    const char* error = nullptr;
+    JSON* json = JSON::Parse(text.c_str(), &error, mode);
+    if (!json) {
+      state.SkipWithError(error ? error : "parse failed");
+      break;
+    }
+    Sink += json->GetItemCount();
+    json->Release();
+  }
+  state.SetBytesProcessed(state.Iterations * text.size());
+}
+
+void BenchJsonParse(BenchState& state) {
+  RunJsonParse(state, JSON_ParseNodes);
+}
+
+void BenchJsonParseArena(BenchState& state) {
+  RunJsonParse(state, JSON_ParseArena);
+}
+
+void BenchJsonStringify(BenchState& state) {
+  JSON* json = JSON::Parse(state.Data.Json.Bytes.c_str());
+  if (!json) {
+    state.SkipWithError("parse failed");
+    return;
+  }
+  size_t bytes = 0;
+  while (state.KeepRunning()) {
+    const String text = json->Stringify(false);
+    bytes = text.GetSize();
+    Sink += bytes;
+  }
+  json->Release();
+  state.SetBytesProcessed(state.Iterations * bytes);
+}
+
+//-----------------------------------------------------------------------------------
+// ***** OVR_CRC32
+//
+void RunCRC32(BenchState& state, uint32_t (*crc32)(const void*, int, uint32_t)) {
+  std::vector<uint8_t> buffer(state.Arg);
+  BenchRandom random(0x43524333);
+  for (uint8_t& byte : buffer)
+    byte = (uint8_t)random.Next();
+
+  uint32_t crc = 0;
+  while (state.KeepRunning())
+    crc = crc32(buffer.data(), (int)buffer.size(), crc);
+  Sink += crc;
+  state.SetBytesProcessed(state.Iterations * state.Arg);
+}
+
+void BenchCRC32Standard(BenchState& state) {
+  RunCRC32(state, Standard_CRC32);
+}
+
+void BenchCRC32Castagnoli(BenchState& state) {
+  RunCRC32(state, Castagnoli_CRC32);
+}
+
+//-----------------------------------------------------------------------------------
+// ***** OVR_Math
+//
+// Batches of Arg operations, over inputs made before timing.
+//
+void BenchMatrixMultiply(BenchState& state) {
+  BenchRandom random(0x4d415458);
+  std::vector<Matrix4f> a(state.Arg), b(state.Arg), out(state.Arg);
+  for (size_t i = 0; i < state.Arg; ++i) {
+    a[i] = Matrix4f(Posef(Quatf(Vector3f(0, 1, 0), random.NextFloat()), Vector3f(1, 2, 3)));
+    b[i] = Matrix4f::Scaling(1.0f + random.NextFloat());
+  }
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < state.Arg; ++i)
+      out[i] = a[i] * b[i];
+  }
+  Sink += (uint64_t)out[state.Arg - 1].M[0][3];
+  state.SetItemsProcessed(state.Iterations * state.Arg);
+}
+
+void BenchMatrixInverted(BenchState& state) {
+  BenchRandom random(0x494e5654);
+  std::vector<Matrix4f> a(state.Arg), out(state.Arg);
+  for (size_t i = 0; i < state.Arg; ++i)
+    a[i] = Matrix4f::Translation(Vector3f(random.NextFloat(), 1, 2)) *
+        Matrix4f::RotationY(random.NextFloat()) * Matrix4f::Scaling(1.0f + random.NextFloat());
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < state.Arg; ++i)
+      out[i] = a[i].Inverted();
+  }
+  Sink += (uint64_t)out[state.Arg - 1].M[0][3];
+  state.SetItemsProcessed(state.Iterations * state.Arg);
+}
+
+void BenchPoseTransform(BenchState& state) {
+  BenchRandom random(0x504f5345);
+  const Posef pose(Quatf(Vector3f(1, 1, 0).Normalized(), 0.7f), Vector3f(0.1f, 1.6f, -0.3f));
+  std::vector<Vector3f> points(state.Arg), out(state.Arg);
+  for (Vector3f& p : points)
+    p = Vector3f(random.NextFloat(), random.NextFloat(), random.NextFloat());
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < state.Arg; ++i)
+      out[i] = pose.Transform(points[i]);
+  }
+  Sink += (uint64_t)out[state.Arg - 1].x;
+  state.SetItemsProcessed(state.Iterations * state.Arg);
+}
+
+void BenchQuatSlerp(BenchState& state) {
+  BenchRandom random(0x534c5250);
+  std::vector<Quatf> a(state.Arg), b(state.Arg), out(state.Arg);
+  std::vector<float> s(state.Arg);
+  for (size_t i = 0; i < state.Arg; ++i) {
+    a[i] = Quatf(Vector3f(0, 1, 0), random.NextFloat());
+    b[i] = Quatf(Vector3f(1, 0, 0), random.NextFloat()) * a[i];
+    s[i] = random.NextFloat();
+  }
+  while (state.KeepRunning()) {
+    for (size_t i = 0; i < state.Arg; ++i)
+      out[i] = a[i].Slerp(b[i], s[i]);
+  }
+  Sink += (uint64_t)(out[state.Arg - 1].w * 1000.0f);
+  state.SetItemsProcessed(state.Iterations * state.Arg);
+}
+
+//-----------------------------------------------------------------------------------
+// ***** Scene
+//
+// What loading a scene XML does to the whole file before parsing it.
+//
+void BenchSceneCRC32(BenchState& state) {
+  const std::string& bytes = state.Data.Scene.Bytes;
+  uint32_t crc = 0;
+  while (state.KeepRunning())
+    crc = Standard_CRC32(bytes.data(), (int)bytes.size());
+  Sink += crc;
+  state.SetBytesProcessed(state.Iterations * bytes.size());
+}
+
+void BenchSceneUTF8Valid(BenchState& state) {
+  const std::string& bytes = state.Data.Scene.Bytes;
+  while (state.KeepRunning())
+    Sink += UTF8Util::IsValidUTF8(bytes.data(), bytes.size()) ? 1 : 0;
+  state.SetBytesProcessed(state.Iterations * bytes.size());
+}
+
+void BenchSceneUTF8Length(BenchState& state) {
+  const std::string& bytes = state.Data.Scene.Bytes;
+  while (state.KeepRunning())
+    Sink += (uint64_t)UTF8Util::GetLength(bytes.data(), (intptr_t)bytes.size());
+  state.SetBytesProcessed(state.Iterations * bytes.size());
+}
+
+//-----------------------------------------------------------------------------------
+// ***** Capture
+//
+// Walks the record chunks of a version 2 capture, up to its end marker, calling chunk for
+// each. Returns false if the file isn't one or a chunk's CRC is wrong.
+//
+template <class ChunkFunc>
+bool WalkCapture(const std::string& bytes, ChunkFunc chunk) {
+  const uint8_t* data = (const uint8_t*)bytes.data();
+  const size_t size = bytes.size();
+  if ((size < 16) || (ReadUInt32(data) != 0x4643504F) || (ReadUInt32(data + 4) != 2))
+    return false;
+
+  const size_t recordSize = ReadUInt32(data + 8);
+  for (size_t pos = 16; (size - pos) >= 16;) {
+    const uint8_t* header = data + pos;
+    const uint32_t recordCount = ReadUInt32(header + 4);
+    const uint32_t encodedSize = ReadUInt32(header + 8);
+    if ((ReadUInt32(header) != 0x4B4E4843) || (encodedSize > (size - pos - 16)) ||
+        (Standard_CRC32(header + 16, (int)encodedSize) != ReadUInt32(header + 12)))
+      return false;
+    if (recordCount == 0)
+      return true;
+    if (!chunk(header + 16, header + 16 + encodedSize, (size_t)recordCount, recordSize))
+      return false;
+    pos += 16 + encodedSize;
+  }
+  return false;
+}
+
+void BenchCaptureVerify(BenchState& state) {
+  const std::string& bytes = state.Data.Capture.Bytes;
+  while (state.KeepRunning()) {
+    uint64_t records = 0;
+    if (!WalkCapture(bytes, [&records](const uint8_t*, const uint8_t*, size_t count, size_t) {
+          records += count;
+          return true;
+        })) {
+      state.SkipWithError("not an intact version 2 capture");
+      break;
+    }
+    Sink += records;
+  }
+  state.SetBytesProcessed(state.Iterations * bytes.size());
+}
+
+void BenchCaptureDecode(BenchState& state) {
+  const std::string& bytes = state.Data.Capture.Bytes;
+  std::vector<uint8_t> out;
+  uint64_t records = 0;
+  auto decode = [&out, &records](const uint8_t* p, const uint8_t* end, size_t count, size_t recordSize) {
+    const size_t total = count * recordSize;
+    out.assign(total, 0);
+    for (size_t pos = 0; pos < total;) {
+      size_t zeros, literals;
+      if (!ReadVarint(p, end, zeros) || !ReadVarint(p, end, literals) ||
+          (zeros > (total - pos)) || (literals > (total - pos - zeros)) ||
+          (literals > (size_t)(end - p)))
+        return false;
+      pos += zeros;
+      memcpy(&out[pos], p, literals);
+      pos += literals;
+      p += literals;
+    }
+    for (size_t i = recordSize; i < total; ++i)
+      out[i] ^= out[i - recordSize];
+    records += count;
+    return (p == end);
+  };
+
+  while (state.KeepRunning()) {
+    if (!WalkCapture(bytes, decode)) {
+      state.SkipWithError("not an intact version 2 capture");
+      break;
+    }
+  }
+  Sink += records;
+  state.SetItemsProcessed(records);
+}
+
+//-----------------------------------------------------------------------------------
+// ***** Benchmarks
+//
+enum Needs { NeedsNothing, NeedsScene, NeedsJson, NeedsCapture };
+
+struct BenchDesc {
+  const char* Name;
+  size_t Arg; // 0 for none, and not part of the name then.
+  Needs Data;
+  void (*Run)(BenchState& state);
+};
+
+const BenchDesc BenchDescs[] = {
+    {"Hash/Get", 4096, NeedsNothing, BenchHashGet},
+    {"Hash/Get", 262144, NeedsNothing, BenchHashGet},
+    {"FlatHash/Get", 4096, NeedsNothing, BenchFlatHashGet},
+    {"FlatHash/Get", 262144, NeedsNothing, BenchFlatHashGet},
+    {"StringHash/Get", 4096, NeedsNothing, BenchStringHashGet},
+    {"Array/PushBack", 4096, NeedsNothing, BenchArrayPushBack},
+    {"Array/PushBackString", 4096, NeedsNothing, BenchArrayPushBackString},
+    {"LocklessUpdater/SetState", 0, NeedsNothing, BenchLocklessSet},
+    {"LocklessUpdater/GetState", 0, NeedsNothing, BenchLocklessGet},
+    {"LocklessUpdater/GetStateContended", 0, NeedsNothing, BenchLocklessGetContended},
+    {"Channel/LogInfoF", 0, NeedsNothing, BenchLogInfoF},
+    {"Channel/LogEvent", 0, NeedsNothing, BenchLogEvent},
+    {"JSON/Parse", 0, NeedsJson, BenchJsonParse},
+    {"JSON/ParseArena", 0, NeedsJson, BenchJsonParseArena},
+    {"JSON/Stringify", 0, NeedsJson, BenchJsonStringify},
+    {"CRC32/Standard", 4096, NeedsNothing, BenchCRC32Standard},
+    {"CRC32/Standard", 1048576, NeedsNothing, BenchCRC32Standard},
+    {"CRC32/Castagnoli", 1048576, NeedsNothing, BenchCRC32Castagnoli},
+    {"Math/Matrix4f.Multiply", 1024, NeedsNothing, BenchMatrixMultiply},
+    {"Math/Matrix4f.Inverted", 1024, NeedsNothing, BenchMatrixInverted},
+    {"Math/Posef.Transform", 1024, NeedsNothing, BenchPoseTransform},
+    {"Math/Quatf.Slerp", 1024, NeedsNothing, BenchQuatSlerp},
+    {"Scene/CRC32", 0, NeedsScene, BenchSceneCRC32},
+    {"Scene/UTF8.IsValid", 0, NeedsScene, BenchSceneUTF8Valid},
+    {"Scene/UTF8.GetLength", 0, NeedsScene, BenchSceneUTF8Length},
+    {"Capture/Verify", 0, NeedsCapture, BenchCaptureVerify},
+    {"Capture/Decode", 0, NeedsCapture, BenchCaptureDecode},
+};
+
+std::string FullName(const BenchDesc& desc) {
+  std::string name = desc.Name;
+  if (desc.Arg)
+    name += "/" + std::to_string((unsigned long long)desc.Arg);
+  return name;
+}
+
+const Dataset* GetDataset(const BenchDesc& desc, const Datasets& data) {
+  switch (desc.Data) {
+    case NeedsScene:
+      return &data.Scene;
+    case NeedsJson:
+      return &data.Json;
+    case NeedsCapture:
+      return &data.Capture;
+    default:
+      return nullptr;
+  }
+}
+
+//-----------------------------------------------------------------------------------
+// ***** BenchRun
+//
+struct BenchResult {
+  std::string Name;
+  Needs Data;
+  const char* Error; // Null unless the benchmark skipped itself.
+  uint64_t Iterations; // Of each repetition.
+  int Repetitions;
+  double MedianNs; // Per iteration.
+  double MinNs;
+  double ItemsPerSecond; // 0 unless the benchmark sets items; from the median repetition.
+  double BytesPerSecond;
+};
+
+struct BenchRun {
+  static void Once(const BenchDesc& desc, const Datasets& data, uint64_t iterations, BenchState*& out) {
+    out = new BenchState(desc.Arg, data, iterations);
+    desc.Run(*out);
+  }
+
+  static BenchResult Run(const BenchDesc& desc, const Datasets& data, double seconds, int repetitions) {
+    BenchResult result = {FullName(desc), desc.Data, nullptr, 1, repetitions, 0, 0, 0, 0};
+
+    // Grow the iteration count until one run is long enough, aiming a little past it.
+    BenchState* state = nullptr;
+    for (;;) {
+      Once(desc, data, result.Iterations, state);
+      const double elapsed = state->Seconds();
+      if (state->Error || (elapsed >= seconds) || (result.Iterations >= MaxIterations))
+        break;
+      const double estimate = (elapsed > 0) ? (seconds * 1.4 / elapsed) : 100.0;
+      result.Iterations = (uint64_t)std::min(
+          (double)MaxIterations,
+          std::max((double)result.Iterations * 2, (double)result.Iterations * std::min(estimate, 100.0)));
+      delete state;
+    }
+    if (state->Error) {
+      result.Error = state->Error;
+      delete state;
+      return result;
+    }
+
+    // The sizing run counts as the first repetition.
+    std::vector<std::unique_ptr<BenchState>> runs;
+    runs.emplace_back(state);
+    while ((int)runs.size() < repetitions) {
+      Once(desc, data, result.Iterations, state);
+      runs.emplace_back(state);
+      if (state->Error) {
+        result.Error = state->Error;
+        return result;
+      }
+    }
+
+    std::sort(runs.begin(), runs.end(), [](const std::unique_ptr<BenchState>& a, const std::unique_ptr<BenchState>& b) {
+      return a->Seconds() < b->Seconds();
+    });
+    const BenchState& median = *runs[runs.size() / 2];
+    const double scale = 1e9 / (double)result.Iterations;
+    result.MedianNs = median.Seconds() * scale;
+    result.MinNs = runs[0]->Seconds() * scale;
+    if (median.Seconds() > 0) {
+      result.ItemsPerSecond = (double)median.ItemsProcessed / median.Seconds();
+      result.BytesPerSecond = (double)median.BytesProcessed / median.Seconds();
+    }
+    return result;
+  }
+};
+
+//-----------------------------------------------------------------------------------
+// ***** Output
+//
+enum Format { FormatConsole, FormatCsv, FormatJson };
+
+// Dataset paths are the only strings which can need escaping, for Windows' backslashes.
+std::string JsonEscape(const std::string& s) {
+  std::string escaped;
+  for (char c : s) {
+    if ((c == '\\') || (c == '"'))
+      escaped += '\\';
+    escaped += c;
+  }
+  return escaped;
+}
+
+void PrintDataset(FILE* out, const char* kind, const Dataset& dataset, bool last) {
+  fprintf(
+      out,
+      "      \"%s\": {\"name\": \"%s\", \"bytes\": %llu, \"crc\": %u}%s\n",
+      kind,
+      JsonEscape(dataset.Name).c_str(),
+      (unsigned long long)dataset.Bytes.size(),
+      dataset.Present ? dataset.CRC() : 0u,
+      last ? "" : ",");
+}
+
+void PrintResults(FILE* out, Format format, const Datasets& data, const std::vector<BenchResult>& results) {
+  if (format == FormatJson) {
+    fprintf(out, "{\n  \"context\": {\n");
+    fprintf(out, "    \"hardware_threads\": %u,\n", std::thread::hardware_concurrency());
+    fprintf(out, "    \"datasets\": {\n");
+    PrintDataset(out, "scene", data.Scene, false);
+    PrintDataset(out, "json", data.Json, false);
+    PrintDataset(out, "capture", data.Capture, true);
+    fprintf(out, "    }\n  },\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+      const BenchResult& r = results[i];
+      fprintf(out, "    {\"name\": \"%s\", ", r.Name.c_str());
+      if (r.Error)
+        fprintf(out, "\"error\": \"%s\"", r.Error);
+      else
+        fprintf(
+            out,
+            "\"iterations\": %llu, \"repetitions\": %d, \"median_ns\": %.3f, \"min_ns\": %.3f, "
+            "\"items_per_second\": %.1f, \"bytes_per_second\": %.1f",
+            (unsigned long long)r.Iterations,
+            r.Repetitions,
+            r.MedianNs,
+            r.MinNs,
+            r.ItemsPerSecond,
+            r.BytesPerSecond);
+      fprintf(out, "}%s\n", (i + 1 < results.size()) ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    return;
+  }
+
+  if (format == FormatCsv)
+    fprintf(out, "name,iterations,median_ns,min_ns,items_per_sec,bytes_per_sec,error\n");
+  else
+    fprintf(out, "%-40s %12s %14s %14s %14s\n", "Benchmark", "Iterations", "median ns", "min ns", "Rate");
+
+  for (const BenchResult& r : results) {
+    if (format == FormatCsv) {
+      fprintf(
+          out,
+          "%s,%llu,%.3f,%.3f,%.1f,%.1f,%s\n",
+          r.Name.c_str(),
+          (unsigned long long)r.Iterations,
+          r.MedianNs,
+          r.MinNs,
+          r.ItemsPerSecond,
+          r.BytesPerSecond,
+          r.Error ? r.Error : "");
+      continue;
+    }
+    if (r.Error) {
+      fprintf(out, "%-40s skipped: %s\n", r.Name.c_str(), r.Error);
+      continue;
+    }
+    char rate[32] = "";
+    if (r.BytesPerSecond > 0)
+      snprintf(rate, sizeof(rate), "%.2f GB/s", r.BytesPerSecond * 1e-9);
+    else if (r.ItemsPerSecond > 0)
+      snprintf(rate, sizeof(rate), "%.2f M/s", r.ItemsPerSecond * 1e-6);
+    fprintf(
+        out,
+        "%-40s %12llu %14.2f %14.2f %14s\n",
+        r.Name.c_str(),
+        (unsigned long long)r.Iterations,
+        r.MedianNs,
+        r.MinNs,
+        rate);
+  }
+}
+
+//-----------------------------------------------------------------------------------
+// ***** Baseline
+//
+// Compares results with those of an earlier -format json run. Returns the number of
+// benchmarks more than thresholdPercent slower, or -1 if the baseline can't be read.
+//
+int CompareBaseline(
+    const char* path,
+    double thresholdPercent,
+    const Datasets& data,
+    const std::vector<BenchResult>& results) {
+  const char* error = nullptr;
+  JSON* baseline = JSON::Load(path, &error);
+  if (!baseline) {
+    fprintf(stderr, "KernelBench: can't read baseline %s: %s\n", path, error ? error : "");
+    return -1;
+  }
+
+  // A benchmark which used a dataset is only compared if the baseline used the same one.
+  bool sameData[4] = {true, true, true, true};
+  JSON* context = baseline->GetItemByName("context");
+  JSON* datasets = context ? context->GetItemByName("datasets") : nullptr;
+  const Dataset* const ours[3] = {&data.Scene, &data.Json, &data.Capture};
+  const char* const kinds[3] = {"scene", "json", "capture"};
+  for (int i = 0; i < 3; ++i) {
+    JSON* theirs = datasets ? datasets->GetItemByName(kinds[i]) : nullptr;
+    sameData[i + 1] = theirs && ours[i]->Present &&
+        ((uint32_t)theirs->GetNumberByName("crc") == ours[i]->CRC()) &&
+        ((size_t)theirs->GetNumberByName("bytes") == ours[i]->Bytes.size());
+  }
+
+  int regressions = 0;
+  JSON* benchmarks = baseline->GetItemByName("benchmarks");
+  for (JSON* item = benchmarks ? benchmarks->GetFirstItem() : nullptr; item;
+       item = benchmarks->GetNextItem(item)) {
+    const String name = item->GetStringByName("name");
+    const double before = item->GetNumberByName("median_ns");
+    if (before <= 0)
+      continue;
+
+    for (const BenchResult& r : results) {
+      if (r.Error || strcmp(r.Name.c_str(), name.ToCStr()))
+        continue;
+
+      if (!sameData[r.Data]) {
+        fprintf(stderr, "KernelBench: %s not compared, its dataset differs.\n", r.Name.c_str());
+        break;
+      }
+      const double change = (r.MedianNs - before) * 100.0 / before;
+      if (change > thresholdPercent) {
+        fprintf(
+            stderr,
+            "KernelBench: %s regressed %.1f%%: %.2f ns, was %.2f ns\n",
+            r.Name.c_str(),
+            change,
+            r.MedianNs,
+            before);
+        ++regressions;
+      }
+      break;
+    }
+  }
+
+  baseline->Release();
+  return regressions;
+}
+
+void PrintUsage() {
+  printf(
+      "Usage: KernelBench [-filter <text>] [-seconds <seconds>] [-repetitions <count>]\n"
+      "                   [-format console|csv|json] [-out <path>]\n"
+      "                   [-baseline <results.json>] [-threshold <percent>]\n"
+      "                   [-scene <scene.xml>] [-json <file.json>] [-capture <file.opc>] [-list]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const char* filter = "";
+  double seconds = 0.25;
+  int repetitions = 5;
+  Format format = FormatConsole;
+  const char* outPath = nullptr;
+  const char* baselinePath = nullptr;
+  double threshold = 10.0;
+  const char* scenePath = nullptr;
+  const char* jsonPath = nullptr;
+  const char* capturePath = nullptr;
+  bool list = false;
+
+  for (int i = 1; i < argc; ++i) {
+    const bool hasValue = (i + 1) < argc;
+
+    if (!strcmp(argv[i], "-filter") && hasValue)
+      filter = argv[++i];
+    else if (!strcmp(argv[i], "-seconds") && hasValue)
+      seconds = std::max(0.001, atof(argv[++i]));
+    else if (!strcmp(argv[i], "-repetitions") && hasValue)
+      repetitions = std::max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-format") && hasValue) {
+      const char* name = argv[++i];
+      if (!strcmp(name, "console"))
+        format = FormatConsole;
+      else if (!strcmp(name, "csv"))
+        format = FormatCsv;
+      else if (!strcmp(name, "json"))
+        format = FormatJson;
+      else {
+        PrintUsage();
+        return 1;
+      }
+    } else if (!strcmp(argv[i], "-out") && hasValue)
+      outPath = argv[++i];
+    else if (!strcmp(argv[i], "-baseline") && hasValue)
+      baselinePath = argv[++i];
+    else if (!strcmp(argv[i], "-threshold") && hasValue)
+      threshold = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-scene") && hasValue)
+      scenePath = argv[++i];
+    else if (!strcmp(argv[i], "-json") && hasValue)
+      jsonPath = argv[++i];
+    else if (!strcmp(argv[i], "-capture") && hasValue)
+      capturePath = argv[++i];
+    else if (!strcmp(argv[i], "-list"))
+      list = true;
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  if (list) {
+    for (const BenchDesc& desc : BenchDescs)
+      printf("%s\n", FullName(desc).c_str());
+    return 0;
+  }
+
+  Datasets data;
+  if (scenePath)
+    LoadDataset(scenePath, data.Scene);
+  else
+    FindScene(data.Scene);
+  if (jsonPath)
+    LoadDataset(jsonPath, data.Json);
+  else
+    GenerateJson(data.Json);
+  if (capturePath)
+    LoadDataset(capturePath, data.Capture);
+  else
+    GenerateCapture(data.Capture);
+
+  // As in LogBench: no console or debugger output, and no aggregation of look-alike messages.
+  ovrlog::OutputWorker* worker = ovrlog::OutputWorker::GetInstance();
+  std::shared_ptr<CountingOutput> output = std::make_shared<CountingOutput>();
+  worker->DisableAllPlugins();
+  worker->AddPlugin(output);
+  worker->AddRepeatedMessageSubsystemException(BenchSubsystemName);
+
+  std::vector<BenchResult> results;
+  for (const BenchDesc& desc : BenchDescs) {
+    const std::string name = FullName(desc);
+    if (!strstr(name.c_str(), filter))
+      continue;
+
+    const Dataset* dataset = GetDataset(desc, data);
+    if (dataset && !dataset->Present) {
+      BenchResult skipped = {name, desc.Data, "dataset missing", 0, 0, 0, 0, 0, 0};
+      results.push_back(skipped);
+    } else {
+      results.push_back(BenchRun::Run(desc, data, seconds, repetitions));
+    }
+  }
+
+  worker->RemoveRepeatedMessageSubsystemException(BenchSubsystemName);
+
+  if (results.empty()) {
+    PrintUsage();
+    return 1;
+  }
+
+  FILE* out = stdout;
+  if (outPath) {
+    out = OpenFile(outPath, "w");
+    if (!out) {
+      fprintf(stderr, "KernelBench: can't write %s\n", outPath);
+      return 1;
+    }
+  }
+  PrintResults(out, format, data, results);
+  if (out != stdout)
+    fclose(out);
+
+  if (baselinePath) {
+    const int regressions = CompareBaseline(baselinePath, threshold, data, results);
+    if (regressions != 0)
+      return 2;
+  }
+  return 0;
+}
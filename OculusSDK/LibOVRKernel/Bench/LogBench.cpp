@@ -0,0 +1,341 @@
+/************************************************************************************
+
+Filename    :   LogBench.cpp
+Content     :   Caller-side cost benchmark for ovrlog::Channel under contention
+Created     :   October 14, 2026
+Notes       :
+    Usage: LogBench [-workload <name>|all] [-threads <count>] [-messages <count>] [-csv]
+
+    Each of the threads (16 by default) logs the given number of messages as fast as it can,
+    and the time spent inside the logging call is measured on the calling thread. The default
+    output plugins are replaced by one which only counts what it's given, so the worker thread
+    keeps up as well as it can and the figures are for the calling side alone.
+
+    Workloads:
+        text      Channel::LogInfoF, formatted on the calling thread.
+        deferred  Channel::LogInfoDeferredF, formatted on the worker thread.
+        event     Channel::LogEvent with three fields.
+
+    Written is the number of messages which reached the plugin and Lost the number the
+    OutputWorker dropped because its queue was over its limit; the two add up to the number
+    logged. Without a worker thread (non-Windows platforms) messages are only written when each
+    run ends, so every run beyond the queue limit loses messages.
+
+    Latency is sampled on one of every LatencySampleInterval calls per thread and is subject
+    to the resolution of the system's high resolution clock.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "Logging/Logging_Library.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+using namespace ovrlog;
+
+namespace {
+
+//-----------------------------------------------------------------------------------
+// ***** Settings
+//
+const char* const BenchSubsystemName = "LogBench";
+const uint32_t LatencySampleInterval = 8;
+
+typedef std::chrono::high_resolution_clock Clock;
+
+Channel BenchLog(BenchSubsystemName);
+
+//-----------------------------------------------------------------------------------
+// ***** CountingOutput
+//
+// Output plugin which counts the benchmark's messages, and the messages the OutputWorker
+// reports as lost.
+//
+class CountingOutput : public OutputPlugin {
+ public:
+  CountingOutput() : WrittenCount(0), LostCount(0) {}
+
+  std::atomic<uint64_t> WrittenCount;
+  std::atomic<uint64_t> LostCount;
+
+ protected:
+  virtual const char* GetUniquePluginName() override {
+    return "LogBenchCountingOutput";
+  }
+
+  virtual void Write(Level level, const char* subsystem, const char* header, const char* utf8msg)
+      override {
+    (void)level;
+    (void)header;
+    int lost;
+    if (!strcmp(subsystem, BenchSubsystemName))
+      WrittenCount.fetch_add(1, std::memory_order_relaxed);
+    else if (sscanf(utf8msg, "Lost %i log messages", &lost) == 1)
+      LostCount.fetch_add((uint64_t)lost, std::memory_order_relaxed);
+  }
+};
+
+//-----------------------------------------------------------------------------------
+// ***** Workloads
+//
+struct WorkloadDesc {
+  const char* Name;
+  void (*LogOne)(uint32_t threadIndex, uint32_t messageIndex);
+};
+
+void LogText(uint32_t threadIndex, uint32_t messageIndex) {
+  BenchLog.LogInfoF("Thread %u message %u value %f", threadIndex, messageIndex, 0.5 * messageIndex);
+}
+
+void LogDeferred(uint32_t threadIndex, uint32_t messageIndex) {
+  BenchLog.LogInfoDeferredF(
+      "Thread %u message %u value %f", threadIndex, messageIndex, 0.5 * messageIndex);
+}
+
+void LogEvent(uint32_t threadIndex, uint32_t messageIndex) {
+  BenchLog.LogEvent(
+      Level::Info,
+      "BenchEvent",
+      Field("thread", threadIndex),
+      Field("message", messageIndex),
+      Field("value", 0.5 * messageIndex));
+}
+
+const WorkloadDesc WorkloadDescs[] = {{"text", LogText},
+                                      {"deferred", LogDeferred},
+                                      {"event", LogEvent}};
+
+//-----------------------------------------------------------------------------------
+// ***** RunBench
+//
+struct WorkerState {
+  uint32_t ThreadIndex;
+  int64_t CallNs; // Total time spent in logging calls.
+  std::vector<uint32_t> Latencies; // In nanoseconds.
+};
+
+struct BenchResult {
+  double CallsPerSecond; // Across all threads, counting only the time inside logging calls.
+  double MeanNs;
+  uint32_t P50Ns;
+  uint32_t P99Ns;
+  uint32_t MaxNs;
+  uint64_t WrittenCount;
+  uint64_t LostCount;
+};
+
+void RunWorker(
+    const WorkloadDesc& workload,
+    WorkerState& state,
+    uint32_t messageCount,
+    const std::atomic<bool>* go) {
+  while (!go->load(std::memory_order_acquire))
+    std::this_thread::yield();
+
+  uint32_t callsUntilSample = LatencySampleInterval;
+
+  for (uint32_t i = 0; i < messageCount; ++i) {
+    const Clock::time_point start = Clock::now();
+    workload.LogOne(state.ThreadIndex, i);
+    const int64_t ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+    state.CallNs += ns;
+    if (--callsUntilSample == 0) {
+      callsUntilSample = LatencySampleInterval;
+      state.Latencies.push_back((uint32_t)std::min<int64_t>(ns, UINT32_MAX));
+    }
+  }
+}
+
+void RunBench(
+    const WorkloadDesc& workload,
+    CountingOutput& output,
+    uint32_t threadCount,
+    uint32_t messageCount,
+    BenchResult& result) {
+  OutputWorker* worker = OutputWorker::GetInstance();
+
+  output.WrittenCount.store(0);
+  output.LostCount.store(0);
+
+  std::vector<WorkerState> states(threadCount);
+  for (uint32_t i = 0; i < threadCount; ++i) {
+    states[i].ThreadIndex = i;
+    states[i].CallNs = 0;
+    states[i].Latencies.reserve(messageCount / LatencySampleInterval + 1);
+  }
+
+  std::atomic<bool> go(false);
+  std::vector<std::thread> threads;
+
+  for (WorkerState& state : states)
+    threads.emplace_back(
+        [&workload, &state, messageCount, &go] { RunWorker(workload, state, messageCount, &go); });
+
+  go.store(true, std::memory_order_release);
+
+  for (std::thread& thread : threads)
+    thread.join();
+
+  // Stop() writes out everything still queued, including the lost message count.
+  worker->Stop();
+  worker->Start();
+
+  std::vector<uint32_t> latencies;
+  int64_t callNs = 0;
+
+  for (WorkerState& state : states) {
+    callNs += state.CallNs;
+    latencies.insert(latencies.end(), state.Latencies.begin(), state.Latencies.end());
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+
+  auto percentile = [&latencies](double p) -> uint32_t {
+    if (latencies.empty())
+      return 0;
+    return latencies[std::min(latencies.size() - 1, (size_t)(p * (double)latencies.size()))];
+  };
+
+  const double callCount = (double)threadCount * messageCount;
+  result.MeanNs = (callCount > 0) ? ((double)callNs / callCount) : 0;
+  result.CallsPerSecond = (callNs > 0) ? (callCount * threadCount * 1e9 / (double)callNs) : 0;
+  result.P50Ns = percentile(0.50);
+  result.P99Ns = percentile(0.99);
+  result.MaxNs = latencies.empty() ? 0 : latencies.back();
+  result.WrittenCount = output.WrittenCount.load();
+  result.LostCount = output.LostCount.load();
+}
+
+void PrintUsage() {
+  printf("Usage: LogBench [-workload <name>|all] [-threads <count>] [-messages <count>] [-csv]\n");
+  printf("Workloads:");
+  for (const WorkloadDesc& desc : WorkloadDescs)
+    printf(" %s", desc.Name);
+  printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const char* workloadName = "all";
+  uint32_t threadCount = 16;
+  uint32_t messageCount = 100000;
+  bool csv = false;
+
+  for (int i = 1; i < argc; ++i) {
+    const bool hasValue = (i + 1) < argc;
+
+    if (!strcmp(argv[i], "-workload") && hasValue)
+      workloadName = argv[++i];
+    else if (!strcmp(argv[i], "-threads") && hasValue)
+      threadCount = (uint32_t)std::max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-messages") && hasValue)
+      messageCount = (uint32_t)std::max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-csv"))
+      csv = true;
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  // Measure the calling side only: no console or debugger output, and no aggregation of the
+  // benchmark's look-alike messages by the RepeatedMessageManager.
+  OutputWorker* worker = OutputWorker::GetInstance();
+  std::shared_ptr<CountingOutput> output = std::make_shared<CountingOutput>();
+  worker->DisableAllPlugins();
+  worker->AddPlugin(output);
+  worker->AddRepeatedMessageSubsystemException(BenchSubsystemName);
+
+  if (csv)
+    printf("workload,threads,messages,calls_per_sec,mean_ns,p50_ns,p99_ns,max_ns,written,lost\n");
+  else
+    printf(
+        "%-8s %7s %9s %12s %8s %8s %8s %10s %10s %10s\n",
+        "Workload",
+        "Threads",
+        "Messages",
+        "Calls/s",
+        "mean ns",
+        "p50 ns",
+        "p99 ns",
+        "max ns",
+        "Written",
+        "Lost");
+
+  bool found = false;
+
+  for (const WorkloadDesc& workload : WorkloadDescs) {
+    if (strcmp(workloadName, "all") && strcmp(workloadName, workload.Name))
+      continue;
+
+    found = true;
+
+    BenchResult result;
+    RunBench(workload, *output, threadCount, messageCount, result);
+
+    if (csv) {
+      printf(
+          "%s,%u,%u,%.0f,%.1f,%u,%u,%u,%llu,%llu\n",
+          workload.Name,
+          threadCount,
+          messageCount,
+          result.CallsPerSecond,
+          result.MeanNs,
+          result.P50Ns,
+          result.P99Ns,
+          result.MaxNs,
+          (unsigned long long)result.WrittenCount,
+          (unsigned long long)result.LostCount);
+    } else {
+      printf(
+          "%-8s %7u %9u %12.0f %8.1f %8u %8u %8u %10llu %10llu\n",
+          workload.Name,
+          threadCount,
+          messageCount,
+          result.CallsPerSecond,
+          result.MeanNs,
+          result.P50Ns,
+          result.P99Ns,
+          result.MaxNs,
+          (unsigned long long)result.WrittenCount,
+          (unsigned long long)result.LostCount);
+    }
+
+    fflush(stdout);
+  }
+
+  worker->RemoveRepeatedMessageSubsystemException(BenchSubsystemName);
+
+  if (!found) {
+    PrintUsage();
+    return 1;
+  }
+
+  return 0;
+}
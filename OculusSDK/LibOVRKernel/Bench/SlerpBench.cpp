@@ -0,0 +1,236 @@
+/************************************************************************************
+
+Filename    :   SlerpBench.cpp
+Content     :   Speed and accuracy benchmark of the Quat interpolation functions
+Created     :   October 14, 2026
+Notes       :
+    Usage: SlerpBench [-angle <degrees>] [-count <pairs>] [-seconds <seconds>] [-csv]
+
+    Interpolates count random pairs of float rotations, at most angle degrees apart (180 by
+    default), at random fractions:
+        Slerp            Quat::Slerp, via acos and sin.
+        FastSlerp        Quat::FastSlerp, via rotation vectors.
+        PolySlerp <n>    Quat::PolySlerp with n terms, one pair at a time.
+        Batch <n>        Quat::PolySlerpBatch with n terms.
+
+    Each function is repeated until it has run for at least the given number of seconds, and
+    the mean time per interpolation is reported along with its largest error in any component
+    compared with a double precision Slerp.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "Extras/OVR_Math.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace OVR;
+
+namespace {
+
+//-----------------------------------------------------------------------------------
+// ***** Settings
+//
+const int PolySlerpTermCounts[] = {2, 4, 8, 16};
+
+typedef std::chrono::high_resolution_clock Clock;
+
+//-----------------------------------------------------------------------------------
+// ***** Inputs
+//
+struct BenchRandom {
+  uint64_t State;
+
+  explicit BenchRandom(uint64_t seed) : State(seed) {}
+
+  double Next() { // xorshift64*, in [0, 1)
+    State ^= State >> 12;
+    State ^= State << 25;
+    State ^= State >> 27;
+    return (double)((State * UINT64_C(2685821657736338717)) >> 11) / 9007199254740992.0;
+  }
+
+  Quatd NextRotation() {
+    Quatd q;
+    do {
+      q = Quatd(Next() * 2 - 1, Next() * 2 - 1, Next() * 2 - 1, Next() * 2 - 1);
+    } while ((q.LengthSq() > 1) || (q.LengthSq() < 1e-6));
+    return q.Normalized();
+  }
+};
+
+struct Inputs {
+  std::vector<Quatf> A;
+  std::vector<Quatf> B;
+  std::vector<float> S;
+  std::vector<Quatd> Expected; // Double precision Slerp of each pair.
+};
+
+void MakeInputs(size_t count, double maxAngleDegrees, Inputs& inputs) {
+  BenchRandom random(UINT64_C(0x9E3779B97F4A7C15));
+  const double maxAngle = DegreeToRad(maxAngleDegrees);
+
+  for (size_t i = 0; i < count; ++i) {
+    const Quatd a = random.NextRotation();
+    Vector3d axis;
+    do {
+      axis = Vector3d(random.Next() * 2 - 1, random.Next() * 2 - 1, random.Next() * 2 - 1);
+    } while (axis.LengthSq() < 1e-6);
+    const Quatd b = Quatd(axis.Normalized(), random.Next() * maxAngle) * a;
+    const double s = random.Next();
+
+    inputs.A.push_back(Quatf(a));
+    inputs.B.push_back(Quatf(b));
+    inputs.S.push_back((float)s);
+    inputs.Expected.push_back(Quatd(inputs.A[i]).Slerp(Quatd(inputs.B[i]), s));
+  }
+}
+
+//-----------------------------------------------------------------------------------
+// ***** RunBench
+//
+enum Function { FunctionSlerp, FunctionFastSlerp, FunctionPolySlerp, FunctionBatch };
+
+void Interpolate(Function function, int terms, const Inputs& inputs, std::vector<Quatf>& out) {
+  const size_t count = inputs.A.size();
+
+  switch (function) {
+    case FunctionSlerp:
+      for (size_t i = 0; i < count; ++i)
+        out[i] = inputs.A[i].Slerp(inputs.B[i], inputs.S[i]);
+      break;
+    case FunctionFastSlerp:
+      for (size_t i = 0; i < count; ++i)
+        out[i] = inputs.A[i].FastSlerp(inputs.B[i], inputs.S[i]);
+      break;
+    case FunctionPolySlerp:
+      for (size_t i = 0; i < count; ++i)
+        out[i] = inputs.A[i].PolySlerp(inputs.B[i], inputs.S[i], terms);
+      break;
+    default:
+      Quatf::PolySlerpBatch(
+          inputs.A.data(), inputs.B.data(), inputs.S.data(), out.data(), count, terms);
+      break;
+  }
+}
+
+struct Result {
+  double NsPerOp;
+  double MaxError;
+};
+
+Result RunBench(Function function, int terms, const Inputs& inputs, double seconds) {
+  std::vector<Quatf> out(inputs.A.size());
+
+  uint64_t opCount = 0;
+  const Clock::time_point startTime = Clock::now();
+  double elapsed = 0;
+
+  do {
+    Interpolate(function, terms, inputs, out);
+    opCount += out.size();
+    elapsed = std::chrono::duration<double>(Clock::now() - startTime).count();
+  } while (elapsed < seconds);
+
+  Result result = {(elapsed * 1e9) / (double)opCount, 0};
+
+  for (size_t i = 0; i < out.size(); ++i) {
+    // Slerp and FastSlerp may return the negation of the expected quaternion.
+    Quatd expected = inputs.Expected[i];
+    if (Quatd(out[i]).Dot(expected) < 0)
+      expected = -expected;
+
+    result.MaxError = std::max(result.MaxError, fabs(out[i].x - expected.x));
+    result.MaxError = std::max(result.MaxError, fabs(out[i].y - expected.y));
+    result.MaxError = std::max(result.MaxError, fabs(out[i].z - expected.z));
+    result.MaxError = std::max(result.MaxError, fabs(out[i].w - expected.w));
+  }
+
+  return result;
+}
+
+struct Options {
+  double AngleDegrees;
+  size_t Count;
+  double Seconds;
+  bool Csv;
+};
+
+void Report(const char* name, int terms, const Result& result, const Options& options) {
+  if (options.Csv)
+    printf("%s,%d,%.3f,%.3g\n", name, terms, result.NsPerOp, result.MaxError);
+  else if (terms)
+    printf("%-10s %5d %10.2f %12.3g\n", name, terms, result.NsPerOp, result.MaxError);
+  else
+    printf("%-10s %5s %10.2f %12.3g\n", name, "", result.NsPerOp, result.MaxError);
+  fflush(stdout);
+}
+
+void PrintUsage() {
+  printf("Usage: SlerpBench [-angle <degrees>] [-count <pairs>] [-seconds <seconds>] [-csv]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options options = {180, 4096, 0.5, false};
+
+  for (int i = 1; i < argc; ++i) {
+    const bool hasValue = (i + 1) < argc;
+
+    if (!strcmp(argv[i], "-angle") && hasValue)
+      options.AngleDegrees = std::min(std::max(atof(argv[++i]), 0.0), 180.0);
+    else if (!strcmp(argv[i], "-count") && hasValue)
+      options.Count = (size_t)std::max(1, atoi(argv[++i]));
+    else if (!strcmp(argv[i], "-seconds") && hasValue)
+      options.Seconds = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-csv"))
+      options.Csv = true;
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  Inputs inputs;
+  MakeInputs(options.Count, options.AngleDegrees, inputs);
+
+  if (options.Csv)
+    printf("function,terms,ns_per_op,max_error\n");
+  else
+    printf("%-10s %5s %10s %12s\n", "Function", "Terms", "ns", "Max error");
+
+  Report("Slerp", 0, RunBench(FunctionSlerp, 0, inputs, options.Seconds), options);
+  Report("FastSlerp", 0, RunBench(FunctionFastSlerp, 0, inputs, options.Seconds), options);
+
+  for (int terms : PolySlerpTermCounts)
+    Report(
+        "PolySlerp", terms, RunBench(FunctionPolySlerp, terms, inputs, options.Seconds), options);
+
+  for (int terms : PolySlerpTermCounts)
+    Report("Batch", terms, RunBench(FunctionBatch, terms, inputs, options.Seconds), options);
+
+  return 0;
+}
@@ -0,0 +1,351 @@
+/************************************************************************************
+
+Filename    :   UTF8Bench.cpp
+Content     :   Throughput benchmark for the OVR_UTF8Util functions
+Created     :   October 14, 2026
+Notes       :
+    Usage: UTF8Bench [-text <name>|all] [-op <name>|all] [-seconds <seconds>] [-csv]
+
+    Texts are ascii (log lines), latin (French), cyrillic (Russian), cjk (Japanese) and mixed
+    (all of these, plus emoji, interleaved line by line), each repeated to about 64KB.
+
+    Ops:
+        length    UTF8Util::GetLength
+        towide    UTF8Util::Strlcpy to wchar_t
+        fromwide  UTF8Util::Strlcpy from wchar_t
+        validate  UTF8Util::IsValidUTF8
+        toutf16   UTF8Util::ConvertUTF8ToUTF16
+        fromutf16 UTF8Util::ConvertUTF16ToUTF8
+
+    Each op is compared with a loop over DecodeNextChar and EncodeChar, one character at a
+    time, which is how the library handled all text before. Throughput is in GB/s of UTF-8.
+    Results are checked against those loops, and a mismatch fails the run.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "Kernel/OVR_UTF8Util.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace OVR;
+
+namespace {
+
+//-----------------------------------------------------------------------------------
+// ***** Texts
+//
+const size_t TextSize = 65536;
+
+const char* const AsciiLine =
+    "[OculusWorldDemoApp] Frame 1234 submitted in 2.31 ms, 0 dropped, layers: 3\n";
+const char* const LatinLine = "Le c\xC5\x93ur de l'\xC3\xA9t\xC3\xA9 s'ouvre \xC3\xA0 la "
+                              "for\xC3\xAAt, d\xC3\xA9j\xC3\xA0 fran\xC3\xA7" "aise.\n";
+const char* const CyrillicLine =
+    "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82, \xD0\xBC\xD0\xB8\xD1\x80! "
+    "\xD0\xA1\xD0\xBA\xD0\xBE\xD1\x80\xD0\xBE\xD1\x81\xD1\x82\xD1\x8C 42 \xD0\xBA\xD0\xBC.\n";
+const char* const CJKLine = "\xE3\x83\x88\xE3\x83\xAC\xE3\x83\x83\xE3\x83\x89\xE3\x83\x9F"
+                            "\xE3\x83\xAB\xE3\x81\xAE\xE9\x80\x9F\xE5\xBA\xA6\xE3\x81\xAF"
+                            "3.5 km/h \xE3\x81\xA7\xE3\x81\x99\xE3\x80\x82\n";
+const char* const EmojiLine = "Status \xF0\x9F\x9F\xA2 ok \xF0\x9F\x8E\xAE "
+                              "controller \xF0\x9F\x94\x8B 87%\n";
+
+enum Text { TextAscii, TextLatin, TextCyrillic, TextCJK, TextMixed, TextCount };
+
+const char* const TextNames[TextCount] = {"ascii", "latin", "cyrillic", "cjk", "mixed"};
+
+std::string MakeText(Text text) {
+  const char* const mixed[] = {AsciiLine, LatinLine, AsciiLine, CyrillicLine, CJKLine, EmojiLine};
+  const char* const single[] = {AsciiLine, LatinLine, CyrillicLine, CJKLine};
+  std::string result;
+
+  for (size_t line = 0; result.size() < TextSize; ++line)
+    result += (text == TextMixed) ? mixed[line % OVR_ARRAY_COUNT(mixed)] : single[text];
+
+  return result;
+}
+
+//-----------------------------------------------------------------------------------
+// ***** Reference loops
+//
+// One character at a time, through DecodeNextChar_Advance0 and EncodeChar.
+//
+size_t ReferenceLength(const std::string& text) {
+  const char* p = text.data();
+  const char* end = p + text.size();
+  size_t length = 0;
+  for (; p < end; ++length)
+    UTF8Util::DecodeNextChar_Advance0(&p);
+  return length;
+}
+
+void ReferenceToWide(const std::string& text, std::vector<wchar_t>& wide) {
+  const char* p = text.data();
+  const char* end = p + text.size();
+  wide.clear();
+  while (p < end) {
+    uint32_t c = UTF8Util::DecodeNextChar_Advance0(&p);
+    if ((sizeof(wchar_t) == 2) && (c >= 0xFFFF)) // As Strlcpy does for 16-bit wchar_t.
+      c = 0xFFFD;
+    wide.push_back((wchar_t)c);
+  }
+}
+
+void ReferenceFromWide(const std::vector<wchar_t>& wide, std::string& text) {
+  text.resize(wide.size() * 6);
+  intptr_t offset = 0;
+  for (wchar_t c : wide)
+    UTF8Util::EncodeChar(&text[0], &offset, (uint32_t)c);
+  text.resize((size_t)offset);
+}
+
+void ReferenceToUTF16(const std::string& text, std::vector<uint16_t>& utf16) {
+  const char* p = text.data();
+  const char* end = p + text.size();
+  utf16.clear();
+  while (p < end) {
+    uint32_t c = UTF8Util::DecodeNextChar_Advance0(&p);
+    if (c >= 0x10000) {
+      utf16.push_back((uint16_t)(0xD800 + ((c - 0x10000) >> 10)));
+      c = 0xDC00 + ((c - 0x10000) & 0x3FF);
+    }
+    utf16.push_back((uint16_t)c);
+  }
+}
+
+void ReferenceFromUTF16(const std::vector<uint16_t>& utf16, std::string& text) {
+  text.resize(utf16.size() * 3);
+  intptr_t offset = 0;
+  for (size_t i = 0; i < utf16.size(); ++i) {
+    uint32_t c = utf16[i];
+    if ((c >= 0xD800) && (c <= 0xDBFF) && ((i + 1) < utf16.size()))
+      c = 0x10000 + ((c - 0xD800) << 10) + (utf16[++i] - 0xDC00);
+    UTF8Util::EncodeChar(&text[0], &offset, c);
+  }
+  text.resize((size_t)offset);
+}
+
+//-----------------------------------------------------------------------------------
+// ***** Ops
+//
+enum Op { OpLength, OpToWide, OpFromWide, OpValidate, OpToUTF16, OpFromUTF16, OpCount };
+
+const char* const OpNames[OpCount] = {
+    "length", "towide", "fromwide", "validate", "toutf16", "fromutf16"};
+
+struct Buffers {
+  std::string Text;
+  std::vector<wchar_t> Wide;
+  std::vector<uint16_t> UTF16;
+  std::string TextOut;
+  std::vector<wchar_t> WideOut;
+  std::vector<uint16_t> UTF16Out;
+};
+
+volatile size_t Sink;
+
+void RunOp(Op op, bool reference, Buffers& b) {
+  const size_t size = b.Text.size();
+
+  switch (op) {
+    case OpLength:
+      Sink = reference ? ReferenceLength(b.Text)
+                       : (size_t)UTF8Util::GetLength(b.Text.data(), (intptr_t)size);
+      break;
+    case OpToWide:
+      if (reference)
+        ReferenceToWide(b.Text, b.WideOut);
+      else
+        Sink = UTF8Util::Strlcpy(b.WideOut.data(), b.WideOut.size(), b.Text.data(), size);
+      break;
+    case OpFromWide:
+      if (reference)
+        ReferenceFromWide(b.Wide, b.TextOut);
+      else
+        Sink = UTF8Util::Strlcpy(&b.TextOut[0], b.TextOut.size(), b.Wide.data(), b.Wide.size());
+      break;
+    case OpValidate:
+      // The reference decoder doesn't validate strictly, so it's just a decode loop here.
+      Sink = reference ? ReferenceLength(b.Text) : UTF8Util::IsValidUTF8(b.Text.data(), size);
+      break;
+    case OpToUTF16:
+      if (reference)
+        ReferenceToUTF16(b.Text, b.UTF16Out);
+      else
+        Sink = UTF8Util::ConvertUTF8ToUTF16(
+            b.UTF16Out.data(), b.UTF16Out.size(), b.Text.data(), size);
+      break;
+    default:
+      if (reference)
+        ReferenceFromUTF16(b.UTF16, b.TextOut);
+      else
+        Sink = UTF8Util::ConvertUTF16ToUTF8(
+            &b.TextOut[0], b.TextOut.size(), b.UTF16.data(), b.UTF16.size());
+      break;
+  }
+}
+
+void PrepareBuffers(Text text, Buffers& b) {
+  b.Text = MakeText(text);
+  ReferenceToWide(b.Text, b.Wide);
+  ReferenceToUTF16(b.Text, b.UTF16);
+
+  // Room for the results and a terminator, as the Strlcpy calls need.
+  b.TextOut.assign(b.Text.size() + 1, '\0');
+  b.WideOut.assign(b.Wide.size() + 1, L'\0');
+  b.UTF16Out.assign(b.UTF16.size(), 0);
+}
+
+// Each op must give the reference result.
+bool Check(Text text, Buffers& b) {
+  const size_t size = b.Text.size();
+  bool ok = (size_t)UTF8Util::GetLength(b.Text.data(), (intptr_t)size) == ReferenceLength(b.Text);
+  ok = ok && ((size_t)UTF8Util::GetLength(b.Text.c_str()) == ReferenceLength(b.Text));
+  ok = ok && UTF8Util::IsValidUTF8(b.Text.data(), size);
+
+  ok = ok && (UTF8Util::Strlcpy(b.WideOut.data(), b.WideOut.size(), b.Text.data(), size) ==
+              b.Wide.size());
+  ok = ok && !memcmp(b.WideOut.data(), b.Wide.data(), b.Wide.size() * sizeof(wchar_t));
+
+  std::string fromWide;
+  ReferenceFromWide(b.Wide, fromWide);
+  ok = ok && (UTF8Util::Strlcpy(&b.TextOut[0], b.TextOut.size(), b.Wide.data(), b.Wide.size()) ==
+              fromWide.size());
+  ok = ok && !memcmp(b.TextOut.data(), fromWide.data(), fromWide.size());
+
+  ok = ok && (UTF8Util::ConvertUTF8ToUTF16(
+                  b.UTF16Out.data(), b.UTF16Out.size(), b.Text.data(), size) == b.UTF16.size());
+  ok = ok && (b.UTF16Out == b.UTF16);
+
+  ok = ok && (UTF8Util::ConvertUTF16ToUTF8(
+                  &b.TextOut[0], b.TextOut.size(), b.UTF16.data(), b.UTF16.size()) == size);
+  ok = ok && !memcmp(b.TextOut.data(), b.Text.data(), size);
+
+  if (!ok)
+    printf("%s: results differ from the reference loops\n", TextNames[text]);
+  return ok;
+}
+
+// Returns GB/s of UTF-8 text.
+double RunBench(Op op, bool reference, Buffers& b, double seconds) {
+  typedef std::chrono::high_resolution_clock Clock;
+  uint64_t byteCount = 0;
+  const Clock::time_point startTime = Clock::now();
+  double elapsed = 0;
+
+  do {
+    for (int i = 0; i < 8; ++i) {
+      RunOp(op, reference, b);
+      byteCount += b.Text.size();
+    }
+
+    elapsed = std::chrono::duration<double>(Clock::now() - startTime).count();
+  } while (elapsed < seconds);
+
+  return ((double)byteCount / 1e9) / elapsed;
+}
+
+void PrintUsage() {
+  printf("Usage: UTF8Bench [-text <name>|all] [-op <name>|all] [-seconds <seconds>] [-csv]\n");
+  printf("Texts:");
+  for (const char* name : TextNames)
+    printf(" %s", name);
+  printf("\nOps:");
+  for (const char* name : OpNames)
+    printf(" %s", name);
+  printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const char* textName = "all";
+  const char* opName = "all";
+  double seconds = 0.25;
+  bool csv = false;
+
+  for (int i = 1; i < argc; ++i) {
+    const bool hasValue = (i + 1) < argc;
+
+    if (!strcmp(argv[i], "-text") && hasValue)
+      textName = argv[++i];
+    else if (!strcmp(argv[i], "-op") && hasValue)
+      opName = argv[++i];
+    else if (!strcmp(argv[i], "-seconds") && hasValue)
+      seconds = atof(argv[++i]);
+    else if (!strcmp(argv[i], "-csv"))
+      csv = true;
+    else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  if (csv)
+    printf("text,op,reference_gbps,gbps\n");
+  else
+    printf("%-9s %-9s %11s %11s %9s\n", "Text", "Op", "Char GB/s", "GB/s", "Speedup");
+
+  bool found = false;
+
+  for (int t = 0; t < TextCount; ++t) {
+    if (strcmp(textName, "all") && strcmp(textName, TextNames[t]))
+      continue;
+
+    Buffers buffers;
+    PrepareBuffers((Text)t, buffers);
+    if (!Check((Text)t, buffers))
+      return 2;
+
+    for (int o = 0; o < OpCount; ++o) {
+      if (strcmp(opName, "all") && strcmp(opName, OpNames[o]))
+        continue;
+
+      found = true;
+
+      const double referenceGBps = RunBench((Op)o, true, buffers, seconds);
+      const double GBps = RunBench((Op)o, false, buffers, seconds);
+
+      if (csv)
+        printf("%s,%s,%.3f,%.3f\n", TextNames[t], OpNames[o], referenceGBps, GBps);
+      else
+        printf(
+            "%-9s %-9s %11.3f %11.3f %8.2fx\n",
+            TextNames[t],
+            OpNames[o],
+            referenceGBps,
+            GBps,
+            (referenceGBps > 0) ? (GBps / referenceGBps) : 0);
+
+      fflush(stdout);
+    }
+  }
+
+  if (!found) {
+    PrintUsage();
+    return 1;
+  }
+
+  return 0;
+}
@@ -135,7 +135,8 @@ OVR::GLEContext::GLEContext()
       EnableHookGetError(true),
       PlatformMajorVersion(0),
       PlatformMinorVersion(0),
-      PlatformWholeVersion(0) {
+      PlatformWholeVersion(0),
+      RequestedExtensions(NULL) {
   // The following sequence is not thread-safe. Two threads could set the context to this at the
   // same time.
   if (GetCurrentContext() == NULL)
@@ -147,14 +148,104 @@ OVR::GLEContext::~GLEContext() {
     SetCurrentContext(NULL);
 }
 
+// Init cache
+// Looking up every function and searching the extension list is slow, and applications often
+// create more than one context on the same driver (e.g. a loading context and a render context).
+// So we remember the last context Init completed and copy it into contexts that match it. Function
+// addresses from wglGetProcAddress are valid only for the same pixel format on the same device,
+// hence the pixel format is part of the key on Windows. Like the current context, this is not
+// thread-safe.
+namespace {
+struct GLECacheKey {
+  std::string Vendor;
+  std::string Renderer;
+  std::string Version;
+  int PixelFormat;
+  const char* const* RequestedExtensions;
+
+  bool operator==(const GLECacheKey& other) const {
+    return (Vendor == other.Vendor) && (Renderer == other.Renderer) &&
+        (Version == other.Version) && (PixelFormat == other.PixelFormat) &&
+        (RequestedExtensions == other.RequestedExtensions);
+  }
+};
+
+struct GLECacheEntry {
+  bool Valid;
+  GLECacheKey Key;
+  // Raw storage rather than a GLEContext, as the GLEContext constructor would make it current.
+  double Context[(sizeof(OVR::GLEContext) + sizeof(double) - 1) / sizeof(double)];
+};
+
+GLECacheEntry GLECache;
+
+// Returns false if there is no current OpenGL context to make a key from.
+bool GetCacheKey(GLECacheKey& key, const char* const* requestedExtensions) {
+  const char* vendor = (const char*)glGetString(GL_VENDOR);
+  const char* renderer = (const char*)glGetString(GL_RENDERER);
+  const char* version = (const char*)glGetString(GL_VERSION);
+
+  if (!vendor || !renderer || !version)
+    return false;
+
+  key.Vendor = vendor;
+  key.Renderer = renderer;
+  key.Version = version;
+#if defined(GLE_WGL_ENABLED)
+  key.PixelFormat = GetPixelFormat(wglGetCurrentDC());
+#else
+  key.PixelFormat = 0;
+#endif
+  key.RequestedExtensions = requestedExtensions;
+  return true;
+}
+} // namespace
+
 void OVR::GLEContext::Init() {
+  GLECacheKey key;
+  bool haveKey = !IsInitialized() && GetCacheKey(key, RequestedExtensions);
+
+  if (haveKey && GLECache.Valid && (GLECache.Key == key)) {
+    // This memcpy is valid for the same reason as the memset in Shutdown.
+    const bool enableHookGetError = EnableHookGetError;
+    memcpy(this, GLECache.Context, sizeof(GLEContext));
+    EnableHookGetError = enableHookGetError;
+    return;
+  }
+
   PlatformInit();
 
   if (!IsInitialized()) {
     InitVersion();
     InitExtensionLoad();
     InitExtensionSupport();
+
+    if (haveKey) {
+      memcpy(GLECache.Context, this, sizeof(GLEContext));
+      GLECache.Key = key;
+      GLECache.Valid = true;
+    }
+  }
+}
+
+void OVR::GLEContext::ClearCache() {
+  GLECache.Valid = false;
+}
+
+void OVR::GLEContext::SetRequestedExtensions(const char* const* extensions) {
+  RequestedExtensions = extensions;
+}
+
+bool OVR::GLEContext::IsExtensionRequested(const char* extension) const {
+  if (!RequestedExtensions)
+    return true;
+
+  for (const char* const* p = RequestedExtensions; *p; ++p) {
+    if (strcmp(*p, extension) == 0)
+      return true;
   }
+
+  return false;
 }
 
 bool OVR::GLEContext::IsInitialized() const {
@@ -549,161 +640,215 @@ void OVR::GLEContext::InitExtensionLoad() {
   GLELoadProc(glBindImageTexture_Impl, glBindImageTexture);
 
   // GL_AMD_debug_output
-  GLELoadProc(glDebugMessageCallbackAMD_Impl, glDebugMessageCallbackAMD);
-  GLELoadProc(glDebugMessageEnableAMD_Impl, glDebugMessageEnableAMD);
-  GLELoadProc(glDebugMessageInsertAMD_Impl, glDebugMessageInsertAMD);
-  GLELoadProc(glGetDebugMessageLogAMD_Impl, glGetDebugMessageLogAMD);
+  if (IsExtensionRequested("GL_AMD_debug_output")) {
+    GLELoadProc(glDebugMessageCallbackAMD_Impl, glDebugMessageCallbackAMD);
+    GLELoadProc(glDebugMessageEnableAMD_Impl, glDebugMessageEnableAMD);
+    GLELoadProc(glDebugMessageInsertAMD_Impl, glDebugMessageInsertAMD);
+    GLELoadProc(glGetDebugMessageLogAMD_Impl, glGetDebugMessageLogAMD);
+  }
 
 #if defined(GLE_CGL_ENABLED)
   // GL_APPLE_element_array
-  GLELoadProc(glDrawElementArrayAPPLE_Impl, glDrawElementArrayAPPLE);
-  GLELoadProc(glDrawRangeElementArrayAPPLE_Impl, glDrawRangeElementArrayAPPLE);
-  GLELoadProc(glElementPointerAPPLE_Impl, glElementPointerAPPLE);
-  GLELoadProc(glMultiDrawElementArrayAPPLE_Impl, glMultiDrawElementArrayAPPLE);
-  GLELoadProc(glMultiDrawRangeElementArrayAPPLE_Impl, glMultiDrawRangeElementArrayAPPLE);
+  if (IsExtensionRequested("GL_APPLE_element_array")) {
+    GLELoadProc(glDrawElementArrayAPPLE_Impl, glDrawElementArrayAPPLE);
+    GLELoadProc(glDrawRangeElementArrayAPPLE_Impl, glDrawRangeElementArrayAPPLE);
+    GLELoadProc(glElementPointerAPPLE_Impl, glElementPointerAPPLE);
+    GLELoadProc(glMultiDrawElementArrayAPPLE_Impl, glMultiDrawElementArrayAPPLE);
+    GLELoadProc(glMultiDrawRangeElementArrayAPPLE_Impl, glMultiDrawRangeElementArrayAPPLE);
+  }
 
   // GL_APPLE_fence
-  GLELoadProc(glDeleteFencesAPPLE_Impl, glDeleteFencesAPPLE);
-  GLELoadProc(glFinishFenceAPPLE_Impl, glFinishFenceAPPLE);
-  GLELoadProc(glFinishObjectAPPLE_Impl, glFinishObjectAPPLE);
-  GLELoadProc(glGenFencesAPPLE_Impl, glGenFencesAPPLE);
-  GLELoadProc(glIsFenceAPPLE_Impl, glIsFenceAPPLE);
-  GLELoadProc(glSetFenceAPPLE_Impl, glSetFenceAPPLE);
-  GLELoadProc(glTestFenceAPPLE_Impl, glTestFenceAPPLE);
-  GLELoadProc(glTestObjectAPPLE_Impl, glTestObjectAPPLE);
+  if (IsExtensionRequested("GL_APPLE_fence")) {
+    GLELoadProc(glDeleteFencesAPPLE_Impl, glDeleteFencesAPPLE);
+    GLELoadProc(glFinishFenceAPPLE_Impl, glFinishFenceAPPLE);
+    GLELoadProc(glFinishObjectAPPLE_Impl, glFinishObjectAPPLE);
+    GLELoadProc(glGenFencesAPPLE_Impl, glGenFencesAPPLE);
+    GLELoadProc(glIsFenceAPPLE_Impl, glIsFenceAPPLE);
+    GLELoadProc(glSetFenceAPPLE_Impl, glSetFenceAPPLE);
+    GLELoadProc(glTestFenceAPPLE_Impl, glTestFenceAPPLE);
+    GLELoadProc(glTestObjectAPPLE_Impl, glTestObjectAPPLE);
+  }
 
   // GL_APPLE_flush_buffer_range
-  GLELoadProc(glBufferParameteriAPPLE_Impl, glMultiDrawRangeElementArrayAPPLE);
-  GLELoadProc(glFlushMappedBufferRangeAPPLE_Impl, glFlushMappedBufferRangeAPPLE);
+  if (IsExtensionRequested("GL_APPLE_flush_buffer_range")) {
+    GLELoadProc(glBufferParameteriAPPLE_Impl, glMultiDrawRangeElementArrayAPPLE);
+    GLELoadProc(glFlushMappedBufferRangeAPPLE_Impl, glFlushMappedBufferRangeAPPLE);
+  }
 
   // GL_APPLE_object_purgeable
-  GLELoadProc(glGetObjectParameterivAPPLE_Impl, glGetObjectParameterivAPPLE);
-  GLELoadProc(glObjectPurgeableAPPLE_Impl, glObjectPurgeableAPPLE);
-  GLELoadProc(glObjectUnpurgeableAPPLE_Impl, glObjectUnpurgeableAPPLE);
+  if (IsExtensionRequested("GL_APPLE_object_purgeable")) {
+    GLELoadProc(glGetObjectParameterivAPPLE_Impl, glGetObjectParameterivAPPLE);
+    GLELoadProc(glObjectPurgeableAPPLE_Impl, glObjectPurgeableAPPLE);
+    GLELoadProc(glObjectUnpurgeableAPPLE_Impl, glObjectUnpurgeableAPPLE);
+  }
 
   // GL_APPLE_texture_range
-  GLELoadProc(glGetTexParameterPointervAPPLE_Impl, glGetTexParameterPointervAPPLE);
-  GLELoadProc(glTextureRangeAPPLE_Impl, glTextureRangeAPPLE);
+  if (IsExtensionRequested("GL_APPLE_texture_range")) {
+    GLELoadProc(glGetTexParameterPointervAPPLE_Impl, glGetTexParameterPointervAPPLE);
+    GLELoadProc(glTextureRangeAPPLE_Impl, glTextureRangeAPPLE);
+  }
 
   // GL_APPLE_vertex_array_object
-  GLELoadProc(glBindVertexArrayAPPLE_Impl, glBindVertexArrayAPPLE);
-  GLELoadProc(glDeleteVertexArraysAPPLE_Impl, glDeleteVertexArraysAPPLE);
-  GLELoadProc(glGenVertexArraysAPPLE_Impl, glGenVertexArraysAPPLE);
-  GLELoadProc(glIsVertexArrayAPPLE_Impl, glIsVertexArrayAPPLE);
+  if (IsExtensionRequested("GL_APPLE_vertex_array_object")) {
+    GLELoadProc(glBindVertexArrayAPPLE_Impl, glBindVertexArrayAPPLE);
+    GLELoadProc(glDeleteVertexArraysAPPLE_Impl, glDeleteVertexArraysAPPLE);
+    GLELoadProc(glGenVertexArraysAPPLE_Impl, glGenVertexArraysAPPLE);
+    GLELoadProc(glIsVertexArrayAPPLE_Impl, glIsVertexArrayAPPLE);
+  }
 
   // GL_APPLE_vertex_array_range
-  GLELoadProc(glFlushVertexArrayRangeAPPLE_Impl, glFlushVertexArrayRangeAPPLE);
-  GLELoadProc(glVertexArrayParameteriAPPLE_Impl, glVertexArrayParameteriAPPLE);
-  GLELoadProc(glVertexArrayRangeAPPLE_Impl, glVertexArrayRangeAPPLE);
+  if (IsExtensionRequested("GL_APPLE_vertex_array_range")) {
+    GLELoadProc(glFlushVertexArrayRangeAPPLE_Impl, glFlushVertexArrayRangeAPPLE);
+    GLELoadProc(glVertexArrayParameteriAPPLE_Impl, glVertexArrayParameteriAPPLE);
+    GLELoadProc(glVertexArrayRangeAPPLE_Impl, glVertexArrayRangeAPPLE);
+  }
 
   // GL_APPLE_vertex_program_evaluators
-  GLELoadProc(glDisableVertexAttribAPPLE_Impl, glDisableVertexAttribAPPLE);
-  GLELoadProc(glEnableVertexAttribAPPLE_Impl, glEnableVertexAttribAPPLE);
-  GLELoadProc(glIsVertexAttribEnabledAPPLE_Impl, glIsVertexAttribEnabledAPPLE);
-  GLELoadProc(glMapVertexAttrib1dAPPLE_Impl, glMapVertexAttrib1dAPPLE);
-  GLELoadProc(glMapVertexAttrib1fAPPLE_Impl, glMapVertexAttrib1fAPPLE);
-  GLELoadProc(glMapVertexAttrib2dAPPLE_Impl, glMapVertexAttrib2dAPPLE);
-  GLELoadProc(glMapVertexAttrib2fAPPLE_Impl, glMapVertexAttrib2fAPPLE);
+  if (IsExtensionRequested("GL_APPLE_vertex_program_evaluators")) {
+    GLELoadProc(glDisableVertexAttribAPPLE_Impl, glDisableVertexAttribAPPLE);
+    GLELoadProc(glEnableVertexAttribAPPLE_Impl, glEnableVertexAttribAPPLE);
+    GLELoadProc(glIsVertexAttribEnabledAPPLE_Impl, glIsVertexAttribEnabledAPPLE);
+    GLELoadProc(glMapVertexAttrib1dAPPLE_Impl, glMapVertexAttrib1dAPPLE);
+    GLELoadProc(glMapVertexAttrib1fAPPLE_Impl, glMapVertexAttrib1fAPPLE);
+    GLELoadProc(glMapVertexAttrib2dAPPLE_Impl, glMapVertexAttrib2dAPPLE);
+    GLELoadProc(glMapVertexAttrib2fAPPLE_Impl, glMapVertexAttrib2fAPPLE);
+  }
 
 #endif // GLE_CGL_ENABLED
 
+  // GL_ARB_buffer_storage
+  if (IsExtensionRequested("GL_ARB_buffer_storage")) {
+    GLELoadProc(glBufferStorage_Impl, glBufferStorage);
+  }
+
   // GL_ARB_copy_buffer
-  GLELoadProc(glCopyBufferSubData_Impl, glCopyBufferSubData);
+  if (IsExtensionRequested("GL_ARB_copy_buffer")) {
+    GLELoadProc(glCopyBufferSubData_Impl, glCopyBufferSubData);
+  }
 
   // GL_ARB_debug_output
-  GLELoadProc(glDebugMessageCallbackARB_Impl, glDebugMessageCallbackARB);
-  GLELoadProc(glDebugMessageControlARB_Impl, glDebugMessageControlARB);
-  GLELoadProc(glDebugMessageInsertARB_Impl, glDebugMessageInsertARB);
-  GLELoadProc(glGetDebugMessageLogARB_Impl, glGetDebugMessageLogARB);
+  if (IsExtensionRequested("GL_ARB_debug_output")) {
+    GLELoadProc(glDebugMessageCallbackARB_Impl, glDebugMessageCallbackARB);
+    GLELoadProc(glDebugMessageControlARB_Impl, glDebugMessageControlARB);
+    GLELoadProc(glDebugMessageInsertARB_Impl, glDebugMessageInsertARB);
+    GLELoadProc(glGetDebugMessageLogARB_Impl, glGetDebugMessageLogARB);
+  }
 
   // GL_ARB_ES2_compatibility
-  GLELoadProc(glClearDepthf_Impl, glClearDepthf);
-  GLELoadProc(glDepthRangef_Impl, glDepthRangef);
-  GLELoadProc(glGetShaderPrecisionFormat_Impl, glGetShaderPrecisionFormat);
-  GLELoadProc(glReleaseShaderCompiler_Impl, glReleaseShaderCompiler);
-  GLELoadProc(glShaderBinary_Impl, glShaderBinary);
+  if (IsExtensionRequested("GL_ARB_ES2_compatibility")) {
+    GLELoadProc(glClearDepthf_Impl, glClearDepthf);
+    GLELoadProc(glDepthRangef_Impl, glDepthRangef);
+    GLELoadProc(glGetShaderPrecisionFormat_Impl, glGetShaderPrecisionFormat);
+    GLELoadProc(glReleaseShaderCompiler_Impl, glReleaseShaderCompiler);
+    GLELoadProc(glShaderBinary_Impl, glShaderBinary);
+  }
 
   // GL_ARB_framebuffer_object
-  GLELoadProc(glBindFramebuffer_Impl, glBindFramebuffer);
-  GLELoadProc(glBindRenderbuffer_Impl, glBindRenderbuffer);
-  GLELoadProc(glBlitFramebuffer_Impl, glBlitFramebuffer);
-  GLELoadProc(glCheckFramebufferStatus_Impl, glCheckFramebufferStatus);
-  GLELoadProc(glDeleteFramebuffers_Impl, glDeleteFramebuffers);
-  GLELoadProc(glDeleteRenderbuffers_Impl, glDeleteRenderbuffers);
-  GLELoadProc(glFramebufferRenderbuffer_Impl, glFramebufferRenderbuffer);
-  GLELoadProc(glFramebufferTexture1D_Impl, glFramebufferTexture1D);
-  GLELoadProc(glFramebufferTexture2D_Impl, glFramebufferTexture2D);
-  GLELoadProc(glFramebufferTexture3D_Impl, glFramebufferTexture3D);
-  GLELoadProc(glFramebufferTextureLayer_Impl, glFramebufferTextureLayer);
-  GLELoadProc(glGenFramebuffers_Impl, glGenFramebuffers);
-  GLELoadProc(glGenRenderbuffers_Impl, glGenRenderbuffers);
-  GLELoadProc(glGenerateMipmap_Impl, glGenerateMipmap);
-  GLELoadProc(glGetFramebufferAttachmentParameteriv_Impl, glGetFramebufferAttachmentParameteriv);
-  GLELoadProc(glGetRenderbufferParameteriv_Impl, glGetRenderbufferParameteriv);
-  GLELoadProc(glIsFramebuffer_Impl, glIsFramebuffer);
-  GLELoadProc(glIsRenderbuffer_Impl, glIsRenderbuffer);
-  GLELoadProc(glRenderbufferStorage_Impl, glRenderbufferStorage);
-  GLELoadProc(glRenderbufferStorageMultisample_Impl, glRenderbufferStorageMultisample);
-
-  if (!glBindFramebuffer_Impl) // This will rarely if ever be the case in practice with modern
-  // computers and drivers.
-  {
-    // See if we can map GL_EXT_framebuffer_object to GL_ARB_framebuffer_object. The former is
-    // basically a subset of the latter, but we use only that subset.
-    GLELoadProc(glBindFramebuffer_Impl, glBindFramebufferEXT);
-    GLELoadProc(glBindRenderbuffer_Impl, glBindRenderbufferEXT);
-    // GLELoadProc(glBlitFramebuffer_Impl, glBlitFramebufferEXT (nonexistent));
-    GLELoadProc(glCheckFramebufferStatus_Impl, glCheckFramebufferStatusEXT);
-    GLELoadProc(glDeleteFramebuffers_Impl, glDeleteFramebuffersEXT);
-    GLELoadProc(glDeleteRenderbuffers_Impl, glDeleteRenderbuffersEXT);
-    GLELoadProc(glFramebufferRenderbuffer_Impl, glFramebufferRenderbufferEXT);
-    GLELoadProc(glFramebufferTexture1D_Impl, glFramebufferTexture1DEXT);
-    GLELoadProc(glFramebufferTexture2D_Impl, glFramebufferTexture2DEXT);
-    GLELoadProc(glFramebufferTexture3D_Impl, glFramebufferTexture3DEXT);
-    // GLELoadProc(glFramebufferTextureLayer_Impl, glFramebufferTextureLayerEXT (nonexistent));
-    GLELoadProc(glGenFramebuffers_Impl, glGenFramebuffersEXT);
-    GLELoadProc(glGenRenderbuffers_Impl, glGenRenderbuffersEXT);
-    GLELoadProc(glGenerateMipmap_Impl, glGenerateMipmapEXT);
-    GLELoadProc(
-        glGetFramebufferAttachmentParameteriv_Impl, glGetFramebufferAttachmentParameterivEXT);
-    GLELoadProc(glGetRenderbufferParameteriv_Impl, glGetRenderbufferParameterivEXT);
-    GLELoadProc(glIsFramebuffer_Impl, glIsFramebufferEXT);
-    GLELoadProc(glIsRenderbuffer_Impl, glIsRenderbufferEXT);
-    GLELoadProc(glRenderbufferStorage_Impl, glRenderbufferStorageEXT);
-    // GLELoadProc(glRenderbufferStorageMultisample_Impl, glRenderbufferStorageMultisampleEXT
-    // (nonexistent));
+  if (IsExtensionRequested("GL_ARB_framebuffer_object")) {
+    GLELoadProc(glBindFramebuffer_Impl, glBindFramebuffer);
+    GLELoadProc(glBindRenderbuffer_Impl, glBindRenderbuffer);
+    GLELoadProc(glBlitFramebuffer_Impl, glBlitFramebuffer);
+    GLELoadProc(glCheckFramebufferStatus_Impl, glCheckFramebufferStatus);
+    GLELoadProc(glDeleteFramebuffers_Impl, glDeleteFramebuffers);
+    GLELoadProc(glDeleteRenderbuffers_Impl, glDeleteRenderbuffers);
+    GLELoadProc(glFramebufferRenderbuffer_Impl, glFramebufferRenderbuffer);
+    GLELoadProc(glFramebufferTexture1D_Impl, glFramebufferTexture1D);
+    GLELoadProc(glFramebufferTexture2D_Impl, glFramebufferTexture2D);
+    GLELoadProc(glFramebufferTexture3D_Impl, glFramebufferTexture3D);
+    GLELoadProc(glFramebufferTextureLayer_Impl, glFramebufferTextureLayer);
+    GLELoadProc(glGenFramebuffers_Impl, glGenFramebuffers);
+    GLELoadProc(glGenRenderbuffers_Impl, glGenRenderbuffers);
+    GLELoadProc(glGenerateMipmap_Impl, glGenerateMipmap);
+    GLELoadProc(glGetFramebufferAttachmentParameteriv_Impl, glGetFramebufferAttachmentParameteriv);
+    GLELoadProc(glGetRenderbufferParameteriv_Impl, glGetRenderbufferParameteriv);
+    GLELoadProc(glIsFramebuffer_Impl, glIsFramebuffer);
+    GLELoadProc(glIsRenderbuffer_Impl, glIsRenderbuffer);
+    GLELoadProc(glRenderbufferStorage_Impl, glRenderbufferStorage);
+    GLELoadProc(glRenderbufferStorageMultisample_Impl, glRenderbufferStorageMultisample);
+
+    if (!glBindFramebuffer_Impl) // This will rarely if ever be the case in practice with modern
+    // computers and drivers.
+    {
+      // See if we can map GL_EXT_framebuffer_object to GL_ARB_framebuffer_object. The former is
+      // basically a subset of the latter, but we use only that subset.
+      GLELoadProc(glBindFramebuffer_Impl, glBindFramebufferEXT);
+      GLELoadProc(glBindRenderbuffer_Impl, glBindRenderbufferEXT);
+      // GLELoadProc(glBlitFramebuffer_Impl, glBlitFramebufferEXT (nonexistent));
+      GLELoadProc(glCheckFramebufferStatus_Impl, glCheckFramebufferStatusEXT);
+      GLELoadProc(glDeleteFramebuffers_Impl, glDeleteFramebuffersEXT);
+      GLELoadProc(glDeleteRenderbuffers_Impl, glDeleteRenderbuffersEXT);
+      GLELoadProc(glFramebufferRenderbuffer_Impl, glFramebufferRenderbufferEXT);
+      GLELoadProc(glFramebufferTexture1D_Impl, glFramebufferTexture1DEXT);
+      GLELoadProc(glFramebufferTexture2D_Impl, glFramebufferTexture2DEXT);
+      GLELoadProc(glFramebufferTexture3D_Impl, glFramebufferTexture3DEXT);
+      // GLELoadProc(glFramebufferTextureLayer_Impl, glFramebufferTextureLayerEXT (nonexistent));
+      GLELoadProc(glGenFramebuffers_Impl, glGenFramebuffersEXT);
+      GLELoadProc(glGenRenderbuffers_Impl, glGenRenderbuffersEXT);
+      GLELoadProc(glGenerateMipmap_Impl, glGenerateMipmapEXT);
+      GLELoadProc(
+          glGetFramebufferAttachmentParameteriv_Impl, glGetFramebufferAttachmentParameterivEXT);
+      GLELoadProc(glGetRenderbufferParameteriv_Impl, glGetRenderbufferParameterivEXT);
+      GLELoadProc(glIsFramebuffer_Impl, glIsFramebufferEXT);
+      GLELoadProc(glIsRenderbuffer_Impl, glIsRenderbufferEXT);
+      GLELoadProc(glRenderbufferStorage_Impl, glRenderbufferStorageEXT);
+      // GLELoadProc(glRenderbufferStorageMultisample_Impl, glRenderbufferStorageMultisampleEXT
+      // (nonexistent));
+    }
+  }
+
+  // GL_ARB_map_buffer_range
+  if (IsExtensionRequested("GL_ARB_map_buffer_range")) {
+    GLELoadProc(glMapBufferRange_Impl, glMapBufferRange);
+    GLELoadProc(glFlushMappedBufferRange_Impl, glFlushMappedBufferRange);
+  }
+
+  // GL_ARB_sync
+  if (IsExtensionRequested("GL_ARB_sync")) {
+    GLELoadProc(glFenceSync_Impl, glFenceSync);
+    GLELoadProc(glDeleteSync_Impl, glDeleteSync);
+    GLELoadProc(glClientWaitSync_Impl, glClientWaitSync);
   }
 
   // GL_ARB_texture_multisample
-  GLELoadProc(glGetMultisamplefv_Impl, glGetMultisamplefv);
-  GLELoadProc(glSampleMaski_Impl, glSampleMaski);
-  GLELoadProc(glTexImage2DMultisample_Impl, glTexImage2DMultisample);
-  GLELoadProc(glTexImage3DMultisample_Impl, glTexImage3DMultisample);
+  if (IsExtensionRequested("GL_ARB_texture_multisample")) {
+    GLELoadProc(glGetMultisamplefv_Impl, glGetMultisamplefv);
+    GLELoadProc(glSampleMaski_Impl, glSampleMaski);
+    GLELoadProc(glTexImage2DMultisample_Impl, glTexImage2DMultisample);
+    GLELoadProc(glTexImage3DMultisample_Impl, glTexImage3DMultisample);
+  }
 
   // GL_ARB_texture_storage
-  GLELoadProc(glTexStorage1D_Impl, glTexStorage1D);
-  GLELoadProc(glTexStorage2D_Impl, glTexStorage2D);
-  GLELoadProc(glTexStorage3D_Impl, glTexStorage3D);
-  GLELoadProc(glTextureStorage1DEXT_Impl, glTextureStorage1DEXT);
-  GLELoadProc(glTextureStorage2DEXT_Impl, glTextureStorage2DEXT);
-  GLELoadProc(glTextureStorage3DEXT_Impl, glTextureStorage3DEXT);
+  if (IsExtensionRequested("GL_ARB_texture_storage")) {
+    GLELoadProc(glTexStorage1D_Impl, glTexStorage1D);
+    GLELoadProc(glTexStorage2D_Impl, glTexStorage2D);
+    GLELoadProc(glTexStorage3D_Impl, glTexStorage3D);
+    GLELoadProc(glTextureStorage1DEXT_Impl, glTextureStorage1DEXT);
+    GLELoadProc(glTextureStorage2DEXT_Impl, glTextureStorage2DEXT);
+    GLELoadProc(glTextureStorage3DEXT_Impl, glTextureStorage3DEXT);
+  }
 
   // GL_ARB_texture_storage_multisample
-  GLELoadProc(glTexStorage2DMultisample_Impl, glTexStorage2DMultisample);
-  GLELoadProc(glTexStorage3DMultisample_Impl, glTexStorage3DMultisample);
-  GLELoadProc(glTextureStorage2DMultisampleEXT_Impl, glTextureStorage2DMultisampleEXT);
-  GLELoadProc(glTextureStorage3DMultisampleEXT_Impl, glTextureStorage3DMultisampleEXT);
+  if (IsExtensionRequested("GL_ARB_texture_storage_multisample")) {
+    GLELoadProc(glTexStorage2DMultisample_Impl, glTexStorage2DMultisample);
+    GLELoadProc(glTexStorage3DMultisample_Impl, glTexStorage3DMultisample);
+    GLELoadProc(glTextureStorage2DMultisampleEXT_Impl, glTextureStorage2DMultisampleEXT);
+    GLELoadProc(glTextureStorage3DMultisampleEXT_Impl, glTextureStorage3DMultisampleEXT);
+  }
 
   // GL_ARB_timer_query
-  GLELoadProc(glGetQueryObjecti64v_Impl, glGetQueryObjecti64v);
-  GLELoadProc(glGetQueryObjectui64v_Impl, glGetQueryObjectui64v);
-  GLELoadProc(glQueryCounter_Impl, glQueryCounter);
+  if (IsExtensionRequested("GL_ARB_timer_query")) {
+    GLELoadProc(glGetQueryObjecti64v_Impl, glGetQueryObjecti64v);
+    GLELoadProc(glGetQueryObjectui64v_Impl, glGetQueryObjectui64v);
+    GLELoadProc(glQueryCounter_Impl, glQueryCounter);
+  }
 
   // GL_ARB_vertex_array_object
-  GLELoadProc(glBindVertexArray_Impl, glBindVertexArray);
-  GLELoadProc(glDeleteVertexArrays_Impl, glDeleteVertexArrays);
-  GLELoadProc(glGenVertexArrays_Impl, glGenVertexArrays);
-  GLELoadProc(glIsVertexArray_Impl, glIsVertexArray);
+  if (IsExtensionRequested("GL_ARB_vertex_array_object")) {
+    GLELoadProc(glBindVertexArray_Impl, glBindVertexArray);
+    GLELoadProc(glDeleteVertexArrays_Impl, glDeleteVertexArrays);
+    GLELoadProc(glGenVertexArrays_Impl, glGenVertexArrays);
+    GLELoadProc(glIsVertexArray_Impl, glIsVertexArray);
+  }
 
 #if defined(GLE_CGL_ENABLED) // Apple OpenGL...
   if (WholeVersion < 302) // It turns out that Apple OpenGL versions prior to 3.2 have
@@ -729,27 +874,33 @@ void OVR::GLEContext::InitExtensionLoad() {
 #endif
 
   // GL_EXT_draw_buffers2
-  GLELoadProc(glColorMaskIndexedEXT_Impl, glColorMaskIndexedEXT);
-  GLELoadProc(glDisableIndexedEXT_Impl, glDisableIndexedEXT);
-  GLELoadProc(glEnableIndexedEXT_Impl, glEnableIndexedEXT);
-  GLELoadProc(glGetBooleanIndexedvEXT_Impl, glGetBooleanIndexedvEXT);
-  GLELoadProc(glGetIntegerIndexedvEXT_Impl, glGetIntegerIndexedvEXT);
-  GLELoadProc(glIsEnabledIndexedEXT_Impl, glIsEnabledIndexedEXT);
+  if (IsExtensionRequested("GL_EXT_draw_buffers2")) {
+    GLELoadProc(glColorMaskIndexedEXT_Impl, glColorMaskIndexedEXT);
+    GLELoadProc(glDisableIndexedEXT_Impl, glDisableIndexedEXT);
+    GLELoadProc(glEnableIndexedEXT_Impl, glEnableIndexedEXT);
+    GLELoadProc(glGetBooleanIndexedvEXT_Impl, glGetBooleanIndexedvEXT);
+    GLELoadProc(glGetIntegerIndexedvEXT_Impl, glGetIntegerIndexedvEXT);
+    GLELoadProc(glIsEnabledIndexedEXT_Impl, glIsEnabledIndexedEXT);
+  }
 
   // GL_KHR_debug
-  GLELoadProc(glDebugMessageCallback_Impl, glDebugMessageCallback);
-  GLELoadProc(glDebugMessageControl_Impl, glDebugMessageControl);
-  GLELoadProc(glDebugMessageInsert_Impl, glDebugMessageInsert);
-  GLELoadProc(glGetDebugMessageLog_Impl, glGetDebugMessageLog);
-  GLELoadProc(glGetObjectLabel_Impl, glGetObjectLabel);
-  GLELoadProc(glGetObjectPtrLabel_Impl, glGetObjectPtrLabel);
-  GLELoadProc(glObjectLabel_Impl, glObjectLabel);
-  GLELoadProc(glObjectPtrLabel_Impl, glObjectPtrLabel);
-  GLELoadProc(glPopDebugGroup_Impl, glPopDebugGroup);
-  GLELoadProc(glPushDebugGroup_Impl, glPushDebugGroup);
+  if (IsExtensionRequested("GL_KHR_debug")) {
+    GLELoadProc(glDebugMessageCallback_Impl, glDebugMessageCallback);
+    GLELoadProc(glDebugMessageControl_Impl, glDebugMessageControl);
+    GLELoadProc(glDebugMessageInsert_Impl, glDebugMessageInsert);
+    GLELoadProc(glGetDebugMessageLog_Impl, glGetDebugMessageLog);
+    GLELoadProc(glGetObjectLabel_Impl, glGetObjectLabel);
+    GLELoadProc(glGetObjectPtrLabel_Impl, glGetObjectPtrLabel);
+    GLELoadProc(glObjectLabel_Impl, glObjectLabel);
+    GLELoadProc(glObjectPtrLabel_Impl, glObjectPtrLabel);
+    GLELoadProc(glPopDebugGroup_Impl, glPopDebugGroup);
+    GLELoadProc(glPushDebugGroup_Impl, glPushDebugGroup);
+  }
 
   // GL_WIN_swap_hint
-  GLELoadProc(glAddSwapHintRectWIN_Impl, glAddSwapHintRectWIN);
+  if (IsExtensionRequested("GL_WIN_swap_hint")) {
+    GLELoadProc(glAddSwapHintRectWIN_Impl, glAddSwapHintRectWIN);
+  }
 }
 
 OVR_DISABLE_MSVC_WARNING(4510 4512 4610) // default constructor could not be generated,
@@ -822,6 +973,7 @@ void OVR::GLEContext::InitExtensionSupport() {
     {gle_APPLE_vertex_program_evaluators, "GL_APPLE_vertex_program_evaluators"},
     {gle_APPLE_ycbcr_422, "GL_APPLE_ycbcr_422"},
 #endif
+    {gle_ARB_buffer_storage, "GL_ARB_buffer_storage"},
     {gle_ARB_copy_buffer, "GL_ARB_copy_buffer"},
     {gle_ARB_debug_output, "GL_ARB_debug_output"},
     {gle_ARB_depth_buffer_float, "GL_ARB_depth_buffer_float"},
@@ -831,6 +983,8 @@ void OVR::GLEContext::InitExtensionSupport() {
     // glBindFramebufferEXT, etc. if
     // necessary
     {gle_ARB_framebuffer_sRGB, "GL_ARB_framebuffer_sRGB"},
+    {gle_ARB_map_buffer_range, "GL_ARB_map_buffer_range"},
+    {gle_ARB_sync, "GL_ARB_sync"},
     {gle_ARB_texture_multisample, "GL_ARB_texture_multisample"},
     {gle_ARB_texture_non_power_of_two, "GL_ARB_texture_non_power_of_two"},
     {gle_ARB_texture_rectangle, "GL_ARB_texture_rectangle"},
@@ -922,6 +1076,30 @@ void OVR::GLEContext::InitExtensionSupport() {
   }
 #endif
 
+  // These are core in OpenGL 3.0, 3.2 and 4.4, and some drivers don't list them as extensions.
+  if (WholeVersion >= 300)
+    gle_ARB_map_buffer_range = true;
+  if (WholeVersion >= 302)
+    gle_ARB_sync = true;
+  if (WholeVersion >= 404)
+    gle_ARB_buffer_storage = true;
+
+  // InitExtensionLoad didn't load the functions of extensions that weren't requested, so we don't
+  // report those as present. An extension is kept if it or any name mapped to it was requested.
+  if (RequestedExtensions) {
+    for (size_t i = 0; i < OVR_ARRAY_COUNT(vspArray); i++) {
+      bool requested = false;
+
+      for (size_t j = 0; (j < OVR_ARRAY_COUNT(vspArray)) && !requested; j++) {
+        if (&vspArray[j].IsPresent == &vspArray[i].IsPresent)
+          requested = IsExtensionRequested(vspArray[j].ExtensionName);
+      }
+
+      if (!requested)
+        vspArray[i].IsPresent = false;
+    }
+  }
+
 } // GLEContext::InitExtensionSupport()
 
 void OVR::GLEContext::InitPlatformVersion() {
@@ -7197,6 +7375,17 @@ void OVR::GLEContext::glMapVertexAttrib2fAPPLE_Hook(
 }
 #endif // GLE_CGL_ENABLED
 
+// GL_ARB_buffer_storage
+void OVR::GLEContext::glBufferStorage_Hook(
+    GLenum target,
+    GLsizeiptr size,
+    const void* data,
+    GLbitfield flags) {
+  if (glBufferStorage_Impl)
+    glBufferStorage_Impl(target, size, data, flags);
+  PostHook(GLE_CURRENT_FUNCTION);
+}
+
 // GL_ARB_copy_buffer
 void OVR::GLEContext::glCopyBufferSubData_Hook(
     GLenum readtarget,
@@ -7477,6 +7666,51 @@ void OVR::GLEContext::glFramebufferTextureLayer_Hook(
   PostHook(GLE_CURRENT_FUNCTION);
 }
 
+// GL_ARB_map_buffer_range
+void* OVR::GLEContext::glMapBufferRange_Hook(
+    GLenum target,
+    GLintptr offset,
+    GLsizeiptr length,
+    GLbitfield access) {
+  void* p = NULL;
+  if (glMapBufferRange_Impl)
+    p = glMapBufferRange_Impl(target, offset, length, access);
+  PostHook(GLE_CURRENT_FUNCTION);
+  return p;
+}
+
+void OVR::GLEContext::glFlushMappedBufferRange_Hook(
+    GLenum target,
+    GLintptr offset,
+    GLsizeiptr length) {
+  if (glFlushMappedBufferRange_Impl)
+    glFlushMappedBufferRange_Impl(target, offset, length);
+  PostHook(GLE_CURRENT_FUNCTION);
+}
+
+// GL_ARB_sync
+GLsync OVR::GLEContext::glFenceSync_Hook(GLenum condition, GLbitfield flags) {
+  GLsync s = NULL;
+  if (glFenceSync_Impl)
+    s = glFenceSync_Impl(condition, flags);
+  PostHook(GLE_CURRENT_FUNCTION);
+  return s;
+}
+
+void OVR::GLEContext::glDeleteSync_Hook(GLsync sync) {
+  if (glDeleteSync_Impl)
+    glDeleteSync_Impl(sync);
+  PostHook(GLE_CURRENT_FUNCTION);
+}
+
+GLenum OVR::GLEContext::glClientWaitSync_Hook(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+  GLenum e = GL_WAIT_FAILED;
+  if (glClientWaitSync_Impl)
+    e = glClientWaitSync_Impl(sync, flags, timeout);
+  PostHook(GLE_CURRENT_FUNCTION);
+  return e;
+}
+
 // GL_ARB_texture_multisample
 void OVR::GLEContext::glTexImage2DMultisample_Hook(
     GLenum target,
@@ -179,10 +179,23 @@ GLE_CLASS_EXPORT class GLEContext {
   bool IsPlatformInitialized() const;
 
   // Loads all the extensions from the current OpenGL context. This must be called after an OpenGL
-  // context has been created and made current.
+  // context has been created and made current. If an earlier context with the same driver (and on
+  // Windows the same pixel format) was initialized with the same requested extensions, its
+  // function table is copied rather than looked up again.
   void Init();
   bool IsInitialized() const;
 
+  // Limits Init to loading and reporting the given extensions (by their GL_ARB_... style names, as
+  // in the gle_ members below), plus the core OpenGL version functions. Extensions that have been
+  // promoted to core are still loaded only if listed. The array is NULL-terminated and must
+  // outlive this GLEContext. NULL, the default, loads every extension GLE knows. WGL and GLX
+  // extensions are always loaded.
+  void SetRequestedExtensions(const char* const* extensions);
+  bool IsExtensionRequested(const char* extension) const;
+
+  // Forgets the function table Init caches, e.g. after the OpenGL driver has been unloaded.
+  static void ClearCache();
+
   // Clears all the extensions initialized by PlatformInit and Init.
   void Shutdown();
 
@@ -213,6 +226,8 @@ GLE_CLASS_EXPORT class GLEContext {
   int PlatformMinorVersion;
   int PlatformWholeVersion;
 
+  const char* const* RequestedExtensions; // See SetRequestedExtensions. NULL means all.
+
   void InitVersion(); // Initializes the version information (e.g. MajorVersion). Called by the
   // public Init function.
   void InitExtensionLoad(); // Loads the function addresses into the function pointers.
@@ -1349,6 +1364,9 @@ GLE_CLASS_EXPORT class GLEContext {
       const GLfloat* points);
 #endif // GLE_CGL_ENABLED
 
+  // GL_ARB_buffer_storage
+  void glBufferStorage_Hook(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
   // GL_ARB_copy_buffer
   void glCopyBufferSubData_Hook(
       GLenum readtarget,
@@ -1466,6 +1484,15 @@ GLE_CLASS_EXPORT class GLEContext {
       GLint level,
       GLint layer);
 
+  // GL_ARB_map_buffer_range
+  void* glMapBufferRange_Hook(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+  void glFlushMappedBufferRange_Hook(GLenum target, GLintptr offset, GLsizeiptr length);
+
+  // GL_ARB_sync
+  GLsync glFenceSync_Hook(GLenum condition, GLbitfield flags);
+  void glDeleteSync_Hook(GLsync sync);
+  GLenum glClientWaitSync_Hook(GLsync sync, GLbitfield flags, GLuint64 timeout);
+
   // GL_ARB_texture_multisample
   void glTexImage2DMultisample_Hook(
       GLenum target,
@@ -2344,6 +2371,9 @@ GLE_CLASS_EXPORT class GLEContext {
   PFNGLMAPVERTEXATTRIB2FAPPLEPROC glMapVertexAttrib2fAPPLE_Impl;
 #endif // GLE_CGL_ENABLED
 
+  // GL_ARB_buffer_storage
+  PFNGLBUFFERSTORAGEPROC glBufferStorage_Impl;
+
   // GL_ARB_copy_buffer
   PFNGLCOPYBUFFERSUBDATAPROC glCopyBufferSubData_Impl;
 
@@ -2385,6 +2415,15 @@ GLE_CLASS_EXPORT class GLEContext {
   // GL_ARB_framebuffer_sRGB
   // (no functions)
 
+  // GL_ARB_map_buffer_range
+  PFNGLMAPBUFFERRANGEPROC glMapBufferRange_Impl;
+  PFNGLFLUSHMAPPEDBUFFERRANGEPROC glFlushMappedBufferRange_Impl;
+
+  // GL_ARB_sync
+  PFNGLFENCESYNCPROC glFenceSync_Impl;
+  PFNGLDELETESYNCPROC glDeleteSync_Impl;
+  PFNGLCLIENTWAITSYNCPROC glClientWaitSync_Impl;
+
   // GL_ARB_texture_multisample
   PFNGLGETMULTISAMPLEFVPROC glGetMultisamplefv_Impl;
   PFNGLSAMPLEMASKIPROC glSampleMaski_Impl;
@@ -2668,6 +2707,7 @@ GLE_CLASS_EXPORT class GLEContext {
   bool gle_APPLE_vertex_array_range;
   bool gle_APPLE_vertex_program_evaluators;
   bool gle_APPLE_ycbcr_422;
+  bool gle_ARB_buffer_storage;
   bool gle_ARB_copy_buffer;
   bool gle_ARB_debug_output;
   bool gle_ARB_depth_buffer_float;
@@ -2675,6 +2715,8 @@ GLE_CLASS_EXPORT class GLEContext {
   bool gle_ARB_ES2_compatibility;
   bool gle_ARB_framebuffer_object;
   bool gle_ARB_framebuffer_sRGB;
+  bool gle_ARB_map_buffer_range;
+  bool gle_ARB_sync;
   bool gle_ARB_texture_multisample;
   bool gle_ARB_texture_non_power_of_two;
   bool gle_ARB_texture_rectangle;
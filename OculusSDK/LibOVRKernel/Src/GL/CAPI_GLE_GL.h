@@ -2754,6 +2754,10 @@ typedef void(GLAPIENTRY* PFNGLUNIFORMMATRIX4X3FVPROC)(
 #define GL_RGBA_INTEGER 0x8D99
 #define GL_BGR_INTEGER 0x8D9A
 #define GL_BGRA_INTEGER 0x8D9B
+#define GL_COMPRESSED_RED_RGTC1 0x8DBB
+#define GL_COMPRESSED_SIGNED_RED_RGTC1 0x8DBC
+#define GL_COMPRESSED_RG_RGTC2 0x8DBD
+#define GL_COMPRESSED_SIGNED_RG_RGTC2 0x8DBE
 #define GL_SAMPLER_1D_ARRAY 0x8DC0
 #define GL_SAMPLER_2D_ARRAY 0x8DC1
 #define GL_SAMPLER_1D_ARRAY_SHADOW 0x8DC3
@@ -3597,6 +3601,29 @@ typedef void(GLAPIENTRY* PFNGLMAPVERTEXATTRIB2FAPPLEPROC)(
 
 #endif // GLE_CGL_ENABLED
 
+#ifndef GL_ARB_buffer_storage
+#define GL_ARB_buffer_storage 1
+
+// GL_ARB_buffer_storage is part of the OpenGL 4.4 core profile.
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#define GL_CLIENT_STORAGE_BIT 0x0200
+#define GL_CLIENT_MAPPED_BUFFER_BARRIER_BIT 0x00004000
+#define GL_BUFFER_IMMUTABLE_STORAGE 0x821F
+#define GL_BUFFER_STORAGE_FLAGS 0x8220
+
+typedef void(GLAPIENTRY* PFNGLBUFFERSTORAGEPROC)(
+    GLenum target,
+    GLsizeiptr size,
+    const void* data,
+    GLbitfield flags);
+
+#define glBufferStorage GLEGetCurrentFunction(glBufferStorage)
+
+#define GLE_ARB_buffer_storage GLEGetCurrentVariable(gle_ARB_buffer_storage)
+#endif
+
 #ifndef GL_ARB_copy_buffer
 #define GL_ARB_copy_buffer 1
 
@@ -4214,6 +4241,62 @@ typedef void(GLAPIENTRY* PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC)(
 #define GLE_ARB_framebuffer_sRGB GLEGetCurrentVariable(gle_ARB_framebuffer_sRGB)
 #endif
 
+#ifndef GL_ARB_map_buffer_range
+#define GL_ARB_map_buffer_range 1
+
+// GL_ARB_map_buffer_range is part of the OpenGL 3.0 core profile.
+#define GL_MAP_READ_BIT 0x0001
+#define GL_MAP_WRITE_BIT 0x0002
+#define GL_MAP_INVALIDATE_RANGE_BIT 0x0004
+#define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+#define GL_MAP_FLUSH_EXPLICIT_BIT 0x0010
+#define GL_MAP_UNSYNCHRONIZED_BIT 0x0020
+
+typedef void*(GLAPIENTRY* PFNGLMAPBUFFERRANGEPROC)(
+    GLenum target,
+    GLintptr offset,
+    GLsizeiptr length,
+    GLbitfield access);
+typedef void(
+    GLAPIENTRY* PFNGLFLUSHMAPPEDBUFFERRANGEPROC)(GLenum target, GLintptr offset, GLsizeiptr length);
+
+#define glMapBufferRange GLEGetCurrentFunction(glMapBufferRange)
+#define glFlushMappedBufferRange GLEGetCurrentFunction(glFlushMappedBufferRange)
+
+#define GLE_ARB_map_buffer_range GLEGetCurrentVariable(gle_ARB_map_buffer_range)
+#endif
+
+#ifndef GL_ARB_sync
+#define GL_ARB_sync 1
+
+// GL_ARB_sync is part of the OpenGL 3.2 core profile.
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#define GL_MAX_SERVER_WAIT_TIMEOUT 0x9111
+#define GL_OBJECT_TYPE 0x9112
+#define GL_SYNC_CONDITION 0x9113
+#define GL_SYNC_STATUS 0x9114
+#define GL_SYNC_FLAGS 0x9115
+#define GL_SYNC_FENCE 0x9116
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#define GL_UNSIGNALED 0x9118
+#define GL_SIGNALED 0x9119
+#define GL_ALREADY_SIGNALED 0x911A
+#define GL_TIMEOUT_EXPIRED 0x911B
+#define GL_CONDITION_SATISFIED 0x911C
+#define GL_WAIT_FAILED 0x911D
+#define GL_TIMEOUT_IGNORED 0xFFFFFFFFFFFFFFFFull
+
+typedef GLsync(GLAPIENTRY* PFNGLFENCESYNCPROC)(GLenum condition, GLbitfield flags);
+typedef void(GLAPIENTRY* PFNGLDELETESYNCPROC)(GLsync sync);
+typedef GLenum(GLAPIENTRY* PFNGLCLIENTWAITSYNCPROC)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+
+#define glFenceSync GLEGetCurrentFunction(glFenceSync)
+#define glDeleteSync GLEGetCurrentFunction(glDeleteSync)
+#define glClientWaitSync GLEGetCurrentFunction(glClientWaitSync)
+
+#define GLE_ARB_sync GLEGetCurrentVariable(gle_ARB_sync)
+#endif
+
 #ifndef GL_ARB_texture_multisample
 #define GL_ARB_texture_multisample 1
 
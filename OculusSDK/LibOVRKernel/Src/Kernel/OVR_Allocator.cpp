@@ -29,12 +29,16 @@ limitations under the License.
 #include "OVR_Alg.h"
 #include "OVR_Std.h"
 #include "Util/Util_SystemInfo.h"
+#include <Logging/Logging_Library.h>
+#include <stddef.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
 #include <exception>
 #include <algorithm>
 #include <sstream>
 #include <memory>
+#include <thread>
 
 #if defined(_MSC_VER)
 #include <crtdbg.h>
@@ -109,6 +113,48 @@ OVR_DISABLE_MSVC_WARNING(4351) // elements of array will be default initialized
 #endif
 #endif
 
+//-----------------------------------------------------------------------------------
+// ***** OVR_ALLOCATOR_POOL_HEAP_ENABLED
+//
+// Defined as 0 or 1.
+// If enabled then we use our PoolHeap instead of a regular heap by default.
+// However, even if this is disabled it can still be enabled at runtime by manually
+// setting the appropriate registry key:
+// HKEY_LOCAL_MACHINE\SOFTWARE\Oculus\PoolHeapEnabled
+// The debug page heap takes precedence over this if both are enabled.
+//
+#ifndef OVR_ALLOCATOR_POOL_HEAP_ENABLED
+#define OVR_ALLOCATOR_POOL_HEAP_ENABLED 0
+#endif
+
+//-----------------------------------------------------------------------------------
+// ***** OVR_ALLOCATOR_LARGE_PAGE_HEAP_ENABLED
+//
+// Defined as 0 or 1.
+// If enabled then we use our LargePageHeap instead of a regular heap by default.
+// However, even if this is disabled it can still be enabled at runtime by manually
+// setting the appropriate registry key:
+// HKEY_LOCAL_MACHINE\SOFTWARE\Oculus\LargePageHeapEnabled
+// The debug page heap and pool heap take precedence over this if also enabled.
+//
+#ifndef OVR_ALLOCATOR_LARGE_PAGE_HEAP_ENABLED
+#define OVR_ALLOCATOR_LARGE_PAGE_HEAP_ENABLED 0
+#endif
+
+//-----------------------------------------------------------------------------------
+// ***** OVR_ALLOCATOR_NUMA_HEAP_ENABLED
+//
+// Defined as 0 or 1.
+// If enabled then we use our NumaHeap instead of a regular heap by default.
+// However, even if this is disabled it can still be enabled at runtime by manually
+// setting the appropriate registry key:
+// HKEY_LOCAL_MACHINE\SOFTWARE\Oculus\NumaHeapEnabled
+// The debug page heap, pool heap and large page heap take precedence over this if also enabled.
+//
+#ifndef OVR_ALLOCATOR_NUMA_HEAP_ENABLED
+#define OVR_ALLOCATOR_NUMA_HEAP_ENABLED 0
+#endif
+
 //-----------------------------------------------------------------------------------
 // ***** OVR_ALLOCATOR_TRACKING_ENABLED
 //
@@ -524,6 +570,103 @@ void SysMemFree(void* p, size_t /*n*/) {
 #endif
 }
 
+//-----------------------------------------------------------------------------------
+// ***** AllocBacktraceTable
+//
+
+AllocBacktraceTable::AllocBacktraceTable()
+    : TableLock(), Buckets(nullptr), BucketCount(0), Count(0) {}
+
+AllocBacktraceTable::~AllocBacktraceTable() {
+  Clear();
+}
+
+const AllocBacktrace* AllocBacktraceTable::Intern(void* const* frames, size_t frameCount) {
+  if (frameCount == 0)
+    return nullptr;
+
+  uint64_t hash = UINT64_C(14695981039346656037); // FNV-1a
+  for (size_t i = 0; i < frameCount; ++i) {
+    hash ^= (uint64_t)(uintptr_t)frames[i];
+    hash *= UINT64_C(1099511628211);
+  }
+
+  Lock::Locker locker(&TableLock);
+
+  if (Count >= BucketCount) {
+    Grow();
+    if (!BucketCount)
+      return nullptr;
+  }
+
+  AllocBacktrace*& bucket = Buckets[hash & (BucketCount - 1)];
+
+  for (AllocBacktrace* entry = bucket; entry; entry = entry->Next) {
+    if ((entry->Hash == hash) && (entry->FrameCount == frameCount) &&
+        (memcmp(entry->Frames, frames, frameCount * sizeof(void*)) == 0))
+      return entry;
+  }
+
+  const size_t entrySize = offsetof(AllocBacktrace, Frames) + (frameCount * sizeof(void*));
+  AllocBacktrace* entry = (AllocBacktrace*)SysMemAlloc(entrySize);
+  if (!entry)
+    return nullptr;
+
+  entry->Next = bucket;
+  entry->Hash = hash;
+  entry->FrameCount = frameCount;
+  memcpy(entry->Frames, frames, frameCount * sizeof(void*));
+  bucket = entry;
+  Count++;
+
+  return entry;
+}
+
+size_t AllocBacktraceTable::GetCount() {
+  Lock::Locker locker(&TableLock);
+  return Count;
+}
+
+void AllocBacktraceTable::Clear() {
+  Lock::Locker locker(&TableLock);
+
+  for (size_t i = 0; i < BucketCount; ++i) {
+    while (Buckets[i]) {
+      AllocBacktrace* entry = Buckets[i];
+      Buckets[i] = entry->Next;
+      SysMemFree(entry, offsetof(AllocBacktrace, Frames) + (entry->FrameCount * sizeof(void*)));
+    }
+  }
+
+  SysMemFree(Buckets, BucketCount * sizeof(AllocBacktrace*));
+  Buckets = nullptr;
+  BucketCount = 0;
+  Count = 0;
+}
+
+void AllocBacktraceTable::Grow() {
+  const size_t newBucketCount = BucketCount ? (BucketCount * 2) : 4096;
+  AllocBacktrace** newBuckets =
+      (AllocBacktrace**)SysMemAlloc(newBucketCount * sizeof(AllocBacktrace*));
+  if (!newBuckets)
+    return; // Keep the current buckets, which just makes chains longer.
+
+  memset(newBuckets, 0, newBucketCount * sizeof(AllocBacktrace*));
+
+  for (size_t i = 0; i < BucketCount; ++i) {
+    while (Buckets[i]) {
+      AllocBacktrace* entry = Buckets[i];
+      Buckets[i] = entry->Next;
+      entry->Next = newBuckets[entry->Hash & (newBucketCount - 1)];
+      newBuckets[entry->Hash & (newBucketCount - 1)] = entry;
+    }
+  }
+
+  SysMemFree(Buckets, BucketCount * sizeof(AllocBacktrace*));
+  Buckets = newBuckets;
+  BucketCount = newBucketCount;
+}
+
 // To consider: Move Symbols to the Allocator class member data. The problem with that
 // is that it exposes the debug interface from header file, which can be done but we
 // would rather not if possible.
@@ -1167,6 +1310,88 @@ __declspec(dllexport)
 #endif
     AllocatorAutoCreate allocatorAutoCreate;
 
+//------------------------------------------------------------------------
+// ***** Allocator sampling
+//
+// Each thread that allocates while sampling is enabled gets an AllocSampleBuffer, which is a
+// single-producer ring of events. The producer is the thread itself and it never takes a lock
+// to record an event. The consumer is whichever thread holds SampleLock and calls
+// DrainSampleBuffers, which happens upon heap iteration or when a ring fills up.
+//
+// Events carry a global sequence number, so that an allocation recorded by one thread and freed by
+// another are applied in the order they occurred, even though they are in different rings.
+//
+// The buffers are owned by the Allocator they are registered with, but they also need to outlive
+// that Allocator if the thread does. SampleRegistryLock guards the ownership hand-off between
+// the two, and is a spin lock because it must be usable before static initialization has run.
+
+struct AllocSampleEvent {
+  static const size_t MaxFrames = 24;
+
+  uint64_t Sequence; // Order of this event relative to all others.
+  const void* Alloc;
+  uint64_t Size; // Size of the allocation.
+  uint64_t Weight; // Estimated bytes the sample represents. 0 for free events.
+  const char* Tag;
+  const char* File;
+  int Line;
+  uint64_t TimeNs;
+  AllocatorThreadId ThreadId;
+  char ThreadName[32];
+  size_t FrameCount;
+  void* Frames[MaxFrames];
+};
+
+struct AllocSampleBuffer {
+  static const uint32_t Capacity = 64; // Power of two.
+
+  std::atomic<Allocator*> Owner; // nullptr if the owner shut down while this thread was alive.
+  AllocSampleBuffer* Next; // Link within Owner->SampleBufferList.
+  bool Orphaned; // True if the thread has exited and Owner is to free this after draining it.
+  std::atomic<uint32_t> Head; // Written only by the producer thread.
+  std::atomic<uint32_t> Tail; // Written only by the consumer.
+  AllocSampleEvent Events[Capacity];
+};
+
+static std::atomic_flag SampleRegistryLock = ATOMIC_FLAG_INIT;
+static std::atomic<uint64_t> SampleSequence(0);
+
+// Scoped lock for an atomic_flag, for the registries below which are accessed by threads that are
+// starting up, exiting, or running static initializers.
+struct SpinLocker {
+  explicit SpinLocker(std::atomic_flag& flag) : Flag(flag) {
+    while (Flag.test_and_set(std::memory_order_acquire))
+      std::this_thread::yield();
+  }
+  ~SpinLocker() {
+    Flag.clear(std::memory_order_release);
+  }
+  std::atomic_flag& Flag;
+};
+
+struct AllocSampleThreadSlot {
+  AllocSampleBuffer* Buffer;
+  int64_t BytesUntilSample; // Counts down with each allocation. A sample is taken upon <= 0.
+  uint64_t RandomState; // xorshift64 state. 0 until first use.
+  bool Retired; // True once this thread's slot has been destructed.
+
+  ~AllocSampleThreadSlot() {
+    if (Buffer) {
+      SpinLocker registryLocker(SampleRegistryLock);
+
+      if (Buffer->Owner.load(std::memory_order_relaxed))
+        Buffer->Orphaned = true; // The owner will free it once it's drained.
+      else
+        SysMemFree(Buffer, sizeof(AllocSampleBuffer));
+    }
+
+    Buffer = nullptr;
+    Retired = true;
+  }
+};
+
+static thread_local AllocSampleThreadSlot SampleSlot = {nullptr, 0, 0, false};
+
 //-----------------------------------------------------------------------------------
 // ***** Allocator
 //
@@ -1230,6 +1455,9 @@ Allocator::Allocator(const char* allocatorName)
       Heap(nullptr),
       DebugPageHeapEnabled(false),
       OSHeapEnabled(false),
+      PoolHeapEnabled(false),
+      LargePageHeapEnabled(false),
+      NumaHeapEnabled(false),
       MallocRedirectEnabled(false),
       MallocRedirect(nullptr),
       TrackingEnabled(false),
@@ -1241,10 +1469,27 @@ Allocator::Allocator(const char* allocatorName)
       DelayedAlignedFreeList(),
       CurrentCounter(),
       SymbolLookupEnabled(false),
-      TagMap(),
-      TagMapLock() {
+      SamplingEnabled(false),
+      SampleIntervalBytes(DefaultSampleIntervalBytes),
+      SampleBufferList(nullptr),
+      SampleLock(),
+      SampledAllocs(),
+      SampledSites(),
+      SampleIterator(),
+      IteratingSamples(false) {
   SetAllocatorName(allocatorName);
 
+  for (size_t i = 0; i < SampleFilterSize; ++i)
+    SampleFilter[i].store(0, std::memory_order_relaxed);
+
+  TotalStats.Clear();
+  for (size_t i = 0; i < AllocatorStats::MaxTagCount; ++i) {
+    TagStats[i].Clear();
+    TagStatsNames[i].store(nullptr, std::memory_order_relaxed);
+  }
+  for (size_t i = 0; i < AllocatorStats::SizeClassCount; ++i)
+    SizeClassStats[i].Clear();
+
   if (ReferenceHeapTimeNs == 0) // There is a thread race condition for the case that on startup two
     // threads somehow execute this line at the same time.
     ReferenceHeapTimeNs = GetCurrentHeapTimeNs();
@@ -1266,6 +1511,12 @@ Allocator::~Allocator() {
 bool Allocator::Init() {
   if (!Heap) // If not already initialized...
   {
+#if OVR_ALLOCATOR_MINIMAL
+    // The inline Alloc and Free functions can't tell our pointers from the CRT's, and they don't
+    // support the debug page heap's tracking requirement.
+    MallocRedirectEnabled = false;
+    DebugPageHeapEnabled = false;
+#else
     // Potentially redirect the CRT malloc family of functions.
     if (!MallocRedirectEnabled) // If not programmatically enabled before this init call...
     {
@@ -1364,6 +1615,43 @@ bool Allocator::Init() {
             true); // If we can successfully kill _CrtIsValidHeapPointer, enable our debug heap.
       }
 #endif
+#endif
+    }
+#endif // OVR_ALLOCATOR_MINIMAL
+
+    // Potentially enable the pool heap.
+    if (!PoolHeapEnabled) // If not programmatically enabled before this init call...
+    {
+#if OVR_ALLOCATOR_POOL_HEAP_ENABLED
+      PoolHeapEnabled = true;
+#elif defined(_MSC_VER)
+      // "HKEY_LOCAL_MACHINE\SOFTWARE\Oculus\PoolHeapEnabled"
+      PoolHeapEnabled =
+          OVR::Util::GetRegistryBoolW(L"Software\\Oculus", L"PoolHeapEnabled", PoolHeapEnabled);
+#endif
+    }
+
+    // Potentially enable the large page heap.
+    if (!LargePageHeapEnabled) // If not programmatically enabled before this init call...
+    {
+#if OVR_ALLOCATOR_LARGE_PAGE_HEAP_ENABLED
+      LargePageHeapEnabled = true;
+#elif defined(_MSC_VER)
+      // "HKEY_LOCAL_MACHINE\SOFTWARE\Oculus\LargePageHeapEnabled"
+      LargePageHeapEnabled = OVR::Util::GetRegistryBoolW(
+          L"Software\\Oculus", L"LargePageHeapEnabled", LargePageHeapEnabled);
+#endif
+    }
+
+    // Potentially enable the NUMA heap.
+    if (!NumaHeapEnabled) // If not programmatically enabled before this init call...
+    {
+#if OVR_ALLOCATOR_NUMA_HEAP_ENABLED
+      NumaHeapEnabled = true;
+#elif defined(_MSC_VER)
+      // "HKEY_LOCAL_MACHINE\SOFTWARE\Oculus\NumaHeapEnabled"
+      NumaHeapEnabled =
+          OVR::Util::GetRegistryBoolW(L"Software\\Oculus", L"NumaHeapEnabled", NumaHeapEnabled);
 #endif
     }
 
@@ -1371,9 +1659,47 @@ bool Allocator::Init() {
       // We will need to enable tracking so that we can distinguish between our pointers and
       // pointers allocated via malloc before we did this redirect.
       TrackingEnabled = true;
+      PoolHeapEnabled = false; // The debug page heap takes precedence.
+      LargePageHeapEnabled = false;
+      NumaHeapEnabled = false;
 
       Heap = new (SysMemAlloc(sizeof(DebugPageHeap))) DebugPageHeap;
       Heap->Init();
+    } else if (PoolHeapEnabled) {
+      if (MallocRedirectEnabled) {
+        // We will need to enable tracking so that we can distinguish between our pointers and
+        // pointers allocated via malloc before we did this redirect.
+        TrackingEnabled = true;
+      }
+
+      LargePageHeapEnabled = false; // The pool heap takes precedence.
+      NumaHeapEnabled = false;
+
+      // PoolHeap gets its memory from SysMemAlloc, so it's safe to use with the malloc redirect.
+      Heap = new (SysMemAlloc(sizeof(PoolHeap))) PoolHeap;
+      Heap->Init();
+    } else if (LargePageHeapEnabled) {
+      if (MallocRedirectEnabled) {
+        // We will need to enable tracking so that we can distinguish between our pointers and
+        // pointers allocated via malloc before we did this redirect.
+        TrackingEnabled = true;
+      }
+
+      NumaHeapEnabled = false; // The large page heap takes precedence.
+
+      // LargePageHeap is an OSHeap, so it's safe to use with the malloc redirect.
+      Heap = new (SysMemAlloc(sizeof(LargePageHeap))) LargePageHeap;
+      Heap->Init();
+    } else if (NumaHeapEnabled) {
+      if (MallocRedirectEnabled) {
+        // We will need to enable tracking so that we can distinguish between our pointers and
+        // pointers allocated via malloc before we did this redirect.
+        TrackingEnabled = true;
+      }
+
+      // NumaHeap uses OS heaps with Windows, so it's safe to use with the malloc redirect.
+      Heap = new (SysMemAlloc(sizeof(NumaHeap))) NumaHeap;
+      Heap->Init();
     } else if (MallocRedirectEnabled) {
       // We will need to enable tracking so that we can distinguish between our pointers and
       // pointers allocated via malloc before we did this redirect.
@@ -1390,6 +1716,10 @@ bool Allocator::Init() {
       Heap->Init();
     }
 
+#if OVR_ALLOCATOR_MINIMAL
+    TrackingEnabled = false; // The inline Alloc and Free functions do neither.
+    SamplingEnabled = false;
+#else
     // Potentially enable allocation tracking.
     if (!TrackingEnabled) // If not programmatically enabled before this init call...
     {
@@ -1400,6 +1730,11 @@ bool Allocator::Init() {
 #endif
     }
 
+    // Potentially enable allocation sampling.
+    if (!SamplingEnabled) // If not programmatically enabled before this init call...
+      SamplingEnabled = IsHeapSamplingRegKeyEnabled(SamplingEnabled);
+#endif
+
     // Initialize the symbol and backtrace utility library
     SymbolLookupEnabled = SymbolLookup::Initialize();
   }
@@ -1434,15 +1769,44 @@ void Allocator::Shutdown() {
     DelayedFreeList.clear();
 
     AllocationMap.clear();
-    TagMap.clear();
     CurrentCounter = 0;
 
+    EnableSampling(false);
+    {
+      // Threads that are still alive keep their buffers, which will be registered anew with
+      // whatever Allocator they next allocate from.
+      SpinLocker registryLocker(SampleRegistryLock);
+
+      while (SampleBufferList) {
+        AllocSampleBuffer* buffer = SampleBufferList;
+        SampleBufferList = buffer->Next;
+
+        if (buffer->Orphaned) {
+          buffer->~AllocSampleBuffer();
+          SysMemFree(buffer, sizeof(AllocSampleBuffer));
+        } else {
+          buffer->Owner.store(nullptr, std::memory_order_release);
+        }
+      }
+    }
+
+    // Nothing refers to the backtraces any more, now that the allocations and samples are gone.
+    Backtraces.Clear();
+
     // Free the heap.
     if (Heap) {
       Heap->Shutdown();
       Heap->~Heap();
       if (DebugPageHeapEnabled)
         SysMemFree(Heap, sizeof(DebugPageHeap));
+      else if (PoolHeapEnabled)
+        SysMemFree(Heap, sizeof(PoolHeap));
+      else if (LargePageHeapEnabled)
+        SysMemFree(Heap, sizeof(LargePageHeap));
+      else if (NumaHeapEnabled)
+        SysMemFree(Heap, sizeof(NumaHeap));
+      else if (OSHeapEnabled)
+        SysMemFree(Heap, sizeof(OSHeap));
       else
         SysMemFree(Heap, sizeof(DefaultHeap));
     }
@@ -1450,14 +1814,17 @@ void Allocator::Shutdown() {
   }
 }
 
+#if !OVR_ALLOCATOR_MINIMAL // Else these are inline forwarders to the Heap.
 void* Allocator::Alloc(size_t size, const char* tag) {
   return AllocDebug(size, tag, nullptr, 0);
 }
+#endif
 
 void* Allocator::Calloc(size_t count, size_t size, const char* tag) {
   return CallocDebug(count, size, tag, nullptr, 0);
 }
 
+#if !OVR_ALLOCATOR_MINIMAL
 void* Allocator::AllocAligned(size_t size, size_t align, const char* tag) {
   return AllocAlignedDebug(size, align, tag, nullptr, 0);
 }
@@ -1469,12 +1836,17 @@ void* Allocator::AllocDebug(size_t size, const char* tag, const char* file, unsi
 
   if (p) {
     TrackAlloc(p, size, tag, file, line);
+    CountAlloc(size, tag);
+
+    if (SamplingEnabled)
+      SampleAlloc(p, size, tag, file, (int)line);
   }
 
   OVR_ALLOC_BENCHMARK_END();
 
   return p;
 }
+#endif // !OVR_ALLOCATOR_MINIMAL
 
 void* Allocator::CallocDebug(
     size_t count,
@@ -1491,6 +1863,7 @@ void* Allocator::CallocDebug(
   return p;
 }
 
+#if !OVR_ALLOCATOR_MINIMAL
 void* Allocator::AllocAlignedDebug(
     size_t size,
     size_t align,
@@ -1503,12 +1876,17 @@ void* Allocator::AllocAlignedDebug(
 
   if (p) {
     TrackAlloc(p, size, tag, file, line);
+    CountAlloc(size, tag);
+
+    if (SamplingEnabled)
+      SampleAlloc(p, size, tag, file, (int)line);
   }
 
   OVR_ALLOC_BENCHMARK_END();
 
   return p;
 }
+#endif // !OVR_ALLOCATOR_MINIMAL
 
 size_t Allocator::GetAllocSize(const void* p) const {
   return Heap->GetAllocSize(p);
@@ -1518,12 +1896,14 @@ size_t Allocator::GetAllocAlignedSize(const void* p, size_t align) const {
   return Heap->GetAllocAlignedSize(p, align);
 }
 
+#if !OVR_ALLOCATOR_MINIMAL
 void Allocator::Free(void* p) {
   OVR_ALLOC_BENCHMARK_START();
 
   if (p) {
     if (UntrackAlloc(p)) // If this pointer is recognized as belonging to us...
     {
+      SampleFree(p);
       Heap->Free(p);
     } else {
       // We don't recognize the pointer being freed. That almost always means one of two things:
@@ -1578,6 +1958,7 @@ void Allocator::FreeAligned(void* p) {
 
   if (p) {
     if (UntrackAlloc(p)) {
+      SampleFree(p);
       Heap->FreeAligned(p);
     } else {
 #if defined(_MSC_VER)
@@ -1612,19 +1993,23 @@ void Allocator::FreeAligned(void* p) {
 void* Allocator::Realloc(void* p, size_t newSize) {
   return ReallocDebug(p, newSize, nullptr, 0);
 }
+#endif // !OVR_ALLOCATOR_MINIMAL
 
 void* Allocator::Recalloc(void* p, size_t count, size_t newSize) {
   return RecallocDebug(p, count, newSize, nullptr, 0);
 }
 
+#if !OVR_ALLOCATOR_MINIMAL
 void* Allocator::ReallocAligned(void* p, size_t newSize, size_t newAlign) {
   return ReallocAlignedDebug(p, newSize, newAlign, nullptr, 0);
 }
+#endif
 
 void* Allocator::RecallocAligned(void* p, size_t count, size_t newSize, size_t newAlign) {
   return RecallocAlignedDebug(p, count, newSize, newAlign, nullptr, 0);
 }
 
+#if !OVR_ALLOCATOR_MINIMAL
 void* Allocator::ReallocDebug(void* p, size_t newSize, const char* file, unsigned line) {
   OVR_ALLOC_BENCHMARK_START();
 
@@ -1643,10 +2028,15 @@ void* Allocator::ReallocDebug(void* p, size_t newSize, const char* file, unsigne
   }
 
   if (valid) {
+    SampleFree(p);
     pNew = Heap->Realloc(p, newSize);
 
     if (pNew) {
       TrackAlloc(pNew, newSize, metadata.Tag, file, line);
+      CountAlloc(newSize, metadata.Tag);
+
+      if (SamplingEnabled)
+        SampleAlloc(pNew, newSize, metadata.Tag, file, (int)line);
     }
   } // Else p came from the CRT heap. It was likely malloc'd before we edirected malloc.
   else if (MallocRedirect) {
@@ -1680,6 +2070,7 @@ void* Allocator::ReallocDebug(void* p, size_t newSize, const char* file, unsigne
 
   return pNew;
 }
+#endif // !OVR_ALLOCATOR_MINIMAL
 
 void* Allocator::RecallocDebug(
     void* p,
@@ -1729,6 +2120,7 @@ void* Allocator::RecallocDebug(
   return pNew;
 }
 
+#if !OVR_ALLOCATOR_MINIMAL
 void* Allocator::ReallocAlignedDebug(
     void* p,
     size_t newSize,
@@ -1747,10 +2139,15 @@ void* Allocator::ReallocAlignedDebug(
   }
 
   if (valid) {
+    SampleFree(p);
     pNew = Heap->ReallocAligned(p, newSize, newAlign);
 
     if (pNew) {
       TrackAlloc(pNew, newSize, metadata.Tag, file, line);
+      CountAlloc(newSize, metadata.Tag);
+
+      if (SamplingEnabled)
+        SampleAlloc(pNew, newSize, metadata.Tag, file, (int)line);
     }
 
     return pNew;
@@ -1780,6 +2177,7 @@ void* Allocator::ReallocAlignedDebug(
 
   return pNew;
 }
+#endif // !OVR_ALLOCATOR_MINIMAL
 
 void* Allocator::RecallocAlignedDebug(
     void* p,
@@ -1856,60 +2254,95 @@ static AllocatorThreadId GetThreadId() {
 #endif
 }
 
-static bool ThreadIdIsValid(AllocatorThreadId threadId) {
-#if defined(_WIN32)
-  bool result = false;
-  HANDLE h = ::OpenThread(THREAD_QUERY_LIMITED_INFORMATION, TRUE, threadId);
+//------------------------------------------------------------------------
+// ***** Allocator tags
+//
+// Each thread's tag stack is a thread_local array, so pushing and popping tags is lock-free and
+// costs a couple of stores. The stacks of all threads are linked into TagStackList, but that is
+// used only for reporting (see Allocator.ReportState) and is touched only upon a thread's first
+// PushTag and upon its exit.
+//
+// ThreadTagStack is trivially constructible, so accessing it doesn't require a thread_local
+// initialization check. ThreadTagStackRegistrar exists only to unlink it upon thread exit.
+
+struct ThreadTagStack {
+  static const uint32_t Capacity = 32;
+
+  struct Entry {
+    const Allocator* Owner; // Tags are per-Allocator, though usually there's just one Allocator.
+    const char* Tag;
+  };
+
+  std::atomic<uint32_t> Depth; // May exceed Capacity, in which case the excess tags are ignored.
+  bool Registered; // True once linked into TagStackList. Stays true after unlinking upon exit.
+  AllocatorThreadId ThreadId;
+  ThreadTagStack* Next; // Link within TagStackList.
+  Entry Entries[Capacity];
+};
+
+static std::atomic_flag TagStackListLock = ATOMIC_FLAG_INIT;
+static ThreadTagStack* TagStackList = nullptr;
+static thread_local ThreadTagStack TagStack;
 
-  if (h) {
-    DWORD exitCode;
-    BOOL bResult = ::GetExitCodeThread(h, &exitCode);
-    result = ((bResult != FALSE) && (exitCode != STILL_ACTIVE));
-    ::CloseHandle(h);
+struct ThreadTagStackRegistrar {
+  void Register() {
+    TagStack.ThreadId = GetThreadId();
+
+    SpinLocker listLocker(TagStackListLock);
+    TagStack.Next = TagStackList;
+    TagStackList = &TagStack;
   }
 
-  return result;
-#else
-  OVR_UNUSED(threadId);
-  return true;
-#endif
-}
+  ~ThreadTagStackRegistrar() {
+    SpinLocker listLocker(TagStackListLock);
+
+    for (ThreadTagStack** link = &TagStackList; *link; link = &(*link)->Next) {
+      if (*link == &TagStack) {
+        *link = TagStack.Next;
+        break;
+      }
+    }
+  }
+};
+
+static thread_local ThreadTagStackRegistrar TagStackRegistrar;
 
 void Allocator::PushTag(const char* tag) {
-  AllocatorThreadId threadId = GetThreadId();
+  ThreadTagStack& stack = TagStack;
+
+  if (!stack.Registered) // If this is the thread's first PushTag...
+  {
+    stack.Registered = true;
+    TagStackRegistrar.Register();
+  }
 
-  Lock::Locker locker(&TagMapLock);
+  uint32_t depth = stack.Depth.load(std::memory_order_relaxed);
 
-  TagMap[threadId].push_back(tag);
+  if (depth < ThreadTagStack::Capacity)
+    stack.Entries[depth] = ThreadTagStack::Entry{this, tag};
 
-  if (TagMap.size() > 128) // This is some number that should be more than the number of unique
-    // threads we ever have.
-    PurgeTagMap();
+  // Release so that reporting threads which see the new depth also see the new entry.
+  stack.Depth.store(depth + 1, std::memory_order_release);
 }
 
 void Allocator::PopTag() {
-  AllocatorThreadId threadId = GetThreadId();
-
-  Lock::Locker locker(&TagMapLock);
+  ThreadTagStack& stack = TagStack;
 
   // We do some error checking to make sure we don't crash if this facility is mis-used.
-  ThreadIdToTagVectorMap::iterator it = TagMap.find(threadId);
+  uint32_t depth = stack.Depth.load(std::memory_order_relaxed);
 
-  if (it != TagMap.end()) {
-    if (!it->second.empty())
-      it->second.pop_back();
-  }
+  if (depth > 0)
+    stack.Depth.store(depth - 1, std::memory_order_release);
 }
 
 const char* Allocator::GetTag(const char* defaultTag) {
-  Lock::Locker locker(&TagMapLock);
+  const ThreadTagStack& stack = TagStack;
 
-  AllocatorThreadId threadId = GetThreadId();
-  ThreadIdToTagVectorMap::const_iterator it = TagMap.find(threadId);
-
-  if (it != TagMap.end()) {
-    if (!it->second.empty())
-      return it->second.back();
+  for (uint32_t i = std::min(stack.Depth.load(std::memory_order_relaxed), ThreadTagStack::Capacity);
+       i > 0;
+       --i) {
+    if (stack.Entries[i - 1].Owner == this)
+      return stack.Entries[i - 1].Tag;
   }
 
   if (defaultTag)
@@ -1918,16 +2351,23 @@ const char* Allocator::GetTag(const char* defaultTag) {
   return OVR_ALLOCATOR_UNSPECIFIED_TAG;
 }
 
-void Allocator::PurgeTagMap() {
-  Lock::Locker locker(&TagMapLock);
+// Appends a line for each thread that currently has a tag pushed with the given allocator.
+// The tags of other threads may change while we read them, but tags are string literals or
+// otherwise long-lived strings, so the worst case is that we report a tag that was just popped.
+static void ReportThreadTags(const Allocator* allocator, std::stringstream& strStream) {
+  SpinLocker listLocker(TagStackListLock);
 
-  for (ThreadIdToTagVectorMap::iterator it = TagMap.begin(); it != TagMap.end();) {
-    AllocatorThreadId threadId = it->first;
+  for (const ThreadTagStack* stack = TagStackList; stack; stack = stack->Next) {
+    const uint32_t depth =
+        std::min(stack->Depth.load(std::memory_order_acquire), ThreadTagStack::Capacity);
 
-    if (!ThreadIdIsValid(threadId))
-      it = TagMap.erase(it);
-    else
-      ++it;
+    for (uint32_t i = depth; i > 0; --i) {
+      if (stack->Entries[i - 1].Owner == allocator) {
+        strStream << "Thread " << stack->ThreadId << " tag: " << stack->Entries[i - 1].Tag
+                  << std::endl;
+        break;
+      }
+    }
   }
 }
 
@@ -1943,7 +2383,7 @@ void Allocator::SetNewBlockMetadata(
     void** backtraceArray,
     size_t backtraceArraySize) {
   amd.Alloc = alloc;
-  amd.Backtrace.assign(backtraceArray, backtraceArray + backtraceArraySize);
+  amd.Backtrace = allocator->Backtraces.Intern(backtraceArray, backtraceArraySize);
   amd.BacktraceSymbols.clear(); // This is only set when needed.
   amd.File = file;
   amd.Line = line;
@@ -1973,15 +2413,10 @@ void Allocator::TrackAlloc(
 
     TrackedAllocMap::value_type value(p, AllocMetadata());
 
-#if defined(_WIN64)
+    // This only captures the return addresses. Identical stacks are then stored once, in
+    // Backtraces.
     void* addressArray[128];
     size_t frameCount = Symbols.GetBacktrace(addressArray, OVR_ARRAY_COUNT(addressArray), 2);
-#else
-    // Currently 32 bit backtrace reading is too slow. We can fix it by writing our own version
-    // that reads the stack frames, but it's not a high priority since we work mostly with 64 bit.
-    void* addressArray[1] = {nullptr};
-    size_t frameCount = 0;
-#endif
 
     if (!tag)
       tag = GetTag();
@@ -2018,6 +2453,7 @@ bool Allocator::UntrackAlloc(const void* p) {
     TrackedAllocMap::iterator it = AllocationMap.find(p);
 
     if (it != AllocationMap.end()) {
+      CountFree(it->second.AllocSize, it->second.Tag);
       AllocationMap.erase(it);
       return true;
     }
@@ -2054,6 +2490,9 @@ bool Allocator::GetAllocMetadata(const void* p, AllocMetadata& metadata) {
 }
 
 bool Allocator::EnableTracking(bool enable) {
+  if (OVR_ALLOCATOR_MINIMAL && enable)
+    return false;
+
   bool result = false;
 
   // We may need to deal with the case that this is called when we
@@ -2077,6 +2516,18 @@ bool Allocator::EnableTracking(bool enable) {
       if (!TrackingEnabled) // If we are disabling tracking...
       {
         AllocationMap.clear(); // Clear all the tracking we've done so far.
+
+        // The frees of the allocations we were tracking will no longer be counted.
+        TotalStats.LiveBytes.store(0, std::memory_order_relaxed);
+        TotalStats.LiveCount.store(0, std::memory_order_relaxed);
+        for (StatCounters& counters : TagStats) {
+          counters.LiveBytes.store(0, std::memory_order_relaxed);
+          counters.LiveCount.store(0, std::memory_order_relaxed);
+        }
+        for (StatCounters& counters : SizeClassStats) {
+          counters.LiveBytes.store(0, std::memory_order_relaxed);
+          counters.LiveCount.store(0, std::memory_order_relaxed);
+        }
       }
 
       result = true;
@@ -2092,7 +2543,7 @@ bool Allocator::EnableTracking(bool enable) {
 bool Allocator::EnableDebugPageHeap(bool enable) {
   bool result = false;
 
-  if (!Heap) // If we haven't initialized yet...
+  if (!Heap && (!OVR_ALLOCATOR_MINIMAL || !enable)) // If we haven't initialized yet...
   {
     DebugPageHeapEnabled = enable;
     result = true;
@@ -2101,10 +2552,46 @@ bool Allocator::EnableDebugPageHeap(bool enable) {
   return result;
 }
 
+bool Allocator::EnablePoolHeap(bool enable) {
+  bool result = false;
+
+  if (!Heap) // If we haven't initialized yet...
+  {
+    PoolHeapEnabled = enable;
+    result = true;
+  }
+
+  return result;
+}
+
+bool Allocator::EnableLargePageHeap(bool enable) {
+  bool result = false;
+
+  if (!Heap) // If we haven't initialized yet...
+  {
+    LargePageHeapEnabled = enable;
+    result = true;
+  }
+
+  return result;
+}
+
+bool Allocator::EnableNumaHeap(bool enable) {
+  bool result = false;
+
+  if (!Heap) // If we haven't initialized yet...
+  {
+    NumaHeapEnabled = enable;
+    result = true;
+  }
+
+  return result;
+}
+
 bool Allocator::EnableMallocRedirect() {
   bool result = false;
 
-  if (!Heap) {
+  if (!Heap && !OVR_ALLOCATOR_MINIMAL) {
     MallocRedirectEnabled = true;
     result = true;
   }
@@ -2123,60 +2610,585 @@ bool Allocator::IsHeapTrackingRegKeyEnabled(bool defaultValue) {
 #endif
 }
 
-const AllocMetadata* Allocator::IterateHeapBegin() {
-  TrackLock.DoLock(); // Will be unlocked in IterateHeapEnd().
-
-  if (TrackingEnabled) {
-    // We have a problem in the case that a single thread calls IterateHeapBegin twice
-    // before calling IterateHeapEnd. It can be resolved the application calling IterateHeapEnd
-    // twice as well, but do we want to support that usage? It's probably easier to just disallow
-    // it.
+static size_t GetSampleFilterIndex(const void* p, size_t filterSize) {
+  // Allocations are at least 8 byte aligned, so the low bits are of no use.
+  return (size_t)((((uint64_t)(uintptr_t)p >> 3) * UINT64_C(0x9E3779B97F4A7C15)) >> 40) &
+      (filterSize - 1);
+}
 
-    if (!AllocationMap.empty()) {
-      TrackIterator = AllocationMap.begin();
-      return &TrackIterator->second;
-    }
-  }
+// Returns the number of bytes until the next sample, drawn from an exponential distribution
+// with the given mean. This makes the sampling a Poisson process over allocated bytes, which
+// gives every byte an equal chance of being sampled regardless of allocation size and pattern.
+static int64_t GetNextSampleInterval(uint64_t& randomState, size_t meanIntervalBytes) {
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 7;
+  randomState ^= randomState << 17;
 
-  return nullptr;
+  // 53 random bits to a double in (0, 1].
+  const double u = ((double)(randomState >> 11) + 1.0) * (1.0 / 9007199254740992.0);
+  return (int64_t)(-log(u) * (double)meanIntervalBytes) + 1;
 }
 
-const AllocMetadata* Allocator::IterateHeapNext() {
-  ++TrackIterator;
+bool Allocator::EnableSampling(bool enable, size_t sampleIntervalBytes) {
+  if (OVR_ALLOCATOR_MINIMAL && enable)
+    return false;
 
-  if (TrackIterator == AllocationMap.end())
-    return nullptr;
+  Lock::Locker locker(&SampleLock);
 
-  return &TrackIterator->second;
+  if (sampleIntervalBytes == 0)
+    sampleIntervalBytes = DefaultSampleIntervalBytes;
+
+  if (!enable && SamplingEnabled) {
+    SamplingEnabled = false;
+    ClearSamples();
+  }
+
+  SampleIntervalBytes = sampleIntervalBytes;
+  SamplingEnabled = enable;
+
+  return true;
 }
 
-void Allocator::IterateHeapEnd() {
-  TrackLock.Unlock();
+bool Allocator::IsHeapSamplingRegKeyEnabled(bool defaultValue) {
+#if defined(_WIN32)
+  // "HKEY_LOCAL_MACHINE\SOFTWARE\Oculus\HeapSamplingEnabled", REG_DWORD of 0 or 1.
+  // This code uses the registry API instead of OVR::Util::SettingsManager, because this code
+  // is allocator code which is special in that it needs to execute before all else is initialized.
+  return OVR::Util::GetRegistryBoolW(L"Software\\Oculus", L"HeapSamplingEnabled", defaultValue);
+#else
+  return defaultValue;
+#endif
 }
 
-size_t Allocator::DescribeAllocation(
-    const AllocMetadata* amd,
-    int amdFlags,
-    char* description,
-    size_t descriptionCapacity,
-    size_t appendedNewlineCount) {
-  SysAllocatedString descriptionString;
-  char buffer[2048];
+void Allocator::SampleAlloc(
+    const void* p,
+    size_t size,
+    const char* tag,
+    const char* file,
+    int line) {
+  AllocSampleThreadSlot& slot = SampleSlot;
 
-  if (amdFlags & AMFAlloc) {
-    snprintf(buffer, OVR_ARRAY_COUNT(buffer), "0x%p", amd->Alloc);
-    descriptionString += buffer;
-  }
+  slot.BytesUntilSample -= (int64_t)size;
+  if (slot.BytesUntilSample > 0) // This is the common case.
+    return;
 
-  if (amdFlags & AMFAllocSize) {
-    snprintf(buffer, OVR_ARRAY_COUNT(buffer), ", size: %llu", amd->AllocSize);
-    descriptionString += buffer;
+  if (slot.RandomState == 0) // If this is the thread's first allocation, start its countdown.
+  {
+    slot.RandomState =
+        (GetCurrentHeapTimeNs() ^ ((uint64_t)GetThreadId() << 32) ^ (uint64_t)(uintptr_t)&slot) |
+        1;
+    slot.BytesUntilSample = GetNextSampleInterval(slot.RandomState, SampleIntervalBytes);
+    return;
   }
 
-  if (amdFlags & AMFBlockSize) {
-    snprintf(buffer, OVR_ARRAY_COUNT(buffer), ", block size: %llu", amd->BlockSize);
-    descriptionString += buffer;
-  }
+  slot.BytesUntilSample = GetNextSampleInterval(slot.RandomState, SampleIntervalBytes);
+
+  AllocSampleEvent event;
+  event.Alloc = p;
+  event.Size = size;
+
+  // An allocation of size s is sampled with probability 1 - exp(-s / interval), so dividing by
+  // that gives an unbiased estimate of the bytes it represents.
+  const double interval = (double)SampleIntervalBytes;
+  const double probability = 1.0 - exp(-(double)size / interval);
+  event.Weight = (probability > 0.0) ? (uint64_t)((double)size / probability) : SampleIntervalBytes;
+  if (event.Weight == 0)
+    event.Weight = 1;
+
+  event.Tag = (tag ? tag : GetTag());
+  event.File = file;
+  event.Line = line;
+  event.TimeNs = Allocator::GetCurrentHeapTimeNs();
+  event.ThreadId = GetThreadId();
+  OVR::Thread::GetCurrentThreadName(event.ThreadName, sizeof(event.ThreadName));
+#if defined(_WIN64)
+  event.FrameCount = Symbols.GetBacktrace(event.Frames, AllocSampleEvent::MaxFrames, 2);
+#else
+  // See TrackAlloc regarding 32 bit backtraces.
+  event.FrameCount = 0;
+#endif
+
+  // Let SampleFree know this pointer needs attention. We do this before the event is published, so
+  // the free of this pointer by any thread can't be missed.
+  std::atomic<uint8_t>& filter = SampleFilter[GetSampleFilterIndex(p, SampleFilterSize)];
+  uint8_t count = filter.load(std::memory_order_relaxed);
+  while ((count != 0xff) &&
+         !filter.compare_exchange_weak(count, (uint8_t)(count + 1), std::memory_order_relaxed))
+    ;
+
+  RecordSampleEvent(event);
+}
+
+void Allocator::SampleFree(const void* p) {
+  if (!p || (SampleFilter[GetSampleFilterIndex(p, SampleFilterSize)].load(
+                 std::memory_order_relaxed) == 0)) // This is the common case.
+    return;
+
+  // p may be sampled. Possibly not, as other pointers share its filter entry.
+  AllocSampleEvent event;
+  event.Alloc = p;
+  event.Size = 0;
+  event.Weight = 0;
+  event.FrameCount = 0;
+
+  RecordSampleEvent(event);
+}
+
+AllocSampleBuffer* Allocator::GetSampleBuffer() {
+  AllocSampleThreadSlot& slot = SampleSlot;
+
+  if (slot.Buffer) {
+    Allocator* owner = slot.Buffer->Owner.load(std::memory_order_relaxed);
+
+    if (owner == this)
+      return slot.Buffer;
+    if (owner)
+      return nullptr; // Another Allocator owns this thread's buffer.
+  } else if (slot.Retired) {
+    return nullptr;
+  } else {
+    slot.Buffer = reinterpret_cast<AllocSampleBuffer*>(SysMemAlloc(sizeof(AllocSampleBuffer)));
+    if (!slot.Buffer)
+      return nullptr;
+    new (slot.Buffer) AllocSampleBuffer;
+    slot.Buffer->Owner.store(nullptr, std::memory_order_relaxed);
+  }
+
+  // Register the buffer with us. It's either new or left over from an Allocator that shut down.
+  AllocSampleBuffer* buffer = slot.Buffer;
+  buffer->Orphaned = false;
+  buffer->Head.store(0, std::memory_order_relaxed);
+  buffer->Tail.store(0, std::memory_order_relaxed);
+
+  SpinLocker registryLocker(SampleRegistryLock);
+  buffer->Next = SampleBufferList;
+  SampleBufferList = buffer;
+  buffer->Owner.store(this, std::memory_order_release);
+
+  return buffer;
+}
+
+void Allocator::RecordSampleEvent(const AllocSampleEvent& event) {
+  AllocSampleBuffer* buffer = GetSampleBuffer();
+
+  if (buffer) {
+    uint32_t head = buffer->Head.load(std::memory_order_relaxed);
+
+    if ((head - buffer->Tail.load(std::memory_order_acquire)) == AllocSampleBuffer::Capacity) {
+      Lock::Locker locker(&SampleLock);
+      DrainSampleBuffers();
+    }
+
+    AllocSampleEvent& slotEvent = buffer->Events[head & (AllocSampleBuffer::Capacity - 1)];
+    slotEvent = event;
+    slotEvent.Sequence = SampleSequence.fetch_add(1, std::memory_order_relaxed);
+    buffer->Head.store(head + 1, std::memory_order_release);
+  } else {
+    Lock::Locker locker(&SampleLock);
+    AllocSampleEvent sequencedEvent = event;
+    sequencedEvent.Sequence = SampleSequence.fetch_add(1, std::memory_order_relaxed);
+    DrainSampleBuffers(); // Apply older pending events first.
+    ApplySampleEvent(sequencedEvent);
+  }
+}
+
+void Allocator::DrainSampleBuffers() {
+  typedef std::vector<const AllocSampleEvent*, StdAllocatorSysMem<const AllocSampleEvent*>>
+      EventPointerVector;
+  EventPointerVector events;
+
+  struct BufferHead {
+    AllocSampleBuffer* Buffer;
+    uint32_t Head;
+  };
+  std::vector<BufferHead, StdAllocatorSysMem<BufferHead>> heads;
+
+  {
+    SpinLocker registryLocker(SampleRegistryLock);
+
+    for (AllocSampleBuffer* buffer = SampleBufferList; buffer; buffer = buffer->Next) {
+      const uint32_t tail = buffer->Tail.load(std::memory_order_relaxed);
+      const uint32_t head = buffer->Head.load(std::memory_order_acquire);
+
+      for (uint32_t i = tail; i != head; ++i)
+        events.push_back(&buffer->Events[i & (AllocSampleBuffer::Capacity - 1)]);
+
+      heads.push_back(BufferHead{buffer, head});
+    }
+  }
+
+  std::sort(
+      events.begin(),
+      events.end(),
+      [](const AllocSampleEvent* a, const AllocSampleEvent* b) -> bool {
+        return (a->Sequence < b->Sequence);
+      });
+
+  if (SamplingEnabled) {
+    for (const AllocSampleEvent* event : events)
+      ApplySampleEvent(*event);
+  }
+
+  SpinLocker registryLocker(SampleRegistryLock);
+
+  for (const BufferHead& bufferHead : heads)
+    bufferHead.Buffer->Tail.store(bufferHead.Head, std::memory_order_release);
+
+  // Free the buffers of exited threads, now that they are empty.
+  for (AllocSampleBuffer** link = &SampleBufferList; *link;) {
+    AllocSampleBuffer* buffer = *link;
+
+    if (buffer->Orphaned &&
+        (buffer->Tail.load(std::memory_order_relaxed) ==
+         buffer->Head.load(std::memory_order_relaxed))) {
+      *link = buffer->Next;
+      buffer->~AllocSampleBuffer();
+      SysMemFree(buffer, sizeof(AllocSampleBuffer));
+    } else {
+      link = &buffer->Next;
+    }
+  }
+}
+
+void Allocator::ApplySampleEvent(const AllocSampleEvent& event) {
+  SampledAllocMap::iterator itAlloc = SampledAllocs.find(event.Alloc);
+
+  if (itAlloc != SampledAllocs.end()) // If this is the free of a sample, or a reuse of its address...
+  {
+    const SampledAlloc& sampledAlloc = itAlloc->second;
+    SampledSiteMap::iterator itSite = SampledSites.find(sampledAlloc.SiteKey);
+
+    if (itSite != SampledSites.end()) {
+      AllocMetadata& site = itSite->second;
+      site.AllocSize -= sampledAlloc.Weight;
+      site.BlockSize -= sampledAlloc.Size;
+      if (--site.Count == 0)
+        SampledSites.erase(itSite);
+    }
+
+    SampledAllocs.erase(itAlloc);
+
+    std::atomic<uint8_t>& filter =
+        SampleFilter[GetSampleFilterIndex(event.Alloc, SampleFilterSize)];
+    uint8_t count = filter.load(std::memory_order_relaxed);
+    while ((count != 0) && (count != 0xff) && // A saturated count stays saturated.
+           !filter.compare_exchange_weak(
+               count, (uint8_t)(count - 1), std::memory_order_relaxed))
+      ;
+  }
+
+  if (event.Weight == 0) // If this is a free event...
+    return;
+
+  // The site key combines the tag with the backtrace (FNV-1a).
+  uint64_t siteKey = UINT64_C(14695981039346656037);
+  auto hashValue = [&siteKey](uint64_t value) {
+    siteKey ^= value;
+    siteKey *= UINT64_C(1099511628211);
+  };
+  hashValue((uint64_t)(uintptr_t)event.Tag);
+  for (size_t i = 0; i < event.FrameCount; ++i)
+    hashValue((uint64_t)(uintptr_t)event.Frames[i]);
+
+  AllocMetadata& site = SampledSites[siteKey];
+
+  if (site.Count == 0) // If this is a new site...
+    site.Backtrace = Backtraces.Intern(event.Frames, event.FrameCount);
+
+  site.Alloc = event.Alloc;
+  site.File = event.File;
+  site.Line = event.Line;
+  site.TimeNs = event.TimeNs;
+  site.Count++;
+  site.AllocSize += event.Weight;
+  site.BlockSize += event.Size;
+  site.Tag = event.Tag;
+  site.ThreadId = event.ThreadId;
+  OVR_strlcpy(site.ThreadName, event.ThreadName, sizeof(site.ThreadName));
+
+  SampledAllocs[event.Alloc] = SampledAlloc{siteKey, event.Weight, event.Size};
+}
+
+void Allocator::ClearSamples() {
+  DrainSampleBuffers(); // Discards the events, as SamplingEnabled is false.
+
+  SampledAllocs.clear();
+  SampledSites.clear();
+
+  for (size_t i = 0; i < SampleFilterSize; ++i)
+    SampleFilter[i].store(0, std::memory_order_relaxed);
+}
+
+//------------------------------------------------------------------------
+// ***** Allocator stats
+//
+
+size_t AllocatorStats::GetSizeClass(uint64_t size) {
+  size_t sizeClass = 0;
+
+  while (size && (sizeClass < (SizeClassCount - 1))) {
+    size >>= 1;
+    ++sizeClass;
+  }
+
+  return sizeClass;
+}
+
+void Allocator::StatCounters::Clear() {
+  LiveBytes.store(0, std::memory_order_relaxed);
+  LiveCount.store(0, std::memory_order_relaxed);
+  PeakBytes.store(0, std::memory_order_relaxed);
+  AllocBytes.store(0, std::memory_order_relaxed);
+  AllocCount.store(0, std::memory_order_relaxed);
+}
+
+void Allocator::StatCounters::CountAlloc(uint64_t size, bool live) {
+  AllocBytes.fetch_add(size, std::memory_order_relaxed);
+  AllocCount.fetch_add(1, std::memory_order_relaxed);
+
+  if (live) {
+    const uint64_t liveBytes = LiveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    LiveCount.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t peakBytes = PeakBytes.load(std::memory_order_relaxed);
+    while ((liveBytes > peakBytes) &&
+           !PeakBytes.compare_exchange_weak(peakBytes, liveBytes, std::memory_order_relaxed))
+      ;
+  }
+}
+
+void Allocator::StatCounters::CountFree(uint64_t size) {
+  LiveBytes.fetch_sub(size, std::memory_order_relaxed);
+  LiveCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void Allocator::StatCounters::Copy(AllocatorStatsEntry& entry) const {
+  entry.LiveBytes = LiveBytes.load(std::memory_order_relaxed);
+  entry.LiveCount = LiveCount.load(std::memory_order_relaxed);
+  entry.PeakBytes = PeakBytes.load(std::memory_order_relaxed);
+  entry.AllocBytes = AllocBytes.load(std::memory_order_relaxed);
+  entry.AllocCount = AllocCount.load(std::memory_order_relaxed);
+}
+
+Allocator::StatCounters& Allocator::GetTagStats(const char* tag) {
+  const size_t slotCount = AllocatorStats::MaxTagCount - 1; // The last slot is for overflow.
+  size_t slot = (size_t)(((uint64_t)(uintptr_t)tag * UINT64_C(0x9E3779B97F4A7C15)) >> 32) % slotCount;
+
+  for (size_t i = 0; i < slotCount; ++i, slot = ((slot + 1) % slotCount)) {
+    const char* slotTag = TagStatsNames[slot].load(std::memory_order_acquire);
+
+    if (!slotTag) {
+      if (TagStatsNames[slot].compare_exchange_strong(slotTag, tag, std::memory_order_acq_rel))
+        return TagStats[slot];
+      // Else another thread claimed it just now, and slotTag is now its tag.
+    }
+
+    // Tags are usually string literals and thus compare by pointer, but the same literal may have
+    // different addresses in different modules.
+    if ((slotTag == tag) || (strcmp(slotTag, tag) == 0))
+      return TagStats[slot];
+  }
+
+  return TagStats[slotCount];
+}
+
+void Allocator::CountAlloc(uint64_t size, const char* tag) {
+  const bool live = TrackingEnabled; // Frees are only counted when tracking. See AllocatorStats.
+
+  TotalStats.CountAlloc(size, live);
+  SizeClassStats[AllocatorStats::GetSizeClass(size)].CountAlloc(size, live);
+  GetTagStats(tag ? tag : GetTag()).CountAlloc(size, live);
+}
+
+void Allocator::CountFree(uint64_t size, const char* tag) {
+  TotalStats.CountFree(size);
+  SizeClassStats[AllocatorStats::GetSizeClass(size)].CountFree(size);
+  GetTagStats(tag ? tag : OVR_ALLOCATOR_UNSPECIFIED_TAG).CountFree(size);
+}
+
+void Allocator::GetStatsSnapshot(AllocatorStats& stats) const {
+  stats.TimeNs = GetCurrentHeapTimeNs();
+  stats.LiveValid = TrackingEnabled;
+
+  TotalStats.Copy(stats.Total);
+  stats.Total.Name = nullptr;
+
+  stats.TagCount = 0;
+  for (size_t i = 0; i < AllocatorStats::MaxTagCount; ++i) {
+    const bool overflowSlot = (i == (AllocatorStats::MaxTagCount - 1));
+    const char* tag =
+        overflowSlot ? "(other)" : TagStatsNames[i].load(std::memory_order_acquire);
+
+    if (tag && (TagStats[i].AllocCount.load(std::memory_order_relaxed) != 0)) {
+      AllocatorStatsEntry& entry = stats.Tags[stats.TagCount++];
+      TagStats[i].Copy(entry);
+      entry.Name = tag;
+    }
+  }
+
+  for (size_t i = 0; i < AllocatorStats::SizeClassCount; ++i) {
+    SizeClassStats[i].Copy(stats.SizeClasses[i]);
+    stats.SizeClasses[i].Name = nullptr;
+  }
+
+  static_assert(
+      AllocatorStats::MaxNodeCount == NumaHeap::MaxNodeCount, "AllocatorStats::Nodes size");
+
+  stats.NodeCount = 0;
+  if (NumaHeapEnabled && Heap) {
+    const NumaHeap* numaHeap = static_cast<const NumaHeap*>(Heap);
+
+    for (size_t i = 0; i < numaHeap->GetNodeCount(); ++i) {
+      NumaHeap::NodeStats nodeStats;
+      numaHeap->GetNodeStats(i, nodeStats);
+
+      AllocatorStatsEntry& entry = stats.Nodes[stats.NodeCount++];
+      entry.Name = nullptr;
+      entry.LiveBytes = nodeStats.LiveBytes;
+      entry.LiveCount = nodeStats.LiveCount;
+      entry.PeakBytes = nodeStats.PeakBytes;
+      entry.AllocBytes = nodeStats.AllocBytes;
+      entry.AllocCount = nodeStats.AllocCount;
+    }
+  }
+}
+
+void Allocator::LogStats(bool includeSizeClasses) const {
+  static ovrlog::Channel Logger("Kernel:Allocator"); // Constructed upon first use, as it allocates.
+
+  if (!Logger.Active(ovrlog::Level::Info))
+    return;
+
+  // This is about 8KB, which is a lot for the stack of some threads.
+  AllocatorStats* stats = reinterpret_cast<AllocatorStats*>(SysMemAlloc(sizeof(AllocatorStats)));
+  if (!stats)
+    return;
+  GetStatsSnapshot(*stats);
+
+  auto logEntry = [](const char* kind, const char* name, const AllocatorStatsEntry& entry) {
+    Logger.LogInfo(
+        "Heap ",
+        kind,
+        "=",
+        name,
+        " live=",
+        entry.LiveBytes,
+        " count=",
+        entry.LiveCount,
+        " peak=",
+        entry.PeakBytes,
+        " allocs=",
+        entry.AllocCount,
+        " allocBytes=",
+        entry.AllocBytes);
+  };
+
+  Logger.LogInfo(
+      "Heap stats for ",
+      AllocatorName,
+      " at ",
+      stats->TimeNs,
+      " ns. Live values ",
+      (stats->LiveValid ? "are valid." : "are unavailable because tracking is disabled."));
+
+  logEntry("total", "all", stats->Total);
+
+  for (size_t i = 0; i < stats->TagCount; ++i)
+    logEntry("tag", stats->Tags[i].Name, stats->Tags[i]);
+
+  if (includeSizeClasses) {
+    for (size_t i = 0; i < AllocatorStats::SizeClassCount; ++i) {
+      if (stats->SizeClasses[i].AllocCount) {
+        char name[24];
+        snprintf(name, sizeof(name), "%llu", (i ? (1ull << (i - 1)) : 0ull));
+        logEntry("sizeClass", name, stats->SizeClasses[i]);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < stats->NodeCount; ++i) {
+    char name[24];
+    snprintf(name, sizeof(name), "%u", (unsigned)i);
+    logEntry("node", name, stats->Nodes[i]);
+  }
+
+  SysMemFree(stats, sizeof(AllocatorStats));
+}
+
+const AllocMetadata* Allocator::IterateHeapBegin() {
+  TrackLock.DoLock(); // Will be unlocked in IterateHeapEnd().
+  SampleLock.DoLock(); // Will be unlocked in IterateHeapEnd().
+  IteratingSamples = (!TrackingEnabled && SamplingEnabled);
+
+  if (IteratingSamples) {
+    DrainSampleBuffers();
+
+    if (!SampledSites.empty()) {
+      SampleIterator = SampledSites.begin();
+      return &SampleIterator->second;
+    }
+  } else if (TrackingEnabled) {
+    // We have a problem in the case that a single thread calls IterateHeapBegin twice
+    // before calling IterateHeapEnd. It can be resolved the application calling IterateHeapEnd
+    // twice as well, but do we want to support that usage? It's probably easier to just disallow
+    // it.
+
+    if (!AllocationMap.empty()) {
+      TrackIterator = AllocationMap.begin();
+      return &TrackIterator->second;
+    }
+  }
+
+  return nullptr;
+}
+
+const AllocMetadata* Allocator::IterateHeapNext() {
+  if (IteratingSamples) {
+    ++SampleIterator;
+
+    if (SampleIterator == SampledSites.end())
+      return nullptr;
+
+    return &SampleIterator->second;
+  }
+
+  ++TrackIterator;
+
+  if (TrackIterator == AllocationMap.end())
+    return nullptr;
+
+  return &TrackIterator->second;
+}
+
+void Allocator::IterateHeapEnd() {
+  IteratingSamples = false;
+  SampleLock.Unlock();
+  TrackLock.Unlock();
+}
+
+size_t Allocator::DescribeAllocation(
+    const AllocMetadata* amd,
+    int amdFlags,
+    char* description,
+    size_t descriptionCapacity,
+    size_t appendedNewlineCount) {
+  SysAllocatedString descriptionString;
+  char buffer[2048];
+
+  if (amdFlags & AMFAlloc) {
+    snprintf(buffer, OVR_ARRAY_COUNT(buffer), "0x%p", amd->Alloc);
+    descriptionString += buffer;
+  }
+
+  if (amdFlags & AMFAllocSize) {
+    snprintf(buffer, OVR_ARRAY_COUNT(buffer), ", size: %llu", amd->AllocSize);
+    descriptionString += buffer;
+  }
+
+  if (amdFlags & AMFBlockSize) {
+    snprintf(buffer, OVR_ARRAY_COUNT(buffer), ", block size: %llu", amd->BlockSize);
+    descriptionString += buffer;
+  }
 
   if (amdFlags & AMFTime) {
     snprintf(buffer, OVR_ARRAY_COUNT(buffer), ", time: %llus", amd->TimeNs / UINT64_C(1000000000));
@@ -2216,15 +3228,30 @@ size_t Allocator::DescribeAllocation(
     if (!descriptionString.empty()) // If anything was written above...
       descriptionString += "\n";
 
-    for (size_t j = 0, jEnd = amd->Backtrace.size();
+    // Look up the whole backtrace at once, so that repeated frames are resolved only once.
+    const bool shouldLookupSymbols =
+        (SymbolLookupEnabled && ((amdFlags & AMFBacktraceSymbols) != 0));
+    std::vector<SymbolInfo, StdAllocatorSysMem<SymbolInfo>> symbolInfoArray;
+
+    const size_t frameCount = amd->Backtrace ? amd->Backtrace->FrameCount : 0;
+    void* const* frames = amd->Backtrace ? amd->Backtrace->Frames : nullptr;
+
+    if (shouldLookupSymbols && frameCount) {
+      std::vector<uint64_t, StdAllocatorSysMem<uint64_t>> addressArray(frameCount);
+      for (size_t j = 0; j < frameCount; ++j)
+        addressArray[j] = (uint64_t)(uintptr_t)frames[j];
+      symbolInfoArray.resize(addressArray.size());
+      if (!Symbols.LookupSymbols(addressArray.data(), symbolInfoArray.data(), addressArray.size()))
+        symbolInfoArray.clear();
+    }
+
+    for (size_t j = 0, jEnd = frameCount;
          (j < jEnd) && (descriptionString.length() < descriptionCapacity);
          ++j) {
-      const bool shouldLookupSymbols =
-          (SymbolLookupEnabled && ((amdFlags & AMFBacktraceSymbols) != 0));
-      SymbolInfo symbolInfo;
+      if ((j < symbolInfoArray.size()) &&
+          (symbolInfoArray[j].filePath[0] || symbolInfoArray[j].function[0])) {
+        const SymbolInfo& symbolInfo = symbolInfoArray[j];
 
-      if (shouldLookupSymbols && Symbols.LookupSymbol((uint64_t)amd->Backtrace[j], symbolInfo) &&
-          (symbolInfo.filePath[0] || symbolInfo.function[0])) {
         if (symbolInfo.filePath[0])
           snprintf(
               buffer,
@@ -2240,7 +3267,7 @@ size_t Allocator::DescribeAllocation(
               OVR_ARRAY_COUNT(buffer),
               "%2u: 0x%p (unknown source file): %s\n",
               (unsigned)j,
-              amd->Backtrace[j],
+              frames[j],
               symbolInfo.function);
       } else {
         snprintf(
@@ -2248,7 +3275,7 @@ size_t Allocator::DescribeAllocation(
             OVR_ARRAY_COUNT(buffer),
             "%2u: 0x%p (symbols unavailable)\n",
             (unsigned)j,
-            amd->Backtrace[j]);
+            frames[j]);
       }
 
       descriptionString += buffer;
@@ -2317,7 +3344,7 @@ size_t Allocator::TraceTrackedAllocations(AllocationTraceCallback callback, uint
     // buffer. We need more dest buffer space below.
     size_t currentStrlen = OVR_strlcat(leakReportBuffer, line, leakReportBufferSize);
 
-    if (amd.Backtrace.empty()) {
+    if (!amd.Backtrace) {
       snprintf(line, OVR_ARRAY_COUNT(line), "(backtrace unavailable)\n");
       OVR_strlcat(leakReportBuffer, line, leakReportBufferSize);
     } else {
@@ -2877,82 +3904,408 @@ void* OSHeap::ReallocAligned(void* p, size_t newSize, size_t /*newAlign*/) {
 }
 
 //------------------------------------------------------------------------
-// ***** SafeMMapAlloc / SafeMMapFree
+// ***** LargePageHeap
 //
 
-void* SafeMMapAlloc(size_t size) {
 #if defined(_WIN32)
-  return VirtualAlloc(
-      nullptr,
-      size,
-      MEM_RESERVE | MEM_COMMIT,
-      PAGE_READWRITE); // size is rounded up to a page. // Returned memory is 0-filled.
+// Large pages require SeLockMemoryPrivilege to be enabled in the process token. The user must
+// have been granted it by policy ("Lock pages in memory"), and this merely turns it on.
+static bool EnableLockMemoryPrivilege() {
+  HANDLE token = nullptr;
 
-#elif defined(OVR_OS_MAC) || defined(OVR_OS_UNIX)
-#if !defined(MAP_FAILED)
-#define MAP_FAILED ((void*)-1)
-#endif
+  if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token))
+    return false;
 
-  void* result = mmap(
-      nullptr,
-      size,
-      PROT_READ | PROT_WRITE,
-      MAP_PRIVATE | MAP_ANON,
-      -1,
-      0); // Returned memory is 0-filled.
-  if (result == MAP_FAILED) // mmap returns MAP_FAILED (-1) upon failure.
-    result = nullptr;
+  TOKEN_PRIVILEGES privileges = {};
+  privileges.PrivilegeCount = 1;
+  privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+  bool result = false;
+
+  if (LookupPrivilegeValueW(nullptr, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid)) {
+    // AdjustTokenPrivileges succeeds even if the privilege wasn't granted, in which case it sets
+    // ERROR_NOT_ALL_ASSIGNED.
+    result = (AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) != FALSE) &&
+        (GetLastError() == ERROR_SUCCESS);
+  }
+
+  CloseHandle(token);
   return result;
+}
 #endif
+
+LargePageHeap::LargePageHeap()
+    : OSHeap(),
+      LargePageSize(0),
+      MappingGranularity(RegularPageSize),
+      BlockLock(),
+      Blocks(),
+      Recycled(),
+      RecycledBytes(0),
+      BlockCount(0) {}
+
+LargePageHeap::~LargePageHeap() {
+  LargePageHeap::Shutdown();
 }
 
-void SafeMMapFree(const void* memory, size_t size) {
+bool LargePageHeap::Init() {
+  OSHeap::Init();
+
 #if defined(_WIN32)
-  OVR_UNUSED(size);
-  VirtualFree(const_cast<void*>(memory), 0, MEM_RELEASE);
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  MappingGranularity = systemInfo.dwAllocationGranularity; // Typically 64 KiB.
 
-#elif defined(OVR_OS_MAC) || defined(OVR_OS_UNIX)
-  size_t pageSize = getpagesize();
-  size = (((size + (pageSize - 1)) / pageSize) * pageSize);
-  munmap(const_cast<void*>(memory), size); // Must supply the size to munmap.
+  const size_t largePageMinimum = GetLargePageMinimum();
+  if (largePageMinimum && EnableLockMemoryPrivilege())
+    LargePageSize = largePageMinimum;
+#elif defined(MAP_HUGETLB)
+  LargePageSize = 2 * 1024 * 1024; // The default huge page size on x64. mmap tells us if not so.
 #endif
+
+  return true;
 }
 
-//------------------------------------------------------------------------
-// ***** DebugPageHeap
+void LargePageHeap::Shutdown() {
+  Lock::Locker locker(&BlockLock);
 
-static size_t AlignSizeUp(size_t value, size_t alignment) {
-  return ((value + (alignment - 1)) & ~(alignment - 1));
-}
+  for (auto& recycled : Recycled)
+    UnmapPages(recycled.second.first, recycled.first, recycled.second.second);
+  Recycled.clear();
+  RecycledBytes = 0;
 
-static size_t AlignSizeDown(size_t value, size_t alignment) {
-  return (value & ~(alignment - 1));
-}
+  // Live blocks are leaked, like the live blocks of the other heaps, in case something still
+  // references them after the Allocator is shut down.
+  Blocks.clear();
+  BlockCount = 0;
 
-template <typename Pointer>
-Pointer AlignPointerUp(Pointer p, size_t alignment) {
-  return reinterpret_cast<Pointer>(
-      ((reinterpret_cast<size_t>(p) + (alignment - 1)) & ~(alignment - 1)));
+  OSHeap::Shutdown();
 }
 
-template <typename Pointer>
-Pointer AlignPointerDown(Pointer p, size_t alignment) {
-  return reinterpret_cast<Pointer>(reinterpret_cast<size_t>(p) & ~(alignment - 1));
-}
+void* LargePageHeap::MapPages(size_t& capacity, bool& largePages) {
+  auto AlignSizeUp = [](size_t value, size_t alignment) -> size_t {
+    return ((value + (alignment - 1)) & ~(alignment - 1));
+  };
 
-const size_t kFreedBlockArrayMaxSizeDefault = 16384;
+  void* p = nullptr;
 
-DebugPageHeap::DebugPageHeap()
-    : FreedBlockArray(nullptr),
-      FreedBlockArrayMaxSize(0),
-      FreedBlockArraySize(0),
-      FreedBlockArrayOldest(0),
-      AllocationCount(0),
-      OverrunPageEnabled(true)
-#if defined(OVR_BUILD_DEBUG)
-      ,
-      OverrunGuardBytesEnabled(true)
-#else
+  if (LargePageSize) {
+    const size_t largeCapacity = AlignSizeUp(capacity, LargePageSize);
+
+#if defined(_WIN32)
+    p = VirtualAlloc(
+        nullptr, largeCapacity, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+#elif defined(MAP_HUGETLB)
+    p = mmap(
+        nullptr,
+        largeCapacity,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+        -1,
+        0);
+    if (p == MAP_FAILED)
+      p = nullptr;
+#endif
+
+    if (p) {
+      capacity = largeCapacity;
+      largePages = true;
+      return p;
+    }
+    // Else the OS is likely out of contiguous physical memory for large pages. Fall back.
+  }
+
+  capacity = AlignSizeUp(capacity, MappingGranularity);
+  largePages = false;
+
+#if defined(_WIN32)
+  p = VirtualAlloc(nullptr, capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+  p = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED)
+    p = nullptr;
+#if defined(MADV_HUGEPAGE)
+  else
+    madvise(p, capacity, MADV_HUGEPAGE); // Ask for transparent huge pages instead.
+#endif
+#endif
+
+  return p;
+}
+
+void LargePageHeap::UnmapPages(void* p, size_t capacity, bool largePages) {
+  OVR_UNUSED(largePages);
+#if defined(_WIN32)
+  OVR_UNUSED(capacity);
+  BOOL result = VirtualFree(p, 0, MEM_RELEASE);
+  OVR_ASSERT_AND_UNUSED(result, result);
+#else
+  munmap(p, capacity);
+#endif
+}
+
+void* LargePageHeap::AllocLarge(size_t size) {
+  Lock::Locker locker(&BlockLock);
+
+  LargeBlock block = {size, size, false};
+  void* p = nullptr;
+
+  // Use the smallest recycled block that fits, unless it would waste more than a quarter.
+  RecycledBlockMap::iterator it = Recycled.lower_bound(size);
+
+  if ((it != Recycled.end()) && (it->first <= (size + (size / 4) + MappingGranularity))) {
+    p = it->second.first;
+    block.Capacity = it->first;
+    block.LargePages = it->second.second;
+    RecycledBytes -= it->first;
+    Recycled.erase(it);
+  } else {
+    p = MapPages(block.Capacity, block.LargePages);
+  }
+
+  if (p) {
+    Blocks[p] = block;
+    BlockCount.store(Blocks.size(), std::memory_order_relaxed);
+  }
+
+  return p;
+}
+
+bool LargePageHeap::FindLarge(const void* p, LargeBlock& block) const {
+  // Large blocks are page-aligned and few, so this avoids the lock for nearly all small blocks.
+  if (!IsPageAligned(p) || (BlockCount.load(std::memory_order_relaxed) == 0))
+    return false;
+
+  Lock::Locker locker(&BlockLock);
+
+  LargeBlockMap::const_iterator it = Blocks.find(p);
+  if (it == Blocks.end())
+    return false;
+
+  block = it->second;
+  return true;
+}
+
+bool LargePageHeap::FreeLarge(void* p) {
+  if (!IsPageAligned(p) || (BlockCount.load(std::memory_order_relaxed) == 0))
+    return false;
+
+  Lock::Locker locker(&BlockLock);
+
+  LargeBlockMap::iterator it = Blocks.find(p);
+  if (it == Blocks.end())
+    return false;
+
+  const LargeBlock block = it->second;
+  Blocks.erase(it);
+  BlockCount.store(Blocks.size(), std::memory_order_relaxed);
+
+  if ((RecycledBytes + block.Capacity) <= MaxRecycledBytes) {
+    Recycled.insert(
+        RecycledBlockMap::value_type(block.Capacity, std::make_pair(p, block.LargePages)));
+    RecycledBytes += block.Capacity;
+  } else {
+    UnmapPages(p, block.Capacity, block.LargePages);
+  }
+
+  return true;
+}
+
+void* LargePageHeap::ReallocLarge(void* p, const LargeBlock& block, size_t newSize) {
+  if (newSize <= block.Capacity) // If it fits in place...
+  {
+    Lock::Locker locker(&BlockLock);
+    Blocks[p].Size = newSize;
+    return p;
+  }
+
+  void* pNew = AllocLarge(newSize);
+
+  if (pNew) {
+    memcpy(pNew, p, block.Size);
+    FreeLarge(p);
+  }
+
+  return pNew;
+}
+
+void* LargePageHeap::Alloc(size_t size) {
+  if (size >= LargeAllocThreshold)
+    return AllocLarge(size);
+
+  return OSHeap::Alloc(size);
+}
+
+void* LargePageHeap::AllocAligned(size_t size, size_t align) {
+  if ((size >= LargeAllocThreshold) && (align <= RegularPageSize))
+    return AllocLarge(size);
+
+  return OSHeap::AllocAligned(size, align);
+}
+
+size_t LargePageHeap::GetAllocSize(const void* p) const {
+  LargeBlock block;
+
+  if (FindLarge(p, block))
+    return block.Size;
+
+  return OSHeap::GetAllocSize(p);
+}
+
+size_t LargePageHeap::GetAllocAlignedSize(const void* p, size_t align) const {
+  LargeBlock block;
+
+  if (FindLarge(p, block))
+    return block.Size;
+
+  return OSHeap::GetAllocAlignedSize(p, align);
+}
+
+void LargePageHeap::Free(void* p) {
+  if (!FreeLarge(p))
+    OSHeap::Free(p);
+}
+
+void LargePageHeap::FreeAligned(void* p) {
+  if (!FreeLarge(p))
+    OSHeap::FreeAligned(p);
+}
+
+void* LargePageHeap::Realloc(void* p, size_t newSize) {
+  if (!p)
+    return Alloc(newSize);
+
+  LargeBlock block;
+
+  if (FindLarge(p, block))
+    return ReallocLarge(p, block, newSize);
+
+  if (newSize >= LargeAllocThreshold) // If a small block is growing into a large one...
+  {
+    void* pNew = AllocLarge(newSize);
+
+    if (pNew) {
+      memcpy(pNew, p, std::min(OSHeap::GetAllocSize(p), newSize));
+      OSHeap::Free(p);
+    }
+
+    return pNew;
+  }
+
+  return OSHeap::Realloc(p, newSize);
+}
+
+void* LargePageHeap::ReallocAligned(void* p, size_t newSize, size_t newAlign) {
+  if (!p)
+    return AllocAligned(newSize, newAlign);
+
+  LargeBlock block;
+
+  if (FindLarge(p, block)) {
+    if (newAlign <= RegularPageSize)
+      return ReallocLarge(p, block, newSize);
+
+    void* pNew = OSHeap::AllocAligned(newSize, newAlign);
+
+    if (pNew) {
+      memcpy(pNew, p, std::min(block.Size, newSize));
+      FreeLarge(p);
+    }
+
+    return pNew;
+  }
+
+  if ((newSize >= LargeAllocThreshold) && (newAlign <= RegularPageSize)) {
+    void* pNew = AllocLarge(newSize);
+
+    if (pNew) {
+      memcpy(pNew, p, std::min(OSHeap::GetAllocAlignedSize(p, newAlign), newSize));
+      OSHeap::FreeAligned(p);
+    }
+
+    return pNew;
+  }
+
+  return OSHeap::ReallocAligned(p, newSize, newAlign);
+}
+
+//------------------------------------------------------------------------
+// ***** SafeMMapAlloc / SafeMMapFree
+//
+
+void* SafeMMapAlloc(size_t size) {
+#if defined(_WIN32)
+  return VirtualAlloc(
+      nullptr,
+      size,
+      MEM_RESERVE | MEM_COMMIT,
+      PAGE_READWRITE); // size is rounded up to a page. // Returned memory is 0-filled.
+
+#elif defined(OVR_OS_MAC) || defined(OVR_OS_UNIX)
+#if !defined(MAP_FAILED)
+#define MAP_FAILED ((void*)-1)
+#endif
+
+  void* result = mmap(
+      nullptr,
+      size,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANON,
+      -1,
+      0); // Returned memory is 0-filled.
+  if (result == MAP_FAILED) // mmap returns MAP_FAILED (-1) upon failure.
+    result = nullptr;
+  return result;
+#endif
+}
+
+void SafeMMapFree(const void* memory, size_t size) {
+#if defined(_WIN32)
+  OVR_UNUSED(size);
+  VirtualFree(const_cast<void*>(memory), 0, MEM_RELEASE);
+
+#elif defined(OVR_OS_MAC) || defined(OVR_OS_UNIX)
+  size_t pageSize = getpagesize();
+  size = (((size + (pageSize - 1)) / pageSize) * pageSize);
+  munmap(const_cast<void*>(memory), size); // Must supply the size to munmap.
+#endif
+}
+
+//------------------------------------------------------------------------
+// ***** DebugPageHeap
+
+static size_t AlignSizeUp(size_t value, size_t alignment) {
+  return ((value + (alignment - 1)) & ~(alignment - 1));
+}
+
+static size_t AlignSizeDown(size_t value, size_t alignment) {
+  return (value & ~(alignment - 1));
+}
+
+template <typename Pointer>
+Pointer AlignPointerUp(Pointer p, size_t alignment) {
+  return reinterpret_cast<Pointer>(
+      ((reinterpret_cast<size_t>(p) + (alignment - 1)) & ~(alignment - 1)));
+}
+
+template <typename Pointer>
+Pointer AlignPointerDown(Pointer p, size_t alignment) {
+  return reinterpret_cast<Pointer>(reinterpret_cast<size_t>(p) & ~(alignment - 1));
+}
+
+const size_t kFreedBlockArrayMaxSizeDefault = 16384;
+
+DebugPageHeap::DebugPageHeap()
+    : FreedBlockArray(nullptr),
+      FreedBlockArrayMaxSize(0),
+      FreedBlockArraySize(0),
+      FreedBlockArrayOldest(0),
+      AllocationCount(0),
+      OverrunPageEnabled(true)
+#if defined(OVR_BUILD_DEBUG)
+      ,
+      OverrunGuardBytesEnabled(true)
+#else
       ,
       OverrunGuardBytesEnabled(false)
 #endif
@@ -3449,69 +4802,845 @@ void DebugPageHeap::FreePageMemory(void* pPageMemory, size_t /*blockSize*/) {
 }
 
 //------------------------------------------------------------------------
-// ***** Allocator debug commands
+// ***** PoolHeap
 //
-//------------------------------------------------------------------------
+// PoolHeapThreadSlot is the per-thread handle to a PoolHeap ThreadCache. Its destructor runs upon
+// thread exit and returns the cache to its heap, if that heap still exists.
+
+struct PoolHeapThreadSlot {
+  PoolHeap* Heap;
+  uint32_t Serial;
+  PoolHeap::ThreadCache* Cache;
+  bool Retired; // True once this thread's slot has been destructed.
+
+  ~PoolHeapThreadSlot() {
+    if (Cache) {
+      PoolHeap* activeHeap = PoolHeap::ActiveHeap.load(std::memory_order_acquire);
+      if (activeHeap && (activeHeap == Heap) && (activeHeap->Serial == Serial))
+        activeHeap->ReleaseThreadCache(Cache);
+    }
+    Heap = nullptr;
+    Cache = nullptr;
+    Retired = true; // Any further frees by this thread (e.g. by other thread_local destructors) go
+    // to the depot.
+  }
+};
 
-// AllocatorTraceDbgCmd
-const char* allocatorTraceDbgCmdName = "Allocator.Trace";
-const char* allocatorTraceDbgCmdUsage = "<filepath> [filter specification]";
-const char* allocatorTraceDbgCmdDesc =
-    "Triggers the logging of the default allocator heap, with an optional filter.";
-const char* allocatorTraceDbgCmdDoc =
-    "Triggers the logging of the default allocator heap, with an optional filter.\n"
-    "The filter is a string which accepts a set of comparisons expressed in postfix (RPN).\n"
-    "Stack traces will be symbolized if the symbol files are present; otherwise they will be missing.\n"
-    "The ability to trace heaps can be enabled in release builds by setting the appropriate\n"
-    "registry key before starting OVRServer:\n"
-    "    HKEY_LOCAL_MACHINE\\SOFTWARE\\Oculus\\HeapTrackingEnabled, REG_DWORD of 0 or 1.\n"
-    "The enabling of the debug page heap can be enabled in release builds by setting:\n"
-    "    HKEY_LOCAL_MACHINE\\SOFTWARE\\Oculus\\DebugPageHeapEnabled, REG_DWORD of 0 or 1.\n"
-    "Allocation tracking and tracing will have more results if malloc tracking is enabled.\n"
-    "    HKEY_LOCAL_MACHINE\\SOFTWARE\\Oculus\\MallocRedirectEnabled, REG_DWORD of 0 or 1.\n"
-    "Use Allocator.ReportState to tell what the current settings are.\n"
-    "\n"
-    "Example usage:\n"
-    "    Allocator.Trace C:\\temp\\trace.txt                                   Trace the entire heap\n"
-    "    Allocator.Trace C:\\temp\\trace.txt \"size > 1024\"                   Trace only allocations > 1024 bytes\n"
-    "    Allocator.Trace C:\\temp\\trace.txt \"size > 1024; size < 2048; and\" Trace allocations between 1024 and 2048\n"
-    "    Allocator.Trace C:\\temp\\trace.txt \"time > -10s\"                   Trace allocations done in the last 10 seconds\n"
-    "    Allocator.Trace C:\\temp\\trace.txt \"time > 50000\"                  Trace allocations done in the first 50000 nanoseconds\n"
-    "    Allocator.Trace C:\\temp\\trace.txt \"tag == geometry\"              Trace only allocations tagged as geometry\n"
-    "    Allocator.Trace C:\\temp\\trace.txt \"ThreadName has vision\"         Trace only allocations from threads with \"vision\" in the name\n";
-int AllocatorTraceDbgCmd(const std::vector<std::string>& args, std::string* output) {
-  OVR_DISABLE_MSVC_WARNING(4996) // 4996: This function or variable may be unsafe.
+static thread_local PoolHeapThreadSlot PoolHeapSlot = {nullptr, 0, nullptr, false};
+
+const uint32_t PoolHeap::ClassSize[PoolHeap::SizeClassCount] =
+    {16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512, 640, 768, 896, 1024};
+
+std::atomic<PoolHeap*> PoolHeap::ActiveHeap(nullptr);
+std::atomic<uint32_t> PoolHeap::NextSerial(0);
+
+PoolHeap::PoolHeap()
+    : SizeClassTable{},
+      Lock(),
+      DepotList{},
+      DepotCount{},
+      CacheList(nullptr),
+      ChunkList(nullptr),
+      ChunkCurrent(nullptr),
+      ChunkEnd(nullptr),
+      Serial(0) {
+  OVR_ASSERT(ClassSize[SizeClassCount - 1] == MaxPooledSize);
+
+  for (uint32_t i = 0, sizeClass = 0; i < OVR_ARRAY_COUNT(SizeClassTable); ++i) {
+    while ((i * DefaultAlignment) > ClassSize[sizeClass])
+      ++sizeClass;
+    SizeClassTable[i] = (uint8_t)sizeClass;
+  }
+}
 
-  OVR::Allocator* allocator = OVR::Allocator::GetInstance(false);
-  if (allocator) {
-    std::stringstream strStream;
+PoolHeap::~PoolHeap() {
+  PoolHeap::Shutdown();
+}
 
-    if (!allocator->IsTrackingEnabled()) {
-      output->append(
-          "Allocator tracking is not enabled. To enable, use the Allocator.EnableTracking command or set the DWORD HKEY_LOCAL_MACHINE\\SOFTWARE\\Oculus\\HeapTrackingEnabled reg key before starting the application.");
-      return -1; // Exit because even if tracking was enabled at some point earlier, all records
-      // would have been cleared with it was disabled.
-    }
+bool PoolHeap::Init() {
+  Serial = ++NextSerial;
 
-    if (args.size() < 2) {
-      output->append(
-          "Filepath first argument is required but was not supplied. See example usage.");
-      return -1;
-    }
+  // Claim the thread_local caches if no other PoolHeap has them.
+  PoolHeap* expected = nullptr;
+  ActiveHeap.compare_exchange_strong(expected, this, std::memory_order_acq_rel);
 
-    std::string filePath = args[1];
-    FILE* file;
-    errno_t err = 0;
+  return true;
+}
 
-#if defined(_WIN32)
-    err = fopen_s(&file, filePath.c_str(), "w");
-#else
-    file = fopen(filePath.c_str(), "w");
-    err = file ? 0 : -1;
-#endif
+void PoolHeap::Shutdown() {
+  PoolHeap* expected = this;
+  ActiveHeap.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
 
-    if (err || !file) {
-      strStream << "Failed to open " << filePath;
+  Lock::Locker autoLock(&Lock);
+
+  // Threads which still reference our caches see that ActiveHeap no longer matches upon exit.
+  while (CacheList) {
+    ThreadCache* next = CacheList->Next;
+    SysMemFree(CacheList, sizeof(ThreadCache));
+    CacheList = next;
+  }
+
+  while (ChunkList) {
+    void* next = *reinterpret_cast<void**>(ChunkList);
+    SysMemFree(ChunkList, ChunkSize);
+    ChunkList = next;
+  }
+
+  for (size_t i = 0; i < SizeClassCount; ++i) {
+    DepotList[i] = nullptr;
+    DepotCount[i] = 0;
+  }
+
+  ChunkCurrent = nullptr;
+  ChunkEnd = nullptr;
+}
+
+void* PoolHeap::Alloc(size_t size) {
+  if (size > MaxPooledSize)
+    return AllocLarge(size, DefaultAlignment);
+
+  const uint32_t sizeClass = SizeClassTable[(size + (DefaultAlignment - 1)) / DefaultAlignment];
+  ThreadCache* cache = GetThreadCache();
+  FreeBlock* block;
+
+  if (cache && cache->FreeList[sizeClass]) {
+    block = cache->FreeList[sizeClass];
+    cache->FreeList[sizeClass] = block->Next;
+    cache->FreeCount[sizeClass]--;
+  } else {
+    block = Refill(cache, sizeClass);
+  }
+
+  return block;
+}
+
+void* PoolHeap::AllocAligned(size_t size, size_t align) {
+  if (align <= DefaultAlignment)
+    return Alloc(size);
+
+  return AllocLarge(size, align);
+}
+
+size_t PoolHeap::GetAllocSize(const void* p) const {
+  const BlockHeader* header = GetHeader(p);
+  return (header->Size - header->Offset);
+}
+
+void PoolHeap::Free(void* p) {
+  if (!p)
+    return;
+
+  BlockHeader* header = GetHeader(p);
+
+  if (header->SizeClass == LargeClass) {
+    SysMemFree(((uint8_t*)p) - header->Offset, header->Size);
+    return;
+  }
+
+  const uint32_t sizeClass = header->SizeClass;
+  FreeBlock* block = reinterpret_cast<FreeBlock*>(p);
+  ThreadCache* cache = GetThreadCache();
+
+  if (cache) {
+    block->Next = cache->FreeList[sizeClass];
+    cache->FreeList[sizeClass] = block;
+
+    if (++cache->FreeCount[sizeClass] > MaxCachedBlocks)
+      Handoff(cache, sizeClass, TransferBatchSize);
+  } else {
+    Lock::Locker autoLock(&Lock);
+    block->Next = DepotList[sizeClass];
+    DepotList[sizeClass] = block;
+    DepotCount[sizeClass]++;
+  }
+}
+
+void* PoolHeap::Realloc(void* p, size_t newSize) {
+  return ReallocAligned(p, newSize, DefaultAlignment);
+}
+
+void* PoolHeap::ReallocAligned(void* p, size_t newSize, size_t newAlign) {
+  if (!p)
+    return AllocAligned(newSize, newAlign);
+
+  if (newSize == 0) // Act like the VC++ CRT, which frees the memory and returns nullptr.
+  {
+    Free(p);
+    return nullptr;
+  }
+
+  const size_t oldSize = GetAllocSize(p);
+
+  // Keep the block if it's big enough and not wastefully large for the new size.
+  if ((newSize <= oldSize) && ((newSize * 2) > oldSize) && ((((size_t)p) & (newAlign - 1)) == 0))
+    return p;
+
+  void* pNew = AllocAligned(newSize, newAlign);
+
+  if (pNew) {
+    memcpy(pNew, p, (oldSize < newSize) ? oldSize : newSize);
+    Free(p);
+  }
+
+  return pNew;
+}
+
+PoolHeap::ThreadCache* PoolHeap::GetThreadCache() {
+  PoolHeapThreadSlot& slot = PoolHeapSlot;
+
+  if ((slot.Heap == this) && (slot.Serial == Serial))
+    return slot.Cache;
+
+  if (slot.Retired || (ActiveHeap.load(std::memory_order_acquire) != this))
+    return nullptr;
+
+  // This is the first use of this heap by the current thread. If the slot refers to a prior heap
+  // which has since been shut down then its cache memory is already gone, so we just overwrite it.
+  ThreadCache* cache = AcquireThreadCache();
+
+  if (cache) {
+    slot.Heap = this;
+    slot.Serial = Serial;
+    slot.Cache = cache;
+  }
+
+  return cache;
+}
+
+PoolHeap::ThreadCache* PoolHeap::AcquireThreadCache() {
+  Lock::Locker autoLock(&Lock);
+
+  for (ThreadCache* cache = CacheList; cache; cache = cache->Next) {
+    if (!cache->InUse) // If this was left behind by a thread that exited...
+    {
+      cache->InUse = true;
+      return cache;
+    }
+  }
+
+  ThreadCache* cache = reinterpret_cast<ThreadCache*>(SysMemAlloc(sizeof(ThreadCache)));
+
+  if (cache) {
+    memset(cache, 0, sizeof(ThreadCache));
+    cache->InUse = true;
+    cache->Next = CacheList;
+    CacheList = cache;
+  }
+
+  return cache;
+}
+
+void PoolHeap::ReleaseThreadCache(ThreadCache* cache) {
+  for (uint32_t i = 0; i < SizeClassCount; ++i) {
+    if (cache->FreeCount[i])
+      Handoff(cache, i, cache->FreeCount[i]);
+  }
+
+  Lock::Locker autoLock(&Lock);
+  cache->InUse = false;
+}
+
+PoolHeap::FreeBlock* PoolHeap::Refill(ThreadCache* cache, uint32_t sizeClass) {
+  // Without a cache we take just the one block we need.
+  const uint32_t wanted = (cache ? TransferBatchSize : 1);
+  FreeBlock* head = nullptr;
+  uint32_t count = 0;
+
+  {
+    Lock::Locker autoLock(&Lock);
+
+    if (DepotList[sizeClass]) {
+      FreeBlock* tail = DepotList[sizeClass];
+      for (count = 1; (count < wanted) && tail->Next; ++count)
+        tail = tail->Next;
+
+      head = DepotList[sizeClass];
+      DepotList[sizeClass] = tail->Next;
+      DepotCount[sizeClass] -= count;
+      tail->Next = nullptr;
+    } else {
+      while (count < wanted) {
+        FreeBlock* block = CarveBlock(sizeClass);
+        if (!block)
+          break;
+        block->Next = head;
+        head = block;
+        ++count;
+      }
+    }
+  }
+
+  if (head && cache) {
+    cache->FreeList[sizeClass] = head->Next;
+    cache->FreeCount[sizeClass] = count - 1;
+  }
+
+  return head;
+}
+
+void PoolHeap::Handoff(ThreadCache* cache, uint32_t sizeClass, uint32_t count) {
+  OVR_ASSERT((count > 0) && (count <= cache->FreeCount[sizeClass]));
+
+  FreeBlock* head = cache->FreeList[sizeClass];
+  FreeBlock* tail = head;
+  for (uint32_t i = 1; i < count; ++i)
+    tail = tail->Next;
+
+  cache->FreeList[sizeClass] = tail->Next;
+  cache->FreeCount[sizeClass] -= count;
+
+  Lock::Locker autoLock(&Lock);
+  tail->Next = DepotList[sizeClass];
+  DepotList[sizeClass] = head;
+  DepotCount[sizeClass] += count;
+}
+
+PoolHeap::FreeBlock* PoolHeap::CarveBlock(uint32_t sizeClass) {
+  const size_t blockSize = HeaderSize + ClassSize[sizeClass];
+
+  if (!ChunkCurrent || ((size_t)(ChunkEnd - ChunkCurrent) < blockSize)) {
+    uint8_t* chunk = reinterpret_cast<uint8_t*>(SysMemAlloc(ChunkSize));
+    if (!chunk)
+      return nullptr;
+
+    // The first pointer of the chunk links it into ChunkList. Any remainder of the prior chunk
+    // is abandoned, which wastes less than MaxPooledSize + HeaderSize per chunk.
+    *reinterpret_cast<void**>(chunk) = ChunkList;
+    ChunkList = chunk;
+    ChunkCurrent = AlignPointerUp(chunk + sizeof(void*), DefaultAlignment);
+    ChunkEnd = chunk + ChunkSize;
+  }
+
+  BlockHeader* header = reinterpret_cast<BlockHeader*>(ChunkCurrent);
+  header->SizeClass = sizeClass;
+  header->Offset = (uint32_t)HeaderSize;
+  header->Size = blockSize;
+  ChunkCurrent += blockSize;
+
+  return reinterpret_cast<FreeBlock*>(((uint8_t*)header) + HeaderSize);
+}
+
+void* PoolHeap::AllocLarge(size_t size, size_t align) {
+  if (align < DefaultAlignment)
+    align = DefaultAlignment;
+
+  if (size > (SIZE_MAX - (HeaderSize + align)))
+    return nullptr;
+
+  // We reserve enough to align the user pointer and still have room for its header before it.
+  // SysMemAlloc guarantees at least pointer alignment.
+  const size_t blockSize = HeaderSize + size + (align - sizeof(void*));
+  uint8_t* block = reinterpret_cast<uint8_t*>(SysMemAlloc(blockSize));
+
+  if (!block)
+    return nullptr;
+
+  uint8_t* p = AlignPointerUp(block + HeaderSize, align);
+  BlockHeader* header = GetHeader(p);
+  header->SizeClass = LargeClass;
+  header->Offset = (uint32_t)(p - block);
+  header->Size = blockSize;
+
+  return p;
+}
+
+//------------------------------------------------------------------------
+// ***** NumaHeap
+//
+
+struct NumaThreadSlot {
+  uint32_t Node; // The node the thread was on when last checked.
+  uint32_t OpsUntilRefresh;
+};
+
+static thread_local NumaThreadSlot NumaSlot = {0, 0};
+
+static uint32_t QueryCurrentNumaNode() {
+#if defined(_WIN32)
+  PROCESSOR_NUMBER processor;
+  GetCurrentProcessorNumberEx(&processor);
+
+  USHORT node;
+  if (GetNumaProcessorNodeEx(&processor, &node))
+    return node;
+#endif
+  return 0;
+}
+
+NumaHeap::NumaHeap() : NodeCount(0) {
+  for (Arena& arena : Arenas)
+    arena.OSHeap = nullptr;
+}
+
+NumaHeap::~NumaHeap() {
+  NumaHeap::Shutdown();
+}
+
+bool NumaHeap::Init() {
+  if (NodeCount) // If already initialized...
+    return true;
+
+  size_t nodeCount = 1;
+
+#if defined(_WIN32)
+  ULONG highestNode;
+  if (GetNumaHighestNodeNumber(&highestNode))
+    nodeCount = std::min<size_t>(highestNode + 1, MaxNodeCount);
+
+  for (size_t i = 0; i < nodeCount; ++i) {
+    Arenas[i].OSHeap = HeapCreate(0, 0, 0);
+
+    if (!Arenas[i].OSHeap) {
+      while (i--) {
+        HeapDestroy(Arenas[i].OSHeap);
+        Arenas[i].OSHeap = nullptr;
+      }
+      return false;
+    }
+  }
+#endif
+
+  for (Arena& arena : Arenas) {
+    arena.LiveBytes = 0;
+    arena.LiveCount = 0;
+    arena.PeakBytes = 0;
+    arena.AllocBytes = 0;
+    arena.AllocCount = 0;
+    arena.RemoteFreeCount = 0;
+  }
+
+  NodeCount = nodeCount;
+  return true;
+}
+
+void NumaHeap::Shutdown() {
+#if defined(_WIN32)
+  for (size_t i = 0; i < NodeCount; ++i) {
+    // Destroying the heap frees anything still allocated from it.
+    HeapDestroy(Arenas[i].OSHeap);
+    Arenas[i].OSHeap = nullptr;
+  }
+#endif
+
+  NodeCount = 0;
+}
+
+uint32_t NumaHeap::GetCurrentNode() const {
+  if (NodeCount <= 1)
+    return 0;
+
+  if (NumaSlot.OpsUntilRefresh == 0) {
+    NumaSlot.Node = QueryCurrentNumaNode();
+    NumaSlot.OpsUntilRefresh = NodeRefreshInterval;
+  }
+
+  NumaSlot.OpsUntilRefresh--;
+  return (uint32_t)(NumaSlot.Node % NodeCount);
+}
+
+void NumaHeap::GetNodeStats(size_t node, NodeStats& stats) const {
+  memset(&stats, 0, sizeof(stats));
+
+  if (node < NodeCount) {
+    const Arena& arena = Arenas[node];
+    stats.LiveBytes = arena.LiveBytes.load(std::memory_order_relaxed);
+    stats.LiveCount = arena.LiveCount.load(std::memory_order_relaxed);
+    stats.PeakBytes = arena.PeakBytes.load(std::memory_order_relaxed);
+    stats.AllocBytes = arena.AllocBytes.load(std::memory_order_relaxed);
+    stats.AllocCount = arena.AllocCount.load(std::memory_order_relaxed);
+    stats.RemoteFreeCount = arena.RemoteFreeCount.load(std::memory_order_relaxed);
+  }
+}
+
+void* NumaHeap::AllocFromNode(uint32_t node, size_t size, size_t align) {
+  if (align < DefaultAlignment)
+    align = DefaultAlignment;
+
+  // The OS heap guarantees less alignment than we need, so we leave room to align within.
+  const size_t capacity = size + HeaderSize + (align - 1);
+  if (capacity < size) // If it overflowed...
+    return nullptr;
+
+  Arena& arena = Arenas[node];
+  uint8_t* base = nullptr;
+  bool large = false;
+
+#if defined(_WIN32)
+  if ((capacity >= LargeBlockSize) && (NodeCount > 1)) {
+    base = static_cast<uint8_t*>(VirtualAllocExNuma(
+        GetCurrentProcess(),
+        nullptr,
+        capacity,
+        MEM_RESERVE | MEM_COMMIT,
+        PAGE_READWRITE,
+        (DWORD)node));
+    large = (base != nullptr);
+  }
+
+  if (!base) // If not large or the node has no memory to spare...
+    base = static_cast<uint8_t*>(HeapAlloc(arena.OSHeap, 0, capacity));
+#else
+  base = static_cast<uint8_t*>(malloc(capacity));
+#endif
+
+  if (!base)
+    return nullptr;
+
+  uint8_t* p = AlignPointerUp(base + HeaderSize, align);
+  BlockHeader* header = GetHeader(p);
+  header->Node = (uint16_t)node;
+  header->Large = (large ? 1 : 0);
+  header->Offset = (uint32_t)(p - base);
+  header->Size = size;
+
+  arena.AllocBytes.fetch_add(size, std::memory_order_relaxed);
+  arena.AllocCount.fetch_add(1, std::memory_order_relaxed);
+  arena.LiveCount.fetch_add(1, std::memory_order_relaxed);
+  const uint64_t liveBytes = arena.LiveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+  if (liveBytes > arena.PeakBytes.load(std::memory_order_relaxed)) // Racy, but close enough.
+    arena.PeakBytes.store(liveBytes, std::memory_order_relaxed);
+
+  return p;
+}
+
+void NumaHeap::FreeToNode(void* base, const BlockHeader& header) {
+#if defined(_WIN32)
+  if (header.Large) {
+    BOOL result = VirtualFree(base, 0, MEM_RELEASE);
+    OVR_ASSERT_AND_UNUSED(result, result);
+  } else {
+    BOOL result = HeapFree(Arenas[header.Node].OSHeap, 0, base);
+    OVR_ASSERT_AND_UNUSED(result, result);
+  }
+#else
+  OVR_UNUSED(header);
+  free(base);
+#endif
+}
+
+void* NumaHeap::Alloc(size_t size) {
+  return AllocFromNode(GetCurrentNode(), size, DefaultAlignment);
+}
+
+void* NumaHeap::AllocAligned(size_t size, size_t align) {
+  return AllocFromNode(GetCurrentNode(), size, align);
+}
+
+size_t NumaHeap::GetAllocSize(const void* p) const {
+  return GetHeader(p)->Size;
+}
+
+void NumaHeap::Free(void* p) {
+  if (!p)
+    return;
+
+  const BlockHeader header = *GetHeader(p);
+  OVR_ASSERT(header.Node < NodeCount);
+  Arena& arena = Arenas[header.Node];
+
+  arena.LiveBytes.fetch_sub(header.Size, std::memory_order_relaxed);
+  arena.LiveCount.fetch_sub(1, std::memory_order_relaxed);
+  if (header.Node != GetCurrentNode())
+    arena.RemoteFreeCount.fetch_add(1, std::memory_order_relaxed);
+
+  FreeToNode(((uint8_t*)p) - header.Offset, header);
+}
+
+void* NumaHeap::Realloc(void* p, size_t newSize) {
+  return ReallocAligned(p, newSize, DefaultAlignment);
+}
+
+void* NumaHeap::ReallocAligned(void* p, size_t newSize, size_t newAlign) {
+  if (!p)
+    return AllocAligned(newSize, newAlign);
+
+  BlockHeader* header = GetHeader(p);
+
+  // Shrink in place, which also keeps the memory on the node it's already on.
+  if ((newSize <= header->Size) && ((((uintptr_t)p) & (newAlign - 1)) == 0)) {
+    Arenas[header->Node].LiveBytes.fetch_sub(header->Size - newSize, std::memory_order_relaxed);
+    header->Size = newSize;
+    return p;
+  }
+
+  void* pNew = AllocFromNode(GetCurrentNode(), newSize, newAlign);
+
+  if (pNew) {
+    memcpy(pNew, p, std::min(header->Size, newSize));
+    Free(p);
+  }
+
+  return pNew;
+}
+
+//------------------------------------------------------------------------
+// ***** FrameArena
+//
+
+thread_local FrameArena* FrameArena::Current = nullptr;
+
+FrameArena::FrameArena(size_t capacity)
+    : Base(nullptr),
+      Capacity(capacity),
+      Used(0),
+      PeakUsed(0),
+      OverflowCount(0),
+      LastAlloc(nullptr) {}
+
+FrameArena::~FrameArena() {
+  FrameArena::Shutdown();
+}
+
+bool FrameArena::Init() {
+  if (!Base) {
+    // SysMemAlloc doesn't guarantee DefaultAlignment, so we reserve enough to align within it.
+    Base = reinterpret_cast<uint8_t*>(SysMemAlloc(Capacity + DefaultAlignment));
+    if (!Base)
+      return false;
+  }
+
+  Reset();
+  PeakUsed = 0;
+  OverflowCount = 0;
+  return true;
+}
+
+void FrameArena::Shutdown() {
+  OVR_ASSERT(Current != this); // A Scope still refers to us.
+
+  if (Base) {
+    SysMemFree(Base, Capacity + DefaultAlignment);
+    Base = nullptr;
+  }
+
+  Reset();
+}
+
+uint8_t* FrameArena::AllocFromRegion(size_t size, size_t align) {
+  if (!Base || (size > Capacity))
+    return nullptr;
+
+  if (align < DefaultAlignment)
+    align = DefaultAlignment;
+
+  uint8_t* regionBase = AlignPointerUp(Base, DefaultAlignment);
+  uint8_t* p = AlignPointerUp(regionBase + Used + HeaderSize, align);
+
+  if ((p < regionBase) || ((size_t)((regionBase + Capacity) - p) < size)) // Also catches p > end.
+    return nullptr;
+
+  *reinterpret_cast<size_t*>(p - HeaderSize) = size;
+  Used = (size_t)((p + size) - regionBase);
+  if (Used > PeakUsed)
+    PeakUsed = Used;
+  LastAlloc = p;
+
+  return p;
+}
+
+bool FrameArena::ResizeInRegion(void* p, size_t newSize) {
+  size_t& size = *reinterpret_cast<size_t*>(((uint8_t*)p) - HeaderSize);
+
+  if (p == LastAlloc) // The most recent allocation can grow or shrink in place.
+  {
+    uint8_t* regionBase = AlignPointerUp(Base, DefaultAlignment);
+    if ((size_t)((regionBase + Capacity) - (uint8_t*)p) < newSize)
+      return false;
+
+    size = newSize;
+    Used = (size_t)((((uint8_t*)p) + newSize) - regionBase);
+    if (Used > PeakUsed)
+      PeakUsed = Used;
+    return true;
+  }
+
+  if (newSize <= size) // Any other allocation can shrink. The tail is reclaimed upon Reset.
+  {
+    size = newSize;
+    return true;
+  }
+
+  return false;
+}
+
+void FrameArena::FreeInRegion(void* p) {
+  if (p == LastAlloc) // Roll back the most recent allocation, which is the common LIFO case.
+  {
+    Used = (size_t)((((uint8_t*)p) - HeaderSize) - AlignPointerUp(Base, DefaultAlignment));
+    LastAlloc = nullptr;
+  }
+  // Else the memory is reclaimed upon Reset.
+}
+
+void* FrameArena::Alloc(size_t size) {
+  void* p = AllocFromRegion(size, DefaultAlignment);
+
+  if (!p) {
+    ++OverflowCount;
+    p = Allocator::GetInstance()->Alloc(size, "FrameArena");
+  }
+
+  return p;
+}
+
+void* FrameArena::AllocAligned(size_t size, size_t align) {
+  void* p = AllocFromRegion(size, align);
+
+  if (!p) {
+    ++OverflowCount;
+    p = Allocator::GetInstance()->AllocAligned(size, align, "FrameArena");
+  }
+
+  return p;
+}
+
+size_t FrameArena::GetAllocSize(const void* p) const {
+  if (Owns(p))
+    return *reinterpret_cast<const size_t*>(((const uint8_t*)p) - HeaderSize);
+
+  return Allocator::GetInstance()->GetAllocSize(p);
+}
+
+size_t FrameArena::GetAllocAlignedSize(const void* p, size_t align) const {
+  if (Owns(p))
+    return *reinterpret_cast<const size_t*>(((const uint8_t*)p) - HeaderSize);
+
+  return Allocator::GetInstance()->GetAllocAlignedSize(p, align);
+}
+
+void FrameArena::Free(void* p) {
+  if (Owns(p))
+    FreeInRegion(p);
+  else if (p)
+    Allocator::GetInstance()->Free(p);
+}
+
+void FrameArena::FreeAligned(void* p) {
+  if (Owns(p))
+    FreeInRegion(p);
+  else if (p)
+    Allocator::GetInstance()->FreeAligned(p);
+}
+
+void* FrameArena::Realloc(void* p, size_t newSize) {
+  if (!p)
+    return Alloc(newSize);
+
+  if (!Owns(p))
+    return Allocator::GetInstance()->Realloc(p, newSize);
+
+  if (newSize == 0) {
+    FreeInRegion(p);
+    return nullptr;
+  }
+
+  if (ResizeInRegion(p, newSize))
+    return p;
+
+  const size_t oldSize = GetAllocSize(p);
+  void* pNew = Alloc(newSize);
+
+  if (pNew) {
+    memcpy(pNew, p, (oldSize < newSize) ? oldSize : newSize);
+    FreeInRegion(p);
+  }
+
+  return pNew;
+}
+
+void* FrameArena::ReallocAligned(void* p, size_t newSize, size_t newAlign) {
+  if (!p)
+    return AllocAligned(newSize, newAlign);
+
+  if (!Owns(p))
+    return Allocator::GetInstance()->ReallocAligned(p, newSize, newAlign);
+
+  if (newSize == 0) {
+    FreeInRegion(p);
+    return nullptr;
+  }
+
+  if (((((size_t)p) & (newAlign - 1)) == 0) && ResizeInRegion(p, newSize))
+    return p;
+
+  const size_t oldSize = GetAllocSize(p);
+  void* pNew = AllocAligned(newSize, newAlign);
+
+  if (pNew) {
+    memcpy(pNew, p, (oldSize < newSize) ? oldSize : newSize);
+    FreeInRegion(p);
+  }
+
+  return pNew;
+}
+
+//------------------------------------------------------------------------
+// ***** Allocator debug commands
+//
+//------------------------------------------------------------------------
+
+// AllocatorTraceDbgCmd
+const char* allocatorTraceDbgCmdName = "Allocator.Trace";
+const char* allocatorTraceDbgCmdUsage = "<filepath> [filter specification]";
+const char* allocatorTraceDbgCmdDesc =
+    "Triggers the logging of the default allocator heap, with an optional filter.";
+const char* allocatorTraceDbgCmdDoc =
+    "Triggers the logging of the default allocator heap, with an optional filter.\n"
+    "The filter is a string which accepts a set of comparisons expressed in postfix (RPN).\n"
+    "Stack traces will be symbolized if the symbol files are present; otherwise they will be missing.\n"
+    "The ability to trace heaps can be enabled in release builds by setting the appropriate\n"
+    "registry key before starting OVRServer:\n"
+    "    HKEY_LOCAL_MACHINE\\SOFTWARE\\Oculus\\HeapTrackingEnabled, REG_DWORD of 0 or 1.\n"
+    "The enabling of the debug page heap can be enabled in release builds by setting:\n"
+    "    HKEY_LOCAL_MACHINE\\SOFTWARE\\Oculus\\DebugPageHeapEnabled, REG_DWORD of 0 or 1.\n"
+    "If tracking is not enabled but sampling is, the trace is of the sampled allocation sites,\n"
+    "with estimated live bytes per site. Sampling can be enabled in release builds by setting:\n"
+    "    HKEY_LOCAL_MACHINE\\SOFTWARE\\Oculus\\HeapSamplingEnabled, REG_DWORD of 0 or 1.\n"
+    "Allocation tracking and tracing will have more results if malloc tracking is enabled.\n"
+    "    HKEY_LOCAL_MACHINE\\SOFTWARE\\Oculus\\MallocRedirectEnabled, REG_DWORD of 0 or 1.\n"
+    "Use Allocator.ReportState to tell what the current settings are.\n"
+    "\n"
+    "Example usage:\n"
+    "    Allocator.Trace C:\\temp\\trace.txt                                   Trace the entire heap\n"
+    "    Allocator.Trace C:\\temp\\trace.txt \"size > 1024\"                   Trace only allocations > 1024 bytes\n"
+    "    Allocator.Trace C:\\temp\\trace.txt \"size > 1024; size < 2048; and\" Trace allocations between 1024 and 2048\n"
+    "    Allocator.Trace C:\\temp\\trace.txt \"time > -10s\"                   Trace allocations done in the last 10 seconds\n"
+    "    Allocator.Trace C:\\temp\\trace.txt \"time > 50000\"                  Trace allocations done in the first 50000 nanoseconds\n"
+    "    Allocator.Trace C:\\temp\\trace.txt \"tag == geometry\"              Trace only allocations tagged as geometry\n"
+    "    Allocator.Trace C:\\temp\\trace.txt \"ThreadName has vision\"         Trace only allocations from threads with \"vision\" in the name\n";
+int AllocatorTraceDbgCmd(const std::vector<std::string>& args, std::string* output) {
+  OVR_DISABLE_MSVC_WARNING(4996) // 4996: This function or variable may be unsafe.
+
+  OVR::Allocator* allocator = OVR::Allocator::GetInstance(false);
+  if (allocator) {
+    std::stringstream strStream;
+
+    if (!allocator->IsTrackingEnabled() && !allocator->IsSamplingEnabled()) {
+      output->append(
+          "Allocator tracking is not enabled. To enable, use the Allocator.EnableTracking command or set the DWORD HKEY_LOCAL_MACHINE\\SOFTWARE\\Oculus\\HeapTrackingEnabled reg key before starting the application.");
+      return -1; // Exit because even if tracking was enabled at some point earlier, all records
+      // would have been cleared with it was disabled.
+    }
+
+    if (args.size() < 2) {
+      output->append(
+          "Filepath first argument is required but was not supplied. See example usage.");
+      return -1;
+    }
+
+    std::string filePath = args[1];
+    FILE* file;
+    errno_t err = 0;
+
+#if defined(_WIN32)
+    err = fopen_s(&file, filePath.c_str(), "w");
+#else
+    file = fopen(filePath.c_str(), "w");
+    err = file ? 0 : -1;
+#endif
+
+    if (err || !file) {
+      strStream << "Failed to open " << filePath;
       *output = strStream.str();
       return -1;
     }
@@ -3614,8 +5743,13 @@ int AllocatorReportStateDbgCmd(const std::vector<std::string>&, std::string* out
 
   if (allocator) {
     bool trackingEnabled = allocator->IsTrackingEnabled();
+    bool samplingEnabled = allocator->IsSamplingEnabled();
+    size_t sampleIntervalBytes = allocator->GetSampleIntervalBytes();
     bool debugPageHeapEnabled = allocator->IsDebugPageHeapEnabled();
     bool osHeapEnabled = allocator->IsOSHeapEnabled();
+    bool poolHeapEnabled = allocator->IsPoolHeapEnabled();
+    bool largePageHeapEnabled = allocator->IsLargePageHeapEnabled();
+    bool numaHeapEnabled = allocator->IsNumaHeapEnabled();
     bool mallocRedirectEnabled = allocator->IsMallocRedirectEnabled();
     bool traceOnShutdownEnabled = allocator->IsAllocationTraceOnShutdownEnabled();
     uint64_t heapTimeNs = allocator->GetCurrentHeapTimeNs();
@@ -3627,8 +5761,13 @@ int AllocatorReportStateDbgCmd(const std::vector<std::string>&, std::string* out
     // briefly for other threads.
     for (const OVR::AllocMetadata* amd = allocator->IterateHeapBegin(); amd;
          amd = allocator->IterateHeapNext()) {
-      heapTrackedCount++;
-      heapTrackedVolume += amd->BlockSize;
+      if (trackingEnabled) {
+        heapTrackedCount++;
+        heapTrackedVolume += amd->BlockSize;
+      } else { // Else amd is a sampled allocation site, and the numbers are estimates.
+        heapTrackedCount += amd->Count;
+        heapTrackedVolume += amd->AllocSize;
+      }
     }
     allocator->IterateHeapEnd();
 #if defined(_DLL)
@@ -3646,10 +5785,32 @@ int AllocatorReportStateDbgCmd(const std::vector<std::string>&, std::string* out
     std::stringstream strStream;
 
     strStream << "Memory tracking: " << (trackingEnabled ? "enabled." : "disabled.") << std::endl;
+    strStream << "Memory sampling: " << (samplingEnabled ? "enabled" : "disabled")
+              << ", interval (bytes): " << sampleIntervalBytes << std::endl;
     strStream << "Underlying heap: "
-              << (debugPageHeapEnabled ? "debug page heap."
-                                       : (osHeapEnabled ? "os heap." : "malloc-based heap."))
+              << (debugPageHeapEnabled
+                      ? "debug page heap."
+                      : (poolHeapEnabled
+                             ? "pool heap."
+                             : (largePageHeapEnabled
+                                    ? "large page heap."
+                                    : (numaHeapEnabled
+                                           ? "NUMA heap."
+                                           : (osHeapEnabled ? "os heap." : "malloc-based heap.")))))
               << std::endl;
+    if (numaHeapEnabled && allocator->GetHeap()) {
+      const OVR::NumaHeap* numaHeap = static_cast<const OVR::NumaHeap*>(allocator->GetHeap());
+
+      for (size_t i = 0; i < numaHeap->GetNodeCount(); ++i) {
+        OVR::NumaHeap::NodeStats nodeStats;
+        numaHeap->GetNodeStats(i, nodeStats);
+        strStream << "NUMA node " << i << ": live bytes: " << nodeStats.LiveBytes
+                  << ", live count: " << nodeStats.LiveCount
+                  << ", peak bytes: " << nodeStats.PeakBytes
+                  << ", alloc count: " << nodeStats.AllocCount
+                  << ", remote frees: " << nodeStats.RemoteFreeCount << std::endl;
+      }
+    }
     strStream << "malloc redirection: " << (mallocRedirectEnabled ? "" : "not ") << "enabled."
               << std::endl;
     strStream << "Shutdown trace: " << (traceOnShutdownEnabled ? "" : "not ") << "enabled."
@@ -3657,9 +5818,12 @@ int AllocatorReportStateDbgCmd(const std::vector<std::string>&, std::string* out
     strStream << "Heap time (ns): " << heapTimeNs << std::endl;
     strStream << "Heap counter: " << heapCounter << std::endl;
     strStream << "Heap allocated count: " << heapTrackedCount << std::endl;
-    strStream << "Heap allocated volume: " << heapTrackedVolume << std::endl;
+    strStream << "Heap allocated volume: " << heapTrackedVolume
+              << ((!trackingEnabled && samplingEnabled) ? " (estimated from samples)" : "")
+              << std::endl;
     strStream << "CRT type: " << crtName << std::endl;
     strStream << "Build type: " << buildName << std::endl;
+    ReportThreadTags(allocator, strStream);
 
     std::string str = strStream.str();
     output->append(str.data(), str.length()); // We don't directly assign string objects because
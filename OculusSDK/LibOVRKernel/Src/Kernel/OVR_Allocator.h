@@ -41,6 +41,7 @@ OVR_DISABLE_ALL_MSVC_WARNINGS()
 #include <map>
 #include <exception>
 #include <new>
+#include <utility>
 #include <atomic>
 OVR_RESTORE_ALL_MSVC_WARNINGS()
 #if defined(_WIN32)
@@ -58,6 +59,21 @@ OVR_RESTORE_ALL_MSVC_WARNINGS()
 #pragma warning(disable : 4351) // new behavior: elements of array will be default initialized
 #endif
 
+//-----------------------------------------------------------------------------------
+// ***** OVR_ALLOCATOR_MINIMAL
+//
+// Defined as 0 or 1.
+// If enabled then the Allocator is built without allocation tracking, sampling, live statistics,
+// CRT malloc redirection and the debug page heap, and its Alloc/Free/Realloc functions become
+// inline forwarders to the Heap. Each allocation then costs a single virtual call, which is
+// intended for shipping builds. The Heap type is still selected at Init, so the pool heap and
+// large page heap remain available. This must be defined identically for LibOVRKernel and all
+// code which includes this header.
+//
+#ifndef OVR_ALLOCATOR_MINIMAL
+#define OVR_ALLOCATOR_MINIMAL 0
+#endif
+
 // Un-define new so that placement new works
 #undef new
 
@@ -184,6 +200,12 @@ OVR_FORCE_INLINE T* ConstructAlt(void* p, const S1& src1, const S2& src2) {
   return ::new (p) T(src1, src2);
 }
 
+// Constructs in place from any constructor's arguments, with no temporary to copy or move.
+template <class T, class... Args>
+OVR_FORCE_INLINE T* ConstructEmplace(void* p, Args&&... args) {
+  return ::new (p) T(std::forward<Args>(args)...);
+}
+
 // Note: These ConstructArray functions don't properly support the case of a C++ exception occurring
 // midway during construction, as they don't deconstruct the successfully constructed array elements
 // before returning.
@@ -369,6 +391,8 @@ class Heap {
 };
 
 class InterceptCRTMalloc;
+struct AllocSampleEvent;
+struct AllocSampleBuffer;
 
 //------------------------------------------------------------------------
 // ***** SysAllocatedPointerVector, etc.
@@ -381,6 +405,52 @@ typedef std::basic_string<char, std::char_traits<char>, StdAllocatorSysMem<char>
 typedef std::vector<SysAllocatedString, StdAllocatorSysMem<SysAllocatedString>>
     SysAllocatedStringVector;
 
+//-----------------------------------------------------------------------------------
+// ***** AllocBacktrace
+//
+// A call stack, shared by every tracked allocation made from it. See AllocBacktraceTable.
+//
+struct AllocBacktrace {
+  AllocBacktrace* Next; // Next within the table's hash bucket.
+  uint64_t Hash;
+  size_t FrameCount;
+  void* Frames[1]; // Actually FrameCount entries.
+};
+
+//-----------------------------------------------------------------------------------
+// ***** AllocBacktraceTable
+//
+// Hash-consed backtraces, so that identical call stacks are stored once and can be compared by
+// pointer. Entries live until Clear, which the Allocator calls only on shutdown, so they stay
+// valid in copies of AllocMetadata. Memory comes from SysMemAlloc.
+//
+class AllocBacktraceTable {
+  OVR_NON_COPYABLE(AllocBacktraceTable)
+
+ public:
+  AllocBacktraceTable();
+  ~AllocBacktraceTable();
+
+  // Returns the entry for the given frames, adding it if needed. Returns nullptr if frameCount is
+  // 0 or if memory is exhausted. Thread-safe.
+  const AllocBacktrace* Intern(void* const* frames, size_t frameCount);
+
+  // Returns the number of distinct backtraces.
+  size_t GetCount();
+
+  // Frees all the entries, which must no longer be referenced.
+  void Clear();
+
+ protected:
+  // Doubles the bucket count. TableLock must be held.
+  void Grow();
+
+  OVR::Lock TableLock;
+  AllocBacktrace** Buckets;
+  size_t BucketCount; // Power of two, or 0 before the first Intern.
+  size_t Count;
+};
+
 //-----------------------------------------------------------------------------------
 // ***** AllocMetadata
 //
@@ -388,7 +458,8 @@ typedef std::vector<SysAllocatedString, StdAllocatorSysMem<SysAllocatedString>>
 //
 struct AllocMetadata {
   const void* Alloc; // The allocation itself.
-  SysAllocatedPointerVector Backtrace; // Array of void*
+  const AllocBacktrace* Backtrace; // Shared with other allocations from the same call stack. May
+  // be nullptr.
   SysAllocatedStringVector BacktraceSymbols; // Array of string.
   const char* File; // __FILE__ of application allocation site.
   int Line; // __LINE__ of application allocation site.
@@ -404,10 +475,11 @@ struct AllocMetadata {
 
   AllocMetadata()
       : Alloc(nullptr),
-        Backtrace(),
+        Backtrace(nullptr),
         File(nullptr),
         Line(0),
         TimeNs(0),
+        Count(0),
         AllocSize(0),
         BlockSize(0),
         Tag(nullptr),
@@ -434,6 +506,50 @@ enum AllocMetadataFlags {
   AMFThreadName = 0x0800
 };
 
+//-----------------------------------------------------------------------------------
+// ***** AllocatorStats
+//
+// A copy of the Allocator's always-on heap counters, as returned by
+// Allocator::GetStatsSnapshot. The counters are relaxed atomics which are read individually, so a
+// snapshot taken during heavy allocation activity may be slightly inconsistent across entries.
+//
+// AllocBytes and AllocCount are always exact. Frees can only be attributed to a tag and size when
+// the Allocator knows the freed block's metadata, which is when tracking is enabled. Accordingly
+// the Live and Peak values are maintained only while tracking is enabled, and LiveValid tells if
+// that's the case. Tracking a few hundred bytes per allocation is a lot more than the counters
+// themselves cost, so if that's too expensive use EnableSampling for live estimates instead.
+//
+// If the Allocator uses a NumaHeap then Nodes has the heap's per-node counters, whose Live and
+// Peak values are always valid, as the heap knows the size of every block it frees.
+//
+struct AllocatorStatsEntry {
+  const char* Name; // Tag name. nullptr for the totals, size class and node entries.
+  uint64_t LiveBytes; // Bytes currently allocated.
+  uint64_t LiveCount; // Allocations currently live.
+  uint64_t PeakBytes; // High-water mark of LiveBytes.
+  uint64_t AllocBytes; // Cumulative bytes allocated.
+  uint64_t AllocCount; // Cumulative number of allocations.
+};
+
+struct AllocatorStats {
+  static const size_t MaxTagCount = 64; // The last tag slot collects all tags beyond the others.
+  static const size_t SizeClassCount = 32; // Class 0 is size 0, class i is [2^(i-1), 2^i).
+  // The last class also has all larger sizes.
+  static const size_t MaxNodeCount = 64; // Same as NumaHeap::MaxNodeCount.
+
+  uint64_t TimeNs; // Allocator::GetCurrentHeapTimeNs at the time of the snapshot.
+  bool LiveValid; // True if tracking is enabled and thus the Live and Peak values are meaningful.
+  AllocatorStatsEntry Total;
+  size_t TagCount; // Number of valid entries in Tags.
+  AllocatorStatsEntry Tags[MaxTagCount];
+  AllocatorStatsEntry SizeClasses[SizeClassCount];
+  size_t NodeCount; // Number of valid entries in Nodes. 0 unless a NumaHeap is used.
+  AllocatorStatsEntry Nodes[MaxNodeCount];
+
+  // Returns the size class index for an allocation size.
+  static size_t GetSizeClass(uint64_t size);
+};
+
 //-----------------------------------------------------------------------------------
 // ***** Allocator
 //
@@ -458,7 +574,13 @@ class Allocator {
   // Allocate memory of specified size with default alignment.
   // Alloc of size==0 will allocate a tiny block & return a valid pointer;
   // this makes it suitable for new operator.
+#if OVR_ALLOCATOR_MINIMAL
+  void* Alloc(size_t size, const char* /*tag*/) {
+    return Heap->Alloc(size);
+  }
+#else
   void* Alloc(size_t size, const char* tag);
+#endif
 
   // Allocate zero-initialized memory of specified count and size with default alignment.
   // Alloc of size==0 will allocate a tiny block & return a valid pointer;
@@ -467,17 +589,40 @@ class Allocator {
 
   // Allocate memory of specified alignment.
   // Memory allocated with AllocAligned MUST be freed with FreeAligned.
+#if OVR_ALLOCATOR_MINIMAL
+  void* AllocAligned(size_t size, size_t align, const char* /*tag*/) {
+    return Heap->AllocAligned(size, align);
+  }
+#else
   void* AllocAligned(size_t size, size_t align, const char* tag);
+#endif
 
   // Same as Alloc, but provides an option of passing file/line data.
+#if OVR_ALLOCATOR_MINIMAL
+  void* AllocDebug(size_t size, const char* /*tag*/, const char* /*file*/, unsigned /*line*/) {
+    return Heap->Alloc(size);
+  }
+#else
   void* AllocDebug(size_t size, const char* tag, const char* file, unsigned line);
+#endif
 
   // Same as Calloc, but provides an option of passing file/line data.
   void* CallocDebug(size_t count, size_t size, const char* tag, const char* file, unsigned line);
 
   // Same as Alloc, but provides an option of passing file/line data.
+#if OVR_ALLOCATOR_MINIMAL
+  void* AllocAlignedDebug(
+      size_t size,
+      size_t align,
+      const char* /*tag*/,
+      const char* /*file*/,
+      unsigned /*line*/) {
+    return Heap->AllocAligned(size, align);
+  }
+#else
   void*
   AllocAlignedDebug(size_t size, size_t align, const char* tag, const char* file, unsigned line);
+#endif
 
   // Returns the size of the allocation.
   size_t GetAllocSize(const void* p) const;
@@ -487,10 +632,24 @@ class Allocator {
 
   // Frees memory allocated by Alloc/Realloc.
   // Free of null pointer is valid and will do nothing.
+#if OVR_ALLOCATOR_MINIMAL
+  void Free(void* p) {
+    if (p)
+      Heap->Free(p);
+  }
+#else
   void Free(void* p);
+#endif
 
   // Frees memory allocated with AllocAligned.
+#if OVR_ALLOCATOR_MINIMAL
+  void FreeAligned(void* p) {
+    if (p)
+      Heap->FreeAligned(p);
+  }
+#else
   void FreeAligned(void* p);
+#endif
 
   // Reallocate memory block to a new size, copying data if necessary. Returns the pointer to
   // new memory block, which may be the same as original pointer. Will return 0 if reallocation
@@ -498,25 +657,54 @@ class Allocator {
   // Realloc to decrease size will never fail.
   // Realloc of pointer == NULL is equivalent to Alloc
   // Realloc to size == 0, shrinks to the minimal size, pointer remains valid and requires Free.
+#if OVR_ALLOCATOR_MINIMAL
+  void* Realloc(void* p, size_t newSize) {
+    return Heap->Realloc(p, newSize);
+  }
+#else
   void* Realloc(void* p, size_t newSize);
+#endif
 
   // Like realloc but also zero-initializes the newly added space.
   void* Recalloc(void* p, size_t count, size_t size);
 
   // Reallocates memory allocated with AllocAligned.
+#if OVR_ALLOCATOR_MINIMAL
+  void* ReallocAligned(void* p, size_t newSize, size_t newAlign) {
+    return Heap->ReallocAligned(p, newSize, newAlign);
+  }
+#else
   void* ReallocAligned(void* p, size_t newSize, size_t newAlign);
+#endif
 
   void* RecallocAligned(void* p, size_t count, size_t newSize, size_t newAlign);
 
   // Same as Realloc, but provides an option of passing file/line data.
+#if OVR_ALLOCATOR_MINIMAL
+  void* ReallocDebug(void* p, size_t newSize, const char* /*file*/, unsigned /*line*/) {
+    return Heap->Realloc(p, newSize);
+  }
+#else
   void* ReallocDebug(void* p, size_t newSize, const char* file, unsigned line);
+#endif
 
   // Like ReallocDebug but also zero-initializes the newly added space.
   void* RecallocDebug(void* p, size_t count, size_t newSize, const char* file, unsigned line);
 
   // Same as ReallocAligned, but provides an option of passing file/line data.
+#if OVR_ALLOCATOR_MINIMAL
+  void* ReallocAlignedDebug(
+      void* p,
+      size_t newSize,
+      size_t newAlign,
+      const char* /*file*/,
+      unsigned /*line*/) {
+    return Heap->ReallocAligned(p, newSize, newAlign);
+  }
+#else
   void*
   ReallocAlignedDebug(void* p, size_t newSize, size_t newAlign, const char* file, unsigned line);
+#endif
 
   void* RecallocAlignedDebug(
       void* p,
@@ -539,15 +727,39 @@ class Allocator {
   const char* GetAllocatorName() const;
 
   // If enabled then allocation tracking is done, which enables leak reports, double-free detection,
-  // etc. Must be called before the Init function.
+  // etc. Must be called before the Init function. Fails if OVR_ALLOCATOR_MINIMAL.
   bool EnableTracking(bool enable);
 
   bool IsTrackingEnabled() const {
     return TrackingEnabled;
   }
 
+  // If enabled then allocations are Poisson-sampled such that on average one in every
+  // sampleIntervalBytes allocated bytes results in a recorded sample, with the tag and backtrace
+  // of the allocation. This costs little enough to be left on in release builds, unlike tracking.
+  // Live samples are aggregated by tag and backtrace, and when tracking is disabled the heap
+  // iteration functions (and thus HeapIterationFilterRPN and the Allocator.Trace command) return
+  // one AllocMetadata per aggregate, in which:
+  //     AllocSize is the estimated number of live bytes allocated at the site.
+  //     BlockSize is the sum of the sizes of the sampled allocations themselves.
+  //     Count is the number of live samples.
+  //     All other fields describe the most recent sample.
+  // May be called before or after the Init function. Disabling discards all samples.
+  // Enabling fails if OVR_ALLOCATOR_MINIMAL.
+  bool EnableSampling(bool enable, size_t sampleIntervalBytes = DefaultSampleIntervalBytes);
+
+  bool IsSamplingEnabled() const {
+    return SamplingEnabled;
+  }
+
+  size_t GetSampleIntervalBytes() const {
+    return SampleIntervalBytes;
+  }
+
+  static const size_t DefaultSampleIntervalBytes = 512 * 1024;
+
   // If enabled then the debug page is used.
-  // Must be called before the Init function.
+  // Must be called before the Init function. Enabling fails if OVR_ALLOCATOR_MINIMAL.
   bool EnableDebugPageHeap(bool enable);
 
   bool IsDebugPageHeapEnabled() const {
@@ -558,6 +770,30 @@ class Allocator {
     return OSHeapEnabled;
   }
 
+  // If enabled then the PoolHeap is used, unless the debug page heap is also enabled.
+  // Must be called before the Init function.
+  bool EnablePoolHeap(bool enable);
+
+  bool IsPoolHeapEnabled() const {
+    return PoolHeapEnabled;
+  }
+
+  // If enabled then the LargePageHeap is used, unless the debug page heap or pool heap is also
+  // enabled. Must be called before the Init function.
+  bool EnableLargePageHeap(bool enable);
+
+  bool IsLargePageHeapEnabled() const {
+    return LargePageHeapEnabled;
+  }
+
+  // If enabled then the NumaHeap is used, unless the debug page heap, pool heap or large page
+  // heap is also enabled. Must be called before the Init function.
+  bool EnableNumaHeap(bool enable);
+
+  bool IsNumaHeapEnabled() const {
+    return NumaHeapEnabled;
+  }
+
   // If enabled then a debug trace of existing allocations occurs on destruction of this Allocator.
   bool EnableAllocationTraceOnShutdown(bool enable) {
     TraceAllocationsOnShutdown = enable;
@@ -568,6 +804,8 @@ class Allocator {
     return TraceAllocationsOnShutdown;
   }
 
+  // Redirects the CRT malloc family of functions to this Allocator. Must be called before the Init
+  // function. Fails if OVR_ALLOCATOR_MINIMAL.
   bool EnableMallocRedirect();
 
   bool IsMallocRedirectEnabled() const {
@@ -576,7 +814,19 @@ class Allocator {
 
   static bool IsHeapTrackingRegKeyEnabled(bool defaultValue);
 
-  // IterateHeapBegin succeeds only if tracking is enabled.
+  static bool IsHeapSamplingRegKeyEnabled(bool defaultValue);
+
+  // Copies the current heap statistics into stats, without locking. This is cheap enough to call
+  // every frame.
+  void GetStatsSnapshot(AllocatorStats& stats) const;
+
+  // Writes the current heap statistics to the Kernel:Allocator ovrlog channel at the Info level,
+  // with one line per tag and optionally one line per non-empty size class. The lines are of the
+  // form "Heap tag=<name> live=<bytes> count=<n> peak=<bytes> allocs=<n> allocBytes=<bytes>", so
+  // they are easy to extract and graph if this is called periodically (e.g. once per second).
+  void LogStats(bool includeSizeClasses = false) const;
+
+  // IterateHeapBegin succeeds only if tracking or sampling is enabled. See EnableSampling.
   // Once IterateHeapBegin is called, the heap is thread-locked until IterateHeapEnd is called.
   // If the heap has no allocations, IterateHeapBegin returns nullptr.
   // You must always call IterateHeapEnd if you call IterateHeapBegin, regardless of the return
@@ -665,11 +915,59 @@ class Allocator {
   // Returns a copy of the AllocMetadata.
   bool GetAllocMetadata(const void* p, AllocMetadata& metadata);
 
+  // Counters for AllocatorStats.
+  struct StatCounters {
+    std::atomic<uint64_t> LiveBytes;
+    std::atomic<uint64_t> LiveCount;
+    std::atomic<uint64_t> PeakBytes;
+    std::atomic<uint64_t> AllocBytes;
+    std::atomic<uint64_t> AllocCount;
+
+    void Clear();
+    void CountAlloc(uint64_t size, bool live);
+    void CountFree(uint64_t size);
+    void Copy(AllocatorStatsEntry& entry) const;
+  };
+
+  // Updates the AllocatorStats counters for an allocation. tag may be nullptr.
+  void CountAlloc(uint64_t size, const char* tag);
+
+  // Updates the AllocatorStats counters for the free of a tracked allocation.
+  void CountFree(uint64_t size, const char* tag);
+
+  // Returns the TagStats entry for the given tag, claiming a free entry if needed.
+  StatCounters& GetTagStats(const char* tag);
+
+  // Counts the allocation toward the next sample and records it if it's selected.
+  void SampleAlloc(const void* p, size_t size, const char* tag, const char* file, int line);
+
+  // Records the free if p may be a sampled allocation.
+  void SampleFree(const void* p);
+
+  // Gets the calling thread's sample buffer, registering a new one if needed. Returns nullptr if
+  // the thread's buffer belongs to another Allocator.
+  AllocSampleBuffer* GetSampleBuffer();
+
+  // Records an event in the calling thread's sample buffer, or applies it directly if there is
+  // no such buffer.
+  void RecordSampleEvent(const AllocSampleEvent& event);
+
+  // Applies the pending events of all threads' sample buffers, in order. SampleLock must be held.
+  void DrainSampleBuffers();
+
+  // Updates SampledAllocs and SampledSites for a single event. SampleLock must be held.
+  void ApplySampleEvent(const AllocSampleEvent& event);
+
+  // Discards all samples and pending events. SampleLock must be held.
+  void ClearSamples();
+
  public:
   // Tag push/pop API
 
   // Every PushTag must be matched by a PopTag. It's easiest to do this via the AllocatorTagScope
-  // utility class.
+  // utility class. Tag stacks are thread_local and lock-free, so tagging is cheap enough to leave
+  // enabled in release builds. Up to 32 nested tags are recorded per thread; deeper tags are
+  // counted but otherwise ignored. tag must remain valid for as long as it's in use.
   void PushTag(const char* tag);
 
   // Matches a PushTag.
@@ -679,11 +977,6 @@ class Allocator {
   // Returns a default string if there is no current tag set for the current thread.
   const char* GetTag(const char* defaultTag = nullptr);
 
- protected:
-  // This is called periodically to purge the map of elements that correspond to threads that no
-  // longer exist.
-  void PurgeTagMap();
-
  protected:
 // Tracked allocations
 #if defined(OVR_BUILD_DEBUG)
@@ -704,24 +997,25 @@ class Allocator {
       TrackedAllocMap;
 #endif
 
-  // Per-thread tag stack
-  typedef std::vector<const char*, StdAllocatorSysMem<const char*>> ConstCharVector;
-#if defined(OVR_BUILD_DEBUG)
-  typedef std::map<
-      AllocatorThreadId,
-      ConstCharVector,
-      std::less<AllocatorThreadId>,
-      StdAllocatorSysMem<std::pair<const AllocatorThreadId, ConstCharVector>>>
-      ThreadIdToTagVectorMap;
-#else
+  // Sampled allocations and the aggregates they contribute to.
+  struct SampledAlloc {
+    uint64_t SiteKey; // Key within SampledSites.
+    uint64_t Weight; // Estimated bytes represented by this sample.
+    uint64_t Size; // Size of the sampled allocation itself.
+  };
   typedef std::unordered_map<
-      AllocatorThreadId,
-      ConstCharVector,
-      std::hash<AllocatorThreadId>,
-      std::equal_to<AllocatorThreadId>,
-      StdAllocatorSysMem<std::pair<const AllocatorThreadId, ConstCharVector>>>
-      ThreadIdToTagVectorMap;
-#endif
+      const void*,
+      SampledAlloc,
+      std::hash<const void*>,
+      std::equal_to<const void*>,
+      StdAllocatorSysMem<std::pair<const void* const, SampledAlloc>>>
+      SampledAllocMap;
+  typedef std::map<
+      uint64_t,
+      AllocMetadata,
+      std::less<uint64_t>,
+      StdAllocatorSysMem<std::pair<const uint64_t, AllocMetadata>>>
+      SampledSiteMap;
 
   char AllocatorName[64]; // The name of this allocator. Useful because we could have multiple
   // instances within a process.
@@ -729,6 +1023,10 @@ class Allocator {
   bool DebugPageHeapEnabled; // If enabled then we use our DebugPageHeap instead of DefaultHeap or
   // OSheap.
   bool OSHeapEnabled; // If enabled then we use our OSHeap instead of DebugPageHeap or DefaultHeap.
+  bool PoolHeapEnabled; // If enabled then we use our PoolHeap instead of OSHeap or DefaultHeap.
+  bool LargePageHeapEnabled; // If enabled then we use our LargePageHeap instead of OSHeap or
+  // DefaultHeap.
+  bool NumaHeapEnabled; // If enabled then we use our NumaHeap instead of OSHeap or DefaultHeap.
   bool MallocRedirectEnabled; // If enabled then we redirect CRT malloc to ourself (only if we are
   // the default global allocator).
   InterceptCRTMalloc* MallocRedirect; //
@@ -739,14 +1037,28 @@ class Allocator {
   TrackedAllocMap::const_iterator
       TrackIterator; // Valid only between IterateHeapBegin and IterateHeapEnd.
   TrackedAllocMap AllocationMap; //
+  AllocBacktraceTable Backtraces; // Interned backtraces of AllocationMap and SampledSites.
   SysAllocatedPointerVector DelayedFreeList; // Used when we are overriding CRT malloc and need to
   // call CRT free on some pointers after we've restored
   // it.
   SysAllocatedPointerVector DelayedAlignedFreeList; // "
   std::atomic_ullong CurrentCounter; // Ever-increasing count of allocation requests.
   bool SymbolLookupEnabled; //
-  ThreadIdToTagVectorMap TagMap; //
-  OVR::Lock TagMapLock; // Thread-exclusive access to TagMap.
+  bool SamplingEnabled; // To consider: Make SamplingEnabled an atomic.
+  size_t SampleIntervalBytes; // Mean number of allocated bytes between samples.
+  AllocSampleBuffer* SampleBufferList; // Registered per-thread buffers. See SampleRegistryLock.
+  OVR::Lock SampleLock; // Thread-exclusive access to SampledAllocs and SampledSites.
+  SampledAllocMap SampledAllocs; // Live sampled allocations.
+  SampledSiteMap SampledSites; // Live samples aggregated by tag and backtrace.
+  SampledSiteMap::const_iterator SampleIterator; // Valid only while IteratingSamples.
+  bool IteratingSamples; // True between IterateHeapBegin and IterateHeapEnd if iterating samples.
+  StatCounters TotalStats; // AllocatorStats counters.
+  StatCounters TagStats[AllocatorStats::MaxTagCount];
+  std::atomic<const char*> TagStatsNames[AllocatorStats::MaxTagCount]; // nullptr if unclaimed.
+  StatCounters SizeClassStats[AllocatorStats::SizeClassCount];
+  static const size_t SampleFilterSize = 16384;
+  std::atomic<uint8_t> SampleFilter[SampleFilterSize]; // Saturating count of live samples per
+  // pointer hash, so that SampleFree can skip nearly all frees without a lock.
   static Allocator* DefaultAllocator; // Default instance.
   static uint64_t ReferenceHeapTimeNs; // The time that GetCurrentHeapTimeNs reports relative to. In
   // practice this is the time of application startup.
@@ -937,6 +1249,91 @@ class OSHeap : public Heap {
 #endif
 };
 
+//------------------------------------------------------------------------
+// ***** LargePageHeap
+//
+// An OSHeap which serves allocations of LargeAllocThreshold bytes or more, such as texture
+// and staging buffers, directly from virtual memory. That memory is backed by large pages where
+// the OS allows it, which reduces TLB pressure and the number of page faults when the memory is
+// first touched. On Windows large pages require the user to have the "Lock pages in memory"
+// privilege (SeLockMemoryPrivilege), and without it we fall back to regular pages. On Linux we
+// try MAP_HUGETLB and fall back to transparent huge page hints.
+//
+// Freed large blocks are kept in a recycle pool of up to MaxRecycledBytes, so that repeated
+// asset loads reuse already committed pages. A request reuses the smallest recycled block which
+// is at least as large and not wastefully larger.
+//
+// Large blocks are page-aligned, and so AllocAligned requests for up to page alignment are
+// served from large blocks as well. Smaller requests are handled by OSHeap.
+//
+class LargePageHeap : public OSHeap {
+ public:
+  LargePageHeap();
+  ~LargePageHeap();
+
+  virtual bool Init();
+  virtual void Shutdown();
+
+  virtual void* Alloc(size_t size);
+  virtual void* AllocAligned(size_t size, size_t align);
+  virtual size_t GetAllocSize(const void* p) const;
+  virtual size_t GetAllocAlignedSize(const void* p, size_t align) const;
+  virtual void Free(void* p);
+  virtual void FreeAligned(void* p);
+  virtual void* Realloc(void* p, size_t newSize);
+  virtual void* ReallocAligned(void* p, size_t newSize, size_t newAlign);
+
+  // Returns true if large pages are available, as opposed to only regular pages.
+  bool IsUsingLargePages() const {
+    return (LargePageSize != 0);
+  }
+
+  static const size_t LargeAllocThreshold = 1024 * 1024;
+  static const size_t MaxRecycledBytes = 256 * 1024 * 1024;
+
+ protected:
+  struct LargeBlock {
+    size_t Size; // Size the user requested.
+    size_t Capacity; // Size of the mapping.
+    bool LargePages; // True if the mapping uses large pages.
+  };
+
+  typedef std::map<
+      const void*,
+      LargeBlock,
+      std::less<const void*>,
+      StdAllocatorSysMem<std::pair<const void* const, LargeBlock>>>
+      LargeBlockMap;
+
+  typedef std::multimap<
+      size_t,
+      std::pair<void*, bool>,
+      std::less<size_t>,
+      StdAllocatorSysMem<std::pair<const size_t, std::pair<void*, bool>>>>
+      RecycledBlockMap; // Capacity -> (mapping, LargePages).
+
+  void* AllocLarge(size_t size);
+  bool FindLarge(const void* p, LargeBlock& block) const; // Returns false if p isn't ours.
+  bool FreeLarge(void* p); // Returns false if p isn't ours.
+  void* ReallocLarge(void* p, const LargeBlock& block, size_t newSize);
+  void* MapPages(size_t& capacity, bool& largePages); // May round capacity up.
+  void UnmapPages(void* p, size_t capacity, bool largePages);
+
+  static bool IsPageAligned(const void* p) {
+    return ((((uintptr_t)p) & (RegularPageSize - 1)) == 0);
+  }
+
+  static const size_t RegularPageSize = 4096;
+
+  size_t LargePageSize; // 0 if large pages are unavailable.
+  size_t MappingGranularity; // Capacity granularity of regular page mappings.
+  mutable OVR::Lock BlockLock; // Protects everything below.
+  LargeBlockMap Blocks; // Live large blocks.
+  RecycledBlockMap Recycled; // Freed large blocks available for reuse.
+  size_t RecycledBytes; // Sum of the capacities in Recycled.
+  std::atomic<size_t> BlockCount; // Number of Blocks, readable without BlockLock.
+};
+
 //------------------------------------------------------------------------
 // ***** DebugPageHeap
 //
@@ -1129,6 +1526,334 @@ class DebugPageHeap : public Heap {
   void FreePageMemory(void* pPageMemory, size_t blockSize);
 };
 
+//------------------------------------------------------------------------
+// ***** PoolHeap
+//
+// Implements a size-class pool heap which avoids contention between threads that make many
+// small allocations (e.g. Ptr<> managed JSON nodes, Fills and Buffers).
+//
+// Technical design:
+//   Requests of up to MaxPooledSize bytes are rounded up to one of SizeClassCount size classes.
+//       Blocks of a given class are carved out of ChunkSize byte chunks obtained via SysMemAlloc.
+//       Chunks are returned to the system only upon Shutdown.
+//   Each thread has a cache of free blocks per size class, found through a thread_local slot.
+//       Alloc and Free are satisfied from this cache without taking any lock.
+//   A block can be freed by a thread other than the one which allocated it, in which case it
+//       goes into the freeing thread's cache. When a thread's cache for a class grows beyond
+//       MaxCachedBlocks, TransferBatchSize blocks are handed off to a global per-class depot.
+//       A thread whose cache is empty refills from the depot before carving new blocks. This
+//       is what lets producer/consumer thread pairs recycle memory instead of growing it.
+//   When a thread exits, its cache is flushed to the depot and recycled for use by a new thread.
+//   Larger requests, and alignments beyond DefaultAlignment, bypass the pools and go directly
+//       to SysMemAlloc.
+//   Every block is preceded by a HeaderSize byte header holding its size class and size, so
+//       Free and GetAllocSize need no lookup.
+//   This class itself allocates no memory other than via SysMemAlloc, so it can be installed
+//       while CRT malloc is redirected to the Allocator.
+//   Only the first PoolHeap to be initialized uses the per-thread caches. Any further instance
+//       works correctly but serves every request from its depot under its lock.
+//
+// Allocation inteface:
+//   Same as DefaultHeap. All returned allocations are aligned to at least DefaultAlignment.
+//   GetAllocSize returns the usable size of the block, which may exceed the requested size.
+//
+
+struct PoolHeapThreadSlot;
+
+class PoolHeap : public Heap {
+ public:
+  PoolHeap();
+  virtual ~PoolHeap();
+
+  bool Init();
+  void Shutdown();
+
+  void* Alloc(size_t size);
+  void* AllocAligned(size_t size, size_t align);
+  size_t GetAllocSize(const void* p) const;
+  size_t GetAllocAlignedSize(const void* p, size_t /*align*/) const {
+    return GetAllocSize(p);
+  }
+  void Free(void* p);
+  void FreeAligned(void* p) {
+    Free(p);
+  }
+  void* Realloc(void* p, size_t newSize);
+  void* ReallocAligned(void* p, size_t newSize, size_t newAlign);
+
+  static const size_t DefaultAlignment = 16;
+  static const size_t HeaderSize = 16; // Must be a multiple of DefaultAlignment.
+  static const size_t SizeClassCount = 20;
+  static const size_t MaxPooledSize = 1024; // Larger requests go to SysMemAlloc.
+  static const size_t ChunkSize = 65536;
+  static const uint32_t MaxCachedBlocks = 64; // Per thread per class, before handing off.
+  static const uint32_t TransferBatchSize = 32; // Blocks moved per depot refill or handoff.
+
+ protected:
+  friend struct PoolHeapThreadSlot;
+
+  struct FreeBlock {
+    FreeBlock* Next;
+  };
+
+  struct BlockHeader {
+    uint32_t SizeClass; // Index into ClassSize, or LargeClass.
+    uint32_t Offset; // Bytes from the start of the underlying memory to the user pointer.
+    size_t Size; // Bytes of underlying memory, including the header and any alignment gap.
+  };
+
+  struct ThreadCache {
+    FreeBlock* FreeList[SizeClassCount];
+    uint32_t FreeCount[SizeClassCount];
+    ThreadCache* Next; // Link within CacheList.
+    bool InUse; // False if the owning thread has exited and this cache can be handed out again.
+  };
+
+  static const uint32_t LargeClass = 0xffffffff;
+  static const uint32_t ClassSize[SizeClassCount];
+
+  static BlockHeader* GetHeader(const void* p) {
+    return reinterpret_cast<BlockHeader*>(((uint8_t*)const_cast<void*>(p)) - HeaderSize);
+  }
+
+  ThreadCache* GetThreadCache();
+  ThreadCache* AcquireThreadCache();
+  void ReleaseThreadCache(ThreadCache* cache);
+  FreeBlock* Refill(ThreadCache* cache, uint32_t sizeClass);
+  void Handoff(ThreadCache* cache, uint32_t sizeClass, uint32_t count);
+  FreeBlock* CarveBlock(uint32_t sizeClass); // Lock must be held.
+  void* AllocLarge(size_t size, size_t align);
+
+  uint8_t SizeClassTable[(MaxPooledSize / DefaultAlignment) + 1]; // Maps (size + 15) / 16 to a
+  // size class.
+  OVR::Lock Lock; // Protects everything below.
+  FreeBlock* DepotList[SizeClassCount]; // Blocks handed off by threads, per size class.
+  uint32_t DepotCount[SizeClassCount];
+  ThreadCache* CacheList; // All ThreadCaches created by this heap, whether in use or not.
+  void* ChunkList; // Singly linked via the first pointer of each chunk.
+  uint8_t* ChunkCurrent; // Next unused byte within the newest chunk.
+  uint8_t* ChunkEnd;
+  uint32_t Serial; // Distinguishes this instance from a prior one at the same address.
+
+  static std::atomic<PoolHeap*> ActiveHeap; // The instance that owns the thread_local caches.
+  static std::atomic<uint32_t> NextSerial;
+};
+
+//------------------------------------------------------------------------
+// ***** NumaHeap
+//
+// Keeps a separate arena per NUMA node and serves each allocation from the arena of the node
+// the calling thread is running on, so that memory allocated and consumed by threads of one node
+// stays in that node's local memory. Freed memory always returns to the arena it came from, even
+// when freed by a thread of another node; such frees are counted as remote frees, which makes
+// cross-node traffic visible. Statistics are kept per node and are always live, independent of
+// Allocator tracking.
+//
+// With Windows each arena is a private OS heap, whose pages are committed by the node's own
+// threads and thus come from its local memory, and blocks of LargeBlockSize or more are placed on
+// the node explicitly via VirtualAllocExNuma. Threads re-check their node every
+// NodeRefreshInterval heap operations, as they may migrate. With other platforms there is a
+// single node, backed by malloc.
+//
+class NumaHeap : public Heap {
+ public:
+  NumaHeap();
+  virtual ~NumaHeap();
+
+  virtual bool Init();
+  virtual void Shutdown();
+
+  virtual void* Alloc(size_t size);
+  virtual void* AllocAligned(size_t size, size_t align);
+  virtual size_t GetAllocSize(const void* p) const;
+  virtual size_t GetAllocAlignedSize(const void* p, size_t /*align*/) const {
+    return GetAllocSize(p);
+  }
+  virtual void Free(void* p);
+  virtual void FreeAligned(void* p) {
+    Free(p);
+  }
+  virtual void* Realloc(void* p, size_t newSize);
+  virtual void* ReallocAligned(void* p, size_t newSize, size_t newAlign);
+
+  struct NodeStats {
+    uint64_t LiveBytes; // Bytes currently allocated from the node.
+    uint64_t LiveCount; // Allocations currently live in the node.
+    uint64_t PeakBytes; // High-water mark of LiveBytes.
+    uint64_t AllocBytes; // Cumulative bytes allocated from the node.
+    uint64_t AllocCount; // Cumulative number of allocations from the node.
+    uint64_t RemoteFreeCount; // Frees of the node's memory by threads of other nodes.
+  };
+
+  // Returns the number of nodes, which is at least 1 after Init.
+  size_t GetNodeCount() const {
+    return NodeCount;
+  }
+
+  // Returns the node whose arena serves the calling thread's allocations.
+  uint32_t GetCurrentNode() const;
+
+  void GetNodeStats(size_t node, NodeStats& stats) const;
+
+  static const size_t MaxNodeCount = 64;
+  static const size_t DefaultAlignment = 16;
+  static const size_t HeaderSize = 16; // Must be a multiple of DefaultAlignment.
+  static const size_t LargeBlockSize = 1024 * 1024;
+  static const uint32_t NodeRefreshInterval = 256;
+
+ protected:
+  struct BlockHeader {
+    uint16_t Node; // Index of the arena the block came from.
+    uint16_t Large; // 1 if the block was allocated directly from virtual memory.
+    uint32_t Offset; // Bytes from the start of the underlying memory to the user pointer.
+    size_t Size; // Size the user requested.
+  };
+
+  struct Arena {
+    void* OSHeap; // HANDLE of the arena's private heap with Windows, else unused.
+    std::atomic<uint64_t> LiveBytes;
+    std::atomic<uint64_t> LiveCount;
+    std::atomic<uint64_t> PeakBytes;
+    std::atomic<uint64_t> AllocBytes;
+    std::atomic<uint64_t> AllocCount;
+    std::atomic<uint64_t> RemoteFreeCount;
+    char Padding[64]; // Keeps the counters of different arenas in different cache lines.
+  };
+
+  static BlockHeader* GetHeader(const void* p) {
+    return reinterpret_cast<BlockHeader*>(((uint8_t*)const_cast<void*>(p)) - HeaderSize);
+  }
+
+  void* AllocFromNode(uint32_t node, size_t size, size_t align);
+  void FreeToNode(void* base, const BlockHeader& header);
+
+  size_t NodeCount;
+  Arena Arenas[MaxNodeCount];
+};
+
+//------------------------------------------------------------------------
+// ***** FrameArena
+//
+// Implements a linear (bump pointer) heap for transient data that lives no longer than a frame,
+// such as HUD strings and temporary vertex or layer arrays.
+//
+// Alloc advances a pointer within a single region of Capacity bytes, reserved at Init via
+// SysMemAlloc. Free is a no-op except for the most recent allocation, which is rolled back.
+// All memory is reclaimed at once by Reset, or by the destruction of a FrameArena::Scope.
+// Requests which don't fit in the remaining space are passed to the default Allocator and are
+// counted by GetOverflowCount, so a Capacity that's too small shows up as a nonzero count and
+// not as a failure.
+//
+// This class is not thread-safe. It's intended to be owned and used by a single thread, e.g. the
+// render thread.
+//
+// Example usage:
+//    FrameArena FrameMemory(1024 * 1024);
+//    FrameMemory.Init();
+//
+//    void App::OnIdle() {
+//      FrameArena::Scope frameScope(&FrameMemory); // Everything below is freed upon return.
+//      FrameArrayPOD<Vertex> vertices;              // Draws from FrameMemory.
+//      ...
+//    }
+//
+
+class FrameArena : public Heap {
+ public:
+  FrameArena(size_t capacity = DefaultCapacity);
+  virtual ~FrameArena();
+
+  bool Init();
+  void Shutdown();
+
+  void* Alloc(size_t size);
+  void* AllocAligned(size_t size, size_t align);
+  size_t GetAllocSize(const void* p) const;
+  size_t GetAllocAlignedSize(const void* p, size_t align) const;
+  void Free(void* p);
+  void FreeAligned(void* p);
+  void* Realloc(void* p, size_t newSize);
+  void* ReallocAligned(void* p, size_t newSize, size_t newAlign);
+
+  // Returns true if p was allocated from our region, as opposed to being an overflow allocation.
+  bool Owns(const void* p) const {
+    const uint8_t* p8 = static_cast<const uint8_t*>(p);
+    return Base && (p8 >= Base) && (p8 < (Base + Capacity + DefaultAlignment));
+  }
+
+  // Invalidates every allocation made from the region. Overflow allocations are unaffected and
+  // must still be freed individually.
+  void Reset() {
+    Used = 0;
+    LastAlloc = nullptr;
+  }
+
+  size_t GetCapacity() const {
+    return Capacity;
+  }
+  size_t GetUsedSize() const {
+    return Used;
+  }
+  size_t GetPeakUsedSize() const {
+    return PeakUsed;
+  }
+  size_t GetOverflowCount() const {
+    return OverflowCount;
+  }
+
+  // Returns the FrameArena that's current for the calling thread, or nullptr if none.
+  static FrameArena* GetCurrent() {
+    return Current;
+  }
+
+  // Makes an arena current for the calling thread. Upon destruction, the arena is rolled back to
+  // the state it had upon construction and the previously current arena is restored. Scopes can
+  // be nested.
+  class Scope {
+   public:
+    Scope(FrameArena* arena)
+        : Arena(arena),
+          Previous(FrameArena::Current),
+          Mark(arena->Used),
+          MarkLastAlloc(arena->LastAlloc) {
+      FrameArena::Current = arena;
+    }
+
+    ~Scope() {
+      Arena->Used = Mark;
+      Arena->LastAlloc = MarkLastAlloc;
+      FrameArena::Current = Previous;
+    }
+
+   protected:
+    FrameArena* Arena;
+    FrameArena* Previous;
+    size_t Mark;
+    uint8_t* MarkLastAlloc;
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+  static const size_t DefaultCapacity = 1024 * 1024;
+  static const size_t DefaultAlignment = 16;
+  static const size_t HeaderSize = 16; // Holds the allocation size. Multiple of DefaultAlignment.
+
+ protected:
+  uint8_t* AllocFromRegion(size_t size, size_t align);
+  bool ResizeInRegion(void* p, size_t newSize);
+  void FreeInRegion(void* p);
+
+  uint8_t* Base; // The start of the region.
+  size_t Capacity; // Size of the region in bytes.
+  size_t Used; // Bytes used from the start of the region.
+  size_t PeakUsed; // High-water mark of Used since Init.
+  size_t OverflowCount; // Number of allocations which didn't fit and went to the default heap.
+  uint8_t* LastAlloc; // The most recent allocation, which can be freed or resized in place.
+
+  static thread_local FrameArena* Current;
+};
+
 ///------------------------------------------------------------------------
 /// ***** AllocatorTagScope
 ///
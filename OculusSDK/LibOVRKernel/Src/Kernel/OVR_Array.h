@@ -28,6 +28,8 @@ limitations under the License.
 #define OVR_Array_h
 
 #include "OVR_ContainerAllocator.h"
+#include <type_traits>
+#include <utility>
 
 namespace OVR {
 
@@ -51,6 +53,10 @@ struct ArrayDefaultPolicy {
   bool NeverShrinking() const {
     return 1;
   }
+  // The capacity to reserve when the array grows to newSize.
+  size_t GetGrowthCapacity(size_t newSize) const {
+    return newSize + (newSize >> 2);
+  }
 
   size_t GetCapacity() const {
     return Capacity;
@@ -84,6 +90,47 @@ struct ArrayConstPolicy {
   bool NeverShrinking() const {
     return NeverShrink;
   }
+  // The capacity to reserve when the array grows to newSize.
+  size_t GetGrowthCapacity(size_t newSize) const {
+    return newSize + (newSize >> 2);
+  }
+
+  size_t GetCapacity() const {
+    return Capacity;
+  }
+  void SetCapacity(size_t capacity) {
+    Capacity = capacity;
+  }
+
+ private:
+  size_t Capacity;
+};
+
+//-----------------------------------------------------------------------------------
+// ***** ArrayGeometricPolicy
+//
+// Grows the capacity by GrowthPercent of the size needed (e.g. 100 doubles it), and never
+// shrinks by default, so an array that's appended to often reallocates only O(log n) times.
+// Suits arrays built up element by element, such as vertices or parsed JSON arrays.
+template <int MinCapacity = 8, int GrowthPercent = 50, bool NeverShrink = true>
+struct ArrayGeometricPolicy {
+  typedef ArrayGeometricPolicy<MinCapacity, GrowthPercent, NeverShrink> SelfType;
+
+  ArrayGeometricPolicy() : Capacity(0) {}
+  ArrayGeometricPolicy(const SelfType&) : Capacity(0) {}
+
+  size_t GetMinCapacity() const {
+    return MinCapacity;
+  }
+  size_t GetGranularity() const {
+    return 1;
+  }
+  bool NeverShrinking() const {
+    return NeverShrink;
+  }
+  size_t GetGrowthCapacity(size_t newSize) const {
+    return newSize + newSize * GrowthPercent / 100;
+  }
 
   size_t GetCapacity() const {
     return Capacity;
@@ -157,10 +204,7 @@ struct ArrayDataBase {
           T* newData = (T*)Allocator::Alloc(sizeof(T) * newCapacity);
           size_t i, s;
           s = (Size < newCapacity) ? Size : newCapacity;
-          for (i = 0; i < s; ++i) {
-            Allocator::Construct(&newData[i], Data[i]);
-            Allocator::Destruct(&Data[i]);
-          }
+          Allocator::Relocate(newData, Data, s);
           for (i = s; i < Size; ++i) {
             Allocator::Destruct(&Data[i]);
           }
@@ -188,7 +232,7 @@ struct ArrayDataBase {
         Reserve(newSize);
       }
     } else if (newSize >= Policy.GetCapacity()) {
-      Reserve(newSize + (newSize >> 2));
+      Reserve(Policy.GetGrowthCapacity(newSize));
     }
     //! IMPORTANT to modify Size only after Reserve completes, because garbage collectable
     // array may use this array and may traverse it during Reserve (in the case, if
@@ -243,6 +287,14 @@ struct ArrayData : ArrayDataBase<T, Allocator, SizePolicy> {
     Allocator::ConstructAlt(this->Data + this->Size - 1, val);
   }
 
+  template <class... Args>
+  ValueType& EmplaceBack(Args&&... args) {
+    BaseType::ResizeNoConstruct(this->Size + 1);
+    ValueType* p = this->Data + this->Size - 1;
+    Allocator::ConstructEmplace(p, std::forward<Args>(args)...);
+    return *p;
+  }
+
   // Append the given data to the array.
   void Append(const ValueType other[], size_t count) {
     if (count) {
@@ -294,6 +346,14 @@ struct ArrayDataCC : ArrayDataBase<T, Allocator, SizePolicy> {
     Allocator::ConstructAlt(this->Data + this->Size - 1, val);
   }
 
+  template <class... Args>
+  ValueType& EmplaceBack(Args&&... args) {
+    BaseType::ResizeNoConstruct(this->Size + 1);
+    ValueType* p = this->Data + this->Size - 1;
+    Allocator::ConstructEmplace(p, std::forward<Args>(args)...);
+    return *p;
+  }
+
   // Append the given data to the array.
   void Append(const ValueType other[], size_t count) {
     if (count) {
@@ -306,6 +366,163 @@ struct ArrayDataCC : ArrayDataBase<T, Allocator, SizePolicy> {
   ValueType DefaultValue;
 };
 
+//-----------------------------------------------------------------------------------
+// ***** ArrayDataInline
+//
+// A modification of ArrayData which keeps up to InlineCapacity elements within the object,
+// and allocates via Allocator only when the array grows beyond that. It returns to the inline
+// buffer when it shrinks back to InlineCapacity or less. For internal use only in InlineArray.
+template <class T, class Allocator, size_t InlineCapacity, class SizePolicy>
+struct ArrayDataInline {
+  typedef T ValueType;
+  typedef Allocator AllocatorType;
+  typedef SizePolicy SizePolicyType;
+  typedef ArrayDataInline<T, Allocator, InlineCapacity, SizePolicy> SelfType;
+
+  ArrayDataInline() : Data(GetInlineData()), Size(0), Policy() {
+    Policy.SetCapacity(InlineCapacity);
+  }
+
+  ArrayDataInline(size_t size) : Data(GetInlineData()), Size(0), Policy() {
+    Policy.SetCapacity(InlineCapacity);
+    Resize(size);
+  }
+
+  ArrayDataInline(const SelfType& a) : Data(GetInlineData()), Size(0), Policy(a.Policy) {
+    Policy.SetCapacity(InlineCapacity);
+    Append(a.Data, a.Size);
+  }
+
+  ~ArrayDataInline() {
+    Allocator::DestructArray(Data, Size);
+    if (!IsInline())
+      Allocator::Free(Data);
+  }
+
+  bool IsInline() const {
+    return (Data == GetInlineData());
+  }
+
+  size_t GetCapacity() const {
+    return Policy.GetCapacity();
+  }
+
+  void ClearAndRelease() {
+    Allocator::DestructArray(Data, Size);
+    if (!IsInline())
+      Allocator::Free(Data);
+    Data = GetInlineData();
+    Size = 0;
+    Policy.SetCapacity(InlineCapacity);
+  }
+
+  // Elements at and beyond newCapacity must already be destructed.
+  void Reserve(size_t newCapacity) {
+    if (Policy.NeverShrinking() && newCapacity < GetCapacity())
+      return;
+
+    if (newCapacity < Policy.GetMinCapacity())
+      newCapacity = Policy.GetMinCapacity();
+
+    T* newData;
+
+    if (newCapacity <= InlineCapacity) {
+      newCapacity = InlineCapacity;
+      newData = GetInlineData();
+    } else {
+      size_t gran = Policy.GetGranularity();
+      newCapacity = (newCapacity + gran - 1) / gran * gran;
+
+      if (!IsInline() && Allocator::IsMovable()) {
+        Data = (T*)Allocator::Realloc(Data, sizeof(T) * newCapacity);
+        Policy.SetCapacity(newCapacity);
+        return;
+      }
+
+      newData = (T*)Allocator::Alloc(sizeof(T) * newCapacity);
+      // OVR_ASSERT(newData); // need to throw (or something) on alloc failure!
+    }
+
+    if (newData != Data) {
+      const size_t count = (Size < newCapacity) ? Size : newCapacity;
+      Allocator::Relocate(newData, Data, count);
+
+      if (!IsInline())
+        Allocator::Free(Data);
+      Data = newData;
+    }
+
+    Policy.SetCapacity(newCapacity);
+  }
+
+  // This version of Resize DOES NOT construct the elements.
+  void ResizeNoConstruct(size_t newSize) {
+    size_t oldSize = Size;
+
+    if (newSize < oldSize) {
+      Allocator::DestructArray(Data + newSize, oldSize - newSize);
+      Size = newSize; // So that Reserve moves only the remaining elements.
+      if (newSize < (Policy.GetCapacity() >> 1)) {
+        Reserve(newSize);
+      }
+    } else if (newSize >= Policy.GetCapacity()) {
+      Reserve(Policy.GetGrowthCapacity(newSize));
+    }
+    Size = newSize;
+  }
+
+  void Resize(size_t newSize) {
+    size_t oldSize = Size;
+    ResizeNoConstruct(newSize);
+    if (newSize > oldSize)
+      Allocator::ConstructArray(Data + oldSize, newSize - oldSize);
+  }
+
+  void PushBack(const ValueType& val) {
+    ResizeNoConstruct(Size + 1);
+    Allocator::Construct(Data + Size - 1, val);
+  }
+
+  template <class S>
+  void PushBackAlt(const S& val) {
+    ResizeNoConstruct(Size + 1);
+    Allocator::ConstructAlt(Data + Size - 1, val);
+  }
+
+  template <class... Args>
+  ValueType& EmplaceBack(Args&&... args) {
+    ResizeNoConstruct(Size + 1);
+    ValueType* p = Data + Size - 1;
+    Allocator::ConstructEmplace(p, std::forward<Args>(args)...);
+    return *p;
+  }
+
+  // Append the given data to the array.
+  void Append(const ValueType other[], size_t count) {
+    if (count) {
+      size_t oldSize = Size;
+      ResizeNoConstruct(Size + count);
+      Allocator::ConstructArray(Data + oldSize, count, other);
+    }
+  }
+
+  ValueType* Data;
+  size_t Size;
+  SizePolicy Policy;
+
+ protected:
+  T* GetInlineData() {
+    return reinterpret_cast<T*>(&InlineBuffer);
+  }
+  const T* GetInlineData() const {
+    return reinterpret_cast<const T*>(&InlineBuffer);
+  }
+
+  typename std::aligned_storage<sizeof(T) * InlineCapacity, OVR_ALIGNOF(T)>::type InlineBuffer;
+
+  void operator=(const SelfType&); // Not supported, as Data may point into InlineBuffer.
+};
+
 //-----------------------------------------------------------------------------------
 // ***** ArrayBase
 //
@@ -431,6 +648,13 @@ class ArrayBase {
     Data.PushBackAlt(val);
   }
 
+  // Constructs a new last element from args, in place. As with PushBack, args must not refer
+  // to elements of this array, since growing it may move them.
+  template <class... Args>
+  ValueType& EmplaceBack(Args&&... args) {
+    return Data.EmplaceBack(std::forward<Args>(args)...);
+  }
+
   // Remove the last element.
   void PopBack(size_t count = 1) {
     OVR_ASSERT(Data.Size >= count);
@@ -849,6 +1073,102 @@ class ArrayCC : public ArrayBase<ArrayDataCC<T, ContainerAllocator<T>, SizePolic
   }
 };
 
+// ***** FrameArray, FrameArrayPOD
+//
+// Equivalents of Array and ArrayPOD which draw from the calling thread's current FrameArena.
+// An instance must be destroyed before the FrameArena::Scope it was created within exits.
+template <class T, class SizePolicy = ArrayDefaultPolicy>
+class FrameArray : public ArrayBase<ArrayData<T, ContainerAllocator_FrameArena<T>, SizePolicy>> {
+ public:
+  typedef T ValueType;
+  typedef ContainerAllocator_FrameArena<T> AllocatorType;
+  typedef SizePolicy SizePolicyType;
+  typedef FrameArray<T, SizePolicy> SelfType;
+  typedef ArrayBase<ArrayData<T, ContainerAllocator_FrameArena<T>, SizePolicy>> BaseType;
+
+  FrameArray() : BaseType() {}
+  explicit FrameArray(size_t size) : BaseType(size) {}
+  FrameArray(const SizePolicyType& p) : BaseType() {
+    SetSizePolicy(p);
+  }
+  FrameArray(const SelfType& a) : BaseType(a) {}
+  const SelfType& operator=(const SelfType& a) {
+    BaseType::operator=(a);
+    return *this;
+  }
+};
+
+template <class T, class SizePolicy = ArrayDefaultPolicy>
+class FrameArrayPOD
+    : public ArrayBase<ArrayData<T, ContainerAllocator_FrameArena_POD<T>, SizePolicy>> {
+ public:
+  typedef T ValueType;
+  typedef ContainerAllocator_FrameArena_POD<T> AllocatorType;
+  typedef SizePolicy SizePolicyType;
+  typedef FrameArrayPOD<T, SizePolicy> SelfType;
+  typedef ArrayBase<ArrayData<T, ContainerAllocator_FrameArena_POD<T>, SizePolicy>> BaseType;
+
+  FrameArrayPOD() : BaseType() {}
+  explicit FrameArrayPOD(size_t size) : BaseType(size) {}
+  FrameArrayPOD(const SizePolicyType& p) : BaseType() {
+    SetSizePolicy(p);
+  }
+  FrameArrayPOD(const SelfType& a) : BaseType(a) {}
+  const SelfType& operator=(const SelfType& a) {
+    BaseType::operator=(a);
+    return *this;
+  }
+};
+
+// ***** InlineArray, InlineArrayPOD
+//
+// Equivalents of Array and ArrayPOD which keep their first N elements within the object, so
+// that small arrays, such as per-eye or per-layer lists, don't allocate. Larger arrays spill
+// to the global heap. As the elements may live inside the array object, moving the array
+// object itself (e.g. by bitwise copy within an enclosing Array) invalidates it.
+template <class T, size_t N, class SizePolicy = ArrayDefaultPolicy>
+class InlineArray : public ArrayBase<ArrayDataInline<T, ContainerAllocator<T>, N, SizePolicy>> {
+ public:
+  typedef T ValueType;
+  typedef ContainerAllocator<T> AllocatorType;
+  typedef SizePolicy SizePolicyType;
+  typedef InlineArray<T, N, SizePolicy> SelfType;
+  typedef ArrayBase<ArrayDataInline<T, ContainerAllocator<T>, N, SizePolicy>> BaseType;
+
+  InlineArray() : BaseType() {}
+  explicit InlineArray(size_t size) : BaseType(size) {}
+  InlineArray(const SizePolicyType& p) : BaseType() {
+    SetSizePolicy(p);
+  }
+  InlineArray(const SelfType& a) : BaseType(a) {}
+  const SelfType& operator=(const SelfType& a) {
+    BaseType::operator=(a);
+    return *this;
+  }
+};
+
+template <class T, size_t N, class SizePolicy = ArrayDefaultPolicy>
+class InlineArrayPOD
+    : public ArrayBase<ArrayDataInline<T, ContainerAllocator_POD<T>, N, SizePolicy>> {
+ public:
+  typedef T ValueType;
+  typedef ContainerAllocator_POD<T> AllocatorType;
+  typedef SizePolicy SizePolicyType;
+  typedef InlineArrayPOD<T, N, SizePolicy> SelfType;
+  typedef ArrayBase<ArrayDataInline<T, ContainerAllocator_POD<T>, N, SizePolicy>> BaseType;
+
+  InlineArrayPOD() : BaseType() {}
+  explicit InlineArrayPOD(size_t size) : BaseType(size) {}
+  InlineArrayPOD(const SizePolicyType& p) : BaseType() {
+    SetSizePolicy(p);
+  }
+  InlineArrayPOD(const SelfType& a) : BaseType(a) {}
+  const SelfType& operator=(const SelfType& a) {
+    BaseType::operator=(a);
+    return *this;
+  }
+};
+
 } // namespace OVR
 
 #endif
@@ -0,0 +1,427 @@
+/************************************************************************************
+
+Filename    :   OVR_AsyncFile.cpp
+Content     :   Asynchronous file reads with a bounded queue depth
+Created     :   October 14, 2026
+Notes       :
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR_AsyncFile.h"
+#include "OVR_UTF8Util.h"
+
+#if defined(OVR_OS_MS)
+#include "OVR_Win32_IncludeWindows.h"
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <memory>
+#include <string.h>
+
+#ifdef OVR_ENABLE_THREADS
+
+namespace OVR {
+
+#if defined(OVR_OS_MS)
+static int AsyncFileError(DWORD error) {
+  if (error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND)
+    return FileConstants::Error_FileNotFound;
+  else if (error == ERROR_ACCESS_DENIED || error == ERROR_SHARING_VIOLATION)
+    return FileConstants::Error_Access;
+  else
+    return FileConstants::Error_IOError;
+}
+#else
+static int AsyncFileError(int error) {
+  if (error == ENOENT)
+    return FileConstants::Error_FileNotFound;
+  else if (error == EACCES || error == EPERM)
+    return FileConstants::Error_Access;
+  else
+    return FileConstants::Error_IOError;
+}
+
+// Reads until size bytes have been read or the end of the file is reached.
+static int ReadAt(int fd, int64_t offset, uint8_t* buffer, int size) {
+  int total = 0;
+
+  while (total < size) {
+    const ssize_t result = ::pread(fd, buffer + total, size - total, (off_t)(offset + total));
+    if (result < 0) {
+      if (errno == EINTR)
+        continue;
+      return -1;
+    }
+    if (result == 0)
+      break;
+    total += (int)result;
+  }
+
+  return total;
+}
+#endif
+
+//-----------------------------------------------------------------------------------
+// ***** AsyncFile
+
+AsyncFile::AsyncFile()
+    : FilePath(), Handle(InvalidHandle), FileSize(0), ErrorCode(0), pQueue(nullptr) {}
+
+AsyncFile::AsyncFile(const char* pfileName)
+    : FilePath(), Handle(InvalidHandle), FileSize(0), ErrorCode(0), pQueue(nullptr) {
+  Open(pfileName);
+}
+
+AsyncFile::~AsyncFile() {
+  Close();
+}
+
+bool AsyncFile::Open(const char* pfileName) {
+  Close();
+
+  FilePath = pfileName ? pfileName : "";
+  ErrorCode = 0;
+
+  if (!pfileName || !*pfileName) {
+    ErrorCode = FileConstants::Error_FileNotFound;
+    return false;
+  }
+
+#if defined(OVR_OS_MS)
+  const size_t fileNameLength = (size_t)UTF8Util::GetLength(pfileName) + 1;
+  wchar_t* pwFileName = (wchar_t*)OVR_ALLOC(fileNameLength * sizeof(pwFileName[0]));
+  if (!pwFileName) {
+    ErrorCode = FileConstants::Error_IOError;
+    return false;
+  }
+  UTF8Util::Strlcpy(pwFileName, fileNameLength, pfileName);
+
+  HANDLE hFile = ::CreateFileW(
+      pwFileName,
+      GENERIC_READ,
+      FILE_SHARE_READ,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED,
+      nullptr);
+  OVR_FREE(pwFileName);
+
+  if (hFile == INVALID_HANDLE_VALUE) {
+    ErrorCode = AsyncFileError(::GetLastError());
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if (!::GetFileSizeEx(hFile, &size)) {
+    ErrorCode = AsyncFileError(::GetLastError());
+    ::CloseHandle(hFile);
+    return false;
+  }
+
+  Handle = (intptr_t)hFile;
+  FileSize = size.QuadPart;
+#else
+  const int fd = ::open(pfileName, O_RDONLY);
+  if (fd < 0) {
+    ErrorCode = AsyncFileError(errno);
+    return false;
+  }
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0) {
+    ErrorCode = AsyncFileError(errno);
+    ::close(fd);
+    return false;
+  }
+
+  Handle = fd;
+  FileSize = fileStat.st_size;
+#endif
+
+  return true;
+}
+
+bool AsyncFile::Close() {
+  if (!IsValid())
+    return false;
+
+#if defined(OVR_OS_MS)
+  ::CloseHandle((HANDLE)Handle);
+#else
+  ::close((int)Handle);
+#endif
+
+  Handle = InvalidHandle;
+  FileSize = 0;
+  pQueue = nullptr;
+  return true;
+}
+
+//-----------------------------------------------------------------------------------
+// ***** AsyncFileQueue
+
+struct AsyncFileQueue::Request {
+#if defined(OVR_OS_MS)
+  // Must come first, so that the OVERLAPPED a completion returns is the Request.
+  OVERLAPPED Overlapped;
+#endif
+  AsyncFile* File;
+  int64_t Offset;
+  uint8_t* Buffer;
+  int Size;
+  CompletionFunction OnComplete;
+};
+
+AsyncFileQueue::AsyncFileQueue(unsigned queueDepth)
+    : QueueDepth(queueDepth ? queueDepth : 1),
+      InFlightCount(0),
+      PendingCount(0),
+      Terminated(false),
+      QueueLock(),
+      RequestCondition(),
+      IdleCondition(),
+      WaitingRequests(),
+      IOThreads(),
+      hCompletionPort(nullptr) {
+#if defined(OVR_OS_MS)
+  // A single thread is enough to dispatch completions; the reads themselves run in the kernel.
+  hCompletionPort = ::CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+  OVR_ASSERT(hCompletionPort);
+  IOThreads.emplace_back([this] { ioThreadMain(); });
+#else
+  // Each thread runs one read at a time, so the thread count is the queue depth.
+  for (unsigned i = 0; i < QueueDepth; ++i)
+    IOThreads.emplace_back([this] { ioThreadMain(); });
+#endif
+}
+
+AsyncFileQueue::~AsyncFileQueue() {
+  Wait();
+
+  {
+    std::lock_guard<std::mutex> locker(QueueLock);
+    Terminated = true;
+  }
+
+#if defined(OVR_OS_MS)
+  // A null OVERLAPPED tells the I/O thread to exit.
+  ::PostQueuedCompletionStatus((HANDLE)hCompletionPort, 0, 0, nullptr);
+#else
+  RequestCondition.notify_all();
+#endif
+
+  for (size_t i = 0; i < IOThreads.size(); ++i)
+    IOThreads[i].join();
+
+#if defined(OVR_OS_MS)
+  ::CloseHandle((HANDLE)hCompletionPort);
+#endif
+}
+
+bool AsyncFileQueue::Read(
+    AsyncFile* file,
+    int64_t offset,
+    void* buffer,
+    int size,
+    const CompletionFunction& onComplete) {
+  if (!file || !file->IsValid() || (offset < 0) || (size < 0) || (!buffer && size))
+    return false;
+
+  if (!bindFile(file))
+    return false;
+
+  Request* request = new Request;
+#if defined(OVR_OS_MS)
+  memset(&request->Overlapped, 0, sizeof(request->Overlapped));
+#endif
+  request->File = file;
+  request->Offset = offset;
+  request->Buffer = (uint8_t*)buffer;
+  request->Size = size;
+  request->OnComplete = onComplete;
+
+  std::unique_lock<std::mutex> locker(QueueLock);
+  ++PendingCount;
+
+#if defined(OVR_OS_MS)
+  if (InFlightCount < QueueDepth) {
+    ++InFlightCount;
+    locker.unlock();
+    issueRequest(request);
+    return true;
+  }
+
+  // Issued by completeRequest once a slot frees up.
+  WaitingRequests.push_back(request);
+#else
+  WaitingRequests.push_back(request);
+  locker.unlock();
+  RequestCondition.notify_one();
+#endif
+
+  return true;
+}
+
+std::future<int> AsyncFileQueue::Read(AsyncFile* file, int64_t offset, void* buffer, int size) {
+  std::shared_ptr<std::promise<int>> promise = std::make_shared<std::promise<int>>();
+  std::future<int> future = promise->get_future();
+
+  if (!Read(file, offset, buffer, size, [promise](int bytesRead) {
+        promise->set_value(bytesRead);
+      }))
+    promise->set_value(-1);
+
+  return future;
+}
+
+void AsyncFileQueue::Wait() {
+  std::unique_lock<std::mutex> locker(QueueLock);
+  IdleCondition.wait(locker, [this] { return PendingCount == 0; });
+}
+
+bool AsyncFileQueue::bindFile(AsyncFile* file) {
+#if defined(OVR_OS_MS)
+  std::lock_guard<std::mutex> locker(QueueLock);
+
+  if (file->pQueue)
+    return (file->pQueue == this);
+
+  // Completions of overlapped reads on the handle are posted to the port from now on, and a
+  // handle can't be moved to another port.
+  if (!::CreateIoCompletionPort((HANDLE)file->Handle, (HANDLE)hCompletionPort, 0, 0))
+    return false;
+
+  file->pQueue = this;
+#else
+  OVR_UNUSED(file);
+#endif
+  return true;
+}
+
+#if defined(OVR_OS_MS)
+
+void AsyncFileQueue::issueRequest(Request* request) {
+  request->Overlapped.Offset = (DWORD)(uint64_t)request->Offset;
+  request->Overlapped.OffsetHigh = (DWORD)((uint64_t)request->Offset >> 32);
+
+  // A read which completes immediately still posts a completion to the port, so only a read
+  // which fails to start is completed here.
+  if (!::ReadFile(
+          (HANDLE)request->File->Handle,
+          request->Buffer,
+          (DWORD)request->Size,
+          nullptr,
+          &request->Overlapped)) {
+    const DWORD error = ::GetLastError();
+    if (error != ERROR_IO_PENDING)
+      completeRequest(request, (error == ERROR_HANDLE_EOF) ? 0 : -1);
+  }
+}
+
+void AsyncFileQueue::ioThreadMain() {
+  for (;;) {
+    DWORD bytesTransferred = 0;
+    ULONG_PTR key = 0;
+    OVERLAPPED* overlapped = nullptr;
+    const BOOL result = ::GetQueuedCompletionStatus(
+        (HANDLE)hCompletionPort, &bytesTransferred, &key, &overlapped, INFINITE);
+
+    if (!overlapped)
+      break;
+
+    int bytesRead = (int)bytesTransferred;
+    if (!result)
+      bytesRead = (::GetLastError() == ERROR_HANDLE_EOF) ? 0 : -1;
+
+    completeRequest(reinterpret_cast<Request*>(overlapped), bytesRead);
+  }
+}
+
+void AsyncFileQueue::completeRequest(Request* request, int bytesRead) {
+  if (request->OnComplete)
+    request->OnComplete(bytesRead);
+  delete request;
+
+  Request* next = nullptr;
+  {
+    std::lock_guard<std::mutex> locker(QueueLock);
+
+    // The slot passes straight to the oldest waiting read.
+    if (!WaitingRequests.empty()) {
+      next = WaitingRequests.front();
+      WaitingRequests.pop_front();
+    } else {
+      --InFlightCount;
+    }
+
+    if (--PendingCount == 0)
+      IdleCondition.notify_all();
+  }
+
+  if (next)
+    issueRequest(next);
+}
+
+#else // OVR_OS_MS
+
+void AsyncFileQueue::issueRequest(Request* request) {
+  const int bytesRead =
+      ReadAt((int)request->File->Handle, request->Offset, request->Buffer, request->Size);
+  completeRequest(request, bytesRead);
+}
+
+void AsyncFileQueue::ioThreadMain() {
+  std::unique_lock<std::mutex> locker(QueueLock);
+
+  for (;;) {
+    RequestCondition.wait(locker, [this] { return Terminated || !WaitingRequests.empty(); });
+    if (WaitingRequests.empty())
+      break;
+
+    Request* request = WaitingRequests.front();
+    WaitingRequests.pop_front();
+    ++InFlightCount;
+
+    locker.unlock();
+    issueRequest(request);
+    locker.lock();
+  }
+}
+
+void AsyncFileQueue::completeRequest(Request* request, int bytesRead) {
+  if (request->OnComplete)
+    request->OnComplete(bytesRead);
+  delete request;
+
+  std::lock_guard<std::mutex> locker(QueueLock);
+  --InFlightCount;
+  if (--PendingCount == 0)
+    IdleCondition.notify_all();
+}
+
+#endif // OVR_OS_MS
+
+} // namespace OVR
+
+#endif // OVR_ENABLE_THREADS
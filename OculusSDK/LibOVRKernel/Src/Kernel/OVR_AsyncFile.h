@@ -0,0 +1,183 @@
+/************************************************************************************
+
+Filename    :   OVR_AsyncFile.h
+Content     :   Asynchronous file reads with a bounded queue depth
+Created     :   October 14, 2026
+Notes       :
+    AsyncFileQueue issues reads without blocking the caller, so that several loads (such as the
+    textures and meshes of a scene) can be in flight at once. On Windows the reads are
+    overlapped and complete through an I/O completion port; elsewhere they're positioned reads
+    run by a small set of I/O threads, one per queue slot.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_AsyncFile_h
+#define OVR_AsyncFile_h
+
+#include "OVR_Types.h"
+#include "OVR_File.h"
+#include "OVR_String.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef OVR_ENABLE_THREADS
+
+namespace OVR {
+
+class AsyncFileQueue;
+
+//-----------------------------------------------------------------------------------
+// ***** AsyncFile
+//
+// A file opened for reading through an AsyncFileQueue. It has no file position; every read
+// gives its own offset. The file must stay open until all reads queued on it have completed.
+// On Windows the file's handle is bound to the first queue that reads it, and can only be read
+// through that queue until it's reopened.
+//
+class AsyncFile {
+  OVR_NON_COPYABLE(AsyncFile)
+
+ public:
+  AsyncFile();
+  AsyncFile(const char* pfileName);
+  ~AsyncFile();
+
+  bool Open(const char* pfileName);
+  bool Close();
+
+  bool IsValid() const {
+    return Handle != InvalidHandle;
+  }
+
+  const char* GetFilePath() const {
+    return FilePath.ToCStr();
+  }
+
+  // File size, or -1 if the file isn't open.
+  int64_t GetLength() const {
+    return IsValid() ? FileSize : -1;
+  }
+
+  // FileConstants::Errors value of the last failed Open.
+  int GetErrorCode() const {
+    return ErrorCode;
+  }
+
+ protected:
+  friend class AsyncFileQueue;
+
+  // A HANDLE on Windows, a file descriptor elsewhere.
+  static const intptr_t InvalidHandle = -1;
+
+  String FilePath;
+  intptr_t Handle;
+  int64_t FileSize;
+  int ErrorCode;
+  AsyncFileQueue* pQueue; // The queue the handle is bound to (Windows only).
+};
+
+//-----------------------------------------------------------------------------------
+// ***** AsyncFileQueue
+//
+// Runs at most QueueDepth reads at a time; reads queued beyond that wait for a free slot, in
+// the order they were queued. Read may be called from any thread, including from completion
+// callbacks.
+//
+// Completion callbacks are called on the queue's I/O threads with the number of bytes read,
+// which is less than the size asked for only at the end of the file, or -1 on failure. They
+// should hand off anything slow (such as decoding or GPU uploads) to another thread, since a
+// callback which blocks holds a queue slot.
+//
+// For example, to read two files at once and wait for both:
+//
+//     AsyncFileQueue queue;
+//     AsyncFile textureFile("Tiles.dds"), meshFile("Room.bin");
+//     std::future<int> textureRead = queue.Read(&textureFile, 0, textureData, textureSize);
+//     std::future<int> meshRead = queue.Read(&meshFile, 0, meshData, meshSize);
+//     bool loaded = (textureRead.get() == textureSize) && (meshRead.get() == meshSize);
+//
+class AsyncFileQueue {
+  OVR_NON_COPYABLE(AsyncFileQueue)
+
+ public:
+  typedef std::function<void(int bytesRead)> CompletionFunction;
+
+  static const unsigned DefaultQueueDepth = 8;
+
+  explicit AsyncFileQueue(unsigned queueDepth = DefaultQueueDepth);
+
+  // Waits for all queued reads to complete.
+  ~AsyncFileQueue();
+
+  // Queues a read of size bytes at offset into buffer, which must stay valid until onComplete
+  // is called. onComplete is called even if the read fails; Read returns false only when the
+  // read couldn't be queued at all (for example because the file isn't open), in which case
+  // onComplete isn't called.
+  bool Read(
+      AsyncFile* file,
+      int64_t offset,
+      void* buffer,
+      int size,
+      const CompletionFunction& onComplete);
+
+  // As above, with the number of bytes read (or -1) delivered through a future.
+  std::future<int> Read(AsyncFile* file, int64_t offset, void* buffer, int size);
+
+  // Returns once every read queued so far has completed and its callback has returned. Must not
+  // be called from a completion callback.
+  void Wait();
+
+  unsigned GetQueueDepth() const {
+    return QueueDepth;
+  }
+
+ protected:
+  struct Request;
+
+  bool bindFile(AsyncFile* file);
+  void issueRequest(Request* request);
+  void completeRequest(Request* request, int bytesRead);
+  void ioThreadMain();
+
+  unsigned QueueDepth;
+  unsigned InFlightCount; // Reads issued and not yet completed, at most QueueDepth.
+  unsigned PendingCount; // Reads not yet completed, including those waiting for a slot.
+  bool Terminated;
+
+  std::mutex QueueLock;
+  std::condition_variable RequestCondition;
+  std::condition_variable IdleCondition;
+  std::deque<Request*> WaitingRequests;
+  std::vector<std::thread> IOThreads;
+
+  void* hCompletionPort; // Windows only.
+};
+
+} // namespace OVR
+
+#endif // OVR_ENABLE_THREADS
+
+#endif // OVR_AsyncFile_h
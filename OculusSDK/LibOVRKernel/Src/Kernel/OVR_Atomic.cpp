@@ -62,6 +62,42 @@ Lock::~Lock() {
 
 #endif
 
+//-------------------------------------------------------------------------------------
+// ***** AdaptiveLock
+
+// State is Locked while held with no parked threads, and LockedWithWaiters once any thread may
+// be parked. A thread which parks always takes the lock as LockedWithWaiters, since it can't
+// tell whether others are still parked; at worst this costs its Unlock one needless wake.
+
+void AdaptiveLock::LockContended() {
+  ContendedCount.fetch_add(1, std::memory_order_relaxed);
+
+  for (unsigned i = 0; i < SpinCount; ++i) {
+    if (State.load(std::memory_order_relaxed) == Unlocked) {
+      int expected = Unlocked;
+      if (State.compare_exchange_weak(
+              expected, Locked, std::memory_order_acquire, std::memory_order_relaxed))
+        return;
+    }
+    OVR_PROCESSOR_PAUSE();
+  }
+
+  ParkCount.fetch_add(1, std::memory_order_relaxed);
+
+  while (State.exchange(LockedWithWaiters, std::memory_order_acquire) != Unlocked) {
+    std::unique_lock<std::mutex> locker(ParkMutex);
+    // Unlock changes State before taking ParkMutex to notify, so checking State under the
+    // mutex means we can't miss the wake for the Unlock we are waiting on.
+    if (State.load(std::memory_order_relaxed) == LockedWithWaiters)
+      ParkCondition.wait(locker);
+  }
+}
+
+void AdaptiveLock::WakeWaiter() {
+  { std::lock_guard<std::mutex> locker(ParkMutex); }
+  ParkCondition.notify_one();
+}
+
 //-------------------------------------------------------------------------------------
 // ***** SharedLock
 
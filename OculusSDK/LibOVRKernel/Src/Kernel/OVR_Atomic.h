@@ -32,6 +32,10 @@ limitations under the License.
 #include "OVR_Types.h"
 
 #include <atomic>
+#if defined(OVR_ENABLE_THREADS)
+#include <condition_variable>
+#include <mutex>
+#endif
 
 // Include System thread functionality.
 #if defined(OVR_OS_MS) && !defined(OVR_OS_MS_MOBILE)
@@ -151,6 +155,240 @@ class Lock {
   };
 };
 
+//-----------------------------------------------------------------------------------
+// ***** RWLock
+
+// RWLock is a non-recursive reader-writer lock, for read-mostly data where Lock would
+// serialize readers needlessly. Any number of threads can hold it shared at once, while
+// holding it exclusive excludes all others. A shared holder must not try to upgrade to
+// exclusive. Like Lock, it cannot be waited on.
+
+class RWLock {
+  OVR_NON_COPYABLE(RWLock)
+
+#if !defined(OVR_ENABLE_THREADS)
+
+ public:
+  // With no thread support, lock does nothing.
+  inline RWLock() {}
+  inline ~RWLock() {}
+  inline void LockShared() {}
+  inline void UnlockShared() {}
+  inline bool TryLockShared() {
+    return true;
+  }
+  inline void LockExclusive() {}
+  inline void UnlockExclusive() {}
+  inline bool TryLockExclusive() {
+    return true;
+  }
+
+// Windows.
+#elif defined(OVR_OS_MS)
+
+  SRWLOCK srwLock;
+
+ public:
+  RWLock() {
+    ::InitializeSRWLock(&srwLock);
+  }
+  ~RWLock() {} // SRW locks need no cleanup.
+  inline void LockShared() {
+    ::AcquireSRWLockShared(&srwLock);
+  }
+  inline void UnlockShared() {
+    ::ReleaseSRWLockShared(&srwLock);
+  }
+  inline bool TryLockShared() {
+    return (::TryAcquireSRWLockShared(&srwLock) != 0);
+  }
+  inline void LockExclusive() {
+    ::AcquireSRWLockExclusive(&srwLock);
+  }
+  inline void UnlockExclusive() {
+    ::ReleaseSRWLockExclusive(&srwLock);
+  }
+  inline bool TryLockExclusive() {
+    return (::TryAcquireSRWLockExclusive(&srwLock) != 0);
+  }
+#else
+  pthread_rwlock_t rwlock;
+
+ public:
+  RWLock() {
+    pthread_rwlock_init(&rwlock, nullptr);
+  }
+  ~RWLock() {
+    pthread_rwlock_destroy(&rwlock);
+  }
+  inline void LockShared() {
+    pthread_rwlock_rdlock(&rwlock);
+  }
+  inline void UnlockShared() {
+    pthread_rwlock_unlock(&rwlock);
+  }
+  inline bool TryLockShared() {
+    return (pthread_rwlock_tryrdlock(&rwlock) == 0);
+  }
+  inline void LockExclusive() {
+    pthread_rwlock_wrlock(&rwlock);
+  }
+  inline void UnlockExclusive() {
+    pthread_rwlock_unlock(&rwlock);
+  }
+  inline bool TryLockExclusive() {
+    return (pthread_rwlock_trywrlock(&rwlock) == 0);
+  }
+
+#endif // OVR_ENABLE_THREADS
+
+ public:
+  // SharedLocker and ExclusiveLocker classes, used for automatic locking
+  class SharedLocker {
+    RWLock* pLock;
+
+   public:
+    SharedLocker(RWLock* plock) {
+      pLock = plock;
+      if (plock)
+        pLock->LockShared();
+    }
+    ~SharedLocker() {
+      Release();
+    }
+
+    void Release() {
+      if (pLock)
+        pLock->UnlockShared();
+      pLock = nullptr;
+    }
+  };
+
+  class ExclusiveLocker {
+    RWLock* pLock;
+
+   public:
+    ExclusiveLocker(RWLock* plock) {
+      pLock = plock;
+      if (plock)
+        pLock->LockExclusive();
+    }
+    ~ExclusiveLocker() {
+      Release();
+    }
+
+    void Release() {
+      if (pLock)
+        pLock->UnlockExclusive();
+      pLock = nullptr;
+    }
+  };
+};
+
+//-----------------------------------------------------------------------------------
+// ***** AdaptiveLock
+
+// AdaptiveLock is a non-recursive mutual-exclusion lock for short critical sections. An
+// uncontended DoLock/Unlock is a single atomic operation each. A contended DoLock spins for up
+// to spinCount pauses waiting for the holder to leave, then parks the thread until Unlock wakes
+// it. It counts how often it was contended and how often a thread had to park, so hot locks can
+// be found and their spin count tuned.
+
+class AdaptiveLock {
+  OVR_NON_COPYABLE(AdaptiveLock)
+
+ public:
+  struct Stats {
+    uint64_t ContendedCount; // Number of DoLock calls which didn't get the lock immediately.
+    uint64_t ParkCount; // Number of those which spun without success and had to park.
+  };
+
+#if !defined(OVR_ENABLE_THREADS)
+
+  // With no thread support, lock does nothing.
+  inline AdaptiveLock(unsigned = 0) {}
+  inline void DoLock() {}
+  inline void Unlock() {}
+  inline bool TryLock() {
+    return true;
+  }
+  Stats GetStats() const {
+    Stats stats = {0, 0};
+    return stats;
+  }
+  void ResetStats() {}
+
+#else
+
+  AdaptiveLock(unsigned spinCount = 4000) : SpinCount(spinCount) {}
+
+  inline void DoLock() {
+    int expected = Unlocked;
+    if (!State.compare_exchange_strong(
+            expected, Locked, std::memory_order_acquire, std::memory_order_relaxed))
+      LockContended();
+  }
+
+  inline bool TryLock() {
+    int expected = Unlocked;
+    return State.compare_exchange_strong(
+        expected, Locked, std::memory_order_acquire, std::memory_order_relaxed);
+  }
+
+  inline void Unlock() {
+    if (State.exchange(Unlocked, std::memory_order_release) == LockedWithWaiters)
+      WakeWaiter();
+  }
+
+  Stats GetStats() const {
+    Stats stats = {ContendedCount.load(std::memory_order_relaxed),
+                   ParkCount.load(std::memory_order_relaxed)};
+    return stats;
+  }
+
+  void ResetStats() {
+    ContendedCount.store(0, std::memory_order_relaxed);
+    ParkCount.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  enum { Unlocked, Locked, LockedWithWaiters };
+
+  void LockContended();
+  void WakeWaiter();
+
+  std::atomic<int> State = {Unlocked};
+  unsigned SpinCount;
+  std::atomic<uint64_t> ContendedCount = {0};
+  std::atomic<uint64_t> ParkCount = {0};
+  std::mutex ParkMutex;
+  std::condition_variable ParkCondition;
+
+#endif // OVR_ENABLE_THREADS
+
+ public:
+  // Locker class, used for automatic locking
+  class Locker {
+    AdaptiveLock* pLock;
+
+   public:
+    Locker(AdaptiveLock* plock) {
+      pLock = plock;
+      if (plock)
+        pLock->DoLock();
+    }
+    ~Locker() {
+      Release();
+    }
+
+    void Release() {
+      if (pLock)
+        pLock->Unlock();
+      pLock = nullptr;
+    }
+  };
+};
+
 //-------------------------------------------------------------------------------------
 // Globally shared Lock implementation used for MessageHandlers, etc.
 
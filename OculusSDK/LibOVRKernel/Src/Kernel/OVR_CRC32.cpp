@@ -26,8 +26,99 @@ limitations under the License.
 
 #include "OVR_CRC32.h"
 
+#include <string.h>
+
+#if defined(OVR_CPU_X86) || defined(OVR_CPU_X86_64)
+#if defined(OVR_CC_MSVC)
+#include <intrin.h>
+#endif
+#include <nmmintrin.h> // SSE4.2
+#include <wmmintrin.h> // PCLMULQDQ
+#define OVR_CRC32_X86 1
+
+// MSVC allows intrinsics for any instruction set in any function; GCC and Clang need the
+// function to be marked for it.
+#if defined(OVR_CC_MSVC)
+#define OVR_CRC32_TARGET(isa)
+#else
+#define OVR_CRC32_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
 namespace OVR {
 
+//-----------------------------------------------------------------------------------
+// ***** Slice-by-8
+//
+// The generic path for all three CRCs. Slice k holds the CRC of a byte followed by k zero
+// bytes, which lets 8 bytes be folded in with 8 independent table lookups.
+
+namespace {
+
+struct CRC32Slices {
+  uint32_t Table[8][256];
+
+  // reflected is true for the LSB-first CRCs (standard and Castagnoli), and false for the
+  // MSB-first camera CRC.
+  CRC32Slices(const uint32_t* table, bool reflected) {
+    memcpy(Table[0], table, sizeof(Table[0]));
+    for (int k = 1; k < 8; ++k) {
+      for (int i = 0; i < 256; ++i) {
+        const uint32_t prev = Table[k - 1][i];
+        Table[k][i] = reflected ? ((prev >> 8) ^ table[prev & 0xFF])
+                                : ((prev << 8) ^ table[prev >> 24]);
+      }
+    }
+  }
+};
+
+inline uint32_t LoadLE32(const uint8_t* p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value)); // Kernel platforms are all little endian.
+  return value;
+}
+
+inline uint32_t LoadBE32(const uint8_t* p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// crc is the raw register, without the pre- and post-inversion.
+uint32_t SliceBy8Reflected(const CRC32Slices& s, const uint8_t* p, size_t bytes, uint32_t crc) {
+  while (bytes >= 8) {
+    const uint32_t lo = LoadLE32(p) ^ crc;
+    const uint32_t hi = LoadLE32(p + 4);
+    crc = s.Table[7][lo & 0xFF] ^ s.Table[6][(lo >> 8) & 0xFF] ^ s.Table[5][(lo >> 16) & 0xFF] ^
+        s.Table[4][lo >> 24] ^ s.Table[3][hi & 0xFF] ^ s.Table[2][(hi >> 8) & 0xFF] ^
+        s.Table[1][(hi >> 16) & 0xFF] ^ s.Table[0][hi >> 24];
+    p += 8;
+    bytes -= 8;
+  }
+
+  while (bytes--)
+    crc = (crc >> 8) ^ s.Table[0][(crc ^ *p++) & 0xFF];
+
+  return crc;
+}
+
+uint32_t SliceBy8Forward(const CRC32Slices& s, const uint8_t* p, size_t bytes, uint32_t crc) {
+  while (bytes >= 8) {
+    const uint32_t hi = LoadBE32(p) ^ crc;
+    const uint32_t lo = LoadBE32(p + 4);
+    crc = s.Table[7][hi >> 24] ^ s.Table[6][(hi >> 16) & 0xFF] ^ s.Table[5][(hi >> 8) & 0xFF] ^
+        s.Table[4][hi & 0xFF] ^ s.Table[3][lo >> 24] ^ s.Table[2][(lo >> 16) & 0xFF] ^
+        s.Table[1][(lo >> 8) & 0xFF] ^ s.Table[0][lo & 0xFF];
+    p += 8;
+    bytes -= 8;
+  }
+
+  while (bytes--)
+    crc = (crc << 8) ^ s.Table[0][(crc >> 24) ^ *p++];
+
+  return crc;
+}
+
+} // namespace
+
 //-----------------------------------------------------------------------------------
 // ***** Oculus Camera CRC-32
 
@@ -66,15 +157,12 @@ static const uint32_t CRC_Table[256] = {
     0xafb010b1, 0xab710d06, 0xa6322bdf, 0xa2f33668, 0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4};
 
 uint32_t OculusCamera_CRC32(const void* data, int bytes, uint32_t accumulator) {
-  const uint8_t* inputBytes = reinterpret_cast<const uint8_t*>(data);
+  static const CRC32Slices slices(CRC_Table, false);
 
-  for (int j = 0; j < bytes; ++j) {
-    int i = ((uint32_t)(accumulator >> 24) ^ *inputBytes++) & 0xFF;
+  if (bytes <= 0)
+    return ~accumulator;
 
-    accumulator = (accumulator << 8) ^ CRC_Table[i];
-  }
-
-  return ~accumulator;
+  return ~SliceBy8Forward(slices, (const uint8_t*)data, (size_t)bytes, accumulator);
 }
 
 //-----------------------------------------------------------------------------------
@@ -150,8 +238,135 @@ const uint32_t CRC32_Table_CRC32_C[256] = {
     0xf36e6f75, 0x105ec76,  0x12551f82, 0xe03e9c81, 0x34f4f86a, 0xc69f7b69, 0xd5cf889d, 0x27a40b9e,
     0x79b737ba, 0x8bdcb4b9, 0x988c474d, 0x6ae7c44e, 0xbe2da0a5, 0x4c4623a6, 0x5f16d052, 0xad7d5351};
 
-// CRC32 core algorithm, slightly unrolled, no hardware acceleration
-uint32_t CalculateCRC32(
+//-----------------------------------------------------------------------------------
+// ***** Hardware paths
+
+#if defined(OVR_CRC32_X86)
+
+namespace {
+
+struct CRC32Features {
+  bool SSE42; // crc32 instruction, for Castagnoli
+  bool PCLMUL; // Carry-less multiply, for folding the standard CRC (with SSE4.1 extracts)
+
+  CRC32Features() {
+    int regs[4];
+#if defined(OVR_CC_MSVC)
+    __cpuidex(regs, 1, 0);
+#else
+    int a, b, c, d;
+    __asm("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(1), "c"(0) :);
+    regs[0] = a;
+    regs[1] = b;
+    regs[2] = c;
+    regs[3] = d;
+#endif
+    SSE42 = (regs[2] & (1 << 20)) != 0;
+    PCLMUL = SSE42 && ((regs[2] & (1 << 1)) != 0);
+  }
+};
+
+const CRC32Features& GetCRC32Features() {
+  static const CRC32Features features;
+  return features;
+}
+
+OVR_CRC32_TARGET("sse4.2")
+uint32_t Castagnoli_SSE42(const uint8_t* p, size_t bytes, uint32_t crc) {
+#if defined(OVR_CPU_X86_64)
+  uint64_t crc64 = crc;
+  for (; bytes >= 8; p += 8, bytes -= 8) {
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    crc64 = _mm_crc32_u64(crc64, value);
+  }
+  crc = (uint32_t)crc64;
+#endif
+
+  for (; bytes >= 4; p += 4, bytes -= 4)
+    crc = _mm_crc32_u32(crc, LoadLE32(p));
+
+  while (bytes--)
+    crc = _mm_crc32_u8(crc, *p++);
+
+  return crc;
+}
+
+// Folds 64 bytes per iteration into four 128-bit lanes with carry-less multiplies, then reduces
+// to 32 bits with a Barrett reduction, as described in Intel's "Fast CRC Computation for Generic
+// Polynomials Using PCLMULQDQ Instruction". bytes must be at least 64 and a multiple of 16.
+OVR_CRC32_TARGET("sse4.2,pclmul")
+uint32_t Standard_PCLMUL(const uint8_t* p, size_t bytes, uint32_t crc) {
+  // Folding constants for the reflected polynomial 0xEDB88320; k1 to k5, P' and mu in the paper.
+  const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+  const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+  const __m128i k5 = _mm_set_epi64x(0, 0x0163cd6124);
+  const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+  const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+  __m128i x1 = _mm_loadu_si128((const __m128i*)(p + 0x00));
+  __m128i x2 = _mm_loadu_si128((const __m128i*)(p + 0x10));
+  __m128i x3 = _mm_loadu_si128((const __m128i*)(p + 0x20));
+  __m128i x4 = _mm_loadu_si128((const __m128i*)(p + 0x30));
+  x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+  p += 64;
+  bytes -= 64;
+
+  for (; bytes >= 64; p += 64, bytes -= 64) {
+    const __m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+    const __m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+    const __m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+    const __m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+    x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+    x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+    x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(p + 0x00)));
+    x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(p + 0x10)));
+    x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(p + 0x20)));
+    x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(p + 0x30)));
+  }
+
+  // Fold the four lanes into one, then any remaining 16-byte blocks into that.
+  const __m128i lanes[3] = {x2, x3, x4};
+  for (int i = 0; i < 3; ++i) {
+    const __m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, lanes[i]), x5);
+  }
+
+  for (; bytes >= 16; p += 16, bytes -= 16) {
+    const __m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)p)), x5);
+  }
+
+  // Fold 128 bits to 64.
+  x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+  x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+  x2 = _mm_srli_si128(x1, 4);
+  x1 = _mm_and_si128(x1, mask32);
+  x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k5, 0x00), x2);
+
+  // Barrett reduction to 32 bits.
+  x2 = _mm_and_si128(x1, mask32);
+  x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+  x2 = _mm_and_si128(x2, mask32);
+  x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+  x1 = _mm_xor_si128(x1, x2);
+
+  return (uint32_t)_mm_extract_epi32(x1, 1);
+}
+
+} // namespace
+
+#endif // OVR_CRC32_X86
+
+//-----------------------------------------------------------------------------------
+// ***** CalculateCRC32
+
+// The byte-table loop used for tables other than the two standard ones.
+static uint32_t CalculateCRC32Generic(
     const uint32_t* OVR_RESTRICT table,
     const void* OVR_RESTRICT message,
     int messageBytes,
@@ -186,4 +401,45 @@ uint32_t CalculateCRC32(
   return ~crc;
 }
 
+// Picks the fastest path the CPU supports for the standard tables, then slice-by-8.
+uint32_t CalculateCRC32(
+    const uint32_t* OVR_RESTRICT table,
+    const void* OVR_RESTRICT message,
+    int messageBytes,
+    uint32_t crc) {
+  if (messageBytes <= 0)
+    return crc;
+
+  const uint8_t* p = (const uint8_t*)message;
+  size_t bytes = (size_t)messageBytes;
+  crc = ~crc;
+
+  if (table == CRC32_Table_CRC32) {
+    static const CRC32Slices slices(CRC32_Table_CRC32, true);
+
+#if defined(OVR_CRC32_X86)
+    if ((bytes >= 64) && GetCRC32Features().PCLMUL) {
+      const size_t folded = bytes & ~(size_t)15;
+      crc = Standard_PCLMUL(p, folded, crc);
+      p += folded;
+      bytes -= folded;
+    }
+#endif
+
+    return ~SliceBy8Reflected(slices, p, bytes, crc);
+  }
+
+  if (table == CRC32_Table_CRC32_C) {
+#if defined(OVR_CRC32_X86)
+    if (GetCRC32Features().SSE42)
+      return ~Castagnoli_SSE42(p, bytes, crc);
+#endif
+
+    static const CRC32Slices slices(CRC32_Table_CRC32_C, true);
+    return ~SliceBy8Reflected(slices, p, bytes, crc);
+  }
+
+  return CalculateCRC32Generic(table, message, messageBytes, ~crc);
+}
+
 } // namespace OVR
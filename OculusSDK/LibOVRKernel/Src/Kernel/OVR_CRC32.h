@@ -50,7 +50,9 @@ extern const uint32_t CRC32_Table_CRC32[256];
 // polynomial 0x1EDC6F41 - CRC32-C (Castagnoli): SSE4.2 [newer]
 extern const uint32_t CRC32_Table_CRC32_C[256];
 
-// CRC32 core algorithm
+// CRC32 core algorithm. For the two tables above this uses the fastest path the CPU supports:
+// PCLMULQDQ folding for CRC32, the SSE4.2 crc32 instruction for CRC32-C, and slice-by-8
+// otherwise. Other tables use a byte-table loop. Pass a previous result as crc to continue it.
 uint32_t CalculateCRC32(
     const uint32_t* OVR_RESTRICT table,
     const void* OVR_RESTRICT data,
@@ -61,14 +63,14 @@ uint32_t CalculateCRC32(
 // ***** CRC-32 Standards
 
 // This is the version you probably want to call.  It's the same one used in PKZIP.
-inline uint32_t Standard_CRC32(const void* data, int bytes) {
-  return CalculateCRC32(CRC32_Table_CRC32, data, bytes, 0);
+inline uint32_t Standard_CRC32(const void* data, int bytes, uint32_t prevCRC = 0) {
+  return CalculateCRC32(CRC32_Table_CRC32, data, bytes, prevCRC);
 }
 
-// This is a version that can be hardware accelerated with SSE4.2 and may be suitable
-// for large data in the future.
-inline uint32_t Castagnoli_CRC32(const void* data, int bytes) {
-  return CalculateCRC32(CRC32_Table_CRC32_C, data, bytes, 0);
+// This version uses the SSE4.2 crc32 instruction where available, which is fast even for short
+// messages.
+inline uint32_t Castagnoli_CRC32(const void* data, int bytes, uint32_t prevCRC = 0) {
+  return CalculateCRC32(CRC32_Table_CRC32_C, data, bytes, prevCRC);
 }
 
 } // namespace OVR
@@ -39,6 +39,7 @@ namespace OVR {
 // CallbackEmitter
 //
 // Emitter of callbacks.
+// DelegateT is one of Delegate0..3, or an InplaceFunction, which can hold a capturing lambda.
 // Thread-safety: All public members may be safely called concurrently.
 template <class DelegateT>
 class CallbackEmitter : public NewOverrideBase {
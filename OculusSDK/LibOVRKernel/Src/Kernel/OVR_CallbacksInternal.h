@@ -51,8 +51,10 @@ class CallbackListener;
 //-----------------------------------------------------------------------------
 // FloatingCallbackEmitter
 //
-// The Call() function is not thread-safe.
-// TBD: Should we add a thread-safe Call() option to constructor?
+// The Call() function is thread-safe and takes no emitter lock. Changes to the listener array
+// publish a new immutable ListenerSnapshot, which Call() picks up with a single atomic load.
+// A replaced snapshot is retired rather than freed, and retired snapshots are freed by a later
+// change once no Call() is in progress, as counted by ActiveCallCount.
 
 class CallbackEmitterBase {
  protected:
@@ -69,7 +71,8 @@ class FloatingCallbackEmitter : public CallbackEmitterBase,
 #if !defined(OVR_CC_MSVC) || (OVR_CC_VERSION > 1600) // Newer than VS2010
         ListenersExist(false),
 #endif
-        DirtyListenersCache(0) {
+        CallSnapshot(nullptr),
+        ActiveCallCount(0) {
   }
 
  public:
@@ -77,7 +80,11 @@ class FloatingCallbackEmitter : public CallbackEmitterBase,
 
   ~FloatingCallbackEmitter() {
     OVR_ASSERT(Listeners.GetSizeI() == 0);
-    // ListenersCache will be emptied here.
+    OVR_ASSERT(ActiveCallCount.load() == 0);
+
+    delete CallSnapshot.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < RetiredSnapshots.GetSize(); ++i)
+      delete RetiredSnapshots[i];
   }
 
   bool AddListener(FloatingCallbackListener<DelegateT>* listener);
@@ -127,22 +134,51 @@ class FloatingCallbackEmitter : public CallbackEmitterBase,
   std::atomic<bool> ListenersExist;
 #endif
 
-  // Is the cache dirty?  This avoids locking and memory allocation in steady state.
-  std::atomic<uint32_t> DirtyListenersCache = {0};
+  // Immutable copy of Listeners used by the Call() function, null if there are none.
+  struct ListenerSnapshot : public NewOverrideBase {
+    ListenerPtrArray Listeners;
+  };
+
+  std::atomic<ListenerSnapshot*> CallSnapshot;
+
+  // Number of Call() functions in progress, which may be using any published snapshot.
+  std::atomic<int> ActiveCallCount;
+
+  // Replaced snapshots which a Call() may still be using. Emitter lock must be held.
+  ArrayPOD<ListenerSnapshot*> RetiredSnapshots;
 
-  // Cache of listeners used by the Call() function.
-  ListenerPtrArray ListenersCacheForCalls;
+  // Counts a Call() for the duration of a scope.
+  class CallScope {
+    std::atomic<int>& Count;
+
+   public:
+    CallScope(std::atomic<int>& count) : Count(count) {
+      Count.fetch_add(1, std::memory_order_seq_cst);
+    }
+    ~CallScope() {
+      Count.fetch_sub(1, std::memory_order_release);
+    }
+  };
+
+  // Publishes a new snapshot of the listener array, in response to an insertion or removal.
+  // The emitter lock must be held.
+  void publishListenersSnapshot() {
+    ListenerSnapshot* snapshot = nullptr;
+    if (Listeners.GetSizeI() > 0) {
+      snapshot = new ListenerSnapshot;
+      snapshot->Listeners = Listeners;
+    }
 
-  // Update the ListenersCache array in response to an insertion or removal.
-  // This is how AddListener() insertions get rolled into the listeners array.
-  // This is how RemoveListener() removals get purged from the cache.
-  void updateListenersCache() {
-    if (DirtyListenersCache != 0) {
-      Lock::Locker locker(GetEmitterLock());
+    ListenerSnapshot* previous = CallSnapshot.exchange(snapshot, std::memory_order_seq_cst);
+    if (previous)
+      RetiredSnapshots.PushBack(previous);
 
-      // TBD: Should memory allocation be further reduced here?
-      ListenersCacheForCalls = Listeners;
-      DirtyListenersCache = 0;
+    // A Call() which starts after this check loads the snapshot published above, so if none
+    // is in progress now, nothing can still be using a retired snapshot.
+    if (ActiveCallCount.load(std::memory_order_seq_cst) == 0) {
+      for (size_t i = 0; i < RetiredSnapshots.GetSize(); ++i)
+        delete RetiredSnapshots[i];
+      RetiredSnapshots.Clear();
     }
   }
 
@@ -153,9 +189,8 @@ class FloatingCallbackEmitter : public CallbackEmitterBase,
       if (Listeners[i] == listener) {
         Listeners.RemoveAt(i);
 
-        // After removing it from the array, set the dirty flag.
-        // Note: Because the flag is atomic, a portable memory fence is implied.
-        DirtyListenersCache = 1;
+        // After removing it from the array, publish the change to Call().
+        publishListenersSnapshot();
 
         break;
       }
@@ -208,9 +243,8 @@ bool FloatingCallbackEmitter<DelegateT>::AddListener(
   // Add the listener to our list
   Listeners.PushBack(listener);
 
-  // After adding it to the array, set the dirty flag.
-  // Note: Because the flag is atomic, a portable memory fence is implied.
-  DirtyListenersCache = 1;
+  // After adding it to the array, publish the change to Call().
+  publishListenersSnapshot();
 
 #if !defined(OVR_CC_MSVC) || (OVR_CC_VERSION > 1600) // Newer than VS2010
   ListenersExist.store(true, std::memory_order_relaxed);
@@ -242,8 +276,7 @@ void FloatingCallbackEmitter<DelegateT>::Shutdown() {
 
   Listeners.ClearAndRelease();
 
-  // Note: Because the flag is atomic, a portable memory fence is implied.
-  DirtyListenersCache = 1;
+  publishListenersSnapshot();
 
 #if !defined(OVR_CC_MSVC) || (OVR_CC_VERSION > 1600) // Newer than VS2010
   ListenersExist.store(false, std::memory_order_relaxed);
@@ -253,20 +286,22 @@ void FloatingCallbackEmitter<DelegateT>::Shutdown() {
 //-----------------------------------------------------------------------------
 // Call function
 //
-// (1) Update the cache of listener references, if it has changed.
+// (1) Count the call and load the current snapshot of listener references.
 // (2) For each listener,
 //    (a) Hold ListenerLock.
 //    (b) If listener handler is valid, call the handler.
-#define OVR_EMITTER_CALL_BODY(params)                                               \
-  updateListenersCache();                                                           \
-  if (IsShutdown)                                                                   \
-    return; /* Pure optimization.  It is fine if this races. */                     \
-  const int count = ListenersCacheForCalls.GetSizeI();                              \
-  for (int i = 0; i < count; ++i) {                                                 \
-    Lock::Locker locker(&ListenersCacheForCalls[i]->ListenerLock);                  \
-    if (ListenersCacheForCalls[i]->Handler.IsValid()) {                             \
-      ListenersCacheForCalls[i]->Handler params; /* Using a macro for this line. */ \
-    }                                                                               \
+#define OVR_EMITTER_CALL_BODY(params)                                                  \
+  CallScope callScope(ActiveCallCount);                                                \
+  const ListenerSnapshot* snapshot = CallSnapshot.load(std::memory_order_seq_cst);     \
+  if (!snapshot)                                                                       \
+    return;                                                                            \
+  const int count = snapshot->Listeners.GetSizeI();                                    \
+  for (int i = 0; i < count; ++i) {                                                    \
+    FloatingCallbackListener<DelegateT>* listener = snapshot->Listeners[i];            \
+    Lock::Locker locker(&listener->ListenerLock);                                      \
+    if (listener->Handler.IsValid()) {                                                 \
+      listener->Handler params; /* Using a macro for this line. */                     \
+    }                                                                                  \
   }
 
 template <class DelegateT>
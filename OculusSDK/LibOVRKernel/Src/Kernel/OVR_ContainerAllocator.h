@@ -29,6 +29,8 @@ limitations under the License.
 
 #include "OVR_Allocator.h"
 #include <string.h>
+#include <type_traits>
+#include <utility>
 
 namespace OVR {
 
@@ -54,6 +56,44 @@ class ContainerAllocatorBase {
   }
 };
 
+//-----------------------------------------------------------------------------------
+// ***** Frame Arena Container Allocator
+
+// Draws from the FrameArena that's current for the calling thread (see FrameArena::Scope), or
+// from the global heap if there is none. Containers using this must be destroyed before the
+// Scope that was current when they allocated, as their memory is reclaimed at that point.
+
+class ContainerAllocatorBase_FrameArena {
+ public:
+  static void* Alloc(size_t size) {
+    FrameArena* arena = FrameArena::GetCurrent();
+    return arena ? arena->Alloc(size) : OVR_ALLOC(size);
+  }
+
+  static void* Realloc(void* p, size_t newSize) {
+    FrameArena* arena = FrameArena::GetCurrent();
+    return arena ? arena->Realloc(p, newSize) : OVR_REALLOC(p, newSize);
+  }
+
+  static void Free(void* p) {
+    FrameArena* arena = FrameArena::GetCurrent();
+    if (arena)
+      arena->Free(p);
+    else
+      OVR_FREE(p);
+  }
+};
+
+//-----------------------------------------------------------------------------------
+// ***** IsTriviallyRelocatable
+//
+// True for types that can be moved to a new address by memcpy, leaving nothing at the old
+// address to destruct. ConstructorCPP then relocates elements with Realloc or memcpy instead of
+// moving them one at a time. Specialize it for types known to qualify that aren't trivially
+// copyable, e.g. those holding only an owning pointer to the heap.
+template <class T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
 //-----------------------------------------------------------------------------------
 // ***** Constructors, Destructors, Copiers
 
@@ -73,6 +113,12 @@ class ConstructorPOD {
     *(T*)p = source;
   }
 
+  // Constructs from any constructor's arguments, without a temporary.
+  template <class... Args>
+  static void ConstructEmplace(void* p, Args&&... args) {
+    OVR::ConstructEmplace<T>(p, std::forward<Args>(args)...);
+  }
+
   static void ConstructArray(void*, size_t) {}
 
   static void ConstructArray(void* p, size_t count, const T& source) {
@@ -97,6 +143,11 @@ class ConstructorPOD {
     memmove(dst, src, count * sizeof(T));
   }
 
+  // Moves count elements to uninitialized dst, leaving src uninitialized.
+  static void Relocate(T* dst, T* src, size_t count) {
+    memcpy((void*)dst, (const void*)src, count * sizeof(T));
+  }
+
   static bool IsMovable() {
     return true;
   }
@@ -123,6 +174,12 @@ class ConstructorMov {
     OVR::ConstructAlt<T, S>(p, source);
   }
 
+  // Constructs from any constructor's arguments, without a temporary.
+  template <class... Args>
+  static void ConstructEmplace(void* p, Args&&... args) {
+    OVR::ConstructEmplace<T>(p, std::forward<Args>(args)...);
+  }
+
   static void ConstructArray(void* p, size_t count) {
     uint8_t* pdata = (uint8_t*)p;
     for (size_t i = 0; i < count; ++i, pdata += sizeof(T))
@@ -159,6 +216,11 @@ class ConstructorMov {
     memmove(dst, src, count * sizeof(T));
   }
 
+  // Moves count elements to uninitialized dst, leaving src uninitialized.
+  static void Relocate(T* dst, T* src, size_t count) {
+    memcpy((void*)dst, (const void*)src, count * sizeof(T));
+  }
+
   static bool IsMovable() {
     return true;
   }
@@ -185,6 +247,12 @@ class ConstructorCPP {
     OVR::ConstructAlt<T, S>(p, source);
   }
 
+  // Constructs from any constructor's arguments, without a temporary.
+  template <class... Args>
+  static void ConstructEmplace(void* p, Args&&... args) {
+    OVR::ConstructEmplace<T>(p, std::forward<Args>(args)...);
+  }
+
   static void ConstructArray(void* p, size_t count) {
     uint8_t* pdata = (uint8_t*)p;
     for (size_t i = 0; i < count; ++i, pdata += sizeof(T))
@@ -223,8 +291,21 @@ class ConstructorCPP {
       dst[i - 1] = src[i - 1];
   }
 
+  // Moves count elements to uninitialized dst, leaving src uninitialized.
+  static void Relocate(T* dst, T* src, size_t count) {
+    if (IsTriviallyRelocatable<T>::value) {
+      memcpy((void*)dst, (const void*)src, count * sizeof(T));
+    } else {
+      for (size_t i = 0; i < count; ++i) {
+        ::new (dst + i) T(std::move(src[i]));
+        src[i].~T();
+      }
+    }
+  }
+
+  // Trivially relocatable types can be reallocated in place, others must be moved element-wise.
   static bool IsMovable() {
-    return false;
+    return IsTriviallyRelocatable<T>::value;
   }
 };
 
@@ -238,6 +319,10 @@ template <class T>
 struct ContainerAllocator : ContainerAllocatorBase, ConstructorMov<T> {};
 template <class T>
 struct ContainerAllocator_CPP : ContainerAllocatorBase, ConstructorCPP<T> {};
+template <class T>
+struct ContainerAllocator_FrameArena_POD : ContainerAllocatorBase_FrameArena, ConstructorPOD<T> {};
+template <class T>
+struct ContainerAllocator_FrameArena : ContainerAllocatorBase_FrameArena, ConstructorMov<T> {};
 
 } // namespace OVR
 
@@ -21,16 +21,20 @@ limitations under the License.
 ************************************************************************************/
 
 #include "OVR_DebugHelp.h"
+#include "OVR_Allocator.h"
 #include "OVR_Types.h"
 #include "OVR_UTF8Util.h"
 #include "OVR_Atomic.h"
 #include "OVR_SysFile.h"
 #include "OVR_Log.h"
 #include "OVR_Std.h"
+#include "OVR_FlightRecorder.h"
 #include "Util/Util_SystemGUI.h"
 
 #include <stdlib.h>
 #include <time.h>
+#include <algorithm>
+#include <unordered_map>
 
 #if defined(OVR_OS_WIN32) || defined(OVR_OS_WIN64)
 #pragma warning(push, 0)
@@ -1553,12 +1557,77 @@ bool SymbolLookup::IsInitialized() {
 void SymbolLookup::Shutdown() {}
 #endif
 
+//-----------------------------------------------------------------------------------
+// ***** SymbolLookupCache
+//
+// Symbols already looked up, keyed by module base address and offset within the module.
+// It allocates only through SysMemAlloc, as the Allocator looks up symbols for its tracking
+// reports while it may be intercepting the CRT heap.
+
+struct SymbolCacheKey {
+  uint64_t moduleBase; // 0 for addresses which aren't within a known module.
+  uint64_t offset;
+
+  bool operator==(const SymbolCacheKey& other) const {
+    return (moduleBase == other.moduleBase) && (offset == other.offset);
+  }
+};
+
+struct SymbolCacheKeyHash {
+  size_t operator()(const SymbolCacheKey& key) const {
+    return (size_t)((key.moduleBase * UINT64_C(0x9E3779B97F4A7C15)) ^ key.offset);
+  }
+};
+
+struct CachedSymbol {
+  CachedSymbol()
+      : size(kMISizeInvalid),
+        fileLineNumber(kMILineNumberInvalid),
+        functionOffset(kMIFunctionOffsetInvalid),
+        function(),
+        filePath() {}
+
+  uint64_t size;
+  int32_t fileLineNumber;
+  int32_t functionOffset;
+  SysAllocatedString function;
+  SysAllocatedString filePath;
+};
+
+struct SymbolLookupCache {
+  // The cache is cleared when it reaches this size, which a process's backtraces rarely exceed.
+  static const size_t MaxEntries = 65536;
+
+  typedef std::unordered_map<
+      SymbolCacheKey,
+      CachedSymbol,
+      SymbolCacheKeyHash,
+      std::equal_to<SymbolCacheKey>,
+      StdAllocatorSysMem<std::pair<const SymbolCacheKey, CachedSymbol>>>
+      SymbolMap;
+
+  OVR::Lock CacheLock; // Guards Symbols, and serializes LookupSymbols calls which use it.
+  SymbolMap Symbols;
+};
+
 SymbolLookup::SymbolLookup()
     : AllowMemoryAllocation(true),
       ModuleListUpdated(false),
       ModuleInfoArray(),
       ModuleInfoArraySize(0),
-      currentModuleInfo{} {}
+      currentModuleInfo{},
+      Cache(nullptr) {
+  void* pCache = SysMemAlloc(sizeof(SymbolLookupCache));
+  if (pCache)
+    Cache = new (pCache) SymbolLookupCache;
+}
+
+SymbolLookup::~SymbolLookup() {
+  if (Cache) {
+    Cache->~SymbolLookupCache();
+    SysMemFree(Cache, sizeof(SymbolLookupCache));
+  }
+}
 
 void SymbolLookup::AddSourceCodeDirectory(const char* pDirectory) {
   OVR_UNUSED(pDirectory);
@@ -1570,6 +1639,7 @@ void SymbolLookup::EnableMemoryAllocation(bool enabled) {
 
 bool SymbolLookup::Refresh() {
   ModuleListUpdated = false;
+  ClearSymbolCache();
   return RefreshModuleList();
 }
 
@@ -1671,6 +1741,12 @@ size_t SymbolLookup::GetBacktrace(
 #elif defined(OVR_OS_WIN32)
   OVR_UNUSED(threadSysIdHelp);
 
+  // For the current thread this follows the frame pointers, which is much faster than StackWalk64
+  // and needs no lock, but stops early at functions which omit them.
+  if (platformThreadContext == nullptr)
+    return RtlCaptureStackBackTrace(
+        (DWORD)skipCount, (ULONG)addressArrayCapacity, addressArray, nullptr);
+
   OVR::Lock::Locker autoLock(GetSymbolLookupLockPtr());
   size_t frameIndex = 0;
 
@@ -1840,6 +1916,62 @@ size_t SymbolLookup::GetBacktrace(
     }
   }
 
+  return frameIndex;
+
+#elif defined(OVR_OS_LINUX) && defined(__GNUC__)
+  // Follows the frame pointers of the current thread, which requires code built with
+  // -fno-omit-frame-pointer. The walk stops at the first frame which isn't within the thread's
+  // stack or above the previous frame.
+  OVR_UNUSED(threadSysIdHelp);
+
+  if (platformThreadContext)
+    return 0;
+
+  struct StackFrame {
+    StackFrame* pParentStackFrame;
+    void* pReturnPC;
+  };
+
+  static thread_local uintptr_t stackLimit = 0;
+  static thread_local uintptr_t stackBase = 0;
+
+  if (stackBase == 0) {
+    pthread_attr_t threadAttr;
+
+    if (pthread_getattr_np(pthread_self(), &threadAttr) == 0) {
+      void* stackAddress = nullptr;
+      size_t stackSize = 0;
+
+      if (pthread_attr_getstack(&threadAttr, &stackAddress, &stackSize) == 0) {
+        stackLimit = (uintptr_t)stackAddress;
+        stackBase = stackLimit + stackSize;
+      }
+
+      pthread_attr_destroy(&threadAttr);
+    }
+
+    if (stackBase == 0)
+      return 0;
+  }
+
+  size_t frameIndex = 0;
+  StackFrame* pStackFrame = (StackFrame*)__builtin_frame_address(0);
+
+  while (pStackFrame && (frameIndex < addressArrayCapacity) &&
+         ((uintptr_t)pStackFrame >= stackLimit) &&
+         (((uintptr_t)pStackFrame + sizeof(StackFrame)) <= stackBase) &&
+         (((uintptr_t)pStackFrame & (sizeof(void*) - 1)) == 0) && pStackFrame->pReturnPC) {
+    if (skipCount)
+      --skipCount;
+    else
+      addressArray[frameIndex++] = pStackFrame->pReturnPC;
+
+    if (pStackFrame->pParentStackFrame <= pStackFrame)
+      break;
+
+    pStackFrame = pStackFrame->pParentStackFrame;
+  }
+
   return frameIndex;
 #else
   OVR_UNUSED(addressArray);
@@ -2450,12 +2582,90 @@ bool SymbolLookup::LookupSymbols(
     uint64_t* addressArray,
     SymbolInfo* pSymbolInfoArray,
     size_t arraySize) {
-  bool success = false;
-
   if (!ModuleListUpdated) {
     RefreshModuleList();
   }
 
+  // The cache allocates memory, which may not be possible within an exception handler.
+  if (!AllowMemoryAllocation || !Cache)
+    return ResolveSymbols(addressArray, pSymbolInfoArray, arraySize);
+
+  typedef std::vector<uint64_t, StdAllocatorSysMem<uint64_t>> AddressVector;
+  typedef std::vector<SymbolInfo, StdAllocatorSysMem<SymbolInfo>> SymbolInfoVector;
+
+  OVR::Lock::Locker autoLock(&Cache->CacheLock);
+  SymbolLookupCache::SymbolMap& symbols = Cache->Symbols;
+
+  if ((symbols.size() + arraySize) > SymbolLookupCache::MaxEntries)
+    symbols.clear();
+
+  // Find the distinct addresses which aren't cached yet, and resolve them in one batch.
+  AddressVector missing;
+  for (size_t i = 0; i < arraySize; ++i) {
+    const ModuleInfo* pModuleInfo = GetModuleInfoForAddress(addressArray[i]);
+    const uint64_t moduleBase = pModuleInfo ? pModuleInfo->baseAddress : 0;
+    if (symbols.find({moduleBase, addressArray[i] - moduleBase}) == symbols.end())
+      missing.push_back(addressArray[i]);
+  }
+
+  if (!missing.empty()) {
+    std::sort(missing.begin(), missing.end());
+    missing.erase(std::unique(missing.begin(), missing.end()), missing.end());
+
+    SymbolInfoVector resolved(missing.size());
+    ResolveSymbols(missing.data(), resolved.data(), missing.size());
+
+    for (size_t i = 0; i < missing.size(); ++i) {
+      const SymbolInfo& symbolInfo = resolved[i];
+      const ModuleInfo* pModuleInfo = GetModuleInfoForAddress(missing[i]);
+      const uint64_t moduleBase = pModuleInfo ? pModuleInfo->baseAddress : 0;
+      CachedSymbol& cachedSymbol = symbols[{moduleBase, missing[i] - moduleBase}];
+      cachedSymbol.size = symbolInfo.size;
+      cachedSymbol.fileLineNumber = symbolInfo.fileLineNumber;
+      cachedSymbol.functionOffset = symbolInfo.functionOffset;
+      cachedSymbol.function = symbolInfo.function;
+      cachedSymbol.filePath = symbolInfo.filePath;
+    }
+  }
+
+  bool success = false;
+
+  for (size_t i = 0; i < arraySize; ++i) {
+    SymbolInfo& symbolInfo = pSymbolInfoArray[i];
+    symbolInfo.address = addressArray[i];
+    symbolInfo.pModuleInfo = GetModuleInfoForAddress(addressArray[i]);
+
+    const uint64_t moduleBase = symbolInfo.pModuleInfo ? symbolInfo.pModuleInfo->baseAddress : 0;
+    const CachedSymbol& cachedSymbol = symbols[{moduleBase, addressArray[i] - moduleBase}];
+    symbolInfo.size = cachedSymbol.size;
+    symbolInfo.fileLineNumber = cachedSymbol.fileLineNumber;
+    symbolInfo.functionOffset = cachedSymbol.functionOffset;
+    OVR_strlcpy(
+        symbolInfo.function, cachedSymbol.function.c_str(), OVR_ARRAY_COUNT(symbolInfo.function));
+    OVR_strlcpy(
+        symbolInfo.filePath, cachedSymbol.filePath.c_str(), OVR_ARRAY_COUNT(symbolInfo.filePath));
+    symbolInfo.sourceCode[0] = '\0';
+
+    if (symbolInfo.function[0] || symbolInfo.filePath[0])
+      success = true;
+  }
+
+  return success;
+}
+
+void SymbolLookup::ClearSymbolCache() {
+  if (Cache) {
+    OVR::Lock::Locker autoLock(&Cache->CacheLock);
+    Cache->Symbols.clear();
+  }
+}
+
+bool SymbolLookup::ResolveSymbols(
+    uint64_t* addressArray,
+    SymbolInfo* pSymbolInfoArray,
+    size_t arraySize) {
+  bool success = false;
+
 #if defined(OVR_OS_MS)
   OVR::Lock::Locker autoLock(GetSymbolLookupLockPtr());
 
@@ -2651,6 +2861,23 @@ const ModuleInfo* SymbolLookup::GetModuleInfoForAddress(uint64_t address) {
   return nullptr;
 }
 
+const ModuleInfo* SymbolLookup::GetModuleInfoForFilePath(const char* filePath) {
+  if (!ModuleListUpdated) {
+    RefreshModuleList();
+  }
+
+  for (size_t i = 0; i < ModuleInfoArraySize; ++i) {
+#if defined(OVR_OS_MS)
+    if (OVR_stricmp(ModuleInfoArray[i].filePath, filePath) == 0)
+#else
+    if (strcmp(ModuleInfoArray[i].filePath, filePath) == 0)
+#endif
+      return &ModuleInfoArray[i];
+  }
+
+  return nullptr;
+}
+
 const ModuleInfo& SymbolLookup::GetModuleInfoForCurrentModule() {
   OVR_ASSERT(ModuleInfoArraySize > 0); // We expect that the modules have been iterated previously.
   if (currentModuleInfo.baseAddress == 0) { // If the current module hasn't been identified yet...
@@ -2662,6 +2889,182 @@ const ModuleInfo& SymbolLookup::GetModuleInfoForCurrentModule() {
   return currentModuleInfo;
 }
 
+//-----------------------------------------------------------------------------------
+// ***** BacktraceCapture
+
+BacktraceCapture::BacktraceCapture()
+    : Modules(), Addresses(), BacktraceBegins(), ModulesCaptured(false) {}
+
+void BacktraceCapture::CaptureModules() {
+  Modules.resize(256);
+  size_t requiredCount = SymbolLookup::GetModuleInfoArray(Modules.data(), Modules.size());
+
+  if (requiredCount > Modules.size()) {
+    Modules.resize(requiredCount);
+    requiredCount = SymbolLookup::GetModuleInfoArray(Modules.data(), Modules.size());
+  }
+
+  Modules.resize(MIN(requiredCount, Modules.size()));
+  ModulesCaptured = true;
+}
+
+size_t BacktraceCapture::AddBacktrace(void* const* addressArray, size_t addressCount) {
+  if (!ModulesCaptured)
+    CaptureModules();
+
+  BacktraceBegins.push_back(Addresses.size());
+  for (size_t i = 0; i < addressCount; ++i)
+    Addresses.push_back((uint64_t)(uintptr_t)addressArray[i]);
+
+  return BacktraceBegins.size() - 1;
+}
+
+const uint64_t* BacktraceCapture::GetBacktrace(size_t index, size_t& addressCount) const {
+  if (index >= BacktraceBegins.size()) {
+    addressCount = 0;
+    return nullptr;
+  }
+
+  const size_t end =
+      ((index + 1) < BacktraceBegins.size()) ? BacktraceBegins[index + 1] : Addresses.size();
+  addressCount = end - BacktraceBegins[index];
+  return Addresses.data() + BacktraceBegins[index];
+}
+
+void BacktraceCapture::Clear() {
+  Modules.clear();
+  Addresses.clear();
+  BacktraceBegins.clear();
+  ModulesCaptured = false;
+}
+
+uint64_t BacktraceCapture::RebaseAddress(SymbolLookup& symbolLookup, uint64_t address) const {
+  for (const ModuleInfo& capturedModule : Modules) {
+    if ((capturedModule.baseAddress <= address) &&
+        (address < (capturedModule.baseAddress + capturedModule.size))) {
+      const ModuleInfo* currentModule = symbolLookup.GetModuleInfoForFilePath(
+          capturedModule.filePath);
+      if (currentModule)
+        return currentModule->baseAddress + (address - capturedModule.baseAddress);
+      break;
+    }
+  }
+
+  return address;
+}
+
+size_t BacktraceCapture::Symbolize(
+    SymbolLookup& symbolLookup,
+    size_t index,
+    SymbolInfo* pSymbolInfoArray,
+    size_t capacity) {
+  size_t addressCount;
+  const uint64_t* addressArray = GetBacktrace(index, addressCount);
+  addressCount = MIN(addressCount, capacity);
+
+  std::vector<uint64_t> rebasedArray(addressCount);
+  for (size_t i = 0; i < addressCount; ++i)
+    rebasedArray[i] = RebaseAddress(symbolLookup, addressArray[i]);
+
+  if (addressCount)
+    symbolLookup.LookupSymbols(rebasedArray.data(), pSymbolInfoArray, addressCount);
+
+  for (size_t i = 0; i < addressCount; ++i)
+    pSymbolInfoArray[i].address = addressArray[i];
+
+  return addressCount;
+}
+
+// The file is text: a header line, then a line per module ("module <base> <size> <path>") and
+// a line per backtrace ("backtrace <count> <address>..."), with numbers in hex.
+static const char* const kBacktraceCaptureHeader = "OVRBacktraceCapture 1";
+
+bool BacktraceCapture::Save(const char* path) const {
+  FILE* file = fopen(path, "w");
+  if (!file)
+    return false;
+
+  bool success = (fprintf(file, "%s\n", kBacktraceCaptureHeader) > 0);
+
+  for (size_t i = 0; success && (i < Modules.size()); ++i)
+    success = (fprintf(
+                   file,
+                   "module %llx %llx %s\n",
+                   (unsigned long long)Modules[i].baseAddress,
+                   (unsigned long long)Modules[i].size,
+                   Modules[i].filePath) > 0);
+
+  for (size_t i = 0; success && (i < BacktraceBegins.size()); ++i) {
+    size_t addressCount;
+    const uint64_t* addressArray = GetBacktrace(i, addressCount);
+
+    success = (fprintf(file, "backtrace %x", (unsigned)addressCount) > 0);
+    for (size_t j = 0; success && (j < addressCount); ++j)
+      success = (fprintf(file, " %llx", (unsigned long long)addressArray[j]) > 0);
+    success = success && (fputc('\n', file) != EOF);
+  }
+
+  return (fclose(file) == 0) && success;
+}
+
+bool BacktraceCapture::Load(const char* path) {
+  Clear();
+
+  FILE* file = fopen(path, "r");
+  if (!file)
+    return false;
+
+  char line[OVR_MAX_PATH + 64];
+  bool success = fgets(line, sizeof(line), file) &&
+      (strncmp(line, kBacktraceCaptureHeader, strlen(kBacktraceCaptureHeader)) == 0);
+  char keyword[16];
+
+  while (success && (fscanf(file, "%15s", keyword) == 1)) {
+    if (strcmp(keyword, "module") == 0) {
+      ModuleInfo moduleInfo;
+      unsigned long long baseAddress, size;
+
+      success = (fscanf(file, "%llx %llx ", &baseAddress, &size) == 2) &&
+          fgets(moduleInfo.filePath, sizeof(moduleInfo.filePath), file);
+
+      if (success) {
+        moduleInfo.filePath[strcspn(moduleInfo.filePath, "\r\n")] = '\0';
+        moduleInfo.baseAddress = baseAddress;
+        moduleInfo.size = size;
+
+        const char* name = moduleInfo.filePath;
+        for (const char* p = moduleInfo.filePath; *p; ++p) {
+          if ((*p == '/') || (*p == '\\'))
+            name = p + 1;
+        }
+        OVR_strlcpy(moduleInfo.name, name, sizeof(moduleInfo.name));
+
+        Modules.push_back(moduleInfo);
+      }
+    } else if (strcmp(keyword, "backtrace") == 0) {
+      unsigned addressCount;
+      success = (fscanf(file, "%x", &addressCount) == 1);
+
+      BacktraceBegins.push_back(Addresses.size());
+      for (unsigned i = 0; success && (i < addressCount); ++i) {
+        unsigned long long address;
+        success = (fscanf(file, "%llx", &address) == 1);
+        Addresses.push_back(address);
+      }
+    } else {
+      success = false;
+    }
+  }
+
+  fclose(file);
+  ModulesCaptured = true;
+
+  if (!success)
+    Clear();
+
+  return success;
+}
+
 ExceptionInfo::ExceptionInfo()
     : time(),
       timeVal(0),
@@ -3980,6 +4383,16 @@ void ExceptionHandler::WriteReport(const char* reportType) {
     // To consider: print exceptionInfo.cpuContext registers
   }
 
+  {
+    // Print the most recent flight recorder events, which show what led up to the report.
+    WriteReportLine("\nFlight recorder\n");
+    FlightRecorder::Dump(
+        [](void* context, const char* line) {
+          static_cast<ExceptionHandler*>(context)->WriteReportLine(line);
+        },
+        this);
+  }
+
 #if defined(OVR_OS_WIN32)
   {
     WriteReportLine("\nApp Info\n");
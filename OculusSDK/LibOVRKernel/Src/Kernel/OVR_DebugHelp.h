@@ -32,6 +32,7 @@ limitations under the License.
 
 #include <stdio.h>
 #include <time.h>
+#include <vector>
 
 #if defined(OVR_OS_WIN32) || defined(OVR_OS_WIN64)
 #include "OVR_Win32_IncludeWindows.h"
@@ -355,11 +356,15 @@ struct SymbolInfo {
         sourceCode() {}
 };
 
+struct SymbolLookupCache;
+
 // Implements support for reading thread lists, module lists, backtraces, and backtrace symbols.
 class SymbolLookup {
+  OVR_NON_COPYABLE(SymbolLookup)
+
  public:
   SymbolLookup();
-  ~SymbolLookup() = default;
+  ~SymbolLookup();
 
   // Every successful call to Initialize must be eventually matched by a call to Shutdown.
   // Shutdown should be called if and only if Initialize returns true.
@@ -375,6 +380,7 @@ class SymbolLookup {
   void EnableMemoryAllocation(bool enabled);
 
   // Refresh our view of the symbols and modules present within the current process.
+  // Also discards the symbol cache, as a module may since have been loaded at a reused address.
   bool Refresh();
 
   // Retrieves the backtrace (call stack) of the given thread. There may be some per-platform
@@ -385,6 +391,8 @@ class SymbolLookup {
   // For Apple platforms the platformThreadContext is x86_thread_state_t* or arm_thread_state_t*.
   // If threadSysIdHelp is non-zero, it may be used by the implementation to help produce a better
   // backtrace.
+  // For the current thread (platformThreadContext == nullptr) this only reads return addresses,
+  // without locks or the OS stack walker, so it's cheap enough to call on every allocation.
   static size_t GetBacktrace(
       void* addressArray[],
       size_t addressArrayCapacity,
@@ -451,20 +459,32 @@ class SymbolLookup {
   bool ReportModuleInformation(OVR::String& sOutput);
 
   // Retrieves symbol info for the given address.
+  // Results are cached by module and offset, so looking up an address again is cheap, and
+  // LookupSymbols resolves each distinct address of the array only once. The cache isn't used
+  // while memory allocation is disabled. sourceCode is never filled in from the cache.
   bool LookupSymbol(uint64_t address, SymbolInfo& symbolInfo);
   bool LookupSymbols(uint64_t* addressArray, SymbolInfo* pSymbolInfoArray, size_t arraySize);
 
+  // Discards the symbols cached by LookupSymbols.
+  void ClearSymbolCache();
+
   // The returned ModuleInfo points to an internal structure. This function assumes that the
   // internal cached ModuleInfo array is valid. If modules are dynamically added or removed
   // during runtime then the array may be partially out of date.
   // May return NULL if there was no found module for the address.
   const ModuleInfo* GetModuleInfoForAddress(uint64_t address);
 
+  // Returns the module loaded from the given file path, or NULL if there is none.
+  const ModuleInfo* GetModuleInfoForFilePath(const char* filePath);
+
   const ModuleInfo& GetModuleInfoForCurrentModule();
 
  protected:
   bool RefreshModuleList();
 
+  // Looks up symbols through the platform, without the cache.
+  bool ResolveSymbols(uint64_t* addressArray, SymbolInfo* pSymbolInfoArray, size_t arraySize);
+
  protected:
   // True by default. If true then we allow allocating memory (and as a
   // result provide less information). This is useful for when in an
@@ -479,6 +499,63 @@ class SymbolLookup {
 
   // The ModuleInfo for the current module, which is often needed and so we make a member for it.
   ModuleInfo currentModuleInfo;
+
+  // Symbols looked up so far. Allocated with SysMemAlloc, and may be null if that failed.
+  SymbolLookupCache* Cache;
+};
+
+// BacktraceCapture
+// Raw backtraces plus the module list they were captured against, for symbolizing later.
+// AddBacktrace only copies addresses, so it's cheap enough to use while measuring, and the
+// lookups happen in Symbolize afterwards. A capture can be written to a file and symbolized by a
+// later run of the same binaries: addresses are rebased to wherever the module with the same file
+// path is loaded at the time.
+class BacktraceCapture {
+ public:
+  BacktraceCapture();
+
+  // Snapshots the module list of the current process. AddBacktrace does this if it hasn't been
+  // done yet; call it again after loading modules whose addresses will be captured.
+  void CaptureModules();
+
+  // Returns the index of the added backtrace.
+  size_t AddBacktrace(void* const* addressArray, size_t addressCount);
+
+  size_t GetBacktraceCount() const {
+    return BacktraceBegins.size();
+  }
+
+  // Returns the addresses of a backtrace as captured, and writes their count.
+  const uint64_t* GetBacktrace(size_t index, size_t& addressCount) const;
+
+  const std::vector<ModuleInfo>& GetModules() const {
+    return Modules;
+  }
+
+  void Clear();
+
+  // Looks up the symbols of a backtrace through the given lookup, writing up to capacity of them.
+  // Returns the number written. SymbolInfo::address is the address as captured, and
+  // SymbolInfo::pModuleInfo refers to the lookup's module, which may be at a different address.
+  size_t Symbolize(
+      SymbolLookup& symbolLookup,
+      size_t index,
+      SymbolInfo* pSymbolInfoArray,
+      size_t capacity);
+
+  // Saves or loads the modules and backtraces, as text. Load replaces the current contents.
+  bool Save(const char* path) const;
+  bool Load(const char* path);
+
+ protected:
+  // Returns the address in the current process which corresponds to a captured address, or the
+  // captured address itself if its module isn't loaded.
+  uint64_t RebaseAddress(SymbolLookup& symbolLookup, uint64_t address) const;
+
+  std::vector<ModuleInfo> Modules;
+  std::vector<uint64_t> Addresses; // Of all backtraces, one after another.
+  std::vector<size_t> BacktraceBegins; // Index in Addresses of each backtrace's first address.
+  bool ModulesCaptured;
 };
 
 // ExceptionInfo
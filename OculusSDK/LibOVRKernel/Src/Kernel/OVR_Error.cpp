@@ -229,20 +229,22 @@ OVRError& OVRError::operator=(OVRError&& ovrError) {
   return *this;
 }
 
-void OVRError::SetCurrentValues() {
+void OVRError::SetCurrentValues(bool captureBacktrace) {
   OVRTime = Timer::GetSeconds(); // It would be better if we called ovr_GetTimeInSeconds, but that
   // doesn't have a constant header to use.
 
   ClockTime = std::chrono::system_clock::now();
 
 #if defined(OVR_ERROR_ENABLE_BACKTRACES)
-  if (Symbols.IsInitialized()) {
+  if (captureBacktrace && Symbols.IsInitialized()) {
     void* addressArray[32];
     size_t n = Symbols.GetBacktrace(
         addressArray, OVR_ARRAY_COUNT(addressArray), 2, nullptr, OVR_THREADSYSID_INVALID);
     Backtrace.Clear();
     Backtrace.Append(addressArray, n);
   }
+#else
+  OVR_UNUSED(captureBacktrace);
 #endif
 }
 
@@ -439,6 +441,52 @@ void SetErrorCallback(OVRErrorCallback callback) {
   ErrorCallback = callback;
 }
 
+// ***** Error site rate limiting
+//
+// A call site making more than ErrorSiteBurst errors within ErrorSiteWindowSeconds has the rest
+// made without a backtrace and without being logged, until the window is up. Frequent recoverable
+// errors, such as from polling a missing device, then cost a map lookup instead of a stack walk and
+// a log write each time. Sites are keyed by return address, as release builds have no file/line.
+
+static const double ErrorSiteWindowSeconds = 1.0;
+static const int ErrorSiteBurst = 4;
+
+struct ErrorSiteState {
+  double WindowStart;
+  int Count; // Errors in the current window
+  int Suppressed; // Errors not logged since the last that was
+};
+
+typedef std::unordered_map<void*, ErrorSiteState> ErrorSiteMap;
+
+static std::mutex ErrorSiteMutex;
+
+static ErrorSiteMap& GetErrorSiteMap() {
+  static ErrorSiteMap errorSiteMap;
+  return errorSiteMap;
+}
+
+// Returns false if the site's error is to be rate limited. Else suppressedCount is set to how many
+// of its errors weren't logged since the last that was.
+static bool AdmitErrorSite(void* site, double now, int& suppressedCount) {
+  std::lock_guard<std::mutex> lock(ErrorSiteMutex);
+
+  ErrorSiteState& state = GetErrorSiteMap()[site];
+  if ((state.Count == 0) || (now - state.WindowStart >= ErrorSiteWindowSeconds)) {
+    state.WindowStart = now;
+    state.Count = 0;
+  }
+
+  if (++state.Count > ErrorSiteBurst) {
+    state.Suppressed++;
+    return false;
+  }
+
+  suppressedCount = state.Suppressed;
+  state.Suppressed = 0;
+  return true;
+}
+
 OVRError MakeError(
     ovrResult errorCode,
     ovrSysErrorCodeType sysCodeType,
@@ -453,16 +501,29 @@ OVRError MakeError(
     ...) {
   OVRError ovrError(errorCode);
 
-  ovrError.SetCurrentValues(); // Sets the current time, etc.
+  int suppressedCount = 0;
+  const bool admitted = AdmitErrorSite(OVRGetReturnAddress(), Timer::GetSeconds(), suppressedCount);
+
+  ovrError.SetCurrentValues(admitted); // Sets the current time, etc.
 
   ovrError.SetSysCode(sysCodeType, sysCode, sysCodeString);
 
+  // Most descriptions fit on the stack; only longer ones need the heap.
+  char description[512];
   va_list argList;
   va_start(argList, pDescriptionFormat);
-  StringBuffer strbuff;
-  strbuff.AppendFormatV(pDescriptionFormat, argList);
+  int descriptionLength = vsnprintf(description, sizeof(description), pDescriptionFormat, argList);
   va_end(argList);
-  ovrError.SetDescription(strbuff.ToCStr());
+
+  if (descriptionLength >= (int)sizeof(description)) {
+    va_start(argList, pDescriptionFormat);
+    StringBuffer strbuff;
+    strbuff.AppendFormatV(pDescriptionFormat, argList);
+    va_end(argList);
+    ovrError.SetDescription(strbuff.ToCStr());
+  } else {
+    ovrError.SetDescription((descriptionLength >= 0) ? description : nullptr);
+  }
 
   ovrError.SetContext(pContext);
 
@@ -479,8 +540,15 @@ OVRError MakeError(
   if (silencerOptions & ovrlog::ErrorSilencer::PreventErrorAsserts)
     assertError = false;
 
-  if (logError)
-    Logger.LogError(ovrError.GetErrorString().ToCStr());
+  if (logError && admitted) {
+    if (suppressedCount)
+      Logger.LogErrorF(
+          "%s  Not logged: %d more from this site\n",
+          ovrError.GetErrorString().ToCStr(),
+          suppressedCount);
+    else
+      Logger.LogError(ovrError.GetErrorString().ToCStr());
+  }
 
   if (assertError) {
     // Assert in debug mode to alert unit tester/developer of the error as it occurs.
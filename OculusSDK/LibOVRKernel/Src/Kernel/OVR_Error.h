@@ -466,8 +466,9 @@ class OVRError {
     return !Succeeded();
   }
 
-  // Sets the OVRTime, ClockTime, Backtrace to current values.
-  void SetCurrentValues(); // To do: Come up with a more appropiate name.
+  // Sets the OVRTime, ClockTime, Backtrace to current values. The backtrace is only raw addresses;
+  // it's left empty if captureBacktrace is false.
+  void SetCurrentValues(bool captureBacktrace = true); // To do: Come up with a more appropiate name.
 
   // Clears all members to a newly default-constructed state.
   void Reset();
@@ -568,6 +569,10 @@ void LogError(OVRError& ovrError);
 /// file/line functionality cleanly between debug and release. The "quiet" parameter will prevent it
 /// from automatically logging/asserting.
 ///
+/// Errors are rate limited per call site: past a few within a second, the site's errors are made
+/// without a backtrace and aren't logged until the second is up, when the next one logged says how
+/// many weren't. They are still returned, set as the last error and passed to the error callback.
+///
 OVRError MakeError(
     ovrResult errorCode,
     ovrSysErrorCodeType sysCodeType,
@@ -35,30 +35,34 @@ limitations under the License.
 namespace OVR {
 
 // Buffered file adds buffering to an existing file
-// FILEBUFFER_SIZE defines the size of internal buffer, while
-// FILEBUFFER_TOLERANCE controls the amount of data we'll effectively try to buffer
-#define FILEBUFFER_SIZE (8192 - 8)
-#define FILEBUFFER_TOLERANCE 4096
+// BufferSize defines the size of internal buffer, while half of it
+// controls the amount of data we'll effectively try to buffer when writing
 
 // ** Constructor/Destructor
 
 // Hidden constructor
 // Not supposed to be used
 BufferedFile::BufferedFile() : DelegatedFile(0) {
-  pBuffer = (uint8_t*)OVR_ALLOC(FILEBUFFER_SIZE);
+  pBuffer = (uint8_t*)OVR_ALLOC(DefaultBufferSize);
   BufferMode = NoBuffer;
   FilePos = 0;
   Pos = 0;
   DataSize = 0;
+  BufferSize = BufferCapacity = ReadAheadSize = DefaultBufferSize;
+  ReadAheadPos = 0;
 }
 
 // Takes another file as source
-BufferedFile::BufferedFile(File* pfile) : DelegatedFile(pfile) {
-  pBuffer = (uint8_t*)OVR_ALLOC(FILEBUFFER_SIZE);
+BufferedFile::BufferedFile(File* pfile, unsigned bufferSize) : DelegatedFile(pfile) {
+  if (!bufferSize)
+    bufferSize = DefaultBufferSize;
+  pBuffer = (uint8_t*)OVR_ALLOC(bufferSize);
   BufferMode = NoBuffer;
   FilePos = pfile->LTell();
   Pos = 0;
   DataSize = 0;
+  BufferSize = BufferCapacity = ReadAheadSize = bufferSize;
+  ReadAheadPos = FilePos;
 }
 
 // Destructor
@@ -89,6 +93,22 @@ bool    BufferedFile::VCopy(const Object &source)
 }
 */
 
+bool BufferedFile::SetBufferSize(unsigned bufferSize) {
+  if (!bufferSize)
+    bufferSize = DefaultBufferSize;
+
+  if (pFile)
+    FlushBuffer();
+
+  uint8_t* newBuffer = (uint8_t*)OVR_REALLOC(pBuffer, bufferSize);
+  if (!newBuffer)
+    return false;
+
+  pBuffer = newBuffer;
+  BufferSize = BufferCapacity = ReadAheadSize = bufferSize;
+  return true;
+}
+
 // Initializes buffering to a certain mode
 bool BufferedFile::SetBufferMode(BufferModeType mode) {
   if (!pBuffer)
@@ -137,11 +157,30 @@ void BufferedFile::LoadBuffer() {
     // We should only reload once all of pre-loaded buffer is consumed.
     OVR_ASSERT(Pos == DataSize);
 
+    // Read further ahead for as long as loads follow on from each other, since that's a
+    // sequential read of a large file. If the larger buffer can't be had, stay at the old size.
+    if (FilePos == ReadAheadPos) {
+      if (ReadAheadSize < (unsigned)MaxReadAheadSize) {
+        const unsigned size = Alg::Min(ReadAheadSize * 2, (unsigned)MaxReadAheadSize);
+        if (size > BufferCapacity) {
+          uint8_t* newBuffer = (uint8_t*)OVR_REALLOC(pBuffer, size);
+          if (newBuffer) {
+            pBuffer = newBuffer;
+            BufferCapacity = size;
+          }
+        }
+        ReadAheadSize = Alg::Min(size, BufferCapacity);
+      }
+    } else {
+      ReadAheadSize = BufferSize;
+    }
+
     // WARNING: Right now LoadBuffer() assumes the buffer's empty
-    int sz = pFile->Read(pBuffer, FILEBUFFER_SIZE);
+    int sz = pFile->Read(pBuffer, (int)ReadAheadSize);
     DataSize = sz < 0 ? 0 : (unsigned)sz;
     Pos = 0;
     FilePos += DataSize;
+    ReadAheadPos = FilePos;
   }
 }
 
@@ -224,10 +263,10 @@ bool    BufferedFile::Stat(FileStats *pfs)
 int BufferedFile::Write(const uint8_t* psourceBuffer, int numBytes) {
   if ((BufferMode == WriteBuffer) || SetBufferMode(WriteBuffer)) {
     // If not data space in buffer, flush
-    if ((FILEBUFFER_SIZE - (int)Pos) < numBytes) {
+    if (((int)BufferSize - (int)Pos) < numBytes) {
       FlushBuffer();
       // If bigger then tolerance, just write directly
-      if (numBytes > FILEBUFFER_TOLERANCE) {
+      if (numBytes > (int)(BufferSize / 2)) {
         int sz = pFile->Write(psourceBuffer, numBytes);
         if (sz > 0)
           FilePos += sz;
@@ -262,14 +301,17 @@ int BufferedFile::Read(uint8_t* pdestBuffer, int numBytes) {
     pdestBuffer += readBytes;
     Pos = DataSize;
 
-    // Don't reload buffer if more then tolerance
-    // (No major advantage, and we don't want to write a loop)
-    if (numBytes > FILEBUFFER_TOLERANCE) {
+    // Don't reload buffer if the rest is more than a buffer's worth; read it straight into the
+    // destination instead, which keeps the sequential run going if there is one.
+    if (numBytes > (int)BufferSize) {
+      const bool sequential = (FilePos == ReadAheadPos);
       numBytes = pFile->Read(pdestBuffer, numBytes);
       if (numBytes > 0) {
         FilePos += numBytes;
         Pos = DataSize = 0;
       }
+      if (sequential)
+        ReadAheadPos = FilePos;
       return readBytes + ((numBytes == -1) ? 0 : numBytes);
     }
 
@@ -285,7 +327,7 @@ int BufferedFile::Read(uint8_t* pdestBuffer, int numBytes) {
 
     /*
     // Alternative Read implementation. The one above is probably better
-    // due to FILEBUFFER_TOLERANCE.
+    // due to the direct read of large requests.
     int     total = 0;
 
     do {
@@ -200,6 +200,13 @@ class File : public RefCountBase<File>, public FileConstants {
   // After close, file cannot be accessed
   virtual bool Close() = 0;
 
+  // Returns the whole contents of the file if they are in memory already, as with MemoryFile
+  // and MappedFile, or null if they can only be read. The data is LGetLength bytes long and
+  // stays valid until the file is closed.
+  virtual const uint8_t* GetData() {
+    return nullptr;
+  }
+
   // ***** Inlines for convenient primitive type serialization
 
   // Read/Write helpers
@@ -512,6 +519,16 @@ class BufferedFile : public DelegatedFile {
   // Underlying file position
   uint64_t FilePos;
 
+  // Configured buffer size, and the size actually allocated, which is larger while
+  // sequential reads have grown the read-ahead.
+  unsigned BufferSize;
+  unsigned BufferCapacity;
+  // Amount the next LoadBuffer reads, and the file position the last load or direct read
+  // ended at. A load which starts there continues a sequential run and doubles the read-ahead,
+  // up to MaxReadAheadSize; any other load drops it back to BufferSize.
+  unsigned ReadAheadSize;
+  uint64_t ReadAheadPos;
+
   // Initializes buffering to a certain mode
   bool SetBufferMode(BufferModeType mode);
   // Flushes buffer
@@ -524,14 +541,33 @@ class BufferedFile : public DelegatedFile {
   // Hidden constructor
   BufferedFile();
   BufferedFile(const BufferedFile&)
-      : DelegatedFile(), pBuffer(NULL), BufferMode(NoBuffer), Pos(0), DataSize(0), FilePos(0) {}
+      : DelegatedFile(),
+        pBuffer(NULL),
+        BufferMode(NoBuffer),
+        Pos(0),
+        DataSize(0),
+        FilePos(0),
+        BufferSize(0),
+        BufferCapacity(0),
+        ReadAheadSize(0),
+        ReadAheadPos(0) {}
 
  public:
+  enum { DefaultBufferSize = 8192 - 8, MaxReadAheadSize = 256 * 1024 };
+
   // Constructor
   // - takes another file as source
-  BufferedFile(File* pfile);
+  // - reads larger than bufferSize bypass the buffer, as do writes larger than half of it;
+  //   0 selects DefaultBufferSize
+  BufferedFile(File* pfile, unsigned bufferSize = DefaultBufferSize);
   ~BufferedFile();
 
+  // Flushes the buffer and reallocates it at a new size, which also resets the read-ahead.
+  bool SetBufferSize(unsigned bufferSize);
+  unsigned GetBufferSize() const {
+    return BufferSize;
+  }
+
   // ** Overridden functions
 
   // We override all the functions that can possibly
@@ -661,6 +697,10 @@ class MemoryFile : public File {
     return (int64_t)Seek((int)offset, origin);
   }
 
+  const uint8_t* GetData() {
+    return Valid ? FileData : nullptr;
+  }
+
  public:
   MemoryFile(const String& fileName, const uint8_t* pBuffer, int buffSize) : FilePath(fileName) {
     FileData = pBuffer;
@@ -685,6 +725,89 @@ class MemoryFile : public File {
   bool Valid;
 };
 
+//-----------------------------------------------------------------------------------
+// ***** Mapped File
+
+// Read-only file whose contents are mapped into memory, with CreateFileMapping on Windows and
+// mmap elsewhere. GetData gives direct access to the contents, so that a loader can parse them
+// from the page cache without reading them into a buffer first; Read copies from the mapping.
+// An empty file is valid, but has no data.
+
+class MappedFile : public File {
+ public:
+  MappedFile();
+  // pfileName should be encoded as UTF-8 to support international file names.
+  MappedFile(const char* pfileName);
+  ~MappedFile();
+
+  bool Open(const char* pfileName);
+
+  const char* GetFilePath() {
+    return FilePath.ToCStr();
+  }
+
+  bool IsValid() {
+    return Valid;
+  }
+  bool IsWritable() {
+    return false;
+  }
+
+  bool Flush() {
+    return true;
+  }
+  int GetErrorCode() {
+    return ErrorCode;
+  }
+
+  int Tell() {
+    return (int)FileIndex;
+  }
+  int64_t LTell() {
+    return FileIndex;
+  }
+
+  int GetLength() {
+    return (int)FileSize;
+  }
+  int64_t LGetLength() {
+    return FileSize;
+  }
+
+  bool Close();
+
+  int CopyFromStream(File* pstream, int byteSize) {
+    OVR_UNUSED2(pstream, byteSize);
+    return -1;
+  }
+
+  int Write(const uint8_t* pbuffer, int numBytes) {
+    OVR_UNUSED2(pbuffer, numBytes);
+    return -1;
+  }
+
+  int Read(uint8_t* pbuffer, int numBytes);
+  int SkipBytes(int numBytes);
+  int BytesAvailable();
+
+  int Seek(int offset, int origin = Seek_Set) {
+    return (int)LSeek(offset, origin);
+  }
+  int64_t LSeek(int64_t offset, int origin = Seek_Set);
+
+  const uint8_t* GetData() {
+    return pData;
+  }
+
+ private:
+  String FilePath;
+  const uint8_t* pData;
+  int64_t FileSize;
+  int64_t FileIndex;
+  int ErrorCode;
+  bool Valid;
+};
+
 // ***** Global path helpers
 
 // Find trailing short filename in a path.
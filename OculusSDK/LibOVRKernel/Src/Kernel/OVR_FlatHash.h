@@ -0,0 +1,568 @@
+/************************************************************************************
+
+PublicHeader:   None
+Filename    :   OVR_FlatHash.h
+Content     :   Open-addressing hash table with SSE2-probed control byte groups
+Created     :   October 14, 2026
+Notes       :
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_FlatHash_h
+#define OVR_FlatHash_h
+
+#include "OVR_Hash.h"
+
+//-----------------------------------------------------------------------------------
+// ***** OVR_FLAT_HASH_SSE2
+//
+// Defined as 0 or 1. If enabled then control byte groups are matched with SSE2, else with a
+// portable loop over the group.
+//
+#ifndef OVR_FLAT_HASH_SSE2
+#if defined(__SSE2__) || defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define OVR_FLAT_HASH_SSE2 1
+#else
+#define OVR_FLAT_HASH_SSE2 0
+#endif
+#endif
+
+#if OVR_FLAT_HASH_SSE2
+#include <emmintrin.h>
+#endif
+
+// 'new' operator is redefined/used in this file.
+#undef new
+
+namespace OVR {
+
+//-----------------------------------------------------------------------------------
+// ***** FlatHashGroup
+//
+// A group of GroupWidth control bytes, one per table slot. A control byte is Empty, Deleted or,
+// for a full slot, the low 7 bits of the hash of the slot's key. The Match functions return a
+// bit mask with bit i set for each matching slot i of the group.
+//
+class FlatHashGroup {
+ public:
+  static const size_t Width = 16;
+  static const int8_t Empty = -128; // 0x80
+  static const int8_t Deleted = -2; // 0xFE
+
+  explicit FlatHashGroup(const int8_t* control) {
+#if OVR_FLAT_HASH_SSE2
+    Control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+#else
+    memcpy(Control, control, Width);
+#endif
+  }
+
+  uint32_t Match(int8_t h2) const {
+#if OVR_FLAT_HASH_SSE2
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), Control));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < Width; ++i) {
+      if (Control[i] == h2)
+        mask |= (1u << i);
+    }
+    return mask;
+#endif
+  }
+
+  uint32_t MatchEmpty() const {
+    return Match(Empty);
+  }
+
+  // Empty and Deleted are the only control bytes with the high bit set.
+  uint32_t MatchEmptyOrDeleted() const {
+#if OVR_FLAT_HASH_SSE2
+    return (uint32_t)_mm_movemask_epi8(Control);
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < Width; ++i) {
+      if (Control[i] < 0)
+        mask |= (1u << i);
+    }
+    return mask;
+#endif
+  }
+
+ protected:
+#if OVR_FLAT_HASH_SSE2
+  __m128i Control;
+#else
+  int8_t Control[Width];
+#endif
+};
+
+//-----------------------------------------------------------------------------------
+// ***** FlatHashNode
+//
+// Key/value pair stored in FlatHash slots. It has the same First/Second layout as HashNode, so
+// that code iterating over a Hash works unchanged with a FlatHash.
+//
+template <class C, class U>
+struct FlatHashNode {
+  typedef C FirstType;
+  typedef U SecondType;
+
+  C First;
+  U Second;
+
+  FlatHashNode(const C& f, const U& s) : First(f), Second(s) {}
+  FlatHashNode(const FlatHashNode& src) : First(src.First), Second(src.Second) {}
+};
+
+//-----------------------------------------------------------------------------------
+// ***** FlatHash
+//
+// Open-addressing hash table in the style of a Swiss table, with the same Get/Set/Find
+// interface as Hash<C, U>, so that it can replace a Hash where lookup speed matters.
+//
+// Nodes are stored inline in a flat slot array with one control byte per slot. A lookup
+// compares 16 control bytes at once against 7 bits of the key's hash, and only compares keys
+// for slots whose control byte matches, so that most lookups touch one line of control bytes
+// and one slot. Hash chases NextInChain indices instead, each of which is usually another
+// cache line. Groups are probed quadratically from the group selected by the rest of the hash.
+// The table is kept at most 7/8 full. Removal leaves a Deleted marker unless the slot's group
+// still has an Empty slot, in which case no probe can have passed it.
+//
+// Differences from Hash:
+//   - Set and Add may move nodes when the table grows, which invalidates pointers returned
+//     by Get. Hash has the same limitation.
+//   - Iteration order is unspecified, as with Hash.
+//   - The hash value isn't cached, so HashF is called again upon growth. Types with costly
+//     hash functions and frequent growth should presize via SetCapacity.
+//
+template <class C, class U, class HashF = FixedSizeHash<C>, class Allocator = ContainerAllocator<C>>
+class FlatHash {
+ public:
+  OVR_MEMORY_REDEFINE_NEW(FlatHash)
+
+  typedef U ValueType;
+  typedef FlatHashNode<C, U> Node;
+  typedef FlatHash<C, U, HashF, Allocator> SelfType;
+
+  FlatHash() : pControl(NULL), pSlots(NULL), Capacity(0), Size(0), GrowthLeft(0) {}
+  FlatHash(int sizeHint) : pControl(NULL), pSlots(NULL), Capacity(0), Size(0), GrowthLeft(0) {
+    SetCapacity(sizeHint);
+  }
+  FlatHash(const SelfType& src)
+      : pControl(NULL), pSlots(NULL), Capacity(0), Size(0), GrowthLeft(0) {
+    Assign(src);
+  }
+  ~FlatHash() {
+    Clear();
+  }
+
+  void operator=(const SelfType& src) {
+    if (&src != this)
+      Assign(src);
+  }
+
+  void Assign(const SelfType& src) {
+    Clear();
+    if (!src.IsEmpty()) {
+      SetCapacity(src.GetSize());
+
+      for (ConstIterator it = src.Begin(); it != src.End(); ++it)
+        Add(it->First, it->Second);
+    }
+  }
+
+  // Remove all entries from the table and free its memory.
+  void Clear() {
+    if (pControl) {
+      for (size_t i = 0; i < Capacity; ++i) {
+        if (pControl[i] >= 0)
+          pSlots[i].~Node();
+      }
+
+      Allocator::Free(pControl);
+      pControl = NULL;
+      pSlots = NULL;
+    }
+
+    Capacity = 0;
+    Size = 0;
+    GrowthLeft = 0;
+  }
+
+  bool IsEmpty() const {
+    return (Size == 0);
+  }
+
+  // Set a new or existing value under the key.
+  void Set(const C& key, const U& value) {
+    const size_t hashValue = HashF()(key);
+    const intptr_t index = findIndexCore(key, hashValue);
+
+    if (index >= 0)
+      pSlots[index].Second = value;
+    else
+      add(key, value, hashValue);
+  }
+
+  // Adds the value without checking whether the key is already present.
+  void Add(const C& key, const U& value) {
+    add(key, value, HashF()(key));
+  }
+
+  void Remove(const C& key) {
+    RemoveAlt(key);
+  }
+
+  template <class K>
+  void RemoveAlt(const K& key) {
+    const intptr_t index = findIndexCore(key, HashF()(key));
+    if (index >= 0)
+      removeIndex((size_t)index);
+  }
+
+  // Retrieve the value under the given key.
+  //  - If there's no value under the key, then return false and leave *pvalue alone.
+  //  - If there is a value, return true, and Set *pvalue to the Entry's value.
+  //  - If pvalue == NULL, return true or false according to the presence of the key.
+  bool Get(const C& key, U* pvalue) const {
+    return GetAlt(key, pvalue);
+  }
+
+  template <class K>
+  bool GetAlt(const K& key, U* pvalue) const {
+    const intptr_t index = findIndexCore(key, HashF()(key));
+    if (index >= 0) {
+      if (pvalue)
+        *pvalue = pSlots[index].Second;
+      return true;
+    }
+    return false;
+  }
+
+  // Retrieve the pointer to a value under the given key, or NULL if there is none.
+  U* Get(const C& key) {
+    return GetAlt(key);
+  }
+  const U* Get(const C& key) const {
+    return GetAlt(key);
+  }
+
+  template <class K>
+  U* GetAlt(const K& key) {
+    const intptr_t index = findIndexCore(key, HashF()(key));
+    return (index >= 0) ? &pSlots[index].Second : NULL;
+  }
+  template <class K>
+  const U* GetAlt(const K& key) const {
+    return const_cast<SelfType*>(this)->GetAlt(key);
+  }
+
+  size_t GetSize() const {
+    return Size;
+  }
+  int GetSizeI() const {
+    return (int)GetSize();
+  }
+
+  // Hint the capacity to >= n.
+  void Resize(size_t n) {
+    SetCapacity(n);
+  }
+
+  // Size the table so that it can contain the given number of elements without growing.
+  // If the table already contains more elements than newSize, then this is a no-op.
+  void SetCapacity(size_t newSize) {
+    if (newSize < Size)
+      return;
+
+    if (newSize == 0) {
+      Clear();
+      return;
+    }
+
+    setRawCapacity(newSize + (newSize / 7) + 1);
+  }
+
+  // Iterator API, like STL.
+  struct ConstIterator {
+    const Node& operator*() const {
+      OVR_ASSERT(!IsEnd());
+      return pHash->pSlots[Index];
+    }
+
+    const Node* operator->() const {
+      return &(operator*());
+    }
+
+    void operator++() {
+      if (!IsEnd())
+        Index = pHash->nextFullIndex(Index + 1);
+    }
+
+    bool operator==(const ConstIterator& it) const {
+      if (IsEnd() && it.IsEnd())
+        return true;
+      return (pHash == it.pHash) && (Index == it.Index);
+    }
+
+    bool operator!=(const ConstIterator& it) const {
+      return !(*this == it);
+    }
+
+    bool IsEnd() const {
+      return (pHash == NULL) || (Index >= pHash->Capacity);
+    }
+
+    ConstIterator() : pHash(NULL), Index(0) {}
+    ConstIterator(const SelfType* h, size_t index) : pHash(h), Index(index) {}
+
+    const SelfType* GetContainer() const {
+      return pHash;
+    }
+    intptr_t GetIndex() const {
+      return (intptr_t)Index;
+    }
+
+   protected:
+    const SelfType* pHash;
+    size_t Index;
+  };
+
+  struct Iterator : public ConstIterator {
+    Node& operator*() const {
+      OVR_ASSERT(!ConstIterator::IsEnd());
+      return ConstIterator::pHash->pSlots[ConstIterator::Index];
+    }
+
+    Node* operator->() const {
+      return &(operator*());
+    }
+
+    Iterator() : ConstIterator(NULL, 0) {}
+    Iterator(SelfType* h, size_t index) : ConstIterator(h, index) {}
+
+    // Removes the current element. The iterator can still be incremented afterwards.
+    void Remove() {
+      OVR_ASSERT(!ConstIterator::IsEnd());
+      const_cast<SelfType*>(ConstIterator::pHash)->removeIndex(ConstIterator::Index);
+    }
+  };
+
+  Iterator Begin() {
+    return Iterator(this, nextFullIndex(0));
+  }
+  Iterator End() {
+    return Iterator(NULL, 0);
+  }
+  ConstIterator Begin() const {
+    return ConstIterator(this, nextFullIndex(0));
+  }
+  ConstIterator End() const {
+    return ConstIterator(NULL, 0);
+  }
+
+  Iterator Find(const C& key) {
+    return FindAlt(key);
+  }
+  ConstIterator Find(const C& key) const {
+    return FindAlt(key);
+  }
+
+  template <class K>
+  Iterator FindAlt(const K& key) {
+    const intptr_t index = findIndexCore(key, HashF()(key));
+    return (index >= 0) ? Iterator(this, (size_t)index) : Iterator(NULL, 0);
+  }
+  template <class K>
+  ConstIterator FindAlt(const K& key) const {
+    return const_cast<SelfType*>(this)->FindAlt(key);
+  }
+
+ protected:
+  static const size_t MinCapacity = FlatHashGroup::Width;
+
+  // Mixes the hash so that hash functors with weak bits, such as IdentityHash, still spread
+  // keys across groups and control byte values.
+  static size_t MixHash(size_t hashValue) {
+    const uint64_t mixed = (uint64_t)hashValue * UINT64_C(0x9E3779B97F4A7C15);
+    return (size_t)(mixed ^ (mixed >> 32));
+  }
+
+  static int8_t H2(size_t mixedHash) {
+    return (int8_t)(mixedHash & 0x7F);
+  }
+
+  size_t GetGroupMask() const {
+    return (Capacity / FlatHashGroup::Width) - 1;
+  }
+
+  size_t GetMaxLoad() const {
+    return Capacity - (Capacity / 8);
+  }
+
+  size_t nextFullIndex(size_t index) const {
+    while ((index < Capacity) && (pControl[index] < 0))
+      index++;
+    return index;
+  }
+
+  // Returns the slot index of the key, or -1 if it's not present.
+  template <class K>
+  intptr_t findIndexCore(const K& key, size_t hashValue) const {
+    if (Size == 0)
+      return -1;
+
+    const size_t mixedHash = MixHash(hashValue);
+    const int8_t h2 = H2(mixedHash);
+    const size_t groupMask = GetGroupMask();
+    size_t group = (mixedHash >> 7) & groupMask;
+
+    // Triangular probing visits every group once when the group count is a power of two.
+    for (size_t step = 1; step <= (groupMask + 1); ++step) {
+      const size_t groupStart = group * FlatHashGroup::Width;
+      const FlatHashGroup controlGroup(pControl + groupStart);
+
+      for (uint32_t mask = controlGroup.Match(h2); mask; mask &= (mask - 1)) {
+        const size_t index = groupStart + Alg::CountTrailing0Bits(mask);
+        if (pSlots[index].First == key)
+          return (intptr_t)index;
+      }
+
+      if (controlGroup.MatchEmpty()) // The key would have been placed before the first Empty.
+        return -1;
+
+      group = (group + step) & groupMask;
+    }
+
+    return -1;
+  }
+
+  // Returns the first Empty or Deleted slot in the probe sequence of the hash.
+  size_t findInsertIndex(size_t mixedHash) const {
+    const size_t groupMask = GetGroupMask();
+    size_t group = (mixedHash >> 7) & groupMask;
+
+    for (size_t step = 1;; ++step) {
+      const size_t groupStart = group * FlatHashGroup::Width;
+      const uint32_t mask = FlatHashGroup(pControl + groupStart).MatchEmptyOrDeleted();
+
+      if (mask)
+        return groupStart + Alg::CountTrailing0Bits(mask);
+
+      // The load limit guarantees there is an Empty slot, so this can't cycle.
+      OVR_ASSERT(step <= groupMask);
+      group = (group + step) & groupMask;
+    }
+  }
+
+  void add(const C& key, const U& value, size_t hashValue) {
+    if (GrowthLeft == 0) {
+      // If much of the table is Deleted, rehashing at the same capacity reclaims it.
+      if (Capacity == 0)
+        setRawCapacity(MinCapacity);
+      else if ((Size * 32) <= (Capacity * 25))
+        setRawCapacity(Capacity);
+      else
+        setRawCapacity(Capacity * 2);
+    }
+
+    const size_t mixedHash = MixHash(hashValue);
+    const size_t index = findInsertIndex(mixedHash);
+
+    if (pControl[index] == FlatHashGroup::Empty)
+      GrowthLeft--;
+
+    new (&pSlots[index]) Node(key, value);
+    pControl[index] = H2(mixedHash);
+    Size++;
+  }
+
+  void removeIndex(size_t index) {
+    OVR_ASSERT((index < Capacity) && (pControl[index] >= 0));
+
+    pSlots[index].~Node();
+    Size--;
+
+    const size_t groupStart = index & ~(FlatHashGroup::Width - 1);
+
+    // A probe only continues past a group that was full when it was made, and such a group
+    // never has an Empty slot again until the next rehash.
+    if (FlatHashGroup(pControl + groupStart).MatchEmpty()) {
+      pControl[index] = FlatHashGroup::Empty;
+      GrowthLeft++;
+    } else
+      pControl[index] = FlatHashGroup::Deleted;
+  }
+
+  // Reallocates the table with at least the given number of slots and reinserts the contents.
+  // This also drops all Deleted markers.
+  void setRawCapacity(size_t newCapacity) {
+    if (newCapacity < MinCapacity)
+      newCapacity = MinCapacity;
+    else {
+      // Force newCapacity to be a power of two.
+      int bits = Alg::UpperBit(newCapacity - 1) + 1;
+      newCapacity = size_t(1) << bits;
+    }
+
+    // The slots follow the control bytes, whose count is a multiple of 16.
+    int8_t* newControl = (int8_t*)Allocator::Alloc(newCapacity * (1 + sizeof(Node)));
+    // Need to do something on alloc failure!
+    OVR_ASSERT(newControl);
+    memset(newControl, FlatHashGroup::Empty, newCapacity);
+
+    int8_t* oldControl = pControl;
+    Node* oldSlots = pSlots;
+    const size_t oldCapacity = Capacity;
+
+    pControl = newControl;
+    pSlots = reinterpret_cast<Node*>(newControl + newCapacity);
+    Capacity = newCapacity;
+    GrowthLeft = GetMaxLoad() - Size;
+
+    for (size_t i = 0; i < oldCapacity; ++i) {
+      if (oldControl[i] >= 0) {
+        const size_t mixedHash = MixHash(HashF()(oldSlots[i].First));
+        const size_t index = findInsertIndex(mixedHash);
+
+        new (&pSlots[index]) Node(oldSlots[i]);
+        pControl[index] = H2(mixedHash);
+        oldSlots[i].~Node();
+      }
+    }
+
+    if (oldControl)
+      Allocator::Free(oldControl);
+  }
+
+  int8_t* pControl; // Capacity control bytes, followed in the same allocation by the slots.
+  Node* pSlots;
+  size_t Capacity; // Slot count. Zero or a power of two no less than MinCapacity.
+  size_t Size; // Number of full slots.
+  size_t GrowthLeft; // Empty slots that can be filled before the table must be rehashed.
+};
+
+} // namespace OVR
+
+#ifdef OVR_DEFINE_NEW
+#define new OVR_DEFINE_NEW
+#endif
+
+#endif // OVR_FlatHash_h
@@ -0,0 +1,178 @@
+/************************************************************************************
+
+Filename    :   OVR_FlightRecorder.cpp
+Content     :   Always-on per-thread event ring dumped by crash and deadlock reports
+Created     :   October 14, 2026
+Notes       :
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR_FlightRecorder.h"
+#include "OVR_Alg.h"
+#include "OVR_DebugHelp.h"
+#include "OVR_Std.h"
+#include <stdio.h>
+#include <string.h>
+
+namespace OVR {
+
+thread_local FlightRecorderRing* FlightRecorder::CurrentRing = nullptr;
+
+// Rings are published here and never freed, so that Dump can read them without locking even
+// while their threads exit. The registry is a fixed array so that Dump doesn't allocate.
+static std::atomic<FlightRecorderRing*> FlightRings[FlightRecorder::MaxThreads];
+static std::atomic<unsigned> FlightRingCount(0);
+
+// Threads past MaxThreads share this ring, which isn't dumped.
+static FlightRecorderRing OverflowRing;
+
+static const char* GetFlightEventKindName(FlightEventKind kind) {
+  switch (kind) {
+    case FlightEvent_Waypoint:
+      return "Waypoint";
+    case FlightEvent_Frame:
+      return "Frame";
+    case FlightEvent_Log:
+      return "Log";
+    default:
+      return "Mark";
+  }
+}
+
+FlightRecorderRing* FlightRecorder::CreateCurrentRing() {
+  const unsigned slot = FlightRingCount.fetch_add(1, std::memory_order_relaxed);
+  if (slot >= MaxThreads) {
+    CurrentRing = &OverflowRing;
+    return CurrentRing;
+  }
+
+  FlightRecorderRing* ring = new FlightRecorderRing;
+  ring->WriteCount.store(0, std::memory_order_relaxed);
+  ring->ThreadSysId = (uint64_t)GetCurrentThreadSysId();
+  snprintf(
+      ring->ThreadName,
+      sizeof(ring->ThreadName),
+      "Thread %llu",
+      (unsigned long long)ring->ThreadSysId);
+  memset(ring->Events, 0, sizeof(ring->Events));
+
+  FlightRings[slot].store(ring, std::memory_order_release);
+  CurrentRing = ring;
+  return ring;
+}
+
+void FlightRecorder::SetThreadName(const char* name) {
+  FlightRecorderRing* ring = CurrentRing;
+  if (!ring)
+    ring = CreateCurrentRing();
+
+  if (ring != &OverflowRing)
+    OVR_strlcpy(ring->ThreadName, name ? name : "", sizeof(ring->ThreadName));
+}
+
+size_t FlightRecorder::Dump(DumpFunc func, void* context, size_t maxEvents) {
+  const uint64_t capacity = FlightRecorderRing::Capacity;
+  const uint64_t mask = capacity - 1;
+
+  FlightRecorderRing* rings[MaxThreads];
+  uint64_t begin[MaxThreads]; // First index each ring still holds
+  uint64_t end[MaxThreads]; // WriteCount of each ring when the dump began
+  uint64_t cursor[MaxThreads];
+  unsigned ringCount = 0;
+
+  const unsigned slotCount =
+      Alg::Min(FlightRingCount.load(std::memory_order_relaxed), (unsigned)MaxThreads);
+  for (unsigned i = 0; i < slotCount; ++i) {
+    FlightRecorderRing* ring = FlightRings[i].load(std::memory_order_acquire);
+    if (ring) {
+      rings[ringCount] = ring;
+      end[ringCount] = ring->WriteCount.load(std::memory_order_acquire);
+      begin[ringCount] = (end[ringCount] > capacity) ? (end[ringCount] - capacity) : 0;
+      cursor[ringCount] = end[ringCount];
+      ringCount++;
+    }
+  }
+
+  // Walk back from the newest event to find where each ring's share of the newest maxEvents
+  // begins. Events still being written by running threads may be torn; at worst that misorders
+  // them slightly here, and they are discarded below.
+  uint64_t newestTicks = 0;
+  for (size_t taken = 0; taken < maxEvents; ++taken) {
+    int newest = -1;
+    for (unsigned r = 0; r < ringCount; ++r) {
+      if ((cursor[r] > begin[r]) &&
+          ((newest < 0) ||
+           (rings[r]->Events[(cursor[r] - 1) & mask].Ticks >
+            rings[newest]->Events[(cursor[newest] - 1) & mask].Ticks)))
+        newest = (int)r;
+    }
+    if (newest < 0)
+      break;
+    cursor[newest]--;
+    if (!taken)
+      newestTicks = rings[newest]->Events[cursor[newest] & mask].Ticks;
+  }
+
+  // Then write them forward, merged by time.
+  size_t written = 0;
+  char line[256];
+
+  for (;;) {
+    int oldest = -1;
+    for (unsigned r = 0; r < ringCount; ++r) {
+      if ((cursor[r] < end[r]) &&
+          ((oldest < 0) ||
+           (rings[r]->Events[cursor[r] & mask].Ticks <
+            rings[oldest]->Events[cursor[oldest] & mask].Ticks)))
+        oldest = (int)r;
+    }
+    if (oldest < 0)
+      break;
+
+    FlightRecorderRing* ring = rings[oldest];
+    const uint64_t index = cursor[oldest]++;
+    const FlightEvent event = ring->Events[index & mask];
+
+    // Drop the event if its thread may have been overwriting it while we copied it.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if ((ring->WriteCount.load(std::memory_order_relaxed) - index) >= capacity)
+      continue;
+
+    const double ageMs = (event.Ticks <= newestTicks)
+        ? -(double)Timer::RawTicksToNanosDuration(newestTicks - event.Ticks) / 1e6
+        : 0.0;
+
+    snprintf(
+        line,
+        sizeof(line),
+        "%12.3f ms  %-20s  %-8s  %s %llu\n",
+        ageMs,
+        ring->ThreadName,
+        GetFlightEventKindName(event.Kind),
+        event.Name ? event.Name : "(null)",
+        (unsigned long long)event.Value);
+    func(context, line);
+    written++;
+  }
+
+  return written;
+}
+
+} // namespace OVR
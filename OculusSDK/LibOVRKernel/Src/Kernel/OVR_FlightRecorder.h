@@ -0,0 +1,135 @@
+/************************************************************************************
+
+Filename    :   OVR_FlightRecorder.h
+Content     :   Always-on per-thread event ring dumped by crash and deadlock reports
+Created     :   October 14, 2026
+Notes       :
+    The flight recorder keeps the most recent events of each thread in a small fixed ring, so
+    that an ExceptionHandler crash report or WatchDogObserver deadlock report can say what the
+    process was doing just before it went wrong. Recording is always on; an event is a few plain
+    stores into memory owned by the calling thread, with no locks or atomic read-modify-writes.
+
+        FlightRecorder::SetThreadName("Render");
+        ...
+        OVR_FLIGHT_RECORD_FRAME(frameIndex);
+        OVR_FLIGHT_RECORD("SubmitBegin", layerCount);
+
+    TraceCall, TraceReturn and TraceWaypoint in Tracing.h record here as well as to ETW.
+
+    Dump writes the newest events of all threads merged in time order. It takes no locks and
+    doesn't allocate, so it may be called from a crash handler. Define OVR_DISABLE_FLIGHT_RECORDER
+    to compile the recording macros out.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_FlightRecorder_h
+#define OVR_FlightRecorder_h
+
+#include "OVR_Types.h"
+#include "OVR_Atomic.h"
+#include "OVR_Timer.h"
+
+namespace OVR {
+
+enum FlightEventKind : uint32_t {
+  FlightEvent_Mark, // Value is user defined.
+  FlightEvent_Waypoint, // TraceCall/TraceReturn/TraceWaypoint. Value is the frame index.
+  FlightEvent_Frame, // Value is the frame index.
+  FlightEvent_Log // Value is a log or error id.
+};
+
+struct FlightEvent {
+  uint64_t Ticks; // Timer::GetTicksRaw
+  const char* Name; // Must be a string with static storage duration, such as a literal.
+  uint64_t Value;
+  FlightEventKind Kind;
+};
+
+// The ring of one thread. Only the owning thread writes it.
+struct FlightRecorderRing {
+  static const uint32_t Capacity = 256; // Power of two.
+
+  std::atomic<uint64_t> WriteCount; // Events ever written; Events[WriteCount % Capacity] is next.
+  uint64_t ThreadSysId;
+  char ThreadName[32];
+  FlightEvent Events[Capacity];
+};
+
+//-----------------------------------------------------------------------------------
+// ***** FlightRecorder
+//
+class FlightRecorder {
+ public:
+  // Rings beyond this many threads aren't recorded.
+  static const unsigned MaxThreads = 64;
+
+  // Events dumped when no limit is given: the last several hundred milliseconds of a typical
+  // process, and few enough to keep a report readable.
+  static const unsigned DefaultDumpEvents = 512;
+
+  static void Record(FlightEventKind kind, const char* name, uint64_t value) {
+    FlightRecorderRing* ring = CurrentRing;
+    if (!ring)
+      ring = CreateCurrentRing();
+
+    const uint64_t index = ring->WriteCount.load(std::memory_order_relaxed);
+    FlightEvent& event = ring->Events[index & (FlightRecorderRing::Capacity - 1)];
+    event.Ticks = Timer::GetTicksRaw();
+    event.Name = name;
+    event.Value = value;
+    event.Kind = kind;
+    ring->WriteCount.store(index + 1, std::memory_order_release);
+  }
+
+  // Names the calling thread in dumps. The name is copied, truncated to 31 characters.
+  static void SetThreadName(const char* name);
+
+  // Receives Dump output, one line at a time, each ending with a newline.
+  typedef void (*DumpFunc)(void* context, const char* line);
+
+  // Writes the newest maxEvents events of all threads, oldest first, with times relative to the
+  // newest. Returns the number of events written.
+  static size_t Dump(DumpFunc func, void* context, size_t maxEvents = DefaultDumpEvents);
+
+ protected:
+  static FlightRecorderRing* CreateCurrentRing();
+
+  static thread_local FlightRecorderRing* CurrentRing;
+};
+
+} // namespace OVR
+
+#if !defined(OVR_DISABLE_FLIGHT_RECORDER)
+#define OVR_FLIGHT_RECORD(name, value) \
+  OVR::FlightRecorder::Record(OVR::FlightEvent_Mark, (name), (uint64_t)(value))
+#define OVR_FLIGHT_RECORD_FRAME(frameIndex) \
+  OVR::FlightRecorder::Record(OVR::FlightEvent_Frame, "Frame", (uint64_t)(frameIndex))
+#define OVR_FLIGHT_RECORD_LOG(name, id) \
+  OVR::FlightRecorder::Record(OVR::FlightEvent_Log, (name), (uint64_t)(id))
+#define OVR_FLIGHT_RECORD_WAYPOINT(name, frameIndex) \
+  OVR::FlightRecorder::Record(OVR::FlightEvent_Waypoint, (name), (uint64_t)(frameIndex))
+#else
+#define OVR_FLIGHT_RECORD(name, value) ((void)0)
+#define OVR_FLIGHT_RECORD_FRAME(frameIndex) ((void)0)
+#define OVR_FLIGHT_RECORD_LOG(name, id) ((void)0)
+#define OVR_FLIGHT_RECORD_WAYPOINT(name, frameIndex) ((void)0)
+#endif
+
+#endif // OVR_FlightRecorder_h
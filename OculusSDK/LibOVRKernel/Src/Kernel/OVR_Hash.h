@@ -198,33 +198,29 @@ template <
     class Allocator = ContainerAllocator<C>,
     class Entry = HashsetCachedEntry<C, HashF>>
 class HashSetBase {
-  enum { HashMinSize = 8 };
+  enum { HashMinSize = 8, RehashStepBuckets = 4 };
+  struct TableType;
 
  public:
   OVR_MEMORY_REDEFINE_NEW(HashSetBase)
 
   typedef HashSetBase<C, HashF, AltHashF, Allocator, Entry> SelfType;
 
-  HashSetBase() : pTable(NULL) {}
-  HashSetBase(int sizeHint) : pTable(NULL) {
+  HashSetBase() : pTable(NULL), pOldTable(NULL), MigrateIndex(0), IncrementalRehash(false) {}
+  HashSetBase(int sizeHint)
+      : pTable(NULL), pOldTable(NULL), MigrateIndex(0), IncrementalRehash(false) {
     SetCapacity(sizeHint);
   }
-  HashSetBase(const SelfType& src) : pTable(NULL) {
+  HashSetBase(const SelfType& src)
+      : pTable(NULL), pOldTable(NULL), MigrateIndex(0), IncrementalRehash(src.IncrementalRehash) {
     Assign(src);
   }
 
   ~HashSetBase() {
-    if (pTable) {
-      // Delete the entries.
-      for (size_t i = 0, n = pTable->SizeMask; i <= n; i++) {
-        Entry* e = &E(i);
-        if (!e->IsEmpty())
-          e->Free();
-      }
-
-      Allocator::Free(pTable);
-      pTable = NULL;
-    }
+    releaseTable(pTable, true);
+    releaseTable(pOldTable, true);
+    pTable = NULL;
+    pOldTable = NULL;
   }
 
   void Assign(const SelfType& src) {
@@ -240,22 +236,29 @@ class HashSetBase {
 
   // Remove all entries from the HashSet table.
   void Clear() {
-    if (pTable) {
-      // Delete the entries.
-      for (size_t i = 0, n = pTable->SizeMask; i <= n; i++) {
-        Entry* e = &E(i);
-        if (!e->IsEmpty())
-          e->Clear();
-      }
-
-      Allocator::Free(pTable);
-      pTable = NULL;
-    }
+    releaseTable(pTable, false);
+    releaseTable(pOldTable, false);
+    pTable = NULL;
+    pOldTable = NULL;
   }
 
   // Returns true if the HashSet is empty.
   bool IsEmpty() const {
-    return pTable == NULL || pTable->EntryCount == 0;
+    return GetSize() == 0;
+  }
+
+  // When enabled, growing the table doesn't rehash it all at once: the old table is kept, and
+  // each insertion that follows moves a few of its buckets to the new one, while lookups search
+  // both. This bounds the time an insertion can take, at the cost of keeping both tables until
+  // the move completes. Any insertion may then move entries, so pointers to values and
+  // iterators are invalidated by every insertion, rather than only by one that grows the table.
+  void SetIncrementalRehash(bool enabled) {
+    IncrementalRehash = enabled;
+    if (!enabled && pOldTable)
+      migrateBuckets(pOldTable->SizeMask + 1);
+  }
+  bool IsIncrementalRehash() const {
+    return IncrementalRehash;
   }
 
   // Set a new or existing value under the key, to the value.
@@ -267,7 +270,7 @@ class HashSetBase {
     intptr_t index = (intptr_t)-1;
 
     if (pTable != NULL)
-      index = findIndexCore(key, hashValue & pTable->SizeMask);
+      index = findIndexCore(key, hashValue);
 
     if (index >= 0) {
       E(index).Value = key;
@@ -290,45 +293,10 @@ class HashSetBase {
       return;
 
     size_t hashValue = AltHashF()(key);
-    intptr_t index = hashValue & pTable->SizeMask;
-
-    Entry* e = &E(index);
-
-    // If empty node or occupied by collider, we have nothing to remove.
-    if (e->IsEmpty() || (e->GetCachedHash(pTable->SizeMask) != (size_t)index))
-      return;
-
-    // Save index
-    intptr_t naturalIndex = index;
-    intptr_t prevIndex = -1;
-
-    while ((e->GetCachedHash(pTable->SizeMask) != (size_t)naturalIndex) || !(e->Value == key)) {
-      // Keep looking through the chain.
-      prevIndex = index;
-      index = e->NextInChain;
-      if (index == -1)
-        return; // End of chain, item not found
-      e = &E(index);
-    }
-
-    // Found it - our item is at index
-    if (naturalIndex == index) {
-      // If we have a follower, move it to us
-      if (!e->IsEndOfChain()) {
-        Entry* enext = &E(e->NextInChain);
-        e->Clear();
-        new (e) Entry(*enext);
-        // Point us to the follower's cell that will be cleared
-        e = enext;
-      }
-    } else {
-      // We are not at natural index, so deal with the prev items next index
-      E(prevIndex).NextInChain = e->NextInChain;
-    }
+    bool followerMoved;
 
-    // Clear us, of the follower cell that was moved.
-    e->Clear();
-    pTable->EntryCount--;
+    if (removeFromTable(pTable, key, hashValue, -1, &followerMoved) < 0 && pOldTable)
+      removeFromTable(pOldTable, key, hashValue, -1, &followerMoved);
     // Should we check the size to condense hash? ...
   }
 
@@ -386,7 +354,9 @@ class HashSetBase {
   }
 
   size_t GetSize() const {
-    return pTable == NULL ? 0 : (size_t)pTable->EntryCount;
+    if (pTable == NULL)
+      return 0;
+    return (size_t)pTable->EntryCount + (pOldTable ? (size_t)pOldTable->EntryCount : 0);
   }
   int GetSizeI() const {
     return (int)GetSize();
@@ -398,9 +368,12 @@ class HashSetBase {
     if (pTable == NULL) {
       // Initial creation of table.  Make a minimum-sized table.
       setRawCapacity(HashMinSize);
-    } else if (pTable->EntryCount * 5 > (pTable->SizeMask + 1) * 4) {
+    } else if (GetSize() * 5 > (pTable->SizeMask + 1) * 4) {
       // pTable is more than 5/4 ths full.  Expand.
-      setRawCapacity((pTable->SizeMask + 1) * 2);
+      if (IncrementalRehash)
+        beginRehash((pTable->SizeMask + 1) * 2);
+      else
+        setRawCapacity((pTable->SizeMask + 1) * 2);
     }
   }
 
@@ -435,20 +408,21 @@ class HashSetBase {
   // Iterator API, like STL.
   struct ConstIterator {
     const C& operator*() const {
-      OVR_ASSERT(Index >= 0 && Index <= (intptr_t)pHash->pTable->SizeMask);
+      OVR_ASSERT(Index >= 0 && Index < (intptr_t)pHash->indexEnd());
       return pHash->E(Index).Value;
     }
 
     const C* operator->() const {
-      OVR_ASSERT(Index >= 0 && Index <= (intptr_t)pHash->pTable->SizeMask);
+      OVR_ASSERT(Index >= 0 && Index < (intptr_t)pHash->indexEnd());
       return &pHash->E(Index).Value;
     }
 
     void operator++() {
       // Find next non-empty Entry.
-      if (Index <= (intptr_t)pHash->pTable->SizeMask) {
+      const size_t end = pHash->indexEnd();
+      if (Index < (intptr_t)end) {
         Index++;
-        while ((size_t)Index <= pHash->pTable->SizeMask && pHash->E(Index).IsEmpty()) {
+        while ((size_t)Index < end && pHash->E(Index).IsEmpty()) {
           Index++;
         }
       }
@@ -468,7 +442,7 @@ class HashSetBase {
 
     bool IsEnd() const {
       return (pHash == NULL) || (pHash->pTable == NULL) ||
-          (Index > (intptr_t)pHash->pTable->SizeMask);
+          (Index >= (intptr_t)pHash->indexEnd());
     }
 
     ConstIterator() : pHash(NULL), Index(0) {}
@@ -500,7 +474,7 @@ class HashSetBase {
     C& operator*() const {
       OVR_ASSERT(
           (ConstIterator::pHash) && ConstIterator::pHash->pTable && (ConstIterator::Index >= 0) &&
-          (ConstIterator::Index <= (intptr_t)ConstIterator::pHash->pTable->SizeMask));
+          (ConstIterator::Index < (intptr_t)ConstIterator::pHash->indexEnd()));
       return const_cast<SelfType*>(ConstIterator::pHash)->E(ConstIterator::Index).Value;
     }
 
@@ -518,54 +492,24 @@ class HashSetBase {
     template <class K>
     void RemoveAlt(const K& key) {
       SelfType* phash = const_cast<SelfType*>(ConstIterator::pHash);
-      // Entry*      ee = &phash->E(ConstIterator::Index);
-      // const C&    key = ee->Value;
-
-      size_t hashValue = AltHashF()(key);
-      intptr_t index = hashValue & phash->pTable->SizeMask;
-
-      Entry* e = &phash->E(index);
-
-      // If empty node or occupied by collider, we have nothing to remove.
-      if (e->IsEmpty() || (e->GetCachedHash(phash->pTable->SizeMask) != (size_t)index))
-        return;
-
-      // Save index
-      intptr_t naturalIndex = index;
-      intptr_t prevIndex = -1;
-
-      while ((e->GetCachedHash(phash->pTable->SizeMask) != (size_t)naturalIndex) ||
-             !(e->Value == key)) {
-        // Keep looking through the chain.
-        prevIndex = index;
-        index = e->NextInChain;
-        if (index == -1)
-          return; // End of chain, item not found
-        e = &phash->E(index);
+      TableType* table = phash->pTable;
+      intptr_t base = 0;
+
+      if (ConstIterator::Index > (intptr_t)table->SizeMask) {
+        base = (intptr_t)table->SizeMask + 1;
+        table = phash->pOldTable;
       }
 
-      if (index == (intptr_t)ConstIterator::Index) {
-        // Found it - our item is at index
-        if (naturalIndex == index) {
-          // If we have a follower, move it to us
-          if (!e->IsEndOfChain()) {
-            Entry* enext = &phash->E(e->NextInChain);
-            e->Clear();
-            new (e) Entry(*enext);
-            // Point us to the follower's cell that will be cleared
-            e = enext;
-            --ConstIterator::Index;
-          }
-        } else {
-          // We are not at natural index, so deal with the prev items next index
-          phash->E(prevIndex).NextInChain = e->NextInChain;
-        }
+      bool followerMoved = false;
+      intptr_t index =
+          removeFromTable(table, key, AltHashF()(key), ConstIterator::Index - base, &followerMoved);
 
-        // Clear us, of the follower cell that was moved.
-        e->Clear();
-        phash->pTable->EntryCount--;
-      } else
+      if (index < 0)
+        return; // Item not found
+      if (index != ConstIterator::Index - base)
         OVR_ASSERT(0); //?
+      else if (followerMoved)
+        --ConstIterator::Index; // Visit the follower, which was moved to the current index.
     }
 
    private:
@@ -582,7 +526,8 @@ class HashSetBase {
 
     // Scan till we hit the First valid Entry.
     size_t i0 = 0;
-    while (i0 <= pTable->SizeMask && E(i0).IsEmpty()) {
+    const size_t end = indexEnd();
+    while (i0 < end && E(i0).IsEmpty()) {
       i0++;
     }
     return Iterator(this, i0);
@@ -630,37 +575,49 @@ class HashSetBase {
   intptr_t findIndex(const K& key) const {
     if (pTable == NULL)
       return -1;
-    size_t hashValue = HashF()(key) & pTable->SizeMask;
-    return findIndexCore(key, hashValue);
+    return findIndexCore(key, HashF()(key));
   }
 
   template <class K>
   intptr_t findIndexAlt(const K& key) const {
     if (pTable == NULL)
       return -1;
-    size_t hashValue = AltHashF()(key) & pTable->SizeMask;
-    return findIndexCore(key, hashValue);
+    return findIndexCore(key, AltHashF()(key));
   }
 
-  // Find the index of the matching Entry.  If no match, then return -1.
+  // Find the index of the matching Entry in either table, as E indexes them.  If no match,
+  // then return -1.
   template <class K>
   intptr_t findIndexCore(const K& key, size_t hashValue) const {
     // Table must exist.
     OVR_ASSERT(pTable != 0);
+
+    intptr_t index = findInTable(pTable, key, hashValue & pTable->SizeMask);
+    if (index < 0 && pOldTable) {
+      index = findInTable(pOldTable, key, hashValue & pOldTable->SizeMask);
+      if (index >= 0)
+        index += (intptr_t)pTable->SizeMask + 1;
+    }
+    return index;
+  }
+
+  // Find the index of the matching Entry within table.  If no match, then return -1.
+  template <class K>
+  static intptr_t findInTable(const TableType* table, const K& key, size_t hashValue) {
     // Hash key must be 'and-ed' by the caller.
-    OVR_ASSERT((hashValue & ~pTable->SizeMask) == 0);
+    OVR_ASSERT((hashValue & ~table->SizeMask) == 0);
 
     size_t index = hashValue;
-    const Entry* e = &E(index);
+    const Entry* e = &TableEntry(table, index);
 
     // If empty or occupied by a collider, not found.
-    if (e->IsEmpty() || (e->GetCachedHash(pTable->SizeMask) != index))
+    if (e->IsEmpty() || (e->GetCachedHash(table->SizeMask) != index))
       return -1;
 
     while (1) {
-      OVR_ASSERT(e->GetCachedHash(pTable->SizeMask) == hashValue);
+      OVR_ASSERT(e->GetCachedHash(table->SizeMask) == hashValue);
 
-      if (e->GetCachedHash(pTable->SizeMask) == hashValue && e->Value == key) {
+      if (e->GetCachedHash(table->SizeMask) == hashValue && e->Value == key) {
         // Found it.
         return index;
       }
@@ -673,16 +630,82 @@ class HashSetBase {
       if (index == (size_t)-1)
         break; // end of chain
 
-      e = &E(index);
+      e = &TableEntry(table, index);
       OVR_ASSERT(!e->IsEmpty());
     }
     return -1;
   }
 
+  // Remove the matching Entry from table, if it's at requiredIndex or requiredIndex is -1.
+  // Returns the index the Entry was found at, or -1 if it's not in table. followerMoved is set
+  // if the next Entry in its chain was moved to that index.
+  template <class K>
+  static intptr_t removeFromTable(
+      TableType* table,
+      const K& key,
+      size_t hashValue,
+      intptr_t requiredIndex,
+      bool* followerMoved) {
+    const size_t mask = table->SizeMask;
+    intptr_t index = hashValue & mask;
+    *followerMoved = false;
+
+    Entry* e = &TableEntry(table, index);
+
+    // If empty node or occupied by collider, we have nothing to remove.
+    if (e->IsEmpty() || (e->GetCachedHash(mask) != (size_t)index))
+      return -1;
+
+    // Save index
+    intptr_t naturalIndex = index;
+    intptr_t prevIndex = -1;
+
+    while ((e->GetCachedHash(mask) != (size_t)naturalIndex) || !(e->Value == key)) {
+      // Keep looking through the chain.
+      prevIndex = index;
+      index = e->NextInChain;
+      if (index == -1)
+        return -1; // End of chain, item not found
+      e = &TableEntry(table, index);
+    }
+
+    if (requiredIndex >= 0 && index != requiredIndex)
+      return index;
+
+    // Found it - our item is at index
+    if (naturalIndex == index) {
+      // If we have a follower, move it to us
+      if (!e->IsEndOfChain()) {
+        Entry* enext = &TableEntry(table, e->NextInChain);
+        e->Clear();
+        new (e) Entry(*enext);
+        // Point us to the follower's cell that will be cleared
+        e = enext;
+        *followerMoved = true;
+      }
+    } else {
+      // We are not at natural index, so deal with the prev items next index
+      TableEntry(table, prevIndex).NextInChain = e->NextInChain;
+    }
+
+    // Clear us, of the follower cell that was moved.
+    e->Clear();
+    table->EntryCount--;
+    return index;
+  }
+
   // Add a new value to the HashSet table, under the specified key.
   template <class CRef>
   void add(const CRef& key, size_t hashValue) {
     CheckExpand();
+    if (pOldTable)
+      migrateBuckets(RehashStepBuckets);
+    insert(key, hashValue);
+  }
+
+  // Add a new value to pTable, which must have room for it.
+  template <class CRef>
+  void insert(const CRef& key, size_t hashValue) {
     hashValue &= pTable->SizeMask;
 
     pTable->EntryCount++;
@@ -741,15 +764,109 @@ class HashSetBase {
     naturalEntry->SetCachedHash(hashValue);
   }
 
-  // Index access helpers.
+  // Index access helpers. While rehashing incrementally, the indexes past pTable's entries are
+  // pOldTable's, so that iterators and findIndex cover both tables.
   Entry& E(size_t index) {
     // Must have pTable and access needs to be within bounds.
-    OVR_ASSERT(index <= pTable->SizeMask);
-    return *(((Entry*)(pTable + 1)) + index);
+    OVR_ASSERT(pTable);
+    if (index <= pTable->SizeMask)
+      return TableEntry(pTable, index);
+    OVR_ASSERT(pOldTable);
+    return TableEntry(pOldTable, index - (pTable->SizeMask + 1));
   }
   const Entry& E(size_t index) const {
-    OVR_ASSERT(index <= pTable->SizeMask);
-    return *(((Entry*)(pTable + 1)) + index);
+    return const_cast<SelfType*>(this)->E(index);
+  }
+
+  size_t indexEnd() const {
+    if (pTable == NULL)
+      return 0;
+    return pTable->SizeMask + 1 + (pOldTable ? pOldTable->SizeMask + 1 : 0);
+  }
+
+  static Entry& TableEntry(TableType* table, size_t index) {
+    OVR_ASSERT(index <= table->SizeMask);
+    return *(((Entry*)(table + 1)) + index);
+  }
+  static const Entry& TableEntry(const TableType* table, size_t index) {
+    OVR_ASSERT(index <= table->SizeMask);
+    return *(((const Entry*)(table + 1)) + index);
+  }
+
+  // Allocates a table of newSize entries, which must be a power of two, all empty.
+  static TableType* allocTable(size_t newSize) {
+    TableType* table = (TableType*)Allocator::Alloc(sizeof(TableType) + sizeof(Entry) * newSize);
+    // Need to do something on alloc failure!
+    OVR_ASSERT(table);
+
+    table->EntryCount = 0;
+    table->SizeMask = newSize - 1;
+
+    // Mark all entries as empty.
+    for (size_t i = 0; i < newSize; i++)
+      TableEntry(table, i).NextInChain = -2;
+    return table;
+  }
+
+  // Destructs the entries and frees the table; Free is used from the dtor, see HashsetEntry.
+  static void releaseTable(TableType* table, bool fromDestructor) {
+    if (table == NULL)
+      return;
+
+    // Delete the entries.
+    for (size_t i = 0, n = table->SizeMask; i <= n; i++) {
+      Entry* e = &TableEntry(table, i);
+      if (!e->IsEmpty()) {
+        if (fromDestructor)
+          e->Free();
+        else
+          e->Clear();
+      }
+    }
+
+    Allocator::Free(table);
+  }
+
+  // Starts an incremental rehash into a new table of newSize entries.
+  void beginRehash(size_t newSize) {
+    // The previous growth's rehash must complete first; at RehashStepBuckets per insertion it
+    // normally has long before the new table fills.
+    if (pOldTable)
+      migrateBuckets(pOldTable->SizeMask + 1);
+
+    pOldTable = pTable;
+    pTable = allocTable(newSize);
+    MigrateIndex = 0;
+  }
+
+  // Moves up to bucketCount of pOldTable's buckets to pTable, and frees pOldTable once it's
+  // empty. A bucket that heads a chain moves with the whole chain, so each chain is entirely
+  // in one table or the other; the other buckets hold entries of chains headed elsewhere.
+  void migrateBuckets(size_t bucketCount) {
+    const size_t oldMask = pOldTable->SizeMask;
+
+    for (; bucketCount && MigrateIndex <= oldMask; --bucketCount, ++MigrateIndex) {
+      Entry* e = &TableEntry(pOldTable, MigrateIndex);
+      if (e->IsEmpty() || (e->GetCachedHash(oldMask) != MigrateIndex))
+        continue;
+
+      for (;;) {
+        const intptr_t next = e->NextInChain;
+        insert(e->Value, HashF()(e->Value));
+        // placement delete of old element
+        e->Clear();
+        pOldTable->EntryCount--;
+        if (next == -1)
+          break;
+        e = &TableEntry(pOldTable, next);
+      }
+    }
+
+    if (MigrateIndex > oldMask || pOldTable->EntryCount == 0) {
+      OVR_ASSERT(pOldTable->EntryCount == 0);
+      Allocator::Free(pOldTable);
+      pOldTable = NULL;
+    }
   }
 
   // Resize the HashSet table to the given size (Rehash the
@@ -776,22 +893,17 @@ class HashSetBase {
     }
 
     SelfType newHash;
-    newHash.pTable = (TableType*)Allocator::Alloc(sizeof(TableType) + sizeof(Entry) * newSize);
-    // Need to do something on alloc failure!
-    OVR_ASSERT(newHash.pTable);
-
-    newHash.pTable->EntryCount = 0;
-    newHash.pTable->SizeMask = newSize - 1;
+    newHash.pTable = allocTable(newSize);
     size_t i, n;
 
-    // Mark all entries as empty.
-    for (i = 0; i < newSize; i++)
-      newHash.E(i).NextInChain = -2;
+    // Copy stuff to newHash, from both tables if rehashing incrementally.
+    TableType* tables[2] = {pTable, pOldTable};
+    for (TableType* table : tables) {
+      if (table == NULL)
+        continue;
 
-    // Copy stuff to newHash
-    if (pTable) {
-      for (i = 0, n = pTable->SizeMask; i <= n; i++) {
-        Entry* e = &E(i);
+      for (i = 0, n = table->SizeMask; i <= n; i++) {
+        Entry* e = &TableEntry(table, i);
         if (e->IsEmpty() == false) {
           // Insert old Entry into new HashSet.
           newHash.Add(e->Value);
@@ -801,11 +913,12 @@ class HashSetBase {
       }
 
       // Delete our old data buffer.
-      Allocator::Free(pTable);
+      Allocator::Free(table);
     }
 
     // Steal newHash's data.
     pTable = newHash.pTable;
+    pOldTable = NULL;
     newHash.pTable = NULL;
   }
 
@@ -816,6 +929,9 @@ class HashSetBase {
     // in memory.
   };
   TableType* pTable;
+  TableType* pOldTable; // Being moved into pTable, while rehashing incrementally.
+  size_t MigrateIndex; // pOldTable's next bucket to move.
+  bool IncrementalRehash;
 };
 
 //-----------------------------------------------------------------------------------
@@ -1168,6 +1284,9 @@ class Hash {
   inline void SetCapacity(size_t newSize) {
     mHash.SetCapacity(newSize);
   }
+  inline void SetIncrementalRehash(bool enabled) {
+    mHash.SetIncrementalRehash(enabled);
+  }
 
   // Iterator API, like STL.
   typedef typename Container::ConstIterator ConstIterator;
@@ -0,0 +1,207 @@
+/************************************************************************************
+
+Filename    :   OVR_InplaceFunction.h
+Content     :   Fixed-capacity callable wrapper which never allocates
+Created     :   October 14, 2026
+Notes       :
+    InplaceFunction<Signature, Capacity> holds any copyable callable, including capturing
+    lambdas, within Capacity bytes of inline storage. Unlike std::function there is no heap
+    fallback: a callable which doesn't fit fails to compile, so construction, copying and
+    calling never allocate.
+
+        InplaceFunction<void(int)> f = [this, scale](int value) { Total += value * scale; };
+        f(3);
+
+    It has the IsValid() and FromMember/FromFree creation functions of Delegate0..3, so it
+    can be used as the DelegateT of CallbackEmitter and CallbackListener.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_InplaceFunction_h
+#define OVR_InplaceFunction_h
+
+#include "OVR_Types.h"
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace OVR {
+
+// Enough for a lambda capturing four pointers, or an object pointer and a member function pointer.
+static const size_t InplaceFunctionDefaultCapacity = 4 * sizeof(void*);
+
+template <class Signature, size_t Capacity = InplaceFunctionDefaultCapacity>
+class InplaceFunction;
+
+template <class R, class... Args, size_t Capacity>
+class InplaceFunction<R(Args...), Capacity> {
+  typedef InplaceFunction<R(Args...), Capacity> this_type;
+
+  // Operations on the stored callable, shared by all InplaceFunctions holding its type.
+  struct OpsTable {
+    R (*Invoke)(void* storage, Args&&... args);
+    void (*Copy)(void* dest, const void* src);
+    void (*Destroy)(void* storage);
+  };
+
+  template <class F>
+  struct OpsFor {
+    static R Invoke(void* storage, Args&&... args) {
+      return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+    }
+
+    static void Copy(void* dest, const void* src) {
+      new (dest) F(*static_cast<const F*>(src));
+    }
+
+    static void Destroy(void* storage) {
+      static_cast<F*>(storage)->~F();
+    }
+
+    static const OpsTable* Get() {
+      static const OpsTable table = {&Invoke, &Copy, &Destroy};
+      return &table;
+    }
+  };
+
+  template <class F>
+  using EnableIfCallable = typename std::enable_if<
+      !std::is_same<typename std::decay<F>::type, this_type>::value &&
+      !std::is_same<typename std::decay<F>::type, std::nullptr_t>::value>::type;
+
+  template <class F>
+  void Construct(F&& f) {
+    typedef typename std::decay<F>::type Functor;
+    static_assert(sizeof(Functor) <= Capacity, "InplaceFunction: the callable exceeds Capacity.");
+    static_assert(
+        alignof(Functor) <= alignof(std::max_align_t),
+        "InplaceFunction: the callable is over-aligned.");
+    static_assert(
+        std::is_copy_constructible<Functor>::value,
+        "InplaceFunction: the callable must be copyable.");
+
+    new (&Storage) Functor(std::forward<F>(f));
+    Ops = OpsFor<Functor>::Get();
+  }
+
+  const OpsTable* Ops;
+  typename std::aligned_storage<Capacity, alignof(std::max_align_t)>::type Storage;
+
+ public:
+  InplaceFunction() : Ops(nullptr) {}
+
+  InplaceFunction(std::nullptr_t) : Ops(nullptr) {}
+
+  // A null function pointer makes an invalid InplaceFunction, as with Delegates.
+  InplaceFunction(R (*f)(Args...)) : Ops(nullptr) {
+    if (f)
+      Construct(f);
+  }
+
+  template <class F, class = EnableIfCallable<F>>
+  InplaceFunction(F&& f) : Ops(nullptr) {
+    Construct(std::forward<F>(f));
+  }
+
+  InplaceFunction(const this_type& other) : Ops(nullptr) {
+    if (other.Ops) {
+      other.Ops->Copy(&Storage, &other.Storage);
+      Ops = other.Ops;
+    }
+  }
+
+  ~InplaceFunction() {
+    Invalidate();
+  }
+
+  this_type& operator=(const this_type& other) {
+    if (this != &other) {
+      Invalidate();
+      if (other.Ops) {
+        other.Ops->Copy(&Storage, &other.Storage);
+        Ops = other.Ops;
+      }
+    }
+    return *this;
+  }
+
+  this_type& operator=(std::nullptr_t) {
+    Invalidate();
+    return *this;
+  }
+
+  template <class F, class = EnableIfCallable<F>>
+  this_type& operator=(F&& f) {
+    Invalidate();
+    Construct(std::forward<F>(f));
+    return *this;
+  }
+
+  // Function invocation. The callable is called as non-const, as with std::function.
+  R operator()(Args... args) const {
+    OVR_ASSERT(Ops);
+    return Ops->Invoke(
+        const_cast<void*>(static_cast<const void*>(&Storage)), std::forward<Args>(args)...);
+  }
+
+  bool IsValid() const {
+    return Ops != nullptr;
+  }
+
+  bool operator!() const {
+    return Ops == nullptr;
+  }
+
+  explicit operator bool() const {
+    return Ops != nullptr;
+  }
+
+  // Destroys the stored callable.
+  void Invalidate() {
+    if (Ops) {
+      Ops->Destroy(&Storage);
+      Ops = nullptr;
+    }
+  }
+
+  // Creation in the style of Delegate0..3, for code moving over from them.
+
+  template <R (*F)(Args...)>
+  static this_type FromFree() {
+    return this_type([](Args... args) -> R { return (F)(std::forward<Args>(args)...); });
+  }
+
+  template <class T, R (T::*F)(Args...)>
+  static this_type FromMember(T* object) {
+    return this_type(
+        [object](Args... args) -> R { return (object->*F)(std::forward<Args>(args)...); });
+  }
+
+  template <class T, R (T::*F)(Args...) const>
+  static this_type FromConstMember(T const* object) {
+    return this_type(
+        [object](Args... args) -> R { return (object->*F)(std::forward<Args>(args)...); });
+  }
+};
+
+} // namespace OVR
+
+#endif // OVR_InplaceFunction_h
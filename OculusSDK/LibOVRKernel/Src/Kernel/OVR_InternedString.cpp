@@ -0,0 +1,76 @@
+/************************************************************************************
+
+Filename    :   OVR_InternedString.cpp
+Content     :   Interned strings with precomputed hashes, and the pool which owns them
+Created     :   October 14, 2026
+Notes       :
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR_InternedString.h"
+
+namespace OVR {
+
+//-----------------------------------------------------------------------------------
+// ***** StringPool
+
+StringPool::StringPool() : Entries(), PoolLock() {}
+
+StringPool::~StringPool() {
+  for (HashSet<EntryKey, EntryHashFunctor>::Iterator it = Entries.Begin(); it != Entries.End();
+       ++it)
+    OVR_FREE(const_cast<Entry*>(it->pEntry));
+}
+
+InternedString StringPool::Intern(const StringView& str) {
+  Lock::Locker locker(&PoolLock);
+
+  const EntryKey* key = Entries.GetAlt(str);
+  if (key)
+    return InternedString(key->pEntry);
+
+  Entry* entry = (Entry*)OVR_ALLOC(offsetof(Entry, Data) + str.GetSize() + 1);
+  if (!entry)
+    return InternedString();
+
+  entry->Hash = String::BernsteinHashFunction(str.GetData(), str.GetSize());
+  entry->NoCaseHash = OVR_memihash(str.GetData(), str.GetSize());
+  entry->Size = str.GetSize();
+  memcpy(entry->Data, str.GetData(), str.GetSize());
+  entry->Data[str.GetSize()] = '\0';
+
+  EntryKey newKey = {entry};
+  Entries.Add(newKey);
+  return InternedString(entry);
+}
+
+InternedString StringPool::Find(const StringView& str) const {
+  Lock::Locker locker(&PoolLock);
+
+  const EntryKey* key = Entries.GetAlt(str);
+  return key ? InternedString(key->pEntry) : InternedString();
+}
+
+size_t StringPool::GetCount() const {
+  Lock::Locker locker(&PoolLock);
+  return Entries.GetSize();
+}
+
+} // namespace OVR
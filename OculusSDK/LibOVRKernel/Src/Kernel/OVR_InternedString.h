@@ -0,0 +1,168 @@
+/************************************************************************************
+
+Filename    :   OVR_InternedString.h
+Content     :   Interned strings with precomputed hashes, and the pool which owns them
+Created     :   October 14, 2026
+Notes       :
+    A StringPool stores one copy of each distinct string interned into it, along with its
+    case-sensitive and case-insensitive hashes. An InternedString is a pointer to such a copy,
+    so interned strings from the same pool compare equal exactly when their pointers are equal,
+    and hashing one just reads the stored hash. Keys which are looked up repeatedly (config
+    and JSON names) can be interned once and then used without allocating or rehashing:
+
+        StringPool pool;
+        InternedString key = pool.Intern("EnableTimeouts");
+        Hash<InternedString, int, InternedString::HashFunctor> settings;
+        settings.Set(key, 1);
+        int* value = settings.Get(key);
+
+    GetHash() and GetNoCaseHash() match String::HashFunctor and String::NoCaseHashFunctor, so
+    an interned string can also be used as a StringView key in String-keyed tables.
+
+    Interned strings are valid for the lifetime of their pool. The pool is thread-safe.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_InternedString_h
+#define OVR_InternedString_h
+
+#include "OVR_String.h"
+#include "OVR_Hash.h"
+#include "OVR_Atomic.h"
+
+namespace OVR {
+
+class StringPool;
+
+//-----------------------------------------------------------------------------------
+// ***** InternedString
+
+class InternedString {
+ public:
+  InternedString() : pEntry(nullptr) {}
+
+  // A default constructed InternedString refers to no pool entry, and reads as "".
+  bool IsNull() const {
+    return (pEntry == nullptr);
+  }
+
+  const char* ToCStr() const {
+    return pEntry ? pEntry->Data : "";
+  }
+
+  // Byte length.
+  size_t GetSize() const {
+    return pEntry ? pEntry->Size : 0;
+  }
+
+  size_t GetHash() const {
+    return pEntry ? pEntry->Hash : String::BernsteinHashFunction("", 0);
+  }
+
+  size_t GetNoCaseHash() const {
+    return pEntry ? pEntry->NoCaseHash : OVR_memihash("", 0);
+  }
+
+  operator StringView() const {
+    return StringView(ToCStr(), GetSize());
+  }
+
+  // Only meaningful between strings interned in the same pool.
+  bool operator==(const InternedString& str) const {
+    return (pEntry == str.pEntry);
+  }
+
+  bool operator!=(const InternedString& str) const {
+    return (pEntry != str.pEntry);
+  }
+
+  struct HashFunctor {
+    size_t operator()(const InternedString& str) const {
+      return str.GetHash();
+    }
+  };
+
+ protected:
+  friend class StringPool;
+
+  struct Entry {
+    size_t Hash;
+    size_t NoCaseHash;
+    size_t Size;
+    char Data[1]; // Size bytes plus a null terminator.
+  };
+
+  explicit InternedString(const Entry* entry) : pEntry(entry) {}
+
+  const Entry* pEntry;
+};
+
+//-----------------------------------------------------------------------------------
+// ***** StringPool
+
+class StringPool {
+  OVR_NON_COPYABLE(StringPool)
+
+ public:
+  StringPool();
+
+  // Frees all entries; InternedStrings from this pool must not be used after this.
+  ~StringPool();
+
+  // Returns the pool's copy of str, adding one if there is none yet.
+  InternedString Intern(const StringView& str);
+
+  // Returns the pool's copy of str if there is one, else a null InternedString. Never
+  // allocates.
+  InternedString Find(const StringView& str) const;
+
+  size_t GetCount() const;
+
+ protected:
+  typedef InternedString::Entry Entry;
+
+  struct EntryKey {
+    const Entry* pEntry;
+
+    bool operator==(const EntryKey& key) const {
+      return (pEntry == key.pEntry);
+    }
+    bool operator==(const StringView& view) const {
+      return (pEntry->Size == view.GetSize()) &&
+          (memcmp(pEntry->Data, view.GetData(), view.GetSize()) == 0);
+    }
+  };
+
+  struct EntryHashFunctor {
+    size_t operator()(const EntryKey& key) const {
+      return key.pEntry->Hash;
+    }
+    size_t operator()(const StringView& view) const {
+      return String::BernsteinHashFunction(view.GetData(), view.GetSize());
+    }
+  };
+
+  HashSet<EntryKey, EntryHashFunctor> Entries;
+  mutable Lock PoolLock; // Protects Entries.
+};
+
+} // namespace OVR
+
+#endif // OVR_InternedString_h
@@ -59,80 +59,223 @@ limitations under the License.
 #include "OVR_JSON.h"
 #include "OVR_SysFile.h"
 #include "OVR_Log.h"
+#include "OVR_Alg.h"
+#include "OVR_Array.h"
+#include "OVR_FlatHash.h"
+
+//-----------------------------------------------------------------------------
+// OVR_JSON_SSE2
+//
+// Defined as 0 or 1. If enabled then whitespace and string contents are scanned 16 bytes at a
+// time with SSE2, else one byte at a time.
+//
+#ifndef OVR_JSON_SSE2
+#if defined(__SSE2__) || defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define OVR_JSON_SSE2 1
+#else
+#define OVR_JSON_SSE2 0
+#endif
+#endif
+
+#if OVR_JSON_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace OVR {
 
 //-----------------------------------------------------------------------------
-// Create a new copy of a string
-static char* JSON_strdup(const char* str) {
-  size_t len = OVR_strlen(str) + 1;
-  char* copy = (char*)OVR_ALLOC(len);
-  if (!copy)
-    return 0;
-  memcpy(copy, str, len);
-  return copy;
-}
+// ***** JSONWriter
 
-//-----------------------------------------------------------------------------
-// Render the number from the given item into a string.
-static char* PrintInt(int valueint) {
-  char* str;
-  str = (char*)OVR_ALLOC(21); // 2^64+1 can be represented in 21 chars.
-  if (str) {
-    snprintf(str, 21, "%d", valueint);
+// Output for JSON text. With a file, text is collected in a fixed size chunk and written out
+// each time the chunk fills, so that saving a large tree doesn't hold its whole text in memory.
+// Without a file the text is collected in a buffer which grows as needed.
+class JSONWriter {
+  OVR_NON_COPYABLE(JSONWriter)
+
+ public:
+  explicit JSONWriter(File* file = nullptr)
+      : pFile(file), Data(nullptr), Size(0), Capacity(0), Failed(false) {
+    reserve(file ? FileChunkSize : MinCapacity);
   }
-  return str;
+
+  ~JSONWriter() {
+    OVR_FREE(Data);
+  }
+
+  void Write(char c) {
+    if (Size == Capacity && !makeRoom(1))
+      return;
+    Data[Size++] = c;
+  }
+
+  void Write(const char* str, size_t length) {
+    while (length) {
+      if (Size == Capacity && !makeRoom(length))
+        return;
+      const size_t count = Alg::Min(length, Capacity - Size);
+      memcpy(Data + Size, str, count);
+      Size += count;
+      str += count;
+      length -= count;
+    }
+  }
+
+  void Write(const char* str) {
+    Write(str, OVR_strlen(str));
+  }
+
+  void WriteNewLine() {
+#ifdef OVR_OS_WIN32
+    Write('\r');
+#endif
+    Write('\n');
+  }
+
+  void WriteTabs(int count) {
+    for (int i = 0; i < count; i++)
+      Write('\t');
+  }
+
+  void Fail() {
+    Failed = true;
+  }
+
+  // Writes out the rest of the text to the file. Returns false if anything failed.
+  bool Finish() {
+    if (pFile && Size && !Failed) {
+      Failed = (pFile->Write((const uint8_t*)Data, (int)Size) != (int)Size);
+      Size = 0;
+    }
+    return !Failed;
+  }
+
+  // Returns the collected text, to be freed with OVR_FREE, or null on failure.
+  char* DetachText() {
+    OVR_ASSERT(!pFile);
+    Write('\0');
+    if (Failed)
+      return nullptr;
+    char* text = Data;
+    Data = nullptr;
+    Size = Capacity = 0;
+    return text;
+  }
+
+ protected:
+  static const size_t MinCapacity = 256;
+  static const size_t FileChunkSize = 64 * 1024;
+
+  bool reserve(size_t capacity) {
+    char* data = (char*)OVR_REALLOC(Data, capacity);
+    if (!data) {
+      Failed = true;
+      return false;
+    }
+    Data = data;
+    Capacity = capacity;
+    return true;
+  }
+
+  bool makeRoom(size_t length) {
+    if (Failed)
+      return false;
+
+    if (pFile) {
+      if (!Capacity)
+        return false;
+      Failed = (pFile->Write((const uint8_t*)Data, (int)Size) != (int)Size);
+      Size = 0;
+      return !Failed;
+    }
+
+    return reserve(Alg::Max(Capacity * 2, Size + length));
+  }
+
+  File* pFile;
+  char* Data;
+  size_t Size;
+  size_t Capacity;
+  bool Failed;
+};
+
+// Writes the decimal digits of value, which has at most 20, to the end of the buffer and
+// returns a pointer to the first.
+static char* FormatDigits(uint64_t value, char* end) {
+  do {
+    *--end = (char)('0' + (value % 10));
+    value /= 10;
+  } while (value);
+  return end;
 }
 
 //-----------------------------------------------------------------------------
 // Render the number from the given item into a string.
-static char* PrintNumber(double d) {
-  char* str;
+static void WriteNumber(JSONWriter& writer, double d) {
+  char buffer[64];
+  char* end = buffer + sizeof(buffer);
   int valueint = (int)d;
 
   if ((fabs(((double)valueint) - d) <= DBL_EPSILON) && (d <= INT_MAX) && (d >= INT_MIN)) {
-    return PrintInt(valueint);
+    // Written as "%d", without going through the C library.
+    char* str = FormatDigits((uint64_t)(valueint < 0 ? -(int64_t)valueint : valueint), end);
+    if (valueint < 0)
+      *--str = '-';
+    writer.Write(str, end - str);
+    return;
+  }
+
+  const bool integral = (fabs(floor(d) - d) <= DBL_EPSILON) && (fabs(d) < 1.0e60);
+
+  if (!integral && (fabs(d) >= 1.0) && (fabs(d) <= 1.0e9)) {
+    // Numbers >= 1 and <= 1e9 are written as "%.6f". Scaled to millionths they are below 2^53,
+    // where the product is off by at most 1/16, so unless it's close to halfway between two
+    // millionths it rounds to the same digits as the exact value would.
+    const double scaled = fabs(d) * 1.0e6;
+    const double rounded = floor(scaled + 0.5);
+    if (fabs(fabs(scaled - rounded) - 0.5) > 0.125) {
+      const uint64_t millionths = (uint64_t)rounded;
+      char* str = FormatDigits(millionths % 1000000, end);
+      while (str > end - 6)
+        *--str = '0';
+      *--str = '.';
+      str = FormatDigits(millionths / 1000000, str);
+      if (d < 0)
+        *--str = '-';
+      writer.Write(str, end - str);
+      return;
+    }
+  }
+
+  // The JSON Standard, section 7.8.3, specifies that decimals are always expressed with '.' and
+  // not some locale-specific decimal such as ',' or ' '. However, since we are using the C
+  // standard library below to write a floating point number, we need to make sure that it's
+  // writing a '.' and not something else. We can't change the locale (even temporarily) here, as
+  // it will affect the whole process by default. That are compiler-specific ways to change this
+  // per-thread, but below we implement the simple solution of simply fixing the decimal after the
+  // string was written.
+
+  if (integral) {
+    // Write integral values with no decimals
+    snprintf(buffer, sizeof(buffer), "%.0f", d);
+  } else if ((fabs(d) < 1.0) || (fabs(d) > 1.0e9)) {
+    // Write numbers < 1 or larger than 1e9 with 7 significant digits
+    snprintf(buffer, sizeof(buffer), "%.7g", d);
   } else {
-    const size_t kCapacity = 64;
-
-    str = (char*)OVR_ALLOC(kCapacity); // This is a nice tradeoff.
-    if (str) {
-      // The JSON Standard, section 7.8.3, specifies that decimals are always expressed with '.' and
-      // not some locale-specific decimal such as ',' or ' '. However, since we are using the C
-      // standard
-      // library below to write a floating point number, we need to make sure that it's writing a
-      // '.'
-      // and not something else. We can't change the locale (even temporarily) here, as it will
-      // affect
-      // the whole process by default. That are compiler-specific ways to change this per-thread,
-      // but
-      // below we implement the simple solution of simply fixing the decimal after the string was
-      // written.
-
-      if ((fabs(floor(d) - d) <= DBL_EPSILON) && (fabs(d) < 1.0e60)) {
-        // Write integral values with no decimals
-        snprintf(str, kCapacity, "%.0f", d);
-      } else if ((fabs(d) < 1.0) || (fabs(d) > 1.0e9)) {
-        // Write numbers < 1 or larger than 1e9 with 7 significant digits
-        snprintf(str, kCapacity, "%.7g", d);
-      } else {
-        // Write numbers >= 1 and <= 1e9 with 6 decimals (7 to 15 sig digits)
-        snprintf(str, kCapacity, "%.6f", d);
-      }
+    // Write numbers >= 1 and <= 1e9 with 6 decimals (7 to 15 sig digits)
+    snprintf(buffer, sizeof(buffer), "%.6f", d);
+  }
 
-      // Convert any found ',' or ''' char to '.'. This will happen only if the locale was set to
-      // write a ','
-      // instead of a '.' for the decimal point. Decimal points are represented only by one of these
-      // three characters in practice.
-      for (char* p = str; *p; p++) {
-        if ((*p == ',') || (*p == '\'')) {
-          *p = '.';
-          break;
-        }
-      }
+  // Convert any found ',' or ''' char to '.'. This will happen only if the locale was set to
+  // write a ',' instead of a '.' for the decimal point. Decimal points are represented only by
+  // one of these three characters in practice.
+  for (char* p = buffer; *p; p++) {
+    if ((*p == ',') || (*p == '\'')) {
+      *p = '.';
+      break;
     }
   }
-  return str;
+
+  writer.Write(buffer);
 }
 
 // Parse the input text into an un-escaped cstring, and populate item.
@@ -145,18 +288,170 @@ const char* AssignError(const char** perror, const char* errorMessage) {
   return 0;
 }
 
+//-----------------------------------------------------------------------------
+// ***** JSONArena
+
+// Bump allocator holding the nodes of a tree parsed with JSON_ParseArena. Its blocks are freed
+// together when the root is destroyed, after the nodes in them.
+class JSONArena : public NewOverrideBase {
+ public:
+  explicit JSONArena(size_t textLength)
+      : Blocks(nullptr),
+        Cursor(nullptr),
+        End(nullptr),
+        NextBlockSize(Alg::Clamp(textLength * 2, MinBlockSize, MaxBlockSize)) {}
+
+  ~JSONArena() {
+    while (Blocks) {
+      Block* next = Blocks->Next;
+      OVR_FREE(Blocks);
+      Blocks = next;
+    }
+  }
+
+  void* Alloc(size_t size) {
+    size = (size + (Alignment - 1)) & ~(Alignment - 1);
+
+    if ((size_t)(End - Cursor) < size) {
+      const size_t blockSize = Alg::Max(NextBlockSize, BlockHeaderSize + size);
+      Block* block = (Block*)OVR_ALLOC(blockSize);
+      if (!block)
+        return nullptr;
+
+      block->Next = Blocks;
+      Blocks = block;
+      Cursor = (uint8_t*)block + BlockHeaderSize;
+      End = (uint8_t*)block + blockSize;
+      NextBlockSize = Alg::Min(NextBlockSize * 2, MaxBlockSize);
+    }
+
+    void* p = Cursor;
+    Cursor += size;
+    return p;
+  }
+
+ protected:
+  static const size_t Alignment = 16;
+  static const size_t MinBlockSize = 4096;
+  static const size_t MaxBlockSize = 1024 * 1024;
+
+  struct Block {
+    Block* Next;
+  };
+  static const size_t BlockHeaderSize = (sizeof(Block) + (Alignment - 1)) & ~(Alignment - 1);
+
+  Block* Blocks;
+  uint8_t* Cursor;
+  uint8_t* End;
+  size_t NextBlockSize;
+};
+
+//-----------------------------------------------------------------------------
+// ***** JSONIndex
+
+// Index over the children of a JSON node, by position and by name. A name maps to the first
+// child with that name, as GetItemByName finds by walking the list.
+class JSONIndex : public NewOverrideBase {
+ public:
+  // Lookups which walk past this many children build an index.
+  static const unsigned MinItems = 16;
+
+  void Append(JSON* item) {
+    NameKey key = {item};
+    if (!Names.Get(key))
+      Names.Add(key, (unsigned)Items.GetSize());
+    Items.PushBack(item);
+  }
+
+  JSON* Find(const char* name) const {
+    const unsigned* index = Names.GetAlt(StringView(name));
+    return index ? Items[*index] : nullptr;
+  }
+
+  // Keys refer to the child's own Name, so that the index doesn't copy the names.
+  struct NameKey {
+    const JSON* pItem;
+
+    bool operator==(const NameKey& key) const {
+      return StringView(pItem->Name) == StringView(key.pItem->Name);
+    }
+    bool operator==(const StringView& view) const {
+      return StringView(pItem->Name) == view;
+    }
+  };
+
+  struct NameHashFunctor {
+    size_t operator()(const NameKey& key) const {
+      return String::BernsteinHashFunction(key.pItem->Name.data(), key.pItem->Name.size());
+    }
+    size_t operator()(const StringView& view) const {
+      return String::BernsteinHashFunction(view.GetData(), view.GetSize());
+    }
+  };
+
+  ArrayPOD<JSON*> Items;
+  FlatHash<NameKey, unsigned, NameHashFunctor> Names;
+};
+
 //-----------------------------------------------------------------------------
 // ***** JSON Node class
 
-JSON::JSON(JSONItemType itemType) : Type(itemType), dValue(0.) {}
+JSON::JSON(JSONItemType itemType)
+    : Type(itemType), dValue(0.), pArena(nullptr), InArena(false), pIndex(nullptr) {}
 
 JSON::~JSON() {
   JSON* child = Children.GetFirst();
   while (!Children.IsNull(child)) {
     child->RemoveNode();
-    child->Release();
+    releaseChild(child);
     child = Children.GetFirst();
   }
+
+  delete pIndex;
+  delete pArena;
+}
+
+void JSON::buildIndex() {
+  OVR_ASSERT(!pIndex);
+  pIndex = new JSONIndex();
+  for (JSON* child = Children.GetFirst(); !Children.IsNull(child);
+       child = Children.GetNext(child))
+    pIndex->Append(child);
+}
+
+void JSON::invalidateIndex() {
+  delete pIndex;
+  pIndex = nullptr;
+}
+
+// Undef new temporarily if it is being redefined
+#ifdef OVR_DEFINE_NEW
+#undef new
+#endif
+
+JSON* JSON::newParsedNode(JSONArena* arena) {
+  if (!arena)
+    return new JSON();
+
+  void* p = arena->Alloc(sizeof(JSON));
+  if (!p)
+    return nullptr;
+
+  JSON* node = ::new (p) JSON();
+  node->InArena = true;
+  return node;
+}
+
+#ifdef OVR_DEFINE_NEW
+#define new OVR_DEFINE_NEW
+#endif
+
+void JSON::releaseChild(JSON* child) {
+  // Arena nodes are only destroyed here; their memory goes with the arena.
+  if (child->InArena)
+    child->~JSON();
+  else
+    child->Release();
 }
 
 //-----------------------------------------------------------------------------
@@ -246,6 +541,77 @@ const char* ParseHex(unsigned* val, unsigned digits, const char* str) {
   return str;
 }
 
+#if OVR_JSON_SSE2
+// The scans below load the aligned 16 byte blocks which hold the input, ignoring the bytes of
+// the first block before the start. An aligned load never crosses a page boundary, so reading
+// a block which holds the terminating null is safe even where the buffer ends within it.
+
+// Returns a mask of the bytes in the block which are (unsigned) greater than ' ', or null.
+static inline uint32_t NonSpaceMask(__m128i block) {
+  const __m128i isSpaceOrNull = _mm_cmpeq_epi8(_mm_min_epu8(block, _mm_set1_epi8(' ')), block);
+  const __m128i isNull = _mm_cmpeq_epi8(block, _mm_setzero_si128());
+  return ((uint32_t)_mm_movemask_epi8(isSpaceOrNull) ^ 0xFFFF) |
+      (uint32_t)_mm_movemask_epi8(isNull);
+}
+
+// Returns a mask of the bytes in the block which end a run of plain string characters.
+static inline uint32_t StringSpecialMask(__m128i block) {
+  const __m128i special = _mm_or_si128(
+      _mm_or_si128(
+          _mm_cmpeq_epi8(block, _mm_set1_epi8('\"')), _mm_cmpeq_epi8(block, _mm_set1_epi8('\\'))),
+      _mm_cmpeq_epi8(block, _mm_setzero_si128()));
+  return (uint32_t)_mm_movemask_epi8(special);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Utility to jump whitespace and cr/lf
+static const char* skip(const char* in) {
+  if (!in)
+    return in;
+
+#if OVR_JSON_SSE2
+  // Most whitespace is between tokens on a line and ends right away.
+  if ((unsigned char)*in > ' ' || !*in)
+    return in;
+
+  const size_t offset = (uintptr_t)in & 15;
+  const char* block = in - offset;
+  uint32_t mask = NonSpaceMask(_mm_load_si128((const __m128i*)block)) >> offset << offset;
+
+  while (!mask) {
+    block += 16;
+    mask = NonSpaceMask(_mm_load_si128((const __m128i*)block));
+  }
+
+  return block + Alg::CountTrailing0Bits(mask);
+#else
+  while (*in && (unsigned char)*in <= ' ')
+    in++;
+  return in;
+#endif
+}
+
+// Returns the first quote, backslash or null at or after str.
+static const char* skipStringRun(const char* str) {
+#if OVR_JSON_SSE2
+  const size_t offset = (uintptr_t)str & 15;
+  const char* block = str - offset;
+  uint32_t mask = StringSpecialMask(_mm_load_si128((const __m128i*)block)) >> offset << offset;
+
+  while (!mask) {
+    block += 16;
+    mask = StringSpecialMask(_mm_load_si128((const __m128i*)block));
+  }
+
+  return block + Alg::CountTrailing0Bits(mask);
+#else
+  while (*str && *str != '\"' && *str != '\\')
+    str++;
+  return str;
+#endif
+}
+
 //-----------------------------------------------------------------------------
 // Parses the input text into a string item and returns the text position after
 // the parsed string
@@ -261,22 +627,32 @@ const char* JSON::parseString(const char* str, const char** perror) {
     return AssignError(perror, "Syntax Error: Missing quote");
   }
 
-  while (*ptr != '\"' && *ptr && ++len) {
-    if (*ptr++ == '\\')
+  for (;;) {
+    const char* run = skipStringRun(ptr);
+    len += (int)(run - ptr);
+    ptr = run;
+    if (*ptr != '\\')
+      break;
+    len++;
+    ptr++;
+    if (*ptr)
       ptr++; // Skip escaped quotes.
   }
 
-  // This is how long we need for the string, roughly.
-  out = (char*)OVR_ALLOC(len + 1);
-  if (!out)
-    return 0;
+  // This is how long we need for the string, roughly. Unescape straight into Value, which
+  // needs no allocation at all for short strings.
+  Value.resize(len + 1);
+  out = &static_cast<std::string&>(Value)[0];
 
   ptr = str + 1;
   ptr2 = out;
 
   while (*ptr != '\"' && *ptr) {
     if (*ptr != '\\') {
-      *ptr2++ = *ptr++;
+      const char* run = skipStringRun(ptr);
+      memcpy(ptr2, ptr, run - ptr);
+      ptr2 += run - ptr;
+      ptr = run;
     } else {
       ptr++;
       switch (*ptr) {
@@ -361,13 +737,10 @@ const char* JSON::parseString(const char* str, const char** perror) {
     }
   }
 
-  *ptr2 = 0;
   if (*ptr == '\"')
     ptr++;
 
-  // Make a copy of the string
-  Value = out;
-  OVR_FREE(out);
+  Value.resize(ptr2 - out);
   Type = JSON_String;
 
   return ptr;
@@ -375,86 +748,60 @@ const char* JSON::parseString(const char* str, const char** perror) {
 
 //-----------------------------------------------------------------------------
 // Render the string provided to an escaped version that can be printed.
-char* PrintString(const char* str) {
-  const char* ptr;
-  char *ptr2, *out;
-  int len = 0;
-  unsigned char token;
-
-  if (!str)
-    return JSON_strdup("");
-  ptr = str;
-
-  token = *ptr;
-  while (token && ++len) {
-    if (strchr("\"\\\b\f\n\r\t", token))
-      len++;
-    else if (token < 32)
-      len += 5;
-    ptr++;
-    token = *ptr;
-  }
+static void WriteString(JSONWriter& writer, const char* str) {
+  writer.Write('\"');
 
-  int buff_size = len + 3;
-  out = (char*)OVR_ALLOC(buff_size);
-  if (!out)
-    return 0;
+  if (str) {
+    const char* run = str;
 
-  ptr2 = out;
-  ptr = str;
-  *ptr2++ = '\"';
-
-  while (*ptr) {
-    if ((unsigned char)*ptr > 31 && *ptr != '\"' && *ptr != '\\')
-      *ptr2++ = *ptr++;
-    else {
-      *ptr2++ = '\\';
-      switch (token = *ptr++) {
+    for (const char* ptr = str; *ptr; ptr++) {
+      const unsigned char token = *ptr;
+      if (token > 31 && token != '\"' && token != '\\')
+        continue;
+
+      writer.Write(run, ptr - run);
+      run = ptr + 1;
+
+      char escape[8] = {'\\'};
+      switch (token) {
         case '\\':
-          *ptr2++ = '\\';
+          escape[1] = '\\';
           break;
         case '\"':
-          *ptr2++ = '\"';
+          escape[1] = '\"';
           break;
         case '\b':
-          *ptr2++ = 'b';
+          escape[1] = 'b';
           break;
         case '\f':
-          *ptr2++ = 'f';
+          escape[1] = 'f';
           break;
         case '\n':
-          *ptr2++ = 'n';
+          escape[1] = 'n';
           break;
         case '\r':
-          *ptr2++ = 'r';
+          escape[1] = 'r';
           break;
         case '\t':
-          *ptr2++ = 't';
+          escape[1] = 't';
           break;
         default:
-          snprintf(ptr2, buff_size - (ptr2 - out), "u%04x", token);
-          ptr2 += 5;
+          snprintf(escape + 1, sizeof(escape) - 1, "u%04x", token);
           break; // Escape and print.
       }
+      writer.Write(escape);
     }
+
+    writer.Write(run);
   }
-  *ptr2++ = '\"';
-  *ptr2++ = 0;
-  return out;
-}
 
-//-----------------------------------------------------------------------------
-// Utility to jump whitespace and cr/lf
-static const char* skip(const char* in) {
-  while (in && *in && (unsigned char)*in <= ' ')
-    in++;
-  return in;
+  writer.Write('\"');
 }
 
 //-----------------------------------------------------------------------------
 // Parses the supplied buffer of JSON text and returns a JSON object tree
 // The returned object must be Released after use
-JSON* JSON::Parse(const char* buff, const char** perror) {
+JSON* JSON::Parse(const char* buff, const char** perror, JSONParseMode mode) {
   const char* end = 0;
   JSON* json = new JSON();
 
@@ -463,7 +810,10 @@ JSON* JSON::Parse(const char* buff, const char** perror) {
     return 0;
   }
 
-  end = json->parseValue(skip(buff), perror);
+  if (mode == JSON_ParseArena)
+    json->pArena = new JSONArena(buff ? OVR_strlen(buff) : 0);
+
+  end = json->parseValue(skip(buff), perror, json->pArena);
   if (!end) {
     json->Release();
     return NULL;
@@ -474,14 +824,14 @@ JSON* JSON::Parse(const char* buff, const char** perror) {
 
 //-----------------------------------------------------------------------------
 // This version works for buffers that are not null terminated strings.
-JSON* JSON::ParseBuffer(const char* buff, int len, const char** perror) {
+JSON* JSON::ParseBuffer(const char* buff, int len, const char** perror, JSONParseMode mode) {
   // Our JSON parser does not support length-based parsing,
   // so ensure it is null-terminated.
   char* termStr = new char[len + 1];
   memcpy(termStr, buff, len);
   termStr[len] = '\0';
 
-  JSON* objJson = Parse(termStr, perror);
+  JSON* objJson = Parse(termStr, perror, mode);
 
   delete[] termStr;
 
@@ -490,7 +840,7 @@ JSON* JSON::ParseBuffer(const char* buff, int len, const char** perror) {
 
 //-----------------------------------------------------------------------------
 // Parser core - when encountering text, process appropriately.
-const char* JSON::parseValue(const char* buff, const char** perror) {
+const char* JSON::parseValue(const char* buff, const char** perror, JSONArena* arena) {
   if (perror)
     *perror = 0;
 
@@ -520,10 +870,10 @@ const char* JSON::parseValue(const char* buff, const char** perror) {
     return parseNumber(buff);
   }
   if (*buff == '[') {
-    return parseArray(buff, perror);
+    return parseArray(buff, perror, arena);
   }
   if (*buff == '{') {
-    return parseObject(buff, perror);
+    return parseObject(buff, perror, arena);
   }
 
   return AssignError(perror, "Syntax Error: Invalid syntax");
@@ -531,42 +881,38 @@ const char* JSON::parseValue(const char* buff, const char** perror) {
 
 //-----------------------------------------------------------------------------
 // Render a value to text.
-char* JSON::PrintValue(int depth, bool fmt) {
-  char* out = 0;
-
+bool JSON::writeValue(JSONWriter& writer, int depth, bool fmt) const {
   switch (Type) {
     case JSON_Null:
-      out = JSON_strdup("null");
+      writer.Write("null", 4);
       break;
     case JSON_Bool:
       if ((int)dValue == 0)
-        out = JSON_strdup("false");
+        writer.Write("false", 5);
       else
-        out = JSON_strdup("true");
+        writer.Write("true", 4);
       break;
     case JSON_Number:
-      out = PrintNumber(dValue);
+      WriteNumber(writer, dValue);
       break;
     case JSON_String:
-      out = PrintString(Value);
+      WriteString(writer, Value);
       break;
     case JSON_Array:
-      out = PrintArray(depth, fmt);
-      break;
+      return writeArray(writer, depth, fmt);
     case JSON_Object:
-      out = PrintObject(depth, fmt);
-      break;
+      return writeObject(writer, depth, fmt);
     case JSON_None:
       OVR_ASSERT_LOG(false, ("Bad JSON type."));
-      break;
+      return false;
   }
-  return out;
+  return true;
 }
 
 //-----------------------------------------------------------------------------
 // Build an array object from input text and returns the text position after
 // the parsed array
-const char* JSON::parseArray(const char* buff, const char** perror) {
+const char* JSON::parseArray(const char* buff, const char** perror, JSONArena* arena) {
   JSON* child;
   if (*buff != '[') {
     return AssignError(perror, "Syntax Error: Missing opening bracket");
@@ -578,23 +924,23 @@ const char* JSON::parseArray(const char* buff, const char** perror) {
   if (*buff == ']')
     return buff + 1; // empty array.
 
-  child = new JSON();
+  child = newParsedNode(arena);
   if (!child)
     return 0; // memory fail
   Children.PushBack(child);
 
-  buff = skip(child->parseValue(skip(buff), perror)); // skip any spacing, get the buff.
+  buff = skip(child->parseValue(skip(buff), perror, arena)); // skip any spacing, get the buff.
   if (!buff)
     return 0;
 
   while (*buff == ',') {
-    JSON* new_item = new JSON();
+    JSON* new_item = newParsedNode(arena);
     if (!new_item)
       return AssignError(perror, "Error: Failed to allocate memory");
 
     Children.PushBack(new_item);
 
-    buff = skip(new_item->parseValue(skip(buff + 1), perror));
+    buff = skip(new_item->parseValue(skip(buff + 1), perror, arena));
     if (!buff)
       return AssignError(perror, "Error: Failed to allocate memory");
   }
@@ -606,85 +952,30 @@ const char* JSON::parseArray(const char* buff, const char** perror) {
 }
 
 //-----------------------------------------------------------------------------
-// Render an array to text.  The returned text must be freed
-char* JSON::PrintArray(int depth, bool fmt) {
-  char** entries;
-  char *out = 0, *ptr, *ret;
-  intptr_t len = 5;
-
-  bool fail = false;
-
-  // How many entries in the array?
-  int numentries = GetItemCount();
-  if (!numentries) {
-    out = (char*)OVR_ALLOC(3);
-    if (out)
-      OVR_strcpy(out, 3, "[]");
-    return out;
-  }
-  // Allocate an array to hold the values for each
-  entries = (char**)OVR_ALLOC(numentries * sizeof(char*));
-  if (!entries)
-    return 0;
-  memset(entries, 0, numentries * sizeof(char*));
-
-  //// Retrieve all the results:
-  JSON* child = Children.GetFirst();
-  for (int i = 0; i < numentries; i++) {
-    // JSON* child = Children[i];
-    ret = child->PrintValue(depth + 1, fmt);
-    entries[i] = ret;
-    if (ret)
-      len += OVR_strlen(ret) + 2 + (fmt ? 1 : 0);
-    else {
-      fail = true;
-      break;
-    }
-    child = Children.GetNext(child);
-  }
+// Render an array to text.
+bool JSON::writeArray(JSONWriter& writer, int depth, bool fmt) const {
+  writer.Write('[');
 
-  // If we didn't fail, try to malloc the output string
-  if (!fail)
-    out = (char*)OVR_ALLOC(len);
-  // If that fails, we fail.
-  if (!out)
-    fail = true;
+  for (const JSON* child = Children.GetFirst(); !Children.IsNull(child);
+       child = Children.GetNext(child)) {
+    if (!child->writeValue(writer, depth + 1, fmt))
+      return false;
 
-  // Handle failure.
-  if (fail) {
-    for (int i = 0; i < numentries; i++) {
-      if (entries[i])
-        OVR_FREE(entries[i]);
-    }
-    OVR_FREE(entries);
-    return 0;
-  }
-
-  // Compose the output array.
-  *out = '[';
-  ptr = out + 1;
-  *ptr = 0;
-  for (int i = 0; i < numentries; i++) {
-    OVR_strcpy(ptr, len - (ptr - out), entries[i]);
-    ptr += OVR_strlen(entries[i]);
-    if (i != numentries - 1) {
-      *ptr++ = ',';
+    if (!Children.IsLast(child)) {
+      writer.Write(',');
       if (fmt)
-        *ptr++ = ' ';
-      *ptr = 0;
+        writer.Write(' ');
     }
-    OVR_FREE(entries[i]);
   }
-  OVR_FREE(entries);
-  *ptr++ = ']';
-  *ptr++ = 0;
-  return out;
+
+  writer.Write(']');
+  return true;
 }
 
 //-----------------------------------------------------------------------------
 // Build an object from the supplied text and returns the text position after
 // the parsed object
-const char* JSON::parseObject(const char* buff, const char** perror) {
+const char* JSON::parseObject(const char* buff, const char** perror, JSONArena* arena) {
   if (*buff != '{') {
     return AssignError(perror, "Syntax Error: Missing opening brace");
   }
@@ -694,7 +985,9 @@ const char* JSON::parseObject(const char* buff, const char** perror) {
   if (*buff == '}')
     return buff + 1; // empty array.
 
-  JSON* child = new JSON();
+  JSON* child = newParsedNode(arena);
+  if (!child)
+    return 0; // memory fail
   Children.PushBack(child);
 
   buff = skip(child->parseString(skip(buff), perror));
@@ -707,12 +1000,12 @@ const char* JSON::parseObject(const char* buff, const char** perror) {
     return AssignError(perror, "Syntax Error: Missing colon");
   }
 
-  buff = skip(child->parseValue(skip(buff + 1), perror)); // skip any spacing, get the value.
+  buff = skip(child->parseValue(skip(buff + 1), perror, arena)); // skip any spacing, get the value.
   if (!buff)
     return 0;
 
   while (*buff == ',') {
-    child = new JSON();
+    child = newParsedNode(arena);
     if (!child)
       return 0; // memory fail
 
@@ -730,7 +1023,7 @@ const char* JSON::parseObject(const char* buff, const char** perror) {
     } // fail!
 
     // Skip any spacing, get the value.
-    buff = skip(child->parseValue(skip(buff + 1), perror));
+    buff = skip(child->parseValue(skip(buff + 1), perror, arena));
     if (!buff)
       return 0;
   }
@@ -742,152 +1035,55 @@ const char* JSON::parseObject(const char* buff, const char** perror) {
 }
 
 //-----------------------------------------------------------------------------
-// Render an object to text.  The returned string must be freed
-char* JSON::PrintObject(int depth, bool fmt) {
-  char **entries = 0, **names = 0;
-  char* out = 0;
-  char *ptr, *ret, *str;
-  intptr_t len = 7, i = 0, j;
-  bool fail = false;
-
-  // Count the number of entries.
-  int numentries = GetItemCount();
+// Render an object to text.
+bool JSON::writeObject(JSONWriter& writer, int depth, bool fmt) const {
+  writer.Write('{');
 
   // Explicitly handle empty object case
-  if (numentries == 0) {
-    out = (char*)OVR_ALLOC(fmt ? depth + 4 : 4);
-    if (!out)
-      return 0;
-    ptr = out;
-    *ptr++ = '{';
-
+  if (Children.IsEmpty()) {
     if (fmt) {
-#ifdef OVR_OS_WIN32
-      *ptr++ = '\r';
-#endif
-      *ptr++ = '\n';
-      for (i = 0; i < depth - 1; i++)
-        *ptr++ = '\t';
+      writer.WriteNewLine();
+      writer.WriteTabs(depth - 1);
     }
-    *ptr++ = '}';
-    *ptr++ = 0;
-    return out;
-  }
-  // Allocate space for the names and the objects
-  entries = (char**)OVR_ALLOC(numentries * sizeof(char*));
-  if (!entries)
-    return 0;
-  names = (char**)OVR_ALLOC(numentries * sizeof(char*));
-
-  if (!names) {
-    OVR_FREE(entries);
-    return 0;
+    writer.Write('}');
+    return true;
   }
-  memset(entries, 0, sizeof(char*) * numentries);
-  memset(names, 0, sizeof(char*) * numentries);
 
-  // Collect all the results into our arrays:
   depth++;
   if (fmt)
-    len += depth;
-
-  JSON* child = Children.GetFirst();
-  while (!Children.IsNull(child)) {
-    names[i] = str = PrintString(child->Name);
-    entries[i++] = ret = child->PrintValue(depth, fmt);
-
-    if (str && ret) {
-      len += OVR_strlen(ret) + OVR_strlen(str) + 2 + (fmt ? 3 + depth : 0);
-    } else {
-      fail = true;
-      break;
-    }
-
-    child = Children.GetNext(child);
-  }
-
-  // Try to allocate the output string
-  if (!fail)
-    out = (char*)OVR_ALLOC(len);
-  if (!out)
-    fail = true;
-
-  // Handle failure
-  if (fail) {
-    for (i = 0; i < numentries; i++) {
-      if (names[i])
-        OVR_FREE(names[i]);
-
-      if (entries[i])
-        OVR_FREE(entries[i]);
-    }
-
-    OVR_FREE(names);
-    OVR_FREE(entries);
-    return 0;
-  }
-
-  // Compose the output:
-  *out = '{';
-  ptr = out + 1;
-  if (fmt) {
-#ifdef OVR_OS_WIN32
-    *ptr++ = '\r';
-#endif
-    *ptr++ = '\n';
-  }
-  *ptr = 0;
-
-  for (i = 0; i < numentries; i++) {
-    if (fmt) {
-      for (j = 0; j < depth; j++) {
-        *ptr++ = '\t';
-      }
-    }
-    OVR_strcpy(ptr, len - (ptr - out), names[i]);
-    ptr += OVR_strlen(names[i]);
-    *ptr++ = ':';
+    writer.WriteNewLine();
 
-    if (fmt) {
-      *ptr++ = '\t';
-    }
-
-    OVR_strcpy(ptr, len - (ptr - out), entries[i]);
-    ptr += OVR_strlen(entries[i]);
-
-    if (i != numentries - 1) {
-      *ptr++ = ',';
-    }
-
-    if (fmt) {
-#ifdef OVR_OS_WIN32
-      *ptr++ = '\r';
-#endif
-      *ptr++ = '\n';
-    }
-    *ptr = 0;
+  for (const JSON* child = Children.GetFirst(); !Children.IsNull(child);
+       child = Children.GetNext(child)) {
+    if (fmt)
+      writer.WriteTabs(depth);
 
-    OVR_FREE(names[i]);
-    OVR_FREE(entries[i]);
-  }
+    WriteString(writer, child->Name);
+    writer.Write(':');
+    if (fmt)
+      writer.Write('\t');
 
-  OVR_FREE(names);
-  OVR_FREE(entries);
+    if (!child->writeValue(writer, depth, fmt))
+      return false;
 
-  if (fmt) {
-    for (i = 0; i < depth - 1; i++) {
-      *ptr++ = '\t';
-    }
+    if (!Children.IsLast(child))
+      writer.Write(',');
+    if (fmt)
+      writer.WriteNewLine();
   }
-  *ptr++ = '}';
-  *ptr++ = 0;
 
-  return out;
+  if (fmt)
+    writer.WriteTabs(depth - 1);
+  writer.Write('}');
+  return true;
 }
 
 // Returns the number of child items in the object
 // Counts the number of items in the object.
 unsigned JSON::GetItemCount() const {
+  if (pIndex)
+    return (unsigned)pIndex->Items.GetSize();
+
   unsigned count = 0;
   for (const JSON* p = Children.GetFirst(); !Children.IsNull(p); p = Children.GetNext(p)) {
     count++;
@@ -896,6 +1092,11 @@ unsigned JSON::GetItemCount() const {
 }
 
 JSON* JSON::GetItemByIndex(unsigned index) {
+  if (!pIndex && (index >= JSONIndex::MinItems))
+    buildIndex();
+  if (pIndex)
+    return (index < pIndex->Items.GetSize()) ? pIndex->Items[index] : 0;
+
   unsigned i = 0;
   JSON* child = 0;
 
@@ -917,7 +1118,11 @@ JSON* JSON::GetItemByIndex(unsigned index) {
 
 // Returns the child item with the given name or NULL if not found
 JSON* JSON::GetItemByName(const char* name) {
+  if (pIndex)
+    return pIndex->Find(name);
+
   JSON* child = 0;
+  unsigned i = 0;
 
   if (!Children.IsEmpty()) {
     child = Children.GetFirst();
@@ -928,9 +1133,14 @@ JSON* JSON::GetItemByName(const char* name) {
         break;
       }
       child = child->GetNext();
+      i++;
     }
   }
 
+  // Look up the next name in an index if this one took long to find.
+  if (i >= JSONIndex::MinItems)
+    buildIndex();
+
   return child;
 }
 
@@ -940,6 +1150,8 @@ void JSON::AddItem(const char* string, JSON* item) {
   if (item) {
     item->Name = string;
     Children.PushBack(item);
+    if (pIndex)
+      pIndex->Append(item);
   }
 }
 
@@ -986,8 +1198,9 @@ void JSON::ReplaceItem(unsigned int index, JSON* new_item)
 void JSON::RemoveLast() {
   JSON* child = Children.GetLast();
   if (!Children.IsNull(child)) {
+    invalidateIndex();
     child->RemoveNode();
-    child->Release();
+    releaseChild(child);
   }
 }
 
@@ -1067,6 +1280,8 @@ String JSON::GetStringByName(const char* name, const String& defValue) {
 void JSON::AddArrayElement(JSON* item) {
   if (item) {
     Children.PushBack(item);
+    if (pIndex)
+      pIndex->Append(item);
   }
 }
 
@@ -1076,6 +1291,8 @@ void JSON::InsertArrayElement(int index, JSON* item) {
     return;
   }
 
+  invalidateIndex();
+
   if (index == 0) {
     Children.PushFront(item);
     return;
@@ -1139,13 +1356,16 @@ JSON* JSON::Copy() {
 }
 
 char* JSON::PrintValue(bool fmt) {
-  return PrintValue(0, fmt);
+  JSONWriter writer;
+  if (!writeValue(writer, 0, fmt))
+    return 0;
+  return writer.DetachText();
 }
 
 //-----------------------------------------------------------------------------
 // Loads and parses the given JSON file pathname and returns a JSON object tree.
 // The returned object must be Released after use.
-JSON* JSON::Load(const char* path, const char** perror) {
+JSON* JSON::Load(const char* path, const char** perror, JSONParseMode mode) {
   SysFile f;
   if (!f.Open(path, File::Open_Read, File::Mode_Read)) {
     AssignError(perror, "Failed to open file");
@@ -1165,7 +1385,7 @@ JSON* JSON::Load(const char* path, const char** perror) {
   // Ensure the result is null-terminated since Parse() expects null-terminated input.
   buff[len] = '\0';
 
-  JSON* json = JSON::Parse((char*)buff, perror);
+  JSON* json = JSON::Parse((char*)buff, perror, mode);
   OVR_FREE(buff);
   return json;
 }
@@ -1177,24 +1397,24 @@ bool JSON::Save(const char* path) {
   if (!f.Open(path, File::Open_Write | File::Open_Create | File::Open_Truncate, File::Mode_Write))
     return false;
 
-  char* text = PrintValue(0, true);
-  if (text) {
-    intptr_t len = OVR_strlen(text);
-    OVR_ASSERT(len <= (intptr_t)(int)len);
+  const bool result = Save(&f, true);
+  f.Close();
+  return result;
+}
 
-    int bytes = f.Write((uint8_t*)text, (int)len);
-    f.Close();
-    OVR_FREE(text);
-    return (bytes == len);
-  } else {
-    return false;
-  }
+bool JSON::Save(File* file, bool fmt) {
+  JSONWriter writer(file);
+  return writeValue(writer, 0, fmt) && writer.Finish();
 }
 
 //-----------------------------------------------------------------------------
 // Serializes the JSON object to a String
 String JSON::Stringify(bool fmt) {
-  char* text = PrintValue(0, fmt);
+  JSONWriter writer;
+  if (!writeValue(writer, 0, fmt))
+    return String();
+
+  char* text = writer.DetachText();
   String copy(text);
   OVR_FREE(text);
   return copy;
@@ -47,12 +47,36 @@ enum JSONItemType {
   JSON_Object = 6
 };
 
+// JSONParseMode selects how Parse, ParseBuffer and Load allocate the nodes of the new tree.
+enum JSONParseMode {
+  // Each node is allocated and reference counted individually, so a node can be kept after
+  // its root has been released, or moved to another tree.
+  JSON_ParseNodes = 0,
+
+  // All parsed nodes are placed in one arena which the root owns, and are freed together when
+  // the root is released. The tree is read and modified the same way, but a parsed node must
+  // not be kept (AddRef'd) beyond the lifetime of its root, nor moved into another tree.
+  JSON_ParseArena = 1
+};
+
+class JSONArena;
+class JSONIndex;
+class JSONWriter;
+class File;
+
 //-----------------------------------------------------------------------------
 // ***** JSON
 
 // JSON object represents a JSON node that can be either a root of the JSON tree
 // or a child item. Every node has a type that describes what is is.
 // New JSON trees are typically loaded JSON::Load or created with JSON::Parse.
+// Parsing creates a node per value, so nodes are allocated from an ObjectPool, or from an arena
+// with JSON_ParseArena.
+
+class JSON;
+
+template <>
+struct ObjectPoolTraits<JSON> : public ObjectPoolTraitsEnabled<JSON> {};
 
 class JSON : public RefCountBase<JSON>, public ListNode<JSON> {
  protected:
@@ -85,17 +109,25 @@ class JSON : public RefCountBase<JSON>, public ListNode<JSON> {
 
   // Creates a new JSON object from parsing string.
   // Returns null pointer and fills in *perror in case of parse error.
-  static JSON* Parse(const char* buff, const char** perror = 0);
+  static JSON*
+  Parse(const char* buff, const char** perror = 0, JSONParseMode mode = JSON_ParseNodes);
 
   // This version works for buffers that are not null terminated strings.
-  static JSON* ParseBuffer(const char* buff, int len, const char** perror = 0);
+  static JSON* ParseBuffer(
+      const char* buff,
+      int len,
+      const char** perror = 0,
+      JSONParseMode mode = JSON_ParseNodes);
 
   // Loads and parses a JSON object from a file.
   // Returns 0 and assigns perror with error message on fail.
-  static JSON* Load(const char* path, const char** perror = 0);
+  static JSON*
+  Load(const char* path, const char** perror = 0, JSONParseMode mode = JSON_ParseNodes);
 
-  // Saves a JSON object to a file.
+  // Saves a JSON object to a file. The text is written out in chunks as it's produced, rather
+  // than being built in memory first.
   bool Save(const char* path);
+  bool Save(File* file, bool fmt = true);
 
   // Return the String representation of a JSON object.
   String Stringify(bool fmt);
@@ -114,7 +146,9 @@ class JSON : public RefCountBase<JSON>, public ListNode<JSON> {
     return (!Children.IsEmpty()) ? Children.GetLast() : 0;
   }
 
-  // Counts the number of items in the object; these methods are inefficient.
+  // Objects and arrays with many items are indexed by name and position on the first lookup
+  // which has to walk far, and later lookups take constant time. The index is kept up to date
+  // by the functions below, so the Name of an item must not be changed while it's a child.
   unsigned GetItemCount() const;
   JSON* GetItemByIndex(unsigned i);
   JSON* GetItemByName(const char* name);
@@ -199,7 +233,7 @@ class JSON : public RefCountBase<JSON>, public ListNode<JSON> {
       node->AddArrayNumber((double)array[i]);
   }
 
-  // Accessed array elements; currently inefficient.
+  // Accessed array elements; indexed the same way as GetItemByIndex.
   int GetArraySize();
   double GetArrayNumber(int index);
   const char* GetArrayString(int index);
@@ -212,16 +246,25 @@ class JSON : public RefCountBase<JSON>, public ListNode<JSON> {
  protected:
   JSON(JSONItemType itemType = JSON_Object);
 
-  // JSON Parsing helper functions.
-  const char* parseValue(const char* buff, const char** perror);
+  JSONArena* pArena; // The arena this root's parsed nodes are in, if any.
+  bool InArena; // True if this node is in its root's arena, rather than separately allocated.
+  JSONIndex* pIndex; // Index over the children, if they have been looked up and are many.
+
+  void buildIndex();
+  void invalidateIndex();
+
+  // JSON Parsing helper functions. The arena is null unless parsing with JSON_ParseArena.
+  static JSON* newParsedNode(JSONArena* arena);
+  static void releaseChild(JSON* child);
+  const char* parseValue(const char* buff, const char** perror, JSONArena* arena);
   const char* parseNumber(const char* num);
-  const char* parseArray(const char* value, const char** perror);
-  const char* parseObject(const char* value, const char** perror);
+  const char* parseArray(const char* value, const char** perror, JSONArena* arena);
+  const char* parseObject(const char* value, const char** perror, JSONArena* arena);
   const char* parseString(const char* str, const char** perror);
 
-  char* PrintValue(int depth, bool fmt);
-  char* PrintObject(int depth, bool fmt);
-  char* PrintArray(int depth, bool fmt);
+  bool writeValue(JSONWriter& writer, int depth, bool fmt) const;
+  bool writeObject(JSONWriter& writer, int depth, bool fmt) const;
+  bool writeArray(JSONWriter& writer, int depth, bool fmt) const;
 };
 } // namespace OVR
 
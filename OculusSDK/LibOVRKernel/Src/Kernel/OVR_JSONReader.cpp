@@ -0,0 +1,589 @@
+/************************************************************************************
+
+Filename    :   OVR_JSONReader.cpp
+Content     :   Streaming, event driven JSON reader
+Created     :   October 14, 2026
+Notes       :
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR_JSONReader.h"
+#include "OVR_SysFile.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace OVR {
+
+// Converts the text of a JSON number the same way JSON::parseNumber does, independent of the
+// locale. Returns false if the text isn't a number.
+static bool ParseNumberText(const char* num, double& value) {
+  double n = 0;
+  int scale = 0, subscale = 0, signsubscale = 1;
+  bool positiveSign = true;
+  bool hasDigits = false;
+
+  if (*num == '-') {
+    positiveSign = false;
+    num++;
+  }
+
+  while (*num >= '0' && *num <= '9') {
+    n = (n * 10.0) + (*num++ - '0');
+    hasDigits = true;
+  }
+
+  if (*num == '.' && num[1] >= '0' && num[1] <= '9') {
+    num++;
+    do {
+      n = (n * 10.0) + (*num++ - '0');
+      scale--;
+    } while (*num >= '0' && *num <= '9');
+  }
+
+  if (*num == 'e' || *num == 'E') {
+    num++;
+    if (*num == '+') {
+      num++;
+    } else if (*num == '-') {
+      signsubscale = -1;
+      num++;
+    }
+
+    while (*num >= '0' && *num <= '9')
+      subscale = (subscale * 10) + (*num++ - '0');
+  }
+
+  if (!hasDigits || *num)
+    return false;
+
+  n *= pow(10.0, (scale + subscale * signsubscale));
+  value = positiveSign ? n : -n;
+  return true;
+}
+
+static bool IsNumberChar(int c) {
+  return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+static void AppendUTF8(String* out, unsigned uc) {
+  char utf8[4];
+  int len;
+
+  if (uc < 0x80) {
+    utf8[0] = (char)uc;
+    len = 1;
+  } else if (uc < 0x800) {
+    utf8[0] = (char)(0xC0 | (uc >> 6));
+    utf8[1] = (char)(0x80 | (uc & 0x3F));
+    len = 2;
+  } else if (uc < 0x10000) {
+    utf8[0] = (char)(0xE0 | (uc >> 12));
+    utf8[1] = (char)(0x80 | ((uc >> 6) & 0x3F));
+    utf8[2] = (char)(0x80 | (uc & 0x3F));
+    len = 3;
+  } else {
+    utf8[0] = (char)(0xF0 | (uc >> 18));
+    utf8[1] = (char)(0x80 | ((uc >> 12) & 0x3F));
+    utf8[2] = (char)(0x80 | ((uc >> 6) & 0x3F));
+    utf8[3] = (char)(0x80 | (uc & 0x3F));
+    len = 4;
+  }
+
+  out->append(utf8, len);
+}
+
+//-----------------------------------------------------------------------------
+// ***** JSONReader
+
+JSONReader::JSONReader()
+    : PathFilters(),
+      pFile(nullptr),
+      Handler(nullptr),
+      Error(nullptr),
+      Stopped(false),
+      Line(1),
+      Levels(),
+      Path(),
+      Token(),
+      BufferPos(0),
+      BufferEnd(0) {}
+
+bool JSONReader::AddPathFilter(const char* path) {
+  if (PathFilters.GetSizeI() >= MaxPathFilters)
+    return false;
+
+  PathFilter filter;
+  if (*path) {
+    for (;;) {
+      const char* end = strchr(path, '/');
+      if (!end) {
+        filter.Components.PushBack(String(path));
+        break;
+      }
+      filter.Components.PushBack(String(path, end - path));
+      path = end + 1;
+    }
+  }
+
+  PathFilters.PushBack(filter);
+  return true;
+}
+
+void JSONReader::ClearPathFilters() {
+  PathFilters.Clear();
+}
+
+bool JSONReader::Read(File* file, JSONReaderHandler* handler, const char** perror) {
+  if (!file || !file->IsValid() || !handler) {
+    if (perror)
+      *perror = "Error: Invalid file";
+    return false;
+  }
+
+  pFile = file;
+  Handler = handler;
+  Error = nullptr;
+  Stopped = false;
+  Line = 1;
+  Levels.Clear();
+  Path.clear();
+  BufferPos = 0;
+  BufferEnd = 0;
+
+  const bool result = readDocument();
+
+  // Don't keep unusually large tokens around between reads.
+  if (Token.capacity() > BufferSize)
+    String().swap(Token);
+
+  pFile = nullptr;
+  Handler = nullptr;
+
+  if (!result && perror)
+    *perror = Error;
+  return result;
+}
+
+bool JSONReader::ReadFile(const char* path, JSONReaderHandler* handler, const char** perror) {
+  SysFile f;
+  if (!f.Open(path, File::Open_Read, File::Mode_Read)) {
+    if (perror)
+      *perror = "Failed to open file";
+    return false;
+  }
+
+  return Read(&f, handler, perror);
+}
+
+bool JSONReader::fillBuffer() {
+  if (!pFile)
+    return false;
+
+  const int bytes = pFile->Read(Buffer, BufferSize);
+  if (bytes <= 0) {
+    pFile = nullptr; // End of the input, or a read error.
+    return false;
+  }
+
+  BufferPos = 0;
+  BufferEnd = bytes;
+  return true;
+}
+
+int JSONReader::peekChar() {
+  if ((BufferPos == BufferEnd) && !fillBuffer())
+    return -1;
+  return Buffer[BufferPos];
+}
+
+int JSONReader::getChar() {
+  const int c = peekChar();
+  if (c >= 0) {
+    ++BufferPos;
+    if (c == '\n')
+      ++Line;
+  }
+  return c;
+}
+
+int JSONReader::skipSpace() {
+  int c = peekChar();
+  while (c >= 0 && c <= 32) {
+    getChar();
+    c = peekChar();
+  }
+  return c;
+}
+
+bool JSONReader::fail(const char* error) {
+  Error = error;
+  return false;
+}
+
+void JSONReader::pushComponent(const Level& parent, const char* component, size_t length) {
+  Path.resize(parent.PathLength);
+  if (parent.PathLength > 0)
+    Path += '/';
+  Path.append(component, length);
+}
+
+JSONReader::MatchType
+JSONReader::matchChild(const Level& parent, const char* component, uint32_t& filterMask) const {
+  filterMask = 0;
+  if (parent.Match == Match_Full)
+    return Match_Full;
+
+  // The child's component is at this index in the path filters.
+  const size_t index = Levels.GetSize() - 1;
+  MatchType match = Match_None;
+
+  for (int i = 0; i < PathFilters.GetSizeI(); ++i) {
+    if (!(parent.FilterMask & (1u << i)))
+      continue;
+
+    const Array<String>& components = PathFilters[i].Components;
+    if (components.GetSize() <= index)
+      continue;
+
+    const String& filterComponent = components[index];
+    if (filterComponent != "*" && filterComponent != component)
+      continue;
+
+    if (components.GetSize() == index + 1)
+      return Match_Full;
+
+    filterMask |= (1u << i);
+    match = Match_Prefix;
+  }
+
+  return match;
+}
+
+bool JSONReader::readDocument() {
+  MatchType match = PathFilters.IsEmpty() ? Match_Full : Match_Prefix;
+  uint32_t filterMask = 0;
+
+  for (int i = 0; i < PathFilters.GetSizeI(); ++i) {
+    if (PathFilters[i].Components.IsEmpty())
+      match = Match_Full;
+    filterMask |= (1u << i);
+  }
+
+  if (skipSpace() < 0)
+    return fail("Syntax Error: Empty input");
+
+  if (!readValue(match, filterMask))
+    return false;
+
+  while (!Levels.IsEmpty() && !Stopped) {
+    const Level& level = Levels.Back();
+    const char close = level.IsObject ? '}' : ']';
+    int c = skipSpace();
+
+    if (c == close) {
+      if (!endContainer())
+        return false;
+      continue;
+    }
+
+    if (level.Count > 0) {
+      if (c != ',')
+        return fail(
+            level.IsObject ? "Syntax Error: Missing ',' or '}'"
+                           : "Syntax Error: Missing ',' or ']'");
+      getChar();
+      c = skipSpace();
+    }
+
+    Levels.Back().Count++;
+
+    if (level.IsObject) {
+      if (c != '\"')
+        return fail("Syntax Error: Missing name");
+      if (!readString(&Token))
+        return false;
+
+      pushComponent(level, Token.c_str(), Token.size());
+      match = matchChild(level, Token.c_str(), filterMask);
+
+      if ((level.Match == Match_Full) && !Handler->OnKey(*this, Token.c_str(), Token.size())) {
+        Stopped = true;
+        break;
+      }
+
+      if (skipSpace() != ':')
+        return fail("Syntax Error: Missing ':'");
+      getChar();
+    } else {
+      char index[16];
+      const int length = snprintf(index, sizeof(index), "%d", level.Count - 1);
+      pushComponent(level, index, length);
+      match = matchChild(level, index, filterMask);
+    }
+
+    if (skipSpace() < 0)
+      return fail("Syntax Error: Unexpected end of input");
+
+    if (!readValue(match, filterMask))
+      return false;
+  }
+
+  return true;
+}
+
+bool JSONReader::readValue(MatchType match, uint32_t filterMask) {
+  const int c = peekChar();
+
+  if (c == '{' || c == '[') {
+    if (match == Match_None)
+      return skipValue();
+
+    getChar();
+
+    if (match == Match_Full) {
+      const bool result = (c == '{') ? Handler->OnStartObject(*this) : Handler->OnStartArray(*this);
+      if (!result) {
+        Stopped = true;
+        return true;
+      }
+    }
+
+    Level level;
+    level.IsObject = (c == '{');
+    level.Match = (uint8_t)match;
+    level.FilterMask = filterMask;
+    level.Count = 0;
+    level.PathLength = (int)Path.size();
+    Levels.PushBack(level);
+    return true;
+  }
+
+  // Only containers can have something of interest inside them.
+  if (match != Match_Full)
+    return skipValue();
+
+  bool result;
+
+  if (c == '\"') {
+    if (!readString(&Token))
+      return false;
+    result = Handler->OnString(*this, Token.c_str(), Token.size());
+  } else if (c == '-' || (c >= '0' && c <= '9')) {
+    double value;
+    if (!readNumber() || !ParseNumberText(Token.c_str(), value))
+      return fail("Syntax Error: Invalid number");
+    result = Handler->OnNumber(*this, value, Token.c_str(), Token.size());
+  } else if (c == 't') {
+    if (!readLiteral("true"))
+      return false;
+    result = Handler->OnBool(*this, true);
+  } else if (c == 'f') {
+    if (!readLiteral("false"))
+      return false;
+    result = Handler->OnBool(*this, false);
+  } else if (c == 'n') {
+    if (!readLiteral("null"))
+      return false;
+    result = Handler->OnNull(*this);
+  } else {
+    return fail("Syntax Error: Invalid syntax");
+  }
+
+  if (!result)
+    Stopped = true;
+  return true;
+}
+
+bool JSONReader::endContainer() {
+  const Level level = Levels.Back();
+  getChar();
+  Levels.PopBack();
+  Path.resize(level.PathLength);
+
+  if (level.Match == Match_Full) {
+    const bool result = level.IsObject ? Handler->OnEndObject(*this) : Handler->OnEndArray(*this);
+    if (!result)
+      Stopped = true;
+  }
+
+  return true;
+}
+
+bool JSONReader::readString(String* out) {
+  getChar(); // The opening quote.
+  if (out)
+    out->clear();
+
+  for (;;) {
+    int c = getChar();
+
+    if (c == '\"')
+      return true;
+    if (c < 0)
+      return fail("Syntax Error: Missing closing quote");
+
+    if (c != '\\') {
+      if (out)
+        *out += (char)c;
+      continue;
+    }
+
+    c = getChar();
+    if (!out) {
+      if (c < 0)
+        return fail("Syntax Error: Missing closing quote");
+      continue;
+    }
+
+    switch (c) {
+      case 'b':
+        *out += '\b';
+        break;
+      case 'f':
+        *out += '\f';
+        break;
+      case 'n':
+        *out += '\n';
+        break;
+      case 'r':
+        *out += '\r';
+        break;
+      case 't':
+        *out += '\t';
+        break;
+
+      case 'u': {
+        unsigned uc = 0;
+        for (int i = 0; i < 4; ++i) {
+          c = getChar();
+          if (c >= '0' && c <= '9')
+            uc = uc * 16 + (c - '0');
+          else if (c >= 'a' && c <= 'f')
+            uc = uc * 16 + (10 + c - 'a');
+          else if (c >= 'A' && c <= 'F')
+            uc = uc * 16 + (10 + c - 'A');
+          else
+            return fail("Syntax Error: Invalid unicode escape");
+        }
+
+        // A UTF16 surrogate pair is two escapes; drop any unpaired half.
+        if (uc >= 0xDC00 && uc <= 0xDFFF)
+          break;
+
+        if (uc >= 0xD800 && uc <= 0xDBFF) {
+          if (peekChar() != '\\')
+            break;
+          getChar();
+          if (getChar() != 'u')
+            return fail("Syntax Error: Invalid unicode escape");
+
+          unsigned uc2 = 0;
+          for (int i = 0; i < 4; ++i) {
+            c = getChar();
+            if (c >= '0' && c <= '9')
+              uc2 = uc2 * 16 + (c - '0');
+            else if (c >= 'a' && c <= 'f')
+              uc2 = uc2 * 16 + (10 + c - 'a');
+            else if (c >= 'A' && c <= 'F')
+              uc2 = uc2 * 16 + (10 + c - 'A');
+            else
+              return fail("Syntax Error: Invalid unicode escape");
+          }
+
+          if (uc2 < 0xDC00 || uc2 > 0xDFFF)
+            break;
+
+          uc = 0x10000 + (((uc & 0x3FF) << 10) | (uc2 & 0x3FF));
+        }
+
+        if (uc != 0)
+          AppendUTF8(out, uc);
+        break;
+      }
+
+      default:
+        if (c < 0)
+          return fail("Syntax Error: Missing closing quote");
+        *out += (char)c;
+        break;
+    }
+  }
+}
+
+bool JSONReader::readNumber() {
+  Token.clear();
+  while (IsNumberChar(peekChar()))
+    Token += (char)getChar();
+  return !Token.empty();
+}
+
+bool JSONReader::readLiteral(const char* literal) {
+  for (; *literal; ++literal) {
+    if (getChar() != *literal)
+      return fail("Syntax Error: Invalid syntax");
+  }
+  return true;
+}
+
+bool JSONReader::skipValue() {
+  int c = peekChar();
+
+  if (c == '\"')
+    return readString(nullptr);
+
+  if (c != '{' && c != '[') {
+    // A number or literal, which ends at the next separator.
+    bool empty = true;
+    while (c >= 0 && c > 32 && c != ',' && c != '}' && c != ']') {
+      getChar();
+      c = peekChar();
+      empty = false;
+    }
+    return empty ? fail("Syntax Error: Invalid syntax") : true;
+  }
+
+  int depth = 0;
+
+  for (;;) {
+    c = peekChar();
+
+    if (c < 0)
+      return fail("Syntax Error: Unexpected end of input");
+
+    if (c == '\"') {
+      if (!readString(nullptr))
+        return false;
+      continue;
+    }
+
+    getChar();
+
+    if (c == '{' || c == '[') {
+      ++depth;
+    } else if (c == '}' || c == ']') {
+      if (--depth == 0)
+        return true;
+    }
+  }
+}
+
+} // namespace OVR
@@ -0,0 +1,212 @@
+/************************************************************************************
+
+Filename    :   OVR_JSONReader.h
+Content     :   Streaming, event driven JSON reader
+Created     :   October 14, 2026
+Notes       :
+    JSONReader reads JSON text from a File in fixed-size chunks and reports what it finds to a
+    JSONReaderHandler as it goes, without building a tree. Memory use is bounded by the nesting
+    depth and the longest string or number read, not by the size of the file.
+
+    With path filters only the values at the given paths (and everything inside them) are
+    reported, and all other values are skipped without being decoded.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_JSONReader_h
+#define OVR_JSONReader_h
+
+#include "OVR_Types.h"
+#include "OVR_Array.h"
+#include "OVR_File.h"
+#include "OVR_String.h"
+
+namespace OVR {
+
+class JSONReader;
+
+//-----------------------------------------------------------------------------
+// ***** JSONReaderHandler
+//
+// Receives the events of a JSONReader. Each returns true to continue reading, or false to
+// stop, for example once everything of interest has been read. Strings are passed as UTF-8,
+// unescaped and null terminated, and are only valid for the duration of the call.
+//
+class JSONReaderHandler {
+ public:
+  virtual ~JSONReaderHandler() {}
+
+  virtual bool OnStartObject(const JSONReader& reader) {
+    OVR_UNUSED(reader);
+    return true;
+  }
+  virtual bool OnEndObject(const JSONReader& reader) {
+    OVR_UNUSED(reader);
+    return true;
+  }
+  virtual bool OnStartArray(const JSONReader& reader) {
+    OVR_UNUSED(reader);
+    return true;
+  }
+  virtual bool OnEndArray(const JSONReader& reader) {
+    OVR_UNUSED(reader);
+    return true;
+  }
+
+  // Called for each member of a reported object, before the member's value.
+  virtual bool OnKey(const JSONReader& reader, const char* key, size_t length) {
+    OVR_UNUSED3(reader, key, length);
+    return true;
+  }
+
+  virtual bool OnString(const JSONReader& reader, const char* str, size_t length) {
+    OVR_UNUSED3(reader, str, length);
+    return true;
+  }
+
+  // text is the number as it appears in the input.
+  virtual bool OnNumber(const JSONReader& reader, double value, const char* text, size_t length) {
+    OVR_UNUSED4(reader, value, text, length);
+    return true;
+  }
+
+  virtual bool OnBool(const JSONReader& reader, bool value) {
+    OVR_UNUSED2(reader, value);
+    return true;
+  }
+
+  virtual bool OnNull(const JSONReader& reader) {
+    OVR_UNUSED(reader);
+    return true;
+  }
+};
+
+//-----------------------------------------------------------------------------
+// ***** JSONReader
+//
+// A path names a value by the keys and array indices leading to it from the root, separated by
+// '/', for example "frames/12/gpuTime"; the root itself is "". A path filter has the same form,
+// and may use "*" for any single key or index. Without path filters every value is reported.
+//
+// Values which are skipped are only checked for balanced brackets and quotes, so a document
+// which is malformed only inside them is read without error.
+//
+// For example, to sum the GPU time of every frame in a large dump:
+//
+//     struct GpuTimeSum : public JSONReaderHandler {
+//       virtual bool OnNumber(const JSONReader&, double value, const char*, size_t) override {
+//         Sum += value;
+//         return true;
+//       }
+//       double Sum = 0;
+//     };
+//
+//     JSONReader reader;
+//     reader.AddPathFilter("frames/*/gpuTime");
+//     GpuTimeSum gpuTimeSum;
+//     reader.ReadFile("PerfDump.json", &gpuTimeSum);
+//
+class JSONReader {
+  OVR_NON_COPYABLE(JSONReader)
+
+ public:
+  // At most this many path filters may be added at once.
+  static const int MaxPathFilters = 32;
+
+  JSONReader();
+
+  bool AddPathFilter(const char* path);
+  void ClearPathFilters();
+
+  // Reads a single JSON value (usually an object) from the current position of the file.
+  // Returns false and assigns perror on a syntax or read error. Being stopped by the handler
+  // is not an error.
+  bool Read(File* file, JSONReaderHandler* handler, const char** perror = 0);
+  bool ReadFile(const char* path, JSONReaderHandler* handler, const char** perror = 0);
+
+  // The path of the value being reported. For OnKey this is the path of the member.
+  const String& GetPath() const {
+    return Path;
+  }
+
+  // Nesting depth of the value being reported, which is 0 for the root.
+  int GetDepth() const {
+    return (int)Levels.GetSize();
+  }
+
+  // Line of the input the reader is at, counting from 1.
+  int GetLine() const {
+    return Line;
+  }
+
+ protected:
+  enum MatchType { Match_None, Match_Prefix, Match_Full };
+
+  // An object or array being read.
+  struct Level {
+    bool IsObject;
+    uint8_t Match; // MatchType of the container itself
+    uint32_t FilterMask; // Path filters which match the path of the container so far
+    int Count; // Members or elements read so far
+    int PathLength; // Length of the container's path
+  };
+
+  struct PathFilter {
+    Array<String> Components;
+  };
+
+  int peekChar();
+  int getChar();
+  int skipSpace();
+  bool fillBuffer();
+
+  bool fail(const char* error);
+  void pushComponent(const Level& parent, const char* component, size_t length);
+  MatchType matchChild(const Level& parent, const char* component, uint32_t& filterMask) const;
+
+  bool readDocument();
+  bool readValue(MatchType match, uint32_t filterMask);
+  bool readString(String* out);
+  bool readNumber();
+  bool readLiteral(const char* literal);
+  bool skipValue();
+  bool endContainer();
+
+  Array<PathFilter> PathFilters;
+
+  File* pFile;
+  JSONReaderHandler* Handler;
+  const char* Error;
+  bool Stopped;
+  int Line;
+
+  ArrayPOD<Level> Levels;
+  String Path;
+  String Token; // The string, key or number being read.
+
+  static const int BufferSize = 16384;
+  int BufferPos;
+  int BufferEnd;
+  uint8_t Buffer[BufferSize];
+};
+
+} // namespace OVR
+
+#endif // OVR_JSONReader_h
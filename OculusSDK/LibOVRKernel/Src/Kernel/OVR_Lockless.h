@@ -97,6 +97,172 @@ class LocklessUpdater {
   SlotType Slots[2];
 };
 
+// ***** LocklessHistory
+
+// For single producer cases where consumers want more than the most recent update: the
+// producer appends timestamped entries to a ring of N slots, and consumers can fetch the latest
+// entry, an older one, or the state interpolated at a given time (pose prediction, perf stat
+// sampling).
+//
+// Each slot is a seqlock: its sequence is odd while the producer writes index i into it and
+// 2 * i + 2 once the write is complete, so a reader can tell both a torn copy and a slot which
+// has since been reused for a newer index. The producer never waits; a reader only retries if
+// the producer laps the whole ring while it copies an entry out, so asking for the latest entry
+// does not contend with the write in progress the way LocklessUpdater's two slots do.
+//
+// This is multiple consumer safe. Times are expected to be non-decreasing.
+//
+// As with LocklessUpdater, SlotType can be a larger fixed size type than T when the history is
+// shared between processes.
+
+// Default interpolation for LocklessHistory::GetStateAt, for the OVR math types (Vector3,
+// Quat, Pose...) which provide Lerp.
+template <class T>
+struct LocklessHistoryLerp {
+  T operator()(const T& a, const T& b, double f) const {
+    return a.Lerp(b, f);
+  }
+};
+
+template <class T, unsigned N, class SlotType = T>
+class LocklessHistory {
+ public:
+  LocklessHistory() {
+    OVR_COMPILER_ASSERT(sizeof(T) <= sizeof(SlotType));
+    // Indices wrap at 2^32, which only maps consistently onto slots for a power of two.
+    static_assert((N >= 2) && ((N & (N - 1)) == 0), "N must be a power of two");
+  }
+
+  // Producer only.
+  void SetState(const T& state, double time) {
+    const uint32_t index = WriteCount.load(std::memory_order_relaxed);
+    Entry& entry = Entries[index % N];
+
+    entry.Sequence.store((index * 2) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    entry.Time = time;
+    entry.Value = state;
+    entry.Sequence.store((index * 2) + 2, std::memory_order_release);
+
+    WriteCount.store(index + 1, std::memory_order_release);
+  }
+
+  // Returns the number of entries which can currently be read, at most N.
+  unsigned GetCount() const {
+    const uint32_t count = WriteCount.load(std::memory_order_acquire);
+    return (count < N) ? count : N;
+  }
+
+  // Copies out the entry written age updates ago, where age 0 is the latest. Returns false if
+  // there is no such entry.
+  bool GetEntry(unsigned age, T& state, double* time = nullptr) const {
+    for (;;) {
+      const uint32_t count = WriteCount.load(std::memory_order_acquire);
+      if ((age >= N) || (age >= count))
+        return false;
+
+      double entryTime;
+      if (ReadEntry(count - 1 - age, state, entryTime)) {
+        if (time)
+          *time = entryTime;
+        return true;
+      }
+
+      // The producer reused the slot while we were copying it out; look again from the
+      // new latest entry.
+    }
+  }
+
+  bool GetLatest(T& state, double* time = nullptr) const {
+    return GetEntry(0, state, time);
+  }
+
+  // Copies out the latest entry whose time is at or before the given time, or the oldest entry
+  // still held if they are all newer. Returns false if the history is empty.
+  bool GetStateBefore(double time, T& state, double* entryTime = nullptr) const {
+    T after;
+    double beforeTime, afterTime;
+    if (!FindBracket(time, state, beforeTime, after, afterTime))
+      return false;
+    if (entryTime)
+      *entryTime = beforeTime;
+    return true;
+  }
+
+  // Returns the state at the given time, interpolated between the entries either side of it.
+  // Times outside of the history clamp to the oldest or latest entry. Returns false if the
+  // history is empty.
+  template <class Lerp = LocklessHistoryLerp<T>>
+  bool GetStateAt(double time, T& state, Lerp lerp = Lerp()) const {
+    T after;
+    double beforeTime, afterTime;
+    if (!FindBracket(time, state, beforeTime, after, afterTime))
+      return false;
+
+    if ((afterTime > beforeTime) && (time > beforeTime)) {
+      const double f = (time - beforeTime) / (afterTime - beforeTime);
+      state = lerp(state, after, (f < 1.0) ? f : 1.0);
+    }
+    return true;
+  }
+
+ private:
+  struct Entry {
+    std::atomic<uint32_t> Sequence = {0};
+    double Time = 0;
+    SlotType Value;
+  };
+
+  bool ReadEntry(uint32_t index, T& state, double& time) const {
+    const Entry& entry = Entries[index % N];
+    const uint32_t sequence = (index * 2) + 2;
+
+    if (entry.Sequence.load(std::memory_order_acquire) != sequence)
+      return false;
+
+    time = entry.Time;
+    state = entry.Value;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return entry.Sequence.load(std::memory_order_relaxed) == sequence;
+  }
+
+  // Walks back from the latest entry to find the entries before and after time. When time is
+  // outside of the history both are the nearest end entry.
+  bool FindBracket(double time, T& before, double& beforeTime, T& after, double& afterTime)
+      const {
+    for (;;) {
+      const uint32_t count = WriteCount.load(std::memory_order_acquire);
+      if (count == 0)
+        return false;
+
+      const uint32_t available = (count < N) ? count : N;
+      bool valid = ReadEntry(count - 1, after, afterTime);
+      before = after;
+      beforeTime = afterTime;
+
+      for (uint32_t age = 1; valid && (age < available) && (beforeTime > time); ++age) {
+        after = before;
+        afterTime = beforeTime;
+        valid = ReadEntry(count - 1 - age, before, beforeTime);
+      }
+
+      if (valid) {
+        if (beforeTime > time) { // Older than the whole history.
+          after = before;
+          afterTime = beforeTime;
+        }
+        return true;
+      }
+
+      // Lapped by the producer while walking back; start again from the new latest entry.
+    }
+  }
+
+  std::atomic<uint32_t> WriteCount = {0};
+  Entry Entries[N];
+};
+
 #pragma pack(push, 8)
 
 // Padded out version stored in the updater slots
@@ -197,6 +363,106 @@ class LocklessBuffer {
 
 #pragma pack(pop)
 
+// ***** LocklessTripleBuffer
+
+// Wait-free alternative to LocklessBuffer for large payloads (camera frames) with a single
+// writer and a single reader, typically living in shared memory.
+//
+// The data area holds three slots of slotSize bytes. At any time the writer owns one slot, the
+// reader owns one, and the third holds the latest completed write. EndWrite swaps the writer's
+// slot with the latest one and AcquireLatest swaps the reader's slot with it, so the writer
+// always has a free slot to fill, the reader keeps its slot for as long as it reads from it,
+// and neither ever has to wait for or retry a copy against the other.
+//
+// The object must be placed in a block of GetRequiredSize(slotSize) bytes and then initialized.
+
+#pragma pack(push, 1)
+
+class LocklessTripleBuffer {
+ public:
+  LocklessTripleBuffer() {
+    ;
+  }
+
+  static size_t GetRequiredSize(unsigned slotSize) {
+    return offsetof(LocklessTripleBuffer, Data) + (size_t(slotSize) * SlotCount);
+  }
+
+  void Initialize(unsigned slotSize) {
+    SlotSize = slotSize;
+    WriteSlot = 0;
+    ReadSlot = 2;
+    ReadGeneration = 0;
+    for (int i = 0; i < SlotCount; ++i)
+      SlotGeneration[i] = 0;
+    LastWrittenGeneration = 0;
+    Latest = 1;
+  }
+
+  unsigned GetSlotSize() const {
+    return SlotSize;
+  }
+
+  // Writer: the returned slot is not visible to the reader until EndWrite.
+  char* GetDataForWrite(unsigned offset = 0) {
+    return &(Data[(size_t(WriteSlot) * SlotSize) + offset]);
+  }
+
+  // Writer: publishes the slot just written as the latest one, takes over the slot it replaces,
+  // and returns the generation of the published write.
+  int EndWrite() {
+    const int generation = ++LastWrittenGeneration;
+    SlotGeneration[WriteSlot] = generation;
+    const uint32_t previous = Latest.exchange(WriteSlot | NewDataFlag, std::memory_order_acq_rel);
+    WriteSlot = previous & SlotMask;
+    return generation;
+  }
+
+  int GetLastWrittenGeneration() const {
+    return LastWrittenGeneration;
+  }
+
+  bool HasNewData() const {
+    return (Latest.load(std::memory_order_acquire) & NewDataFlag) != 0;
+  }
+
+  // Reader: takes ownership of the latest completed slot if there has been a write since the
+  // last call, and returns the generation of the slot now held, 0 if nothing has been written.
+  int AcquireLatest() {
+    if (HasNewData()) {
+      const uint32_t previous = Latest.exchange(ReadSlot, std::memory_order_acq_rel);
+      ReadSlot = previous & SlotMask;
+      ReadGeneration = SlotGeneration[ReadSlot];
+    }
+    return ReadGeneration;
+  }
+
+  // Reader: the slot held since the last AcquireLatest, which the writer won't touch.
+  const char* GetDataForRead(unsigned offset = 0) const {
+    return &(Data[(size_t(ReadSlot) * SlotSize) + offset]);
+  }
+
+ private:
+  enum { SlotCount = 3, SlotMask = 3, NewDataFlag = 4 };
+
+  unsigned SlotSize = 0;
+
+  // Index of the slot holding the latest completed write, with NewDataFlag set until the
+  // reader takes it.
+  std::atomic<uint32_t> Latest;
+  std::atomic<int> LastWrittenGeneration;
+
+  uint32_t WriteSlot = 0; // Writer only.
+  uint32_t ReadSlot = 2; // Reader only.
+  int ReadGeneration = 0; // Reader only.
+  int SlotGeneration[SlotCount]; // Written by the owner of each slot.
+
+  // Data starts here...
+  char Data[1];
+};
+
+#pragma pack(pop)
+
 } // namespace OVR
 
 #endif // OVR_Lockless_h
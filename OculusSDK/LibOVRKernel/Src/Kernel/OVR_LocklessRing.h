@@ -0,0 +1,441 @@
+/************************************************************************************
+
+Filename    :   OVR_LocklessRing.h
+Content     :   Bounded lock-free ring queues for passing items between threads
+Created     :   October 14, 2026
+Notes       :
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef OVR_LocklessRing_h
+#define OVR_LocklessRing_h
+
+#include "OVR_Types.h"
+#include "OVR_Alg.h"
+#include "OVR_Atomic.h"
+#include "OVR_ContainerAllocator.h"
+#include "OVR_Threads.h"
+
+// 'new' operator is redefined/used in this file.
+#undef new
+
+namespace OVR {
+
+// Rings pad their producer and consumer state to this, so that a producer and a consumer on
+// different cores don't contend for the same cache line.
+static const size_t LocklessRingCacheLineSize = 64;
+
+//-----------------------------------------------------------------------------------
+// ***** SPSCRing
+//
+// Bounded FIFO queue for exactly one producer thread and one consumer thread. Neither side
+// ever blocks or takes a lock: TryPush fails if the ring is full and TryPop fails if it's
+// empty. The capacity is rounded up to a power of two.
+//
+// Head is written only by the consumer and Tail only by the producer. Each side keeps a cached
+// copy of the other side's index and reloads it only when the cached value says the ring is
+// full or empty, so in steady state neither side reads the other's cache line.
+//
+// Like CircularBuffer, elements are copy-constructed in and destructed upon pop, via
+// Allocator's Construct and Destruct.
+//
+// Example usage:
+//    SPSCRing<LogEntry> Ring(1024);
+//
+//    // Producer thread:
+//    if (!Ring.TryPush(entry))
+//      ... // Full; drop the entry or retry later.
+//
+//    // Consumer thread:
+//    LogEntry entry;
+//    while (Ring.TryPop(entry))
+//      Write(entry);
+//
+template <class T, class Allocator = ContainerAllocator<T>>
+class SPSCRing {
+ public:
+  typedef T ValueType;
+
+  explicit SPSCRing(size_t capacity)
+      : Head(0), CachedTail(0), Tail(0), CachedHead(0), Mask(RoundCapacity(capacity) - 1) {
+    Data = (T*)Allocator::Alloc((Mask + 1) * sizeof(T));
+    OVR_ASSERT(Data);
+  }
+
+  ~SPSCRing() {
+    const size_t tail = Tail.load(std::memory_order_relaxed);
+    for (size_t i = Head.load(std::memory_order_relaxed); i != tail; ++i)
+      Allocator::Destruct(&Data[i & Mask]);
+    Allocator::Free(Data);
+  }
+
+  // Producer only. Returns false if the ring is full.
+  bool TryPush(const T& item) {
+    const size_t tail = Tail.load(std::memory_order_relaxed);
+
+    if ((tail - CachedHead) > Mask) { // If it looks full...
+      CachedHead = Head.load(std::memory_order_acquire);
+      if ((tail - CachedHead) > Mask)
+        return false;
+    }
+
+    Allocator::Construct(&Data[tail & Mask], item);
+    Tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer only. Returns false if the ring is empty, in which case item is unchanged.
+  bool TryPop(T& item) {
+    const size_t head = Head.load(std::memory_order_relaxed);
+
+    if (head == CachedTail) { // If it looks empty...
+      CachedTail = Tail.load(std::memory_order_acquire);
+      if (head == CachedTail)
+        return false;
+    }
+
+    T* slot = &Data[head & Mask];
+    item = *slot;
+    Allocator::Destruct(slot);
+    Head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // These are exact only when called by the producer or consumer while the other side is idle.
+  size_t GetSize() const {
+    return Tail.load(std::memory_order_acquire) - Head.load(std::memory_order_acquire);
+  }
+  bool IsEmpty() const {
+    return (GetSize() == 0);
+  }
+  bool IsFull() const {
+    return (GetSize() > Mask);
+  }
+
+  size_t GetCapacity() const {
+    return Mask + 1;
+  }
+
+ protected:
+  static size_t RoundCapacity(size_t capacity) {
+    if (capacity < 2)
+      return 2;
+    return size_t(1) << (Alg::UpperBit(capacity - 1) + 1);
+  }
+
+  // Consumer state.
+  std::atomic<size_t> Head; // Index of the next element to pop.
+  size_t CachedTail; // The consumer's most recent read of Tail.
+  char ConsumerPadding[LocklessRingCacheLineSize];
+
+  // Producer state.
+  std::atomic<size_t> Tail; // Index of the next element to push.
+  size_t CachedHead; // The producer's most recent read of Head.
+  char ProducerPadding[LocklessRingCacheLineSize];
+
+  // Shared, read-only state.
+  const size_t Mask;
+  T* Data;
+
+  OVR_NON_COPYABLE(SPSCRing)
+};
+
+//-----------------------------------------------------------------------------------
+// ***** MPMCRing
+//
+// Bounded FIFO queue for any number of producer and consumer threads. TryPush and TryPop
+// never block or take a lock. The capacity is rounded up to a power of two.
+//
+// Each slot has a sequence number which says whether the slot is ready to be filled or ready to
+// be consumed for the current lap around the ring. Producers claim slots by advancing
+// EnqueuePos with a compare-exchange and consumers by advancing DequeuePos, so producers and
+// consumers only contend among themselves, and a slot's sequence number hands the element over
+// from its producer to its consumer with release/acquire ordering.
+//
+template <class T, class Allocator = ContainerAllocator<T>>
+class MPMCRing {
+ public:
+  typedef T ValueType;
+
+  explicit MPMCRing(size_t capacity)
+      : EnqueuePos(0), DequeuePos(0), Mask(RoundCapacity(capacity) - 1) {
+    Slots = (Slot*)Allocator::Alloc((Mask + 1) * sizeof(Slot));
+    OVR_ASSERT(Slots);
+
+    for (size_t i = 0; i <= Mask; ++i)
+      new (&Slots[i].Sequence) std::atomic<size_t>(i);
+  }
+
+  ~MPMCRing() {
+    const size_t enqueuePos = EnqueuePos.load(std::memory_order_relaxed);
+    for (size_t pos = DequeuePos.load(std::memory_order_relaxed); pos != enqueuePos; ++pos)
+      Allocator::Destruct(Slots[pos & Mask].GetValue());
+    Allocator::Free(Slots); // std::atomic<size_t> has a trivial destructor.
+  }
+
+  // Returns false if the ring is full.
+  bool TryPush(const T& item) {
+    size_t pos = EnqueuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    for (;;) {
+      slot = &Slots[pos & Mask];
+      const size_t sequence = slot->Sequence.load(std::memory_order_acquire);
+      const intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+
+      if (diff == 0) { // If the slot is free for this lap...
+        if (EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+        // Else pos was updated to the current value; retry with it.
+      } else if (diff < 0) // The slot still holds the element from the previous lap.
+        return false;
+      else // Another producer claimed this slot first.
+        pos = EnqueuePos.load(std::memory_order_relaxed);
+    }
+
+    Allocator::Construct(slot->GetValue(), item);
+    slot->Sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Returns false if the ring is empty, in which case item is unchanged.
+  bool TryPop(T& item) {
+    size_t pos = DequeuePos.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    for (;;) {
+      slot = &Slots[pos & Mask];
+      const size_t sequence = slot->Sequence.load(std::memory_order_acquire);
+      const intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+
+      if (diff == 0) { // If the slot was filled for this lap...
+        if (DequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) // The slot hasn't been filled yet.
+        return false;
+      else // Another consumer took this slot first.
+        pos = DequeuePos.load(std::memory_order_relaxed);
+    }
+
+    T* value = slot->GetValue();
+    item = *value;
+    Allocator::Destruct(value);
+    slot->Sequence.store(pos + Mask + 1, std::memory_order_release); // Free for the next lap.
+    return true;
+  }
+
+  // Approximate, as other threads may be pushing or popping concurrently.
+  size_t GetSize() const {
+    const size_t dequeuePos = DequeuePos.load(std::memory_order_acquire);
+    const size_t enqueuePos = EnqueuePos.load(std::memory_order_acquire);
+    return (enqueuePos > dequeuePos) ? (enqueuePos - dequeuePos) : 0;
+  }
+  bool IsEmpty() const {
+    return (GetSize() == 0);
+  }
+  bool IsFull() const {
+    return (GetSize() > Mask);
+  }
+
+  size_t GetCapacity() const {
+    return Mask + 1;
+  }
+
+ protected:
+  struct Slot {
+    std::atomic<size_t> Sequence;
+    typename std::aligned_storage<sizeof(T), OVR_ALIGNOF(T)>::type Value;
+
+    T* GetValue() {
+      return reinterpret_cast<T*>(&Value);
+    }
+  };
+
+  static size_t RoundCapacity(size_t capacity) {
+    if (capacity < 2)
+      return 2;
+    return size_t(1) << (Alg::UpperBit(capacity - 1) + 1);
+  }
+
+  std::atomic<size_t> EnqueuePos; // Written by producers.
+  char ProducerPadding[LocklessRingCacheLineSize];
+  std::atomic<size_t> DequeuePos; // Written by consumers.
+  char ConsumerPadding[LocklessRingCacheLineSize];
+  const size_t Mask;
+  Slot* Slots;
+
+  OVR_NON_COPYABLE(MPMCRing)
+};
+
+#ifdef OVR_ENABLE_THREADS
+
+//-----------------------------------------------------------------------------------
+// ***** BlockingRing
+//
+// Adds blocking Push and Pop to an SPSCRing or MPMCRing, with the same producer and consumer
+// thread rules as the underlying ring. Push waits while the ring is full and Pop waits while
+// it's empty, via OVR::Event.
+//
+// The fast paths don't touch the events: a push or pop signals the other side's event only if
+// a thread of that side is waiting, as counted by the waiter counts. A waiter registers itself
+// before re-checking the ring, so a push or pop which happens in between sees the registration
+// and signals.
+//
+// Example usage:
+//    BlockingRing<MPMCRing<FrameSubmission>> Submissions(8);
+//
+//    // Any app thread:
+//    Submissions.Push(submission);
+//
+//    // Compositor thread:
+//    FrameSubmission submission;
+//    if (Submissions.Pop(submission, 100)) // Wait up to 100ms.
+//      ...
+//
+template <class Ring>
+class BlockingRing {
+ public:
+  typedef typename Ring::ValueType ValueType;
+
+  explicit BlockingRing(size_t capacity)
+      : Queue(capacity), PushWaiters(0), PopWaiters(0), NotEmpty(), NotFull() {}
+
+  bool TryPush(const ValueType& item) {
+    if (!Queue.TryPush(item))
+      return false;
+    Signal(PopWaiters, NotEmpty);
+    return true;
+  }
+
+  bool TryPop(ValueType& item) {
+    if (!Queue.TryPop(item))
+      return false;
+    Signal(PushWaiters, NotFull);
+    return true;
+  }
+
+  // Waits up to delay milliseconds for room. Returns false upon timeout.
+  bool Push(const ValueType& item, unsigned delay = OVR_WAIT_INFINITE) {
+    if (TryPush(item))
+      return true;
+
+    bool result = false;
+    PushWaiters.fetch_add(1, std::memory_order_seq_cst);
+
+    for (;;) {
+      NotFull.ResetEvent();
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      if (Queue.TryPush(item)) {
+        result = true;
+        break;
+      }
+
+      if (!NotFull.Wait(delay)) { // If timed out...
+        result = Queue.TryPush(item);
+        break;
+      }
+    }
+
+    PushWaiters.fetch_sub(1, std::memory_order_seq_cst);
+
+    if (result) {
+      Signal(PopWaiters, NotEmpty);
+      if (!Queue.IsFull()) // Pass the wakeup on, in case several pops happened at once.
+        Signal(PushWaiters, NotFull);
+    }
+
+    return result;
+  }
+
+  // Waits up to delay milliseconds for an item. Returns false upon timeout.
+  bool Pop(ValueType& item, unsigned delay = OVR_WAIT_INFINITE) {
+    if (TryPop(item))
+      return true;
+
+    bool result = false;
+    PopWaiters.fetch_add(1, std::memory_order_seq_cst);
+
+    for (;;) {
+      NotEmpty.ResetEvent();
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      if (Queue.TryPop(item)) {
+        result = true;
+        break;
+      }
+
+      if (!NotEmpty.Wait(delay)) { // If timed out...
+        result = Queue.TryPop(item);
+        break;
+      }
+    }
+
+    PopWaiters.fetch_sub(1, std::memory_order_seq_cst);
+
+    if (result) {
+      Signal(PushWaiters, NotFull);
+      if (!Queue.IsEmpty()) // Pass the wakeup on, in case several pushes happened at once.
+        Signal(PopWaiters, NotEmpty);
+    }
+
+    return result;
+  }
+
+  Ring& GetRing() {
+    return Queue;
+  }
+
+  size_t GetSize() const {
+    return Queue.GetSize();
+  }
+  bool IsEmpty() const {
+    return Queue.IsEmpty();
+  }
+  size_t GetCapacity() const {
+    return Queue.GetCapacity();
+  }
+
+ protected:
+  static void Signal(std::atomic<int>& waiters, Event& event) {
+    // Orders our ring update before the waiter count read, pairing with the fence in Push/Pop.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) > 0)
+      event.SetEvent();
+  }
+
+  Ring Queue;
+  std::atomic<int> PushWaiters; // Threads blocked in Push.
+  std::atomic<int> PopWaiters; // Threads blocked in Pop.
+  Event NotEmpty;
+  Event NotFull;
+
+  OVR_NON_COPYABLE(BlockingRing)
+};
+
+#endif // OVR_ENABLE_THREADS
+
+} // namespace OVR
+
+#ifdef OVR_DEFINE_NEW
+#define new OVR_DEFINE_NEW
+#endif
+
+#endif // OVR_LocklessRing_h
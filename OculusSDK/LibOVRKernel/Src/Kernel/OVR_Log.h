@@ -161,14 +161,29 @@ inline void LogDebug(Args&&... args) {
 //
 intptr_t AssertHandlerDiskFile(intptr_t userParameter, const char* title, const char* message);
 
+// The arguments are only evaluated if debug messages are enabled, and the calls compile to
+// nothing if ovrlog's LOGGING_MIN_LEVEL is above Debug.
+#if LOGGING_MIN_LEVEL <= 2 // ovrlog::Level::Debug
+#define OVR_DEBUG_LOG(args)                                     \
+  do {                                                          \
+    if (OVR::DefaultChannel.Active(ovrlog::Level::Debug)) {     \
+      OVR::LogDebug args;                                       \
+    }                                                           \
+  } while (0);
+#define OVR_DEBUG_LOG_TEXT(args)                                \
+  do {                                                          \
+    if (OVR::DefaultChannel.Active(ovrlog::Level::Debug)) {     \
+      OVR::LogDebug args;                                       \
+    }                                                           \
+  } while (0);
+#else
 #define OVR_DEBUG_LOG(args) \
   do {                      \
-    OVR::LogDebug args;     \
   } while (0);
 #define OVR_DEBUG_LOG_TEXT(args) \
   do {                           \
-    OVR::LogDebug args;          \
   } while (0);
+#endif
 #define OVR_ERROR_LOG(args) \
   do {                      \
     OVR::LogError args;     \
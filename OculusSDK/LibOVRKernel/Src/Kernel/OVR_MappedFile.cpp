@@ -0,0 +1,247 @@
+/************************************************************************************
+
+Filename    :   OVR_MappedFile.cpp
+Content     :   Read-only memory mapped file
+Created     :   October 14, 2026
+Notes       :
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR_File.h"
+#include "OVR_UTF8Util.h"
+
+#if defined(OVR_OS_MS)
+#include "OVR_Win32_IncludeWindows.h"
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <limits.h>
+#include <string.h>
+
+namespace OVR {
+
+#if defined(OVR_OS_MS)
+static int MappedFileError(DWORD error) {
+  if (error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND)
+    return FileConstants::Error_FileNotFound;
+  else if (error == ERROR_ACCESS_DENIED || error == ERROR_SHARING_VIOLATION)
+    return FileConstants::Error_Access;
+  else
+    return FileConstants::Error_IOError;
+}
+#else
+static int MappedFileError(int error) {
+  if (error == ENOENT)
+    return FileConstants::Error_FileNotFound;
+  else if (error == EACCES || error == EPERM)
+    return FileConstants::Error_Access;
+  else
+    return FileConstants::Error_IOError;
+}
+#endif
+
+//-----------------------------------------------------------------------------------
+// ***** MappedFile
+
+MappedFile::MappedFile()
+    : FilePath(), pData(nullptr), FileSize(0), FileIndex(0), ErrorCode(0), Valid(false) {}
+
+MappedFile::MappedFile(const char* pfileName)
+    : FilePath(), pData(nullptr), FileSize(0), FileIndex(0), ErrorCode(0), Valid(false) {
+  Open(pfileName);
+}
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+bool MappedFile::Open(const char* pfileName) {
+  Close();
+
+  FilePath = pfileName ? pfileName : "";
+  ErrorCode = 0;
+
+  if (!pfileName || !*pfileName) {
+    ErrorCode = Error_FileNotFound;
+    return false;
+  }
+
+#if defined(OVR_OS_MS)
+  const size_t fileNameLength = (size_t)UTF8Util::GetLength(pfileName) + 1;
+  wchar_t* pwFileName = (wchar_t*)OVR_ALLOC(fileNameLength * sizeof(pwFileName[0]));
+  if (!pwFileName) {
+    ErrorCode = Error_IOError;
+    return false;
+  }
+  UTF8Util::Strlcpy(pwFileName, fileNameLength, pfileName);
+
+  HANDLE hFile = ::CreateFileW(
+      pwFileName,
+      GENERIC_READ,
+      FILE_SHARE_READ,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL,
+      nullptr);
+  OVR_FREE(pwFileName);
+
+  if (hFile == INVALID_HANDLE_VALUE) {
+    ErrorCode = MappedFileError(::GetLastError());
+    return false;
+  }
+
+  LARGE_INTEGER size;
+  if (!::GetFileSizeEx(hFile, &size) || ((uint64_t)size.QuadPart > (uint64_t)SIZE_MAX)) {
+    ErrorCode = Error_IOError;
+    ::CloseHandle(hFile);
+    return false;
+  }
+
+  // An empty file can't be mapped, and has nothing to read anyway.
+  if (size.QuadPart > 0) {
+    HANDLE hMapping = ::CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (hMapping) {
+      pData = (const uint8_t*)::MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+      if (!pData)
+        ErrorCode = MappedFileError(::GetLastError());
+
+      // The view keeps the mapping and file open until it's unmapped.
+      ::CloseHandle(hMapping);
+    } else {
+      ErrorCode = MappedFileError(::GetLastError());
+    }
+  }
+
+  ::CloseHandle(hFile);
+  FileSize = size.QuadPart;
+#else
+  const int fd = ::open(pfileName, O_RDONLY);
+  if (fd < 0) {
+    ErrorCode = MappedFileError(errno);
+    return false;
+  }
+
+  struct stat fileStat;
+  if ((fstat(fd, &fileStat) != 0) || ((uint64_t)fileStat.st_size > (uint64_t)SIZE_MAX)) {
+    ErrorCode = Error_IOError;
+    ::close(fd);
+    return false;
+  }
+
+  // An empty file can't be mapped, and has nothing to read anyway.
+  if (fileStat.st_size > 0) {
+    void* data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED)
+      pData = (const uint8_t*)data;
+    else
+      ErrorCode = MappedFileError(errno);
+  }
+
+  // The mapping keeps the file open until it's unmapped.
+  ::close(fd);
+  FileSize = fileStat.st_size;
+#endif
+
+  if (ErrorCode) {
+    FileSize = 0;
+    return false;
+  }
+
+  FileIndex = 0;
+  Valid = true;
+  return true;
+}
+
+bool MappedFile::Close() {
+  if (pData) {
+#if defined(OVR_OS_MS)
+    ::UnmapViewOfFile(pData);
+#else
+    munmap(const_cast<uint8_t*>(pData), (size_t)FileSize);
+#endif
+    pData = nullptr;
+  }
+
+  const bool wasValid = Valid;
+  FileSize = 0;
+  FileIndex = 0;
+  Valid = false;
+  return wasValid;
+}
+
+int MappedFile::Read(uint8_t* pbuffer, int numBytes) {
+  if (!Valid)
+    return -1;
+
+  numBytes = SkipBytes(numBytes);
+  if (numBytes > 0)
+    memcpy(pbuffer, pData + FileIndex - numBytes, numBytes);
+
+  return numBytes;
+}
+
+int MappedFile::SkipBytes(int numBytes) {
+  if (!Valid)
+    return -1;
+
+  if (numBytes > BytesAvailable())
+    numBytes = BytesAvailable();
+
+  if (numBytes > 0)
+    FileIndex += numBytes;
+
+  return numBytes;
+}
+
+int MappedFile::BytesAvailable() {
+  const int64_t available = FileSize - FileIndex;
+  return (available > INT_MAX) ? INT_MAX : (int)available;
+}
+
+int64_t MappedFile::LSeek(int64_t offset, int origin) {
+  if (!Valid)
+    return -1;
+
+  switch (origin) {
+    case Seek_Set:
+      break;
+    case Seek_Cur:
+      offset += FileIndex;
+      break;
+    case Seek_End:
+      offset += FileSize;
+      break;
+    default:
+      return -1;
+  }
+
+  if (offset < 0 || offset > FileSize)
+    return -1;
+
+  FileIndex = offset;
+  return FileIndex;
+}
+
+} // namespace OVR
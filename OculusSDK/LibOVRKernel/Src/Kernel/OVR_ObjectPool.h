@@ -0,0 +1,357 @@
+/************************************************************************************
+
+PublicHeader:   Kernel
+Filename    :   OVR_ObjectPool.h
+Content     :   Fixed-size object pool, usable by RefCountBase-derived types
+Created     :   October 14, 2026
+Notes       :
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_ObjectPool_h
+#define OVR_ObjectPool_h
+
+#include "OVR_Types.h"
+#include "OVR_Allocator.h"
+#include "OVR_Atomic.h"
+
+// Undef new temporarily if it is being redefined
+#ifdef OVR_DEFINE_NEW
+#undef new
+#endif
+
+namespace OVR {
+
+//-----------------------------------------------------------------------------------
+// ***** ObjectPoolTraits
+//
+// Specialize this for a class to have its RefCountBase new/delete operators use ObjectPool<C>,
+// so that Release() returns the memory to the pool. The specialization must precede any code
+// which creates or destroys C objects, including C's own inline functions, so it's best to put it
+// right before C's definition.
+//
+// Example usage:
+//    class Widget;
+//
+//    template <>
+//    struct ObjectPoolTraits<Widget> : public ObjectPoolTraitsEnabled<Widget> {};
+//
+//    class Widget : public RefCountBase<Widget> { ... };
+//
+// Subclasses of C are pooled too, as long as they are no larger than C. If C is usually
+// instantiated via a larger subclass, pass that subclass as LargestType. It may be incomplete
+// at this point.
+//
+template <class C>
+struct ObjectPoolTraits {
+  static const bool Enabled = false;
+};
+
+template <class C, class LargestType = C>
+struct ObjectPoolTraitsEnabled {
+  static const bool Enabled = true;
+  typedef LargestType BlockType; // The pool's blocks are sizeof(BlockType).
+  static const size_t BlocksPerSlab = 128; // Blocks carved from each slab allocation.
+  static const bool ThreadCacheEnabled = true; // If true then each thread keeps a few free blocks.
+};
+
+//-----------------------------------------------------------------------------------
+// ***** ObjectPool
+//
+// A slab allocator for objects of up to a single size. Blocks are carved out of slabs of
+// BlocksPerSlab blocks which are allocated from the default Allocator, so that objects of a type
+// are densely packed and allocation and free are O(1). Free blocks are kept on an intrusive free
+// list. If ThreadCacheEnabled, each thread additionally keeps up to MaxCachedBlocks free blocks
+// of its own which are allocated and freed without taking the pool lock.
+//
+// Slabs are never returned to the Allocator, as pooled object types are expected to be churned
+// continuously. The pool itself is never destroyed, so that objects freed during static
+// destruction are still valid to free.
+//
+// Use via ObjectPoolTraits, or directly:
+//    void* p = ObjectPool<Widget>::GetInstance()->Alloc();
+//    Widget* w = new (p) Widget;
+//    ...
+//    w->~Widget();
+//    ObjectPool<Widget>::GetInstance()->Free(w);
+//
+template <class C, class Traits = ObjectPoolTraits<C>>
+class ObjectPool {
+ public:
+  static const size_t BlockAlignment = 16;
+  static const size_t BlockSize =
+      (sizeof(typename Traits::BlockType) + (BlockAlignment - 1)) & ~(BlockAlignment - 1);
+  static const size_t SlabSize = BlockSize * Traits::BlocksPerSlab;
+  static const uint32_t MaxCachedBlocks = 32; // Per thread, before returning half to the pool.
+
+  static ObjectPool* GetInstance() {
+    // Constructed upon first use and intentionally never destructed. See above.
+    static ObjectPool* instance = new (SysMemAlloc(sizeof(ObjectPool))) ObjectPool;
+    return instance;
+  }
+
+  // Returns a block of BlockSize bytes, or nullptr upon failure.
+  void* Alloc() {
+    if (Traits::ThreadCacheEnabled) {
+      ThreadCache& cache = GetThreadCache();
+
+      if (!cache.FreeList)
+        cache.Refill(this);
+
+      if (cache.FreeList) {
+        FreeBlock* block = cache.FreeList;
+        cache.FreeList = block->Next;
+        cache.Count--;
+        return block;
+      }
+
+      return nullptr;
+    }
+
+    Lock::Locker locker(&PoolLock);
+    return PopBlock();
+  }
+
+  // Returns a block which was returned by Alloc.
+  void Free(void* p) {
+    if (!p)
+      return;
+
+    FreeBlock* block = static_cast<FreeBlock*>(p);
+
+    if (Traits::ThreadCacheEnabled) {
+      ThreadCache& cache = GetThreadCache();
+
+      block->Next = cache.FreeList;
+      cache.FreeList = block;
+
+      if (++cache.Count > MaxCachedBlocks)
+        cache.Flush(this, MaxCachedBlocks / 2);
+      return;
+    }
+
+    Lock::Locker locker(&PoolLock);
+    block->Next = FreeList;
+    FreeList = block;
+  }
+
+  // Returns true if p is within one of our slabs. This is slow, as it visits every slab.
+  bool Owns(const void* p) {
+    Lock::Locker locker(&PoolLock);
+
+    for (Slab* slab = SlabList; slab; slab = slab->Next) {
+      const uint8_t* blocks = slab->GetBlocks();
+      if ((p >= blocks) && (p < (blocks + SlabSize)))
+        return true;
+    }
+
+    return false;
+  }
+
+  // Returns the number of slabs allocated so far.
+  size_t GetSlabCount() const {
+    return SlabCount;
+  }
+
+ protected:
+  struct FreeBlock {
+    FreeBlock* Next;
+  };
+
+  struct Slab {
+    Slab* Next;
+
+    uint8_t* GetBlocks() {
+      return reinterpret_cast<uint8_t*>(this) + BlockAlignment;
+    }
+  };
+
+  struct ThreadCache {
+    FreeBlock* FreeList;
+    uint32_t Count;
+
+    ThreadCache() : FreeList(nullptr), Count(0) {}
+
+    ~ThreadCache() { // Return our blocks to the pool when our thread exits.
+      Flush(ObjectPool::GetInstance(), Count);
+    }
+
+    void Refill(ObjectPool* pool) {
+      Lock::Locker locker(&pool->PoolLock);
+
+      for (uint32_t i = 0; i < (MaxCachedBlocks / 2); ++i) {
+        FreeBlock* block = pool->PopBlock();
+        if (!block)
+          break;
+        block->Next = FreeList;
+        FreeList = block;
+        Count++;
+      }
+    }
+
+    void Flush(ObjectPool* pool, uint32_t count) {
+      Lock::Locker locker(&pool->PoolLock);
+
+      while (FreeList && count--) {
+        FreeBlock* block = FreeList;
+        FreeList = block->Next;
+        Count--;
+        block->Next = pool->FreeList;
+        pool->FreeList = block;
+      }
+    }
+  };
+
+  ObjectPool()
+      : PoolLock(),
+        FreeList(nullptr),
+        SlabList(nullptr),
+        Carve(nullptr),
+        CarveEnd(nullptr),
+        SlabCount(0) {}
+
+  static ThreadCache& GetThreadCache() {
+    static thread_local ThreadCache cache;
+    return cache;
+  }
+
+  // PoolLock must be held.
+  FreeBlock* PopBlock() {
+    if (FreeList) {
+      FreeBlock* block = FreeList;
+      FreeList = block->Next;
+      return block;
+    }
+
+    if (Carve == CarveEnd) // If the current slab is used up...
+    {
+      Slab* slab = static_cast<Slab*>(OVR::Allocator::GetInstance()->AllocAligned(
+          BlockAlignment + SlabSize, BlockAlignment, "ObjectPool"));
+      if (!slab)
+        return nullptr;
+
+      slab->Next = SlabList;
+      SlabList = slab;
+      SlabCount++;
+      Carve = slab->GetBlocks();
+      CarveEnd = Carve + SlabSize;
+    }
+
+    FreeBlock* block = reinterpret_cast<FreeBlock*>(Carve);
+    Carve += BlockSize;
+    return block;
+  }
+
+  OVR::Lock PoolLock; // Protects everything below.
+  FreeBlock* FreeList; // Blocks freed back to the pool.
+  Slab* SlabList; // All slabs, for Owns.
+  uint8_t* Carve; // Next never-used block within the newest slab.
+  uint8_t* CarveEnd;
+  size_t SlabCount;
+};
+
+//-----------------------------------------------------------------------------------
+// ***** ObjectPoolNew
+//
+// Implements the RefCountBase new and delete operators for class C. They use ObjectPool<C> if
+// ObjectPoolTraits<C> is enabled and the requested size fits, and the default Allocator
+// otherwise, which is the same as OVR_MEMORY_REDEFINE_NEW does.
+//
+template <class C, class Traits = ObjectPoolTraits<C>, bool enabled = Traits::Enabled>
+struct ObjectPoolNew {
+  static void* Alloc(size_t sz, const char* file, int line) {
+    OVR_UNUSED2(file, line);
+    void* p = OVR_ALLOC_DEBUG(sz, file, line);
+    if (!p)
+      throw OVR::bad_alloc();
+    return p;
+  }
+
+  static void Free(void* p, size_t /*sz*/) {
+    OVR_FREE(p);
+  }
+
+  static void FreeUnsized(void* p) {
+    OVR_FREE(p);
+  }
+};
+
+template <class C, class Traits>
+struct ObjectPoolNew<C, Traits, true> {
+  typedef ObjectPool<C, Traits> Pool;
+
+  static void* Alloc(size_t sz, const char* file, int line) {
+    OVR_UNUSED2(file, line);
+    void* p = (sz <= Pool::BlockSize) ? Pool::GetInstance()->Alloc()
+                                      : OVR_ALLOC_DEBUG(sz, file, line);
+    if (!p)
+      throw OVR::bad_alloc();
+    return p;
+  }
+
+  static void Free(void* p, size_t sz) {
+    if (sz <= Pool::BlockSize)
+      Pool::GetInstance()->Free(p);
+    else
+      OVR_FREE(p);
+  }
+
+  // Used only when a constructor throws, so it's OK that this is slow.
+  static void FreeUnsized(void* p) {
+    if (Pool::GetInstance()->Owns(p))
+      Pool::GetInstance()->Free(p);
+    else
+      OVR_FREE(p);
+  }
+};
+
+// Redefines all delete/new operators in a RefCountBase-style class template, for its CRTP
+// parameter class_name. The sized form of delete is used so that the size of the object's
+// dynamic type is available, which requires class_name to have a virtual destructor.
+#define OVR_OBJECT_POOL_REDEFINE_NEW_IMPL(class_name, check_delete)         \
+  void* operator new(size_t sz) {                                           \
+    return OVR::ObjectPoolNew<class_name>::Alloc(sz, __FILE__, __LINE__);   \
+  }                                                                         \
+                                                                            \
+  void* operator new(size_t sz, const char* file, int line) {               \
+    return OVR::ObjectPoolNew<class_name>::Alloc(sz, file, line);           \
+  }                                                                         \
+                                                                            \
+  void operator delete(void* p, size_t sz) {                                \
+    if (p) {                                                                \
+      check_delete(class_name, p);                                          \
+      OVR::ObjectPoolNew<class_name>::Free(p, sz);                          \
+    }                                                                       \
+  }                                                                         \
+                                                                            \
+  void operator delete(void* p, const char*, int) {                         \
+    if (p) {                                                                \
+      check_delete(class_name, p);                                          \
+      OVR::ObjectPoolNew<class_name>::FreeUnsized(p);                       \
+    }                                                                       \
+  }
+
+} // namespace OVR
+
+#ifdef OVR_DEFINE_NEW
+#define new OVR_DEFINE_NEW
+#endif
+
+#endif // OVR_ObjectPool_h
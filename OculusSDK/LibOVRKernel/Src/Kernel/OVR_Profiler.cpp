@@ -0,0 +1,450 @@
+/************************************************************************************
+
+Filename    :   OVR_Profiler.cpp
+Content     :   In-process scope profiler with Chrome trace export
+Created     :   October 14, 2026
+Notes       :
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR_Profiler.h"
+#include "OVR_Alg.h"
+#include "OVR_String.h"
+#include "OVR_SysFile.h"
+
+#if defined(OVR_OS_MS)
+#include "OVR_Win32_IncludeWindows.h"
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include <memory>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace OVR {
+
+std::atomic<bool> ScopeProfiler::Running(false);
+
+namespace {
+
+enum ProfileEventKind { Kind_Scope, Kind_Frame, Kind_Counter, Kind_Instant };
+
+struct ProfileEvent {
+  const char* Name; // Null for frames
+  uint64_t BeginTicks; // Timer::GetTicksRaw
+  uint64_t EndTicks; // The same as BeginTicks for counters and instants
+  double Value; // A counter's value, or the frame index of a frame or instant, -1 if none
+  uint32_t Kind; // ProfileEventKind
+};
+
+// Text recorded by RecordMarker, which is copied, unlike event names.
+struct ProfileMarker {
+  uint64_t Ticks;
+  uint32_t TraceThreadId;
+  String Text;
+};
+
+} // namespace
+
+// The events of one thread, or of a track made with CreateTrack. Only the owning thread writes
+// Events and WriteCount; exporting reads them concurrently, and discards any event the owner may
+// have overwritten meanwhile.
+struct ProfileTrack {
+  ProfileTrack(unsigned capacity, uint32_t traceThreadId)
+      : Events(new ProfileEvent[capacity]),
+        Mask(capacity - 1),
+        WriteCount(0),
+        TraceThreadId(traceThreadId),
+        Name() {}
+
+  std::unique_ptr<ProfileEvent[]> Events;
+  uint64_t Mask;
+  std::atomic<uint64_t> WriteCount;
+  uint32_t TraceThreadId; // Small id used as the tid in the trace
+  String Name; // Guarded by ProfileRegistry::Lock
+};
+
+namespace {
+
+// All the rings ever created. Rings of threads which have exited are kept, so their events
+// can still be exported.
+struct ProfileRegistry {
+  std::mutex Lock;
+  std::vector<std::unique_ptr<ProfileTrack>> Rings;
+  unsigned EventsPerThread = ScopeProfiler::DefaultEventsPerThread;
+  uint64_t OriginTicks = 0; // Time of the first Start, which becomes 0 in the trace
+  std::vector<ProfileMarker> Markers; // A ring of up to MaxMarkers
+  uint64_t MarkerCount = 0;
+};
+
+ProfileRegistry& GetRegistry() {
+  // Never destroyed, as threads may still be recording while the process exits.
+  static ProfileRegistry* registry = new ProfileRegistry;
+  return *registry;
+}
+
+thread_local ProfileTrack* CurrentRing = nullptr;
+
+uint64_t GetOSThreadId() {
+#if defined(OVR_OS_MS)
+  return ::GetCurrentThreadId();
+#else
+  return (uint64_t)(uintptr_t)pthread_self();
+#endif
+}
+
+uint32_t GetOSProcessId() {
+#if defined(OVR_OS_MS)
+  return ::GetCurrentProcessId();
+#else
+  return (uint32_t)getpid();
+#endif
+}
+
+// Must be called with the registry locked.
+ProfileTrack* AddRing(ProfileRegistry& registry, const char* name) {
+  unsigned capacity = 1;
+  while (capacity < registry.EventsPerThread)
+    capacity <<= 1;
+
+  ProfileTrack* ring = new ProfileTrack(capacity, (uint32_t)registry.Rings.size() + 1);
+  ring->Name = name;
+  registry.Rings.emplace_back(ring);
+  return ring;
+}
+
+ProfileTrack* CreateCurrentRing() {
+  ProfileRegistry& registry = GetRegistry();
+  std::lock_guard<std::mutex> locker(registry.Lock);
+
+  char name[32];
+  snprintf(name, sizeof(name), "Thread %llu", (unsigned long long)GetOSThreadId());
+  CurrentRing = AddRing(registry, name);
+  return CurrentRing;
+}
+
+void RecordToRing(
+    ProfileTrack* ring,
+    const char* name,
+    uint64_t beginTicks,
+    uint64_t endTicks,
+    double value = -1,
+    uint32_t kind = Kind_Scope) {
+  const uint64_t index = ring->WriteCount.load(std::memory_order_relaxed);
+  ProfileEvent& event = ring->Events[index & ring->Mask];
+  event.Name = name;
+  event.BeginTicks = beginTicks;
+  event.EndTicks = endTicks;
+  event.Value = value;
+  event.Kind = kind;
+  ring->WriteCount.store(index + 1, std::memory_order_release);
+}
+
+double TicksToTraceMicros(uint64_t ticks) {
+  return (double)Timer::RawTicksToNanosDuration(ticks) / 1000.0;
+}
+
+// Appends str to out as the contents of a JSON string.
+void AppendJSONString(String& out, const char* str) {
+  for (; *str; ++str) {
+    const unsigned char c = (unsigned char)*str;
+    if ((c == '"') || (c == '\\')) {
+      out.AppendChar('\\');
+      out.AppendChar(c);
+    } else if (c < 0x20) {
+      char escape[8];
+      snprintf(escape, sizeof(escape), "\\u%04x", c);
+      out += escape;
+    } else {
+      out.AppendChar(c);
+    }
+  }
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------------
+// ***** ScopeProfiler
+
+void ScopeProfiler::Start(unsigned eventsPerThread) {
+  ProfileRegistry& registry = GetRegistry();
+  {
+    std::lock_guard<std::mutex> locker(registry.Lock);
+    registry.EventsPerThread = Alg::Max(eventsPerThread, 16u);
+    if (!registry.OriginTicks)
+      registry.OriginTicks = Timer::GetTicksRaw();
+  }
+
+  Running.store(true, std::memory_order_relaxed);
+}
+
+void ScopeProfiler::Stop() {
+  Running.store(false, std::memory_order_relaxed);
+}
+
+void ScopeProfiler::Clear() {
+  ProfileRegistry& registry = GetRegistry();
+  std::lock_guard<std::mutex> locker(registry.Lock);
+
+  // A thread recording at the same time may leave one stale event behind, which only shows up
+  // as an extra scope in the trace.
+  for (size_t i = 0; i < registry.Rings.size(); ++i)
+    registry.Rings[i]->WriteCount.store(0, std::memory_order_relaxed);
+  registry.Markers.clear();
+  registry.MarkerCount = 0;
+  registry.OriginTicks = Running.load(std::memory_order_relaxed) ? Timer::GetTicksRaw() : 0;
+}
+
+void ScopeProfiler::Record(const char* name, uint64_t beginTicks, uint64_t endTicks) {
+  ProfileTrack* ring = CurrentRing;
+  if (!ring)
+    ring = CreateCurrentRing();
+
+  RecordToRing(ring, name, beginTicks, endTicks);
+}
+
+ProfileTrack* ScopeProfiler::CreateTrack(const char* name) {
+  ProfileRegistry& registry = GetRegistry();
+  std::lock_guard<std::mutex> locker(registry.Lock);
+  return AddRing(registry, name);
+}
+
+void ScopeProfiler::RecordTrack(
+    ProfileTrack* track,
+    const char* name,
+    uint64_t beginTicks,
+    uint64_t endTicks) {
+  if (track)
+    RecordToRing(track, name, beginTicks, endTicks);
+}
+
+void ScopeProfiler::RecordFrame(
+    ProfileTrack* track,
+    int64_t frameIndex,
+    uint64_t beginTicks,
+    uint64_t endTicks) {
+  if (track)
+    RecordToRing(track, nullptr, beginTicks, endTicks, (double)frameIndex, Kind_Frame);
+}
+
+void ScopeProfiler::RecordCounter(
+    ProfileTrack* track,
+    const char* name,
+    uint64_t ticks,
+    double value) {
+  if (track)
+    RecordToRing(track, name, ticks, ticks, value, Kind_Counter);
+}
+
+void ScopeProfiler::RecordInstant(
+    ProfileTrack* track,
+    const char* name,
+    uint64_t ticks,
+    int64_t frameIndex) {
+  if (track)
+    RecordToRing(track, name, ticks, ticks, (double)frameIndex, Kind_Instant);
+}
+
+void ScopeProfiler::RecordMarker(const char* text) {
+  if (!IsRunning() || !text)
+    return;
+
+  const uint64_t ticks = Timer::GetTicksRaw();
+  ProfileTrack* ring = CurrentRing;
+  if (!ring)
+    ring = CreateCurrentRing();
+
+  ProfileRegistry& registry = GetRegistry();
+  std::lock_guard<std::mutex> locker(registry.Lock);
+
+  if (registry.Markers.size() < MaxMarkers)
+    registry.Markers.emplace_back();
+  ProfileMarker& marker = registry.Markers[(size_t)(registry.MarkerCount % MaxMarkers)];
+  marker.Ticks = ticks;
+  marker.TraceThreadId = ring->TraceThreadId;
+  size_t length = strlen(text);
+  while ((length > 0) && ((text[length - 1] == '\n') || (text[length - 1] == '\r')))
+    --length; // Log lines usually end with one.
+  marker.Text = String(text, length);
+  ++registry.MarkerCount;
+}
+
+void ScopeProfiler::SetThreadName(const char* name) {
+  ProfileTrack* ring = CurrentRing;
+  if (!ring)
+    ring = CreateCurrentRing();
+
+  std::lock_guard<std::mutex> locker(GetRegistry().Lock);
+  ring->Name = name;
+}
+
+bool ScopeProfiler::WriteChromeTrace(File* file) {
+  if (!file || !file->IsWritable())
+    return false;
+
+  ProfileRegistry& registry = GetRegistry();
+  std::lock_guard<std::mutex> locker(registry.Lock);
+
+  const uint32_t processId = GetOSProcessId();
+  const uint64_t originTicks = registry.OriginTicks;
+  bool ok = true;
+  bool first = true;
+  String text;
+  char number[128];
+
+  text = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+  for (size_t r = 0; ok && (r < registry.Rings.size()); ++r) {
+    ProfileTrack* ring = registry.Rings[r].get();
+
+    text += first ? "\n" : ",\n";
+    first = false;
+    text += "{\"name\":\"thread_name\",\"ph\":\"M\",";
+    snprintf(number, sizeof(number), "\"pid\":%u,\"tid\":%u,", processId, ring->TraceThreadId);
+    text += number;
+    text += "\"args\":{\"name\":\"";
+    AppendJSONString(text, ring->Name.ToCStr());
+    text += "\"}}";
+
+    // Copy out the events the ring still holds, then drop any the owner overwrote while we
+    // copied. Events have no interior pointers, so a torn one is harmless until it's dropped.
+    const uint64_t capacity = ring->Mask + 1;
+    const uint64_t writeCount = ring->WriteCount.load(std::memory_order_acquire);
+    const uint64_t begin = (writeCount > capacity) ? (writeCount - capacity) : 0;
+    std::vector<ProfileEvent> events((size_t)(writeCount - begin));
+    for (uint64_t i = begin; i < writeCount; ++i)
+      events[(size_t)(i - begin)] = ring->Events[i & ring->Mask];
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t laterWriteCount = ring->WriteCount.load(std::memory_order_relaxed);
+    const uint64_t valid =
+        (laterWriteCount > capacity) ? Alg::Max(begin, laterWriteCount - capacity) : begin;
+
+    for (uint64_t i = valid; i < writeCount; ++i) {
+      const ProfileEvent& event = events[(size_t)(i - begin)];
+      if ((!event.Name && (event.Kind != Kind_Frame)) || (event.BeginTicks < originTicks) ||
+          (event.EndTicks < event.BeginTicks))
+        continue;
+
+      // Times are in microseconds, as the format requires. Scopes and frames are complete
+      // ("X") events, counters "C" and instants "i".
+      const double ts = TicksToTraceMicros(event.BeginTicks - originTicks);
+      text += ",\n{\"name\":\"";
+      if (event.Kind == Kind_Frame) {
+        snprintf(number, sizeof(number), "Frame %lld", (long long)event.Value);
+        text += number;
+      } else {
+        AppendJSONString(text, event.Name);
+      }
+
+      if (event.Kind == Kind_Counter) {
+        snprintf(
+            number,
+            sizeof(number),
+            "\",\"ph\":\"C\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%.9g}}",
+            processId,
+            ring->TraceThreadId,
+            ts,
+            event.Value);
+      } else if (event.Kind == Kind_Instant) {
+        snprintf(
+            number,
+            sizeof(number),
+            "\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f",
+            processId,
+            ring->TraceThreadId,
+            ts);
+      } else {
+        snprintf(
+            number,
+            sizeof(number),
+            "\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+            processId,
+            ring->TraceThreadId,
+            ts,
+            TicksToTraceMicros(event.EndTicks - event.BeginTicks));
+      }
+      text += number;
+
+      if ((event.Kind == Kind_Frame) || ((event.Kind == Kind_Instant) && (event.Value >= 0))) {
+        snprintf(number, sizeof(number), ",\"args\":{\"frame\":%lld}}", (long long)event.Value);
+        text += number;
+      } else if (event.Kind != Kind_Counter) {
+        text += "}";
+      }
+
+      if (text.GetSize() >= 60000) {
+        ok = (file->Write((const uint8_t*)text.ToCStr(), (int)text.GetSize()) ==
+              (int)text.GetSize());
+        text.Clear();
+        if (!ok)
+          break;
+      }
+    }
+  }
+
+  // Markers, oldest first.
+  const size_t markerCount = registry.Markers.size();
+  for (size_t m = 0; ok && (m < markerCount); ++m) {
+    const size_t index = (size_t)((registry.MarkerCount - markerCount + m) % MaxMarkers);
+    const ProfileMarker& marker = registry.Markers[index];
+    if (marker.Ticks < originTicks)
+      continue;
+
+    text += first ? "\n" : ",\n";
+    first = false;
+    text += "{\"name\":\"";
+    AppendJSONString(text, marker.Text.ToCStr());
+    snprintf(
+        number,
+        sizeof(number),
+        "\",\"cat\":\"log\",\"ph\":\"i\",\"s\":\"t\",\"pid\":%u,\"tid\":%u,\"ts\":%.3f}",
+        processId,
+        marker.TraceThreadId,
+        TicksToTraceMicros(marker.Ticks - originTicks));
+    text += number;
+
+    if (text.GetSize() >= 60000) {
+      ok = (file->Write((const uint8_t*)text.ToCStr(), (int)text.GetSize()) == (int)text.GetSize());
+      text.Clear();
+    }
+  }
+
+  text += "\n]}\n";
+  if (ok)
+    ok = (file->Write((const uint8_t*)text.ToCStr(), (int)text.GetSize()) == (int)text.GetSize());
+
+  return ok && file->Flush();
+}
+
+bool ScopeProfiler::WriteChromeTrace(const char* path) {
+  SysFile file;
+  if (!file.Open(path, File::Open_Write | File::Open_Create | File::Open_Truncate))
+    return false;
+
+  const bool ok = WriteChromeTrace(&file);
+  return file.Close() && ok;
+}
+
+} // namespace OVR
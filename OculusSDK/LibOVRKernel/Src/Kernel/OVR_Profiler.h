@@ -0,0 +1,175 @@
+/************************************************************************************
+
+Filename    :   OVR_Profiler.h
+Content     :   In-process scope profiler with Chrome trace export
+Created     :   October 14, 2026
+Notes       :
+    OVR_PROFILE_SCOPE("name") times the enclosing scope with Timer::GetTicksRaw while the
+    ScopeProfiler is running, and records it in a ring owned by the calling thread, so recording
+    takes no locks and doesn't contend with other threads. Ticks are converted to time only on
+    export. When stopped, a scope costs one
+    relaxed load. Each thread's ring keeps its most recent events; older ones are overwritten.
+
+    WriteChromeTrace exports what has been recorded as Chrome trace event JSON, which can be
+    opened with chrome://tracing or https://ui.perfetto.dev.
+
+        ScopeProfiler::Start();
+        ...
+        void RenderFrame() {
+          OVR_PROFILE_SCOPE("RenderFrame");
+          ...
+        }
+        ...
+        ScopeProfiler::Stop();
+        ScopeProfiler::WriteChromeTrace("Frames.json");
+
+    Besides scopes a trace can hold frames, counters and instant events on tracks, and log
+    markers, so that CPU scopes, GPU passes, per-frame stats and log messages share one timeline,
+    with frames and instants carrying the frame index they belong to.
+
+    Unlike the ETW events in Tracing.h nothing needs to be installed, and no privileges are
+    needed. Define OVR_DISABLE_PROFILER to compile the scopes out entirely.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_Profiler_h
+#define OVR_Profiler_h
+
+#include "OVR_Types.h"
+#include "OVR_Atomic.h"
+#include "OVR_File.h"
+#include "OVR_Timer.h"
+
+namespace OVR {
+
+struct ProfileTrack;
+
+//-----------------------------------------------------------------------------------
+// ***** ScopeProfiler
+//
+// Names passed to Record (and so to OVR_PROFILE_SCOPE) are kept by pointer, and must outlive
+// the recording; string literals are the usual choice.
+//
+class ScopeProfiler {
+ public:
+  static const unsigned DefaultEventsPerThread = 16384;
+  static const unsigned MaxMarkers = 4096;
+
+  // Starts recording. eventsPerThread is the ring size for threads which record their first
+  // event after this call; it is rounded up to a power of two.
+  static void Start(unsigned eventsPerThread = DefaultEventsPerThread);
+
+  // Stops recording. Scopes which were entered while running are still recorded when they end.
+  static void Stop();
+
+  static bool IsRunning() {
+    return Running.load(std::memory_order_relaxed);
+  }
+
+  // Discards everything recorded so far.
+  static void Clear();
+
+  // Records a completed scope for the calling thread, with times from Timer::GetTicksRaw.
+  static void Record(const char* name, uint64_t beginTicks, uint64_t endTicks);
+
+  // Names the calling thread in the exported trace. The name is copied.
+  static void SetThreadName(const char* name);
+
+  // Creates a track, which appears in the trace like a thread, for events which don't belong to
+  // the thread recording them, such as GPU work. Tracks are never destroyed. The name is copied.
+  static ProfileTrack* CreateTrack(const char* name);
+
+  // Records a completed event on a track. Only one thread at a time may record to a track.
+  static void RecordTrack(
+      ProfileTrack* track,
+      const char* name,
+      uint64_t beginTicks,
+      uint64_t endTicks);
+
+  // Records a frame on a track: a complete event named for the frame, with frameIndex in its
+  // args, so a frame found in other stats can be found in the trace.
+  static void RecordFrame(
+      ProfileTrack* track,
+      int64_t frameIndex,
+      uint64_t beginTicks,
+      uint64_t endTicks);
+
+  // Records the value of a counter at a time, on a track. Values with the same name are shown
+  // as one graph.
+  static void
+  RecordCounter(ProfileTrack* track, const char* name, uint64_t ticks, double value);
+
+  // Records an instant event on a track, with the frame it belongs to unless frameIndex is
+  // negative.
+  static void
+  RecordInstant(ProfileTrack* track, const char* name, uint64_t ticks, int64_t frameIndex = -1);
+
+  // Records text, such as a log message, as an instant event on the calling thread at the
+  // current time. Does nothing while stopped. The text is copied under a lock, so this is for
+  // occasional markers rather than per-frame events; the most recent MaxMarkers are kept.
+  static void RecordMarker(const char* text);
+
+  // Writes the events recorded so far, which may be done while running. Returns false if the
+  // file couldn't be written.
+  static bool WriteChromeTrace(File* file);
+  static bool WriteChromeTrace(const char* path);
+
+ protected:
+  static std::atomic<bool> Running;
+};
+
+//-----------------------------------------------------------------------------------
+// ***** ProfileScope
+//
+// Records the time between its construction and destruction, if the profiler was running when
+// it was constructed. Normally used through OVR_PROFILE_SCOPE.
+//
+class ProfileScope {
+  OVR_NON_COPYABLE(ProfileScope)
+
+ public:
+  explicit ProfileScope(const char* name)
+      : Name(name), BeginTicks(ScopeProfiler::IsRunning() ? Timer::GetTicksRaw() : 0) {}
+
+  ~ProfileScope() {
+    // Timer ticks are never 0, so 0 marks a scope entered while stopped.
+    if (BeginTicks)
+      ScopeProfiler::Record(Name, BeginTicks, Timer::GetTicksRaw());
+  }
+
+ protected:
+  const char* Name;
+  uint64_t BeginTicks;
+};
+
+} // namespace OVR
+
+#if !defined(OVR_DISABLE_PROFILER)
+#define OVR_PROFILE_SCOPE_CAT_(a, b) a##b
+#define OVR_PROFILE_SCOPE_CAT(a, b) OVR_PROFILE_SCOPE_CAT_(a, b)
+#define OVR_PROFILE_SCOPE(name) \
+  OVR::ProfileScope OVR_PROFILE_SCOPE_CAT(ovrProfileScope_, __LINE__)(name)
+#define OVR_PROFILE_FUNCTION() OVR_PROFILE_SCOPE(__FUNCTION__)
+#else
+#define OVR_PROFILE_SCOPE(name) ((void)0)
+#define OVR_PROFILE_FUNCTION() ((void)0)
+#endif
+
+#endif // OVR_Profiler_h
@@ -27,6 +27,24 @@ limitations under the License.
 #include "OVR_Rand.h"
 #include "OVR_Timer.h"
 
+#include <string.h>
+
+#if defined(OVR_CPU_X86) || defined(OVR_CPU_X86_64)
+#if defined(OVR_CC_MSVC)
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#define OVR_RAND_X86 1
+
+// MSVC allows intrinsics for any instruction set in any function; GCC and Clang need the
+// function to be marked for it.
+#if defined(OVR_CC_MSVC)
+#define OVR_RAND_TARGET(isa)
+#else
+#define OVR_RAND_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
 namespace OVR {
 
 void RandomNumberGenerator::SeedRandom() {
@@ -72,4 +90,240 @@ void RandomNumberGenerator::Seed(uint32_t x, uint32_t y) {
   Seeded = true;
 }
 
+//-----------------------------------------------------------------------------------
+// ***** RandomStream
+
+namespace {
+
+inline uint64_t RotateLeft(uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+// One step of all four generators, writing each 64-bit result as its low then high half.
+void StepScalar(uint64_t (&s)[4][4], uint32_t* out) {
+  for (int g = 0; g < 4; ++g) {
+    const uint64_t result = RotateLeft(s[0][g] + s[3][g], 23) + s[0][g];
+    const uint64_t t = s[1][g] << 17;
+    s[2][g] ^= s[0][g];
+    s[3][g] ^= s[1][g];
+    s[1][g] ^= s[2][g];
+    s[0][g] ^= s[3][g];
+    s[2][g] ^= t;
+    s[3][g] = RotateLeft(s[3][g], 45);
+
+    out[g * 2] = (uint32_t)result;
+    out[g * 2 + 1] = (uint32_t)(result >> 32);
+  }
+}
+
+// Advances generator g as if by 2^128 steps (jump) or 2^192 steps (long jump).
+void Jump(uint64_t (&s)[4][4], int g, const uint64_t (&polynomial)[4]) {
+  uint64_t jumped[4] = {0, 0, 0, 0};
+  for (int i = 0; i < 4; ++i) {
+    for (int bit = 0; bit < 64; ++bit) {
+      if (polynomial[i] & ((uint64_t)1 << bit)) {
+        for (int w = 0; w < 4; ++w)
+          jumped[w] ^= s[w][g];
+      }
+
+      const uint64_t t = s[1][g] << 17;
+      s[2][g] ^= s[0][g];
+      s[3][g] ^= s[1][g];
+      s[1][g] ^= s[2][g];
+      s[0][g] ^= s[3][g];
+      s[2][g] ^= t;
+      s[3][g] = RotateLeft(s[3][g], 45);
+    }
+  }
+
+  for (int w = 0; w < 4; ++w)
+    s[w][g] = jumped[w];
+}
+
+const uint64_t JumpPolynomial[4] = {
+    0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+const uint64_t LongJumpPolynomial[4] = {
+    0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL};
+
+#if defined(OVR_RAND_X86)
+
+bool HasAVX2() {
+  int regs[4];
+#if defined(OVR_CC_MSVC)
+  __cpuidex(regs, 1, 0);
+#else
+  int a, b, c, d;
+  __asm("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(1), "c"(0) :);
+  regs[0] = a;
+  regs[1] = b;
+  regs[2] = c;
+  regs[3] = d;
+#endif
+
+  // AVX needs the OS to save the upper halves of the registers, which XCR0 bits 1 and 2 show.
+  if (!(regs[2] & (1 << 27)) || !(regs[2] & (1 << 28)))
+    return false;
+
+#if defined(OVR_CC_MSVC)
+  const uint64_t xcr0 = _xgetbv(0);
+  __cpuidex(regs, 7, 0);
+#else
+  uint32_t xcr0Low, xcr0High;
+  __asm("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+  const uint64_t xcr0 = ((uint64_t)xcr0High << 32) | xcr0Low;
+  __asm("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(7), "c"(0) :);
+  regs[1] = b;
+#endif
+
+  return ((xcr0 & 6) == 6) && ((regs[1] & (1 << 5)) != 0);
+}
+
+bool UseAVX2() {
+  static const bool useAVX2 = HasAVX2();
+  return useAVX2;
+}
+
+OVR_RAND_TARGET("avx2")
+inline __m256i RotateLeftAVX2(__m256i x, int k) {
+  return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+}
+
+// blocks steps of the four generators. When toFloat, writes floats offset + scale * (x >> 8)
+// to outFloat instead of the values to out.
+OVR_RAND_TARGET("avx2")
+void StepAVX2(
+    uint64_t (&state)[4][4],
+    uint32_t* out,
+    float* outFloat,
+    size_t blocks,
+    bool toFloat,
+    float offset,
+    float scale) {
+  __m256i s0 = _mm256_loadu_si256((const __m256i*)state[0]);
+  __m256i s1 = _mm256_loadu_si256((const __m256i*)state[1]);
+  __m256i s2 = _mm256_loadu_si256((const __m256i*)state[2]);
+  __m256i s3 = _mm256_loadu_si256((const __m256i*)state[3]);
+  const __m256 offsets = _mm256_set1_ps(offset);
+  const __m256 scales = _mm256_set1_ps(scale);
+
+  for (size_t i = 0; i < blocks; ++i) {
+    // Little endian, so each 64-bit result is stored as its low then high half.
+    const __m256i result = _mm256_add_epi64(RotateLeftAVX2(_mm256_add_epi64(s0, s3), 23), s0);
+    const __m256i t = _mm256_slli_epi64(s1, 17);
+    s2 = _mm256_xor_si256(s2, s0);
+    s3 = _mm256_xor_si256(s3, s1);
+    s1 = _mm256_xor_si256(s1, s2);
+    s0 = _mm256_xor_si256(s0, s3);
+    s2 = _mm256_xor_si256(s2, t);
+    s3 = RotateLeftAVX2(s3, 45);
+
+    if (toFloat) {
+      const __m256 value = _mm256_cvtepi32_ps(_mm256_srli_epi32(result, 8));
+      _mm256_storeu_ps(outFloat + i * 8, _mm256_add_ps(offsets, _mm256_mul_ps(value, scales)));
+    } else {
+      _mm256_storeu_si256((__m256i*)(out + i * 8), result);
+    }
+  }
+
+  _mm256_storeu_si256((__m256i*)state[0], s0);
+  _mm256_storeu_si256((__m256i*)state[1], s1);
+  _mm256_storeu_si256((__m256i*)state[2], s2);
+  _mm256_storeu_si256((__m256i*)state[3], s3);
+}
+
+#endif // OVR_RAND_X86
+
+inline float ToFloat(uint32_t value, float offset, float scale) {
+  return offset + scale * (float)(value >> 8);
+}
+
+} // namespace
+
+void RandomStream::Seed(uint64_t seed, uint32_t stream) {
+  // SplitMix64 expands the seed into the first generator's state, which can't then be all zero.
+  for (int w = 0; w < 4; ++w) {
+    uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    State[w][0] = z ^ (z >> 31);
+  }
+
+  for (uint32_t i = 0; i < stream; ++i)
+    Jump(State, 0, LongJumpPolynomial);
+
+  // The others follow it at intervals of 2^128, well within the 2^192 given to each stream.
+  for (int g = 1; g < 4; ++g) {
+    for (int w = 0; w < 4; ++w)
+      State[w][g] = State[w][g - 1];
+    Jump(State, g, JumpPolynomial);
+  }
+
+  BufferIndex = BlockSize;
+}
+
+void RandomStream::refill() {
+#if defined(OVR_RAND_X86)
+  if (UseAVX2())
+    StepAVX2(State, Buffer, nullptr, 1, false, 0, 0);
+  else
+#endif
+    StepScalar(State, Buffer);
+  BufferIndex = 0;
+}
+
+void RandomStream::Fill(uint32_t* out, size_t count) {
+  // Use up what is buffered first, so the sequence is the same as from Next.
+  for (; count && (BufferIndex < BlockSize); --count)
+    *out++ = Buffer[BufferIndex++];
+
+  const size_t blocks = count / BlockSize;
+#if defined(OVR_RAND_X86)
+  if (UseAVX2())
+    StepAVX2(State, out, nullptr, blocks, false, 0, 0);
+  else
+#endif
+  {
+    for (size_t i = 0; i < blocks; ++i)
+      StepScalar(State, out + i * BlockSize);
+  }
+
+  out += blocks * BlockSize;
+  count -= blocks * BlockSize;
+
+  for (; count; --count)
+    *out++ = Next();
+}
+
+void RandomStream::Fill(float* out, size_t count) {
+  Fill(out, count, 0.0f, 1.0f);
+}
+
+void RandomStream::Fill(float* out, size_t count, float fmin, float fmax) {
+  const float scale = (fmax - fmin) * (1.0f / 16777216.0f); // 2^24
+
+  for (; count && (BufferIndex < BlockSize); --count)
+    *out++ = ToFloat(Buffer[BufferIndex++], fmin, scale);
+
+  const size_t blocks = count / BlockSize;
+#if defined(OVR_RAND_X86)
+  if (UseAVX2())
+    StepAVX2(State, nullptr, out, blocks, true, fmin, scale);
+  else
+#endif
+  {
+    uint32_t values[BlockSize];
+    for (size_t i = 0; i < blocks; ++i) {
+      StepScalar(State, values);
+      for (int j = 0; j < BlockSize; ++j)
+        out[i * BlockSize + j] = ToFloat(values[j], fmin, scale);
+    }
+  }
+
+  out += blocks * BlockSize;
+  count -= blocks * BlockSize;
+
+  for (; count; --count)
+    *out++ = ToFloat(Next(), fmin, scale);
+}
+
 } // namespace OVR
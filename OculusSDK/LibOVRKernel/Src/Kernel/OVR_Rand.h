@@ -175,6 +175,66 @@ class RandomNumberGenerator {
   }
 };
 
+//-----------------------------------------------------------------------------------
+// ***** RandomStream
+//
+// A generator for bulk random numbers, such as procedural placement or sample jitter. It runs
+// four interleaved xoshiro256++ generators (Blackman and Vigna) as one, so that Fill produces
+// four 64-bit values per step, with AVX2 where the CPU supports it. The sequence doesn't depend
+// on whether AVX2 was used, or on how it was split between Next and Fill calls.
+//
+// Streams with the same seed are 2^192 values apart, so threads which each use their own stream
+// never overlap and give reproducible results however the work is scheduled:
+//
+//     RandomStream random(sceneSeed, threadIndex);
+//     random.Fill(jitter, jitterCount, -0.5f, 0.5f);
+//
+// Seeding takes time proportional to the stream index, about a microsecond per stream.
+//
+class RandomStream {
+ public:
+  // Values produced per step of the four generators.
+  static const int BlockSize = 8;
+
+  RandomStream() {
+    Seed(0);
+  }
+
+  explicit RandomStream(uint64_t seed, uint32_t stream = 0) {
+    Seed(seed, stream);
+  }
+
+  void Seed(uint64_t seed, uint32_t stream = 0);
+
+  // Returns an unsigned uint32_t uniformly distributed in interval [0..2^32-1]
+  OVR_FORCE_INLINE uint32_t Next() {
+    if (BufferIndex == BlockSize)
+      refill();
+    return Buffer[BufferIndex++];
+  }
+
+  // Float uniformly distributed over half-open interval [0..1), with 24 bits of precision
+  // (the most a float has in that interval). Uses one value of the sequence.
+  OVR_FORCE_INLINE float NextFloat() {
+    return (float)(Next() >> 8) * (1.0f / 16777216.0f); // 2^24
+  }
+
+  // Fills out with count values, as if by calling Next (or NextFloat) count times.
+  void Fill(uint32_t* out, size_t count);
+  void Fill(float* out, size_t count);
+
+  // Floats uniformly distributed over [fmin..fmax)
+  void Fill(float* out, size_t count, float fmin, float fmax);
+
+ protected:
+  void refill();
+
+  // State[word][generator], so that one word of all four generators is one AVX2 register.
+  uint64_t State[4][4];
+  uint32_t Buffer[BlockSize];
+  int BufferIndex;
+};
+
 } // namespace OVR
 
 #endif // OVR_Rand_h
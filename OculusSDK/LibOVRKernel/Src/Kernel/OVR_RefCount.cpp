@@ -51,6 +51,17 @@ RefCountNTSImplCore::~RefCountNTSImplCore() {
   //  0 if Release() was properly called.
   //  1 if the object was declared on stack or as an aggregate.
   OVR_ASSERT(RefCount <= 1);
+
+  if (pWeakProxy) {
+    pWeakProxy->Alive = false;
+    pWeakProxy->Release();
+  }
+}
+
+RefCountWeakProxy* RefCountNTSImplCore::GetWeakProxy() const {
+  if (!pWeakProxy)
+    pWeakProxy = new RefCountWeakProxy{1, true};
+  return pWeakProxy;
 }
 
 #ifdef OVR_BUILD_DEBUG
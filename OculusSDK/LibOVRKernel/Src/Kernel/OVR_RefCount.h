@@ -30,6 +30,7 @@ limitations under the License.
 
 #include "OVR_Types.h"
 #include "OVR_Allocator.h"
+#include "OVR_ObjectPool.h"
 
 namespace OVR {
 
@@ -50,6 +51,9 @@ class RefCountBaseNTS;
 
 class RefCountImpl;
 class RefCountNTSImpl;
+struct RefCountWeakProxy;
+template <class C>
+class WeakPtr;
 
 //-----------------------------------------------------------------------------------
 // ***** Implementation For Reference Counting
@@ -96,10 +100,20 @@ class RefCountImplCore {
 class RefCountNTSImplCore {
  protected:
   mutable int RefCount;
+  mutable RefCountWeakProxy* pWeakProxy; // Created by the first WeakPtr to this object.
+
+  template <class C>
+  friend class WeakPtr;
+
+  RefCountWeakProxy* GetWeakProxy() const;
 
  public:
   // RefCountImpl constructor always initializes RefCount to 1 by default.
-  OVR_FORCE_INLINE RefCountNTSImplCore() : RefCount(1) {}
+  OVR_FORCE_INLINE RefCountNTSImplCore() : RefCount(1), pWeakProxy(nullptr) {}
+
+  // A copy is a new object, with its own count and no WeakPtrs.
+  OVR_FORCE_INLINE RefCountNTSImplCore(const RefCountNTSImplCore&)
+      : RefCount(1), pWeakProxy(nullptr) {}
 
   // Need virtual destructor
   // This:    1. Makes sure the right destructor's called.
@@ -227,6 +241,27 @@ class RefCountBaseStatVImpl : virtual public Base {
   // DOM-IGNORE-END
 };
 
+//-----------------------------------------------------------------------------------
+// ***** RefCountTraits
+//
+// RefCountTraits<C> selects the reference counting used by RefCountBase<C>. It is thread-safe
+// unless specialized. Types which are only ever referenced from one thread can avoid the atomic
+// increments by specializing it before the class is defined:
+//     template <>
+//     struct RefCountTraits<Widget> : public RefCountTraitsNTS {};
+// Such types also support WeakPtr.
+
+struct RefCountTraitsTS {
+  typedef RefCountImpl Impl;
+};
+
+struct RefCountTraitsNTS {
+  typedef RefCountNTSImpl Impl;
+};
+
+template <class C>
+struct RefCountTraits : public RefCountTraitsTS {};
+
 //-----------------------------------------------------------------------------------
 // *** End user RefCountBase<> classes
 
@@ -238,10 +273,35 @@ class RefCountBaseStatVImpl : virtual public Base {
 // hidden by Ptr<>.
 
 template <class C>
-class RefCountBase : public RefCountBaseStatImpl<RefCountImpl> {
+class RefCountBase : public RefCountBaseStatImpl<typename RefCountTraits<C>::Impl> {
+  typedef typename RefCountTraits<C>::Impl Impl;
+
  public:
   // Constructor.
-  OVR_FORCE_INLINE RefCountBase() : RefCountBaseStatImpl<RefCountImpl>() {}
+  OVR_FORCE_INLINE RefCountBase() : RefCountBaseStatImpl<Impl>() {}
+
+// *** Override New and Delete
+// These allocate from ObjectPool<C> if ObjectPoolTraits<C> enables it. See OVR_ObjectPool.h.
+
+// DOM-IGNORE-BEGIN
+#ifdef OVR_DEFINE_NEW
+#undef new
+#endif
+
+#ifdef OVR_BUILD_DEBUG
+#define OVR_REFCOUNTALLOC_CHECK_DELETE(class_name, p) Impl::checkInvalidDelete((class_name*)p)
+#else
+#define OVR_REFCOUNTALLOC_CHECK_DELETE(class_name, p)
+#endif
+
+  OVR_OBJECT_POOL_REDEFINE_NEW_IMPL(C, OVR_REFCOUNTALLOC_CHECK_DELETE)
+
+#undef OVR_REFCOUNTALLOC_CHECK_DELETE
+
+#ifdef OVR_DEFINE_NEW
+#define new OVR_DEFINE_NEW
+#endif
+  // DOM-IGNORE-END
 };
 
 // RefCountBaseV is the same as RefCountBase but with virtual AddRef/Release
@@ -267,6 +327,29 @@ class RefCountBaseNTS : public RefCountBaseStatImpl<RefCountNTSImpl> {
  public:
   // Constructor.
   OVR_FORCE_INLINE RefCountBaseNTS() : RefCountBaseStatImpl<RefCountNTSImpl>() {}
+
+// *** Override New and Delete
+// These allocate from ObjectPool<C> if ObjectPoolTraits<C> enables it. See OVR_ObjectPool.h.
+
+// DOM-IGNORE-BEGIN
+#ifdef OVR_DEFINE_NEW
+#undef new
+#endif
+
+#ifdef OVR_BUILD_DEBUG
+#define OVR_REFCOUNTALLOC_CHECK_DELETE(class_name, p) checkInvalidDelete((class_name*)p)
+#else
+#define OVR_REFCOUNTALLOC_CHECK_DELETE(class_name, p)
+#endif
+
+  OVR_OBJECT_POOL_REDEFINE_NEW_IMPL(C, OVR_REFCOUNTALLOC_CHECK_DELETE)
+
+#undef OVR_REFCOUNTALLOC_CHECK_DELETE
+
+#ifdef OVR_DEFINE_NEW
+#define new OVR_DEFINE_NEW
+#endif
+  // DOM-IGNORE-END
 };
 
 //-----------------------------------------------------------------------------------
@@ -456,6 +539,90 @@ class Ptr {
   }
 };
 
+//-----------------------------------------------------------------------------------
+// ***** Weak pointer
+//
+// WeakPtr refers to a non-thread-safe ref-counted object (RefCountBaseNTS, or RefCountBase with
+// RefCountTraitsNTS) without keeping it alive, for caches and back references. Lock returns a
+// Ptr to the object, or null once the object is being destroyed. Like the object, a WeakPtr
+// must only be used on the thread which uses the object. Example usage:
+//     WeakPtr<Model> cached = model;
+//     ...
+//     Ptr<Model> m = cached.Lock();
+//     if (m)
+//       ...
+//
+
+// RefCountWeakProxy is shared by an object and the WeakPtrs to it. It outlives the object,
+// which clears Alive when it's destroyed.
+struct RefCountWeakProxy {
+  int RefCount; // The number of WeakPtrs, plus one while the object is alive.
+  bool Alive;
+
+  void Release() {
+    if (--RefCount == 0)
+      delete this;
+  }
+};
+
+template <class C>
+class WeakPtr {
+ protected:
+  C* pObject;
+  RefCountWeakProxy* pProxy;
+
+ public:
+  WeakPtr() : pObject(nullptr), pProxy(nullptr) {}
+
+  WeakPtr(C* pobj) : pObject(pobj), pProxy(pobj ? pobj->GetWeakProxy() : nullptr) {
+    if (pProxy)
+      pProxy->RefCount++;
+  }
+
+  WeakPtr(const Ptr<C>& src) : WeakPtr(src.GetPtr()) {}
+
+  WeakPtr(const WeakPtr<C>& src) : pObject(src.pObject), pProxy(src.pProxy) {
+    if (pProxy)
+      pProxy->RefCount++;
+  }
+
+  ~WeakPtr() {
+    if (pProxy)
+      pProxy->Release();
+  }
+
+  WeakPtr<C>& operator=(const WeakPtr<C>& src) {
+    if (src.pProxy)
+      src.pProxy->RefCount++;
+    if (pProxy)
+      pProxy->Release();
+    pObject = src.pObject;
+    pProxy = src.pProxy;
+    return *this;
+  }
+
+  WeakPtr<C>& operator=(C* pobj) {
+    return *this = WeakPtr<C>(pobj);
+  }
+
+  // True once the object is being destroyed, or if this was never assigned an object.
+  bool IsExpired() const {
+    return !pProxy || !pProxy->Alive || (pObject->GetRefCount() == 0);
+  }
+
+  // Returns a reference to the object, or null if it has expired.
+  Ptr<C> Lock() const {
+    return IsExpired() ? Ptr<C>() : Ptr<C>(pObject);
+  }
+
+  void Clear() {
+    if (pProxy)
+      pProxy->Release();
+    pObject = nullptr;
+    pProxy = nullptr;
+  }
+};
+
 // LockedPtr
 //
 // Helper class to simplify thread-safety of the TrackingManager.
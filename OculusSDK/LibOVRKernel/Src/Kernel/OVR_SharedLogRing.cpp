@@ -0,0 +1,304 @@
+/************************************************************************************
+
+Filename    :   OVR_SharedLogRing.cpp
+Content     :   Cross-process shared memory ring of log records
+Created     :   October 14, 2026
+Notes       :
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR_SharedLogRing.h"
+#include "OVR_Alg.h"
+
+#include <chrono>
+#include <limits.h>
+#include <string.h>
+
+namespace OVR {
+
+OVR_COMPILER_ASSERT(sizeof(SharedLogRingHeader) == 64);
+OVR_COMPILER_ASSERT(sizeof(SharedLogRecordHeader) == 64);
+
+// Smallest slot we allow, so every record has room for some text.
+static const uint32_t SharedLogRingMinSlotSize = sizeof(SharedLogRecordHeader) + 64;
+
+static uint32_t RoundUpPow2(uint32_t value) {
+  uint32_t result = 1;
+  while (result < value)
+    result <<= 1;
+  return result;
+}
+
+static bool GetRingSize(uint32_t slotCount, uint32_t slotSize, int& size) {
+  const uint64_t size64 = sizeof(SharedLogRingHeader) + ((uint64_t)slotCount * slotSize);
+  if (size64 > (uint64_t)INT_MAX)
+    return false;
+  size = (int)size64;
+  return true;
+}
+
+//-----------------------------------------------------------------------------------
+// ***** SharedLogRingWriter
+
+SharedLogRingWriter::SharedLogRingWriter() : pSharedMemory(), Header(nullptr), Slots(nullptr) {}
+
+SharedLogRingWriter::~SharedLogRingWriter() {
+  Close();
+}
+
+bool SharedLogRingWriter::Open(const char* name, unsigned slotCount, unsigned slotSize) {
+  Close();
+
+  slotCount = RoundUpPow2(Alg::Max(slotCount, 2u));
+  slotSize = Alg::Max(slotSize, SharedLogRingMinSlotSize);
+  slotSize = (slotSize + 7) & ~7u; // Keeps each slot's Generation 8 byte aligned.
+
+  SharedMemory::OpenParameters params;
+  params.globalName = name;
+  params.openMode = SharedMemory::OpenMode_CreateOrOpen;
+  params.remoteMode = SharedMemory::RemoteMode_ReadOnly;
+  params.accessMode = SharedMemory::AccessMode_ReadWrite;
+  if (!GetRingSize(slotCount, slotSize, params.minSizeBytes))
+    return false;
+
+  Ptr<SharedMemory> sharedMemory = SharedMemoryFactory::GetInstance()->Open(params);
+  if (!sharedMemory || !sharedMemory->GetData() ||
+      sharedMemory->GetSizeI() < params.minSizeBytes)
+    return false;
+
+  SharedLogRingHeader* header = (SharedLogRingHeader*)sharedMemory->GetData();
+
+  // A ring left by a previous run (or in use by another process) keeps going if it has the
+  // same layout, so that readers see one continuous sequence.
+  if ((header->Magic != SharedLogRingMagic) || (header->Version != SharedLogRingVersion) ||
+      (header->SlotCount != slotCount) || (header->SlotSize != slotSize)) {
+    header->Magic = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    memset((uint8_t*)header + sizeof(SharedLogRingHeader), 0, (size_t)slotCount * slotSize);
+    header->Version = SharedLogRingVersion;
+    header->SlotCount = slotCount;
+    header->SlotSize = slotSize;
+    header->WriteCount.store(0, std::memory_order_relaxed);
+
+    // Readers check Magic first, so it's published last.
+    std::atomic_thread_fence(std::memory_order_release);
+    header->Magic = SharedLogRingMagic;
+  }
+
+  pSharedMemory = sharedMemory;
+  Header = header;
+  Slots = (uint8_t*)header + sizeof(SharedLogRingHeader);
+  return true;
+}
+
+void SharedLogRingWriter::Close() {
+  Header = nullptr;
+  Slots = nullptr;
+  pSharedMemory.Clear();
+}
+
+void SharedLogRingWriter::Publish(
+    ovrlog::Level level,
+    const char* subsystem,
+    const char* text,
+    size_t textLength) {
+  if (!Header)
+    return;
+
+  const uint64_t sequence = Header->WriteCount.fetch_add(1, std::memory_order_relaxed);
+  uint8_t* slot = Slots + (size_t)(sequence & (Header->SlotCount - 1)) * Header->SlotSize;
+  SharedLogRecordHeader* record = (SharedLogRecordHeader*)slot;
+
+  record->Generation.store((sequence * 2) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  const size_t textCapacity = Header->SlotSize - sizeof(SharedLogRecordHeader) - 1;
+  if (textLength > textCapacity)
+    textLength = textCapacity;
+
+  record->UnixTimeMs = (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+  record->Level = (uint32_t)level;
+  record->TextLength = (uint32_t)textLength;
+
+  size_t subsystemLength = subsystem ? strlen(subsystem) : 0;
+  if (subsystemLength >= sizeof(record->Subsystem))
+    subsystemLength = sizeof(record->Subsystem) - 1;
+  memcpy(record->Subsystem, subsystem, subsystemLength);
+  record->Subsystem[subsystemLength] = '\0';
+
+  char* recordText = (char*)(record + 1);
+  memcpy(recordText, text, textLength);
+  recordText[textLength] = '\0';
+
+  // If a writer for a later lap of the ring has taken the slot in the meantime, this record
+  // was already lost and the slot is left to that writer.
+  uint64_t expected = (sequence * 2) + 1;
+  record->Generation.compare_exchange_strong(
+      expected, (sequence * 2) + 2, std::memory_order_release, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------------
+// ***** SharedLogRingReader
+
+SharedLogRingReader::SharedLogRingReader()
+    : pSharedMemory(),
+      Header(nullptr),
+      Slots(nullptr),
+      SlotCount(0),
+      SlotSize(0),
+      NextSequence(0),
+      LostCount(0),
+      RecordCopy() {}
+
+SharedLogRingReader::~SharedLogRingReader() {
+  Close();
+}
+
+bool SharedLogRingReader::Open(const char* name, bool fromOldest) {
+  Close();
+
+  SharedMemory::OpenParameters params;
+  params.globalName = name;
+  params.openMode = SharedMemory::OpenMode_OpenOnly;
+  params.remoteMode = SharedMemory::RemoteMode_ReadOnly;
+  params.accessMode = SharedMemory::AccessMode_ReadOnly;
+  params.minSizeBytes = sizeof(SharedLogRingHeader);
+
+  Ptr<SharedMemory> sharedMemory = SharedMemoryFactory::GetInstance()->Open(params);
+  if (!sharedMemory || !sharedMemory->GetData() ||
+      sharedMemory->GetSizeI() < (int)sizeof(SharedLogRingHeader))
+    return false;
+
+  const SharedLogRingHeader* header = (const SharedLogRingHeader*)sharedMemory->GetData();
+  if (header->Magic != SharedLogRingMagic)
+    return false;
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  int size;
+  if ((header->Version != SharedLogRingVersion) || (header->SlotCount < 2) ||
+      ((header->SlotCount & (header->SlotCount - 1)) != 0) ||
+      (header->SlotSize < SharedLogRingMinSlotSize) || ((header->SlotSize & 7) != 0) ||
+      !GetRingSize(header->SlotCount, header->SlotSize, size) ||
+      (sharedMemory->GetSizeI() < size))
+    return false;
+
+  pSharedMemory = sharedMemory;
+  Header = header;
+  Slots = (const uint8_t*)header + sizeof(SharedLogRingHeader);
+  SlotCount = header->SlotCount;
+  SlotSize = header->SlotSize;
+  LostCount = 0;
+  RecordCopy.Resize(SlotSize);
+
+  const uint64_t writeCount = Header->WriteCount.load(std::memory_order_acquire);
+  if (!fromOldest)
+    NextSequence = writeCount;
+  else
+    NextSequence = (writeCount > SlotCount) ? (writeCount - SlotCount) : 0;
+
+  return true;
+}
+
+void SharedLogRingReader::Close() {
+  Header = nullptr;
+  Slots = nullptr;
+  pSharedMemory.Clear();
+}
+
+bool SharedLogRingReader::Read(Entry& entry) {
+  if (!Header)
+    return false;
+
+  for (;;) {
+    const uint64_t writeCount = Header->WriteCount.load(std::memory_order_acquire);
+    if (NextSequence >= writeCount)
+      return false;
+
+    // Skip records which have been overwritten already.
+    if ((writeCount - NextSequence) > SlotCount) {
+      LostCount += (writeCount - SlotCount) - NextSequence;
+      NextSequence = writeCount - SlotCount;
+    }
+
+    const uint8_t* slot = Slots + (size_t)(NextSequence & (SlotCount - 1)) * SlotSize;
+    const SharedLogRecordHeader* record = (const SharedLogRecordHeader*)slot;
+    const uint64_t complete = (NextSequence * 2) + 2;
+
+    const uint64_t generation = record->Generation.load(std::memory_order_acquire);
+    if (generation < complete)
+      return false; // Claimed, but not finished yet.
+
+    if (generation == complete) {
+      memcpy(RecordCopy.GetDataPtr(), slot, SlotSize);
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if (record->Generation.load(std::memory_order_relaxed) == complete) {
+        SharedLogRecordHeader* copy = (SharedLogRecordHeader*)RecordCopy.GetDataPtr();
+        char* text = (char*)(copy + 1);
+        const size_t textCapacity = SlotSize - sizeof(SharedLogRecordHeader) - 1;
+
+        // Don't trust the lengths and terminators, as any process may write to the ring.
+        copy->Subsystem[sizeof(copy->Subsystem) - 1] = '\0';
+        entry.TextLength = Alg::Min((size_t)copy->TextLength, textCapacity);
+        text[entry.TextLength] = '\0';
+
+        entry.Sequence = NextSequence++;
+        entry.UnixTimeMs = copy->UnixTimeMs;
+        entry.Level = (ovrlog::Level)copy->Level;
+        entry.Subsystem = copy->Subsystem;
+        entry.Text = text;
+        return true;
+      }
+    }
+
+    // The slot was taken for a later record while we looked at it, so this one is lost.
+    ++LostCount;
+    ++NextSequence;
+  }
+}
+
+//-----------------------------------------------------------------------------------
+// ***** SharedLogRingOutput
+
+SharedLogRingOutput::SharedLogRingOutput(
+    const char* ringName,
+    unsigned slotCount,
+    unsigned slotSize)
+    : Writer() {
+  Writer.Open(ringName, slotCount, slotSize);
+}
+
+const char* SharedLogRingOutput::GetUniquePluginName() {
+  return "SharedLogRingOutput";
+}
+
+void SharedLogRingOutput::Write(
+    ovrlog::Level level,
+    const char* subsystem,
+    const char* header,
+    const char* utf8msg) {
+  OVR_UNUSED(header);
+  Writer.Publish(level, subsystem, utf8msg, strlen(utf8msg));
+}
+
+} // namespace OVR
@@ -0,0 +1,210 @@
+/************************************************************************************
+
+Filename    :   OVR_SharedLogRing.h
+Content     :   Cross-process shared memory ring of log records
+Created     :   October 14, 2026
+Notes       :
+    A SharedLogRing is a named shared memory region holding a fixed number of fixed-size log
+    record slots. Writers publish records into it and a collector in another process tails it
+    with a SharedLogRingReader, without any other IPC. Record n goes into slot n % SlotCount, so
+    once the ring is full each new record overwrites the oldest; the reader detects this and
+    counts the records it missed.
+
+    Each slot is guarded by a generation counter in the manner of LocklessHistory: it is
+    2 * n + 1 while record n is being written and 2 * n + 2 once it is complete. The reader
+    checks the generation before and after copying a record out, so it never returns a torn
+    record, and a writer never waits on a reader.
+
+    To have the log output published to a ring:
+
+        ovrlog::OutputWorker::GetInstance()->AddPlugin(
+            std::make_shared<OVR::SharedLogRingOutput>("OculusLogRing"));
+
+    and in the collector:
+
+        SharedLogRingReader reader;
+        if (reader.Open("OculusLogRing")) {
+          SharedLogRingReader::Entry entry;
+          while (reader.Read(entry))
+            Collect(entry.Sequence, entry.Subsystem, entry.Text);
+        }
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_SharedLogRing_h
+#define OVR_SharedLogRing_h
+
+#include "OVR_Types.h"
+#include "OVR_Array.h"
+#include "OVR_Atomic.h"
+#include "OVR_SharedMemory.h"
+
+#include "Logging/Logging_Library.h"
+
+namespace OVR {
+
+//-----------------------------------------------------------------------------------
+// ***** SharedLogRing layout
+//
+// The region is a SharedLogRingHeader followed by SlotCount slots of SlotSize bytes, each a
+// SharedLogRecordHeader followed by the record's text. All fields have fixed sizes, so 32-bit
+// and 64-bit processes can share a ring.
+
+static const uint32_t SharedLogRingMagic = 0x4C524F4F; // "OORL"
+static const uint32_t SharedLogRingVersion = 1;
+
+struct SharedLogRingHeader {
+  uint32_t Magic; // SharedLogRingMagic once the ring is initialized
+  uint32_t Version; // SharedLogRingVersion
+  uint32_t SlotCount; // A power of two
+  uint32_t SlotSize; // Bytes per slot, including its SharedLogRecordHeader
+  std::atomic<uint64_t> WriteCount; // Number of records claimed by writers so far
+  uint8_t Padding[40];
+};
+
+struct SharedLogRecordHeader {
+  std::atomic<uint64_t> Generation; // See the file notes; 0 if the slot has never been written
+  uint64_t UnixTimeMs; // Wall clock time at which the record was published
+  uint32_t Level; // ovrlog::Level
+  uint32_t TextLength; // Bytes of text following this header, not including its '\0'
+  char Subsystem[32]; // Null terminated, and cut to fit
+  uint8_t Padding[8];
+};
+
+//-----------------------------------------------------------------------------------
+// ***** SharedLogRingWriter
+//
+// Publishes records into a ring, creating the region if it doesn't exist yet. Publish may be
+// called from any number of threads, and from several processes which open the same ring.
+//
+class SharedLogRingWriter {
+  OVR_NON_COPYABLE(SharedLogRingWriter)
+
+ public:
+  SharedLogRingWriter();
+  ~SharedLogRingWriter();
+
+  // slotCount is rounded up to a power of two. If the ring already exists with the same
+  // geometry its records and sequence numbers are kept, otherwise it is reset. Returns false
+  // if the region couldn't be opened.
+  bool Open(const char* name, unsigned slotCount = 4096, unsigned slotSize = 512);
+  void Close();
+
+  bool IsOpen() const {
+    return Header != nullptr;
+  }
+
+  // Text which doesn't fit in a slot is cut at the slot size.
+  void Publish(ovrlog::Level level, const char* subsystem, const char* text, size_t textLength);
+
+ protected:
+  Ptr<SharedMemory> pSharedMemory;
+  SharedLogRingHeader* Header;
+  uint8_t* Slots;
+};
+
+//-----------------------------------------------------------------------------------
+// ***** SharedLogRingReader
+//
+// Tails a ring created by a SharedLogRingWriter, from read-only shared memory.
+//
+class SharedLogRingReader {
+  OVR_NON_COPYABLE(SharedLogRingReader)
+
+ public:
+  // A record copied out of the ring. Subsystem and Text point into the reader, and are valid
+  // until the next call to Read.
+  struct Entry {
+    uint64_t Sequence;
+    uint64_t UnixTimeMs;
+    ovrlog::Level Level;
+    const char* Subsystem;
+    const char* Text;
+    size_t TextLength;
+  };
+
+  SharedLogRingReader();
+  ~SharedLogRingReader();
+
+  // Fails if the ring doesn't exist or hasn't been initialized by a writer. When fromOldest is
+  // true reading starts at the oldest record still in the ring, otherwise at the next new one.
+  bool Open(const char* name, bool fromOldest = true);
+  void Close();
+
+  bool IsOpen() const {
+    return Header != nullptr;
+  }
+
+  // Copies out the next record in sequence. Returns false if there are no new complete records
+  // yet. Records which were overwritten before they could be read are skipped and counted in
+  // GetLostCount. A writer which dies part way through a record holds the reader at that record
+  // until the ring wraps past it.
+  bool Read(Entry& entry);
+
+  uint64_t GetNextSequence() const {
+    return NextSequence;
+  }
+
+  uint64_t GetLostCount() const {
+    return LostCount;
+  }
+
+ protected:
+  Ptr<SharedMemory> pSharedMemory;
+  const SharedLogRingHeader* Header;
+  const uint8_t* Slots;
+  uint32_t SlotCount;
+  uint32_t SlotSize;
+  uint64_t NextSequence;
+  uint64_t LostCount;
+  ArrayPOD<uint8_t> RecordCopy; // The last record read, which Entry points into
+};
+
+//-----------------------------------------------------------------------------------
+// ***** SharedLogRingOutput
+//
+// Log output plugin which publishes each message to a SharedLogRingWriter, as one record whose
+// text is the message without the header; the record holds the level, subsystem and time.
+//
+class SharedLogRingOutput : public ovrlog::OutputPlugin {
+ public:
+  explicit SharedLogRingOutput(
+      const char* ringName,
+      unsigned slotCount = 4096,
+      unsigned slotSize = 512);
+
+  bool IsOpen() const {
+    return Writer.IsOpen();
+  }
+
+ protected:
+  virtual const char* GetUniquePluginName() override;
+  virtual void Write(
+      ovrlog::Level level,
+      const char* subsystem,
+      const char* header,
+      const char* utf8msg) override;
+
+  SharedLogRingWriter Writer;
+};
+
+} // namespace OVR
+
+#endif // OVR_SharedLogRing_h
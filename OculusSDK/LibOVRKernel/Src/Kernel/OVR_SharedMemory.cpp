@@ -42,6 +42,11 @@ limitations under the License.
 #include <unistd.h> // close()
 #endif // OVR_OS_LINUX
 
+#if defined(OVR_OS_LINUX)
+#include <linux/mempolicy.h> // MPOL_PREFERRED
+#include <sys/syscall.h> // SYS_mbind
+#endif // OVR_OS_LINUX
+
 OVR_DEFINE_SINGLETON(OVR::SharedMemoryFactory);
 
 namespace OVR {
@@ -178,6 +183,14 @@ OVR_DEFINE_SINGLETON(FakeMemoryManager);
 
 namespace OVR {
 
+// Reads a byte from each page of a view, so the pages are faulted in now rather than on first
+// use. Reading is enough: the region is shared, so a later write doesn't fault again.
+static void PrefaultView(const void* view, size_t size, size_t pageSize) {
+  const volatile uint8_t* bytes = (const volatile uint8_t*)view;
+  for (size_t offset = 0; offset < size; offset += pageSize)
+    (void)bytes[offset];
+}
+
 static SharedMemoryInternalBase* CreateFakeSharedMemory(
     const SharedMemory::OpenParameters& params) {
   return FakeMemoryManager::GetInstance()->Open(
@@ -218,14 +231,74 @@ class SharedMemoryInternal : public SharedMemoryInternalBase {
   }
 };
 
-static SharedMemoryInternal*
-DoFileMap(HANDLE hFileMapping, const char* fileName, bool openReadOnly, int minSize) {
+// Enables SeLockMemoryPrivilege for the process, which creating a large page section needs.
+// Fails if the account doesn't hold the privilege.
+static bool EnableLockMemoryPrivilege() {
+  HANDLE hToken = NULL;
+  if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &hToken))
+    return false;
+
+  TOKEN_PRIVILEGES privileges;
+  ZeroMemory(&privileges, sizeof(privileges));
+  privileges.PrivilegeCount = 1;
+  privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+  // AdjustTokenPrivileges succeeds without enabling anything if the privilege isn't held.
+  const bool enabled =
+      LookupPrivilegeValueW(NULL, L"SeLockMemoryPrivilege", &privileges.Privileges[0].Luid) &&
+      AdjustTokenPrivileges(hToken, FALSE, &privileges, 0, NULL, NULL) &&
+      (GetLastError() == ERROR_SUCCESS);
+
+  CloseHandle(hToken);
+  return enabled;
+}
+
+static void ApplyMapOptions(
+    void* pFileView,
+    int minSize,
+    const SharedMemory::OpenParameters& params,
+    const char* fileName) {
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+
+  // Prefault first, so that a lock doesn't have to fault the pages in one at a time.
+  if (params.mapFlags & (SharedMemory::MapFlag_Prefault | SharedMemory::MapFlag_Lock))
+    PrefaultView(pFileView, (size_t)minSize, systemInfo.dwPageSize);
+
+  if (params.mapFlags & SharedMemory::MapFlag_Lock) {
+    // VirtualLock is limited by the minimum working set size, so grow it by the view size.
+    SIZE_T minimumSize = 0, maximumSize = 0;
+    if (GetProcessWorkingSetSize(GetCurrentProcess(), &minimumSize, &maximumSize)) {
+      SetProcessWorkingSetSize(
+          GetCurrentProcess(), minimumSize + (SIZE_T)minSize, maximumSize + (SIZE_T)minSize);
+    }
+
+    if (!VirtualLock(pFileView, (SIZE_T)minSize)) {
+      Logger.LogDebugF(
+          "WARNING: Unable to lock view of file for %s error code = %d", fileName, GetLastError());
+    }
+  }
+
+  OVR_UNUSED(fileName);
+}
+
+static SharedMemoryInternal* DoFileMap(
+    HANDLE hFileMapping,
+    const char* fileName,
+    bool openReadOnly,
+    int minSize,
+    const SharedMemory::OpenParameters& params) {
   // Interpret the access mode as a map desired access code
   DWORD mapDesiredAccess = openReadOnly ? FILE_MAP_READ : FILE_MAP_WRITE;
 
   // Map view of the file to this process
   void* pFileView = MapViewOfFile(hFileMapping, mapDesiredAccess, 0, 0, minSize);
 
+  // A view of a large page section must cover whole large pages, which mapping the whole
+  // section is sure to.
+  if (!pFileView && (minSize > 0))
+    pFileView = MapViewOfFile(hFileMapping, mapDesiredAccess, 0, 0, 0);
+
   // If mapping could not be created,
   if (!pFileView) {
     CloseHandle(hFileMapping);
@@ -236,6 +309,8 @@ DoFileMap(HANDLE hFileMapping, const char* fileName, bool openReadOnly, int minS
     return NULL;
   }
 
+  ApplyMapOptions(pFileView, minSize, params, fileName);
+
   // Create internal representation
   SharedMemoryInternal* pimple = new SharedMemoryInternal(hFileMapping, pFileView);
 
@@ -251,8 +326,11 @@ DoFileMap(HANDLE hFileMapping, const char* fileName, bool openReadOnly, int minS
   return pimple;
 }
 
-static SharedMemoryInternal*
-AttemptOpenSharedMemory(const char* fileName, int minSize, bool openReadOnly) {
+static SharedMemoryInternal* AttemptOpenSharedMemory(
+    const char* fileName,
+    int minSize,
+    bool openReadOnly,
+    const SharedMemory::OpenParameters& params) {
   // Interpret the access mode as a map desired access code
   DWORD mapDesiredAccess = openReadOnly ? FILE_MAP_READ : FILE_MAP_WRITE;
 
@@ -270,14 +348,15 @@ AttemptOpenSharedMemory(const char* fileName, int minSize, bool openReadOnly) {
   }
 
   // Map the file
-  return DoFileMap(hFileMapping, fileName, openReadOnly, minSize);
+  return DoFileMap(hFileMapping, fileName, openReadOnly, minSize, params);
 }
 
 static SharedMemoryInternal* AttemptCreateSharedMemory(
     const char* fileName,
     int minSize,
     bool openReadOnly,
-    bool allowRemoteWrite) {
+    bool allowRemoteWrite,
+    const SharedMemory::OpenParameters& params) {
   // Prepare a SECURITY_ATTRIBUTES object
   SECURITY_ATTRIBUTES security;
   ZeroMemory(&security, sizeof(security));
@@ -317,14 +396,47 @@ static SharedMemoryInternal* AttemptCreateSharedMemory(
 
   std::wstring wFileName = UTF8StringToUCSString(fileName);
 
+  const DWORD numaNode = (params.numaNode >= 0) ? (DWORD)params.numaNode : NUMA_NO_PREFERRED_NODE;
+  HANDLE hFileMapping = NULL;
+
+  // Large pages are committed, and never paged out, when the section is created. The section
+  // size has to be a whole number of them.
+  if (params.mapFlags & SharedMemory::MapFlag_LargePages) {
+    const SIZE_T largePageSize = GetLargePageMinimum();
+
+    if (largePageSize && EnableLockMemoryPrivilege()) {
+      const uint64_t largeSize =
+          (((uint64_t)minSize + largePageSize - 1) / largePageSize) * largePageSize;
+
+      hFileMapping = CreateFileMappingNumaW(
+          INVALID_HANDLE_VALUE,
+          &security,
+          pageProtectCode | SEC_COMMIT | SEC_LARGE_PAGES,
+          (DWORD)(largeSize >> 32),
+          (DWORD)largeSize,
+          wFileName.c_str(),
+          numaNode);
+    }
+
+    if (NULL == hFileMapping) {
+      Logger.LogDebugF(
+          "WARNING: Unable to create large page file mapping for %s error code = %d",
+          fileName,
+          GetLastError());
+    }
+  }
+
   // Attempt to create a file mapping
-  HANDLE hFileMapping = CreateFileMappingW(
-      INVALID_HANDLE_VALUE, // From page file
-      &security, // Security attributes
-      pageProtectCode, // Read-only?
-      0, // High word for size = 0
-      minSize, // Low word for size
-      wFileName.c_str()); // Name of global shared memory file
+  if (NULL == hFileMapping) {
+    hFileMapping = CreateFileMappingNumaW(
+        INVALID_HANDLE_VALUE, // From page file
+        &security, // Security attributes
+        pageProtectCode, // Read-only?
+        0, // High word for size = 0
+        minSize, // Low word for size
+        wFileName.c_str(), // Name of global shared memory file
+        numaNode); // Preferred NUMA node
+  }
 
   // Free the security descriptor buffer
   LocalFree(security.lpSecurityDescriptor);
@@ -347,7 +459,7 @@ static SharedMemoryInternal* AttemptCreateSharedMemory(
 #endif
 
   // Map the file
-  return DoFileMap(hFileMapping, fileName, openReadOnly, minSize);
+  return DoFileMap(hFileMapping, fileName, openReadOnly, minSize, params);
 }
 
 static SharedMemoryInternal* CreateSharedMemory(const SharedMemory::OpenParameters& params) {
@@ -366,7 +478,7 @@ static SharedMemoryInternal* CreateSharedMemory(const SharedMemory::OpenParamete
     // If opening should be attempted first,
     if (params.openMode != SharedMemory::OpenMode_CreateOnly) {
       // Attempt to open a shared memory map
-      retval = AttemptOpenSharedMemory(fileName, params.minSizeBytes, openReadOnly);
+      retval = AttemptOpenSharedMemory(fileName, params.minSizeBytes, openReadOnly, params);
 
       // If successful,
       if (retval) {
@@ -381,8 +493,8 @@ static SharedMemoryInternal* CreateSharedMemory(const SharedMemory::OpenParamete
       const bool allowRemoteWrite = (params.remoteMode == SharedMemory::RemoteMode_ReadWrite);
 
       // Attempt to create a shared memory map
-      retval =
-          AttemptCreateSharedMemory(fileName, params.minSizeBytes, openReadOnly, allowRemoteWrite);
+      retval = AttemptCreateSharedMemory(
+          fileName, params.minSizeBytes, openReadOnly, allowRemoteWrite, params);
 
       // If successful,
       if (retval) {
@@ -429,8 +541,65 @@ class SharedMemoryInternal : public SharedMemoryInternalBase {
   }
 };
 
-static SharedMemoryInternal*
-DoFileMap(int hFileMapping, const char* fileName, bool openReadOnly, int minSize) {
+static void ApplyMapOptions(
+    void* pFileView,
+    int minSize,
+    const SharedMemory::OpenParameters& params,
+    const char* fileName) {
+#if defined(MADV_HUGEPAGE)
+  // Only takes effect if shared memory huge pages are enabled, in
+  // /sys/kernel/mm/transparent_hugepage/shmem_enabled.
+  if ((params.mapFlags & SharedMemory::MapFlag_LargePages) &&
+      (madvise(pFileView, minSize, MADV_HUGEPAGE) < 0)) {
+    Logger.LogDebugF(
+        "WARNING: Unable to use huge pages for %s error code = %d", fileName, errno);
+  }
+#endif
+
+#if defined(OVR_OS_LINUX)
+  // Applies to pages first faulted in through this view, so it has to come before prefaulting.
+  static const int MaxNumaNodes = 1024;
+  if ((params.numaNode >= 0) && (params.numaNode < MaxNumaNodes)) {
+    const int bitsPerWord = (int)sizeof(unsigned long) * 8;
+    unsigned long nodeMask[MaxNumaNodes / (sizeof(unsigned long) * 8)] = {};
+    nodeMask[params.numaNode / bitsPerWord] = 1ul << (params.numaNode % bitsPerWord);
+
+    const long result = syscall(
+        SYS_mbind,
+        pFileView,
+        (unsigned long)minSize,
+        MPOL_PREFERRED,
+        nodeMask,
+        (unsigned long)MaxNumaNodes + 1,
+        0);
+    if (result < 0) {
+      Logger.LogDebugF(
+          "WARNING: Unable to bind %s to NUMA node %d error code = %d",
+          fileName,
+          params.numaNode,
+          errno);
+    }
+  }
+#endif
+
+  // Prefault first, so that a lock doesn't have to fault the pages in one at a time.
+  if (params.mapFlags & (SharedMemory::MapFlag_Prefault | SharedMemory::MapFlag_Lock))
+    PrefaultView(pFileView, (size_t)minSize, (size_t)sysconf(_SC_PAGESIZE));
+
+  if ((params.mapFlags & SharedMemory::MapFlag_Lock) && (mlock(pFileView, minSize) < 0)) {
+    Logger.LogDebugF(
+        "WARNING: Unable to lock view of file for %s error code = %d", fileName, errno);
+  }
+
+  OVR_UNUSED(fileName);
+}
+
+static SharedMemoryInternal* DoFileMap(
+    int hFileMapping,
+    const char* fileName,
+    bool openReadOnly,
+    int minSize,
+    const SharedMemory::OpenParameters& params) {
   // Calculate the required flags based on read/write mode
   int prot = openReadOnly ? PROT_READ : (PROT_READ | PROT_WRITE);
 
@@ -445,6 +614,8 @@ DoFileMap(int hFileMapping, const char* fileName, bool openReadOnly, int minSize
     return NULL;
   }
 
+  ApplyMapOptions(pFileView, minSize, params, fileName);
+
   // Create internal representation
   SharedMemoryInternal* pimple = new SharedMemoryInternal(hFileMapping, pFileView, minSize);
 
@@ -460,8 +631,11 @@ DoFileMap(int hFileMapping, const char* fileName, bool openReadOnly, int minSize
   return pimple;
 }
 
-static SharedMemoryInternal*
-AttemptOpenSharedMemory(const char* fileName, int minSize, bool openReadOnly) {
+static SharedMemoryInternal* AttemptOpenSharedMemory(
+    const char* fileName,
+    int minSize,
+    bool openReadOnly,
+    const SharedMemory::OpenParameters& params) {
   // Calculate permissions and flags based on read/write mode
   int flags = openReadOnly ? O_RDONLY : O_RDWR;
   int perms = openReadOnly ? S_IRUSR : (S_IRUSR | S_IWUSR);
@@ -479,14 +653,15 @@ AttemptOpenSharedMemory(const char* fileName, int minSize, bool openReadOnly) {
   }
 
   // Map the file
-  return DoFileMap(hFileMapping, fileName, openReadOnly, minSize);
+  return DoFileMap(hFileMapping, fileName, openReadOnly, minSize, params);
 }
 
 static SharedMemoryInternal* AttemptCreateSharedMemory(
     const char* fileName,
     int minSize,
     bool openReadOnly,
-    bool allowRemoteWrite) {
+    bool allowRemoteWrite,
+    const SharedMemory::OpenParameters& params) {
   // Create mode
   // Note: Cannot create the shared memory file read-only because then ftruncate() will fail.
   int flags = O_CREAT | O_RDWR;
@@ -527,7 +702,7 @@ static SharedMemoryInternal* AttemptCreateSharedMemory(
   }
 
   // Map the file
-  return DoFileMap(hFileMapping, fileName, openReadOnly, minSize);
+  return DoFileMap(hFileMapping, fileName, openReadOnly, minSize, params);
 }
 
 static SharedMemoryInternal* CreateSharedMemory(const SharedMemory::OpenParameters& params) {
@@ -547,7 +722,7 @@ static SharedMemoryInternal* CreateSharedMemory(const SharedMemory::OpenParamete
     // If opening should be attempted first,
     if (params.openMode != SharedMemory::OpenMode_CreateOnly) {
       // Attempt to open a shared memory map
-      retval = AttemptOpenSharedMemory(fileName, params.minSizeBytes, openReadOnly);
+      retval = AttemptOpenSharedMemory(fileName, params.minSizeBytes, openReadOnly, params);
 
       // If successful,
       if (retval) {
@@ -562,8 +737,8 @@ static SharedMemoryInternal* CreateSharedMemory(const SharedMemory::OpenParamete
       const bool allowRemoteWrite = (params.remoteMode == SharedMemory::RemoteMode_ReadWrite);
 
       // Attempt to create a shared memory map
-      retval =
-          AttemptCreateSharedMemory(fileName, params.minSizeBytes, openReadOnly, allowRemoteWrite);
+      retval = AttemptCreateSharedMemory(
+          fileName, params.minSizeBytes, openReadOnly, allowRemoteWrite, params);
 
       // If successful,
       if (retval) {
@@ -71,6 +71,21 @@ class SharedMemory : public RefCountBase<SharedMemory> {
     RemoteMode_ReadWrite // Other processes can open in read-write mode
   };
 
+  // Options for how the region is backed and mapped into this process. Each is best effort:
+  // one which the OS or the account doesn't allow is skipped and logged, and the region is
+  // opened anyway.
+  enum MapFlags {
+    MapFlag_None = 0,
+    // Back the region with large pages. On Windows this applies when creating the region, and
+    // needs SeLockMemoryPrivilege; on Linux it asks for transparent huge pages.
+    MapFlag_LargePages = 1,
+    // Fault in every page of this process's view up front, so that the first access to any
+    // part of the region doesn't page fault.
+    MapFlag_Prefault = 2,
+    // Lock this process's view into physical memory, so it's never paged out.
+    MapFlag_Lock = 4
+  };
+
   // Modes for opening a new shared memory region
   struct OpenParameters {
     OpenParameters()
@@ -78,7 +93,9 @@ class SharedMemory : public RefCountBase<SharedMemory> {
           minSizeBytes(0),
           openMode(SharedMemory::OpenMode_CreateOrOpen),
           remoteMode(SharedMemory::RemoteMode_ReadWrite),
-          accessMode(SharedMemory::AccessMode_ReadWrite) {}
+          accessMode(SharedMemory::AccessMode_ReadWrite),
+          mapFlags(SharedMemory::MapFlag_None),
+          numaNode(-1) {}
 
     // Creation parameters
     const char* globalName; // Name of the shared memory region
@@ -87,6 +104,10 @@ class SharedMemory : public RefCountBase<SharedMemory> {
     SharedMemory::RemoteMode remoteMode; // When creating, what access should other processes get?
     SharedMemory::AccessMode
         accessMode; // When opening/creating, what access should this process get?
+
+    // Mapping options
+    unsigned mapFlags; // Combination of SharedMemory::MapFlags
+    int numaNode; // Preferred NUMA node for the region's memory, or -1 for the default
   };
 
  public:
@@ -146,7 +167,7 @@ class ISharedObject : public RefCountBase<ISharedObject<SharedType>> {
  protected:
   Ptr<SharedMemory> pSharedMemory;
 
-  bool Open(const char* name, bool readOnly) {
+  bool Open(const char* name, bool readOnly, unsigned mapFlags = SharedMemory::MapFlag_None) {
     // Configure open parameters based on read-only mode
     SharedMemory::OpenParameters params;
 
@@ -163,6 +184,7 @@ class ISharedObject : public RefCountBase<ISharedObject<SharedType>> {
     params.minSizeBytes = RegionSize;
     params.openMode =
         readOnly ? SharedMemory::OpenMode_OpenOnly : SharedMemory::OpenMode_CreateOrOpen;
+    params.mapFlags = mapFlags;
 
     // Attempt to open the shared memory file
     pSharedMemory = SharedMemoryFactory::GetInstance()->Open(params);
@@ -204,8 +226,8 @@ class ISharedObject : public RefCountBase<ISharedObject<SharedType>> {
 template <class SharedType>
 class SharedObjectWriter : public ISharedObject<SharedType> {
  public:
-  OVR_FORCE_INLINE bool Open(const char* name) {
-    return ISharedObject<SharedType>::Open(name, false);
+  OVR_FORCE_INLINE bool Open(const char* name, unsigned mapFlags = SharedMemory::MapFlag_None) {
+    return ISharedObject<SharedType>::Open(name, false, mapFlags);
   }
   OVR_FORCE_INLINE SharedType* Get() {
     return ISharedObject<SharedType>::Get();
@@ -216,8 +238,8 @@ class SharedObjectWriter : public ISharedObject<SharedType> {
 template <class SharedType>
 class SharedObjectReader : public ISharedObject<SharedType> {
  public:
-  OVR_FORCE_INLINE bool Open(const char* name) {
-    return ISharedObject<SharedType>::Open(name, true);
+  OVR_FORCE_INLINE bool Open(const char* name, unsigned mapFlags = SharedMemory::MapFlag_None) {
+    return ISharedObject<SharedType>::Open(name, true, mapFlags);
   }
   OVR_FORCE_INLINE const SharedType* Get() const {
     return ISharedObject<SharedType>::Get();
@@ -0,0 +1,485 @@
+/************************************************************************************
+
+Filename    :   OVR_SharedRing.cpp
+Content     :   Cross-process shared memory ring of fixed-size records
+Created     :   October 14, 2026
+Notes       :
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR_SharedRing.h"
+#include "OVR_Alg.h"
+
+#if defined(OVR_OS_MS)
+#include "OVR_Win32_IncludeWindows.h"
+#include "OVR_UTF8Util.h"
+#else
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#if defined(OVR_OS_LINUX)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
+#endif
+
+#include <chrono>
+#include <limits.h>
+#include <string.h>
+#include <thread>
+
+namespace OVR {
+
+OVR_COMPILER_ASSERT(sizeof(SharedRingHeader) == 64);
+OVR_COMPILER_ASSERT(sizeof(SharedRingReaderSlot) == 64);
+
+static const size_t SharedRingTableSize =
+    sizeof(SharedRingHeader) + (SharedRingMaxReaders * sizeof(SharedRingReaderSlot));
+
+static uint32_t RoundUpPow2(uint32_t value) {
+  uint32_t result = 1;
+  while (result < value)
+    result <<= 1;
+  return result;
+}
+
+static uint32_t GetSlotStride(uint32_t recordSize) {
+  // The generation, then the record padded so the next generation is 8 byte aligned.
+  return (uint32_t)sizeof(uint64_t) + ((recordSize + 7) & ~7u);
+}
+
+static bool GetRingSize(uint32_t slotCount, uint32_t slotStride, int& size) {
+  const uint64_t size64 = SharedRingTableSize + ((uint64_t)slotCount * slotStride);
+  if (size64 > (uint64_t)INT_MAX)
+    return false;
+  size = (int)size64;
+  return true;
+}
+
+static uint32_t GetCurrentProcessIdU32() {
+#if defined(OVR_OS_MS)
+  return (uint32_t)::GetCurrentProcessId();
+#else
+  return (uint32_t)::getpid();
+#endif
+}
+
+// Used to take over the reader slots of processes which exited without closing their reader.
+static bool IsProcessAlive(uint32_t processId) {
+#if defined(OVR_OS_MS)
+  HANDLE hProcess = ::OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
+  if (!hProcess)
+    return (::GetLastError() != ERROR_INVALID_PARAMETER);
+
+  DWORD exitCode = 0;
+  const BOOL result = ::GetExitCodeProcess(hProcess, &exitCode);
+  ::CloseHandle(hProcess);
+  return !result || (exitCode == STILL_ACTIVE);
+#else
+  return (::kill((pid_t)processId, 0) == 0) || (errno == EPERM);
+#endif
+}
+
+#if defined(OVR_OS_MS)
+static String GetReaderEventName(const String& ringName, int readerIndex) {
+  char suffix[24];
+  snprintf(suffix, sizeof(suffix), ".Reader%d", readerIndex);
+  return ringName + suffix;
+}
+#endif
+
+//-----------------------------------------------------------------------------------
+// ***** SharedRingWriterBase
+
+SharedRingWriterBase::SharedRingWriterBase()
+    : pSharedMemory(), Name(), Header(nullptr), Readers(nullptr), Slots(nullptr) {
+  memset(ReaderEvents, 0, sizeof(ReaderEvents));
+}
+
+SharedRingWriterBase::~SharedRingWriterBase() {
+  Close();
+}
+
+bool SharedRingWriterBase::Open(const char* name, unsigned slotCount, uint32_t recordSize) {
+  Close();
+
+  slotCount = RoundUpPow2(Alg::Max(slotCount, 2u));
+  const uint32_t slotStride = GetSlotStride(recordSize);
+
+  // Readers claim slots and publish their cursors, so they need write access too.
+  SharedMemory::OpenParameters params;
+  params.globalName = name;
+  params.openMode = SharedMemory::OpenMode_CreateOrOpen;
+  params.remoteMode = SharedMemory::RemoteMode_ReadWrite;
+  params.accessMode = SharedMemory::AccessMode_ReadWrite;
+  if (!GetRingSize(slotCount, slotStride, params.minSizeBytes))
+    return false;
+
+  Ptr<SharedMemory> sharedMemory = SharedMemoryFactory::GetInstance()->Open(params);
+  if (!sharedMemory || !sharedMemory->GetData() ||
+      sharedMemory->GetSizeI() < params.minSizeBytes)
+    return false;
+
+  SharedRingHeader* header = (SharedRingHeader*)sharedMemory->GetData();
+
+  // A ring left by a previous run of the writer keeps going if it has the same layout, so that
+  // its readers see one continuous sequence.
+  if ((header->Magic != SharedRingMagic) || (header->Version != SharedRingVersion) ||
+      (header->SlotCount != slotCount) || (header->RecordSize != recordSize) ||
+      (header->SlotStride != slotStride)) {
+    header->Magic = 0;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    const size_t clearSize = (size_t)params.minSizeBytes - sizeof(SharedRingHeader);
+    memset((uint8_t*)header + sizeof(SharedRingHeader), 0, clearSize);
+    header->Version = SharedRingVersion;
+    header->SlotCount = slotCount;
+    header->RecordSize = recordSize;
+    header->SlotStride = slotStride;
+    header->NotifyCount.store(0, std::memory_order_relaxed);
+    header->WriteCount.store(0, std::memory_order_relaxed);
+
+    // Readers check Magic first, so it's published last.
+    std::atomic_thread_fence(std::memory_order_release);
+    header->Magic = SharedRingMagic;
+  }
+
+  pSharedMemory = sharedMemory;
+  Name = name;
+  Header = header;
+  Readers = (SharedRingReaderSlot*)(header + 1);
+  Slots = (uint8_t*)header + SharedRingTableSize;
+  return true;
+}
+
+void SharedRingWriterBase::Close() {
+#if defined(OVR_OS_MS)
+  for (int i = 0; i < SharedRingMaxReaders; ++i) {
+    if (ReaderEvents[i])
+      ::CloseHandle((HANDLE)ReaderEvents[i]);
+  }
+#endif
+  memset(ReaderEvents, 0, sizeof(ReaderEvents));
+
+  Header = nullptr;
+  Readers = nullptr;
+  Slots = nullptr;
+  pSharedMemory.Clear();
+}
+
+int SharedRingWriterBase::GetReaderCount() const {
+  int count = 0;
+
+  if (Readers) {
+    for (int i = 0; i < SharedRingMaxReaders; ++i) {
+      if (Readers[i].ProcessId.load(std::memory_order_relaxed))
+        ++count;
+    }
+  }
+
+  return count;
+}
+
+uint64_t SharedRingWriterBase::GetSlowestReaderCursor() const {
+  uint64_t slowest = GetWriteCount();
+
+  if (Readers) {
+    for (int i = 0; i < SharedRingMaxReaders; ++i) {
+      if (Readers[i].ProcessId.load(std::memory_order_relaxed))
+        slowest = Alg::Min(slowest, Readers[i].Cursor.load(std::memory_order_relaxed));
+    }
+  }
+
+  return slowest;
+}
+
+void SharedRingWriterBase::Publish(const void* record) {
+  if (!Header)
+    return;
+
+  const uint64_t sequence = Header->WriteCount.load(std::memory_order_relaxed);
+  uint8_t* slot = Slots + (size_t)(sequence & (Header->SlotCount - 1)) * Header->SlotStride;
+  std::atomic<uint64_t>* generation = (std::atomic<uint64_t>*)slot;
+
+  generation->store((sequence * 2) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  memcpy(slot + sizeof(uint64_t), record, Header->RecordSize);
+
+  generation->store((sequence * 2) + 2, std::memory_order_release);
+  Header->WriteCount.store(sequence + 1, std::memory_order_release);
+
+  notifyReaders();
+}
+
+void SharedRingWriterBase::notifyReaders() {
+  // Pairs with the Waiting store in SharedRingReaderBase::Wait: either the reader sees the new
+  // WriteCount before it sleeps, or we see it waiting and wake it.
+  Header->NotifyCount.fetch_add(1, std::memory_order_seq_cst);
+
+#if defined(OVR_OS_LINUX)
+  for (int i = 0; i < SharedRingMaxReaders; ++i) {
+    if (Readers[i].Waiting.load(std::memory_order_seq_cst)) {
+      ::syscall(SYS_futex, &Header->NotifyCount, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+      break;
+    }
+  }
+#elif defined(OVR_OS_MS)
+  for (int i = 0; i < SharedRingMaxReaders; ++i) {
+    if (!Readers[i].Waiting.load(std::memory_order_seq_cst))
+      continue;
+
+    if (!ReaderEvents[i]) {
+      std::wstring eventName = UTF8StringToUCSString(GetReaderEventName(Name, i));
+      ReaderEvents[i] = ::OpenEventW(EVENT_MODIFY_STATE, FALSE, eventName.c_str());
+    }
+    if (ReaderEvents[i])
+      ::SetEvent((HANDLE)ReaderEvents[i]);
+  }
+#endif
+}
+
+//-----------------------------------------------------------------------------------
+// ***** SharedRingReaderBase
+
+SharedRingReaderBase::SharedRingReaderBase()
+    : pSharedMemory(),
+      Header(nullptr),
+      ReaderSlot(nullptr),
+      Slots(nullptr),
+      SlotCount(0),
+      SlotStride(0),
+      RecordSize(0),
+      NextSequence(0),
+      LostCount(0),
+      hEvent(nullptr) {}
+
+SharedRingReaderBase::~SharedRingReaderBase() {
+  Close();
+}
+
+bool SharedRingReaderBase::Open(const char* name, uint32_t recordSize, bool fromOldest) {
+  Close();
+
+  SharedMemory::OpenParameters params;
+  params.globalName = name;
+  params.openMode = SharedMemory::OpenMode_OpenOnly;
+  params.remoteMode = SharedMemory::RemoteMode_ReadWrite;
+  params.accessMode = SharedMemory::AccessMode_ReadWrite;
+  params.minSizeBytes = (int)SharedRingTableSize;
+
+  Ptr<SharedMemory> sharedMemory = SharedMemoryFactory::GetInstance()->Open(params);
+  if (!sharedMemory || !sharedMemory->GetData() ||
+      sharedMemory->GetSizeI() < (int)SharedRingTableSize)
+    return false;
+
+  const SharedRingHeader* header = (const SharedRingHeader*)sharedMemory->GetData();
+  if (header->Magic != SharedRingMagic)
+    return false;
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  int size;
+  if ((header->Version != SharedRingVersion) || (header->SlotCount < 2) ||
+      ((header->SlotCount & (header->SlotCount - 1)) != 0) || (header->RecordSize != recordSize) ||
+      (header->SlotStride != GetSlotStride(recordSize)) ||
+      !GetRingSize(header->SlotCount, header->SlotStride, size) ||
+      (sharedMemory->GetSizeI() < size))
+    return false;
+
+  pSharedMemory = sharedMemory;
+  Header = header;
+  Slots = (const uint8_t*)header + SharedRingTableSize;
+  SlotCount = header->SlotCount;
+  SlotStride = header->SlotStride;
+  RecordSize = recordSize;
+  LostCount = 0;
+
+  const uint64_t writeCount = Header->WriteCount.load(std::memory_order_acquire);
+  if (!fromOldest)
+    NextSequence = writeCount;
+  else
+    NextSequence = (writeCount > SlotCount) ? (writeCount - SlotCount) : 0;
+
+  if (!claimReaderSlot(name)) {
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+bool SharedRingReaderBase::claimReaderSlot(const char* name) {
+  SharedRingReaderSlot* readers = (SharedRingReaderSlot*)(Header + 1);
+  const uint32_t processId = GetCurrentProcessIdU32();
+
+  // Take a free slot if there is one, and otherwise one left behind by a process which exited.
+  int index = -1;
+  for (int pass = 0; (pass < 2) && (index < 0); ++pass) {
+    for (int i = 0; i < SharedRingMaxReaders; ++i) {
+      uint32_t owner = readers[i].ProcessId.load(std::memory_order_relaxed);
+      if ((pass == 0) ? (owner != 0) : ((owner == 0) || IsProcessAlive(owner)))
+        continue;
+      if (readers[i].ProcessId.compare_exchange_strong(owner, processId)) {
+        index = i;
+        break;
+      }
+    }
+  }
+
+  if (index < 0)
+    return false;
+
+  ReaderSlot = &readers[index];
+  ReaderSlot->Waiting.store(0, std::memory_order_relaxed);
+  ReaderSlot->Cursor.store(NextSequence, std::memory_order_relaxed);
+  ReaderSlot->LostCount.store(0, std::memory_order_relaxed);
+
+#if defined(OVR_OS_MS)
+  // Auto-reset, so that each wakeup is consumed by the Wait it woke.
+  std::wstring eventName = UTF8StringToUCSString(GetReaderEventName(name, index));
+  hEvent = ::CreateEventW(nullptr, FALSE, FALSE, eventName.c_str());
+
+#else
+  OVR_UNUSED(name);
+#endif
+
+  return true;
+}
+
+void SharedRingReaderBase::Close() {
+#if defined(OVR_OS_MS)
+  if (hEvent)
+    ::CloseHandle((HANDLE)hEvent);
+#endif
+  hEvent = nullptr;
+
+  if (ReaderSlot) {
+    ReaderSlot->Waiting.store(0, std::memory_order_relaxed);
+    ReaderSlot->ProcessId.store(0, std::memory_order_release);
+    ReaderSlot = nullptr;
+  }
+
+  Header = nullptr;
+  Slots = nullptr;
+  pSharedMemory.Clear();
+}
+
+bool SharedRingReaderBase::copyRecord(uint64_t sequence, void* record) const {
+  const uint8_t* slot = Slots + (size_t)(sequence & (SlotCount - 1)) * SlotStride;
+  const std::atomic<uint64_t>* generation = (const std::atomic<uint64_t>*)slot;
+  const uint64_t complete = (sequence * 2) + 2;
+
+  if (generation->load(std::memory_order_acquire) != complete)
+    return false;
+
+  memcpy(record, slot + sizeof(uint64_t), RecordSize);
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  return (generation->load(std::memory_order_relaxed) == complete);
+}
+
+bool SharedRingReaderBase::Read(void* record) {
+  if (!Header)
+    return false;
+
+  for (;;) {
+    const uint64_t writeCount = Header->WriteCount.load(std::memory_order_acquire);
+    if (NextSequence >= writeCount)
+      return false;
+
+    // Skip records which have been overwritten already.
+    if ((writeCount - NextSequence) > SlotCount) {
+      LostCount += (writeCount - SlotCount) - NextSequence;
+      NextSequence = writeCount - SlotCount;
+    }
+
+    const bool copied = copyRecord(NextSequence, record);
+
+    // If the copy failed the slot was taken for a later record while we looked at it, so this
+    // one is lost.
+    if (!copied)
+      ++LostCount;
+    ++NextSequence;
+
+    ReaderSlot->Cursor.store(NextSequence, std::memory_order_relaxed);
+    ReaderSlot->LostCount.store(LostCount, std::memory_order_relaxed);
+
+    if (copied)
+      return true;
+  }
+}
+
+bool SharedRingReaderBase::ReadLatest(void* record) {
+  if (!Header)
+    return false;
+
+  for (;;) {
+    const uint64_t writeCount = Header->WriteCount.load(std::memory_order_acquire);
+    if (NextSequence >= writeCount)
+      return false;
+
+    // The newest record can only fail to copy if the writer has lapped us, so just try again.
+    if (copyRecord(writeCount - 1, record)) {
+      NextSequence = writeCount;
+      ReaderSlot->Cursor.store(NextSequence, std::memory_order_relaxed);
+      return true;
+    }
+  }
+}
+
+bool SharedRingReaderBase::Wait(unsigned timeoutMs) {
+  if (!Header)
+    return false;
+  if (HasNew())
+    return true;
+
+  // See SharedRingWriterBase::notifyReaders for the ordering.
+  ReaderSlot->Waiting.store(1, std::memory_order_seq_cst);
+  const uint32_t notifyCount = Header->NotifyCount.load(std::memory_order_seq_cst);
+
+  if (!HasNew()) {
+#if defined(OVR_OS_LINUX)
+    struct timespec timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_nsec = (long)(timeoutMs % 1000) * 1000000;
+    ::syscall(
+        SYS_futex, &Header->NotifyCount, FUTEX_WAIT, notifyCount, &timeout, nullptr, 0);
+#elif defined(OVR_OS_MS)
+    OVR_UNUSED(notifyCount);
+    if (hEvent)
+      ::WaitForSingleObject((HANDLE)hEvent, timeoutMs);
+    else
+      ::Sleep(Alg::Min(timeoutMs, 1u));
+#else
+    // No cross-process wait primitive here, so poll.
+    OVR_UNUSED(notifyCount);
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (!HasNew() && (std::chrono::steady_clock::now() < deadline))
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+  }
+
+  ReaderSlot->Waiting.store(0, std::memory_order_relaxed);
+  return HasNew();
+}
+
+} // namespace OVR
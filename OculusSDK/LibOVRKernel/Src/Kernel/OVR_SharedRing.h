@@ -0,0 +1,260 @@
+/************************************************************************************
+
+Filename    :   OVR_SharedRing.h
+Content     :   Cross-process shared memory ring of fixed-size records
+Created     :   October 14, 2026
+Notes       :
+    A SharedRing is a named shared memory region holding the last SlotCount records of type T
+    published by a single writer process, for any number of local readers (up to
+    SharedRingMaxReaders at once). It is meant for state which is published continuously, such
+    as headset pose or treadmill state, where a reader wants either every record or just the
+    latest one, and a socket round-trip per record is too slow.
+
+    The writer never waits on readers: once the ring is full each new record overwrites the
+    oldest, and a reader which falls behind skips what it missed and counts it. Records are
+    guarded by a generation counter per slot as in SharedLogRing, so a reader never returns a
+    torn record.
+
+    Each reader holds a slot in the region's reader table, with its cursor (the next sequence it
+    will read) so that the writer can see who is listening and how far behind they are. A reader
+    can block in Wait for the next record, which costs the writer nothing while nobody waits.
+    Readers are woken through a named event per reader slot on Windows and a futex on Linux;
+    elsewhere Wait polls.
+
+    In the publisher:
+
+        SharedRingWriter<TreadmillState> writer;
+        writer.Open("BotsimuTreadmill");
+        ...
+        writer.Publish(state);
+
+    and in a consumer:
+
+        SharedRingReader<TreadmillState> reader;
+        if (reader.Open("BotsimuTreadmill")) {
+          TreadmillState state;
+          while (reader.Wait(100)) {
+            while (reader.Read(state))
+              Consume(state);
+          }
+        }
+
+    The layout is described by the structs below and doesn't depend on the process, so readers
+    written in other languages can map the region directly. T itself must have the same layout
+    in every process which maps the ring: use fixed-size fields, and no pointers.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_SharedRing_h
+#define OVR_SharedRing_h
+
+#include "OVR_Types.h"
+#include "OVR_Atomic.h"
+#include "OVR_SharedMemory.h"
+
+#include <type_traits>
+
+namespace OVR {
+
+//-----------------------------------------------------------------------------------
+// ***** SharedRing layout
+//
+// The region is a SharedRingHeader, then SharedRingMaxReaders SharedRingReaderSlots, then
+// SlotCount record slots of SlotStride bytes. Each record slot is a 64-bit generation, which is
+// 2 * n + 1 while record n is being written and 2 * n + 2 once it is complete, followed by the
+// record itself.
+
+static const uint32_t SharedRingMagic = 0x474E5253; // "SRNG"
+static const uint32_t SharedRingVersion = 1;
+static const int SharedRingMaxReaders = 16;
+
+struct SharedRingHeader {
+  uint32_t Magic; // SharedRingMagic once the ring is initialized
+  uint32_t Version; // SharedRingVersion
+  uint32_t SlotCount; // A power of two
+  uint32_t RecordSize; // sizeof(T)
+  uint32_t SlotStride; // Bytes per record slot, including its generation
+  std::atomic<uint32_t> NotifyCount; // Incremented after each record; the Linux futex word
+  std::atomic<uint64_t> WriteCount; // Number of records published so far
+  uint8_t Padding[32];
+};
+
+struct SharedRingReaderSlot {
+  std::atomic<uint32_t> ProcessId; // Process holding the slot, or 0 if it's free
+  std::atomic<uint32_t> Waiting; // Nonzero while the reader is blocked in Wait
+  std::atomic<uint64_t> Cursor; // Sequence of the next record the reader will read
+  std::atomic<uint64_t> LostCount; // Records the reader missed because it fell behind
+  uint8_t Padding[40];
+};
+
+//-----------------------------------------------------------------------------------
+// ***** SharedRingWriterBase
+//
+// The untyped part of SharedRingWriter.
+//
+class SharedRingWriterBase {
+  OVR_NON_COPYABLE(SharedRingWriterBase)
+
+ public:
+  SharedRingWriterBase();
+  ~SharedRingWriterBase();
+
+  void Close();
+
+  bool IsOpen() const {
+    return Header != nullptr;
+  }
+
+  // Sequence the next record will get.
+  uint64_t GetWriteCount() const {
+    return Header ? Header->WriteCount.load(std::memory_order_relaxed) : 0;
+  }
+
+  // Number of readers currently holding a reader slot.
+  int GetReaderCount() const;
+
+  // The smallest cursor among the current readers, or GetWriteCount if there are none. A value
+  // more than SlotCount behind GetWriteCount means a reader is losing records.
+  uint64_t GetSlowestReaderCursor() const;
+
+ protected:
+  bool Open(const char* name, unsigned slotCount, uint32_t recordSize);
+  void Publish(const void* record);
+  void notifyReaders();
+
+  Ptr<SharedMemory> pSharedMemory;
+  String Name;
+  SharedRingHeader* Header;
+  SharedRingReaderSlot* Readers;
+  uint8_t* Slots;
+  void* ReaderEvents[SharedRingMaxReaders]; // Windows only, opened on first use.
+};
+
+//-----------------------------------------------------------------------------------
+// ***** SharedRingReaderBase
+//
+// The untyped part of SharedRingReader.
+//
+class SharedRingReaderBase {
+  OVR_NON_COPYABLE(SharedRingReaderBase)
+
+ public:
+  SharedRingReaderBase();
+  ~SharedRingReaderBase();
+
+  void Close();
+
+  bool IsOpen() const {
+    return Header != nullptr;
+  }
+
+  // True if there is a record which hasn't been read yet.
+  bool HasNew() const {
+    return Header && (NextSequence < Header->WriteCount.load(std::memory_order_acquire));
+  }
+
+  // Blocks until there is a record which hasn't been read yet, or timeoutMs have passed.
+  // Returns HasNew.
+  bool Wait(unsigned timeoutMs);
+
+  uint64_t GetNextSequence() const {
+    return NextSequence;
+  }
+
+  // Records which were overwritten before they could be read. Records passed over by
+  // ReadLatest aren't counted.
+  uint64_t GetLostCount() const {
+    return LostCount;
+  }
+
+ protected:
+  bool Open(const char* name, uint32_t recordSize, bool fromOldest);
+  bool Read(void* record);
+  bool ReadLatest(void* record);
+  bool copyRecord(uint64_t sequence, void* record) const;
+  bool claimReaderSlot(const char* name);
+
+  Ptr<SharedMemory> pSharedMemory;
+  const SharedRingHeader* Header;
+  SharedRingReaderSlot* ReaderSlot;
+  const uint8_t* Slots;
+  uint32_t SlotCount;
+  uint32_t SlotStride;
+  uint32_t RecordSize;
+  uint64_t NextSequence;
+  uint64_t LostCount;
+  void* hEvent; // Windows only, signaled by the writer while Waiting is set.
+};
+
+//-----------------------------------------------------------------------------------
+// ***** SharedRingWriter
+//
+// Publishes records of type T into a ring, creating the region if it doesn't exist yet. There
+// must be only one writer for a ring at a time.
+//
+template <class T>
+class SharedRingWriter : public SharedRingWriterBase {
+  static_assert(std::is_trivially_copyable<T>::value, "SharedRing records are copied bytewise");
+
+ public:
+  // slotCount is rounded up to a power of two. If the ring already exists with the same
+  // geometry its records, sequence numbers and readers are kept, otherwise it is reset.
+  bool Open(const char* name, unsigned slotCount = 64) {
+    return SharedRingWriterBase::Open(name, slotCount, (uint32_t)sizeof(T));
+  }
+
+  void Publish(const T& record) {
+    SharedRingWriterBase::Publish(&record);
+  }
+};
+
+//-----------------------------------------------------------------------------------
+// ***** SharedRingReader
+//
+// Reads records of type T from a ring created by a SharedRingWriter<T>. Not thread safe; use
+// one reader per thread.
+//
+template <class T>
+class SharedRingReader : public SharedRingReaderBase {
+  static_assert(std::is_trivially_copyable<T>::value, "SharedRing records are copied bytewise");
+
+ public:
+  // Fails if the ring doesn't exist, hasn't been initialized by a writer, holds records of a
+  // different size, or has no free reader slot. When fromOldest is true reading starts at the
+  // oldest record still in the ring, otherwise at the next new one.
+  bool Open(const char* name, bool fromOldest = false) {
+    return SharedRingReaderBase::Open(name, (uint32_t)sizeof(T), fromOldest);
+  }
+
+  // Copies out the next record in sequence. Returns false if there are no new records yet.
+  bool Read(T& record) {
+    return SharedRingReaderBase::Read(&record);
+  }
+
+  // Copies out the newest record, passing over any older unread ones. Returns false if there
+  // are no new records yet.
+  bool ReadLatest(T& record) {
+    return SharedRingReaderBase::ReadLatest(&record);
+  }
+};
+
+} // namespace OVR
+
+#endif // OVR_SharedRing_h
@@ -30,6 +30,13 @@ limitations under the License.
 // localeconv() call in OVR_strtod()
 #include <locale.h>
 
+#if defined(__SSE2__) || defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define OVR_STD_SSE2 1
+#include <emmintrin.h>
+#else
+#define OVR_STD_SSE2 0
+#endif
+
 namespace OVR {
 
 // Source for functions not available on all platforms is included here.
@@ -174,32 +181,176 @@ size_t OVR_CDECL OVR_strlcat(wchar_t* dest, const wchar_t* src, size_t destsize)
 }
 
 // Case insensitive compare implemented in platform-specific way.
-int OVR_CDECL OVR_stricmp(const char* a, const char* b) {
-#if defined(OVR_OS_MS)
-#if defined(OVR_CC_MSVC) && (OVR_CC_MSVC >= 1400)
-  return ::_stricmp(a, b);
-#else
-  return ::stricmp(a, b);
+//-----------------------------------------------------------------------------------
+// ***** Case-insensitive compare and hash
+//
+// These fold ASCII only, like OVR_tolower, rather than going through the C runtime's locale
+// aware versions; on Windows _stricmp checks the locale for every call. The compares look at
+// 16 bytes at a time with SSE2, and go a byte at a time where a string may end near a page
+// boundary.
+
+namespace {
+
+inline int CompareLowered(uint8_t a, uint8_t b) {
+  return OVR_tolower(a) - OVR_tolower(b);
+}
+
+#if OVR_STD_SSE2
+
+const size_t CompareBlockSize = 16;
+
+// Folds 'A'-'Z' to lower case: bytes are biased so that 'A' becomes -128, after which the
+// upper case letters are exactly those which compare less than -128 + 26.
+inline __m128i LowerASCII(__m128i bytes) {
+  const __m128i biased = _mm_add_epi8(bytes, _mm_set1_epi8((char)(0x80 - 'A')));
+  const __m128i isUpper = _mm_cmplt_epi8(biased, _mm_set1_epi8((char)(-128 + 26)));
+  return _mm_or_si128(bytes, _mm_and_si128(isUpper, _mm_set1_epi8(0x20)));
+}
+
+// Returns a bit per byte which differs after folding, or is a terminator when stopAtNull.
+inline unsigned CompareBlock(const char* a, const char* b, bool stopAtNull) {
+  const __m128i bytesA = _mm_loadu_si128((const __m128i*)a);
+  const __m128i bytesB = _mm_loadu_si128((const __m128i*)b);
+  unsigned mask =
+      (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(LowerASCII(bytesA), LowerASCII(bytesB))) ^ 0xFFFF;
+  if (stopAtNull)
+    mask |= (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(bytesA, _mm_setzero_si128()));
+  return mask;
+}
+
+// True if a 16 byte load at p can't run into the next page, where a load past the end of a
+// null-terminated string could fault.
+inline bool BlockInPage(const char* p) {
+  return ((uintptr_t)p & 4095) <= (4096 - CompareBlockSize);
+}
+
+#endif // OVR_STD_SSE2
+
+// Compares up to count bytes, stopping early at a terminator when StopAtNull.
+template <bool StopAtNull>
+int CompareNoCase(const char* a, const char* b, size_t count) {
+  size_t i = 0;
+
+#if OVR_STD_SSE2
+  while ((count - i) >= CompareBlockSize) {
+    if (StopAtNull && (!BlockInPage(a + i) || !BlockInPage(b + i))) {
+      // Step a byte at a time until past the page boundary.
+      const size_t end = i + CompareBlockSize;
+      for (; i < end; ++i) {
+        const int diff = CompareLowered((uint8_t)a[i], (uint8_t)b[i]);
+        if (diff || !a[i])
+          return diff;
+      }
+      continue;
+    }
+
+    const unsigned mask = CompareBlock(a + i, b + i, StopAtNull);
+    if (mask) {
+      i += Alg::CountTrailing0Bits((uint32_t)mask);
+      return CompareLowered((uint8_t)a[i], (uint8_t)b[i]);
+    }
+    i += CompareBlockSize;
+  }
 #endif
 
+  for (; i < count; ++i) {
+    const int diff = CompareLowered((uint8_t)a[i], (uint8_t)b[i]);
+    if (diff || (StopAtNull && !a[i]))
+      return diff;
+  }
+
+  return 0;
+}
+
+// Loads up to 8 bytes as a little-endian word, with the missing bytes zero.
+inline uint64_t LoadPartialWord(const uint8_t* p, size_t size) {
+  uint64_t word = 0;
+  for (size_t i = 0; i < size; ++i)
+    word |= (uint64_t)p[i] << (i * 8);
+  return word;
+}
+
+inline uint64_t LoadWord(const uint8_t* p) {
+#if (OVR_BYTE_ORDER == OVR_LITTLE_ENDIAN)
+  uint64_t word;
+  memcpy(&word, p, sizeof(word));
+  return word;
 #else
-  return strcasecmp(a, b);
+  return LoadPartialWord(p, 8);
 #endif
 }
 
-int OVR_CDECL OVR_strnicmp(const char* a, const char* b, size_t count) {
-#if defined(OVR_OS_MS)
-#if defined(OVR_CC_MSVC) && (OVR_CC_MSVC >= 1400)
-  return ::_strnicmp(a, b, count);
+// Folds 'A'-'Z' in each byte of the word to lower case. Bytes with the top bit set are left
+// alone, so UTF-8 sequences aren't changed.
+inline uint64_t LowerWord(uint64_t word) {
+  const uint64_t ones = 0x0101010101010101ull;
+  const uint64_t low7 = word & (0x7F * ones);
+  const uint64_t aboveA = low7 + ((0x80 - 'A') * ones); // Top bit set for bytes >= 'A'
+  const uint64_t aboveZ = low7 + ((0x7F - 'Z') * ones); // Top bit set for bytes > 'Z'
+  const uint64_t isUpper = (aboveA ^ aboveZ) & ~word & (0x80 * ones);
+  return word | (isUpper >> 2);
+}
+
+inline uint64_t MixWord(uint64_t h, uint64_t word) {
+  h ^= word;
+  h *= 0x9E3779B97F4A7C15ull;
+  return h ^ (h >> 29);
+}
+
+} // namespace
+
+// glibc's strcasecmp is already vectorized, and faster than CompareNoCase.
+int OVR_CDECL OVR_stricmp(const char* a, const char* b) {
+#if defined(__GLIBC__)
+  return strcasecmp(a, b);
 #else
-  return ::strnicmp(a, b, count);
+  return CompareNoCase<true>(a, b, (size_t)-1);
 #endif
+}
 
-#else
+int OVR_CDECL OVR_strnicmp(const char* a, const char* b, size_t count) {
+#if defined(__GLIBC__)
   return strncasecmp(a, b, count);
+#else
+  return CompareNoCase<true>(a, b, count);
 #endif
 }
 
+int OVR_CDECL OVR_memicmp(const void* a, const void* b, size_t size) {
+  return CompareNoCase<false>((const char*)a, (const char*)b, size);
+}
+
+size_t OVR_CDECL OVR_memihash(const void* data, size_t size, size_t seed) {
+  const uint8_t* p = (const uint8_t*)data;
+  uint64_t h = (uint64_t)seed ^ ((uint64_t)size * 0xC2B2AE3D27D4EB4Full);
+
+  // Two independent lanes, so that the multiplies of consecutive words overlap.
+  uint64_t h2 = h ^ 0x165667B19E3779F9ull;
+  for (; size >= 16; size -= 16, p += 16) {
+    h = MixWord(h, LowerWord(LoadWord(p)));
+    h2 = MixWord(h2, LowerWord(LoadWord(p + 8)));
+  }
+
+  if (size >= 8) {
+    h = MixWord(h, LowerWord(LoadWord(p)));
+    p += 8;
+    size -= 8;
+  }
+
+  if (size)
+    h2 = MixWord(h2, LowerWord(LoadPartialWord(p, size)));
+
+  // Final avalanche, from MurmurHash3's fmix64, so the low bits used for buckets depend on
+  // every input byte.
+  h ^= h2 * 0xFF51AFD7ED558CCDull;
+  h ^= h >> 33;
+  h *= 0xFF51AFD7ED558CCDull;
+  h ^= h >> 33;
+  h *= 0xC4CEB9FE1A85EC53ull;
+  h ^= h >> 33;
+  return (size_t)h;
+}
+
 wchar_t* OVR_CDECL OVR_wcscpy(wchar_t* dest, size_t destsize, const wchar_t* src) {
 #if defined(OVR_MSVC_SAFESTRING)
   wcscpy_s(dest, destsize, src);
@@ -296,10 +296,19 @@ inline uint64_t OVR_CDECL OVR_atouq(const char* string) {
   return OVR_strtouq(string, NULL, 10);
 }
 
-// Implemented in OVR_Std.cpp in platform-specific manner.
+// Case-insensitive compares, which fold ASCII letters only, as OVR_tolower does. With glibc
+// these are strcasecmp and strncasecmp, which do the same in the C locale.
 int OVR_CDECL OVR_stricmp(const char* dest, const char* src);
 int OVR_CDECL OVR_strnicmp(const char* dest, const char* src, size_t count);
 
+// Like OVR_strnicmp, but compares exactly size bytes and doesn't stop at a null.
+int OVR_CDECL OVR_memicmp(const void* a, const void* b, size_t size);
+
+// Case-insensitive hash of size bytes, folding ASCII letters as OVR_memicmp does, so buffers
+// which compare equal hash equal. Reads 8 bytes at a time; the value isn't stable across
+// versions, so don't persist it.
+size_t OVR_CDECL OVR_memihash(const void* data, size_t size, size_t seed = 0);
+
 // This is like vsprintf but with a destination buffer size argument. However, the behavior is
 // different
 // from vsnprintf in that the return value semantics are like vsprintf (which returns -1 on capacity
@@ -34,6 +34,7 @@ limitations under the License.
 #include "OVR_Atomic.h"
 #include "OVR_Std.h"
 #include "OVR_Alg.h"
+#include <string.h>
 #include <string>
 
 namespace OVR {
@@ -44,6 +45,54 @@ class StringBuffer;
 // Special/default null-terminated length argument
 const size_t StringIsNullTerminated = size_t(-1);
 
+//-----------------------------------------------------------------------------------
+// ***** StringView
+
+// StringView refers to a run of UTF8 bytes owned by something else, so that a string can be
+// passed to a lookup without constructing a String. The bytes needn't be null-terminated, and
+// must outlive the view.
+//
+// Example usage:
+//     Hash<String, int, String::HashFunctor> table;
+//     int* value = table.GetAlt(StringView(name, nameLength)); // No String is allocated.
+
+class StringView {
+ public:
+  StringView() : pData(""), Size(0) {}
+  StringView(const char* str) : pData(str ? str : ""), Size(str ? OVR_strlen(str) : 0) {}
+  StringView(const char* data, size_t size) : pData(data), Size(size) {}
+  StringView(const std::string& str) : pData(str.data()), Size(str.size()) {}
+
+  const char* GetData() const {
+    return pData;
+  }
+
+  // Byte length.
+  size_t GetSize() const {
+    return Size;
+  }
+
+  bool IsEmpty() const {
+    return (Size == 0);
+  }
+
+  bool operator==(const StringView& view) const {
+    return (Size == view.Size) && (memcmp(pData, view.pData, Size) == 0);
+  }
+
+  bool operator!=(const StringView& view) const {
+    return !operator==(view);
+  }
+
+  bool EqualsNoCase(const StringView& view) const {
+    return (Size == view.Size) && (OVR_memicmp(pData, view.pData, Size) == 0);
+  }
+
+ protected:
+  const char* pData;
+  size_t Size;
+};
+
 //-----------------------------------------------------------------------------------
 // ***** String Class
 
@@ -84,6 +133,10 @@ class String : public std::string {
     inherited::assign(src.data(), src.length());
   }
 
+  explicit String(const StringView& view) {
+    inherited::assign(view.GetData(), view.GetSize());
+  }
+
   explicit String(const wchar_t* data) {
     if (data)
       String::operator=(data); // Need to do UCS2->UTF8 conversion
@@ -368,6 +421,14 @@ class String : public std::string {
     return !operator==(str);
   }
 
+  bool operator==(const StringView& view) const {
+    return (StringView(*this) == view);
+  }
+
+  bool operator!=(const StringView& view) const {
+    return !operator==(view);
+  }
+
   bool operator<(const char* pstr) const {
     return OVR_strcmp(inherited::c_str(), (pstr ? pstr : "")) < 0;
   }
@@ -411,33 +472,40 @@ class String : public std::string {
   }
 
   struct NoCaseKey {
-    const String* pStr;
-    NoCaseKey(const String& str) : pStr(&str){};
+    StringView View;
+    NoCaseKey(const StringView& view) : View(view){};
   };
 
   bool operator==(const NoCaseKey& strKey) const {
-    return (CompareNoCase(ToCStr(), strKey.pStr->ToCStr()) == 0);
+    return StringView(*this).EqualsNoCase(strKey.View);
   }
 
   bool operator!=(const NoCaseKey& strKey) const {
-    return !(CompareNoCase(ToCStr(), strKey.pStr->ToCStr()) == 0);
+    return !operator==(strKey);
   }
 
-  // Hash functor used for strings.
+  // Hash functor used for strings. Supports additional lookup based on StringView.
   struct HashFunctor {
     size_t operator()(const String& str) const {
       return String::BernsteinHashFunction(str.data(), str.size());
     }
+    size_t operator()(const StringView& view) const {
+      return String::BernsteinHashFunction(view.GetData(), view.GetSize());
+    }
   };
 
   // Case-insensitive hash functor used for strings. Supports additional
-  // lookup based on NoCaseKey.
+  // lookup based on StringView and NoCaseKey. Uses OVR_memihash, which hashes a word at a time,
+  // rather than BernsteinHashFunctionCIS.
   struct NoCaseHashFunctor {
     size_t operator()(const String& str) const {
-      return String::BernsteinHashFunctionCIS(str.data(), str.size());
+      return OVR_memihash(str.data(), str.size());
+    }
+    size_t operator()(const StringView& view) const {
+      return OVR_memihash(view.GetData(), view.GetSize());
     }
     size_t operator()(const NoCaseKey& key) const {
-      return String::BernsteinHashFunctionCIS(key.pStr->c_str(), key.pStr->size());
+      return OVR_memihash(key.View.GetData(), key.View.GetSize());
     }
   };
 };
@@ -515,9 +583,71 @@ class StringBuffer {
   // Append a string
   void AppendString(const wchar_t* pstr, size_t len = StringIsNullTerminated);
   void AppendString(const char* putf8str, size_t utf8StrSz = StringIsNullTerminated);
+  // Formats as vsnprintf does. The common specifiers (d, i, u, x, c, s, f and so on, without '*'
+  // widths) are formatted by a single pass over the format, into a stack buffer that's appended
+  // in chunks, so that only the StringBuffer's own growth touches the heap.
   void AppendFormatV(const char* format, va_list argList);
   void AppendFormat(const char* format, ...);
 
+  // An AppendFmt argument, captured by type; a string's characters aren't copied.
+  struct FormatArg {
+    enum ArgType {
+      Type_None,
+      Type_Int,
+      Type_UInt,
+      Type_Double,
+      Type_Bool,
+      Type_Char,
+      Type_String,
+      Type_Pointer
+    };
+
+    ArgType Type;
+    union {
+      int64_t Int; // Also Type_Bool and Type_Char.
+      uint64_t UInt;
+      double Double;
+      const char* Chars;
+      const void* Pointer;
+    };
+    size_t Size; // Of Type_String's Chars.
+
+    FormatArg() : Type(Type_None), Int(0), Size(0) {}
+    FormatArg(bool v) : Type(Type_Bool), Int(v), Size(0) {}
+    FormatArg(char v) : Type(Type_Char), Int(v), Size(0) {}
+    FormatArg(signed char v) : Type(Type_Int), Int(v), Size(0) {}
+    FormatArg(short v) : Type(Type_Int), Int(v), Size(0) {}
+    FormatArg(int v) : Type(Type_Int), Int(v), Size(0) {}
+    FormatArg(long v) : Type(Type_Int), Int(v), Size(0) {}
+    FormatArg(long long v) : Type(Type_Int), Int(v), Size(0) {}
+    FormatArg(unsigned char v) : Type(Type_UInt), UInt(v), Size(0) {}
+    FormatArg(unsigned short v) : Type(Type_UInt), UInt(v), Size(0) {}
+    FormatArg(unsigned int v) : Type(Type_UInt), UInt(v), Size(0) {}
+    FormatArg(unsigned long v) : Type(Type_UInt), UInt(v), Size(0) {}
+    FormatArg(unsigned long long v) : Type(Type_UInt), UInt(v), Size(0) {}
+    FormatArg(float v) : Type(Type_Double), Double(v), Size(0) {}
+    FormatArg(double v) : Type(Type_Double), Double(v), Size(0) {}
+    FormatArg(const char* v)
+        : Type(Type_String), Chars(v ? v : "(null)"), Size(v ? OVR_strlen(v) : 6) {}
+    FormatArg(const std::string& v) : Type(Type_String), Chars(v.data()), Size(v.size()) {}
+    FormatArg(const StringView& v) : Type(Type_String), Chars(v.GetData()), Size(v.GetSize()) {}
+    FormatArg(const void* v) : Type(Type_Pointer), Pointer(v), Size(0) {}
+  };
+
+  // Type safe formatting: each {} in format is replaced by the next argument, as printf's
+  // %d, %u, %g, %c, %s or %p would write it, and bools as true or false. {:spec} applies a
+  // printf specifier, without the '%', to an argument it suits, e.g. {:.2f} or {:08x}.
+  // {{ and }} write { and }.
+  //
+  // Example usage:
+  //     sb.AppendFmt("{} of {} frames dropped, {:.2f} ms", dropped, total, ms);
+  template <class... Args>
+  void AppendFmt(const char* format, const Args&... args) {
+    const FormatArg argArray[] = {FormatArg(args)..., FormatArg()};
+    AppendFmtArgs(format, argArray, sizeof...(Args));
+  }
+  void AppendFmtArgs(const char* format, const FormatArg* args, size_t argCount);
+
   // Assigned a string with dynamic data (copied through initializer).
   // void        AssignString(const InitStruct& src, size_t size);
 
@@ -53,35 +53,35 @@ class StringHash : public Hash<String, U, String::NoCaseHashFunctor, Allocator>
     BaseType::operator=(src);
   }
 
-  bool GetCaseInsensitive(const String& key, U* pvalue) const {
+  bool GetCaseInsensitive(const StringView& key, U* pvalue) const {
     String::NoCaseKey ikey(key);
     return BaseType::GetAlt(ikey, pvalue);
   }
   // Pointer-returning get variety.
-  const U* GetCaseInsensitive(const String& key) const {
+  const U* GetCaseInsensitive(const StringView& key) const {
     String::NoCaseKey ikey(key);
     return BaseType::GetAlt(ikey);
   }
-  U* GetCaseInsensitive(const String& key) {
+  U* GetCaseInsensitive(const StringView& key) {
     String::NoCaseKey ikey(key);
     return BaseType::GetAlt(ikey);
   }
 
   typedef typename BaseType::Iterator base_iterator;
 
-  base_iterator FindCaseInsensitive(const String& key) {
+  base_iterator FindCaseInsensitive(const StringView& key) {
     String::NoCaseKey ikey(key);
     return BaseType::FindAlt(ikey);
   }
 
   // Set just uses a find and assigns value if found. The key is not modified;
   // this behavior is identical to Flash string variable assignment.
-  void SetCaseInsensitive(const String& key, const U& value) {
+  void SetCaseInsensitive(const StringView& key, const U& value) {
     base_iterator it = FindCaseInsensitive(key);
     if (it != BaseType::End()) {
       it->Second = value;
     } else {
-      BaseType::Add(key, value);
+      BaseType::Add(String(key), value);
     }
   }
 };
@@ -27,46 +27,451 @@ limitations under the License.
 #include "OVR_String.h"
 #include "OVR_Log.h"
 #include <stdarg.h>
+#include <stdio.h>
 
 namespace OVR {
 
-void StringBuffer::AppendFormatV(const char* format, va_list argList) {
-  char buffer[512];
-  char* bufferUsed = buffer;
-  char* bufferAllocated = NULL;
+namespace {
+
+// Collects formatted output on the stack, and appends it to the StringBuffer in chunks, so that
+// a format call grows the StringBuffer at most once per chunk and allocates nothing else.
+class FormatWriter {
+ public:
+  explicit FormatWriter(StringBuffer& dest) : Dest(dest), Used(0) {}
+  ~FormatWriter() {
+    Flush();
+  }
+
+  void Write(const char* data, size_t size) {
+    if (Used + size > sizeof(Buffer)) {
+      Flush();
+      if (size > sizeof(Buffer)) {
+        Dest.AppendString(data, size);
+        return;
+      }
+    }
+    memcpy(Buffer + Used, data, size);
+    Used += size;
+  }
+
+  void Write(char c) {
+    if (Used == sizeof(Buffer))
+      Flush();
+    Buffer[Used++] = c;
+  }
+
+  void WriteRepeated(char c, size_t count) {
+    while (count--)
+      Write(c);
+  }
+
+  void Flush() {
+    if (Used) {
+      Dest.AppendString(Buffer, Used);
+      Used = 0;
+    }
+  }
+
+ private:
+  StringBuffer& Dest;
+  size_t Used;
+  char Buffer[512];
+};
+
+// A parsed printf specifier.
+struct FormatSpec {
+  char Spec[24]; // From the '%' to the conversion, without the length, for snprintf.
+  size_t PrefixSize; // Of Spec, before the conversion.
+  size_t Size; // Of the specifier in the format, after the '%'.
+  int Width; // -1 if none.
+  int Precision; // -1 if none.
+  bool LeftAlign;
+  bool Simple; // No flags, width or precision.
+  char Length; // 0, 'H' (hh), 'h', 'l', 'L' (ll) or 'z'.
+  char Conversion;
+};
+
+// Parses up to two digits, which is as wide as a specifier this handles gets.
+bool ParseSpecNumber(const char*& p, size_t& out, FormatSpec& spec, int& value) {
+  value = 0;
+  for (int digits = 0; *p >= '0' && *p <= '9'; ++digits) {
+    if (digits == 2)
+      return false;
+    value = (value * 10) + (*p - '0');
+    spec.Spec[out++] = *p++;
+  }
+  return true;
+}
+
+// Parses the specifier after a '%'. Returns false for those which are left to vsnprintf: '*'
+// widths and precisions, wide characters and strings, and lengths other than hh, h, l, ll and z.
+bool ParseFormatSpec(const char* p, FormatSpec& spec) {
+  const char* start = p;
+  size_t out = 0;
+
+  spec.Spec[out++] = '%';
+  spec.Width = -1;
+  spec.Precision = -1;
+  spec.LeftAlign = false;
+  spec.Length = 0;
+
+  for (int flagCount = 0; *p && strchr("-+ #0", *p); ++flagCount) {
+    if (flagCount == 5)
+      return false;
+    spec.LeftAlign |= (*p == '-');
+    spec.Spec[out++] = *p++;
+  }
+
+  if (*p >= '0' && *p <= '9') {
+    if (!ParseSpecNumber(p, out, spec, spec.Width))
+      return false;
+  }
+
+  if (*p == '.') {
+    spec.Spec[out++] = *p++;
+    if (!ParseSpecNumber(p, out, spec, spec.Precision))
+      return false;
+  }
+
+  if (*p == 'h') {
+    spec.Length = (p[1] == 'h') ? 'H' : 'h';
+    p += (p[1] == 'h') ? 2 : 1;
+  } else if (*p == 'l') {
+    spec.Length = (p[1] == 'l') ? 'L' : 'l';
+    p += (p[1] == 'l') ? 2 : 1;
+  } else if (*p == 'z') {
+    spec.Length = 'z';
+    p++;
+  }
+
+  const char conversion = *p;
+  if (!conversion || !strchr("diouxXcsfFeEgGp", conversion))
+    return false;
+  if (spec.Length && strchr("csp", conversion))
+    return false;
+  if (spec.Length && (spec.Length != 'l') && strchr("fFeEgG", conversion))
+    return false;
+
+  spec.PrefixSize = out;
+  spec.Simple = (out == 1);
+  spec.Spec[out++] = conversion;
+  spec.Spec[out] = '\0';
+  spec.Conversion = conversion;
+  spec.Size = (size_t)(p + 1 - start);
+  return true;
+}
+
+// Copies spec's Spec with length inserted before the conversion.
+void BuildSpec(const FormatSpec& spec, const char* length, char* out) {
+  memcpy(out, spec.Spec, spec.PrefixSize);
+  out += spec.PrefixSize;
+  while (*length)
+    *out++ = *length++;
+  *out++ = spec.Conversion;
+  *out = '\0';
+}
+
+template <class T>
+void WriteSnprintf(FormatWriter& writer, const char* spec, T value) {
+  char buffer[512]; // A width and precision of 99 each fit, even for %f of DBL_MAX.
+  const int length = snprintf(buffer, sizeof(buffer), spec, value);
+  if (length > 0)
+    writer.Write(buffer, ((size_t)length < sizeof(buffer)) ? (size_t)length : sizeof(buffer) - 1);
+}
+
+void WriteUnsigned(FormatWriter& writer, uint64_t value, bool negative) {
+  char digits[24];
+  char* p = digits + sizeof(digits);
+  do {
+    *--p = (char)('0' + (value % 10));
+    value /= 10;
+  } while (value);
+  if (negative)
+    *--p = '-';
+  writer.Write(p, (size_t)(digits + sizeof(digits) - p));
+}
+
+void WriteSigned(FormatWriter& writer, int64_t value) {
+  WriteUnsigned(writer, (value < 0) ? (0 - (uint64_t)value) : (uint64_t)value, value < 0);
+}
+
+void WriteHex(FormatWriter& writer, uint64_t value, bool upper) {
+  const char* hexDigits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  char digits[16];
+  char* p = digits + sizeof(digits);
+  do {
+    *--p = hexDigits[value & 0xf];
+    value >>= 4;
+  } while (value);
+  writer.Write(p, (size_t)(digits + sizeof(digits) - p));
+}
+
+// d and i.
+void WriteInt(FormatWriter& writer, const FormatSpec& spec, int64_t value) {
+  if (spec.Simple) {
+    WriteSigned(writer, value);
+  } else {
+    char specBuffer[sizeof(spec.Spec) + 2];
+    BuildSpec(spec, "ll", specBuffer);
+    WriteSnprintf(writer, specBuffer, (long long)value);
+  }
+}
+
+// o, u, x and X.
+void WriteUInt(FormatWriter& writer, const FormatSpec& spec, uint64_t value) {
+  if (spec.Simple && (spec.Conversion == 'u')) {
+    WriteUnsigned(writer, value, false);
+  } else if (spec.Simple && (spec.Conversion == 'x' || spec.Conversion == 'X')) {
+    WriteHex(writer, value, spec.Conversion == 'X');
+  } else {
+    char specBuffer[sizeof(spec.Spec) + 2];
+    BuildSpec(spec, "ll", specBuffer);
+    WriteSnprintf(writer, specBuffer, (unsigned long long)value);
+  }
+}
+
+// c and s, whose size is already limited by any precision.
+void WriteChars(FormatWriter& writer, const FormatSpec& spec, const char* chars, size_t size) {
+  const size_t padding = (spec.Width > (int)size) ? (size_t)spec.Width - size : 0;
+  if (!spec.LeftAlign)
+    writer.WriteRepeated(' ', padding);
+  writer.Write(chars, size);
+  if (spec.LeftAlign)
+    writer.WriteRepeated(' ', padding);
+}
+
+size_t PrecisionLimitedSize(const FormatSpec& spec, size_t size) {
+  return (spec.Precision >= 0 && (size_t)spec.Precision < size) ? (size_t)spec.Precision : size;
+}
+
+// Formats the argument for spec, taken from args, which the caller continues to use.
+void WriteVarArg(FormatWriter& writer, const FormatSpec& spec, va_list* args) {
+  switch (spec.Conversion) {
+    case 'd':
+    case 'i': {
+      int64_t value;
+      switch (spec.Length) {
+        case 'H':
+          value = (signed char)va_arg(*args, int);
+          break;
+        case 'h':
+          value = (short)va_arg(*args, int);
+          break;
+        case 'l':
+          value = va_arg(*args, long);
+          break;
+        case 'L':
+          value = va_arg(*args, long long);
+          break;
+        case 'z':
+          value = va_arg(*args, intptr_t);
+          break;
+        default:
+          value = va_arg(*args, int);
+          break;
+      }
+      WriteInt(writer, spec, value);
+    } break;
+
+    case 'o':
+    case 'u':
+    case 'x':
+    case 'X': {
+      uint64_t value;
+      switch (spec.Length) {
+        case 'H':
+          value = (unsigned char)va_arg(*args, unsigned int);
+          break;
+        case 'h':
+          value = (unsigned short)va_arg(*args, unsigned int);
+          break;
+        case 'l':
+          value = va_arg(*args, unsigned long);
+          break;
+        case 'L':
+          value = va_arg(*args, unsigned long long);
+          break;
+        case 'z':
+          value = va_arg(*args, size_t);
+          break;
+        default:
+          value = va_arg(*args, unsigned int);
+          break;
+      }
+      WriteUInt(writer, spec, value);
+    } break;
+
+    case 'c': {
+      const char c = (char)va_arg(*args, int);
+      WriteChars(writer, spec, &c, 1);
+    } break;
+
+    case 's': {
+      const char* chars = va_arg(*args, const char*);
+      if (!chars)
+        chars = "(null)";
+      size_t size;
+      if (spec.Precision >= 0) {
+        const char* end = (const char*)memchr(chars, 0, (size_t)spec.Precision);
+        size = end ? (size_t)(end - chars) : (size_t)spec.Precision;
+      } else {
+        size = strlen(chars);
+      }
+      WriteChars(writer, spec, chars, size);
+    } break;
+
+    case 'p':
+      WriteSnprintf(writer, spec.Spec, va_arg(*args, void*));
+      break;
+
+    default: // f, F, e, E, g and G
+      WriteSnprintf(writer, spec.Spec, va_arg(*args, double));
+      break;
+  }
+}
+
+// Appends the output of vsnprintf, formatted on the stack if it fits, else directly into the
+// StringBuffer.
+void AppendVsnprintf(StringBuffer& buffer, const char* format, va_list argList) {
+  char stackBuffer[512];
 
   va_list argListSaved;
   va_copy(argListSaved, argList);
-
   int requiredStrlen = vsnprintf(
-      bufferUsed,
-      OVR_ARRAY_COUNT(buffer),
+      stackBuffer,
+      OVR_ARRAY_COUNT(stackBuffer),
       format,
       argListSaved); // The large majority of the time this will succeed.
-
-  if (requiredStrlen >= (int)sizeof(buffer)) // If the initial capacity wasn't enough...
-  {
-    bufferAllocated = (char*)OVR_ALLOC(sizeof(char) * (requiredStrlen + 1));
-    bufferUsed = bufferAllocated;
-    if (bufferAllocated) {
-      va_end(argListSaved);
-      va_copy(argListSaved, argList);
-      requiredStrlen = vsnprintf(bufferAllocated, (requiredStrlen + 1), format, argListSaved);
-    }
-  }
+  va_end(argListSaved);
 
   if (requiredStrlen < 0) // If there was a printf format error...
-  {
-    bufferUsed = NULL;
+    return;
+
+  if (requiredStrlen < (int)sizeof(stackBuffer)) {
+    buffer.AppendString(stackBuffer, (size_t)requiredStrlen);
+    return;
   }
 
+  // Grow the StringBuffer to fit, and format again into its new space.
+  const size_t oldSize = buffer.GetSize();
+  buffer.Resize(oldSize + requiredStrlen);
+
+  va_copy(argListSaved, argList);
+  vsnprintf(&buffer[oldSize], (size_t)requiredStrlen + 1, format, argListSaved);
   va_end(argListSaved);
+}
+
+void WriteFmtDefault(FormatWriter& writer, const StringBuffer::FormatArg& arg) {
+  switch (arg.Type) {
+    case StringBuffer::FormatArg::Type_Int:
+      WriteSigned(writer, arg.Int);
+      break;
+    case StringBuffer::FormatArg::Type_UInt:
+      WriteUnsigned(writer, arg.UInt, false);
+      break;
+    case StringBuffer::FormatArg::Type_Double:
+      WriteSnprintf(writer, "%g", arg.Double);
+      break;
+    case StringBuffer::FormatArg::Type_Bool:
+      if (arg.Int)
+        writer.Write("true", 4);
+      else
+        writer.Write("false", 5);
+      break;
+    case StringBuffer::FormatArg::Type_Char:
+      writer.Write((char)arg.Int);
+      break;
+    case StringBuffer::FormatArg::Type_String:
+      writer.Write(arg.Chars, arg.Size);
+      break;
+    case StringBuffer::FormatArg::Type_Pointer:
+      WriteSnprintf(writer, "%p", const_cast<void*>(arg.Pointer));
+      break;
+    default:
+      break;
+  }
+}
 
-  if (bufferUsed)
-    AppendString(bufferUsed);
+// Writes arg for the placeholder whose contents, between the braces, are [first, last).
+void WriteFmtArg(
+    FormatWriter& writer,
+    const StringBuffer::FormatArg& arg,
+    const char* first,
+    const char* last) {
+  typedef StringBuffer::FormatArg FormatArg;
+
+  FormatSpec spec;
+  char specText[sizeof(spec.Spec)];
+  const size_t specSize = (size_t)(last - first) - 1; // After the ':'.
+
+  if ((first == last) || (*first != ':') || (specSize >= sizeof(specText))) {
+    WriteFmtDefault(writer, arg);
+    return;
+  }
+
+  memcpy(specText, first + 1, specSize);
+  specText[specSize] = '\0';
+
+  if (!ParseFormatSpec(specText, spec) || (spec.Size != specSize) || spec.Length) {
+    WriteFmtDefault(writer, arg);
+    return;
+  }
 
-  if (bufferAllocated)
-    OVR_FREE(bufferAllocated);
+  const bool isInteger = (arg.Type == FormatArg::Type_Int) || (arg.Type == FormatArg::Type_UInt) ||
+      (arg.Type == FormatArg::Type_Bool) || (arg.Type == FormatArg::Type_Char);
+  const int64_t intValue = (arg.Type == FormatArg::Type_UInt) ? (int64_t)arg.UInt : arg.Int;
+
+  if (isInteger && strchr("di", spec.Conversion))
+    WriteInt(writer, spec, intValue);
+  else if (isInteger && strchr("ouxX", spec.Conversion))
+    WriteUInt(writer, spec, (uint64_t)intValue);
+  else if (isInteger && (spec.Conversion == 'c')) {
+    const char c = (char)intValue;
+    WriteChars(writer, spec, &c, 1);
+  } else if ((arg.Type == FormatArg::Type_Double) && strchr("fFeEgG", spec.Conversion))
+    WriteSnprintf(writer, spec.Spec, arg.Double);
+  else if ((arg.Type == FormatArg::Type_String) && (spec.Conversion == 's'))
+    WriteChars(writer, spec, arg.Chars, PrecisionLimitedSize(spec, arg.Size));
+  else if ((arg.Type == FormatArg::Type_Pointer) && (spec.Conversion == 'p'))
+    WriteSnprintf(writer, spec.Spec, const_cast<void*>(arg.Pointer));
+  else
+    WriteFmtDefault(writer, arg);
+}
+
+} // namespace
+
+void StringBuffer::AppendFormatV(const char* format, va_list argList) {
+  FormatWriter writer(*this);
+  FormatSpec spec;
+
+  va_list args;
+  va_copy(args, argList);
+
+  for (const char* p = format; *p;) {
+    const char* percent = strchr(p, '%');
+    if (!percent) {
+      writer.Write(p, strlen(p));
+      break;
+    }
+
+    writer.Write(p, (size_t)(percent - p));
+
+    if (percent[1] == '%') {
+      writer.Write('%');
+      p = percent + 2;
+    } else if (ParseFormatSpec(percent + 1, spec)) {
+      WriteVarArg(writer, spec, &args);
+      p = percent + 1 + spec.Size;
+    } else {
+      // Leave the rest of the format, from this specifier on, to vsnprintf; args has been
+      // advanced past the arguments formatted so far.
+      writer.Flush();
+      AppendVsnprintf(*this, percent, args);
+      break;
+    }
+  }
+
+  va_end(args);
 }
 
 void StringBuffer::AppendFormat(const char* format, ...) {
@@ -75,4 +480,39 @@ void StringBuffer::AppendFormat(const char* format, ...) {
   AppendFormatV(format, argList);
   va_end(argList);
 }
+
+void StringBuffer::AppendFmtArgs(const char* format, const FormatArg* args, size_t argCount) {
+  FormatWriter writer(*this);
+  size_t argIndex = 0;
+
+  for (const char* p = format; *p;) {
+    const char* brace = strpbrk(p, "{}");
+    if (!brace) {
+      writer.Write(p, strlen(p));
+      break;
+    }
+
+    writer.Write(p, (size_t)(brace - p));
+
+    if (brace[1] == brace[0]) { // {{ or }}
+      writer.Write(brace[0]);
+      p = brace + 2;
+      continue;
+    }
+
+    const char* close = (brace[0] == '{') ? strchr(brace, '}') : NULL;
+    if (!close) { // A lone brace is written as is.
+      writer.Write(brace[0]);
+      p = brace + 1;
+      continue;
+    }
+
+    if (argIndex < argCount)
+      WriteFmtArg(writer, args[argIndex++], brace + 1, close);
+    else
+      writer.Write(brace, (size_t)(close + 1 - brace)); // More placeholders than arguments.
+    p = close + 1;
+  }
+}
+
 } // namespace OVR
@@ -118,13 +118,14 @@ SysFile::SysFile() : DelegatedFile(0) {
 Ptr<File> FileFILEOpen(const String& path, int flags, int mode);
 
 // Opens a file
-SysFile::SysFile(const String& path, int flags, int mode) : DelegatedFile(0) {
-  Open(path, flags, mode);
+SysFile::SysFile(const String& path, int flags, int mode, unsigned bufferSize)
+    : DelegatedFile(0) {
+  Open(path, flags, mode, bufferSize);
 }
 
 // ** Open & management
 // Will fail if file's already open
-bool SysFile::Open(const String& path, int flags, int mode) {
+bool SysFile::Open(const String& path, int flags, int mode, unsigned bufferSize) {
   pFile = FileFILEOpen(path, flags, mode);
   if ((!pFile) || (!pFile->IsValid())) {
     pFile = *new UnopenedFile;
@@ -133,7 +134,7 @@ bool SysFile::Open(const String& path, int flags, int mode) {
   }
   // pFile = *OVR_NEW DelegatedFile(pFile); // MA Testing
   if (flags & Open_Buffered)
-    pFile = *new BufferedFile(pFile);
+    pFile = *new BufferedFile(pFile, bufferSize);
   return 1;
 }
 
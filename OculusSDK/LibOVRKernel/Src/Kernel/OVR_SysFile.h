@@ -77,10 +77,19 @@ class SysFile : public DelegatedFile {
   // ** Constructor
   SysFile();
   // Opens a file
-  SysFile(const String& path, int flags = Open_Read | Open_Buffered, int mode = Mode_ReadWrite);
+  // - bufferSize is the BufferedFile buffer size used with Open_Buffered, 0 for the default
+  SysFile(
+      const String& path,
+      int flags = Open_Read | Open_Buffered,
+      int mode = Mode_ReadWrite,
+      unsigned bufferSize = 0);
 
   // ** Open & management
-  bool Open(const String& path, int flags = Open_Read | Open_Buffered, int mode = Mode_ReadWrite);
+  bool Open(
+      const String& path,
+      int flags = Open_Read | Open_Buffered,
+      int mode = Mode_ReadWrite,
+      unsigned bufferSize = 0);
 
   OVR_FORCE_INLINE bool Create(const String& path, int mode = Mode_ReadWrite) {
     return Open(path, Open_ReadWrite | Open_Create, mode);
@@ -30,6 +30,7 @@ limitations under the License.
 #include "OVR_Timer.h"
 #include "OVR_DebugHelp.h"
 #include "OVR_Log.h"
+#include <chrono>
 #include <new>
 
 #if defined(_MSC_VER)
@@ -83,6 +84,86 @@ void SystemSingletonInternal::RegisterDestroyCallback() {
   }
 }
 
+//-----------------------------------------------------------------------------
+// StartupProfile
+
+struct StartupPhaseRecord {
+  const char* Name;
+  uint64_t BeginNanos;
+  uint64_t EndNanos;
+};
+
+static StartupPhaseRecord StartupPhases[StartupProfile::MaxPhases];
+static size_t StartupPhaseCount = 0;
+static uint64_t StartupOriginNanos = 0; // Begin of the earliest phase
+
+static Lock& GetStartupProfileLock() { // Constructed on demand, as with GetSSILock.
+  static Lock profileLock;
+  return profileLock;
+}
+
+uint64_t StartupProfile::GetTicksNanos() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void StartupProfile::RecordPhase(const char* name, uint64_t beginNanos, uint64_t endNanos) {
+  Lock::Locker locker(&GetStartupProfileLock());
+
+  if ((StartupPhaseCount == 0) || (beginNanos < StartupOriginNanos))
+    StartupOriginNanos = beginNanos;
+
+  if (StartupPhaseCount < MaxPhases) {
+    StartupPhaseRecord& record = StartupPhases[StartupPhaseCount++];
+    record.Name = name;
+    record.BeginNanos = beginNanos;
+    record.EndNanos = endNanos;
+  }
+}
+
+size_t StartupProfile::GetPhases(StartupPhase* phases, size_t capacity) {
+  Lock::Locker locker(&GetStartupProfileLock());
+
+  const size_t count = (StartupPhaseCount < capacity) ? StartupPhaseCount : capacity;
+  for (size_t i = 0; i < count; ++i) {
+    phases[i].Name = StartupPhases[i].Name;
+    phases[i].StartSeconds = (StartupPhases[i].BeginNanos - StartupOriginNanos) / 1e9;
+    phases[i].DurationSeconds = (StartupPhases[i].EndNanos - StartupPhases[i].BeginNanos) / 1e9;
+  }
+  return count;
+}
+
+void StartupProfile::LogPhases(const char* milestone) {
+  const uint64_t nowNanos = GetTicksNanos();
+
+  StartupPhase phases[MaxPhases];
+  const size_t count = GetPhases(phases, MaxPhases);
+
+  uint64_t originNanos = nowNanos;
+  {
+    Lock::Locker locker(&GetStartupProfileLock());
+    if (StartupPhaseCount > 0)
+      originNanos = StartupOriginNanos;
+  }
+
+  Logger.LogEvent(
+      ovrlog::Level::Info,
+      "StartupProfile",
+      ovrlog::Field("milestone", milestone ? milestone : ""),
+      ovrlog::Field("seconds", (nowNanos - originNanos) / 1e9),
+      ovrlog::Field("phases", (uint64_t)count));
+
+  for (size_t i = 0; i < count; ++i) {
+    Logger.LogEvent(
+        ovrlog::Level::Info,
+        "StartupPhase",
+        ovrlog::Field("name", phases[i].Name),
+        ovrlog::Field("startMs", phases[i].StartSeconds * 1000.0),
+        ovrlog::Field("durationMs", phases[i].DurationSeconds * 1000.0));
+  }
+}
+
 //-----------------------------------------------------------------------------
 // System
 
@@ -107,8 +188,13 @@ void OVRNewFailureHandler() {
 
 // Initializes System core, installing allocator.
 void System::Init() {
+  StartupPhaseScope initPhase("System::Init");
+
   // Restart logging if we shut down before
-  ovrlog::RestartLogging();
+  {
+    StartupPhaseScope phase("System::Init Logging");
+    ovrlog::RestartLogging();
+  }
 
 #if defined(_MSC_VER)
   // Make it so that failure of the C malloc family of functions results in the same behavior as C++
@@ -138,6 +224,7 @@ void System::Init() {
 #endif
 
   if (++System_Init_Count == 1) {
+    StartupPhaseScope phase("System::Init Timer");
     Timer::initializeTimerSystem();
   } else {
     Logger.LogError("Init recursively called; depth = ", System_Init_Count);
@@ -135,19 +135,70 @@ std::atomic<T*> OVR::SystemSingletonBase<T>::SingletonInstance;
   virtual ~T();                             \
   virtual void OnSystemDestroy() override;
 
-// Place this in the singleton class source file
+// Place this in the singleton class source file. Construction of the instance is recorded as a
+// StartupProfile phase named after the class.
 #define OVR_DEFINE_SINGLETON(T)                  \
   namespace OVR {                                \
   template <>                                    \
   T* SystemSingletonBase<T>::SlowGetInstance() { \
     static OVR::Lock lock;                       \
     OVR::Lock::Locker locker(&lock);             \
-    if (!SingletonInstance.load())               \
+    if (!SingletonInstance.load()) {             \
+      OVR::StartupPhaseScope phase(#T);          \
       SingletonInstance = new T;                 \
+    }                                            \
     return SingletonInstance;                    \
   }                                              \
   }
 
+//-----------------------------------------------------------------------------
+// StartupProfile
+//
+// Records how long each phase of startup took, such as the parts of System::Init and the
+// construction of each singleton, so their share of time-to-first-frame can be measured.
+// Singletons are created on first use rather than by System::Init, so the phases show up when
+// the app first needs them. Times come from the steady clock rather than Timer, so phases can
+// be recorded before System::Init. Phases after the first MaxPhases are dropped.
+
+struct StartupPhase {
+  const char* Name; // Must have static storage duration.
+  double StartSeconds; // Relative to the start of the first recorded phase
+  double DurationSeconds;
+};
+
+class StartupProfile {
+ public:
+  static const size_t MaxPhases = 64;
+
+  static uint64_t GetTicksNanos();
+
+  static void RecordPhase(const char* name, uint64_t beginNanos, uint64_t endNanos);
+
+  // Copies up to capacity phases, in the order they ended. Returns the number copied.
+  static size_t GetPhases(StartupPhase* phases, size_t capacity);
+
+  // Logs a "StartupProfile" event with the time from the first phase until now, labelled with
+  // milestone (for example "FirstFrame"), followed by a "StartupPhase" event for each phase.
+  static void LogPhases(const char* milestone);
+};
+
+// Records the time between its construction and destruction as a StartupProfile phase.
+class StartupPhaseScope {
+  OVR_NON_COPYABLE(StartupPhaseScope)
+
+ public:
+  explicit StartupPhaseScope(const char* name)
+      : Name(name), BeginNanos(StartupProfile::GetTicksNanos()) {}
+
+  ~StartupPhaseScope() {
+    StartupProfile::RecordPhase(Name, BeginNanos, StartupProfile::GetTicksNanos());
+  }
+
+ protected:
+  const char* Name;
+  uint64_t BeginNanos;
+};
+
 // ***** System Core Initialization class
 
 // System initialization must take place before any other OVR_Kernel objects are used;
@@ -0,0 +1,431 @@
+/************************************************************************************
+
+Filename    :   OVR_TaskScheduler.cpp
+Content     :   Work-stealing task scheduler, task groups and ParallelFor
+Created     :   October 14, 2026
+Notes       :
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "OVR_TaskScheduler.h"
+
+#ifdef OVR_ENABLE_THREADS
+
+#include <stdio.h>
+
+OVR_DEFINE_SINGLETON(OVR::SharedTaskScheduler);
+
+namespace OVR {
+
+OVR_THREAD_LOCAL TaskScheduler::Worker* TaskScheduler::CurrentWorker = nullptr;
+
+// Spins an idle worker does, looking for work, before it goes to sleep.
+static const int IdleSpinCount = 64;
+
+//-----------------------------------------------------------------------------------
+// ***** TaskDeque
+//
+// This follows Le, Pop, Cohen and Nardelli, "Correct and Efficient Work-Stealing for Weak
+// Memory Models" (PPoPP 2013), with sequentially consistent operations on Top and Bottom in
+// place of their standalone fences.
+//
+
+TaskDeque::TaskDeque(size_t initialCapacity) : Top(0), Bottom(0), RetiredRings() {
+  size_t capacity = 16;
+  while (capacity < initialCapacity)
+    capacity *= 2;
+
+  Ring* ring = new Ring;
+  ring->Mask = (int64_t)capacity - 1;
+  ring->Slots = new std::atomic<Task*>[capacity];
+  CurrentRing.store(ring, std::memory_order_relaxed);
+}
+
+TaskDeque::~TaskDeque() {
+  RetiredRings.PushBack(CurrentRing.load(std::memory_order_relaxed));
+
+  for (size_t i = 0; i < RetiredRings.GetSize(); ++i) {
+    delete[] RetiredRings[i]->Slots;
+    delete RetiredRings[i];
+  }
+}
+
+TaskDeque::Ring* TaskDeque::Grow(Ring* ring, int64_t top, int64_t bottom) {
+  Ring* newRing = new Ring;
+  newRing->Mask = (ring->Mask * 2) + 1;
+  newRing->Slots = new std::atomic<Task*>[(size_t)newRing->Mask + 1];
+
+  for (int64_t i = top; i < bottom; ++i)
+    newRing->Put(i, ring->Get(i));
+
+  RetiredRings.PushBack(ring);
+  CurrentRing.store(newRing, std::memory_order_release);
+  return newRing;
+}
+
+void TaskDeque::Push(Task* task) {
+  const int64_t bottom = Bottom.load(std::memory_order_relaxed);
+  const int64_t top = Top.load(std::memory_order_acquire);
+  Ring* ring = CurrentRing.load(std::memory_order_relaxed);
+
+  if ((bottom - top) > ring->Mask)
+    ring = Grow(ring, top, bottom);
+
+  ring->Put(bottom, task);
+  Bottom.store(bottom + 1, std::memory_order_release);
+}
+
+Task* TaskDeque::Pop() {
+  const int64_t bottom = Bottom.load(std::memory_order_relaxed) - 1;
+  Ring* ring = CurrentRing.load(std::memory_order_relaxed);
+  Bottom.store(bottom, std::memory_order_seq_cst);
+  int64_t top = Top.load(std::memory_order_seq_cst);
+
+  if (top > bottom) { // Empty.
+    Bottom.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  Task* task = ring->Get(bottom);
+
+  if (top == bottom) { // Last task; race thieves for it.
+    if (!Top.compare_exchange_strong(
+            top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+      task = nullptr;
+    Bottom.store(bottom + 1, std::memory_order_relaxed);
+  }
+
+  return task;
+}
+
+TaskDeque::StealResult TaskDeque::Steal(Task*& task) {
+  int64_t top = Top.load(std::memory_order_seq_cst);
+  const int64_t bottom = Bottom.load(std::memory_order_seq_cst);
+
+  if (top >= bottom)
+    return StealEmpty;
+
+  Ring* ring = CurrentRing.load(std::memory_order_acquire);
+  task = ring->Get(top);
+
+  if (!Top.compare_exchange_strong(
+          top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+    return StealAbort;
+
+  return StealSuccess;
+}
+
+//-----------------------------------------------------------------------------------
+// ***** TaskScheduler
+
+TaskScheduler::TaskScheduler(unsigned workerCount)
+    : Workers(),
+      SharedQueueLock(),
+      SharedQueue(),
+      SharedQueueSize(0),
+      WorkEpoch(0),
+      SleeperCount(0),
+      SleepLock(),
+      SleepCondition(),
+      Terminated(false) {
+  if (workerCount == 0) {
+    const unsigned hardwareThreadCount = std::thread::hardware_concurrency();
+    workerCount = (hardwareThreadCount > 2) ? (hardwareThreadCount - 1) : 1;
+  }
+
+  // All the deques must exist before any worker starts stealing from them.
+  for (unsigned i = 0; i < workerCount; ++i) {
+    Worker* worker = new Worker;
+    worker->Scheduler = this;
+    worker->Index = i;
+    Workers.PushBack(worker);
+  }
+
+  for (unsigned i = 0; i < workerCount; ++i) {
+    Worker* worker = Workers[i];
+    worker->Thread = std::thread([this, worker] { WorkerMain(worker); });
+  }
+}
+
+TaskScheduler::~TaskScheduler() {
+  Shutdown();
+
+  for (size_t i = 0; i < Workers.GetSize(); ++i)
+    delete Workers[i];
+}
+
+void TaskScheduler::Shutdown() {
+  // Set under SharedQueueLock too, so that no task reaches the shared queue after the workers
+  // have drained it.
+  {
+    std::lock_guard<std::mutex> sharedLocker(SharedQueueLock);
+    std::lock_guard<std::mutex> locker(SleepLock);
+    Terminated.store(true, std::memory_order_release);
+  }
+  SleepCondition.notify_all();
+
+  for (size_t i = 0; i < Workers.GetSize(); ++i) {
+    if (Workers[i]->Thread.joinable())
+      Workers[i]->Thread.join();
+  }
+}
+
+bool TaskScheduler::Submit(Task* task) {
+  Worker* worker = CurrentWorker;
+
+  // A worker pushing onto its own deque will still run the task before it exits.
+  if (worker && (worker->Scheduler == this)) {
+    worker->Deque.Push(task);
+  } else {
+    std::lock_guard<std::mutex> locker(SharedQueueLock);
+    if (Terminated.load(std::memory_order_relaxed))
+      return false;
+    SharedQueue.push_back(task);
+    SharedQueueSize.store(SharedQueue.size(), std::memory_order_relaxed);
+  }
+
+  // Pairs with the SleeperCount increment and WorkEpoch check in WorkerMain: either that
+  // worker sees the new epoch and doesn't sleep, or we see it as a sleeper and wake it.
+  WorkEpoch.fetch_add(1, std::memory_order_seq_cst);
+
+  if (SleeperCount.load(std::memory_order_seq_cst) > 0) {
+    { std::lock_guard<std::mutex> locker(SleepLock); }
+    SleepCondition.notify_one();
+  }
+
+  return true;
+}
+
+bool TaskScheduler::StealTask(Task*& task, unsigned firstVictim) {
+  const unsigned workerCount = (unsigned)Workers.GetSize();
+
+  for (unsigned i = 0; i < workerCount; ++i) {
+    Worker* victim = Workers[(firstVictim + i) % workerCount];
+    if (victim == CurrentWorker)
+      continue;
+
+    TaskDeque::StealResult result;
+    while ((result = victim->Deque.Steal(task)) == TaskDeque::StealAbort)
+      OVR_PROCESSOR_PAUSE();
+
+    if (result == TaskDeque::StealSuccess)
+      return true;
+  }
+
+  return false;
+}
+
+bool TaskScheduler::RunOneTask() {
+  Worker* worker = CurrentWorker;
+  if (worker && (worker->Scheduler != this))
+    worker = nullptr;
+
+  Task* task = worker ? worker->Deque.Pop() : nullptr;
+
+  if (!task && SharedQueueSize.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> locker(SharedQueueLock);
+    if (!SharedQueue.empty()) {
+      task = SharedQueue.front();
+      SharedQueue.pop_front();
+      SharedQueueSize.store(SharedQueue.size(), std::memory_order_relaxed);
+    }
+  }
+
+  if (!task) {
+    // Start from a different victim each time so thieves spread out rather than all hitting
+    // the first worker.
+    static OVR_THREAD_LOCAL unsigned StealCursor = 0;
+    const unsigned firstVictim = worker ? (worker->Index + 1 + StealCursor) : StealCursor;
+    StealCursor++;
+
+    if (!StealTask(task, firstVictim))
+      return false;
+  }
+
+  RunTask(task);
+  return true;
+}
+
+void TaskScheduler::RunTask(Task* task) {
+  task->Function();
+
+  TaskGroup* group = task->Group;
+  delete task;
+  group->OnTaskDone();
+}
+
+void TaskScheduler::WorkerMain(Worker* worker) {
+  CurrentWorker = worker;
+
+  char threadName[32];
+  snprintf(threadName, sizeof(threadName), "TaskWorker %u", worker->Index);
+  Thread::SetCurrentThreadName(threadName);
+
+  while (!Terminated.load(std::memory_order_acquire)) {
+    // Read the epoch before looking for work, so that a task submitted after we looked
+    // changes it and keeps us from sleeping.
+    const uint32_t epoch = WorkEpoch.load(std::memory_order_seq_cst);
+
+    bool ranTask = false;
+    for (int spin = 0; (spin < IdleSpinCount) && !ranTask; ++spin) {
+      ranTask = RunOneTask();
+      if (!ranTask)
+        OVR_PROCESSOR_PAUSE();
+    }
+
+    if (ranTask)
+      continue;
+
+    std::unique_lock<std::mutex> locker(SleepLock);
+    SleeperCount.fetch_add(1, std::memory_order_seq_cst);
+    while ((WorkEpoch.load(std::memory_order_seq_cst) == epoch) &&
+           !Terminated.load(std::memory_order_acquire))
+      SleepCondition.wait(locker);
+    SleeperCount.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // Run what's still queued, since a thread may be blocked in TaskGroup::Wait on it and no
+  // other worker may be left to take it.
+  while (RunOneTask()) {
+  }
+
+  CurrentWorker = nullptr;
+}
+
+//-----------------------------------------------------------------------------------
+// ***** TaskGroup
+
+TaskGroup::TaskGroup(TaskScheduler* scheduler)
+    : Scheduler(scheduler ? scheduler : SharedTaskScheduler::GetInstance()->GetScheduler()),
+      PendingCount(0),
+      DoneLock(),
+      DoneCondition() {}
+
+TaskGroup::~TaskGroup() {
+  Wait();
+}
+
+void TaskGroup::Run(std::function<void()> function) {
+  Task* task = new Task;
+  task->Function = std::move(function);
+  task->Group = this;
+
+  PendingCount.fetch_add(1, std::memory_order_relaxed);
+  if (!Scheduler->Submit(task))
+    Scheduler->RunTask(task); // The workers are stopped, so nothing else would run it.
+}
+
+// The final decrement of PendingCount happens under DoneLock, and Wait takes DoneLock before
+// returning. That way the thread finishing the last task is done with the group before Wait
+// can return and let the group be destroyed.
+void TaskGroup::OnTaskDone() {
+  int pending = PendingCount.load(std::memory_order_relaxed);
+
+  for (;;) {
+    if (pending == 1) {
+      std::lock_guard<std::mutex> locker(DoneLock);
+      if (PendingCount.compare_exchange_strong(pending, 0, std::memory_order_acq_rel)) {
+        DoneCondition.notify_all();
+        return;
+      }
+    } else if (PendingCount.compare_exchange_weak(
+                   pending, pending - 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+      return;
+    }
+  }
+}
+
+void TaskGroup::Wait() {
+  while (!IsDone()) {
+    if (Scheduler->RunOneTask())
+      continue;
+
+    // Nothing left to run, so the group's remaining tasks are running on other threads.
+    std::unique_lock<std::mutex> locker(DoneLock);
+    if (!IsDone())
+      DoneCondition.wait(locker);
+  }
+
+  std::lock_guard<std::mutex> locker(DoneLock);
+}
+
+//-----------------------------------------------------------------------------------
+// ***** ParallelFor
+
+static void ParallelForRange(
+    TaskGroup& group,
+    size_t begin,
+    size_t end,
+    size_t grainSize,
+    const std::function<void(size_t, size_t)>& body) {
+  // Hand off the upper half until what's left is small enough, so that thieves take large
+  // ranges and split them further themselves.
+  while ((end - begin) > grainSize) {
+    const size_t middle = begin + ((end - begin) / 2);
+    group.Run([&group, middle, end, grainSize, &body] {
+      ParallelForRange(group, middle, end, grainSize, body);
+    });
+    end = middle;
+  }
+
+  body(begin, end);
+}
+
+void ParallelFor(
+    size_t begin,
+    size_t end,
+    size_t grainSize,
+    const std::function<void(size_t, size_t)>& body,
+    TaskScheduler* scheduler) {
+  if (begin >= end)
+    return;
+
+  TaskGroup group(scheduler);
+
+  if (grainSize == 0) {
+    const size_t rangeCount = 8 * (group.GetScheduler()->GetWorkerCount() + 1);
+    grainSize = Alg::Max<size_t>(1, (end - begin) / rangeCount);
+  }
+
+  ParallelForRange(group, begin, end, grainSize, body);
+  group.Wait();
+}
+
+//-----------------------------------------------------------------------------------
+// ***** SharedTaskScheduler
+
+SharedTaskScheduler::SharedTaskScheduler() : Scheduler() {
+  // Must be at end of function
+  PushDestroyCallbacks();
+}
+
+SharedTaskScheduler::~SharedTaskScheduler() {}
+
+void SharedTaskScheduler::OnThreadDestroy() {
+  Scheduler.Shutdown();
+}
+
+void SharedTaskScheduler::OnSystemDestroy() {
+  delete this;
+}
+
+} // namespace OVR
+
+#endif // OVR_ENABLE_THREADS
@@ -0,0 +1,261 @@
+/************************************************************************************
+
+Filename    :   OVR_TaskScheduler.h
+Content     :   Work-stealing task scheduler, task groups and ParallelFor
+Created     :   October 14, 2026
+Notes       :
+    A TaskScheduler owns a fixed set of worker threads, each with its own TaskDeque.
+    Tasks spawned from a worker go onto that worker's deque, where the worker pops them
+    newest-first while idle workers steal them oldest-first. Tasks spawned from any other
+    thread go onto a shared queue which all workers take from.
+
+    Work is submitted and waited on through a TaskGroup:
+
+        TaskGroup group;
+        group.Run([&] { DecodeTexture(a); });
+        group.Run([&] { DecodeTexture(b); });
+        group.Wait(); // Runs queued tasks on this thread too, rather than just blocking.
+
+    ParallelFor splits an index range into tasks:
+
+        ParallelFor(0, objectCount, 64, [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i)
+            CullObject(i);
+        });
+
+    TaskGroup and ParallelFor use the process-wide SharedTaskScheduler unless given a
+    scheduler. Tasks must not throw.
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_TaskScheduler_h
+#define OVR_TaskScheduler_h
+
+#include "OVR_Types.h"
+#include "OVR_Alg.h"
+#include "OVR_Array.h"
+#include "OVR_Atomic.h"
+#include "OVR_System.h"
+#include "OVR_Threads.h"
+
+#include <deque>
+#include <functional>
+#include <thread>
+
+#ifdef OVR_ENABLE_THREADS
+
+namespace OVR {
+
+class TaskGroup;
+class TaskScheduler;
+
+//-----------------------------------------------------------------------------------
+// ***** Task
+
+struct Task {
+  std::function<void()> Function;
+  TaskGroup* Group;
+};
+
+//-----------------------------------------------------------------------------------
+// ***** TaskDeque
+//
+// Chase-Lev work-stealing deque of Task pointers. The owning thread pushes and pops at the
+// bottom, any other thread may steal from the top. The ring grows as needed; outgrown rings
+// are kept until the deque is destroyed, since a thief may still be reading from one.
+//
+class TaskDeque {
+  OVR_NON_COPYABLE(TaskDeque)
+
+ public:
+  enum StealResult { StealEmpty, StealAbort, StealSuccess };
+
+  explicit TaskDeque(size_t initialCapacity = 256);
+  ~TaskDeque();
+
+  // Owner only.
+  void Push(Task* task);
+  Task* Pop();
+
+  // Any thread. StealAbort means another thread took the top task first; the deque may still
+  // have tasks in it.
+  StealResult Steal(Task*& task);
+
+  bool IsEmpty() const {
+    return Bottom.load(std::memory_order_relaxed) <= Top.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Ring {
+    int64_t Mask;
+    std::atomic<Task*>* Slots;
+
+    Task* Get(int64_t index) const {
+      return Slots[index & Mask].load(std::memory_order_relaxed);
+    }
+    void Put(int64_t index, Task* task) {
+      Slots[index & Mask].store(task, std::memory_order_relaxed);
+    }
+  };
+
+  Ring* Grow(Ring* ring, int64_t top, int64_t bottom);
+
+  std::atomic<int64_t> Top;
+  char Pad[64 - sizeof(std::atomic<int64_t>)]; // Keeps thieves off the owner's cache line.
+  std::atomic<int64_t> Bottom;
+  std::atomic<Ring*> CurrentRing;
+  ArrayPOD<Ring*> RetiredRings;
+};
+
+//-----------------------------------------------------------------------------------
+// ***** TaskScheduler
+
+class TaskScheduler {
+  OVR_NON_COPYABLE(TaskScheduler)
+
+ public:
+  // A workerCount of 0 starts one worker per hardware thread, less one for the thread that
+  // waits on the work, and at least one.
+  explicit TaskScheduler(unsigned workerCount = 0);
+  ~TaskScheduler();
+
+  unsigned GetWorkerCount() const {
+    return (unsigned)Workers.GetSize();
+  }
+
+  // Stops and joins the workers, which first run every task already queued. Tasks submitted
+  // afterwards are run inline by TaskGroup::Run. Called by the destructor.
+  void Shutdown();
+
+  // Runs one queued task on the calling thread: from the calling worker's own deque first,
+  // then the shared queue, then stolen from another worker. Returns false if none was found.
+  bool RunOneTask();
+
+ protected:
+  friend class TaskGroup;
+
+  struct Worker {
+    TaskScheduler* Scheduler;
+    unsigned Index;
+    TaskDeque Deque;
+    std::thread Thread;
+  };
+
+  static OVR_THREAD_LOCAL Worker* CurrentWorker; // The worker the current thread is, if any.
+
+  // Returns false, without queueing the task, once Shutdown has stopped the workers.
+  bool Submit(Task* task);
+  void RunTask(Task* task);
+  bool StealTask(Task*& task, unsigned firstVictim);
+  void WorkerMain(Worker* worker);
+
+  ArrayPOD<Worker*> Workers;
+
+  // Tasks submitted from threads which aren't workers of this scheduler.
+  std::mutex SharedQueueLock;
+  std::deque<Task*> SharedQueue;
+  std::atomic<size_t> SharedQueueSize;
+
+  // Idle workers sleep on SleepCondition until WorkEpoch changes, which Submit does after
+  // queueing each task.
+  std::atomic<uint32_t> WorkEpoch;
+  std::atomic<int> SleeperCount;
+  std::mutex SleepLock;
+  std::condition_variable SleepCondition;
+  std::atomic<bool> Terminated;
+};
+
+//-----------------------------------------------------------------------------------
+// ***** TaskGroup
+//
+// Tracks a set of tasks so they can be waited on. Tasks in the group may run more tasks in the
+// same group or in nested groups. The destructor waits for the group.
+//
+class TaskGroup {
+  OVR_NON_COPYABLE(TaskGroup)
+
+ public:
+  // Uses SharedTaskScheduler if scheduler is null.
+  explicit TaskGroup(TaskScheduler* scheduler = nullptr);
+  ~TaskGroup();
+
+  void Run(std::function<void()> function);
+
+  // Returns once every task run in the group has finished. While tasks are outstanding the
+  // calling thread runs queued tasks, and blocks only when there are none left to take.
+  void Wait();
+
+  bool IsDone() const {
+    return PendingCount.load(std::memory_order_acquire) == 0;
+  }
+
+  TaskScheduler* GetScheduler() const {
+    return Scheduler;
+  }
+
+ protected:
+  friend class TaskScheduler;
+
+  void OnTaskDone();
+
+  TaskScheduler* Scheduler;
+  std::atomic<int> PendingCount;
+  std::mutex DoneLock; // Held for the final decrement of PendingCount, see OnTaskDone.
+  std::condition_variable DoneCondition;
+};
+
+//-----------------------------------------------------------------------------------
+// ***** ParallelFor
+//
+// Calls body(rangeBegin, rangeEnd) over disjoint sub-ranges covering [begin, end), in
+// parallel, and returns when all have finished. The range is split in halves down to at most
+// grainSize indices per call. A grainSize of 0 picks one that gives each thread several
+// ranges to balance over.
+//
+void ParallelFor(
+    size_t begin,
+    size_t end,
+    size_t grainSize,
+    const std::function<void(size_t, size_t)>& body,
+    TaskScheduler* scheduler = nullptr);
+
+//-----------------------------------------------------------------------------------
+// ***** SharedTaskScheduler
+//
+// The process-wide scheduler, created on first use and shut down with the System.
+//
+class SharedTaskScheduler : public SystemSingletonBase<SharedTaskScheduler> {
+  OVR_DECLARE_SINGLETON(SharedTaskScheduler);
+  virtual void OnThreadDestroy() override;
+
+ public:
+  TaskScheduler* GetScheduler() {
+    return &Scheduler;
+  }
+
+ protected:
+  TaskScheduler Scheduler;
+};
+
+} // namespace OVR
+
+#endif // OVR_ENABLE_THREADS
+
+#endif // OVR_TaskScheduler_h
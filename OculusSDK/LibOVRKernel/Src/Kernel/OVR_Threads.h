@@ -103,18 +103,30 @@ class Mutex {
 // Event is a wait-able synchronization object similar to Windows event.
 // Event can be waited on until it's signaled by another thread calling
 // either SetEvent or PulseEvent.
+//
+// The state is a single atomic word, so setting or resetting an event nobody is waiting on
+// never enters the kernel. Waiters block on the address of that word (futex on Linux,
+// WaitOnAddress on Windows 8+), falling back to StateMutex and StateWaitCondition where the
+// OS has no address wait.
 
 class Event {
-  // Event state, its mutex and the wait condition
-  volatile bool State;
-  volatile bool Temporary;
-  mutable std::mutex StateMutex;
+  enum { StateUnset = 0, StateSet = 1, StatePulsed = 3 };
+
+  // Event state and the number of threads inside Wait
+  std::atomic<uint32_t> State;
+  std::atomic<uint32_t> WaiterCount;
+  std::mutex StateMutex;
   std::condition_variable StateWaitCondition;
 
-  void updateState(bool newState, bool newTemp, bool mustNotify);
+  void updateState(uint32_t newState, bool mustNotify);
+
+  // Blocks while State still equals the given value, for up to delay milliseconds; may return
+  // early. Implemented per platform.
+  void waitOnState(uint32_t value, unsigned delay);
+  void wakeWaiters();
 
  public:
-  Event(bool setInitially = 0) : State(setInitially), Temporary(false) {}
+  Event(bool setInitially = 0) : State(setInitially ? StateSet : StateUnset), WaiterCount(0) {}
   ~Event() {}
 
   // Wait on an event condition until it is set
@@ -123,19 +135,19 @@ class Event {
 
   // Set an event, releasing objects waiting on it
   void SetEvent() {
-    updateState(true, false, true);
+    updateState(StateSet, true);
   }
 
   // Reset an event, un-signaling it
   void ResetEvent() {
-    updateState(false, false, false);
+    updateState(StateUnset, false);
   }
 
   // Set and then reset an event once a waiter is released.
   // If threads are already waiting, they will be notified and released
   // If threads are not waiting, the event is set until the first thread comes in
   void PulseEvent() {
-    updateState(true, true, true);
+    updateState(StatePulsed, true);
   }
 };
 
@@ -40,6 +40,13 @@ limitations under the License.
 #include <unistd.h>
 #include <sys/time.h>
 #include <errno.h>
+#include <limits.h>
+#include <chrono>
+
+#if defined(OVR_OS_LINUX)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
 
 #if defined(OVR_OS_MAC) || defined(OVR_OS_BSD)
 #include <sys/sysctl.h>
@@ -172,36 +179,110 @@ bool Mutex::IsLockedByAnotherThread() {
 // ***** Event
 
 bool Event::Wait(unsigned delay) {
-  std::unique_lock<std::mutex> locker(StateMutex);
+  const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  bool registered = false;
+  bool result = false;
+
+  for (;;) {
+    uint32_t state = State.load(std::memory_order_seq_cst);
+
+    if (state != StateUnset) {
+      // Take care of temporary 'pulsing' of a state: only the waiter which resets it
+      // is released.
+      if ((state == StateSet) ||
+          State.compare_exchange_strong(state, StateUnset, std::memory_order_acq_rel)) {
+        result = true;
+        break;
+      }
+      continue;
+    }
 
-  // Do the correct amount of waiting
-  if (delay == OVR_WAIT_INFINITE) {
-    while (!State)
-      StateWaitCondition.wait(locker);
-  } else if (delay) {
-    if (!State)
-      StateWaitCondition.wait_for(locker, std::chrono::milliseconds(delay));
-  }
+    unsigned remaining = delay;
+    if (delay != OVR_WAIT_INFINITE) {
+      const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::steady_clock::now() - startTime)
+                               .count();
+      if (elapsed >= (long long)delay)
+        break;
+      remaining = delay - (unsigned)elapsed;
+    }
 
-  bool state = State;
-  // Take care of temporary 'pulsing' of a state
-  if (Temporary) {
-    Temporary = false;
-    State = false;
+    // Register as a waiter and check State again before blocking, so that an updateState
+    // after that check is guaranteed to see us and wake us.
+    if (!registered) {
+      WaiterCount.fetch_add(1, std::memory_order_seq_cst);
+      registered = true;
+      continue;
+    }
+
+    waitOnState(StateUnset, remaining);
   }
-  return state;
+
+  if (registered)
+    WaiterCount.fetch_sub(1, std::memory_order_relaxed);
+  return result;
 }
 
-void Event::updateState(bool newState, bool newTemp, bool mustNotify) {
-  std::unique_lock<std::mutex> lock(StateMutex);
-  State = newState;
-  Temporary = newTemp;
-  if (mustNotify) {
-    lock.unlock();
-    StateWaitCondition.notify_all();
-  }
+void Event::updateState(uint32_t newState, bool mustNotify) {
+  State.store(newState, std::memory_order_seq_cst);
+
+  // Nobody can be blocked on the old state if nobody is registered, so skip the wake.
+  if (mustNotify && WaiterCount.load(std::memory_order_seq_cst))
+    wakeWaiters();
 }
 
+#if defined(OVR_OS_LINUX)
+
+void Event::waitOnState(uint32_t value, unsigned delay) {
+  struct timespec timeout;
+  timeout.tv_sec = delay / 1000;
+  timeout.tv_nsec = (delay % 1000) * 1000000;
+
+  // Returns at once if State no longer holds value.
+  syscall(
+      SYS_futex,
+      reinterpret_cast<uint32_t*>(&State),
+      FUTEX_WAIT_PRIVATE,
+      value,
+      (delay == OVR_WAIT_INFINITE) ? nullptr : &timeout,
+      nullptr,
+      0);
+}
+
+void Event::wakeWaiters() {
+  syscall(
+      SYS_futex,
+      reinterpret_cast<uint32_t*>(&State),
+      FUTEX_WAKE_PRIVATE,
+      INT_MAX,
+      nullptr,
+      nullptr,
+      0);
+}
+
+#else // No address wait on this platform.
+
+void Event::waitOnState(uint32_t value, unsigned delay) {
+  // wakeWaiters takes StateMutex after State has changed, so checking State under the
+  // mutex means the wake can't be missed.
+  std::unique_lock<std::mutex> locker(StateMutex);
+  if (State.load(std::memory_order_relaxed) != value)
+    return;
+  if (delay == OVR_WAIT_INFINITE)
+    StateWaitCondition.wait(locker);
+  else
+    StateWaitCondition.wait_for(locker, std::chrono::milliseconds(delay));
+}
+
+void Event::wakeWaiters() {
+  { std::lock_guard<std::mutex> locker(StateMutex); }
+  // NOTE: The lock does not need to be held when calling notify_all(),
+  // and holding it is in fact a pessimization.
+  StateWaitCondition.notify_all();
+}
+
+#endif // OVR_OS_LINUX
+
 ThreadId GetCurrentThreadId() {
   return (void*)pthread_self();
 }
@@ -148,38 +148,118 @@ bool Mutex::IsLockedByAnotherThread() {
 //-----------------------------------------------------------------------------------
 // ***** Event
 
-bool Event::Wait(unsigned delay) {
-  std::unique_lock<std::mutex> locker(StateMutex);
+// WaitOnAddress is Windows 8+ and lives in api-ms-win-core-synch-l1-2-0.dll, so it's looked up
+// at runtime rather than linked, and Windows 7 uses the StateMutex fallback.
+typedef BOOL(WINAPI* WaitOnAddressFunc)(volatile VOID*, PVOID, SIZE_T, DWORD);
+typedef VOID(WINAPI* WakeByAddressAllFunc)(PVOID);
+
+struct AddressWaitFunctions {
+  WaitOnAddressFunc WaitOnAddress;
+  WakeByAddressAllFunc WakeByAddressAll;
+
+  AddressWaitFunctions() : WaitOnAddress(nullptr), WakeByAddressAll(nullptr) {
+    HMODULE hSynch = GetModuleHandleW(L"api-ms-win-core-synch-l1-2-0.dll");
+    if (!hSynch)
+      hSynch = LoadLibraryW(L"api-ms-win-core-synch-l1-2-0.dll");
+    if (hSynch) {
+      WaitOnAddress = (WaitOnAddressFunc)(uintptr_t)GetProcAddress(hSynch, "WaitOnAddress");
+      WakeByAddressAll =
+          (WakeByAddressAllFunc)(uintptr_t)GetProcAddress(hSynch, "WakeByAddressAll");
+      if (!WaitOnAddress || !WakeByAddressAll)
+        WaitOnAddress = nullptr;
+    }
+  }
+};
+
+static const AddressWaitFunctions& GetAddressWaitFunctions() {
+  static const AddressWaitFunctions functions;
+  return functions;
+}
 
-  // Do the correct amount of waiting
-  if (delay == OVR_WAIT_INFINITE) {
-    while (!State)
-      StateWaitCondition.wait(locker);
-  } else if (delay) {
-    if (!State)
-      StateWaitCondition.wait_for(locker, std::chrono::milliseconds(delay));
+bool Event::Wait(unsigned delay) {
+  const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  bool registered = false;
+  bool result = false;
+
+  for (;;) {
+    uint32_t state = State.load(std::memory_order_seq_cst);
+
+    if (state != StateUnset) {
+      // Take care of temporary 'pulsing' of a state: only the waiter which resets it
+      // is released.
+      if ((state == StateSet) ||
+          State.compare_exchange_strong(state, StateUnset, std::memory_order_acq_rel)) {
+        result = true;
+        break;
+      }
+      continue;
+    }
+
+    unsigned remaining = delay;
+    if (delay != OVR_WAIT_INFINITE) {
+      const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::steady_clock::now() - startTime)
+                               .count();
+      if (elapsed >= (long long)delay)
+        break;
+      remaining = delay - (unsigned)elapsed;
+    }
+
+    // Register as a waiter and check State again before blocking, so that an updateState
+    // after that check is guaranteed to see us and wake us.
+    if (!registered) {
+      WaiterCount.fetch_add(1, std::memory_order_seq_cst);
+      registered = true;
+      continue;
+    }
+
+    waitOnState(StateUnset, remaining);
   }
 
-  bool state = State;
-  // Take care of temporary 'pulsing' of a state
-  if (Temporary) {
-    Temporary = false;
-    State = false;
+  if (registered)
+    WaiterCount.fetch_sub(1, std::memory_order_relaxed);
+  return result;
+}
+
+void Event::updateState(uint32_t newState, bool mustNotify) {
+  State.store(newState, std::memory_order_seq_cst);
+
+  // Nobody can be blocked on the old state if nobody is registered, so skip the wake.
+  if (mustNotify && WaiterCount.load(std::memory_order_seq_cst))
+    wakeWaiters();
+}
+
+void Event::waitOnState(uint32_t value, unsigned delay) {
+  const AddressWaitFunctions& functions = GetAddressWaitFunctions();
+
+  if (functions.WaitOnAddress) {
+    functions.WaitOnAddress(&State, &value, sizeof(value), delay); // INFINITE == OVR_WAIT_INFINITE
+    return;
   }
-  return state;
+
+  // wakeWaiters takes StateMutex after State has changed, so checking State under the
+  // mutex means the wake can't be missed.
+  std::unique_lock<std::mutex> locker(StateMutex);
+  if (State.load(std::memory_order_relaxed) != value)
+    return;
+  if (delay == OVR_WAIT_INFINITE)
+    StateWaitCondition.wait(locker);
+  else
+    StateWaitCondition.wait_for(locker, std::chrono::milliseconds(delay));
 }
 
-void Event::updateState(bool newState, bool newTemp, bool mustNotify) {
-  {
-    std::lock_guard<std::mutex> lock(StateMutex);
-    State = newState;
-    Temporary = newTemp;
+void Event::wakeWaiters() {
+  const AddressWaitFunctions& functions = GetAddressWaitFunctions();
+
+  if (functions.WaitOnAddress) {
+    functions.WakeByAddressAll(&State);
+    return;
   }
 
+  { std::lock_guard<std::mutex> locker(StateMutex); }
   // NOTE: The lock does not need to be held when calling notify_all(),
   // and holding it is in fact a pessimization.
-  if (mustNotify)
-    StateWaitCondition.notify_all();
+  StateWaitCondition.notify_all();
 }
 
 //-----------------------------------------------------------------------------------
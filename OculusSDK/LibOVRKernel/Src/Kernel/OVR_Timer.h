@@ -31,6 +31,15 @@ limitations under the License.
 #include "OVR_Types.h"
 #include <chrono>
 
+#if defined(OVR_CPU_X86) || defined(OVR_CPU_X86_64)
+#if defined(OVR_CC_MSVC)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define OVR_TIMER_TSC_SUPPORTED 1
+#endif
+
 namespace OVR {
 
 //-----------------------------------------------------------------------------------
@@ -64,6 +73,50 @@ class Timer {
   // This may return a recorded time if Replaying a recording
   static uint64_t OVR_STDCALL GetVirtualTicksNanos();
 
+  // ***** Raw ticks
+  //
+  // GetTicksRaw is meant for fine-grained instrumentation, where GetTicksNanos costs too much.
+  // When the CPU has an invariant TSC (one which runs at a constant rate in every power state) it
+  // returns the TSC, which takes a few nanoseconds to read; otherwise it returns GetTicksNanos.
+  // Raw ticks can only be compared with each other, and should be converted to nanoseconds later,
+  // away from the hot path. Raw ticks read before System::Init shouldn't be mixed with later ones.
+  static uint64_t GetTicksRaw() {
+#if defined(OVR_TIMER_TSC_SUPPORTED)
+    if (UsingTSC)
+      return __rdtsc();
+#endif
+    return GetTicksNanos();
+  }
+
+  // True if GetTicksRaw returns the TSC.
+  static bool IsUsingTSC() {
+    return UsingTSC;
+  }
+
+  // Converts the difference between two raw tick values to nanoseconds.
+  static uint64_t RawTicksToNanosDuration(uint64_t rawTicks) {
+    if (!UsingTSC)
+      return rawTicks;
+
+    // TSCNanosMultiplier is nanoseconds per tick in 32.32 fixed point, and below 1.0.
+    return ((rawTicks >> 32) * TSCNanosMultiplier) +
+        (((rawTicks & 0xffffffff) * TSCNanosMultiplier) >> 32);
+  }
+
+  // Converts a duration in nanoseconds to raw ticks; the inverse of RawTicksToNanosDuration. Used
+  // to place times measured by other clocks, such as GPU timestamps, among raw tick values.
+  static uint64_t NanosToRawTicksDuration(uint64_t nanos) {
+    if (!UsingTSC || !TSCNanosMultiplier)
+      return nanos;
+
+    return (uint64_t)(((double)nanos * 4294967296.0) / (double)TSCNanosMultiplier);
+  }
+
+  // Converts a raw tick value to the timebase of GetTicksNanos. With the TSC the result is
+  // measured back from the current time, so its error grows with the age of the value, by about
+  // 10 microseconds per second.
+  static uint64_t RawTicksToNanos(uint64_t rawTicks);
+
 #ifdef OVR_OS_MS
   static double OVR_STDCALL GetPerfFrequencyInverse();
 
@@ -94,6 +147,12 @@ class Timer {
   static void initializeTimerSystem();
   static void shutdownTimerSystem();
 
+  // Enables the TSC for GetTicksRaw if it's invariant, and measures its rate.
+  static void calibrateTSC();
+
+  static bool UsingTSC;
+  static uint64_t TSCNanosMultiplier;
+
   // for recorded data playback.
   static double VirtualSeconds;
   static bool useVirtualSeconds;
@@ -27,6 +27,7 @@ limitations under the License.
 ************************************************************************************/
 
 #include "OVR_UTF8Util.h"
+#include "OVR_Alg.h"
 #include <wchar.h>
 #include <string.h>
 
@@ -47,9 +48,215 @@ limitations under the License.
 #endif
 #endif
 
+#if defined(__SSE2__) || defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define OVR_UTF8_SSE2 1
+#include <emmintrin.h>
+#else
+#define OVR_UTF8_SSE2 0
+#endif
+
 namespace OVR {
 namespace UTF8Util {
 
+//-----------------------------------------------------------------------------------
+// ***** ASCII runs
+//
+// Most text is largely ASCII, so the functions below skip or copy runs of it 16 bytes (or units)
+// at a time before going on a character at a time. Each helper returns the length of the ASCII
+// run at the start of its input, but only looks at whole blocks of 16, so it can stop up to 15
+// short of the end of an all-ASCII input. The copying helpers may write a whole block past the
+// run, so length must not exceed the room in the destination.
+
+namespace {
+
+const size_t ASCIIBlockSize = 16;
+
+inline size_t MinSize(size_t a, size_t b) {
+  return (a < b) ? a : b;
+}
+
+inline size_t SkipASCIIBlocks(const char* p, size_t length) {
+  if ((length < ASCIIBlockSize) || ((uint8_t)p[0] >= 0x80))
+    return 0;
+
+  size_t i = 0;
+  for (; (length - i) >= ASCIIBlockSize; i += ASCIIBlockSize) {
+#if OVR_UTF8_SSE2
+    const int nonASCII = _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(p + i)));
+    if (nonASCII)
+      return i + Alg::LowerBit((size_t)nonASCII);
+#else
+    for (size_t j = 0; j < ASCIIBlockSize; ++j) {
+      if ((uint8_t)p[i + j] >= 0x80)
+        return i + j;
+    }
+#endif
+  }
+
+  return i;
+}
+
+// Unit is a 2 or 4 byte character type.
+template <class Unit>
+inline size_t WidenASCIIBlocks(Unit* pdest, const char* psrc, size_t length) {
+  if ((length < ASCIIBlockSize) || ((uint8_t)psrc[0] >= 0x80))
+    return 0;
+
+  size_t i = 0;
+  for (; (length - i) >= ASCIIBlockSize; i += ASCIIBlockSize) {
+#if OVR_UTF8_SSE2
+    const __m128i bytes = _mm_loadu_si128((const __m128i*)(psrc + i));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    __m128i* out = (__m128i*)(pdest + i);
+
+    if (sizeof(Unit) == 2) {
+      _mm_storeu_si128(out, lo);
+      _mm_storeu_si128(out + 1, hi);
+    } else {
+      _mm_storeu_si128(out, _mm_unpacklo_epi16(lo, zero));
+      _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, zero));
+      _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, zero));
+      _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, zero));
+    }
+
+    const int nonASCII = _mm_movemask_epi8(bytes);
+    if (nonASCII)
+      return i + Alg::LowerBit((size_t)nonASCII);
+#else
+    for (size_t j = 0; j < ASCIIBlockSize; ++j) {
+      if ((uint8_t)psrc[i + j] >= 0x80)
+        return i + j;
+      pdest[i + j] = (Unit)psrc[i + j];
+    }
+#endif
+  }
+
+  return i;
+}
+
+template <class Unit>
+inline size_t NarrowASCIIBlocks(char* pdest, const Unit* psrc, size_t length) {
+  if ((length < ASCIIBlockSize) || ((uint32_t)psrc[0] >= 0x80))
+    return 0;
+
+  size_t i = 0;
+  for (; (length - i) >= ASCIIBlockSize; i += ASCIIBlockSize) {
+#if OVR_UTF8_SSE2
+    // One bit per byte of the units, set for bytes of ASCII units.
+    const __m128i* in = (const __m128i*)(psrc + i);
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t asciiBits;
+    __m128i a, b;
+
+    if (sizeof(Unit) == 2) {
+      const __m128i highBits = _mm_set1_epi16((short)0xFF80);
+      a = _mm_loadu_si128(in);
+      b = _mm_loadu_si128(in + 1);
+      asciiBits = (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(a, highBits), zero)) |
+          ((uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(b, highBits), zero)) << 16) |
+          UINT64_C(0xFFFFFFFF00000000);
+    } else {
+      const __m128i highBits = _mm_set1_epi32((int)0xFFFFFF80);
+      const __m128i a0 = _mm_loadu_si128(in), a1 = _mm_loadu_si128(in + 1);
+      const __m128i b0 = _mm_loadu_si128(in + 2), b1 = _mm_loadu_si128(in + 3);
+      asciiBits = (uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(a0, highBits), zero)) |
+          ((uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(a1, highBits), zero)) << 16) |
+          ((uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(b0, highBits), zero)) << 32) |
+          ((uint64_t)_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(b1, highBits), zero)) << 48);
+      a = _mm_packs_epi32(a0, a1); // Exact for ASCII units, which is all that's kept.
+      b = _mm_packs_epi32(b0, b1);
+    }
+
+    _mm_storeu_si128((__m128i*)(pdest + i), _mm_packus_epi16(a, b));
+
+    const uint64_t nonASCII = ~asciiBits;
+    if (nonASCII) {
+      const uint32_t low = (uint32_t)nonASCII;
+      const size_t bit =
+          low ? Alg::LowerBit(low) : (32 + Alg::LowerBit((uint32_t)(nonASCII >> 32)));
+      return i + (bit / sizeof(Unit));
+    }
+#else
+    for (size_t j = 0; j < ASCIIBlockSize; ++j) {
+      if ((uint32_t)psrc[i + j] >= 0x80)
+        return i + j;
+      pdest[i + j] = (char)psrc[i + j];
+    }
+#endif
+  }
+
+  return i;
+}
+
+// DecodeNextChar_Advance0, with the two and three byte sequences of non-Latin text inlined. It
+// reads no further than DecodeNextChar_Advance0 does, and returns the same.
+inline uint32_t DecodeNextCharInline(const char** putf8Buffer) {
+  const uint8_t* p = (const uint8_t*)*putf8Buffer;
+
+  if (((p[0] & 0xE0) == 0xC0) && ((p[1] & 0xC0) == 0x80)) {
+    const uint32_t uc = ((p[0] & 0x1Fu) << 6) | (p[1] & 0x3Fu);
+    *putf8Buffer += 2;
+    return (uc < 0x80) ? 0xFFFD : uc;
+  }
+
+  if (((p[0] & 0xF0) == 0xE0) && ((p[1] & 0xC0) == 0x80) && ((p[2] & 0xC0) == 0x80)) {
+    const uint32_t uc = ((p[0] & 0x0Fu) << 12) | ((p[1] & 0x3Fu) << 6) | (p[2] & 0x3Fu);
+    *putf8Buffer += 3;
+    return (uc < 0x800) ? 0xFFFD : uc;
+  }
+
+  return DecodeNextChar_Advance0(putf8Buffer);
+}
+
+// Decodes the well-formed UTF-8 sequence (as defined by RFC 3629) at p, which is before end.
+// Returns -1 if it's malformed, in which case size is 1 so that decoding resumes at the next byte.
+inline int32_t DecodeCharStrict(const uint8_t* p, const uint8_t* end, int& size) {
+  const uint32_t c = p[0];
+  const size_t available = (size_t)(end - p);
+  size = 1;
+
+  if (c < 0x80)
+    return (int32_t)c;
+
+  if (c < 0xC2) // Continuation byte, or an overlong two byte lead.
+    return -1;
+
+  if (c < 0xE0) {
+    if ((available < 2) || ((p[1] & 0xC0) != 0x80))
+      return -1;
+    size = 2;
+    return (int32_t)(((c & 0x1F) << 6) | (p[1] & 0x3F));
+  }
+
+  if (c < 0xF0) {
+    // E0 would be overlong below A0, and ED a surrogate above 9F.
+    const uint32_t lo = (c == 0xE0) ? 0xA0 : 0x80;
+    const uint32_t hi = (c == 0xED) ? 0x9F : 0xBF;
+    if ((available < 3) || (p[1] < lo) || (p[1] > hi) || ((p[2] & 0xC0) != 0x80))
+      return -1;
+    size = 3;
+    return (int32_t)(((c & 0x0F) << 12) | ((p[1] & 0x3F) << 6) | (p[2] & 0x3F));
+  }
+
+  if (c < 0xF5) {
+    // F0 would be overlong below 90, and F4 above 0x10FFFF above 8F.
+    const uint32_t lo = (c == 0xF0) ? 0x90 : 0x80;
+    const uint32_t hi = (c == 0xF4) ? 0x8F : 0xBF;
+    if ((available < 4) || (p[1] < lo) || (p[1] > hi) || ((p[2] & 0xC0) != 0x80) ||
+        ((p[3] & 0xC0) != 0x80))
+      return -1;
+    size = 4;
+    return (int32_t)(
+        ((c & 0x07) << 18) | ((p[1] & 0x3F) << 12) | ((p[2] & 0x3F) << 6) | (p[3] & 0x3F));
+  }
+
+  return -1;
+}
+
+} // namespace
+
 size_t Strlcpy(char* pDestUTF8, size_t destCharCount, const wchar_t* pSrcUCS, size_t sourceLength) {
   if (sourceLength == (size_t)-1)
     sourceLength = wcslen(pSrcUCS);
@@ -58,10 +265,31 @@ size_t Strlcpy(char* pDestUTF8, size_t destCharCount, const wchar_t* pSrcUCS, si
 
   size_t i;
   for (i = 0; i < sourceLength; ++i) {
+    // Copy ASCII runs in bulk while they fit.
+    if ((destLength + ASCIIBlockSize) < destCharCount) {
+      const size_t ascii = NarrowASCIIBlocks(
+          pDestUTF8 + destLength,
+          pSrcUCS + i,
+          MinSize(sourceLength - i, destCharCount - destLength - 1));
+      i += ascii;
+      destLength += ascii;
+      if (i == sourceLength)
+        break;
+    }
+
+    // Characters of up to three bytes go straight to the destination when they surely fit.
+    const uint32_t c = (uint32_t)pSrcUCS[i];
+    if ((c <= 0xFFFF) && ((destLength + 3) < destCharCount)) {
+      intptr_t offset = (intptr_t)destLength;
+      EncodeChar(pDestUTF8, &offset, c);
+      destLength = (size_t)offset;
+      continue;
+    }
+
     char buff[6]; // longest utf8 encoding just to be safe
     intptr_t count = 0;
 
-    EncodeChar(buff, &count, pSrcUCS[i]);
+    EncodeChar(buff, &count, c);
 
     // If this character occupies more than the remaining space (leaving room for the trailing
     // '\0'), truncate here
@@ -94,7 +322,26 @@ size_t Strlcpy(wchar_t* pDestUCS, size_t destCharCount, const char* pSrcUTF8, si
   size_t destLength = 0, requiredLength = 0;
 
   for (const char* pSrcUTF8End = (pSrcUTF8 + sourceLength); pSrcUTF8 < pSrcUTF8End;) {
-    uint32_t c = DecodeNextChar_Advance0(&pSrcUTF8);
+    // Copy ASCII runs in bulk while they fit, and once the destination is full just count them.
+    if ((uint8_t)*pSrcUTF8 < 0x80) {
+      const size_t sourceLeft = (size_t)(pSrcUTF8End - pSrcUTF8);
+      size_t ascii;
+      if ((destLength + ASCIIBlockSize) < destCharCount) {
+        ascii = WidenASCIIBlocks(
+            pDestUCS + destLength, pSrcUTF8, MinSize(sourceLeft, destCharCount - destLength - 1));
+        destLength += ascii;
+      } else if ((destLength + 1) < destCharCount) {
+        ascii = 0; // Nearly full, so the last few are copied one at a time.
+      } else {
+        ascii = SkipASCIIBlocks(pSrcUTF8, sourceLeft);
+      }
+      requiredLength += ascii;
+      pSrcUTF8 += ascii;
+      if (pSrcUTF8 >= pSrcUTF8End)
+        break;
+    }
+
+    uint32_t c = DecodeNextCharInline(&pSrcUTF8);
     OVR_ASSERT_M(
         pSrcUTF8 <= (pSrcUTF8 + sourceLength), "Strlcpy sourceLength was not on a UTF8 boundary.");
 
@@ -124,14 +371,29 @@ intptr_t GetLength(const char* buf, intptr_t buflen) {
   intptr_t length = 0;
 
   if (buflen != -1) {
-    while (p - buf < buflen) {
+    const char* end = buf + buflen;
+    while (p < end) {
+      const size_t ascii = SkipASCIIBlocks(p, (size_t)(end - p));
+      p += ascii;
+      length += (intptr_t)ascii;
+      if (p >= end)
+        break;
+
       // We should be able to have ASStrings with 0 in the middle.
-      UTF8Util::DecodeNextChar_Advance0(&p);
+      DecodeNextCharInline(&p);
       length++;
     }
   } else {
-    while (UTF8Util::DecodeNextChar_Advance0(&p))
+    // The decoder never steps past the terminator, so p stays within end.
+    const char* end = buf + strlen(buf);
+    for (;;) {
+      const size_t ascii = SkipASCIIBlocks(p, (size_t)(end - p));
+      p += ascii;
+      length += (intptr_t)ascii;
+      if (!DecodeNextCharInline(&p))
+        break;
       length++;
+    }
   }
 
   return length;
@@ -386,5 +648,116 @@ void EncodeChar(char* pbuffer, intptr_t* pindex, uint32_t ucs_character) {
     // Invalid char; don't encode anything.
   }
 }
+
+bool IsValidUTF8(const char* putf8str, size_t byteLength) {
+  const uint8_t* p = (const uint8_t*)putf8str;
+  const uint8_t* end = p + byteLength;
+
+  while (p < end) {
+    p += SkipASCIIBlocks((const char*)p, (size_t)(end - p));
+    if (p >= end)
+      break;
+
+    int size;
+    if (DecodeCharStrict(p, end, size) < 0)
+      return false;
+    p += size;
+  }
+
+  return true;
+}
+
+size_t ConvertUTF8ToUTF16(
+    uint16_t* pDestUTF16,
+    size_t destCapacity,
+    const char* pSrcUTF8,
+    size_t sourceLength) {
+  const uint8_t* p = (const uint8_t*)pSrcUTF8;
+  const uint8_t* end = p + sourceLength;
+  size_t destLength = 0; // Units written, which stops growing at the first unit that won't fit.
+  size_t requiredLength = 0;
+
+  while (p < end) {
+    if (*p < 0x80) {
+      const size_t sourceLeft = (size_t)(end - p);
+      size_t ascii;
+      if (destLength != requiredLength)
+        ascii = SkipASCIIBlocks((const char*)p, sourceLeft);
+      else {
+        ascii = WidenASCIIBlocks(
+            pDestUTF16 + destLength,
+            (const char*)p,
+            MinSize(sourceLeft, destCapacity - destLength));
+        destLength += ascii;
+      }
+      requiredLength += ascii;
+      p += ascii;
+      if (p >= end)
+        break;
+    }
+
+    int size;
+    int32_t c = DecodeCharStrict(p, end, size);
+    p += size;
+    if (c < 0)
+      c = 0xFFFD;
+
+    const size_t units = (c >= 0x10000) ? 2 : 1;
+    if ((destLength == requiredLength) && ((destLength + units) <= destCapacity)) {
+      if (units == 2) {
+        pDestUTF16[destLength++] = (uint16_t)(0xD800 + ((c - 0x10000) >> 10));
+        pDestUTF16[destLength++] = (uint16_t)(0xDC00 + ((c - 0x10000) & 0x3FF));
+      } else {
+        pDestUTF16[destLength++] = (uint16_t)c;
+      }
+    }
+    requiredLength += units;
+  }
+
+  return requiredLength;
+}
+
+size_t ConvertUTF16ToUTF8(
+    char* pDestUTF8,
+    size_t destCapacity,
+    const uint16_t* pSrcUTF16,
+    size_t sourceLength) {
+  const uint16_t* p = pSrcUTF16;
+  const uint16_t* end = p + sourceLength;
+  size_t destLength = 0; // Bytes written, which stop at the first character that won't fit.
+  size_t requiredLength = 0;
+
+  while (p < end) {
+    if (destLength == requiredLength) {
+      const size_t ascii = NarrowASCIIBlocks(
+          pDestUTF8 + destLength, p, MinSize((size_t)(end - p), destCapacity - destLength));
+      destLength += ascii;
+      requiredLength += ascii;
+      p += ascii;
+      if (p >= end)
+        break;
+    }
+
+    uint32_t c = *p++;
+    if ((c >= 0xD800) && (c <= 0xDFFF)) {
+      // A high surrogate followed by a low one is a pair; any other surrogate is unpaired.
+      if ((c <= 0xDBFF) && (p < end) && (*p >= 0xDC00) && (*p <= 0xDFFF))
+        c = 0x10000 + ((c - 0xD800) << 10) + (*p++ - 0xDC00);
+      else
+        c = 0xFFFD;
+    }
+
+    const size_t size = (size_t)GetEncodeCharSize(c);
+    if ((destLength == requiredLength) && ((destLength + size) <= destCapacity)) {
+      intptr_t offset = (intptr_t)destLength;
+      EncodeChar(pDestUTF8, &offset, c);
+      destLength = (size_t)offset;
+    }
+    requiredLength += size;
+  }
+
+  return requiredLength;
+}
+
 } // namespace UTF8Util
 } // namespace OVR
@@ -124,6 +124,38 @@ inline uint32_t DecodeNextChar(const char** putf8Buffer) {
     (*putf8Buffer)--;
   return ch;
 }
+
+// *** Validation and UTF-16 conversion.
+//
+// These follow RFC 3629 strictly, unlike the functions above: overlong forms, surrogates and
+// code points above 0x10FFFF are malformed. ASCII runs are handled 16 bytes at a time.
+
+// Returns true if the byteLength bytes at putf8str are well-formed UTF-8.
+bool IsValidUTF8(const char* putf8str, size_t byteLength);
+
+// Converts sourceLength bytes of UTF-8 to UTF-16, replacing each malformed byte with U+FFFD.
+// Writes the characters which fit in destCapacity units, without splitting a surrogate pair,
+// and doesn't null-terminate. Returns the number of units the whole conversion takes.
+//
+// Example usage:
+//     std::vector<uint16_t> text(ConvertUTF8ToUTF16(nullptr, 0, str8, size));
+//     ConvertUTF8ToUTF16(text.data(), text.size(), str8, size);
+//
+size_t ConvertUTF8ToUTF16(
+    uint16_t* pDestUTF16,
+    size_t destCapacity,
+    const char* pSrcUTF8,
+    size_t sourceLength);
+
+// Converts sourceLength units of UTF-16 to UTF-8, replacing unpaired surrogates with U+FFFD.
+// Writes the characters which fit in destCapacity bytes, and doesn't null-terminate. Returns
+// the number of bytes the whole conversion takes.
+size_t ConvertUTF16ToUTF8(
+    char* pDestUTF8,
+    size_t destCapacity,
+    const uint16_t* pSrcUTF16,
+    size_t sourceLength);
+
 } // namespace UTF8Util
 } // namespace OVR
 
@@ -28,6 +28,8 @@ limitations under the License.
 #ifndef OVR_Tracing_h
 #define OVR_Tracing_h
 
+#include "Kernel/OVR_FlightRecorder.h"
+
 //-----------------------------------------------------------------------------------
 // ***** OVR_ENABLE_ETW_TRACING definition (XXX default to on for windows builds?)
 //
@@ -76,10 +78,17 @@ limitations under the License.
   } while (0)
 #define TraceFini() EventUnregisterOVR_SDK_LibOVR()
 
-// Trace function call and return for perf, and waypoints for debug
-#define TraceCall(frameIndex) EventWriteCall(__FUNCTIONW__, __LINE__, (frameIndex))
-#define TraceReturn(frameIndex) EventWriteReturn(__FUNCTIONW__, __LINE__, (frameIndex))
-#define TraceWaypoint(frameIndex) EventWriteWaypoint(__FUNCTIONW__, __LINE__, (frameIndex))
+// Trace function call and return for perf, and waypoints for debug. These also go to the
+// FlightRecorder, so crash and deadlock reports show them without a trace session.
+#define TraceCall(frameIndex)                              \
+  (OVR_FLIGHT_RECORD_WAYPOINT(__FUNCTION__, (frameIndex)), \
+   EventWriteCall(__FUNCTIONW__, __LINE__, (frameIndex)))
+#define TraceReturn(frameIndex)                             \
+  (OVR_FLIGHT_RECORD_WAYPOINT(__FUNCTION__, (frameIndex)),  \
+   EventWriteReturn(__FUNCTIONW__, __LINE__, (frameIndex)))
+#define TraceWaypoint(frameIndex)                             \
+  (OVR_FLIGHT_RECORD_WAYPOINT(__FUNCTION__, (frameIndex)),    \
+   EventWriteWaypoint(__FUNCTIONW__, __LINE__, (frameIndex)))
 
 // DistortionRenderer events
 #define TraceDistortionBegin(id, frameIndex) EventWriteDistortionBegin((id), (frameIndex))
@@ -352,9 +361,9 @@ limitations under the License.
 #define TracingIsEnabled() (false)
 #define TraceInit() ((void)0)
 #define TraceFini() ((void)0)
-#define TraceCall(frameIndex) ((void)0)
-#define TraceReturn(frameIndex) ((void)0)
-#define TraceWaypoint(frameIndex) ((void)0)
+#define TraceCall(frameIndex) OVR_FLIGHT_RECORD_WAYPOINT(__FUNCTION__, (frameIndex))
+#define TraceReturn(frameIndex) OVR_FLIGHT_RECORD_WAYPOINT(__FUNCTION__, (frameIndex))
+#define TraceWaypoint(frameIndex) OVR_FLIGHT_RECORD_WAYPOINT(__FUNCTION__, (frameIndex))
 #define TraceDistortionBegin(id, frameIndex) ((void)0)
 #define TraceDistortionWaitGPU(id, frameIndex) ((void)0)
 #define TraceDistortionPresent(id, frameIndex) ((void)0)
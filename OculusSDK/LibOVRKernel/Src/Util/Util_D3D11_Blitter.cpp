@@ -296,6 +296,7 @@ void D3DTextureWriter::Shutdown() {
   device.Clear();
   textureCopy.Clear();
   textureCopyDesc = {};
+  ClearQueuedGrabs();
   pixels.reset();
 }
 
@@ -303,6 +304,7 @@ void D3DTextureWriter::SetDevice(ID3D11Device* deviceNew) {
   if (device != deviceNew) {
     textureCopy.Clear();
     textureCopyDesc = {};
+    ClearQueuedGrabs();
     // No need to clear the pixels.
 
     device = deviceNew;
@@ -416,8 +418,110 @@ D3DTextureWriter::Result D3DTextureWriter::GrabPixels(
     return Result::TEXTURE_MAP_FAILURE;
   }
 
-  // Now copy textureSource to pixels, converting textureSource's format as-needed to make pixels be
-  // BGRA.
+  ConvertMappedPixels(mapped, textureDesc, depthProj, linearDepthScale);
+
+  deviceContext->Unmap(textureSource, 0); // Always succeeds.
+
+  return Result::SUCCESS;
+}
+
+D3DTextureWriter::Result D3DTextureWriter::QueueGrab(ID3D11Texture2D* texture, UINT subresource) {
+  if (texture == nullptr)
+    return Result::NULL_SURFACE;
+
+  if (device == nullptr)
+    return Result::NULL_DEVICE;
+
+  Ptr<ID3D11DeviceContext> deviceContext;
+  device->GetImmediateContext(&deviceContext.GetRawRef()); // Always succeeds.
+
+  // If the reader has fallen ReadbackLatency grabs behind, we drop the oldest rather than waiting.
+  if (readbackCount == ReadbackLatency) {
+    readbackFirst = (readbackFirst + 1) % ReadbackLatency;
+    readbackCount--;
+  }
+
+  Readback& readback = readbacks[(readbackFirst + readbackCount) % ReadbackLatency];
+
+  D3D11_TEXTURE2D_DESC textureDesc{};
+  texture->GetDesc(&textureDesc);
+  textureDesc.BindFlags = 0;
+  textureDesc.Usage = D3D11_USAGE_STAGING;
+  textureDesc.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+  textureDesc.MiscFlags = 0;
+
+  // As with textureCopy, the ring's textures can usually be reused from one grab to the next.
+  if (!readback.Texture || (textureDesc != readback.TextureDesc)) {
+    readback.Texture.Clear();
+    readback.TextureDesc = textureDesc;
+
+    HRESULT hr = device->CreateTexture2D(&textureDesc, nullptr, &readback.Texture.GetRawRef());
+
+    if (FAILED(hr)) {
+      readback.Texture.Clear();
+      readback.TextureDesc = {};
+      return Result::TEXTURE_CREATION_FAILURE;
+    }
+  }
+
+  deviceContext->CopyResource(readback.Texture, texture); // Always succeeds.
+  readback.Subresource = subresource;
+  readbackCount++;
+
+  return Result::SUCCESS;
+}
+
+D3DTextureWriter::Result D3DTextureWriter::TryGrabQueued(
+    const ovrTimewarpProjectionDesc* depthProj,
+    const float* linearDepthScale) {
+  if (readbackCount == 0)
+    return Result::NULL_SURFACE;
+
+  if (device == nullptr)
+    return Result::NULL_DEVICE;
+
+  Ptr<ID3D11DeviceContext> deviceContext;
+  device->GetImmediateContext(&deviceContext.GetRawRef()); // Always succeeds.
+
+  Readback& readback = readbacks[readbackFirst];
+
+  // Unlike GrabPixels, we don't block until the GPU has executed the copy.
+  D3D11_MAPPED_SUBRESOURCE mapped{};
+  HRESULT hr = deviceContext->Map(
+      readback.Texture, readback.Subresource, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped);
+
+  if (hr == DXGI_ERROR_WAS_STILL_DRAWING)
+    return Result::NOT_READY;
+
+  readbackFirst = (readbackFirst + 1) % ReadbackLatency;
+  readbackCount--;
+
+  if (FAILED(hr))
+    return Result::TEXTURE_MAP_FAILURE;
+
+  ConvertMappedPixels(mapped, readback.TextureDesc, depthProj, linearDepthScale);
+
+  deviceContext->Unmap(readback.Texture, readback.Subresource); // Always succeeds.
+
+  return Result::SUCCESS;
+}
+
+void D3DTextureWriter::ClearQueuedGrabs() {
+  for (Readback& readback : readbacks) {
+    readback.Texture.Clear();
+    readback.TextureDesc = {};
+  }
+
+  readbackFirst = 0;
+  readbackCount = 0;
+}
+
+void D3DTextureWriter::ConvertMappedPixels(
+    const D3D11_MAPPED_SUBRESOURCE& mapped,
+    const D3D11_TEXTURE2D_DESC& textureDesc,
+    const ovrTimewarpProjectionDesc* depthProj,
+    const float* linearDepthScale) {
+  // Copy the mapped texture to pixels, converting its format as-needed to make pixels be BGRA.
   if (pixelsDimentions.first != textureDesc.Width ||
       pixelsDimentions.second != textureDesc.Height) {
     pixels.reset(new uint32_t[textureDesc.Width * textureDesc.Height]);
@@ -585,10 +689,6 @@ D3DTextureWriter::Result D3DTextureWriter::GrabPixels(
       }
     }
   }
-
-  deviceContext->Unmap(textureSource, 0); // Always succeeds.
-
-  return Result::SUCCESS;
 }
 
 uint32_t*
@@ -97,6 +97,7 @@ class D3DTextureWriter {
     TEXTURE_CREATION_FAILURE,
     TEXTURE_MAP_FAILURE,
     FILE_CREATION_FAILURE,
+    NOT_READY,
   };
 
   // Beware that if the texture being saved is one that is a render target then the rendering to
@@ -124,6 +125,21 @@ class D3DTextureWriter {
       const ovrTimewarpProjectionDesc* depthProj,
       const float* linearDepthScale);
 
+  // Asynchronous version of GrabPixels, for grabbing a texture every frame (e.g. recording the
+  // mirror texture) without stalling the pipeline. QueueGrab copies the texture to the next of a
+  // ring of ReadbackLatency staging textures. TryGrabQueued then maps the oldest queued copy, some
+  // frames later, without waiting: it returns NOT_READY while the GPU hasn't finished that copy,
+  // else converts it into pixels as GrabPixels does. If the ring is full, QueueGrab drops the
+  // oldest copy. SavePixelsToBMP and friends work on the result as usual.
+  static const int ReadbackLatency = 3;
+
+  Result QueueGrab(ID3D11Texture2D* texture, UINT subresource);
+  Result TryGrabQueued(const ovrTimewarpProjectionDesc* depthProj, const float* linearDepthScale);
+  int GetQueuedGrabCount() const {
+    return readbackCount;
+  }
+  void ClearQueuedGrabs();
+
   static uint32_t* ConvertRGBA2BGRA(const uint32_t* src, uint32_t* dst, unsigned pixelCount);
   static char* ConvertBGRA2RGB(const uint32_t* src, char* dst, unsigned pixelCount);
 
@@ -135,6 +151,22 @@ class D3DTextureWriter {
   // it and reallocate it anew.
   std::pair<UINT, UINT> pixelsDimentions = {0, 0};
   std::unique_ptr<uint32_t[]> pixels; // Windows RGB .bmp files are actually in BGRA or BGR format.
+
+  struct Readback {
+    Ptr<ID3D11Texture2D> Texture;
+    D3D11_TEXTURE2D_DESC TextureDesc;
+    UINT Subresource;
+  };
+
+  std::array<Readback, ReadbackLatency> readbacks; // The QueueGrab ring.
+  int readbackFirst = 0; // Index of the oldest queued grab.
+  int readbackCount = 0;
+
+  void ConvertMappedPixels(
+      const D3D11_MAPPED_SUBRESOURCE& mapped,
+      const D3D11_TEXTURE2D_DESC& textureDesc,
+      const ovrTimewarpProjectionDesc* depthProj,
+      const float* linearDepthScale);
 };
 } // namespace D3DUtil
 } // namespace OVR
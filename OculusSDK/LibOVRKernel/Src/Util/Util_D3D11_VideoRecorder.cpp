@@ -0,0 +1,451 @@
+/************************************************************************************
+
+Filename    :   Util_D3D11_VideoRecorder.cpp
+Content     :   Records D3D11 textures to H.264 video with the hardware encoder
+Created     :   October 14, 2026
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "Util_D3D11_VideoRecorder.h"
+
+#ifdef OVR_OS_MS
+
+#include "Util_Direct3D.h"
+#include "Kernel/OVR_Timer.h"
+#include <d3d10.h> // ID3D10Multithread
+#include <mfapi.h>
+#include <mferror.h>
+
+#pragma comment(lib, "mfplat.lib")
+#pragma comment(lib, "mfreadwrite.lib")
+#pragma comment(lib, "mfuuid.lib")
+
+namespace OVR {
+namespace D3DUtil {
+
+static ovrlog::Channel Log("VideoRecorder");
+
+//-------------------------------------------------------------------------------------
+// ***** D3DVideoRecorder
+
+D3DVideoRecorder::D3DVideoRecorder()
+    : ProcessorInputWidth(0),
+      ProcessorInputHeight(0),
+      StreamIndex(0),
+      Width(0),
+      Height(0),
+      FrameDuration(0),
+      StartTime(0.0),
+      Recording(false),
+      MFStarted(false),
+      DroppedFrameCount(0),
+      SampleReleased(this),
+      StopRequested(false) {
+  for (Surface& surface : Surfaces) {
+    surface.State = Surface_Free;
+    surface.Time = 0;
+  }
+}
+
+D3DVideoRecorder::~D3DVideoRecorder() {
+  Stop();
+}
+
+bool D3DVideoRecorder::Start(
+    ID3D11Device* device,
+    const wchar_t* path,
+    uint32_t width,
+    uint32_t height,
+    uint32_t framesPerSecond,
+    uint32_t bitRate) {
+  OVR_ASSERT(!Recording);
+  if (Recording || !device || !path || !width || !height || !framesPerSecond) {
+    return false;
+  }
+
+  Device = device;
+  Device->GetImmediateContext(&Context.GetRawRef());
+
+  HRESULT hr = Device->QueryInterface(IID_PPV_ARGS(&VideoDevice.GetRawRef()));
+  if (FAILED(hr)) {
+    Log.LogError("The device wasn't created with D3D11_CREATE_DEVICE_VIDEO_SUPPORT");
+    Release();
+    return false;
+  }
+
+  hr = Context->QueryInterface(IID_PPV_ARGS(&VideoContext.GetRawRef()));
+  OVR_D3D_CHECK_RET_IMPL(hr, Release(); return false;);
+
+  // The encoder uses the device from its own threads.
+  Ptr<ID3D10Multithread> multithread;
+  hr = Context->QueryInterface(IID_PPV_ARGS(&multithread.GetRawRef()));
+  OVR_D3D_CHECK_RET_IMPL(hr, Release(); return false;);
+  multithread->SetMultithreadProtected(TRUE);
+
+  Width = width;
+  Height = height;
+  FrameDuration = 10000000 / framesPerSecond;
+
+  for (Surface& surface : Surfaces) {
+    D3D11_TEXTURE2D_DESC desc{};
+    desc.Width = Width;
+    desc.Height = Height;
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = DXGI_FORMAT_NV12;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D11_USAGE_DEFAULT;
+    desc.BindFlags = D3D11_BIND_RENDER_TARGET; // Required for a video processor output view.
+
+    hr = Device->CreateTexture2D(&desc, nullptr, &surface.Texture.GetRawRef());
+    OVR_D3D_CHECK_RET_IMPL(hr, Release(); return false;);
+    OVR_D3D_TAG_OBJECT(surface.Texture);
+
+    surface.State = Surface_Free;
+  }
+
+  hr = MFStartup(MF_VERSION, MFSTARTUP_LITE);
+  OVR_D3D_CHECK_RET_IMPL(hr, Release(); return false;);
+  MFStarted = true;
+
+  if (!CreateSinkWriter(path, framesPerSecond, bitRate)) {
+    Release();
+    return false;
+  }
+
+  StartTime = Timer::GetSeconds();
+  DroppedFrameCount = 0;
+  StopRequested = false;
+  Recording = true;
+  EncodeThread = std::thread(&D3DVideoRecorder::EncodeThreadProc, this);
+
+  return true;
+}
+
+void D3DVideoRecorder::Stop() {
+  if (Recording) {
+    {
+      std::lock_guard<std::mutex> lock(QueueMutex);
+      StopRequested = true;
+    }
+    QueueChanged.notify_one();
+    EncodeThread.join();
+
+    HRESULT hr = SinkWriter->Finalize();
+    OVR_D3D_CHECK(hr);
+
+    Recording = false;
+  }
+
+  Release();
+}
+
+bool D3DVideoRecorder::AddFrame(ID3D11Texture2D* texture) {
+  if (!Recording || !texture) {
+    return false;
+  }
+
+  D3D11_TEXTURE2D_DESC textureDesc{};
+  texture->GetDesc(&textureDesc);
+
+  if (!Processor || (textureDesc.Width != ProcessorInputWidth) ||
+      (textureDesc.Height != ProcessorInputHeight)) {
+    if (!CreateVideoProcessor(textureDesc.Width, textureDesc.Height)) {
+      return false;
+    }
+  }
+
+  // The mirror texture is usually the same from one frame to the next, so its view is too.
+  if (InputTexture != texture) {
+    InputView.Clear();
+    InputTexture.Clear();
+
+    D3D11_VIDEO_PROCESSOR_INPUT_VIEW_DESC inputViewDesc{};
+    inputViewDesc.ViewDimension = D3D11_VPIV_DIMENSION_TEXTURE2D;
+
+    HRESULT hr = VideoDevice->CreateVideoProcessorInputView(
+        texture, ProcessorEnum, &inputViewDesc, &InputView.GetRawRef());
+    OVR_D3D_CHECK_RET_FALSE(hr);
+
+    InputTexture = texture;
+  }
+
+  int index = -1;
+  for (int i = 0; (i < SurfaceCount) && (index < 0); ++i) {
+    if (Surfaces[i].State.load(std::memory_order_acquire) == Surface_Free) {
+      index = i;
+    }
+  }
+
+  if (index < 0) {
+    // The encoder is behind. Dropping this frame keeps the app's frame rate.
+    DroppedFrameCount++;
+    return false;
+  }
+
+  Surface& surface = Surfaces[index];
+
+  D3D11_VIDEO_PROCESSOR_STREAM stream{};
+  stream.Enable = TRUE;
+  stream.pInputSurface = InputView;
+
+  HRESULT hr = VideoContext->VideoProcessorBlt(Processor, surface.OutputView, 0, 1, &stream);
+  OVR_D3D_CHECK_RET_FALSE(hr);
+
+  surface.Time = (LONGLONG)((Timer::GetSeconds() - StartTime) * 10000000.0);
+  surface.State.store(Surface_Queued, std::memory_order_release);
+
+  {
+    std::lock_guard<std::mutex> lock(QueueMutex);
+    EncodeQueue.push_back(index);
+  }
+  QueueChanged.notify_one();
+
+  return true;
+}
+
+bool D3DVideoRecorder::CreateVideoProcessor(uint32_t inputWidth, uint32_t inputHeight) {
+  InputView.Clear();
+  InputTexture.Clear();
+  Processor.Clear();
+  ProcessorEnum.Clear();
+  for (Surface& surface : Surfaces) {
+    surface.OutputView.Clear();
+  }
+
+  D3D11_VIDEO_PROCESSOR_CONTENT_DESC contentDesc{};
+  contentDesc.InputFrameFormat = D3D11_VIDEO_FRAME_FORMAT_PROGRESSIVE;
+  contentDesc.InputWidth = inputWidth;
+  contentDesc.InputHeight = inputHeight;
+  contentDesc.OutputWidth = Width;
+  contentDesc.OutputHeight = Height;
+  contentDesc.Usage = D3D11_VIDEO_USAGE_OPTIMAL_SPEED;
+
+  HRESULT hr =
+      VideoDevice->CreateVideoProcessorEnumerator(&contentDesc, &ProcessorEnum.GetRawRef());
+  OVR_D3D_CHECK_RET_FALSE(hr);
+
+  hr = VideoDevice->CreateVideoProcessor(ProcessorEnum, 0, &Processor.GetRawRef());
+  OVR_D3D_CHECK_RET_FALSE(hr);
+
+  // The mirror texture is full range RGB, and the encoder expects studio range YCbCr.
+  D3D11_VIDEO_PROCESSOR_COLOR_SPACE inputColorSpace{};
+  inputColorSpace.RGB_Range = 0; // Full range
+  VideoContext->VideoProcessorSetStreamColorSpace(Processor, 0, &inputColorSpace);
+
+  D3D11_VIDEO_PROCESSOR_COLOR_SPACE outputColorSpace{};
+  outputColorSpace.YCbCr_Matrix = 1; // BT.709
+  outputColorSpace.Nominal_Range = D3D11_VIDEO_PROCESSOR_NOMINAL_RANGE_16_235;
+  VideoContext->VideoProcessorSetOutputColorSpace(Processor, &outputColorSpace);
+
+  D3D11_VIDEO_PROCESSOR_OUTPUT_VIEW_DESC outputViewDesc{};
+  outputViewDesc.ViewDimension = D3D11_VPOV_DIMENSION_TEXTURE2D;
+
+  for (Surface& surface : Surfaces) {
+    hr = VideoDevice->CreateVideoProcessorOutputView(
+        surface.Texture, ProcessorEnum, &outputViewDesc, &surface.OutputView.GetRawRef());
+    OVR_D3D_CHECK_RET_FALSE(hr);
+  }
+
+  ProcessorInputWidth = inputWidth;
+  ProcessorInputHeight = inputHeight;
+  return true;
+}
+
+bool D3DVideoRecorder::CreateSinkWriter(
+    const wchar_t* path,
+    uint32_t framesPerSecond,
+    uint32_t bitRate) {
+  UINT resetToken = 0;
+  HRESULT hr = MFCreateDXGIDeviceManager(&resetToken, &DeviceManager.GetRawRef());
+  OVR_D3D_CHECK_RET_FALSE(hr);
+
+  hr = DeviceManager->ResetDevice(Device, resetToken);
+  OVR_D3D_CHECK_RET_FALSE(hr);
+
+  Ptr<IMFAttributes> attributes;
+  hr = MFCreateAttributes(&attributes.GetRawRef(), 3);
+  OVR_D3D_CHECK_RET_FALSE(hr);
+  attributes->SetUnknown(MF_SINK_WRITER_D3D_MANAGER, DeviceManager);
+  attributes->SetUINT32(MF_READWRITE_ENABLE_HARDWARE_TRANSFORMS, TRUE);
+  attributes->SetUINT32(MF_SINK_WRITER_DISABLE_THROTTLING, TRUE); // We drop frames ourselves.
+
+  hr = MFCreateSinkWriterFromURL(path, nullptr, attributes, &SinkWriter.GetRawRef());
+  if (FAILED(hr)) {
+    Log.LogErrorF("Couldn't create %ls for recording", path);
+    return false;
+  }
+
+  Ptr<IMFMediaType> outputType;
+  hr = MFCreateMediaType(&outputType.GetRawRef());
+  OVR_D3D_CHECK_RET_FALSE(hr);
+  outputType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+  outputType->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_H264);
+  outputType->SetUINT32(MF_MT_AVG_BITRATE, bitRate);
+  outputType->SetUINT32(MF_MT_INTERLACE_MODE, MFVideoInterlace_Progressive);
+  MFSetAttributeSize(outputType, MF_MT_FRAME_SIZE, Width, Height);
+  MFSetAttributeRatio(outputType, MF_MT_FRAME_RATE, framesPerSecond, 1);
+  MFSetAttributeRatio(outputType, MF_MT_PIXEL_ASPECT_RATIO, 1, 1);
+
+  hr = SinkWriter->AddStream(outputType, &StreamIndex);
+  OVR_D3D_CHECK_RET_FALSE(hr);
+
+  Ptr<IMFMediaType> inputType;
+  hr = MFCreateMediaType(&inputType.GetRawRef());
+  OVR_D3D_CHECK_RET_FALSE(hr);
+  inputType->SetGUID(MF_MT_MAJOR_TYPE, MFMediaType_Video);
+  inputType->SetGUID(MF_MT_SUBTYPE, MFVideoFormat_NV12);
+  inputType->SetUINT32(MF_MT_INTERLACE_MODE, MFVideoInterlace_Progressive);
+  MFSetAttributeSize(inputType, MF_MT_FRAME_SIZE, Width, Height);
+  MFSetAttributeRatio(inputType, MF_MT_FRAME_RATE, framesPerSecond, 1);
+  MFSetAttributeRatio(inputType, MF_MT_PIXEL_ASPECT_RATIO, 1, 1);
+
+  hr = SinkWriter->SetInputMediaType(StreamIndex, inputType, nullptr);
+  if (FAILED(hr)) {
+    Log.LogErrorF("No H.264 encoder accepts %ux%u NV12 input", Width, Height);
+    return false;
+  }
+
+  hr = SinkWriter->BeginWriting();
+  OVR_D3D_CHECK_RET_FALSE(hr);
+
+  return true;
+}
+
+void D3DVideoRecorder::EncodeThreadProc() {
+  for (;;) {
+    int index;
+    {
+      std::unique_lock<std::mutex> lock(QueueMutex);
+      QueueChanged.wait(lock, [this] { return StopRequested || !EncodeQueue.empty(); });
+
+      if (EncodeQueue.empty()) // We write out everything queued before stopping.
+        break;
+
+      index = EncodeQueue.front();
+      EncodeQueue.pop_front();
+    }
+
+    Surface& surface = Surfaces[index];
+    surface.State.store(Surface_Encoding, std::memory_order_release);
+
+    // The sample wraps the surface itself, and SampleReleased frees the surface once the encoder
+    // has released the sample, as the encoder may read it after WriteSample returns.
+    Ptr<IMFMediaBuffer> buffer;
+    Ptr<IMFSample> sample;
+    Ptr<IMFTrackedSample> trackedSample;
+    bool tracked = false;
+    HRESULT hr = MFCreateDXGISurfaceBuffer(
+        __uuidof(ID3D11Texture2D), surface.Texture, 0, FALSE, &buffer.GetRawRef());
+
+    if (SUCCEEDED(hr)) {
+      Ptr<IMF2DBuffer> buffer2D;
+      DWORD length = 0;
+      if (SUCCEEDED(buffer->QueryInterface(IID_PPV_ARGS(&buffer2D.GetRawRef()))) &&
+          SUCCEEDED(buffer2D->GetContiguousLength(&length))) {
+        buffer->SetCurrentLength(length);
+      }
+      hr = MFCreateVideoSampleFromSurface(nullptr, &sample.GetRawRef());
+    }
+    if (SUCCEEDED(hr))
+      hr = sample->AddBuffer(buffer);
+    if (SUCCEEDED(hr))
+      hr = sample->QueryInterface(IID_PPV_ARGS(&trackedSample.GetRawRef()));
+    if (SUCCEEDED(hr))
+      hr = trackedSample->SetAllocator(&SampleReleased, surface.Texture);
+    if (SUCCEEDED(hr)) {
+      tracked = true;
+      sample->SetSampleTime(surface.Time);
+      sample->SetSampleDuration(FrameDuration);
+      hr = SinkWriter->WriteSample(StreamIndex, sample);
+    }
+
+    if (FAILED(hr)) {
+      OVR_D3D_CHECK(hr);
+      if (!tracked) // Otherwise SampleReleased frees it when we release the sample below.
+        surface.State.store(Surface_Free, std::memory_order_release);
+    }
+  }
+}
+
+STDMETHODIMP D3DVideoRecorder::SampleReleasedCallback::QueryInterface(REFIID riid, void** ppv) {
+  if (!ppv)
+    return E_POINTER;
+
+  if ((riid == __uuidof(IMFAsyncCallback)) || (riid == __uuidof(IUnknown))) {
+    *ppv = static_cast<IMFAsyncCallback*>(this);
+    return S_OK;
+  }
+
+  *ppv = nullptr;
+  return E_NOINTERFACE;
+}
+
+STDMETHODIMP D3DVideoRecorder::SampleReleasedCallback::Invoke(IMFAsyncResult* result) {
+  // The state is the surface's texture, which SetAllocator was given.
+  Ptr<IUnknown> state;
+  if (SUCCEEDED(result->GetState(&state.GetRawRef()))) {
+    for (Surface& surface : Recorder->Surfaces) {
+      Ptr<IUnknown> texture;
+      surface.Texture->QueryInterface(IID_PPV_ARGS(&texture.GetRawRef()));
+
+      if (texture == state)
+        surface.State.store(Surface_Free, std::memory_order_release);
+    }
+  }
+
+  return S_OK;
+}
+
+void D3DVideoRecorder::Release() {
+  OVR_ASSERT(!Recording);
+
+  SinkWriter.Clear(); // Releases the encoder and with it any samples it still holds.
+  DeviceManager.Clear();
+
+  if (MFStarted) {
+    MFShutdown();
+    MFStarted = false;
+  }
+
+  InputView.Clear();
+  InputTexture.Clear();
+  for (Surface& surface : Surfaces) {
+    surface.OutputView.Clear();
+    surface.Texture.Clear();
+    surface.State = Surface_Free;
+  }
+  Processor.Clear();
+  ProcessorEnum.Clear();
+  ProcessorInputWidth = 0;
+  ProcessorInputHeight = 0;
+
+  VideoContext.Clear();
+  VideoDevice.Clear();
+  Context.Clear();
+  Device.Clear();
+
+  EncodeQueue.clear();
+}
+
+} // namespace D3DUtil
+} // namespace OVR
+
+#endif // OVR_OS_MS
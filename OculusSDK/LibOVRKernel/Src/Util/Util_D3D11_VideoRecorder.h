@@ -0,0 +1,165 @@
+/************************************************************************************
+
+Filename    :   Util_D3D11_VideoRecorder.h
+Content     :   Records D3D11 textures to H.264 video with the hardware encoder
+Created     :   October 14, 2026
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_Util_D3D11_VideoRecorder_h
+#define OVR_Util_D3D11_VideoRecorder_h
+
+#include "Kernel/OVR_RefCount.h"
+#include "Kernel/OVR_Log.h"
+
+#ifdef OVR_OS_MS
+
+#include <d3d11_1.h>
+#include <mfidl.h>
+#include <mfreadwrite.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace OVR {
+namespace D3DUtil {
+
+//-------------------------------------------------------------------------------------
+// ***** D3DVideoRecorder
+
+// Records a texture, typically the mirror texture, to an H.264 .mp4 file, without any CPU
+// readback. AddFrame converts the texture to NV12 with the D3D11 video processor, on the GPU, into
+// one of a small ring of surfaces. A separate thread hands the surfaces to a Media Foundation sink
+// writer, which uses the hardware encoder (NVENC, AMF, Quick Sync) where the driver provides one.
+// A surface returns to the ring once the encoder has released it; if none is free, AddFrame drops
+// the frame rather than waiting for the encoder.
+//
+// The device must have been created with D3D11_CREATE_DEVICE_VIDEO_SUPPORT. Start makes it
+// multithread protected, as the encoder uses it from its own threads.
+
+class D3DVideoRecorder {
+ public:
+  D3DVideoRecorder();
+  ~D3DVideoRecorder();
+
+  // Frames added are scaled to width x height. bitRate is in bits per second.
+  bool Start(
+      ID3D11Device* device,
+      const wchar_t* path,
+      uint32_t width,
+      uint32_t height,
+      uint32_t framesPerSecond,
+      uint32_t bitRate);
+
+  // Writes out the frames still queued and closes the file.
+  void Stop();
+
+  bool IsRecording() const {
+    return Recording;
+  }
+
+  // Must be called from the thread that uses the device's immediate context. The frame's time is
+  // taken from when it's added, so frames may be added at any rate.
+  bool AddFrame(ID3D11Texture2D* texture);
+
+  uint32_t GetDroppedFrameCount() const {
+    return DroppedFrameCount;
+  }
+
+ private:
+  // Called by Media Foundation when the encoder is done with a surface's sample.
+  class SampleReleasedCallback : public IMFAsyncCallback {
+   public:
+    SampleReleasedCallback(D3DVideoRecorder* recorder) : Recorder(recorder) {}
+
+    STDMETHODIMP QueryInterface(REFIID riid, void** ppv) override;
+    STDMETHODIMP_(ULONG) AddRef() override {
+      return 1; // Owned by the D3DVideoRecorder.
+    }
+    STDMETHODIMP_(ULONG) Release() override {
+      return 1;
+    }
+    STDMETHODIMP GetParameters(DWORD*, DWORD*) override {
+      return E_NOTIMPL;
+    }
+    STDMETHODIMP Invoke(IMFAsyncResult* result) override;
+
+   private:
+    D3DVideoRecorder* Recorder;
+  };
+
+  enum SurfaceState { Surface_Free, Surface_Queued, Surface_Encoding };
+
+  struct Surface {
+    Ptr<ID3D11Texture2D> Texture; // NV12
+    Ptr<ID3D11VideoProcessorOutputView> OutputView;
+    std::atomic<int> State;
+    LONGLONG Time; // In 100ns units, since Start.
+  };
+
+  static const int SurfaceCount = 4;
+
+  bool CreateVideoProcessor(uint32_t inputWidth, uint32_t inputHeight);
+  bool CreateSinkWriter(const wchar_t* path, uint32_t framesPerSecond, uint32_t bitRate);
+  void EncodeThreadProc();
+  void Release();
+
+  Ptr<ID3D11Device> Device;
+  Ptr<ID3D11DeviceContext> Context;
+  Ptr<ID3D11VideoDevice> VideoDevice;
+  Ptr<ID3D11VideoContext> VideoContext;
+  Ptr<ID3D11VideoProcessorEnumerator> ProcessorEnum;
+  Ptr<ID3D11VideoProcessor> Processor;
+  uint32_t ProcessorInputWidth;
+  uint32_t ProcessorInputHeight;
+  Ptr<ID3D11Texture2D> InputTexture; // The texture InputView was created for.
+  Ptr<ID3D11VideoProcessorInputView> InputView;
+
+  Ptr<IMFDXGIDeviceManager> DeviceManager;
+  Ptr<IMFSinkWriter> SinkWriter;
+  DWORD StreamIndex;
+
+  uint32_t Width;
+  uint32_t Height;
+  LONGLONG FrameDuration; // In 100ns units.
+  double StartTime;
+  bool Recording;
+  bool MFStarted;
+  uint32_t DroppedFrameCount;
+
+  std::array<Surface, SurfaceCount> Surfaces;
+  SampleReleasedCallback SampleReleased;
+
+  std::thread EncodeThread;
+  std::mutex QueueMutex; // Protects EncodeQueue and StopRequested.
+  std::condition_variable QueueChanged;
+  std::deque<int> EncodeQueue; // Indexes of Surface_Queued surfaces, oldest first.
+  bool StopRequested;
+};
+
+} // namespace D3DUtil
+} // namespace OVR
+
+#endif // OVR_OS_MS
+#endif // OVR_Util_D3D11_VideoRecorder_h
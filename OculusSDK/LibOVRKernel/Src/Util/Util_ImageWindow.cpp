@@ -114,9 +114,16 @@ ImageWindow::ImageWindow(uint32_t width, uint32_t height)
       pRT(NULL),
       // resolution(),
       frontBufferMutex(new Mutex()),
-      frames(),
+      presentMutex(new Mutex()),
+      backFrame(),
+      pendingFrame(),
+      droppedFrameCount(0),
       greyBitmap(NULL),
-      colorBitmap(NULL) {
+      colorBitmap(NULL),
+      deviceMultithread(NULL),
+      frameReadyEvent(),
+      presentThreadQuit(false),
+      presentThread() {
   D2D1CreateFactoryFn createFactory = NULL;
   DWriteCreateFactoryFn writeFactory = NULL;
 
@@ -167,6 +174,8 @@ ImageWindow::ImageWindow(uint32_t width, uint32_t height)
 }
 
 ImageWindow::~ImageWindow() {
+  StopPresentThread();
+
   for (int i = 0; i < MaxWindows; ++i) {
     if (globalWindow[i] == this) {
       globalWindow[i] = NULL;
@@ -183,12 +192,13 @@ ImageWindow::~ImageWindow() {
   if (pRT)
     pRT->Release();
 
+  if (deviceMultithread)
+    deviceMultithread->Release();
+
   {
     Mutex::Locker locker(frontBufferMutex);
-
-    while (frames.GetSize()) {
-      Ptr<Frame> aFrame = frames.PopBack();
-    }
+    backFrame.Clear();
+    pendingFrame.Clear();
   }
 
   if (hWindow) {
@@ -275,59 +285,97 @@ void ImageWindow::AssociateSurface(void* surface) {
         }
         pRT = tmpTarget;
       }
+
+      if (pRT && !deviceMultithread) {
+        // Kept for StartPresentThread, which draws to the surface from another thread.
+        pDxgiSurface->GetDevice(__uuidof(ID3D10Multithread), (void**)&deviceMultithread);
+      }
+
+      pDxgiSurface->Release();
     }
   }
 }
 
 void ImageWindow::Process() {
+  // The present thread, if any, presents frames as they're completed.
+  if (presentThread)
+    return;
+
   if (pRT && greyBitmap) {
     OnPaint();
-
-    pRT->Flush();
   }
 }
 
-void ImageWindow::Complete() {
-  Mutex::Locker locker(frontBufferMutex);
+bool ImageWindow::StartPresentThread() {
+  if (presentThread)
+    return true;
 
-  if (frames.IsEmpty())
-    return;
+  if (!pRT || !greyBitmap || !deviceMultithread)
+    return false;
 
-  if (frames.PeekBack(0)->ready)
-    return;
+  // D2D draws with the device's immediate context, which the app uses on its own thread.
+  deviceMultithread->SetMultithreadProtected(TRUE);
+
+  presentThreadQuit.store(false, std::memory_order_relaxed);
+  presentThread = std::make_unique<std::thread>([this] { this->PresentThreadProc(); });
+  return true;
+}
 
-  Ptr<Frame> frame = frames.PeekBack(0);
+void ImageWindow::StopPresentThread() {
+  if (!presentThread)
+    return;
 
-  frame->ready = true;
+  presentThreadQuit.store(true, std::memory_order_release);
+  frameReadyEvent.SetEvent();
+  presentThread->join();
+  presentThread.reset();
 }
 
-void ImageWindow::OnPaint() {
-  Mutex::Locker locker(frontBufferMutex);
+void ImageWindow::PresentThreadProc() {
+  Thread::SetCurrentThreadName("ImageWindow");
 
-  // Nothing to do
-  if (frames.IsEmpty())
-    return;
+  while (!presentThreadQuit.load(std::memory_order_acquire)) {
+    frameReadyEvent.Wait();
+    frameReadyEvent.ResetEvent();
 
-  if (!frames.PeekFront(0)->ready)
-    return;
+    if (!presentThreadQuit.load(std::memory_order_acquire))
+      OnPaint();
+  }
+}
+
+void ImageWindow::Complete() {
+  {
+    Mutex::Locker locker(frontBufferMutex);
 
-  Ptr<Frame> currentFrame = frames.PopFront();
+    if (!backFrame)
+      return;
 
-  Ptr<Frame> nextFrame = NULL;
+    // The frame not yet presented is stale now; it's dropped rather than queued behind.
+    if (pendingFrame)
+      droppedFrameCount.fetch_add(1, std::memory_order_relaxed);
 
-  if (!frames.IsEmpty())
-    nextFrame = frames.PeekFront(0);
+    backFrame->ready = true;
+    pendingFrame = backFrame;
+    backFrame.Clear();
+  }
 
-  while (nextFrame && nextFrame->ready) {
-    // Free up the current frame since it's been removed from the deque
-    currentFrame = frames.PopFront();
+  frameReadyEvent.SetEvent();
+}
 
-    if (frames.IsEmpty())
-      break;
+void ImageWindow::OnPaint() {
+  Mutex::Locker presentLocker(presentMutex);
 
-    nextFrame = frames.PeekFront(0);
+  Ptr<Frame> currentFrame;
+  {
+    Mutex::Locker locker(frontBufferMutex);
+    currentFrame = pendingFrame;
+    pendingFrame.Clear();
   }
 
+  // Nothing to do
+  if (!currentFrame)
+    return;
+
   if (currentFrame->imageData)
     greyBitmap->CopyFromMemory(NULL, currentFrame->imageData, currentFrame->width);
 
@@ -443,30 +491,33 @@ void ImageWindow::OnPaint() {
   pRT->Flush();
 }
 
+// Must be called with frontBufferMutex held.
 Ptr<Frame> ImageWindow::lastUnreadyFrame() {
   static int framenumber = 0;
 
-  if (frames.GetSize() && !frames.PeekBack(0)->ready)
-    return frames.PeekBack(0);
-
   // Create a new frame if an unready one doesn't already exist
-  Ptr<Frame> tmpFrame = *new Frame(framenumber);
-  frames.PushBack(tmpFrame);
-
-  ++framenumber;
+  if (!backFrame) {
+    backFrame = *new Frame(framenumber);
+    ++framenumber;
+  }
 
-  return tmpFrame;
+  return backFrame;
 }
 
 void ImageWindow::UpdateImageBW(const uint8_t* imageData, uint32_t width, uint32_t height) {
   if (pRT && greyBitmap) {
+    // Copied before taking the lock, which the producers share.
+    void* copy = malloc(width * height);
+    memcpy(copy, imageData, width * height);
+
     Mutex::Locker locker(frontBufferMutex);
 
     Ptr<Frame> frame = lastUnreadyFrame();
-    frame->imageData = malloc(width * height);
+    if (frame->imageData)
+      free(frame->imageData);
+    frame->imageData = copy;
     frame->width = width;
     frame->height = height;
-    memcpy(frame->imageData, imageData, width * height);
   }
 }
 
@@ -476,14 +527,18 @@ void ImageWindow::UpdateImageRGBA(
     uint32_t height,
     uint32_t pitch) {
   if (pRT && colorBitmap) {
+    void* copy = malloc(pitch * height);
+    memcpy(copy, imageData, pitch * height);
+
     Mutex::Locker locker(frontBufferMutex);
 
     Ptr<Frame> frame = lastUnreadyFrame();
-    frame->colorImageData = malloc(pitch * height);
+    if (frame->colorImageData)
+      free(frame->colorImageData);
+    frame->colorImageData = copy;
     frame->width = width;
     frame->height = height;
     frame->colorPitch = pitch;
-    memcpy(frame->colorImageData, imageData, pitch * height);
   }
 }
 
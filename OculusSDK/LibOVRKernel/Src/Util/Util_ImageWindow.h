@@ -30,6 +30,7 @@ limitations under the License.
 #if defined(OVR_OS_WIN32)
 #include "Kernel/OVR_Win32_IncludeWindows.h"
 #include <d2d1.h>
+#include <d3d10.h> // ID3D10Multithread
 #include <dwrite.h>
 #endif
 
@@ -39,6 +40,9 @@ limitations under the License.
 #include "Kernel/OVR_Deque.h"
 
 #include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <thread>
 
 namespace OVR {
 namespace Util {
@@ -98,17 +102,31 @@ class Frame : virtual public RefCountBaseV<Frame> {
 };
 
 #if defined(OVR_OS_WIN32)
+// Frames are double buffered: producers fill the back frame, and Complete hands it on as the
+// pending frame, so they only ever hold the lock for a pointer swap. Presenting takes the pending
+// frame and draws it outside that lock. A frame completed before the previous one was presented
+// replaces it, and is counted as dropped, so a slow presenter never backs up the producers.
+//
+// Frames are presented by Process, on the rendering thread, or by StartPresentThread's thread.
 class ImageWindow {
   HWND hWindow;
   ID2D1RenderTarget* pRT;
   D2D1_SIZE_U resolution;
 
-  std::unique_ptr<Mutex> frontBufferMutex;
+  std::unique_ptr<Mutex> frontBufferMutex; // Guards backFrame and pendingFrame
+  std::unique_ptr<Mutex> presentMutex; // Serializes drawing to pRT
 
-  InPlaceMutableDeque<Ptr<Frame>> frames;
+  Ptr<Frame> backFrame; // Being filled by the producers
+  Ptr<Frame> pendingFrame; // Completed, and not yet presented
+  std::atomic<uint32_t> droppedFrameCount;
 
   ID2D1Bitmap* greyBitmap;
   ID2D1Bitmap* colorBitmap;
+  ID3D10Multithread* deviceMultithread; // The surface's device
+
+  Event frameReadyEvent;
+  std::atomic<bool> presentThreadQuit;
+  std::unique_ptr<std::thread> presentThread;
 
  public:
   // constructors
@@ -134,6 +152,16 @@ class ImageWindow {
 
   void AssociateSurface(void* surface);
 
+  // Presents frames as they're completed from a thread of our own, after which Process does
+  // nothing. Call after AssociateSurface; the surface's device is made multithread protected.
+  bool StartPresentThread();
+  void StopPresentThread();
+
+  // Frames completed and then replaced before they could be presented.
+  uint32_t GetDroppedFrameCount() const {
+    return droppedFrameCount.load(std::memory_order_relaxed);
+  }
+
   void addCircle(float x, float y, float radius, float r, float g, float b, bool fill);
   void addText(float x, float y, float r, float g, float b, OVR::String text);
 
@@ -146,6 +174,7 @@ class ImageWindow {
 
  private:
   Ptr<Frame> lastUnreadyFrame();
+  void PresentThreadProc();
 
   static const int MaxWindows = 4;
   static ImageWindow* globalWindow[MaxWindows];
@@ -197,6 +226,15 @@ class ImageWindow {
     OVR_UNUSED(surface);
   }
 
+  bool StartPresentThread() {
+    return false;
+  }
+  void StopPresentThread() {}
+
+  uint32_t GetDroppedFrameCount() const {
+    return 0;
+  }
+
   void addCircle(float x, float y, float radius, float r, float g, float b, bool fill) {
     OVR_UNUSED(x);
     OVR_UNUSED(y);
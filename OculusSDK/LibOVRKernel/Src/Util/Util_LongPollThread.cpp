@@ -28,16 +28,55 @@ limitations under the License.
 #include "Util_LongPollThread.h"
 #include "Util_Watchdog.h"
 
+#include <algorithm>
+
 OVR_DEFINE_SINGLETON(OVR::Util::LongPollThread);
 
 namespace OVR {
 namespace Util {
 
-void LongPollThread::AddPollFunc(CallbackListener<PollFunc>* func) {
-  PollSubject.AddListener(func);
+static uint64_t GetPollMsTime() {
+  return Timer::GetTicksNanos() / 1000000;
+}
+
+// Orders DueHeap so that the earliest due group is at the front.
+bool LongPollThread::IsDueLater(const PollGroup* a, const PollGroup* b) {
+  return a->DueMsec > b->DueMsec;
+}
+
+// Returns the first multiple of the interval after both now and the current due time, so a group
+// which was called early isn't called again at its original due time.
+static uint64_t GetNextDueMsec(uint64_t nowMsec, uint64_t dueMsec, int intervalMsec) {
+  return ((std::max(nowMsec, dueMsec) / intervalMsec) + 1) * intervalMsec;
+}
+
+void LongPollThread::AddPollFunc(CallbackListener<PollFunc>* func, int intervalMsec) {
+  intervalMsec = std::max(intervalMsec, 1);
+
+  Lock::Locker locker(&GroupLock);
+
+  auto it = std::find_if(Groups.begin(), Groups.end(), [intervalMsec](const auto& group) {
+    return group->IntervalMsec == intervalMsec;
+  });
+
+  if (it == Groups.end()) {
+    PollGroup* group = new PollGroup;
+    group->IntervalMsec = intervalMsec;
+    group->DueMsec = GetNextDueMsec(GetPollMsTime(), 0, intervalMsec);
+    Groups.emplace_back(group);
+    it = Groups.end() - 1;
+
+    DueHeap.push_back(group);
+    std::push_heap(DueHeap.begin(), DueHeap.end(), IsDueLater);
+
+    // The new group may be due before the thread would otherwise wake.
+    WakeEvent.SetEvent();
+  }
+
+  (*it)->Subject.AddListener(func);
 }
 
-LongPollThread::LongPollThread() : Terminated(false) {
+LongPollThread::LongPollThread() : Terminated(false), WakeAll(false) {
   LongPollThreadHandle = std::make_unique<std::thread>([this] { this->Run(); });
 
   // Must be at end of function
@@ -55,6 +94,7 @@ void LongPollThread::OnThreadDestroy() {
 }
 
 void LongPollThread::Wake() {
+  WakeAll.store(true, std::memory_order_relaxed);
   WakeEvent.SetEvent();
 }
 
@@ -70,14 +110,47 @@ void LongPollThread::OnSystemDestroy() {
 void LongPollThread::Run() {
   Thread::SetCurrentThreadName("LongPoll");
   WatchDog watchdog("LongPoll");
+  std::vector<PollGroup*> dueGroups;
 
   // While not terminated,
   do {
-    watchdog.Feed(10000);
+    watchdog.Feed(MaxSleepMsec + 10000);
+
+    int sleepMsec = MaxSleepMsec;
+    dueGroups.clear();
+
+    {
+      Lock::Locker locker(&GroupLock);
+
+      const uint64_t nowMsec = GetPollMsTime();
+      const bool wakeAll = WakeAll.exchange(false, std::memory_order_relaxed);
+
+      // Take the groups which are due, or nearly so.
+      while (!DueHeap.empty()) {
+        PollGroup* group = DueHeap.front();
+        if (!wakeAll && (group->DueMsec > (nowMsec + (group->IntervalMsec / CoalesceDivisor))))
+          break;
+
+        std::pop_heap(DueHeap.begin(), DueHeap.end(), IsDueLater);
+        DueHeap.pop_back();
+        dueGroups.push_back(group);
+      }
+
+      for (PollGroup* group : dueGroups) {
+        group->DueMsec = GetNextDueMsec(nowMsec, group->DueMsec, group->IntervalMsec);
+        DueHeap.push_back(group);
+        std::push_heap(DueHeap.begin(), DueHeap.end(), IsDueLater);
+      }
+
+      if (!DueHeap.empty() && (DueHeap.front()->DueMsec < (nowMsec + MaxSleepMsec)))
+        sleepMsec = (int)(std::max(DueHeap.front()->DueMsec, nowMsec) - nowMsec);
+    }
 
-    PollSubject.Call();
+    // Groups are never removed, so they can be called without the lock held.
+    for (PollGroup* group : dueGroups)
+      group->Subject.Call();
 
-    WakeEvent.Wait(WakeupInterval);
+    WakeEvent.Wait(sleepMsec);
     WakeEvent.ResetEvent();
   } while (!Terminated.load(std::memory_order_acquire));
 }
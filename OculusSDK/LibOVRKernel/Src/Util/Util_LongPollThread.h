@@ -33,7 +33,10 @@ limitations under the License.
 #include "Kernel/OVR_System.h"
 #include "Kernel/OVR_Threads.h"
 #include "Kernel/OVR_Callbacks.h"
+#include "Kernel/OVR_InplaceFunction.h"
+#include <memory>
 #include <thread>
+#include <vector>
 
 namespace OVR {
 namespace Util {
@@ -41,28 +44,52 @@ namespace Util {
 //-----------------------------------------------------------------------------
 // LongPollThread
 
-// This thread runs long-polling subsystems that wake up every second or so
+// This thread runs long-polling subsystems, each at its own interval.
 // The motivation is to reduce the number of threads that are running to minimize the risk of
 // deadlock
+// The thread sleeps until the next poll function is due. Functions with the same interval are
+// called together, and due times are multiples of the interval, so that functions whose intervals
+// are multiples of each other share wakeups. A function due shortly after a wakeup is called early
+// with it rather than waking up again.
 class LongPollThread : public SystemSingletonBase<LongPollThread> {
   OVR_DECLARE_SINGLETON(LongPollThread);
   virtual void OnThreadDestroy() override;
 
  public:
-  typedef Delegate0<void> PollFunc;
-  static const int WakeupInterval = 1000; // milliseconds
+  typedef InplaceFunction<void()> PollFunc; // May be a capturing lambda.
+  static const int WakeupInterval = 1000; // milliseconds, the default poll interval
 
-  void AddPollFunc(CallbackListener<PollFunc>* func);
+  // Calls func about every intervalMsec milliseconds.
+  void AddPollFunc(CallbackListener<PollFunc>* func, int intervalMsec = WakeupInterval);
 
+  // Calls all the poll functions now, regardless of when they're next due.
   void Wake();
 
   // debug method for assertion to maintain initialization order for this singleton
   static bool IsInitialized();
 
  protected:
-  CallbackEmitter<PollFunc> PollSubject;
+  // The poll functions which share an interval.
+  struct PollGroup {
+    int IntervalMsec;
+    uint64_t DueMsec;
+    CallbackEmitter<PollFunc> Subject;
+  };
+
+  // The longest the thread sleeps with nothing due, so that its WatchDog stays fed.
+  static const int MaxSleepMsec = 5000;
+
+  // A group due within this fraction of its interval after a wakeup is called with it.
+  static const int CoalesceDivisor = 8;
+
+  Lock GroupLock; // Guards Groups and DueHeap.
+  std::vector<std::unique_ptr<PollGroup>> Groups;
+  std::vector<PollGroup*> DueHeap; // Min-heap of Groups by DueMsec.
+
+  static bool IsDueLater(const PollGroup* a, const PollGroup* b);
 
   std::atomic<bool> Terminated;
+  std::atomic<bool> WakeAll;
   Event WakeEvent;
   std::unique_ptr<std::thread> LongPollThreadHandle;
 
@@ -0,0 +1,241 @@
+/************************************************************************************
+
+Filename    :   Util_MemorySampler.cpp
+Content     :   Periodic process memory sampling on the LongPollThread
+Created     :   October 14, 2026
+Notes       :
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "Util_MemorySampler.h"
+#include "Util_SystemInfo.h"
+#include "Kernel/OVR_Timer.h"
+#include <Logging/Logging_Library.h>
+#include <algorithm>
+
+#if defined(_WIN32)
+#include "Kernel/OVR_Win32_IncludeWindows.h"
+#include <dxgi1_4.h>
+#endif
+
+namespace OVR {
+namespace Util {
+
+static ovrlog::Channel Logger("Kernel:MemorySampler");
+
+// Adds a sample to stats, keeping sums in place of the averages.
+static void AddToStatSums(MemoryStat& stat, uint64_t value, bool first) {
+  stat.Min = first ? value : std::min(stat.Min, value);
+  stat.Max = first ? value : std::max(stat.Max, value);
+  stat.Avg = first ? value : (stat.Avg + value);
+}
+
+static void AddToStatsSums(MemorySampleStats& stats, const MemorySample& sample) {
+  const bool first = (stats.SampleCount == 0);
+  if (first)
+    stats.FirstTimeNs = sample.TimeNs;
+  stats.LastTimeNs = sample.TimeNs;
+  AddToStatSums(stats.Resident, sample.ResidentBytes, first);
+  AddToStatSums(stats.Committed, sample.CommittedBytes, first);
+  AddToStatSums(stats.Gpu, sample.GpuBytes, first);
+  stats.SampleCount++;
+}
+
+// Turns the sums left by AddToStatsSums into averages.
+static void FinishStatsSums(MemorySampleStats& stats) {
+  if (stats.SampleCount) {
+    stats.Resident.Avg /= stats.SampleCount;
+    stats.Committed.Avg /= stats.SampleCount;
+    stats.Gpu.Avg /= stats.SampleCount;
+  }
+}
+
+//-----------------------------------------------------------------------------
+// MemorySampler
+
+MemorySampler::MemorySampler(int intervalMsec, size_t capacity, size_t logInterval)
+    : IntervalMsec(std::max(intervalMsec, 1)),
+      LogInterval(logInterval),
+      PollListener(),
+      SampleLock(),
+      Ring(std::max(capacity, (size_t)1)),
+      WriteCount(0),
+      Window() {
+#if defined(_WIN32)
+  GpuAdaptersOpened = false;
+#endif
+
+  PollListener.SetHandler([this] { SampleNow(); });
+}
+
+MemorySampler::~MemorySampler() {
+  PollListener.Cancel();
+
+#if defined(_WIN32)
+  for (void* adapter : GpuAdapters)
+    static_cast<IDXGIAdapter3*>(adapter)->Release();
+#endif
+}
+
+void MemorySampler::Start() {
+  if (!PollListener.IsListening()) {
+    LongPollThread* pollThread = LongPollThread::GetInstance();
+    if (pollThread)
+      pollThread->AddPollFunc(&PollListener, IntervalMsec);
+  }
+}
+
+void MemorySampler::Stop() {
+  PollListener.Cancel();
+}
+
+void MemorySampler::ReadGpuBytes(MemorySample& sample) {
+#if defined(_WIN32)
+  // Called with SampleLock held, so the adapters are only opened once.
+  if (!GpuAdaptersOpened) {
+    GpuAdaptersOpened = true;
+
+    // Loaded dynamically so that linking LibOVRKernel doesn't require dxgi.lib.
+    typedef HRESULT(WINAPI * CreateDXGIFactory1Func)(REFIID, void**);
+    HMODULE dxgi = ::LoadLibraryW(L"dxgi.dll");
+    CreateDXGIFactory1Func createFactory = dxgi
+        ? reinterpret_cast<CreateDXGIFactory1Func>(::GetProcAddress(dxgi, "CreateDXGIFactory1"))
+        : nullptr;
+    IDXGIFactory1* factory = nullptr;
+
+    if (createFactory && SUCCEEDED(createFactory(__uuidof(IDXGIFactory1), (void**)&factory))) {
+      IDXGIAdapter1* adapter = nullptr;
+      for (UINT i = 0; factory->EnumAdapters1(i, &adapter) != DXGI_ERROR_NOT_FOUND; ++i) {
+        IDXGIAdapter3* adapter3 = nullptr;
+        // IDXGIAdapter3 requires Windows 10. Without it GPU usage is reported as 0.
+        if (SUCCEEDED(adapter->QueryInterface(__uuidof(IDXGIAdapter3), (void**)&adapter3)))
+          GpuAdapters.push_back(adapter3);
+        adapter->Release();
+      }
+      factory->Release();
+    }
+    // dxgi.dll is left loaded, as the adapters depend on it.
+  }
+
+  for (void* adapter : GpuAdapters) {
+    DXGI_QUERY_VIDEO_MEMORY_INFO info;
+    IDXGIAdapter3* adapter3 = static_cast<IDXGIAdapter3*>(adapter);
+    if (SUCCEEDED(adapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info)))
+      sample.GpuBytes += info.CurrentUsage;
+    if (SUCCEEDED(adapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &info)))
+      sample.GpuBytes += info.CurrentUsage;
+  }
+#else
+  OVR_UNUSED(sample);
+#endif
+}
+
+void MemorySampler::SampleNow() {
+  const ProcessMemoryInfo pmi = GetCurrentProcessMemoryInfo();
+
+  MemorySample sample = {};
+  sample.ResidentBytes = pmi.UsedMemory;
+  sample.CommittedBytes = pmi.CommittedMemory;
+
+  MemorySampleStats window = {};
+  bool logWindow = false;
+
+  {
+    Lock::Locker locker(&SampleLock);
+
+    ReadGpuBytes(sample);
+    sample.TimeNs = Timer::GetTicksNanos();
+
+    Ring[(size_t)(WriteCount % Ring.size())] = sample;
+    WriteCount++;
+
+    if (LogInterval) {
+      AddToStatsSums(Window, sample);
+      if (Window.SampleCount >= LogInterval) {
+        window = Window;
+        Window = MemorySampleStats();
+        logWindow = true;
+      }
+    }
+  }
+
+  if (logWindow) {
+    FinishStatsSums(window);
+
+    Logger.LogEvent(
+        ovrlog::Level::Info,
+        "MemorySamples",
+        ovrlog::Field("count", (uint64_t)window.SampleCount),
+        ovrlog::Field("seconds", (window.LastTimeNs - window.FirstTimeNs) / 1e9),
+        ovrlog::Field("residentMin", window.Resident.Min),
+        ovrlog::Field("residentMax", window.Resident.Max),
+        ovrlog::Field("residentAvg", window.Resident.Avg),
+        ovrlog::Field("commitMin", window.Committed.Min),
+        ovrlog::Field("commitMax", window.Committed.Max),
+        ovrlog::Field("commitAvg", window.Committed.Avg),
+        ovrlog::Field("gpuMin", window.Gpu.Min),
+        ovrlog::Field("gpuMax", window.Gpu.Max),
+        ovrlog::Field("gpuAvg", window.Gpu.Avg));
+  }
+}
+
+size_t MemorySampler::GetSamples(MemorySample* samples, size_t capacity) const {
+  Lock::Locker locker(&SampleLock);
+
+  const uint64_t held = std::min<uint64_t>(WriteCount, Ring.size());
+  const size_t count = (size_t)std::min<uint64_t>(held, capacity);
+
+  for (size_t i = 0; i < count; ++i)
+    samples[i] = Ring[(size_t)((WriteCount - count + i) % Ring.size())];
+
+  return count;
+}
+
+MemorySampleStats MemorySampler::GetStats() const {
+  MemorySampleStats stats = {};
+
+  Lock::Locker locker(&SampleLock);
+
+  const uint64_t held = std::min<uint64_t>(WriteCount, Ring.size());
+  for (uint64_t i = WriteCount - held; i < WriteCount; ++i)
+    AddToStatsSums(stats, Ring[(size_t)(i % Ring.size())]);
+
+  FinishStatsSums(stats);
+  return stats;
+}
+
+void MemorySampler::Clear() {
+  Lock::Locker locker(&SampleLock);
+  WriteCount = 0;
+  Window = MemorySampleStats();
+}
+
+MemorySampleStats MemorySampler::ComputeStats(const MemorySample* samples, size_t count) {
+  MemorySampleStats stats = {};
+
+  for (size_t i = 0; i < count; ++i)
+    AddToStatsSums(stats, samples[i]);
+
+  FinishStatsSums(stats);
+  return stats;
+}
+
+} // namespace Util
+} // namespace OVR
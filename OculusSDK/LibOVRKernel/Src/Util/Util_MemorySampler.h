@@ -0,0 +1,140 @@
+/************************************************************************************
+
+Filename    :   Util_MemorySampler.h
+Content     :   Periodic process memory sampling on the LongPollThread
+Created     :   October 14, 2026
+Notes       :
+    MemorySampler records the process resident set, commit and GPU memory usage at a fixed
+    interval from the LongPollThread, into a ring of the most recent samples. Every so many
+    samples it logs a "MemorySamples" structured event with the min/max/avg of each value over
+    those samples, so growth over a long session shows up in the log without an external
+    profiler.
+
+        MemorySampler sampler; // Each second, logging a summary each minute.
+        sampler.Start();
+        ...
+        MemorySampleStats stats = sampler.GetStats();
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Oculus VR Rift SDK License Version 3.3 (the "License");
+you may not use the Oculus VR Rift SDK except in compliance with the License,
+which is provided at the time of installation or download, or which
+otherwise accompanies this software in either electronic or hard copy form.
+
+You may obtain a copy of the License at
+
+http://www.oculusvr.com/licenses/LICENSE-3.3
+
+Unless required by applicable law or agreed to in writing, the Oculus VR SDK
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef OVR_Util_MemorySampler_h
+#define OVR_Util_MemorySampler_h
+
+#include "Kernel/OVR_Types.h"
+#include "Kernel/OVR_Threads.h"
+#include "Util_LongPollThread.h"
+#include <vector>
+
+namespace OVR {
+namespace Util {
+
+//-----------------------------------------------------------------------------
+// MemorySample
+
+struct MemorySample {
+  uint64_t TimeNs; // Timer::GetTicksNanos
+  uint64_t ResidentBytes; // ProcessMemoryInfo::UsedMemory
+  uint64_t CommittedBytes; // ProcessMemoryInfo::CommittedMemory
+  uint64_t GpuBytes; // Video memory used by this process, or 0 where unknown.
+};
+
+struct MemoryStat {
+  uint64_t Min;
+  uint64_t Max;
+  uint64_t Avg;
+};
+
+struct MemorySampleStats {
+  size_t SampleCount; // If 0 then the other values are 0.
+  uint64_t FirstTimeNs;
+  uint64_t LastTimeNs;
+  MemoryStat Resident;
+  MemoryStat Committed;
+  MemoryStat Gpu;
+};
+
+//-----------------------------------------------------------------------------
+// MemorySampler
+//
+// Samples are taken on the LongPollThread, and may be read from any thread.
+//
+class MemorySampler {
+  OVR_NON_COPYABLE(MemorySampler)
+
+ public:
+  static const int DefaultIntervalMsec = 1000;
+  static const size_t DefaultCapacity = 3600; // An hour at the default interval
+  static const size_t DefaultLogInterval = 60; // Samples per logged event. 0 disables logging.
+
+  MemorySampler(
+      int intervalMsec = DefaultIntervalMsec,
+      size_t capacity = DefaultCapacity,
+      size_t logInterval = DefaultLogInterval);
+  ~MemorySampler();
+
+  // Starts or stops sampling on the LongPollThread. Recorded samples are kept.
+  void Start();
+  void Stop();
+  bool IsRunning() const {
+    return PollListener.IsListening();
+  }
+
+  // Takes a sample now, on the calling thread.
+  void SampleNow();
+
+  // Copies up to capacity of the most recent samples to samples, oldest first.
+  // Returns the number copied.
+  size_t GetSamples(MemorySample* samples, size_t capacity) const;
+
+  // Returns stats over the samples the ring holds.
+  MemorySampleStats GetStats() const;
+
+  // Discards the recorded samples.
+  void Clear();
+
+  // Returns stats over samples[0, count).
+  static MemorySampleStats ComputeStats(const MemorySample* samples, size_t count);
+
+ protected:
+  void ReadGpuBytes(MemorySample& sample);
+
+  int IntervalMsec;
+  size_t LogInterval;
+  CallbackListener<LongPollThread::PollFunc> PollListener;
+
+  mutable Lock SampleLock; // Guards the members below.
+  std::vector<MemorySample> Ring;
+  uint64_t WriteCount; // Samples ever written; Ring[WriteCount % Ring.size()] is next.
+
+  // Stats of the samples since the last logged event, with sums in place of the averages until
+  // the event is logged.
+  MemorySampleStats Window;
+
+#if defined(_WIN32)
+  // IDXGIAdapter3 for each adapter, opened on first use. Kept opaque to avoid DXGI headers here.
+  std::vector<void*> GpuAdapters;
+  bool GpuAdaptersOpened;
+#endif
+};
+
+} // namespace Util
+} // namespace OVR
+
+#endif // OVR_Util_MemorySampler_h
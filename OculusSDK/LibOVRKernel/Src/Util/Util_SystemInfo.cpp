@@ -33,6 +33,12 @@ limitations under the License.
 #include "Kernel/OVR_Error.h"
 #include <locale>
 #include <codecvt>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <stdio.h>
+#include <string.h>
+#include <thread>
 
 #if defined(OVR_OS_LINUX)
 #include <sys/utsname.h>
@@ -2174,6 +2180,21 @@ ProcessMemoryInfo GetCurrentProcessMemoryInfo() {
     pmi.UsedMemory = (uint64_t)pmce.WorkingSetSize; // The set of pages in the virtual address space
     // of the process that are currently resident in
     // physical memory.
+    pmi.CommittedMemory = (uint64_t)pmce.PrivateUsage;
+  }
+#elif defined(OVR_OS_LINUX)
+  // statm reports, in pages: size resident shared text lib data dt
+  FILE* file = fopen("/proc/self/statm", "r");
+  if (file) {
+    unsigned long long size, resident, shared, text, lib, data;
+    const int fieldCount = fscanf(
+        file, "%llu %llu %llu %llu %llu %llu", &size, &resident, &shared, &text, &lib, &data);
+    if (fieldCount == 6) {
+      const uint64_t pageSize = (uint64_t)sysconf(_SC_PAGESIZE);
+      pmi.UsedMemory = resident * pageSize;
+      pmi.CommittedMemory = data * pageSize;
+    }
+    fclose(file);
   }
 #else
 // To do: Implement this.
@@ -2468,10 +2489,282 @@ bool ModuleInfoLookup::GetAddressIsFromCurrentModule(uint64_t address) {
   return (mi && (mi->baseAddress == miCurrent.baseAddress));
 }
 
+//-----------------------------------------------------------------------------
+// SystemInfoCollector
+//
+// Owns the thread which collects SystemInfoSnapshots, and the latest one collected.
+//
+
+class SystemInfoCollector : public SystemSingletonBase<SystemInfoCollector> {
+  OVR_DECLARE_SINGLETON(SystemInfoCollector);
+
+ public:
+  std::shared_ptr<const SystemInfoSnapshot> GetSnapshot();
+  std::shared_ptr<const SystemInfoSnapshot> WaitForSnapshot(unsigned timeoutMs);
+  void Refresh();
+
+ protected:
+  void OnThreadDestroy() override;
+  void Run();
+  void Publish(const std::shared_ptr<SystemInfoSnapshot>& snapshot);
+
+  Lock SnapshotLock;
+  std::shared_ptr<const SystemInfoSnapshot> Snapshot; // Guarded by SnapshotLock
+  uint32_t PublishCount; // Guarded by SnapshotLock
+  Event PublishedEvent; // Set once the first snapshot is published
+  Event WakeEvent;
+  std::atomic<bool> Terminated;
+  std::unique_ptr<std::thread> CollectorThread;
+};
+
+static const char kSystemInfoCacheHeader[] = "OVRSystemInfoCache 1";
+
+// Returns an id which differs on each boot of the system, or an empty string if it can't be
+// determined, in which case snapshots aren't saved or read back.
+static std::string GetBootId() {
+#if defined(_WIN32)
+  DWORD bootId = 0;
+  DWORD size = sizeof(bootId);
+  if (RegGetValueW(
+          HKEY_LOCAL_MACHINE,
+          L"SYSTEM\\CurrentControlSet\\Control\\Session Manager\\Memory Management\\"
+          L"PrefetchParameters",
+          L"BootId",
+          RRF_RT_REG_DWORD,
+          nullptr,
+          &bootId,
+          &size) == ERROR_SUCCESS)
+    return std::to_string(bootId);
+  return std::string();
+#elif defined(OVR_OS_LINUX)
+  char bootId[64] = {};
+  FILE* file = fopen("/proc/sys/kernel/random/boot_id", "r");
+  if (file) {
+    if (!fgets(bootId, sizeof(bootId), file))
+      bootId[0] = '\0';
+    fclose(file);
+  }
+  bootId[strcspn(bootId, "\r\n")] = '\0';
+  return std::string(bootId);
+#else
+  return std::string();
+#endif
+}
+
+static std::string GetSystemInfoCachePath() {
+#if defined(_WIN32)
+  return std::string(GetBaseOVRPath(true).ToCStr()) + "\\SystemInfoCache.txt";
+#else
+  return std::string(GetBaseOVRPath(true).ToCStr()) + "/SystemInfoCache.txt";
+#endif
+}
+
+// Writes one "name value" line. Values are single lines, so any line breaks become spaces.
+static bool WriteSystemInfoLine(FILE* file, const char* name, const String& value) {
+  std::string line(value.ToCStr());
+  std::replace(line.begin(), line.end(), '\n', ' ');
+  std::replace(line.begin(), line.end(), '\r', ' ');
+  return fprintf(file, "%s %s\n", name, line.c_str()) > 0;
+}
+
+static bool SaveSystemInfoSnapshot(const std::string& path, const SystemInfoSnapshot& snapshot) {
+  // Write to a temporary file and move it into place, so no process reads a partial snapshot.
+  const std::string tempPath = path + ".tmp";
+  FILE* file = fopen(tempPath.c_str(), "w");
+  if (!file)
+    return false;
+
+  bool success = (fprintf(file, "%s\n", kSystemInfoCacheHeader) > 0) &&
+      WriteSystemInfoLine(file, "Key", String(snapshot.Key.c_str())) &&
+      WriteSystemInfoLine(file, "OSVersion", snapshot.OSVersion) &&
+      WriteSystemInfoLine(file, "CameraDriverVersion", snapshot.CameraDriverVersion) &&
+      WriteSystemInfoLine(file, "ProcessorInfo", snapshot.ProcessorInfo) &&
+      WriteSystemInfoLine(file, "MachineTags", snapshot.MachineTags);
+
+  for (size_t i = 0; success && (i < snapshot.GraphicsCards.size()); ++i)
+    success = WriteSystemInfoLine(file, "GraphicsCard", snapshot.GraphicsCards[i]);
+
+  success = (fclose(file) == 0) && success;
+
+  if (success) {
+    remove(path.c_str());
+    success = (rename(tempPath.c_str(), path.c_str()) == 0);
+  }
+  if (!success)
+    remove(tempPath.c_str());
+
+  return success;
+}
+
+// Reads back a saved snapshot. Returns false if there is none, or if it was saved under a
+// different key.
+static bool LoadSystemInfoSnapshot(
+    const std::string& path,
+    const std::string& key,
+    SystemInfoSnapshot& snapshot) {
+  FILE* file = fopen(path.c_str(), "r");
+  if (!file)
+    return false;
+
+  char line[1024];
+  bool success = fgets(line, sizeof(line), file) &&
+      (strncmp(line, kSystemInfoCacheHeader, strlen(kSystemInfoCacheHeader)) == 0);
+  bool keyMatched = false;
+
+  while (success && fgets(line, sizeof(line), file)) {
+    line[strcspn(line, "\r\n")] = '\0';
+
+    char* value = strchr(line, ' ');
+    if (!value)
+      continue;
+    *value++ = '\0';
+
+    if (strcmp(line, "Key") == 0) {
+      keyMatched = (key == value);
+      success = keyMatched;
+    } else if (strcmp(line, "OSVersion") == 0)
+      snapshot.OSVersion = value;
+    else if (strcmp(line, "CameraDriverVersion") == 0)
+      snapshot.CameraDriverVersion = value;
+    else if (strcmp(line, "ProcessorInfo") == 0)
+      snapshot.ProcessorInfo = value;
+    else if (strcmp(line, "MachineTags") == 0)
+      snapshot.MachineTags = value;
+    else if (strcmp(line, "GraphicsCard") == 0)
+      snapshot.GraphicsCards.push_back(String(value));
+  }
+
+  fclose(file);
+
+  if (!success || !keyMatched)
+    return false;
+
+  snapshot.Key = key;
+  snapshot.FromDisk = true;
+  return true;
+}
+
+static void CollectSystemInfoSnapshot(SystemInfoSnapshot& snapshot) {
+  snapshot.OSVersion = OSVersionAsString();
+  snapshot.CameraDriverVersion = GetCameraDriverVersion();
+  snapshot.ProcessorInfo = GetProcessorInfo();
+
+  Array<String> gpus;
+  GetGraphicsCardList(gpus);
+  for (size_t i = 0; i < gpus.GetSize(); ++i)
+    snapshot.GraphicsCards.push_back(gpus[i]);
+
+#if defined(_WIN32)
+  snapshot.MachineTags = GetMachineTags();
+#endif
+}
+
+SystemInfoCollector::SystemInfoCollector() : PublishCount(0), Terminated(false) {
+  CollectorThread = std::make_unique<std::thread>([this] { this->Run(); });
+
+  // Must be at end of function
+  PushDestroyCallbacks();
+}
+
+SystemInfoCollector::~SystemInfoCollector() {
+  OVR_ASSERT(!CollectorThread->joinable());
+}
+
+void SystemInfoCollector::OnThreadDestroy() {
+  Terminated.store(true, std::memory_order_relaxed);
+  WakeEvent.SetEvent();
+
+  CollectorThread->join();
+}
+
+void SystemInfoCollector::OnSystemDestroy() {
+  delete this;
+}
+
+std::shared_ptr<const SystemInfoSnapshot> SystemInfoCollector::GetSnapshot() {
+  Lock::Locker locker(&SnapshotLock);
+  return Snapshot;
+}
+
+std::shared_ptr<const SystemInfoSnapshot> SystemInfoCollector::WaitForSnapshot(
+    unsigned timeoutMs) {
+  PublishedEvent.Wait(timeoutMs);
+  return GetSnapshot();
+}
+
+void SystemInfoCollector::Refresh() {
+  WakeEvent.SetEvent();
+}
+
+void SystemInfoCollector::Publish(const std::shared_ptr<SystemInfoSnapshot>& snapshot) {
+  {
+    Lock::Locker locker(&SnapshotLock);
+    snapshot->Version = ++PublishCount;
+    Snapshot = snapshot;
+  }
+
+  PublishedEvent.SetEvent();
+}
+
+void SystemInfoCollector::Run() {
+  Thread::SetCurrentThreadName("SystemInfo");
+
+  const std::string path = GetSystemInfoCachePath();
+
+  // The saved snapshot is only used for the first collection; a refresh always collects.
+  for (bool useSaved = true;; useSaved = false) {
+    // The key is collected here as well, as reading the driver version touches the disk.
+    const std::string bootId = GetBootId();
+    const std::string key =
+        bootId.empty() ? std::string() : (bootId + " " + GetCameraDriverVersion().ToCStr());
+
+    std::shared_ptr<SystemInfoSnapshot> snapshot = std::make_shared<SystemInfoSnapshot>();
+
+    if (!useSaved || key.empty() || !LoadSystemInfoSnapshot(path, key, *snapshot)) {
+      *snapshot = SystemInfoSnapshot(); // Discard anything read before a mismatched key.
+      snapshot->Key = key;
+      CollectSystemInfoSnapshot(*snapshot);
+
+      if (!key.empty() && !SaveSystemInfoSnapshot(path, *snapshot))
+        OVR_DEBUG_LOG(("SystemInfoCollector: Unable to save %s", path.c_str()));
+    }
+
+    Publish(snapshot);
+
+    WakeEvent.Wait();
+    WakeEvent.ResetEvent();
+
+    if (Terminated.load(std::memory_order_relaxed))
+      break;
+  }
+}
+
+void StartSystemInfoCollection() {
+  SystemInfoCollector::GetInstance();
+}
+
+std::shared_ptr<const SystemInfoSnapshot> GetSystemInfoSnapshot() {
+  SystemInfoCollector* collector = SystemInfoCollector::GetInstance();
+  return collector ? collector->GetSnapshot() : nullptr;
+}
+
+std::shared_ptr<const SystemInfoSnapshot> WaitForSystemInfoSnapshot(unsigned timeoutMs) {
+  SystemInfoCollector* collector = SystemInfoCollector::GetInstance();
+  return collector ? collector->WaitForSnapshot(timeoutMs) : nullptr;
+}
+
+void RefreshSystemInfo() {
+  SystemInfoCollector* collector = SystemInfoCollector::GetInstance();
+  if (collector)
+    collector->Refresh();
+}
+
 } // namespace Util
 
 } // namespace OVR
 
+OVR_DEFINE_SINGLETON(OVR::Util::SystemInfoCollector);
+
 #if defined(_WIN32)
 OVR_DEFINE_SINGLETON(OVR::Util::PdhHelper);
 #endif
@@ -31,6 +31,7 @@ limitations under the License.
 #include "Kernel/OVR_Types.h"
 #include "Kernel/OVR_Array.h"
 #include "Kernel/OVR_DebugHelp.h"
+#include <memory>
 #include <vector>
 #include <set>
 #include <string>
@@ -420,6 +421,7 @@ String GetSystemFileVersionStringW(const wchar_t filePath[MAX_PATH]);
 struct ProcessMemoryInfo {
   uint64_t UsedMemory; // Same as Windows working set size.
   // https://msdn.microsoft.com/en-us/library/windows/desktop/cc441804%28v=vs.85%29.aspx
+  uint64_t CommittedMemory; // Private commit on Windows, data segment size on Linux.
 };
 
 ProcessMemoryInfo GetCurrentProcessMemoryInfo();
@@ -483,6 +485,46 @@ class ModuleInfoLookup {
 
 extern ModuleInfoLookup DefaultModuleInfoLookup;
 
+//-----------------------------------------------------------------------------
+// SystemInfoSnapshot
+//
+// The slower of the system info above, collected together in the background so that callers
+// don't wait on driver and registry queries. A snapshot is saved under GetBaseOVRPath, keyed by
+// the boot id and the camera driver version (the kernel release on Linux), and later processes
+// started in the same boot with the same driver read it back instead of collecting it again.
+//
+// Example usage:
+//     StartSystemInfoCollection(); // Early in startup; returns immediately.
+//     ...
+//     std::shared_ptr<const SystemInfoSnapshot> info = GetSystemInfoSnapshot();
+//     if (info) // Null until the first snapshot is available.
+//       LogText("OS version: %s\n", info->OSVersion.ToCStr());
+//
+struct SystemInfoSnapshot {
+  uint32_t Version; // Incremented each time this process publishes a snapshot.
+  bool FromDisk; // True if it was read back from a snapshot saved by an earlier process.
+  std::string Key; // Boot id and driver version. Empty if the boot id is unknown.
+  String OSVersion; // OSVersionAsString()
+  String CameraDriverVersion; // GetCameraDriverVersion()
+  String ProcessorInfo; // GetProcessorInfo()
+  std::vector<String> GraphicsCards; // GetGraphicsCardList()
+  String MachineTags; // GetMachineTags()
+};
+
+// Starts collecting on a background thread, if that hasn't already started.
+void StartSystemInfoCollection();
+
+// Returns the latest snapshot, or null if there isn't one yet. Starts collecting if needed.
+// Never blocks on the collection.
+std::shared_ptr<const SystemInfoSnapshot> GetSystemInfoSnapshot();
+
+// As GetSystemInfoSnapshot, but waits up to timeoutMs for the first snapshot.
+std::shared_ptr<const SystemInfoSnapshot> WaitForSystemInfoSnapshot(unsigned timeoutMs);
+
+// Collects again in the background, ignoring the saved snapshot. Until the new snapshot is
+// published the accessors return the previous one.
+void RefreshSystemInfo();
+
 } // namespace Util
 } // namespace OVR
 
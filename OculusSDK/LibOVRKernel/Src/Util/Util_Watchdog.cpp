@@ -29,6 +29,7 @@ limitations under the License.
 #include <Logging/Logging_Library.h>
 
 #include "Kernel/OVR_DebugHelp.h"
+#include "Kernel/OVR_FlightRecorder.h"
 #include "Kernel/OVR_Win32_IncludeWindows.h"
 
 #if defined(OVR_OS_LINUX) || defined(OVR_OS_MAC)
@@ -60,6 +61,11 @@ static uint32_t GetFastMsTime() {
 #endif
 }
 
+// Time base of the timer wheel, which unlike GetFastMsTime doesn't wrap.
+static uint64_t GetWheelMsTime() {
+  return Timer::GetTicksNanos() / 1000000;
+}
+
 static std::string SanitizeString(const char* cstr) {
   std::ostringstream ss;
   char ch;
@@ -79,6 +85,7 @@ static ovrlog::Channel Logger("Kernel:Watchdog");
 WatchDogObserver::WatchDogObserver()
     : ListLock(),
       DogList(),
+      WheelTick(GetWheelMsTime() / WheelTickMsec),
       IsReporting(false),
       TerminationEvent(),
       DeadlockSeen(false),
@@ -98,7 +105,9 @@ WatchDogObserver::~WatchDogObserver() {
 
 void WatchDogObserver::OnThreadDestroy() {
   Logger.LogDebug("Setting TerminationEvent for watchdog thread.");
+  Terminated.store(true, std::memory_order_relaxed);
   TerminationEvent.SetEvent();
+  WakeEvent.SetEvent();
 
   WatchdogThreadHandle->join();
 }
@@ -126,6 +135,15 @@ void WatchDogObserver::OnDeadlock(const String& deadlockedThreadName) {
           "\n---END OF DEADLOCK STATE---");
     }
 
+    String flightRecorderOutput;
+    FlightRecorder::Dump(
+        [](void* context, const char* line) { *static_cast<String*>(context) += line; },
+        &flightRecorderOutput);
+    Logger.LogWarning(
+        "---FLIGHT RECORDER---\n\n",
+        flightRecorderOutput.ToCStr(),
+        "\n---END OF FLIGHT RECORDER---");
+
     // For internal builds done by our engineers, we write minidumps as per the settings below. We
     // don't generate breakpad minidumps nor upload breakpad crash reports. For non-internal builds
     // (typically public builds), we generate breakpad mindumps and will upload them as necessary.
@@ -169,80 +187,209 @@ void WatchDogObserver::OnDeadlock(const String& deadlockedThreadName) {
   }
 }
 
+// Milliseconds between checks of a dog which is overdue
+static const int kWakeupIntervalMsec = 4000; // 4 seconds
+
+// Number of consecutive long cycles before the watchdog dumps a minidump
+static const int kLongCycleTimeLimitMsec = 60000; // 1 minute
+static const int kMaxConsecutiveLongCycles = kLongCycleTimeLimitMsec / kWakeupIntervalMsec;
+
 int WatchDogObserver::Run() {
   Thread::SetCurrentThreadName("WatchDog");
 
   Logger.LogDebug("Starting watchdog thread");
 
-  // Milliseconds between checks
-  static const int kWakeupIntervalMsec = 4000; // 4 seconds
-
-  // Number of consecutive long cycles before the watchdog dumps a minidump
-  static const int kLongCycleTimeLimitMsec = 60000; // 1 minute
-  static const int kMaxConsecutiveLongCycles = kLongCycleTimeLimitMsec / kWakeupIntervalMsec;
-
-  // By counting consecutive long cycles instead of using a timeout, we prevent false positives
-  // from debugger breakpoints and sleep/resume of the OS.
-  int ConsecutiveLongCycles = 0; // Number of long cycles seen in a row
-
   // While not requested to terminate:
-  while (!TerminationEvent.Wait(kWakeupIntervalMsec)) {
-    bool sawLongCycle = false;
+  while (!Terminated.load(std::memory_order_acquire)) {
     String deadlockedThreadName;
+    uint32_t sleepMsec;
 
     {
       Lock::Locker locker(&ListLock);
 
-      const uint32_t t1 = GetFastMsTime();
+      const uint64_t nowWheelMs = GetWheelMsTime();
+      deadlockedThreadName = CheckDueDogs(GetFastMsTime(), nowWheelMs);
+      sleepMsec = GetSleepMilliseconds(nowWheelMs);
 
-      const int count = DogList.GetSizeI();
-      for (int i = 0; i < count; ++i) {
-        WatchDog* dog = DogList[i];
+      // Reset deadlock seen flag
+      if (LongCycleDogCount == 0)
+        DeadlockSeen = false;
+    }
 
-        const int threshold = dog->ThreshholdMilliseconds;
-        const uint32_t t0 = dog->WhenLastFedMilliseconds;
+    // Since it requires consecutive long cycles, waking up from sleep/resume will not trigger a
+    // deadlock.
+    if (!deadlockedThreadName.IsEmpty())
+      OnDeadlock(deadlockedThreadName);
 
-        // If threshold exceeded, assume there is thread deadlock of some sort.
-        int delta = static_cast<int>(t1 - t0);
+    WakeEvent.Wait(sleepMsec);
+    WakeEvent.ResetEvent();
+  }
 
-        // Include an upper bound in case the computer went to sleep
-        if (delta > threshold && (ConsecutiveLongCycles > 0 || delta < threshold * 5)) {
-          sawLongCycle = true;
+  Logger.LogDebug("Terminating watchdog thread");
 
-          deadlockedThreadName = dog->ThreadName;
-          Logger.LogWarning(
-              "Long cycle detected ",
-              ConsecutiveLongCycles + 1,
-              "x (max=",
-              kMaxConsecutiveLongCycles,
-              ") in thread '",
-              deadlockedThreadName,
-              "'");
-        }
+  return 0;
+}
+
+String WatchDogObserver::CheckDueDogs(uint32_t nowMs, uint64_t nowWheelMs) {
+  const uint64_t nowTick = nowWheelMs / WheelTickMsec;
+  WatchDog* dueList = nullptr;
+
+  auto takeSlot = [&dueList](WatchDog*& slot) {
+    while (slot) {
+      WatchDog* dog = slot;
+      slot = dog->WheelNext;
+      dog->WheelSlot = nullptr;
+      dog->WheelNext = dueList;
+      dueList = dog;
+    }
+  };
+
+  if ((nowTick - WheelTick) >= (uint64_t)WheelSlotCount * WheelSlotCount) {
+    // We haven't run for longer than the wheel spans, so everything is due.
+    for (auto& level : WheelSlots)
+      for (WatchDog*& slot : level)
+        takeSlot(slot);
+    WheelTick = nowTick;
+  }
+
+  while (WheelTick < nowTick) {
+    ++WheelTick;
+
+    // Entering a new span of level 0, so spread the level 1 slot for it over level 0.
+    if ((WheelTick % WheelSlotCount) == 0) {
+      WatchDog* cascadeList = nullptr;
+      std::swap(cascadeList, WheelSlots[1][(WheelTick / WheelSlotCount) % WheelSlotCount]);
+
+      while (cascadeList) {
+        WatchDog* dog = cascadeList;
+        cascadeList = dog->WheelNext;
+        dog->WheelSlot = nullptr;
+        FileDog(dog, dog->WheelDueTick);
       }
     }
 
-    // If we did not see a long cycle:
-    if (!sawLongCycle) {
-      if (ConsecutiveLongCycles > 0) {
+    takeSlot(WheelSlots[0][WheelTick % WheelSlotCount]);
+  }
+
+  String deadlockedThreadName;
+
+  while (dueList) {
+    WatchDog* dog = dueList;
+    dueList = dog->WheelNext;
+
+    const int threshold = dog->ThreshholdMilliseconds.load(std::memory_order_relaxed);
+    const uint32_t t0 = dog->WhenLastFedMilliseconds.load(std::memory_order_relaxed);
+
+    // If threshold exceeded, assume there is thread deadlock of some sort.
+    const int delta = static_cast<int>(nowMs - t0);
+
+    if (delta > threshold) {
+      // Include an upper bound in case the computer went to sleep
+      if ((dog->LongCycleCount > 0) || (delta < threshold * 5)) {
+        if (dog->LongCycleCount++ == 0)
+          LongCycleDogCount++;
+
+        Logger.LogWarning(
+            "Long cycle detected ",
+            dog->LongCycleCount,
+            "x (max=",
+            kMaxConsecutiveLongCycles,
+            ") in thread '",
+            dog->ThreadName,
+            "'");
+
+        if (dog->LongCycleCount >= kMaxConsecutiveLongCycles)
+          deadlockedThreadName = dog->ThreadName;
+      }
+
+      // Keep checking while it stays overdue, so that only a long cycle which persists counts
+      // as a deadlock.
+      FileDog(dog, (nowWheelMs + kWakeupIntervalMsec) / WheelTickMsec);
+    } else {
+      if (dog->LongCycleCount > 0) {
         // Reset log cycle count
-        ConsecutiveLongCycles = 0;
+        dog->LongCycleCount = 0;
+        LongCycleDogCount--;
 
-        Logger.LogWarning("Recovered from long cycles");
+        Logger.LogWarning("Recovered from long cycles in thread '", dog->ThreadName, "'");
       }
 
-      // Reset deadlock seen flag
-      DeadlockSeen = false;
-    } else if (++ConsecutiveLongCycles >= kMaxConsecutiveLongCycles) {
-      // Since it requires consecutive long cycles, waking up from sleep/resume will not trigger a
-      // deadlock.
-      OnDeadlock(deadlockedThreadName);
+      FileDog(dog, GetDueTick(dog, nowMs, nowWheelMs));
     }
   }
 
-  Logger.LogDebug("Terminating watchdog thread");
+  return deadlockedThreadName;
+}
 
-  return 0;
+uint32_t WatchDogObserver::GetSleepMilliseconds(uint64_t nowWheelMs) const {
+  uint64_t dueTick = 0;
+
+  for (uint32_t i = 1; (i < WheelSlotCount) && !dueTick; ++i) {
+    if (WheelSlots[0][(WheelTick + i) % WheelSlotCount])
+      dueTick = WheelTick + i;
+  }
+
+  // Otherwise wake up to cascade the next level 1 slot which has anything in it.
+  for (uint32_t i = 1; (i <= WheelSlotCount) && !dueTick; ++i) {
+    const uint64_t span = (WheelTick / WheelSlotCount) + i;
+    if (WheelSlots[1][span % WheelSlotCount])
+      dueTick = span * WheelSlotCount;
+  }
+
+  if (!dueTick) // If there are no dogs, sleep until one is added.
+    return OVR_WAIT_INFINITE;
+
+  const uint64_t dueMs = dueTick * WheelTickMsec;
+  return (dueMs > nowWheelMs) ? (uint32_t)(dueMs - nowWheelMs) : 0;
+}
+
+uint64_t WatchDogObserver::GetDueTick(const WatchDog* dog, uint32_t nowMs, uint64_t nowWheelMs)
+    const {
+  const uint32_t dueMs = dog->WhenLastFedMilliseconds.load(std::memory_order_relaxed) +
+      (uint32_t)dog->ThreshholdMilliseconds.load(std::memory_order_relaxed) + 1;
+  const int64_t dueWheelMs = (int64_t)nowWheelMs + static_cast<int32_t>(dueMs - nowMs);
+
+  return (dueWheelMs > 0) ? (((uint64_t)dueWheelMs + WheelTickMsec - 1) / WheelTickMsec) : 0;
+}
+
+void WatchDogObserver::FileDog(WatchDog* dog, uint64_t dueTick) {
+  OVR_ASSERT(!dog->WheelSlot);
+
+  WatchDog** slot;
+  dog->WheelDueTick = dueTick;
+
+  if (dueTick <= WheelTick) // If already due, check it on the next tick.
+    slot = &WheelSlots[0][(WheelTick + 1) % WheelSlotCount];
+  else if ((dueTick - WheelTick) < WheelSlotCount)
+    slot = &WheelSlots[0][dueTick % WheelSlotCount];
+  else if ((dueTick - WheelTick) < (uint64_t)WheelSlotCount * WheelSlotCount)
+    slot = &WheelSlots[1][(dueTick / WheelSlotCount) % WheelSlotCount];
+  else
+    slot = &WheelSlots[1][((WheelTick / WheelSlotCount) + WheelSlotCount - 1) % WheelSlotCount];
+
+  dog->WheelSlot = slot;
+  dog->WheelPrev = nullptr;
+  dog->WheelNext = *slot;
+  if (*slot)
+    (*slot)->WheelPrev = dog;
+  *slot = dog;
+}
+
+void WatchDogObserver::UnfileDog(WatchDog* dog) {
+  if (!dog->WheelSlot)
+    return;
+
+  if (dog->WheelPrev)
+    dog->WheelPrev->WheelNext = dog->WheelNext;
+  else
+    *dog->WheelSlot = dog->WheelNext;
+
+  if (dog->WheelNext)
+    dog->WheelNext->WheelPrev = dog->WheelPrev;
+
+  dog->WheelSlot = nullptr;
+  dog->WheelNext = nullptr;
+  dog->WheelPrev = nullptr;
 }
 
 void WatchDogObserver::Add(WatchDog* dog) {
@@ -251,6 +398,8 @@ void WatchDogObserver::Add(WatchDog* dog) {
   if (!dog->Listed) {
     DogList.PushBack(dog);
     dog->Listed = true;
+    FileDog(dog, GetDueTick(dog, GetFastMsTime(), GetWheelMsTime()));
+    WakeEvent.SetEvent();
   }
 }
 
@@ -264,10 +413,53 @@ void WatchDogObserver::Remove(WatchDog* dog) {
       }
     }
 
+    UnfileDog(dog);
+
+    if (dog->LongCycleCount > 0) {
+      dog->LongCycleCount = 0;
+      LongCycleDogCount--;
+    }
+
     dog->Listed = false;
   }
 }
 
+void WatchDogObserver::Reschedule(WatchDog* dog, int threshold) {
+  Lock::Locker locker(&ListLock);
+
+  dog->ThreshholdMilliseconds.store(threshold, std::memory_order_relaxed);
+
+  // An overdue dog is already being checked at the long cycle interval.
+  if (dog->Listed && (dog->LongCycleCount == 0)) {
+    UnfileDog(dog);
+    FileDog(dog, GetDueTick(dog, GetFastMsTime(), GetWheelMsTime()));
+    WakeEvent.SetEvent();
+  }
+}
+
+void WatchDogObserver::GetStats(std::vector<WatchDogStats>& stats) {
+  Lock::Locker locker(&ListLock);
+
+  const uint32_t nowMs = GetFastMsTime();
+  stats.resize(DogList.GetSize());
+
+  for (size_t i = 0; i < stats.size(); ++i) {
+    const WatchDog* dog = DogList[i];
+    WatchDogStats& dogStats = stats[i];
+
+    dogStats.ThreadName = dog->ThreadName;
+    dogStats.ThresholdMilliseconds = dog->ThreshholdMilliseconds.load(std::memory_order_relaxed);
+    dogStats.SinceLastFedMilliseconds =
+        nowMs - dog->WhenLastFedMilliseconds.load(std::memory_order_relaxed);
+    dogStats.LastIntervalMilliseconds =
+        dog->LastFeedIntervalMilliseconds.load(std::memory_order_relaxed);
+    dogStats.MaxIntervalMilliseconds =
+        dog->MaxFeedIntervalMilliseconds.load(std::memory_order_relaxed);
+    dogStats.FeedCount = dog->FeedCount.load(std::memory_order_relaxed);
+    dogStats.SlowFeedCount = dog->SlowFeedCount.load(std::memory_order_relaxed);
+  }
+}
+
 void WatchDogObserver::EnableReporting(const String organization, const String application) {
   OrganizationName = organization;
   ApplicationName = application;
@@ -299,11 +491,24 @@ void WatchDog::Enable() {
 }
 
 void WatchDog::Feed(int threshold) {
-  WhenLastFedMilliseconds = GetFastMsTime();
-  ThreshholdMilliseconds = threshold;
+  // Only this thread writes these, so they need no read-modify-write operations.
+  const uint32_t now = GetFastMsTime();
+  const uint32_t interval = now - WhenLastFedMilliseconds.load(std::memory_order_relaxed);
+  WhenLastFedMilliseconds.store(now, std::memory_order_relaxed);
+
+  LastFeedIntervalMilliseconds.store(interval, std::memory_order_relaxed);
+  if (interval > MaxFeedIntervalMilliseconds.load(std::memory_order_relaxed))
+    MaxFeedIntervalMilliseconds.store(interval, std::memory_order_relaxed);
+  FeedCount.store(FeedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  if (interval > static_cast<uint32_t>(threshold) / 2)
+    SlowFeedCount.store(
+        SlowFeedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
 
   if (!Listed) {
+    ThreshholdMilliseconds.store(threshold, std::memory_order_relaxed);
     Enable();
+  } else if (threshold != ThreshholdMilliseconds.load(std::memory_order_relaxed)) {
+    WatchDogObserver::GetInstance()->Reschedule(this, threshold);
   }
 }
 } // namespace Util
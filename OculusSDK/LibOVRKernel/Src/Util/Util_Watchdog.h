@@ -34,10 +34,27 @@ limitations under the License.
 #include "Kernel/OVR_System.h"
 #include "Kernel/OVR_Threads.h"
 #include <thread>
+#include <vector>
 
 namespace OVR {
 namespace Util {
 
+//-----------------------------------------------------------------------------
+// WatchDogStats
+//
+// Feed timing of a WatchDog, from WatchDogObserver::GetStats. A thread whose intervals creep
+// toward its threshold is at risk of being reported as deadlocked.
+
+struct WatchDogStats {
+  String ThreadName;
+  int ThresholdMilliseconds;
+  uint32_t SinceLastFedMilliseconds;
+  uint32_t LastIntervalMilliseconds; // Between the two most recent feeds.
+  uint32_t MaxIntervalMilliseconds; // Longest between feeds since the WatchDog was created.
+  uint64_t FeedCount;
+  uint64_t SlowFeedCount; // Feeds which came more than half the threshold after the previous one.
+};
+
 //-----------------------------------------------------------------------------
 // WatchDog
 
@@ -51,15 +68,29 @@ class WatchDog : public NewOverrideBase {
   void Disable();
   void Enable();
 
+  // Only the thread being watched may feed its WatchDog. Feeding with the same threshold as last
+  // time takes only relaxed stores; changing it reschedules the observer.
   void Feed(int threshold);
 
  protected:
-  // Use 32 bit int so assignment and comparison is atomic
+  // Written only by the fed thread, and read by the observer. Use 32 bit int so assignment and
+  // comparison is atomic.
   std::atomic<uint32_t> WhenLastFedMilliseconds = {0};
   std::atomic<int> ThreshholdMilliseconds = {0};
+  std::atomic<uint32_t> LastFeedIntervalMilliseconds = {0};
+  std::atomic<uint32_t> MaxFeedIntervalMilliseconds = {0};
+  std::atomic<uint64_t> FeedCount = {0};
+  std::atomic<uint64_t> SlowFeedCount = {0};
 
   String ThreadName;
   bool Listed;
+
+  // Observer state, guarded by WatchDogObserver::ListLock.
+  WatchDog* WheelNext = nullptr; // Within the timer wheel slot.
+  WatchDog* WheelPrev = nullptr;
+  WatchDog** WheelSlot = nullptr; // The slot this is filed in, or nullptr.
+  uint64_t WheelDueTick = 0;
+  int LongCycleCount = 0; // Consecutive checks which found this overdue.
 };
 
 //-----------------------------------------------------------------------------
@@ -108,10 +139,27 @@ class WatchDogObserver : public SystemSingletonBase<WatchDogObserver> {
     AddBreakpadInfoClient = pAddBreakpadInfoClient;
   }
 
+  // Writes the feed timing of every enabled WatchDog.
+  void GetStats(std::vector<WatchDogStats>& stats);
+
  protected:
   Lock ListLock;
   Array<WatchDog*> DogList;
 
+  // Hierarchical timer wheel of the listed WatchDogs, by when each is next due to be checked, so
+  // the observer sleeps until the earliest is due instead of scanning them all periodically. Level
+  // 0 slots are one tick long, and each level 1 slot spans all of level 0. Dogs due later than
+  // level 1 spans are filed in its last slot and refiled when it comes due. Guarded by ListLock.
+  static const uint32_t WheelTickMsec = 256;
+  static const uint32_t WheelSlotCount = 64;
+  WatchDog* WheelSlots[2][WheelSlotCount] = {};
+  uint64_t WheelTick = 0; // The last tick which has been processed.
+  int LongCycleDogCount = 0; // Dogs with a non-zero LongCycleCount.
+
+  // Wakes the observer to recompute how long to sleep.
+  Event WakeEvent;
+  std::atomic<bool> Terminated = {false};
+
   // This indicates that EnableReporting() was requested
   bool IsReporting = false;
 
@@ -137,6 +185,21 @@ class WatchDogObserver : public SystemSingletonBase<WatchDogObserver> {
 
   void Add(WatchDog* dog);
   void Remove(WatchDog* dog);
+
+  // Changes the threshold of a listed dog, which may make it due sooner than it was filed.
+  void Reschedule(WatchDog* dog, int threshold);
+
+  // Timer wheel operations. ListLock must be held.
+  void FileDog(WatchDog* dog, uint64_t dueTick);
+  void UnfileDog(WatchDog* dog);
+  uint64_t GetDueTick(const WatchDog* dog, uint32_t nowMs, uint64_t nowWheelMs) const;
+
+  // Checks the dogs which have come due, refiles them, and returns the name of a deadlocked
+  // thread if any. ListLock must be held.
+  String CheckDueDogs(uint32_t nowMs, uint64_t nowWheelMs);
+
+  // Returns the milliseconds until the next dog is due. ListLock must be held.
+  uint32_t GetSleepMilliseconds(uint64_t nowWheelMs) const;
 };
 } // namespace Util
 } // namespace OVR
@@ -40,6 +40,9 @@ limitations under the License.
 #include <unordered_map>
 #include <unordered_set>
 #include <mutex>
+#include <atomic>
+#include <type_traits>
+#include <string.h>
 #include <time.h>
 
 #pragma warning(push)
@@ -109,6 +112,26 @@ enum class Level : Log_Level_t
 };
 
 
+//-----------------------------------------------------------------------------
+// Build-time minimum log level
+//
+// Messages below LOGGING_MIN_LEVEL are removed at compile time. Channel::Active() is constant
+// false for them, the fixed-level functions such as LogTrace() and LogDebugF() compile to an
+// empty function without instantiating any formatting code, and the LOGGING_LOG_TRACE and
+// LOGGING_LOG_DEBUG macros below don't evaluate their arguments. The value is a Level as an
+// integer, so for example defining LOGGING_MIN_LEVEL=3 in a shipping build keeps only Info,
+// Warning and Error messages.
+
+#ifndef LOGGING_MIN_LEVEL
+    #define LOGGING_MIN_LEVEL 1 // Level::Trace, so nothing is removed.
+#endif
+
+constexpr bool IsLevelCompiledIn(Level level)
+{
+    return (Log_Level_t)level >= LOGGING_MIN_LEVEL;
+}
+
+
 //-----------------------------------------------------------------------------
 // Line of Code
 //
@@ -280,12 +303,266 @@ LOGGING_INLINE void LogStringize(LogStringBuffer& buffer, const std::wstring& fi
 }
 
 
+//-----------------------------------------------------------------------------
+// Deferred log arguments
+//
+// Channel::LogDeferredF() does not format on the calling thread. It records the format string
+// pointer and the raw argument values, and the OutputWorker thread does the printf formatting
+// when it writes the message out. The format string must therefore outlive the message; in
+// practice it must be a string literal in a module which stays loaded until the message has
+// been written (see OutputWorker::Flush).
+//
+// The arguments are encoded as a sequence of items, each a DeferredArgType byte followed by
+// the value: 4 bytes for Int32, 8 bytes for Int64, Double and Pointer, and for String a
+// uint32_t length, the characters and a terminating '\0'. Items use the writer's native byte
+// order. Only numbers, enums, pointers and narrow strings can be logged this way.
+
+enum class DeferredArgType : uint8_t
+{
+    Int32,
+    Int64,
+    Double,
+    Pointer,
+    String
+};
+
+struct DeferredArgWriter
+{
+    // Arguments which don't fit are dropped, and strings are cut to fit. The decoder prints the
+    // conversion specifications of dropped arguments as they appear in the format.
+    static const size_t Capacity = 1024;
+
+    char   Data[Capacity];
+    size_t Size;
+
+    DeferredArgWriter() : Size(0)
+    {
+    }
+
+    void WriteValue(DeferredArgType type, const void* value, size_t valueBytes)
+    {
+        if (Size + 1 + valueBytes > Capacity)
+            return;
+        Data[Size] = (char)type;
+        memcpy(Data + Size + 1, value, valueBytes);
+        Size += 1 + valueBytes;
+    }
+
+    void WriteString(const char* str, size_t length)
+    {
+        const size_t overhead = 1 + sizeof(uint32_t) + 1;
+        if (Size + overhead > Capacity)
+            return;
+        if (length > Capacity - (Size + overhead))
+            length = Capacity - (Size + overhead);
+
+        const uint32_t length32 = (uint32_t)length;
+        Data[Size] = (char)DeferredArgType::String;
+        memcpy(Data + Size + 1, &length32, sizeof(length32));
+        memcpy(Data + Size + 1 + sizeof(length32), str, length);
+        Data[Size + 1 + sizeof(length32) + length] = '\0';
+        Size += overhead + length;
+    }
+
+    void WriteString(const char* str)
+    {
+        if (!str)
+            str = "(null)";
+        WriteString(str, strlen(str));
+    }
+};
+
+LOGGING_INLINE void DeferredArgEncode(DeferredArgWriter& writer, const char* value)
+{
+    writer.WriteString(value);
+}
+
+LOGGING_INLINE void DeferredArgEncode(DeferredArgWriter& writer, char* value)
+{
+    writer.WriteString(value);
+}
+
+template<size_t N>
+LOGGING_INLINE void DeferredArgEncode(DeferredArgWriter& writer, const char(&value)[N])
+{
+    writer.WriteString(value);
+}
+
+LOGGING_INLINE void DeferredArgEncode(DeferredArgWriter& writer, const std::string& value)
+{
+    writer.WriteString(value.c_str(), value.size());
+}
+
+// Wide strings would be recorded as their pointer value. Convert them to UTF8 first.
+void DeferredArgEncode(DeferredArgWriter& writer, const wchar_t* value) = delete;
+void DeferredArgEncode(DeferredArgWriter& writer, wchar_t* value) = delete;
+
+template<typename T>
+LOGGING_INLINE typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+DeferredArgEncode(DeferredArgWriter& writer, const T& value)
+{
+    if (sizeof(T) <= sizeof(int32_t))
+    {
+        const int32_t value32 = (int32_t)value;
+        writer.WriteValue(DeferredArgType::Int32, &value32, sizeof(value32));
+    }
+    else
+    {
+        const int64_t value64 = (int64_t)value;
+        writer.WriteValue(DeferredArgType::Int64, &value64, sizeof(value64));
+    }
+}
+
+template<typename T>
+LOGGING_INLINE typename std::enable_if<std::is_floating_point<T>::value>::type
+DeferredArgEncode(DeferredArgWriter& writer, const T& value)
+{
+    const double valueDouble = (double)value;
+    writer.WriteValue(DeferredArgType::Double, &valueDouble, sizeof(valueDouble));
+}
+
+template<typename T>
+LOGGING_INLINE void DeferredArgEncode(DeferredArgWriter& writer, T* const& value)
+{
+    const uint64_t value64 = (uint64_t)(uintptr_t)value;
+    writer.WriteValue(DeferredArgType::Pointer, &value64, sizeof(value64));
+}
+
+// One decoded item of DeferredArgWriter data.
+struct DeferredArg
+{
+    DeferredArgType Type;
+    int64_t         Integer; // Int32, Int64 and Pointer
+    double          Double;
+    const char*     String;  // Null terminated
+};
+
+// Reads back the items written by a DeferredArgWriter.
+class DeferredArgReader
+{
+public:
+    DeferredArgReader(const char* data, size_t dataSize) :
+        Data(data),
+        Remaining(dataSize),
+        Malformed(false)
+    {
+    }
+
+    bool IsMalformed() const
+    {
+        return Malformed;
+    }
+
+    // Returns false at the end of the data, or if the data is malformed.
+    bool Read(DeferredArg& arg);
+
+private:
+    void advance(size_t bytes);
+    bool readBytes(void* value, size_t bytes);
+
+    const char* Data;
+    size_t      Remaining;
+    bool        Malformed;
+};
+
+// Formats a message recorded by Channel::LogDeferredF, whose encoded arguments are data. The
+// first item of data is the channel prefix, which is written before the formatted text.
+// Arguments which don't match their conversion are printed in their own default form.
+// This is what the OutputWorker thread uses, and it can be used to decode recorded messages
+// offline. Returns false if data is malformed, in which case output holds what was decoded.
+bool FormatDeferredLogMessage(const char* format, const char* data, size_t dataSize, std::string& output);
+
+
+//-----------------------------------------------------------------------------
+// Structured log events
+//
+// Channel::LogEvent() records a named event with typed fields, for tools which would otherwise
+// have to parse log text:
+//
+//     Log.LogEvent(Level::Info, "FrameStats", Field("fps", fps), Field("dropped", droppedCount));
+//
+// The event is encoded by a DeferredArgWriter on the calling thread, without building any
+// strings: the channel prefix and the event name as String items, then for each field its name
+// as a String item followed by its value. Field values can be anything LogDeferredF accepts.
+// Text plugins are given the event as a line such as: FrameStats fps=89.9 dropped=0
+// Plugins which want the typed values read OutputMessage::EventData with a LogEventReader,
+// as OutputEventJsonFile does.
+
+template<typename T>
+struct LogField
+{
+    const char* Name;
+    const T&    Value;
+};
+
+template<typename T>
+LOGGING_INLINE LogField<T> Field(const char* name, const T& value)
+{
+    return LogField<T>{ name, value };
+}
+
+template<typename T>
+LOGGING_INLINE void DeferredArgEncode(DeferredArgWriter& writer, const LogField<T>& field)
+{
+    writer.WriteString(field.Name);
+    DeferredArgEncode(writer, field.Value);
+}
+
+// Reads the fields of an event recorded by Channel::LogEvent.
+class LogEventReader
+{
+public:
+    LogEventReader(const char* data, size_t dataSize);
+
+    // The channel prefix, which is usually empty.
+    const char* GetPrefix() const
+    {
+        return Prefix;
+    }
+
+    const char* GetName() const
+    {
+        return EventName;
+    }
+
+    // Reads the next field. Returns false after the last field, or if the data is malformed.
+    bool Next(const char*& name, DeferredArg& value);
+
+    bool IsMalformed() const
+    {
+        return Reader.IsMalformed();
+    }
+
+private:
+    DeferredArgReader Reader;
+    const char*       Prefix;
+    const char*       EventName;
+};
+
+// Formats an event recorded by Channel::LogEvent as the channel prefix, the event name and
+// space separated name=value pairs, with string values quoted. Returns false if data is
+// malformed, in which case output holds what was decoded.
+bool FormatLogEvent(const char* data, size_t dataSize, std::string& output);
+
+
 //-----------------------------------------------------------------------------
 // Log Output Worker Thread
 //
 // Worker thread that produces the output.
 // Call AddPlugin() to register an output plugin.
 
+// One message passed to OutputPlugin::WriteBatch
+struct OutputMessage
+{
+    Level       MessageLogLevel;
+    const char* SubsystemName;
+    const char* Header;
+    const char* Utf8Msg;
+    LogTime     Time;
+    const char* EventData;     // If this is a Channel::LogEvent, its LogEventReader data, else nullptr
+    size_t      EventDataSize;
+};
+
 // User-defined output plugin
 class OutputPlugin
 {
@@ -297,6 +574,17 @@ public:
 
     // Write data to output.
     virtual void Write(Level level, const char* subsystem, const char* header, const char* utf8msg) = 0;
+
+    // Write a batch of messages, in order. The worker thread writes everything it has queued
+    // through this, so a plugin which can output several messages with one call (one file or
+    // console write) should override it. The default calls Write() for each message.
+    virtual void WriteBatch(const OutputMessage* messages, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            Write(messages[i].MessageLogLevel, messages[i].SubsystemName, messages[i].Header, messages[i].Utf8Msg);
+        }
+    }
 };
 
 
@@ -344,13 +632,13 @@ enum class WriteOption : Write_Option_t
 //
 // Design
 //    In our HandleMessage function:
-//    For every message we receive, we look at the last N messages received and see if this message
-//    appears to be a duplicate of any of the previous ones. We make that decision by first checking
-//    if the text of the message matches an entry in a hash table of known currently repeating 
-//    messages. If not present then we make that decision based on the text of the message being 
-//    similar to message text of the last N received messages and being received within some period
-//    of time since the last similar message. It it appears to be a repeat, then we add it to the 
-//    hash table. 
+//    For every message we receive, we see if this message appears to be a duplicate of a recent
+//    one. Messages are identified by a hash of their subsystem name and the first N characters of
+//    their text. We make that decision by first checking if the hash matches an entry in a table
+//    of known currently repeating messages. If not present then we look the hash up in a table of
+//    recently seen messages, each of which has a count that halves for every period of time in
+//    which the message wasn't seen. If the count says it was seen recently, then it appears to be
+//    a repeat and we move it to the table of repeating messages.
 //
 //    In our Poll function:
 //    Each message in the hash table has a repeat count, which is the number of times
@@ -362,16 +650,14 @@ enum class WriteOption : Write_Option_t
 //    amount of time.
 //
 //    Performance considerations:
-//    The list of N previously received messages represents the biggest potential performance cost 
-//    to this functionality. We need to check the currently incoming message against each of the 
-//    last N messages. That check needs to be fast, and the maintenance of the data structure
-//    which holds that data (e.g. container heap usage) needs to be fast. One fairly fast solution 
-//    is to maintain the last N messages as a hash table of string hashes, and so when a new message
-//    is received, we do an O(1) hash table lookup. But we need to continuously prune the hash table,
-//    which is an O(n) operation unless we have some kind of priority_queue alongside the hash  
-//    table which tells us how to quickly find the oldest entries in the hash table. A simpler  
-//    solution is to prune the hash table only when it gets beyond N*2 messages. So we only do 
-//    this O(n) pass periodically.
+//    HandleMessage is called for every message, including when a subsystem is flooding the log,
+//    so its cost must not grow with the amount of logging. Both tables are fixed-size arrays
+//    which are allocated once. A message may live in only the <tableProbeCount> slots following
+//    its hash's home slot, so a lookup compares at most that many entries and never needs to
+//    prune. When a recent message needs a slot and all of them are taken, the least recently
+//    seen one is replaced. When a repeating message needs a slot and all of them are busy
+//    aggregating, it is just printed. The stored text of repeating messages is truncated at
+//    <maxRepeatedMessageLength>, so memory use has a hard upper bound however noisy things get.
 //
 class RepeatedMessageManager {
 public:
@@ -417,8 +703,18 @@ public:
   void RemoveRepeatedMessageSubsytemException(const char* subsystemName);
 
 protected:
-  // Keep the last <recentMessageCount> messages to see if any of them are repeated.
-  static const uint32_t recentMessageCount = 40;
+  // Number of slots in the table of recently seen messages. Must be a power of two.
+  static const uint32_t recentMessageTableSize = 256;
+
+  // Number of slots in the table of repeating messages. Must be a power of two.
+  static const uint32_t repeatedMessageTableSize = 64;
+
+  // Number of consecutive slots, starting at its hash's home slot, in which a message can be
+  // stored. This is the most entries a lookup in either table compares.
+  static const uint32_t tableProbeCount = 8;
+
+  // Max length of the repeated message text we keep for the aggregate printing.
+  static const uint32_t maxRepeatedMessageLength = 1024;
 
   // The number of leading characters in a message which we consider for comparisons.
   static const uint32_t messagePrefixLength = 36;
@@ -438,7 +734,8 @@ protected:
   // prune any old entries that don't look like they are repeating any more.
   static const uint32_t purgeDeferredMessageTimeMs = 100;
 
-  // String hash used to identify similar messages.
+  // String hash used to identify similar messages. Zero is never used for a message, and marks
+  // an empty table slot.
   typedef uint32_t PrefixHashType;
 
   // For our uses we don't want LogTime, which is a calendar time that's hard and slow to work
@@ -446,23 +743,22 @@ protected:
   // is absolute milliseconds which can derived from a LogTime.
   typedef int64_t LogTimeMs;
 
-  // Stores a recently generated message. It doesn't store the entire message string,
-  // as we care only about the first N characters of messages. We store the last M messages
-  // ever received in a list of RecentMessages. That way we can tell if there was a recent repeat.
-  // To consider: we don't currently consider the subsystem name as part of the uniqueness of the 
-  // string. We may want or need to do this, but it's very unlikely two strings would be the same
-  // while coming from separate subsystems.
+  // Stores a recently generated message. It doesn't store the message string, as we care only
+  // about the hash of its subsystem and first N characters. That way we can tell if there was a
+  // recent repeat.
   struct RecentMessage
   {
-    LogTimeMs timeMs; // Time that the message was generated.
-                      // Don't need to store the message or message prefix itself, though it may help debugging.
+    PrefixHashType hash; // Message hash, or 0 if this slot is empty.
+    LogTimeMs timeMs;    // Time that the message was last seen.
+    uint32_t count;      // Number of times seen, halved for every maxDeferrableDetectionTimeMs
+                         // that passed without the message being seen.
   };
-  typedef std::unordered_map<PrefixHashType, RecentMessage> RecentMessageMapType;
 
   // Represents a message which has been identified as being repeated. This struct allows us to
   // know how many times the message was repeated, when it was first seen, etc.
   struct RepeatedMessage
   {
+    PrefixHashType hash;         // Message hash, or 0 if this slot is empty.
     std::string subsystemName;   // To consider: Convert to char [16]
     Level messageLogLevel;       // log level, e.g. Level::Trace.
     std::string stream;          // The first message of the repeated set.
@@ -471,16 +767,9 @@ protected:
     uint32_t aggregatedCount;    // Number of times this message was aggregated for later.
     uint32_t printedCount;       // Number of times this message has been 'printed';
                                  //  aggregate printing counts multiple times towards this.
-    RepeatedMessage() : subsystemName(), messageLogLevel(), stream(),
+    RepeatedMessage() : hash(), subsystemName(), messageLogLevel(), stream(),
       initialTimeMs(), lastTimeMs(), aggregatedCount(), printedCount() {}
-    RepeatedMessage(const char* subsystemName_, Level messageLogLevel_, const char* stream_,
-      LogTimeMs initialTimeMs_, LogTimeMs lastTimeMs_,
-      uint32_t aggregatedCount_)
-      : subsystemName(subsystemName_), messageLogLevel(messageLogLevel_), stream(stream_),
-      initialTimeMs(initialTimeMs_), lastTimeMs(lastTimeMs_), aggregatedCount(aggregatedCount_),
-      printedCount() {}
   };
-  typedef std::unordered_map<PrefixHashType, RepeatedMessage> RepeatedMessageMapType;
 
   // Prints a message that's an aggregate deferred printing.
   void PrintDeferredAggregateMessage(OutputWorker* outputWorker, RepeatedMessage& repeatedMessage);
@@ -488,6 +777,22 @@ protected:
   // Calculates a hash for the given string for at most <messagePrefixLength> characters.
   static PrefixHashType GetHash(const char* str);
 
+  // Combines the subsystem name and message prefix hashes into the never-zero table key.
+  static PrefixHashType GetMessageHash(PrefixHashType subsystemNameHash, PrefixHashType prefixHash);
+
+  // Returns count halved once for every maxDeferrableDetectionTimeMs in elapsedMs.
+  static uint32_t GetDecayedCount(uint32_t count, int64_t elapsedMs);
+
+  // Returns the RepeatedMessageTable entry for hash, or nullptr if there is none.
+  RepeatedMessage* FindRepeatedMessage(PrefixHashType hash);
+
+  // Returns an empty RepeatedMessageTable slot for hash, or nullptr if all of its slots are used.
+  RepeatedMessage* AllocRepeatedMessage(PrefixHashType hash);
+
+  // Returns the RecentMessageTable entry for hash. If there is none then returns an empty slot for
+  // it, or else the least recently seen of its slots, with hash set to 0 in either case.
+  RecentMessage* FindRecentMessage(PrefixHashType hash, LogTimeMs currentLogTimeMs);
+
   // Gets the current LogTime in LogTimeMs.
   static LogTimeMs GetCurrentLogMillisecondTime();
 
@@ -505,11 +810,9 @@ protected:
   // prevent there being a problem if that external code unexpectedly calls us back.
   bool BusyInWrite;
 
-  // To do: Get a fixed-size node allocator working with this container for low overhead.
-  RecentMessageMapType RecentMessageMap;
-
-  // To consider: Get a fixed-size node allocator working with this container for low overhead.
-  RepeatedMessageMapType RepeatedMessageMap;
+  // Open-addressed tables indexed by the low bits of the message hash.
+  std::array<RecentMessage, recentMessageTableSize> RecentMessageTable;
+  std::array<RepeatedMessage, repeatedMessageTableSize> RepeatedMessageTable;
 
   // We don't need to store the string, just the string hash.
   std::unordered_set<PrefixHashType> RepeatedMessageExceptionSet;
@@ -548,6 +851,12 @@ extern "C"
     OVR_EXPORTED_FUNCTION extern void OutputWorkerOutputFunctionC(const char* subsystemName, Log_Level_t messageLogLevel, const char* stream, bool relogged, Write_Option_t option);
     typedef void(*OutputWorkerOutputFunctionType)(const char* subsystemName, Log_Level_t messageLogLevel, const char* stream, bool relogged, Write_Option_t option);
 
+    OVR_EXPORTED_FUNCTION extern void OutputWorkerDeferredOutputFunctionC(const char* subsystemName, Log_Level_t messageLogLevel, const char* format, const char* data, size_t dataSize, Write_Option_t option);
+    typedef void(*OutputWorkerDeferredOutputFunctionType)(const char* subsystemName, Log_Level_t messageLogLevel, const char* format, const char* data, size_t dataSize, Write_Option_t option);
+
+    OVR_EXPORTED_FUNCTION extern void OutputWorkerEventOutputFunctionC(const char* subsystemName, Log_Level_t messageLogLevel, const char* data, size_t dataSize, Write_Option_t option);
+    typedef void(*OutputWorkerEventOutputFunctionType)(const char* subsystemName, Log_Level_t messageLogLevel, const char* data, size_t dataSize, Write_Option_t option);
+
     OVR_EXPORTED_FUNCTION extern void ConfiguratorOnChannelLevelChangeC(const char* channelName, Log_Level_t minimumOutputLevel);
     typedef void(*ConfiguratorOnChannelLevelChangeType)(const char* channelName, Log_Level_t minimumOutputLevel);
 
@@ -567,6 +876,7 @@ void RestartLogging();
 // Log Output Worker Thread
 class OutputWorker
 {
+    friend class Configurator;
     OutputWorker(); // Use GetInstance() to get the singleton instance.
 
 public:
@@ -588,6 +898,12 @@ public:
 
     void Write(const char* subsystemName, Level messageLogLevel, const char* stream, bool relogged, WriteOption option);
 
+    // Write a message whose formatting is left to the worker thread; see DeferredArgWriter.
+    void WriteDeferred(const char* subsystemName, Level messageLogLevel, const char* format, const char* data, size_t dataSize, WriteOption option);
+
+    // Write a structured event recorded by Channel::LogEvent; see LogEventReader.
+    void WriteEvent(const char* subsystemName, Level messageLogLevel, const char* data, size_t dataSize, WriteOption option);
+
     // Plugin management
     void AddPlugin(std::shared_ptr<OutputPlugin> plugin);
     void RemovePlugin(std::shared_ptr<OutputPlugin> plugin);
@@ -616,46 +932,149 @@ private:
     Lock PluginsLock;
     std::set< std::shared_ptr<OutputPlugin> > Plugins;
 
+    // Copy of Plugins taken by ProcessQueuedMessages(), which writes to the plugins without
+    // holding PluginsLock. Consumer only.
+    std::vector< std::shared_ptr<OutputPlugin> > PluginsSnapshot;
+
+    struct ThreadBuffer;
+
     // Worker Log Buffer
     struct QueuedLogMessage
     {
-        const Name        SubsystemName;
-        const Level       MessageLogLevel;
-        std::string       Buffer;
-        LogTime           Time;
-        QueuedLogMessage* Next;
-        OvrLogHandle      FlushEvent;
-
-        QueuedLogMessage(const char* subsystemName, Level messageLogLevel, const char* stream, const LogTime& time);
+        Name                           SubsystemName;
+        Level                          MessageLogLevel;
+        std::string                    Buffer;
+        LogTime                        Time;
+        int64_t                        Tick;         // Steady clock time at which it was queued, see ThreadBuffer
+        std::atomic<QueuedLogMessage*> Next;
+        OvrLogHandle                   FlushEvent;
+        const char*                    DeferredFormat; // If set, Buffer holds DeferredArgWriter data to format with it
+        bool                           IsEvent;      // If set, Buffer holds the LogEventReader data of an event
+        bool                           IsPooled;     // True if this is one of MessagePool's slots
+        ThreadBuffer*                  OwnerBuffer;  // The ThreadBuffer this is a slot of, if any
+        std::atomic<uint32_t>          NextFreeSlot; // Free list link, see MessagePool
+
+        QueuedLogMessage();
+        void Set(const char* subsystemName, Level messageLogLevel, const char* stream, const LogTime& time);
+        void SetDeferred(const char* subsystemName, Level messageLogLevel, const char* format, const char* data, size_t dataSize, const LogTime& time);
+        void SetLogEvent(const char* subsystemName, Level messageLogLevel, const char* data, size_t dataSize, const LogTime& time);
     };
 
+    // Number of preallocated message slots. Slots keep their Buffer allocation when recycled,
+    // so in steady state queuing a message does not touch the heap. When every slot is in use
+    // messages are heap allocated instead, up to WorkQueueLimit queued messages in total.
+    static const int MessagePoolSize = 1024;
+
+    // Recycled slot buffers larger than this are released rather than kept.
+    static const size_t MaxPooledBufferBytes = 4096;
+
     // Maximum number of logs that we allow in the queue at a time.
     // If we go beyond this limit, we keep a count of additional logs that were lost.
-    static const int WorkQueueLimit = 1000;
-
-    AutoHandle        WorkerWakeEvent;      // Event letting the worker thread know the queue is not empty
-    Lock              WorkQueueLock;        // Lock guarding the work queue
-    QueuedLogMessage* WorkQueueHead;        // Head of linked list of work that is queued
-    QueuedLogMessage* WorkQueueTail;        // Tail of linked list of work that is queued
-    int               WorkQueueSize;        // Size of the linked list of queued work
-    int               WorkQueueOverrun;     // Number of log messages that exceeded the limit
+    static const int WorkQueueLimit = 16384;
+
+    // Preallocated message slots, and a lock-free stack of the free ones. FreeSlotTop holds the
+    // index + 1 of the top free slot (0 when none are free) in its low 32 bits and a counter,
+    // bumped on every push, in its high 32 bits so a stale pop cannot succeed (ABA).
+    std::unique_ptr<QueuedLogMessage[]> MessagePool;
+    std::atomic<uint64_t> FreeSlotTop;
+
+    QueuedLogMessage* AllocMessage(bool ignoreQueueLimit);
+    void FreeMessage(QueuedLogMessage* msg);
+
+    // Each thread which logs gets a single-producer, single-consumer ring of message slots, so
+    // that writers on different threads don't contend with each other. A message is stamped with
+    // a steady clock Tick as it is queued, and ProcessQueuedMessages() merges the rings (and the
+    // work queue below) by Tick, oldest first. LogTime is too coarse to order by (a millisecond
+    // on Windows, a second elsewhere). Order is kept between the messages which have been queued
+    // by the time the worker reaches them; a message stamped just before another thread's but
+    // queued just after it may be written after it.
+    //
+    // Buffers are adopted by new threads when their thread exits, and are never freed, as a
+    // thread may exit during or after the OutputWorker's static destruction. Threads beyond the
+    // first MaxThreadBuffers, and messages which find their ring full, use the work queue.
+    static const uint32_t ThreadBufferSize = 128; // A power of two
+    static const int MaxThreadBuffers = 64;
+
+    struct ThreadBuffer
+    {
+        QueuedLogMessage      Slots[ThreadBufferSize];
+        std::atomic<uint32_t> Tail;          // Count of messages queued; written by the owner thread
+        std::atomic<uint32_t> Head;          // Count of slots released back to the owner, in FreeMessage()
+        uint32_t              ReadIndex;     // Count of messages taken by the consumer; consumer only
+        uint32_t              ReadTail;      // Tail as last read by the consumer; consumer only
+        std::atomic<bool>     Owned;         // True while a thread is writing to this buffer
+        ThreadBuffer*         NextBuffer;    // Next in the ThreadBuffers list; set before it is pushed
+
+        ThreadBuffer();
+    };
+
+    // Holds the current thread's ThreadBuffer, releasing it for reuse when the thread exits.
+    struct ThreadBufferReference
+    {
+        ThreadBuffer* Buffer;
+        bool          Exited; // Set on thread exit, or if there was no buffer for it; the thread then uses the work queue
+
+        ~ThreadBufferReference();
+    };
+
+    static thread_local ThreadBufferReference CurrentThreadBuffer;
+
+    std::atomic<ThreadBuffer*> ThreadBuffers;     // Push-only list of all buffers
+    std::atomic<int>           ThreadBufferCount;
+    std::atomic<bool>          WorkerIdle;        // Set while the worker thread is about to wait, see WorkerThreadEntrypoint()
+
+    // Returns the next free slot of the current thread's ring, or nullptr if the ring is full or
+    // the thread can't have one.
+    QueuedLogMessage* AllocThreadMessage();
+
+    // Returns the current thread's ThreadBuffer, adopting or creating one on first use.
+    ThreadBuffer* GetThreadBuffer();
+
+    // Stamps msg and queues it, on its ring if it has one or else on the work queue, and wakes
+    // the worker thread if needed.
+    void QueueMessage(QueuedLogMessage* msg);
+
+    // Returns the oldest queued message of the rings, or nullptr if there is none. Consumer only.
+    QueuedLogMessage* PeekThreadMessage(ThreadBuffer*& messageBuffer);
+
+    // True if any ring has a message the consumer hasn't taken yet.
+    bool HasThreadMessages();
+
+    static int64_t GetCurrentLogTick();
+
+    // The work queue is an intrusive multiple-producer, single-consumer linked list (Vyukov).
+    // Writers append by exchanging WorkQueueTail and then linking the previous tail to the new
+    // message, so Write() never takes a lock. Only the thread running ProcessQueuedMessages(),
+    // which holds WorkQueueConsumerLock, reads from WorkQueueHead. WorkQueueStub is a permanent
+    // node so the list is never empty.
+    AutoHandle                     WorkerWakeEvent;       // Event letting the worker thread know the queue is not empty
+    Lock                           WorkQueueConsumerLock; // Lock serializing the queue consumers (worker thread, Stop())
+    QueuedLogMessage               WorkQueueStub;         // Permanent list node
+    QueuedLogMessage*              WorkQueueHead;         // Oldest node; consumer only
+    std::atomic<QueuedLogMessage*> WorkQueueTail;         // Newest node; producers exchange this
+    std::atomic<int>               WorkQueueSize;         // Number of queued messages, including ones still being linked
+    std::atomic<int>               WorkQueueOverrun;      // Number of log messages that exceeded the limit
     // The work queue size is used to avoid overwhelming the logging thread, since it takes 1-2 milliseconds
     // to log out each message it can easily fall behind a large amount of logs.  Lost log messages are added
     // to the WorkQueueOverrun count so that they can be reported as "X logs were lost".
 
-    inline void WorkQueueAdd(QueuedLogMessage* msg)
-    {
-        if (WorkQueueTail)
-        {
-            WorkQueueTail->Next = msg;
-        }
-        else
-        {
-            WorkQueueHead = msg;
-        }
-        WorkQueueTail = msg;
-        ++WorkQueueSize;
-    }
+    // Appends a message to the queue. Returns true if the queue was empty, in which case the
+    // caller should wake the worker thread.
+    bool WorkQueueAdd(QueuedLogMessage* msg);
+
+    // Links msg after the current tail; the list half of WorkQueueAdd().
+    void WorkQueueLink(QueuedLogMessage* msg);
+
+    // Signals WorkerWakeEvent.
+    void WakeWorkerThread();
+
+    // Removes the oldest message. Returns nullptr if the queue is empty, or if the next message
+    // is still being linked by its writer. Requires WorkQueueConsumerLock, see ProcessQueuedMessages().
+    QueuedLogMessage* WorkQueueRemove();
+
+    // Message taken off the work queue by ProcessQueuedMessages() which is waiting for its turn
+    // in the merge with the rings. Consumer only.
+    QueuedLogMessage* WorkQueuePending;
 
     #if defined(_WIN32)
         #define OVR_THREAD_FUNCTION_TYPE DWORD WINAPI
@@ -678,8 +1097,26 @@ private:
     static void AppendHeader(char* buffer, size_t bufferBytes,
                              Level level, const char* subsystemName);
 
+    // Writes all queued messages to the plugins.
     void ProcessQueuedMessages();
 
+    // Messages taken off the work queue and waiting to be written to the plugins as one batch.
+    // Only used by ProcessQueuedMessages(), which holds WorkQueueConsumerLock.
+    static const int BatchSize = 64;
+    static const int BatchHeaderBytes = 128; // Timestamp, level and a Name::MaxLength subsystem name.
+    QueuedLogMessage* BatchQueued[BatchSize];
+    OutputMessage     BatchMessages[BatchSize];
+    char              BatchHeaders[BatchSize][BatchHeaderBytes];
+    std::string       BatchDeferredText[BatchSize]; // Formatted text of deferred messages and events
+    int               BatchCount;
+
+    // Adds message to the batch, writing the batch out first if it is full. The batch owns
+    // the message until it has been written.
+    void AddToBatch(QueuedLogMessage* message);
+
+    // Writes the batch to each plugin in PluginsSnapshot, and frees its messages.
+    void WriteBatch();
+
     void FlushDbgViewLogImmediately(const char* subsystemName, Level messageLogLevel, const char* stream);
 };
 
@@ -736,6 +1173,7 @@ class Channel
 {
 public:
     Channel(const char* nameString);
+    Channel(const char* nameString, Level defaultMinimumOutputLevel); // Overrides DefaultMinimumOutputLevel.
     Channel(const Channel& other);
     ~Channel();
 
@@ -766,7 +1204,7 @@ public:
 
     LOGGING_INLINE bool Active(Level level) const
     {
-        return MinimumOutputLevel <= (uint32_t)level;
+        return IsLevelCompiledIn(level) && (MinimumOutputLevel <= (uint32_t)level);
     }
 
     template<typename... Args>
@@ -781,46 +1219,31 @@ public:
     template<typename... Args>
     LOGGING_INLINE void LogError(Args&&... args) const
     {
-        if (Active(Level::Error))
-        {
-            doLog(Level::Error, std::forward<Args>(args)...);
-        }
+        logAtLevel<Level::Error, Level::Trace>(StreamLogTag(), std::forward<Args>(args)...);
     }
 
     template<typename... Args>
     LOGGING_INLINE void LogWarning(Args&&... args) const
     {
-        if (Active(Level::Warning))
-        {
-            doLog(Level::Warning, std::forward<Args>(args)...);
-        }
+        logAtLevel<Level::Warning, Level::Trace>(StreamLogTag(), std::forward<Args>(args)...);
     }
 
     template<typename... Args>
     LOGGING_INLINE void LogInfo(Args&&... args) const
     {
-        if (Active(Level::Info))
-        {
-            doLog(Level::Info, std::forward<Args>(args)...);
-        }
+        logAtLevel<Level::Info, Level::Trace>(StreamLogTag(), std::forward<Args>(args)...);
     }
 
     template<typename... Args>
     LOGGING_INLINE void LogDebug(Args&&... args) const
     {
-        if (Active(Level::Debug))
-        {
-            doLog(Level::Debug, std::forward<Args>(args)...);
-        }
+        logAtLevel<Level::Debug, Level::Trace>(StreamLogTag(), std::forward<Args>(args)...);
     }
 
     template<typename... Args>
     LOGGING_INLINE void LogTrace(Args&&... args) const
     {
-        if (Active(Level::Trace))
-        {
-            doLog(Level::Trace, std::forward<Args>(args)...);
-        }
+        logAtLevel<Level::Trace, Level::Trace>(StreamLogTag(), std::forward<Args>(args)...);
     }
 
     // printf style log functions
@@ -836,45 +1259,86 @@ public:
     template<typename... Args>
     LOGGING_INLINE void LogErrorF(Args&&... args) const
     {
-        if (Active(Level::Error))
-        {
-            doLogF(Level::Error, std::forward<Args>(args)...);
-        }
+        logAtLevel<Level::Error, Level::Trace>(PrintfLogTag(), std::forward<Args>(args)...);
     }
 
     template<typename... Args>
     LOGGING_INLINE void LogWarningF(Args&&... args) const
     {
-        if (Active(Level::Warning))
-        {
-            doLogF(Level::Warning, std::forward<Args>(args)...);
-        }
+        logAtLevel<Level::Warning, Level::Trace>(PrintfLogTag(), std::forward<Args>(args)...);
     }
 
     template<typename... Args>
     LOGGING_INLINE void LogInfoF(Args&&... args) const
     {
-        if (Active(Level::Info))
-        {
-            doLogF(Level::Info, std::forward<Args>(args)...);
-        }
+        logAtLevel<Level::Info, Level::Trace>(PrintfLogTag(), std::forward<Args>(args)...);
     }
 
     template<typename... Args>
     LOGGING_INLINE void LogDebugF(Args&&... args) const
     {
-        if (Active(Level::Debug))
+        logAtLevel<Level::Debug, Level::Trace>(PrintfLogTag(), std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogTraceF(Args&&... args) const
+    {
+        logAtLevel<Level::Trace, Level::Trace>(PrintfLogTag(), std::forward<Args>(args)...);
+    }
+
+    // Deferred printf style log functions
+    // These only record the format pointer and the argument values, leaving the formatting to
+    // the logging thread, so they are much cheaper for the caller than LogF. The format must be
+    // a string literal, and the arguments numbers, enums, pointers or narrow strings.
+    // See DeferredArgWriter.
+    template<typename... Args>
+    LOGGING_INLINE void LogDeferredF(Level level, const char* format, const Args&... args) const
+    {
+        if (Active(level))
         {
-            doLogF(Level::Debug, std::forward<Args>(args)...);
+            doLogDeferredF(level, format, args...);
         }
     }
 
     template<typename... Args>
-    LOGGING_INLINE void LogTraceF(Args&&... args) const
+    LOGGING_INLINE void LogErrorDeferredF(const char* format, const Args&... args) const
+    {
+        logAtLevel<Level::Error, Level::Trace>(DeferredLogTag(), format, args...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogWarningDeferredF(const char* format, const Args&... args) const
+    {
+        logAtLevel<Level::Warning, Level::Trace>(DeferredLogTag(), format, args...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogInfoDeferredF(const char* format, const Args&... args) const
+    {
+        logAtLevel<Level::Info, Level::Trace>(DeferredLogTag(), format, args...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogDebugDeferredF(const char* format, const Args&... args) const
+    {
+        logAtLevel<Level::Debug, Level::Trace>(DeferredLogTag(), format, args...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogTraceDeferredF(const char* format, const Args&... args) const
+    {
+        logAtLevel<Level::Trace, Level::Trace>(DeferredLogTag(), format, args...);
+    }
+
+    // Structured events
+    // Records an event with a name and typed fields, made with Field("name", value). The event
+    // and field names must be string literals or otherwise outlive the call. See LogEventReader.
+    template<typename... Fields>
+    LOGGING_INLINE void LogEvent(Level level, const char* name, const Fields&... fields) const
     {
-        if (Active(Level::Trace))
+        if (Active(level))
         {
-            doLogF(Level::Trace, std::forward<Args>(args)...);
+            doLogEvent(level, name, fields...);
         }
     }
 
@@ -916,10 +1380,58 @@ public:
     }
     // DANGER DANGER DANGER
 
+protected:
+    // Tags selecting the doLog function for logAtLevel(), so it instantiates only that one.
+    struct StreamLogTag {};
+    struct PrintfLogTag {};
+    struct DeferredLogTag {};
+
+    // Logs at the fixed level L if it is active. If L is below StaticMinimumLevel or
+    // LOGGING_MIN_LEVEL this is an empty function, and the message formatting code is never
+    // instantiated.
+    template<Level L, Level StaticMinimumLevel, typename Tag, typename... Args>
+    LOGGING_INLINE void logAtLevel(Tag tag, Args&&... args) const
+    {
+        logAtLevelIf<L>(std::integral_constant<bool, IsLevelCompiledIn(L) && (L >= StaticMinimumLevel)>(),
+                        tag, std::forward<Args>(args)...);
+    }
+
 private:
     //-------------------------------------------------------------------------
     // Internal Implementation
 
+    template<Level L, typename Tag, typename... Args>
+    LOGGING_INLINE void logAtLevelIf(std::true_type, Tag tag, Args&&... args) const
+    {
+        if (Active(L))
+        {
+            doLogTagged(tag, L, std::forward<Args>(args)...);
+        }
+    }
+
+    template<Level L, typename Tag, typename... Args>
+    LOGGING_INLINE void logAtLevelIf(std::false_type, Tag, Args&&...) const
+    {
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void doLogTagged(StreamLogTag, Level level, Args&&... args) const
+    {
+        doLog(level, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void doLogTagged(PrintfLogTag, Level level, Args&&... args) const
+    {
+        doLogF(level, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void doLogTagged(DeferredLogTag, Level level, const char* format, const Args&... args) const
+    {
+        doLogDeferredF(level, format, args...);
+    }
+
     Channel() = delete;
     Channel(Channel&& other) = delete;
     Channel& operator=(const Channel& other) = delete;
@@ -946,6 +1458,12 @@ private:
     // Target of doLog function
     static OutputWorkerOutputFunctionType OutputWorkerOutputFunction;
 
+    // Target of doLogDeferredF function
+    static OutputWorkerDeferredOutputFunctionType OutputWorkerDeferredOutputFunction;
+
+    // Target of doLogEvent function
+    static OutputWorkerEventOutputFunctionType OutputWorkerEventOutputFunction;
+
     // Target of OnChannelLevelChange
     static ConfiguratorOnChannelLevelChangeType ConfiguratorOnChannelLevelChange;
 
@@ -1091,9 +1609,259 @@ private:
 
         delete[] logCharsAllocated;
     }
+
+    LOGGING_INLINE void writeDeferredArgs(DeferredArgWriter& writer) const
+    {
+        (void)writer;
+    }
+
+    template<typename T, typename... Args>
+    LOGGING_INLINE void writeDeferredArgs(DeferredArgWriter& writer, const T& arg, const Args&... args) const
+    {
+        DeferredArgEncode(writer, arg);
+        writeDeferredArgs(writer, args...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void doLogDeferredF(Level level, const char* format, const Args&... args) const
+    {
+        int silenceOptions = ErrorSilencer::GetSilenceOptions();
+        if (silenceOptions & ErrorSilencer::CompletelySilenceLogs)
+        {
+            return;
+        }
+
+        if (level > Level::Debug && (silenceOptions & ErrorSilencer::DemoteToDebug))
+        {
+            // Demote to debug
+            level = Level::Debug;
+        }
+        else if (level == Level::Error && (silenceOptions & ErrorSilencer::DemoteErrorsToWarnings))
+        {
+            // Demote to warning
+            level = Level::Warning;
+        }
+
+        DeferredArgWriter writer;
+        writer.WriteString(Prefix.c_str(), Prefix.size());
+        writeDeferredArgs(writer, args...);
+
+        // Submit the raw arguments to logging subsystem
+        OutputWorkerDeferredOutputFunction(SubsystemName.Get(), (Log_Level_t)level, format, writer.Data, writer.Size, (Write_Option_t)WriteOption::Default);
+    }
+
+    template<typename... Fields>
+    LOGGING_INLINE void doLogEvent(Level level, const char* name, const Fields&... fields) const
+    {
+        int silenceOptions = ErrorSilencer::GetSilenceOptions();
+        if (silenceOptions & ErrorSilencer::CompletelySilenceLogs)
+        {
+            return;
+        }
+
+        if (level > Level::Debug && (silenceOptions & ErrorSilencer::DemoteToDebug))
+        {
+            // Demote to debug
+            level = Level::Debug;
+        }
+        else if (level == Level::Error && (silenceOptions & ErrorSilencer::DemoteErrorsToWarnings))
+        {
+            // Demote to warning
+            level = Level::Warning;
+        }
+
+        DeferredArgWriter writer;
+        writer.WriteString(Prefix.c_str(), Prefix.size());
+        writer.WriteString(name);
+        writeDeferredArgs(writer, fields...);
+
+        // Submit the fields to logging subsystem
+        OutputWorkerEventOutputFunction(SubsystemName.Get(), (Log_Level_t)level, writer.Data, writer.Size, (Write_Option_t)WriteOption::Default);
+    }
+};
+
+
+//-----------------------------------------------------------------------------
+// StaticChannel
+//
+// A Channel with a compile-time minimum level, which is also its default minimum output level.
+// Messages below it are removed the same way as messages below LOGGING_MIN_LEVEL, whatever
+// level the channel is later set to at runtime:
+//
+//     static ovrlog::StaticChannel<ovrlog::Level::Info> Logger("Kernel:Allocator");
+//     Logger.LogTrace("Freed ", size); // Compiles to nothing.
+
+template<Level StaticMinimumLevel>
+class StaticChannel : public Channel
+{
+public:
+    explicit StaticChannel(const char* nameString) :
+        Channel(nameString, StaticMinimumLevel)
+    {
+    }
+
+    LOGGING_INLINE bool Active(Level level) const
+    {
+        return (level >= StaticMinimumLevel) && Channel::Active(level);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void Log(Level level, Args&&... args) const
+    {
+        if (Active(level))
+        {
+            Channel::Log(level, std::forward<Args>(args)...);
+        }
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogF(Level level, Args&&... args) const
+    {
+        if (Active(level))
+        {
+            Channel::LogF(level, std::forward<Args>(args)...);
+        }
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogDeferredF(Level level, const char* format, const Args&... args) const
+    {
+        if (Active(level))
+        {
+            Channel::LogDeferredF(level, format, args...);
+        }
+    }
+
+    template<typename... Fields>
+    LOGGING_INLINE void LogEvent(Level level, const char* name, const Fields&... fields) const
+    {
+        if (Active(level))
+        {
+            Channel::LogEvent(level, name, fields...);
+        }
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogError(Args&&... args) const
+    {
+        logAtLevel<Level::Error, StaticMinimumLevel>(StreamLogTag(), std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogWarning(Args&&... args) const
+    {
+        logAtLevel<Level::Warning, StaticMinimumLevel>(StreamLogTag(), std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogInfo(Args&&... args) const
+    {
+        logAtLevel<Level::Info, StaticMinimumLevel>(StreamLogTag(), std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogDebug(Args&&... args) const
+    {
+        logAtLevel<Level::Debug, StaticMinimumLevel>(StreamLogTag(), std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogTrace(Args&&... args) const
+    {
+        logAtLevel<Level::Trace, StaticMinimumLevel>(StreamLogTag(), std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogErrorF(Args&&... args) const
+    {
+        logAtLevel<Level::Error, StaticMinimumLevel>(PrintfLogTag(), std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogWarningF(Args&&... args) const
+    {
+        logAtLevel<Level::Warning, StaticMinimumLevel>(PrintfLogTag(), std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogInfoF(Args&&... args) const
+    {
+        logAtLevel<Level::Info, StaticMinimumLevel>(PrintfLogTag(), std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogDebugF(Args&&... args) const
+    {
+        logAtLevel<Level::Debug, StaticMinimumLevel>(PrintfLogTag(), std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogTraceF(Args&&... args) const
+    {
+        logAtLevel<Level::Trace, StaticMinimumLevel>(PrintfLogTag(), std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogErrorDeferredF(const char* format, const Args&... args) const
+    {
+        logAtLevel<Level::Error, StaticMinimumLevel>(DeferredLogTag(), format, args...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogWarningDeferredF(const char* format, const Args&... args) const
+    {
+        logAtLevel<Level::Warning, StaticMinimumLevel>(DeferredLogTag(), format, args...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogInfoDeferredF(const char* format, const Args&... args) const
+    {
+        logAtLevel<Level::Info, StaticMinimumLevel>(DeferredLogTag(), format, args...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogDebugDeferredF(const char* format, const Args&... args) const
+    {
+        logAtLevel<Level::Debug, StaticMinimumLevel>(DeferredLogTag(), format, args...);
+    }
+
+    template<typename... Args>
+    LOGGING_INLINE void LogTraceDeferredF(const char* format, const Args&... args) const
+    {
+        logAtLevel<Level::Trace, StaticMinimumLevel>(DeferredLogTag(), format, args...);
+    }
 };
 
 
+//-----------------------------------------------------------------------------
+// LOGGING_LOG_TRACE / LOGGING_LOG_DEBUG
+//
+// Log through a Channel or StaticChannel without evaluating the arguments unless the message
+// is going to be written. When the level is below LOGGING_MIN_LEVEL they expand to nothing.
+//
+//     LOGGING_LOG_TRACE(Logger, "Frame ", frameIndex, ": ", DescribeFrame(frame));
+//     LOGGING_LOG_DEBUG_F(Logger, "Reallocated %d buffers", CountBuffers());
+
+#define LOGGING_LOG_IF_ACTIVE_(channel, level, function, ...) \
+    do { if ((channel).Active(level)) { (channel).function(__VA_ARGS__); } } while (0)
+
+#if LOGGING_MIN_LEVEL <= 1 // Level::Trace
+    #define LOGGING_LOG_TRACE(channel, ...)   LOGGING_LOG_IF_ACTIVE_(channel, ovrlog::Level::Trace, LogTrace, __VA_ARGS__)
+    #define LOGGING_LOG_TRACE_F(channel, ...) LOGGING_LOG_IF_ACTIVE_(channel, ovrlog::Level::Trace, LogTraceF, __VA_ARGS__)
+#else
+    #define LOGGING_LOG_TRACE(channel, ...)   do { } while (0)
+    #define LOGGING_LOG_TRACE_F(channel, ...) do { } while (0)
+#endif
+
+#if LOGGING_MIN_LEVEL <= 2 // Level::Debug
+    #define LOGGING_LOG_DEBUG(channel, ...)   LOGGING_LOG_IF_ACTIVE_(channel, ovrlog::Level::Debug, LogDebug, __VA_ARGS__)
+    #define LOGGING_LOG_DEBUG_F(channel, ...) LOGGING_LOG_IF_ACTIVE_(channel, ovrlog::Level::Debug, LogDebugF, __VA_ARGS__)
+#else
+    #define LOGGING_LOG_DEBUG(channel, ...)   do { } while (0)
+    #define LOGGING_LOG_DEBUG_F(channel, ...) do { } while (0)
+#endif
+
+
 //-----------------------------------------------------------------------------
 // Log Configurator
 //
@@ -1110,6 +1878,14 @@ public:
 
     // Sets the channel level
     virtual void SaveChannelLevel(const char* name, Level level) = 0;
+
+    // Optionally reads every stored channel level in one pass, which the Configurator then
+    // serves channel lookups from instead of calling RestoreChannelLevel() per channel.
+    // Returns false if the plugin can't enumerate its settings, which is the default.
+    virtual bool LoadChannelLevels(std::vector< std::pair<std::string, Level> >& levels);
+
+    // Writes a set of changed channel levels. By default calls SaveChannelLevel() for each.
+    virtual void SaveChannelLevels(const std::vector< std::pair<std::string, Level> >& levels);
 };
 
 class Configurator
@@ -1151,6 +1927,10 @@ public:
 
     // Internal: Iterate through all channels and store them
     void RestoreAllChannelLogLevels();
+
+    // Internal: Write the channel levels changed since the last call to the plugin. Called by
+    // the OutputWorker thread, and when the OutputWorker stops.
+    void SavePendingChannelLevels();
 private:
 
     void RestoreAllChannelLogLevelsNoLock();
@@ -1159,6 +1939,23 @@ private:
     std::shared_ptr<ConfiguratorPlugin> Plugin;
 
     void SetChannelNoLock(std::string channelName, Level level, bool overrideUser);
+
+    // Gets the stored level for a channel, returning false if there is none. Reads through
+    // ChannelLevelCache, so each name is looked up in the plugin at most once.
+    bool LookupChannelLevelNoLock(const char* channelName, Level& level);
+
+    void SavePendingChannelLevelsNoLock();
+
+    // Stored channel levels, with Level::Count for names the plugin has no level for. If
+    // ChannelLevelCacheComplete then the plugin's LoadChannelLevels() filled it and names which
+    // aren't in it have no stored level.
+    std::unordered_map<std::string, Level> ChannelLevelCache;
+    bool ChannelLevelCacheComplete;
+
+    // Levels set since the last SavePendingChannelLevels(). Saving is left to the OutputWorker
+    // thread so that changing a channel level doesn't wait on the registry or disk.
+    std::unordered_map<std::string, Level> PendingChannelLevelSaves;
+    std::atomic<bool> HasPendingChannelLevelSaves;
 };
 
 
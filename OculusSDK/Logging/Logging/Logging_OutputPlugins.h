@@ -51,10 +51,17 @@ protected:
     virtual const char* GetUniquePluginName() override;
     virtual void Write(Level level, const char* subsystem, const char* header, const char* utf8msg) override;
 
+    // Sets the console color once per run of same-level messages, and writes each run with as
+    // few console writes as the coloring allows.
+    virtual void WriteBatch(const OutputMessage* messages, size_t count) override;
+
     // If enabled then we use stdio instead of platform-specific calls. By default we 
     // use direct platform calls because they are lower overhead and because (for Windows)
     // they are UTF8-savvy (unlike stdio on Windows). Defaults to false.
 	  bool UseStdio;
+
+    // Text of the current run in WriteBatch, kept to reuse its allocation.
+    std::string BatchText;
 };
 
 
@@ -104,6 +111,106 @@ private:
 };
 
 
+
+//-----------------------------------------------------------------------------
+// Memory-Mapped Log File
+//
+// Writes messages into a preallocated, memory-mapped file, so each message costs a memcpy
+// and no system calls; the OS writes the pages back. The file starts with a FileHeader whose
+// WriteOffset is updated after each message, so if the process crashes the log up to the last
+// complete message is still on disk and a reader knows where it ends. When a message doesn't
+// fit the file is rotated: path is renamed to path.1, path.1 to path.2 and so on up to
+// path.<maxFileCount - 1>, and a new file is started. A file left from a previous run is
+// rotated the same way on construction. On destruction the file is truncated to its used size.
+
+class OutputMappedFile : public OutputPlugin
+{
+public:
+    // On-disk header at the start of each file. Messages are UTF8 text lines from HeaderSize
+    // up to WriteOffset; the rest of the file is zero filled.
+    struct FileHeader
+    {
+        char     Magic[8];    // "OVRMLOG1"
+        uint32_t HeaderSize;  // sizeof(FileHeader)
+        uint32_t Reserved;
+        uint64_t FileSize;    // Preallocated size of the file
+        uint64_t WriteOffset; // End of the last complete message
+        uint8_t  Padding[32];
+    };
+
+    // utf8Path is the path of the current log file. fileSize is rounded up to hold at least the
+    // header and one message byte. maxFileCount includes the current file.
+    OutputMappedFile(const char* utf8Path, size_t fileSize = 16 * 1024 * 1024, int maxFileCount = 4);
+    ~OutputMappedFile();
+
+    bool IsOpen() const
+    {
+        return Header != nullptr;
+    }
+
+private:
+    virtual const char* GetUniquePluginName() override;
+    virtual void Write(Level level, const char* subsystem, const char* header, const char* utf8msg) override;
+
+    // Maps a new, empty file at Path. Returns false (and leaves the plugin closed) on failure.
+    bool Open();
+
+    // Unmaps the current file and truncates it to its used size.
+    void Close();
+
+    // Closes the current file, shifts the older files along and opens a new one.
+    bool Rotate();
+
+    std::string Path;
+    size_t      FileSize;
+    int         MaxFileCount;
+
+    #if defined(_WIN32)
+        HANDLE FileHandle;
+        HANDLE MappingHandle;
+    #else
+        int FileDescriptor;
+    #endif
+
+    FileHeader* Header;      // Start of the mapped view, or nullptr if the plugin is closed
+    char*       MappedData;  // Same address as Header
+};
+
+
+
+//-----------------------------------------------------------------------------
+// Structured Event JSON File
+//
+// Appends the events logged with Channel::LogEvent to a file as JSON lines, one object per
+// event, so tools can read them without parsing log text. For example:
+//     {"time":"2026-10-14T09:30:01.250","level":"Info","subsystem":"Render","event":"FrameStats","fps":89.9,"dropped":0}
+// Fields keep their recorded type: integers and doubles are JSON numbers, strings and pointers
+// are JSON strings. On Windows time is the local time; elsewhere it is seconds since the epoch.
+// Plain text messages are not written by this plugin.
+
+class OutputEventJsonFile : public OutputPlugin
+{
+public:
+    OutputEventJsonFile(const char* utf8Path);
+    ~OutputEventJsonFile();
+
+    bool IsOpen() const
+    {
+        return File != nullptr;
+    }
+
+private:
+    virtual const char* GetUniquePluginName() override;
+    virtual void Write(Level level, const char* subsystem, const char* header, const char* utf8msg) override;
+    virtual void WriteBatch(const OutputMessage* messages, size_t count) override;
+
+    // Appends the JSON line for one event to Lines.
+    void AppendEvent(const OutputMessage& message);
+
+    FILE*       File;
+    std::string Lines; // Text of the current batch, kept to reuse its allocation
+};
+
 } // namespace ovrlog
 
 #endif // Logging_OutputPlugins_h
@@ -33,6 +33,8 @@ limitations under the License.
 #include <time.h>
 #include <string.h>
 #include <assert.h>
+#include <chrono>
+#include <thread>
 
 #pragma warning(push)
 
@@ -61,8 +63,12 @@ namespace ovrlog {
 //--------------------------------------------------------------------------------------------------
 
 RepeatedMessageManager::RepeatedMessageManager()
-  : Mutex(), BusyInWrite(false), RecentMessageMap(), RepeatedMessageMap(), RepeatedMessageExceptionSet()
-{}
+  : Mutex(), BusyInWrite(false), RecentMessageTable(), RepeatedMessageTable(), RepeatedMessageExceptionSet()
+{
+  static_assert((recentMessageTableSize & (recentMessageTableSize - 1)) == 0, "Must be a power of two");
+  static_assert((repeatedMessageTableSize & (repeatedMessageTableSize - 1)) == 0, "Must be a power of two");
+  static_assert(tableProbeCount <= repeatedMessageTableSize, "Probe count exceeds table size");
+}
 
 void RepeatedMessageManager::PrintDeferredAggregateMessage(OutputWorker* outputWorker, RepeatedMessage& repeatedMessage){
   // Don't lock Mutex, as it's expected to already be locked.
@@ -137,6 +143,65 @@ int64_t RepeatedMessageManager::GetLogMillisecondTimeDifference(LogTimeMs begin,
     // return hash;
   }
 
+RepeatedMessageManager::PrefixHashType
+RepeatedMessageManager::GetMessageHash(PrefixHashType subsystemNameHash, PrefixHashType prefixHash)
+{
+  PrefixHashType hash = prefixHash ^ (subsystemNameHash * 0x9E3779B1U);
+  hash ^= (hash >> 16); // Mix the high bits into the low bits used to index the tables.
+  return (hash != 0) ? hash : 1;
+}
+
+uint32_t RepeatedMessageManager::GetDecayedCount(uint32_t count, int64_t elapsedMs)
+{
+  const int64_t periods = (elapsedMs / maxDeferrableDetectionTimeMs);
+  return (periods >= 32) ? 0 : (count >> periods);
+}
+
+RepeatedMessageManager::RepeatedMessage*
+RepeatedMessageManager::FindRepeatedMessage(PrefixHashType hash)
+{
+  for (uint32_t i = 0; i < tableProbeCount; ++i) {
+    RepeatedMessage& slot = RepeatedMessageTable[(hash + i) & (repeatedMessageTableSize - 1)];
+    if (slot.hash == hash)
+      return &slot;
+  }
+  return nullptr;
+}
+
+RepeatedMessageManager::RepeatedMessage*
+RepeatedMessageManager::AllocRepeatedMessage(PrefixHashType hash)
+{
+  for (uint32_t i = 0; i < tableProbeCount; ++i) {
+    RepeatedMessage& slot = RepeatedMessageTable[(hash + i) & (repeatedMessageTableSize - 1)];
+    if (slot.hash == 0)
+      return &slot;
+  }
+  return nullptr;
+}
+
+RepeatedMessageManager::RecentMessage*
+RepeatedMessageManager::FindRecentMessage(PrefixHashType hash, LogTimeMs currentLogTimeMs)
+{
+  RecentMessage* victim = nullptr;
+  int64_t victimAgeMs = -1;
+
+  for (uint32_t i = 0; i < tableProbeCount; ++i) {
+    RecentMessage& slot = RecentMessageTable[(hash + i) & (recentMessageTableSize - 1)];
+    if (slot.hash == hash)
+      return &slot;
+
+    const int64_t ageMs = (slot.hash == 0) ? INT64_MAX :
+      GetLogMillisecondTimeDifference(slot.timeMs, currentLogTimeMs);
+    if (ageMs > victimAgeMs) {
+      victim = &slot;
+      victimAgeMs = ageMs;
+    }
+  }
+
+  victim->hash = 0;
+  return victim;
+}
+
 RepeatedMessageManager::HandleResult
 RepeatedMessageManager::HandleMessage(const char* subsystemName, Level messageLogLevel, 
   const char* stream)
@@ -158,18 +223,17 @@ RepeatedMessageManager::HandleMessage(const char* subsystemName, Level messageLo
     return HandleResult::Passed;
   }
 
+  const PrefixHashType messageHash = GetMessageHash(subsystemNameHash, prefixHash);
+
   // We will need the current time below for all pathways.
   const LogTimeMs currentLogTimeMs = GetCurrentLogMillisecondTime();
 
-  // First look at our repeated messages. This is a container of known repeating messages.
-  auto itRepeated = RepeatedMessageMap.find(prefixHash);
+  // First look at our repeated messages. This is a table of known repeating messages.
+  RepeatedMessage* pRepeated = FindRepeatedMessage(messageHash);
 
-  if (itRepeated != RepeatedMessageMap.end()) { // If this is a message that's already repeating...
-    RepeatedMessage& repeatedMessage = itRepeated->second;
+  if (pRepeated != nullptr) { // If this is a message that's already repeating...
+    RepeatedMessage& repeatedMessage = *pRepeated;
 
-    // Assume subsystemName == repeatedMessage->subsystemName, though theoretically it's possible
-    // that two subsystems generate the same prefix string. Let's worry about that if we see it.
-    //
     // Assume messageLogLevel == repeatedMessage->messageLogLevel for the purposes of handling
     // repeated messages. It's possible that a subsystem may generate the same message string
     // but with different log levels, but we've never seen that, and it may not be significant
@@ -191,7 +255,7 @@ RepeatedMessageManager::HandleMessage(const char* subsystemName, Level messageLo
       // repeatedMessage.stream, in order to print the most recent variation of this repeat when 
       // the aggregated print is done.
       if (++repeatedMessage.aggregatedCount >= maxDeferredMessages)
-        repeatedMessage.stream = stream;
+        repeatedMessage.stream.assign(stream, strnlen(stream, maxRepeatedMessageLength));
 
       return HandleResult::Aggregated;
     }
@@ -201,19 +265,40 @@ RepeatedMessageManager::HandleMessage(const char* subsystemName, Level messageLo
   }
   else {
     // Else this message wasn't known to be previously repeating, but maybe it's the first repeat
-    // we are encountering. Check the RecentMessageMap for this.
-    auto itRecent = RecentMessageMap.find(prefixHash);
-
-    if (itRecent != RecentMessageMap.end()) { // If it looks like a repeat of something recent...
-      RepeatedMessageMap[prefixHash] = RepeatedMessage(
-        subsystemName, messageLogLevel, stream, currentLogTimeMs, currentLogTimeMs, 0);
+    // we are encountering. Check the RecentMessageTable for this.
+    RecentMessage& recentMessage = *FindRecentMessage(messageHash, currentLogTimeMs);
+    uint32_t count = 0;
+
+    if (recentMessage.hash == messageHash) {
+      const int64_t logTimeDifferenceMs =
+        GetLogMillisecondTimeDifference(recentMessage.timeMs, currentLogTimeMs);
+      count = GetDecayedCount(recentMessage.count, logTimeDifferenceMs);
+    }
 
-      // No need to keep it in the RecentMessageMap any more, since it's now classified as repeat.
-      RecentMessageMap.erase(itRecent);
+    RepeatedMessage* pNewRepeated = nullptr;
+    if (count > 0) // If it looks like a repeat of something recent...
+      pNewRepeated = AllocRepeatedMessage(messageHash);
+
+    if (pNewRepeated != nullptr) {
+      RepeatedMessage& repeatedMessage = *pNewRepeated;
+      repeatedMessage.hash = messageHash;
+      repeatedMessage.subsystemName = subsystemName;
+      repeatedMessage.messageLogLevel = messageLogLevel;
+      repeatedMessage.stream.assign(stream, strnlen(stream, maxRepeatedMessageLength));
+      repeatedMessage.initialTimeMs = currentLogTimeMs;
+      repeatedMessage.lastTimeMs = currentLogTimeMs;
+      repeatedMessage.aggregatedCount = 0;
+      repeatedMessage.printedCount = 0;
+
+      // No need to keep it in the RecentMessageTable any more, since it's now classified as repeat.
+      recentMessage.hash = 0;
     }
     else {
-      // Else add it to RecentMessageMap. Old RecentMessageMap entries will be removed by Poll().
-      RecentMessageMap[prefixHash] = RecentMessage{ currentLogTimeMs };
+      // Else record it in the RecentMessageTable. If the repeated table had no room for it then
+      // it stays here and is just printed, and it'll be tried again on its next repeat.
+      recentMessage.hash = messageHash;
+      recentMessage.timeMs = currentLogTimeMs;
+      recentMessage.count = count + 1;
     }
   }
 
@@ -226,43 +311,16 @@ void RepeatedMessageManager::Poll(OutputWorker* outputWorker) {
   {
     std::lock_guard<std::recursive_mutex> lock(Mutex);
 
-    if (RecentMessageMap.size() > (recentMessageCount * 2)) {
-      // Prune the oldest messages out of RecentMessageMap until 
-      // RecentMessageMap.size() == recentMessageCount. Unfortunately, RecentMessageMap is an
-      // unsorted hash container, so we can't quickly find the oldest N messages. We can solve 
-      // this by doing a copy of iterators to an array, sort, erase first N iterators. A faster 
-      // solution would be to keep a std::queue of iterators that were added to the map, though 
-      // that results in some complicated code. Maybe we'll do that, but let's do the sort 
-      // solution first.
-      const size_t arrayCapacity = (recentMessageCount * 3);
-      RecentMessageMapType::iterator itArray[arrayCapacity]; // Avoid memory allocation.
-      size_t itArraySize = 0;
-
-      for (RecentMessageMapType::iterator it = RecentMessageMap.begin();
-        (it != RecentMessageMap.end()) && (itArraySize < arrayCapacity);
-        ++it) {
-        itArray[itArraySize++] = it;
-      }
-
-      std::sort(
-        itArray,
-        itArray + itArraySize, // Put the oldest at the end of the array.
-        [](const RecentMessageMapType::iterator& it1,
-          const RecentMessageMapType::iterator& it2) -> bool {
-        return (it2->second.timeMs < it1->second.timeMs); // Sort newest to oldest.
-      });
-
-      for (size_t i = 0; i < itArraySize; ++i)
-        RecentMessageMap.erase(itArray[i]);
-    }
-
-    // Currently we go through the entire RepeatedMessageMap every time we are here, though we 
-    // have a purgeDeferredMessageTimeMs constant which we have to make this more granular, for 
-    // efficiency purposed. To do.
+    // RecentMessageTable needs no pruning, as its entries are replaced when their slots are
+    // needed. Currently we go through the entire RepeatedMessageTable every time we are here,
+    // though we have a purgeDeferredMessageTimeMs constant which we have to make this more
+    // granular, for efficiency purposed. To do.
     const LogTimeMs currentLogTimeMs = GetCurrentLogMillisecondTime();
 
-    for (auto it = RepeatedMessageMap.begin(); it != RepeatedMessageMap.end();) {
-      RepeatedMessage& repeatedMessage = it->second;
+    for (RepeatedMessage& repeatedMessage : RepeatedMessageTable) {
+      if (repeatedMessage.hash == 0)
+        continue;
+
       LogTimeMs logTimeDifferenceMs =
         GetLogMillisecondTimeDifference(repeatedMessage.lastTimeMs, currentLogTimeMs);
 
@@ -277,7 +335,7 @@ void RepeatedMessageManager::Poll(OutputWorker* outputWorker) {
           messagesToPrint.emplace_back(std::move(repeatedMessage));
         }
 
-        it = RepeatedMessageMap.erase(it);
+        repeatedMessage.hash = 0;
         continue;
       }
       else if (repeatedMessage.aggregatedCount >= maxDeferredMessages) {
@@ -285,7 +343,6 @@ void RepeatedMessageManager::Poll(OutputWorker* outputWorker) {
         repeatedMessage.printedCount += repeatedMessage.aggregatedCount;
         repeatedMessage.aggregatedCount = 0; // Reset this for a new round of aggregation.
       }
-      ++it;
     }
   } // lock
 
@@ -334,6 +391,8 @@ void RepeatedMessageManager::RemoveRepeatedMessageSubsytemException(const char*
 // Channel
 
 OutputWorkerOutputFunctionType Channel::OutputWorkerOutputFunction;
+OutputWorkerDeferredOutputFunctionType Channel::OutputWorkerDeferredOutputFunction;
+OutputWorkerEventOutputFunctionType Channel::OutputWorkerEventOutputFunction;
 ConfiguratorOnChannelLevelChangeType Channel::ConfiguratorOnChannelLevelChange;
 ConfiguratorRegisterType Channel::ConfiguratorRegister;
 ConfiguratorUnregisterType Channel::ConfiguratorUnregister;
@@ -402,6 +461,16 @@ extern "C"
         OutputWorker::GetInstance()->Write(subsystemName, (Level)messageLogLevel, stream, relogged, (WriteOption)option);
     }
 
+    void OutputWorkerDeferredOutputFunctionC(const char* subsystemName, Log_Level_t messageLogLevel, const char* format, const char* data, size_t dataSize, Write_Option_t option)
+    {
+        OutputWorker::GetInstance()->WriteDeferred(subsystemName, (Level)messageLogLevel, format, data, dataSize, (WriteOption)option);
+    }
+
+    void OutputWorkerEventOutputFunctionC(const char* subsystemName, Log_Level_t messageLogLevel, const char* data, size_t dataSize, Write_Option_t option)
+    {
+        OutputWorker::GetInstance()->WriteEvent(subsystemName, (Level)messageLogLevel, data, dataSize, (WriteOption)option);
+    }
+
     void ConfiguratorOnChannelLevelChangeC(const char* channelName, Log_Level_t level)
     {
         Configurator::GetInstance()->OnChannelLevelChange(channelName, level);
@@ -463,12 +532,23 @@ OutputWorker::OutputWorker() :
     IsInDebugger(false),
     PluginsLock(),
     Plugins(),
+    MessagePool(new QueuedLogMessage[MessagePoolSize]),
+    FreeSlotTop(0),
+    ThreadBuffers(nullptr),
+    ThreadBufferCount(0),
+    WorkerIdle(true),
     WorkerWakeEvent(),
-    WorkQueueLock(),
+    WorkQueueConsumerLock(),
+    WorkQueueStub(),
+    WorkQueueHead(&WorkQueueStub),
+    WorkQueueTail(&WorkQueueStub),
+    WorkQueueSize(0),
     WorkQueueOverrun(0),
+    WorkQueuePending(nullptr),
     StartStopLock(),
     WorkerTerminator(),
-    LoggingThread()
+    LoggingThread(),
+    BatchCount(0)
 {
     #if defined(_WIN32)
         // Create a worker wake event
@@ -477,6 +557,13 @@ OutputWorker::OutputWorker() :
         // To do: Implement this.
     #endif
     
+    // Put all the pool slots on the free list
+    for (int i = 0; i < MessagePoolSize; ++i)
+    {
+        MessagePool[i].IsPooled = true;
+        FreeMessage(&MessagePool[i]);
+    }
+
     IsInDebugger = IsDebuggerAttached();
 
     InstallDefaultOutputPlugins();
@@ -669,15 +756,8 @@ void OutputWorker::Stop()
         LoggingThread.Clear();
     }
 
-    // Hold scoped work queue lock:
-    {
-        // This ensures that logs are not printed out of order on Stop(), and that Flush()
-        // can use the flag to check if a flush has already occurred.
-        Locker workQueueLock(WorkQueueLock);
-
-        // Finish the last set of queued messages to avoid losing any before Stop() returns.
-        ProcessQueuedMessages();
-    }
+    // Finish the last set of queued messages to avoid losing any before Stop() returns.
+    ProcessQueuedMessages();
 }
 
 
@@ -772,23 +852,16 @@ void OutputWorker::Flush()
     #if defined(_WIN32)
         AutoHandle flushEvent;
 
-        // Scoped work queue lock:
-        {
-            Locker workQueueLock(WorkQueueLock);
-
-            // Generate a flush event
-            flushEvent = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
-            LogStringBuffer buffer("Logging", ovrlog::Level::Info);
-            LogTime time = GetCurrentLogTime();
-            QueuedLogMessage* queuedBuffer = new QueuedLogMessage("Logging", ovrlog::Level::Info, "", time);
-            queuedBuffer->FlushEvent = flushEvent.Get();
+        // Generate a flush event
+        flushEvent = ::CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        LogTime time = GetCurrentLogTime();
+        QueuedLogMessage* queuedBuffer = AllocMessage(true);
+        queuedBuffer->Set("Logging", ovrlog::Level::Info, "", time);
+        queuedBuffer->FlushEvent = flushEvent.Get();
 
-            // Add queued buffer to the end of the work queue
-            WorkQueueAdd(queuedBuffer);
-
-            // Wake the worker thread
-            ::SetEvent(WorkerWakeEvent.Get());
-        }
+        // Add queued buffer to the end of the work queue, and wake the worker thread
+        QueueMessage(queuedBuffer);
+        ::SetEvent(WorkerWakeEvent.Get());
 
         // Wait until the event signals.
         // Since we are guaranteed to never lose log messages, as late as Stop() being called,
@@ -856,86 +929,157 @@ OVR_THREAD_FUNCTION_TYPE OutputWorker::WorkerThreadEntrypoint_(void* vworker)
 
 void OutputWorker::ProcessQueuedMessages()
 {
+    // Only one thread may remove from the work queue at a time.
+    Locker consumerLocker(WorkQueueConsumerLock);
+
     // Potentially trigger aggregated repeating messages.
     RepeatedMessageManagerInstance.Poll(this);
 
-    static const int TempBufferBytes = 1024; // 1 KiB
-    char HeaderBuffer[TempBufferBytes];
-
-    QueuedLogMessage* message = nullptr;
+    // Write behind any channel level changes.
+    Configurator::GetInstance()->SavePendingChannelLevels();
 
-    // Pull messages off the queue
-    int lostCount = 0;
+    // Take a copy of the plugin set for this batch, so adding and removing plugins doesn't
+    // wait on output.
     {
-        Locker locker(WorkQueueLock);
-        message = WorkQueueHead;
-        WorkQueueHead = WorkQueueTail = nullptr;
-        lostCount = WorkQueueOverrun;
-        WorkQueueOverrun = 0;
-        WorkQueueSize = 0;
-    }
-
-    if (message == nullptr)
-    {
-        // No data to process
-        return;
+        Locker locker(PluginsLock);
+        PluginsSnapshot.assign(Plugins.begin(), Plugins.end());
     }
 
     // Log output format:
     // TIMESTAMP <L> [SubSystem] Message
 
     // If some messages were lost,
+    int lostCount = WorkQueueOverrun.exchange(0);
     if (lostCount > 0)
     {
         char str[255];
         snprintf(str, sizeof(str), "Lost %i log messages due to queue overrun; try to reduce the amount of logging", lostCount);
 
-        // Insert at the front of the list
-        LogTime t = GetCurrentLogTime();
-        QueuedLogMessage* queuedMsg = new QueuedLogMessage("Logging", Level::Error, str, t);
-        queuedMsg->Next = message;
-        message = queuedMsg;
+        QueuedLogMessage* lostMsg = AllocMessage(true);
+        lostMsg->Set("Logging", Level::Error, str, GetCurrentLogTime());
+        AddToBatch(lostMsg);
     }
 
+    // Keep going until WorkQueueSize drops to zero, rather than just until the list looks empty:
+    // a writer increments the size before linking its message, and only the writer which takes
+    // the size up from zero wakes the worker thread, so we must not stop while one is mid-append.
+    int processedCount = 0;
+    for (;;)
     {
-        Locker locker(PluginsLock);
+        // Merge the work queue with the rings, taking whichever message was queued first.
+        if (WorkQueuePending == nullptr)
+            WorkQueuePending = WorkQueueRemove();
+
+        ThreadBuffer* messageBuffer;
+        QueuedLogMessage* message = PeekThreadMessage(messageBuffer);
 
-        // For each log message,
-        for (QueuedLogMessage* next; message; message = next)
+        if (WorkQueuePending != nullptr && (message == nullptr || WorkQueuePending->Tick < message->Tick))
         {
-            // If the message is a flush event,
-            if (message->FlushEvent != nullptr)
-            {
-                // Signal it to wake up the waiting Flush() call.
-                #if defined(_WIN32)
-                    ::SetEvent(message->FlushEvent);
-                #else
-                    // To do: Implement this. Ideally switch this OutputWorker class to use std::condition_variable
-                #endif
-            }
-            else
-            {
-                std::size_t timestampLength = GetTimestamp(HeaderBuffer, sizeof(HeaderBuffer), message->Time);
+            message = WorkQueuePending;
+            WorkQueuePending = nullptr;
+            ++processedCount;
+        }
+        else if (message != nullptr)
+        {
+            ++messageBuffer->ReadIndex;
+        }
+        else
+        {
+            // Write what we have before the queue can be seen as empty, so that a Flush() which
+            // finds it empty knows those messages are out.
+            WriteBatch();
+
+            const int remaining = WorkQueueSize.fetch_sub(processedCount, std::memory_order_acq_rel) - processedCount;
+            processedCount = 0;
+            if (remaining == 0)
+                break;
+
+            // A writer is between claiming its spot in the queue and linking its message.
+            std::this_thread::yield();
+            continue;
+        }
 
-                // Construct header on top of timestamp buffer
-                AppendHeader(HeaderBuffer + timestampLength, sizeof(HeaderBuffer) - timestampLength,
-                    message->MessageLogLevel, message->SubsystemName.Get());
+        // If the message is a flush event,
+        if (message->FlushEvent != nullptr)
+        {
+            // Write everything queued before it, then signal it to wake up the waiting Flush() call.
+            WriteBatch();
 
-                // For each plugin,
-                for (auto& plugin : Plugins)
-                {
-                    plugin->Write(
-                        message->MessageLogLevel,
-                        message->SubsystemName.Get(),
-                        HeaderBuffer,
-                        message->Buffer.c_str());
-                }
-            }
+            #if defined(_WIN32)
+                ::SetEvent(message->FlushEvent);
+            #else
+                // To do: Implement this. Ideally switch this OutputWorker class to use std::condition_variable
+            #endif
 
-            next = message->Next;
-            delete message;
+            FreeMessage(message);
+        }
+        else
+        {
+            AddToBatch(message);
         }
     }
+
+    // Don't keep removed plugins alive until the next wake.
+    PluginsSnapshot.clear();
+}
+
+void OutputWorker::AddToBatch(QueuedLogMessage* message)
+{
+    if (BatchCount == BatchSize)
+        WriteBatch();
+
+    const int index = BatchCount++;
+    char* header = BatchHeaders[index];
+
+    std::size_t timestampLength = GetTimestamp(header, BatchHeaderBytes, message->Time);
+
+    // Construct header on top of timestamp buffer
+    AppendHeader(header + timestampLength, BatchHeaderBytes - timestampLength,
+        message->MessageLogLevel, message->SubsystemName.Get());
+
+    OutputMessage& output = BatchMessages[index];
+    output.MessageLogLevel = message->MessageLogLevel;
+    output.SubsystemName = message->SubsystemName.Get();
+    output.Header = header;
+    output.Utf8Msg = message->Buffer.c_str();
+    output.Time = message->Time;
+    output.EventData = nullptr;
+    output.EventDataSize = 0;
+
+    if (message->DeferredFormat != nullptr)
+    {
+        std::string& deferredText = BatchDeferredText[index];
+        FormatDeferredLogMessage(message->DeferredFormat, message->Buffer.data(), message->Buffer.size(), deferredText);
+        output.Utf8Msg = deferredText.c_str();
+    }
+    else if (message->IsEvent)
+    {
+        std::string& eventText = BatchDeferredText[index];
+        FormatLogEvent(message->Buffer.data(), message->Buffer.size(), eventText);
+        output.Utf8Msg = eventText.c_str();
+        output.EventData = message->Buffer.data();
+        output.EventDataSize = message->Buffer.size();
+    }
+
+    BatchQueued[index] = message;
+}
+
+void OutputWorker::WriteBatch()
+{
+    if (BatchCount == 0)
+        return;
+
+    for (auto& plugin : PluginsSnapshot)
+    {
+        plugin->WriteBatch(BatchMessages, (size_t)BatchCount);
+    }
+
+    for (int i = 0; i < BatchCount; ++i)
+    {
+        FreeMessage(BatchQueued[i]);
+    }
+
+    BatchCount = 0;
 }
 
 void OutputWorker::FlushDbgViewLogImmediately(const char* subsystemName, Level messageLogLevel, const char* stream)
@@ -1018,82 +1162,456 @@ void OutputWorker::WorkerThreadEntrypoint()
     {
         if (WorkerTerminator.WaitOn(WorkerWakeEvent.Get()))
         {
-            ProcessQueuedMessages();
+            WorkerIdle.store(false, std::memory_order_relaxed);
+
+            for (;;)
+            {
+                ProcessQueuedMessages();
+
+                // From here writers to the rings wake us. Look at the rings once more, in case a
+                // message was queued after we finished but before a writer could see the flag.
+                // The fence pairs with the one in QueueMessage().
+                WorkerIdle.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                if (!HasThreadMessages())
+                    break;
+
+                WorkerIdle.store(false, std::memory_order_relaxed);
+            }
         }
     }
 }
 
 void OutputWorker::Write(const char* subsystemName, Level messageLogLevel, const char* stream, bool relogged, WriteOption option)
 {
-    bool dropped = false; // Flag indicates if the message was dropped due to queue overrun
-    bool needToWakeWorkerThread = false; // Flag indicates if we need to wake the worker thread
+    // Check to see if this message looks like it's repeat message which we want to aggregate
+    // in order to avoid log spam of the same similar message repeatedly.
+    if (RepeatedMessageManagerInstance.HandleMessage(subsystemName, messageLogLevel, stream) == 
+        RepeatedMessageManager::HandleResult::Aggregated)
+    {
+      return;
+    }
 
     // Add work to queue.
+    QueuedLogMessage* msg = AllocThreadMessage();
+    if (msg == nullptr)
     {
-        Locker locker(WorkQueueLock);
+        msg = AllocMessage(option == WriteOption::DangerouslyIgnoreQueueLimit);
+    }
 
-        // Check to see if this message looks like it's repeat message which we want to aggregate
-        // in order to avoid log spam of the same similar message repeatedly.
-        if (RepeatedMessageManagerInstance.HandleMessage(subsystemName, messageLogLevel, stream) == 
-            RepeatedMessageManager::HandleResult::Aggregated)
+    if (msg == nullptr)
+    {
+        // Record drop
+        WorkQueueOverrun.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        msg->Set(subsystemName, messageLogLevel, stream, GetCurrentLogTime());
+        QueueMessage(msg);
+    }
+
+    // If this is the first time logging this message,
+    if (!relogged)
+    {
+        // If we are in a debugger,
+        if (IsInDebugger)
         {
-          return;
+            FlushDbgViewLogImmediately(subsystemName, messageLogLevel, stream);
         }
+    }
+}
+
+void OutputWorker::WriteDeferred(const char* subsystemName, Level messageLogLevel, const char* format, const char* data, size_t dataSize, WriteOption option)
+{
+    // Deferred messages skip the RepeatedMessageManager, which compares the formatted text.
+
+    QueuedLogMessage* msg = AllocThreadMessage();
+    if (msg == nullptr)
+    {
+        msg = AllocMessage(option == WriteOption::DangerouslyIgnoreQueueLimit);
+    }
+
+    if (msg == nullptr)
+    {
+        // Record drop
+        WorkQueueOverrun.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        msg->SetDeferred(subsystemName, messageLogLevel, format, data, dataSize, GetCurrentLogTime());
+        QueueMessage(msg);
+    }
+
+    // The debugger output is immediate, so it has to be formatted here.
+    if (IsInDebugger)
+    {
+        std::string text;
+        FormatDeferredLogMessage(format, data, dataSize, text);
+        FlushDbgViewLogImmediately(subsystemName, messageLogLevel, text.c_str());
+    }
+}
+
+void OutputWorker::WriteEvent(const char* subsystemName, Level messageLogLevel, const char* data, size_t dataSize, WriteOption option)
+{
+    // Events skip the RepeatedMessageManager, as they are expected to repeat with new values.
+
+    QueuedLogMessage* msg = AllocThreadMessage();
+    if (msg == nullptr)
+    {
+        msg = AllocMessage(option == WriteOption::DangerouslyIgnoreQueueLimit);
+    }
+
+    if (msg == nullptr)
+    {
+        // Record drop
+        WorkQueueOverrun.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        msg->SetLogEvent(subsystemName, messageLogLevel, data, dataSize, GetCurrentLogTime());
+        QueueMessage(msg);
+    }
+
+    if (IsInDebugger)
+    {
+        std::string text;
+        FormatLogEvent(data, dataSize, text);
+        FlushDbgViewLogImmediately(subsystemName, messageLogLevel, text.c_str());
+    }
+}
+
+void OutputWorker::WakeWorkerThread()
+{
+    #if defined(_WIN32)
+        ::SetEvent(WorkerWakeEvent.Get());
+    #else
+        // To do: Implement this. Ideally switch this OutputWorker class to use std::condition_variable
+    #endif
+}
+
+OutputWorker::QueuedLogMessage* OutputWorker::AllocMessage(bool ignoreQueueLimit)
+{
+    // Pop a slot off the free list
+    uint64_t top = FreeSlotTop.load(std::memory_order_acquire);
+    while ((uint32_t)top != 0)
+    {
+        QueuedLogMessage* slot = &MessagePool[(uint32_t)top - 1];
+        uint64_t next = (top & 0xffffffff00000000ull) | slot->NextFreeSlot.load(std::memory_order_relaxed);
+
+        if (FreeSlotTop.compare_exchange_weak(top, next, std::memory_order_acquire, std::memory_order_acquire))
+            return slot;
+    }
+
+    // All the slots are queued. Absorb the burst on the heap, unless the queue is at its limit.
+    if (!ignoreQueueLimit && WorkQueueSize.load(std::memory_order_relaxed) >= WorkQueueLimit)
+        return nullptr;
+
+    return new QueuedLogMessage();
+}
+
+void OutputWorker::FreeMessage(QueuedLogMessage* msg)
+{
+    if (msg->OwnerBuffer != nullptr)
+    {
+        if (msg->Buffer.capacity() > MaxPooledBufferBytes)
+            std::string().swap(msg->Buffer);
+
+        // The merge keeps each ring's messages in order, and WriteBatch() frees them in batch
+        // order, so a ring's slots always come back oldest first.
+        ThreadBuffer* buffer = msg->OwnerBuffer;
+        buffer->Head.store(buffer->Head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        return;
+    }
+
+    if (!msg->IsPooled)
+    {
+        delete msg;
+        return;
+    }
+
+    if (msg->Buffer.capacity() > MaxPooledBufferBytes)
+        std::string().swap(msg->Buffer);
+
+    const uint32_t slotIndex = (uint32_t)(msg - MessagePool.get());
+    uint64_t top = FreeSlotTop.load(std::memory_order_relaxed);
+    uint64_t newTop;
+    do
+    {
+        msg->NextFreeSlot.store((uint32_t)top, std::memory_order_relaxed);
+        newTop = ((top & 0xffffffff00000000ull) + 0x100000000ull) | (slotIndex + 1);
+    } while (!FreeSlotTop.compare_exchange_weak(top, newTop, std::memory_order_release, std::memory_order_relaxed));
+}
 
-        if (option != WriteOption::DangerouslyIgnoreQueueLimit &&
-            WorkQueueSize >= WorkQueueLimit)
+bool OutputWorker::WorkQueueAdd(QueuedLogMessage* msg)
+{
+    // Count the message before it is visible, so the consumer never sees a zero size while
+    // there is a message it has not yet reached.
+    const bool wasEmpty = (WorkQueueSize.fetch_add(1, std::memory_order_acq_rel) == 0);
+    WorkQueueLink(msg);
+    return wasEmpty;
+}
+
+void OutputWorker::WorkQueueLink(QueuedLogMessage* msg)
+{
+    msg->Next.store(nullptr, std::memory_order_relaxed);
+    QueuedLogMessage* prev = WorkQueueTail.exchange(msg, std::memory_order_acq_rel);
+
+    // Until this store the list is cut between prev and msg; WorkQueueRemove() reports it as
+    // empty at that point.
+    prev->Next.store(msg, std::memory_order_release);
+}
+
+OutputWorker::QueuedLogMessage* OutputWorker::WorkQueueRemove()
+{
+    QueuedLogMessage* head = WorkQueueHead;
+    QueuedLogMessage* next = head->Next.load(std::memory_order_acquire);
+
+    // Step over the stub
+    if (head == &WorkQueueStub)
+    {
+        if (next == nullptr)
+            return nullptr;
+        WorkQueueHead = head = next;
+        next = next->Next.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr)
+    {
+        WorkQueueHead = next;
+        return head;
+    }
+
+    // head is the last linked node. If it is not the tail, a writer is linking a node after it.
+    if (head != WorkQueueTail.load(std::memory_order_acquire))
+        return nullptr;
+
+    // Put the stub back behind head so head can be removed without emptying the list.
+    WorkQueueLink(&WorkQueueStub);
+
+    next = head->Next.load(std::memory_order_acquire);
+    if (next != nullptr)
+    {
+        WorkQueueHead = next;
+        return head;
+    }
+
+    return nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// ThreadBuffer
+
+thread_local OutputWorker::ThreadBufferReference OutputWorker::CurrentThreadBuffer;
+
+OutputWorker::ThreadBuffer::ThreadBuffer() :
+    Slots(),
+    Tail(0),
+    Head(0),
+    ReadIndex(0),
+    ReadTail(0),
+    Owned(false),
+    NextBuffer(nullptr)
+{
+    for (QueuedLogMessage& slot : Slots)
+    {
+        slot.OwnerBuffer = this;
+    }
+}
+
+OutputWorker::ThreadBufferReference::~ThreadBufferReference()
+{
+    // The buffer may still have messages in it; the worker writes them out as usual.
+    if (Buffer != nullptr)
+    {
+        Buffer->Owned.store(false, std::memory_order_release);
+        Buffer = nullptr;
+    }
+
+    Exited = true;
+}
+
+OutputWorker::ThreadBuffer* OutputWorker::GetThreadBuffer()
+{
+    ThreadBufferReference& reference = CurrentThreadBuffer;
+    if (reference.Buffer != nullptr || reference.Exited)
+    {
+        return reference.Buffer;
+    }
+
+    // Adopt the buffer of a thread which has exited, if there is one.
+    ThreadBuffer* head = ThreadBuffers.load(std::memory_order_acquire);
+    for (ThreadBuffer* buffer = head; buffer != nullptr; buffer = buffer->NextBuffer)
+    {
+        bool owned = false;
+        if (!buffer->Owned.load(std::memory_order_relaxed) &&
+            buffer->Owned.compare_exchange_strong(owned, true, std::memory_order_acquire, std::memory_order_relaxed))
         {
-            // Record drop
-            WorkQueueOverrun++;
-            dropped = true;
+            reference.Buffer = buffer;
+            return buffer;
         }
-        else
-        {
-            // Add queued buffer to the end of the work queue
-            LogTime time = GetCurrentLogTime();
-            WorkQueueAdd(new QueuedLogMessage(subsystemName, messageLogLevel, stream, time));
+    }
 
-            // Only need to wake the worker thread on the first message
-            // The SetEvent() call takes 6 microseconds or so
-            if (WorkQueueSize <= 1)
-            {
-                needToWakeWorkerThread = true;
-            }
+    if (ThreadBufferCount.fetch_add(1, std::memory_order_relaxed) >= MaxThreadBuffers)
+    {
+        // This thread uses the work queue from now on, rather than searching again every message.
+        ThreadBufferCount.fetch_sub(1, std::memory_order_relaxed);
+        reference.Exited = true;
+        return nullptr;
+    }
+
+    ThreadBuffer* buffer = new ThreadBuffer();
+    buffer->Owned.store(true, std::memory_order_relaxed);
+
+    buffer->NextBuffer = head;
+    while (!ThreadBuffers.compare_exchange_weak(buffer->NextBuffer, buffer, std::memory_order_release, std::memory_order_acquire))
+    {
+    }
+
+    reference.Buffer = buffer;
+    return buffer;
+}
+
+OutputWorker::QueuedLogMessage* OutputWorker::AllocThreadMessage()
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    if (buffer == nullptr)
+    {
+        return nullptr;
+    }
+
+    const uint32_t tail = buffer->Tail.load(std::memory_order_relaxed);
+    if (tail - buffer->Head.load(std::memory_order_acquire) >= ThreadBufferSize)
+    {
+        return nullptr; // The ring is full
+    }
+
+    return &buffer->Slots[tail & (ThreadBufferSize - 1)];
+}
+
+void OutputWorker::QueueMessage(QueuedLogMessage* msg)
+{
+    msg->Tick = GetCurrentLogTick();
+
+    ThreadBuffer* buffer = msg->OwnerBuffer;
+    if (buffer == nullptr)
+    {
+        // Only need to wake the worker thread on the first message
+        // The SetEvent() call takes 6 microseconds or so
+        if (WorkQueueAdd(msg))
+        {
+            WakeWorkerThread();
         }
+        return;
     }
 
-    if (!dropped && needToWakeWorkerThread)
+    buffer->Tail.store(buffer->Tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+
+    // Either the worker sees this message when it looks at the rings before waiting, or we see it
+    // idle here; only the first writer to see it idle wakes it. See WorkerThreadEntrypoint().
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (WorkerIdle.load(std::memory_order_relaxed) && WorkerIdle.exchange(false, std::memory_order_relaxed))
     {
-        // Wake the worker thread
-        #if defined(_WIN32)
-            ::SetEvent(WorkerWakeEvent.Get());
-        #else
-            // To do: Implement this. Ideally switch this OutputWorker class to use std::condition_variable
-        #endif
+        WakeWorkerThread();
     }
+}
 
-    // If this is the first time logging this message,
-    if (!relogged)
+OutputWorker::QueuedLogMessage* OutputWorker::PeekThreadMessage(ThreadBuffer*& messageBuffer)
+{
+    // A linear scan for the oldest head is cheap next to writing the message, with at most
+    // MaxThreadBuffers rings.
+    QueuedLogMessage* oldest = nullptr;
+    messageBuffer = nullptr;
+
+    for (ThreadBuffer* buffer = ThreadBuffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->NextBuffer)
     {
-        // If we are in a debugger,
-        if (IsInDebugger)
+        // Only read the writer's Tail again once we've reached the last one we read.
+        if (buffer->ReadIndex == buffer->ReadTail)
         {
-            FlushDbgViewLogImmediately(subsystemName, messageLogLevel, stream);
+            buffer->ReadTail = buffer->Tail.load(std::memory_order_acquire);
+            if (buffer->ReadIndex == buffer->ReadTail)
+                continue;
+        }
+
+        QueuedLogMessage* msg = &buffer->Slots[buffer->ReadIndex & (ThreadBufferSize - 1)];
+        if (oldest == nullptr || msg->Tick < oldest->Tick)
+        {
+            oldest = msg;
+            messageBuffer = buffer;
         }
     }
+
+    return oldest;
+}
+
+bool OutputWorker::HasThreadMessages()
+{
+    Locker consumerLocker(WorkQueueConsumerLock);
+
+    for (ThreadBuffer* buffer = ThreadBuffers.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->NextBuffer)
+    {
+        if (buffer->Tail.load(std::memory_order_acquire) != buffer->ReadIndex)
+            return true;
+    }
+
+    return false;
+}
+
+int64_t OutputWorker::GetCurrentLogTick()
+{
+    return (int64_t)std::chrono::steady_clock::now().time_since_epoch().count();
 }
 
 //-----------------------------------------------------------------------------
 // QueuedLogMessage
 
-OutputWorker::QueuedLogMessage::QueuedLogMessage(const char* subsystemName, Level messageLogLevel, const char* stream, const LogTime& time) :
-    SubsystemName(subsystemName),
-    MessageLogLevel(messageLogLevel),
-    Buffer(stream),
-    Time(time),
+OutputWorker::QueuedLogMessage::QueuedLogMessage() :
+    SubsystemName(""),
+    MessageLogLevel(Level::Info),
+    Buffer(),
+    Time(),
+    Tick(0),
     Next(nullptr),
-    FlushEvent(nullptr)
+    FlushEvent(nullptr),
+    DeferredFormat(nullptr),
+    IsEvent(false),
+    IsPooled(false),
+    OwnerBuffer(nullptr),
+    NextFreeSlot(0)
+{
+}
+
+void OutputWorker::QueuedLogMessage::Set(const char* subsystemName, Level messageLogLevel, const char* stream, const LogTime& time)
+{
+    SubsystemName = Name(subsystemName);
+    MessageLogLevel = messageLogLevel;
+    Buffer.assign(stream); // Reuses the existing allocation if it is large enough
+    Time = time;
+    FlushEvent = nullptr;
+    DeferredFormat = nullptr;
+    IsEvent = false;
+}
+
+void OutputWorker::QueuedLogMessage::SetDeferred(const char* subsystemName, Level messageLogLevel, const char* format, const char* data, size_t dataSize, const LogTime& time)
+{
+    SubsystemName = Name(subsystemName);
+    MessageLogLevel = messageLogLevel;
+    Buffer.assign(data, dataSize);
+    Time = time;
+    FlushEvent = nullptr;
+    DeferredFormat = format;
+    IsEvent = false;
+}
+
+void OutputWorker::QueuedLogMessage::SetLogEvent(const char* subsystemName, Level messageLogLevel, const char* data, size_t dataSize, const LogTime& time)
 {
+    SubsystemName = Name(subsystemName);
+    MessageLogLevel = messageLogLevel;
+    Buffer.assign(data, dataSize);
+    Time = time;
+    FlushEvent = nullptr;
+    DeferredFormat = nullptr;
+    IsEvent = true;
 }
 
 void Channel::GetFunctionPointers()
@@ -1103,6 +1621,8 @@ void Channel::GetFunctionPointers()
     {
         #if defined(_WIN32)
             OutputWorkerOutputFunction = (OutputWorkerOutputFunctionType)GetProcAddress(GetModuleHandle(NULL), "OutputWorkerOutputFunctionC");
+            OutputWorkerDeferredOutputFunction = (OutputWorkerDeferredOutputFunctionType)GetProcAddress(GetModuleHandle(NULL), "OutputWorkerDeferredOutputFunctionC");
+            OutputWorkerEventOutputFunction = (OutputWorkerEventOutputFunctionType)GetProcAddress(GetModuleHandle(NULL), "OutputWorkerEventOutputFunctionC");
             ConfiguratorOnChannelLevelChange = (ConfiguratorOnChannelLevelChangeType)GetProcAddress(GetModuleHandle(NULL), "ConfiguratorOnChannelLevelChangeC");
             ConfiguratorRegister = (ConfiguratorRegisterType)GetProcAddress(GetModuleHandle(NULL), "ConfiguratorRegisterC");
             ConfiguratorUnregister = (ConfiguratorUnregisterType)GetProcAddress(GetModuleHandle(NULL), "ConfiguratorUnregisterC");
@@ -1113,6 +1633,12 @@ void Channel::GetFunctionPointers()
         if (!OutputWorkerOutputFunction)
             OutputWorkerOutputFunction = OutputWorkerOutputFunctionC;
 
+        if (!OutputWorkerDeferredOutputFunction)
+            OutputWorkerDeferredOutputFunction = OutputWorkerDeferredOutputFunctionC;
+
+        if (!OutputWorkerEventOutputFunction)
+            OutputWorkerEventOutputFunction = OutputWorkerEventOutputFunctionC;
+
         if (!ConfiguratorOnChannelLevelChange)
             ConfiguratorOnChannelLevelChange = ConfiguratorOnChannelLevelChangeC;
 
@@ -1146,6 +1672,15 @@ Channel::Channel(const char* nameString) :
     registerNode();
 }
 
+Channel::Channel(const char* nameString, Level defaultMinimumOutputLevel) :
+    DefaultMinimumOutputLevel(defaultMinimumOutputLevel),
+    SubsystemName(nameString),
+    MinimumOutputLevel((Log_Level_t)DefaultMinimumOutputLevel),
+    UserOverrodeMinimumOutputLevel(false)
+{
+    registerNode();
+}
+
 Channel::Channel(const Channel& other) :
     SubsystemName(other.SubsystemName),
     MinimumOutputLevel(other.MinimumOutputLevel),
@@ -1258,6 +1793,346 @@ void LogStringize(LogStringBuffer& buffer, const wchar_t* const & first)
 }
 
 
+//-----------------------------------------------------------------------------
+// Deferred log formatting
+
+bool DeferredArgReader::Read(DeferredArg& arg)
+{
+    if (Remaining == 0 || Malformed)
+        return false;
+
+    arg.Type = (DeferredArgType)(uint8_t)*Data;
+    advance(1);
+    arg.Integer = 0;
+    arg.Double = 0;
+    arg.String = "";
+
+    switch (arg.Type)
+    {
+    case DeferredArgType::Int32:
+    {
+        int32_t value32;
+        if (!readBytes(&value32, sizeof(value32)))
+            return false;
+        arg.Integer = value32;
+        return true;
+    }
+    case DeferredArgType::Int64:
+    case DeferredArgType::Pointer:
+        return readBytes(&arg.Integer, sizeof(arg.Integer));
+    case DeferredArgType::Double:
+        return readBytes(&arg.Double, sizeof(arg.Double));
+    case DeferredArgType::String:
+    {
+        uint32_t length;
+        if (!readBytes(&length, sizeof(length)) || Remaining < (size_t)length + 1 || Data[length] != '\0')
+            break;
+        arg.String = Data;
+        advance((size_t)length + 1);
+        return true;
+    }
+    default:
+        break;
+    }
+
+    Malformed = true;
+    return false;
+}
+
+void DeferredArgReader::advance(size_t bytes)
+{
+    Data += bytes;
+    Remaining -= bytes;
+}
+
+bool DeferredArgReader::readBytes(void* value, size_t bytes)
+{
+    if (Remaining < bytes)
+    {
+        Malformed = true;
+        return false;
+    }
+    memcpy(value, Data, bytes);
+    advance(bytes);
+    return true;
+}
+
+namespace {
+
+template<typename T>
+void AppendFormatted(std::string& output, const char* spec, T value)
+{
+    char buffer[128];
+    int length = snprintf(buffer, sizeof(buffer), spec, value);
+    if (length < 0)
+        return;
+
+    if ((size_t)length < sizeof(buffer))
+    {
+        output.append(buffer, (size_t)length);
+    }
+    else
+    {
+        const size_t offset = output.size();
+        output.resize(offset + (size_t)length + 1);
+        snprintf(&output[offset], (size_t)length + 1, spec, value);
+        output.resize(offset + (size_t)length);
+    }
+}
+
+// Appends arg as formatted by the printf conversion specification spec, which holds the flags,
+// width and precision, and conversion, the conversion character with any length modifiers
+// removed. The length modifier is chosen from the argument's type instead.
+void AppendDeferredArg(std::string& output, std::string& spec, char conversion, const DeferredArg& arg)
+{
+    const bool isIntegerConversion = (strchr("diouxXc", conversion) != nullptr);
+    const bool isFloatConversion = (strchr("eEfFgGaA", conversion) != nullptr);
+
+    switch (arg.Type)
+    {
+    case DeferredArgType::Int32:
+    case DeferredArgType::Int64:
+        if (conversion == 'c')
+        {
+            spec += 'c';
+            AppendFormatted(output, spec.c_str(), (int)arg.Integer);
+        }
+        else if (isFloatConversion)
+        {
+            spec += conversion;
+            AppendFormatted(output, spec.c_str(), (double)arg.Integer);
+        }
+        else
+        {
+            // Int32 values sign extend on decoding; an unsigned conversion must only see the
+            // original 32 bits.
+            if (!isIntegerConversion)
+                conversion = 'd';
+            spec += "ll";
+            spec += conversion;
+            if (conversion == 'd' || conversion == 'i')
+                AppendFormatted(output, spec.c_str(), (long long)arg.Integer);
+            else if (arg.Type == DeferredArgType::Int32)
+                AppendFormatted(output, spec.c_str(), (unsigned long long)(uint32_t)arg.Integer);
+            else
+                AppendFormatted(output, spec.c_str(), (unsigned long long)arg.Integer);
+        }
+        break;
+
+    case DeferredArgType::Double:
+        spec += (isFloatConversion ? conversion : 'g');
+        AppendFormatted(output, spec.c_str(), arg.Double);
+        break;
+
+    case DeferredArgType::Pointer:
+        if (conversion == 'x' || conversion == 'X')
+        {
+            spec += "ll";
+            spec += conversion;
+            AppendFormatted(output, spec.c_str(), (unsigned long long)arg.Integer);
+        }
+        else
+        {
+            spec += 'p';
+            AppendFormatted(output, spec.c_str(), (const void*)(uintptr_t)arg.Integer);
+        }
+        break;
+
+    case DeferredArgType::String:
+        if (spec.size() == 1) // If there are no flags, width or precision (the common case)
+        {
+            output += arg.String;
+        }
+        else
+        {
+            spec += 's';
+            AppendFormatted(output, spec.c_str(), arg.String);
+        }
+        break;
+    }
+}
+
+} // namespace
+
+bool FormatDeferredLogMessage(const char* format, const char* data, size_t dataSize, std::string& output)
+{
+    output.clear();
+
+    DeferredArgReader reader(data, dataSize);
+    DeferredArg arg;
+
+    // The channel prefix comes first
+    if (reader.Read(arg) && arg.Type == DeferredArgType::String)
+        output += arg.String;
+
+    if (!format)
+        return !reader.IsMalformed();
+
+    std::string spec;
+    const char* p = format;
+    while (*p)
+    {
+        if (*p != '%')
+        {
+            const char* next = strchr(p, '%');
+            if (!next)
+            {
+                output += p;
+                break;
+            }
+            output.append(p, next - p);
+            p = next;
+            continue;
+        }
+
+        if (p[1] == '%')
+        {
+            output += '%';
+            p += 2;
+            continue;
+        }
+
+        // Parse the conversion specification: %[flags][width][.precision][length]conversion
+        const char* specBegin = p++;
+        spec = '%';
+        bool argsMissing = false;
+
+        while (*p && strchr("-+ #0", *p))
+            spec += *p++;
+
+        for (int field = 0; field < 2; ++field) // Width, then precision
+        {
+            if (field == 1)
+            {
+                if (*p != '.')
+                    break;
+                spec += *p++;
+            }
+
+            if (*p == '*') // Width or precision passed as an argument
+            {
+                ++p;
+                if (reader.Read(arg) && (arg.Type == DeferredArgType::Int32 || arg.Type == DeferredArgType::Int64))
+                    spec += std::to_string((int)arg.Integer);
+                else
+                    argsMissing = true;
+            }
+            else
+            {
+                while (*p >= '0' && *p <= '9')
+                    spec += *p++;
+            }
+        }
+
+        // Skip length modifiers, including Microsoft's I, I32 and I64
+        while (*p && strchr("hljztLqI", *p))
+        {
+            if (p[0] == 'I' && ((p[1] == '3' && p[2] == '2') || (p[1] == '6' && p[2] == '4')))
+                p += 2;
+            ++p;
+        }
+
+        const char conversion = *p;
+        if (conversion == '\0')
+        {
+            output += specBegin;
+            break;
+        }
+        ++p;
+
+        if (argsMissing || !reader.Read(arg))
+        {
+            // Print the specification as written for arguments which weren't recorded.
+            output.append(specBegin, p - specBegin);
+            continue;
+        }
+
+        AppendDeferredArg(output, spec, conversion, arg);
+    }
+
+    return !reader.IsMalformed();
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Structured log events
+
+LogEventReader::LogEventReader(const char* data, size_t dataSize) :
+    Reader(data, dataSize),
+    Prefix(""),
+    EventName("")
+{
+    DeferredArg arg;
+
+    if (Reader.Read(arg) && arg.Type == DeferredArgType::String)
+        Prefix = arg.String;
+
+    if (Reader.Read(arg) && arg.Type == DeferredArgType::String)
+        EventName = arg.String;
+}
+
+bool LogEventReader::Next(const char*& name, DeferredArg& value)
+{
+    DeferredArg nameArg;
+
+    // A field whose value didn't fit in the DeferredArgWriter is dropped along with its name.
+    if (!Reader.Read(nameArg) || nameArg.Type != DeferredArgType::String || !Reader.Read(value))
+        return false;
+
+    name = nameArg.String;
+    return true;
+}
+
+bool FormatLogEvent(const char* data, size_t dataSize, std::string& output)
+{
+    output.clear();
+
+    LogEventReader reader(data, dataSize);
+    output += reader.GetPrefix();
+    output += reader.GetName();
+
+    const char* name;
+    DeferredArg value;
+    while (reader.Next(name, value))
+    {
+        output += ' ';
+        output += name;
+        output += '=';
+
+        switch (value.Type)
+        {
+        case DeferredArgType::Int32:
+        case DeferredArgType::Int64:
+            AppendFormatted(output, "%lld", (long long)value.Integer);
+            break;
+        case DeferredArgType::Double:
+            AppendFormatted(output, "%g", value.Double);
+            break;
+        case DeferredArgType::Pointer:
+            AppendFormatted(output, "0x%llx", (unsigned long long)value.Integer);
+            break;
+        case DeferredArgType::String:
+            output += '"';
+            for (const char* p = value.String; *p; ++p) // Escaped to keep the event on one line
+            {
+                if (*p == '\n')
+                {
+                    output += "\\n";
+                    continue;
+                }
+                if (*p == '"' || *p == '\\')
+                    output += '\\';
+                output += *p;
+            }
+            output += '"';
+            break;
+        }
+    }
+
+    return !reader.IsMalformed();
+}
+
 //-----------------------------------------------------------------------------
 // ConfiguratorPlugin
 
@@ -1269,13 +2144,31 @@ ConfiguratorPlugin::~ConfiguratorPlugin()
 {
 }
 
+bool ConfiguratorPlugin::LoadChannelLevels(std::vector< std::pair<std::string, Level> >& levels)
+{
+    levels.clear();
+    return false;
+}
+
+void ConfiguratorPlugin::SaveChannelLevels(const std::vector< std::pair<std::string, Level> >& levels)
+{
+    for (const auto& channelLevel : levels)
+    {
+        SaveChannelLevel(channelLevel.first.c_str(), channelLevel.second);
+    }
+}
+
 
 //-----------------------------------------------------------------------------
 // Log Configurator
 
 Configurator::Configurator() :
     GlobalMinimumLogLevel((Log_Level_t) Level::Debug),
-    Plugin(nullptr)
+    Plugin(nullptr),
+    ChannelLevelCache(),
+    ChannelLevelCacheComplete(false),
+    PendingChannelLevelSaves(),
+    HasPendingChannelLevelSaves(false)
 {
 }
 
@@ -1307,10 +2200,7 @@ void Configurator::RestoreChannelLogLevel(const char* channelName)
     Level level = (Level) GlobalMinimumLogLevel;
 
     // Look up the log level for this channel if we can
-    if (Plugin)
-    {
-        Plugin->RestoreChannelLevel(channelName, level);
-    }
+    LookupChannelLevelNoLock(channelName, level);
 
     const std::string stdChannelName(channelName);
 
@@ -1322,10 +2212,7 @@ void Configurator::RestoreChannelLogLevel(ChannelNode* channelNode)
     Level level = (Level)GlobalMinimumLogLevel;
 
     // Look up the log level for this channel if we can
-    if (Plugin)
-    {
-        Plugin->RestoreChannelLevel(channelNode->SubsystemName, level);
-    }
+    LookupChannelLevelNoLock(channelNode->SubsystemName, level);
 
     // Don't undo user calls to SetMinimumOutputLevelNoSave()
     if (*(channelNode->UserOverrodeMinimumOutputLevel) == false)
@@ -1352,8 +2239,22 @@ void Configurator::SetPlugin(std::shared_ptr<ConfiguratorPlugin> plugin)
 {
     Locker locker(OutputWorker::GetInstance()->GetChannelsLock());
 
+    // Changes not yet written belong to the old plugin.
+    SavePendingChannelLevelsNoLock();
+
     Plugin = plugin;
 
+    // Read all the stored levels at once if the plugin can, rather than one per channel.
+    ChannelLevelCache.clear();
+    ChannelLevelCacheComplete = false;
+
+    std::vector< std::pair<std::string, Level> > levels;
+    if (Plugin && Plugin->LoadChannelLevels(levels))
+    {
+        ChannelLevelCache.insert(levels.begin(), levels.end());
+        ChannelLevelCacheComplete = true;
+    }
+
     for (ChannelNode* channelNode = ChannelNodeHead; channelNode; channelNode = channelNode->Next)
     {
         RestoreChannelLogLevel(channelNode->SubsystemName);
@@ -1399,8 +2300,74 @@ void Configurator::OnChannelLevelChange(const char* channelName, Log_Level_t min
 
     if (Plugin)
     {
-        // Save channel level
-        Plugin->SaveChannelLevel(channelName, (Level) minimumOutputLevel);
+        // Save channel level, from the worker thread.
+        const std::string stdChannelName(channelName);
+        ChannelLevelCache[stdChannelName] = (Level) minimumOutputLevel;
+        PendingChannelLevelSaves[stdChannelName] = (Level) minimumOutputLevel;
+        HasPendingChannelLevelSaves.store(true, std::memory_order_release);
+
+        OutputWorker::GetInstance()->WakeWorkerThread();
+    }
+}
+
+bool Configurator::LookupChannelLevelNoLock(const char* channelName, Level& level)
+{
+    if (!Plugin)
+    {
+        return false;
+    }
+
+    const std::string stdChannelName(channelName);
+
+    auto it = ChannelLevelCache.find(stdChannelName);
+    if (it == ChannelLevelCache.end())
+    {
+        if (ChannelLevelCacheComplete)
+        {
+            return false;
+        }
+
+        // Level::Count is left as-is by a plugin with no level for the channel.
+        Level storedLevel = Level::Count;
+        Plugin->RestoreChannelLevel(channelName, storedLevel);
+        it = ChannelLevelCache.emplace(stdChannelName, storedLevel).first;
+    }
+
+    if (it->second == Level::Count)
+    {
+        return false;
+    }
+
+    level = it->second;
+    return true;
+}
+
+void Configurator::SavePendingChannelLevels()
+{
+    if (!HasPendingChannelLevelSaves.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    Locker locker(OutputWorker::GetInstance()->GetChannelsLock());
+    SavePendingChannelLevelsNoLock();
+}
+
+void Configurator::SavePendingChannelLevelsNoLock()
+{
+    HasPendingChannelLevelSaves.store(false, std::memory_order_relaxed);
+
+    if (PendingChannelLevelSaves.empty())
+    {
+        return;
+    }
+
+    std::vector< std::pair<std::string, Level> > levels(PendingChannelLevelSaves.begin(), PendingChannelLevelSaves.end());
+    PendingChannelLevelSaves.clear();
+
+    if (Plugin)
+    {
+        Plugin->SaveChannelLevels(levels);
     }
 }
 
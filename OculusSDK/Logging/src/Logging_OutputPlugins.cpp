@@ -27,9 +27,17 @@ limitations under the License.
 #include "Logging/Logging_OutputPlugins.h"
 #include "Logging/Logging_Tools.h"
 
+#include <cmath>
 #include <iostream>
 #include <time.h>
 
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <stdio.h>
+    #include <sys/mman.h>
+    #include <unistd.h>
+#endif
+
 namespace ovrlog {
 
 
@@ -56,6 +64,57 @@ const char* OutputConsole::GetUniquePluginName()
     return "DefaultOutputConsole";
 }
 
+#if defined(_WIN32)
+static WORD GetConsoleAttributes(Level level)
+{
+    WORD attr = 0;
+
+    switch (level)
+    {
+    case Level::Disabled: // Shouldn't occur, but we handle for consistency.
+        attr |= FOREGROUND_BLUE;
+        break;
+    case Level::Trace:
+        attr |= FOREGROUND_BLUE | FOREGROUND_RED;
+        break;
+    case Level::Debug:
+        attr |= FOREGROUND_BLUE | FOREGROUND_GREEN | FOREGROUND_RED;
+        break;
+    case Level::Info:
+        attr |= FOREGROUND_BLUE | FOREGROUND_GREEN | FOREGROUND_RED | FOREGROUND_INTENSITY;
+        break;
+    case Level::Warning:
+        attr |= FOREGROUND_GREEN | FOREGROUND_RED | FOREGROUND_INTENSITY;
+        break;
+    case Level::Error:
+        attr |= FOREGROUND_RED | FOREGROUND_INTENSITY;
+        break;
+    default:
+        break;
+    }
+    static_assert(Level::Count == static_cast<Level>(6), "Needs updating");
+
+    return attr;
+}
+#else
+// Returns the stream for level, and sets colorPrefix to the escape sequence that colors its header.
+static FILE* GetConsoleStream(Level level, const char*& colorPrefix)
+{
+    switch(level)
+    {
+    case Level::Warning:
+      colorPrefix = "\e[38;5;255m\e[48;5;208m";
+      return stderr;
+    case Level::Error:
+      colorPrefix = "\e[38;5;255m\e[48;5;196m";
+      return stderr;
+    default:
+      colorPrefix = "";
+      return stdout;
+    }
+}
+#endif
+
 void OutputConsole::Write(Level level, const char* /*subsystem*/, const char* header, const char* utf8msg)
 {
     #if defined(_WIN32)
@@ -64,32 +123,7 @@ void OutputConsole::Write(Level level, const char* /*subsystem*/, const char* he
         // Save current console attributes
         CONSOLE_SCREEN_BUFFER_INFO bufInfo{};
         BOOL oldAttrValid = ::GetConsoleScreenBufferInfo(hConsole, &bufInfo);
-        WORD attr = 0;
-
-        switch (level)
-        {
-        case Level::Disabled: // Shouldn't occur, but we handle for consistency.
-            attr |= FOREGROUND_BLUE;
-            break;
-        case Level::Trace:
-            attr |= FOREGROUND_BLUE | FOREGROUND_RED;
-            break;
-        case Level::Debug:
-            attr |= FOREGROUND_BLUE | FOREGROUND_GREEN | FOREGROUND_RED;
-            break;
-        case Level::Info:
-            attr |= FOREGROUND_BLUE | FOREGROUND_GREEN | FOREGROUND_RED | FOREGROUND_INTENSITY;
-            break;
-        case Level::Warning:
-            attr |= FOREGROUND_GREEN | FOREGROUND_RED | FOREGROUND_INTENSITY;
-            break;
-        case Level::Error:
-            attr |= FOREGROUND_RED | FOREGROUND_INTENSITY;
-            break;
-        default:
-            break;
-        }
-        static_assert(Level::Count == static_cast<Level>(6), "Needs updating");
+        WORD attr = GetConsoleAttributes(level);
 
         ::SetConsoleTextAttribute(hConsole, attr & ~FOREGROUND_INTENSITY);
 
@@ -126,28 +160,10 @@ void OutputConsole::Write(Level level, const char* /*subsystem*/, const char* he
         }
     #else
 
-        FILE* output = stdout;
-
-        switch(level)
-        {
-        case Level::Trace:
-          break;
-        case Level::Debug:
-          break;
-        case Level::Info:
-          break;
-        case Level::Warning:
-          output = stderr;
-          fprintf(output, "\e[38;5;255m\e[48;5;208m");
-          break;
-        case Level::Error:
-          output = stderr;
-          fprintf(output, "\e[38;5;255m\e[48;5;196m");
-          break;
-        default:
-          break;
-        }
+        const char* colorPrefix;
+        FILE* output = GetConsoleStream(level, colorPrefix);
 
+        fprintf(output, "%s", colorPrefix);
         fprintf(output, "%s", header);
         fprintf(output, "\e[0m ");
 
@@ -156,6 +172,89 @@ void OutputConsole::Write(Level level, const char* /*subsystem*/, const char* he
 }
 
 
+void OutputConsole::WriteBatch(const OutputMessage* messages, size_t count)
+{
+    #if defined(_WIN32)
+        if (UseStdio)
+        {
+            OutputPlugin::WriteBatch(messages, count);
+            return;
+        }
+
+        HANDLE hConsole = ::GetStdHandle(STD_OUTPUT_HANDLE);
+
+        // Save current console attributes
+        CONSOLE_SCREEN_BUFFER_INFO bufInfo{};
+        BOOL oldAttrValid = ::GetConsoleScreenBufferInfo(hConsole, &bufInfo);
+
+        for (size_t i = 0; i < count;)
+        {
+            const Level level = messages[i].MessageLogLevel;
+            const WORD attr = GetConsoleAttributes(level);
+            DWORD dwCount;
+
+            if ((attr & FOREGROUND_INTENSITY) != 0)
+            {
+                // Headers are drawn without the intensity of their message, so each message
+                // takes two writes.
+                for (; i < count && messages[i].MessageLogLevel == level; ++i)
+                {
+                    ::SetConsoleTextAttribute(hConsole, attr & ~FOREGROUND_INTENSITY);
+                    WriteConsoleA(hConsole, messages[i].Header, (DWORD)strlen(messages[i].Header), &dwCount, nullptr);
+
+                    BatchText = messages[i].Utf8Msg;
+                    BatchText += '\n';
+                    ::SetConsoleTextAttribute(hConsole, attr);
+                    WriteConsoleA(hConsole, BatchText.data(), (DWORD)BatchText.size(), &dwCount, nullptr);
+                }
+            }
+            else
+            {
+                // The whole run is one color, so write it at once.
+                BatchText.clear();
+                for (; i < count && messages[i].MessageLogLevel == level; ++i)
+                {
+                    BatchText += messages[i].Header;
+                    BatchText += messages[i].Utf8Msg;
+                    BatchText += '\n';
+                }
+
+                ::SetConsoleTextAttribute(hConsole, attr);
+                WriteConsoleA(hConsole, BatchText.data(), (DWORD)BatchText.size(), &dwCount, nullptr);
+            }
+        }
+
+        // Restore original attributes, if saved
+        if ( TRUE == oldAttrValid )
+        {
+            ::SetConsoleTextAttribute(hConsole, bufInfo.wAttributes);
+        }
+    #else
+        // Color changes are inline escape sequences, so each run of messages to the same stream
+        // is one write.
+        for (size_t i = 0; i < count;)
+        {
+            const char* colorPrefix;
+            FILE* output = GetConsoleStream(messages[i].MessageLogLevel, colorPrefix);
+
+            BatchText.clear();
+            for (; i < count; ++i)
+            {
+                if (GetConsoleStream(messages[i].MessageLogLevel, colorPrefix) != output)
+                    break;
+
+                BatchText += colorPrefix;
+                BatchText += messages[i].Header;
+                BatchText += "\e[0m ";
+                BatchText += messages[i].Utf8Msg;
+                BatchText += '\n';
+            }
+
+            fwrite(BatchText.data(), 1, BatchText.size(), output);
+        }
+    #endif
+}
+
 //-----------------------------------------------------------------------------
 // System Application Event Log
 
@@ -310,6 +409,401 @@ void OutputDbgView::Write(Level level, const char* subsystem, const char* header
 }
 
 
+
+//-----------------------------------------------------------------------------
+// Memory-Mapped Log File
+
+static_assert(sizeof(OutputMappedFile::FileHeader) == 64, "FileHeader is an on-disk format");
+
+#if defined(_WIN32)
+static std::wstring Utf8ToWide(const std::string& utf8)
+{
+    int length = ::MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, nullptr, 0);
+    if (length <= 0)
+        return std::wstring();
+
+    std::wstring wide((size_t)length, L'\0');
+    ::MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), -1, &wide[0], length);
+    wide.resize((size_t)length - 1);
+    return wide;
+}
+#endif
+
+static void RenameFile(const std::string& from, const std::string& to)
+{
+    #if defined(_WIN32)
+        ::MoveFileExW(Utf8ToWide(from).c_str(), Utf8ToWide(to).c_str(), MOVEFILE_REPLACE_EXISTING);
+    #else
+        ::rename(from.c_str(), to.c_str());
+    #endif
+}
+
+static void DeleteFileUtf8(const std::string& path)
+{
+    #if defined(_WIN32)
+        ::DeleteFileW(Utf8ToWide(path).c_str());
+    #else
+        ::unlink(path.c_str());
+    #endif
+}
+
+static bool FileExists(const std::string& path)
+{
+    #if defined(_WIN32)
+        return ::GetFileAttributesW(Utf8ToWide(path).c_str()) != INVALID_FILE_ATTRIBUTES;
+    #else
+        return ::access(path.c_str(), F_OK) == 0;
+    #endif
+}
+
+OutputMappedFile::OutputMappedFile(const char* utf8Path, size_t fileSize, int maxFileCount) :
+    Path(utf8Path ? utf8Path : ""),
+    FileSize(fileSize),
+    MaxFileCount(maxFileCount < 1 ? 1 : maxFileCount),
+    #if defined(_WIN32)
+        FileHandle(INVALID_HANDLE_VALUE),
+        MappingHandle(nullptr),
+    #else
+        FileDescriptor(-1),
+    #endif
+    Header(nullptr),
+    MappedData(nullptr)
+{
+    if (FileSize < sizeof(FileHeader) + 1)
+        FileSize = sizeof(FileHeader) + 1;
+
+    if (Path.empty())
+        return;
+
+    // Keep the log from the previous run as path.1
+    if (FileExists(Path))
+        Rotate();
+    else
+        Open();
+}
+
+OutputMappedFile::~OutputMappedFile()
+{
+    Close();
+}
+
+const char* OutputMappedFile::GetUniquePluginName()
+{
+    return "DefaultOutputMappedFile";
+}
+
+bool OutputMappedFile::Open()
+{
+    #if defined(_WIN32)
+        FileHandle = ::CreateFileW(Utf8ToWide(Path).c_str(), GENERIC_READ | GENERIC_WRITE,
+                                   FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, CREATE_ALWAYS,
+                                   FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (FileHandle == INVALID_HANDLE_VALUE)
+            return false;
+
+        // Mapping a size larger than the file extends (and allocates) the file.
+        const uint64_t size64 = (uint64_t)FileSize;
+        MappingHandle = ::CreateFileMappingW(FileHandle, nullptr, PAGE_READWRITE,
+                                             (DWORD)(size64 >> 32), (DWORD)size64, nullptr);
+        if (MappingHandle)
+            MappedData = (char*)::MapViewOfFile(MappingHandle, FILE_MAP_WRITE, 0, 0, FileSize);
+    #else
+        FileDescriptor = ::open(Path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (FileDescriptor < 0)
+            return false;
+
+        // The file must really be allocated: touching a page of a sparse file mapping raises
+        // SIGBUS if the disk turns out to be full.
+        #if defined(__linux__)
+            const bool allocated = (::posix_fallocate(FileDescriptor, 0, (off_t)FileSize) == 0);
+        #else
+            const bool allocated = (::ftruncate(FileDescriptor, (off_t)FileSize) == 0);
+        #endif
+
+        if (allocated)
+        {
+            void* view = ::mmap(nullptr, FileSize, PROT_READ | PROT_WRITE, MAP_SHARED, FileDescriptor, 0);
+            if (view != MAP_FAILED)
+                MappedData = (char*)view;
+        }
+    #endif
+
+    if (!MappedData)
+    {
+        Close();
+        return false;
+    }
+
+    Header = (FileHeader*)MappedData;
+    memcpy(Header->Magic, "OVRMLOG1", sizeof(Header->Magic));
+    Header->HeaderSize = (uint32_t)sizeof(FileHeader);
+    Header->Reserved = 0;
+    Header->FileSize = (uint64_t)FileSize;
+    Header->WriteOffset = sizeof(FileHeader);
+    return true;
+}
+
+void OutputMappedFile::Close()
+{
+    const uint64_t usedSize = Header ? Header->WriteOffset : 0;
+
+    #if defined(_WIN32)
+        if (MappedData)
+            ::UnmapViewOfFile(MappedData);
+        if (MappingHandle)
+            ::CloseHandle(MappingHandle);
+        if (FileHandle != INVALID_HANDLE_VALUE)
+        {
+            if (usedSize)
+            {
+                LARGE_INTEGER end;
+                end.QuadPart = (LONGLONG)usedSize;
+                if (::SetFilePointerEx(FileHandle, end, nullptr, FILE_BEGIN))
+                    ::SetEndOfFile(FileHandle);
+            }
+            ::CloseHandle(FileHandle);
+        }
+        MappingHandle = nullptr;
+        FileHandle = INVALID_HANDLE_VALUE;
+    #else
+        if (MappedData)
+            ::munmap(MappedData, FileSize);
+        if (FileDescriptor >= 0)
+        {
+            if (usedSize)
+            {
+                // On failure the file keeps its zero filled tail; the header still gives its
+                // used size.
+                int result = ::ftruncate(FileDescriptor, (off_t)usedSize);
+                (void)result;
+            }
+            ::close(FileDescriptor);
+        }
+        FileDescriptor = -1;
+    #endif
+
+    Header = nullptr;
+    MappedData = nullptr;
+}
+
+bool OutputMappedFile::Rotate()
+{
+    Close();
+
+    DeleteFileUtf8(Path + "." + std::to_string(MaxFileCount - 1));
+    for (int i = MaxFileCount - 2; i >= 1; --i)
+        RenameFile(Path + "." + std::to_string(i), Path + "." + std::to_string(i + 1));
+    if (MaxFileCount > 1)
+        RenameFile(Path, Path + ".1");
+
+    return Open();
+}
+
+void OutputMappedFile::Write(Level level, const char* subsystem, const char* header, const char* utf8msg)
+{
+    (void)level; // unused
+    (void)subsystem; // unused
+
+    if (!Header)
+        return;
+
+    const size_t capacity = FileSize - sizeof(FileHeader);
+    size_t headerLength = strlen(header);
+    size_t msgLength = strlen(utf8msg);
+
+    // Messages longer than a whole file are cut to fit, keeping the line break.
+    if (headerLength + msgLength + 1 > capacity)
+    {
+        if (headerLength + 1 > capacity)
+            headerLength = capacity - 1;
+        msgLength = capacity - 1 - headerLength;
+    }
+
+    const size_t lineLength = headerLength + msgLength + 1;
+    if (Header->WriteOffset + lineLength > FileSize)
+    {
+        if (!Rotate())
+            return; // Logging to this file stops if a new one cannot be created.
+    }
+
+    // WriteOffset is only moved past the whole line once it has been written, so a crash part
+    // way through leaves the header pointing at the end of the previous line.
+    const size_t offset = (size_t)Header->WriteOffset;
+    memcpy(MappedData + offset, header, headerLength);
+    memcpy(MappedData + offset + headerLength, utf8msg, msgLength);
+    MappedData[offset + headerLength + msgLength] = '\n';
+    Header->WriteOffset = offset + lineLength;
+}
+
+
+
+//-----------------------------------------------------------------------------
+// Structured Event JSON File
+
+static void AppendJsonString(std::string& output, const char* str)
+{
+    output += '"';
+    for (const char* p = str; *p; ++p)
+    {
+        const unsigned char c = (unsigned char)*p;
+        switch (c)
+        {
+        case '"':  output += "\\\""; break;
+        case '\\': output += "\\\\"; break;
+        case '\n': output += "\\n"; break;
+        case '\r': output += "\\r"; break;
+        case '\t': output += "\\t"; break;
+        default:
+            if (c < 0x20)
+            {
+                char escape[8];
+                snprintf(escape, sizeof(escape), "\\u%04x", c);
+                output += escape;
+            }
+            else
+            {
+                output += (char)c; // UTF8 sequences are copied as they are.
+            }
+            break;
+        }
+    }
+    output += '"';
+}
+
+OutputEventJsonFile::OutputEventJsonFile(const char* utf8Path) :
+    File(nullptr),
+    Lines()
+{
+    if (!utf8Path || !utf8Path[0])
+        return;
+
+    #if defined(_WIN32)
+        File = ::_wfsopen(Utf8ToWide(utf8Path).c_str(), L"ab", _SH_DENYWR);
+    #else
+        File = fopen(utf8Path, "ab");
+    #endif
+}
+
+OutputEventJsonFile::~OutputEventJsonFile()
+{
+    if (File)
+        fclose(File);
+}
+
+const char* OutputEventJsonFile::GetUniquePluginName()
+{
+    return "DefaultOutputEventJsonFile";
+}
+
+void OutputEventJsonFile::Write(Level level, const char* subsystem, const char* header, const char* utf8msg)
+{
+    // Events only arrive through WriteBatch, as Write has no access to their fields.
+    (void)level;
+    (void)subsystem;
+    (void)header;
+    (void)utf8msg;
+}
+
+void OutputEventJsonFile::WriteBatch(const OutputMessage* messages, size_t count)
+{
+    if (!File)
+        return;
+
+    Lines.clear();
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (messages[i].EventData)
+            AppendEvent(messages[i]);
+    }
+
+    if (!Lines.empty())
+    {
+        fwrite(Lines.data(), 1, Lines.size(), File);
+        fflush(File);
+    }
+}
+
+void OutputEventJsonFile::AppendEvent(const OutputMessage& message)
+{
+    char buffer[64];
+
+    #if defined(_WIN32)
+        const SYSTEMTIME& time = message.Time;
+        snprintf(buffer, sizeof(buffer), "{\"time\":\"%04u-%02u-%02uT%02u:%02u:%02u.%03u\"",
+            time.wYear, time.wMonth, time.wDay, time.wHour, time.wMinute, time.wSecond, time.wMilliseconds);
+    #else
+        snprintf(buffer, sizeof(buffer), "{\"time\":%lld", (long long)message.Time);
+    #endif
+    Lines += buffer;
+
+    const char* levelName = "Disabled";
+    switch (message.MessageLogLevel)
+    {
+    case Level::Trace:   levelName = "Trace";   break;
+    case Level::Debug:   levelName = "Debug";   break;
+    case Level::Info:    levelName = "Info";    break;
+    case Level::Warning: levelName = "Warning"; break;
+    case Level::Error:   levelName = "Error";   break;
+    default:             break;
+    }
+    static_assert(Level::Count == static_cast<Level>(6), "Needs updating");
+
+    Lines += ",\"level\":\"";
+    Lines += levelName;
+    Lines += "\",\"subsystem\":";
+    AppendJsonString(Lines, message.SubsystemName);
+
+    LogEventReader reader(message.EventData, message.EventDataSize);
+    if (reader.GetPrefix()[0])
+    {
+        Lines += ",\"prefix\":";
+        AppendJsonString(Lines, reader.GetPrefix());
+    }
+    Lines += ",\"event\":";
+    AppendJsonString(Lines, reader.GetName());
+
+    const char* name;
+    DeferredArg value;
+    while (reader.Next(name, value))
+    {
+        Lines += ',';
+        AppendJsonString(Lines, name);
+        Lines += ':';
+
+        switch (value.Type)
+        {
+        case DeferredArgType::Int32:
+        case DeferredArgType::Int64:
+            snprintf(buffer, sizeof(buffer), "%lld", (long long)value.Integer);
+            Lines += buffer;
+            break;
+        case DeferredArgType::Double:
+            if (std::isfinite(value.Double))
+            {
+                // Use the shortest of these which reads back as the same value.
+                snprintf(buffer, sizeof(buffer), "%.15g", value.Double);
+                if (strtod(buffer, nullptr) != value.Double)
+                    snprintf(buffer, sizeof(buffer), "%.17g", value.Double);
+                Lines += buffer;
+            }
+            else
+            {
+                Lines += "null"; // JSON has no NaN or infinity.
+            }
+            break;
+        case DeferredArgType::Pointer:
+            snprintf(buffer, sizeof(buffer), "\"0x%llx\"", (unsigned long long)value.Integer);
+            Lines += buffer;
+            break;
+        case DeferredArgType::String:
+            AppendJsonString(Lines, value.String);
+            break;
+        }
+    }
+
+    Lines += "}\n";
+}
+
 } // namespace ovrlog
 
 #ifdef OVR_STRINGIZE
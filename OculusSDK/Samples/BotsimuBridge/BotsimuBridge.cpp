@@ -0,0 +1,644 @@
+/************************************************************************************
+Filename    :   BotsimuBridge.cpp
+Content     :   Native UDP to vJoy / keyboard bridge for the DetectVR treadmill
+Created     :   October 14, 2026
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*************************************************************************************/
+/// A native replacement for Botsimu's vjoy.py and directkeys.py.  DetectVR sends a datagram
+/// to localhost:9988 as the headset crosses its walk threshold, and the bridge turns it into
+/// the virtual joystick's Y axis, or a held key, for whatever game is running.
+///
+/// Datagrams are either the single byte the scripts read, nonzero to walk, or a 4 byte
+/// little-endian float, walking while it's at or above the threshold.  Floats stop walking
+/// once below threshold - hysteresis, so a value hovering at the threshold doesn't chatter.
+///
+/// The receive thread keeps a batch of overlapped receives posted on an I/O completion port
+/// and takes every completed one in a single GetQueuedCompletionStatusEx call, which is
+/// Windows' counterpart of recvmmsg.  Each is timestamped and handed over an SPSCRing to the
+/// output thread, so a slow driver call never leaves the socket without a receive posted.
+/// The output thread applies the latest state once per batch, holding the vJoy device for
+/// its whole run rather than acquiring it per datagram as vjoy.py did, and records the time
+/// from receive to the driver call returning in a histogram.
+///   -port <port>          The UDP port, 9988 by default.
+///   -keys                 Holds a key down while walking, as directkeys.py, instead of vJoy.
+///   -key <scan code>      The key's scan code, 0x11 (W) by default.
+///   -device <id>          The vJoy device, 1 by default.
+///   -dll <path>           vJoyInterface.dll, by default the one beside the executable.
+///   -walkaxis <value>     The Y axis while walking, 8195 by default; stopped is centered.
+///   -threshold <value>    0.5 by default, which any nonzero byte reaches.
+///   -hysteresis <value>   0 by default.
+///   -report <seconds>     Prints the latency histogram this often, 10 by default; 0 for only at exit.
+
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+
+#include "Kernel/OVR_System.h"
+#include "Kernel/OVR_Timer.h"
+#include "Kernel/OVR_Threads.h"
+#include "Kernel/OVR_LocklessRing.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#pragma comment(lib, "ws2_32.lib")
+
+using namespace OVR;
+
+static const int      ReceiveCount  = 16;     // Receives kept posted, and the most taken per batch
+static const size_t   RingCapacity  = 1024;
+static const LONG     AxisCenter    = 16393;  // As vjoy.py's generateJoystickPosition defaults
+
+struct Settings
+{
+    unsigned short  Port;
+    bool            Keys;
+    WORD            ScanCode;
+    UINT            Device;
+    const char*     DllPath;
+    LONG            WalkAxis;
+    float           Threshold;
+    float           Hysteresis;
+    double          ReportSeconds;
+};
+
+//-------------------------------------------------------------------------------------
+// Time from receive to output, in power of two buckets of microseconds.
+class LatencyHistogram
+{
+public:
+    static const int BucketCount = 20;  // The last holds everything from 2^18 us, about 0.25s
+
+    LatencyHistogram() { Reset(); }
+
+    void Reset()
+    {
+        memset(Buckets, 0, sizeof(Buckets));
+        Count = 0;
+        TotalNanos = 0;
+        MaxNanos = 0;
+    }
+
+    void Add(uint64_t nanos)
+    {
+        uint64_t micros = nanos / 1000;
+        int bucket = 0;
+        while (micros > 1 && bucket < BucketCount - 1)
+        {
+            micros >>= 1;
+            ++bucket;
+        }
+        ++Buckets[bucket];
+        ++Count;
+        TotalNanos += nanos;
+        if (nanos > MaxNanos)
+            MaxNanos = nanos;
+    }
+
+    void Print(const char* title) const
+    {
+        if (!Count)
+        {
+            printf("%s: no datagrams\n", title);
+            return;
+        }
+
+        printf("%s: %llu datagrams, mean %.1f us, p50 < %u us, p99 < %u us, max %.1f us\n", title,
+               (unsigned long long)Count, TotalNanos / (Count * 1000.0), PercentileMicros(0.5),
+               PercentileMicros(0.99), MaxNanos / 1000.0);
+
+        for (int i = 0; i < BucketCount; ++i)
+        {
+            if (Buckets[i])
+                printf("    < %7u us  %10llu\n", BucketLimitMicros(i), (unsigned long long)Buckets[i]);
+        }
+        fflush(stdout);
+    }
+
+private:
+    static unsigned BucketLimitMicros(int bucket)
+    {
+        return 2u << bucket;
+    }
+
+    // The upper bound of the bucket holding the given fraction of the datagrams
+    unsigned PercentileMicros(double fraction) const
+    {
+        const uint64_t target = (uint64_t)(fraction * Count);
+        uint64_t sum = 0;
+        for (int i = 0; i < BucketCount; ++i)
+        {
+            sum += Buckets[i];
+            if (sum > target)
+                return BucketLimitMicros(i);
+        }
+        return BucketLimitMicros(BucketCount - 1);
+    }
+
+    uint64_t    Buckets[BucketCount];
+    uint64_t    Count;
+    uint64_t    TotalNanos;
+    uint64_t    MaxNanos;
+};
+
+//-------------------------------------------------------------------------------------
+// Where the walk state goes.
+class OutputSink
+{
+public:
+    virtual ~OutputSink() {}
+    virtual bool SetWalking(bool walking) = 0;
+};
+
+// vJoyInterface.dll, loaded at run time as the scripts did, so no vJoy SDK is needed to build.
+class VJoyOutput : public OutputSink
+{
+public:
+    VJoyOutput() : Module(NULL), Device(0), Acquired(false), WalkAxis(0),
+                   VJoyEnabled(NULL), AcquireVJD(NULL), RelinquishVJD(NULL), UpdateVJD(NULL)
+    {
+        memset(&Position, 0, sizeof(Position));
+    }
+
+    ~VJoyOutput() { Close(); }
+
+    bool Open(const char* dllPath, UINT device, LONG walkAxis)
+    {
+        Module = LoadLibraryA(dllPath);
+        if (!Module)
+        {
+            printf("ERROR: Failed to load '%s'.\n", dllPath);
+            return false;
+        }
+
+        VJoyEnabled   = (VJoyEnabledFunc)GetProcAddress(Module, "vJoyEnabled");
+        AcquireVJD    = (AcquireVJDFunc)GetProcAddress(Module, "AcquireVJD");
+        RelinquishVJD = (RelinquishVJDFunc)GetProcAddress(Module, "RelinquishVJD");
+        UpdateVJD     = (UpdateVJDFunc)GetProcAddress(Module, "UpdateVJD");
+        if (!VJoyEnabled || !AcquireVJD || !RelinquishVJD || !UpdateVJD)
+        {
+            printf("ERROR: '%s' is not vJoyInterface.dll.\n", dllPath);
+            return false;
+        }
+
+        if (!VJoyEnabled())
+        {
+            printf("ERROR: vJoy is not installed or enabled; run vJoySetup.exe from FirstTimeSetup.\n");
+            return false;
+        }
+
+        Device = device;
+        if (!AcquireVJD(Device))
+        {
+            printf("ERROR: Failed to acquire vJoy device %u; is another feeder using it?\n", Device);
+            return false;
+        }
+        Acquired = true;
+
+        WalkAxis = walkAxis;
+        Position.bDevice = (BYTE)Device;
+        Position.wAxisX = AxisCenter;
+        Position.wAxisY = AxisCenter;
+        Position.wAxisXRot = AxisCenter;
+        Position.wAxisYRot = AxisCenter;
+        return UpdateVJD(Device, &Position) != FALSE;
+    }
+
+    void Close()
+    {
+        if (Acquired)
+        {
+            SetWalking(false);
+            RelinquishVJD(Device);
+            Acquired = false;
+        }
+        if (Module)
+        {
+            FreeLibrary(Module);
+            Module = NULL;
+        }
+    }
+
+    bool SetWalking(bool walking) override
+    {
+        Position.wAxisY = walking ? WalkAxis : AxisCenter;
+        return UpdateVJD(Device, &Position) != FALSE;
+    }
+
+private:
+    // JOYSTICK_POSITION_V2 from vJoy's public.h, which UpdateVJD takes; vjoy.py packed only
+    // the first version's fields, which this begins with.
+    struct JoystickPosition
+    {
+        BYTE    bDevice;
+        LONG    wThrottle, wRudder, wAileron;
+        LONG    wAxisX, wAxisY, wAxisZ;
+        LONG    wAxisXRot, wAxisYRot, wAxisZRot;
+        LONG    wSlider, wDial, wWheel;
+        LONG    wAxisVX, wAxisVY, wAxisVZ;
+        LONG    wAxisVBRX, wAxisVBRY, wAxisVBRZ;
+        LONG    lButtons;
+        DWORD   bHats, bHatsEx1, bHatsEx2, bHatsEx3;
+        LONG    lButtonsEx1, lButtonsEx2, lButtonsEx3;
+    };
+
+    typedef BOOL (__cdecl *VJoyEnabledFunc)();
+    typedef BOOL (__cdecl *AcquireVJDFunc)(UINT device);
+    typedef VOID (__cdecl *RelinquishVJDFunc)(UINT device);
+    typedef BOOL (__cdecl *UpdateVJDFunc)(UINT device, PVOID data);
+
+    HMODULE             Module;
+    UINT                Device;
+    bool                Acquired;
+    LONG                WalkAxis;
+    JoystickPosition    Position;
+    VJoyEnabledFunc     VJoyEnabled;
+    AcquireVJDFunc      AcquireVJD;
+    RelinquishVJDFunc   RelinquishVJD;
+    UpdateVJDFunc       UpdateVJD;
+};
+
+// Holds a key down while walking, with DirectInput scan codes as directkeys.py.
+class KeyOutput : public OutputSink
+{
+public:
+    KeyOutput(WORD scanCode) : ScanCode(scanCode), Down(false) {}
+    ~KeyOutput() { SetWalking(false); }
+
+    bool SetWalking(bool walking) override
+    {
+        if (walking == Down)
+            return true;
+
+        INPUT input = {};
+        input.type = INPUT_KEYBOARD;
+        input.ki.wScan = ScanCode;
+        input.ki.dwFlags = KEYEVENTF_SCANCODE | (walking ? 0 : KEYEVENTF_KEYUP);
+        Down = walking;
+        return SendInput(1, &input, sizeof(input)) == 1;
+    }
+
+private:
+    WORD    ScanCode;
+    bool    Down;
+};
+
+//-------------------------------------------------------------------------------------
+class Bridge
+{
+public:
+    Bridge(const Settings& settings, OutputSink* output) :
+        Config(settings), Output(output), Socket(INVALID_SOCKET), Port(NULL),
+        Samples(RingCapacity), Quit(false), DroppedCount(0), MalformedCount(0), Walking(false)
+    {
+        memset(Slots, 0, sizeof(Slots));
+    }
+
+    ~Bridge() { Stop(); }
+
+    bool Start()
+    {
+        Socket = WSASocketW(AF_INET, SOCK_DGRAM, IPPROTO_UDP, NULL, 0, WSA_FLAG_OVERLAPPED);
+        if (Socket == INVALID_SOCKET)
+        {
+            printf("ERROR: Failed to create the socket (%d).\n", WSAGetLastError());
+            return false;
+        }
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(Config.Port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(Socket, (const sockaddr*)&address, sizeof(address)) == SOCKET_ERROR)
+        {
+            printf("ERROR: Failed to bind localhost:%u (%d); is vjoy.py or directkeys.py still running?\n",
+                   (unsigned)Config.Port, WSAGetLastError());
+            return false;
+        }
+
+        Port = CreateIoCompletionPort((HANDLE)Socket, NULL, 0, 1);
+        if (!Port)
+        {
+            printf("ERROR: Failed to create the completion port (%u).\n", (unsigned)GetLastError());
+            return false;
+        }
+
+        for (int i = 0; i < ReceiveCount; ++i)
+        {
+            if (!PostReceive(Slots[i]))
+                return false;
+        }
+
+        ReceiveThread.reset(new std::thread([this] { ReceiveThreadProc(); }));
+        OutputThread.reset(new std::thread([this] { OutputThreadProc(); }));
+        return true;
+    }
+
+    void Stop()
+    {
+        Quit = true;
+        OutputReady.SetEvent();
+        if (ReceiveThread)
+        {
+            ReceiveThread->join();
+            ReceiveThread.reset();
+        }
+        if (OutputThread)
+        {
+            OutputThread->join();
+            OutputThread.reset();
+        }
+
+        // Cancels the receives still posted; their completions go to the port, closed after
+        if (Socket != INVALID_SOCKET)
+        {
+            closesocket(Socket);
+            Socket = INVALID_SOCKET;
+        }
+        if (Port)
+        {
+            CloseHandle(Port);
+            Port = NULL;
+        }
+    }
+
+    // Only once Stop has returned
+    void PrintSummary() const
+    {
+        TotalLatency.Print("Receive to output latency, whole run");
+        if (DroppedCount || MalformedCount)
+            printf("%u datagrams dropped with the ring full, %u of an unknown size\n",
+                   (unsigned)DroppedCount, (unsigned)MalformedCount);
+    }
+
+private:
+    struct ReceiveSlot
+    {
+        OVERLAPPED  Overlapped;     // First, so a completion's OVERLAPPED is its slot
+        WSABUF      Buffer;
+        DWORD       Flags;
+        char        Data[16];
+    };
+
+    struct Sample
+    {
+        float       Value;
+        uint64_t    ReceivedNanos;
+    };
+
+    bool PostReceive(ReceiveSlot& slot)
+    {
+        memset(&slot.Overlapped, 0, sizeof(slot.Overlapped));
+        slot.Buffer.buf = slot.Data;
+        slot.Buffer.len = sizeof(slot.Data);
+        slot.Flags = 0;
+        if (WSARecvFrom(Socket, &slot.Buffer, 1, NULL, &slot.Flags, NULL, NULL, &slot.Overlapped, NULL) == 0)
+            return true;    // Completed at once; the completion is still queued to the port
+
+        const int error = WSAGetLastError();
+        if (error == WSA_IO_PENDING)
+            return true;
+
+        printf("ERROR: Failed to post a receive (%d).\n", error);
+        return false;
+    }
+
+    bool ReadSample(const ReceiveSlot& slot, DWORD size, Sample& sample)
+    {
+        if (size == 1)
+        {
+            sample.Value = slot.Data[0] ? 1.0f : 0.0f;
+            return true;
+        }
+        if (size == sizeof(float))
+        {
+            memcpy(&sample.Value, slot.Data, sizeof(float));
+            return true;
+        }
+        return false;
+    }
+
+    void ReceiveThreadProc()
+    {
+        Thread::SetCurrentThreadName("BotsimuBridge Receive");
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+
+        OVERLAPPED_ENTRY entries[ReceiveCount];
+        while (!Quit)
+        {
+            ULONG count = 0;
+            if (!GetQueuedCompletionStatusEx(Port, entries, ReceiveCount, &count, 100, FALSE))
+                continue;   // Timed out, to check Quit
+
+            const uint64_t now = Timer::GetTicksNanos();
+            for (ULONG i = 0; i < count; ++i)
+            {
+                ReceiveSlot& slot = *(ReceiveSlot*)entries[i].lpOverlapped;
+
+                // dwNumberOfBytesTransferred is the datagram's size.  A failed receive, such as one
+                // reporting an ICMP port unreachable or a truncated datagram, has a nonzero
+                // NTSTATUS in Internal and is just reposted.
+                Sample sample;
+                sample.ReceivedNanos = now;
+                if (slot.Overlapped.Internal == 0)
+                {
+                    if (!ReadSample(slot, entries[i].dwNumberOfBytesTransferred, sample))
+                        ++MalformedCount;
+                    else if (!Samples.TryPush(sample))
+                        ++DroppedCount;
+                }
+
+                if (!Quit)
+                    PostReceive(slot);
+            }
+
+            OutputReady.SetEvent();
+        }
+    }
+
+    void OutputThreadProc()
+    {
+        Thread::SetCurrentThreadName("BotsimuBridge Output");
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL);
+
+        double nextReport = Timer::GetSeconds() + Config.ReportSeconds;
+        uint64_t batchNanos[RingCapacity];
+
+        while (!Quit)
+        {
+            OutputReady.Wait(250);
+            OutputReady.ResetEvent();   // Before draining, so a push after this sets it again
+
+            // Only the last state counts, as it's where the treadmill is now
+            size_t batchCount = 0;
+            bool walking = Walking;
+            Sample sample;
+            while (batchCount < RingCapacity && Samples.TryPop(sample))
+            {
+                if (sample.Value >= Config.Threshold)
+                    walking = true;
+                else if (sample.Value < Config.Threshold - Config.Hysteresis)
+                    walking = false;
+                batchNanos[batchCount++] = sample.ReceivedNanos;
+            }
+
+            if (batchCount)
+            {
+                if (walking != Walking && !Output->SetWalking(walking))
+                    printf("ERROR: Failed to %s.\n", walking ? "start walking" : "stop walking");
+                Walking = walking;
+
+                const uint64_t now = Timer::GetTicksNanos();
+                for (size_t i = 0; i < batchCount; ++i)
+                {
+                    ReportLatency.Add(now - batchNanos[i]);
+                    TotalLatency.Add(now - batchNanos[i]);
+                }
+            }
+
+            if (Config.ReportSeconds > 0 && Timer::GetSeconds() >= nextReport)
+            {
+                ReportLatency.Print("Receive to output latency");
+                ReportLatency.Reset();
+                nextReport += Config.ReportSeconds;
+            }
+        }
+    }
+
+    const Settings                  Config;
+    OutputSink*                     Output;
+    SOCKET                          Socket;
+    HANDLE                          Port;
+    ReceiveSlot                     Slots[ReceiveCount];
+    SPSCRing<Sample>                Samples;
+    Event                           OutputReady;
+    std::unique_ptr<std::thread>    ReceiveThread;
+    std::unique_ptr<std::thread>    OutputThread;
+    std::atomic<bool>               Quit;
+    std::atomic<uint32_t>           DroppedCount;
+    std::atomic<uint32_t>           MalformedCount;
+
+    // Output thread only
+    bool                            Walking;
+    LatencyHistogram                ReportLatency;
+    LatencyHistogram                TotalLatency;
+};
+
+//-------------------------------------------------------------------------------------
+static Event QuitRequested;
+
+static BOOL WINAPI ConsoleCtrlHandler(DWORD)
+{
+    QuitRequested.SetEvent();
+    return TRUE;
+}
+
+// vJoyInterface.dll from the directory the executable is in, as vjoy.py loaded it from its own
+static void GetDefaultDllPath(char* path, DWORD capacity)
+{
+    const DWORD length = GetModuleFileNameA(NULL, path, capacity);
+    char* slash = (length && length < capacity) ? strrchr(path, '\\') : NULL;
+    if (slash && (size_t)(slash + 1 - path) + sizeof("vJoyInterface.dll") <= capacity)
+        strcpy(slash + 1, "vJoyInterface.dll");
+    else
+        strcpy(path, "vJoyInterface.dll");
+}
+
+int main(int argc, char** argv)
+{
+    char defaultDllPath[MAX_PATH];
+    GetDefaultDllPath(defaultDllPath, MAX_PATH);
+
+    Settings settings = { 9988, false, 0x11, 1, defaultDllPath, 8195, 0.5f, 0.0f, 10.0 };
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = (i + 1) < argc;
+
+        if (!strcmp(argv[i], "-port") && hasValue)
+            settings.Port = (unsigned short)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-keys"))
+            settings.Keys = true;
+        else if (!strcmp(argv[i], "-key") && hasValue)
+            settings.ScanCode = (WORD)strtoul(argv[++i], NULL, 0);
+        else if (!strcmp(argv[i], "-device") && hasValue)
+            settings.Device = (UINT)atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-dll") && hasValue)
+            settings.DllPath = argv[++i];
+        else if (!strcmp(argv[i], "-walkaxis") && hasValue)
+            settings.WalkAxis = atol(argv[++i]);
+        else if (!strcmp(argv[i], "-threshold") && hasValue)
+            settings.Threshold = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "-hysteresis") && hasValue)
+            settings.Hysteresis = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "-report") && hasValue)
+            settings.ReportSeconds = atof(argv[++i]);
+    }
+
+    printf("Botsimu Bridge\n"
+           "--------------\n");
+
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        printf("ERROR: Failed to start Winsock.\n");
+        return 1;
+    }
+
+    System::Init();
+    int exitCode = 1;
+
+    {
+        std::unique_ptr<OutputSink> output;
+        if (settings.Keys)
+        {
+            output.reset(new KeyOutput(settings.ScanCode));
+        }
+        else
+        {
+            VJoyOutput* vjoy = new VJoyOutput;
+            output.reset(vjoy);
+            if (!vjoy->Open(settings.DllPath, settings.Device, settings.WalkAxis))
+                output.reset();
+        }
+
+        if (output)
+        {
+            Bridge bridge(settings, output.get());
+            if (bridge.Start())
+            {
+                printf("Listening on localhost:%u, driving %s. Ctrl+C to quit.\n", (unsigned)settings.Port,
+                       settings.Keys ? "the keyboard" : "vJoy");
+                fflush(stdout);
+
+                SetConsoleCtrlHandler(ConsoleCtrlHandler, TRUE);
+                QuitRequested.Wait();
+
+                bridge.Stop();
+                bridge.PrintSummary();
+                exitCode = 0;
+            }
+        }
+    }
+
+    System::Destroy();
+    WSACleanup();
+    return exitCode;
+}
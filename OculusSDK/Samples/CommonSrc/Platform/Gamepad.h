@@ -85,6 +85,20 @@ struct GamepadState
     bool operator!=(const GamepadState& b) const
     {
         return !(*this == b);
+    }
+    // The analog inputs are interpolated; the buttons are b's once f reaches 1.
+    GamepadState Lerp(const GamepadState& b, double f) const
+    {
+        GamepadState s;
+        const float t = (float)f;
+        s.Buttons = (f < 1.0) ? Buttons : b.Buttons;
+        s.LX = LX + (b.LX - LX) * t;
+        s.LY = LY + (b.LY - LY) * t;
+        s.RX = RX + (b.RX - RX) * t;
+        s.RY = RY + (b.RY - RY) * t;
+        s.LT = LT + (b.LT - LT) * t;
+        s.RT = RT + (b.RT - RT) * t;
+        return s;
     }
 	void Debug() const
 	{
@@ -104,8 +118,66 @@ public:
     // Get the number of connected gamepads.
     virtual uint32_t GetGamepadCount() = 0;
 
-    // Get the state of the gamepad with a given index.
+    // Get the state of the first gamepad. Returns true if it changed since the last call.
     virtual bool    GetGamepadState(GamepadState* pState) = 0;
+
+    // Get the state of the gamepad with a given index. Returns true if it changed since the last call.
+    virtual bool    GetGamepadState(uint32_t index, GamepadState* pState) = 0;
+
+    // Each gamepad's state is also sampled into a history at a high rate, timestamped in seconds
+    // on the Timer::GetTicksNanos clock. Get the sample taken age samples before the latest.
+    virtual bool    GetGamepadSample(uint32_t index, unsigned age, GamepadState* pState, double* pTime) = 0;
+
+    // Get the state at the given time, interpolated between the samples either side of it.
+    virtual bool    GetGamepadStateAt(uint32_t index, double time, GamepadState* pState) = 0;
+
+    // Get the analog inputs averaged over [fromTime, toTime], each sample holding until the next,
+    // and the buttons as of toTime. Integrating the sticks over a frame this way catches movement
+    // within it; a toTime past the latest sample, such as the predicted display time, holds that sample.
+    bool            GetGamepadAverage(uint32_t index, double fromTime, double toTime, GamepadState* pState)
+    {
+        GamepadState sum, sample;
+        double       sampleTime, end = toTime, covered = 0;
+        bool         haveButtons = false;
+
+        for (unsigned age = 0; GetGamepadSample(index, age, &sample, &sampleTime); ++age)
+        {
+            const double start = (sampleTime > fromTime) ? sampleTime : fromTime;
+            if (end > start)
+            {
+                const float weight = (float)(end - start);
+                sum.LX += sample.LX * weight;
+                sum.LY += sample.LY * weight;
+                sum.RX += sample.RX * weight;
+                sum.RY += sample.RY * weight;
+                sum.LT += sample.LT * weight;
+                sum.RT += sample.RT * weight;
+                covered += end - start;
+            }
+            if (!haveButtons && (sampleTime <= toTime))
+            {
+                sum.Buttons = sample.Buttons;
+                haveButtons = true;
+            }
+            if (sampleTime <= fromTime)
+                break;
+            if (sampleTime < end)
+                end = sampleTime;
+        }
+
+        if (covered <= 0)
+            return GetGamepadStateAt(index, toTime, pState);
+
+        const float scale = (float)(1.0 / covered);
+        sum.LX *= scale;
+        sum.LY *= scale;
+        sum.RX *= scale;
+        sum.RY *= scale;
+        sum.LT *= scale;
+        sum.RT *= scale;
+        *pState = sum;
+        return true;
+    }
 };
 
 }} // OVR::OvrPlatform
@@ -23,6 +23,9 @@ limitations under the License.
 
 #include "Win32_Gamepad.h"
 
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+
 
 OVR_DISABLE_MSVC_WARNING(28159) // C28159: GetTickCount: consider using another function instead.
 
@@ -32,19 +35,37 @@ namespace OVR { namespace OvrPlatform { namespace Win32 {
 GamepadManager::GamepadManager() : 
   //hXInputModule(NULL),
     pXInputGetState(NULL),
-    LastPadPacketNo(0xffffffff),
-    NextTryTime(0)
+    States(),
+    hStopEvent(NULL),
+    PollThread()
 {
+    for (uint32_t i = 0; i < MaxGamepads; ++i)
+        LastPadPacketNo[i] = 0xffffffff;
+
     hXInputModule = ::LoadLibraryW(L"Xinput9_1_0.dll");
     if (hXInputModule)
     {
         pXInputGetState = (PFn_XInputGetState)
             ::GetProcAddress(hXInputModule, "XInputGetState");        
     }
+
+    if (pXInputGetState)
+    {
+        hStopEvent = ::CreateEventW(NULL, TRUE, FALSE, NULL);
+        if (hStopEvent)
+            PollThread = std::thread(&GamepadManager::PollThreadMain, this);
+    }
 }
 
 GamepadManager::~GamepadManager()
 {
+    if (PollThread.joinable())
+    {
+        ::SetEvent(hStopEvent);
+        PollThread.join();
+    }
+    if (hStopEvent)
+        ::CloseHandle(hStopEvent);
     if (hXInputModule)
         ::FreeLibrary(hXInputModule);
 }
@@ -71,49 +92,95 @@ static inline float GamepadTrigger(BYTE in)
 
 uint32_t GamepadManager::GetGamepadCount()
 {
-    return 1;
+    uint32_t count = 0;
+    for (uint32_t mask = States.GetState().ConnectedMask; mask; mask &= mask - 1)
+        ++count;
+    return count;
 }
 
 bool GamepadManager::GetGamepadState(GamepadState* pState)
 {
-    if (pXInputGetState)
+    return GetGamepadState(0, pState);
+}
+
+bool GamepadManager::GetGamepadSample(uint32_t index, unsigned age, GamepadState* pState, double* pTime)
+{
+    return (index < MaxGamepads) && History[index].GetEntry(age, *pState, pTime);
+}
+
+bool GamepadManager::GetGamepadStateAt(uint32_t index, double time, GamepadState* pState)
+{
+    return (index < MaxGamepads) && History[index].GetStateAt(time, *pState);
+}
+
+bool GamepadManager::GetGamepadState(uint32_t index, GamepadState* pState)
+{
+    if (index >= MaxGamepads)
+        return false;
+
+    const PadStates states = States.GetState();
+    if (!(states.ConnectedMask & (1 << index)) || (states.PacketNo[index] == LastPadPacketNo[index]))
+        return false;
+
+    // State changed.
+    *pState = states.State[index];
+    LastPadPacketNo[index] = states.PacketNo[index];
+    return true;
+}
+
+void GamepadManager::PollThreadMain()
+{
+    PadStates states;
+    DWORD     nextTryTime[MaxGamepads] = {}; // If no device was found then we don't try to access it again until some later time. 
+
+    // The default timer period would have the wait below take about 15ms.
+    const bool timerPeriodSet = (timeBeginPeriod(1) == TIMERR_NOERROR);
+
+    do
     {
-        if((NextTryTime == 0) || (GetTickCount() >= NextTryTime)) // If the device is known to be present or if it's time to try testing for it again...
+        for (DWORD i = 0; i < MaxGamepads; ++i)
         {
+            if ((nextTryTime[i] != 0) && (GetTickCount() < nextTryTime[i]))
+                continue;
+
             XINPUT_STATE xis;
-            DWORD dwResult = pXInputGetState(0, &xis); // This function is expensive, including if there is no connected device.
+            DWORD dwResult = pXInputGetState(i, &xis); // This function is expensive, including if there is no connected device.
 
-            if(dwResult == ERROR_SUCCESS)
+            if (dwResult == ERROR_SUCCESS)
             {
-                if (xis.dwPacketNumber != LastPadPacketNo)
+                if (!(states.ConnectedMask & (1 << i)) || (xis.dwPacketNumber != states.PacketNo[i]))
                 {
-                    // State changed.
-                    pState->Buttons = xis.Gamepad.wButtons; // Currently matches Xinput
-                    pState->LT = GamepadTrigger(xis.Gamepad.bLeftTrigger);
-                    pState->RT = GamepadTrigger(xis.Gamepad.bRightTrigger);
-                    pState->LX = GamepadStick(xis.Gamepad.sThumbLX);
-                    pState->LY = GamepadStick(xis.Gamepad.sThumbLY);
-                    pState->RX = GamepadStick(xis.Gamepad.sThumbRX);
-                    pState->RY = GamepadStick(xis.Gamepad.sThumbRY);
-
-                    LastPadPacketNo = xis.dwPacketNumber;
-                    NextTryTime = 0;
-
-                    return true;
+                    GamepadState& state = states.State[i];
+                    state.Buttons = xis.Gamepad.wButtons; // Currently matches Xinput
+                    state.LT = GamepadTrigger(xis.Gamepad.bLeftTrigger);
+                    state.RT = GamepadTrigger(xis.Gamepad.bRightTrigger);
+                    state.LX = GamepadStick(xis.Gamepad.sThumbLX);
+                    state.LY = GamepadStick(xis.Gamepad.sThumbLY);
+                    state.RX = GamepadStick(xis.Gamepad.sThumbRX);
+                    state.RY = GamepadStick(xis.Gamepad.sThumbRY);
+                    states.PacketNo[i] = xis.dwPacketNumber;
                 }
+                states.ConnectedMask |= (1 << i);
+                nextTryTime[i] = 0;
+
+                History[i].SetState(states.State[i], Timer::GetTicksNanos() * (1.0 / Timer::NanosPerSecond));
             }
-            else if(dwResult == ERROR_DEVICE_NOT_CONNECTED)
+            else if (dwResult == ERROR_DEVICE_NOT_CONNECTED)
             {
                 // Don't bother wasting time on XInputGetState if one isn't connected, as it's very slow when one isn't connected.
-                // GetTickCount64 is available with Windows Vista+ and doesn't wrap around.
                 // GetTickCount wraps around every 49.7 days since the system started, but we don't need absolute time and it's OK 
-                // if we have a false positive which would occur if NextTryTime is set to a value that has wrapped around to zero.
-                NextTryTime = GetTickCount() + 5000;
+                // if we have a false positive which would occur if nextTryTime is set to a value that has wrapped around to zero.
+                states.ConnectedMask &= ~(1 << i);
+                states.State[i] = GamepadState();
+                nextTryTime[i] = GetTickCount() + 5000;
             }
         }
-    }
 
-    return false;
+        States.SetState(states);
+    } while (::WaitForSingleObject(hStopEvent, PollIntervalMs) == WAIT_TIMEOUT);
+
+    if (timerPeriodSet)
+        timeEndPeriod(1);
 }
 
 }}} // OVR::OvrPlatform::Win32
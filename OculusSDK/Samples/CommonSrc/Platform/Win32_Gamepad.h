@@ -27,10 +27,16 @@ limitations under the License.
 #include "Gamepad.h"
 
 #include "Kernel/OVR_Win32_IncludeWindows.h"
+#include "Kernel/OVR_Lockless.h"
 #include <xinput.h>
+#include <atomic>
+#include <thread>
 
 namespace OVR { namespace OvrPlatform { namespace Win32 {
 
+// XInputGetState is slow, especially for a slot with nothing connected, so a thread of our own
+// polls all the slots at a fixed rate and publishes them through a LocklessUpdater. Reading the
+// state never makes a system call, and finding a newly connected pad never hitches a frame.
 class GamepadManager : public OvrPlatform::GamepadManager
 {
 public:
@@ -39,15 +45,39 @@ public:
 
     virtual uint32_t  GetGamepadCount();
     virtual bool    GetGamepadState(GamepadState* pState);
+    virtual bool    GetGamepadState(uint32_t index, GamepadState* pState);
+
+    virtual bool    GetGamepadSample(uint32_t index, unsigned age, GamepadState* pState, double* pTime);
+    virtual bool    GetGamepadStateAt(uint32_t index, double time, GamepadState* pState);
+
+    static const uint32_t MaxGamepads = XUSER_MAX_COUNT;
+    static const DWORD    PollIntervalMs = 1;   // With a 1ms timer period, for 500-1000Hz sampling.
+    static const unsigned HistorySize = 1024;   // About a second of samples.
 
 private:
+    void PollThreadMain();
+
+    // What the poll thread publishes.
+    struct PadStates
+    {
+        uint32_t        ConnectedMask;
+        uint32_t        PacketNo[MaxGamepads];
+        GamepadState    State[MaxGamepads];
+
+        PadStates() : ConnectedMask(0) { memset(PacketNo, 0, sizeof(PacketNo)); }
+    };
+
     // Dynamically ink to XInput to simplify projects.
     HMODULE             hXInputModule;
     typedef DWORD (WINAPI *PFn_XInputGetState)(DWORD dwUserIndex, XINPUT_STATE* pState);
     PFn_XInputGetState  pXInputGetState;
 
-    uint32_t            LastPadPacketNo;    // Used to prevent reading the same packet twice.
-    uint32_t            NextTryTime;        // If no device was found then we don't try to access it again until some later time. 
+    LocklessUpdater<PadStates> States;
+    LocklessHistory<GamepadState, HistorySize> History[MaxGamepads]; // Connected pads only.
+    uint32_t            LastPadPacketNo[MaxGamepads];   // Used to prevent reading the same packet twice.
+
+    HANDLE              hStopEvent;
+    std::thread         PollThread;
 };
 
 }}}
@@ -501,18 +501,37 @@ int PlatformCore::Run()
 {
     ovr_TraceMessage(ovrLogLevel_Info, "PlatformCore::Run start");
 
+    bool firstFrameDone = false;
+
+    // Messages are drained for up to this long before each frame, so that a storm of them, such as
+    // mouse moves or raw input, can't hold frames back; any left over wait for the next frame.
+    const double messageBudgetSeconds = 0.002;
+
     while (!Quit)
     {
+        const double messageDeadline = ovr_GetTimeInSeconds() + messageBudgetSeconds;
+
         MSG msg;
-        if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+        while (!Quit && PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
         {
             TranslateMessage(&msg);
             DispatchMessage(&msg);
+
+            if (ovr_GetTimeInSeconds() > messageDeadline)
+                break;
         }
-        else
+
+        if (!Quit)
         {
             pApp->OnIdle();
 
+            // Log how startup time was spent, now that the first frame has been rendered.
+            if (!firstFrameDone)
+            {
+                firstFrameDone = true;
+                OVR::StartupProfile::LogPhases("FirstFrame");
+            }
+
             // Keep sleeping when we're minimized.
             if (IsIconic(hWnd))
             {
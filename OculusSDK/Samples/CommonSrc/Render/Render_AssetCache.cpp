@@ -0,0 +1,302 @@
+/************************************************************************************
+
+Filename    :   Render_AssetCache.cpp
+Content     :   Keeps loaded textures and model buffers for later scene loads to reuse
+Created     :   October 14, 2026
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "Render_AssetCache.h"
+
+#include <algorithm>
+
+namespace OVR { namespace Render {
+
+AssetCache::AssetCache()
+  : Entries(),
+    Limit(512 * 1024 * 1024),
+    UseCounter(0),
+    HitCount(0),
+    EntriesLock()
+{
+}
+
+AssetCache::~AssetCache()
+{
+    Clear();
+}
+
+void AssetCache::SetLimit(size_t bytes)
+{
+    Lock::Locker locker(&EntriesLock);
+    Limit = bytes;
+}
+
+size_t AssetCache::GetCachedBytes() const
+{
+    Lock::Locker locker(&EntriesLock);
+    size_t bytes = 0;
+    for (auto it = Entries.begin(); it != Entries.end(); ++it)
+    {
+        bytes += it->second.Bytes;
+    }
+    return bytes;
+}
+
+uint64_t AssetCache::HashContent(const void* data, size_t size)
+{
+    // FNV-1a, which the baked scenes also store their source's hash as.
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint64_t       hash  = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+size_t AssetCache::GetImageBytes(const TextureImage& image)
+{
+    const int levels = (image.Format & Texture_GenMipmaps) ? GetNumMipLevels(image.Width, image.Height)
+                                                           : std::max(image.MipCount, 1);
+    size_t bytes = 0;
+    for (int i = 0; i < levels; i++)
+    {
+        bytes += GetTextureSize(image.Format, std::max(image.Width >> i, 1), std::max(image.Height >> i, 1));
+    }
+    return (image.Format & Texture_Cubemap) ? bytes * 6 : bytes;
+}
+
+std::string AssetCache::textureKey(const char* path, int loadFlags)
+{
+    char flags[16];
+    snprintf(flags, sizeof(flags), "|%x", loadFlags);
+    return std::string(path) + flags;
+}
+
+std::string AssetCache::modelsKey(const char* path)
+{
+    return std::string(path) + "|models";
+}
+
+Ptr<Texture> AssetCache::FindTexture(const char* path, int loadFlags, uint64_t contentHash, int* sampleMode)
+{
+    Lock::Locker locker(&EntriesLock);
+    auto found = Entries.find(textureKey(path, loadFlags));
+    if (found == Entries.end() || found->second.Hash != contentHash || !found->second.CachedTexture)
+    {
+        return NULL;
+    }
+    found->second.LastUsed = ++UseCounter;
+    HitCount++;
+    if (sampleMode)
+    {
+        *sampleMode = found->second.SampleMode;
+    }
+    return found->second.CachedTexture;
+}
+
+void AssetCache::AddTexture(const char* path, int loadFlags, uint64_t contentHash, Texture* texture, size_t bytes,
+                            int sampleMode)
+{
+    {
+        Lock::Locker locker(&EntriesLock);
+        Entry& entry = Entries[textureKey(path, loadFlags)];
+        entry.Hash          = contentHash;
+        entry.CachedTexture = texture;
+        entry.SampleMode    = sampleMode;
+        entry.Bytes         = bytes;
+        entry.LastUsed      = ++UseCounter;
+    }
+    Trim();
+}
+
+int AssetCache::ReuseModelBuffers(const char* path, uint64_t sourceHash, const std::vector<Ptr<Model> >& models)
+{
+    Lock::Locker locker(&EntriesLock);
+    auto found = Entries.find(modelsKey(path));
+    if (found == Entries.end() || found->second.Hash != sourceHash)
+    {
+        return 0;
+    }
+
+    Entry& entry = found->second;
+    if (!isUsed(entry))
+    {
+        takeBuffers(entry);
+    }
+
+    // The models of a scene load still in use give their buffers directly.
+    int reused = 0;
+    for (size_t i = 0; i < models.size(); i++)
+    {
+        Model* model = models[i];
+        ModelBuffers buffers;
+        if (i < entry.Models.size())
+        {
+            const Model* cached = entry.Models[i];
+            if (!cached->HasRenderBuffers())
+            {
+                continue;
+            }
+            buffers.VertexBuffer    = cached->VertexBuffer;
+            buffers.AttributeBuffer = cached->AttributeBuffer;
+            buffers.IndexBuffer     = cached->IndexBuffer;
+            buffers.Layout          = cached->Layout;
+            buffers.QuantizeBias    = cached->QuantizeBias;
+            buffers.QuantizeScale   = cached->QuantizeScale;
+            buffers.VertexCount     = cached->Vertices.size();
+            buffers.IndexCount      = cached->Indices.size();
+        }
+        else if (i < entry.Buffers.size())
+        {
+            buffers = entry.Buffers[i];
+        }
+        else
+        {
+            break;
+        }
+
+        if ((!buffers.VertexBuffer && !buffers.IndexBuffer) ||
+            buffers.VertexCount != model->Vertices.size() || buffers.IndexCount != model->Indices.size())
+        {
+            continue;
+        }
+        OVR_ASSERT(!model->VertexBuffer && !model->IndexBuffer);
+        model->Layout          = buffers.Layout;
+        model->QuantizeBias    = buffers.QuantizeBias;
+        model->QuantizeScale   = buffers.QuantizeScale;
+        model->VertexBuffer    = buffers.VertexBuffer;
+        model->AttributeBuffer = buffers.AttributeBuffer;
+        model->IndexBuffer     = buffers.IndexBuffer;
+        reused++;
+    }
+
+    entry.LastUsed = ++UseCounter;
+    if (reused)
+    {
+        HitCount++;
+    }
+    return reused;
+}
+
+void AssetCache::AddModels(const char* path, uint64_t sourceHash, const std::vector<Ptr<Model> >& models)
+{
+    {
+        Lock::Locker locker(&EntriesLock);
+        Entry& entry = Entries[modelsKey(path)];
+        entry.Hash     = sourceHash;
+        entry.Models   = models;
+        entry.Buffers.clear();
+        entry.Bytes    = 0;
+        entry.LastUsed = ++UseCounter;
+    }
+    Trim();
+}
+
+void AssetCache::takeBuffers(Entry& entry)
+{
+    if (entry.Models.empty())
+    {
+        return;
+    }
+
+    entry.Buffers.resize(entry.Models.size());
+    entry.Bytes = 0;
+    for (size_t i = 0; i < entry.Models.size(); i++)
+    {
+        Model*        model   = entry.Models[i];
+        ModelBuffers& buffers = entry.Buffers[i];
+        if (model->HasRenderBuffers())
+        {
+            buffers.VertexBuffer    = model->VertexBuffer;
+            buffers.AttributeBuffer = model->AttributeBuffer;
+            buffers.IndexBuffer     = model->IndexBuffer;
+        }
+        buffers.Layout        = model->Layout;
+        buffers.QuantizeBias  = model->QuantizeBias;
+        buffers.QuantizeScale = model->QuantizeScale;
+        buffers.VertexCount   = model->Vertices.size();
+        buffers.IndexCount    = model->Indices.size();
+
+        entry.Bytes += buffers.VertexBuffer ? buffers.VertexBuffer->GetSize() : 0;
+        entry.Bytes += buffers.AttributeBuffer ? buffers.AttributeBuffer->GetSize() : 0;
+        entry.Bytes += buffers.IndexBuffer ? buffers.IndexBuffer->GetSize() : 0;
+    }
+    entry.Models.clear();
+}
+
+bool AssetCache::isUsed(const Entry& entry)
+{
+    if (entry.CachedTexture)
+    {
+        return entry.CachedTexture->GetRefCount() > 1;
+    }
+    for (size_t i = 0; i < entry.Models.size(); i++)
+    {
+        if (entry.Models[i]->GetRefCount() > 1)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AssetCache::Trim()
+{
+    Lock::Locker locker(&EntriesLock);
+
+    // Entries are dropped least recently used first, until the unused ones fit.
+    std::vector<std::pair<uint32_t, std::string> > unused;
+    size_t unusedBytes = 0;
+    for (auto it = Entries.begin(); it != Entries.end(); )
+    {
+        Entry& entry = it->second;
+        if (isUsed(entry))
+        {
+            ++it;
+            continue;
+        }
+        takeBuffers(entry);
+        if (entry.Bytes == 0)
+        {
+            it = Entries.erase(it);
+            continue;
+        }
+        unused.push_back(std::make_pair(entry.LastUsed, it->first));
+        unusedBytes += entry.Bytes;
+        ++it;
+    }
+
+    std::sort(unused.begin(), unused.end());
+    for (size_t i = 0; i < unused.size() && unusedBytes > Limit; i++)
+    {
+        auto found = Entries.find(unused[i].second);
+        unusedBytes -= found->second.Bytes;
+        Entries.erase(found);
+    }
+}
+
+void AssetCache::Clear()
+{
+    Lock::Locker locker(&EntriesLock);
+    Entries.clear();
+    HitCount = 0;
+}
+
+}} // namespace OVR::Render
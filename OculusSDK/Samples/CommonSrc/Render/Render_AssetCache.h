@@ -0,0 +1,127 @@
+/************************************************************************************
+
+Filename    :   Render_AssetCache.h
+Content     :   Keeps loaded textures and model buffers for later scene loads to reuse
+Created     :   October 14, 2026
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_Render_AssetCache_h
+#define OVR_Render_AssetCache_h
+
+#include "Render_Device.h"
+#include "Kernel/OVR_Atomic.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace OVR { namespace Render {
+
+//-----------------------------------------------------------------------------------
+// ***** AssetCache
+//
+// Holds on to the textures and model buffers scenes are loaded with, so that loading a scene
+// again, or another scene using the same texture files, reuses them instead of decoding and
+// uploading everything again. Textures are keyed by file path and load flags, and only reused
+// while the file's contents still hash the same. Model buffers are keyed by the scene file and
+// the hash of its source, and handed to the models loaded from it that match the earlier ones.
+//
+// Entries still referenced from elsewhere, such as by a loaded scene, are always kept. Once
+// nothing else uses them, the least recently used are dropped while they take more than the limit.
+//
+// Textures and buffers belong to the RenderDevice that created them, so Clear the cache before
+// the device goes. FindTexture may be called from any thread; the rest only from the render thread.
+
+class AssetCache
+{
+public:
+    AssetCache();
+    ~AssetCache();
+
+    // For the entries nothing else uses.
+    void     SetLimit(size_t bytes);
+    size_t   GetLimit() const               { return Limit; }
+    size_t   GetCachedBytes() const;
+    int      GetHitCount() const            { return HitCount; }
+
+    // The hash texture entries are checked against.
+    static uint64_t HashContent(const void* data, size_t size);
+    // What the texture created from image takes, with the mips it is created with.
+    static size_t   GetImageBytes(const TextureImage& image);
+
+    // sampleMode, if set, is given the one the texture was added with.
+    Ptr<Texture> FindTexture(const char* path, int loadFlags, uint64_t contentHash, int* sampleMode = NULL);
+    // bytes is what the texture takes, by its mip chain, and sampleMode the one its image set.
+    void     AddTexture(const char* path, int loadFlags, uint64_t contentHash, Texture* texture, size_t bytes,
+                        int sampleMode = -1);
+
+    // Gives each of models the buffers, and vertex layout, of the model at the same index last
+    // added for the scene, where that has them and the same vertex and index counts. Returns the
+    // number of models given buffers.
+    int      ReuseModelBuffers(const char* path, uint64_t sourceHash, const std::vector<Ptr<Model> >& models);
+    // Remembers the models, whose buffers are taken once they're drawn and later released.
+    void     AddModels(const char* path, uint64_t sourceHash, const std::vector<Ptr<Model> >& models);
+
+    // Drops the unused entries over the limit; Add calls this.
+    void     Trim();
+    void     Clear();
+
+private:
+    struct ModelBuffers
+    {
+        Ptr<Buffer>         VertexBuffer;
+        Ptr<Buffer>         AttributeBuffer;
+        Ptr<Buffer>         IndexBuffer;
+        VertexLayout        Layout;
+        Vector3f            QuantizeBias;   // Of VertexBuffer, with VertexLayout_Quantized.
+        float               QuantizeScale;
+        size_t              VertexCount;
+        size_t              IndexCount;
+
+        ModelBuffers() : Layout(VertexLayout_Interleaved), QuantizeBias(), QuantizeScale(1.0f),
+                         VertexCount(0), IndexCount(0) { }
+    };
+
+    struct Entry
+    {
+        uint64_t            Hash;
+        Ptr<Texture>        CachedTexture;
+        std::vector<Ptr<Model> >   Models;      // Until they're released, then Buffers.
+        std::vector<ModelBuffers>  Buffers;
+        int                 SampleMode;
+        size_t              Bytes;
+        uint32_t            LastUsed;
+
+        Entry() : Hash(0), SampleMode(-1), Bytes(0), LastUsed(0) { }
+    };
+
+    static std::string textureKey(const char* path, int loadFlags);
+    static std::string modelsKey(const char* path);
+    static void        takeBuffers(Entry& entry);
+    static bool        isUsed(const Entry& entry);
+
+    std::unordered_map<std::string, Entry> Entries;
+    size_t                                 Limit;
+    uint32_t                               UseCounter;
+    int                                    HitCount;
+    mutable Lock                           EntriesLock;
+};
+
+}} // namespace OVR::Render
+
+#endif // OVR_Render_AssetCache_h
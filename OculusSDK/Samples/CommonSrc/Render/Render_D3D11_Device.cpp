@@ -34,6 +34,7 @@ limitations under the License.
 #include <direct.h>
 
 #include "Kernel/OVR_Std.h"
+#include "Kernel/OVR_TaskScheduler.h"
 
 #include "Util/Util_Direct3D.h"
 #include <comdef.h>
@@ -49,6 +50,9 @@ namespace OVR { namespace Render { namespace D3D11 {
 
 using namespace D3DUtil;
 
+// The recorder of the slice the calling thread is recording, if any.
+static OVR_THREAD_LOCAL RenderDevice::DeferredRecorder* CurrentRecorder = nullptr;
+
 static D3D11_INPUT_ELEMENT_DESC ModelVertexDesc[] =
 {
     { "Position",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, Pos),   D3D11_INPUT_PER_VERTEX_DATA, 0 },
@@ -58,6 +62,39 @@ static D3D11_INPUT_ELEMENT_DESC ModelVertexDesc[] =
     { "Normal",     0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, Norm),  D3D11_INPUT_PER_VERTEX_DATA, 0 },
 };
 
+// VertexLayout_Split: positions in slot 0, VertexAttributes in slot 1.
+static D3D11_INPUT_ELEMENT_DESC ModelSplitVertexDesc[] =
+{
+    { "Position",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,                                 D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "Color",      0, DXGI_FORMAT_R8G8B8A8_UNORM,  1, offsetof(VertexAttributes, C),     D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "TexCoord",   0, DXGI_FORMAT_R32G32_FLOAT,    1, offsetof(VertexAttributes, U),     D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "TexCoord",   1, DXGI_FORMAT_R32G32_FLOAT,    1, offsetof(VertexAttributes, U2),    D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "Normal",     0, DXGI_FORMAT_R32G32B32_FLOAT, 1, offsetof(VertexAttributes, Norm),  D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
+// VertexLayout_Quantized: one stream of QuantizedVertex, expanded to floats by the input assembler.
+static D3D11_INPUT_ELEMENT_DESC ModelQuantizedVertexDesc[] =
+{
+    { "Position",   0, DXGI_FORMAT_R16G16B16A16_SNORM, 0, offsetof(QuantizedVertex, Pos),    D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "Color",      0, DXGI_FORMAT_R8G8B8A8_UNORM,     0, offsetof(QuantizedVertex, C),      D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "TexCoord",   0, DXGI_FORMAT_R16G16_FLOAT,       0, offsetof(QuantizedVertex, UV),     D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "TexCoord",   1, DXGI_FORMAT_R16G16_FLOAT,       0, offsetof(QuantizedVertex, UV) + 4, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+    { "Normal",     0, DXGI_FORMAT_R8G8B8A8_SNORM,     0, offsetof(QuantizedVertex, Norm),   D3D11_INPUT_PER_VERTEX_DATA, 0 },
+};
+
+// InstancedModel: ModelVertexDesc in slot 0, and the rows of each instance transform in slot 1.
+static D3D11_INPUT_ELEMENT_DESC ModelInstancedVertexDesc[] =
+{
+    { "Position",    0, DXGI_FORMAT_R32G32B32_FLOAT,    0, offsetof(Vertex, Pos),   D3D11_INPUT_PER_VERTEX_DATA,   0 },
+    { "Color",       0, DXGI_FORMAT_R8G8B8A8_UNORM,     0, offsetof(Vertex, C),     D3D11_INPUT_PER_VERTEX_DATA,   0 },
+    { "TexCoord",    0, DXGI_FORMAT_R32G32_FLOAT,       0, offsetof(Vertex, U),     D3D11_INPUT_PER_VERTEX_DATA,   0 },
+    { "TexCoord",    1, DXGI_FORMAT_R32G32_FLOAT,       0, offsetof(Vertex, U2),    D3D11_INPUT_PER_VERTEX_DATA,   0 },
+    { "Normal",      0, DXGI_FORMAT_R32G32B32_FLOAT,    0, offsetof(Vertex, Norm),  D3D11_INPUT_PER_VERTEX_DATA,   0 },
+    { "InstanceRow", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0,                       D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+    { "InstanceRow", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16,                      D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+    { "InstanceRow", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32,                      D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+};
+
 #pragma region Scene shaders
 
 #define MVP_VARYINGS                 \
@@ -71,15 +108,67 @@ static D3D11_INPUT_ELEMENT_DESC ModelVertexDesc[] =
     "   float3 VPos     : TEXCOORD4;\n"     \
     "};\n"
 
+// The view correction late latching rewrites after the frame's draws are submitted; the
+// identity otherwise. Lighting stays in the view as drawn.
+#define LATE_LATCH_UNIFORMS \
+    "cbuffer LateLatch : register(b2) { float4x4 LateView; };\n"
+
 static const char* MVPVertexShaderSrc =
     "float4x4 Proj;\n"
     "float4x4 View;\n"
     "float4 GlobalTint;\n"
+    LATE_LATCH_UNIFORMS
+    MVP_VARYINGS
+    "void main(in float4 Position : POSITION, in float4 Color : COLOR0, in float2 TexCoord : TEXCOORD0, in float2 TexCoord1 : TEXCOORD1, in float3 Normal : NORMAL,\n"
+    "          out Varyings ov)\n"
+    "{\n"
+    "   ov.Position = mul(Proj, mul(LateView, mul(View, Position)));\n"
+    "   ov.Normal = mul(View, Normal);\n"
+    "   ov.VPos = mul(View, Position);\n"
+    "   ov.TexCoord = TexCoord;\n"
+    "   ov.TexCoord1 = TexCoord1;\n"
+    "   ov.Color = Color * GlobalTint;\n"
+    "}\n";
+
+// MVPVertexShaderSrc, with Position and Normal first taken from instance to model space. It has
+// the same uniforms, so it can stand in for MVP with any fill's pixel shader.
+static const char* MVPInstancedVertexShaderSrc =
+    "float4x4 Proj;\n"
+    "float4x4 View;\n"
+    "float4 GlobalTint;\n"
+    LATE_LATCH_UNIFORMS
     MVP_VARYINGS
     "void main(in float4 Position : POSITION, in float4 Color : COLOR0, in float2 TexCoord : TEXCOORD0, in float2 TexCoord1 : TEXCOORD1, in float3 Normal : NORMAL,\n"
+    "          in float4 InstanceRow0 : INSTANCEROW0, in float4 InstanceRow1 : INSTANCEROW1, in float4 InstanceRow2 : INSTANCEROW2,\n"
     "          out Varyings ov)\n"
     "{\n"
-    "   ov.Position = mul(Proj, mul(View, Position));\n"
+    "   float4 MPos = float4(dot(InstanceRow0, Position), dot(InstanceRow1, Position), dot(InstanceRow2, Position), Position.w);\n"
+    "   float3 MNormal = float3(dot(InstanceRow0.xyz, Normal), dot(InstanceRow1.xyz, Normal), dot(InstanceRow2.xyz, Normal));\n"
+    "   ov.Position = mul(Proj, mul(LateView, mul(View, MPos)));\n"
+    "   ov.Normal = mul(View, MNormal);\n"
+    "   ov.VPos = mul(View, MPos);\n"
+    "   ov.TexCoord = TexCoord;\n"
+    "   ov.TexCoord1 = TexCoord1;\n"
+    "   ov.Color = Color * GlobalTint;\n"
+    "}\n";
+
+// MVPVertexShaderSrc drawn as two instances, one for each half of a stereo viewport. View is the
+// left eye's, which the normal and view position keep, so lighting is from the left eye.
+static const char* MVPStereoVertexShaderSrc =
+    "float4x4 Proj;\n"
+    "float4x4 View;\n"
+    "float4 GlobalTint;\n"
+    "float4x4 EyeProj[2];\n"
+    "float4 EyeClipPlane[2];\n"
+    LATE_LATCH_UNIFORMS
+    MVP_VARYINGS
+    "void main(in float4 Position : POSITION, in float4 Color : COLOR0, in float2 TexCoord : TEXCOORD0, in float2 TexCoord1 : TEXCOORD1, in float3 Normal : NORMAL,\n"
+    "          in uint InstanceId : SV_InstanceID,\n"
+    "          out Varyings ov, out float oClipDist : SV_ClipDistance0)\n"
+    "{\n"
+    "   uint eye = InstanceId & 1;\n"
+    "   ov.Position = mul(EyeProj[eye], mul(LateView, mul(View, Position)));\n"
+    "   oClipDist = dot(EyeClipPlane[eye], ov.Position);\n"
     "   ov.Normal = mul(View, Normal);\n"
     "   ov.VPos = mul(View, Position);\n"
     "   ov.TexCoord = TexCoord;\n"
@@ -375,6 +464,62 @@ static const char* MultiTextureHeavyAluEarlyZPixelShaderSrc =
     "   return pixColor;\n"
     "}\n";
 
+// The array shaders draw models whose textures were packed into array textures. The vertex
+// color alpha holds the diffuse slice in its high four bits and the lightmap slice in its low
+// four, so the tint must leave alpha at one.
+#define TEXTURE_ARRAY_SLICES                                        \
+    "float2 GetSlices(float alpha)\n"                               \
+    "{\n"                                                           \
+    "   float packed = floor(alpha * 255.0 + 0.5);\n"               \
+    "   float diffuse = floor(packed / 16.0);\n"                    \
+    "   return float2(diffuse, packed - diffuse * 16.0);\n"         \
+    "}\n"
+
+static const char* TextureArrayPixelShaderSrc =
+    "Texture2DArray Texture : register(t0);\n"
+    "SamplerState Linear : register(s0);\n"
+    "struct Varyings\n"
+    "{\n"
+    "   float4 Position : SV_Position;\n"
+    "   float4 Color    : COLOR0;\n"
+    "   float2 TexCoord : TEXCOORD0;\n"
+    "};\n"
+    TEXTURE_ARRAY_SLICES
+    "float4 main(in Varyings ov) : SV_Target\n"
+    "{\n"
+    "   float2 slices = GetSlices(ov.Color.a);\n"
+    "   float4 color2 = Texture.Sample(Linear, float3(ov.TexCoord, slices.x));\n"
+    "   color2.rgb *= ov.Color.rgb;\n"
+    "   if (color2.a <= 0.4)\n"
+    "           discard;\n"
+    "   return color2;\n"
+    "}\n";
+
+static const char* MultiTextureArrayPixelShaderSrc =
+    "Texture2DArray Texture[2] : register(t0);\n"
+    "SamplerState Linear[2] : register(s0);\n"
+    "struct Varyings\n"
+    "{\n"
+    "   float4 Position : SV_Position;\n"
+    "   float4 Color    : COLOR0;\n"
+    "   float2 TexCoord : TEXCOORD0;\n"
+    "   float2 TexCoord1 : TEXCOORD1;\n"
+    "};\n"
+    TEXTURE_ARRAY_SLICES
+    "float4 main(in Varyings ov) : SV_Target\n"
+    "{\n"
+    "   float2 slices = GetSlices(ov.Color.a);\n"
+    "   float4 color1 = Texture[0].Sample(Linear[0], float3(ov.TexCoord, slices.x));\n"
+    "   float4 color2 = Texture[1].Sample(Linear[1], float3(ov.TexCoord1, slices.y));\n"
+    "   color2.rgb = sqrt(color2.rgb);\n"
+    "   color2.rgb = color2.rgb * lerp(0.2, 1.2, saturate(length(color2.rgb)));\n"
+    "   color2 = color1 * color2;\n"
+    "   if (color2.a <= 0.6)\n"
+    "       discard;\n"
+    "   color2.rgb *= ov.Color.rgb;\n"
+    "   return float4(color2.rgb / color2.a, 1);\n"
+    "}\n";
+
 #define LIGHTING_COMMON                 \
     "cbuffer Lighting : register(b1)\n" \
     "{\n"                               \
@@ -621,7 +766,8 @@ RenderDevice::RenderDevice(ovrSession session, const RendererParams& p, HWND win
     }
     
 
-    int flags = D3D11_CREATE_DEVICE_BGRA_SUPPORT;
+    // Video support lets D3DVideoRecorder convert and encode the mirror texture on the GPU.
+    int flags = D3D11_CREATE_DEVICE_BGRA_SUPPORT | D3D11_CREATE_DEVICE_VIDEO_SUPPORT;
 
     // FIXME: Disable debug device creation while
     // we find the source of the debug slowdown.
@@ -644,6 +790,14 @@ RenderDevice::RenderDevice(ovrSession session, const RendererParams& p, HWND win
                                NULL, flags, NULL, 0, D3D11_SDK_VERSION,
                                &Device.GetRawRef(), &featureLevel, &Context.GetRawRef());
     }
+    if (FAILED(hr) && (flags & D3D11_CREATE_DEVICE_VIDEO_SUPPORT))
+    {
+        // Some drivers have no video support, which we only need for recording.
+        flags &= ~D3D11_CREATE_DEVICE_VIDEO_SUPPORT;
+        hr = D3D11CreateDevice(Adapter, Adapter ? D3D_DRIVER_TYPE_UNKNOWN : D3D_DRIVER_TYPE_HARDWARE,
+                               NULL, flags, NULL, 0, D3D11_SDK_VERSION,
+                               &Device.GetRawRef(), &featureLevel, &Context.GetRawRef());
+    }
     OVR_D3D_CHECK_RET(hr);
 
     if (!RecreateSwapChain())
@@ -656,48 +810,70 @@ RenderDevice::RenderDevice(ovrSession session, const RendererParams& p, HWND win
         MaxTextureSet[i] = 0;
     }
 
-    ID3D10Blob* vsData = CompileShader(VShaderSrcs[0].ShaderModel, VShaderSrcs[0].SourceStr);
+    // Compile the builtin shaders in parallel. After the first run they mostly come straight
+    // from the shader cache (see CompileShader).
+    ID3D10Blob* vsBlobs[VShader_Count] = {};
+    ID3D10Blob* gsBlobs[GShader_Count] = {};
+    ID3D10Blob* fsBlobs[FShader_Count] = {};
+    {
+        TaskGroup group(SharedTaskScheduler::GetInstance()->GetScheduler());
+
+        for (int i = 0; i < VShader_Count; i++)
+        {
+            OVR_ASSERT(VShaderSrcs[i].SourceStr != NULL);      // You forgot a shader!
+            group.Run([this, i, &vsBlobs]() { vsBlobs[i] = CompileShader(VShaderSrcs[i].ShaderModel, VShaderSrcs[i].SourceStr); });
+        }
+        for (int i = 0; i < GShader_Count; i++)
+        {
+            OVR_ASSERT(GShaderSrcs[i].SourceStr != NULL);      // You forgot a shader!
+            group.Run([this, i, &gsBlobs]() { gsBlobs[i] = CompileShader(GShaderSrcs[i].ShaderModel, GShaderSrcs[i].SourceStr); });
+        }
+        for (int i = 0; i < FShader_Count; i++)
+        {
+            OVR_ASSERT(FShaderSrcs[i].SourceStr != NULL);      // You forgot a shader!
+            group.Run([this, i, &fsBlobs]() { fsBlobs[i] = CompileShader(FShaderSrcs[i].ShaderModel, FShaderSrcs[i].SourceStr); });
+        }
+
+        group.Wait();
+    }
+
+    ID3D10Blob* vsData = vsBlobs[0];
 
     VertexShaders[VShader_MV] = *new VertexShader(this, vsData);
     for (int i = 1; i < VShader_Count; i++)
     {
-        OVR_ASSERT(VShaderSrcs[i].SourceStr != NULL);      // You forgot a shader!
-        ID3D10Blob *pShader = CompileShader(VShaderSrcs[i].ShaderModel, VShaderSrcs[i].SourceStr);
+        ID3D10Blob *pShader = vsBlobs[i];
 
         VertexShaders[i] = NULL;
         if (pShader != NULL)
         {
             VertexShaders[i] = *new VertexShader(this, pShader);
+
+            if (i == VShader_MVPInstanced)
+            {
+                ModelInstancedVertexIL = NULL;
+                hr = Device->CreateInputLayout(ModelInstancedVertexDesc, sizeof(ModelInstancedVertexDesc) / sizeof(ModelInstancedVertexDesc[0]),
+                                               pShader->GetBufferPointer(), pShader->GetBufferSize(), &ModelInstancedVertexIL.GetRawRef());
+                OVR_D3D_CHECK_RET(hr);
+            }
         }
     }
 
     for (int i = 0; i < GShader_Count; i++)
     {
-        OVR_ASSERT(GShaderSrcs[i].SourceStr != NULL);      // You forgot a shader!
-        const char* source      = GShaderSrcs[i].SourceStr;
-        const char* shaderModel = GShaderSrcs[i].ShaderModel;
-
         GeometryShaders[i] = NULL;
-
+        if (gsBlobs[i] != NULL)
         {
-            ID3D10Blob *pShader = CompileShader(shaderModel, source);
-
-            if (pShader != NULL)
-            {
-                GeometryShaders[i] = *new GeomShader(this, pShader);
-            }
+            GeometryShaders[i] = *new GeomShader(this, gsBlobs[i]);
         }
     }
 
     for (int i = 0; i < FShader_Count; i++)
     {
-        OVR_ASSERT(FShaderSrcs[i].SourceStr != NULL);      // You forgot a shader!
-        ID3D10Blob *pShader = CompileShader(FShaderSrcs[i].ShaderModel, FShaderSrcs[i].SourceStr);
-
         PixelShaders[i] = NULL;
-        if (pShader != NULL)
+        if (fsBlobs[i] != NULL)
         {
-            PixelShaders[i] = *new PixelShader(this, pShader);
+            PixelShaders[i] = *new PixelShader(this, fsBlobs[i]);
         }
     }
 
@@ -708,6 +884,16 @@ RenderDevice::RenderDevice(ovrSession session, const RendererParams& p, HWND win
     hr = Device->CreateInputLayout(ModelVertexDesc, sizeof(ModelVertexDesc) / sizeof(ModelVertexDesc[0]), buffer, bufferSize, objRef);
     OVR_D3D_CHECK_RET(hr);
 
+    ModelSplitVertexIL = NULL;
+    objRef = &ModelSplitVertexIL.GetRawRef();
+    hr = Device->CreateInputLayout(ModelSplitVertexDesc, sizeof(ModelSplitVertexDesc) / sizeof(ModelSplitVertexDesc[0]), buffer, bufferSize, objRef);
+    OVR_D3D_CHECK_RET(hr);
+
+    ModelQuantizedVertexIL = NULL;
+    objRef = &ModelQuantizedVertexIL.GetRawRef();
+    hr = Device->CreateInputLayout(ModelQuantizedVertexDesc, sizeof(ModelQuantizedVertexDesc) / sizeof(ModelQuantizedVertexDesc[0]), buffer, bufferSize, objRef);
+    OVR_D3D_CHECK_RET(hr);
+
     Ptr<ShaderSet> gouraudShaders = *new ShaderSet();
     gouraudShaders->SetShader(VertexShaders[VShader_MVP]);
     gouraudShaders->SetShader(PixelShaders[FShader_Gouraud]);
@@ -729,15 +915,13 @@ RenderDevice::RenderDevice(ovrSession session, const RendererParams& p, HWND win
     bm.RenderTarget[0].SrcBlend = bm.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE; //premultiplied alpha
     bm.RenderTarget[0].DestBlend = bm.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
     bm.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
-    BlendStatePreMulAlpha = NULL;
-    hr = Device->CreateBlendState(&bm, &BlendStatePreMulAlpha.GetRawRef());
+    BlendStatePreMulAlpha = GetBlendState(bm);
     bm.RenderTarget[0].SrcBlend = bm.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_SRC_ALPHA; //normal alpha
-    BlendStateNormalAlpha = NULL;
-    hr = Device->CreateBlendState(&bm, &BlendStateNormalAlpha.GetRawRef());
-
-
-
-    OVR_D3D_CHECK_RET(hr);
+    BlendStateNormalAlpha = GetBlendState(bm);
+    if (!BlendStatePreMulAlpha || !BlendStateNormalAlpha)
+    {
+        return;
+    }
 
     // If more rasterizer permutations are needed use a bitmask and generate
     // rasterizer state on demand.
@@ -748,30 +932,26 @@ RenderDevice::RenderDevice(ovrSession session, const RendererParams& p, HWND win
     rs.DepthClipEnable = true;
     rs.ScissorEnable   = false;
     rs.FillMode = D3D11_FILL_SOLID;
-    RasterizerCullBack = NULL;
-    hr = Device->CreateRasterizerState(&rs, &RasterizerCullBack.GetRawRef());
-    OVR_D3D_CHECK_RET(hr);
+    RasterizerCullBack = GetRasterizerState(rs);
     rs.ScissorEnable = true;
-    hr = Device->CreateRasterizerState(&rs, &RasterizerCullBackScissorEnabled.GetRawRef());
-    OVR_D3D_CHECK_RET(hr);
+    RasterizerCullBackScissorEnabled = GetRasterizerState(rs);
 
     rs.CullMode = D3D11_CULL_FRONT;
     rs.ScissorEnable   = false;
-    RasterizerCullFront = NULL;
-    hr = Device->CreateRasterizerState(&rs, &RasterizerCullFront.GetRawRef());
-    OVR_D3D_CHECK_RET(hr);
+    RasterizerCullFront = GetRasterizerState(rs);
     rs.ScissorEnable = true;
-    hr = Device->CreateRasterizerState(&rs, &RasterizerCullFrontScissorEnabled.GetRawRef());
-    OVR_D3D_CHECK_RET(hr);
+    RasterizerCullFrontScissorEnabled = GetRasterizerState(rs);
 
     rs.CullMode = D3D11_CULL_NONE;
     rs.ScissorEnable   = false;
-    RasterizerCullOff = NULL;
-    hr = Device->CreateRasterizerState(&rs, &RasterizerCullOff.GetRawRef());
-    OVR_D3D_CHECK_RET(hr);
+    RasterizerCullOff = GetRasterizerState(rs);
     rs.ScissorEnable = true;
-    hr = Device->CreateRasterizerState(&rs, &RasterizerCullOffScissorEnabled.GetRawRef());
-    OVR_D3D_CHECK_RET(hr);
+    RasterizerCullOffScissorEnabled = GetRasterizerState(rs);
+    if (!RasterizerCullBack || !RasterizerCullBackScissorEnabled || !RasterizerCullFront ||
+        !RasterizerCullFrontScissorEnabled || !RasterizerCullOff || !RasterizerCullOffScissorEnabled)
+    {
+        return;
+    }
 
     QuadVertexBuffer = *CreateBuffer();
     const Render::Vertex QuadVertices[] =
@@ -784,6 +964,20 @@ RenderDevice::RenderDevice(ovrSession session, const RendererParams& p, HWND win
 
     SetDepthMode(0, 0);
 
+    // Create every depth and sampler mode's state now, rather than on first use mid-frame.
+    for (int func = 0; func < Compare_Count; func++)
+    {
+        GetDepthState(true, false, (CompareFunc)func);
+        GetDepthState(true, true, (CompareFunc)func);
+    }
+    for (int address = Sample_Repeat; address <= Sample_ClampBorder; address += Sample_Clamp)
+    {
+        for (int filter = Sample_Linear; filter <= Sample_Anisotropic; filter++)
+        {
+            GetSamplerState(address | filter);
+        }
+    }
+
     Blitter = *new D3DUtil::Blitter(Device);
     if (!Blitter->Initialize())
     {
@@ -792,10 +986,17 @@ RenderDevice::RenderDevice(ovrSession session, const RendererParams& p, HWND win
 
     Context->QueryInterface(IID_PPV_ARGS(&UserAnnotation.GetRawRef()));
 
+    CreateUniformRing();
+    CreateLateLatchBuffers();
+
+    D3D11_FEATURE_DATA_THREADING threading = {};
+    DriverCommandLists = SUCCEEDED(Device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading))) &&
+                         threading.DriverCommandLists;
 }
 
 RenderDevice::~RenderDevice()
 {
+    Recorders.clear();
     DeleteFills();
 }
 
@@ -903,16 +1104,12 @@ static int GetDepthStateIndex(bool enable, bool write, RenderDevice::CompareFunc
     return 1 + int(func) * 2 + write;
 }
 
-void RenderDevice::SetDepthMode(bool enable, bool write, CompareFunc func)
+ID3D11DepthStencilState* RenderDevice::GetDepthState(bool enable, bool write, CompareFunc func)
 {
-    HRESULT hr;
-
     int index = GetDepthStateIndex(enable, write, func);
     if (DepthStates[index])
     {
-        CurDepthState = DepthStates[index];
-        Context->OMSetDepthStencilState(DepthStates[index], 0);
-        return;
+        return DepthStates[index];
     }
 
     D3D11_DEPTH_STENCIL_DESC dss;
@@ -923,14 +1120,60 @@ void RenderDevice::SetDepthMode(bool enable, bool write, CompareFunc func)
     case Compare_Always:  dss.DepthFunc = D3D11_COMPARISON_ALWAYS;  break;
     case Compare_Less:    dss.DepthFunc = D3D11_COMPARISON_LESS;    break;
     case Compare_Greater: dss.DepthFunc = D3D11_COMPARISON_GREATER; break;
+    case Compare_LessEqual:    dss.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;    break;
+    case Compare_GreaterEqual: dss.DepthFunc = D3D11_COMPARISON_GREATER_EQUAL; break;
     default:
         OVR_ASSERT(0);
     }
     dss.DepthWriteMask = write ? D3D11_DEPTH_WRITE_MASK_ALL : D3D11_DEPTH_WRITE_MASK_ZERO;
-    hr = Device->CreateDepthStencilState(&dss, &DepthStates[index].GetRawRef());
-    OVR_D3D_CHECK_RET(hr);
-    Context->OMSetDepthStencilState(DepthStates[index], 0);
-    CurDepthState = DepthStates[index];
+    DepthStates[index] = GetDepthStencilState(dss);
+    return DepthStates[index];
+}
+
+void RenderDevice::SetDepthMode(bool enable, bool write, CompareFunc func)
+{
+    ID3D11DepthStencilState* state = GetDepthState(enable, write, func);
+    if (state)
+    {
+        Context->OMSetDepthStencilState(state, 0);
+        CurDepthState = state;
+    }
+}
+
+template<class Desc, class State>
+static State* getCachedState(ID3D11Device* device, StateObjectCache<Desc, State>& cache, const Desc& desc,
+                             HRESULT (STDMETHODCALLTYPE ID3D11Device::*create)(const Desc*, State**))
+{
+    State* state = cache.Find(desc);
+    if (!state)
+    {
+        Ptr<State> created;
+        HRESULT hr = (device->*create)(&desc, &created.GetRawRef());
+        OVR_D3D_CHECK_RET_NULL(hr);
+        cache.Add(desc, created);
+        state = created;
+    }
+    return state;
+}
+
+ID3D11DepthStencilState* RenderDevice::GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc)
+{
+    return getCachedState(Device, DepthStateCache, desc, &ID3D11Device::CreateDepthStencilState);
+}
+
+ID3D11RasterizerState* RenderDevice::GetRasterizerState(const D3D11_RASTERIZER_DESC& desc)
+{
+    return getCachedState(Device, RasterizerStateCache, desc, &ID3D11Device::CreateRasterizerState);
+}
+
+ID3D11BlendState* RenderDevice::GetBlendState(const D3D11_BLEND_DESC& desc)
+{
+    return getCachedState(Device, BlendStateCache, desc, &ID3D11Device::CreateBlendState);
+}
+
+ID3D11SamplerState* RenderDevice::GetSamplerState(const D3D11_SAMPLER_DESC& desc)
+{
+    return getCachedState(Device, SamplerStateCache, desc, &ID3D11Device::CreateSamplerState);
 }
 
 Texture* RenderDevice::GetDepthBuffer(int w, int h, int ms, TextureFormat depthFormat)
@@ -1007,6 +1250,8 @@ bool Buffer::Data(int use, const void *buffer, size_t size)
 {
     HRESULT hr;
 
+    Index32 = (use & Buffer_Index32) != 0;
+
     if (D3DBuffer && Size >= size)
     {
         if (Dynamic)
@@ -1025,7 +1270,7 @@ bool Buffer::Data(int use, const void *buffer, size_t size)
         else
         {
             OVR_ASSERT(!(use & Buffer_ReadOnly));
-            Ren->Context->UpdateSubresource(D3DBuffer, 0, NULL, buffer, 0, 0);
+            Ren->GetContext()->UpdateSubresource(D3DBuffer, 0, NULL, buffer, 0, 0);
             return true;
         }
     }
@@ -1127,7 +1372,7 @@ void* Buffer::Map(size_t start, size_t size, int flags)
         mapFlags = D3D11_MAP_WRITE_NO_OVERWRITE;
 
     D3D11_MAPPED_SUBRESOURCE map;
-    if (SUCCEEDED(Ren->Context->Map(D3DBuffer, 0, mapFlags, 0, &map)))
+    if (SUCCEEDED(Ren->GetContext()->Map(D3DBuffer, 0, mapFlags, 0, &map)))
         return ((char*)map.pData) + start;
     else
         return NULL;
@@ -1137,7 +1382,7 @@ bool Buffer::Unmap(void* m)
 {
     OVR_UNUSED(m);
 
-    Ren->Context->Unmap(D3DBuffer, 0);
+    Ren->GetContext()->Unmap(D3DBuffer, 0);
     return true;
 }
 
@@ -1165,39 +1410,177 @@ template<> bool Shader<Render::Shader_Geometry, ID3D11GeometryShader>::Load(void
 
 template<> void Shader<Render::Shader_Vertex, ID3D11VertexShader>::Set(PrimitiveType) const
 {
-    Ren->Context->VSSetShader(D3DShader, NULL, 0);
+    Ren->GetContext()->VSSetShader(D3DShader, NULL, 0);
 }
 template<> void Shader<Render::Shader_Pixel, ID3D11PixelShader>::Set(PrimitiveType) const
 {
-    Ren->Context->PSSetShader(D3DShader, NULL, 0);
+    Ren->GetContext()->PSSetShader(D3DShader, NULL, 0);
 }
 template<> void Shader<Render::Shader_Geometry, ID3D11GeometryShader>::Set(PrimitiveType) const
 {
-    Ren->Context->GSSetShader(D3DShader, NULL, 0);
+    Ren->GetContext()->GSSetShader(D3DShader, NULL, 0);
 }
 
 template<> void Shader<Render::Shader_Vertex, ID3D11VertexShader>::SetUniformBuffer(Render::Buffer* buffer, int i)
 {
-    Ren->Context->VSSetConstantBuffers(i, 1, &((Buffer*)buffer)->D3DBuffer.GetRawRef());
+    Ren->GetContext()->VSSetConstantBuffers(i, 1, &((Buffer*)buffer)->D3DBuffer.GetRawRef());
 }
 template<> void Shader<Render::Shader_Pixel, ID3D11PixelShader>::SetUniformBuffer(Render::Buffer* buffer, int i)
 {
-    Ren->Context->PSSetConstantBuffers(i, 1, &((Buffer*)buffer)->D3DBuffer.GetRawRef());
+    Ren->GetContext()->PSSetConstantBuffers(i, 1, &((Buffer*)buffer)->D3DBuffer.GetRawRef());
 }
 template<> void Shader<Render::Shader_Geometry, ID3D11GeometryShader>::SetUniformBuffer(Render::Buffer* buffer, int i)
 {
-    Ren->Context->GSSetConstantBuffers(i, 1, &((Buffer*)buffer)->D3DBuffer.GetRawRef());
+    Ren->GetContext()->GSSetConstantBuffers(i, 1, &((Buffer*)buffer)->D3DBuffer.GetRawRef());
+}
+
+//-------------------------------------------------------------------------------------
+// ***** Shader cache
+//
+// Compiled shaders are kept in %LOCALAPPDATA%\Oculus\ShaderCache, a file per shader, named by
+// a hash of everything the bytecode depends on: the source, entry point, profile, flags and
+// compiler version. A missing, stale or damaged file is just a miss, and is rewritten.
+// Files are written under a temporary name and renamed, so that a concurrent reader (another
+// worker or another process) never sees a partial one.
+
+static const uint32_t ShaderCacheMagic = 0x43535644; // "DVSC"
+
+struct ShaderCacheHeader
+{
+    uint32_t Magic;
+    uint32_t Size;      // Of the bytecode which follows
+    uint64_t Hash;      // The key, guarding against hash collisions in the file name
+};
+
+static uint64_t HashShaderBytes(uint64_t hash, const void* data, size_t size)
+{
+    // 64-bit FNV-1a
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static uint64_t HashShader(const char* profile, const char* src, const char* mainName, UINT flags)
+{
+    const UINT compilerVersion = D3D_COMPILER_VERSION;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    hash = HashShaderBytes(hash, profile, strlen(profile) + 1);
+    hash = HashShaderBytes(hash, mainName, strlen(mainName) + 1);
+    hash = HashShaderBytes(hash, &flags, sizeof(flags));
+    hash = HashShaderBytes(hash, &compilerVersion, sizeof(compilerVersion));
+    return HashShaderBytes(hash, src, strlen(src));
+}
+
+// Returns an empty string if there's nowhere to keep the cache.
+static std::wstring GetShaderCacheDirectory()
+{
+    wchar_t localAppData[MAX_PATH];
+    DWORD length = GetEnvironmentVariableW(L"LOCALAPPDATA", localAppData, MAX_PATH);
+    if ((length == 0) || (length >= MAX_PATH))
+        return std::wstring();
+
+    std::wstring directory = std::wstring(localAppData) + L"\\Oculus";
+    CreateDirectoryW(directory.c_str(), nullptr);   // Fails harmlessly if it already exists.
+    directory += L"\\ShaderCache";
+    CreateDirectoryW(directory.c_str(), nullptr);
+    return directory;
+}
+
+static const std::wstring& ShaderCacheDirectory()
+{
+    static const std::wstring directory = GetShaderCacheDirectory(); // Thread-safe in C++11
+    return directory;
+}
+
+static std::wstring ShaderCachePath(uint64_t hash)
+{
+    wchar_t name[32];
+    swprintf_s(name, L"\\%016llx.dxbc", (unsigned long long)hash);
+    return ShaderCacheDirectory() + name;
+}
+
+static ID3D10Blob* LoadCachedShader(uint64_t hash)
+{
+    if (ShaderCacheDirectory().empty())
+        return nullptr;
+
+    ScopedFileHANDLE file(CreateFileW(ShaderCachePath(hash).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+    if (!file.IsValid())
+        return nullptr;
+
+    ShaderCacheHeader header = {};
+    DWORD bytesRead = 0;
+    if (!ReadFile(file.Get(), &header, sizeof(header), &bytesRead, nullptr) || (bytesRead != sizeof(header)) ||
+        (header.Magic != ShaderCacheMagic) || (header.Hash != hash) || (header.Size == 0))
+        return nullptr;
+
+    Ptr<ID3D10Blob> shader;
+    if (FAILED(D3DCreateBlob(header.Size, &shader.GetRawRef())))
+        return nullptr;
+
+    // Device::Create*Shader validates the bytecode's own checksum, so a damaged file fails there.
+    if (!ReadFile(file.Get(), shader->GetBufferPointer(), header.Size, &bytesRead, nullptr) || (bytesRead != header.Size))
+        return nullptr;
+
+    shader->AddRef();
+    return shader;
+}
+
+static void StoreCachedShader(uint64_t hash, ID3D10Blob* shader)
+{
+    if (ShaderCacheDirectory().empty())
+        return;
+
+    const std::wstring path = ShaderCachePath(hash);
+    wchar_t suffix[32];
+    swprintf_s(suffix, L".%lu.tmp", GetCurrentThreadId());
+    const std::wstring tempPath = path + suffix;
+
+    {
+        ScopedFileHANDLE file(CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, nullptr,
+                                          CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr));
+        if (!file.IsValid())
+            return;
+
+        ShaderCacheHeader header = { ShaderCacheMagic, (uint32_t)shader->GetBufferSize(), hash };
+        DWORD bytesWritten = 0;
+        if (!WriteFile(file.Get(), &header, sizeof(header), &bytesWritten, nullptr) ||
+            !WriteFile(file.Get(), shader->GetBufferPointer(), header.Size, &bytesWritten, nullptr) ||
+            (bytesWritten != header.Size))
+        {
+            file.Close();
+            DeleteFileW(tempPath.c_str());
+            return;
+        }
+    }
+
+    if (!MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+        DeleteFileW(tempPath.c_str());
 }
 
+// Safe to call from several threads at once, as Init does.
 ID3D10Blob* RenderDevice::CompileShader(const char* profile, const char* src, const char* mainName)
 {
+    const UINT flags = D3DCOMPILE_DEBUG;
+    const uint64_t hash = HashShader(profile, src, mainName, flags);
+
+    if (ID3D10Blob* cached = LoadCachedShader(hash))
+        return cached;
+
     Ptr<ID3D10Blob> shader;
     Ptr<ID3D10Blob> errors;
     HRESULT hr = D3DCompile(src, strlen(src), NULL, NULL, NULL, mainName, profile,
-        D3DCOMPILE_DEBUG, 0, &shader.GetRawRef(), &errors.GetRawRef());
+        flags, 0, &shader.GetRawRef(), &errors.GetRawRef());
     LogD3DCompileError(hr, errors);
     OVR_D3D_CHECK_RET_NULL(hr);
 
+    StoreCachedShader(hash, shader);
+
     shader->AddRef();
     return shader;
 }
@@ -1350,8 +1733,6 @@ Fill* RenderDevice::GetTextureFill(Render::Texture* t, bool useAlpha, bool usePr
 
 ID3D11SamplerState* RenderDevice::GetSamplerState(int sm)
 {
-    HRESULT hr;
-
     if (SamplerStates[sm])
         return SamplerStates[sm];
 
@@ -1378,8 +1759,7 @@ ID3D11SamplerState* RenderDevice::GetSamplerState(int sm)
         ss.Filter = D3D11_FILTER_MIN_MAG_MIP_LINEAR;
     }
     ss.MaxLOD = 15;
-    hr = Device->CreateSamplerState(&ss, &SamplerStates[sm].GetRawRef());
-    OVR_D3D_CHECK_RET_NULL(hr);
+    SamplerStates[sm] = GetSamplerState(ss);
     return SamplerStates[sm];
 }
 
@@ -1495,33 +1875,37 @@ void Texture::Update(void* data, uint32_t height, uint32_t stride)
 
 void RenderDevice::SetTexture(Render::ShaderStage stage, int slot, const Texture* t)
 {
-    if (MaxTextureSet[stage] <= slot)
+    // Executing a command list restores the immediate context's bindings, so textures set while
+    // recording never need unbinding from it.
+    if (!CurrentRecorder && (MaxTextureSet[stage] <= slot))
         MaxTextureSet[stage] = slot + 1;
 
+    ID3D11DeviceContext* context = GetContext();
+
     ID3D11ShaderResourceView* sv = t ? t->GetSv() : NULL;
     switch (stage)
     {
     case Shader_Pixel:
-        Context->PSSetShaderResources(slot, 1, &sv);
+        context->PSSetShaderResources(slot, 1, &sv);
         if (t)
         {
-            Context->PSSetSamplers(slot, 1, &t->Sampler.GetRawRef());
+            context->PSSetSamplers(slot, 1, &t->Sampler.GetRawRef());
         }
         break;
 
     case Shader_Vertex:
-        Context->VSSetShaderResources(slot, 1, &sv);
+        context->VSSetShaderResources(slot, 1, &sv);
         if (t)
         {
-            Context->VSSetSamplers(slot, 1, &t->Sampler.GetRawRef());
+            context->VSSetSamplers(slot, 1, &t->Sampler.GetRawRef());
         }
         break;
 
     case Shader_Compute:
-        Context->CSSetShaderResources(slot, 1, &sv);
+        context->CSSetShaderResources(slot, 1, &sv);
         if (t)
         {
-            Context->CSSetSamplers(slot, 1, &t->Sampler.GetRawRef());
+            context->CSSetSamplers(slot, 1, &t->Sampler.GetRawRef());
         }
         break;
 
@@ -1774,6 +2158,15 @@ std::tuple<unsigned int, const void*> RenderDevice::GenerateSubresourceData(
     case DXGI_FORMAT_BC3_UNORM_SRGB: // fall thru
     case DXGI_FORMAT_BC3_UNORM: bytesPerBlock = 16;  break;
 
+    case DXGI_FORMAT_BC4_UNORM: // fall thru
+    case DXGI_FORMAT_BC4_SNORM: bytesPerBlock = 8;  break;
+
+    case DXGI_FORMAT_BC5_UNORM: // fall thru
+    case DXGI_FORMAT_BC5_SNORM: bytesPerBlock = 16;  break;
+
+    case DXGI_FORMAT_BC6H_UF16: // fall thru
+    case DXGI_FORMAT_BC6H_SF16: bytesPerBlock = 16;  break;
+
     case DXGI_FORMAT_BC7_UNORM_SRGB: // fall thru
     case DXGI_FORMAT_BC7_UNORM: bytesPerBlock = 16;  break;
 
@@ -1923,6 +2316,22 @@ Texture* RenderDevice::CreateTexture(uint64_t format, int width, int height, con
         {
             convertedFormat = (format & Texture_SRGB) ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
         }
+        else if (textureFormat == Texture_BC4U)
+        {
+            convertedFormat = DXGI_FORMAT_BC4_UNORM;
+        }
+        else if (textureFormat == Texture_BC4S)
+        {
+            convertedFormat = DXGI_FORMAT_BC4_SNORM;
+        }
+        else if (textureFormat == Texture_BC5U)
+        {
+            convertedFormat = DXGI_FORMAT_BC5_UNORM;
+        }
+        else if (textureFormat == Texture_BC5S)
+        {
+            convertedFormat = DXGI_FORMAT_BC5_SNORM;
+        }
         else
         {
             OVR_ASSERT(false);  return NULL;
@@ -2084,6 +2493,21 @@ Texture* RenderDevice::CreateTexture(uint64_t format, int width, int height, con
             isCompressed = true;
             break;
 
+        // The SDK has no swap chain formats for these, so they work only as plain textures.
+        case Texture_BC4U:
+        case Texture_BC4S:
+        case Texture_BC5U:
+        case Texture_BC5S:
+            bpp = 1;
+            ovrFormat = OVR_FORMAT_UNKNOWN;
+            if (textureFormat == Texture_BC4U)      d3dformat = DXGI_FORMAT_BC4_UNORM;
+            else if (textureFormat == Texture_BC4S) d3dformat = DXGI_FORMAT_BC4_SNORM;
+            else if (textureFormat == Texture_BC5U) d3dformat = DXGI_FORMAT_BC5_UNORM;
+            else                                    d3dformat = DXGI_FORMAT_BC5_SNORM;
+            srvFormat = d3dformat;
+            isCompressed = true;
+            break;
+
         case Texture_RGBA16f:
             bpp = 8;
             ovrFormat = OVR_FORMAT_R16G16B16A16_FLOAT;
@@ -2174,6 +2598,15 @@ Texture* RenderDevice::CreateTexture(uint64_t format, int width, int height, con
 
         bool isDynamic = (format & Texture_CpuDynamic) != 0;
 
+        // Generate mips on the GPU where the format allows it, rather than filtering them here.
+        bool gpuGenMips = false;
+        if ((format & Texture_GenMipmaps) && !isCompressed && !isDepth && !isDynamic && samples == 1)
+        {
+            UINT formatSupport = 0;
+            gpuGenMips = SUCCEEDED(Device->CheckFormatSupport(d3dformat, &formatSupport)) &&
+                         (formatSupport & D3D11_FORMAT_SUPPORT_MIP_AUTOGEN);
+        }
+
         dsDesc.ArraySize = 1;
         dsDesc.Format = d3dformat;
         dsDesc.SampleDesc.Count = samples;
@@ -2324,6 +2757,12 @@ Texture* RenderDevice::CreateTexture(uint64_t format, int width, int height, con
         }
         else
         {
+            if (gpuGenMips)
+            {
+                dsDesc.BindFlags |= D3D11_BIND_RENDER_TARGET;   // D3D11_RESOURCE_MISC_GENERATE_MIPS requires it
+                dsDesc.MiscFlags |= D3D11_RESOURCE_MISC_GENERATE_MIPS;
+            }
+
             NewTex->Tex = NULL;
             hr = Device->CreateTexture2D(&dsDesc, nullptr, &NewTex->Tex.GetRawRef());
             OVR_D3D_CHECK_RET_NULL(hr);
@@ -2418,6 +2857,22 @@ Texture* RenderDevice::CreateTexture(uint64_t format, int width, int height, con
                     {
                         convertedFormat = (format & Texture_SRGB) ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
                     }
+                    else if (textureFormat == Texture_BC4U)
+                    {
+                        convertedFormat = DXGI_FORMAT_BC4_UNORM;
+                    }
+                    else if (textureFormat == Texture_BC4S)
+                    {
+                        convertedFormat = DXGI_FORMAT_BC4_SNORM;
+                    }
+                    else if (textureFormat == Texture_BC5U)
+                    {
+                        convertedFormat = DXGI_FORMAT_BC5_UNORM;
+                    }
+                    else if (textureFormat == Texture_BC5S)
+                    {
+                        convertedFormat = DXGI_FORMAT_BC5_SNORM;
+                    }
                     else
                     {
                         OVR_ASSERT(false);  return NULL;
@@ -2464,9 +2919,12 @@ Texture* RenderDevice::CreateTexture(uint64_t format, int width, int height, con
                         byteData += (width * height * bpp);
                     }
                   
-                    if (format & Texture_GenMipmaps)
+                    if ((format & Texture_GenMipmaps) && gpuGenMips)
+                    {
+                        Context->GenerateMips(NewTex->TexSv.back());
+                    }
+                    else if (format & Texture_GenMipmaps)
                     {
-                        // TODO: Just call GenerateMips() instead
                         OVR_ASSERT((textureFormat) == Texture_RGBA);
                         int srcw = width, srch = height;
                         int level = 0;
@@ -2570,24 +3028,103 @@ Texture* RenderDevice::CreateTexture(uint64_t format, int width, int height, con
     }
 }
 
-// Rendering
-
-void RenderDevice::ResolveMsaa(OVR::Render::Texture* msaaTex, OVR::Render::Texture* outputTex)
+Texture* RenderDevice::CreateTextureArray(const std::vector<Render::Texture*>& slices)
 {
-    uint64_t format = ((Texture*)msaaTex)->Format;
-    OVR_ASSERT_M(!(format & Texture_DepthMask), "Resolving depth buffers not supported.");
-
-    TextureFormat textureFormat = (TextureFormat)(format & Texture_TypeMask);
+    if (slices.empty())
+    {
+        return NULL;
+    }
 
-    DXGI_FORMAT resolveFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
-    switch (textureFormat & Texture_TypeMask)
+    // Only plain shader resources can be copied into the array, and all in the same layout.
+    const Texture* first = (const Texture*)slices[0];
+    if (!first->Tex || first->TextureChain || first->TexSv.empty() ||
+        (first->Format & (Texture_Cubemap | Texture_Array | Texture_RenderTarget | Texture_DepthMask)))
     {
-    case Texture_B5G6R5:    resolveFormat = DXGI_FORMAT_B5G6R5_UNORM; break;
-    case Texture_BGR5A1:    resolveFormat = DXGI_FORMAT_B5G5R5A1_UNORM; break;
-    case Texture_BGRA4:     resolveFormat = DXGI_FORMAT_B4G4R4A4_UNORM; break;
-    case Texture_RGBA8:     resolveFormat = format & Texture_SRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM; break;
-    case Texture_BGRA8:     resolveFormat = format & Texture_SRGB ? DXGI_FORMAT_B8G8R8A8_UNORM_SRGB : DXGI_FORMAT_B8G8R8A8_UNORM; break;
-    case Texture_BGRX:      resolveFormat = format & Texture_SRGB ? DXGI_FORMAT_B8G8R8X8_UNORM_SRGB : DXGI_FORMAT_B8G8R8X8_UNORM; break;
+        return NULL;
+    }
+    D3D11_TEXTURE2D_DESC desc;
+    first->Tex->GetDesc(&desc);
+    if (desc.ArraySize != 1 || desc.SampleDesc.Count != 1 || slices.size() > D3D11_REQ_TEXTURE2D_ARRAY_AXIS_DIMENSION)
+    {
+        return NULL;
+    }
+    for (size_t i = 1; i < slices.size(); i++)
+    {
+        const Texture* slice = (const Texture*)slices[i];
+        if (!slice->Tex || slice->TextureChain || slice->Format != first->Format)
+        {
+            return NULL;
+        }
+        D3D11_TEXTURE2D_DESC sliceDesc;
+        slice->Tex->GetDesc(&sliceDesc);
+        if (sliceDesc.Width != desc.Width || sliceDesc.Height != desc.Height ||
+            sliceDesc.MipLevels != desc.MipLevels || sliceDesc.Format != desc.Format ||
+            sliceDesc.ArraySize != 1)
+        {
+            return NULL;
+        }
+    }
+
+    desc.ArraySize      = (UINT)slices.size();
+    desc.Usage          = D3D11_USAGE_DEFAULT;
+    desc.BindFlags      = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = 0;
+    desc.MiscFlags      = 0;
+
+    // The array holds the mips it was copied from, and has none to generate.
+    const uint64_t format = (first->Format & ~(uint64_t)Texture_GenMipmaps) | Texture_Array;
+    Ptr<Texture> NewTex = *new Texture(Session, this, format, first->Width, first->Height);
+    NewTex->Samples = 1;
+    HRESULT hr = Device->CreateTexture2D(&desc, NULL, &NewTex->Tex.GetRawRef());
+    OVR_D3D_CHECK_RET_NULL(hr);
+
+    for (size_t i = 0; i < slices.size(); i++)
+    {
+        const Texture* slice = (const Texture*)slices[i];
+        for (UINT mip = 0; mip < desc.MipLevels; mip++)
+        {
+            Context->CopySubresourceRegion(NewTex->Tex, D3D11CalcSubresource(mip, (UINT)i, desc.MipLevels), 0, 0, 0,
+                                           slice->Tex, D3D11CalcSubresource(mip, 0, desc.MipLevels), NULL);
+        }
+    }
+
+    // View the slices with the same format the first texture is sampled through.
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvd;
+    first->TexSv[0]->GetDesc(&srvd);
+    srvd.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+    srvd.Texture2DArray.MostDetailedMip = 0;
+    srvd.Texture2DArray.MipLevels       = desc.MipLevels;
+    srvd.Texture2DArray.FirstArraySlice = 0;
+    srvd.Texture2DArray.ArraySize       = desc.ArraySize;
+
+    Ptr<ID3D11ShaderResourceView> srv;
+    hr = Device->CreateShaderResourceView(NewTex->Tex, &srvd, &srv.GetRawRef());
+    OVR_D3D_CHECK_RET_NULL(hr);
+    NewTex->TexSv.push_back(srv);
+    NewTex->Sampler = first->Sampler;
+
+    NewTex->AddRef();
+    return NewTex;
+}
+
+// Rendering
+
+void RenderDevice::ResolveMsaa(OVR::Render::Texture* msaaTex, OVR::Render::Texture* outputTex)
+{
+    uint64_t format = ((Texture*)msaaTex)->Format;
+    OVR_ASSERT_M(!(format & Texture_DepthMask), "Resolving depth buffers not supported.");
+
+    TextureFormat textureFormat = (TextureFormat)(format & Texture_TypeMask);
+
+    DXGI_FORMAT resolveFormat = DXGI_FORMAT_R8G8B8A8_UNORM;
+    switch (textureFormat & Texture_TypeMask)
+    {
+    case Texture_B5G6R5:    resolveFormat = DXGI_FORMAT_B5G6R5_UNORM; break;
+    case Texture_BGR5A1:    resolveFormat = DXGI_FORMAT_B5G5R5A1_UNORM; break;
+    case Texture_BGRA4:     resolveFormat = DXGI_FORMAT_B4G4R4A4_UNORM; break;
+    case Texture_RGBA8:     resolveFormat = format & Texture_SRGB ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM; break;
+    case Texture_BGRA8:     resolveFormat = format & Texture_SRGB ? DXGI_FORMAT_B8G8R8A8_UNORM_SRGB : DXGI_FORMAT_B8G8R8A8_UNORM; break;
+    case Texture_BGRX:      resolveFormat = format & Texture_SRGB ? DXGI_FORMAT_B8G8R8X8_UNORM_SRGB : DXGI_FORMAT_B8G8R8X8_UNORM; break;
     case Texture_RGBA16f:   resolveFormat = DXGI_FORMAT_R16G16B16A16_FLOAT; break;
     case Texture_R11G11B10f: resolveFormat = DXGI_FORMAT_R11G11B10_FLOAT; break;
     default:    OVR_FAIL(); break;
@@ -2625,6 +3162,23 @@ void RenderDevice::SetCullMode(CullMode cullMode)
     ActiveCullMode = cullMode;
 }
 
+void RenderDevice::SetColorWrite(bool enabled)
+{
+    if (!enabled && !BlendStateNoColorWrite)
+    {
+        D3D11_BLEND_DESC bm;
+        memset(&bm, 0, sizeof(bm));
+        bm.RenderTarget[0].BlendOp = bm.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+        bm.RenderTarget[0].SrcBlend = bm.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+        bm.RenderTarget[0].DestBlend = bm.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
+        bm.RenderTarget[0].RenderTargetWriteMask = 0;
+        BlendStateNoColorWrite = GetBlendState(bm);
+    }
+
+    // The scene draws with the default blend state, which is what enabling goes back to.
+    Context->OMSetBlendState(enabled ? NULL : BlendStateNoColorWrite.GetPtr(), NULL, 0xffffffff);
+}
+
 void RenderDevice::BeginRendering()
 {
     SetCullMode(RenderDevice::Cull_Back);
@@ -2713,17 +3267,51 @@ void RenderDevice::BltFlipCubemap(Render::Texture* /* src */, Render::Texture* /
 
 void RenderDevice::Render(const Matrix4f& matrix, Model* model) 
 {
+    const bool split     = (model->Layout == VertexLayout_Split);
+    const bool quantized = (model->Layout == VertexLayout_Quantized);
+
     // Store data in buffers if not already
     if (!model->VertexBuffer)
     {
         if (model->Vertices.size() > 0)
         {
-            Ptr<Buffer> vb = *CreateBuffer();
-            if (!vb->Data(Buffer_Vertex | Buffer_ReadOnly, &model->Vertices[0], model->Vertices.size() * sizeof(Vertex)))
+            if (quantized)
             {
-              OVR_ASSERT(false);
+                std::vector<QuantizedVertex> vertices;
+                model->QuantizeVertices(vertices);
+
+                Ptr<Buffer> vb = *CreateBuffer();
+                if (!vb->Data(Buffer_Vertex | Buffer_ReadOnly, &vertices[0], vertices.size() * sizeof(QuantizedVertex)))
+                {
+                  OVR_ASSERT(false);
+                }
+                model->VertexBuffer = vb;
+            }
+            else if (split)
+            {
+                std::vector<Vector3f> positions;
+                std::vector<VertexAttributes> attributes;
+                model->GetSplitVertexStreams(positions, attributes);
+
+                Ptr<Buffer> pb = *CreateBuffer();
+                Ptr<Buffer> ab = *CreateBuffer();
+                if (!pb->Data(Buffer_Vertex | Buffer_ReadOnly, &positions[0], positions.size() * sizeof(Vector3f)) ||
+                    !ab->Data(Buffer_Vertex | Buffer_ReadOnly, &attributes[0], attributes.size() * sizeof(VertexAttributes)))
+                {
+                  OVR_ASSERT(false);
+                }
+                model->VertexBuffer = pb;
+                model->AttributeBuffer = ab;
+            }
+            else
+            {
+                Ptr<Buffer> vb = *CreateBuffer();
+                if (!vb->Data(Buffer_Vertex | Buffer_ReadOnly, &model->Vertices[0], model->Vertices.size() * sizeof(Vertex)))
+                {
+                  OVR_ASSERT(false);
+                }
+                model->VertexBuffer = vb;
             }
-            model->VertexBuffer = vb;
         }
     }
     if (!model->IndexBuffer)
@@ -2731,7 +3319,7 @@ void RenderDevice::Render(const Matrix4f& matrix, Model* model)
         if (model->Indices.size() > 0)
         {
             Ptr<Buffer> ib = *CreateBuffer();
-            if (!ib->Data(Buffer_Index | Buffer_ReadOnly, &model->Indices[0], model->Indices.size() * 2))
+            if (!model->SetIndexBufferData(ib))
             {
               OVR_ASSERT(false);
             }
@@ -2741,9 +3329,24 @@ void RenderDevice::Render(const Matrix4f& matrix, Model* model)
 
     if (model->VertexBuffer && model->IndexBuffer)
     {
-        Render(model->Fill ? model->Fill : DefaultFill,
-          model->VertexBuffer, model->IndexBuffer,
-          matrix, 0, (unsigned)model->Indices.size(), model->GetPrimType());
+        if (split)
+        {
+            RenderSplit(model->Fill ? model->Fill : DefaultFill,
+              model->VertexBuffer, model->AttributeBuffer, model->IndexBuffer,
+              matrix, 0, (unsigned)model->Indices.size(), model->GetPrimType());
+        }
+        else if (quantized)
+        {
+            RenderQuantized(model->Fill ? model->Fill : DefaultFill,
+              model->VertexBuffer, model->IndexBuffer,
+              matrix * model->GetDequantizeMatrix(), 0, (unsigned)model->Indices.size(), model->GetPrimType());
+        }
+        else
+        {
+            Render(model->Fill ? model->Fill : DefaultFill,
+              model->VertexBuffer, model->IndexBuffer,
+              matrix, 0, (unsigned)model->Indices.size(), model->GetPrimType());
+        }
     }
 }
 
@@ -2767,22 +3370,118 @@ void RenderDevice::Render(const Fill* fill, Render::Buffer* vertices, Render::Bu
     ID3D11Buffer* vertexBuffer = ((Buffer*)vertices)->GetBuffer();
     UINT vertexOffset = offset;
     UINT vertexStride = sizeof(Vertex);
-    Context->IASetInputLayout(ModelVertexIL);
+    GetContext()->IASetInputLayout(ModelVertexIL);
     vertexStride = sizeof(Vertex);
 
-    Context->IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
+    GetContext()->IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
+
+    DrawBound(fill, indices, matrix, count, rprim);
+}
+
+void RenderDevice::RenderSplit(const Fill* fill, Render::Buffer* positions, Render::Buffer* attributes,
+    Render::Buffer* indices, const Matrix4f& matrix, int firstVertex, int count, PrimitiveType rprim)
+{
+    // An empty slot reads as zero, so positions alone are all that's fetched without attributes.
+    ID3D11Buffer* vertexBuffers[2] = { ((Buffer*)positions)->GetBuffer(),
+                                       attributes ? ((Buffer*)attributes)->GetBuffer() : nullptr };
+    UINT vertexStrides[2] = { sizeof(Vector3f), sizeof(VertexAttributes) };
+    UINT vertexOffsets[2] = { firstVertex * vertexStrides[0], firstVertex * vertexStrides[1] };
+    GetContext()->IASetInputLayout(ModelSplitVertexIL);
+
+    GetContext()->IASetVertexBuffers(0, 2, vertexBuffers, vertexStrides, vertexOffsets);
+
+    DrawBound(fill, indices, matrix, count, rprim);
+}
+
+void RenderDevice::RenderQuantized(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
+    const Matrix4f& matrix, int firstVertex, int count, PrimitiveType rprim)
+{
+    ID3D11Buffer* vertexBuffer = ((Buffer*)vertices)->GetBuffer();
+    UINT vertexStride = sizeof(QuantizedVertex);
+    UINT vertexOffset = firstVertex * vertexStride;
+    GetContext()->IASetInputLayout(ModelQuantizedVertexIL);
+
+    GetContext()->IASetVertexBuffers(0, 1, &vertexBuffer, &vertexStride, &vertexOffset);
+
+    DrawBound(fill, indices, matrix, count, rprim);
+}
+
+bool RenderDevice::CanRenderStereo(const Fill* fill)
+{
+    // MVPStereo replaces only the standard MVP vertex shader.
+    ShaderSet* shaders = ((ShaderFill*)fill)->GetShaders();
+    return VertexShaders[VShader_MVPStereo] && !MultiresActive &&
+           (shaders->GetShader(Shader_Vertex) == VertexShaders[VShader_MVP].GetPtr()) &&
+           !shaders->GetShader(Shader_Geometry) && !ExtraShaders;
+}
+
+bool RenderDevice::RenderInstances(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
+    Render::Buffer* instances, const Matrix4f& matrix, int count, int instanceCount, PrimitiveType rprim)
+{
+    // MVPInstanced replaces only the standard MVP vertex shader; a geometry shader or ExtraShaders
+    // would expect the fill's own.
+    ShaderSet* shaders = ((ShaderFill*)fill)->GetShaders();
+    if (!ModelInstancedVertexIL || !VertexShaders[VShader_MVPInstanced] ||
+        (shaders->GetShader(Shader_Vertex) != VertexShaders[VShader_MVP].GetPtr()) ||
+        shaders->GetShader(Shader_Geometry) || ExtraShaders)
+    {
+        return false;
+    }
+
+    ID3D11Buffer* vertexBuffers[2] = { ((Buffer*)vertices)->GetBuffer(), ((Buffer*)instances)->GetBuffer() };
+    UINT vertexStrides[2] = { sizeof(Vertex), 3 * sizeof(Vector4f) };
+    UINT vertexOffsets[2] = { 0, 0 };
+    GetContext()->IASetInputLayout(ModelInstancedVertexIL);
+
+    GetContext()->IASetVertexBuffers(0, 2, vertexBuffers, vertexStrides, vertexOffsets);
+
+    DrawBound(fill, indices, matrix, count, rprim, instanceCount);
+    return true;
+}
+
+void RenderDevice::DrawBound(const Fill* fill, Render::Buffer* indices, const Matrix4f& matrix, int count,
+    PrimitiveType rprim, int instanceCount)
+{
+    DeferredRecorder* recorder = CurrentRecorder;
+    ID3D11DeviceContext* context = GetContext();
+    Ptr<Buffer>* uniformBuffers = recorder ? recorder->UniformBuffers : UniformBuffers;
 
     if (indices)
     {
-        Context->IASetIndexBuffer(((Buffer*)indices)->GetBuffer(), DXGI_FORMAT_R16_UINT, 0);
+        context->IASetIndexBuffer(((Buffer*)indices)->GetBuffer(),
+                                  indices->Is32BitIndex() ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT, 0);
     }
 
     ShaderSet* shaders = ((ShaderFill*)fill)->GetShaders();
 
-    ShaderBase* vshader = ((ShaderBase*)shaders->GetShader(Shader_Vertex));
+    context->VSSetConstantBuffers(2, 1, &LateLatchBound);
+
+    // During a stereo pass, RenderModel only lets through fills which CanRenderStereo.
+    const bool stereo = StereoPassActive && (instanceCount == 0);
+    OVR_ASSERT(!stereo || CanRenderStereo(fill));
+
+    ShaderBase* vshader = (instanceCount > 0) ? (ShaderBase*)VertexShaders[VShader_MVPInstanced].GetPtr()
+                        : stereo              ? (ShaderBase*)VertexShaders[VShader_MVPStereo].GetPtr()
+                                              : (ShaderBase*)shaders->GetShader(Shader_Vertex);
+    // The octilinear GS takes the MVP vertex shaders' varyings, and only triangles.
+    ShaderBase* multiresShader = nullptr;
+    if (MultiresActive && !shaders->GetShader(Shader_Geometry) &&
+        ((rprim == Prim_Triangles) || (rprim == Prim_TriangleStrip)) &&
+        ((vshader == VertexShaders[VShader_MVP].GetPtr()) || (vshader == VertexShaders[VShader_MVPInstanced].GetPtr())))
+    {
+        multiresShader = GeometryShaders[GShader_OctilinearEmulated].GetPtr();
+    }
+
     unsigned char* vertexData = vshader->UniformData;
     if (vertexData != NULL)
     {
+        if (recorder)
+        {
+            // Other slices patch the same shader's uniforms at the same time.
+            recorder->VertexUniforms.assign(vertexData, vertexData + vshader->UniformsSize);
+            vertexData = recorder->VertexUniforms.data();
+        }
+
         // TODO: some VSes don't start with StandardUniformData!
         if (vshader->UniformsSize >= sizeof(StandardUniformData))
         {
@@ -2791,17 +3490,31 @@ void RenderDevice::Render(const Fill* fill, Render::Buffer* vertices, Render::Bu
             stdUniforms->Proj = StdUniforms.Proj;
             stdUniforms->GlobalTint = StdUniforms.GlobalTint;
         }
+        if (stereo && (vshader->UniformsSize >= sizeof(StereoUniformData)))
+        {
+            StereoUniformData* stereoUniforms = (StereoUniformData*)vertexData;
+            for (int eye = 0; eye < 2; eye++)
+            {
+                stereoUniforms->EyeProj[eye] = StereoClipFromLeft[eye].Transposed();
+                stereoUniforms->EyeClipPlane[eye] = StereoClipPlanes[eye];
+            }
+        }
 
-        if (!UniformBuffers[Shader_Vertex]->Data(Buffer_Uniform, vertexData, vshader->UniformsSize))
+        // The ring is mapped on the immediate context only.
+        if (recorder || !UploadRingUniforms(Shader_Vertex, vertexData, vshader->UniformsSize))
         {
-            OVR_ASSERT(false);
+            if (!uniformBuffers[Shader_Vertex]->Data(Buffer_Uniform, vertexData, vshader->UniformsSize))
+            {
+                OVR_ASSERT(false);
+            }
+            vshader->SetUniformBuffer(uniformBuffers[Shader_Vertex]);
         }
-        vshader->SetUniformBuffer(UniformBuffers[Shader_Vertex]);
     }
 
     for (int i = Shader_Vertex + 1; i < Shader_Count; i++)
     {
-        if (shaders->GetShader(i))
+        ShaderBase* shader = (ShaderBase*)shaders->GetShader(i);
+        if (shader)
         {
             if (i != Shader_Geometry)
             {
@@ -2810,9 +3523,17 @@ void RenderDevice::Render(const Fill* fill, Render::Buffer* vertices, Render::Bu
                 // we don't want to call UpdateBuffer here. If we have other use
                 // cases for geometry shaders emerge look into making this
                 // mechanism more generic.
-                ((ShaderBase*)shaders->GetShader(i))->UpdateBuffer(UniformBuffers[i]);
+                if (!recorder && UploadRingUniforms((ShaderStage)i, shader->UniformData, shader->UniformsSize))
+                {
+                    continue;
+                }
+                shader->UpdateBuffer(uniformBuffers[i]);
+                shader->SetUniformBuffer(uniformBuffers[i]);
+            }
+            else
+            {
+                shader->SetUniformBuffer(UniformBuffers[i]);
             }
-            ((ShaderBase*)shaders->GetShader(i))->SetUniformBuffer(UniformBuffers[i]);
         }
     }
 
@@ -2832,21 +3553,83 @@ void RenderDevice::Render(const Fill* fill, Render::Buffer* vertices, Render::Bu
         OVR_ASSERT(0);
         return;
     }
-    Context->IASetPrimitiveTopology(prim);
+    context->IASetPrimitiveTopology(prim);
 
-    fill->Set(rprim);
+    // Each recorder batches fills over its own slice of draws.
+    bool setFill;
+    if (recorder)
+    {
+        setFill = (fill != recorder->BatchedFill) || (rprim != recorder->BatchedFillPrim);
+        recorder->BatchedFill = fill;
+        recorder->BatchedFillPrim = rprim;
+    }
+    else
+    {
+        setFill = needsFillSet(fill, rprim);
+    }
+
+    // A geometry shader is unbound after each draw, so its fill must be set every time.
+    if (setFill || ExtraShaders || shaders->GetShader(Shader_Geometry))
+    {
+        fill->Set(rprim);
+    }
     if (ExtraShaders)
     {
         ExtraShaders->Set(rprim);
     }
+    if (instanceCount > 0)
+    {
+        // The next draw with this fill has to restore its vertex shader.
+        vshader->Set(rprim);
+        if (recorder)
+        {
+            recorder->BatchedFill = nullptr;
+        }
+        else
+        {
+            BatchedFill = nullptr;
+        }
+    }
+    else if (stereo)
+    {
+        // Every draw in a stereo pass uses MVPStereo, so it can stay set with a batched fill.
+        vshader->Set(rprim);
+    }
+    if (multiresShader)
+    {
+        multiresShader->Set(rprim);
+        multiresShader->SetUniformBuffer(UniformBuffers[Shader_Geometry]);
+    }
 
-    if (indices)
+    if (stereo)
+    {
+        if (indices)
+        {
+            context->DrawIndexedInstanced(count, 2, 0, 0, 0);
+        }
+        else
+        {
+            context->DrawInstanced(count, 2, 0, 0);
+        }
+    }
+    else if (instanceCount > 0)
+    {
+        if (indices)
+        {
+            context->DrawIndexedInstanced(count, instanceCount, 0, 0, 0);
+        }
+        else
+        {
+            context->DrawInstanced(count, instanceCount, 0, 0);
+        }
+    }
+    else if (indices)
     {
-        Context->DrawIndexed(count, 0, 0);
+        context->DrawIndexed(count, 0, 0);
     }
     else
     {
-        Context->Draw(count, 0);
+        context->Draw(count, 0);
     }
 
     // Disable geometry shader in case we set it above. This isn't ideal but
@@ -2854,9 +3637,9 @@ void RenderDevice::Render(const Fill* fill, Render::Buffer* vertices, Render::Bu
     // could try and disable the shader if it's not part of the shader set, but
     // the abstraction depends on having a valid pointer to a shader so we have
     // no good way calling back into the rendering API (D3D11/D3D12/OpenGL).
-    if (shaders->GetShader(Shader_Geometry))
+    if (shaders->GetShader(Shader_Geometry) || multiresShader)
     {
-        Context->GSSetShader(nullptr, nullptr, 0);
+        context->GSSetShader(nullptr, nullptr, 0);
     }
 }
 
@@ -2879,6 +3662,372 @@ size_t RenderDevice::QueryGPUMemorySize()
     return adapterDesc.DedicatedVideoMemory;
 }
 
+void RenderDevice::CreateUniformRing()
+{
+    // Binding by offset needs the D3D11.1 runtime as well as driver support for both
+    // offsetting and NO_OVERWRITE maps of constant buffers.
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+    if (FAILED(Device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) ||
+        !options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer)
+    {
+        return;
+    }
+    if (FAILED(Context->QueryInterface(IID_PPV_ARGS(&Context1.GetRawRef()))))
+    {
+        return;
+    }
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.ByteWidth      = 4 * 1024 * 1024;
+    desc.Usage          = D3D11_USAGE_DYNAMIC;
+    desc.BindFlags      = D3D11_BIND_CONSTANT_BUFFER;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    HRESULT hr = Device->CreateBuffer(&desc, NULL, &UniformRing.GetRawRef());
+    if (FAILED(hr))
+    {
+        Context1.Clear();
+        return;
+    }
+
+    UniformRingSize = desc.ByteWidth;
+    // Start full so the first upload maps with DISCARD.
+    UniformRingOffset = UniformRingSize;
+}
+
+bool RenderDevice::UploadRingUniforms(ShaderStage stage, const void* data, int size)
+{
+    if (!UniformRing || (size <= 0))
+    {
+        return false;
+    }
+
+    // Offsets and sizes are counted in 16-byte constants and must be multiples of 16
+    // constants, so each allocation is rounded up to 256 bytes.
+    const UINT allocSize = (UINT(size) + 255) & ~255u;
+    if (allocSize > UniformRingSize)
+    {
+        return false;
+    }
+
+    D3D11_MAP mapType = D3D11_MAP_WRITE_NO_OVERWRITE;
+    if (UniformRingOffset + allocSize > UniformRingSize)
+    {
+        mapType = D3D11_MAP_WRITE_DISCARD;
+        UniformRingOffset = 0;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(Context->Map(UniformRing, 0, mapType, 0, &mapped)))
+    {
+        return false;
+    }
+    memcpy((unsigned char*)mapped.pData + UniformRingOffset, data, size);
+    Context->Unmap(UniformRing, 0);
+
+    UINT firstConstant = UniformRingOffset / 16;
+    UINT numConstants = allocSize / 16;
+    UniformRingOffset += allocSize;
+
+    ID3D11Buffer* buffer = UniformRing;
+    switch (stage)
+    {
+    case Shader_Vertex:
+        Context1->VSSetConstantBuffers1(0, 1, &buffer, &firstConstant, &numConstants);
+        break;
+    case Shader_Geometry:
+        Context1->GSSetConstantBuffers1(0, 1, &buffer, &firstConstant, &numConstants);
+        break;
+    case Shader_Fragment:
+        Context1->PSSetConstantBuffers1(0, 1, &buffer, &firstConstant, &numConstants);
+        break;
+    default:
+        OVR_ASSERT(false);
+        return false;
+    }
+    return true;
+}
+
+void RenderDevice::CreateLateLatchBuffers()
+{
+    const Matrix4f identity;
+
+    D3D11_BUFFER_DESC desc = {};
+    desc.ByteWidth = sizeof(Matrix4f);
+    desc.Usage     = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    D3D11_SUBRESOURCE_DATA data = {};
+    data.pSysMem = &identity;
+    HRESULT hr = Device->CreateBuffer(&desc, &data, &LateLatchIdentity.GetRawRef());
+    OVR_D3D_CHECK_RET(hr);
+    LateLatchBound = LateLatchIdentity;
+
+    // Without NO_OVERWRITE, a map after the draws would give them the memory of their own.
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+    if (FAILED(Device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) ||
+        !options.MapNoOverwriteOnDynamicConstantBuffer)
+    {
+        return;
+    }
+
+    desc.Usage          = D3D11_USAGE_DYNAMIC;
+    desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    for (int eye = 0; eye < 2; eye++)
+    {
+        hr = Device->CreateBuffer(&desc, &data, &LateLatchEyes[eye].GetRawRef());
+        if (FAILED(hr))
+        {
+            LateLatchEyes[0].Clear();
+            LateLatchEyes[1].Clear();
+            return;
+        }
+    }
+    LateLatchSupported = true;
+}
+
+bool RenderDevice::WriteLateLatch(int eye, const Matrix4f& correction, D3D11_MAP mapType)
+{
+    D3D11_MAPPED_SUBRESOURCE mapped;
+    if (FAILED(Context->Map(LateLatchEyes[eye], 0, mapType, 0, &mapped)))
+    {
+        return false;
+    }
+    const Matrix4f transposed = correction.Transposed();
+    memcpy(mapped.pData, &transposed, sizeof(transposed));
+    Context->Unmap(LateLatchEyes[eye], 0);
+    return true;
+}
+
+void RenderDevice::BeginLateLatchFrame()
+{
+    // DISCARD leaves the last frame's corrections to the draws still reading them.
+    for (int eye = 0; eye < 2 && LateLatchSupported; eye++)
+    {
+        WriteLateLatch(eye, Matrix4f(), D3D11_MAP_WRITE_DISCARD);
+    }
+    LateLatchBound = LateLatchIdentity;
+}
+
+void RenderDevice::SetLateLatchEye(int eye)
+{
+    LateLatchBound = (LateLatchSupported && (eye >= 0) && (eye < 2)) ? LateLatchEyes[eye].GetPtr()
+                                                                      : LateLatchIdentity.GetPtr();
+}
+
+void RenderDevice::UpdateLateLatch(const Matrix4f corrections[2])
+{
+    for (int eye = 0; eye < 2 && LateLatchSupported; eye++)
+    {
+        WriteLateLatch(eye, corrections[eye], D3D11_MAP_WRITE_NO_OVERWRITE);
+    }
+}
+
+// The C++ side of OCTILINEAR_CONSTANT_BUFFER.
+struct OctilinearDataCb
+{
+    float NDCSplitsX[2];
+    float NDCSplitsY[2];
+    float WarpLeft;
+    float WarpRight;
+    float WarpUp;
+    float WarpDown;
+};
+
+bool RenderDevice::SupportsMultires() const
+{
+    return GeometryShaders[GShader_OctilinearEmulated].GetPtr() != nullptr;
+}
+
+bool RenderDevice::BeginMultires(const Vector2i& pos, const MultiresLayout& layout)
+{
+    if (MultiresActive || StereoPassActive || !SupportsMultires())
+    {
+        return false;
+    }
+
+    // The GS culls against the split at the center of clip space.
+    OctilinearDataCb data = {};
+    data.WarpLeft = layout.WarpLeft;
+    data.WarpRight = layout.WarpRight;
+    data.WarpUp = layout.WarpUp;
+    data.WarpDown = layout.WarpDown;
+    if (!UniformBuffers[Shader_Geometry]->Data(Buffer_Uniform, &data, sizeof(data)))
+    {
+        return false;
+    }
+
+    // Each quadrant's viewport is centered on the split and spans the rectilinear extent, of
+    // which the warp only lets through the part the quadrant's scissor keeps. Quadrants are
+    // ordered as the GS numbers them: top left, top right, bottom left, bottom right.
+    const float splitX = float(pos.x + layout.SizeLeft);
+    const float splitY = float(pos.y + layout.SizeUp);
+    const float halfW[2] = { layout.SizeLeft * (1.0f + layout.WarpLeft), layout.SizeRight * (1.0f + layout.WarpRight) };
+    const float halfH[2] = { layout.SizeUp * (1.0f + layout.WarpUp), layout.SizeDown * (1.0f + layout.WarpDown) };
+    D3D11_VIEWPORT viewports[4];
+    D3D11_RECT     scissors[4];
+    for (int i = 0; i < 4; i++)
+    {
+        const int right = i & 1;
+        const int bottom = i >> 1;
+        viewports[i].TopLeftX = splitX - halfW[right];
+        viewports[i].TopLeftY = splitY - halfH[bottom];
+        viewports[i].Width = 2.0f * halfW[right];
+        viewports[i].Height = 2.0f * halfH[bottom];
+        viewports[i].MinDepth = 0;
+        viewports[i].MaxDepth = 1;
+        scissors[i].left = right ? (LONG)splitX : pos.x;
+        scissors[i].right = right ? (LONG)splitX + layout.SizeRight : (LONG)splitX;
+        scissors[i].top = bottom ? (LONG)splitY : pos.y;
+        scissors[i].bottom = bottom ? (LONG)splitY + layout.SizeDown : (LONG)splitY;
+    }
+    Context->RSSetViewports(4, viewports);
+    Context->RSSetScissorRects(4, scissors);
+
+    MultiresScissorWasEnabled = ScissorEnabled;
+    EnableScissor(true);
+
+    const Sizei size = layout.GetSize();
+    MultiresViewport = Recti(pos.x, pos.y, size.w, size.h);
+    MultiresActive = true;
+    BatchedFill = nullptr;
+    return true;
+}
+
+void RenderDevice::EndMultires()
+{
+    if (!MultiresActive)
+    {
+        return;
+    }
+    MultiresActive = false;
+    BatchedFill = nullptr;
+    EnableScissor(MultiresScissorWasEnabled);
+    SetViewport(MultiresViewport);
+}
+
+// Slices smaller than this aren't worth a command list.
+static const size_t MinRecordSliceDraws = 64;
+
+ID3D11DeviceContext* RenderDevice::GetContext() const
+{
+    return CurrentRecorder ? CurrentRecorder->Context.GetPtr() : Context.GetPtr();
+}
+
+bool RenderDevice::CreateRecorders(size_t count)
+{
+    while (Recorders.size() < count)
+    {
+        DeferredRecorder recorder;
+        HRESULT hr = Device->CreateDeferredContext(0, &recorder.Context.GetRawRef());
+        OVR_D3D_CHECK_RET_FALSE(hr);
+        for (int i = 0; i < Shader_Count; i++)
+        {
+            recorder.UniformBuffers[i] = *CreateBuffer();
+        }
+        Recorders.push_back(recorder);
+    }
+    return true;
+}
+
+bool RenderDevice::RecordParallel(size_t count, const std::function<void(size_t, size_t)>& recordRange)
+{
+    // RenderModel changes the device's projection for fills which can't render stereo, and
+    // ExtraShaders is set on the immediate context only.
+    if (!DriverCommandLists || StereoPassActive || ExtraShaders || CurrentRecorder)
+    {
+        return false;
+    }
+
+    TaskScheduler* scheduler = SharedTaskScheduler::GetInstance()->GetScheduler();
+    const size_t sliceCount = std::min<size_t>(scheduler->GetWorkerCount() + 1, count / MinRecordSliceDraws);
+    if ((sliceCount < 2) || !CreateRecorders(sliceCount))
+    {
+        return false;
+    }
+
+    // Deferred contexts start each command list with default state, so every slice starts
+    // from the immediate context's targets and fixed-function state, and the constant buffers
+    // above slot 0 which draws don't set themselves.
+    const UINT bufferCount = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT - 1;
+    ID3D11RenderTargetView*  rtvs[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT] = {};
+    ID3D11DepthStencilView*  dsv = nullptr;
+    D3D11_VIEWPORT           viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+    UINT                     viewportCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+    D3D11_RECT               scissors[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE];
+    UINT                     scissorCount = D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE;
+    ID3D11RasterizerState*   rasterizerState = nullptr;
+    ID3D11DepthStencilState* depthState = nullptr;
+    UINT                     stencilRef = 0;
+    ID3D11BlendState*        blendState = nullptr;
+    FLOAT                    blendFactor[4];
+    UINT                     sampleMask = 0;
+    ID3D11Buffer*            vsBuffers[bufferCount] = {};
+    ID3D11Buffer*            psBuffers[bufferCount] = {};
+
+    Context->OMGetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, rtvs, &dsv);
+    Context->RSGetViewports(&viewportCount, viewports);
+    Context->RSGetScissorRects(&scissorCount, scissors);
+    Context->RSGetState(&rasterizerState);
+    Context->OMGetDepthStencilState(&depthState, &stencilRef);
+    Context->OMGetBlendState(&blendState, blendFactor, &sampleMask);
+    Context->VSGetConstantBuffers(1, bufferCount, vsBuffers);
+    Context->PSGetConstantBuffers(1, bufferCount, psBuffers);
+
+    TaskGroup group(scheduler);
+    for (size_t slice = 0; slice < sliceCount; slice++)
+    {
+        group.Run([&, slice]()
+        {
+            DeferredRecorder& recorder = Recorders[slice];
+            ID3D11DeviceContext* context = recorder.Context;
+
+            context->OMSetRenderTargets(D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, rtvs, dsv);
+            context->RSSetViewports(viewportCount, viewports);
+            context->RSSetScissorRects(scissorCount, scissors);
+            context->RSSetState(rasterizerState);
+            context->OMSetDepthStencilState(depthState, stencilRef);
+            context->OMSetBlendState(blendState, blendFactor, sampleMask);
+            context->VSSetConstantBuffers(1, bufferCount, vsBuffers);
+            context->PSSetConstantBuffers(1, bufferCount, psBuffers);
+
+            recorder.BatchedFill = nullptr;
+            CurrentRecorder = &recorder;
+            recordRange(count * slice / sliceCount, count * (slice + 1) / sliceCount);
+            CurrentRecorder = nullptr;
+
+            HRESULT hr = context->FinishCommandList(FALSE, &recorder.CommandList.GetRawRef());
+            OVR_ASSERT(SUCCEEDED(hr));
+            OVR_UNUSED(hr);
+        });
+    }
+    group.Wait();
+
+    // Executing restores the immediate context's state after each list.
+    for (size_t slice = 0; slice < sliceCount; slice++)
+    {
+        DeferredRecorder& recorder = Recorders[slice];
+        if (recorder.CommandList)
+        {
+            Context->ExecuteCommandList(recorder.CommandList, TRUE);
+            recorder.CommandList = NULL;
+        }
+    }
+
+    for (UINT i = 0; i < D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT; i++)
+    {
+        if (rtvs[i]) rtvs[i]->Release();
+    }
+    for (UINT i = 0; i < bufferCount; i++)
+    {
+        if (vsBuffers[i]) vsBuffers[i]->Release();
+        if (psBuffers[i]) psBuffers[i]->Release();
+    }
+    if (dsv)             dsv->Release();
+    if (rasterizerState) rasterizerState->Release();
+    if (depthState)      depthState->Release();
+    if (blendState)      blendState->Release();
+    return true;
+}
+
 
 bool RenderDevice::Present(bool withVsync)
 {
@@ -2916,11 +4065,27 @@ void RenderDevice::FillRect(float left, float top, float right, float bottom, Co
     Context->OMSetBlendState(NULL, NULL, 0xffffffff);
 }
 
-void RenderDevice::RenderText(const struct Font* font, const char* str, float x, float y, float size, Color c, const Matrix4f* view)
+void RenderDevice::FlushText()
 {
-	Context->OMSetBlendState(BlendStatePreMulAlpha, NULL, 0xffffffff);
-    OVR::Render::RenderDevice::RenderText(font, str, x, y, size, c, view);
-    Context->OMSetBlendState(NULL, NULL, 0xffffffff);
+    if (!HasPendingText())
+    {
+        return;
+    }
+
+    // Text can be flushed from inside another 2D draw, so put back whatever blending it set.
+    ID3D11BlendState* blendState = nullptr;
+    FLOAT blendFactor[4];
+    UINT sampleMask = 0;
+    Context->OMGetBlendState(&blendState, blendFactor, &sampleMask);
+
+    Context->OMSetBlendState(BlendStatePreMulAlpha, NULL, 0xffffffff);
+    OVR::Render::RenderDevice::FlushText();
+    Context->OMSetBlendState(blendState, blendFactor, sampleMask);
+
+    if (blendState)
+    {
+        blendState->Release();
+    }
 }
 
 void RenderDevice::FillGradientRect(float left, float top, float right, float bottom, Color col_top, Color col_btm, const Matrix4f* view)
@@ -2964,6 +4129,156 @@ void RenderDevice::EndGpuEvent()
 #endif
 }
 
+bool RenderDevice::CreateGpuTimerQueries(int frameCount, int timestampsPerFrame)
+{
+    if (frameCount > GpuTimerFrameCount)
+        return false;
+
+    D3D11_QUERY_DESC disjointDesc = { D3D11_QUERY_TIMESTAMP_DISJOINT, 0 };
+    D3D11_QUERY_DESC timestampDesc = { D3D11_QUERY_TIMESTAMP, 0 };
+
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        HRESULT hr = Device->CreateQuery(&disjointDesc, &GpuTimerDisjoint[frame].GetRawRef());
+
+        GpuTimerTimestamps[frame].resize(timestampsPerFrame);
+        for (int i = 0; SUCCEEDED(hr) && (i < timestampsPerFrame); ++i)
+            hr = Device->CreateQuery(&timestampDesc, &GpuTimerTimestamps[frame][i].GetRawRef());
+
+        if (FAILED(hr))
+        {
+            ReleaseGpuTimerQueries();
+            return false;
+        }
+    }
+    return true;
+}
+
+void RenderDevice::ReleaseGpuTimerQueries()
+{
+    for (int frame = 0; frame < GpuTimerFrameCount; ++frame)
+    {
+        GpuTimerDisjoint[frame].Clear();
+        GpuTimerTimestamps[frame].clear();
+    }
+}
+
+void RenderDevice::BeginGpuTimerQueries(int frame)
+{
+    Context->Begin(GpuTimerDisjoint[frame]);
+}
+
+void RenderDevice::WriteGpuTimestamp(int frame, int index)
+{
+    Context->End(GpuTimerTimestamps[frame][index]);
+}
+
+void RenderDevice::EndGpuTimerQueries(int frame)
+{
+    Context->End(GpuTimerDisjoint[frame]);
+}
+
+RenderDevice::GpuTimerReadResult RenderDevice::ReadGpuTimestamps(int frame, int count, uint64_t* timestamps, uint64_t& frequency)
+{
+    // DONOTFLUSH, so that polling doesn't submit work early; the frames are old enough
+    // to have been flushed by Present anyway.
+    D3D11_QUERY_DATA_TIMESTAMP_DISJOINT disjoint;
+    HRESULT hr = Context->GetData(GpuTimerDisjoint[frame], &disjoint, sizeof(disjoint), D3D11_ASYNC_GETDATA_DONOTFLUSH);
+    if (hr == S_FALSE)
+        return GpuTimerRead_NotReady;
+    if (FAILED(hr) || disjoint.Disjoint)
+        return GpuTimerRead_Invalid;
+
+    for (int i = 0; i < count; ++i)
+    {
+        UINT64 timestamp = 0;
+        hr = Context->GetData(GpuTimerTimestamps[frame][i], &timestamp, sizeof(timestamp), D3D11_ASYNC_GETDATA_DONOTFLUSH);
+        if (hr == S_FALSE)
+            return GpuTimerRead_NotReady;
+        if (FAILED(hr))
+            return GpuTimerRead_Invalid;
+        timestamps[i] = timestamp;
+    }
+
+    frequency = disjoint.Frequency;
+    return GpuTimerRead_Ready;
+}
+
+bool RenderDevice::CreateOcclusionQueries(int frameCount, int queriesPerFrame)
+{
+    if (frameCount > OcclusionFrameCount)
+        return false;
+
+    D3D11_QUERY_DESC occlusionDesc = { D3D11_QUERY_OCCLUSION, 0 };
+
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        HRESULT hr = S_OK;
+        OcclusionQueries[frame].resize(queriesPerFrame);
+        for (int i = 0; SUCCEEDED(hr) && (i < queriesPerFrame); ++i)
+            hr = Device->CreateQuery(&occlusionDesc, &OcclusionQueries[frame][i].GetRawRef());
+
+        if (FAILED(hr))
+        {
+            ReleaseOcclusionQueries();
+            return false;
+        }
+    }
+    return true;
+}
+
+void RenderDevice::ReleaseOcclusionQueries()
+{
+    for (int frame = 0; frame < OcclusionFrameCount; ++frame)
+        OcclusionQueries[frame].clear();
+}
+
+void RenderDevice::BeginOcclusionQuery(int frame, int index)
+{
+    Context->Begin(OcclusionQueries[frame][index]);
+}
+
+void RenderDevice::EndOcclusionQuery(int frame, int index)
+{
+    Context->End(OcclusionQueries[frame][index]);
+}
+
+bool RenderDevice::ReadOcclusionQueries(int frame, int count, uint64_t* samples)
+{
+    // DONOTFLUSH as for the timer queries. A failure reads as visible, which is always safe.
+    for (int i = 0; i < count; ++i)
+    {
+        UINT64 passed = 0;
+        HRESULT hr = Context->GetData(OcclusionQueries[frame][i], &passed, sizeof(passed), D3D11_ASYNC_GETDATA_DONOTFLUSH);
+        if (hr == S_FALSE)
+            return false;
+        samples[i] = FAILED(hr) ? ~0ull : passed;
+    }
+    return true;
+}
+
+bool RenderDevice::SignalFrameFence(int slot)
+{
+    if (!FrameFenceQueries[slot])
+    {
+        D3D11_QUERY_DESC eventDesc = { D3D11_QUERY_EVENT, 0 };
+        if (FAILED(Device->CreateQuery(&eventDesc, &FrameFenceQueries[slot].GetRawRef())))
+            return false;
+    }
+
+    Context->End(FrameFenceQueries[slot]);
+    return true;
+}
+
+bool RenderDevice::IsFrameFenceDone(int slot)
+{
+    // DONOTFLUSH as for the timer queries; the next Present flushes the event anyway. A failure
+    // means the device was lost, and nothing is using the resources any more.
+    BOOL done = FALSE;
+    HRESULT hr = Context->GetData(FrameFenceQueries[slot], &done, sizeof(done), D3D11_ASYNC_GETDATA_DONOTFLUSH);
+    return (hr != S_FALSE);
+}
+
 
 
 }}} // namespace OVR::Render::D3D11
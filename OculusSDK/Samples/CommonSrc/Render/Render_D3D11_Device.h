@@ -33,6 +33,8 @@ limitations under the License.
 
 #include <vector>
 #include <string>
+#include <string.h>
+#include <unordered_map>
 
 
 namespace OVR { namespace Render { namespace D3D11 {
@@ -225,6 +227,42 @@ public:
 };
 
 
+// State objects keyed by their full description, hashed and compared bytewise. Descriptions
+// must be zero-filled before they're set up, so that their padding compares equal.
+template<class Desc, class State>
+class StateObjectCache
+{
+public:
+    State* Find(const Desc& desc) const
+    {
+        auto it = States.find(desc);
+        return (it != States.end()) ? it->second.GetPtr() : NULL;
+    }
+    void Add(const Desc& desc, State* state) { States[desc] = state; }
+    void Clear()                             { States.clear(); }
+
+private:
+    struct DescHash
+    {
+        size_t operator()(const Desc& desc) const
+        {
+            // FNV-1a
+            const unsigned char* bytes = (const unsigned char*)&desc;
+            uint32_t hash = 2166136261u;
+            for (size_t i = 0; i < sizeof(Desc); i++)
+                hash = (hash ^ bytes[i]) * 16777619u;
+            return hash;
+        }
+    };
+    struct DescEqual
+    {
+        bool operator()(const Desc& a, const Desc& b) const { return memcmp(&a, &b, sizeof(Desc)) == 0; }
+    };
+
+    std::unordered_map<Desc, Ptr<State>, DescHash, DescEqual> States;
+};
+
+
 class RenderDevice : public Render::RenderDevice
 {
 public:
@@ -251,22 +289,40 @@ public:
     Ptr<ID3D11RasterizerState>      RasterizerCullFrontScissorEnabled;
 	Ptr<ID3D11BlendState>           BlendStatePreMulAlpha; 
 	Ptr<ID3D11BlendState>           BlendStateNormalAlpha; 
+    Ptr<ID3D11BlendState>           BlendStateNoColorWrite;
 	D3D11_VIEWPORT                  D3DViewport;
 
     Ptr<ID3D11DepthStencilState>    DepthStates[1 + 2 * Compare_Count];
     Ptr<ID3D11DepthStencilState>    CurDepthState;
     Ptr<ID3D11InputLayout>          ModelVertexIL;
+    Ptr<ID3D11InputLayout>          ModelSplitVertexIL;
+    Ptr<ID3D11InputLayout>          ModelQuantizedVertexIL;
+    Ptr<ID3D11InputLayout>          ModelInstancedVertexIL;
     Ptr<ID3D11InputLayout>          DistortionVertexIL;
     Ptr<ID3D11InputLayout>          HeightmapVertexIL;
 
     Ptr<ID3D11SamplerState>         SamplerStates[Sample_Count];
 
+    // Every state object the device creates goes through these, so that a description is
+    // only ever created once. DepthStates and SamplerStates index into them by mode, and
+    // are filled at startup so that setting a mode never creates a state mid-frame.
+    StateObjectCache<D3D11_DEPTH_STENCIL_DESC, ID3D11DepthStencilState> DepthStateCache;
+    StateObjectCache<D3D11_RASTERIZER_DESC, ID3D11RasterizerState>      RasterizerStateCache;
+    StateObjectCache<D3D11_BLEND_DESC, ID3D11BlendState>                BlendStateCache;
+    StateObjectCache<D3D11_SAMPLER_DESC, ID3D11SamplerState>            SamplerStateCache;
+
     struct StandardUniformData
     {
         Matrix4f  Proj;
         Matrix4f  View;
         Vector4f  GlobalTint;
     }                              StdUniforms;
+    // The uniforms of the MVPStereo vertex shader.
+    struct StereoUniformData : public StandardUniformData
+    {
+        Matrix4f  EyeProj[2];
+        Vector4f  EyeClipPlane[2];
+    };
     Ptr<Buffer>                    UniformBuffers[Shader_Count];
     int                            MaxTextureSet[Shader_Count];
 
@@ -289,7 +345,49 @@ public:
 
     Ptr<ID3DUserDefinedAnnotation> UserAnnotation;  // for GPU profile markers
 
+    // Per-draw uniforms are suballocated from one dynamic constant buffer that is mapped
+    // with NO_OVERWRITE and bound by offset through the D3D11.1 context. When the ring
+    // wraps it is mapped with DISCARD, which lets the driver hand us fresh memory while
+    // the GPU still reads the previous frames' constants.
+    Ptr<ID3D11DeviceContext1>      Context1;
+    Ptr<ID3D11Buffer>              UniformRing;
+    UINT                           UniformRingSize = 0;
+    UINT                           UniformRingOffset = 0;
+
+    // The MVP vertex shaders' LateView, bound to slot 2 by every draw: the identity, or an
+    // eye's correction. The eye buffers are mapped with DISCARD as a frame starts and with
+    // NO_OVERWRITE by UpdateLateLatch, so draws the GPU hasn't run yet read the new view.
+    Ptr<ID3D11Buffer>              LateLatchIdentity;
+    Ptr<ID3D11Buffer>              LateLatchEyes[2];
+    ID3D11Buffer*                  LateLatchBound = nullptr;
+    bool                           LateLatchSupported = false;
+
+    // RecordParallel gives each slice of draws a deferred context, and its own copies of the
+    // state that DrawBound changes per draw on the immediate context.
+    struct DeferredRecorder
+    {
+        Ptr<ID3D11DeviceContext>   Context;
+        Ptr<ID3D11CommandList>     CommandList;
+        Ptr<Buffer>                UniformBuffers[Shader_Count];
+        std::vector<unsigned char> VertexUniforms;
+        const Fill*                BatchedFill = nullptr;
+        PrimitiveType              BatchedFillPrim = Prim_Triangles;
+    };
+    std::vector<DeferredRecorder>  Recorders;
+    bool                           DriverCommandLists = false;
+
+    // For GPU pass timing, per frame set
+    Ptr<ID3D11Query>               GpuTimerDisjoint[GpuTimerFrameCount];
+    std::vector<Ptr<ID3D11Query> > GpuTimerTimestamps[GpuTimerFrameCount];
+
+    // For occlusion culling, per frame set
+    std::vector<Ptr<ID3D11Query> > OcclusionQueries[OcclusionFrameCount];
+
+    // Event queries ending each fenced frame, for deferred releases
+    Ptr<ID3D11Query>               FrameFenceQueries[DeferredReleaseFrameCount];
+
     bool                           ScissorEnabled = false;
+    bool                           MultiresScissorWasEnabled = false;
     CullMode                       ActiveCullMode = Cull_Back;
 
 public:
@@ -310,12 +408,43 @@ public:
 
     size_t QueryGPUMemorySize();
 
+    // The context to record into: the calling thread's deferred context while RecordParallel
+    // runs its slices, otherwise the immediate Context.
+    ID3D11DeviceContext* GetContext() const;
+
+    // Records only when the driver executes command lists natively; with the runtime's
+    // emulation, recording costs more than it saves.
+    virtual bool RecordParallel(size_t count, const std::function<void(size_t, size_t)>& recordRange) override;
+
+    // Creates UniformRing if the driver supports constant buffer offsets and NO_OVERWRITE
+    // mapping of dynamic constant buffers; otherwise draws keep using UniformBuffers.
+    void CreateUniformRing();
+    // Copies size bytes of uniforms into the ring and binds them to slot 0 of the stage.
+    // Returns false if the ring is unavailable, in which case nothing has been bound.
+    bool UploadRingUniforms(ShaderStage stage, const void* data, int size);
+    // Creates deferred contexts until there are count recorders.
+    bool CreateRecorders(size_t count);
+    // Creates the late latch buffers, with the eyes' only if the driver can map dynamic
+    // constant buffers with NO_OVERWRITE.
+    void CreateLateLatchBuffers();
+    bool WriteLateLatch(int eye, const Matrix4f& correction, D3D11_MAP mapType);
+
+    virtual bool SupportsLateLatch() const override { return LateLatchSupported; }
+    virtual void BeginLateLatchFrame() override;
+    virtual void SetLateLatchEye(int eye) override;
+    virtual void UpdateLateLatch(const Matrix4f corrections[2]) override;
+
+    virtual bool SupportsMultires() const override;
+    virtual bool BeginMultires(const Vector2i& pos, const MultiresLayout& layout) override;
+    virtual void EndMultires() override;
+
     virtual void Clear(float r = 0, float g = 0, float b = 0, float a = 1,
         float depth = 1,
         bool clearColor = true, bool clearDepth = true, int faceIndex = -1) override;
 
     virtual Buffer* CreateBuffer() override;
     virtual Texture* CreateTexture(uint64_t format, int width, int height, const void* data, int mipcount = 1, ovrResult* error = nullptr) override;
+    virtual Texture* CreateTextureArray(const std::vector<Render::Texture*>& slices) override;
 
     static std::tuple<unsigned int, const void*> GenerateSubresourceData(
         unsigned imageWidth, unsigned imageHeight, int format, unsigned imageDimUpperLimit,
@@ -329,6 +458,7 @@ public:
 
     virtual void SetCullMode(CullMode cullMode) override;
     virtual void EnableScissor(bool enabled) override;
+    virtual void SetColorWrite(bool enabled) override;
 
     virtual void BeginRendering() override;
     virtual void SetRenderTarget(Render::Texture* color,
@@ -344,7 +474,7 @@ public:
 
     // Overridden to apply proper blend state.
     virtual void FillRect(float left, float top, float right, float bottom, Color c, const Matrix4f* view = NULL) override;
-    virtual void RenderText(const struct Font* font, const char* str, float x, float y, float size, Color c, const Matrix4f* view = NULL) override;
+    virtual void FlushText() override;
     virtual void FillGradientRect(float left, float top, float right, float bottom, Color col_top, Color col_btm, const Matrix4f* view) override;
     virtual void RenderImage(float left, float top, float right, float bottom, ShaderFill* image, unsigned char alpha = 255, const Matrix4f* view = NULL) override;
 
@@ -353,6 +483,11 @@ public:
         const Matrix4f& matrix, int offset, int count, PrimitiveType prim = Prim_Triangles) override;
     virtual void RenderWithAlpha(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
         const Matrix4f& matrix, int offset, int count, PrimitiveType prim = Prim_Triangles) override;
+    virtual void RenderSplit(const Fill* fill, Render::Buffer* positions, Render::Buffer* attributes,
+        Render::Buffer* indices, const Matrix4f& matrix, int firstVertex, int count,
+        PrimitiveType prim = Prim_Triangles) override;
+    virtual void RenderQuantized(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
+        const Matrix4f& matrix, int firstVertex, int count, PrimitiveType prim = Prim_Triangles) override;
     virtual Fill *GetSimpleFill(int flags = Fill::F_Solid) override;
     virtual Fill *GetTextureFill(Render::Texture* tex, bool useAlpha = false, bool usePremult = false) override;
 
@@ -362,6 +497,13 @@ public:
     virtual ID3D10Blob* CompileShader(const char* profile, const char* src, const char* mainName = "main");
 
     ID3D11SamplerState* GetSamplerState(int sm);
+    ID3D11DepthStencilState* GetDepthState(bool enable, bool write, CompareFunc func);
+
+    // Returns the cached state object for desc, creating it on first use.
+    ID3D11DepthStencilState* GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc);
+    ID3D11RasterizerState*   GetRasterizerState(const D3D11_RASTERIZER_DESC& desc);
+    ID3D11BlendState*        GetBlendState(const D3D11_BLEND_DESC& desc);
+    ID3D11SamplerState*      GetSamplerState(const D3D11_SAMPLER_DESC& desc);
 
     void SetTexture(Render::ShaderStage stage, int slot, const Texture* t);
     bool SaveCubemapTexture(Render::Texture* tex, Vector3f transl, const std::string& filePath, std::string* error) override;
@@ -370,6 +512,33 @@ public:
     virtual void BeginGpuEvent(const char* markerText, uint32_t markerColor) override;
     virtual void EndGpuEvent() override;
 
+protected:
+    virtual bool CreateGpuTimerQueries(int frameCount, int timestampsPerFrame) override;
+    virtual void ReleaseGpuTimerQueries() override;
+    virtual void BeginGpuTimerQueries(int frame) override;
+    virtual void WriteGpuTimestamp(int frame, int index) override;
+    virtual void EndGpuTimerQueries(int frame) override;
+    virtual GpuTimerReadResult ReadGpuTimestamps(int frame, int count, uint64_t* timestamps, uint64_t& frequency) override;
+
+    virtual bool CreateOcclusionQueries(int frameCount, int queriesPerFrame) override;
+    virtual void ReleaseOcclusionQueries() override;
+    virtual void BeginOcclusionQuery(int frame, int index) override;
+    virtual void EndOcclusionQuery(int frame, int index) override;
+    virtual bool ReadOcclusionQueries(int frame, int count, uint64_t* samples) override;
+
+    virtual bool SignalFrameFence(int slot) override;
+    virtual bool IsFrameFenceDone(int slot) override;
+
+    virtual bool RenderInstances(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
+                                 Render::Buffer* instances, const Matrix4f& matrix, int count, int instanceCount,
+                                 PrimitiveType prim) override;
+    virtual bool CanRenderStereo(const Fill* fill) override;
+
+    // Draws with the vertex buffers and input layout already bound. With instanceCount above zero,
+    // draws that many instances with the MVPInstanced vertex shader in place of the fill's, and
+    // during a stereo pass, two instances with MVPStereo.
+    void DrawBound(const Fill* fill, Render::Buffer* indices, const Matrix4f& matrix, int count,
+                   PrimitiveType rprim, int instanceCount = 0);
 };
 
 
@@ -23,53 +23,1742 @@ limitations under the License.
 
 #include "../Render/Render_Device.h"
 #include "../Render/Render_Font.h"
+#include "Kernel/OVR_Alg.h"
+#include "Kernel/OVR_Timer.h"
+#include <algorithm>
 
 
 namespace OVR { namespace Render {
 
     void Model::Render(const Matrix4f& ltw, RenderDevice* ren)
     {
-        if(Visible)
+        if(Visible && !Culled && !Occluded)
+        {
+            RenderAt(ltw * GetMatrix(), ren);
+        }
+    }
+
+    void Model::RenderAt(const Matrix4f& viewFromModel, RenderDevice* ren)
+    {
+        if(Visible && !Culled && !Occluded)
         {
             AutoGpuProf prof(ren, (AssetName.length() > 0 ? AssetName.c_str() : "Model_Render"));
-            Matrix4f m = ltw * GetMatrix();
-            ren->Render(m, this);
+            ren->RenderModel(viewFromModel, this);
         }
     }
 
-    void Container::Render(const Matrix4f& ltw, RenderDevice* ren)
+    void Model::Draw(const Matrix4f& viewFromModel, RenderDevice* ren)
     {
-        Matrix4f m = ltw * GetMatrix();
-        for(size_t i = 0; i < Nodes.size(); i++)
+        ren->Render(viewFromModel, GetLodMesh());
+    }
+
+    void Model::DrawDepth(const Matrix4f& viewFromModel, RenderDevice* ren, const class Fill* fill)
+    {
+        // A mesh not drawn yet has no buffers, and is left to the main pass to make them.
+        Model* mesh = GetLodMesh();
+        if (!mesh->VertexBuffer || !mesh->IndexBuffer)
         {
-            Nodes[i]->Render(m, ren);
+            return;
+        }
+
+        const int count = (int)mesh->Indices.size();
+        if (mesh->Layout == VertexLayout_Split)
+        {
+            Buffer* attributes = (fill == ren->GetDepthFill()) ? nullptr : mesh->AttributeBuffer.GetPtr();
+            ren->RenderSplit(fill, mesh->VertexBuffer, attributes, mesh->IndexBuffer, viewFromModel, 0, count,
+                             mesh->GetPrimType());
+        }
+        else if (mesh->Layout == VertexLayout_Quantized)
+        {
+            ren->RenderQuantized(fill, mesh->VertexBuffer, mesh->IndexBuffer,
+                                 viewFromModel * mesh->GetDequantizeMatrix(), 0, count, mesh->GetPrimType());
+        }
+        else
+        {
+            ren->Render(fill, mesh->VertexBuffer, mesh->IndexBuffer, viewFromModel, 0, count, mesh->GetPrimType());
+        }
+    }
+
+    int Model::UpdateCulling(const Matrix4f& ltw, const FrustumCuller* culler)
+    {
+        return UpdateCullingAt(ltw * GetMatrix(), culler);
+    }
+
+    int Model::UpdateCullingAt(const Matrix4f& worldFromModel, const FrustumCuller* culler)
+    {
+        Culled = culler && Visible && !culler->IsVisible(GetLocalBounds(), worldFromModel);
+        Occluded = false;
+        return Culled ? 1 : 0;
+    }
+
+    void Model::CollectDrawItems(const Matrix4f& ltw, RenderQueue& queue)
+    {
+        if(Visible && !Culled && !Occluded)
+        {
+            queue.Add(this, ltw * GetMatrix());
+        }
+    }
+
+    const Bounds3f& Model::GetLocalBounds() const
+    {
+        if (!LocalBoundsCurrent)
+        {
+            LocalBounds.Clear();
+            for (size_t i = 0; i < Vertices.size(); i++)
+            {
+                LocalBounds.AddPoint(Vertices[i].Pos);
+            }
+            LocalBoundsCurrent = true;
+        }
+        return LocalBounds;
+    }
+
+    void Model::ReleaseRenderer(RenderDevice* ren)
+    {
+        ren->ReleaseDeferred(VertexBuffer);
+        ren->ReleaseDeferred(AttributeBuffer);
+        ren->ReleaseDeferred(IndexBuffer);
+        for (size_t i = 0; i < Lods.size(); i++)
+        {
+            ren->ReleaseDeferred(Lods[i]->VertexBuffer);
+            ren->ReleaseDeferred(Lods[i]->AttributeBuffer);
+            ren->ReleaseDeferred(Lods[i]->IndexBuffer);
+        }
+
+        // The fill may be shared, so its textures stay bound; the queue just holds them as well.
+        if (Fill)
+        {
+            for (int i = 0; i < 8; i++)
+            {
+                Ptr<Texture> pixelTexture = Fill->GetTexture(i, Shader_Pixel);
+                Ptr<Texture> vertexTexture = Fill->GetTexture(i, Shader_Vertex);
+                ren->ReleaseDeferred(pixelTexture);
+                ren->ReleaseDeferred(vertexTexture);
+            }
+        }
+    }
+
+    void InstancedModel::ReleaseRenderer(RenderDevice* ren)
+    {
+        Model::ReleaseRenderer(ren);
+        ren->ReleaseDeferred(InstanceBuffer);
+    }
+
+    void InstancedModel::Draw(const Matrix4f& viewFromModel, RenderDevice* ren)
+    {
+        ren->RenderInstanced(viewFromModel, this);
+    }
+
+    const Bounds3f& InstancedModel::GetLocalBounds() const
+    {
+        if (!InstanceBoundsCurrent)
+        {
+            InstanceBounds.Clear();
+            const Bounds3f& meshBounds = Model::GetLocalBounds();
+            const Vector3f& mins = meshBounds.GetMins();
+            const Vector3f& maxs = meshBounds.GetMaxs();
+            if ((mins.x <= maxs.x) && (mins.y <= maxs.y) && (mins.z <= maxs.z))
+            {
+                for (size_t i = 0; i < Instances.size(); i++)
+                {
+                    for (int corner = 0; corner < 8; corner++)
+                    {
+                        const Vector3f p((corner & 1) ? maxs.x : mins.x,
+                                         (corner & 2) ? maxs.y : mins.y,
+                                         (corner & 4) ? maxs.z : mins.z);
+                        InstanceBounds.AddPoint(Instances[i].Transform(p));
+                    }
+                }
+            }
+            InstanceBoundsCurrent = true;
+        }
+        return InstanceBounds;
+    }
+
+    void InstancedModel::GetInstanceRows(std::vector<Vector4f>& rows) const
+    {
+        rows.resize(Instances.size() * 3);
+        for (size_t i = 0; i < Instances.size(); i++)
+        {
+            const Matrix4f& m = Instances[i];
+            OVR_ASSERT((m.M[3][0] == 0.0f) && (m.M[3][1] == 0.0f) && (m.M[3][2] == 0.0f) && (m.M[3][3] == 1.0f));
+            for (int r = 0; r < 3; r++)
+            {
+                rows[i * 3 + r] = Vector4f(m.M[r][0], m.M[r][1], m.M[r][2], m.M[r][3]);
+            }
+        }
+    }
+
+    void Model::GetSplitVertexStreams(std::vector<Vector3f>& positions,
+                                      std::vector<VertexAttributes>& attributes) const
+    {
+        positions.resize(Vertices.size());
+        attributes.resize(Vertices.size());
+        for (size_t i = 0; i < Vertices.size(); i++)
+        {
+            const Vertex& v = Vertices[i];
+            positions[i] = v.Pos;
+            attributes[i].C = v.C;
+            attributes[i].U = v.U;
+            attributes[i].V = v.V;
+            attributes[i].U2 = v.U2;
+            attributes[i].V2 = v.V2;
+            attributes[i].Norm = v.Norm;
+        }
+    }
+
+    // Rounds to the nearest half float, flushing what is too small for one to zero and
+    // saturating what is too large.
+    static uint16_t FloatToHalf(float f)
+    {
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        const uint16_t sign     = (uint16_t)((bits >> 16) & 0x8000);
+        const uint32_t exponent = (bits >> 23) & 0xff;
+        const uint32_t mantissa = bits & 0x7fffff;
+
+        if (exponent == 0xff)
+        {
+            return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+        }
+        const int halfExponent = (int)exponent - 127 + 15;
+        if (halfExponent >= 31)
+        {
+            return (uint16_t)(sign | 0x7bff);
+        }
+        if (halfExponent <= 0)
+        {
+            // Subnormal halves, below 2^-14.
+            if (halfExponent < -10)
+            {
+                return sign;
+            }
+            const uint32_t full  = mantissa | 0x800000;
+            const int      shift = 14 - halfExponent;
+            uint32_t half = full >> shift;
+            if ((full >> (shift - 1)) & 1)
+            {
+                half++;
+            }
+            return (uint16_t)(sign | half);
+        }
+        // Rounding up may carry into the exponent, which is still the right half.
+        uint32_t half = ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+        if (mantissa & 0x1000)
+        {
+            half++;
+        }
+        return (uint16_t)(sign | Alg::Min<uint32_t>(half, 0x7bff));
+    }
+
+    static int16_t ToSnorm16(float f)
+    {
+        return (int16_t)floorf(Alg::Clamp(f, -1.0f, 1.0f) * 32767.0f + 0.5f);
+    }
+
+    static int8_t ToSnorm8(float f)
+    {
+        return (int8_t)floorf(Alg::Clamp(f, -1.0f, 1.0f) * 127.0f + 0.5f);
+    }
+
+    void Model::QuantizeVertices(std::vector<QuantizedVertex>& vertices)
+    {
+        const Bounds3f& bounds = GetLocalBounds();
+        QuantizeBias  = Vector3f::Zero();
+        QuantizeScale = 1.0f;
+        if (!Vertices.empty())
+        {
+            const Vector3f halfExtent = (bounds.b[1] - bounds.b[0]) * 0.5f;
+            QuantizeBias = (bounds.b[0] + bounds.b[1]) * 0.5f;
+            const float largest = Alg::Max(halfExtent.x, Alg::Max(halfExtent.y, halfExtent.z));
+            if (largest > 0.0f)
+            {
+                QuantizeScale = largest;
+            }
+        }
+
+        const float toUnit = 1.0f / QuantizeScale;
+        vertices.resize(Vertices.size());
+        for (size_t i = 0; i < Vertices.size(); i++)
+        {
+            const Vertex&    v = Vertices[i];
+            QuantizedVertex& q = vertices[i];
+            const Vector3f   p = (v.Pos - QuantizeBias) * toUnit;
+            q.Pos[0]  = ToSnorm16(p.x);
+            q.Pos[1]  = ToSnorm16(p.y);
+            q.Pos[2]  = ToSnorm16(p.z);
+            q.Pos[3]  = 32767;
+            q.C       = v.C;
+            q.UV[0]   = FloatToHalf(v.U);
+            q.UV[1]   = FloatToHalf(v.V);
+            q.UV[2]   = FloatToHalf(v.U2);
+            q.UV[3]   = FloatToHalf(v.V2);
+            q.Norm[0] = ToSnorm8(v.Norm.x);
+            q.Norm[1] = ToSnorm8(v.Norm.y);
+            q.Norm[2] = ToSnorm8(v.Norm.z);
+            q.Norm[3] = 0;
+        }
+    }
+
+    bool Model::SetIndexBufferData(Buffer* ib) const
+    {
+        if (NeedsIndex32())
+        {
+            return ib->Data(Buffer_Index | Buffer_Index32 | Buffer_ReadOnly, &Indices[0],
+                            Indices.size() * sizeof(uint32_t));
+        }
+
+        std::vector<uint16_t> indices16(Indices.size());
+        for (size_t i = 0; i < Indices.size(); i++)
+        {
+            indices16[i] = (uint16_t)Indices[i];
+        }
+        return ib->Data(Buffer_Index | Buffer_ReadOnly, &indices16[0], indices16.size() * sizeof(uint16_t));
+    }
+
+    // Spreads the low 10 bits of v out to every third bit, for a Morton code.
+    static uint32_t SpreadMortonBits(uint32_t v)
+    {
+        v &= 0x3ff;
+        v = (v | (v << 16)) & 0x030000ff;
+        v = (v | (v << 8))  & 0x0300f00f;
+        v = (v | (v << 4))  & 0x030c30c3;
+        v = (v | (v << 2))  & 0x09249249;
+        return v;
+    }
+
+    void Model::SplitIntoClusters(size_t maxTriangles, std::vector<Ptr<Model> >& clusters) const
+    {
+        OVR_ASSERT(Type == Prim_Triangles);
+        OVR_ASSERT(maxTriangles > 0);
+
+        const size_t triangleCount = Indices.size() / 3;
+        if (triangleCount == 0)
+        {
+            return;
         }
+
+        // Order the triangles along a Morton curve through the bounds of their centroids, so that
+        // each run of maxTriangles is spatially compact.
+        const Bounds3f& bounds = GetLocalBounds();
+        const Vector3f  size = bounds.GetMaxs() - bounds.GetMins();
+        const Vector3f  scale(size.x > 0 ? 1023.0f / size.x : 0.0f,
+                              size.y > 0 ? 1023.0f / size.y : 0.0f,
+                              size.z > 0 ? 1023.0f / size.z : 0.0f);
+
+        std::vector<std::pair<uint32_t, uint32_t> > order(triangleCount);   // Morton code, triangle
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            const Vector3f centroid = (Vertices[Indices[t * 3]].Pos + Vertices[Indices[t * 3 + 1]].Pos +
+                                       Vertices[Indices[t * 3 + 2]].Pos) * (1.0f / 3.0f);
+            const Vector3f cell = (centroid - bounds.GetMins()).EntrywiseMultiply(scale);
+            order[t].first = SpreadMortonBits((uint32_t)Alg::Max(cell.x, 0.0f)) |
+                             (SpreadMortonBits((uint32_t)Alg::Max(cell.y, 0.0f)) << 1) |
+                             (SpreadMortonBits((uint32_t)Alg::Max(cell.z, 0.0f)) << 2);
+            order[t].second = (uint32_t)t;
+        }
+        std::sort(order.begin(), order.end());
+
+        // Maps a vertex of this model to its index in the cluster being built.
+        std::vector<uint32_t> remap(Vertices.size(), UINT_MAX);
+        std::vector<uint32_t> used;
+
+        for (size_t first = 0; first < triangleCount; first += maxTriangles)
+        {
+            const size_t last = Alg::Min(first + maxTriangles, triangleCount);
+
+            Ptr<Model> cluster = *new Model(Type);
+            cluster->AssetName = AssetName;
+            cluster->Fill = Fill;
+            cluster->Visible = Visible;
+            cluster->Layout = Layout;
+            cluster->SetPosition(GetPosition());
+            cluster->SetOrientation(GetOrientation());
+
+            for (size_t i = first; i < last; i++)
+            {
+                const size_t t = order[i].second;
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    const uint32_t v = Indices[t * 3 + corner];
+                    if (remap[v] == UINT_MAX)
+                    {
+                        remap[v] = cluster->AddVertex(Vertices[v]);
+                        used.push_back(v);
+                    }
+                    cluster->Indices.push_back(remap[v]);
+                }
+            }
+
+            for (size_t i = 0; i < used.size(); i++)
+            {
+                remap[used[i]] = UINT_MAX;
+            }
+            used.clear();
+
+            clusters.push_back(cluster);
+        }
+    }
+
+    // The most m scales any axis by.
+    static float MaxAxisScale(const Matrix4f& m)
+    {
+        float scale = 0.0f;
+        for (int c = 0; c < 3; c++)
+        {
+            scale = Alg::Max(scale, m.M[0][c] * m.M[0][c] + m.M[1][c] * m.M[1][c] + m.M[2][c] * m.M[2][c]);
+        }
+        return sqrtf(scale);
+    }
+
+    // Appends the triangles of mesh to model, transformed by matrix, with normals rotated by rot.
+    static void AppendTransformedMesh(Model* model, const Model* mesh, const Matrix4f& matrix, const Quatf& rot)
+    {
+        const uint32_t base = model->GetNextVertexIndex();
+        for (size_t v = 0; v < mesh->Vertices.size(); v++)
+        {
+            Vertex vertex = mesh->Vertices[v];
+            vertex.Pos  = matrix.Transform(vertex.Pos);
+            vertex.Norm = rot.Rotate(vertex.Norm);
+            model->AddVertex(vertex);
+        }
+        for (size_t i = 0; i < mesh->Indices.size(); i++)
+        {
+            model->Indices.push_back(base + mesh->Indices[i]);
+        }
+    }
+
+    void Model::MergeModels(const std::vector<Ptr<Model> >& models, size_t maxVertices, float maxExtent,
+                            std::vector<Ptr<Model> >& merged)
+    {
+        if (models.empty())
+        {
+            return;
+        }
+
+        // The world bounds of each model, from the corners of its local bounds.
+        std::vector<Bounds3f> bounds(models.size());
+        Bounds3f              centers;
+        for (size_t i = 0; i < models.size(); i++)
+        {
+            OVR_ASSERT(models[i]->Type == Prim_Triangles);
+            const Bounds3f& local  = models[i]->GetLocalBounds();
+            const Matrix4f& matrix = models[i]->GetMatrix();
+            for (int corner = 0; corner < 8; corner++)
+            {
+                bounds[i].AddPoint(matrix.Transform(Vector3f(local.b[corner & 1].x, local.b[(corner >> 1) & 1].y,
+                                                             local.b[corner >> 2].z)));
+            }
+            centers.AddPoint((bounds[i].GetMins() + bounds[i].GetMaxs()) * 0.5f);
+        }
+
+        const Vector3f size = centers.GetMaxs() - centers.GetMins();
+        const Vector3f scale(size.x > 0 ? 1023.0f / size.x : 0.0f,
+                             size.y > 0 ? 1023.0f / size.y : 0.0f,
+                             size.z > 0 ? 1023.0f / size.z : 0.0f);
+
+        std::vector<std::pair<uint32_t, uint32_t> > order(models.size());   // Morton code, model
+        for (size_t i = 0; i < models.size(); i++)
+        {
+            const Vector3f center = (bounds[i].GetMins() + bounds[i].GetMaxs()) * 0.5f;
+            const Vector3f cell = (center - centers.GetMins()).EntrywiseMultiply(scale);
+            order[i].first = SpreadMortonBits((uint32_t)Alg::Max(cell.x, 0.0f)) |
+                             (SpreadMortonBits((uint32_t)Alg::Max(cell.y, 0.0f)) << 1) |
+                             (SpreadMortonBits((uint32_t)Alg::Max(cell.z, 0.0f)) << 2);
+            order[i].second = (uint32_t)i;
+        }
+        std::sort(order.begin(), order.end());
+
+        // Runs of models along the curve that fit together, each merged once it can't grow.
+        size_t first = 0;
+        while (first < order.size())
+        {
+            const Model* firstModel = models[order[first].second];
+            Bounds3f     runBounds  = bounds[order[first].second];
+            size_t       runVertices = firstModel->Vertices.size();
+            size_t       last = first + 1;
+            for (; last < order.size(); last++)
+            {
+                const size_t i = order[last].second;
+                Bounds3f grown = runBounds;
+                grown.AddPoint(bounds[i].GetMins());
+                grown.AddPoint(bounds[i].GetMaxs());
+                const Vector3f extent = grown.GetMaxs() - grown.GetMins();
+                if ((runVertices + models[i]->Vertices.size() > maxVertices) ||
+                    (extent.x > maxExtent) || (extent.y > maxExtent) || (extent.z > maxExtent))
+                {
+                    break;
+                }
+                runBounds = grown;
+                runVertices += models[i]->Vertices.size();
+            }
+
+            if (last == first + 1)
+            {
+                merged.push_back(models[order[first].second]);
+                first = last;
+                continue;
+            }
+
+            Ptr<Model> run = *new Model(Prim_Triangles);
+            run->AssetName = firstModel->AssetName;
+            run->Fill = firstModel->Fill;
+            run->Visible = firstModel->Visible;
+            run->Layout = firstModel->Layout;
+            run->Vertices.reserve(runVertices);
+
+            int runLods = 0;
+            for (size_t r = first; r < last; r++)
+            {
+                const Model* model = models[order[r].second];
+                AppendTransformedMesh(run, model, model->GetMatrix(), model->GetOrientation());
+                runLods = Alg::Max(runLods, (int)model->Lods.size());
+            }
+
+            // Merged errors are in world units, which the models' own scale theirs to.
+            for (int lod = 0; lod < runLods; lod++)
+            {
+                Ptr<Model> runLod = *new Model(Prim_Triangles);
+                runLod->AssetName = run->AssetName;
+                runLod->Visible = run->Visible;
+                runLod->Layout = run->Layout;
+                float runError = 0.0f;
+                for (size_t r = first; r < last; r++)
+                {
+                    const Model* model = models[order[r].second];
+                    const int    level = Alg::Min(lod, (int)model->Lods.size() - 1);
+                    AppendTransformedMesh(runLod, (level >= 0) ? model->Lods[level].GetPtr() : model,
+                                          model->GetMatrix(), model->GetOrientation());
+                    if (level >= 0)
+                    {
+                        runError = Alg::Max(runError, model->LodErrors[level] * MaxAxisScale(model->GetMatrix()));
+                    }
+                }
+                run->Lods.push_back(runLod);
+                run->LodErrors.push_back(runError);
+            }
+
+            merged.push_back(run);
+            first = last;
+        }
+    }
+
+    //-------------------------------------------------------------------------------------
+    // ***** Vertex cache optimization
+    //
+    // From Tom Forsyth, "Linear-Speed Vertex Cache Optimisation". Triangles are emitted greedily,
+    // scoring each vertex by its position in a simulated LRU cache and by how many of its
+    // triangles remain, and taking the triangle whose vertices score highest.
+
+    static const int   VertexCacheSize         = 32;
+    static const float VertexCacheDecayPower   = 1.5f;
+    static const float VertexCacheLastTriScore = 0.75f;
+    static const float ValenceBoostScale       = 2.0f;
+    static const float ValenceBoostPower       = 0.5f;
+
+    static float ScoreVertex(int cachePosition, int remainingTriangles)
+    {
+        if (remainingTriangles == 0)
+        {
+            return -1.0f;   // No triangles left to take it.
+        }
+
+        float score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+            {
+                // It was used by the last triangle, so gets a fixed score whichever corner it
+                // was, or triangles sharing an edge with it would be favored too strongly.
+                score = VertexCacheLastTriScore;
+            }
+            else
+            {
+                const float scale = 1.0f / (VertexCacheSize - 3);
+                score = powf(1.0f - (cachePosition - 3) * scale, VertexCacheDecayPower);
+            }
+        }
+
+        // Favor vertices with few triangles left, to get them out of the way.
+        return score + ValenceBoostScale * powf((float)remainingTriangles, -ValenceBoostPower);
     }
 
-    Matrix4f SceneView::GetViewMatrix() const
-    {
-        Matrix4f view = Matrix4f(GetOrientation().Conj()) * Matrix4f::Translation(GetPosition());
-        return view;
-    }
+    void Model::OptimizeVertexCache()
+    {
+        OVR_ASSERT(Type == Prim_Triangles);
+        OVR_ASSERT(!VertexBuffer && !IndexBuffer);
+
+        const size_t triangleCount = Indices.size() / 3;
+        const size_t vertexCount   = Vertices.size();
+        if (triangleCount < 2)
+        {
+            return;
+        }
+
+        // Triangles of each vertex, as offsets into vertexTriangles.
+        std::vector<uint32_t> triangleStart(vertexCount + 1, 0);
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            triangleStart[Indices[i] + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            triangleStart[v + 1] += triangleStart[v];
+        }
+        std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+        std::vector<int>      remaining(vertexCount, 0);     // Unemitted triangles of each vertex
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            const uint32_t v = Indices[i];
+            vertexTriangles[triangleStart[v] + remaining[v]++] = (uint32_t)(i / 3);
+        }
+
+        std::vector<int>   cachePosition(vertexCount, -1);
+        std::vector<float> vertexScore(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            vertexScore[v] = ScoreVertex(-1, remaining[v]);
+        }
+
+        std::vector<float> triangleScore(triangleCount);
+        std::vector<bool>  emitted(triangleCount, false);
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            triangleScore[t] = vertexScore[Indices[t * 3]] + vertexScore[Indices[t * 3 + 1]] +
+                               vertexScore[Indices[t * 3 + 2]];
+        }
+
+        // The cache holds up to three more than its size while a triangle is added.
+        uint32_t cache[VertexCacheSize + 3];
+        int      cacheCount = 0;
+
+        std::vector<uint32_t> newIndices;
+        newIndices.reserve(Indices.size());
+
+        size_t nextUnemitted = 0;   // No triangle before this is unemitted.
+        size_t best = 0;
+        for (size_t t = 1; t < triangleCount; t++)
+        {
+            if (triangleScore[t] > triangleScore[best])
+            {
+                best = t;
+            }
+        }
+
+        for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+        {
+            if (best == SIZE_MAX)
+            {
+                // Nothing in the cache has triangles left, so jump to the next unemitted one.
+                while (emitted[nextUnemitted])
+                {
+                    nextUnemitted++;
+                }
+                best = nextUnemitted;
+            }
+
+            emitted[best] = true;
+
+            // Add its vertices to the front of the cache, keeping the rest in order.
+            uint32_t newCache[VertexCacheSize + 3];
+            int      newCacheCount = 0;
+            for (int corner = 0; corner < 3; corner++)
+            {
+                const uint32_t v = Indices[best * 3 + corner];
+                newIndices.push_back(v);
+                newCache[newCacheCount++] = v;
+                remaining[v]--;
+
+                // Take the triangle off the vertex's list of unemitted triangles.
+                uint32_t* tris = &vertexTriangles[triangleStart[v]];
+                for (int i = 0; i <= remaining[v]; i++)
+                {
+                    if (tris[i] == best)
+                    {
+                        tris[i] = tris[remaining[v]];
+                        break;
+                    }
+                }
+            }
+            for (int i = 0; i < cacheCount; i++)
+            {
+                const uint32_t v = cache[i];
+                if ((v != newCache[0]) && (v != newCache[1]) && (v != newCache[2]))
+                {
+                    newCache[newCacheCount++] = v;
+                }
+            }
+
+            // Rescore the cached vertices and their triangles, and find the best of those.
+            for (int i = 0; i < newCacheCount; i++)
+            {
+                const uint32_t v = newCache[i];
+                cachePosition[v] = (i < VertexCacheSize) ? i : -1;
+                vertexScore[v] = ScoreVertex(cachePosition[v], remaining[v]);
+            }
+
+            best = SIZE_MAX;
+            float bestScore = -1.0f;
+            for (int i = 0; i < newCacheCount; i++)
+            {
+                const uint32_t v = newCache[i];
+                const uint32_t* tris = &vertexTriangles[triangleStart[v]];
+                for (int j = 0; j < remaining[v]; j++)
+                {
+                    const uint32_t t = tris[j];
+                    const float score = vertexScore[Indices[t * 3]] + vertexScore[Indices[t * 3 + 1]] +
+                                        vertexScore[Indices[t * 3 + 2]];
+                    triangleScore[t] = score;
+                    if (score > bestScore)
+                    {
+                        bestScore = score;
+                        best = t;
+                    }
+                }
+            }
+
+            cacheCount = Alg::Min(newCacheCount, (int)VertexCacheSize);
+            memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+        }
+
+        // Renumber the vertices in order of first use. Unused ones go at the end.
+        std::vector<uint32_t> remap(vertexCount, UINT_MAX);
+        std::vector<Vertex>   newVertices;
+        newVertices.reserve(vertexCount);
+        for (size_t i = 0; i < newIndices.size(); i++)
+        {
+            const uint32_t v = newIndices[i];
+            if (remap[v] == UINT_MAX)
+            {
+                remap[v] = (uint32_t)newVertices.size();
+                newVertices.push_back(Vertices[v]);
+            }
+            newIndices[i] = remap[v];
+        }
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            if (remap[v] == UINT_MAX)
+            {
+                newVertices.push_back(Vertices[v]);
+            }
+        }
+
+        Vertices.swap(newVertices);
+        Indices.swap(newIndices);
+    }
+
+    //-------------------------------------------------------------------------------------
+    // ***** Mesh simplification
+    //
+    // From Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics". Each
+    // vertex keeps the sum of the squared distances to the planes of its triangles, as a quadric;
+    // a collapse adds the two vertices' and costs what that gives at the position kept. Collapses
+    // are made cheapest first from a heap, skipping entries made stale by an earlier collapse.
+
+    // The quadric of planes ax + by + cz + d = 0, as the upper triangle of its symmetric matrix.
+    struct SimplifyQuadric
+    {
+        double A2, AB, AC, AD, B2, BC, BD, C2, CD, D2;
+
+        SimplifyQuadric() : A2(0), AB(0), AC(0), AD(0), B2(0), BC(0), BD(0), C2(0), CD(0), D2(0) { }
+
+        void AddPlane(double a, double b, double c, double d)
+        {
+            A2 += a * a; AB += a * b; AC += a * c; AD += a * d;
+            B2 += b * b; BC += b * c; BD += b * d;
+            C2 += c * c; CD += c * d;
+            D2 += d * d;
+        }
+
+        void Add(const SimplifyQuadric& q)
+        {
+            A2 += q.A2; AB += q.AB; AC += q.AC; AD += q.AD;
+            B2 += q.B2; BC += q.BC; BD += q.BD;
+            C2 += q.C2; CD += q.CD;
+            D2 += q.D2;
+        }
+
+        // The sum of the squared distances from p to the planes.
+        double Error(const Vector3f& p) const
+        {
+            const double x = p.x, y = p.y, z = p.z;
+            return A2 * x * x + B2 * y * y + C2 * z * z + D2 +
+                   2.0 * (AB * x * y + AC * x * z + BC * y * z + AD * x + BD * y + CD * z);
+        }
+    };
+
+    struct SimplifyCollapse
+    {
+        double   Cost;
+        uint32_t From, To;
+        uint32_t FromVersion, ToVersion;    // The vertices' versions when the cost was found.
+
+        // Orders the heap cheapest first.
+        bool operator<(const SimplifyCollapse& other) const { return Cost > other.Cost; }
+    };
+
+    static bool LessPosition(const Vector3f& a, const Vector3f& b)
+    {
+        return (a.x != b.x) ? (a.x < b.x) : (a.y != b.y) ? (a.y < b.y) : (a.z < b.z);
+    }
+
+    Model* Model::Simplify(size_t targetTriangles, float& error) const
+    {
+        OVR_ASSERT(Type == Prim_Triangles);
+
+        const size_t vertexCount = Vertices.size();
+        const size_t cornerCount = Indices.size() - (Indices.size() % 3);
+        std::vector<uint32_t> indices(Indices.begin(), Indices.begin() + cornerCount);
+        size_t triangleCount = cornerCount / 3;
+        error = 0.0f;
+
+        // Live triangles of each vertex. Lists may hold dead ones, which are skipped.
+        std::vector<std::vector<uint32_t> > vertexTriangles(vertexCount);
+        for (size_t i = 0; i < cornerCount; i++)
+        {
+            vertexTriangles[indices[i]].push_back((uint32_t)(i / 3));
+        }
+        std::vector<uint8_t> deadTriangle(triangleCount, 0);
+
+        // A vertex sharing its position with another, as at a texture seam, is neither moved nor
+        // collapsed onto, so that both sides of the seam keep meeting. One on an open or
+        // non-manifold edge isn't moved either, so the outline stays where it is.
+        std::vector<uint8_t> seam(vertexCount, 0), fixed(vertexCount, 0);
+        {
+            std::vector<uint32_t> byPosition(vertexCount);
+            for (size_t v = 0; v < vertexCount; v++)
+            {
+                byPosition[v] = (uint32_t)v;
+            }
+            std::sort(byPosition.begin(), byPosition.end(), [this](uint32_t a, uint32_t b)
+                      { return LessPosition(Vertices[a].Pos, Vertices[b].Pos); });
+            for (size_t i = 1; i < vertexCount; i++)
+            {
+                if (Vertices[byPosition[i - 1]].Pos == Vertices[byPosition[i]].Pos)
+                {
+                    seam[byPosition[i - 1]] = seam[byPosition[i]] = 1;
+                }
+            }
+        }
+
+        // The other corners of v's live triangles, a neighbour once for each triangle it shares.
+        std::vector<uint32_t> neighbours;
+        auto gatherNeighbours = [&](uint32_t v, std::vector<uint32_t>& result)
+        {
+            result.clear();
+            for (uint32_t t : vertexTriangles[v])
+            {
+                if (!deadTriangle[t])
+                {
+                    for (int corner = 0; corner < 3; corner++)
+                    {
+                        if (indices[t * 3 + corner] != v)
+                        {
+                            result.push_back(indices[t * 3 + corner]);
+                        }
+                    }
+                }
+            }
+            std::sort(result.begin(), result.end());
+        };
+
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            fixed[v] = seam[v];
+            gatherNeighbours((uint32_t)v, neighbours);
+            for (size_t i = 0; (i < neighbours.size()) && !fixed[v]; )
+            {
+                size_t j = i;
+                while ((j < neighbours.size()) && (neighbours[j] == neighbours[i]))
+                {
+                    j++;
+                }
+                fixed[v] = (j - i != 2);
+                i = j;
+            }
+        }
+
+        std::vector<SimplifyQuadric> quadrics(vertexCount);
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            const Vector3f& p0 = Vertices[indices[t * 3]].Pos;
+            const Vector3f  n  = (Vertices[indices[t * 3 + 1]].Pos - p0).Cross(Vertices[indices[t * 3 + 2]].Pos - p0);
+            const float     length = n.Length();
+            if (length > 0.0f)
+            {
+                const Vector3f unit = n / length;
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    quadrics[indices[t * 3 + corner]].AddPlane(unit.x, unit.y, unit.z, -unit.Dot(p0));
+                }
+            }
+        }
+
+        std::vector<uint32_t>         versions(vertexCount, 0);
+        std::vector<SimplifyCollapse> heap;
+        auto pushCollapse = [&](uint32_t from, uint32_t to)
+        {
+            if (!fixed[from] && !seam[to])
+            {
+                SimplifyQuadric q = quadrics[from];
+                q.Add(quadrics[to]);
+                const SimplifyCollapse collapse = { q.Error(Vertices[to].Pos), from, to, versions[from], versions[to] };
+                heap.push_back(collapse);
+                std::push_heap(heap.begin(), heap.end());
+            }
+        };
+        for (size_t i = 0; i < cornerCount; i++)
+        {
+            const uint32_t a = indices[i];
+            const uint32_t b = indices[(i % 3 == 2) ? i - 2 : i + 1];
+            pushCollapse(a, b);
+            pushCollapse(b, a);
+        }
+
+        std::vector<uint32_t> toNeighbours, shared;
+        while ((triangleCount > targetTriangles) && !heap.empty())
+        {
+            std::pop_heap(heap.begin(), heap.end());
+            const SimplifyCollapse collapse = heap.back();
+            heap.pop_back();
+            const uint32_t u = collapse.From, v = collapse.To;
+            if ((collapse.FromVersion != versions[u]) || (collapse.ToVersion != versions[v]))
+            {
+                continue;
+            }
+
+            // The edge must still be there with a triangle each side, and u and v share no other
+            // neighbour, or the collapse would pinch the surface.
+            gatherNeighbours(u, neighbours);
+            gatherNeighbours(v, toNeighbours);
+            neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+            toNeighbours.erase(std::unique(toNeighbours.begin(), toNeighbours.end()), toNeighbours.end());
+            shared.clear();
+            std::set_intersection(neighbours.begin(), neighbours.end(), toNeighbours.begin(), toNeighbours.end(),
+                                  std::back_inserter(shared));
+            if (!std::binary_search(neighbours.begin(), neighbours.end(), v) || (shared.size() != 2))
+            {
+                continue;
+            }
+
+            // Nor may moving u flip or flatten one of its triangles that stays.
+            const Vector3f& from = Vertices[u].Pos;
+            const Vector3f& to   = Vertices[v].Pos;
+            bool flips = false;
+            for (uint32_t t : vertexTriangles[u])
+            {
+                const uint32_t* tri = &indices[t * 3];
+                if (deadTriangle[t] || (tri[0] == v) || (tri[1] == v) || (tri[2] == v))
+                {
+                    continue;
+                }
+                const int       corner = (tri[0] == u) ? 0 : (tri[1] == u) ? 1 : 2;
+                const Vector3f& p1 = Vertices[tri[(corner + 1) % 3]].Pos;
+                const Vector3f& p2 = Vertices[tri[(corner + 2) % 3]].Pos;
+                const Vector3f  before = (p1 - from).Cross(p2 - from);
+                const Vector3f  after  = (p1 - to).Cross(p2 - to);
+                if (after.Dot(before) <= 0.25f * after.Length() * before.Length())
+                {
+                    flips = true;
+                    break;
+                }
+            }
+            if (flips)
+            {
+                continue;
+            }
+
+            for (uint32_t t : vertexTriangles[u])
+            {
+                uint32_t* tri = &indices[t * 3];
+                if (deadTriangle[t])
+                {
+                    continue;
+                }
+                if ((tri[0] == v) || (tri[1] == v) || (tri[2] == v))
+                {
+                    deadTriangle[t] = 1;
+                    triangleCount--;
+                    continue;
+                }
+                for (int corner = 0; corner < 3; corner++)
+                {
+                    tri[corner] = (tri[corner] == u) ? v : tri[corner];
+                }
+                vertexTriangles[v].push_back(t);
+            }
+            vertexTriangles[u].clear();
+            std::vector<uint32_t>& toTriangles = vertexTriangles[v];
+            toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(),
+                                             [&](uint32_t t) { return deadTriangle[t] != 0; }),
+                              toTriangles.end());
+
+            quadrics[v].Add(quadrics[u]);
+            versions[u]++;
+            versions[v]++;
+            error = Alg::Max(error, (float)sqrt(Alg::Max(collapse.Cost, 0.0)));
+
+            gatherNeighbours(v, neighbours);
+            neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+            for (uint32_t n : neighbours)
+            {
+                pushCollapse(n, v);
+                pushCollapse(v, n);
+            }
+        }
+
+        // Keep only the vertices still used.
+        Model* mesh = new Model(Prim_Triangles);
+        mesh->AssetName = AssetName;
+        mesh->Visible = Visible;
+        mesh->Layout = Layout;
+        mesh->Indices.reserve(triangleCount * 3);
+        std::vector<uint32_t> remap(vertexCount, UINT_MAX);
+        for (size_t i = 0; i < cornerCount; i++)
+        {
+            if (deadTriangle[i / 3])
+            {
+                continue;
+            }
+            const uint32_t v = indices[i];
+            if (remap[v] == UINT_MAX)
+            {
+                remap[v] = mesh->AddVertex(Vertices[v]);
+            }
+            mesh->Indices.push_back(remap[v]);
+        }
+        mesh->OptimizeVertexCache();
+        return mesh;
+    }
+
+    void Model::GenerateLods(int maxLods, size_t minTriangles)
+    {
+        Lods.clear();
+        LodErrors.clear();
+        CurrentLod = 0;
+        if (Type != Prim_Triangles)
+        {
+            return;
+        }
+
+        // Each level simplifies the one before, so its error is theirs added up.
+        const Model* previous = this;
+        float        error = 0.0f;
+        for (int lod = 0; lod < maxLods; lod++)
+        {
+            const size_t triangles = previous->Indices.size() / 3;
+            if (triangles < minTriangles)
+            {
+                break;
+            }
+            float      lodError = 0.0f;
+            Ptr<Model> mesh = *previous->Simplify(triangles / 2, lodError);
+            if (mesh->Indices.size() / 3 > triangles * 3 / 4)
+            {
+                break;  // Mostly seams and outline, which the next level wouldn't get much further with.
+            }
+            error += lodError;
+            Lods.push_back(mesh);
+            LodErrors.push_back(error);
+            previous = mesh;
+        }
+    }
+
+    const float Model::LodHysteresis = 0.25f;
+
+    int Model::SelectLod(float errorScale, float maxError)
+    {
+        const int count = (int)Lods.size();
+        int       lod = Alg::Min(CurrentLod, count);
+        while ((lod < count) && (LodErrors[lod] * errorScale <= maxError * (1.0f - LodHysteresis)))
+        {
+            lod++;
+        }
+        while ((lod > 0) && (LodErrors[lod - 1] * errorScale > maxError * (1.0f + LodHysteresis)))
+        {
+            lod--;
+        }
+        CurrentLod = lod;
+
+        if (lod > 0)
+        {
+            Model* mesh = Lods[lod - 1];
+            if (mesh->Fill != Fill)
+            {
+                mesh->Fill = Fill;
+            }
+            mesh->SetVertexLayout(Layout);
+        }
+        return lod;
+    }
+
+    uint32_t Container::TopologyVersion = 0;
+
+    void Container::Render(const Matrix4f& ltw, RenderDevice* ren)
+    {
+        Matrix4f m = ltw * GetMatrix();
+        for(size_t i = 0; i < Nodes.size(); i++)
+        {
+            Nodes[i]->Render(m, ren);
+        }
+    }
+
+    int Container::UpdateCulling(const Matrix4f& ltw, const FrustumCuller* culler)
+    {
+        Matrix4f m = ltw * GetMatrix();
+        int culledCount = 0;
+        for(size_t i = 0; i < Nodes.size(); i++)
+        {
+            culledCount += Nodes[i]->UpdateCulling(m, culler);
+        }
+        return culledCount;
+    }
+
+    void Container::CollectDrawItems(const Matrix4f& ltw, RenderQueue& queue)
+    {
+        Matrix4f m = ltw * GetMatrix();
+        for(size_t i = 0; i < Nodes.size(); i++)
+        {
+            Nodes[i]->CollectDrawItems(m, queue);
+        }
+    }
+
+    void SceneTransforms::Build(Container& root)
+    {
+        Clear();
+        add(&root, -1);
+        WorldChanged.resize(Nodes.size());
+        BuiltVersion = Container::TopologyVersion;
+        Built = true;
+
+        // Every node's world matrix needs computing after a build.
+        SeenVersions.resize(Nodes.size());
+        for (size_t i = 0; i < Nodes.size(); i++)
+        {
+            SeenVersions[i] = Nodes[i]->TransformVersion - 1;
+        }
+    }
+
+    void SceneTransforms::add(Node* node, int32_t parent)
+    {
+        const int32_t index = (int32_t)Nodes.size();
+        Nodes.push_back(node);
+        Parents.push_back(parent);
+        LocalMatrices.push_back(Matrix4f());
+        WorldMatrices.push_back(Matrix4f());
+
+        if (node->GetType() == Node::Node_Container)
+        {
+            Container* container = (Container*)node;
+            for (size_t i = 0; i < container->Nodes.size(); i++)
+            {
+                add(container->Nodes[i], index);
+            }
+        }
+    }
+
+    void SceneTransforms::Clear()
+    {
+        Nodes.clear();
+        Parents.clear();
+        LocalMatrices.clear();
+        WorldMatrices.clear();
+        SeenVersions.clear();
+        WorldChanged.clear();
+        Built = false;
+    }
+
+    void SceneTransforms::Update(Container& root)
+    {
+        if (!Built || (BuiltVersion != Container::TopologyVersion) || Nodes.empty() || (Nodes[0] != &root))
+        {
+            Build(root);
+        }
+
+        // Parents come before their children, so one pass sees each parent's change first.
+        for (size_t i = 0; i < Nodes.size(); i++)
+        {
+            Node* node = Nodes[i];
+            const int32_t parent = Parents[i];
+            bool changed = (parent >= 0) && WorldChanged[parent];
+            if (SeenVersions[i] != node->TransformVersion)
+            {
+                LocalMatrices[i] = node->GetMatrix();
+                SeenVersions[i] = node->TransformVersion;
+                changed = true;
+            }
+            if (changed)
+            {
+                WorldMatrices[i] = (parent >= 0) ? WorldMatrices[parent] * LocalMatrices[i] : LocalMatrices[i];
+            }
+            WorldChanged[i] = changed;
+        }
+    }
+
+    bool FrustumCuller::AddFrustum(const Matrix4f& clipFromWorld)
+    {
+        if (FrustumCount >= MaxFrustums)
+        {
+            return false;
+        }
+
+        // The side planes are w + x >= 0, w - x >= 0, w + y >= 0 and w - y >= 0 in clip space.
+        static const int   axis[4] = { 0, 0, 1, 1 };
+        static const float sign[4] = { 1.0f, -1.0f, 1.0f, -1.0f };
+        const Matrix4f& m = clipFromWorld;
+
+        for (int i = 0; i < 4; i++)
+        {
+            const int a = axis[i];
+            PlaneX[FrustumCount][i] = m.M[3][0] + sign[i] * m.M[a][0];
+            PlaneY[FrustumCount][i] = m.M[3][1] + sign[i] * m.M[a][1];
+            PlaneZ[FrustumCount][i] = m.M[3][2] + sign[i] * m.M[a][2];
+            PlaneW[FrustumCount][i] = m.M[3][3] + sign[i] * m.M[a][3];
+        }
+
+        FrustumCount++;
+        return true;
+    }
+
+    bool FrustumCuller::IsVisible(const Vector3f& center, const Vector3f& halfExtents) const
+    {
+        // The box is outside a plane if its center is further outside than the box's extent
+        // along the plane normal, and outside the frustum if it is outside any plane.
+#if defined(OVR_MATH_SSE2)
+        const __m128 cx = _mm_set1_ps(center.x);
+        const __m128 cy = _mm_set1_ps(center.y);
+        const __m128 cz = _mm_set1_ps(center.z);
+        const __m128 ex = _mm_set1_ps(halfExtents.x);
+        const __m128 ey = _mm_set1_ps(halfExtents.y);
+        const __m128 ez = _mm_set1_ps(halfExtents.z);
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        const __m128 zero = _mm_setzero_ps();
+
+        for (int f = 0; f < FrustumCount; f++)
+        {
+            const __m128 px = _mm_loadu_ps(PlaneX[f]);
+            const __m128 py = _mm_loadu_ps(PlaneY[f]);
+            const __m128 pz = _mm_loadu_ps(PlaneZ[f]);
+            const __m128 pw = _mm_loadu_ps(PlaneW[f]);
+
+            const __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)),
+                _mm_add_ps(_mm_mul_ps(pz, cz), pw));
+            const __m128 radius = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, px), ex),
+                           _mm_mul_ps(_mm_andnot_ps(signMask, py), ey)),
+                _mm_mul_ps(_mm_andnot_ps(signMask, pz), ez));
+
+            if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), zero)) == 0)
+            {
+                return true;
+            }
+        }
+#else
+        for (int f = 0; f < FrustumCount; f++)
+        {
+            bool inside = true;
+            for (int i = 0; (i < 4) && inside; i++)
+            {
+                const float distance = PlaneX[f][i] * center.x + PlaneY[f][i] * center.y +
+                                       PlaneZ[f][i] * center.z + PlaneW[f][i];
+                const float radius = fabsf(PlaneX[f][i]) * halfExtents.x +
+                                     fabsf(PlaneY[f][i]) * halfExtents.y +
+                                     fabsf(PlaneZ[f][i]) * halfExtents.z;
+                inside = (distance + radius >= 0.0f);
+            }
+            if (inside)
+            {
+                return true;
+            }
+        }
+#endif
+        return false;
+    }
+
+    bool FrustumCuller::IsVisible(const Bounds3f& localBounds, const Matrix4f& ltw) const
+    {
+        const Vector3f& mins = localBounds.GetMins();
+        const Vector3f& maxs = localBounds.GetMaxs();
+        if ((mins.x > maxs.x) || (mins.y > maxs.y) || (mins.z > maxs.z))
+        {
+            return true;
+        }
+
+        // The world box enclosing the transformed local box.
+        const Vector3f localCenter = (mins + maxs) * 0.5f;
+        const Vector3f localHalfExtents = (maxs - mins) * 0.5f;
+        const Vector3f center = ltw.Transform(localCenter);
+        Vector3f halfExtents;
+        for (int r = 0; r < 3; r++)
+        {
+            halfExtents[r] = fabsf(ltw.M[r][0]) * localHalfExtents.x +
+                             fabsf(ltw.M[r][1]) * localHalfExtents.y +
+                             fabsf(ltw.M[r][2]) * localHalfExtents.z;
+        }
+
+        return IsVisible(center, halfExtents);
+    }
+
+    void RenderQueue::Clear()
+    {
+        Items.clear();
+        Order.clear();
+        Built = false;
+    }
+
+    void RenderQueue::Add(Model* model, const Matrix4f& worldFromModel)
+    {
+        Item item;
+        item.pModel = model;
+        item.WorldFromModel = worldFromModel;
+        Items.push_back(item);
+        Built = false;
+    }
+
+    // Returns the index of p in the sorted, unique pointers.
+    static uint64_t pointerRank(const std::vector<const void*>& sorted, const void* p)
+    {
+        return (uint64_t)(std::lower_bound(sorted.begin(), sorted.end(), p) - sorted.begin());
+    }
+
+    static const void* drawItemShaders(const Model* model)
+    {
+        return model->Fill ? (const void*)static_cast<ShaderFill*>(model->Fill.GetPtr())->GetShaders() : nullptr;
+    }
+
+    void RenderQueue::Sort(const Vector3f& viewPos)
+    {
+        const size_t count = Items.size();
+
+        // The keys hold the shader set's rank in the top 16 bits, the fill's in the next 16, and
+        // the distance to the model's bounds in the low 32, whose float bits sort like the
+        // distances since they're not negative. Ranks rather than pointers keep a group together
+        // when a pointer doesn't fit in 16 bits.
+        std::vector<const void*> shaders(count), fills(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            shaders[i] = drawItemShaders(Items[i].pModel);
+            fills[i] = Items[i].pModel->Fill.GetPtr();
+        }
+        std::sort(shaders.begin(), shaders.end());
+        shaders.erase(std::unique(shaders.begin(), shaders.end()), shaders.end());
+        std::sort(fills.begin(), fills.end());
+        fills.erase(std::unique(fills.begin(), fills.end()), fills.end());
+
+        Keys.resize(count);
+        Order.resize(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            const Item& item = Items[i];
+            const Bounds3f& bounds = item.pModel->GetLocalBounds();
+            Vector3f center = item.WorldFromModel.GetTranslation();
+            if (bounds.GetMins().x <= bounds.GetMaxs().x)
+            {
+                center = item.WorldFromModel.Transform((bounds.GetMins() + bounds.GetMaxs()) * 0.5f);
+            }
+            const float distance = (center - viewPos).Length();
+            uint32_t distanceBits;
+            memcpy(&distanceBits, &distance, sizeof(distanceBits));
+
+            const uint64_t shaderRank = std::min<uint64_t>(pointerRank(shaders, drawItemShaders(item.pModel)), 0xffff);
+            const uint64_t fillRank = std::min<uint64_t>(pointerRank(fills, item.pModel->Fill.GetPtr()), 0xffff);
+            Keys[i] = (shaderRank << 48) | (fillRank << 32) | distanceBits;
+            Order[i] = (uint32_t)i;
+        }
+
+        // A depth pass sets next to no state, so it just goes nearest first.
+        DepthOrder.assign(Order.begin(), Order.end());
+        std::sort(DepthOrder.begin(), DepthOrder.end(),
+                  [this](uint32_t a, uint32_t b) { return (uint32_t)Keys[a] < (uint32_t)Keys[b]; });
+
+        // LSD radix sort on the key bytes, skipping the bytes which are the same in every key.
+        uint64_t allOr = 0, allAnd = ~uint64_t(0);
+        for (size_t i = 0; i < count; i++)
+        {
+            allOr |= Keys[i];
+            allAnd &= Keys[i];
+        }
+        const uint64_t varying = allOr ^ allAnd;
+
+        KeyScratch.resize(count);
+        OrderScratch.resize(count);
+        for (int shift = 0; shift < 64; shift += 8)
+        {
+            if (((varying >> shift) & 0xff) == 0)
+            {
+                continue;
+            }
+
+            size_t offsets[256] = { 0 };
+            for (size_t i = 0; i < count; i++)
+            {
+                offsets[(Keys[i] >> shift) & 0xff]++;
+            }
+            size_t total = 0;
+            for (int b = 0; b < 256; b++)
+            {
+                const size_t n = offsets[b];
+                offsets[b] = total;
+                total += n;
+            }
+            for (size_t i = 0; i < count; i++)
+            {
+                const size_t dest = offsets[(Keys[i] >> shift) & 0xff]++;
+                KeyScratch[dest] = Keys[i];
+                OrderScratch[dest] = Order[i];
+            }
+            Keys.swap(KeyScratch);
+            Order.swap(OrderScratch);
+        }
+
+        Built = true;
+    }
+
+    bool RenderQueue::HasRenderBuffers() const
+    {
+        for (const Item& item : Items)
+        {
+            if (!item.pModel->HasDrawBuffers())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void RenderQueue::Render(RenderDevice* ren, const Matrix4f& view) const
+    {
+        OVR_ASSERT(Built);
+
+        if (ren->IsParallelRecordingEnabled() && HasRenderBuffers())
+        {
+            auto recordRange = [&](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    const Item& item = Items[Order[i]];
+                    ren->RenderModel(view * item.WorldFromModel, item.pModel);
+                }
+            };
+            if (ren->RecordParallel(Order.size(), recordRange))
+            {
+                return;
+            }
+        }
+
+        ren->BeginFillBatch();
+        for (size_t i = 0; i < Order.size(); i++)
+        {
+            const Item& item = Items[Order[i]];
+            ren->RenderModel(view * item.WorldFromModel, item.pModel);
+        }
+        ren->EndFillBatch();
+    }
+
+    void RenderQueue::RenderDepth(RenderDevice* ren, const Matrix4f& view) const
+    {
+        OVR_ASSERT(Built);
+
+        ren->SetColorWrite(false);
+        ren->BeginFillBatch();
+        for (size_t i = 0; i < DepthOrder.size(); i++)
+        {
+            const Item& item = Items[DepthOrder[i]];
+            ren->RenderModelDepth(view * item.WorldFromModel, item.pModel);
+        }
+        ren->EndFillBatch();
+        ren->SetColorWrite(true);
+    }
+
+    Matrix4f SceneView::GetViewMatrix() const
+    {
+        Matrix4f view = Matrix4f(GetOrientation().Conj()) * Matrix4f::Translation(GetPosition());
+        return view;
+    }
+
+    void LightingParams::Update(const Matrix4f& view, const Vector3f* SceneLightPos)
+    {
+        Version++;
+        for (int i = 0; i < LightCount; i++)
+        {
+            LightPos[i] = view.Transform(SceneLightPos[i]);
+        }
+    }
+
+    void Scene::Render(RenderDevice* ren, const Matrix4f& view)
+    {
+        AutoGpuProf prof(ren, "Scene_Render");
+
+        Lighting.Update(view, LightPos);
+
+        ren->SetLighting(&Lighting);
+
+        UpdateTransforms();
+        for (size_t i = 0; i < Transforms.GetCount(); i++)
+        {
+            Node* node = Transforms.GetNode(i);
+            if (node->GetType() == Node::Node_Model)
+            {
+                ((Model*)node)->RenderAt(view * Transforms.GetWorldMatrix(i), ren);
+            }
+        }
+    }
+
+    void Scene::BuildRenderQueue(RenderQueue& queue, const Vector3f& viewPos)
+    {
+        queue.Clear();
+        UpdateTransforms();
+        for (size_t i = 0; i < Transforms.GetCount(); i++)
+        {
+            Node* node = Transforms.GetNode(i);
+            if (node->GetType() == Node::Node_Model)
+            {
+                Model* model = (Model*)node;
+                if (model->Visible && !model->Culled && !model->Occluded)
+                {
+                    queue.Add(model, Transforms.GetWorldMatrix(i));
+                }
+            }
+        }
+        queue.Sort(viewPos);
+    }
+
+    void Scene::Render(RenderDevice* ren, const Matrix4f& view, const RenderQueue& queue)
+    {
+        AutoGpuProf prof(ren, "Scene_Render");
+
+        Lighting.Update(view, LightPos);
+
+        ren->SetLighting(&Lighting);
+
+        queue.Render(ren, view);
+    }
+
+    void Scene::RenderDepth(RenderDevice* ren, const Matrix4f& view, const RenderQueue& queue)
+    {
+        AutoGpuProf prof(ren, "Scene_RenderDepth");
+
+        queue.RenderDepth(ren, view);
+    }
+
+    int Scene::UpdateCulling(const FrustumCuller& culler)
+    {
+        if (culler.GetFrustumCount() == 0)
+        {
+            ClearCulling();
+            return 0;
+        }
+
+        UpdateTransforms();
+        int culledCount = 0;
+        for (size_t i = 0; i < Transforms.GetCount(); i++)
+        {
+            Node* node = Transforms.GetNode(i);
+            if (node->GetType() == Node::Node_Model)
+            {
+                culledCount += ((Model*)node)->UpdateCullingAt(Transforms.GetWorldMatrix(i), &culler);
+            }
+        }
+        return culledCount;
+    }
+
+    void Scene::ClearCulling()
+    {
+        World.UpdateCulling(Matrix4f::Identity(), nullptr);
+    }
+
+    int Scene::SelectLods(const Vector3f& viewPos, float pixelsPerUnit, float maxPixelError)
+    {
+        UpdateTransforms();
+        int reducedCount = 0;
+        for (size_t i = 0; i < Transforms.GetCount(); i++)
+        {
+            Node* node = Transforms.GetNode(i);
+            if (node->GetType() != Node::Node_Model)
+            {
+                continue;
+            }
+            Model* model = (Model*)node;
+            if (model->Lods.empty() || !model->Visible || model->Culled)
+            {
+                continue;
+            }
+
+            // The distance to the nearest point of the world bounds, from the corners of the local
+            // ones. Errors are in model units, and instances are taken to be unscaled.
+            const Matrix4f& worldFromModel = Transforms.GetWorldMatrix(i);
+            const Bounds3f& local = model->GetLocalBounds();
+            Bounds3f        world;
+            for (int corner = 0; corner < 8; corner++)
+            {
+                world.AddPoint(worldFromModel.Transform(Vector3f(local.b[corner & 1].x, local.b[(corner >> 1) & 1].y,
+                                                                 local.b[corner >> 2].z)));
+            }
+            const Vector3f nearest(Alg::Clamp(viewPos.x, world.GetMins().x, world.GetMaxs().x),
+                                   Alg::Clamp(viewPos.y, world.GetMins().y, world.GetMaxs().y),
+                                   Alg::Clamp(viewPos.z, world.GetMins().z, world.GetMaxs().z));
+            const float distance = Alg::Max((nearest - viewPos).Length(), 0.001f);
+
+            const float errorScale = MaxAxisScale(worldFromModel) * pixelsPerUnit / distance;
+            reducedCount += (model->SelectLod(errorScale, maxPixelError) > 0) ? 1 : 0;
+        }
+        return reducedCount;
+    }
+
+    void Scene::ClearLods()
+    {
+        UpdateTransforms();
+        for (size_t i = 0; i < Transforms.GetCount(); i++)
+        {
+            Node* node = Transforms.GetNode(i);
+            if (node->GetType() == Node::Node_Model)
+            {
+                ((Model*)node)->CurrentLod = 0;
+            }
+        }
+    }
+
+    void OcclusionCuller::Clear()
+    {
+        Frames.clear();
+        Hidden.clear();
+        FrameSerial = 0;
+    }
+
+    int OcclusionCuller::Update(RenderDevice* ren, Scene& scene)
+    {
+        OVR_UNUSED(scene);
+
+        if (ren->BeginOcclusionFrame(FrameSerial))
+        {
+            // Frames older than the one read back won't be, as the device keeps the newest.
+            const uint64_t serial = ren->GetOcclusionSamplesSerial();
+            while (!Frames.empty() && (Frames.front().Serial < serial))
+            {
+                Frames.pop_front();
+            }
+
+            if (!Frames.empty() && (Frames.front().Serial == serial))
+            {
+                // Each view tested the models in the same order, so sorting by model, stably,
+                // brings a model's tests together.
+                std::vector<Test>& tests = Frames.front().Tests;
+                std::stable_sort(tests.begin(), tests.end(),
+                                 [](const Test& a, const Test& b) { return a.pModel.GetPtr() < b.pModel.GetPtr(); });
+
+                const std::vector<uint64_t>& samples = ren->GetOcclusionSamples();
+                Hidden.clear();
+                for (size_t first = 0; first < tests.size(); )
+                {
+                    size_t last = first;
+                    bool seen = false;
+                    for (; (last < tests.size()) && (tests[last].pModel == tests[first].pModel); last++)
+                    {
+                        const int query = tests[last].Query;
+                        seen = seen || (query < 0) || (query >= (int)samples.size()) || (samples[query] != 0);
+                    }
+                    if (!seen)
+                    {
+                        Hidden.push_back(tests[first].pModel);
+                    }
+                    first = last;
+                }
+                Frames.pop_front();
+            }
+        }
+
+        int occludedCount = 0;
+        for (const Ptr<Model>& model : Hidden)
+        {
+            if (model->Visible && !model->Culled)
+            {
+                model->Occluded = true;
+                occludedCount++;
+            }
+        }
+        return occludedCount;
+    }
+
+    void OcclusionCuller::TestView(RenderDevice* ren, Scene& scene, const Matrix4f& view, RenderDevice::CompareFunc depthFunc)
+    {
+        if (FrameSerial == 0)
+        {
+            return;
+        }
+
+        if (Frames.empty() || (Frames.back().Serial != FrameSerial))
+        {
+            Frames.push_back(Frame());
+            Frames.back().Serial = FrameSerial;
+        }
+        std::vector<Test>& tests = Frames.back().Tests;
+
+        AutoGpuProf prof(ren, "OcclusionTests");
+
+        const Vector3f eye = view.Inverted().GetTranslation();
+
+        ren->SetColorWrite(false);
+        ren->SetDepthMode(true, false, depthFunc);
+        ren->SetCullMode(RenderDevice::Cull_Off);
+
+        scene.UpdateTransforms();
+        for (size_t i = 0; i < scene.Transforms.GetCount(); i++)
+        {
+            Node* node = scene.Transforms.GetNode(i);
+            if (node->GetType() != Node::Node_Model)
+            {
+                continue;
+            }
+
+            Model* model = (Model*)node;
+            if (!model->Visible || model->Culled)
+            {
+                continue;
+            }
+
+            Test test;
+            test.pModel = model;
+            test.Query = -1;
 
-    void LightingParams::Update(const Matrix4f& view, const Vector3f* SceneLightPos)
-    {
-        Version++;
-        for (int i = 0; i < LightCount; i++)
-        {
-            LightPos[i] = view.Transform(SceneLightPos[i]);
+            const Bounds3f& localBounds = model->GetLocalBounds();
+            const Vector3f& mins = localBounds.GetMins();
+            const Vector3f& maxs = localBounds.GetMaxs();
+            if ((mins.x <= maxs.x) && (mins.y <= maxs.y) && (mins.z <= maxs.z))
+            {
+                const Bounds3f box(mins - Vector3f(BoxMargin), maxs + Vector3f(BoxMargin));
+                const Matrix4f& worldFromModel = scene.Transforms.GetWorldMatrix(i);
+
+                // The eye against the world box enclosing the model's, as FrustumCuller does.
+                const Vector3f localCenter = (box.GetMins() + box.GetMaxs()) * 0.5f;
+                const Vector3f localHalfExtents = (box.GetMaxs() - box.GetMins()) * 0.5f;
+                const Vector3f toEye = eye - worldFromModel.Transform(localCenter);
+                bool eyeNear = true;
+                for (int r = 0; r < 3; r++)
+                {
+                    const float halfExtent = fabsf(worldFromModel.M[r][0]) * localHalfExtents.x +
+                                             fabsf(worldFromModel.M[r][1]) * localHalfExtents.y +
+                                             fabsf(worldFromModel.M[r][2]) * localHalfExtents.z;
+                    eyeNear = eyeNear && (fabsf(toEye[r]) <= halfExtent + EyeMargin);
+                }
+
+                if (!eyeNear)
+                {
+                    test.Query = ren->TestOcclusionBox(box, view * worldFromModel);
+                }
+            }
+            tests.push_back(test);
         }
+
+        ren->SetCullMode(RenderDevice::Cull_Back);
+        ren->SetDepthMode(true, true, depthFunc);
+        ren->SetColorWrite(true);
     }
 
-    void Scene::Render(RenderDevice* ren, const Matrix4f& view)
+    void OcclusionCuller::EndFrame(RenderDevice* ren)
     {
-        AutoGpuProf prof(ren, "Scene_Render");
-
-        Lighting.Update(view, LightPos);
-
-        ren->SetLighting(&Lighting);
-
-        World.Render(view, ren);
+        ren->EndOcclusionFrame();
+        FrameSerial = 0;
     }
 
 
@@ -124,7 +1813,7 @@ namespace OVR { namespace Render {
 
         Model* box = new Model();
 
-        uint16_t startIndex = 0;
+        uint32_t startIndex = 0;
         // Cube
         startIndex =
             box->AddVertex(Vector3f(x1, y2, z1), ycolor);
@@ -235,7 +1924,7 @@ namespace OVR { namespace Render {
         };
 
 
-        uint16_t startIndex = GetNextVertexIndex();
+        uint32_t startIndex = GetNextVertexIndex();
 
         enum
         {
@@ -262,7 +1951,7 @@ namespace OVR { namespace Render {
     {    
         Vector3f s = size * 0.5f;
         Vector3f o = origin;
-        uint16_t i = GetNextVertexIndex();
+        uint32_t i = GetNextVertexIndex();
 
         AddVertex(-s.x + o.x,  s.y + o.y, -s.z + o.z,  c, 1, 0, 0, 0, -1);
         AddVertex(s.x  + o.x,  s.y + o.y, -s.z + o.z,  c, 0, 0, 0, 0, -1);
@@ -497,53 +2186,655 @@ namespace OVR { namespace Render {
     // ***** Rendering
 
 
-    RenderDevice::RenderDevice(ovrSession session) :
-        Session(session),
-        TotalTextureMemoryUsage(0)
+    RenderDevice::RenderDevice(ovrSession session) :
+        Session(session),
+        TextBatchDepth(0),
+        TotalTextureMemoryUsage(0),
+        GpuTimingEnabled(false),
+        GpuTimerFrameOpen(false),
+        GpuTimerFrameIndex(0),
+        OcclusionQueriesEnabled(false),
+        OcclusionFrameOpen(false),
+        OcclusionFrameIndex(0),
+        OcclusionFrameSerial(0),
+        OcclusionSamplesSerial(0),
+        FillBatchOpen(false),
+        BatchedFill(nullptr),
+        BatchedFillPrim(Prim_Triangles),
+        StereoPassActive(false),
+        MultiresActive(false),
+        MultiresViewport(),
+        ParallelRecordingEnabled(false)
+    {
+        resetGpuTimerFrames();
+        resetOcclusionFrames();
+        resetDeferredReleases();
+    }
+
+    RenderDevice::~RenderDevice()
+    {
+        Shutdown();
+    }
+
+    void RenderDevice::Shutdown()
+    {
+        // Do not issue virtual function calls from here. Shutdown is called
+        // from the destructor.
+
+        pTextVertexBuffer.Clear();
+        TextMeshes.clear();
+        TextBatches.clear();
+        LightingBuffer.Clear();
+
+        // Derived devices release their timer queries in their own Shutdown.
+        GpuTimingEnabled = false;
+        resetGpuTimerFrames();
+        OcclusionQueriesEnabled = false;
+        resetOcclusionFrames();
+        OcclusionBox.Clear();
+        DepthFill.Clear();
+
+        // Releases still queued go at once; the device is going away with whatever uses them.
+        resetDeferredReleases();
+
+        Session = nullptr;
+    }
+
+    void RenderDevice::resetGpuTimerFrames()
+    {
+        for (GpuTimerFrame& frame : GpuTimerFrames)
+        {
+            frame.Passes.clear();
+            frame.TimestampCount = 0;
+            frame.Pending = false;
+            frame.CpuBeginTicks = 0;
+        }
+        GpuTimerFrameOpen = false;
+        GpuTimerFrameIndex = 0;
+        GpuTimerStack.clear();
+        GpuPassTimes.clear();
+    }
+
+    void RenderDevice::resetOcclusionFrames()
+    {
+        for (OcclusionFrame& frame : OcclusionFrames)
+        {
+            frame.QueryCount = 0;
+            frame.Pending = false;
+            frame.Serial = 0;
+        }
+        OcclusionFrameOpen = false;
+        OcclusionFrameIndex = 0;
+        OcclusionSamples.clear();
+        OcclusionSamplesSerial = 0;
+    }
+
+    void RenderDevice::resetDeferredReleases()
+    {
+        std::list<DeferredRelease> released;
+        {
+            Lock::Locker locker(&DeferredReleaseLock);
+            released.swap(DeferredReleases);
+            ReleaseFrame = 1;
+        }
+
+        RetiredFrame = 0;
+        ReleaseFenceIndex = 0;
+        for (ReleaseFence& fence : ReleaseFences)
+        {
+            fence.Frame = 0;
+            fence.Pending = false;
+        }
+    }
+
+    // The list node is default constructed in place and the pointer swapped into it, since
+    // copying a Ptr would touch the count, which isn't atomic for Buffers.
+    void RenderDevice::ReleaseDeferred(Ptr<Buffer>& buffer)
+    {
+        if (!buffer)
+            return;
+
+        Lock::Locker locker(&DeferredReleaseLock);
+        DeferredReleases.emplace_back();
+        DeferredRelease& release = DeferredReleases.back();
+        std::swap(release.pBuffer.GetRawRef(), buffer.GetRawRef());
+        release.Frame = ReleaseFrame;
+    }
+
+    void RenderDevice::ReleaseDeferred(Ptr<Texture>& texture)
+    {
+        if (!texture)
+            return;
+
+        Lock::Locker locker(&DeferredReleaseLock);
+        DeferredReleases.emplace_back();
+        DeferredRelease& release = DeferredReleases.back();
+        std::swap(release.pTexture.GetRawRef(), texture.GetRawRef());
+        release.Frame = ReleaseFrame;
+    }
+
+    void RenderDevice::RetireFrame()
+    {
+        // Poll the fences oldest first, starting with the one this frame would reuse.
+        for (int i = 0; i < DeferredReleaseFrameCount; ++i)
+        {
+            const int slot = (ReleaseFenceIndex + i) % DeferredReleaseFrameCount;
+            ReleaseFence& fence = ReleaseFences[slot];
+            if (!fence.Pending)
+                continue;
+            if (!IsFrameFenceDone(slot))
+                break;
+
+            fence.Pending = false;
+            RetiredFrame = Alg::Max(RetiredFrame, fence.Frame);
+        }
+
+        std::list<DeferredRelease> retired;
+        {
+            Lock::Locker locker(&DeferredReleaseLock);
+
+            // Signalled under the lock, so that no release can be tagged with this frame after
+            // its fence. If the GPU is so far behind that the slot is still pending, the frame
+            // isn't fenced, and retires along with the next one that is.
+            const int slot = ReleaseFenceIndex % DeferredReleaseFrameCount;
+            if (!ReleaseFences[slot].Pending)
+            {
+                if (SignalFrameFence(slot))
+                {
+                    ReleaseFences[slot].Frame = ReleaseFrame;
+                    ReleaseFences[slot].Pending = true;
+                    ReleaseFenceIndex++;
+                }
+                else if (ReleaseFrame > DeferredReleaseFrameCount)
+                {
+                    RetiredFrame = ReleaseFrame - DeferredReleaseFrameCount;
+                }
+            }
+            ReleaseFrame++;
+
+            std::list<DeferredRelease>::iterator end = DeferredReleases.begin();
+            while ((end != DeferredReleases.end()) && (end->Frame <= RetiredFrame))
+                ++end;
+            retired.splice(retired.end(), DeferredReleases, DeferredReleases.begin(), end);
+        }
+
+        // The retired resources are destroyed with the list, outside the lock.
+    }
+
+    bool RenderDevice::SetGpuTimingEnabled(bool enabled)
+    {
+        if (enabled == GpuTimingEnabled)
+            return true;
+
+        if (enabled)
+        {
+            if (!CreateGpuTimerQueries(GpuTimerFrameCount, GpuTimerMaxTimestamps))
+                return false;
+        }
+        else
+        {
+            if (GpuTimerFrameOpen)
+                EndGpuTimerFrame();
+            ReleaseGpuTimerQueries();
+        }
+
+        resetGpuTimerFrames();
+        GpuTimingEnabled = enabled;
+        return true;
+    }
+
+    bool RenderDevice::BeginGpuTimerFrame()
+    {
+        if (!GpuTimingEnabled)
+            return false;
+
+        if (GpuTimerFrameOpen)
+            EndGpuTimerFrame();
+
+        // Read back finished frames oldest first, which starts with the one this frame would
+        // reuse. A frame which isn't done yet means later ones aren't either.
+        bool haveNewTimes = false;
+        std::vector<uint64_t>& timestamps = GpuTimestampScratch;
+        timestamps.resize(GpuTimerMaxTimestamps);
+
+        for (int i = 0; i < GpuTimerFrameCount; ++i)
+        {
+            const int slot = (GpuTimerFrameIndex + i) % GpuTimerFrameCount;
+            GpuTimerFrame& frame = GpuTimerFrames[slot];
+            if (!frame.Pending)
+                continue;
+
+            uint64_t frequency = 0;
+            const GpuTimerReadResult result = (frame.TimestampCount == 0) ? GpuTimerRead_Invalid :
+                ReadGpuTimestamps(slot, frame.TimestampCount, timestamps.data(), frequency);
+            if (result == GpuTimerRead_NotReady)
+                break;
+
+            frame.Pending = false;
+            if ((result != GpuTimerRead_Ready) || (frequency == 0))
+                continue;
+
+            GpuPassTimes.clear();
+            const uint64_t origin = timestamps[0];
+            const double nanosPerTick = 1e9 / (double)frequency;
+
+            for (const GpuTimerPass& pass : frame.Passes)
+            {
+                if ((pass.EndIndex < 0) || (timestamps[pass.EndIndex] < timestamps[pass.BeginIndex]))
+                    continue;
+
+                // Timestamps before the first one are possible on some drivers; clamp them.
+                const uint64_t begin = Alg::Max(timestamps[pass.BeginIndex], origin) - origin;
+                const uint64_t end = Alg::Max(timestamps[pass.EndIndex], origin) - origin;
+
+                GpuPassTime passTime;
+                passTime.Name = pass.Name;
+                passTime.Depth = pass.Depth;
+                passTime.Milliseconds = (double)(end - begin) * nanosPerTick * 1e-6;
+                passTime.BeginTicks = frame.CpuBeginTicks +
+                    Timer::NanosToRawTicksDuration((uint64_t)((double)begin * nanosPerTick));
+                passTime.EndTicks = frame.CpuBeginTicks +
+                    Timer::NanosToRawTicksDuration((uint64_t)((double)end * nanosPerTick));
+                GpuPassTimes.push_back(passTime);
+            }
+            haveNewTimes = true;
+        }
+
+        const int slot = GpuTimerFrameIndex % GpuTimerFrameCount;
+        GpuTimerFrame& frame = GpuTimerFrames[slot];
+        if (frame.Pending)
+            return haveNewTimes; // The GPU is more than GpuTimerFrameCount frames behind.
+
+        frame.Passes.clear();
+        frame.TimestampCount = 0;
+        frame.CpuBeginTicks = Timer::GetTicksRaw();
+        BeginGpuTimerQueries(slot);
+        GpuTimerFrameOpen = true;
+        return haveNewTimes;
+    }
+
+    void RenderDevice::EndGpuTimerFrame()
+    {
+        if (!GpuTimerFrameOpen)
+            return;
+
+        const int slot = GpuTimerFrameIndex % GpuTimerFrameCount;
+        EndGpuTimerQueries(slot);
+        GpuTimerFrames[slot].Pending = true;
+        GpuTimerFrameIndex++;
+        GpuTimerFrameOpen = false;
+
+        // Scopes still open belong to the frame just ended, and aren't timed from here on.
+        for (int& passIndex : GpuTimerStack)
+            passIndex = -1;
+    }
+
+    void RenderDevice::BeginGpuTimer(const char* name)
+    {
+        if (!GpuTimingEnabled)
+            return;
+
+        GpuTimerFrame& frame = GpuTimerFrames[GpuTimerFrameIndex % GpuTimerFrameCount];
+
+        // Each pass needs two timestamps, so one isn't started unless both are available.
+        if (!GpuTimerFrameOpen || ((frame.TimestampCount + 2) > GpuTimerMaxTimestamps))
+        {
+            GpuTimerStack.push_back(-1);
+            return;
+        }
+
+        GpuTimerPass pass;
+        pass.Name = name;
+        pass.Depth = (int)GpuTimerStack.size();
+        pass.BeginIndex = frame.TimestampCount++;
+        pass.EndIndex = -1;
+        WriteGpuTimestamp(GpuTimerFrameIndex % GpuTimerFrameCount, pass.BeginIndex);
+
+        GpuTimerStack.push_back((int)frame.Passes.size());
+        frame.Passes.push_back(pass);
+    }
+
+    void RenderDevice::EndGpuTimer()
+    {
+        if (GpuTimerStack.empty())
+            return;
+
+        const int passIndex = GpuTimerStack.back();
+        GpuTimerStack.pop_back();
+        if (!GpuTimingEnabled || !GpuTimerFrameOpen || (passIndex < 0))
+            return;
+
+        const int slot = GpuTimerFrameIndex % GpuTimerFrameCount;
+        GpuTimerFrame& frame = GpuTimerFrames[slot];
+        GpuTimerPass& pass = frame.Passes[passIndex];
+        pass.EndIndex = frame.TimestampCount++;
+        WriteGpuTimestamp(slot, pass.EndIndex);
+    }
+
+    bool RenderDevice::SetOcclusionQueriesEnabled(bool enabled)
+    {
+        if (enabled == OcclusionQueriesEnabled)
+            return true;
+
+        if (enabled)
+        {
+            if (!CreateOcclusionQueries(OcclusionFrameCount, OcclusionMaxQueries))
+                return false;
+        }
+        else
+        {
+            if (OcclusionFrameOpen)
+                EndOcclusionFrame();
+            ReleaseOcclusionQueries();
+        }
+
+        resetOcclusionFrames();
+        OcclusionQueriesEnabled = enabled;
+        return true;
+    }
+
+    bool RenderDevice::BeginOcclusionFrame(uint64_t& frameSerial)
+    {
+        frameSerial = 0;
+        if (!OcclusionQueriesEnabled)
+            return false;
+
+        if (OcclusionFrameOpen)
+            EndOcclusionFrame();
+
+        // Read back finished frames oldest first, keeping the newest; as with the timers, a
+        // frame which isn't done yet means later ones aren't either.
+        bool haveNewSamples = false;
+        for (int i = 0; i < OcclusionFrameCount; ++i)
+        {
+            const int slot = (OcclusionFrameIndex + i) % OcclusionFrameCount;
+            OcclusionFrame& frame = OcclusionFrames[slot];
+            if (!frame.Pending)
+                continue;
+
+            OcclusionScratch.resize(frame.QueryCount);
+            if ((frame.QueryCount > 0) && !ReadOcclusionQueries(slot, frame.QueryCount, OcclusionScratch.data()))
+                break;
+
+            frame.Pending = false;
+            OcclusionSamples.swap(OcclusionScratch);
+            OcclusionSamplesSerial = frame.Serial;
+            haveNewSamples = true;
+        }
+
+        const int slot = OcclusionFrameIndex % OcclusionFrameCount;
+        OcclusionFrame& frame = OcclusionFrames[slot];
+        if (frame.Pending)
+            return haveNewSamples; // The GPU is more than OcclusionFrameCount frames behind.
+
+        frame.QueryCount = 0;
+        frame.Serial = ++OcclusionFrameSerial;
+        OcclusionFrameOpen = true;
+        frameSerial = frame.Serial;
+        return haveNewSamples;
+    }
+
+    void RenderDevice::EndOcclusionFrame()
+    {
+        if (!OcclusionFrameOpen)
+            return;
+
+        OcclusionFrames[OcclusionFrameIndex % OcclusionFrameCount].Pending = true;
+        OcclusionFrameIndex++;
+        OcclusionFrameOpen = false;
+    }
+
+    int RenderDevice::TestOcclusionBox(const Bounds3f& box, const Matrix4f& viewFromBox)
+    {
+        if (!OcclusionFrameOpen)
+            return -1;
+
+        const int slot = OcclusionFrameIndex % OcclusionFrameCount;
+        OcclusionFrame& frame = OcclusionFrames[slot];
+        if (frame.QueryCount >= OcclusionMaxQueries)
+            return -1;
+
+        if (!OcclusionBox)
+        {
+            OcclusionBox = *Model::CreateAxisFaceColorBox(-1.0f, 1.0f, Color(), -1.0f, 1.0f, Color(), -1.0f, 1.0f, Color());
+            OcclusionBox->Fill = GetSimpleFill();
+        }
+
+        const Vector3f center = (box.GetMins() + box.GetMaxs()) * 0.5f;
+        const Vector3f halfExtents = (box.GetMaxs() - box.GetMins()) * 0.5f;
+        const Matrix4f boxFromCube = Matrix4f::Translation(center) * Matrix4f::Scaling(halfExtents);
+
+        const int index = frame.QueryCount++;
+        BeginOcclusionQuery(slot, index);
+        Render(viewFromBox * boxFromCube, OcclusionBox);
+        EndOcclusionQuery(slot, index);
+        return index;
+    }
+
+    Fill* RenderDevice::CreateTextureFill(Render::Texture* t, bool useAlpha, bool usePremult)
+    {
+        ShaderSet* shaders = CreateShaderSet();
+        shaders->SetShader(LoadBuiltinShader(Shader_Vertex, VShader_MVP));
+        shaders->SetShader(LoadBuiltinShader(Shader_Fragment, usePremult ? FShader_AlphaPremultTexture : ( useAlpha ? FShader_AlphaTexture : FShader_Texture )));
+        Fill *f = new ShaderFill(*shaders);
+        f->SetTexture(0, t);
+        return f;
+    }
+
+    void LightingParams::Set(ShaderSet* s) const
+    {
+        s->SetUniform4fvArray("Ambient", 1, &Ambient);
+        s->SetUniform1f("LightCount", LightCount);
+        s->SetUniform4fvArray("LightPos", (int)LightCount, LightPos);
+        s->SetUniform4fvArray("LightColor", (int)LightCount, LightColor);
+    }
+
+    void RenderDevice::SetLighting(const LightingParams* lt)
+    {
+        if (!LightingBuffer)
+            LightingBuffer = *CreateBuffer();
+
+        LightingBuffer->Data(Buffer_Uniform, lt, sizeof(LightingParams));
+        SetCommonUniformBuffer(1, LightingBuffer);
+    }
+
+    void RenderDevice::RenderInstanced(const Matrix4f& matrix, InstancedModel* model)
+    {
+        if (model->Instances.empty())
+        {
+            return;
+        }
+
+        if (!model->InstanceBuffer)
+        {
+            std::vector<Vector4f> rows;
+            model->GetInstanceRows(rows);
+            Ptr<Buffer> ib = *CreateBuffer();
+            if (!ib->Data(Buffer_Vertex | Buffer_ReadOnly, &rows[0], rows.size() * sizeof(Vector4f)))
+            {
+                OVR_ASSERT(false);
+            }
+            model->InstanceBuffer = ib;
+        }
+
+        // The instances all draw the model's level of detail, whose own buffers are made by the
+        // first per-instance draw. During a stereo pass the instances are drawn separately, each
+        // to both eyes.
+        Model* mesh = model->GetLodMesh();
+        if (mesh->VertexBuffer && mesh->IndexBuffer && (mesh->Layout == VertexLayout_Interleaved) &&
+            !StereoPassActive)
+        {
+            const Fill* fill = model->Fill ? model->Fill.GetPtr() : GetSimpleFill();
+            if (RenderInstances(fill, mesh->VertexBuffer, mesh->IndexBuffer, model->InstanceBuffer,
+                                matrix, (int)mesh->Indices.size(), (int)model->Instances.size(),
+                                model->GetPrimType()))
+            {
+                return;
+            }
+        }
+
+        for (size_t i = 0; i < model->Instances.size(); i++)
+        {
+            Render(matrix * model->Instances[i], mesh);
+        }
+    }
+
+    void RenderDevice::RenderModel(const Matrix4f& matrix, Model* model)
+    {
+        if (!StereoPassActive || CanRenderStereo(model->Fill ? model->Fill.GetPtr() : GetSimpleFill()))
+        {
+            model->Draw(matrix, this);
+            return;
+        }
+
+        // Draw to each eye in turn.
+        const Matrix4f savedProj = Proj;
+        StereoPassActive = false;
+        for (int eye = 0; eye < 2; eye++)
+        {
+            ApplyStereoParams(StereoEyeViewports[eye], StereoEyeProj[eye]);
+            model->Draw(StereoEyeFromLeft[eye] * matrix, this);
+        }
+        StereoPassActive = true;
+        ApplyStereoParams(StereoViewport, savedProj);
+    }
+
+    void RenderDevice::RenderModelDepth(const Matrix4f& matrix, Model* model)
+    {
+        const Fill* fill = GetDepthPassFill(model->Fill ? model->Fill.GetPtr() : nullptr);
+        if (!fill)
+        {
+            return;
+        }
+
+        if (!StereoPassActive || CanRenderStereo(fill))
+        {
+            model->DrawDepth(matrix, this, fill);
+            return;
+        }
+
+        const Matrix4f savedProj = Proj;
+        StereoPassActive = false;
+        for (int eye = 0; eye < 2; eye++)
+        {
+            ApplyStereoParams(StereoEyeViewports[eye], StereoEyeProj[eye]);
+            model->DrawDepth(StereoEyeFromLeft[eye] * matrix, this, fill);
+        }
+        StereoPassActive = true;
+        ApplyStereoParams(StereoViewport, savedProj);
+    }
+
+    const Fill* RenderDevice::GetDepthPassFill(const Fill* fill)
     {
+        if (!fill)
+        {
+            return GetDepthFill();
+        }
+
+        // The builtins are compared by their fragment shaders, as fills share them.
+        const Shader* fragment = ((ShaderFill*)fill)->GetShaders()->GetShader(Shader_Fragment);
+        static const BuiltinFragmentShaders alphaTested[] = { FShader_Texture, FShader_MultiTexture,
+                                                              FShader_TextureArray, FShader_MultiTextureArray };
+        static const BuiltinFragmentShaders blended[] = { FShader_AlphaTexture, FShader_AlphaBlendedTexture,
+                                                          FShader_AlphaPremultTexture };
+        for (BuiltinFragmentShaders shader : alphaTested)
+        {
+            if (fragment == LoadBuiltinShader(Shader_Fragment, shader))
+            {
+                return fill;
+            }
+        }
+        for (BuiltinFragmentShaders shader : blended)
+        {
+            if (fragment == LoadBuiltinShader(Shader_Fragment, shader))
+            {
+                return nullptr;
+            }
+        }
+        return GetDepthFill();
     }
 
-    RenderDevice::~RenderDevice()
+    Fill* RenderDevice::GetDepthFill()
     {
-        Shutdown();
+        if (!DepthFill)
+        {
+            ShaderSet* shaders = CreateShaderSet();
+            shaders->SetShader(LoadBuiltinShader(Shader_Vertex, VShader_MVP));
+            shaders->SetShader(LoadBuiltinShader(Shader_Fragment, FShader_Solid));
+            DepthFill = *new ShaderFill(*shaders);
+        }
+        return DepthFill;
     }
 
-    void RenderDevice::Shutdown()
+    bool RenderDevice::BeginStereoPass(const Recti eyeViewports[2], const Matrix4f eyeProjections[2],
+                                       const Matrix4f& rightFromLeft)
     {
-        // Do not issue virtual function calls from here. Shutdown is called
-        // from the destructor.
+        const Recti& left = eyeViewports[0];
+        const Recti& right = eyeViewports[1];
+        if (StereoPassActive || MultiresActive || !CanRenderStereo(GetSimpleFill()) ||
+            (left.y != right.y) || (left.h != right.h) || (left.x + left.w > right.x))
+        {
+            return false;
+        }
 
-        pTextVertexBuffer.Clear();
-        LightingBuffer.Clear();
+        StereoViewport = Recti(left.x, left.y, right.x + right.w - left.x, left.h);
+        const float uw = (float)StereoViewport.w;
 
-        Session = nullptr;
+        for (int eye = 0; eye < 2; eye++)
+        {
+            const Recti& vp = eyeViewports[eye];
+            StereoEyeViewports[eye] = vp;
+            StereoEyeProj[eye] = eyeProjections[eye];
+            StereoEyeFromLeft[eye] = (eye == 0) ? Matrix4f::Identity() : rightFromLeft;
+
+            // Scale and offset clip-space x from the eye's viewport to StereoViewport.
+            Matrix4f eyeToUnion;
+            eyeToUnion.M[0][0] = vp.w / uw;
+            eyeToUnion.M[0][3] = (2.0f * (vp.x - StereoViewport.x) + vp.w) / uw - 1.0f;
+            StereoClipFromLeft[eye] = eyeToUnion * eyeProjections[eye] * StereoEyeFromLeft[eye];
+        }
+
+        // The left eye keeps x <= its right edge, and the right eye x >= its left edge.
+        const float leftEdge = 2.0f * (left.x + left.w - StereoViewport.x) / uw - 1.0f;
+        const float rightEdge = 2.0f * (right.x - StereoViewport.x) / uw - 1.0f;
+        StereoClipPlanes[0] = Vector4f(-1.0f, 0.0f, 0.0f, leftEdge);
+        StereoClipPlanes[1] = Vector4f(1.0f, 0.0f, 0.0f, -rightEdge);
+
+        StereoPassActive = true;
+        BatchedFill = nullptr;
+        SetViewport(StereoViewport);
+        return true;
     }
 
-    Fill* RenderDevice::CreateTextureFill(Render::Texture* t, bool useAlpha, bool usePremult)
+    void RenderDevice::EndStereoPass()
     {
-        ShaderSet* shaders = CreateShaderSet();
-        shaders->SetShader(LoadBuiltinShader(Shader_Vertex, VShader_MVP));
-        shaders->SetShader(LoadBuiltinShader(Shader_Fragment, usePremult ? FShader_AlphaPremultTexture : ( useAlpha ? FShader_AlphaTexture : FShader_Texture )));
-        Fill *f = new ShaderFill(*shaders);
-        f->SetTexture(0, t);
-        return f;
+        StereoPassActive = false;
+        BatchedFill = nullptr;
     }
 
-    void LightingParams::Set(ShaderSet* s) const
+    MultiresLayout MultiresLayout::Make(Sizei size, float warp)
     {
-        s->SetUniform4fvArray("Ambient", 1, &Ambient);
-        s->SetUniform1f("LightCount", LightCount);
-        s->SetUniform4fvArray("LightPos", (int)LightCount, LightPos);
-        s->SetUniform4fvArray("LightColor", (int)LightCount, LightColor);
+        // A quadrant's edge lands at 1 / (1 + warp) of its rectilinear extent, while the
+        // density at the split is unchanged.
+        MultiresLayout layout;
+        layout.WarpLeft = layout.WarpRight = layout.WarpUp = layout.WarpDown = warp;
+        layout.SizeLeft  = layout.SizeRight = (int)ceilf(size.w * 0.5f / (1.0f + warp));
+        layout.SizeUp    = layout.SizeDown  = (int)ceilf(size.h * 0.5f / (1.0f + warp));
+        return layout;
     }
 
-    void RenderDevice::SetLighting(const LightingParams* lt)
+    ovrTextureLayoutOctilinear MultiresLayout::GetOvrLayout() const
     {
-        if (!LightingBuffer)
-            LightingBuffer = *CreateBuffer();
-
-        LightingBuffer->Data(Buffer_Uniform, lt, sizeof(LightingParams));
-        SetCommonUniformBuffer(1, LightingBuffer);
+        ovrTextureLayoutOctilinear octilinear;
+        octilinear.WarpLeft  = WarpLeft;
+        octilinear.WarpRight = WarpRight;
+        octilinear.WarpUp    = WarpUp;
+        octilinear.WarpDown  = WarpDown;
+        octilinear.SizeLeft  = (float)SizeLeft;
+        octilinear.SizeRight = (float)SizeRight;
+        octilinear.SizeUp    = (float)SizeUp;
+        octilinear.SizeDown  = (float)SizeDown;
+        return octilinear;
     }
 
     float RenderDevice::MeasureText(const Font* font, const char* str, float size, float strsize[2],
@@ -619,46 +2910,31 @@ namespace OVR { namespace Render {
 
 
 
-    void RenderDevice::RenderText(const Font* font, const char* str,
-        float x, float y, float size, Color c, const Matrix4f* view)
+    const std::vector<Vertex>& RenderDevice::GetTextMesh(const Font* font, const char* str, float size, Color c)
     {
-        size_t length = strlen(str);
-
-        // Do not attempt to render if we have an empty string.
-        if (length == 0) { return; }
-
-        if(!pTextVertexBuffer)
-        {
-            pTextVertexBuffer = *CreateBuffer();
-            if(!pTextVertexBuffer)
-            {
-                return;
-            }
-        }
-
-        if(!font->fill)
+        TextMeshKey key;
+        key.pFont = font;
+        key.Size = size;
+        key.TextColor = c;
+        key.Str = str;
+
+        auto it = TextMeshes.find(key);
+        if (it != TextMeshes.end())
         {
-            font->fill = CreateTextureFill(Ptr<Texture>(
-                *CreateTexture(Texture_R, font->twidth, font->theight, font->tex)), true, false);
+            return it->second;
         }
 
-        pTextVertexBuffer->Data(Buffer_Vertex, NULL, length * 6 * sizeof(Vertex));
-        Vertex* vertices = (Vertex*)pTextVertexBuffer->Map(0, length * 6 * sizeof(Vertex), Map_Discard);
-        if(!vertices)
+        if (TextMeshes.size() >= TextMeshCacheSize)
         {
-            return;
+            TextMeshes.clear();
         }
+        std::vector<Vertex>& vertices = TextMeshes[key];
 
-        Matrix4f m = Matrix4f(size / font->lineheight, 0, 0, 0,
-            0, size / font->lineheight, 0, 0,
-            0, 0, 0, 0,
-            x, y, 0, 1).Transposed();
-
-        if (view)
-            m = (*view) * m;
+        const size_t length = key.Str.length();
+        vertices.reserve(length * 6);
 
+        const float scale = size / font->lineheight;
         float xp = 0, yp = (float)font->ascent;
-        int   ivertex = 0;
 
         for (size_t i = 0; i < length; i++)
         {
@@ -679,33 +2955,139 @@ namespace OVR { namespace Render {
             }
 
             const Font::Char* ch = &font->chars[(int)str[i]];
-            Vertex* chv = &vertices[ivertex];
-            for(int j = 0; j < 6; j++)
-            {
-                chv[j].C = c;
-            }
-            float fx = xp + ch->x;
-            float fy = yp - ch->y;
-            float cx = font->twidth * (ch->u2 - ch->u1);
-            float cy = font->theight * (ch->v2 - ch->v1);
-            chv[0] = Vertex(Vector3f(fx, fy, 0), c, ch->u1, ch->v1);
-            chv[1] = Vertex(Vector3f(fx + cx, fy, 0), c, ch->u2, ch->v1);
-            chv[2] = Vertex(Vector3f(fx + cx, cy + fy, 0), c, ch->u2, ch->v2);
-            chv[3] = Vertex(Vector3f(fx, fy, 0), c, ch->u1, ch->v1);
-            chv[4] = Vertex(Vector3f(fx + cx, cy + fy, 0), c, ch->u2, ch->v2);
-            chv[5] = Vertex(Vector3f(fx, fy + cy, 0), c, ch->u1, ch->v2);
-            ivertex += 6;
+            float fx = (xp + ch->x) * scale;
+            float fy = (yp - ch->y) * scale;
+            float cx = font->twidth * (ch->u2 - ch->u1) * scale;
+            float cy = font->theight * (ch->v2 - ch->v1) * scale;
+            vertices.push_back(Vertex(Vector3f(fx, fy, 0), c, ch->u1, ch->v1));
+            vertices.push_back(Vertex(Vector3f(fx + cx, fy, 0), c, ch->u2, ch->v1));
+            vertices.push_back(Vertex(Vector3f(fx + cx, cy + fy, 0), c, ch->u2, ch->v2));
+            vertices.push_back(Vertex(Vector3f(fx, fy, 0), c, ch->u1, ch->v1));
+            vertices.push_back(Vertex(Vector3f(fx + cx, cy + fy, 0), c, ch->u2, ch->v2));
+            vertices.push_back(Vertex(Vector3f(fx, fy + cy, 0), c, ch->u1, ch->v2));
 
             xp += ch->advance;
         }
 
-        pTextVertexBuffer->Unmap(vertices);
+        return vertices;
+    }
+
+    void RenderDevice::RenderText(const Font* font, const char* str,
+        float x, float y, float size, Color c, const Matrix4f* view)
+    {
+        // Do not attempt to render if we have an empty string.
+        if (str[0] == 0) { return; }
+
+        if(!font->fill)
+        {
+            font->fill = CreateTextureFill(Ptr<Texture>(
+                *CreateTexture(Texture_R, font->twidth, font->theight, font->tex)), true, false);
+        }
+
+        const std::vector<Vertex>& mesh = GetTextMesh(font, str, size, c);
+        if (mesh.empty())
+        {
+            return;
+        }
+
+        TextBatch* batch = NULL;
+        for (size_t i = 0; i < TextBatches.size(); i++)
+        {
+            if (TextBatches[i].pFont == font)
+            {
+                batch = &TextBatches[i];
+                break;
+            }
+        }
+        if (!batch)
+        {
+            TextBatches.push_back(TextBatch());
+            batch = &TextBatches.back();
+            batch->pFont = font;
+        }
+
+        // The batch is drawn untransformed, so move the string to where it's drawn here.
+        const size_t first = batch->Vertices.size();
+        batch->Vertices.insert(batch->Vertices.end(), mesh.begin(), mesh.end());
+        for (size_t i = first; i < batch->Vertices.size(); i++)
+        {
+            Vector3f& pos = batch->Vertices[i].Pos;
+            pos.x += x;
+            pos.y += y;
+            if (view)
+            {
+                pos = view->Transform(pos);
+            }
+        }
+
+        if (TextBatchDepth == 0)
+        {
+            FlushText();
+        }
+    }
+
+    void RenderDevice::BeginTextBatch()
+    {
+        TextBatchDepth++;
+    }
+
+    void RenderDevice::EndTextBatch()
+    {
+        OVR_ASSERT(TextBatchDepth > 0);
+        if (--TextBatchDepth == 0)
+        {
+            FlushText();
+        }
+    }
+
+    bool RenderDevice::HasPendingText() const
+    {
+        for (size_t i = 0; i < TextBatches.size(); i++)
+        {
+            if (!TextBatches[i].Vertices.empty())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void RenderDevice::FlushText()
+    {
+        for (size_t i = 0; i < TextBatches.size(); i++)
+        {
+            TextBatch& batch = TextBatches[i];
+            if (batch.Vertices.empty())
+            {
+                continue;
+            }
+
+            if(!pTextVertexBuffer)
+            {
+                pTextVertexBuffer = *CreateBuffer();
+                if(!pTextVertexBuffer)
+                {
+                    return;
+                }
+            }
 
-        Render(font->fill, pTextVertexBuffer, NULL, m, 0, ivertex, Prim_Triangles);
+            const size_t bytes = batch.Vertices.size() * sizeof(Vertex);
+            pTextVertexBuffer->Data(Buffer_Vertex, NULL, bytes);
+            Vertex* vertices = (Vertex*)pTextVertexBuffer->Map(0, bytes, Map_Discard);
+            if (vertices)
+            {
+                memcpy(vertices, &batch.Vertices[0], bytes);
+                pTextVertexBuffer->Unmap(vertices);
+                Render(batch.pFont->fill, pTextVertexBuffer, NULL, Matrix4f(), 0, (int)batch.Vertices.size(), Prim_Triangles);
+            }
+            batch.Vertices.clear();
+        }
     }
 
     void RenderDevice::FillRect(float left, float top, float right, float bottom, Color c, const Matrix4f* matrix)
     {
+        FlushText();
+
         if(!pTextVertexBuffer)
         {
             pTextVertexBuffer = *CreateBuffer();
@@ -741,6 +3123,8 @@ namespace OVR { namespace Render {
 
     void RenderDevice::FillGradientRect(float left, float top, float right, float bottom, Color col_top, Color col_btm, const Matrix4f* matrix)
     {
+        FlushText();
+
         if(!pTextVertexBuffer)
         {
             pTextVertexBuffer = *CreateBuffer();
@@ -776,6 +3160,8 @@ namespace OVR { namespace Render {
 
     void RenderDevice::FillTexturedRect(float left, float top, float right, float bottom, float ul, float vt, float ur, float vb, Color c, Ptr<Texture> tex, const Matrix4f* matrix, bool premultAlpha /*= false*/)
     {
+        FlushText();
+
         if(!pTextVertexBuffer)
         {
             pTextVertexBuffer = *CreateBuffer();
@@ -826,6 +3212,8 @@ namespace OVR { namespace Render {
         OVR_ASSERT ( y != NULL );
         // z can be NULL for 2D stuff.
 
+        FlushText();
+
         if(!pTextVertexBuffer)
         {
             pTextVertexBuffer = *CreateBuffer();
@@ -874,6 +3262,8 @@ namespace OVR { namespace Render {
         unsigned char alpha,
         const Matrix4f* view)
     {
+        FlushText();
+
         Color c = Color(255, 255, 255, alpha);
         Ptr<Model> m = *new Model(Prim_Triangles);
         m->AddVertex(left,  bottom,  0.0f, c, 0.0f, 0.0f);
@@ -991,6 +3381,258 @@ namespace OVR { namespace Render {
         return true;
     }
 
+    const float CollisionModel::MaxBoundsExtent = 100000.0f;
+
+    const Bounds3f& CollisionModel::GetBounds() const
+    {
+        if (!BoundsCurrent)
+        {
+            // The model is the intersection of the planes' inner half-spaces, so its box is that of
+            // its corners: the points where three planes meet which are inside all the others.
+            // The faces of the MaxBoundsExtent box close off any open directions.
+            const float tolerance = 0.01f;
+            std::vector<Planef> planes(Planes);
+            for (int axis = 0; axis < 3; axis++)
+            {
+                Vector3f n;
+                n[axis] = 1.0f;
+                planes.push_back(Planef(n, -MaxBoundsExtent));
+                planes.push_back(Planef(-n, -MaxBoundsExtent));
+            }
+
+            Bounds.Clear();
+            const size_t count = planes.size();
+            for (size_t i = 0; i < count; i++)
+            {
+                for (size_t j = i + 1; j < count; j++)
+                {
+                    for (size_t k = j + 1; k < count; k++)
+                    {
+                        const Vector3f& a = planes[i].N;
+                        const Vector3f& b = planes[j].N;
+                        const Vector3f& c = planes[k].N;
+                        const float det = a.Dot(b.Cross(c));
+                        if (fabsf(det) < 1e-6f)
+                        {
+                            continue;
+                        }
+
+                        const Vector3f corner = (b.Cross(c) * -planes[i].D +
+                                                 c.Cross(a) * -planes[j].D +
+                                                 a.Cross(b) * -planes[k].D) / det;
+                        bool inside = true;
+                        for (size_t m = 0; (m < count) && inside; m++)
+                        {
+                            inside = (planes[m].TestSide(corner) <= tolerance);
+                        }
+                        if (inside)
+                        {
+                            Bounds.AddPoint(corner);
+                        }
+                    }
+                }
+            }
+
+            if (Bounds.GetMins().x > Bounds.GetMaxs().x)
+            {
+                // No corner survived rounding; fall back to the whole box rather than miss hits.
+                Bounds = Bounds3f(Vector3f(-MaxBoundsExtent), Vector3f(MaxBoundsExtent));
+            }
+            else
+            {
+                Bounds.GetMins() -= Vector3f(tolerance);
+                Bounds.GetMaxs() += Vector3f(tolerance);
+            }
+            BoundsCurrent = true;
+        }
+        return Bounds;
+    }
+
+    static bool BoundsContain(const Bounds3f& bounds, const Vector3f& p)
+    {
+        return (p.x >= bounds.GetMins().x) && (p.x <= bounds.GetMaxs().x) &&
+               (p.y >= bounds.GetMins().y) && (p.y <= bounds.GetMaxs().y) &&
+               (p.z >= bounds.GetMins().z) && (p.z <= bounds.GetMaxs().z);
+    }
+
+    void CollisionBVH::Build(const std::vector<Ptr<CollisionModel> >& models)
+    {
+        Models = models;
+        Nodes.clear();
+        if (!Models.empty())
+        {
+            Nodes.reserve(2 * Models.size());
+            Nodes.resize(1);
+            BuildNode(0, 0, (int32_t)Models.size());
+        }
+    }
+
+    void CollisionBVH::Clear()
+    {
+        Nodes.clear();
+        Models.clear();
+    }
+
+    void CollisionBVH::BuildNode(int32_t nodeIndex, int32_t first, int32_t count)
+    {
+        // Leaves hold this many models or fewer.
+        const int32_t leafCount = 2;
+
+        Bounds3f bounds;
+        Bounds3f centers;
+        for (int32_t i = first; i < first + count; i++)
+        {
+            const Bounds3f& modelBounds = Models[i]->GetBounds();
+            bounds.AddPoint(modelBounds.GetMins());
+            bounds.AddPoint(modelBounds.GetMaxs());
+            centers.AddPoint((modelBounds.GetMins() + modelBounds.GetMaxs()) * 0.5f);
+        }
+        Nodes[nodeIndex].Bounds = bounds;
+
+        if (count <= leafCount)
+        {
+            Nodes[nodeIndex].First = first;
+            Nodes[nodeIndex].Count = count;
+            return;
+        }
+
+        // Split at the median model center along the axis the centers are most spread on.
+        const Vector3f spread = centers.GetMaxs() - centers.GetMins();
+        const int axis = (spread.x >= spread.y) ? ((spread.x >= spread.z) ? 0 : 2)
+                                                : ((spread.y >= spread.z) ? 1 : 2);
+        const int32_t half = count / 2;
+        std::nth_element(
+            Models.begin() + first, Models.begin() + first + half, Models.begin() + first + count,
+            [axis](const Ptr<CollisionModel>& a, const Ptr<CollisionModel>& b)
+            {
+                const Bounds3f& ab = a->GetBounds();
+                const Bounds3f& bb = b->GetBounds();
+                return (ab.GetMins()[axis] + ab.GetMaxs()[axis]) <
+                       (bb.GetMins()[axis] + bb.GetMaxs()[axis]);
+            });
+
+        const int32_t childIndex = (int32_t)Nodes.size();
+        Nodes.resize(Nodes.size() + 2);
+        Nodes[nodeIndex].First = childIndex;
+        Nodes[nodeIndex].Count = 0;
+        BuildNode(childIndex, first, half);
+        BuildNode(childIndex + 1, first + half, count - half);
+    }
+
+    bool CollisionBVH::TestPoint(const Vector3f& p) const
+    {
+        if (Nodes.empty())
+        {
+            return false;
+        }
+
+        // Median splits keep the depth near log2 of the model count.
+        int32_t stack[64];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0)
+        {
+            const BVHNode& node = Nodes[stack[--stackSize]];
+            if (!BoundsContain(node.Bounds, p))
+            {
+                continue;
+            }
+
+            if (node.Count > 0)
+            {
+                for (int32_t i = node.First; i < node.First + node.Count; i++)
+                {
+                    if (Models[i]->TestPoint(p))
+                    {
+                        return true;
+                    }
+                }
+            }
+            else
+            {
+                stack[stackSize++] = node.First + 1;
+                stack[stackSize++] = node.First;
+            }
+        }
+        return false;
+    }
+
+    bool CollisionBVH::TestRay(const Vector3f& origin, const Vector3f& norm, float& len, Planef* ph) const
+    {
+        if (Nodes.empty())
+        {
+            return false;
+        }
+
+        // CollisionModel::TestRay only hits a model which contains the origin or the end of the
+        // segment, so only nodes whose bounds contain either can hold a hit.
+        const Vector3f end = origin + norm * len;
+        bool  hit = false;
+        float hitLen = len;
+
+        int32_t stack[64];
+        int stackSize = 0;
+        stack[stackSize++] = 0;
+
+        while (stackSize > 0)
+        {
+            const BVHNode& node = Nodes[stack[--stackSize]];
+            if (!BoundsContain(node.Bounds, end) && !BoundsContain(node.Bounds, origin))
+            {
+                continue;
+            }
+
+            if (node.Count > 0)
+            {
+                for (int32_t i = node.First; i < node.First + node.Count; i++)
+                {
+                    float modelLen = len;
+                    Planef modelPlane;
+                    if (Models[i]->TestRay(origin, norm, modelLen, &modelPlane) &&
+                        (!hit || (modelLen < hitLen)))
+                    {
+                        hit = true;
+                        hitLen = modelLen;
+                        if (ph)
+                        {
+                            *ph = modelPlane;
+                        }
+                    }
+                }
+            }
+            else
+            {
+                stack[stackSize++] = node.First + 1;
+                stack[stackSize++] = node.First;
+            }
+        }
+
+        if (hit)
+        {
+            len = hitLen;
+        }
+        return hit;
+    }
+
+    Texture* CreateTextureFromImage(RenderDevice* ren, const TextureImage& image)
+    {
+        Texture* out = ren->CreateTexture(image.Format, image.Width, image.Height, image.Data, image.MipCount);
+        if (!out)
+        {
+            return NULL;
+        }
+        if (image.Commit)
+        {
+            out->Commit();
+        }
+        if (image.SampleMode != -1)
+        {
+            out->SetSampleMode(image.SampleMode);
+        }
+        return out;
+    }
+
     int GetNumMipLevels(int w, int h)
     {
         int n = 1;
@@ -1027,7 +3669,9 @@ namespace OVR { namespace Render {
         {
         case Texture_R:            return w*h;
         case Texture_RGBA:         return w*h*4;
-        case Texture_BC1: {
+        case Texture_BC1:
+        case Texture_BC4U:
+        case Texture_BC4S: {
             int bw = (w+3)/4, bh = (h+3)/4;
             return bw * bh * 8;
                            }
@@ -1035,7 +3679,9 @@ namespace OVR { namespace Render {
         case Texture_BC3:
         case Texture_BC6U:
         case Texture_BC6S:
-        case Texture_BC7: {      
+        case Texture_BC7:
+        case Texture_BC5U:
+        case Texture_BC5S: {      
             int bw = (w+3)/4, bh = (h+3)/4;
             return bw * bh * 16;
                            }
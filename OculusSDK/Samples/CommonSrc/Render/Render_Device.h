@@ -27,14 +27,32 @@ limitations under the License.
 #include "Kernel/OVR_RefCount.h"
 #include "Kernel/OVR_File.h"
 #include "Kernel/OVR_Color.h"
+#include "Kernel/OVR_Atomic.h"
 #include "OVR_CAPI.h"
 
 #include <vector>
 #include <string>
 #include <array>
+#include <functional>
+#include <list>
+#include <unordered_map>
 
 
-namespace OVR { namespace Render {
+namespace OVR {
+
+namespace Render {
+class Fill;
+class Buffer;
+class Node;
+}
+
+// Scene objects are only referenced from the render thread, so they skip atomic reference
+// counting. This also lets caches refer to them with WeakPtr.
+template <> struct RefCountTraits<Render::Fill> : public RefCountTraitsNTS {};
+template <> struct RefCountTraits<Render::Buffer> : public RefCountTraitsNTS {};
+template <> struct RefCountTraits<Render::Node> : public RefCountTraitsNTS {};
+
+namespace Render {
 
 class RenderDevice;
 struct Font;
@@ -61,6 +79,14 @@ enum PrimitiveType
     Prim_Count
 };
 
+// How a Model's vertices are laid out in its GPU buffers.
+enum VertexLayout
+{
+    VertexLayout_Interleaved,   // One stream of Vertex.
+    VertexLayout_Split,         // A stream of Vector3f positions and one of VertexAttributes.
+    VertexLayout_Quantized      // One stream of QuantizedVertex, in about half the memory.
+};
+
 class Fill : public RefCountBase<Fill>
 {
 public:
@@ -81,7 +107,9 @@ public:
 
 #define LIST_VERTEX_SHADERS(_) \
 _(MV) \
-_(MVP)
+_(MVP) \
+_(MVPInstanced) \
+_(MVPStereo)
 
 #define LIST_GEOMETRY_SHADERS(_) \
 _(OctilinearEmulated) \
@@ -98,7 +126,9 @@ _(AlphaPremultTexture) \
 _(LitGouraud) \
 _(LitTexture) \
 _(MultiTexture) \
-_(MultiTextureHeavyAluEarlyZ)
+_(MultiTextureHeavyAluEarlyZ) \
+_(TextureArray) \
+_(MultiTextureArray)
 
 enum BuiltinVertexShaders
 {
@@ -142,6 +172,7 @@ enum BufferUsage
     Buffer_Compute  = 16,
     Buffer_TypeMask = 0xff,
     Buffer_ReadOnly = 0x100, // Buffer must be created with Data().
+    Buffer_Index32  = 0x200, // With Buffer_Index, the indices are uint32_t rather than uint16_t.
 };
 
 enum TextureFormat : uint64_t
@@ -168,8 +199,12 @@ enum TextureFormat : uint64_t
     Texture_BC2             = 0x220,
     Texture_BC3             = 0x230,
     Texture_BC6S            = 0x240,
-    Texture_BC6U            = 0x241,
+    Texture_BC6U            = 0x260,    // Not 0x241, which Texture_TypeMask turns into Texture_BC6S.
     Texture_BC7             = 0x250,
+    Texture_BC4U            = 0x270,
+    Texture_BC4S            = 0x280,
+    Texture_BC5U            = 0x290,
+    Texture_BC5S            = 0x2a0,
     
     Texture_Depth32f        = 0x1000,   // aliased as default Texture_Depth
     Texture_Depth24Stencil8 = 0x2000,
@@ -193,6 +228,7 @@ enum TextureFormat : uint64_t
     Texture_GenMipmapsBySdk = 0x2000000,    // not compatible with Texture_GenMipmaps
 
     Texture_Cubemap         = 0x4000000,
+    Texture_Array           = 0x8000000,    // made by CreateTextureArray
 
     Texture_MirrorPostDistortion        = 0x10000000,
     Texture_MirrorLeftEyeOnly           = 0x20000000,
@@ -396,6 +432,7 @@ public:
 class Buffer : public RefCountBase<Buffer>
 {
 public:
+    Buffer() : Index32(false) { }
     virtual ~Buffer() {}
 
     virtual size_t GetSize() = 0;
@@ -404,6 +441,12 @@ public:
 
     // Allocates a buffer, optionally filling it with data.
     virtual bool   Data(int use, const void* buffer, size_t size) = 0;
+
+    // Whether the last Data was given Buffer_Index32.
+    bool           Is32BitIndex() const { return Index32; }
+
+protected:
+    bool           Index32;
 };
 
 class Texture : public RefCountBase<Texture>
@@ -442,9 +485,12 @@ class CollisionModel : public RefCountBase<CollisionModel>
 public:
 	std::vector<Planef > Planes;
 
+	CollisionModel() : Bounds(), BoundsCurrent(false) { }
+
 	void Add(const Planef& p)
 	{
 		Planes.push_back(p);
+		BoundsCurrent = false;
 	}
 
 	// Return whether p is inside this
@@ -452,8 +498,68 @@ public:
 
 	// Assumes that the origin of the ray is outside this.
 	bool TestRay(const Vector3f& origin, const Vector3f& norm, float& len, Planef* ph = NULL) const;
+
+	// Returns a box containing the points inside all the planes, computed when first needed after
+	// planes are added. The box is limited to +/-MaxBoundsExtent on each axis, which also bounds
+	// the directions the planes leave open.
+	const Bounds3f& GetBounds() const;
+
+	static const float MaxBoundsExtent;
+
+private:
+	mutable Bounds3f Bounds;
+	mutable bool     BoundsCurrent;
+};
+
+// Bounding volume hierarchy over a set of CollisionModels, so that point and ray queries only
+// test the planes of the models whose bounds they touch.
+class CollisionBVH
+{
+public:
+    CollisionBVH() : Nodes(), Models() { }
+
+    // Builds the hierarchy over models, replacing any previous contents. The models' planes
+    // must not change while they are in the hierarchy.
+    void   Build(const std::vector<Ptr<CollisionModel> >& models);
+    void   Clear();
+
+    size_t GetModelCount() const { return Models.size(); }
+
+    // Returns whether p is inside any of the models.
+    bool   TestPoint(const Vector3f& p) const;
+
+    // Finds the nearest of the models' CollisionModel::TestRay hits within len of origin. On a
+    // hit, sets len and ph as CollisionModel::TestRay does and returns true.
+    bool   TestRay(const Vector3f& origin, const Vector3f& norm, float& len, Planef* ph = NULL) const;
+
+private:
+    struct BVHNode
+    {
+        Bounds3f Bounds;
+        int32_t  First;     // Leaf: the first of its Models. Interior: the first of two child Nodes.
+        int32_t  Count;     // Leaf: the number of its Models. Interior: 0.
+    };
+
+    void BuildNode(int32_t nodeIndex, int32_t first, int32_t count);
+
+    std::vector<BVHNode>                Nodes;      // Nodes[0] is the root.
+    std::vector<Ptr<CollisionModel> >   Models;     // In leaf order.
 };
 
+class Node;
+class Model;
+class InstancedModel;
+class FrustumCuller;
+class RenderQueue;
+
+} // namespace Render
+
+// Scene graph nodes, which are mostly Models, are created and released in bulk upon scene loads.
+template <>
+struct ObjectPoolTraits<Render::Node> : public ObjectPoolTraitsEnabled<Render::Node, Render::Model> {};
+
+namespace Render {
+
 class Node : public RefCountBase<Node>
 {
     Vector3f     Pos;
@@ -463,7 +569,11 @@ class Node : public RefCountBase<Node>
 	mutable bool      MatCurrent;
 
 public:
-    Node() : Pos(Vector3f(0)), MatCurrent(1) { }
+    // Bumped whenever the transform changes, which SceneTransforms::Update checks for. A count
+    // rather than a flag, since a node may be in more than one scene.
+    uint32_t          TransformVersion;
+
+    Node() : Pos(Vector3f(0)), MatCurrent(1), TransformVersion(0) { }
     virtual ~Node() { }
 
     enum NodeType
@@ -476,13 +586,17 @@ public:
 
     virtual void ClearRenderer() { }
 
+    // Like ClearRenderer, but hands the buffers and the textures of the fills to
+    // ren->ReleaseDeferred, so that the node can go away while the GPU may still be drawing it.
+    virtual void ReleaseRenderer(RenderDevice* ren) { OVR_UNUSED(ren); }
+
     const Vector3f&  GetPosition() const      { return Pos; }
     const Quatf&     GetOrientation() const   { return Rot; }
-    void             SetPosition(Vector3f p)  { Pos = p; MatCurrent = 0; }
-    void             SetOrientation(Quatf q)  { Rot = q; MatCurrent = 0; }
+    void             SetPosition(Vector3f p)  { Pos = p; MatCurrent = 0; TransformVersion++; }
+    void             SetOrientation(Quatf q)  { Rot = q; MatCurrent = 0; TransformVersion++; }
 
-    void             Move(Vector3f p)         { Pos += p; MatCurrent = 0; }
-    void             Rotate(Quatf q)          { Rot = q * Rot; MatCurrent = 0; }
+    void             Move(Vector3f p)         { Pos += p; MatCurrent = 0; TransformVersion++; }
+    void             Rotate(Quatf q)          { Rot = q * Rot; MatCurrent = 0; TransformVersion++; }
 
 
     // For testing only; causes Position an Orientation
@@ -490,6 +604,7 @@ public:
     {
         MatCurrent = true;
         Mat = m;        
+        TransformVersion++;
     }
 
 
@@ -505,6 +620,18 @@ public:
     }
 
 	virtual void     Render(const Matrix4f& ltw, RenderDevice* ren) { OVR_UNUSED2(ltw, ren); }
+
+    // Marks the models under this node which are outside all of culler's frustums so that Render
+    // skips them, given the parent's local-to-world transform, and returns how many were marked.
+    // A null culler marks them all visible.
+    virtual int      UpdateCulling(const Matrix4f& ltw, const FrustumCuller* culler) { OVR_UNUSED2(ltw, culler); return 0; }
+
+    // Sets the GPU vertex layout of the models under this node, dropping their buffers if it changes.
+    virtual void     SetVertexLayout(VertexLayout layout) { OVR_UNUSED(layout); }
+
+    // Adds the models under this node that Render would draw to queue, given the parent's
+    // local-to-world transform.
+    virtual void     CollectDrawItems(const Matrix4f& ltw, RenderQueue& queue) { OVR_UNUSED2(ltw, queue); }
 };
 
 struct Vertex
@@ -531,6 +658,26 @@ struct Vertex
     }
 };
 
+// Everything in a Vertex but its position, for the second stream of a VertexLayout_Split model.
+struct VertexAttributes
+{
+    Color     C;
+    float     U, V;
+    float     U2, V2;
+    Vector3f  Norm;
+};
+
+// A Vertex in 24 bytes rather than 44, for the stream of a VertexLayout_Quantized model. The
+// position is 16-bit snorm within the model's bounds, Model::GetDequantizeMatrix mapping it back;
+// the texture coordinates are half floats and the normal 8-bit snorm.
+struct QuantizedVertex
+{
+    int16_t   Pos[4];     // Pos[3] is 32767, so that W reads as 1.
+    Color     C;
+    uint16_t  UV[4];      // U, V, U2, V2
+    int8_t    Norm[4];    // Norm[3] is 0.
+};
+
 /*
 struct DistortionVertex
 {
@@ -582,24 +729,127 @@ class SwapChainCreationFailedException
 
 //-----------------------------------------------------------------------------------
 
+// Tests world space boxes against the union of up to MaxFrustums view frustums, such as the two
+// eye frustums of a frame. Only the four side planes of each frustum are used: together they
+// exclude everything behind the eye, and they don't depend on the depth range or on whether the
+// far plane is at infinity.
+class FrustumCuller
+{
+public:
+    enum { MaxFrustums = 8 };
+
+    FrustumCuller() : FrustumCount(0) { }
+
+    void Clear() { FrustumCount = 0; }
+
+    // Adds the frustum of a projection * view matrix. Returns false if MaxFrustums are held.
+    bool AddFrustum(const Matrix4f& clipFromWorld);
+
+    int  GetFrustumCount() const { return FrustumCount; }
+
+    // Returns true if the box may be visible in any of the frustums.
+    bool IsVisible(const Vector3f& center, const Vector3f& halfExtents) const;
+
+    // Returns true if the box of a model with the given local bounds and local-to-world transform
+    // may be visible. Empty bounds are always visible.
+    bool IsVisible(const Bounds3f& localBounds, const Matrix4f& ltw) const;
+
+private:
+    // The side planes of each frustum, by component, so that one frustum is tested as a vector.
+    // A point p is inside plane i of frustum f if PlaneX[f][i]*p.x + ... + PlaneW[f][i] >= 0.
+    float PlaneX[MaxFrustums][4];
+    float PlaneY[MaxFrustums][4];
+    float PlaneZ[MaxFrustums][4];
+    float PlaneW[MaxFrustums][4];
+    int   FrustumCount;
+};
+
+// The models of a scene traversal, sorted so that models sharing shaders and textures are drawn
+// together, and front to back within each group. Build it once a frame, after culling, and render
+// it for each eye; rendering skips setting a Fill that is already set.
+class RenderQueue
+{
+public:
+    RenderQueue() : Built(false) { }
+
+    void Clear();
+
+    // Called by Node::CollectDrawItems.
+    void Add(Model* model, const Matrix4f& worldFromModel);
+
+    // Sorts the added models, by distance from viewPos within each group of them sharing shaders
+    // and textures.
+    void Sort(const Vector3f& viewPos);
+
+    // Whether Sort has been called since the last Clear.
+    bool   IsBuilt() const      { return Built; }
+    size_t GetItemCount() const { return Items.size(); }
+
+    // Records the draws in parallel through RenderDevice::RecordParallel while that is enabled
+    // and every model HasRenderBuffers.
+    void Render(RenderDevice* ren, const Matrix4f& view) const;
+
+    // Draws only the depth of the models, with colour writes off and nearest first regardless of
+    // fill, through RenderDevice::RenderModelDepth. Render after it with the depth test passing
+    // equal depths then shades each visible pixel once.
+    void RenderDepth(RenderDevice* ren, const Matrix4f& view) const;
+
+private:
+    bool HasRenderBuffers() const;
+
+    struct Item
+    {
+        Model*   pModel;
+        Matrix4f WorldFromModel;
+    };
+
+    std::vector<Item>     Items;
+    std::vector<uint32_t> Order;        // Items in draw order, once sorted.
+    std::vector<uint32_t> DepthOrder;   // Items nearest first, for RenderDepth.
+    std::vector<uint64_t> Keys;
+    std::vector<uint64_t> KeyScratch;
+    std::vector<uint32_t> OrderScratch;
+    bool                  Built;
+};
+
 class Model : public Node
 {
 public:
     std::string             AssetName;
     std::vector<Vertex>     Vertices;
-    std::vector<uint16_t>   Indices;
+    std::vector<uint32_t>   Indices;    // Stored in a 16-bit index buffer when they all fit.
     PrimitiveType           Type;
     Ptr<class Fill>         Fill;
     bool                    Visible;
     bool                    IsCollisionModel;
+    bool                    Culled;     // Set by UpdateCulling; Render skips the model while set.
+    bool                    Occluded;   // Set by OcclusionCuller::Update and cleared by UpdateCulling; likewise.
+    VertexLayout            Layout;
 
     // Some renderers will create these if they didn't exist before rendering.
     // Currently they are not updated, so vertex data should not be changed after rendering.
+    // With VertexLayout_Split, VertexBuffer holds only the positions and AttributeBuffer the rest.
     Ptr<Buffer>       VertexBuffer;
+    Ptr<Buffer>       AttributeBuffer;
     Ptr<Buffer>       IndexBuffer;
 
+    // With VertexLayout_Quantized, a position p from VertexBuffer is QuantizeBias + p * QuantizeScale
+    // in model space. Set by QuantizeVertices along with the buffer.
+    Vector3f          QuantizeBias;
+    float             QuantizeScale;
+
+    // Simplified versions of the mesh from GenerateLods, coarsest last, and the furthest each
+    // may have moved the surface, in model units. Draw uses Lods[CurrentLod - 1] in place of the
+    // model's own mesh while CurrentLod isn't 0; Scene::SelectLods sets it.
+    std::vector<Ptr<Model> > Lods;
+    std::vector<float>       LodErrors;
+    int                      CurrentLod;
+
     Model(PrimitiveType t = Prim_Triangles, const char* assetName = nullptr)
-        : AssetName(), Type(t), Fill(NULL), Visible(true), IsCollisionModel(false)
+        : AssetName(), Type(t), Fill(NULL), Visible(true), IsCollisionModel(false), Culled(false),
+          Occluded(false), Layout(VertexLayout_Interleaved), QuantizeBias(), QuantizeScale(1.0f),
+          Lods(), LodErrors(), CurrentLod(0),
+          LocalBounds(), LocalBoundsCurrent(false)
     {
         AssetName = "Model: ";
         if (assetName)
@@ -613,42 +863,112 @@ public:
 
     virtual void Render(const Matrix4f& ltw, RenderDevice* ren);
 
+    // Draws the model with the given view-from-model transform, without the visibility checks.
+    virtual void Draw(const Matrix4f& viewFromModel, RenderDevice* ren);
+
+    // Draws the depth of the mesh Draw uses with fill, once Draw has made its buffers. Just the
+    // positions are read when fill is RenderDevice::GetDepthFill.
+    virtual void DrawDepth(const Matrix4f& viewFromModel, RenderDevice* ren, const class Fill* fill);
+
+    virtual int  UpdateCulling(const Matrix4f& ltw, const FrustumCuller* culler);
+
+    virtual void CollectDrawItems(const Matrix4f& ltw, RenderQueue& queue);
+
+    // Render and UpdateCulling, given the model's own transform rather than its parent's.
+    void RenderAt(const Matrix4f& viewFromModel, RenderDevice* ren);
+    int  UpdateCullingAt(const Matrix4f& worldFromModel, const FrustumCuller* culler);
+
     PrimitiveType GetPrimType() const { return Type; }
 
+    // Returns the bounds of Vertices in model space, computed when first needed after vertices
+    // are added. Empty if there are no vertices.
+    virtual const Bounds3f& GetLocalBounds() const;
+
     void SetVisible(bool visible) { Visible = visible; }
     bool IsVisible() const        { return Visible; }
 
     void ClearRenderer()
     {
         VertexBuffer.Clear();
+        AttributeBuffer.Clear();
         IndexBuffer.Clear();
+        for (size_t i = 0; i < Lods.size(); i++)
+        {
+            Lods[i]->ClearRenderer();
+        }
+    }
+
+    virtual void ReleaseRenderer(RenderDevice* ren);
+
+    // Whether the buffers a renderer creates on first draw exist, so that drawing the model
+    // changes nothing in it. Models are only drawn from several threads at once once they do.
+    virtual bool HasRenderBuffers() const
+    {
+        return (Vertices.empty() || (VertexBuffer && ((Layout != VertexLayout_Split) || AttributeBuffer))) &&
+               (Indices.empty() || IndexBuffer);
+    }
+
+    // HasRenderBuffers for the mesh Draw currently uses.
+    virtual bool HasDrawBuffers() const
+    {
+        const Model* mesh = GetLodMesh();
+        return (mesh == this) ? HasRenderBuffers() : mesh->HasRenderBuffers();
+    }
+
+    virtual void SetVertexLayout(VertexLayout layout)
+    {
+        if (layout != Layout)
+        {
+            Layout = layout;
+            ClearRenderer();
+        }
+    }
+
+    // The mesh Draw uses: this model, or the level of detail SelectLod picked.
+    Model*       GetLodMesh()       { return (CurrentLod > 0) ? Lods[CurrentLod - 1].GetPtr() : this; }
+    const Model* GetLodMesh() const { return (CurrentLod > 0) ? Lods[CurrentLod - 1].GetPtr() : this; }
+
+    // Fills positions and attributes with the two streams of a VertexLayout_Split model.
+    void GetSplitVertexStreams(std::vector<Vector3f>& positions,
+                               std::vector<VertexAttributes>& attributes) const;
+
+    // Fills vertices with the stream of a VertexLayout_Quantized model, and sets QuantizeBias and
+    // QuantizeScale to the centre and the largest half extent of the local bounds.
+    void QuantizeVertices(std::vector<QuantizedVertex>& vertices);
+
+    // Maps quantized positions to model space, and goes after the view-from-model transform they
+    // are drawn with. The scale is uniform, so normals only change length.
+    Matrix4f GetDequantizeMatrix() const
+    {
+        return Matrix4f::Translation(QuantizeBias) * Matrix4f::Scaling(QuantizeScale);
     }
 
     // Returns the index next added vertex will have.
-    uint16_t GetNextVertexIndex() const
+    uint32_t GetNextVertexIndex() const
     {
-        return (uint16_t)Vertices.size();
+        return (uint32_t)Vertices.size();
     }
 
-    uint16_t AddVertex(const Vertex& v)
+    uint32_t AddVertex(const Vertex& v)
     {
 		    OVR_ASSERT(!VertexBuffer && !IndexBuffer);
 		    size_t size = Vertices.size();
-		    OVR_ASSERT(size <= USHRT_MAX);      // We only use a short to store vert indices.
-		    uint16_t index = (uint16_t) size;
+		    OVR_ASSERT(size <= UINT_MAX);
+		    uint32_t index = (uint32_t) size;
 		    Vertices.push_back(v);
+		    LocalBoundsCurrent = false;
 		    return index;
     }
-    uint16_t AddVertex(const Vector3f& v, const Color& c, float u_ = 0, float v_ = 0)
+    uint32_t AddVertex(const Vector3f& v, const Color& c, float u_ = 0, float v_ = 0)
     {
         return AddVertex(Vertex(v,c,u_,v_));
     }
-    uint16_t AddVertex(float x, float y, float z, const Color& c, float u, float v)
+    uint32_t AddVertex(float x, float y, float z, const Color& c, float u, float v)
     {
         return AddVertex(Vertex(Vector3f(x,y,z),c, u,v));
     }
 
-    void AddLine(uint16_t a, uint16_t b)
+    void AddLine(uint32_t a, uint32_t b)
     {
         Indices.push_back(a);
         Indices.push_back(b);
@@ -656,23 +976,23 @@ public:
 
 	  void AddQuad(Vertex v0, Vertex v1, Vertex v2, Vertex v3)
 	  {
-		    int t = GetNextVertexIndex();
+		    uint32_t t = GetNextVertexIndex();
 		    AddVertex(v0);
 		    AddVertex(v1);
 		    AddVertex(v2);
 		    AddVertex(v3);
-		    AddTriangle(uint16_t(t), uint16_t(t + 3), uint16_t(t + 1));
-		    AddTriangle(uint16_t(t), uint16_t(t + 2), uint16_t(t + 3));
+		    AddTriangle(t, t + 3, t + 1);
+		    AddTriangle(t, t + 2, t + 3);
 	  }
 
 
-    uint16_t AddVertex(float x, float y, float z, const Color& c,
+    uint32_t AddVertex(float x, float y, float z, const Color& c,
                       float u, float v, float nx, float ny, float nz)
     {
         return AddVertex(Vertex(Vector3f(x,y,z),c, u,v, Vector3f(nx,ny,nz)));
     }
 
-	  uint16_t AddVertex(float x, float y, float z, const Color& c,
+	  uint32_t AddVertex(float x, float y, float z, const Color& c,
                        float u1, float v1, float u2, float v2, float nx, float ny, float nz)
     {
         return AddVertex(Vertex(Vector3f(x,y,z), c, u1, v1, u2, v2, Vector3f(nx,ny,nz)));
@@ -683,13 +1003,58 @@ public:
         AddLine(AddVertex(a), AddVertex(b));
     }
 
-    void AddTriangle(uint16_t a, uint16_t b, uint16_t c)
+    void AddTriangle(uint32_t a, uint32_t b, uint32_t c)
     {
         Indices.push_back(a);
         Indices.push_back(b);
         Indices.push_back(c);
     }
 
+    // Whether Indices need a 32-bit index buffer.
+    bool NeedsIndex32() const { return Vertices.size() > 0x10000; }
+
+    // Fills ib with Indices, as 16-bit indices unless NeedsIndex32.
+    bool SetIndexBufferData(Buffer* ib) const;
+
+    // Splits a Prim_Triangles model into clusters of at most maxTriangles spatially close
+    // triangles each, so that culling can reject parts of a big mesh. Each cluster gets only the
+    // vertices it uses, and this model's Fill, layout and transform. Appends them to clusters.
+    void SplitIntoClusters(size_t maxTriangles, std::vector<Ptr<Model> >& clusters) const;
+
+    // The reverse: merges Prim_Triangles models into as few models as it can, each of at most
+    // maxVertices vertices and no larger than maxExtent along any axis, so that the parts of a
+    // scene sharing a Fill draw together while culling still rejects what's out of view. The
+    // models are taken along a Morton curve through their centers, and have their transforms
+    // applied to the vertices; merged models get the first one's Fill and layout, and as many
+    // levels of detail as the most any of them has, each merged from the models' own at that
+    // level or their coarsest. Models that don't merge with any other are appended to merged as
+    // they are.
+    static void MergeModels(const std::vector<Ptr<Model> >& models, size_t maxVertices, float maxExtent,
+                            std::vector<Ptr<Model> >& merged);
+
+    // Reorders the triangles of a Prim_Triangles model for post-transform vertex cache hits
+    // (Forsyth's linear-speed algorithm), then renumbers Vertices in order of first use for fetch
+    // locality. Each triangle keeps its winding. Call before the model is first rendered.
+    void OptimizeVertexCache();
+
+    // Returns a simplified copy of a Prim_Triangles model with at most targetTriangles triangles
+    // where it can get there, by quadric error edge collapses (Garland and Heckbert) which move a
+    // vertex onto a neighbour. Vertices on open edges or texture seams stay where they are, and a
+    // collapse that would flip a triangle isn't made. Sets error to the furthest the surface may
+    // have moved. The copy has only the vertices it uses, cache optimized, and no transform.
+    Model* Simplify(size_t targetTriangles, float& error) const;
+
+    // Replaces Lods with up to maxLods simplified meshes, each with about half the triangles of
+    // the one before, stopping once a mesh has fewer than minTriangles or simplifying it gains
+    // little. Call before the model is first rendered.
+    void GenerateLods(int maxLods, size_t minTriangles);
+
+    // Picks the coarsest level whose error, times errorScale, is within maxError, moving only when
+    // the error is LodHysteresis past maxError so that a model near the limit doesn't flicker
+    // between two. Gives the level the model's Fill and layout. Returns CurrentLod.
+    int SelectLod(float errorScale, float maxError);
+    static const float LodHysteresis;
+
 
     // Uses texture coordinates for uniform world scaling (must use a repeat sampler).
     void  AddSolidColorBox(float x1, float y1, float z1,
@@ -716,6 +1081,72 @@ public:
     static Model* CreateGrid(Vector3f origin, Vector3f stepx, Vector3f stepy,
                              int halfx, int halfy, int nmajor = 5,
 							 Color minor = Color(64,64,64,192), Color major = Color(128,128,128,192));
+
+private:
+    mutable Bounds3f        LocalBounds;
+    mutable bool            LocalBoundsCurrent;
+};
+
+// A model whose vertices are drawn once for each of its instance transforms, with one draw call
+// where the device supports it. The instance transforms are from instance to model space and must
+// be affine.
+class InstancedModel : public Model
+{
+public:
+    std::vector<Matrix4f>   Instances;
+
+    // Created by RenderDevice::RenderInstanced, like VertexBuffer; holds the top three rows of
+    // each instance transform.
+    Ptr<Buffer>             InstanceBuffer;
+
+    InstancedModel(PrimitiveType t = Prim_Triangles, const char* assetName = nullptr)
+        : Model(t, assetName), Instances(), InstanceBuffer(), InstanceBounds(), InstanceBoundsCurrent(false)
+    {
+    }
+
+    virtual void Draw(const Matrix4f& viewFromModel, RenderDevice* ren);
+
+    // Draws nothing: instances may be drawn with a vertex shader of their own, whose depths
+    // needn't match the depth pass's exactly, so they are left to the main pass.
+    virtual void DrawDepth(const Matrix4f& viewFromModel, RenderDevice* ren, const class Fill* fill)
+    {
+        OVR_UNUSED3(viewFromModel, ren, fill);
+    }
+
+    // Returns the bounds of all the instances in model space.
+    virtual const Bounds3f& GetLocalBounds() const;
+
+    void ClearRenderer()
+    {
+        Model::ClearRenderer();
+        InstanceBuffer.Clear();
+    }
+
+    virtual void ReleaseRenderer(RenderDevice* ren);
+
+    virtual bool HasRenderBuffers() const
+    {
+        return Model::HasRenderBuffers() && (Instances.empty() || InstanceBuffer);
+    }
+
+    virtual bool HasDrawBuffers() const
+    {
+        return Model::HasDrawBuffers() && (Instances.empty() || InstanceBuffer);
+    }
+
+    void AddInstance(const Matrix4f& modelFromInstance)
+    {
+        OVR_ASSERT(!InstanceBuffer);
+        Instances.push_back(modelFromInstance);
+        InstanceBoundsCurrent = false;
+    }
+
+    // Fills rows with the top three rows of each instance transform, as InstanceBuffer holds them.
+    void GetInstanceRows(std::vector<Vector4f>& rows) const;
+
+private:
+    mutable Bounds3f        InstanceBounds;
+    mutable bool            InstanceBoundsCurrent;
 };
 
 class Container : public Node
@@ -734,31 +1165,106 @@ public:
             Nodes[i]->ClearRenderer();
     }
 
+    virtual void ReleaseRenderer(RenderDevice* ren)
+    {
+        for (size_t i=0; i< Nodes.size(); i++)
+            Nodes[i]->ReleaseRenderer(ren);
+    }
+
+    virtual void SetVertexLayout(VertexLayout layout)
+    {
+        for (size_t i=0; i< Nodes.size(); i++)
+            Nodes[i]->SetVertexLayout(layout);
+    }
+
     virtual NodeType GetType() const { return Node_Container; }
 
     virtual void Render(const Matrix4f& ltw, RenderDevice* ren);
 
-    void Add(Node *n) { Nodes.push_back(n); }
-    void Add(Model *n, class Fill *f) { n->Fill = f; Nodes.push_back(n); }
-    void RemoveLast() { Nodes.pop_back(); }
-    void Clear() { Nodes.clear(); }
+    virtual int  UpdateCulling(const Matrix4f& ltw, const FrustumCuller* culler);
+
+    virtual void CollectDrawItems(const Matrix4f& ltw, RenderQueue& queue);
+
+    void Add(Node *n) { Nodes.push_back(n); TopologyVersion++; }
+    void Add(Model *n, class Fill *f) { n->Fill = f; Nodes.push_back(n); TopologyVersion++; }
+    void RemoveLast() { Nodes.pop_back(); TopologyVersion++; }
+    void Clear() { Nodes.clear(); TopologyVersion++; }
+
+    // Counts changes to any Container's Nodes, so that SceneTransforms knows to rebuild.
+    static uint32_t    TopologyVersion;
 
 	bool               CollideChildren;
 
 	Container() : CollideChildren(1) {}
 };
 
+// The nodes of a Container tree in one array, parents before children, with their local and
+// world matrices alongside. Update recomputes only the world matrices of nodes whose transform
+// changed, or one of their ancestors' did, so a static subtree costs a version check per node.
+// Rebuilds itself when any Container's Nodes have changed since it was built.
+class SceneTransforms
+{
+public:
+    SceneTransforms() : BuiltVersion(0), Built(false) { }
+
+    void Build(Container& root);
+    void Clear();
+    void Update(Container& root);
+
+    size_t          GetCount() const                { return Nodes.size(); }
+    Node*           GetNode(size_t i) const         { return Nodes[i]; }
+    const Matrix4f& GetWorldMatrix(size_t i) const  { return WorldMatrices[i]; }
+
+private:
+    void add(Node* node, int32_t parent);
+
+    std::vector<Node*>    Nodes;
+    std::vector<int32_t>  Parents;          // Index of each node's parent, or -1.
+    std::vector<Matrix4f> LocalMatrices;
+    std::vector<Matrix4f> WorldMatrices;
+    std::vector<uint32_t> SeenVersions;     // Each node's TransformVersion at the last Update.
+    std::vector<uint8_t>  WorldChanged;     // Scratch for Update.
+    uint32_t              BuiltVersion;
+    bool                  Built;
+};
+
 class Scene
 {
 public:
     Container                   World;
+    SceneTransforms             Transforms;
     Vector3f                    LightPos[8];
     LightingParams	            Lighting;
     std::vector<Ptr<Model> >	Models;
 
 public:
+    // Brings Transforms up to date with World. Render, BuildRenderQueue and UpdateCulling do
+    // this themselves, and it costs little once done for a frame.
+    void UpdateTransforms() { Transforms.Update(World); }
+
     void Render(RenderDevice* ren, const Matrix4f& view);
 
+    // Fills queue with the World models Render would draw, sorted for viewPos, so that each eye
+    // can render it with the Render below.
+    void BuildRenderQueue(RenderQueue& queue, const Vector3f& viewPos);
+    void Render(RenderDevice* ren, const Matrix4f& view, const RenderQueue& queue);
+    // The queue's depth pass, for before the Render above.
+    void RenderDepth(RenderDevice* ren, const Matrix4f& view, const RenderQueue& queue);
+
+    // Culls the World models outside all of the culler's frustums from later Renders, until the
+    // next UpdateCulling or ClearCulling. Returns the number of models culled.
+    int  UpdateCulling(const FrustumCuller& culler);
+    void ClearCulling();
+
+    // Picks each World model's level of detail for a view from viewPos, as the coarsest whose
+    // error projects to at most maxPixelError pixels at the model's nearest point, where
+    // pixelsPerUnit is the projected pixels per world unit at a distance of one. Models culled
+    // keep theirs. The instances of an InstancedModel share a level, picked for the nearest.
+    // Returns the number of models drawn with a simplified mesh. ClearLods goes back to the full
+    // meshes.
+    int  SelectLods(const Vector3f& viewPos, float pixelsPerUnit, float maxPixelError);
+    void ClearLods();
+
     void SetAmbient(Color4f color)
     {
         Lighting.Ambient = color;
@@ -775,6 +1281,7 @@ public:
 	void Clear()
 	{
 		World.Clear();
+		Transforms.Clear();
 		Models.clear();
 		Lighting.Ambient = Color4f(0.0f, 0.0f, 0.0f, 0.0f);
 		Lighting.LightCount = 0;
@@ -784,6 +1291,16 @@ public:
     {
         World.ClearRenderer();
     }
+
+    void ReleaseRenderer(RenderDevice* ren)
+    {
+        World.ReleaseRenderer(ren);
+    }
+
+    void SetVertexLayout(VertexLayout layout)
+    {
+        World.SetVertexLayout(layout);
+    }
 };
 
 class SceneView : public Node
@@ -831,6 +1348,47 @@ struct RendererParams
 
 
 
+//-----------------------------------------------------------------------------------
+// ***** MultiresLayout
+
+// The SDK's octilinear texture layout, for lens-matched shading. The eye's clip space is split
+// into quadrants at its center, and in each w grows with the distance from the split, so the
+// pixels thin out toward the edges of the view, where the lens spreads them anyway. Sizes are
+// the pixels each quadrant takes from the split, in an eye viewport of GetSize.
+struct MultiresLayout
+{
+    float WarpLeft, WarpRight, WarpUp, WarpDown;
+    int   SizeLeft, SizeRight, SizeUp, SizeDown;
+
+    MultiresLayout()
+      : WarpLeft(0), WarpRight(0), WarpUp(0), WarpDown(0), SizeLeft(0), SizeRight(0), SizeUp(0), SizeDown(0) { }
+
+    // The layout with the density of a rectilinear viewport of size at its center, and warp in
+    // each quadrant. A warp of 0.5 renders the edges at under half density in each axis.
+    static MultiresLayout Make(Sizei size, float warp);
+
+    Sizei GetSize() const { return Sizei(SizeLeft + SizeRight, SizeUp + SizeDown); }
+    ovrTextureLayoutOctilinear GetOvrLayout() const;
+};
+
+
+//-----------------------------------------------------------------------------------
+// ***** GpuPassTime
+
+// The GPU time of one AutoGpuProf scope, from a frame the GPU has finished.
+struct GpuPassTime
+{
+    const char* Name;
+    int         Depth;          // Nesting depth, 0 for scopes not inside another
+    double      Milliseconds;
+
+    // Begin and end in Timer::GetTicksRaw ticks, for the trace exporter. The GPU clock is
+    // aligned with the CPU at the start of the frame, so this is only approximate.
+    uint64_t    BeginTicks;
+    uint64_t    EndTicks;
+};
+
+
 //-----------------------------------------------------------------------------------
 // ***** RenderDevice
 
@@ -847,17 +1405,221 @@ protected:
     Vector4f            GlobalTint;
     Ptr<Buffer>         pTextVertexBuffer;
 
+    // Tessellated strings, relative to the string's origin, keyed by everything that goes into
+    // their vertices. Cleared when it outgrows TextMeshCacheSize, which drops the strings that
+    // changed along with the static ones.
+    struct TextMeshKey
+    {
+        const Font*     pFont;
+        float           Size;
+        Color           TextColor;
+        std::string     Str;
+
+        bool operator==(const TextMeshKey& other) const
+        {
+            return (pFont == other.pFont) && (Size == other.Size) && (TextColor == other.TextColor) &&
+                   (Str == other.Str);
+        }
+    };
+    struct TextMeshKeyHash
+    {
+        size_t operator()(const TextMeshKey& key) const
+        {
+            const uint32_t c = (uint32_t(key.TextColor.R) << 24) | (uint32_t(key.TextColor.G) << 16) |
+                               (uint32_t(key.TextColor.B) << 8) | key.TextColor.A;
+            return std::hash<std::string>()(key.Str) ^ (std::hash<const void*>()(key.pFont) * 31) ^
+                   (std::hash<float>()(key.Size) * 131) ^ (c * 2654435761u);
+        }
+    };
+    enum { TextMeshCacheSize = 512 };
+    std::unordered_map<TextMeshKey, std::vector<Vertex>, TextMeshKeyHash> TextMeshes;
+
+    // Text waiting to be drawn, transformed to where it's drawn, one batch per font.
+    struct TextBatch
+    {
+        const Font*         pFont;
+        std::vector<Vertex> Vertices;
+    };
+    std::vector<TextBatch> TextBatches;
+    int                    TextBatchDepth;
+
     size_t		        TotalTextureMemoryUsage;
 
     // For lighting on platforms with uniform buffers
     Ptr<Buffer>         LightingBuffer;
 
+    // GPU pass timing. Each frame's timestamps go to the next of GpuTimerFrameCount query
+    // sets, and are read back when that set comes around again, by which time the GPU has
+    // normally finished with it.
+    enum { GpuTimerFrameCount = 4, GpuTimerMaxTimestamps = 256 };
+
+    struct GpuTimerPass
+    {
+        const char* Name;
+        int         Depth;
+        int         BeginIndex;
+        int         EndIndex;       // -1 if the pass didn't end within the frame
+    };
+
+    struct GpuTimerFrame
+    {
+        std::vector<GpuTimerPass> Passes;
+        int         TimestampCount;
+        bool        Pending;        // Issued, and not read back yet
+        uint64_t    CpuBeginTicks;  // Timer::GetTicksRaw when the frame began
+    };
+
+    bool                        GpuTimingEnabled;
+    bool                        GpuTimerFrameOpen;
+    int                         GpuTimerFrameIndex;
+    GpuTimerFrame               GpuTimerFrames[GpuTimerFrameCount];
+    std::vector<int>            GpuTimerStack;  // Passes of the open frame, -1 for untimed ones
+    std::vector<GpuPassTime>    GpuPassTimes;
+    std::vector<uint64_t>       GpuTimestampScratch;
+
+    enum GpuTimerReadResult
+    {
+        GpuTimerRead_NotReady,
+        GpuTimerRead_Ready,
+        GpuTimerRead_Invalid,   // The GPU clock changed during the frame
+    };
+
+    // Implemented by devices which support timestamp queries. Create makes the query sets and
+    // returns false if it can't; Read must not wait for the GPU, and returns timestamps in
+    // ticks of the given frequency.
+    virtual bool CreateGpuTimerQueries(int frameCount, int timestampsPerFrame) { OVR_UNUSED2(frameCount, timestampsPerFrame); return false; }
+    virtual void ReleaseGpuTimerQueries() { }
+    virtual void BeginGpuTimerQueries(int frame) { OVR_UNUSED(frame); }
+    virtual void WriteGpuTimestamp(int frame, int index) { OVR_UNUSED2(frame, index); }
+    virtual void EndGpuTimerQueries(int frame) { OVR_UNUSED(frame); }
+    virtual GpuTimerReadResult ReadGpuTimestamps(int frame, int count, uint64_t* timestamps, uint64_t& frequency)
+    { OVR_UNUSED4(frame, count, timestamps, frequency); return GpuTimerRead_Invalid; }
+
+    void resetGpuTimerFrames();
+
+    // Occlusion queries, in per frame sets read back as the timer queries are. Serials number
+    // the frames begun, from 1, so that results can be matched to the frame that asked.
+    enum { OcclusionFrameCount = 4, OcclusionMaxQueries = 2048 };
+
+    struct OcclusionFrame
+    {
+        int         QueryCount;
+        bool        Pending;        // Issued, and not read back yet
+        uint64_t    Serial;
+    };
+
+    bool                        OcclusionQueriesEnabled;
+    bool                        OcclusionFrameOpen;
+    int                         OcclusionFrameIndex;
+    uint64_t                    OcclusionFrameSerial;   // Of the latest frame begun
+    OcclusionFrame              OcclusionFrames[OcclusionFrameCount];
+    std::vector<uint64_t>       OcclusionSamples;
+    std::vector<uint64_t>       OcclusionScratch;
+    uint64_t                    OcclusionSamplesSerial; // Of the frame OcclusionSamples came from
+    Ptr<Model>                  OcclusionBox;           // Unit cube drawn for each query
+
+    Ptr<Fill>                   DepthFill;              // Made by GetDepthFill
+
+    // Implemented by devices which support occlusion queries. Create makes the query sets and
+    // returns false if it can't; Read must not wait for the GPU, and returns false until every
+    // one of the frame's count queries has its number of samples.
+    virtual bool CreateOcclusionQueries(int frameCount, int queriesPerFrame) { OVR_UNUSED2(frameCount, queriesPerFrame); return false; }
+    virtual void ReleaseOcclusionQueries() { }
+    virtual void BeginOcclusionQuery(int frame, int index) { OVR_UNUSED2(frame, index); }
+    virtual void EndOcclusionQuery(int frame, int index) { OVR_UNUSED2(frame, index); }
+    virtual bool ReadOcclusionQueries(int frame, int count, uint64_t* samples) { OVR_UNUSED3(frame, count, samples); return false; }
+
+    void resetOcclusionFrames();
+
+    // Deferred destruction. Each release is tagged with the frame it came in, and dropped by
+    // RetireFrame once the fence signalled at the end of that frame has completed. Fences
+    // complete in order, so a completed one retires every earlier frame too.
+    enum { DeferredReleaseFrameCount = 4 };
+
+    struct DeferredRelease
+    {
+        Ptr<Buffer>     pBuffer;
+        Ptr<Texture>    pTexture;
+        uint64_t        Frame;
+    };
+
+    struct ReleaseFence
+    {
+        uint64_t        Frame;
+        bool            Pending;    // Signalled, and not seen to complete yet
+    };
+
+    Lock                        DeferredReleaseLock;    // Guards DeferredReleases and ReleaseFrame
+    std::list<DeferredRelease>  DeferredReleases;       // Oldest first
+    uint64_t                    ReleaseFrame;           // Frame releases are tagged with now
+    uint64_t                    RetiredFrame;           // Latest frame the GPU has finished
+    int                         ReleaseFenceIndex;
+    ReleaseFence                ReleaseFences[DeferredReleaseFrameCount];
+
+    // Implemented by devices which can fence the GPU. Signal marks the end of the work
+    // submitted so far in slot, or returns false if it can't; IsFrameFenceDone must not wait
+    // for the GPU. Without fences, releases are kept for DeferredReleaseFrameCount frames,
+    // longer than the GPU normally runs behind.
+    virtual bool SignalFrameFence(int slot) { OVR_UNUSED(slot); return false; }
+    virtual bool IsFrameFenceDone(int slot) { OVR_UNUSED(slot); return true; }
+
+    void resetDeferredReleases();
+
+    // While a fill batch is open, devices skip Fill::Set for a fill and primitive already set.
+    bool                FillBatchOpen;
+    const Fill*         BatchedFill;
+    PrimitiveType       BatchedFillPrim;
+
+    // Implemented by devices which support instancing. Draws instanceCount instances of
+    // interleaved vertices, each transformed by three rows from instances, or returns false
+    // without drawing if fill can't be instanced.
+    virtual bool RenderInstances(const Fill* fill, Buffer* vertices, Buffer* indices, Buffer* instances,
+                                 const Matrix4f& matrix, int count, int instanceCount, PrimitiveType prim)
+    { OVR_UNUSED4(fill, vertices, indices, instances); OVR_UNUSED4(matrix, count, instanceCount, prim); return false; }
+
+    // Single-pass stereo state, set by BeginStereoPass.
+    bool                StereoPassActive;
+    Recti               StereoViewport;         // Both eye viewports
+    Recti               StereoEyeViewports[2];
+    Matrix4f            StereoEyeProj[2];       // Each eye's projection
+    Matrix4f            StereoEyeFromLeft[2];
+    Matrix4f            StereoClipFromLeft[2];  // To each eye's half of StereoViewport's clip space
+    Vector4f            StereoClipPlanes[2];    // Clip-space planes bounding each eye's half
+
+    bool                MultiresActive;         // Between BeginMultires and EndMultires
+    Recti               MultiresViewport;
+
+    // Implemented by devices which support single-pass stereo: returns whether draws with fill
+    // can go to both eyes at once, as two instances whose uniforms hold StereoClipFromLeft and
+    // StereoClipPlanes. Draws with other fills are done once per eye.
+    virtual bool CanRenderStereo(const Fill* fill) { OVR_UNUSED(fill); return false; }
+
+    bool                ParallelRecordingEnabled;
+
+    // Returns the cached vertices of str drawn at the origin, tessellating it if needed.
+    const std::vector<Vertex>& GetTextMesh(const Font* font, const char* str, float size, Color c);
+    bool HasPendingText() const;
+
+    // Returns whether fill needs setting for a draw, and notes it as set.
+    bool needsFillSet(const Fill* fill, PrimitiveType prim)
+    {
+        if (FillBatchOpen && (fill == BatchedFill) && (prim == BatchedFillPrim))
+        {
+            return false;
+        }
+        BatchedFill = fill;
+        BatchedFillPrim = prim;
+        return true;
+    }
+
 public:
     enum CompareFunc
     {
         Compare_Always  = 0,
         Compare_Less    = 1,
         Compare_Greater = 2,
+        Compare_LessEqual    = 3,
+        Compare_GreaterEqual = 4,
         Compare_Count
     };
 
@@ -905,6 +1667,9 @@ public:
     // Resources
     virtual Buffer*  CreateBuffer() = 0;
     virtual Texture* CreateTexture(uint64_t format, int width, int height, const void* data, int mipcount = 1, ovrResult* error = nullptr) = 0;
+    // Copies each of slices, which must share their format, size and mips, into a slice of a new
+    // array texture, for the array shaders. Returns NULL where the device or the format can't.
+    virtual Texture* CreateTextureArray(const std::vector<Texture*>& slices) { OVR_UNUSED(slices); return NULL; }
 
     virtual ShaderSet* CreateShaderSet() { return new ShaderSetMatrixTranspose; }
     virtual Shader* LoadBuiltinShader(ShaderStage stage, int shader) = 0;
@@ -922,6 +1687,11 @@ public:
     // Finish scene.
     void FinishScene();
 
+    // Between these, a draw with the same fill and primitive as the last one doesn't set the fill
+    // again. Only draws which leave the device state a fill sets unchanged may be batched.
+    void BeginFillBatch()   { FillBatchOpen = true; BatchedFill = nullptr; }
+    void EndFillBatch()     { FillBatchOpen = false; BatchedFill = nullptr; }
+
     virtual void ResolveMsaa(Texture* msaaTex, Texture* outputTex) = 0;
 
     // Texture must have been created with Texture_RenderTarget. Use NULL for the default render target.
@@ -953,6 +1723,10 @@ public:
     virtual void EnableScissor(bool /*enabled*/) { OVR_ASSERT(false); }
     virtual void SetCullMode(CullMode cullMode) = 0;
 
+    // Turns writes to the colour target on or off, such as for occlusion tests. Implemented by
+    // the devices which support occlusion queries.
+    virtual void SetColorWrite(bool enabled) { OVR_UNUSED(enabled); }
+
     // The index 0 is reserved for non-buffer uniforms, and so cannot be used with this function.
     virtual void SetCommonUniformBuffer(int i, Buffer* buffer) { OVR_UNUSED2(i, buffer); }
 
@@ -964,6 +1738,70 @@ public:
                         PrimitiveType prim = Prim_Triangles) = 0;
 	virtual void RenderWithAlpha(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
 		const Matrix4f& matrix, int offset, int count, PrimitiveType prim = Prim_Triangles) = 0;
+    // Renders from a Vector3f position stream and a VertexAttributes stream, as a
+    // VertexLayout_Split model uses. firstVertex is in vertices; indices can be null. attributes
+    // can be null too, to fetch only the positions, and the attributes then read as zero.
+    virtual void RenderSplit(const Fill* fill, Buffer* positions, Buffer* attributes, Buffer* indices,
+                             const Matrix4f& matrix, int firstVertex, int count,
+                             PrimitiveType prim = Prim_Triangles) = 0;
+    // Renders from a stream of QuantizedVertex, as a VertexLayout_Quantized model uses; matrix
+    // must end with the model's GetDequantizeMatrix. firstVertex is in vertices; indices can be null.
+    virtual void RenderQuantized(const Fill* fill, Buffer* vertices, Buffer* indices,
+                                 const Matrix4f& matrix, int firstVertex, int count,
+                                 PrimitiveType prim = Prim_Triangles) = 0;
+    // Whether the device can fetch the vertices of models with layout. Callers of
+    // Node::SetVertexLayout should keep to VertexLayout_Interleaved otherwise.
+    virtual bool SupportsVertexLayout(VertexLayout layout) const { OVR_UNUSED(layout); return true; }
+    // Draws each instance of model, with one instanced draw once its buffers exist if the device
+    // supports instancing the model's fill, and with a draw per instance otherwise.
+    void RenderInstanced(const Matrix4f& matrix, InstancedModel* model);
+
+    // Draws model with Model::Draw, to both eyes during a stereo pass.
+    void RenderModel(const Matrix4f& matrix, Model* model);
+
+    // Likewise with Model::DrawDepth, for a depth pass, with the fill GetDepthPassFill gives for
+    // the model's. Colour writes should be disabled around it with SetColorWrite.
+    void RenderModelDepth(const Matrix4f& matrix, Model* model);
+
+    // The fill a depth pass draws models of fill with: GetDepthFill, unless fill's fragment
+    // shader is a builtin which discards pixels by texture alpha, when it's fill itself, or one
+    // which blends, when it's null as the model mustn't be drawn. Other fragment shaders are
+    // taken to write every pixel.
+    const Fill* GetDepthPassFill(const Fill* fill);
+    // Draws positions with MVP and writes a solid colour, for what the depth pass needs no more of.
+    Fill*       GetDepthFill();
+
+    // Starts a single-pass stereo pass, in which RenderModel draws each model to both eyes with
+    // one draw call where the device can. The eye viewports must be side by side, the left one
+    // first, with the same y and height. View matrices passed to draws are the left eye's;
+    // rightFromLeft takes its view space to the right eye's. Returns false, starting no pass, if
+    // the device doesn't support it or the viewports aren't laid out so.
+    bool BeginStereoPass(const Recti eyeViewports[2], const Matrix4f eyeProjections[2],
+                         const Matrix4f& rightFromLeft);
+    // Ends the pass. The viewport and projection are left as StereoViewport's and undefined.
+    void EndStereoPass();
+    bool IsStereoPassActive() const { return StereoPassActive; }
+
+    // Late latching: where supported, the MVP vertex shaders take their view through a
+    // correction the GPU reads from a buffer as it draws, so the view of a frame's world can be
+    // rewritten after its draws are submitted. BeginLateLatchFrame starts both eyes' corrections
+    // at identity, SetLateLatchEye picks the eye later draws use, or none for -1 as for
+    // head-locked draws, and UpdateLateLatch sets each eye's correction, from its view as drawn
+    // to its view now. Draws the GPU has already run keep the view they were drawn with.
+    virtual bool SupportsLateLatch() const { return false; }
+    virtual void BeginLateLatchFrame() { }
+    virtual void SetLateLatchEye(int eye) { OVR_UNUSED(eye); }
+    virtual void UpdateLateLatch(const Matrix4f corrections[2]) { OVR_UNUSED(corrections); }
+
+    // Multiresolution: where supported, the triangles drawn with the MVP vertex shaders between
+    // BeginMultires and EndMultires go out in layout, to the eye viewport of its size at
+    // pos, for submitting with an ovrLayerEyeFovMultires layer. Other draws only reach the top
+    // left quadrant, and stereo passes can't be begun. EndMultires leaves the viewport as the
+    // whole eye viewport.
+    virtual bool SupportsMultires() const { return false; }
+    virtual bool BeginMultires(const Vector2i& pos, const MultiresLayout& layout) { OVR_UNUSED2(pos, layout); return false; }
+    virtual void EndMultires() { }
+    bool IsMultiresActive() const { return MultiresActive; }
 
     // Returns width of text in same units as drawing. If strsize is not null, stores width and height.
     // Can optionally return char-range selection rectangle.
@@ -971,6 +1809,14 @@ public:
                              const size_t charRange[2] = 0, Vector2f charRangeRect[2] = 0);
     virtual void RenderText(const Font* font, const char* str, float x, float y, float size, Color c, const Matrix4f* view = NULL);
 
+    // Between these, RenderText collects its text for one draw per font, made at the outermost
+    // EndTextBatch or before the next rect, line or image so that text keeps its order with
+    // those. Other draws made inside a batch go underneath its text.
+    void BeginTextBatch();
+    void EndTextBatch();
+    // Draws the text RenderText has collected. Devices override this to set up blending.
+    virtual void FlushText();
+
     virtual void FillRect(float left, float top, float right, float bottom, Color c, const Matrix4f* view = NULL);
     void RenderLines ( int NumLines, Color c, float *x, float *y, float *z = nullptr );
     virtual void FillTexturedRect(
@@ -1034,12 +1880,129 @@ public:
     virtual void BeginGpuEvent(const char* markerText, uint32_t markerColor) { (void)markerText; (void)markerColor; }
     virtual void EndGpuEvent() { }
 
+    // GPU pass timing. While enabled, the AutoGpuProf scopes between BeginGpuTimerFrame and
+    // EndGpuTimerFrame are timed with GPU timestamp queries, and read back a few frames later
+    // without waiting on the GPU. Scope names are kept by pointer until then. Returns false if
+    // the device doesn't support timestamp queries.
+    bool SetGpuTimingEnabled(bool enabled);
+    bool IsGpuTimingEnabled() const { return GpuTimingEnabled; }
+
+    // While enabled, RenderQueue::Render hands its draws to RecordParallel.
+    void SetParallelRecordingEnabled(bool enabled) { ParallelRecordingEnabled = enabled; }
+    bool IsParallelRecordingEnabled() const        { return ParallelRecordingEnabled; }
+
+    // Implemented by devices which can record draws on several threads at once. Calls
+    // recordRange over consecutive slices of [0, count) on worker threads, each slice's draws
+    // recorded separately, then submits the recordings in slice order. Only RenderModel may be
+    // called from recordRange, for models which HasRenderBuffers. Returns false without calling
+    // recordRange if the draws can't be recorded in parallel right now.
+    virtual bool RecordParallel(size_t count, const std::function<void(size_t, size_t)>& recordRange)
+    { OVR_UNUSED2(count, recordRange); return false; }
+
+    // Call at the start of each frame. Returns true if an earlier frame was read back, whose
+    // times GetGpuPassTimes then returns. If the GPU is so far behind that the query set for
+    // this frame is still in use, the frame isn't timed.
+    bool BeginGpuTimerFrame();
+    void EndGpuTimerFrame();
+
+    void BeginGpuTimer(const char* name);
+    void EndGpuTimer();
+
+    // The passes of the latest frame read back, in the order they began.
+    const std::vector<GpuPassTime>& GetGpuPassTimes() const { return GpuPassTimes; }
+
+    // Occlusion queries. While enabled, each box given to TestOcclusionBox between
+    // BeginOcclusionFrame and EndOcclusionFrame is drawn as a query, and counts the samples that
+    // pass the depth test; a frame's counts are read back once the GPU has finished the frame,
+    // without waiting on it. Returns false if the device doesn't support occlusion queries.
+    bool SetOcclusionQueriesEnabled(bool enabled);
+    bool IsOcclusionQueriesEnabled() const { return OcclusionQueriesEnabled; }
+
+    // Call once a frame before its tests. Returns true if an earlier frame was read back, whose
+    // counts GetOcclusionSamples then returns. frameSerial is set to the serial of the frame
+    // begun, or to 0 if the GPU is so far behind that the frame's query set is still in use.
+    bool BeginOcclusionFrame(uint64_t& frameSerial);
+    void EndOcclusionFrame();
+
+    // Draws the box, in the space of viewFromBox, with the current viewport, projection and
+    // depth mode, as a query. Colour writes should be disabled around it with SetColorWrite.
+    // Returns the query's index in the frame's counts, or -1 if there's no query for it.
+    int  TestOcclusionBox(const Bounds3f& box, const Matrix4f& viewFromBox);
+
+    // The sample counts of the latest frame read back, by query index, and that frame's serial.
+    const std::vector<uint64_t>& GetOcclusionSamples() const { return OcclusionSamples; }
+    uint64_t GetOcclusionSamplesSerial() const               { return OcclusionSamplesSerial; }
+
+    // Takes over the reference the Ptr holds, clearing it, and keeps it until the GPU has
+    // finished the frames submitted so far, so that reloads and evictions don't destroy
+    // resources it may still be using. The reference count isn't touched, so this can be
+    // called from any thread for a reference only that thread uses.
+    void ReleaseDeferred(Ptr<Buffer>& buffer);
+    void ReleaseDeferred(Ptr<Texture>& texture);
+
+    // Call once a frame after its last submission, from the render thread. Fences the frame,
+    // and destroys the resources released before frames the GPU has since finished. Never
+    // waits for the GPU.
+    void RetireFrame();
+
 
     virtual bool SaveCubemapTexture(Render::Texture* tex, Vector3f transl, const std::string& filePath, std::string* error) = 0;
 
 private:
 };
 
+//-----------------------------------------------------------------------------------
+// ***** OcclusionCuller
+
+// Conservative occlusion culling of a Scene's models with the device's occlusion queries, read
+// back a frame or more late so that nothing waits on the GPU. After each view of a frame is
+// drawn, TestView draws the box of every model the frustum kept, grown by BoxMargin, against
+// that view's depth; the scene as drawn is the occluder. Update then marks the models whose
+// boxes passed no samples in any view of the latest frame read back as Occluded, for Render
+// to skip. Hidden models are still tested, so one that's uncovered is drawn again a frame or
+// two later. Models with the eye within EyeMargin of their box are never hidden, as the near
+// plane could clip their box away.
+class OcclusionCuller
+{
+public:
+    OcclusionCuller() : BoxMargin(0.05f), EyeMargin(0.25f), FrameSerial(0) { }
+
+    // Forgets all the results, which hold references to the models tested; call it when the
+    // scene changes or the culling is turned off.
+    void Clear();
+
+    // Call each frame after Scene::UpdateCulling, which clears Occluded, and before the views
+    // are drawn. Begins the device's occlusion frame and returns the number of models marked.
+    int  Update(RenderDevice* ren, Scene& scene);
+
+    // Call after drawing the scene for a view, with its viewport and projection still set.
+    // Leaves depth writes on with depthFunc, and back face culling.
+    void TestView(RenderDevice* ren, Scene& scene, const Matrix4f& view, RenderDevice::CompareFunc depthFunc);
+
+    // Call once the frame's views are drawn.
+    void EndFrame(RenderDevice* ren);
+
+    float BoxMargin;    // In world units, so that a box isn't hidden by its own model's depth.
+    float EyeMargin;
+
+private:
+    struct Test
+    {
+        Ptr<Model>  pModel;
+        int         Query;  // -1 if the model wasn't tested, and counts as seen.
+    };
+
+    struct Frame
+    {
+        uint64_t            Serial;
+        std::vector<Test>   Tests;
+    };
+
+    std::list<Frame>         Frames;        // Tested and not read back yet, oldest first
+    std::vector<Ptr<Model> > Hidden;        // Found hidden by the latest frame read back
+    uint64_t                 FrameSerial;   // Of the frame being tested, or 0
+};
+
 //-----------------------------------------------------------------------------------
 // GPU profile marker helper to encapsulate a given scope block
 class AutoGpuProf
@@ -1047,7 +2010,10 @@ class AutoGpuProf
 public:
     AutoGpuProf(RenderDevice* device, const char* markerText, uint32_t color)
         : mDevice(device)
-    { device->BeginGpuEvent(markerText, color); }
+    {
+        device->BeginGpuEvent(markerText, color);
+        device->BeginGpuTimer(markerText);
+    }
 
     // Generates random color if one is not provided
     AutoGpuProf(RenderDevice* device, const char* markerText)
@@ -1058,9 +2024,14 @@ public:
                         ((rand() & 0xFF) <<  8) +
                          (rand() & 0xFF);
         device->BeginGpuEvent(markerText, color);
+        device->BeginGpuTimer(markerText);
     }
 
-    ~AutoGpuProf() { mDevice->EndGpuEvent(); }
+    ~AutoGpuProf()
+    {
+        mDevice->EndGpuTimer();
+        mDevice->EndGpuEvent();
+    }
          
 private:
     RenderDevice* mDevice;
@@ -1089,6 +2060,25 @@ Texture* LoadTextureTgaTopDown (RenderDevice* ren, File* f, int textureLoadFlags
 Texture* LoadTextureTgaBottomUp(RenderDevice* ren, File* f, int textureLoadFlags, unsigned char alpha = 255);
 Texture* LoadTextureDDSTopDown (RenderDevice* ren, File* f, int textureLoadFlags);
 
+// A texture decoded from a file but not yet created. Decoding only touches the file, so it
+// can run on a worker thread; CreateTextureFromImage must be called on the render thread.
+struct TextureImage
+{
+    uint64_t                    Format;
+    int                         Width, Height;
+    int                         MipCount;
+    int                         SampleMode;     // -1 leaves the texture's default sample mode.
+    bool                        Commit;         // Commit static swap texture sets once created.
+    const unsigned char*        Data;           // Into Storage, or into a mapped file that must outlive the image.
+    std::vector<unsigned char>  Storage;
+
+    TextureImage() : Format(0), Width(0), Height(0), MipCount(1), SampleMode(-1), Commit(false), Data(NULL) { }
+};
+
+bool     DecodeTextureTga(File* f, int textureLoadFlags, unsigned char alpha, bool bottomUp, TextureImage& image);
+bool     DecodeTextureDDS(File* f, int textureLoadFlags, TextureImage& image);
+Texture* CreateTextureFromImage(RenderDevice* ren, const TextureImage& image);
+
 
 }} // namespace OVR::Render
 
@@ -25,6 +25,11 @@ limitations under the License.
 #include "../Util/Logger.h"
 #include <assert.h>
 
+// Core from OpenGL 3.0, with the same value in GL_ARB_half_float_vertex.
+#ifndef GL_HALF_FLOAT
+#define GL_HALF_FLOAT 0x140B
+#endif
+
 namespace OVR { namespace Render { namespace GL {
 
 OVR::GLEContext gleContext;
@@ -44,12 +49,14 @@ void InitGLExtensions()
 static const char glsl2Prefix[] =
 "#version 110\n"
 "#extension GL_ARB_shader_texture_lod : enable\n"
+"#extension GL_EXT_texture_array : enable\n"
 "#define _FRAGCOLOR_DECLARATION\n"
 "#define _VS_IN attribute\n"
 "#define _VS_OUT varying\n"
 "#define _FS_IN varying\n"
 "#define _TEXTURELOD texture2DLod\n"
 "#define _TEXTURE texture2D\n"
+"#define _TEXTUREARRAY texture2DArray\n"
 "#define _FRAGCOLOR gl_FragColor\n";
 
 static const char glsl3Prefix[] =
@@ -60,6 +67,7 @@ static const char glsl3Prefix[] =
 "#define _FS_IN in\n"
 "#define _TEXTURELOD textureLod\n"
 "#define _TEXTURE texture\n"
+"#define _TEXTUREARRAY texture\n"
 "#define _FRAGCOLOR FragColor\n";
 
 
@@ -90,6 +98,74 @@ static const char* MVPVertexShaderSrc =
     "   oColor = Color * GlobalTint;\n"
     "}\n";
 
+// MVPVertexShaderSrc, with Position and Normal first taken from instance to model space. It has
+// the same uniforms, so it can stand in for MVP with any fill's fragment shader.
+static const char* MVPInstancedVertexShaderSrc =
+    "uniform mat4 Proj;\n"
+    "uniform mat4 View;\n"
+    "uniform vec4 GlobalTint;\n"
+    
+    "_VS_IN vec4 Position;\n"
+    "_VS_IN vec4 Color;\n"
+    "_VS_IN vec2 TexCoord;\n"
+    "_VS_IN vec2 TexCoord1;\n"
+    "_VS_IN vec3 Normal;\n"
+    "_VS_IN vec4 InstanceRow0;\n"
+    "_VS_IN vec4 InstanceRow1;\n"
+    "_VS_IN vec4 InstanceRow2;\n"
+    
+    "_VS_OUT vec4 oColor;\n"
+    "_VS_OUT vec2 oTexCoord;\n"
+    "_VS_OUT vec2 oTexCoord1;\n"
+    "_VS_OUT vec3 oNormal;\n"
+    "_VS_OUT vec3 oVPos;\n"
+    
+    "void main()\n"
+    "{\n"
+    "   vec4 mPos = vec4(dot(InstanceRow0, Position), dot(InstanceRow1, Position), dot(InstanceRow2, Position), Position.w);\n"
+    "   vec3 mNormal = vec3(dot(InstanceRow0.xyz, Normal), dot(InstanceRow1.xyz, Normal), dot(InstanceRow2.xyz, Normal));\n"
+    "   gl_Position = Proj * (View * mPos);\n"
+    "   oNormal = vec3(View * vec4(mNormal,0));\n"
+    "   oVPos = vec3(View * mPos);\n"
+    "   oTexCoord = TexCoord;\n"
+    "   oTexCoord1 = TexCoord1;\n"
+    "   oColor = Color * GlobalTint;\n"
+    "}\n";
+
+// MVPVertexShaderSrc drawn as two instances, one for each half of a stereo viewport. View is the
+// left eye's, which the normal and view position keep, so lighting is from the left eye. Needs
+// GLSL 1.50 for gl_InstanceID and gl_ClipDistance.
+static const char* MVPStereoVertexShaderSrc =
+    "uniform mat4 Proj;\n"
+    "uniform mat4 View;\n"
+    "uniform vec4 GlobalTint;\n"
+    "uniform mat4 EyeProj[2];\n"
+    "uniform vec4 EyeClipPlane[2];\n"
+    
+    "_VS_IN vec4 Position;\n"
+    "_VS_IN vec4 Color;\n"
+    "_VS_IN vec2 TexCoord;\n"
+    "_VS_IN vec2 TexCoord1;\n"
+    "_VS_IN vec3 Normal;\n"
+    
+    "_VS_OUT vec4 oColor;\n"
+    "_VS_OUT vec2 oTexCoord;\n"
+    "_VS_OUT vec2 oTexCoord1;\n"
+    "_VS_OUT vec3 oNormal;\n"
+    "_VS_OUT vec3 oVPos;\n"
+    
+    "void main()\n"
+    "{\n"
+    "   int eye = gl_InstanceID & 1;\n"
+    "   gl_Position = EyeProj[eye] * (View * Position);\n"
+    "   gl_ClipDistance[0] = dot(EyeClipPlane[eye], gl_Position);\n"
+    "   oNormal = vec3(View * vec4(Normal,0));\n"
+    "   oVPos = vec3(View * Position);\n"
+    "   oTexCoord = TexCoord;\n"
+    "   oTexCoord1 = TexCoord1;\n"
+    "   oColor = Color * GlobalTint;\n"
+    "}\n";
+
 static const char* MVVertexShaderSrc =
     "uniform mat4 View;\n"
     
@@ -300,6 +376,63 @@ static const char* MultiTextureHeavyAluEarlyZFragShaderSrc =
     "}\n";
 
 
+// The array shaders draw models whose textures were packed into array textures. The vertex
+// color alpha holds the diffuse slice in its high four bits and the lightmap slice in its low
+// four, so the tint must leave alpha at one.
+#define TEXTURE_ARRAY_SLICES                                        \
+    "vec2 GetSlices(float alpha)\n"                                 \
+    "{\n"                                                           \
+    "   float packed = floor(alpha * 255.0 + 0.5);\n"               \
+    "   float diffuse = floor(packed / 16.0);\n"                    \
+    "   return vec2(diffuse, packed - diffuse * 16.0);\n"           \
+    "}\n"
+
+static const char* TextureArrayFragShaderSrc =
+    "uniform sampler2DArray Texture0;\n"
+
+    "_FS_IN vec4 oColor;\n"
+    "_FS_IN vec2 oTexCoord;\n"
+
+    "_FRAGCOLOR_DECLARATION\n"
+
+    TEXTURE_ARRAY_SLICES
+
+    "void main()\n"
+    "{\n"
+    "   vec2 slices = GetSlices(oColor.a);\n"
+    "   _FRAGCOLOR = _TEXTUREARRAY(Texture0, vec3(oTexCoord, slices.x));\n"
+    "   _FRAGCOLOR.rgb *= oColor.rgb;\n"
+    "   if (_FRAGCOLOR.a < 0.4)\n"
+    "       discard;\n"
+    "}\n";
+
+static const char* MultiTextureArrayFragShaderSrc =
+    "uniform sampler2DArray Texture0;\n"
+    "uniform sampler2DArray Texture1;\n"
+
+    "_FS_IN vec4 oColor;\n"
+    "_FS_IN vec2 oTexCoord;\n"
+    "_FS_IN vec2 oTexCoord1;\n"
+
+    "_FRAGCOLOR_DECLARATION\n"
+
+    TEXTURE_ARRAY_SLICES
+
+    "void main()\n"
+    "{\n"
+    "    vec2 slices = GetSlices(oColor.a);\n"
+    "    vec4 color1 = _TEXTUREARRAY(Texture0, vec3(oTexCoord, slices.x));\n"
+    "    vec4 color2 = _TEXTUREARRAY(Texture1, vec3(oTexCoord1, slices.y));\n"
+    "    color2.rgb = sqrt(color2.rgb);\n"
+    "    color2.rgb = color2.rgb * mix(0.2, 1.2, clamp(length(color2.rgb),0.0,1.0));\n"
+    "    _FRAGCOLOR = color1 * color2;\n"
+    "   _FRAGCOLOR.rgb *= oColor.rgb;\n"
+    "   if (_FRAGCOLOR.a <= 0.6)\n"
+    "		discard;\n"
+    "   _FRAGCOLOR.rgb /= _FRAGCOLOR.a;\n"
+    "}\n";
+
+
 static const char* VShaderSrcs[] =
 {
     #define MK_VERTEX_SHADER_NAME(name) name##VertexShaderSrc,
@@ -370,8 +503,20 @@ RenderDevice::RenderDevice(ovrSession session, const RendererParams&)
     MsaaFbo(0),
     GLVersionInfo(),
     DebugCallbackControl(),
-    Lighting(NULL)
+    Lighting(NULL),
+    StreamBuffer(0),
+    StreamData(NULL),
+    StreamFrameSize(0),
+    StreamFrameUsed(0),
+    StreamFrame(0),
+    StreamFences(),
+    FrameFenceSyncs(),
+    CurrentProgram(InvalidBinding),
+    BoundTextures(),
+    BoundTextureTargets(),
+    ActiveTextureSlot(-1)
 {
+
     InitGLExtensions();
     DebugCallbackControl.Initialize();
 
@@ -412,7 +557,7 @@ RenderDevice::RenderDevice(ovrSession session, const RendererParams&)
         delete[] pShaderSource;
     }
 
-    Ptr<ShaderSet> gouraudShaders = *new ShaderSet();
+    Ptr<ShaderSet> gouraudShaders = *new ShaderSet(this);
     gouraudShaders->SetShader(VertexShaders[VShader_MVP]);
     gouraudShaders->SetShader(FragShaders[FShader_Gouraud]);
     DefaultFill = *new ShaderFill(gouraudShaders);
@@ -433,6 +578,8 @@ RenderDevice::RenderDevice(ovrSession session, const RendererParams&)
         glGenVertexArrays(1, &Vao);
     }
 
+    CreateStreamBuffer();
+
     Blitter = *new GLUtil::Blitter();
     Blitter->Initialize();
 
@@ -459,6 +606,8 @@ void RenderDevice::Shutdown()
     {
         glDeleteVertexArrays(1, &Vao);
     }
+
+    ReleaseStreamBuffer();
     
     for (int i = 0; i < VShader_Count; ++i)
     {
@@ -473,10 +622,225 @@ void RenderDevice::Shutdown()
     DefaultFill.Clear();
     DepthBuffers.clear();
 
+    ReleaseGpuTimerQueries();
+    ReleaseOcclusionQueries();
+
+    for (GLsync& fence : FrameFenceSyncs)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = 0;
+    }
+
     DebugCallbackControl.Shutdown();
 }
 
 
+bool RenderDevice::CreateGpuTimerQueries(int frameCount, int timestampsPerFrame)
+{
+    if (!GLE_ARB_timer_query || (frameCount > GpuTimerFrameCount))
+        return false;
+
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        GpuTimerQueries[frame].resize(timestampsPerFrame);
+        glGenQueries(timestampsPerFrame, GpuTimerQueries[frame].data());
+    }
+    return true;
+}
+
+void RenderDevice::ReleaseGpuTimerQueries()
+{
+    for (std::vector<GLuint>& queries : GpuTimerQueries)
+    {
+        if (!queries.empty())
+            glDeleteQueries((GLsizei)queries.size(), queries.data());
+        queries.clear();
+    }
+}
+
+void RenderDevice::WriteGpuTimestamp(int frame, int index)
+{
+    glQueryCounter(GpuTimerQueries[frame][index], GL_TIMESTAMP);
+}
+
+bool RenderDevice::CreateOcclusionQueries(int frameCount, int queriesPerFrame)
+{
+    // Occlusion queries are core since GL 1.5.
+    if (frameCount > OcclusionFrameCount)
+        return false;
+
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        OcclusionQueries[frame].resize(queriesPerFrame);
+        glGenQueries(queriesPerFrame, OcclusionQueries[frame].data());
+    }
+    return true;
+}
+
+void RenderDevice::ReleaseOcclusionQueries()
+{
+    for (std::vector<GLuint>& queries : OcclusionQueries)
+    {
+        if (!queries.empty())
+            glDeleteQueries((GLsizei)queries.size(), queries.data());
+        queries.clear();
+    }
+}
+
+void RenderDevice::BeginOcclusionQuery(int frame, int index)
+{
+    glBeginQuery(GL_SAMPLES_PASSED, OcclusionQueries[frame][index]);
+}
+
+void RenderDevice::EndOcclusionQuery(int frame, int index)
+{
+    OVR_UNUSED2(frame, index);
+    glEndQuery(GL_SAMPLES_PASSED);
+}
+
+bool RenderDevice::ReadOcclusionQueries(int frame, int count, uint64_t* samples)
+{
+    // As with the timestamps, the last query being available means they all are.
+    const std::vector<GLuint>& queries = OcclusionQueries[frame];
+    GLint available = 0;
+    glGetQueryObjectiv(queries[count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return false;
+
+    for (int i = 0; i < count; ++i)
+    {
+        GLuint passed = 0;
+        glGetQueryObjectuiv(queries[i], GL_QUERY_RESULT, &passed);
+        samples[i] = passed;
+    }
+    return true;
+}
+
+void RenderDevice::CreateStreamBuffer()
+{
+    if (!GLE_ARB_buffer_storage || !GLE_ARB_sync || !GLE_ARB_map_buffer_range)
+        return;
+
+    // Enough for a full screen of debug text and menu quads per frame.
+    StreamFrameSize = 2 * 1024 * 1024;
+    const size_t     totalSize = StreamFrameSize * StreamFrameCount;
+    const GLbitfield flags     = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &StreamBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, StreamBuffer);
+    glBufferStorage(GL_ARRAY_BUFFER, totalSize, NULL, flags);
+    StreamData = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, totalSize, flags);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (!StreamData)
+    {
+        glDeleteBuffers(1, &StreamBuffer);
+        StreamBuffer = 0;
+    }
+}
+
+void RenderDevice::ReleaseStreamBuffer()
+{
+    for (GLsync& fence : StreamFences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = 0;
+    }
+
+    if (StreamBuffer)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, StreamBuffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDeleteBuffers(1, &StreamBuffer);
+    }
+    StreamBuffer = 0;
+    StreamData = NULL;
+}
+
+void* RenderDevice::AllocStream(size_t size, size_t& offset)
+{
+    // Keep every allocation aligned for any vertex format.
+    const size_t allocSize = (size + 15) & ~size_t(15);
+    if (!StreamData || (StreamFrameUsed + allocSize > StreamFrameSize))
+        return NULL;
+
+    offset = StreamFrame * StreamFrameSize + StreamFrameUsed;
+    StreamFrameUsed += allocSize;
+    return StreamData + offset;
+}
+
+void RenderDevice::EndStreamFrame()
+{
+    if (!StreamData)
+        return;
+
+    StreamFences[StreamFrame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    StreamFrame = (StreamFrame + 1) % StreamFrameCount;
+    StreamFrameUsed = 0;
+
+    // The GPU has normally finished with a section long before we come back around to it.
+    GLsync& fence = StreamFences[StreamFrame];
+    if (fence)
+    {
+        GLenum result;
+        do
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1ms
+        } while (result == GL_TIMEOUT_EXPIRED);
+
+        glDeleteSync(fence);
+        fence = 0;
+    }
+}
+
+RenderDevice::GpuTimerReadResult RenderDevice::ReadGpuTimestamps(int frame, int count, uint64_t* timestamps, uint64_t& frequency)
+{
+    // Queries complete in order, so the last one being available means they all are.
+    const std::vector<GLuint>& queries = GpuTimerQueries[frame];
+    GLint available = 0;
+    glGetQueryObjectiv(queries[count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return GpuTimerRead_NotReady;
+
+    for (int i = 0; i < count; ++i)
+    {
+        GLuint64 timestamp = 0;
+        glGetQueryObjectui64v(queries[i], GL_QUERY_RESULT, &timestamp);
+        timestamps[i] = timestamp;
+    }
+
+    frequency = 1000000000; // GL_TIMESTAMP is in nanoseconds.
+    return GpuTimerRead_Ready;
+}
+
+bool RenderDevice::SignalFrameFence(int slot)
+{
+    if (!GLE_ARB_sync)
+        return false;
+
+    GLsync& fence = FrameFenceSyncs[slot];
+    if (fence)
+        glDeleteSync(fence);
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    return (fence != 0);
+}
+
+bool RenderDevice::IsFrameFenceDone(int slot)
+{
+    // A zero timeout only polls; the swap has flushed the fence by the time it's asked about.
+    GLsync& fence = FrameFenceSyncs[slot];
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        return false;
+
+    glDeleteSync(fence);
+    fence = 0;
+    return true;
+}
+
+
 void RenderDevice::FillTexturedRect(float left, float top, float right, float bottom, float ul, float vt, float ur, float vb, Color c, Ptr<OVR::Render::Texture> tex, const Matrix4f* view, bool premultAlpha /*= false*/)
 {
 	Render::RenderDevice::FillTexturedRect(left, top, right, bottom, ul, vt, ur, vb, c, tex, view, premultAlpha);
@@ -519,6 +883,8 @@ void RenderDevice::SetDepthMode(bool enable, bool write, CompareFunc func)
         case Compare_Always:  glDepthFunc(GL_ALWAYS); break;
         case Compare_Less:    glDepthFunc(GL_LESS); break;
         case Compare_Greater: glDepthFunc(GL_GREATER); break;
+        case Compare_LessEqual:    glDepthFunc(GL_LEQUAL); break;
+        case Compare_GreaterEqual: glDepthFunc(GL_GEQUAL); break;
         default: assert(0);
         }
     }
@@ -545,12 +911,30 @@ void RenderDevice::FillRect(float left, float top, float right, float bottom, Co
     glDisable(GL_BLEND);
 }
 
-void RenderDevice::RenderText(const struct Font* font, const char* str, float x, float y, float size, Color c, const Matrix4f* view)
-{    
+void RenderDevice::FlushText()
+{
+    if (!HasPendingText())
+    {
+        return;
+    }
+
+    // Text can be flushed from inside another 2D draw, so put back whatever blending it set.
+    const GLboolean blend = glIsEnabled(GL_BLEND);
+    GLint srcRGB, dstRGB, srcAlpha, dstAlpha;
+    glGetIntegerv(GL_BLEND_SRC_RGB, &srcRGB);
+    glGetIntegerv(GL_BLEND_DST_RGB, &dstRGB);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &srcAlpha);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &dstAlpha);
+
     glEnable(GL_BLEND);
     glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-    OVR::Render::RenderDevice::RenderText(font, str, x, y, size, c, view);
-    glDisable(GL_BLEND);
+    OVR::Render::RenderDevice::FlushText();
+
+    glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+    if (!blend)
+    {
+        glDisable(GL_BLEND);
+    }
 }
 
 void RenderDevice::FillGradientRect(float left, float top, float right, float bottom, Color col_top, Color col_btm, const Matrix4f* view)
@@ -629,6 +1013,12 @@ void RenderDevice::ResolveMsaa(OVR::Render::Texture* msaaTex, OVR::Render::Textu
     OVR_ASSERT_AND_UNUSED(!err, err);
 }
 
+void RenderDevice::SetColorWrite(bool enabled)
+{
+    const GLboolean write = enabled ? GL_TRUE : GL_FALSE;
+    glColorMask(write, write, write, write);
+}
+
 void RenderDevice::SetCullMode(CullMode cullMode)
 {
     switch (cullMode)
@@ -701,8 +1091,49 @@ void RenderDevice::SetWorldUniforms(const Matrix4f& proj, const Vector4f& global
 
 void RenderDevice::SetTexture(Render::ShaderStage, int slot, const Texture* t)
 {
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture((t->GetSamples() > 1) ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D, ((Texture*)t)->GetTexId());
+    const GLenum target = (t->GetFormat() & Texture_Array) ? GL_TEXTURE_2D_ARRAY :
+                          (t->GetSamples() > 1) ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D;
+    BindTexture(slot, target, ((Texture*)t)->GetTexId());
+}
+
+void RenderDevice::UseProgram(GLuint prog)
+{
+    if (prog != CurrentProgram)
+    {
+        glUseProgram(prog);
+        CurrentProgram = prog;
+    }
+}
+
+void RenderDevice::BindTexture(int slot, GLenum target, GLuint tex)
+{
+    OVR_ASSERT(slot >= 0);
+    if ((slot < MaxTextureSlots) && (BoundTextures[slot] == tex) && (BoundTextureTargets[slot] == target))
+        return;
+
+    if (slot != ActiveTextureSlot)
+    {
+        glActiveTexture(GL_TEXTURE0 + slot);
+        ActiveTextureSlot = slot;
+    }
+    glBindTexture(target, tex);
+
+    if (slot < MaxTextureSlots)
+    {
+        BoundTextures[slot] = tex;
+        BoundTextureTargets[slot] = target;
+    }
+}
+
+void RenderDevice::InvalidateBindings()
+{
+    CurrentProgram = InvalidBinding;
+    for (int i = 0; i < MaxTextureSlots; i++)
+    {
+        BoundTextures[i] = InvalidBinding;
+        BoundTextureTargets[i] = GL_NONE;
+    }
+    ActiveTextureSlot = -1;
 }
 
 bool RenderDevice::SaveCubemapTexture(Render::Texture* /*tex*/, Vector3f /*transl*/, const std::string& /*filePath*/, std::string* /*error*/)
@@ -741,12 +1172,14 @@ void RenderDevice::Blt(Render::Texture* texture)
 {
     Texture* tex = (Texture*)texture;
     Blitter->Blt(tex->GetTexId());
+    InvalidateBindings();
 }
 
 void RenderDevice::Blt(Render::Texture* texture, uint32_t topLeftX, uint32_t topLeftY, uint32_t width, uint32_t height)
 {
     Texture* tex = (Texture*)texture;
     Blitter->Blt(tex->GetTexId(), topLeftX, topLeftY, width, height);
+    InvalidateBindings();
 }
 
 void RenderDevice::BltToTex(Render::Texture* /* src */, Render::Texture* /* dest */)
@@ -757,6 +1190,7 @@ void RenderDevice::BltToTex(Render::Texture* /* src */, Render::Texture* /* dest
 void RenderDevice::BltFlipCubemap(Render::Texture* src, Render::Texture* temp)
 {
     Blitter->BltCubemap(((Texture*)src)->GetTexId(), ((Texture*)temp)->GetTexId(), src->GetWidth());
+    InvalidateBindings();
 }
 
 void RenderDevice::Render(const Matrix4f& matrix, Model* model)
@@ -766,28 +1200,227 @@ void RenderDevice::Render(const Matrix4f& matrix, Model* model)
         glBindVertexArray(Vao);
     }
 
+    const bool split     = (model->Layout == VertexLayout_Split);
+    const bool quantized = (model->Layout == VertexLayout_Quantized);
+
     // Store data in buffers if not already
     if (!model->VertexBuffer)
     {
-        Ptr<Render::Buffer> vb = *CreateBuffer();
-        vb->Data(Buffer_Vertex | Buffer_ReadOnly, &model->Vertices[0], model->Vertices.size() * sizeof(Vertex));
-        model->VertexBuffer = vb;
+        if (quantized)
+        {
+            std::vector<QuantizedVertex> vertices;
+            model->QuantizeVertices(vertices);
+
+            Ptr<Render::Buffer> vb = *CreateBuffer();
+            vb->Data(Buffer_Vertex | Buffer_ReadOnly, &vertices[0], vertices.size() * sizeof(QuantizedVertex));
+            model->VertexBuffer = vb;
+        }
+        else if (split)
+        {
+            std::vector<Vector3f> positions;
+            std::vector<VertexAttributes> attributes;
+            model->GetSplitVertexStreams(positions, attributes);
+
+            Ptr<Render::Buffer> pb = *CreateBuffer();
+            pb->Data(Buffer_Vertex | Buffer_ReadOnly, &positions[0], positions.size() * sizeof(Vector3f));
+            model->VertexBuffer = pb;
+
+            Ptr<Render::Buffer> ab = *CreateBuffer();
+            ab->Data(Buffer_Vertex | Buffer_ReadOnly, &attributes[0], attributes.size() * sizeof(VertexAttributes));
+            model->AttributeBuffer = ab;
+        }
+        else
+        {
+            Ptr<Render::Buffer> vb = *CreateBuffer();
+            vb->Data(Buffer_Vertex | Buffer_ReadOnly, &model->Vertices[0], model->Vertices.size() * sizeof(Vertex));
+            model->VertexBuffer = vb;
+        }
     }
 
     if (!model->IndexBuffer)
     {
         Ptr<Render::Buffer> ib = *CreateBuffer();
-        ib->Data(Buffer_Index | Buffer_ReadOnly, &model->Indices[0], model->Indices.size() * 2);
+        model->SetIndexBufferData(ib);
         model->IndexBuffer = ib;
     }
 
-    Render(model->Fill ? (const Fill*)model->Fill : (const Fill*)DefaultFill,
-           model->VertexBuffer, model->IndexBuffer,
-           matrix, 0, (int)model->Indices.size(), model->GetPrimType());
+    if (split)
+    {
+        RenderSplit(model->Fill ? (const Fill*)model->Fill : (const Fill*)DefaultFill,
+                    model->VertexBuffer, model->AttributeBuffer, model->IndexBuffer,
+                    matrix, 0, (int)model->Indices.size(), model->GetPrimType());
+    }
+    else if (quantized)
+    {
+        RenderQuantized(model->Fill ? (const Fill*)model->Fill : (const Fill*)DefaultFill,
+                        model->VertexBuffer, model->IndexBuffer,
+                        matrix * model->GetDequantizeMatrix(), 0, (int)model->Indices.size(), model->GetPrimType());
+    }
+    else
+    {
+        Render(model->Fill ? (const Fill*)model->Fill : (const Fill*)DefaultFill,
+               model->VertexBuffer, model->IndexBuffer,
+               matrix, 0, (int)model->Indices.size(), model->GetPrimType());
+    }
 }
 
 void RenderDevice::Render(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
                       const Matrix4f& matrix, int offset, int count, PrimitiveType rprim)
+{
+    GLenum prim = SetDrawState(fill, matrix, rprim);
+    if (prim == GL_NONE)
+        return;
+
+    Buffer* vb = (Buffer*)vertices;
+    glBindBuffer(GL_ARRAY_BUFFER, vb->GetBuffer());
+    for (int i = 0; i < 5; i++)
+        glEnableVertexAttribArray(i);
+
+    char* vertexOffset = reinterpret_cast<char*>(vb->GetBaseOffset() + offset);
+    glVertexAttribPointer(0, 3, GL_FLOAT,         false, sizeof(Vertex), vertexOffset + OVR_OFFSETOF(Vertex, Pos));
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  sizeof(Vertex), vertexOffset + OVR_OFFSETOF(Vertex, C));
+    glVertexAttribPointer(2, 2, GL_FLOAT,         false, sizeof(Vertex), vertexOffset + OVR_OFFSETOF(Vertex, U));
+    glVertexAttribPointer(3, 2, GL_FLOAT,         false, sizeof(Vertex), vertexOffset + OVR_OFFSETOF(Vertex, U2));
+    glVertexAttribPointer(4, 3, GL_FLOAT,         false, sizeof(Vertex), vertexOffset + OVR_OFFSETOF(Vertex, Norm));
+
+    DrawBound(prim, indices, count);
+}
+
+void RenderDevice::RenderSplit(const Fill* fill, Render::Buffer* positions, Render::Buffer* attributes,
+                               Render::Buffer* indices, const Matrix4f& matrix, int firstVertex, int count,
+                               PrimitiveType rprim)
+{
+    GLenum prim = SetDrawState(fill, matrix, rprim);
+    if (prim == GL_NONE)
+        return;
+
+    char* positionOffset  = reinterpret_cast<char*>(((Buffer*)positions)->GetBaseOffset() + firstVertex * sizeof(Vector3f));
+    glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, ((Buffer*)positions)->GetBuffer());
+    glVertexAttribPointer(0, 3, GL_FLOAT,         false, sizeof(Vector3f), positionOffset);
+
+    // Without attributes only the positions are fetched, and disabled arrays read the current
+    // attribute values, which are zero.
+    if (!attributes)
+    {
+        for (int i = 1; i < 5; i++)
+        {
+            glDisableVertexAttribArray(i);
+            glVertexAttrib4f(i, 0.0f, 0.0f, 0.0f, 0.0f);
+        }
+        DrawBound(prim, indices, count);
+        return;
+    }
+
+    for (int i = 1; i < 5; i++)
+        glEnableVertexAttribArray(i);
+
+    char* attributeOffset = reinterpret_cast<char*>(((Buffer*)attributes)->GetBaseOffset() + firstVertex * sizeof(VertexAttributes));
+    glBindBuffer(GL_ARRAY_BUFFER, ((Buffer*)attributes)->GetBuffer());
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  sizeof(VertexAttributes), attributeOffset + OVR_OFFSETOF(VertexAttributes, C));
+    glVertexAttribPointer(2, 2, GL_FLOAT,         false, sizeof(VertexAttributes), attributeOffset + OVR_OFFSETOF(VertexAttributes, U));
+    glVertexAttribPointer(3, 2, GL_FLOAT,         false, sizeof(VertexAttributes), attributeOffset + OVR_OFFSETOF(VertexAttributes, U2));
+    glVertexAttribPointer(4, 3, GL_FLOAT,         false, sizeof(VertexAttributes), attributeOffset + OVR_OFFSETOF(VertexAttributes, Norm));
+
+    DrawBound(prim, indices, count);
+}
+
+void RenderDevice::RenderQuantized(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
+                                   const Matrix4f& matrix, int firstVertex, int count, PrimitiveType rprim)
+{
+    GLenum prim = SetDrawState(fill, matrix, rprim);
+    if (prim == GL_NONE)
+        return;
+
+    Buffer* vb = (Buffer*)vertices;
+    glBindBuffer(GL_ARRAY_BUFFER, vb->GetBuffer());
+    for (int i = 0; i < 5; i++)
+        glEnableVertexAttribArray(i);
+
+    char* vertexOffset = reinterpret_cast<char*>(vb->GetBaseOffset() + firstVertex * sizeof(QuantizedVertex));
+    glVertexAttribPointer(0, 4, GL_SHORT,         true,  sizeof(QuantizedVertex), vertexOffset + OVR_OFFSETOF(QuantizedVertex, Pos));
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  sizeof(QuantizedVertex), vertexOffset + OVR_OFFSETOF(QuantizedVertex, C));
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT,    false, sizeof(QuantizedVertex), vertexOffset + OVR_OFFSETOF(QuantizedVertex, UV));
+    glVertexAttribPointer(3, 2, GL_HALF_FLOAT,    false, sizeof(QuantizedVertex), vertexOffset + OVR_OFFSETOF(QuantizedVertex, UV) + 4);
+    glVertexAttribPointer(4, 3, GL_BYTE,          true,  sizeof(QuantizedVertex), vertexOffset + OVR_OFFSETOF(QuantizedVertex, Norm));
+
+    DrawBound(prim, indices, count);
+}
+
+bool RenderDevice::SupportsVertexLayout(VertexLayout layout) const
+{
+    // Half float vertex attributes are core from OpenGL 3.0.
+    return (layout != VertexLayout_Quantized) || (GLVersionInfo.WholeVersion >= 300) ||
+           GLVersionInfo.HasGLExtension("GL_ARB_half_float_vertex");
+}
+
+bool RenderDevice::RenderInstances(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
+                                   Render::Buffer* instances, const Matrix4f& matrix, int count, int instanceCount,
+                                   PrimitiveType rprim)
+{
+    // glVertexAttribDivisor is core from OpenGL 3.3, and MVPInstanced can only replace MVP.
+    ShaderSet* shaders = (ShaderSet*) ((ShaderFill*)fill)->GetShaders();
+    if ((GLVersionInfo.WholeVersion < 303) ||
+        (shaders->GetShader(Shader_Vertex) != VertexShaders[VShader_MVP].GetPtr()))
+    {
+        return false;
+    }
+
+    if (!shaders->InstancedShaders)
+    {
+        Ptr<ShaderSet> instancedShaders = *new ShaderSet(this);
+        instancedShaders->SetShader(VertexShaders[VShader_MVPInstanced]);
+        instancedShaders->SetShader(shaders->GetShader(Shader_Fragment));
+        shaders->InstancedShaders = instancedShaders;
+    }
+
+    GLenum prim = SetDrawState(fill, matrix, rprim, shaders->InstancedShaders);
+    if (prim == GL_NONE)
+        return true;
+
+    glBindBuffer(GL_ARRAY_BUFFER, ((Buffer*)vertices)->GLBuffer);
+    for (int i = 0; i < 8; i++)
+        glEnableVertexAttribArray(i);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT,         false, sizeof(Vertex), reinterpret_cast<char*>(OVR_OFFSETOF(Vertex, Pos)));
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  sizeof(Vertex), reinterpret_cast<char*>(OVR_OFFSETOF(Vertex, C)));
+    glVertexAttribPointer(2, 2, GL_FLOAT,         false, sizeof(Vertex), reinterpret_cast<char*>(OVR_OFFSETOF(Vertex, U)));
+    glVertexAttribPointer(3, 2, GL_FLOAT,         false, sizeof(Vertex), reinterpret_cast<char*>(OVR_OFFSETOF(Vertex, U2)));
+    glVertexAttribPointer(4, 3, GL_FLOAT,         false, sizeof(Vertex), reinterpret_cast<char*>(OVR_OFFSETOF(Vertex, Norm)));
+
+    glBindBuffer(GL_ARRAY_BUFFER, ((Buffer*)instances)->GLBuffer);
+    for (int i = 0; i < 3; i++)
+    {
+        glVertexAttribPointer(5 + i, 4, GL_FLOAT, false, 3 * sizeof(Vector4f), reinterpret_cast<char*>(i * sizeof(Vector4f)));
+        glVertexAttribDivisor(5 + i, 1);
+    }
+
+    DrawBound(prim, indices, count, instanceCount);
+    return true;
+}
+
+bool RenderDevice::CanRenderStereo(const Fill* fill)
+{
+    // MVPStereo needs GLSL 1.50, and can only replace MVP.
+    ShaderSet* shaders = (ShaderSet*) ((ShaderFill*)fill)->GetShaders();
+    return (GLVersionInfo.WholeVersion >= 302) &&
+           (shaders->GetShader(Shader_Vertex) == VertexShaders[VShader_MVP].GetPtr());
+}
+
+ShaderSet* RenderDevice::getStereoShaders(ShaderSet* shaders)
+{
+    if (!shaders->StereoShaders)
+    {
+        Ptr<ShaderSet> stereoShaders = *new ShaderSet(this);
+        stereoShaders->SetShader(VertexShaders[VShader_MVPStereo]);
+        stereoShaders->SetShader(shaders->GetShader(Shader_Fragment));
+        shaders->StereoShaders = stereoShaders;
+    }
+    return shaders->StereoShaders;
+}
+
+GLenum RenderDevice::SetDrawState(const Fill* fill, const Matrix4f& matrix, PrimitiveType rprim,
+                                  ShaderSet* instancedShaders)
 {
     ShaderSet* shaders = (ShaderSet*) ((ShaderFill*)fill)->GetShaders();
 
@@ -805,10 +1438,34 @@ void RenderDevice::Render(const Fill* fill, Render::Buffer* vertices, Render::Bu
         break;
     default:
         assert(0);
-        return;
+        return GL_NONE;
     }
 
-    fill->Set();
+    if (needsFillSet(fill, rprim))
+    {
+        fill->Set();
+    }
+    if (instancedShaders)
+    {
+        // The fill's textures stay bound; the next draw with it has to restore its program.
+        instancedShaders->Set(rprim);
+        shaders = instancedShaders;
+        BatchedFill = nullptr;
+    }
+    else if (StereoPassActive)
+    {
+        // During a stereo pass, RenderModel only lets through fills which CanRenderStereo. Every
+        // draw in the pass uses a stereo program, so it can stay set with a batched fill.
+        OVR_ASSERT(CanRenderStereo(fill));
+        shaders = getStereoShaders(shaders);
+        shaders->Set(rprim);
+
+        Matrix4f eyeProj[2] = { StereoClipFromLeft[0].Transposed(), StereoClipFromLeft[1].Transposed() };
+        if (shaders->EyeProjLoc >= 0)
+            glUniformMatrix4fv(shaders->EyeProjLoc, 2, 0, &eyeProj[0].M[0][0]);
+        if (shaders->EyeClipPlaneLoc >= 0)
+            glUniform4fv(shaders->EyeClipPlaneLoc, 2, &StereoClipPlanes[0].x);
+    }
     if (shaders->ProjLoc >= 0)
         glUniformMatrix4fv(shaders->ProjLoc, 1, 0, &Proj.M[0][0]);
     if (shaders->ViewLoc >= 0)
@@ -822,20 +1479,47 @@ void RenderDevice::Render(const Fill* fill, Render::Buffer* vertices, Render::Bu
         Lighting->Set(shaders);
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, ((Buffer*)vertices)->GLBuffer);
-    for (int i = 0; i < 5; i++)
-        glEnableVertexAttribArray(i);
+    return prim;
+}
 
-    glVertexAttribPointer(0, 3, GL_FLOAT,         false, sizeof(Vertex), reinterpret_cast<char*>(offset) + OVR_OFFSETOF(Vertex, Pos));
-    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  sizeof(Vertex), reinterpret_cast<char*>(offset) + OVR_OFFSETOF(Vertex, C));
-    glVertexAttribPointer(2, 2, GL_FLOAT,         false, sizeof(Vertex), reinterpret_cast<char*>(offset) + OVR_OFFSETOF(Vertex, U));
-    glVertexAttribPointer(3, 2, GL_FLOAT,         false, sizeof(Vertex), reinterpret_cast<char*>(offset) + OVR_OFFSETOF(Vertex, U2));
-    glVertexAttribPointer(4, 3, GL_FLOAT,         false, sizeof(Vertex), reinterpret_cast<char*>(offset) + OVR_OFFSETOF(Vertex, Norm));
+void RenderDevice::DrawBound(GLenum prim, Render::Buffer* indices, int count, int instanceCount)
+{
+    if (StereoPassActive && (instanceCount == 0))
+    {
+        glEnable(GL_CLIP_DISTANCE0);
+        if (indices)
+        {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ((Buffer*)indices)->GLBuffer);
+            glDrawElementsInstanced(prim, count, indices->Is32BitIndex() ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT, NULL, 2);
+        }
+        else
+        {
+            glDrawArraysInstanced(prim, 0, count, 2);
+        }
+        glDisable(GL_CLIP_DISTANCE0);
+    }
+    else if (instanceCount > 0)
+    {
+        if (indices)
+        {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ((Buffer*)indices)->GLBuffer);
+            glDrawElementsInstanced(prim, count, indices->Is32BitIndex() ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT, NULL, instanceCount);
+        }
+        else
+        {
+            glDrawArraysInstanced(prim, 0, count, instanceCount);
+        }
 
-    if (indices)
+        for (int i = 5; i < 8; i++)
+        {
+            glVertexAttribDivisor(i, 0);
+            glDisableVertexAttribArray(i);
+        }
+    }
+    else if (indices)
     {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ((Buffer*)indices)->GLBuffer);
-        glDrawElements(prim, count, GL_UNSIGNED_SHORT, NULL);
+        glDrawElements(prim, count, indices->Is32BitIndex() ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT, NULL);
     }
     else
     {
@@ -867,13 +1551,28 @@ Buffer::~Buffer()
         glDeleteBuffers(1, &GLBuffer);
 }
 
+GLuint Buffer::GetBuffer() const
+{
+    return Streamed ? Ren->GetStreamBuffer() : GLBuffer;
+}
+
 bool Buffer::Data(int use, const void* buffer, size_t size)
 {
+    Index32 = (use & Buffer_Index32) != 0;
+
     switch (use & Buffer_TypeMask)
     {
     case Buffer_Index:     Use = GL_ELEMENT_ARRAY_BUFFER; break;
     default:               Use = GL_ARRAY_BUFFER; break;
     }
+    Size = size;
+
+    // Dynamic vertices without initial data are about to be written through Map, so they can
+    // come from the stream buffer instead of storage that glBufferData would have to reallocate.
+    Streamed  = !buffer && (Use == GL_ARRAY_BUFFER) && !(use & Buffer_ReadOnly) && (Ren->GetStreamBuffer() != 0);
+    StreamPtr = NULL;
+    if (Streamed)
+        return 1;
 
     if (!GLBuffer)
         glGenBuffers(1, &GLBuffer);
@@ -887,19 +1586,49 @@ bool Buffer::Data(int use, const void* buffer, size_t size)
     return 1;
 }
 
-void* Buffer::Map(size_t, size_t, int)
+void* Buffer::Map(size_t start, size_t size, int flags)
 {
-    int mode = GL_WRITE_ONLY;
-    //if (flags & Map_Unsynchronized)
-    //    mode |= GL_MAP_UNSYNCHRONIZED;
-    
+    if (Streamed)
+    {
+        if (StreamPtr && !(flags & Map_Discard))
+            return StreamPtr + start;
+
+        StreamPtr = (unsigned char*)Ren->AllocStream(Size, StreamOffset);
+        if (StreamPtr)
+            return StreamPtr + start;
+
+        // The stream buffer is full this frame, so this buffer needs storage of its own.
+        Streamed = false;
+        if (!GLBuffer)
+            glGenBuffers(1, &GLBuffer);
+        glBindBuffer(Use, GLBuffer);
+        glBufferData(Use, Size, NULL, GL_DYNAMIC_DRAW);
+    }
+
     glBindBuffer(Use, GLBuffer);
-    void* v = glMapBuffer(Use, mode);
-    return v;
+
+    if (GLE_ARB_map_buffer_range)
+    {
+        // Invalidating orphans the old storage instead of waiting for draws that still read it.
+        GLbitfield access = GL_MAP_WRITE_BIT;
+        if (flags & Map_Discard)
+            access |= GL_MAP_INVALIDATE_BUFFER_BIT;
+        if (flags & Map_Unsynchronized)
+            access |= GL_MAP_UNSYNCHRONIZED_BIT;
+
+        return glMapBufferRange(Use, start, size ? size : (Size - start), access);
+    }
+
+    unsigned char* v = (unsigned char*)glMapBuffer(Use, GL_WRITE_ONLY);
+    return v ? (v + start) : NULL;
 }
 
 bool Buffer::Unmap(void*)
 {
+    // The stream buffer is mapped coherently for its whole lifetime.
+    if (Streamed)
+        return true;
+
     glBindBuffer(Use, GLBuffer);
     int r = glUnmapBuffer(Use);
     return r != 0;
@@ -932,18 +1661,25 @@ bool Shader::Compile(const char* src)
     return 1;
 }
 
-ShaderSet::ShaderSet() :
+ShaderSet::ShaderSet(RenderDevice* ren) :
+    Ren(ren),
   //Prog(0),
+    InstancedShaders(),
+    StereoShaders(),
     UniformInfo(),
     ProjLoc(0),
     ViewLoc(0),
     GlobalTintLoc(0),
+    EyeProjLoc(-1),
+    EyeClipPlaneLoc(-1),
   //TexLoc[8];
     UsesLighting(false),
     LightingVer(0)
 {
     memset(TexLoc, 0, sizeof(TexLoc));
     Prog = glCreateProgram();
+    // The name may be one of a deleted program which is still cached as current.
+    Ren->InvalidateBindings();
 }
 ShaderSet::~ShaderSet()
 {
@@ -974,6 +1710,9 @@ bool ShaderSet::Link()
     glBindAttribLocation(Prog, 2, "TexCoord");
     glBindAttribLocation(Prog, 3, "TexCoord1");
     glBindAttribLocation(Prog, 4, "Normal");
+    glBindAttribLocation(Prog, 5, "InstanceRow0");
+    glBindAttribLocation(Prog, 6, "InstanceRow1");
+    glBindAttribLocation(Prog, 7, "InstanceRow2");
 
     glLinkProgram(Prog);
     GLint r;
@@ -986,7 +1725,7 @@ bool ShaderSet::Link()
         if (!r)
             return 0;
     }
-    glUseProgram(Prog);
+    Ren->UseProgram(Prog);
 
     UniformInfo.clear();
     LightingVer = 0;
@@ -1016,6 +1755,7 @@ bool ShaderSet::Link()
             }
             Uniform u;
             u.Name = name;
+            u.Id = GetUniformId(name);
             u.Location = l;
             u.Size = size;
             switch (type)
@@ -1040,6 +1780,8 @@ bool ShaderSet::Link()
     ProjLoc         = glGetUniformLocation(Prog, "Proj");
     ViewLoc         = glGetUniformLocation(Prog, "View");
     GlobalTintLoc   = glGetUniformLocation(Prog, "GlobalTint");
+    EyeProjLoc      = glGetUniformLocation(Prog, "EyeProj");
+    EyeClipPlaneLoc = glGetUniformLocation(Prog, "EyeClipPlane");
     for (int i = 0; i < 8; i++)
     {
         char texv[32];
@@ -1057,28 +1799,50 @@ bool ShaderSet::Link()
 
 void ShaderSet::Set(PrimitiveType) const
 {
-    glUseProgram(Prog);
+    Ren->UseProgram(Prog);
 }
 
-bool ShaderSet::SetUniform(const char* name, int n, const float* v)
+uint32_t ShaderSet::GetUniformId(const char* name)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const char* p = name; *p; p++)
+        hash = (hash ^ (uint8_t)*p) * 16777619u;
+    return hash;
+}
+
+const ShaderSet::Uniform* ShaderSet::FindUniform(uint32_t id, const char* name) const
 {
     for (size_t i = 0; i < UniformInfo.size(); i++)
-        if (!strcmp(UniformInfo[i].Name.ToCStr(), name))
+        if ((UniformInfo[i].Id == id) && !strcmp(UniformInfo[i].Name.ToCStr(), name))
+            return &UniformInfo[i];
+    return NULL;
+}
+
+bool ShaderSet::SetUniform(const char* name, int n, const float* v)
+{
+    return SetUniform(GetUniformId(name), name, n, v);
+}
+
+bool ShaderSet::SetUniform(uint32_t id, const char* name, int n, const float* v)
+{
+    const Uniform* u = FindUniform(id, name);
+    if (u)
+    {
+        OVR_ASSERT(u->Location >= 0);
+        Ren->UseProgram(Prog);
+        switch (u->Type)
         {
-            OVR_ASSERT(UniformInfo[i].Location >= 0);
-            glUseProgram(Prog);
-            switch (UniformInfo[i].Type)
-            {
-            case 1:   glUniform1fv(UniformInfo[i].Location, n, v); break;
-            case 2:   glUniform2fv(UniformInfo[i].Location, n/2, v); break;
-            case 3:   glUniform3fv(UniformInfo[i].Location, n/3, v); break;
-            case 4:   glUniform4fv(UniformInfo[i].Location, n/4, v); break;
-            case 12:  glUniformMatrix3fv(UniformInfo[i].Location, 1, 1, v); break;
-            case 16:  glUniformMatrix4fv(UniformInfo[i].Location, 1, 1, v); break;
-            default: OVR_ASSERT(0);
-            }
-            return 1;
+        case 1:   glUniform1fv(u->Location, n, v); break;
+        case 2:   glUniform2fv(u->Location, n/2, v); break;
+        case 3:   glUniform3fv(u->Location, n/3, v); break;
+        case 4:   glUniform4fv(u->Location, n/4, v); break;
+        case 12:  glUniformMatrix3fv(u->Location, 1, 1, v); break;
+        case 16:  glUniformMatrix4fv(u->Location, 1, 1, v); break;
+        default: OVR_ASSERT(0);
         }
+        return 1;
+    }
 
     WriteLog("[RenderGLDevice] Warning: uniform %s not present in selected shader", name);
     return 0;
@@ -1086,13 +1850,13 @@ bool ShaderSet::SetUniform(const char* name, int n, const float* v)
 
 bool ShaderSet::SetUniform4x4f(const char* name, const Matrix4f& m)
 {
-    for (size_t i = 0; i < UniformInfo.size(); i++)
-        if (!strcmp(UniformInfo[i].Name.ToCStr(), name))
-        {
-            glUseProgram(Prog);
-            glUniformMatrix4fv(UniformInfo[i].Location, 1, 1, &m.M[0][0]);
-            return 1;
-        }
+    const Uniform* u = FindUniform(GetUniformId(name), name);
+    if (u)
+    {
+        Ren->UseProgram(Prog);
+        glUniformMatrix4fv(u->Location, 1, 1, &m.M[0][0]);
+        return 1;
+    }
 
     WriteLog("[RenderGLDevice] Warning: uniform %s not present in selected shader", name);
     return 0;
@@ -1139,50 +1903,54 @@ void Texture::Set(int slot, Render::ShaderStage stage) const
 
 void Texture::SetSampleMode(int sm)
 {
+    Ren->InvalidateBindings();
+    const GLenum target = (GetFormat() & Texture_Array) ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
 	  if (GetFormat() & Texture_Cubemap)
           glBindTexture(GL_TEXTURE_CUBE_MAP, GetTexId());
+	  else if (GetFormat() & Texture_Array)
+          glBindTexture(GL_TEXTURE_2D_ARRAY, GetTexId());
 	  else
           glBindTexture((GetSamples() > 1) ? GL_TEXTURE_2D_MULTISAMPLE : GL_TEXTURE_2D, GetTexId());
 
     switch (sm & Sample_FilterMask)
     {
     case Sample_Linear:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         if(GLE_EXT_texture_filter_anisotropic)
-        	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1);
+        	glTexParameteri(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1);
         break;
 
     case Sample_Anisotropic:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         if(GLE_EXT_texture_filter_anisotropic)
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 4);
+            glTexParameteri(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, 4);
         break;
 
     case Sample_Nearest:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
         if(GLE_EXT_texture_filter_anisotropic)
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1);
+            glTexParameteri(target, GL_TEXTURE_MAX_ANISOTROPY_EXT, 1);
         break;
     }
 
     switch (sm & Sample_AddressMask)
     {
     case Sample_Repeat:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
         break;
 
     case Sample_Clamp:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
         break;
 
     case Sample_ClampBorder:
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
         break;
     }
 }
@@ -1215,6 +1983,7 @@ void Texture::GenerateMips()
         }
     }
     
+    Ren->InvalidateBindings();
     glBindTexture(GL_TEXTURE_2D, GetTexId());
     glEnable(GL_TEXTURE_2D);
     glGenerateMipmap(GL_TEXTURE_2D);
@@ -1233,6 +2002,7 @@ void Texture::Commit()
         }
 
         ovr_CommitTextureSwapChain(Session, TextureChain);
+        Ren->InvalidateBindings();
     }
 }
 
@@ -1355,6 +2125,22 @@ Texture* RenderDevice::CreateTexture(uint64_t format, int width, int height, con
         glformat = isSRGB ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB : GL_COMPRESSED_RGBA_BPTC_UNORM_ARB;
         isCompressed = true;
         break;
+    case Texture_BC4U:
+        glformat = GL_COMPRESSED_RED_RGTC1;
+        isCompressed = true;
+        break;
+    case Texture_BC4S:
+        glformat = GL_COMPRESSED_SIGNED_RED_RGTC1;
+        isCompressed = true;
+        break;
+    case Texture_BC5U:
+        glformat = GL_COMPRESSED_RG_RGTC2;
+        isCompressed = true;
+        break;
+    case Texture_BC5S:
+        glformat = GL_COMPRESSED_SIGNED_RG_RGTC2;
+        isCompressed = true;
+        break;
     default:
         OVR_FAIL();
         return NULL;
@@ -1629,24 +2415,9 @@ Texture* RenderDevice::CreateTexture(uint64_t format, int width, int height, con
         (format & Texture_RGBA8) &&
         ((format & Texture_SwapTextureSetStatic) == 0))
     {
-        int srcw = width, srch = height;
-        int level = 0;
-        uint8_t* mipmaps = NULL;
-        do
-        {
-            level++;
-            int mipw = srcw >> 1; if (mipw < 1) mipw = 1;
-            int miph = srch >> 1; if (miph < 1) miph = 1;
-            if (mipmaps == NULL)
-                mipmaps = (uint8_t*)OVR_ALLOC(mipw * miph * 4);
-            FilterRgba2x2(level == 1 ? (const uint8_t*)data : mipmaps, srcw, srch, mipmaps);
-            glTexImage2D(GL_TEXTURE_2D, level, internalFormat, mipw, miph, 0, glformat, gltype, mipmaps);
-            srcw = mipw;
-            srch = miph;
-        } while (srcw > 1 || srch > 1);
-        if (mipmaps)
-            OVR_FREE(mipmaps);
-        glTexParameteri(textureTarget, GL_TEXTURE_MAX_LEVEL, level);
+        // Filter the mips down from the top level on the GPU, in linear space for sRGB formats.
+        glGenerateMipmap(textureTarget);
+        glTexParameteri(textureTarget, GL_TEXTURE_MAX_LEVEL, GetNumMipLevels(width, height) - 1);
     }
     else if (furtherInitialization)
     {
@@ -1667,6 +2438,95 @@ Texture* RenderDevice::CreateTexture(uint64_t format, int width, int height, con
         glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
     }
 
+    // Texture creation bound textures directly, and the runtime may have as well. This also
+    // drops cached bindings of deleted textures whose names may have been reused.
+    InvalidateBindings();
+
+    OVR_ASSERT(!glGetError());
+    return NewTex;
+}
+
+Texture* RenderDevice::CreateTextureArray(const std::vector<Render::Texture*>& slices)
+{
+    // Array textures are core from 3.0. Without copy_image, each slice's mips are read back and
+    // uploaded again, so only the compressed and RGBA8 formats the scenes load are taken.
+    if (slices.empty() || GLVersionInfo.WholeVersion < 300)
+    {
+        return NULL;
+    }
+    Texture* first = (Texture*)slices[0];
+    const uint64_t format = first->GetFormat();
+    const bool     isCompressed = (format & Texture_Compressed) != 0;
+    if (first->TextureChain || first->GetSamples() > 1 ||
+        (format & (Texture_Cubemap | Texture_Array | Texture_RenderTarget | Texture_DepthMask)) ||
+        (!isCompressed && (format & Texture_TypeMask) != Texture_RGBA8))
+    {
+        return NULL;
+    }
+    for (size_t i = 1; i < slices.size(); i++)
+    {
+        Texture* slice = (Texture*)slices[i];
+        if (slice->TextureChain || slice->GetFormat() != format ||
+            slice->GetWidth() != first->GetWidth() || slice->GetHeight() != first->GetHeight())
+        {
+            return NULL;
+        }
+    }
+
+    InvalidateBindings();
+    GLint internalFormat = 0, maxLevel = 0;
+    glBindTexture(GL_TEXTURE_2D, first->GetTexId());
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+    glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+    const int width = first->GetWidth(), height = first->GetHeight();
+    const int mipCount = std::min((int)maxLevel + 1, GetNumMipLevels(width, height));
+    const int layers = (int)slices.size();
+
+    Texture* NewTex = new Texture(Session, this, (format & ~(uint64_t)Texture_GenMipmaps) | Texture_Array,
+                                  width, height, 1);
+    glGenTextures(1, &NewTex->TexId);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, NewTex->TexId);
+    for (int mip = 0; mip < mipCount; mip++)
+    {
+        const int w = std::max(width >> mip, 1), h = std::max(height >> mip, 1);
+        if (isCompressed)
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, mip, internalFormat, w, h, layers, 0,
+                                   GetTextureSize(format, w, h) * layers, NULL);
+        else
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, mip, internalFormat, w, h, layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    }
+
+    std::vector<unsigned char> level;
+    for (int layer = 0; layer < layers; layer++)
+    {
+        Texture* slice = (Texture*)slices[layer];
+        for (int mip = 0; mip < mipCount; mip++)
+        {
+            const int w = std::max(width >> mip, 1), h = std::max(height >> mip, 1);
+            level.resize(isCompressed ? GetTextureSize(format, w, h) : (size_t)w * h * 4);
+
+            glBindTexture(GL_TEXTURE_2D, slice->GetTexId());
+            if (isCompressed)
+                glGetCompressedTexImage(GL_TEXTURE_2D, mip, level.data());
+            else
+                glGetTexImage(GL_TEXTURE_2D, mip, GL_RGBA, GL_UNSIGNED_BYTE, level.data());
+
+            glBindTexture(GL_TEXTURE_2D_ARRAY, NewTex->TexId);
+            if (isCompressed)
+                glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, mip, 0, 0, layer, w, h, 1, internalFormat,
+                                          (GLsizei)level.size(), level.data());
+            else
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, mip, 0, 0, layer, w, h, 1, GL_RGBA, GL_UNSIGNED_BYTE, level.data());
+        }
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, mipCount - 1);
+
+    InvalidateBindings();
     OVR_ASSERT(!glGetError());
     return NewTex;
 }
@@ -224,12 +224,19 @@ public:
     size_t        Size;
     GLenum        Use;
     GLuint        GLBuffer;
+    // Vertex buffers that are rewritten with Map(Map_Discard) before every draw have no GL
+    // storage of their own; their contents live at StreamOffset in the device's stream buffer.
+    bool          Streamed;
+    size_t        StreamOffset;
+    unsigned char* StreamPtr;
 
 public:
-    Buffer(RenderDevice* r) : Ren(r), Size(0), Use(0), GLBuffer(0) {}
+    Buffer(RenderDevice* r) : Ren(r), Size(0), Use(0), GLBuffer(0), Streamed(false), StreamOffset(0), StreamPtr(NULL) {}
     ~Buffer();
 
-    GLuint         GetBuffer() { return GLBuffer; }
+    GLuint         GetBuffer() const;
+    // Byte offset of the contents within GetBuffer().
+    size_t         GetBaseOffset() const { return Streamed ? StreamOffset : 0; }
 
     virtual size_t GetSize() { return Size; }
     virtual void*  Map(size_t start, size_t size, int flags = 0);
@@ -315,26 +322,39 @@ public:
 class ShaderSet : public Render::ShaderSet
 {
 public:
-    GLuint Prog;
+    RenderDevice* Ren;
+    GLuint        Prog;
+
+    // This set's fragment shader with MVPInstanced, linked by RenderDevice::RenderInstances, and
+    // with MVPStereo, linked for the first stereo pass draw.
+    Ptr<ShaderSet> InstancedShaders;
+    Ptr<ShaderSet> StereoShaders;
 
     struct Uniform
     {
-        String Name;
-        int    Location, Size;
-        int    Type; // currently number of floats in vector
+        String   Name;
+        uint32_t Id;   // GetUniformId(Name)
+        int      Location, Size;
+        int      Type; // currently number of floats in vector
 
-        Uniform() : Name(), Location(0), Size(0), Type(0){}
+        Uniform() : Name(), Id(0), Location(0), Size(0), Type(0){}
     };
-    std::vector<Uniform> UniformInfo;
+    std::vector<Uniform> UniformInfo;  // Resolved once at link
 
     int     ProjLoc, ViewLoc, GlobalTintLoc;
+    int     EyeProjLoc, EyeClipPlaneLoc;
     int     TexLoc[8];
     bool    UsesLighting;
     int     LightingVer;
 
-    ShaderSet();
+    ShaderSet(RenderDevice* ren);
     ~ShaderSet();
 
+    // Hash of a uniform name. Callers that set the same uniform often can compute it once and
+    // use the id overload of SetUniform, which skips hashing the name.
+    static uint32_t GetUniformId(const char* name);
+    const Uniform*  FindUniform(uint32_t id, const char* name) const;
+
     virtual void SetShader(Render::Shader *s);
     virtual void UnsetShader(int stage);
 
@@ -345,6 +365,7 @@ public:
     // (unless a buffer is used, then each buffer is independent).     
     virtual bool SetUniform(const char* name, int n, const float* v);
     virtual bool SetUniform4x4f(const char* name, const Matrix4f& m);
+    bool         SetUniform(uint32_t id, const char* name, int n, const float* v);
 
     bool Link();
 };
@@ -384,6 +405,64 @@ protected:
     GLVersionAndExtensions         GLVersionInfo;
     DebugCallback                  DebugCallbackControl;
     const LightingParams*          Lighting;
+    std::vector<GLuint>            GpuTimerQueries[GpuTimerFrameCount];  // GL_TIMESTAMP queries
+    std::vector<GLuint>            OcclusionQueries[OcclusionFrameCount]; // GL_SAMPLES_PASSED queries
+
+    // Streamed vertex data goes into one persistently mapped buffer split into a section per
+    // frame in flight. The fence of a section is waited on before the section is reused.
+    static const int               StreamFrameCount = 3;
+    GLuint                         StreamBuffer;
+    unsigned char*                 StreamData;
+    size_t                         StreamFrameSize;
+    size_t                         StreamFrameUsed;
+    int                            StreamFrame;
+    GLsync                         StreamFences[StreamFrameCount];
+
+    // Fences ending each fenced frame, for deferred releases; needs ARB_sync.
+    GLsync                         FrameFenceSyncs[DeferredReleaseFrameCount];
+
+    // Needs ARB_buffer_storage; without it streamed buffers fall back to orphaning.
+    void CreateStreamBuffer();
+    void ReleaseStreamBuffer();
+
+    // The program and per-slot textures last bound through UseProgram and BindTexture. A value
+    // of InvalidBinding means unknown, e.g. after the Blitter or the runtime touched GL state.
+    enum { InvalidBinding = 0xFFFFFFFFu, MaxTextureSlots = 8 };
+    GLuint                         CurrentProgram;
+    GLuint                         BoundTextures[MaxTextureSlots];
+    GLenum                         BoundTextureTargets[MaxTextureSlots];
+    int                            ActiveTextureSlot;
+
+    virtual bool CreateGpuTimerQueries(int frameCount, int timestampsPerFrame) override;
+    virtual void ReleaseGpuTimerQueries() override;
+    virtual void WriteGpuTimestamp(int frame, int index) override;
+    virtual GpuTimerReadResult ReadGpuTimestamps(int frame, int count, uint64_t* timestamps, uint64_t& frequency) override;
+
+    virtual bool CreateOcclusionQueries(int frameCount, int queriesPerFrame) override;
+    virtual void ReleaseOcclusionQueries() override;
+    virtual void BeginOcclusionQuery(int frame, int index) override;
+    virtual void EndOcclusionQuery(int frame, int index) override;
+    virtual bool ReadOcclusionQueries(int frame, int count, uint64_t* samples) override;
+
+    virtual bool SignalFrameFence(int slot) override;
+    virtual bool IsFrameFenceDone(int slot) override;
+
+    virtual bool RenderInstances(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
+                                 Render::Buffer* instances, const Matrix4f& matrix, int count, int instanceCount,
+                                 PrimitiveType prim) override;
+
+    virtual bool CanRenderStereo(const Fill* fill) override;
+    ShaderSet*   getStereoShaders(ShaderSet* shaders);
+
+    // Sets the fill and uniforms for a draw, and returns the GL primitive, or GL_NONE if there
+    // is none for rprim. instancedShaders, if given, replaces the fill's program, and during a
+    // stereo pass the fill's MVPStereo program does.
+    GLenum SetDrawState(const Fill* fill, const Matrix4f& matrix, PrimitiveType rprim,
+                        ShaderSet* instancedShaders = nullptr);
+    // Draws with the vertex attributes already set up, then disables them. With instanceCount
+    // above zero, draws that many instances and also resets attributes 5 to 7. During a stereo
+    // pass other draws are two instances, one per eye.
+    void   DrawBound(GLenum prim, Render::Buffer* indices, int count, int instanceCount = 0);
 
 public:
     RenderDevice(ovrSession session, const RendererParams& p);
@@ -392,6 +471,20 @@ public:
     virtual void DeleteFills() override;
 
     virtual void Shutdown() override;
+
+    // glUseProgram and glBindTexture, skipped when the binding is already current.
+    void   UseProgram(GLuint prog);
+    void   BindTexture(int slot, GLenum target, GLuint tex);
+    // Must be called after GL binding state was changed other than through the two above.
+    void   InvalidateBindings();
+
+    GLuint GetStreamBuffer() const { return StreamBuffer; }
+    // Returns size bytes of stream memory that stay valid until the end of the frame, and their
+    // offset in the stream buffer, or NULL if the stream buffer is missing or full this frame.
+    void*  AllocStream(size_t size, size_t& offset);
+    // Fences the current frame's stream section and moves on to the next one. Called by the
+    // platform devices after presenting.
+    void   EndStreamFrame();
     
     virtual void FillTexturedRect(float left, float top, float right, float bottom, float ul, float vt, float ur, float vb, Color c, Ptr<OVR::Render::Texture> tex, const Matrix4f* view, bool premultAlpha = false) override;
 
@@ -411,6 +504,7 @@ public:
     virtual void ResolveMsaa(OVR::Render::Texture* msaaTex, OVR::Render::Texture* outputTex) override;
 
     virtual void SetCullMode(CullMode cullMode) override;
+    virtual void SetColorWrite(bool enabled) override;
 
     virtual bool Present(bool withVsync)  override{ OVR_UNUSED(withVsync); return true; };
     virtual void SetRenderTarget(Render::Texture* color,
@@ -425,7 +519,7 @@ public:
 
     // Overridden to apply proper blend state.
     virtual void FillRect(float left, float top, float right, float bottom, Color c, const Matrix4f* view = NULL) override;
-    virtual void RenderText(const struct Font* font, const char* str, float x, float y, float size, Color c, const Matrix4f* view = NULL) override;
+    virtual void FlushText() override;
     virtual void FillGradientRect(float left, float top, float right, float bottom, Color col_top, Color col_btm, const Matrix4f* view) override;
     virtual void RenderImage(float left, float top, float right, float bottom, ShaderFill* image, unsigned char alpha = 255, const Matrix4f* view = NULL) override;
 
@@ -434,10 +528,18 @@ public:
                         const Matrix4f& matrix, int offset, int count, PrimitiveType prim = Prim_Triangles) override;
     virtual void RenderWithAlpha(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
                                  const Matrix4f& matrix, int offset, int count, PrimitiveType prim = Prim_Triangles) override;
+    virtual void RenderSplit(const Fill* fill, Render::Buffer* positions, Render::Buffer* attributes,
+                             Render::Buffer* indices, const Matrix4f& matrix, int firstVertex, int count,
+                             PrimitiveType prim = Prim_Triangles) override;
+    virtual void RenderQuantized(const Fill* fill, Render::Buffer* vertices, Render::Buffer* indices,
+                                 const Matrix4f& matrix, int firstVertex, int count,
+                                 PrimitiveType prim = Prim_Triangles) override;
+    virtual bool SupportsVertexLayout(VertexLayout layout) const override;
 
     virtual Buffer* CreateBuffer() override;
     virtual Texture* CreateTexture(uint64_t format, int width, int height, const void* data, int mipcount = 1, ovrResult* error = nullptr) override;
-    virtual ShaderSet* CreateShaderSet() override { return new ShaderSet; }
+    virtual Texture* CreateTextureArray(const std::vector<Render::Texture*>& slices) override;
+    virtual ShaderSet* CreateShaderSet() override { return new ShaderSet(this); }
 
     virtual Fill *GetSimpleFill(int flags = Fill::F_Solid) override;
     virtual Fill *GetTextureFill(Render::Texture* tex, bool useAlpha = false, bool usePremult = false) override;
@@ -187,6 +187,8 @@ bool RenderDevice::Present(bool useVsync)
 	success = SwapBuffers(dc);
 	ReleaseDC(Window, dc);
 
+    EndStreamFrame();
+
     OVR_ASSERT(success == TRUE);
     return success == TRUE;
 }
@@ -33,6 +33,12 @@ static const uint32_t OVR_DXT3_MAGIC_NUMBER = 0x33545844; // "DXT3"
 static const uint32_t OVR_DXT4_MAGIC_NUMBER = 0x34545844; // "DXT4"
 static const uint32_t OVR_DXT5_MAGIC_NUMBER = 0x35545844; // "DXT5"
 static const uint32_t OVR_DX10_MAGIC_NUMBER = 0x30315844; // "DX10" - Means use the extended header
+static const uint32_t OVR_ATI1_MAGIC_NUMBER = 0x31495441; // "ATI1"
+static const uint32_t OVR_BC4U_MAGIC_NUMBER = 0x55344342; // "BC4U"
+static const uint32_t OVR_BC4S_MAGIC_NUMBER = 0x53344342; // "BC4S"
+static const uint32_t OVR_ATI2_MAGIC_NUMBER = 0x32495441; // "ATI2"
+static const uint32_t OVR_BC5U_MAGIC_NUMBER = 0x55354342; // "BC5U"
+static const uint32_t OVR_BC5S_MAGIC_NUMBER = 0x53354342; // "BC5S"
 
 static const uint32_t DDS_Cubemap_PositiveX = 0x00000600;
 static const uint32_t DDS_Cubemap_NegativeX = 0x00000a00;
@@ -99,13 +105,19 @@ static inline int InterpretPixelFormatFourCC(uint32_t fourCC) {
 	case OVR_DXT3_MAGIC_NUMBER: return Texture_BC2;
 	case OVR_DXT4_MAGIC_NUMBER: return Texture_BC3;
 	case OVR_DXT5_MAGIC_NUMBER: return Texture_BC3;
+	case OVR_ATI1_MAGIC_NUMBER: return Texture_BC4U;
+	case OVR_BC4U_MAGIC_NUMBER: return Texture_BC4U;
+	case OVR_BC4S_MAGIC_NUMBER: return Texture_BC4S;
+	case OVR_ATI2_MAGIC_NUMBER: return Texture_BC5U;
+	case OVR_BC5U_MAGIC_NUMBER: return Texture_BC5U;
+	case OVR_BC5S_MAGIC_NUMBER: return Texture_BC5S;
 	}
 
 	// Unrecognized FourCC
 	return -1;
 }
 
-Texture* LoadTextureDDSTopDown(RenderDevice* ren, File* f, int textureLoadFlags)
+bool DecodeTextureDDS(File* f, int textureLoadFlags, TextureImage& image)
 {
     bool srgbAware = (textureLoadFlags & TextureLoad_SrgbAware) != 0;
     bool anisotropic = (textureLoadFlags & TextureLoad_Anisotropic) != 0;
@@ -117,7 +129,7 @@ Texture* LoadTextureDDSTopDown(RenderDevice* ren, File* f, int textureLoadFlags)
     f->Read(filecode, 4);
     if (strncmp((const char*)filecode, "DDS ", 4) != 0)
     {
-        return NULL;
+        return false;
     }
 
     f->Read((unsigned char*)(&header), sizeof(header));
@@ -153,6 +165,18 @@ Texture* LoadTextureDDSTopDown(RenderDevice* ren, File* f, int textureLoadFlags)
                 case DXGI_FORMAT_BC3_UNORM_SRGB:
                     format = Texture_BC3;
                     break;
+                case DXGI_FORMAT_BC4_UNORM:
+                    format = Texture_BC4U;
+                    break;
+                case DXGI_FORMAT_BC4_SNORM:
+                    format = Texture_BC4S;
+                    break;
+                case DXGI_FORMAT_BC5_UNORM:
+                    format = Texture_BC5U;
+                    break;
+                case DXGI_FORMAT_BC5_SNORM:
+                    format = Texture_BC5S;
+                    break;
                 case DXGI_FORMAT_BC6H_SF16:
                     format = Texture_BC6S;
                     break;
@@ -166,14 +190,14 @@ Texture* LoadTextureDDSTopDown(RenderDevice* ren, File* f, int textureLoadFlags)
                 default:
                     OVR_ASSERT(false);
                     // Add more formats and you encounter dds files that need them
-                    break;
+                    return false;
             }
         }
         else
         {
             format = InterpretPixelFormatFourCC(header.PixelFormat.FourCC);
             if (format == -1) {
-                return NULL;
+                return false;
             }
         }
     }
@@ -201,26 +225,46 @@ Texture* LoadTextureDDSTopDown(RenderDevice* ren, File* f, int textureLoadFlags)
           }
       }
 
-    int            byteLen = f->BytesAvailable();
-    unsigned char* bytes   = new unsigned char[byteLen];
-    f->Read(bytes, byteLen);
-    Texture* out = ren->CreateTexture(format, (int)width, (int)height, bytes, mipCount);
-	if (!out) {
-		return NULL;
-	}
+    // Upload straight from files whose contents are in memory already, such as a MappedFile.
+    const uint8_t* data = f->GetData();
+    if (data)
+    {
+        data += f->LTell();
+    }
+    else
+    {
+        int byteLen = f->BytesAvailable();
+        image.Storage.resize(byteLen);
+        f->Read(image.Storage.data(), byteLen);
+        data = image.Storage.data();
+    }
+
+    image.Format = format;
+    image.Width = width;
+    image.Height = height;
+    image.MipCount = (int)mipCount;
+    image.Data = data;
 
     if(strstr(f->GetFilePath(), "_c."))
     {
-        out->SetSampleMode(Sample_Clamp | (anisotropic ? Sample_Anisotropic : 0));
+        image.SampleMode = Sample_Clamp | (anisotropic ? Sample_Anisotropic : 0);
     }
     else
     {
-        out->SetSampleMode((anisotropic ? Sample_Anisotropic : 0));
+        image.SampleMode = (anisotropic ? Sample_Anisotropic : 0);
     }
 
-    delete[] bytes;
+    return true;
+}
 
-    return out;
+Texture* LoadTextureDDSTopDown(RenderDevice* ren, File* f, int textureLoadFlags)
+{
+    TextureImage image;
+    if (!DecodeTextureDDS(f, textureLoadFlags, image))
+    {
+        return NULL;
+    }
+    return CreateTextureFromImage(ren, image);
 }
 
 
@@ -23,10 +23,11 @@ limitations under the License.
 
 
 #include "Render_Device.h"
+#include "Kernel/OVR_SysFile.h"
 
 namespace OVR { namespace Render {
 
-Texture* LoadTextureTgaEitherWay(RenderDevice* ren, File* f, int textureLoadFlags, unsigned char alpha, bool bottomUp)
+bool DecodeTextureTga(File* f, int textureLoadFlags, unsigned char alpha, bool bottomUp, TextureImage& image)
 {
     OVR_ASSERT(textureLoadFlags != 255); // probably means an older style call is being made
 
@@ -36,12 +37,32 @@ Texture* LoadTextureTgaEitherWay(RenderDevice* ren, File* f, int textureLoadFlag
     bool createSwapTextureSet = (textureLoadFlags & TextureLoad_SwapTextureSet) != 0;
     bool isHdcp = (textureLoadFlags & TextureLoad_Hdcp) != 0;
 
+    // TextureConverter writes a BC7 copy of a TGA next to it, with its mips made already. Use that
+    // instead when this load would give the same image.
+    if (!bottomUp && (alpha == 255) && !generatePremultAlpha && !isHdcp && f->GetFilePath())
+    {
+        std::string ddsPath = f->GetFilePath();
+        size_t extension = ddsPath.rfind('.');
+        if ((extension != std::string::npos) && (ddsPath.find_first_of("/\\", extension) == std::string::npos))
+        {
+            ddsPath.replace(extension, std::string::npos, ".dds");
+            SysFile ddsFile(ddsPath.c_str());
+            if (ddsFile.IsValid() && DecodeTextureDDS(&ddsFile, textureLoadFlags, image))
+            {
+                // Like the TGA, commit static swap texture sets as soon as they're created.
+                image.Commit = true;
+                return true;
+            }
+            image = TextureImage();
+        }
+    }
+
     f->SeekToBegin();
 
     if ( f->GetLength() == 0 )
     {
         // File doesn't exist!
-        return NULL;
+        return false;
     }
     
     int desclen = f->ReadUByte();
@@ -58,10 +79,11 @@ Texture* LoadTextureTgaEitherWay(RenderDevice* ren, File* f, int textureLoadFlag
     int bpp = f->ReadUByte();
     int descbyte = f->ReadUByte();
     int imgsize = width * height * 4;
-    unsigned char* imgdata = (unsigned char*) OVR_ALLOC(imgsize);
+    image.Storage.resize(imgsize);
+    unsigned char* imgdata = image.Storage.data();
     unsigned char buf[16];
-    f->Read(imgdata, desclen);
-    f->Read(imgdata, palCount * (palSize + 7) >> 3);
+    f->Skip(desclen);
+    f->Skip(palCount * (palSize + 7) >> 3);
     int bpl = width * 4;
 
     // From the interwebs (very reliable I'm sure):
@@ -146,15 +168,15 @@ Texture* LoadTextureTgaEitherWay(RenderDevice* ren, File* f, int textureLoadFlag
 
         default:
             OVR_ASSERT ( !"Unknown bits per pixel" );
-            OVR_FREE(imgdata);
-            return NULL;
+            image.Storage.clear();
+            return false;
         }
         break;
 
     default:
         OVR_ASSERT ( !"unknown file format" );
-        OVR_FREE(imgdata);
-        return NULL;
+        image.Storage.clear();
+        return false;
     }
 
     uint64_t format = Texture_RGBA|Texture_GenMipmaps;
@@ -174,27 +196,36 @@ Texture* LoadTextureTgaEitherWay(RenderDevice* ren, File* f, int textureLoadFlag
         format |= Texture_SRGB;
     }
 
-    Texture* out = ren->CreateTexture(format, width, height, imgdata);
-    if (!out)
-    {
-        return NULL;
-    }
+    image.Format = format;
+    image.Width = width;
+    image.Height = height;
+    image.MipCount = 1;
+    image.Data = imgdata;
 
     // Commit static image immediately since we're done rendering to it.
-    out->Commit();
+    image.Commit = true;
 
     // check for clamp based on texture name
     if(strstr(f->GetFilePath(), "_c."))
     {
-        out->SetSampleMode(Sample_Clamp | (anisotropic ? Sample_Anisotropic : 0));
+        image.SampleMode = Sample_Clamp | (anisotropic ? Sample_Anisotropic : 0);
     }
     else if(anisotropic)
     {
-        out->SetSampleMode((anisotropic ? Sample_Anisotropic : 0));
+        image.SampleMode = (anisotropic ? Sample_Anisotropic : 0);
     }
 
-    OVR_FREE(imgdata);
-    return out;
+    return true;
+}
+
+Texture* LoadTextureTgaEitherWay(RenderDevice* ren, File* f, int textureLoadFlags, unsigned char alpha, bool bottomUp)
+{
+    TextureImage image;
+    if (!DecodeTextureTga(f, textureLoadFlags, alpha, bottomUp, image))
+    {
+        return NULL;
+    }
+    return CreateTextureFromImage(ren, image);
 }
 
 Texture* LoadTextureTgaTopDown(RenderDevice* ren, File* f, int textureLoadFlags, unsigned char alpha)
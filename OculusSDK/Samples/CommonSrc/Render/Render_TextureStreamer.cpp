@@ -0,0 +1,380 @@
+/************************************************************************************
+
+Filename    :   Render_TextureStreamer.cpp
+Content     :   Keeps scene texture mips resident by on-screen size, under a budget
+Created     :   October 14, 2026
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#include "Render_TextureStreamer.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace OVR { namespace Render {
+
+static const size_t PageSize = 4096;
+
+TextureStreamer::TextureStreamer()
+  : Budget(256 * 1024 * 1024),
+    ResidentBytes(0),
+    FullBytes(0),
+    StartSize(128),
+    DetailScale(2.0f),
+    MaxPending(2),
+    Frame(0)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    Clear();
+}
+
+void TextureStreamer::Clear()
+{
+    ReadGroup.Wait();
+    Streams.clear();
+    ModelStreams.clear();
+    ResidentBytes = 0;
+    FullBytes = 0;
+}
+
+int TextureStreamer::AddTexture(RenderDevice* ren, TextureImage& image, File* file)
+{
+    const uint64_t format = image.Format;
+    if ((format & (Texture_Cubemap | Texture_SwapTextureSet | Texture_SwapTextureSetStatic |
+                   Texture_RenderTarget | Texture_DepthMask)) ||
+        image.Width <= 0 || image.Height <= 0)
+    {
+        return -1;
+    }
+
+    const bool generated  = (format & Texture_GenMipmaps) != 0;
+    const bool compressed = (format & Texture_Compressed) != 0;
+    const int  levelCount = generated ? GetNumMipLevels(image.Width, image.Height) : image.MipCount;
+
+    // The top level of a compressed texture must be whole blocks, and generated mips are filtered
+    // down from levels at least two texels on a side.
+    int coarsestMip = 0;
+    while (coarsestMip + 1 < levelCount &&
+           std::max(image.Width, image.Height) >> coarsestMip > StartSize)
+    {
+        const int w = image.Width >> (coarsestMip + 1), h = image.Height >> (coarsestMip + 1);
+        if (compressed ? ((image.Width % (4 << (coarsestMip + 1))) || (image.Height % (4 << (coarsestMip + 1))))
+                       : (w < 1 || h < 1))
+        {
+            break;
+        }
+        coarsestMip++;
+    }
+    if (coarsestMip == 0)
+    {
+        return -1;
+    }
+
+    std::unique_ptr<Stream> stream(new Stream);
+    stream->Image.Format     = image.Format;
+    stream->Image.Width      = image.Width;
+    stream->Image.Height     = image.Height;
+    stream->Image.MipCount   = image.MipCount;
+    stream->Image.SampleMode = image.SampleMode;
+    stream->Image.Commit     = image.Commit;
+    stream->Image.Data       = image.Data;
+    stream->Image.Storage.swap(image.Storage);
+    if (stream->Image.Storage.empty())
+    {
+        stream->Source = file;
+    }
+    stream->LevelCount       = levelCount;
+    stream->CoarsestMip      = coarsestMip;
+
+    stream->LevelOffsets.resize(levelCount + 1);
+    stream->LevelOffsets[0] = 0;
+    for (int i = 0; i < levelCount; i++)
+    {
+        const int w = std::max(image.Width >> i, 1), h = std::max(image.Height >> i, 1);
+        stream->LevelOffsets[i + 1] = stream->LevelOffsets[i] + GetTextureSize(format, w, h);
+    }
+
+    if (generated)
+    {
+        stream->Mips.resize(coarsestMip);
+        const unsigned char* src = stream->Image.Data;
+        for (int i = 0; i < coarsestMip; i++)
+        {
+            const int w = image.Width >> i, h = image.Height >> i;
+            stream->Mips[i].resize((size_t)(w >> 1) * (h >> 1) * 4);
+            FilterRgba2x2(src, w, h, stream->Mips[i].data());
+            src = stream->Mips[i].data();
+        }
+    }
+
+    stream->ResidentMip = levelCount;
+    if (!setResidentMip(ren, *stream, coarsestMip))
+    {
+        image.Storage.swap(stream->Image.Storage);
+        return -1;
+    }
+    stream->WantedMip = coarsestMip;
+    FullBytes += stream->GetBytes(0);
+
+    Streams.push_back(std::move(stream));
+    return (int)Streams.size() - 1;
+}
+
+void TextureStreamer::AddBinding(int stream, ShaderFill* fill, int slot, Model* model)
+{
+    // Models sharing a fill bind it once.
+    std::vector<Binding>& bindings = Streams[stream]->Bindings;
+    bool bound = false;
+    for (size_t i = 0; i < bindings.size() && !bound; i++)
+    {
+        bound = (bindings[i].Fill == fill) && (bindings[i].Slot == slot);
+    }
+    if (!bound)
+    {
+        Binding binding;
+        binding.Fill = fill;
+        binding.Slot = slot;
+        bindings.push_back(binding);
+        fill->SetTexture(slot, Streams[stream]->Current);
+    }
+
+    if (model)
+    {
+        ModelStreams[model].push_back(stream);
+    }
+}
+
+int TextureStreamer::mipForPixels(const Stream& stream, float pixels) const
+{
+    const float texels = pixels * DetailScale;
+    const int   size   = std::max(stream.Image.Width, stream.Image.Height);
+    int mip = 0;
+    while (mip < stream.CoarsestMip && (float)(size >> (mip + 1)) >= texels)
+    {
+        mip++;
+    }
+    return mip;
+}
+
+void TextureStreamer::Update(RenderDevice* ren, Scene& scene, const Vector3f& viewPos, float projectionScale)
+{
+    Frame++;
+
+    for (size_t i = 0; i < Streams.size(); i++)
+    {
+        Streams[i]->WantedMip = Streams[i]->CoarsestMip;
+    }
+
+    // Want the detail that covers each drawn model's bounding sphere, for its nearest point.
+    scene.UpdateTransforms();
+    const SceneTransforms& transforms = scene.Transforms;
+    for (size_t i = 0; i < transforms.GetCount(); i++)
+    {
+        Node* node = transforms.GetNode(i);
+        if (node->GetType() != Node::Node_Model)
+        {
+            continue;
+        }
+        Model* model = (Model*)node;
+        auto   found = ModelStreams.find(model);
+        if (found == ModelStreams.end() || !model->Visible || model->Culled)
+        {
+            continue;
+        }
+
+        const Bounds3f& bounds = model->GetLocalBounds();
+        const Matrix4f& world  = transforms.GetWorldMatrix(i);
+        float scale = 0.0f;
+        for (int c = 0; c < 3; c++)
+        {
+            const Vector3f axis(world.M[0][c], world.M[1][c], world.M[2][c]);
+            scale = std::max(scale, axis.Length());
+        }
+        const Vector3f center   = world.Transform((bounds.b[0] + bounds.b[1]) * 0.5f);
+        const float    radius   = (bounds.b[1] - bounds.b[0]).Length() * 0.5f * scale;
+        const float    distance = std::max((center - viewPos).Length() - radius, 0.05f);
+        const float    pixels   = 2.0f * radius * projectionScale / distance;
+
+        for (int streamIndex : found->second)
+        {
+            Stream& stream = *Streams[streamIndex];
+            stream.WantedMip = std::min(stream.WantedMip, mipForPixels(stream, pixels));
+            stream.LastUsedFrame = Frame;
+        }
+    }
+
+    // Recreate the textures whose finer mips have been read in.
+    int pendingCount = 0;
+    for (size_t i = 0; i < Streams.size(); i++)
+    {
+        Stream& stream = *Streams[i];
+        if (stream.PendingMip < 0)
+        {
+            continue;
+        }
+        if (!stream.PendingReady.load(std::memory_order_acquire))
+        {
+            pendingCount++;
+            continue;
+        }
+
+        const int mip = std::max(stream.PendingMip, stream.WantedMip);
+        stream.PendingMip = -1;
+        if (mip < stream.ResidentMip && makeRoom(ren, stream, stream.GetBytes(mip)))
+        {
+            setResidentMip(ren, stream, mip);
+        }
+    }
+
+    // Start reading in for the blurriest of the rest.
+    std::vector<Stream*> wanting;
+    for (size_t i = 0; i < Streams.size(); i++)
+    {
+        Stream* stream = Streams[i].get();
+        if (stream->PendingMip < 0 && stream->WantedMip < stream->ResidentMip)
+        {
+            wanting.push_back(stream);
+        }
+    }
+    std::sort(wanting.begin(), wanting.end(), [](const Stream* a, const Stream* b)
+    {
+        return (a->ResidentMip - a->WantedMip) > (b->ResidentMip - b->WantedMip);
+    });
+    for (size_t i = 0; i < wanting.size() && pendingCount < MaxPending; i++, pendingCount++)
+    {
+        startPending(*wanting[i], wanting[i]->WantedMip);
+    }
+}
+
+void TextureStreamer::startPending(Stream& stream, int mip)
+{
+    stream.PendingMip = mip;
+
+    // Images in memory already are ready as they are.
+    if (!stream.Source)
+    {
+        stream.PendingReady.store(true, std::memory_order_release);
+        return;
+    }
+
+    stream.PendingReady.store(false, std::memory_order_relaxed);
+    Stream*              pstream = &stream;
+    const unsigned char* begin   = stream.Image.Data + stream.LevelOffsets[mip];
+    const unsigned char* end     = stream.Image.Data + stream.LevelOffsets[stream.ResidentMip];
+    ReadGroup.Run([pstream, begin, end]()
+    {
+        // Touch a byte of each page, so that the render thread finds them in memory.
+        volatile unsigned char sink = 0;
+        for (const unsigned char* p = begin; p < end; p += PageSize)
+        {
+            sink = sink + *p;
+        }
+        pstream->PendingReady.store(true, std::memory_order_release);
+    });
+}
+
+bool TextureStreamer::makeRoom(RenderDevice* ren, Stream& stream, size_t bytes)
+{
+    while (ResidentBytes - stream.ResidentBytes + bytes > Budget)
+    {
+        // Prefer the longest unused streams, then those with the most unneeded detail.
+        Stream* victim     = NULL;
+        int     victimMip  = 0;
+        bool    victimUsed = true;
+        for (size_t i = 0; i < Streams.size(); i++)
+        {
+            Stream* s = Streams[i].get();
+            if (s == &stream || s->ResidentMip >= s->CoarsestMip)
+            {
+                continue;
+            }
+
+            const bool used = (s->LastUsedFrame == Frame);
+            if (used && s->ResidentMip >= s->WantedMip)
+            {
+                continue;
+            }
+
+            bool better = !victim;
+            if (victim)
+            {
+                if (used != victimUsed)
+                    better = !used;
+                else if (!used)
+                    better = s->LastUsedFrame < victim->LastUsedFrame;
+                else
+                    better = (s->WantedMip - s->ResidentMip) > (victimMip - victim->ResidentMip);
+            }
+            if (better)
+            {
+                victim     = s;
+                victimMip  = used ? s->WantedMip : s->CoarsestMip;
+                victimUsed = used;
+            }
+        }
+
+        if (!victim || !setResidentMip(ren, *victim, victimMip))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TextureStreamer::setResidentMip(RenderDevice* ren, Stream& stream, int mip)
+{
+    TextureImage level;
+    level.Format     = stream.Image.Format;
+    level.Width      = std::max(stream.Image.Width >> mip, 1);
+    level.Height     = std::max(stream.Image.Height >> mip, 1);
+    level.SampleMode = stream.Image.SampleMode;
+    level.Commit     = stream.Image.Commit;
+    if (stream.Image.Format & Texture_GenMipmaps)
+    {
+        level.MipCount = 1;
+        level.Data     = mip ? stream.Mips[mip - 1].data() : stream.Image.Data;
+    }
+    else
+    {
+        level.MipCount = stream.LevelCount - mip;
+        level.Data     = stream.Image.Data + stream.LevelOffsets[mip];
+    }
+
+    Texture* texture = CreateTextureFromImage(ren, level);
+    if (!texture)
+    {
+        return false;
+    }
+
+    // The old level may still be bound to draws the GPU hasn't run yet.
+    ren->ReleaseDeferred(stream.Current);
+    stream.Current = *texture;
+    ResidentBytes = ResidentBytes - stream.ResidentBytes + stream.GetBytes(mip);
+    stream.ResidentBytes = stream.GetBytes(mip);
+    stream.ResidentMip = mip;
+
+    for (size_t i = 0; i < stream.Bindings.size(); i++)
+    {
+        stream.Bindings[i].Fill->SetTexture(stream.Bindings[i].Slot, texture);
+    }
+    return true;
+}
+
+}} // namespace OVR::Render
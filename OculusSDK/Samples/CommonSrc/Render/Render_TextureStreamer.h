@@ -0,0 +1,137 @@
+/************************************************************************************
+
+Filename    :   Render_TextureStreamer.h
+Content     :   Keeps scene texture mips resident by on-screen size, under a budget
+Created     :   October 14, 2026
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+************************************************************************************/
+
+#ifndef OVR_Render_TextureStreamer_h
+#define OVR_Render_TextureStreamer_h
+
+#include "Render_Device.h"
+#include "Kernel/OVR_TaskScheduler.h"
+
+#include <atomic>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace OVR { namespace Render {
+
+//-----------------------------------------------------------------------------------
+// ***** TextureStreamer
+//
+// Keeps only the mips of each streamed texture that its models need on screen resident, under a
+// byte budget. Textures start with their coarse mips only, no larger than the start size, and
+// are recreated from a finer mip as the models drawing with them come closer, a few a frame.
+// When that would go over budget, first the textures that weren't drawn last frame and then
+// those with more detail than they need are dropped back down.
+//
+// The decoded image of each texture is kept, so changing residency needs no decoding. DDS images
+// stay in their mapped file, and the pages a finer mip needs are read in on a worker thread
+// before the texture is recreated, so the render thread doesn't wait on the disk.
+//
+// A stream's texture is replaced whenever its residency changes, so it must only be bound
+// through fills given to AddBinding, which the streamer keeps pointing at the current texture.
+
+class TextureStreamer
+{
+public:
+    TextureStreamer();
+    ~TextureStreamer();
+
+    void     SetBudget(size_t bytes)        { Budget = bytes; }
+    size_t   GetBudget() const              { return Budget; }
+    // Streams added later start with their largest mip no bigger than this.
+    void     SetStartSize(int size)         { StartSize = size; }
+    // Texels wanted per pixel a model covers, allowing for textures that repeat across it.
+    void     SetDetailScale(float scale)    { DetailScale = scale; }
+
+    size_t   GetResidentBytes() const       { return ResidentBytes; }
+    // What every stream would take with all of its mips resident.
+    size_t   GetFullBytes() const           { return FullBytes; }
+    int      GetStreamCount() const         { return (int)Streams.size(); }
+
+    // Takes over the image, and the file it may point into, and creates the stream's first
+    // texture. Returns -1, leaving the image alone, for images that can't be streamed such as
+    // cubemaps, swap texture sets and those without smaller mips.
+    int      AddTexture(RenderDevice* ren, TextureImage& image, File* file);
+    Texture* GetTexture(int stream) const   { return Streams[stream]->Current; }
+
+    // Binds the stream to the fill's texture slot. model, which draws with the fill, decides
+    // the detail the stream needs.
+    void     AddBinding(int stream, ShaderFill* fill, int slot, Model* model);
+
+    // Call once a frame, before the scene is drawn and after its culling, which models not drawn
+    // are left out by. projectionScale is the viewport height in pixels times the projection's
+    // M[1][1] over two, the pixels a unit covers at unit distance.
+    void     Update(RenderDevice* ren, Scene& scene, const Vector3f& viewPos, float projectionScale);
+
+    // Call along with clearing the scene the streams were bound in.
+    void     Clear();
+
+private:
+    struct Binding
+    {
+        Ptr<ShaderFill>     Fill;
+        int                 Slot;
+    };
+
+    struct Stream
+    {
+        TextureImage        Image;          // Every mip, or only the top one for generated mips.
+        Ptr<File>           Source;         // Image.Data points into it when Storage is empty.
+        std::vector<std::vector<unsigned char> > Mips; // Mips 1 and on, for generated mips.
+        std::vector<size_t> LevelOffsets;   // Of each level in the chain, and its end.
+        int                 LevelCount;
+        int                 CoarsestMip;    // Always resident.
+        int                 ResidentMip;    // Finest mip of Current.
+        int                 WantedMip;      // For last frame's draws.
+        int                 PendingMip;     // Being read in for, or -1.
+        std::atomic<bool>   PendingReady;
+        size_t              ResidentBytes;
+        uint32_t            LastUsedFrame;
+        Ptr<Texture>        Current;
+        std::vector<Binding> Bindings;
+
+        Stream() : LevelCount(0), CoarsestMip(0), ResidentMip(0), WantedMip(0), PendingMip(-1),
+                   PendingReady(false), ResidentBytes(0), LastUsedFrame(0) { }
+
+        size_t GetBytes(int mip) const { return LevelOffsets[LevelCount] - LevelOffsets[mip]; }
+    };
+
+    int   mipForPixels(const Stream& stream, float pixels) const;
+    void  startPending(Stream& stream, int mip);
+    bool  makeRoom(RenderDevice* ren, Stream& stream, size_t bytes);
+    bool  setResidentMip(RenderDevice* ren, Stream& stream, int mip);
+
+    std::vector<std::unique_ptr<Stream> >       Streams;
+    std::unordered_map<Model*, std::vector<int> > ModelStreams;
+    size_t                                      Budget;
+    size_t                                      ResidentBytes;
+    size_t                                      FullBytes;
+    int                                         StartSize;
+    float                                       DetailScale;
+    int                                         MaxPending;
+    uint32_t                                    Frame;
+    TaskGroup                                   ReadGroup;      // Destroyed first; its tasks use Streams.
+};
+
+}} // namespace OVR::Render
+
+#endif // OVR_Render_TextureStreamer_h
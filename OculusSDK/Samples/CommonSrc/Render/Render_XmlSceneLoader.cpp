@@ -23,11 +23,25 @@ limitations under the License.
 
 #include "Render_XmlSceneLoader.h"
 #include "../Util/Logger.h"
+#include "Kernel/OVR_TaskScheduler.h"
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <math.h>
+#include <string.h>
+#include <memory>
+#include <thread>
+#include <unordered_map>
 
 namespace OVR { namespace Render {
 
 XmlHandler::XmlHandler() :
     pXmlDocument(NULL),
+    pTextureStreamer(NULL),
+    pAssetCache(NULL),
+    MergeStaticModels(false),
+    PackTextures(false),
     textureCount(0),
     modelCount(0),
     collisionModelCount(0),
@@ -41,6 +55,638 @@ XmlHandler::~XmlHandler()
     delete pXmlDocument;
 }
 
+//-------------------------------------------------------------------------------------
+// ***** Baked scenes
+//
+// A baked scene holds what ReadFile builds from one XML scene, so later loads can skip parsing it.
+// It's written next to the XML with the hash of the XML it came from, and is only used while
+// that still matches. Data is in the writing machine's byte order and layout, 4-byte aligned:
+//   BakedSceneHeader
+//   per texture:          uint32 name length, name
+//   per model:            BakedModelHeader, name, Vertex[VertexCount], uint32 indices[IndexCount],
+//                         then per level of detail BakedLodHeader, Vertex[], uint32 indices[]
+//   per collision model:  uint32 plane count, Planef[plane count], then likewise for ground ones
+
+static const uint32_t BakedSceneMagic   = 0x4b425653; // "SVBK"
+static const uint32_t BakedSceneVersion = 2;
+
+// Levels of detail baked for each drawn model, halving the triangles each time.
+static const int    BakedLodMaxLevels    = 3;
+static const size_t BakedLodMinTriangles = 256;
+
+struct BakedSceneHeader
+{
+    uint32_t    Magic;
+    uint32_t    Version;
+    uint64_t    SourceHash;
+    uint32_t    VertexSize;
+    uint32_t    TextureCount;
+    uint32_t    ModelCount;
+    uint32_t    CollisionModelCount;
+    uint32_t    GroundCollisionModelCount;
+    uint32_t    Reserved;
+};
+
+struct BakedModelHeader
+{
+    uint32_t    NameLength;
+    uint32_t    IsCollisionModel;
+    int32_t     DiffuseTexture;
+    int32_t     LightmapTexture;
+    uint32_t    VertexCount;
+    uint32_t    IndexCount;
+    uint32_t    LodCount;
+};
+
+struct BakedLodHeader
+{
+    uint32_t    VertexCount;
+    uint32_t    IndexCount;
+    float       Error;
+};
+
+// Reads a baked scene in place, failing on anything that runs past the end of the file.
+class BakedSceneReader
+{
+public:
+    BakedSceneReader(const uint8_t* data, size_t size) : Data(data), Size(size), Offset(0) { }
+
+    const void* Take(size_t count, size_t elementSize)
+    {
+        if (count > (Size - Offset) / elementSize)
+        {
+            return NULL;
+        }
+        const void* p = Data + Offset;
+        Offset = Alg::Min(Size, Offset + ((count * elementSize + 3) & ~size_t(3)));
+        return p;
+    }
+
+    template<class T>
+    bool Read(T& value)
+    {
+        const void* p = Take(1, sizeof(T));
+        if (!p)
+        {
+            return false;
+        }
+        memcpy(&value, p, sizeof(T));
+        return true;
+    }
+
+    bool ReadString(std::string& str)
+    {
+        uint32_t length = 0;
+        const char* chars = Read(length) ? (const char*)Take(length, 1) : NULL;
+        if (!chars)
+        {
+            return false;
+        }
+        str.assign(chars, length);
+        return true;
+    }
+
+private:
+    const uint8_t*  Data;
+    size_t          Size;
+    size_t          Offset;
+};
+
+class BakedSceneWriter
+{
+public:
+    void Write(const void* data, size_t size)
+    {
+        const uint8_t* bytes = (const uint8_t*)data;
+        Data.insert(Data.end(), bytes, bytes + size);
+        Data.resize((Data.size() + 3) & ~size_t(3), 0);
+    }
+
+    template<class T>
+    void Write(const T& value)
+    {
+        Write(&value, sizeof(T));
+    }
+
+    void WriteString(const std::string& str)
+    {
+        Write((uint32_t)str.size());
+        Write(str.data(), str.size());
+    }
+
+    std::vector<uint8_t> Data;
+};
+
+//-------------------------------------------------------------------------------------
+// ***** XmlPullReader
+//
+// Walks the elements of a scene file in place, without building a document. Next returns each
+// start tag, end tag and run of text in turn, as spans into the file, so the vertex text is
+// parsed where it lies rather than copied into nodes. It reads the XML the exporter writes:
+// elements, attributes, text, comments and the declaration. Anything else, such as entities,
+// CDATA or a DOCTYPE, is an error, and ReadFile parses those files as a document instead.
+
+class XmlPullReader
+{
+public:
+    enum Event
+    {
+        Event_Start,    // Also reported for empty elements, which are followed by an Event_End.
+        Event_End,
+        Event_Text,     // Whitespace between elements is skipped.
+        Event_Done,
+        Event_Error
+    };
+
+    XmlPullReader(const char* data, size_t size)
+      : P(data), End(data + size), NameBegin(NULL), NameEnd(NULL), TextBegin(NULL), TextEnd(NULL),
+        Depth(0), PendingEnd(false) { }
+
+    Event Next()
+    {
+        if (PendingEnd)
+        {
+            PendingEnd = false;
+            Depth--;
+            return Event_End;
+        }
+
+        while (P < End)
+        {
+            if (*P != '<')
+            {
+                const char* begin = P;
+                P = (const char*)memchr(P, '<', End - P);
+                if (!P)
+                {
+                    P = End;
+                }
+                if (!IsBlank(begin, P))
+                {
+                    TextBegin = begin;
+                    TextEnd   = P;
+                    return Event_Text;
+                }
+                continue;
+            }
+
+            if (StartsWith("<?"))
+            {
+                if (!SkipPast("?>"))
+                    return Event_Error;
+                continue;
+            }
+            if (StartsWith("<!--"))
+            {
+                if (!SkipPast("-->"))
+                    return Event_Error;
+                continue;
+            }
+            if (StartsWith("<!"))
+            {
+                return Event_Error;
+            }
+
+            if (StartsWith("</"))
+            {
+                P += 2;
+                if (!ReadName() || !SkipSpaces() || (*P != '>') || (Depth == 0))
+                {
+                    return Event_Error;
+                }
+                P++;
+                Depth--;
+                return Event_End;
+            }
+
+            P++;
+            return ReadStartTag() ? Event_Start : Event_Error;
+        }
+        return (Depth == 0) ? Event_Done : Event_Error;
+    }
+
+    // Of the last start or end tag.
+    bool IsName(const char* name) const
+    {
+        const size_t length = strlen(name);
+        return ((size_t)(NameEnd - NameBegin) == length) && (memcmp(NameBegin, name, length) == 0);
+    }
+
+    // Of the last start tag. Values run up to their closing quote.
+    const char* FindAttribute(const char* name, const char** valueEnd = NULL) const
+    {
+        const size_t length = strlen(name);
+        for (size_t i = 0; i < Attributes.size(); i++)
+        {
+            const Attribute& a = Attributes[i];
+            if (((size_t)(a.NameEnd - a.NameBegin) == length) && (memcmp(a.NameBegin, name, length) == 0))
+            {
+                if (valueEnd)
+                {
+                    *valueEnd = a.ValueEnd;
+                }
+                return a.ValueBegin;
+            }
+        }
+        return NULL;
+    }
+
+    bool AttributeIs(const char* name, const char* value) const
+    {
+        const char* valueEnd = NULL;
+        const char* found    = FindAttribute(name, &valueEnd);
+        const size_t length  = strlen(value);
+        return found && ((size_t)(valueEnd - found) == length) && (memcmp(found, value, length) == 0);
+    }
+
+    void QueryIntAttribute(const char* name, int* value) const
+    {
+        const char* found = FindAttribute(name);
+        if (found)
+        {
+            *value = atoi(found);
+        }
+    }
+
+    void QueryFloatAttribute(const char* name, float* value) const
+    {
+        const char* found = FindAttribute(name);
+        if (found)
+        {
+            *value = (float)atof(found);
+        }
+    }
+
+    void QueryBoolAttribute(const char* name, bool* value) const
+    {
+        const char* found = FindAttribute(name);
+        if (found)
+        {
+            *value = AttributeIs(name, "true") || (atoi(found) != 0);
+        }
+    }
+
+    // After a start tag, reads the element's text and its end tag. Empty elements give an empty span.
+    bool ReadText(const char** begin, const char** end)
+    {
+        *begin = *end = P;
+        Event event = Next();
+        if (event == Event_Text)
+        {
+            *begin = TextBegin;
+            *end   = TextEnd;
+            event  = Next();
+        }
+        return event == Event_End;
+    }
+
+    // After a start tag, skips everything up to and including its end tag.
+    bool SkipElement()
+    {
+        for (int depth = 1; depth > 0; )
+        {
+            const Event event = Next();
+            if (event == Event_Start)
+                depth++;
+            else if (event == Event_End)
+                depth--;
+            else if (event != Event_Text)
+                return false;
+        }
+        return true;
+    }
+
+private:
+    struct Attribute
+    {
+        const char* NameBegin;
+        const char* NameEnd;
+        const char* ValueBegin;
+        const char* ValueEnd;
+    };
+
+    static bool IsSpace(char c)
+    {
+        return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r');
+    }
+
+    static bool IsBlank(const char* begin, const char* end)
+    {
+        while ((begin < end) && IsSpace(*begin))
+        {
+            begin++;
+        }
+        return begin == end;
+    }
+
+    bool StartsWith(const char* prefix) const
+    {
+        const size_t length = strlen(prefix);
+        return ((size_t)(End - P) >= length) && (memcmp(P, prefix, length) == 0);
+    }
+
+    bool SkipPast(const char* terminator)
+    {
+        for (; P < End; P++)
+        {
+            if (StartsWith(terminator))
+            {
+                P += strlen(terminator);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Returns false at the end of the data, so callers can then read *P.
+    bool SkipSpaces()
+    {
+        while ((P < End) && IsSpace(*P))
+        {
+            P++;
+        }
+        return P < End;
+    }
+
+    bool ReadName()
+    {
+        NameBegin = P;
+        while ((P < End) && !IsSpace(*P) && (*P != '>') && (*P != '/') && (*P != '='))
+        {
+            P++;
+        }
+        NameEnd = P;
+        return (NameEnd != NameBegin) && (P < End);
+    }
+
+    bool ReadStartTag()
+    {
+        Attributes.clear();
+        if (!ReadName())
+        {
+            return false;
+        }
+        const char* elementBegin = NameBegin;
+        const char* elementEnd   = NameEnd;
+
+        for (;;)
+        {
+            if (!SkipSpaces())
+            {
+                return false;
+            }
+            if (*P == '>')
+            {
+                P++;
+                break;
+            }
+            if (*P == '/')
+            {
+                if ((End - P < 2) || (P[1] != '>'))
+                {
+                    return false;
+                }
+                P += 2;
+                PendingEnd = true;
+                break;
+            }
+
+            Attribute a;
+            if (!ReadName())
+            {
+                return false;
+            }
+            a.NameBegin = NameBegin;
+            a.NameEnd   = NameEnd;
+            if (!SkipSpaces() || (*P != '=') || (++P, !SkipSpaces()) || ((*P != '"') && (*P != '\'')))
+            {
+                return false;
+            }
+            const char quote = *P++;
+            a.ValueBegin = P;
+            P = (const char*)memchr(P, quote, End - P);
+            if (!P || memchr(a.ValueBegin, '&', P - a.ValueBegin))
+            {
+                return false;
+            }
+            a.ValueEnd = P++;
+            Attributes.push_back(a);
+        }
+
+        NameBegin = elementBegin;
+        NameEnd   = elementEnd;
+        Depth++;
+        return true;
+    }
+
+    const char*             P;
+    const char*             End;
+    const char*             NameBegin;
+    const char*             NameEnd;
+    const char*             TextBegin;
+    const char*             TextEnd;
+    std::vector<Attribute>  Attributes;     // Kept between tags, so it's only allocated once.
+    int                     Depth;
+    bool                    PendingEnd;
+};
+
+// Reads the collisionModel elements in a collisionModels or groundCollisionModels element.
+static bool StreamXmlCollisionModels(XmlPullReader& reader, std::vector<Ptr<CollisionModel> >& models, bool ground)
+{
+    XmlPullReader::Event event;
+    while ((event = reader.Next()) == XmlPullReader::Event_Start)
+    {
+        if (!reader.IsName("collisionModel"))
+        {
+            if (!reader.SkipElement())
+                return false;
+            continue;
+        }
+
+        Ptr<CollisionModel> cm = *new CollisionModel();
+        while ((event = reader.Next()) == XmlPullReader::Event_Start)
+        {
+            if (reader.IsName("plane"))
+            {
+                Vector3f norm;
+                float    D = 0.f;
+                reader.QueryFloatAttribute("nx", &norm.x);
+                reader.QueryFloatAttribute("ny", &norm.y);
+                reader.QueryFloatAttribute("nz", &norm.z);
+                reader.QueryFloatAttribute("d", &D);
+                if (!ground)
+                {
+                    D -= 0.5f;
+                    if (models.size() == 26)
+                        D += 0.5f;  // tighten the terrace collision so player can move right up to rail
+                }
+                cm->Add(Planef(norm.z, norm.y, norm.x * -1.0f, D));
+            }
+            if (!reader.SkipElement())
+            {
+                return false;
+            }
+        }
+        if (event != XmlPullReader::Event_End)
+        {
+            return false;
+        }
+        models.push_back(cm);
+    }
+    return event == XmlPullReader::Event_End;
+}
+
+bool XmlHandler::ParseXmlStream(const char* data, size_t size)
+{
+    XmlPullReader reader(data, size);
+    if ((reader.Next() != XmlPullReader::Event_Start) || !reader.IsName("scene"))
+    {
+        return false;
+    }
+
+    // Kept across models, so they're only allocated for the largest.
+    std::vector<Vector3f> vertices, normals, diffuseUVs, lightmapUVs;
+    std::vector<uint32_t> indices;
+    const char*           text;
+    const char*           textEnd;
+
+    XmlPullReader::Event event;
+    while ((event = reader.Next()) == XmlPullReader::Event_Start)
+    {
+        if (reader.IsName("textures"))
+        {
+            WriteLog("[XmlSceneLoader] Reading textures...");
+            while ((event = reader.Next()) == XmlPullReader::Event_Start)
+            {
+                const char* nameEnd = NULL;
+                const char* name    = reader.IsName("texture") ? reader.FindAttribute("fileName", &nameEnd) : NULL;
+                if (name)
+                {
+                    TextureNames.push_back(std::string(name, nameEnd));
+                }
+                if (!reader.SkipElement())
+                    return false;
+            }
+        }
+        else if (reader.IsName("models"))
+        {
+            int count = 0;
+            reader.QueryIntAttribute("count", &count);
+            WriteLog("[XmlSceneLoader] Loading models... %i models to load...", count);
+
+            while ((event = reader.Next()) == XmlPullReader::Event_Start)
+            {
+                if (!reader.IsName("model"))
+                {
+                    if (!reader.SkipElement())
+                        return false;
+                    continue;
+                }
+
+                if (Models.size() % 15 == 0)
+                {
+                    WriteLog("[XmlSceneLoader] %i models remaining...", count - (int)Models.size());
+                }
+
+                const char* nameEnd = NULL;
+                const char* name    = reader.FindAttribute("name", &nameEnd);
+                std::string modelName = name ? std::string(name, nameEnd) : std::string();
+                bool isCollisionModel = false;
+                reader.QueryBoolAttribute("isCollisionModel", &isCollisionModel);
+
+                int diffuseTextureIndex  = -1;
+                int lightmapTextureIndex = -1;
+                vertices.clear();
+                normals.clear();
+                diffuseUVs.clear();
+                lightmapUVs.clear();
+                indices.clear();
+
+                while ((event = reader.Next()) == XmlPullReader::Event_Start)
+                {
+                    bool ok = true;
+                    if (reader.IsName("vertices") || reader.IsName("normals") || reader.IsName("indices"))
+                    {
+                        const bool isIndices = reader.IsName("indices");
+                        std::vector<Vector3f>* array = reader.IsName("vertices") ? &vertices : &normals;
+                        ok = reader.ReadText(&text, &textEnd);
+                        if (ok && isIndices)
+                            ParseIndexString(text, textEnd, &indices);
+                        else if (ok)
+                            ParseVectorString(text, textEnd, array);
+                    }
+                    else if (reader.IsName("material"))
+                    {
+                        const bool diffuse  = reader.AttributeIs("name", "diffuse");
+                        const bool lightmap = !diffuse && reader.AttributeIs("name", "lightmap");
+                        while (ok && ((event = reader.Next()) == XmlPullReader::Event_Start))
+                        {
+                            if ((diffuse || lightmap) && reader.IsName("texture"))
+                            {
+                                int& index = diffuse ? diffuseTextureIndex : lightmapTextureIndex;
+                                reader.QueryIntAttribute("index", &index);
+                                ok = reader.ReadText(&text, &textEnd);
+                                if (ok && (index > -1))
+                                {
+                                    ParseVectorString(text, textEnd, diffuse ? &diffuseUVs : &lightmapUVs, true);
+                                }
+                            }
+                            else
+                            {
+                                ok = reader.SkipElement();
+                            }
+                        }
+                        ok = ok && (event == XmlPullReader::Event_End);
+                    }
+                    else
+                    {
+                        ok = reader.SkipElement();
+                    }
+                    if (!ok)
+                    {
+                        return false;
+                    }
+                }
+                if ((event != XmlPullReader::Event_End) ||
+                    (normals.size() < vertices.size()) ||
+                    ((diffuseTextureIndex > -1) && (diffuseUVs.size() < vertices.size())) ||
+                    ((diffuseTextureIndex > -1) && (lightmapTextureIndex > -1) && (lightmapUVs.size() < vertices.size())))
+                {
+                    return false;
+                }
+
+                AddModel(modelName.c_str(), isCollisionModel, vertices, normals,
+                         diffuseTextureIndex, diffuseUVs, lightmapTextureIndex, lightmapUVs, indices);
+            }
+            WriteLog("[XmlSceneLoader] Done.");
+        }
+        else if (reader.IsName("collisionModels"))
+        {
+            if (!StreamXmlCollisionModels(reader, CollisionModels, false))
+                return false;
+            continue;
+        }
+        else if (reader.IsName("groundCollisionModels"))
+        {
+            if (!StreamXmlCollisionModels(reader, GroundCollisionModels, true))
+                return false;
+            continue;
+        }
+        else
+        {
+            if (!reader.SkipElement())
+                return false;
+            continue;
+        }
+
+        if (event != XmlPullReader::Event_End)
+        {
+            return false;
+        }
+    }
+    return (event == XmlPullReader::Event_End) && (reader.Next() == XmlPullReader::Event_Done);
+}
+
 bool XmlHandler::ReadFile(const char* fileName, OVR::Render::RenderDevice* pRender,
                           OVR::Render::Scene* pScene,
                           std::vector<Ptr<CollisionModel> >* pCollisions,
@@ -48,16 +694,19 @@ bool XmlHandler::ReadFile(const char* fileName, OVR::Render::RenderDevice* pRend
                           bool srgbAware /*= false*/,
                           bool anisotropic /*= false*/,
                           OVR::Render::BuiltinGeometryShaders geomShader /*= GShader_Disabled*/,
-                          bool heavyAluAndEarlyZ /*= false*/)
+                          bool heavyAluAndEarlyZ /*= false*/,
+                          CollisionBVH* pCollisionTree /*= NULL*/,
+                          CollisionBVH* pGroundCollisionTree /*= NULL*/,
+                          const std::function<void(int loaded, int total)>& progress /*= nullptr*/)
 {
-    if(pXmlDocument->LoadFile(fileName) != 0)
+    MappedFile xmlFile(fileName);
+    if (!xmlFile.GetData())
     {
         return false;
     }
 
     // Extract the relative path to our working directory for loading textures
     filePath[0] = 0;
-    intptr_t pos = 0;
 	intptr_t len = strlen(fileName);
     for(intptr_t i = len; i > 0; i--)
     {
@@ -69,8 +718,373 @@ bool XmlHandler::ReadFile(const char* fileName, OVR::Render::RenderDevice* pRend
         }        
     }    
 
+    // Use the baked scene while it matches the XML, and bake it again whenever it doesn't. The hash
+    // changes whenever anything baked from the XML could.
+    const uint64_t sourceHash = AssetCache::HashContent(xmlFile.GetData(), (size_t)xmlFile.LGetLength());
+    const std::string bakedFileName = std::string(fileName) + ".baked";
+    const bool baked = ReadBakedFile(bakedFileName.c_str(), sourceHash);
+    if (baked)
+    {
+        WriteLog("[XmlSceneLoader] Using baked scene %s", bakedFileName.c_str());
+    }
+    // Otherwise walk the mapped file in place, and only build a document for files using more XML
+    // than the exporter writes.
+    const bool streamed = !baked && ParseXmlStream((const char*)xmlFile.GetData(), (size_t)xmlFile.LGetLength());
+    if (!baked && !streamed)
+    {
+        TextureNames.clear();
+        Models.clear();
+        ModelMaterials.clear();
+        CollisionModels.clear();
+        GroundCollisionModels.clear();
+        if (pXmlDocument->Parse((const char*)xmlFile.GetData(), (size_t)xmlFile.LGetLength()) != 0)
+        {
+            return false;
+        }
+    }
+    xmlFile.Close();
+
     // Load the textures
     WriteLog("[XmlSceneLoader] Loading textures...");
+    if (!baked && !streamed)
+    {
+        ParseXmlTextures();
+    }
+    int textureLoadFlags = 0;
+    textureLoadFlags |= srgbAware ? TextureLoad_SrgbAware : 0;
+    textureLoadFlags |= anisotropic ? TextureLoad_Anisotropic : 0;
+    LoadTextures(textureLoadFlags, pRender, progress);
+    WriteLog("[XmlSceneLoader] Done.\n");
+
+    // Load the models
+    if (!baked && !streamed)
+    {
+        ParseXmlModels();
+    }
+    // Bake what was read, with levels of detail for the drawn models, before the models are
+    // changed for drawing.
+    if (!baked)
+    {
+        if (!streamed)
+        {
+            ParseXmlCollisionModels();
+        }
+        for (size_t i = 0; i < Models.size(); i++)
+        {
+            Model* model = Models[i];
+            if (model->Visible && !model->IsCollisionModel && (model->GetPrimType() == Prim_Triangles))
+            {
+                model->GenerateLods(BakedLodMaxLevels, BakedLodMinTriangles);
+            }
+        }
+        WriteBakedFile(bakedFileName.c_str(), sourceHash);
+    }
+
+    TextureArrays.assign(Textures.size(), Ptr<Texture>());
+    TextureSlices.assign(Textures.size(), -1);
+    const bool packed = PackTextures && !heavyAluAndEarlyZ && packTextures(pRender);
+
+    // Models keeps what was read, and the scene gets the merged models.
+    std::vector<Ptr<Model> >   sceneModels;
+    std::vector<ModelMaterial> sceneMaterials;
+    if (MergeStaticModels)
+    {
+        mergeStaticModels(sceneModels, sceneMaterials, heavyAluAndEarlyZ);
+        WriteLog("[XmlSceneLoader] Merged %i models into %i", (int)Models.size(), (int)sceneModels.size());
+    }
+    else
+    {
+        sceneModels    = Models;
+        sceneMaterials = ModelMaterials;
+    }
+
+    if (pAssetCache)
+    {
+        // Packed models' vertices hold their slices, which later loads may pack differently.
+        const std::string cacheName = std::string(fileName) + (packed ? "|packed" : "") +
+                                      (MergeStaticModels ? "|merged" : "");
+        const uint64_t    cacheHash = packed ? sourceHash ^ AssetCache::HashContent(TextureSlices.data(),
+                                                                                    TextureSlices.size() * sizeof(int))
+                                             : sourceHash;
+        const int reused = pAssetCache->ReuseModelBuffers(cacheName.c_str(), cacheHash, sceneModels);
+        if (reused)
+        {
+            WriteLog("[XmlSceneLoader] Reusing the buffers of %i cached models", reused);
+        }
+        pAssetCache->AddModels(cacheName.c_str(), cacheHash, sceneModels);
+    }
+
+    // Models with the same textures share a fill, so draws sorted by fill group them.
+    std::map<MaterialDraw, Ptr<ShaderFill> > fills;
+    for(size_t i = 0; i < sceneModels.size(); ++i)
+    {
+        const int diffuseTextureIndex  = sceneMaterials[i].DiffuseTexture;
+        const int lightmapTextureIndex = sceneMaterials[i].LightmapTexture;
+
+        //set up the shader
+        const MaterialDraw draw   = getMaterialDraw(sceneMaterials[i], heavyAluAndEarlyZ);
+        Ptr<ShaderFill>&   shader = fills[draw];
+        if (!shader)
+        {
+            shader = *new ShaderFill(*pRender->CreateShaderSet());
+            shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Vertex, VShader_MVP));
+            if (geomShader != GShader_Disabled)
+            {
+                shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Geometry, geomShader));
+            }
+            shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Fragment, std::get<0>(draw)));
+            if (std::get<1>(draw))
+            {
+                shader->SetTexture(0, std::get<1>(draw));
+            }
+            if (std::get<2>(draw))
+            {
+                shader->SetTexture(1, std::get<2>(draw));
+            }
+        }
+        sceneModels[i]->Fill = shader;
+
+        if (pTextureStreamer)
+        {
+            if (diffuseTextureIndex > -1 && TextureStreams[diffuseTextureIndex] >= 0)
+                pTextureStreamer->AddBinding(TextureStreams[diffuseTextureIndex], shader, 0, sceneModels[i]);
+            if (diffuseTextureIndex > -1 && lightmapTextureIndex > -1 && TextureStreams[lightmapTextureIndex] >= 0)
+                pTextureStreamer->AddBinding(TextureStreams[lightmapTextureIndex], shader, 1, sceneModels[i]);
+        }
+
+        pScene->World.Add(sceneModels[i]);
+        pScene->Models.push_back(sceneModels[i]);
+    }
+
+    if (pCollisions)
+        pCollisions->insert(pCollisions->end(), CollisionModels.begin(), CollisionModels.end());
+    if (pGroundCollisions)
+        pGroundCollisions->insert(pGroundCollisions->end(), GroundCollisionModels.begin(), GroundCollisionModels.end());
+
+    // Build the hierarchies over everything loaded, so collision queries needn't test every model.
+    if (pCollisionTree && pCollisions)
+        pCollisionTree->Build(*pCollisions);
+    if (pGroundCollisionTree && pGroundCollisions)
+        pGroundCollisionTree->Build(*pGroundCollisions);
+	return true;
+}
+
+// Merged models stay small enough for culling to reject those out of view.
+static const float  MergedModelMaxExtent   = 32.0f;
+static const size_t MergedModelMaxVertices = 0x10000;   // Still 16-bit indices.
+
+void XmlHandler::mergeStaticModels(std::vector<Ptr<Model> >& models, std::vector<ModelMaterial>& materials,
+                                   bool heavyAluAndEarlyZ) const
+{
+    // Group the models by what they draw with, in the order each first appears. Collision models
+    // and others not drawn are kept as they are.
+    std::map<MaterialDraw, size_t>         groupOfDraw;
+    std::vector<std::vector<Ptr<Model> > > groups;
+    std::vector<size_t>                    groupMaterials;
+    for (size_t i = 0; i < Models.size(); i++)
+    {
+        Model* model = Models[i];
+        if (!model->Visible || model->IsCollisionModel || model->GetPrimType() != Prim_Triangles)
+        {
+            models.push_back(Models[i]);
+            materials.push_back(ModelMaterials[i]);
+            continue;
+        }
+
+        const MaterialDraw draw = getMaterialDraw(ModelMaterials[i], heavyAluAndEarlyZ);
+        auto group = groupOfDraw.insert(std::make_pair(draw, groups.size()));
+        if (group.second)
+        {
+            groups.resize(groups.size() + 1);
+            groupMaterials.push_back(i);
+        }
+        groups[group.first->second].push_back(Models[i]);
+    }
+
+    for (size_t g = 0; g < groups.size(); g++)
+    {
+        Model::MergeModels(groups[g], MergedModelMaxVertices, MergedModelMaxExtent, models);
+        materials.resize(models.size(), ModelMaterials[groupMaterials[g]]);
+    }
+}
+
+XmlHandler::MaterialDraw XmlHandler::getMaterialDraw(const ModelMaterial& material, bool heavyAluAndEarlyZ) const
+{
+    const int diffuse  = material.DiffuseTexture;
+    const int lightmap = material.LightmapTexture;
+    if (diffuse < 0)
+    {
+        return MaterialDraw(FShader_LitGouraud, NULL, NULL);
+    }
+
+    // Models with a packed texture have all of theirs packed.
+    const bool packed = TextureSlices[diffuse] >= 0;
+    Texture*   diffuseTexture = packed ? TextureArrays[diffuse] : Textures[diffuse];
+    if (lightmap < 0)
+    {
+        return MaterialDraw(packed ? FShader_TextureArray : FShader_Texture, diffuseTexture, NULL);
+    }
+    Texture* lightmapTexture = packed ? TextureArrays[lightmap] : Textures[lightmap];
+    const BuiltinFragmentShaders shader = packed ? FShader_MultiTextureArray :
+                                          heavyAluAndEarlyZ ? FShader_MultiTextureHeavyAluEarlyZ : FShader_MultiTexture;
+    return MaterialDraw(shader, diffuseTexture, lightmapTexture);
+}
+
+// Packed textures are small enough that their own texture changes dominate drawing them, and
+// the array shaders have four bits for each slice.
+static const int PackedTextureMaxSize   = 1024;
+static const int PackedTextureMaxSlices = 16;
+
+bool XmlHandler::packTextures(RenderDevice* pRender)
+{
+    // Scenes listing a file more than once have the one texture at each of its indices, which
+    // is packed by its first.
+    const int count = (int)Textures.size();
+    std::vector<int> firstIndex(count);
+    std::unordered_map<Texture*, int> indexOfTexture;
+    for (int i = 0; i < count; i++)
+    {
+        firstIndex[i] = Textures[i] ? indexOfTexture.insert(std::make_pair(Textures[i].GetPtr(), i)).first->second : i;
+    }
+
+    // Streamed textures are replaced as they stream, so only the others drawn with are packed.
+    std::vector<char> packable(count, 0);
+    for (size_t i = 0; i < ModelMaterials.size(); i++)
+    {
+        const int textures[2] = { ModelMaterials[i].DiffuseTexture, ModelMaterials[i].LightmapTexture };
+        for (int t = 0; t < 2 && textures[0] >= 0; t++)
+        {
+            const int index   = (textures[t] >= 0) ? firstIndex[textures[t]] : -1;
+            Texture*  texture = (index >= 0) ? Textures[index].GetPtr() : NULL;
+            if (texture && TextureStreams[index] < 0 && !(texture->GetFormat() & (Texture_Cubemap | Texture_Array)) &&
+                std::max(texture->GetWidth(), texture->GetHeight()) <= PackedTextureMaxSize)
+            {
+                packable[index] = 1;
+            }
+        }
+    }
+
+    // A model draws with either the array shaders or the others, so one with a texture that
+    // can't be packed keeps all of its textures out.
+    auto leaveOutMixed = [&]()
+    {
+        for (bool changed = true; changed; )
+        {
+            changed = false;
+            for (size_t i = 0; i < ModelMaterials.size(); i++)
+            {
+                const int diffuse  = ModelMaterials[i].DiffuseTexture;
+                const int lightmap = ModelMaterials[i].LightmapTexture;
+                if (diffuse < 0)
+                {
+                    continue;
+                }
+                const bool diffusePacked  = packable[firstIndex[diffuse]] != 0;
+                const bool lightmapPacked = (lightmap < 0) || packable[firstIndex[lightmap]];
+                if (diffusePacked != lightmapPacked)
+                {
+                    packable[firstIndex[diffuse]] = 0;
+                    if (lightmap >= 0)
+                    {
+                        packable[firstIndex[lightmap]] = 0;
+                    }
+                    changed = true;
+                }
+            }
+        }
+    };
+    leaveOutMixed();
+
+    // Textures sharing everything an array's slices must are packed together, in scene order.
+    std::map<std::tuple<uint64_t, int, int, int>, std::vector<int> > groups;
+    for (int i = 0; i < count; i++)
+    {
+        if (packable[i] && firstIndex[i] == i)
+        {
+            const Texture* texture = Textures[i];
+            groups[std::make_tuple(texture->GetFormat(), texture->GetWidth(), texture->GetHeight(),
+                                   TextureSampleModes[i])].push_back(i);
+        }
+    }
+
+    int arrayCount = 0;
+    for (auto group = groups.begin(); group != groups.end(); ++group)
+    {
+        const std::vector<int>& members    = group->second;
+        const int               sampleMode = std::get<3>(group->first);
+        for (size_t first = 0; first < members.size(); first += PackedTextureMaxSlices)
+        {
+            const size_t end = std::min(first + PackedTextureMaxSlices, members.size());
+            std::vector<Texture*> slices;
+            for (size_t m = first; m < end; m++)
+            {
+                slices.push_back(Textures[members[m]]);
+            }
+
+            // Those the device can't make arrays of, such as with differing mips, stay as they are.
+            Ptr<Texture> array;
+            Texture*     created = pRender->CreateTextureArray(slices);
+            if (created)
+            {
+                array.SetPtr(*created);
+                if (sampleMode != -1)
+                {
+                    array->SetSampleMode(sampleMode);
+                }
+                arrayCount++;
+            }
+            for (size_t m = first; m < end; m++)
+            {
+                if (array)
+                {
+                    TextureArrays[members[m]] = array;
+                    TextureSlices[members[m]] = (int)(m - first);
+                }
+                else
+                {
+                    packable[members[m]] = 0;
+                }
+            }
+        }
+    }
+
+    // Leaving those out can leave others that were packed mixed, which then draw unpacked.
+    leaveOutMixed();
+    int packedCount = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const int first = firstIndex[i];
+        TextureArrays[i] = packable[first] ? TextureArrays[first] : Ptr<Texture>();
+        TextureSlices[i] = packable[first] ? TextureSlices[first] : -1;
+        packedCount += (packable[i] && first == i) ? 1 : 0;
+    }
+    if (packedCount == 0)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < Models.size(); i++)
+    {
+        const int diffuse  = ModelMaterials[i].DiffuseTexture;
+        const int lightmap = ModelMaterials[i].LightmapTexture;
+        if (diffuse < 0 || TextureSlices[diffuse] < 0)
+        {
+            continue;
+        }
+        const uint8_t slices = (uint8_t)((TextureSlices[diffuse] << 4) | (lightmap >= 0 ? TextureSlices[lightmap] : 0));
+        std::vector<Vertex>& vertices = Models[i]->Vertices;
+        for (size_t v = 0; v < vertices.size(); v++)
+        {
+            vertices[v].C.A = slices;
+        }
+    }
+
+    WriteLog("[XmlSceneLoader] Packed %i textures into %i arrays", packedCount, arrayCount);
+    return true;
+}
+
+void XmlHandler::ParseXmlTextures()
+{
     XMLElement* pXmlTexture = pXmlDocument->FirstChildElement("scene")->FirstChildElement("textures");
     OVR_ASSERT(pXmlTexture);
     if (pXmlTexture)
@@ -79,53 +1093,163 @@ bool XmlHandler::ReadFile(const char* fileName, OVR::Render::RenderDevice* pRend
         pXmlTexture = pXmlTexture->FirstChildElement("texture");
     }
 
-    for(int i = 0; i < textureCount; ++i)
+    for(int i = 0; i < textureCount; ++i)
+    {
+        TextureNames.push_back(pXmlTexture->Attribute("fileName"));
+        pXmlTexture = pXmlTexture->NextSiblingElement("texture");
+    }
+}
+
+void XmlHandler::LoadTextures(int textureLoadFlags, RenderDevice* pRender,
+                              const std::function<void(int loaded, int total)>& progress)
+{
+    // Decoding only reads the files, so it runs on worker threads while this thread creates each
+    // texture as soon as its decode is done, in scene order so texture indices are unchanged.
+    struct PendingTexture
+    {
+        char                FileName[300];
+        bool                IsDDS;
+        Ptr<MappedFile>     File;
+        TextureImage        Image;
+        bool                Decoded;
+        uint64_t            ContentHash;
+        Ptr<Texture>        Cached;
+        int                 SameAs;     // Earlier texture of the same file, or -1.
+        std::atomic<bool>   Ready;
+
+        PendingTexture() : IsDDS(false), Decoded(false), ContentHash(0), SameAs(-1), Ready(false) { FileName[0] = 0; }
+    };
+
+    const int count = (int)TextureNames.size();
+    std::unique_ptr<PendingTexture[]> pending(new PendingTexture[count > 0 ? count : 1]);
+
+    std::unordered_map<std::string, int> firstOfName;
+    for(int i = 0; i < count; ++i)
     {
-        const char* textureName = pXmlTexture->Attribute("fileName");
+        const char* textureName = TextureNames[i].c_str();
 		intptr_t    dotpos = strcspn(textureName, ".");
-        char        fname[300];
+        char*       fname = pending[i].FileName;
 
-		if (pos == len)
-		{            
-            snprintf(fname, 300, "%s", textureName);
-		}
-		else
-		{
-            snprintf(fname, 300, "%s%s", filePath, textureName);
-		}
+        snprintf(fname, 300, "%s%s", filePath, textureName);
+        pending[i].IsDDS = (textureName[dotpos] != 0) &&
+                           (textureName[dotpos + 1] == 'd' || textureName[dotpos + 1] == 'D');
 
-        int textureLoadFlags = 0;
-        textureLoadFlags |= srgbAware ? TextureLoad_SrgbAware : 0;
-        textureLoadFlags |= anisotropic ? TextureLoad_Anisotropic : 0;
+        // Scenes listing a file more than once share the one texture.
+        auto first = firstOfName.insert(std::make_pair(TextureNames[i], i));
+        if (!first.second)
+        {
+            pending[i].SameAs = first.first->second;
+        }
+    }
 
-        SysFile* pFile = new SysFile(fname);
-		Ptr<Texture> texture;
-		if (textureName[dotpos + 1] == 'd' || textureName[dotpos + 1] == 'D')
-		{
-			// DDS file
-            Texture* tmp_ptr = LoadTextureDDSTopDown(pRender, pFile, textureLoadFlags);
-			if(tmp_ptr)
-			{
-				texture.SetPtr(*tmp_ptr);
-			}
-		}
-		else
-		{
-            Texture* tmp_ptr = LoadTextureTgaTopDown(pRender, pFile, textureLoadFlags, 255);
+    // Streamed textures need their images, so are only looked up in the cache without a streamer.
+    AssetCache* cache       = pAssetCache;
+    const bool  lookupCache = cache && !pTextureStreamer;
+
+    TaskGroup decodeGroup;
+    for(int i = 0; i < count; ++i)
+    {
+        PendingTexture* texture = &pending[i];
+        if (texture->SameAs >= 0)
+        {
+            continue;
+        }
+        decodeGroup.Run([texture, textureLoadFlags, cache, lookupCache]()
+        {
+            texture->File = *new MappedFile(texture->FileName);
+            if (cache && texture->File->GetData())
+            {
+                texture->ContentHash = AssetCache::HashContent(texture->File->GetData(),
+                                                               (size_t)texture->File->LGetLength());
+                if (lookupCache)
+                {
+                    texture->Cached = cache->FindTexture(texture->FileName, textureLoadFlags, texture->ContentHash,
+                                                         &texture->Image.SampleMode);
+                }
+            }
+            if (texture->Cached)
+            {
+                texture->Ready.store(true, std::memory_order_release);
+                return;
+            }
+            texture->Decoded = texture->IsDDS ?
+                DecodeTextureDDS(texture->File, textureLoadFlags, texture->Image) :
+                DecodeTextureTga(texture->File, textureLoadFlags, 255, false, texture->Image);
+            texture->Ready.store(true, std::memory_order_release);
+        });
+    }
+
+    for(int i = 0; i < count; ++i)
+    {
+        PendingTexture& texture = pending[i];
+        if (texture.SameAs >= 0)
+        {
+            Textures.push_back(Textures[texture.SameAs]);
+            TextureStreams.push_back(TextureStreams[texture.SameAs]);
+            TextureSampleModes.push_back(TextureSampleModes[texture.SameAs]);
+            if (progress)
+            {
+                progress(i + 1, count);
+            }
+            continue;
+        }
+        while (!texture.Ready.load(std::memory_order_acquire))
+        {
+            if (progress)
+            {
+                progress(i, count);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+		Ptr<Texture> tex = texture.Cached;
+        int          stream = -1;
+        if (texture.Decoded && pTextureStreamer)
+        {
+            stream = pTextureStreamer->AddTexture(pRender, texture.Image, texture.File);
+            if (stream >= 0)
+            {
+                tex = pTextureStreamer->GetTexture(stream);
+            }
+        }
+        if (texture.Decoded && stream < 0)
+        {
+            Texture* tmp_ptr = CreateTextureFromImage(pRender, texture.Image);
 			if(tmp_ptr)
 			{
-				texture.SetPtr(*tmp_ptr);
+				tex.SetPtr(*tmp_ptr);
 			}
-		}
+            if (tex && cache)
+            {
+                cache->AddTexture(texture.FileName, textureLoadFlags, texture.ContentHash, tex,
+                                  AssetCache::GetImageBytes(texture.Image), texture.Image.SampleMode);
+            }
+        }
 
-        Textures.push_back(texture);
-        pFile->Close();
-        pFile->Release();
-        pXmlTexture = pXmlTexture->NextSiblingElement("texture");
+        Textures.push_back(tex);
+        TextureStreams.push_back(stream);
+        TextureSampleModes.push_back(texture.Image.SampleMode);
+
+        // DDS images may point into the mapped file, so only release it once the texture exists.
+        // The streamer holds on to it for the images it takes that point into it.
+        texture.Image.Storage.clear();
+        texture.Image.Storage.shrink_to_fit();
+        if (stream < 0)
+        {
+            texture.File->Close();
+        }
+        texture.File.Clear();
+
+        if (progress)
+        {
+            progress(i + 1, count);
+        }
     }
-    WriteLog("[XmlSceneLoader] Done.\n");
+    decodeGroup.Wait();
+}
 
-    // Load the models
+void XmlHandler::ParseXmlModels()
+{
 	pXmlDocument->FirstChildElement("scene")->FirstChildElement("models")->
 		          QueryIntAttribute("count", &modelCount);
 	
@@ -139,45 +1263,22 @@ bool XmlHandler::ReadFile(const char* fileName, OVR::Render::RenderDevice* pRend
             WriteLog("[XmlSceneLoader] %i models remaining...", modelCount - i);
 		}
         const char* name = pXmlModel->Attribute("name");
-        Models.push_back(*new Model(Prim_Triangles, name));
         bool isCollisionModel = false;
         pXmlModel->QueryBoolAttribute("isCollisionModel", &isCollisionModel);
-        Models[i]->IsCollisionModel = isCollisionModel;
-		if (isCollisionModel)
-		{
-			Models[i]->Visible = false;
-		}
-
-        bool tree_c = (strcmp(name, "tree_C") == 0) || (strcmp(name, "Object03") == 0);
 
         //read the vertices
-        std::vector<Vector3f> *vertices = new std::vector<Vector3f>();
+        std::vector<Vector3f> vertices;
         ParseVectorString(pXmlModel->FirstChildElement("vertices")->FirstChild()->
-			              ToText()->Value(), vertices);
-
-		for (size_t vertexIndex = 0; vertexIndex < vertices->size(); ++vertexIndex)
-		{
-			vertices->at(vertexIndex).x *= -1.0f;
-
-            if (tree_c)
-            {   // Move the terrace tree closer to the house
-                vertices->at(vertexIndex).z += 0.5;
-            }
-		}
+			              ToText()->Value(), &vertices);
 
         //read the normals
-        std::vector<Vector3f> *normals = new std::vector<Vector3f>();
+        std::vector<Vector3f> normals;
         ParseVectorString(pXmlModel->FirstChildElement("normals")->FirstChild()->
-			              ToText()->Value(), normals);
-
-		for (size_t normalIndex = 0; normalIndex < normals->size(); ++normalIndex)
-		{
-			normals->at(normalIndex).z *= -1.0f;
-		}
+			              ToText()->Value(), &normals);
 
         //read the textures
-        std::vector<Vector3f> *diffuseUVs = new std::vector<Vector3f>();
-        std::vector<Vector3f> *lightmapUVs = new std::vector<Vector3f>();
+        std::vector<Vector3f> diffuseUVs;
+        std::vector<Vector3f> lightmapUVs;
         int         diffuseTextureIndex = -1;
         int         lightmapTextureIndex = -1;
         XMLElement* pXmlCurMaterial = pXmlModel->FirstChildElement("material");
@@ -191,7 +1292,7 @@ bool XmlHandler::ReadFile(const char* fileName, OVR::Render::RenderDevice* pRend
                 if(diffuseTextureIndex > -1)
                 {
                     ParseVectorString(pXmlCurMaterial->FirstChildElement("texture")->
-						              FirstChild()->ToText()->Value(), diffuseUVs, true);
+						              FirstChild()->ToText()->Value(), &diffuseUVs, true);
                 }
             }
             else if(pXmlCurMaterial->Attribute("name", "lightmap"))
@@ -204,120 +1305,102 @@ bool XmlHandler::ReadFile(const char* fileName, OVR::Render::RenderDevice* pRend
                     XMLNode* firstChild = firstChildElement->FirstChild();
                     XMLText* text = firstChild->ToText();
                     const char* value = text->Value();
-                    ParseVectorString(value, lightmapUVs, true);
+                    ParseVectorString(value, &lightmapUVs, true);
                 }
             }
 
             pXmlCurMaterial = pXmlCurMaterial->NextSiblingElement("material");
         }
 
-        //set up the shader
-        Ptr<ShaderFill> shader = *new ShaderFill(*pRender->CreateShaderSet());
-        shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Vertex, VShader_MVP));
-        if (geomShader != GShader_Disabled)
-        {
-            shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Geometry, geomShader));
+        // Read the vertex indices for the triangles
+        const char* indexStr = pXmlModel->FirstChildElement("indices")->
+                                          FirstChild()->ToText()->Value();
+        std::vector<uint32_t> indices;
+        ParseIndexString(indexStr, &indices);
+
+        AddModel(name, isCollisionModel, vertices, normals,
+                 diffuseTextureIndex, diffuseUVs, lightmapTextureIndex, lightmapUVs, indices);
+
+        pXmlModel = pXmlModel->NextSiblingElement("model");
+    }
+    WriteLog("[XmlSceneLoader] Done.");
+}
+
+void XmlHandler::AddModel(const char* name, bool isCollisionModel,
+                          std::vector<Vector3f>& vertices, std::vector<Vector3f>& normals,
+                          int diffuseTextureIndex, std::vector<Vector3f>& diffuseUVs,
+                          int lightmapTextureIndex, std::vector<Vector3f>& lightmapUVs,
+                          std::vector<uint32_t>& indices)
+{
+    Ptr<Model> model = *new Model(Prim_Triangles, name);
+    model->IsCollisionModel = isCollisionModel;
+	if (isCollisionModel)
+	{
+		model->Visible = false;
+	}
+
+    bool tree_c = (strcmp(name, "tree_C") == 0) || (strcmp(name, "Object03") == 0);
+
+	for (size_t vertexIndex = 0; vertexIndex < vertices.size(); ++vertexIndex)
+	{
+		vertices.at(vertexIndex).x *= -1.0f;
+
+        if (tree_c)
+        {   // Move the terrace tree closer to the house
+            vertices.at(vertexIndex).z += 0.5;
         }
+	}
+
+	for (size_t normalIndex = 0; normalIndex < normals.size(); ++normalIndex)
+	{
+		normals.at(normalIndex).z *= -1.0f;
+	}
+
+    ModelMaterial material = { name, diffuseTextureIndex, lightmapTextureIndex };
+    ModelMaterials.push_back(material);
+
+    //add all the vertices to the model
+    const size_t numVerts = vertices.size();
+    model->Vertices.reserve(numVerts);
+    for(size_t v = 0; v < numVerts; ++v)
+    {
         if(diffuseTextureIndex > -1)
         {
-            shader->SetTexture(0, Textures[diffuseTextureIndex]);
             if(lightmapTextureIndex > -1)
             {
-                if (!heavyAluAndEarlyZ)
-                {
-                    shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Fragment, FShader_MultiTexture));
-                }
-                else
-                {
-                    shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Fragment, FShader_MultiTextureHeavyAluEarlyZ));
-                }
-                shader->SetTexture(1, Textures[lightmapTextureIndex]);
+                model->AddVertex(vertices.at(v).z, vertices.at(v).y, vertices.at(v).x, Color(255, 255, 255),
+                                 diffuseUVs.at(v).x, diffuseUVs.at(v).y, lightmapUVs.at(v).x, lightmapUVs.at(v).y,
+                                 normals.at(v).x, normals.at(v).y, normals.at(v).z);
             }
             else
             {
-                shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Fragment, FShader_Texture));
+                model->AddVertex(vertices.at(v).z, vertices.at(v).y, vertices.at(v).x, Color(255, 255, 255),
+                                 diffuseUVs.at(v).x, diffuseUVs.at(v).y, 0, 0,
+                                 normals.at(v).x, normals.at(v).y, normals.at(v).z);
             }
         }
         else
         {
-            shader->GetShaders()->SetShader(pRender->LoadBuiltinShader(Shader_Fragment, FShader_LitGouraud));
-        }
-        Models[i]->Fill = shader;
-
-        //add all the vertices to the model
-        const size_t numVerts = vertices->size();
-        for(size_t v = 0; v < numVerts; ++v)
-        {
-            if(diffuseTextureIndex > -1)
-            {
-                if(lightmapTextureIndex > -1)
-                {
-                    Models[i]->AddVertex(vertices->at(v).z, vertices->at(v).y, vertices->at(v).x, Color(255, 255, 255),
-                                          diffuseUVs->at(v).x, diffuseUVs->at(v).y, lightmapUVs->at(v).x, lightmapUVs->at(v).y,
-                                          normals->at(v).x, normals->at(v).y, normals->at(v).z);
-                }
-                else
-                {
-                    Models[i]->AddVertex(vertices->at(v).z, vertices->at(v).y, vertices->at(v).x, Color(255, 255, 255),
-                                          diffuseUVs->at(v).x, diffuseUVs->at(v).y, 0, 0,
-                                          normals->at(v).x, normals->at(v).y, normals->at(v).z);
-                }
-            }
-            else
-            {
-                Models[i]->AddVertex(vertices->at(v).z, vertices->at(v).y, vertices->at(v).x, Color(255, 255, 255, 255),
-                                      0, 0, 0, 0,
-                                      normals->at(v).x, normals->at(v).y, normals->at(v).z);
-            }
-        }
-
-        // Read the vertex indices for the triangles
-        const char* indexStr = pXmlModel->FirstChildElement("indices")->
-                                          FirstChild()->ToText()->Value();
-        
-        size_t stringLength = strlen(indexStr);
-
-        for(size_t j = 0; j < stringLength; )
-        {
-            size_t k = j + 1;
-            for(; k < stringLength; ++k)
-            {
-                if (indexStr[k] == ' ')
-                    break;                
-            }
-            char text[20];
-            for(size_t l = 0; l < k - j; ++l)
-            {
-                text[l] = indexStr[j + l];
-            }
-            text[k - j] = '\0';
-
-            Models[i]->Indices.push_back((unsigned short)atoi(text));
-            j = k + 1;
-        }
-
-        // Reverse index order to match original expected orientation
-        std::vector<uint16_t>& indices    = Models[i]->Indices;
-        size_t         indexCount = indices.size();         
-
-        for (size_t revIndex = 0; revIndex < indexCount/2; revIndex++)
-        {
-            unsigned short itemp               = indices[revIndex];
-            indices[revIndex]                  = indices[indexCount - revIndex - 1];
-            indices[indexCount - revIndex - 1] = itemp;            
+            model->AddVertex(vertices.at(v).z, vertices.at(v).y, vertices.at(v).x, Color(255, 255, 255, 255),
+                             0, 0, 0, 0,
+                             normals.at(v).x, normals.at(v).y, normals.at(v).z);
         }
+    }
 
-        delete vertices;
-        delete normals;
-        delete diffuseUVs;
-        delete lightmapUVs;
+    // Reverse index order to match original expected orientation
+    model->Indices.assign(indices.rbegin(), indices.rend());
 
-        pScene->World.Add(Models[i]);
-        pScene->Models.push_back(Models[i]);
-        pXmlModel = pXmlModel->NextSiblingElement("model");
+    // Exported meshes are in authoring order, so reorder them for the vertex cache once here.
+    if (model->GetPrimType() == Prim_Triangles)
+    {
+        model->OptimizeVertexCache();
     }
-    WriteLog("[XmlSceneLoader] Done.");
 
+    Models.push_back(model);
+}
+
+void XmlHandler::ParseXmlCollisionModels()
+{
     //load the collision models
     WriteLog("[XmlSceneLoader] Loading collision models... ");
     XMLElement* pXmlCollisionModel = pXmlDocument->FirstChildElement("scene")->FirstChildElement("collisionModels");
@@ -355,8 +1438,7 @@ bool XmlHandler::ReadFile(const char* fileName, OVR::Render::RenderDevice* pRend
             pXmlPlane = pXmlPlane->NextSiblingElement("plane");
         }
 
-        if (pCollisions)
-        pCollisions->push_back(cm);
+        CollisionModels.push_back(cm);
         pXmlCollisionModel = pXmlCollisionModel->NextSiblingElement("collisionModel");
     }
     }
@@ -392,53 +1474,346 @@ bool XmlHandler::ReadFile(const char* fileName, OVR::Render::RenderDevice* pRend
             pXmlPlane = pXmlPlane->NextSiblingElement("plane");
         }
 
-        if (pGroundCollisions)
-        pGroundCollisions->push_back(cm);
+        GroundCollisionModels.push_back(cm);
         pXmlCollisionModel = pXmlCollisionModel->NextSiblingElement("collisionModel");
     }
     }
     WriteLog("[XmlSceneLoader] Done.");
-	return true;
 }
 
-void XmlHandler::ParseVectorString(const char* str, std::vector<OVR::Vector3f> *array,
-	                               bool is2element)
+bool XmlHandler::ReadBakedFile(const char* bakedFileName, uint64_t sourceHash)
 {
-    size_t stride = is2element ? 2 : 3;
-    size_t stringLength = strlen(str);
-    size_t element = 0;
-    float v[3];
+    MappedFile bakedFile(bakedFileName);
+    if (!bakedFile.GetData())
+    {
+        return false;
+    }
+
+    BakedSceneReader reader(bakedFile.GetData(), (size_t)bakedFile.LGetLength());
+    BakedSceneHeader header;
+    if (!reader.Read(header) || (header.Magic != BakedSceneMagic) || (header.Version != BakedSceneVersion) ||
+        (header.SourceHash != sourceHash) || (header.VertexSize != sizeof(Vertex)))
+    {
+        return false;
+    }
+
+    // Fill locals first, so a bad file leaves nothing behind for the XML path.
+    std::vector<std::string>            textureNames(header.TextureCount);
+    std::vector<Ptr<Model> >            models;
+    std::vector<ModelMaterial>          materials;
+    std::vector<Ptr<CollisionModel> >   collisionModels[2];
+
+    for (uint32_t i = 0; i < header.TextureCount; i++)
+    {
+        if (!reader.ReadString(textureNames[i]))
+        {
+            return false;
+        }
+    }
 
-    for(size_t j = 0; j < stringLength;)
+    for (uint32_t i = 0; i < header.ModelCount; i++)
     {
-        size_t k = j + 1;
-        for(; k < stringLength; ++k)
+        BakedModelHeader modelHeader;
+        if (!reader.Read(modelHeader))
+        {
+            return false;
+        }
+        const char*     name     = (const char*)reader.Take(modelHeader.NameLength, 1);
+        const Vertex*   vertices = name ? (const Vertex*)reader.Take(modelHeader.VertexCount, sizeof(Vertex)) : NULL;
+        const uint32_t* indices  = vertices ? (const uint32_t*)reader.Take(modelHeader.IndexCount, sizeof(uint32_t)) : NULL;
+        if (!indices ||
+            (modelHeader.DiffuseTexture >= (int32_t)header.TextureCount) ||
+            (modelHeader.LightmapTexture >= (int32_t)header.TextureCount))
+        {
+            return false;
+        }
+
+        ModelMaterial material = { std::string(name, modelHeader.NameLength),
+                                   modelHeader.DiffuseTexture, modelHeader.LightmapTexture };
+        Ptr<Model> model = *new Model(Prim_Triangles, material.Name.c_str());
+        model->IsCollisionModel = (modelHeader.IsCollisionModel != 0);
+        model->Visible = !model->IsCollisionModel;
+        model->Vertices.assign(vertices, vertices + modelHeader.VertexCount);
+        model->Indices.assign(indices, indices + modelHeader.IndexCount);
+
+        for (uint32_t lod = 0; lod < modelHeader.LodCount; lod++)
         {
-            if(str[k] == ' ')
+            BakedLodHeader lodHeader;
+            const Vertex*   lodVertices = reader.Read(lodHeader) ? (const Vertex*)reader.Take(lodHeader.VertexCount, sizeof(Vertex)) : NULL;
+            const uint32_t* lodIndices  = lodVertices ? (const uint32_t*)reader.Take(lodHeader.IndexCount, sizeof(uint32_t)) : NULL;
+            if (!lodIndices)
             {
-                break;
+                return false;
+            }
+            Ptr<Model> mesh = *new Model(Prim_Triangles, material.Name.c_str());
+            mesh->Visible = model->Visible;
+            mesh->Vertices.assign(lodVertices, lodVertices + lodHeader.VertexCount);
+            mesh->Indices.assign(lodIndices, lodIndices + lodHeader.IndexCount);
+            model->Lods.push_back(mesh);
+            model->LodErrors.push_back(lodHeader.Error);
+        }
+        models.push_back(model);
+        materials.push_back(material);
+    }
+
+    const uint32_t collisionCounts[2] = { header.CollisionModelCount, header.GroundCollisionModelCount };
+    for (int list = 0; list < 2; list++)
+    {
+        for (uint32_t i = 0; i < collisionCounts[list]; i++)
+        {
+            uint32_t planeCount = 0;
+            const Planef* planes = reader.Read(planeCount) ? (const Planef*)reader.Take(planeCount, sizeof(Planef)) : NULL;
+            if (!planes)
+            {
+                return false;
+            }
+            Ptr<CollisionModel> cm = *new CollisionModel();
+            for (uint32_t j = 0; j < planeCount; j++)
+            {
+                cm->Add(planes[j]);
+            }
+            collisionModels[list].push_back(cm);
+        }
+    }
+
+    TextureNames.swap(textureNames);
+    Models.swap(models);
+    ModelMaterials.swap(materials);
+    CollisionModels.swap(collisionModels[0]);
+    GroundCollisionModels.swap(collisionModels[1]);
+    return true;
+}
+
+void XmlHandler::WriteBakedFile(const char* bakedFileName, uint64_t sourceHash) const
+{
+    BakedSceneHeader header;
+    memset(&header, 0, sizeof(header));
+    header.Magic                     = BakedSceneMagic;
+    header.Version                   = BakedSceneVersion;
+    header.SourceHash                = sourceHash;
+    header.VertexSize                = sizeof(Vertex);
+    header.TextureCount              = (uint32_t)TextureNames.size();
+    header.ModelCount                = (uint32_t)Models.size();
+    header.CollisionModelCount       = (uint32_t)CollisionModels.size();
+    header.GroundCollisionModelCount = (uint32_t)GroundCollisionModels.size();
+
+    BakedSceneWriter writer;
+    writer.Write(header);
+
+    for (size_t i = 0; i < TextureNames.size(); i++)
+    {
+        writer.WriteString(TextureNames[i]);
+    }
+
+    for (size_t i = 0; i < Models.size(); i++)
+    {
+        const Model*         model    = Models[i];
+        const ModelMaterial& material = ModelMaterials[i];
+
+        BakedModelHeader modelHeader;
+        modelHeader.NameLength       = (uint32_t)material.Name.size();
+        modelHeader.IsCollisionModel = model->IsCollisionModel ? 1 : 0;
+        modelHeader.DiffuseTexture   = material.DiffuseTexture;
+        modelHeader.LightmapTexture  = material.LightmapTexture;
+        modelHeader.VertexCount      = (uint32_t)model->Vertices.size();
+        modelHeader.IndexCount       = (uint32_t)model->Indices.size();
+        modelHeader.LodCount         = (uint32_t)model->Lods.size();
+        writer.Write(modelHeader);
+        writer.Write(material.Name.data(), material.Name.size());
+        writer.Write(model->Vertices.data(), model->Vertices.size() * sizeof(Vertex));
+        writer.Write(model->Indices.data(), model->Indices.size() * sizeof(uint32_t));
+
+        for (size_t lod = 0; lod < model->Lods.size(); lod++)
+        {
+            const Model* mesh = model->Lods[lod];
+            BakedLodHeader lodHeader;
+            lodHeader.VertexCount = (uint32_t)mesh->Vertices.size();
+            lodHeader.IndexCount  = (uint32_t)mesh->Indices.size();
+            lodHeader.Error       = model->LodErrors[lod];
+            writer.Write(lodHeader);
+            writer.Write(mesh->Vertices.data(), mesh->Vertices.size() * sizeof(Vertex));
+            writer.Write(mesh->Indices.data(), mesh->Indices.size() * sizeof(uint32_t));
+        }
+    }
+
+    const std::vector<Ptr<CollisionModel> >* collisionModels[2] = { &CollisionModels, &GroundCollisionModels };
+    for (int list = 0; list < 2; list++)
+    {
+        for (size_t i = 0; i < collisionModels[list]->size(); i++)
+        {
+            const std::vector<Planef>& planes = (*collisionModels[list])[i]->Planes;
+            writer.Write((uint32_t)planes.size());
+            writer.Write(planes.data(), planes.size() * sizeof(Planef));
+        }
+    }
+
+    // A scene that can't be baked, say from a read-only directory, still loads from the XML.
+    SysFile bakedFile(bakedFileName, File::Open_Write | File::Open_Create | File::Open_Truncate);
+    if (!bakedFile.IsValid() ||
+        bakedFile.Write(writer.Data.data(), (int)writer.Data.size()) != (int)writer.Data.size())
+    {
+        WriteLog("[XmlSceneLoader] Couldn't write baked scene %s", bakedFileName);
+    }
+    bakedFile.Close();
+}
+
+//-------------------------------------------------------------------------------------
+// ***** Number lists
+//
+// Vertex data is stored as space separated numbers. These parse them in place; building a
+// string per number and calling atof was most of the time spent loading a scene.
+
+static inline bool IsListSpace(char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r');
+}
+
+static inline const char* SkipListSpaces(const char* p, const char* end)
+{
+    while ((p < end) && IsListSpace(*p))
+    {
+        p++;
+    }
+    return p;
+}
+
+static inline const char* SkipListNumber(const char* p, const char* end)
+{
+    while ((p < end) && !IsListSpace(*p))
+    {
+        p++;
+    }
+    return p;
+}
+
+static size_t CountListNumbers(const char* p, const char* end)
+{
+    size_t count = 0;
+    for (p = SkipListSpaces(p, end); p < end; p = SkipListSpaces(SkipListNumber(p, end), end))
+    {
+        count++;
+    }
+    return count;
+}
+
+// Parses a decimal number with optional sign, fraction and exponent, as the exporter writes
+// them. Up to 19 significant digits are kept, which is far more than a float holds.
+static float ParseListFloat(const char* p)
+{
+    static const double PowersOf10[] =
+    {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const uint64_t MaxMantissa = 1000000000000000000ULL;
+
+    bool negative = (*p == '-');
+    if (negative || (*p == '+'))
+    {
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int      exponent = 0;
+    for (; (*p >= '0') && (*p <= '9'); p++)
+    {
+        if (mantissa < MaxMantissa)
+            mantissa = mantissa * 10 + (*p - '0');
+        else
+            exponent++;
+    }
+    if (*p == '.')
+    {
+        for (p++; (*p >= '0') && (*p <= '9'); p++)
+        {
+            if (mantissa < MaxMantissa)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                exponent--;
             }
         }
-        char text[20];
-        for(size_t l = 0; l < k - j; ++l)
+    }
+    if ((*p == 'e') || (*p == 'E'))
+    {
+        p++;
+        bool negativeExponent = (*p == '-');
+        if (negativeExponent || (*p == '+'))
+        {
+            p++;
+        }
+        int e = 0;
+        for (; (*p >= '0') && (*p <= '9'); p++)
         {
-            text[l] = str[j + l];
+            if (e < 10000)
+                e = e * 10 + (*p - '0');
         }
-        text[k - j] = '\0';
-        v[element] = (float)atof(text);
+        exponent += negativeExponent ? -e : e;
+    }
+
+    double value = (double)mantissa;
+    if (mantissa != 0)
+    {
+        if ((exponent >= 0) && (exponent <= 22))
+            value *= PowersOf10[exponent];
+        else if ((exponent < 0) && (exponent >= -22))
+            value /= PowersOf10[-exponent];
+        else
+            value *= pow(10.0, (double)exponent);
+    }
+    return (float)(negative ? -value : value);
+}
+
+static uint32_t ParseListUInt(const char* p)
+{
+    uint32_t value = 0;
+    for (; (*p >= '0') && (*p <= '9'); p++)
+    {
+        value = value * 10 + (uint32_t)(*p - '0');
+    }
+    return value;
+}
+
+void XmlHandler::ParseVectorString(const char* str, std::vector<OVR::Vector3f> *array,
+	                               bool is2element)
+{
+    ParseVectorString(str, str + strlen(str), array, is2element);
+}
+
+void XmlHandler::ParseVectorString(const char* str, const char* end, std::vector<OVR::Vector3f> *array,
+                                   bool is2element)
+{
+    const size_t stride = is2element ? 2 : 3;
+
+    // Count the numbers first, so the array is only allocated once.
+    array->reserve(array->size() + CountListNumbers(str, end) / stride);
+
+    size_t element = 0;
+    float v[3] = { 0.0f, 0.0f, 0.0f };
+    for (const char* p = SkipListSpaces(str, end); p < end; p = SkipListSpaces(SkipListNumber(p, end), end))
+    {
+        v[element] = ParseListFloat(p);
 
-        if(element == (stride - 1))
+        if (++element == stride)
         {
             //we've got all the elements of our vertex, so store them
-            OVR::Vector3f vect;
-            vect.x = v[0];
-            vect.y = v[1];
-            vect.z = is2element ? 0.0f : v[2];
-            array->push_back(vect);
+            array->push_back(OVR::Vector3f(v[0], v[1], is2element ? 0.0f : v[2]));
+            element = 0;
         }
+    }
+}
+
+void XmlHandler::ParseIndexString(const char* str, std::vector<uint32_t> *array)
+{
+    ParseIndexString(str, str + strlen(str), array);
+}
+
+void XmlHandler::ParseIndexString(const char* str, const char* end, std::vector<uint32_t> *array)
+{
+    array->reserve(array->size() + CountListNumbers(str, end));
 
-        j = k + 1;
-        element = (element + 1) % stride;
+    for (const char* p = SkipListSpaces(str, end); p < end; p = SkipListSpaces(SkipListNumber(p, end), end))
+    {
+        array->push_back(ParseListUInt(p));
     }
 }
 
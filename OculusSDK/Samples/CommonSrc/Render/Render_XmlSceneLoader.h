@@ -25,8 +25,12 @@ limitations under the License.
 #define OVR_Render_XmlSceneLoader_h
 
 #include "Render_Device.h"
+#include "Render_TextureStreamer.h"
+#include "Render_AssetCache.h"
 #include "Kernel/OVR_SysFile.h"
 
+#include <tuple>
+
 using namespace OVR;
 using namespace OVR::Render;
 
@@ -42,6 +46,8 @@ public:
     XmlHandler();
     ~XmlHandler();
 
+    // Textures are decoded on worker threads. progress, if set, is called on the calling thread
+    // while they load, with the number of textures created so far.
     bool ReadFile(const char* fileName, OVR::Render::RenderDevice* pRender,
                   OVR::Render::Scene* pScene,
                   std::vector<Ptr<CollisionModel> >* pCollisions,
@@ -49,21 +55,93 @@ public:
                   bool srgbAware = false,
                   bool anisotropic = false,
                   OVR::Render::BuiltinGeometryShaders geomShader = GShader_Disabled,
-                  bool heavyAluAndEarlyZ = false);
+                  bool heavyAluAndEarlyZ = false,
+                  CollisionBVH* pCollisionTree = NULL,
+                  CollisionBVH* pGroundCollisionTree = NULL,
+                  const std::function<void(int loaded, int total)>& progress = nullptr);
+
+    // Textures that can be streamed are added to streamer by ReadFile, and bound through it.
+    void SetTextureStreamer(TextureStreamer* streamer) { pTextureStreamer = streamer; }
+
+    // ReadFile reuses the textures and model buffers in cache that match the files, and adds
+    // those it loads. Textures the streamer takes are left out of it.
+    void SetAssetCache(AssetCache* cache) { pAssetCache = cache; }
+
+    // Merges the visible models sharing textures into a few spatially compact models each, so
+    // that the scene takes fewer draws.
+    void SetMergeStaticModels(bool merge) { MergeStaticModels = merge; }
+
+    // Copies the small textures that share a format, size and sample mode into array textures,
+    // and has the models drawing with them pick their slices, so that models with different
+    // small textures share fills and can be merged.
+    void SetPackTextures(bool pack) { PackTextures = pack; }
 
 protected:
     void ParseVectorString(const char* str, std::vector<OVR::Vector3f> *array,
 		                   bool is2element = false);
+    void ParseVectorString(const char* str, const char* end, std::vector<OVR::Vector3f> *array,
+		                   bool is2element = false);
+    void ParseIndexString(const char* str, std::vector<uint32_t> *array);
+    void ParseIndexString(const char* str, const char* end, std::vector<uint32_t> *array);
 
 private:
-    tinyxml2::XMLDocument*     pXmlDocument;
-    char                       filePath[250];
-    int                        textureCount;
-    std::vector<Ptr<Texture> > Textures;
-    int                        modelCount;
-    std::vector<Ptr<Model> >   Models;
-    int                        collisionModelCount;
-    int                        groundCollisionModelCount;
+    struct ModelMaterial
+    {
+        std::string Name;
+        int         DiffuseTexture;
+        int         LightmapTexture;
+    };
+
+    // The fragment shader and diffuse and lightmap textures a material draws with.
+    typedef std::tuple<BuiltinFragmentShaders, Texture*, Texture*> MaterialDraw;
+
+    // Reads the whole scene from the file's text in place, without building a document. Fails on
+    // XML the exporter doesn't write, which ParseXmlTextures and the rest then read instead.
+    bool ParseXmlStream(const char* data, size_t size);
+    void ParseXmlTextures();
+    void ParseXmlModels();
+    void ParseXmlCollisionModels();
+    // Flips the parsed arrays into the scene's coordinates, and adds the model they describe.
+    void AddModel(const char* name, bool isCollisionModel,
+                  std::vector<OVR::Vector3f>& vertices, std::vector<OVR::Vector3f>& normals,
+                  int diffuseTextureIndex, std::vector<OVR::Vector3f>& diffuseUVs,
+                  int lightmapTextureIndex, std::vector<OVR::Vector3f>& lightmapUVs,
+                  std::vector<uint32_t>& indices);
+    // Appends Models, with those that can be merged merged, and their materials.
+    void mergeStaticModels(std::vector<Ptr<Model> >& models, std::vector<ModelMaterial>& materials,
+                           bool heavyAluAndEarlyZ) const;
+    // Fills in TextureArrays and TextureSlices, and writes the slices into the vertex color alpha
+    // of the models drawing with packed textures, which must all be packed. Returns false if
+    // nothing was packed.
+    bool packTextures(OVR::Render::RenderDevice* pRender);
+    MaterialDraw getMaterialDraw(const ModelMaterial& material, bool heavyAluAndEarlyZ) const;
+    void LoadTextures(int textureLoadFlags, OVR::Render::RenderDevice* pRender,
+                      const std::function<void(int loaded, int total)>& progress);
+
+    // The baked scene is written next to the XML as "<fileName>.baked".
+    bool ReadBakedFile(const char* bakedFileName, uint64_t sourceHash);
+    void WriteBakedFile(const char* bakedFileName, uint64_t sourceHash) const;
+
+    tinyxml2::XMLDocument*             pXmlDocument;
+    TextureStreamer*                   pTextureStreamer;
+    AssetCache*                        pAssetCache;
+    bool                               MergeStaticModels;
+    bool                               PackTextures;
+    char                               filePath[250];
+    int                                textureCount;
+    std::vector<std::string>           TextureNames;   // Relative to filePath.
+    std::vector<Ptr<Texture> >         Textures;
+    std::vector<int>                   TextureStreams; // Parallel to Textures, -1 if not streamed.
+    std::vector<int>                   TextureSampleModes; // Parallel to Textures.
+    std::vector<Ptr<Texture> >         TextureArrays;  // Parallel to Textures, what each was packed into.
+    std::vector<int>                   TextureSlices;  // Parallel to Textures, -1 if not packed.
+    int                                modelCount;
+    std::vector<Ptr<Model> >           Models;
+    std::vector<ModelMaterial>         ModelMaterials; // Parallel to Models.
+    int                                collisionModelCount;
+    int                                groundCollisionModelCount;
+    std::vector<Ptr<CollisionModel> >  CollisionModels;
+    std::vector<Ptr<CollisionModel> >  GroundCollisionModels;
 };
 
 }} // OVR::Render
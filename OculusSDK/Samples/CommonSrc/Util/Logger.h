@@ -28,6 +28,8 @@ limitations under the License.
 
 #include <stdio.h>
 
+#include "Kernel/OVR_Profiler.h"
+
 #define LOG_MODE_STRING " {DEBUG}   "
 
 template<typename... Args> void WriteLog(Args&&... args)
@@ -77,6 +79,9 @@ template<typename... Args> void WriteLog(Args&&... args)
         printf("\n");
     }
 
+    // and to the profile trace, if one is recording
+    OVR::ScopeProfiler::RecordMarker(printedBuffer);
+
     delete[] dynamicBuffer;
 }
 
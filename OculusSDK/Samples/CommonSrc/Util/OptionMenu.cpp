@@ -53,11 +53,11 @@ bool OptionShortcut::MatchKey(OVR::KeyCode key, bool shift) const
 
         if(Keys[i].ShiftUsage == ShortcutKey::Shift_Modify)
         {
-            pNotify->CallNotify(&shift);
+            Notify(&shift);
         }
         else
         {
-            pNotify->CallNotify();
+            Notify(NULL);
         }
         return true;
     }
@@ -70,9 +70,9 @@ bool OptionShortcut::MatchGamepadButton(uint32_t gamepadButtonMask) const
     {
         if (GamepadButtons[i] & gamepadButtonMask)
         {
-            if (pNotify != NULL)
+            if (Notify)
             {
-                pNotify->CallNotify();
+                Notify(NULL);
             }
             return true;
         }
@@ -200,7 +200,6 @@ OptionVar::OptionVar(const char* name, void* pvar, VarType type,
     this->pVar  = pvar;
     fFormat     = ((Type == Type_Trigger) && !formatFunction) ? FormatTrigger : formatFunction;
     fUpdate     = updateFunction;
-    pNotify     = 0;
     FormatString= 0;
 
     MaxFloat    = FLT_MAX;
@@ -214,8 +213,11 @@ OptionVar::OptionVar(const char* name, void* pvar, VarType type,
 
     SelectedIndex = 0;
 
-    ShortcutUp.pNotify = new FunctionNotifyContext<OptionVar, bool>(this, &OptionVar::NextValue);
-    ShortcutDown.pNotify = new FunctionNotifyContext<OptionVar, bool>(this, &OptionVar::PrevValue);
+    CachedValueBits = 0;
+    ValueDirty      = true;
+
+    ShortcutUp.Notify = [this](bool* shift) { NextValue(shift); };
+    ShortcutDown.Notify = [this](bool* shift) { PrevValue(shift); };
 }
 
 
@@ -230,7 +232,6 @@ OptionVar::OptionVar(const char* name, int32_t* pvar,
     this->pVar  = pvar;
     fFormat     = formatFunction ? formatFunction : FormatInt;
     fUpdate     = updateFunction;
-    pNotify     = 0;
     FormatString= formatString;
 
     MaxFloat    = FLT_MAX;
@@ -244,8 +245,11 @@ OptionVar::OptionVar(const char* name, int32_t* pvar,
 
     SelectedIndex = 0;
 
-    ShortcutUp.pNotify = new FunctionNotifyContext<OptionVar, bool>(this, &OptionVar::NextValue);
-    ShortcutDown.pNotify = new FunctionNotifyContext<OptionVar, bool>(this, &OptionVar::PrevValue);
+    CachedValueBits = 0;
+    ValueDirty      = true;
+
+    ShortcutUp.Notify = [this](bool* shift) { NextValue(shift); };
+    ShortcutDown.Notify = [this](bool* shift) { PrevValue(shift); };
 }
 
 // Float with range and step size.
@@ -260,7 +264,6 @@ OptionVar::OptionVar(const char* name, float* pvar,
     this->pVar  = pvar;
     fFormat     = formatFunction ? formatFunction : FormatFloat;
     fUpdate     = updateFunction;
-    pNotify     = 0;
     FormatString= formatString ? formatString : "%.3f";
 
     MinFloat    = minf;
@@ -274,14 +277,15 @@ OptionVar::OptionVar(const char* name, float* pvar,
 
     SelectedIndex = 0;
 
-    ShortcutUp.pNotify = new FunctionNotifyContext<OptionVar, bool>(this, &OptionVar::NextValue);
-    ShortcutDown.pNotify = new FunctionNotifyContext<OptionVar, bool>(this, &OptionVar::PrevValue);
+    CachedValueBits = 0;
+    ValueDirty      = true;
+
+    ShortcutUp.Notify = [this](bool* shift) { NextValue(shift); };
+    ShortcutDown.Notify = [this](bool* shift) { PrevValue(shift); };
 }
 
 OptionVar::~OptionVar()
 {
-    if (pNotify)
-        delete pNotify;
 }
 
 void OptionVar::NextValue(bool* pFastStep)
@@ -471,6 +475,7 @@ OptionVar& OptionVar::AddEnumValue(const char* displayName, int32_t value)
     entry.Name = displayName;
     entry.Value = value;
     EnumValues.push_back(entry);
+    ValueDirty = true;
     return *this;
 }
 
@@ -478,8 +483,43 @@ std::string OptionVar::GetValue()
 {
     if(fFormat == NULL)
         return std::string();
-    else
+
+    // The built-in formats show only the variable, so are redone when it's changed, through the
+    // menu or behind its back. Custom ones may show other state too, so are redone every time.
+    if (fFormat != FormatEnum && fFormat != FormatInt && fFormat != FormatFloat &&
+        fFormat != FormatBool && fFormat != FormatTrigger)
         return fFormat(this);
+
+    uint32_t valueBits = GetValueBits();
+    if (ValueDirty || valueBits != CachedValueBits)
+    {
+        CachedValue     = fFormat(this);
+        CachedValueBits = valueBits;
+        ValueDirty      = false;
+    }
+    return CachedValue;
+}
+
+uint32_t OptionVar::GetValueBits()
+{
+    uint32_t bits = 0;
+    if (pVar)
+    {
+        switch (Type)
+        {
+        case Type_Enum:
+        case Type_Int:
+        case Type_Float:
+            memcpy(&bits, pVar, sizeof(bits));
+            break;
+        case Type_Bool:
+            bits = *AsBool() ? 1 : 0;
+            break;
+        default:
+            break;
+        }
+    }
+    return bits;
 }
 
 uint32_t OptionVar::GetEnumIndex()
@@ -580,14 +620,14 @@ OptionSelectionMenu::OptionSelectionMenu(OptionSelectionMenu* parentMenu)
     RenderShortcutChangeMessages = true;
 
     // Setup handlers for menu navigation actions.
-    NavShortcuts[Nav_Up].pNotify = new FunctionNotifyContext<OptionSelectionMenu, bool>(this, &OptionSelectionMenu::HandleUp);
-    NavShortcuts[Nav_Down].pNotify = new FunctionNotifyContext<OptionSelectionMenu, bool>(this, &OptionSelectionMenu::HandleDown);
-    NavShortcuts[Nav_Left].pNotify = new FunctionNotifySimple<OptionSelectionMenu>(this, &OptionSelectionMenu::HandleLeft);
-    NavShortcuts[Nav_Right].pNotify = new FunctionNotifySimple<OptionSelectionMenu>(this, &OptionSelectionMenu::HandleRight);
-    NavShortcuts[Nav_Select].pNotify = new FunctionNotifySimple<OptionSelectionMenu>(this, &OptionSelectionMenu::HandleSelect);
-    NavShortcuts[Nav_Back].pNotify = new FunctionNotifySimple<OptionSelectionMenu>(this, &OptionSelectionMenu::HandleBack);
-    ToggleShortcut.pNotify = new FunctionNotifySimple<OptionSelectionMenu>(this, &OptionSelectionMenu::HandleMenuToggle);
-    ToggleSingleItemShortcut.pNotify = new FunctionNotifySimple<OptionSelectionMenu>(this, &OptionSelectionMenu::HandleSingleItemToggle);
+    NavShortcuts[Nav_Up].Notify = [this](bool* shift) { HandleUp(shift); };
+    NavShortcuts[Nav_Down].Notify = [this](bool* shift) { HandleDown(shift); };
+    NavShortcuts[Nav_Left].Notify = [this](bool*) { HandleLeft(); };
+    NavShortcuts[Nav_Right].Notify = [this](bool*) { HandleRight(); };
+    NavShortcuts[Nav_Select].Notify = [this](bool*) { HandleSelect(); };
+    NavShortcuts[Nav_Back].Notify = [this](bool*) { HandleBack(); };
+    ToggleShortcut.Notify = [this](bool*) { HandleMenuToggle(); };
+    ToggleSingleItemShortcut.Notify = [this](bool*) { HandleSingleItemToggle(); };
 
     // Bind keys and buttons to menu navigation actions.
     NavShortcuts[Nav_Up].AddShortcut(ShortcutKey(Key_Up, ShortcutKey::Shift_Modify));
@@ -761,17 +801,38 @@ Color ApplyGammaCurveAndBrightness(Color inColor, float gammaCurve, Vector3f bri
     return inColor;
 }
 
-Recti OptionSelectionMenu::Render(RenderDevice* prender, std::string title, float textSize, float centerX, float centerY)
+// Whether everything the layout was made from is the same, so that it needn't be made again.
+static bool SameLayoutInputs(const OptionSelectionMenu::MenuLayout& a, const OptionSelectionMenu::MenuLayout& b)
+{
+    return a.Kind == b.Kind && a.TextSize == b.TextSize &&
+           a.CenterX == b.CenterX && a.CenterY == b.CenterY &&
+           a.GammaCurve == b.GammaCurve && a.Brightness == b.Brightness &&
+           a.DisplayState == b.DisplayState && a.HighlightIndex == b.HighlightIndex &&
+           a.SelectionActive == b.SelectionActive && a.PopupBorder == b.PopupBorder &&
+           a.Title == b.Title && a.MenuItems == b.MenuItems && a.Values == b.Values &&
+           a.Popup == b.Popup;
+}
+
+void OptionSelectionMenu::collectLayoutInputs(std::string title, float textSize, float centerX, float centerY,
+                                              MenuLayout& layout)
 {
+    layout.TextSize   = textSize;
+    layout.CenterX    = centerX;
+    layout.CenterY    = centerY;
+    layout.GammaCurve = Menu_ColorGammaCurve;
+    layout.Brightness = Menu_Brightness;
+
     // If we are invisible, render shortcut notifications.
     // Both child and parent have visible == true even if only child is shown.
     if ( DisplayState == Display_None )
     {
-        if ( RenderShortcutChangeMessages )
+        if ( RenderShortcutChangeMessages && (ovr_GetTimeInSeconds() < PopupMessageTimeout) )
         {
-            return renderShortcutChangeMessage(prender, textSize, centerX, centerY);
+            layout.Kind        = MenuLayout::Kind_Popup;
+            layout.Popup       = PopupMessage;
+            layout.PopupBorder = PopupMessageBorder;
         }
-        return Recti ( 0, 0, 0, 0);
+        return;
     }
 
     title += Label;
@@ -782,9 +843,58 @@ Recti OptionSelectionMenu::Render(RenderDevice* prender, std::string title, floa
         if (title.size() > 0)
             title += " > ";
 
-        return GetSubmenu()->Render(prender, title, textSize, centerX, centerY);
+        GetSubmenu()->collectLayoutInputs(title, textSize, centerX, centerY, layout);
+        return;
     }
 
+    if ( title.length() == 0 )
+    {
+        title = "Main menu";
+    }
+
+    layout.Kind            = MenuLayout::Kind_Menu;
+    layout.Title           = title;
+    layout.DisplayState    = DisplayState;
+    layout.SelectionActive = SelectionActive;
+
+    if (DisplayState == Display_Menu)
+    {
+        layout.HighlightIndex = SelectedIndex;
+        for (size_t i = 0; i < Items.size(); i++)
+        {
+            if (i > 0)
+                layout.Values += "\n";
+            layout.Values += Items[i]->GetValue();
+        }
+
+        for (size_t i = 0; i < Items.size(); i++)
+        {
+            if (i > 0)
+                layout.MenuItems += "\n";
+            layout.MenuItems += Items[i]->GetLabel();
+        }
+    }
+    else
+    {
+        layout.Values = Items[SelectedIndex]->GetValue();
+        layout.MenuItems = Items[SelectedIndex]->GetLabel();
+    }
+}
+
+bool OptionSelectionMenu::UpdateLayout(RenderDevice* prender, std::string title, float textSize, float centerX, float centerY)
+{
+    MenuLayout layout;
+    collectLayoutInputs(title, textSize, centerX, centerY, layout);
+
+    if (Layout.Valid && SameLayoutInputs(layout, Layout))
+        return false;
+
+    Layout = layout;
+    Layout.Valid = true;
+
+    if (Layout.Kind != MenuLayout::Kind_Menu)
+        return true;
+
     Color focusColor(180, 80, 20, 210);
     Color pickedColor(120, 55, 10, 140);
     Color titleColor(0x18, 0x1A, 0x4D, 210);
@@ -793,12 +903,12 @@ Recti OptionSelectionMenu::Render(RenderDevice* prender, std::string title, floa
     Color textColor(255,255,0,210);
 
     // convert all colors to requested srgb space
-    focusColor          = ApplyGammaCurveAndBrightness(focusColor,           Menu_ColorGammaCurve, Menu_Brightness);
-    pickedColor         = ApplyGammaCurveAndBrightness(pickedColor,          Menu_ColorGammaCurve, Menu_Brightness);
-    titleColor          = ApplyGammaCurveAndBrightness(titleColor,           Menu_ColorGammaCurve, Menu_Brightness);
-    titleOutlineColor   = ApplyGammaCurveAndBrightness(titleOutlineColor,    Menu_ColorGammaCurve, Menu_Brightness);
-    blueRectColor       = ApplyGammaCurveAndBrightness(blueRectColor,        Menu_ColorGammaCurve, Menu_Brightness);
-    textColor           = ApplyGammaCurveAndBrightness(textColor,            Menu_ColorGammaCurve, Menu_Brightness);
+    Layout.FocusColor        = ApplyGammaCurveAndBrightness(focusColor,           Menu_ColorGammaCurve, Menu_Brightness);
+    Layout.PickedColor       = ApplyGammaCurveAndBrightness(pickedColor,          Menu_ColorGammaCurve, Menu_Brightness);
+    Layout.TitleColor        = ApplyGammaCurveAndBrightness(titleColor,           Menu_ColorGammaCurve, Menu_Brightness);
+    Layout.TitleOutlineColor = ApplyGammaCurveAndBrightness(titleOutlineColor,    Menu_ColorGammaCurve, Menu_Brightness);
+    Layout.BlueRectColor     = ApplyGammaCurveAndBrightness(blueRectColor,        Menu_ColorGammaCurve, Menu_Brightness);
+    Layout.TextColor         = ApplyGammaCurveAndBrightness(textColor,            Menu_ColorGammaCurve, Menu_Brightness);
 
     float    labelsSize[2]     = {0.0f, 0.0f};
     float    bufferSize[2]     = {0.0f, 0.0f};
@@ -811,43 +921,16 @@ Recti OptionSelectionMenu::Render(RenderDevice* prender, std::string title, floa
 
     prender->MeasureText(&DejaVu, "      ", textSize, bufferSize);
 
-    std::string values;
-    std::string menuItems;
-
-    int highlightIndex = 0;
-    if (DisplayState == Display_Menu)
-    {
-        highlightIndex = SelectedIndex;
-        for (size_t i = 0; i < Items.size(); i++)
-        {
-            if (i > 0)
-                values += "\n";
-            values += Items[i]->GetValue();
-        }
-
-        for (size_t i = 0; i < Items.size(); i++)
-        {
-            if (i > 0)
-                menuItems += "\n";
-            menuItems += Items[i]->GetLabel();
-        }
-    }
-    else
-    {
-        values = Items[SelectedIndex]->GetValue();
-        menuItems = Items[SelectedIndex]->GetLabel();
-    }
-
     // Measure labels
-    const char* menuItemsCStr = menuItems.c_str();
-    bool havelLabelSelection = FindLineCharRange(menuItemsCStr, highlightIndex, selection);
+    const char* menuItemsCStr = Layout.MenuItems.c_str();
+    bool havelLabelSelection = FindLineCharRange(menuItemsCStr, Layout.HighlightIndex, selection);
 	OVR_UNUSED(havelLabelSelection);
     prender->MeasureText(&DejaVu, menuItemsCStr, textSize, labelsSize,
                          selection, labelSelectionRect);
 
     // Measure label-to-value gap
-    const char* valuesCStr = values.c_str();
-    bool haveValueSelection = FindLineCharRange(valuesCStr, highlightIndex, selection);
+    const char* valuesCStr = Layout.Values.c_str();
+    bool haveValueSelection = FindLineCharRange(valuesCStr, Layout.HighlightIndex, selection);
 	OVR_UNUSED(haveValueSelection);
     prender->MeasureText(&DejaVu, valuesCStr, textSize, valuesSize, selection, valueSelectionRect);
 
@@ -866,80 +949,109 @@ Recti OptionSelectionMenu::Render(RenderDevice* prender, std::string title, floa
     Vector2f bottomRight = topLeft + totalDimensions;
 
     // If displaying a single item, shift it down.
-    if (DisplayState == Display_SingleItem)
+    if (Layout.DisplayState == Display_SingleItem)
     {
         topLeft.y     += textSize * 7;
         bottomRight.y += textSize * 7;
     }
 
-    prender->FillRect(topLeft.x, topLeft.y, bottomRight.x, bottomRight.y, blueRectColor);
-    Recti bounds;
-    bounds.x = (int)floor(topLeft.x);
-    bounds.y = (int)floor(topLeft.y);
-    bounds.w = (int)ceil(totalDimensions.x);
-    bounds.h = (int)ceil(totalDimensions.y);
+    Layout.TopLeft = topLeft;
+    Layout.BottomRight = bottomRight;
+    Layout.Bounds.x = (int)floor(topLeft.x);
+    Layout.Bounds.y = (int)floor(topLeft.y);
+    Layout.Bounds.w = (int)ceil(totalDimensions.x);
+    Layout.Bounds.h = (int)ceil(totalDimensions.y);
 
-    Vector2f labelsPos = topLeft + borderSize;
-    Vector2f valuesPos = labelsPos + Vector2f(labelsSize[0], 0) + Vector2f(bufferSize[0], 0);
+    Layout.LabelsPos = topLeft + borderSize;
+    Layout.ValuesPos = Layout.LabelsPos + Vector2f(labelsSize[0], 0) + Vector2f(bufferSize[0], 0);
 
-    // Highlight selected label
+    // Selected label and value highlights
     Vector2f selectionInset = Vector2f(0.3f, 2.0f);
-    if (DisplayState == Display_Menu)
+    Layout.LabelSelection[0] = Layout.LabelsPos + labelSelectionRect[0] - selectionInset;
+    Layout.LabelSelection[1] = Layout.LabelsPos + labelSelectionRect[1] + selectionInset;
+    Layout.ValueSelection[0] = Layout.ValuesPos + valueSelectionRect[0] - selectionInset;
+    Layout.ValueSelection[1] = Layout.ValuesPos + valueSelectionRect[1] + selectionInset;
+
+    // Measure title
+    if (Layout.DisplayState == Display_Menu && Layout.Title.length() > 0)
     {
-        Vector2f labelSelectionTopLeft = labelsPos + labelSelectionRect[0] - selectionInset;
-        Vector2f labelSelectionBottomRight = labelsPos + labelSelectionRect[1] + selectionInset;
+        Vector2f titleDimensions;
+        prender->MeasureText(&DejaVu, Layout.Title.c_str(), textSize, &titleDimensions.x);
+        Vector2f titleTopLeft = topLeft - Vector2f(0, borderSize.y) * 2 - Vector2f(0, titleDimensions.y);
 
-        prender->FillRect(labelSelectionTopLeft.x, labelSelectionTopLeft.y,
-                          labelSelectionBottomRight.x, labelSelectionBottomRight.y,
-                          SelectionActive ? pickedColor : focusColor);
+        Layout.TitleOutline[0] = titleTopLeft;
+        Layout.TitleOutline[1] = Vector2f(titleTopLeft.x + totalDimensions.x,
+                                          titleTopLeft.y + titleDimensions.y + borderSize.y * 2);
+        Layout.TitleRect[0]    = titleTopLeft + borderSize / 2;
+        Layout.TitleRect[1]    = Vector2f(titleTopLeft.x + totalDimensions.x - borderSize.x / 2,
+                                          titleTopLeft.y + borderSize.y / 2 + titleDimensions.y);
+        Layout.TitlePos        = titleTopLeft + borderSize;
+
+        float extraHeight = topLeft.y - titleTopLeft.y;
+        Layout.Bounds.y -= (int)ceil(extraHeight);
+        Layout.Bounds.h += (int)ceil(extraHeight);
     }
 
-    // Highlight selected value if active
-    if (SelectionActive)
+    return true;
+}
+
+Recti OptionSelectionMenu::Render(RenderDevice* prender, std::string title, float textSize, float centerX, float centerY)
+{
+    UpdateLayout(prender, title, textSize, centerX, centerY);
+
+    if (Layout.Kind == MenuLayout::Kind_Popup)
+    {
+        return DrawTextBox(prender, centerX, centerY + 120.0f, textSize, Layout.Popup.c_str(),
+                           DrawText_Center | (Layout.PopupBorder ? DrawText_Border : 0));
+    }
+    if (Layout.Kind != MenuLayout::Kind_Menu)
     {
-        Vector2f valueSelectionTopLeft = valuesPos + valueSelectionRect[0] - selectionInset;
-        Vector2f valueSelectionBottomRight = valuesPos + valueSelectionRect[1] + selectionInset;
-        prender->FillRect(valueSelectionTopLeft.x, valueSelectionTopLeft.y,
-                          valueSelectionBottomRight.x, valueSelectionBottomRight.y,
-                          focusColor);
+        return Recti ( 0, 0, 0, 0);
     }
 
-    // Measure and draw title
-    if ( title.length() == 0 )
+    prender->FillRect(Layout.TopLeft.x, Layout.TopLeft.y, Layout.BottomRight.x, Layout.BottomRight.y,
+                      Layout.BlueRectColor);
+
+    // Highlight selected label
+    if (Layout.DisplayState == Display_Menu)
     {
-        title = "Main menu";
+        prender->FillRect(Layout.LabelSelection[0].x, Layout.LabelSelection[0].y,
+                          Layout.LabelSelection[1].x, Layout.LabelSelection[1].y,
+                          Layout.SelectionActive ? Layout.PickedColor : Layout.FocusColor);
     }
-    if (DisplayState == Display_Menu && title.length() > 0)
+
+    // Highlight selected value if active
+    if (Layout.SelectionActive)
     {
-        Vector2f titleDimensions;
-        prender->MeasureText(&DejaVu, title.c_str(), textSize, &titleDimensions.x);
-        Vector2f titleTopLeft = topLeft - Vector2f(0, borderSize.y) * 2 - Vector2f(0, titleDimensions.y);
-        titleDimensions.x = totalDimensions.x;
-        
-        prender->FillRect(titleTopLeft.x, titleTopLeft.y,
-                          titleTopLeft.x + totalDimensions.x,
-                          titleTopLeft.y + titleDimensions.y + borderSize.y * 2,
-                          titleOutlineColor);
-        
-        prender->FillRect(titleTopLeft.x + borderSize.x / 2, titleTopLeft.y + borderSize.y / 2,
-                          titleTopLeft.x + totalDimensions.x - borderSize.x / 2,
-                          titleTopLeft.y + borderSize.y / 2 + titleDimensions.y,
-                          titleColor);
-                          
-        prender->RenderText(&DejaVu, title.c_str(), titleTopLeft.x + borderSize.x,
-                            titleTopLeft.y + borderSize.y, textSize, textColor);
+        prender->FillRect(Layout.ValueSelection[0].x, Layout.ValueSelection[0].y,
+                          Layout.ValueSelection[1].x, Layout.ValueSelection[1].y,
+                          Layout.FocusColor);
+    }
 
+    // The title, labels and values go out as one draw.
+    prender->BeginTextBatch();
 
-        float extraHeight = topLeft.y - titleTopLeft.y;
-        bounds.y -= (int)ceil(extraHeight);
-        bounds.h += (int)ceil(extraHeight);
+    if (Layout.DisplayState == Display_Menu && Layout.Title.length() > 0)
+    {
+        prender->FillRect(Layout.TitleOutline[0].x, Layout.TitleOutline[0].y,
+                          Layout.TitleOutline[1].x, Layout.TitleOutline[1].y,
+                          Layout.TitleOutlineColor);
+        
+        prender->FillRect(Layout.TitleRect[0].x, Layout.TitleRect[0].y,
+                          Layout.TitleRect[1].x, Layout.TitleRect[1].y,
+                          Layout.TitleColor);
+                          
+        prender->RenderText(&DejaVu, Layout.Title.c_str(), Layout.TitlePos.x, Layout.TitlePos.y,
+                            textSize, Layout.TextColor);
     }
 
-    prender->RenderText(&DejaVu, menuItemsCStr, labelsPos.x, labelsPos.y, textSize, textColor);
+    prender->RenderText(&DejaVu, Layout.MenuItems.c_str(), Layout.LabelsPos.x, Layout.LabelsPos.y, textSize, Layout.TextColor);
 
-    prender->RenderText(&DejaVu, valuesCStr, valuesPos.x, valuesPos.y, textSize, textColor);
+    prender->RenderText(&DejaVu, Layout.Values.c_str(), Layout.ValuesPos.x, Layout.ValuesPos.y, textSize, Layout.TextColor);
 
-    return bounds;
+    prender->EndTextBatch();
+
+    return Layout.Bounds;
 }
 
 
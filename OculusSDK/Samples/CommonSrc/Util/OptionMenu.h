@@ -30,6 +30,7 @@ limitations under the License.
 #include "Kernel/OVR_System.h"
 #include "Kernel/OVR_Nullptr.h"
 #include "Kernel/OVR_Timer.h"
+#include "Kernel/OVR_InplaceFunction.h"
 #include "Kernel/OVR_SysFile.h"
 #include "Extras/OVR_Math.h"
 
@@ -46,43 +47,14 @@ using namespace OVR::Render;
 
 
 //-------------------------------------------------------------------------------------
-struct FunctionNotifyBase : public NewOverrideBase
-{
-	virtual ~FunctionNotifyBase(){}
-    virtual void CallNotify(void*) { }
-    virtual void CallNotify() { }
-};
+// Called when a shortcut is triggered. shift is NULL unless the shortcut key uses
+// Shift_Modify, in which case it points to the shift key state.
+typedef InplaceFunction<void(bool* shift)> ShortcutNotify;
 
-// Simple member pointer wrapper to support calling class members
-template<class C, class X>
-struct FunctionNotifyContext : public FunctionNotifyBase
-{
-    typedef void (C::*FnPtr)(X*);
+class OptionVar;
 
-    FunctionNotifyContext(C* p, FnPtr fn) : pContext(NULL), pClass(p), pFn(fn) { }
-    FunctionNotifyContext(C* p, FnPtr fn, X* pContext) : pContext(pContext), pClass(p), pFn(fn) { }
-    virtual void CallNotify(void* var)  { (void)(pClass->*pFn)(static_cast<X*>(var)); }
-    virtual void CallNotify()  { (void)(pClass->*pFn)(pContext); }
-private:
-
-    X*      pContext;
-    C*      pClass;
-    FnPtr   pFn;
-};
-
-template<class C>
-struct FunctionNotifySimple : public FunctionNotifyBase
-{
-    typedef void (C::*FnPtr)(void);
-
-    FunctionNotifySimple(C* p, FnPtr fn) : pClass(p), pFn(fn) { }
-    virtual void CallNotify(void*)  { CallNotify(); }
-    virtual void CallNotify()  { (void)(pClass->*pFn)(); }
-private:
-
-    C*      pClass;
-    FnPtr   pFn;
-};
+// Called when an option's value changes.
+typedef InplaceFunction<void(OptionVar* var)> OptionNotify;
 
 
 //-------------------------------------------------------------------------------------
@@ -110,11 +82,10 @@ struct OptionShortcut
 {
     std::vector<ShortcutKey>  Keys;
     std::vector<uint32_t>     GamepadButtons;
-    FunctionNotifyBase* pNotify;
+    ShortcutNotify            Notify;
 
-    OptionShortcut() : pNotify(NULL) {}
-    OptionShortcut(FunctionNotifyBase* pNotify) : pNotify(pNotify) {}
-    ~OptionShortcut()  { delete pNotify; }
+    OptionShortcut() {}
+    OptionShortcut(const ShortcutNotify& notify) : Notify(notify) {}
 
     void AddShortcut(ShortcutKey key) { Keys.push_back(key); }
     void AddShortcut(uint32_t gamepadButton) { GamepadButtons.push_back(gamepadButton); }
@@ -273,10 +244,15 @@ public:
     template<class C>
     OptionVar& SetNotify(C* p, void (C::*fn)(OptionVar*))
     {
-        OVR_ASSERT(pNotify == 0); // Can't set notifier twice.
-        pNotify = new FunctionNotifyContext<C, OptionVar>(p, fn, this);
+        return SetNotify(OptionNotify([p, fn](OptionVar* var) { (p->*fn)(var); }));
+    }
+
+    OptionVar& SetNotify(const OptionNotify& notify)
+    {
+        OVR_ASSERT(!Notify); // Can't set notifier twice.
+        Notify = notify;
         return *this;
-    }   
+    }
 
 
     //String Format();
@@ -325,10 +301,14 @@ private:
 
     void SignalUpdate()
     {
+        ValueDirty = true;
         if (fUpdate) fUpdate(this);
-        if (pNotify) pNotify->CallNotify(this);
+        if (Notify) Notify(this);
     }
 
+    // The variable's raw value, for noticing when it's been changed outside the menu.
+    uint32_t                  GetValueBits();
+
     // Array of possible enum values.
     std::vector<EnumEntry>    EnumValues;
     // Gets the index of the current enum value.
@@ -336,7 +316,7 @@ private:
 
     FormatFunction            fFormat;
     UpdateFunction            fUpdate;
-    FunctionNotifyBase*       pNotify; 
+    OptionNotify              Notify;
 
     VarType         Type;
     void*           pVar;
@@ -355,6 +335,11 @@ private:
     int32_t     StepInt;
 
     int         SelectedIndex;
+
+    // GetValue's last result, for the built-in formats.
+    std::string CachedValue;
+    uint32_t    CachedValueBits;
+    bool        ValueDirty;
 };
 
 
@@ -365,7 +350,9 @@ private:
 // Items are added to the menu with AddBool, AddEnum, AddFloat on startup,
 // and are editable by using arrow keys (underlying variable is modified).
 // 
-// Call Render() to render the menu every frame.
+// Call Render() to render the menu every frame. The layout is kept between calls, and only
+// redone when what's shown changes; UpdateLayout tells callers that draw the menu into a texture
+// of its own when it needs redrawing.
 //
 // Menu also support displaying popup messages with a timeout, displayed
 // when menu body isn't up.
@@ -381,6 +368,10 @@ public:
     // Returns rendered bounds.
     Recti Render(RenderDevice* prender, std::string title, float textHeight, float centerX, float centerY);
 
+    // Lays out the menu, or the popup message, for Render. Returns false if nothing shown has
+    // changed since the last layout, in which case Render would draw the same as it last did.
+    bool UpdateLayout(RenderDevice* prender, std::string title, float textHeight, float centerX, float centerY);
+
     // Clear all the menu items
     void Clear();
 
@@ -479,10 +470,56 @@ public:
     // terminated by a newline (\n). 
     size_t          Enumerate(std::string& optionVarLines) const;
 
+    // What Render draws, and what it was laid out from.
+    struct MenuLayout
+    {
+        enum KindType
+        {
+            Kind_None,
+            Kind_Popup,
+            Kind_Menu
+        };
+
+        MenuLayout() : Valid(false), Kind(Kind_None), TextSize(0), CenterX(0), CenterY(0),
+                       GammaCurve(0), DisplayState(Display_None), HighlightIndex(0),
+                       SelectionActive(false), PopupBorder(false) { }
+
+        bool        Valid;
+
+        // Inputs
+        KindType    Kind;
+        float       TextSize;
+        float       CenterX;
+        float       CenterY;
+        float       GammaCurve;
+        Vector3f    Brightness;
+        int         DisplayState;
+        int         HighlightIndex;
+        bool        SelectionActive;
+        bool        PopupBorder;
+        std::string Title;
+        std::string MenuItems;  // One label per line
+        std::string Values;     // One value per line
+        std::string Popup;
+
+        // Kind_Menu results
+        Color       FocusColor, PickedColor, TitleColor, TitleOutlineColor, BlueRectColor, TextColor;
+        Vector2f    TopLeft, BottomRight;
+        Vector2f    LabelsPos, ValuesPos, TitlePos;
+        Vector2f    LabelSelection[2], ValueSelection[2];
+        Vector2f    TitleOutline[2], TitleRect[2];
+        Recti       Bounds;
+    };
+
 protected:
 
     Recti renderShortcutChangeMessage(RenderDevice* prender, float textSize, float centerX, float centerY);
 
+    // Fills in layout's inputs from the visible submenu.
+    void  collectLayoutInputs(std::string title, float textSize, float centerX, float centerY, MenuLayout& layout);
+
+    MenuLayout Layout;
+
 public:
     OptionSelectionMenu* GetSubmenu();
     OptionSelectionMenu* GetOrCreateSubmenu(const std::string& submenuName);
@@ -22,18 +22,141 @@ limitations under the License.
 *************************************************************************************/
 
 #include "RenderProfiler.h"
+#include "Kernel/OVR_Alg.h"
+
+#include <math.h>
 
 using namespace OVR;
 
-RenderProfiler::RenderProfiler()
+//-------------------------------------------------------------------------------------
+// ***** TimingHistogram
+
+static int GetTimingBucket(double seconds)
+{
+    const double micros = seconds * 1000000.0;
+    if (!(micros >= 0.5)) // Also catches NaN.
+        return 0;
+
+    const uint32_t maxMicros = (1u << TimingHistogram::MaxExponent) - 1;
+    const uint32_t value = (micros < maxMicros) ? (uint32_t)(micros + 0.5) : maxMicros;
+    if (value < TimingHistogram::LinearCount)
+        return (int)value;
+
+    // Keep the top five bits, which are 16..31, and the exponent.
+    const int exponent = Alg::UpperBit(value);
+    const int shift = exponent - 4;
+    return TimingHistogram::LinearCount + (exponent - 5) * TimingHistogram::SubBucketCount +
+           (int)((value >> shift) - TimingHistogram::SubBucketCount);
+}
+
+// Largest duration, in seconds, which falls in the bucket.
+static double GetTimingBucketUpperBound(int bucket)
+{
+    if (bucket < TimingHistogram::LinearCount)
+        return bucket / 1000000.0;
+
+    const int range = (bucket - TimingHistogram::LinearCount) / TimingHistogram::SubBucketCount;
+    const int sub = (bucket - TimingHistogram::LinearCount) % TimingHistogram::SubBucketCount;
+    const int shift = range + 1;
+    const uint32_t upper = ((uint32_t)(TimingHistogram::SubBucketCount + sub + 1) << shift) - 1;
+    return upper / 1000000.0;
+}
+
+void TimingHistogram::Clear()
+{
+    memset(Counts, 0, sizeof(Counts));
+    Count = 0;
+    SumSeconds = 0.0;
+    MaxSeconds = 0.0;
+}
+
+void TimingHistogram::Add(double seconds)
+{
+    Counts[GetTimingBucket(seconds)]++;
+    Count++;
+    SumSeconds += seconds;
+    if (seconds > MaxSeconds)
+        MaxSeconds = seconds;
+}
+
+void TimingHistogram::Merge(const TimingHistogram& other)
+{
+    for (int i = 0; i < BucketCount; i++)
+        Counts[i] += other.Counts[i];
+    Count += other.Count;
+    SumSeconds += other.SumSeconds;
+    if (other.MaxSeconds > MaxSeconds)
+        MaxSeconds = other.MaxSeconds;
+}
+
+double TimingHistogram::GetPercentile(double fraction) const
+{
+    if (Count == 0)
+        return 0.0;
+
+    // The rank of the value wanted, counting from 1.
+    uint32_t rank = (uint32_t)ceil(fraction * Count);
+    rank = Alg::Clamp(rank, 1u, Count);
+
+    uint32_t seen = 0;
+    for (int i = 0; i < BucketCount; i++)
+    {
+        seen += Counts[i];
+        if (seen >= rank)
+            return Alg::Min(GetTimingBucketUpperBound(i), MaxSeconds);
+    }
+
+    return MaxSeconds;
+}
+
+TimingStats::TimingStats(const TimingHistogram& histogram) :
+    Count(histogram.GetCount()),
+    Mean(histogram.GetMean()),
+    P50(histogram.GetPercentile(0.50)),
+    P95(histogram.GetPercentile(0.95)),
+    P99(histogram.GetPercentile(0.99)),
+    Max(histogram.GetMax())
+{
+}
+
+//-------------------------------------------------------------------------------------
+// ***** RenderProfiler
+
+RenderProfiler::RenderProfiler() :
+    WindowFrames(DefaultWindowFrames),
+    WindowFrameCount(0),
+    WindowIndex(0),
+    LastFrameStartTime(0.0),
+    OnWindowComplete()
 {
     memset(SampleHistory, 0, sizeof(SampleHistory));
     memset(SampleAverage, 0, sizeof(SampleAverage));
+    memset(StageLast, 0, sizeof(StageLast));
     SampleCurrentFrame = 0;
 }
 
+const char* RenderProfiler::GetStageName(StageType stageType)
+{
+    switch (stageType)
+    {
+    case Stage_WaitToBeginFrame:    return "WaitToBeginFrame";
+    case Stage_Simulation:          return "Simulation";
+    case Stage_SimulationJoin:      return "SimulationJoin";
+    case Stage_Render:              return "Render";
+    default:                        return "";
+    }
+}
+
+void RenderProfiler::RecordStage(StageType stageType, double seconds)
+{
+    StageLast[stageType] = seconds;
+    StageWindowHistograms[stageType].Add(seconds);
+}
+
 void RenderProfiler::RecordSample(SampleType sampleType)
 {
+    const double now = ovr_GetTimeInSeconds();
+
     if (sampleType == Sample_FrameStart)
     {
         // Recompute averages and subtract off frame start time.
@@ -50,10 +173,139 @@ void RenderProfiler::RecordSample(SampleType sampleType)
             SampleAverage[sample] /= NumFramesOfTimerHistory;
         }
 
+        addFrameToHistograms(now);
+
         SampleCurrentFrame = ((SampleCurrentFrame + 1) % NumFramesOfTimerHistory);
     }
 
-    SampleHistory[SampleCurrentFrame][sampleType] = ovr_GetTimeInSeconds();
+    SampleHistory[SampleCurrentFrame][sampleType] = now;
+}
+
+void RenderProfiler::addFrameToHistograms(double frameStartTime)
+{
+    // Nothing to add before the first complete frame.
+    const double lastFrameStartTime = LastFrameStartTime;
+    LastFrameStartTime = frameStartTime;
+    if (lastFrameStartTime == 0.0)
+        return;
+
+    const double* samples = SampleHistory[SampleCurrentFrame];
+    WindowHistograms[Sample_FrameStart].Add(frameStartTime - lastFrameStartTime);
+
+    // A sample which wasn't recorded this frame is left over from an earlier one, and went
+    // negative when the frame start was subtracted again.
+    for (int sample = 1; sample < Sample_LAST; sample++)
+    {
+        if (samples[sample] >= 0.0)
+            WindowHistograms[sample].Add(samples[sample]);
+    }
+
+    if (++WindowFrameCount < WindowFrames)
+        return;
+
+    for (int sample = 0; sample < Sample_LAST; sample++)
+    {
+        WindowStats[sample] = TimingStats(WindowHistograms[sample]);
+        TotalHistograms[sample].Merge(WindowHistograms[sample]);
+        WindowHistograms[sample].Clear();
+    }
+    for (int stage = 0; stage < Stage_LAST; stage++)
+    {
+        StageWindowStats[stage] = TimingStats(StageWindowHistograms[stage]);
+        StageTotalHistograms[stage].Merge(StageWindowHistograms[stage]);
+        StageWindowHistograms[stage].Clear();
+    }
+
+    if (OnWindowComplete)
+        OnWindowComplete(WindowStats, WindowIndex);
+
+    WindowFrameCount = 0;
+    WindowIndex++;
+}
+
+void RenderProfiler::SetWindowFrames(int frames)
+{
+    WindowFrames = Alg::Max(frames, 1);
+    WindowFrameCount = 0;
+    for (int sample = 0; sample < Sample_LAST; sample++)
+        WindowHistograms[sample].Clear();
+    for (int stage = 0; stage < Stage_LAST; stage++)
+        StageWindowHistograms[stage].Clear();
+}
+
+TimingStats RenderProfiler::GetTotalStats(SampleType sampleType) const
+{
+    // Include the window in progress.
+    TimingHistogram histogram = TotalHistograms[sampleType];
+    histogram.Merge(WindowHistograms[sampleType]);
+    return TimingStats(histogram);
+}
+
+TimingStats RenderProfiler::GetTotalStageStats(StageType stageType) const
+{
+    TimingHistogram histogram = StageTotalHistograms[stageType];
+    histogram.Merge(StageWindowHistograms[stageType]);
+    return TimingStats(histogram);
+}
+
+void RenderProfiler::ResetHistograms()
+{
+    for (int sample = 0; sample < Sample_LAST; sample++)
+    {
+        WindowHistograms[sample].Clear();
+        TotalHistograms[sample].Clear();
+        WindowStats[sample] = TimingStats();
+    }
+    for (int stage = 0; stage < Stage_LAST; stage++)
+    {
+        StageWindowHistograms[stage].Clear();
+        StageTotalHistograms[stage].Clear();
+        StageWindowStats[stage] = TimingStats();
+    }
+
+    WindowFrameCount = 0;
+    WindowIndex = 0;
+
+    for (GpuPassStats& pass : GpuPasses)
+        pass.Histogram.Clear();
+}
+
+void RenderProfiler::RecordGpuPasses(const std::vector<Render::GpuPassTime>& passes)
+{
+    // Sum the frame's passes by name first, as e.g. each model is its own pass.
+    GpuFrameMs.assign(GpuPasses.size(), -1.0);
+
+    for (const Render::GpuPassTime& pass : passes)
+    {
+        size_t index = 0;
+        while ((index < GpuPasses.size()) && (GpuPasses[index].Name != pass.Name))
+            index++;
+
+        if (index == GpuPasses.size())
+        {
+            if (GpuPasses.size() >= MaxGpuPasses)
+                continue;
+
+            GpuPassStats stats;
+            stats.Name = pass.Name;
+            stats.Depth = pass.Depth;
+            stats.LastMs = 0.0;
+            GpuPasses.push_back(stats);
+            GpuFrameMs.push_back(-1.0);
+        }
+
+        GpuFrameMs[index] = Alg::Max(GpuFrameMs[index], 0.0) + pass.Milliseconds;
+    }
+
+    // Passes which didn't run this frame keep their last time, and aren't counted.
+    for (size_t index = 0; index < GpuPasses.size(); index++)
+    {
+        if (GpuFrameMs[index] < 0.0)
+            continue;
+
+        GpuPasses[index].LastMs = GpuFrameMs[index];
+        GpuPasses[index].Histogram.Add(GpuFrameMs[index] / 1000.0);
+    }
 }
 
 const double* RenderProfiler::GetLastSampleSet() const
@@ -64,7 +316,7 @@ const double* RenderProfiler::GetLastSampleSet() const
 // Returns rendered bounds
 Recti RenderProfiler::DrawOverlay(RenderDevice* prender, float centerX, float centerY, float textHeight)
 {
-    char buf[256 * Sample_LAST];
+    char buf[512 * Sample_LAST + 128 * (Stage_LAST + MaxGpuPassesShown)];
     OVR_strcpy ( buf, sizeof(buf), "Timing stats" );     // No trailing \n is deliberate.
 
     /*int timerLastFrame = TimerCurrentFrame - 1;
@@ -97,5 +349,66 @@ Recti RenderProfiler::DrawOverlay(RenderDevice* prender, float centerX, float ce
         OVR_strcat ( buf, sizeof(buf), bufTemp );
     }
 
+    // Tail latency over the last complete window, including the frame interval.
+    if (WindowStats[Sample_FrameStart].Count)
+    {
+        char bufTemp[256];
+        snprintf( bufTemp, sizeof(bufTemp), "\n\nLast %d frames", WindowFrames );
+        OVR_strcat ( buf, sizeof(buf), bufTemp );
+
+        for ( int timerNum = Sample_FrameStart; timerNum < Sample_LAST; timerNum++ )
+        {
+            char const *pName = "";
+            switch ( timerNum )
+            {
+            case Sample_FrameStart         :     pName = "FrameInterval      "; break;
+            case Sample_AfterGameProcessing:     pName = "AfterGameProcessing"; break;
+            case Sample_AfterEyeRender     :     pName = "AfterEyeRender     "; break;
+            case Sample_AfterPresent       :     pName = "AfterPresent       "; break;
+            }
+            const TimingStats& stats = WindowStats[timerNum];
+            snprintf( bufTemp, sizeof(bufTemp),
+                      "\np50: %.2lf\t350p95: %.2lf\t700p99: %.2lf\t1050Max: %.2lfms\t1450%s",
+                      stats.P50 * 1000.0, stats.P95 * 1000.0, stats.P99 * 1000.0,
+                      stats.Max * 1000.0, pName );
+            OVR_strcat ( buf, sizeof(buf), bufTemp );
+        }
+    }
+
+    // Stages recorded since the last reset, with the tail of the last complete window.
+    bool stagesShown = false;
+    for ( int stage = 0; stage < Stage_LAST; stage++ )
+    {
+        if (StageWindowHistograms[stage].GetCount() == 0 && StageWindowStats[stage].Count == 0)
+            continue;
+        if (!stagesShown)
+        {
+            OVR_strcat ( buf, sizeof(buf), "\n\nStages" );
+            stagesShown = true;
+        }
+        char bufTemp[256];
+        snprintf( bufTemp, sizeof(bufTemp), "\nRaw: %.2lfms\t400p95: %.2lfms\t800%s",
+                  StageLast[stage] * 1000.0, StageWindowStats[stage].P95 * 1000.0,
+                  GetStageName((StageType)stage) );
+        OVR_strcat ( buf, sizeof(buf), bufTemp );
+    }
+
+    // GPU time per pass, indented by nesting depth.
+    if (!GpuPasses.empty())
+    {
+        OVR_strcat ( buf, sizeof(buf), "\n\nGPU passes" );
+
+        const size_t passCount = Alg::Min(GpuPasses.size(), (size_t)MaxGpuPassesShown);
+        for ( size_t index = 0; index < passCount; index++ )
+        {
+            const GpuPassStats& pass = GpuPasses[index];
+            char bufTemp[256];
+            snprintf( bufTemp, sizeof(bufTemp), "\nRaw: %.2lfms\t400p95: %.2lfms\t800%*s%.40s",
+                      pass.LastMs, pass.Histogram.GetPercentile(0.95) * 1000.0,
+                      Alg::Min(pass.Depth, 8) * 2, "", pass.Name.c_str() );
+            OVR_strcat ( buf, sizeof(buf), bufTemp );
+        }
+    }
+
     return DrawTextBox(prender, centerX, centerY, textHeight, buf, DrawText_Center);
 }
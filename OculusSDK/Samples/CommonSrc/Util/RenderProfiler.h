@@ -38,15 +38,81 @@ limitations under the License.
 
 #include <vector>
 #include <string>
+#include <functional>
+
+//-------------------------------------------------------------------------------------
+// ***** TimingHistogram
+
+// Counts durations in log-linear buckets, as HdrHistogram does, so percentiles can be read
+// to within 1/16 (about 6%) from a fixed 1.3KB however many values were added. Durations are
+// kept in microseconds, from 1us up to 16s; longer ones are counted in the last bucket, though
+// GetMax is always exact.
+class TimingHistogram
+{
+public:
+    // Values below LinearCount microseconds get a bucket each. Above that each power of two
+    // is split into SubBucketCount buckets.
+    enum
+    {
+        LinearCount    = 32,
+        SubBucketCount = LinearCount / 2,
+        MaxExponent    = 24,
+        BucketCount    = LinearCount + (MaxExponent - 5) * SubBucketCount
+    };
+
+    TimingHistogram() { Clear(); }
+
+    void     Clear();
+    void     Add(double seconds);
+    void     Merge(const TimingHistogram& other);
+
+    uint32_t GetCount() const { return Count; }
+    double   GetMax() const { return MaxSeconds; }
+    double   GetMean() const { return Count ? (SumSeconds / Count) : 0.0; }
+
+    // Returns the smallest duration which at least the given fraction (0..1) of the values
+    // are no greater than, rounded up to its bucket's upper bound.
+    double   GetPercentile(double fraction) const;
+
+private:
+    uint32_t Counts[BucketCount];
+    uint32_t Count;
+    double   SumSeconds;
+    double   MaxSeconds;
+};
+
+// Summary of a TimingHistogram, in seconds.
+struct TimingStats
+{
+    uint32_t Count;
+    double   Mean;
+    double   P50;
+    double   P95;
+    double   P99;
+    double   Max;
+
+    TimingStats() : Count(0), Mean(0), P50(0), P95(0), P99(0), Max(0) { }
+    explicit TimingStats(const TimingHistogram& histogram);
+};
 
 //-------------------------------------------------------------------------------------
 // ***** RenderProfiler
 
 // Tracks reported timing sample in a frame and dislays them an overlay from DrawOverlay().
+//
+// Besides the last few frames it keeps a TimingHistogram per sample type, of the time from the
+// start of the frame to the sample. Sample_FrameStart, which would always be 0, holds the time
+// from one frame start to the next instead. Percentiles are reported for fixed windows of
+// frames, and for everything since the last ResetHistograms.
+//
+// Stages are durations rather than times since the frame start, as a stage such as the next
+// frame's simulation may run on another thread, overlapping the rest of the frame. They go into
+// histograms windowed along with the samples.
 class RenderProfiler
 {
 public:
     enum { NumFramesOfTimerHistory = 10 };
+    enum { DefaultWindowFrames = 450 }; // 5 seconds at 90Hz
 
     enum SampleType
     {
@@ -61,22 +127,89 @@ public:
         Sample_LAST
     };
 
+    enum StageType
+    {
+        Stage_WaitToBeginFrame       ,  // ovr_WaitToBeginFrame, wherever it ran
+        Stage_Simulation             ,  // Moving the player for the frame
+        Stage_SimulationJoin         ,  // Waiting on a pipelined simulation to finish
+        Stage_Render                 ,  // From simulation to after present
+
+        Stage_LAST
+    };
+
+    static const char* GetStageName(StageType stageType);
+
     RenderProfiler();
 
     // Records the current time for the given sample type.
     void          RecordSample(SampleType sampleType);
+    // Adds the duration of the given stage for the frame in progress. Call from the thread
+    // recording samples; stages timed on other threads are recorded once they're joined.
+    void          RecordStage(StageType stageType, double seconds);
+    double        GetLastStage(StageType stageType) const { return StageLast[stageType]; }
 
     const double* GetAverages() const { return SampleAverage; } 
     const double* GetLastSampleSet() const;
 
+    // Called with the stats of each window as it completes, indexed by SampleType, and the
+    // number of windows completed before it.
+    typedef std::function<void(const TimingStats* stats, int windowIndex)> WindowHandler;
+
+    // Sets the number of frames per window; the current window is restarted.
+    void          SetWindowFrames(int frames);
+    int           GetWindowFrames() const { return WindowFrames; }
+    void          SetWindowHandler(const WindowHandler& handler) { OnWindowComplete = handler; }
+
+    // Stats for the last complete window, and for all frames since ResetHistograms.
+    const TimingStats& GetWindowStats(SampleType sampleType) const { return WindowStats[sampleType]; }
+    TimingStats   GetTotalStats(SampleType sampleType) const;
+    // Also valid from the window handler, for the window it's called with.
+    const TimingStats& GetWindowStageStats(StageType stageType) const { return StageWindowStats[stageType]; }
+    TimingStats   GetTotalStageStats(StageType stageType) const;
+
+    void          ResetHistograms();
+
+    // GPU time per AutoGpuProf pass name, summed over a frame's passes of that name.
+    struct GpuPassStats
+    {
+        std::string     Name;
+        int             Depth;          // Of the first pass with the name
+        double          LastMs;
+        TimingHistogram Histogram;      // Since ResetHistograms
+    };
+
+    enum { MaxGpuPasses = 64, MaxGpuPassesShown = 12 };
+
+    // Adds the pass times of a frame, as given by RenderDevice::GetGpuPassTimes after
+    // BeginGpuTimerFrame read one back.
+    void          RecordGpuPasses(const std::vector<Render::GpuPassTime>& passes);
+    const std::vector<GpuPassStats>& GetGpuPassStats() const { return GpuPasses; }
+
     // Returns rendered bounds.
     Recti          DrawOverlay(RenderDevice* prender, float centerX, float centerY, float textHeight);
 
 private:
+    void          addFrameToHistograms(double frameStartTime);
 
     double      SampleHistory[NumFramesOfTimerHistory][Sample_LAST];
     double      SampleAverage[Sample_LAST];
     int         SampleCurrentFrame;
+
+    TimingHistogram WindowHistograms[Sample_LAST];
+    TimingHistogram TotalHistograms[Sample_LAST];
+    TimingStats     WindowStats[Sample_LAST];
+    double          StageLast[Stage_LAST];
+    TimingHistogram StageWindowHistograms[Stage_LAST];
+    TimingHistogram StageTotalHistograms[Stage_LAST];
+    TimingStats     StageWindowStats[Stage_LAST];
+    int             WindowFrames;
+    int             WindowFrameCount;
+    int             WindowIndex;
+    double          LastFrameStartTime;
+    WindowHandler   OnWindowComplete;
+
+    std::vector<GpuPassStats> GpuPasses;    // In the order the names were first seen
+    std::vector<double>       GpuFrameMs;   // Scratch for RecordGpuPasses, per GpuPasses entry
 };
 
 #endif // OVR_RenderProfiler_h
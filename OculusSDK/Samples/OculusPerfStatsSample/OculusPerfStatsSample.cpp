@@ -18,16 +18,221 @@ limitations under the License.
 *************************************************************************************/
 /// This sample demonstrates how you can gather any Oculus Rift enabled application's
 /// performance statistics via the provided SDK API.
+///
+/// It also works as a sidecar for collecting them: it polls at the display's rate and
+/// publishes a PerfStatsRecord for each compositor frame to a shared-memory ring, and
+/// optionally to a UDP listener or a StatsD server.  See PerfStatsRing.h.
+///   -shm <name>          Names the ring, PERF_STATS_RING_NAME by default.
+///   -noshm               Publishes no ring.
+///   -udp <host:port>     Sends the records as datagrams.
+///   -statsd <host:port>  Sends the main timings as StatsD timers, and drops as counters.
+///   -quiet               Prints nothing once the stats are flowing.
 
 #include "OVR_CAPI.h"   // Include the Oculus SDK
+#include "PerfStatsRing.h"
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
 #include <assert.h>
 #include <thread>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#pragma comment(lib, "ws2_32.lib")
+
+static const uint32_t RingCapacity    = 4096;   // Around 45 seconds at 90 Hz
+static const size_t   MaxDatagramSize = 1400;   // Stays under a typical MTU
+
+//-------------------------------------------------------------------------------------
+// The shared-memory ring, laid out as PerfStatsRing.h describes.
+class PerfStatsRingWriter
+{
+public:
+    PerfStatsRingWriter() : Mapping(NULL), Header(NULL), Records(NULL) {}
+    ~PerfStatsRingWriter() { Close(); }
+
+    bool Open(const char* name)
+    {
+        const DWORD size = sizeof(PerfStatsRingHeader) + RingCapacity * sizeof(PerfStatsRecord);
+        Mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, size, name);
+        if (!Mapping)
+            return false;
+        Header = (PerfStatsRingHeader*)MapViewOfFile(Mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        if (!Header)
+        {
+            Close();
+            return false;
+        }
+        Records = (PerfStatsRecord*)(Header + 1);
+
+        // Readers check the magic last, once the rest is filled in.
+        Header->Version    = PerfStatsVersion;
+        Header->RecordSize = sizeof(PerfStatsRecord);
+        Header->Capacity   = RingCapacity;
+        Header->WriteCount = 0;
+        InterlockedExchange((volatile LONG*)&Header->Magic, PerfStatsMagic);
+        return true;
+    }
+
+    void Write(const PerfStatsRecord& record)
+    {
+        const int64_t count = Header->WriteCount;
+        Records[count % RingCapacity] = record;
+        InterlockedExchange64(&Header->WriteCount, count + 1); // Publishes the record
+    }
+
+    void Close()
+    {
+        if (Header)
+            UnmapViewOfFile(Header);
+        if (Mapping)
+            CloseHandle(Mapping);
+        Mapping = NULL;
+        Header  = NULL;
+        Records = NULL;
+    }
+
+    bool IsOpen() const { return Header != NULL; }
+
+private:
+    HANDLE               Mapping;
+    PerfStatsRingHeader* Header;
+    PerfStatsRecord*     Records;
+};
+
+//-------------------------------------------------------------------------------------
+// A connected UDP socket, for the datagram and StatsD sinks.
+class UdpSender
+{
+public:
+    UdpSender() : Socket(INVALID_SOCKET) {}
+    ~UdpSender() { Close(); }
+
+    // hostPort is "host:port".
+    bool Open(const char* hostPort)
+    {
+        const char* colon = strrchr(hostPort, ':');
+        if (!colon || (colon == hostPort) || ((size_t)(colon - hostPort) >= sizeof(Host)))
+            return false;
+        memcpy(Host, hostPort, colon - hostPort);
+        Host[colon - hostPort] = '\0';
+
+        addrinfo hints = {};
+        hints.ai_family   = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+        hints.ai_protocol = IPPROTO_UDP;
+        addrinfo* address = NULL;
+        if (getaddrinfo(Host, colon + 1, &hints, &address) != 0)
+            return false;
+
+        Socket = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if ((Socket != INVALID_SOCKET) && (connect(Socket, address->ai_addr, (int)address->ai_addrlen) != 0))
+            Close();
+        freeaddrinfo(address);
+        return Socket != INVALID_SOCKET;
+    }
+
+    // Losing a datagram is fine: the records carry their indices.
+    void Send(const void* data, size_t size)
+    {
+        if (Socket != INVALID_SOCKET)
+            send(Socket, (const char*)data, (int)size, 0);
+    }
+
+    void Close()
+    {
+        if (Socket != INVALID_SOCKET)
+            closesocket(Socket);
+        Socket = INVALID_SOCKET;
+    }
+
+    bool IsOpen() const { return Socket != INVALID_SOCKET; }
+
+private:
+    SOCKET Socket;
+    char   Host[256];
+};
 
 //-------------------------------------------------------------------------------------
 
-int main()
+static float ToMilliseconds(float seconds)
 {
+    // The SDK gives -1 for times it doesn't have, which stays -1.
+    return (seconds < 0.0f) ? -1.0f : seconds * 1000.0f;
+}
+
+static PerfStatsRecord MakeRecord(const ovrPerfStats& perfStats, const ovrPerfStatsPerCompositorFrame& frame)
+{
+    PerfStatsRecord record = {};
+    record.CompositorFrameIndex        = frame.CompositorFrameIndex;
+    record.HmdVsyncIndex               = frame.HmdVsyncIndex;
+    record.AppFrameIndex               = frame.AppFrameIndex;
+    record.AppDroppedFrameCount        = frame.AppDroppedFrameCount;
+    record.CompositorDroppedFrameCount = frame.CompositorDroppedFrameCount;
+    record.AswPresentedFrameCount      = frame.AswPresentedFrameCount;
+    record.ProcessId                   = perfStats.VisibleProcessId;
+    record.Flags                       = (frame.AswIsActive ? PerfStatsFlag_AswActive : 0) |
+                                         (perfStats.AswIsAvailable ? PerfStatsFlag_AswAvailable : 0);
+
+    record.AppMotionToPhotonLatency              = ToMilliseconds(frame.AppMotionToPhotonLatency);
+    record.AppQueueAheadTime                     = ToMilliseconds(frame.AppQueueAheadTime);
+    record.AppCpuElapsedTime                     = ToMilliseconds(frame.AppCpuElapsedTime);
+    record.AppGpuElapsedTime                     = ToMilliseconds(frame.AppGpuElapsedTime);
+    record.CompositorLatency                     = ToMilliseconds(frame.CompositorLatency);
+    record.CompositorCpuElapsedTime              = ToMilliseconds(frame.CompositorCpuElapsedTime);
+    record.CompositorGpuElapsedTime              = ToMilliseconds(frame.CompositorGpuElapsedTime);
+    record.CompositorCpuStartToGpuEndElapsedTime = ToMilliseconds(frame.CompositorCpuStartToGpuEndElapsedTime);
+    record.CompositorGpuEndToVsyncElapsedTime    = ToMilliseconds(frame.CompositorGpuEndToVsyncElapsedTime);
+
+    record.AdaptiveGpuPerformanceScale = perfStats.AdaptiveGpuPerformanceScale;
+    return record;
+}
+
+// Appends the record's StatsD lines to buffer, returning false if they didn't fit.
+static bool AppendStatsD(char* buffer, size_t bufferSize, size_t& used, const PerfStatsRecord& record,
+                         const PerfStatsRecord* previous)
+{
+    const int appDropped = previous ? (record.AppDroppedFrameCount - previous->AppDroppedFrameCount) : 0;
+    const int compositorDropped = previous ? (record.CompositorDroppedFrameCount - previous->CompositorDroppedFrameCount) : 0;
+
+    int length = snprintf(buffer + used, bufferSize - used,
+                          "ovr.app.gpu:%.3f|ms\novr.app.cpu:%.3f|ms\novr.app.latency:%.3f|ms\n"
+                          "ovr.compositor.gpu:%.3f|ms\novr.compositor.cpu:%.3f|ms\n"
+                          "ovr.app.dropped:%d|c\novr.compositor.dropped:%d|c\n",
+                          record.AppGpuElapsedTime, record.AppCpuElapsedTime, record.AppMotionToPhotonLatency,
+                          record.CompositorGpuElapsedTime, record.CompositorCpuElapsedTime,
+                          (appDropped > 0) ? appDropped : 0, (compositorDropped > 0) ? compositorDropped : 0);
+    if ((length < 0) || ((size_t)length >= bufferSize - used))
+    {
+        buffer[used] = '\0';
+        return false;
+    }
+    used += length;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    const char* ringName   = PERF_STATS_RING_NAME;
+    const char* udpTarget  = NULL;
+    const char* statsdTarget = NULL;
+    bool        quiet      = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-shm") && (i + 1 < argc))
+            ringName = argv[++i];
+        else if (!strcmp(argv[i], "-noshm"))
+            ringName = NULL;
+        else if (!strcmp(argv[i], "-udp") && (i + 1 < argc))
+            udpTarget = argv[++i];
+        else if (!strcmp(argv[i], "-statsd") && (i + 1 < argc))
+            statsdTarget = argv[++i];
+        else if (!strcmp(argv[i], "-quiet"))
+            quiet = true;
+    }
+
     // Initializes LibOVR, and the Rift
     ovrInitParams initParams = { ovrInit_Invisible | ovrInit_RequestVersion, OVR_MINOR_VERSION, NULL, 0, 0 };
     ovrResult result = ovr_Initialize(&initParams);
@@ -36,6 +241,19 @@ int main()
     printf("Oculus Rift Performance Stats Viewer Sample\n"
            "-------------------------------------------\n");
 
+    WSADATA wsaData;
+    const bool socketsStarted = (udpTarget || statsdTarget) && (WSAStartup(MAKEWORD(2, 2), &wsaData) == 0);
+
+    PerfStatsRingWriter ring;
+    UdpSender           udp;
+    UdpSender           statsd;
+    if (ringName && !ring.Open(ringName))
+        printf("ERROR: Failed to create the shared memory ring '%s'.\n", ringName);
+    if (udpTarget && !(socketsStarted && udp.Open(udpTarget)))
+        printf("ERROR: Failed to open UDP target '%s'.\n", udpTarget);
+    if (statsdTarget && !(socketsStarted && statsd.Open(statsdTarget)))
+        printf("ERROR: Failed to open StatsD target '%s'.\n", statsdTarget);
+
     {
         ovrSession session;
         ovrGraphicsLuid luid;
@@ -49,13 +267,22 @@ int main()
         ovrHmdDesc hmdDesc = ovr_GetHmdDesc(session);
         float hmdRefreshRate = hmdDesc.DisplayRefreshRate;
 
+        // The stats give up to ovrMaxProvidedFrameStats frames, so polling once a refresh
+        // keeps up with every frame, and with some to spare when a poll is late.
+        const auto pollInterval = std::chrono::microseconds((int)(1000000.0f / hmdRefreshRate));
+
         ovrPerfStats lastPerfStats;
         ovrPerfStatsPerCompositorFrame& lastFrameStats = lastPerfStats.FrameStats[0]; // [0] contains the most recent stats
         lastFrameStats.HmdVsyncIndex = -1;  // reset to make sure we know it's not updated via the SDK yet
         lastPerfStats.VisibleProcessId = -1;
+        double lastReportTime = ovr_GetTimeInSeconds();
 
         ovrPerfStats perfStats;
 
+        // The last record published, as new frames are only those with a later index.
+        PerfStatsRecord lastRecord = {};
+        bool            havePublished = false;
+
         bool waitingForStatsMessaged = false;
 
         // Main loop
@@ -71,43 +298,99 @@ int main()
 
             ovr_GetPerfStats(session, &perfStats);
 
-            if (lastPerfStats.VisibleProcessId == -1)
-            {
-            }
-
             // Did we get any valid stats?
             if (perfStats.FrameStatsCount > 0)
             {
-                // Did we process a frame before?
-                if (lastFrameStats.HmdVsyncIndex > 0)
+                // Publish new frames oldest first, which is the reverse of their order in the stats.
+                uint32_t datagram[MaxDatagramSize / sizeof(uint32_t)];
+                PerfStatsDatagramHeader* datagramHeader = (PerfStatsDatagramHeader*)datagram;
+                PerfStatsRecord* datagramRecords = (PerfStatsRecord*)(datagramHeader + 1);
+                datagramHeader->Magic = PerfStatsMagic;
+                datagramHeader->Version = PerfStatsVersion;
+                datagramHeader->RecordCount = 0;
+
+                char   statsdText[MaxDatagramSize];
+                size_t statsdUsed = 0;
+
+                bool firstNew = true;
+                for (int i = perfStats.FrameStatsCount - 1; i >= 0; --i)
                 {
-                    // Are we still looking at the same app, or did focus shift?
-                    if (lastPerfStats.VisibleProcessId == perfStats.VisibleProcessId)
+                    const ovrPerfStatsPerCompositorFrame& frame = perfStats.FrameStats[i];
+                    if (havePublished && (frame.CompositorFrameIndex <= lastRecord.CompositorFrameIndex) &&
+                        (perfStats.VisibleProcessId == lastRecord.ProcessId))
                     {
-                        int framesSinceLastInterval = perfStats.FrameStats[0].HmdVsyncIndex - lastFrameStats.HmdVsyncIndex;
-
-                        int appFramesSinceLastInterval = perfStats.FrameStats[0].AppFrameIndex - lastFrameStats.AppFrameIndex;
-                        int compFramesSinceLastInterval = perfStats.FrameStats[0].CompositorFrameIndex - lastFrameStats.CompositorFrameIndex;
+                        continue;
+                    }
 
-                        float appFrameRate = (float)appFramesSinceLastInterval / framesSinceLastInterval * hmdRefreshRate;
-                        float compFrameRate = (float)compFramesSinceLastInterval / framesSinceLastInterval * hmdRefreshRate;
+                    PerfStatsRecord record = MakeRecord(perfStats, frame);
+                    if (firstNew && perfStats.AnyFrameStatsDropped)
+                        record.Flags |= PerfStatsFlag_StatsDropped;
+                    firstNew = false;
 
-                        printf("App PID: %d\tApp FPS: %0.0f\tCompositor FPS: %0.0f\n", perfStats.VisibleProcessId, appFrameRate, compFrameRate);
+                    if (ring.IsOpen())
+                        ring.Write(record);
+                    if (udp.IsOpen())
+                        datagramRecords[datagramHeader->RecordCount++] = record;
+                    if (statsd.IsOpen() && !AppendStatsD(statsdText, sizeof(statsdText), statsdUsed, record,
+                                                         havePublished ? &lastRecord : NULL))
+                    {
+                        statsd.Send(statsdText, statsdUsed);
+                        statsdUsed = 0;
+                        AppendStatsD(statsdText, sizeof(statsdText), statsdUsed, record, havePublished ? &lastRecord : NULL);
                     }
-                    else
+
+                    lastRecord = record;
+                    havePublished = true;
+                }
+
+                static_assert(sizeof(PerfStatsDatagramHeader) + ovrMaxProvidedFrameStats * sizeof(PerfStatsRecord) <= MaxDatagramSize,
+                              "A poll's records fit in one datagram.");
+                if (datagramHeader->RecordCount > 0)
+                    udp.Send(datagram, sizeof(PerfStatsDatagramHeader) + datagramHeader->RecordCount * sizeof(PerfStatsRecord));
+                if (statsdUsed > 0)
+                    statsd.Send(statsdText, statsdUsed);
+
+                // In this app, since we don't care about individual frame time values and only looking at frame rate,
+                // we can update the frame rate once a second (i.e. 1000 ms) and look at the number of frames rendered.
+                const double now = ovr_GetTimeInSeconds();
+                if (now - lastReportTime >= 1.0)
+                {
+                    lastReportTime = now;
+
+                    // Did we process a frame before?
+                    if (lastFrameStats.HmdVsyncIndex > 0)
                     {
-                        printf("Focus shifted to another VR app. Resetting perf stats...\n");
-                        result = ovr_ResetPerfStats(session);
-                        if (!OVR_SUCCESS(result))
+                        // Are we still looking at the same app, or did focus shift?
+                        if (lastPerfStats.VisibleProcessId == perfStats.VisibleProcessId)
                         {
-                            printf("ERROR: Failed to reset perf stats.\n");
-                            return 1;
+                            int framesSinceLastInterval = perfStats.FrameStats[0].HmdVsyncIndex - lastFrameStats.HmdVsyncIndex;
+
+                            int appFramesSinceLastInterval = perfStats.FrameStats[0].AppFrameIndex - lastFrameStats.AppFrameIndex;
+                            int compFramesSinceLastInterval = perfStats.FrameStats[0].CompositorFrameIndex - lastFrameStats.CompositorFrameIndex;
+
+                            float appFrameRate = (float)appFramesSinceLastInterval / framesSinceLastInterval * hmdRefreshRate;
+                            float compFrameRate = (float)compFramesSinceLastInterval / framesSinceLastInterval * hmdRefreshRate;
+
+                            if (!quiet)
+                                printf("App PID: %d\tApp FPS: %0.0f\tCompositor FPS: %0.0f\n", perfStats.VisibleProcessId, appFrameRate, compFrameRate);
+                        }
+                        else
+                        {
+                            printf("Focus shifted to another VR app. Resetting perf stats...\n");
+                            result = ovr_ResetPerfStats(session);
+                            if (!OVR_SUCCESS(result))
+                            {
+                                printf("ERROR: Failed to reset perf stats.\n");
+                                return 1;
+                            }
+                            // The indices start again, so any frame is new.
+                            havePublished = false;
                         }
                     }
-                }
 
-                // save off values for next interval's calculations
-                lastPerfStats = perfStats;
+                    // save off values for next interval's calculations
+                    lastPerfStats = perfStats;
+                }
                 waitingForStatsMessaged = false;
             }
             else if(!waitingForStatsMessaged)
@@ -118,15 +401,19 @@ int main()
                 waitingForStatsMessaged = true;
             }
 
-            // In this app, since we don't care about individual frame time values and only looking at frame rate,
-            // we can update the frame rate once a second (i.e. 1000 ms) and look at the number of frames rendered.
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            std::this_thread::sleep_for(pollInterval);
         }
 
         // Release resources
         ovr_Destroy(session);
     }
 
+    ring.Close();
+    udp.Close();
+    statsd.Close();
+    if (socketsStarted)
+        WSACleanup();
+
     ovr_Shutdown();
     return 0;
 }
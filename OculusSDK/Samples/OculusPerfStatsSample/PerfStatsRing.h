@@ -0,0 +1,94 @@
+/************************************************************************************
+Filename    :   PerfStatsRing.h
+Content     :   Layout of the records OculusPerfStatsSample publishes
+Created     :   October 14, 2026
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*************************************************************************************/
+/// One record is published per compositor frame, to a named shared-memory ring and,
+/// optionally, as UDP datagrams.  Readers of either include this header.
+///
+/// The ring is a PerfStatsRingHeader followed by Capacity records.  The writer fills
+/// record (WriteCount % Capacity) and then increments WriteCount, so a reader copies
+/// the records between its last count and WriteCount, and then reads WriteCount again:
+/// any copied record more than Capacity behind it may have been overwritten meanwhile.
+///
+/// A UDP datagram is a PerfStatsDatagramHeader followed by RecordCount records.
+
+#ifndef OVR_PerfStatsRing_h
+#define OVR_PerfStatsRing_h
+
+#include <stdint.h>
+
+#define PERF_STATS_RING_NAME "OculusPerfStats"
+
+enum
+{
+    PerfStatsMagic    = 0x53505652, // "RVPS"
+    PerfStatsVersion  = 1
+};
+
+#pragma pack(push, 4)
+
+struct PerfStatsRecord
+{
+    int32_t  CompositorFrameIndex;
+    int32_t  HmdVsyncIndex;
+    int32_t  AppFrameIndex;
+    int32_t  AppDroppedFrameCount;
+    int32_t  CompositorDroppedFrameCount;
+    int32_t  AswPresentedFrameCount;
+    int32_t  ProcessId;                 // The visible app's
+    uint32_t Flags;                     // PerfStatsFlag_*
+
+    // In milliseconds
+    float    AppMotionToPhotonLatency;
+    float    AppQueueAheadTime;
+    float    AppCpuElapsedTime;
+    float    AppGpuElapsedTime;
+    float    CompositorLatency;
+    float    CompositorCpuElapsedTime;
+    float    CompositorGpuElapsedTime;
+    float    CompositorCpuStartToGpuEndElapsedTime;
+    float    CompositorGpuEndToVsyncElapsedTime;
+
+    float    AdaptiveGpuPerformanceScale;
+};
+
+enum
+{
+    PerfStatsFlag_AswActive     = 0x1,
+    PerfStatsFlag_AswAvailable  = 0x2,
+    PerfStatsFlag_StatsDropped  = 0x4  // Frames were missed before this one
+};
+
+struct PerfStatsRingHeader
+{
+    uint32_t          Magic;
+    uint32_t          Version;
+    uint32_t          RecordSize;
+    uint32_t          Capacity;
+    volatile int64_t  WriteCount;
+};
+
+struct PerfStatsDatagramHeader
+{
+    uint32_t Magic;
+    uint16_t Version;
+    uint16_t RecordCount;
+};
+
+#pragma pack(pop)
+
+#endif // OVR_PerfStatsRing_h
@@ -376,13 +376,16 @@ Done:
 //-------------------------------------------------------------------------------------
 int WINAPI WinMain(HINSTANCE hinst, HINSTANCE, LPSTR, int)
 {
+    // Find and verify the LibOVR runtime while the window opens
+    ovr_PrepareInitialize();
+
+    VALIDATE(DIRECTX.InitWindow(hinst, L"Oculus Room Tiny (DX11)"), "Failed to open window.");
+
     // Initializes LibOVR, and the Rift
 	ovrInitParams initParams = { ovrInit_RequestVersion | ovrInit_FocusAware, OVR_MINOR_VERSION, NULL, 0, 0 };
 	ovrResult result = ovr_Initialize(&initParams);
     VALIDATE(OVR_SUCCESS(result), "Failed to initialize libOVR.");
 
-    VALIDATE(DIRECTX.InitWindow(hinst, L"Oculus Room Tiny (DX11)"), "Failed to open window.");
-
     DIRECTX.Run(MainLoop);
 
     ovr_Shutdown();
@@ -156,6 +156,7 @@ struct OculusEyeTexture
             for (size_t i = 0; i < TexResource.size(); i++)
             {
                 Release(TexResource[i]);
+                DIRECTX.RtvHandleProvider.FreeCpuHandle(TexRtv[i]);
             }
 
             ovr_DestroyTextureSwapChain(Session, TextureChain);
@@ -166,6 +167,7 @@ struct OculusEyeTexture
             for (size_t i = 0; i < DepthTex.size(); i++)
             {
                 Release(DepthTex[i]);
+                DIRECTX.DsvHandleProvider.FreeCpuHandle(DepthTexDsv[i]);
             }
 
             ovr_DestroyTextureSwapChain(Session, DepthTextureChain);
@@ -354,30 +356,15 @@ static bool MainLoop(bool retryCreate)
 
             ovrTimewarpProjectionDesc PosTimewarpProjectionDesc = {};
 
-			// Render Scene to Eye Buffers
+            // Hold P to record the eyes' command lists on worker threads, each eye split into
+            // DirectX12::RecordPartitions lists, instead of one list per eye on this thread.
+            bool recordParallel = DIRECTX.Key['P'];
+            // Hold B to replay the room from bundles (see Scene::RenderBundle) instead
+            bool renderBundle = DIRECTX.Key['B'];
+
+            XMMATRIX eyeProjView[2];
             for (int eye = 0; eye < 2; ++eye)
             {
-                DIRECTX.SetActiveContext(eye == 0 ? DrawContext_EyeRenderLeft : DrawContext_EyeRenderRight);
-
-                DIRECTX.SetActiveEye(eye);
-
-                CD3DX12_RESOURCE_BARRIER resBar = CD3DX12_RESOURCE_BARRIER::Transition(pEyeRenderTexture[eye]->GetD3DColorResource(),
-                                                                                       D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-                                                                                       D3D12_RESOURCE_STATE_RENDER_TARGET);
-                DIRECTX.CurrentFrameResources().CommandLists[DIRECTX.ActiveContext]->ResourceBarrier(1, &resBar);
-
-                if (pEyeRenderTexture[eye]->GetD3DDepthResource())
-                {
-                    resBar = CD3DX12_RESOURCE_BARRIER::Transition(pEyeRenderTexture[eye]->GetD3DDepthResource(),
-                                                                  D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-                                                                  D3D12_RESOURCE_STATE_DEPTH_WRITE);
-                    DIRECTX.CurrentFrameResources().CommandLists[DIRECTX.ActiveContext]->ResourceBarrier(1, &resBar);
-                }
-
-                DIRECTX.SetAndClearRenderTarget(pEyeRenderTexture[eye]->GetRtv(), pEyeRenderTexture[eye]->GetDsv());
-                DIRECTX.SetViewport((float)eyeRenderViewport[eye].Pos.x, (float)eyeRenderViewport[eye].Pos.y,
-                                    (float)eyeRenderViewport[eye].Size.w, (float)eyeRenderViewport[eye].Size.h);
-                                
                 //Get the pose information in XM format
                 XMVECTOR eyeQuat = XMVectorSet(EyeRenderPose[eye].Orientation.x, EyeRenderPose[eye].Orientation.y,
                                                EyeRenderPose[eye].Orientation.z, EyeRenderPose[eye].Orientation.w);
@@ -393,28 +380,95 @@ static bool MainLoop(bool retryCreate)
                                             p.M[0][1], p.M[1][1], p.M[2][1], p.M[3][1],
                                             p.M[0][2], p.M[1][2], p.M[2][2], p.M[3][2],
                                             p.M[0][3], p.M[1][3], p.M[2][3], p.M[3][3]);
-                XMMATRIX prod = XMMatrixMultiply(view, proj);
+                eyeProjView[eye] = XMMatrixMultiply(view, proj);
+            }
+
+            // Look the eyes' current buffers up here, so the workers in recordParallel don't call into the SDK
+            ID3D12Resource* eyeColor[2];
+            ID3D12Resource* eyeDepth[2];
+            for (int eye = 0; eye < 2; ++eye)
+            {
+                eyeColor[eye] = pEyeRenderTexture[eye]->GetD3DColorResource();
+                eyeDepth[eye] = pEyeRenderTexture[eye]->GetD3DDepthResource();
+            }
 
-                roomScene->Render(&prod, 1, 1, 1, 1, true);
+            // Moves an eye's buffers between being rendered to and being read by the compositor
+            auto transitionEye = [&](ID3D12GraphicsCommandList* cmdList, int eye, bool toRender)
+            {
+                CD3DX12_RESOURCE_BARRIER resBar = CD3DX12_RESOURCE_BARRIER::Transition(eyeColor[eye],
+                    toRender ? D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE : D3D12_RESOURCE_STATE_RENDER_TARGET,
+                    toRender ? D3D12_RESOURCE_STATE_RENDER_TARGET : D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+                cmdList->ResourceBarrier(1, &resBar);
+
+                if (eyeDepth[eye])
+                {
+                    resBar = CD3DX12_RESOURCE_BARRIER::Transition(eyeDepth[eye],
+                        toRender ? D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE : D3D12_RESOURCE_STATE_DEPTH_WRITE,
+                        toRender ? D3D12_RESOURCE_STATE_DEPTH_WRITE : D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+                    cmdList->ResourceBarrier(1, &resBar);
+                }
+            };
 
-                resBar = CD3DX12_RESOURCE_BARRIER::Transition(pEyeRenderTexture[eye]->GetD3DColorResource(),
-                                                              D3D12_RESOURCE_STATE_RENDER_TARGET,
-                                                              D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-                DIRECTX.CurrentFrameResources().CommandLists[DIRECTX.ActiveContext]->ResourceBarrier(1, &resBar);
-                
-                if (pEyeRenderTexture[eye]->GetD3DDepthResource())
+            if (recordParallel)
+            {
+                D3D12_CPU_DESCRIPTOR_HANDLE eyeRtv[2], eyeDsv[2];
+                for (int eye = 0; eye < 2; ++eye)
                 {
-                    resBar = CD3DX12_RESOURCE_BARRIER::Transition(pEyeRenderTexture[eye]->GetD3DDepthResource(),
-                                                                  D3D12_RESOURCE_STATE_DEPTH_WRITE,
-                                                                  D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-                    DIRECTX.CurrentFrameResources().CommandLists[DIRECTX.ActiveContext]->ResourceBarrier(1, &resBar);
+                    eyeRtv[eye] = pEyeRenderTexture[eye]->GetRtv();
+                    eyeDsv[eye] = pEyeRenderTexture[eye]->GetDsv();
                 }
 
-                // kick off eye render command lists before ovr_SubmitFrame()
-                DIRECTX.SubmitCommandList(DIRECTX.ActiveContext);
-                
-                // Commit rendering to the swap chain
-                pEyeRenderTexture[eye]->Commit();
+                // The lists execute in order, so only an eye's first partition clears and its last hands it back
+                DIRECTX.RecordParallel([&](int listIdx, ID3D12GraphicsCommandList* cmdList)
+                {
+                    int eye = listIdx / DirectX12::RecordPartitions;
+                    int partition = listIdx % DirectX12::RecordPartitions;
+
+                    if (partition == 0)
+                        transitionEye(cmdList, eye, true);
+
+                    DirectX12::SetAndClearRenderTarget(cmdList, &eyeRtv[eye], &eyeDsv[eye], (partition == 0));
+                    DirectX12::SetViewport(cmdList, (float)eyeRenderViewport[eye].Pos.x, (float)eyeRenderViewport[eye].Pos.y,
+                                           (float)eyeRenderViewport[eye].Size.w, (float)eyeRenderViewport[eye].Size.h);
+
+                    roomScene->Render(cmdList, &eyeProjView[eye], 1, 1, 1, 1, partition, DirectX12::RecordPartitions);
+
+                    if (partition == DirectX12::RecordPartitions - 1)
+                        transitionEye(cmdList, eye, false);
+                });
+
+                // Commit rendering to the swap chains
+                for (int eye = 0; eye < 2; ++eye)
+                    pEyeRenderTexture[eye]->Commit();
+            }
+            else
+            {
+                // Render Scene to Eye Buffers
+                for (int eye = 0; eye < 2; ++eye)
+                {
+                    DIRECTX.SetActiveContext(eye == 0 ? DrawContext_EyeRenderLeft : DrawContext_EyeRenderRight);
+
+                    DIRECTX.SetActiveEye(eye);
+
+                    transitionEye(DIRECTX.CurrentFrameResources().CommandLists[DIRECTX.ActiveContext], eye, true);
+
+                    DIRECTX.SetAndClearRenderTarget(pEyeRenderTexture[eye]->GetRtv(), pEyeRenderTexture[eye]->GetDsv());
+                    DIRECTX.SetViewport((float)eyeRenderViewport[eye].Pos.x, (float)eyeRenderViewport[eye].Pos.y,
+                                        (float)eyeRenderViewport[eye].Size.w, (float)eyeRenderViewport[eye].Size.h);
+
+                    if (renderBundle)
+                        roomScene->RenderBundle(DIRECTX.CurrentFrameResources().CommandLists[DIRECTX.ActiveContext], eye, &eyeProjView[eye], 1, 1, 1, 1);
+                    else
+                        roomScene->Render(&eyeProjView[eye], 1, 1, 1, 1, true);
+
+                    transitionEye(DIRECTX.CurrentFrameResources().CommandLists[DIRECTX.ActiveContext], eye, false);
+
+                    // kick off eye render command lists before ovr_SubmitFrame()
+                    DIRECTX.SubmitCommandList(DIRECTX.ActiveContext);
+
+                    // Commit rendering to the swap chain
+                    pEyeRenderTexture[eye]->Commit();
+                }
             }
 
             // Initialize our single full screen Fov layer.
@@ -452,37 +506,48 @@ static bool MainLoop(bool retryCreate)
             ID3D12Resource* mirrorTexRes = nullptr;
             ovr_GetMirrorTextureBufferDX(session, mirrorTexture, IID_PPV_ARGS(&mirrorTexRes));
 
-            //DIRECTX.SetAndClearRenderTarget(DIRECTX.CurrentFrameResources().SwapChainRtvHandle, nullptr, 1.0f, 0.5f, 0.0f, 1.0f);
+            //DIRECTX.SetAndClearRenderTarget(DIRECTX.SwapChainRtvHandles[DIRECTX.SwapChainFrameIndex], nullptr, 1.0f, 0.5f, 0.0f, 1.0f);
 
-            CD3DX12_RESOURCE_BARRIER preMirrorBlitBar[] =
+            // The copy as a frame graph pass, which batches the transitions either side of it
+            FrameGraph mirrorGraph;
+            FrameGraphD3D12 frameGraphBackend;
+            int backBuffer = mirrorGraph.ImportResource(DIRECTX.CurrentSwapChainBuffer(), FrameGraphUsage_RenderTarget, FrameGraphUsage_CopyDest);
+            int mirrorBuffer = mirrorGraph.ImportResource(mirrorTexRes, FrameGraphUsage_RenderTarget, FrameGraphUsage_RenderTarget);
+            int copyPass = mirrorGraph.AddPass("MirrorCopy", [&](void* context)
             {
-                CD3DX12_RESOURCE_BARRIER::Transition(DIRECTX.CurrentFrameResources().SwapChainBuffer, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_DEST),
-                CD3DX12_RESOURCE_BARRIER::Transition(mirrorTexRes, D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_COPY_SOURCE)
-            };
-
-            // Indicate that the back buffer will now be copied into
-            DIRECTX.CurrentFrameResources().CommandLists[DIRECTX.ActiveContext]->ResourceBarrier(ARRAYSIZE(preMirrorBlitBar), preMirrorBlitBar);
-
-            // TODO: Leads to debug layer error messages, so we use CopyTextureRegion instead
-            //DIRECTX.CurrentFrameResources().CommandLists[DIRECTX.ActiveContext]->CopyResource(DIRECTX.CurrentFrameResources().SwapChainBuffer, mirrorTexRes);
-
-            D3D12_TEXTURE_COPY_LOCATION copySrc = {};
-            copySrc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-            copySrc.SubresourceIndex = 0;
-            copySrc.pResource = DIRECTX.CurrentFrameResources().SwapChainBuffer;
-            D3D12_TEXTURE_COPY_LOCATION copyDst = {};
-            copyDst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
-            copyDst.SubresourceIndex = 0;
-            copyDst.pResource = mirrorTexRes;
-            DIRECTX.CurrentFrameResources().CommandLists[DIRECTX.ActiveContext]->CopyTextureRegion(&copySrc, 0, 0, 0, &copyDst, nullptr);
-
-            CD3DX12_RESOURCE_BARRIER resBar = CD3DX12_RESOURCE_BARRIER::Transition(mirrorTexRes,
-                                                                                   D3D12_RESOURCE_STATE_COPY_SOURCE,
-                                                                                   D3D12_RESOURCE_STATE_RENDER_TARGET);
-            DIRECTX.CurrentFrameResources().CommandLists[DIRECTX.ActiveContext]->ResourceBarrier(1, &resBar);
+                // TODO: Leads to debug layer error messages, so we use CopyTextureRegion instead
+                //((ID3D12GraphicsCommandList*)context)->CopyResource(DIRECTX.CurrentSwapChainBuffer(), mirrorTexRes);
+
+                D3D12_TEXTURE_COPY_LOCATION copySrc = {};
+                copySrc.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+                copySrc.SubresourceIndex = 0;
+                copySrc.pResource = DIRECTX.CurrentSwapChainBuffer();
+                D3D12_TEXTURE_COPY_LOCATION copyDst = {};
+                copyDst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+                copyDst.SubresourceIndex = 0;
+                copyDst.pResource = mirrorTexRes;
+                ((ID3D12GraphicsCommandList*)context)->CopyTextureRegion(&copySrc, 0, 0, 0, &copyDst, nullptr);
+            }, true);
+            mirrorGraph.Use(copyPass, backBuffer, FrameGraphUsage_CopyDest);
+            mirrorGraph.Use(copyPass, mirrorBuffer, FrameGraphUsage_CopySource);
+
+            mirrorGraph.Compile(frameGraphBackend);
+            mirrorGraph.Execute(frameGraphBackend, DIRECTX.CurrentFrameResources().CommandLists[DIRECTX.ActiveContext]);
         }
 
         DIRECTX.SubmitCommandListAndPresent(drawMirror);
+
+        // Report how long the host has been blocked on the GPU, which should be next to nothing
+        // with DirectX12::FramesInFlight frames to run ahead
+        if (DIRECTX.WaitStats.FrameCount == 1000)
+        {
+            char waitStr[128];
+            sprintf_s(waitStr, "Waited for the GPU on %d of %d frames, %.2fms average, %.2fms max\n",
+                      (int)DIRECTX.WaitStats.WaitCount, (int)DIRECTX.WaitStats.FrameCount,
+                      DIRECTX.WaitStats.TotalWaitMs / DIRECTX.WaitStats.FrameCount, DIRECTX.WaitStats.MaxWaitMs);
+            OutputDebugStringA(waitStr);
+            DIRECTX.WaitStats = DirectX12::FrameWaitStats();
+        }
     }
 
     // Release resources
@@ -409,6 +409,13 @@ static bool MainLoop(bool retryCreate)
         Abort(ovrError_DeviceUnavailable);
     }
 
+    // Buffer and texture contents go in on the transfer queue
+    if (!Uploads.Create())
+    {
+        Debug.Log("Upload queue creation failed");
+        Abort(ovrError_InvalidOperation);
+    }
+
     // Begin the initialization command buffer, note that various initialization steps need a valid command buffer to operate correctly
     if (!Platform.CurrentDrawCmd().Begin())
     {
@@ -458,8 +465,10 @@ static bool MainLoop(bool retryCreate)
     // Get swapchain images ready for blitting (use drawCmd instead of xferCmd to keep things simple)
     Platform.sc.Prepare(Platform.CurrentDrawCmd().buf);
 
-    // Perform all init-time commands
-    if (!(Platform.CurrentDrawCmd().End() && Platform.CurrentDrawCmd().Exec(Platform.drawQueue) && Platform.CurrentDrawCmd().Wait()))
+    // Perform all init-time commands, once the uploads they acquire are done
+    if (!(Platform.CurrentDrawCmd().End() &&
+          Platform.CurrentDrawCmd().Exec(Platform.drawQueue, Uploads.Submit(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT) &&
+          Platform.CurrentDrawCmd().Wait()))
     {
         Debug.Log("Executing initial command buffer failed");
         Abort(ovrError_InvalidOperation);
@@ -517,6 +526,9 @@ static bool MainLoop(bool retryCreate)
 
 	if (isVisible)
         {
+            // Holding B replays the room from secondary command buffers recorded on the first frames
+            bool renderStatic = Platform.Key['B'];
+
             Platform.NextDrawCmd();
             auto& cmd = Platform.CurrentDrawCmd();
             cmd.Reset();
@@ -539,9 +551,7 @@ static bool MainLoop(bool retryCreate)
                 rpBegin.clearValueCount = (uint32_t)clearValues.size();
                 rpBegin.pClearValues = clearValues.data();
 
-                vkCmdBeginRenderPass(cmd.buf, &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
-
-                vkCmdBindPipeline(cmd.buf, VK_PIPELINE_BIND_POINT_GRAPHICS, perEye[eye].pipe.pipe);
+                vkCmdBeginRenderPass(cmd.buf, &rpBegin, renderStatic ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
 
                 // Get view and projection matrices
                 Matrix4f finalRollPitchYaw = rollPitchYaw * Matrix4f(eyeRenderPose[eye].Orientation);
@@ -554,13 +564,21 @@ static bool MainLoop(bool retryCreate)
                 posTimewarpProjectionDesc = ovrTimewarpProjectionDesc_FromProjection(proj, ovrProjection_None);
 
                 // Render world
-                roomScene.Render(view, proj, layout, vb);
+                if (renderStatic)
+                {
+                    roomScene.RenderStatic(view, proj, layout, perEye[eye].pipe, perEye[eye].rp, vb, eye);
+                }
+                else
+                {
+                    vkCmdBindPipeline(cmd.buf, VK_PIPELINE_BIND_POINT_GRAPHICS, perEye[eye].pipe.pipe);
+                    roomScene.Render(view, proj, layout, vb, eye);
+                }
 
                 vkCmdEndRenderPass(cmd.buf);
             }
 
             cmd.End();
-            cmd.Exec(Platform.drawQueue);
+            cmd.Exec(Platform.drawQueue, Uploads.Submit(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
 
             // Commit changes to the textures so they get picked up by the compositor
             for (auto eye: { ovrEye_Left, ovrEye_Right })
@@ -603,12 +621,20 @@ static bool MainLoop(bool retryCreate)
             ovr_RecenterTrackingOrigin(session);
 
         // Blit mirror texture to the swapchain's back buffer
-        // For now block until we have an output to render into
+        // Only the copy from Swapchain::maxImages frames ago is waited for, the rest is ordered on the GPU by semaphores
         // The swapchain uses VK_PRESENT_MODE_IMMEDIATE_KHR or VK_PRESENT_MODE_MAILBOX_KHR to avoid blocking eye rendering
-        Platform.sc.Aquire();
+        Platform.NextPresentFrame();
+        auto& presentFrame = Platform.CurrentPresentFrame();
+        auto& xferCmd = presentFrame.cmd;
+        xferCmd.Reset();
+        if (!Platform.sc.Aquire(presentFrame.acquired))
+        {
+            // Skip the mirror this frame while the swapchain is recreated
+            ++frameIndex;
+            continue;
+        }
 
-        Platform.xferCmd.Reset();
-        Platform.xferCmd.Begin();
+        xferCmd.Begin();
 
         auto presentImage = Platform.sc.image[Platform.sc.renderImageIdx];
 
@@ -626,7 +652,7 @@ static bool MainLoop(bool retryCreate)
         presentBarrier.subresourceRange.levelCount = 1;
         presentBarrier.subresourceRange.baseArrayLayer = 0;
         presentBarrier.subresourceRange.layerCount = 1;
-        vkCmdPipelineBarrier(Platform.xferCmd.buf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+        vkCmdPipelineBarrier(xferCmd.buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
             0, nullptr,
             0, nullptr,
             1, &presentBarrier);
@@ -650,7 +676,7 @@ static bool MainLoop(bool retryCreate)
             region.dstSubresource.layerCount = 1;
             region.dstOffsets[0] = { 0, 0, 0 };
             region.dstOffsets[1] = { windowSize.w, windowSize.h, 1 };
-            vkCmdBlitImage(Platform.xferCmd.buf, mirrorTexture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            vkCmdBlitImage(xferCmd.buf, mirrorTexture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                 presentImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_LINEAR);
         #else
             // Copy using xferCmd which has VK_QUEUE_TRANSFER_BIT set and can operate asynchronously to drawCmd
@@ -666,7 +692,7 @@ static bool MainLoop(bool retryCreate)
             region.dstSubresource.layerCount = 1;
             region.dstOffset = { 0, 0, 0 };
             region.extent = { (uint32_t)windowSize.w, (uint32_t)windowSize.h, 1 };
-            vkCmdCopyImage(Platform.xferCmd.buf,
+            vkCmdCopyImage(xferCmd.buf,
                 mirrorTexture.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                 presentImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
                 1, &region);
@@ -686,19 +712,17 @@ static bool MainLoop(bool retryCreate)
         presentBarrier.subresourceRange.levelCount = 1;
         presentBarrier.subresourceRange.baseArrayLayer = 0;
         presentBarrier.subresourceRange.layerCount = 1;
-        vkCmdPipelineBarrier(Platform.xferCmd.buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
+        vkCmdPipelineBarrier(xferCmd.buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0,
             0, nullptr,
             0, nullptr,
             1, &presentBarrier);
 
-        Platform.xferCmd.End();
+        xferCmd.End();
 
-        Platform.xferCmd.Exec(Platform.xferQueue);
-        Platform.xferCmd.Wait();
-
-        // For now just block on Aquire's fence, could use a semaphore with e.g.:
-        // Platform.sc.Present(Platform.xferQueue, Platform.xferDone);
-        Platform.sc.Present(Platform.xferQueue, VK_NULL_HANDLE);
+        // The copy waits (at the transfer stage the barrier above starts from) for the image to be acquired,
+        // and the present for the copy
+        xferCmd.Exec(Platform.xferQueue, presentFrame.acquired, VK_PIPELINE_STAGE_TRANSFER_BIT, presentFrame.copied);
+        Platform.sc.Present(Platform.xferQueue, presentFrame.copied);
 
         ++frameIndex;
     }
@@ -706,6 +730,10 @@ static bool MainLoop(bool retryCreate)
 Done:
     Debug.Log("Exiting main loop...");
 
+    // Frames in flight still use the scene's buffers and command buffers
+    if (Platform.device)
+        vkDeviceWaitIdle(Platform.device);
+
     roomScene.Release();
 
     vb.Release();
@@ -719,6 +747,7 @@ Done:
         perEye[eye].Release();
     }
 
+    Uploads.Release();
     Platform.ReleaseDevice();
     ovr_Destroy(session);
 
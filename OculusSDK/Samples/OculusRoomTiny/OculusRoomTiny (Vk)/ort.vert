@@ -3,7 +3,7 @@
 #extension GL_ARB_separate_shader_objects : enable
 #extension GL_ARB_shading_language_420pack : enable
 
-layout (std140, push_constant) uniform buf
+layout (std140, set = 1, binding = 0) uniform buf
 {
     mat4 mvp;
 } ubuf;
@@ -72,8 +72,8 @@ int WINAPI WinMain(HINSTANCE hinst, HINSTANCE, LPSTR, int)
 
         // Decide if allowing parallelism, with subsequent 
         // addition of extra frame of latency
-        if (DIRECTX.Key['1']) appRenderVR.DistortAndPresent(0,0,0,0,false);
-        else                  appRenderVR.DistortAndPresent(0,0,0,0,true);
+        appRenderVR.Pipeline.SetDepth(DIRECTX.Key['1'] ? 2 : 1);
+        appRenderVR.DistortAndPresent();
     }
 
     return (appRenderVR.Release(hinst));
@@ -22,14 +22,26 @@ limitations under the License.
 #ifndef OVR_Win32_AppRendered_h
 #define OVR_Win32_AppRendered_h
 
+#include "Win32_FramePipeline.h"
+
 struct AppRenderVR : BasicVR
 {
     // Additional structures needed
     Model * pLatencyTestModel;
     Model * DistModel[2];
 
+    // Frames the GPU may still be drawing.  Stage 0 is the CPU submitting a frame, stage 1 the
+    // GPU drawing it, so Pipeline's depth trades latency (1) against CPU/GPU overlap (2 or more).
+    struct GpuFrame
+    {
+        ID3D11Query * Done;
+        GpuFrame() : Done(0) {}
+    };
+    FramePipeline<GpuFrame> Pipeline;
+    GpuFrame *              CurrentFrame;
+
     //--------------------------------------------------------------------------
-    AppRenderVR(HINSTANCE hinst) : BasicVR(hinst)
+    AppRenderVR(HINSTANCE hinst) : BasicVR(hinst), Pipeline(2, 1), CurrentFrame(0)
     {
     }
 
@@ -123,13 +135,30 @@ struct AppRenderVR : BasicVR
     //------------------------------------------------------
     void BeginFrame()
     {
+        // Wait for the GPU to finish frames, until the pipeline's depth leaves room for this one
+        while (!(CurrentFrame = Pipeline.TryBegin(0)))
+            RetireGpuFrames();
+        if (!CurrentFrame->Done)
+        {
+            D3D11_QUERY_DESC queryDesc = { D3D11_QUERY_EVENT, 0 };
+            DIRECTX.Device->CreateQuery(&queryDesc, &CurrentFrame->Done);
+        }
+
         // Start timing
         ovr_BeginFrameTiming(HMD, 0); 
     }
 
+    //------------------------------------------------------
+    void RetireGpuFrames()
+    {
+        GpuFrame * drawing = Pipeline.Current(1) ? Pipeline.Current(1) : Pipeline.TryBegin(1);
+        if (drawing && (DIRECTX.Context->GetData(drawing->Done, 0, 0, 0) == S_OK))
+            Pipeline.End(1);
+    }
+
     //----------------------------------------------------------------------------------
     void DistortAndPresent(Texture * leftEyeTexture = 0, ovrPosef * leftEyePose = 0,
-                            double debugTimeAdjuster = 0, Quatf * extraQuat = 0, bool waitForGPU = true)
+                            double debugTimeAdjuster = 0, Quatf * extraQuat = 0)
     {
         // Use defaults where none specified
         Texture * useEyeTexture[2]    = {pEyeRenderTexture[0],pEyeRenderTexture[1]};
@@ -176,13 +205,14 @@ struct AppRenderVR : BasicVR
 
         DIRECTX.SwapChain->Present(true, 0); // Vsync enabled
 
+        // Hand the frame over to the GPU stage; the next BeginFrame waits on it if the depth is used up
+        DIRECTX.Context->End(CurrentFrame->Done);
+        Pipeline.End(0);
+        RetireGpuFrames();
+
         // Only flush GPU for ExtendDesktop; not needed in Direct App Rendering with Oculus driver.
         if (HMD->HmdCaps & ovrHmdCap_ExtendDesktop)
-        {
             DIRECTX.Context->Flush();
-            if (waitForGPU) 
-                Util.WaitUntilGpuIdle();
-        }
         Util.OutputFrameTime(ovr_GetTimeInSeconds());
         ovr_EndFrameTiming(HMD);
     }
@@ -24,6 +24,7 @@ limitations under the License.
 
 #include <cstdlib>
 #include <algorithm>
+#include <atomic>
 
 #if defined(_MSC_VER)
     #pragma warning(disable: 4351) // new behavior: elements of array will be default initialized
@@ -117,6 +118,136 @@ struct OculusTexture
 	}
 };
 
+//------------------------------------------------------------
+// Lets another thread render the content of a layer, such as a quad, at its own rate.
+// The producer thread calls BeginUpdate, draws with the deferred context it returns
+// into the render target it is given, and calls EndUpdate.  The render thread calls
+// Latch before submitting the frame, which plays back the most recently finished
+// update, if there is a new one, and commits it to the swap chain, so the layer
+// otherwise keeps showing its last image without waiting on the producer.
+// The three slots are handed between the threads through one atomic index, so
+// neither thread ever blocks the other.  A swap chain's index only moves on when
+// it is committed, from the render thread, so the producer draws into its own
+// textures, which are copied across.
+struct AsyncLayerTexture
+{
+    static const int            SlotCount = 3;
+    static const int            NewFlag = 4;
+
+    OculusTexture               Texture;
+    ID3D11DeviceContext       * DeferredContext;
+    ID3D11Texture2D           * SlotTex[SlotCount];
+    ID3D11RenderTargetView    * SlotRtv[SlotCount];
+    ID3D11CommandList         * SlotCommands[SlotCount];
+    int                         WriteSlot;      // Owned by the producer
+    int                         ReadSlot;       // Owned by the render thread
+    std::atomic<int>            Latest;         // The slot between them, with NewFlag once written
+    int                         LatchCount;
+
+    AsyncLayerTexture() :
+        DeferredContext(nullptr),
+        SlotTex(),
+        SlotRtv(),
+        SlotCommands(),
+        WriteSlot(0),
+        ReadSlot(1),
+        Latest(2),
+        LatchCount(0)
+    {
+    }
+
+    bool Init(ovrSession session, int sizeW, int sizeH)
+    {
+        if (!Texture.Init(session, sizeW, sizeH))
+            return false;
+        if (FAILED(DIRECTX.Device->CreateDeferredContext(0, &DeferredContext)))
+            return false;
+
+        // Typeless to match the swap chain's textures, for CopyResource
+        D3D11_TEXTURE2D_DESC dsDesc = {};
+        dsDesc.Width = sizeW;
+        dsDesc.Height = sizeH;
+        dsDesc.MipLevels = 1;
+        dsDesc.ArraySize = 1;
+        dsDesc.Format = DXGI_FORMAT_R8G8B8A8_TYPELESS;
+        dsDesc.SampleDesc.Count = 1;
+        dsDesc.Usage = D3D11_USAGE_DEFAULT;
+        dsDesc.BindFlags = D3D11_BIND_RENDER_TARGET;
+
+        D3D11_RENDER_TARGET_VIEW_DESC rtvd = {};
+        rtvd.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        rtvd.ViewDimension = D3D11_RTV_DIMENSION_TEXTURE2D;
+
+        for (int i = 0; i < SlotCount; ++i)
+        {
+            if (FAILED(DIRECTX.Device->CreateTexture2D(&dsDesc, nullptr, &SlotTex[i])) ||
+                FAILED(DIRECTX.Device->CreateRenderTargetView(SlotTex[i], &rtvd, &SlotRtv[i])))
+                return false;
+        }
+        return true;
+    }
+
+    ~AsyncLayerTexture()
+    {
+        for (int i = 0; i < SlotCount; ++i)
+        {
+            Release(SlotCommands[i]);
+            Release(SlotRtv[i]);
+            Release(SlotTex[i]);
+        }
+        Release(DeferredContext);
+    }
+
+    // Producer thread.  Clears the render target and sets it, and the viewport, on the
+    // context; anything drawing with it must use it rather than DIRECTX.Context.
+    ID3D11DeviceContext * BeginUpdate(ID3D11RenderTargetView ** rtv = 0, float red = 0, float green = 0, float blue = 0, float alpha = 0)
+    {
+        // The slot may still hold an update the render thread never got to
+        Release(SlotCommands[WriteSlot]);
+
+        float color[] = { red, green, blue, alpha };
+        DeferredContext->OMSetRenderTargets(1, &SlotRtv[WriteSlot], nullptr);
+        DeferredContext->ClearRenderTargetView(SlotRtv[WriteSlot], color);
+        D3D11_VIEWPORT D3Dvp = { 0, 0, (float)Texture.SizeW, (float)Texture.SizeH, 0, 1 };
+        DeferredContext->RSSetViewports(1, &D3Dvp);
+        if (rtv) *rtv = SlotRtv[WriteSlot];
+        return DeferredContext;
+    }
+
+    // Producer thread.  Publishes the update, taking back whichever slot it replaces.
+    void EndUpdate()
+    {
+        DeferredContext->FinishCommandList(FALSE, &SlotCommands[WriteSlot]);
+        WriteSlot = Latest.exchange(WriteSlot | NewFlag, std::memory_order_acq_rel) & (NewFlag - 1);
+    }
+
+    // Render thread, before ovr_SubmitFrame.  Returns whether the layer changed.
+    bool Latch()
+    {
+        if (!(Latest.load(std::memory_order_acquire) & NewFlag))
+            return false;
+        ReadSlot = Latest.exchange(ReadSlot, std::memory_order_acq_rel) & (NewFlag - 1);
+
+        DIRECTX.Context->ExecuteCommandList(SlotCommands[ReadSlot], TRUE);
+        Release(SlotCommands[ReadSlot]);
+
+        int currentIndex = 0;
+        ovr_GetTextureSwapChainCurrentIndex(Texture.Session, Texture.TextureChain, &currentIndex);
+        ID3D11Texture2D* tex = nullptr;
+        ovr_GetTextureSwapChainBufferDX(Texture.Session, Texture.TextureChain, currentIndex, IID_PPV_ARGS(&tex));
+        DIRECTX.Context->CopyResource(tex, SlotTex[ReadSlot]);
+        tex->Release();
+
+        Texture.Commit();
+        ++LatchCount;
+        return true;
+    }
+
+    // Render thread.  False until the producer's first update has been latched, as
+    // the swap chain holds nothing worth showing before then.
+    bool HasContent() const { return LatchCount > 0; }
+};
+
 //------------------------------------------------------------------------------------
 //Helper functions to convert from Oculus types to XM types - consider to add to SDK
 inline XMVECTOR ConvertToXM(ovrQuatf q)    { return(XMVectorSet(q.x, q.y, q.z, q.w)); }
@@ -298,6 +429,113 @@ struct VRLayer
     }
 };
 
+//----------------------------------------------------------------------
+// Picks the fraction of a layer's eye textures to render into, from the perf stats
+// the compositor reports, so the app keeps up with the display as its GPU load varies.
+// The swap chains keep their size; only the viewport within them is scaled.
+// It scales down as soon as frames are dropped, or the GPU time passes HighWater of
+// the frame, and only scales up after the GPU time has stayed under LowWater for
+// FramesToRaise frames, so it doesn't flip between two sizes.  Each change waits
+// Cooldown frames before the next, as the stats lag the frames by a few.
+struct AdaptiveResolution
+{
+    ovrSession                  Session;
+    float                       FrameBudget;        // Seconds per display refresh
+    float                       Scale;              // Of each axis
+    float                       MinScale, MaxScale;
+    float                       HighWater, LowWater;
+    float                       RaiseStep;
+    int                         FramesToRaise;
+    int                         Cooldown;
+    int                         FramesUnderLow;
+    int                         FramesSinceChange;
+    int                         LastDroppedFrameCount;
+    int                         LastAppFrameIndex;
+
+    AdaptiveResolution(ovrSession session, float minScale = 0.5f, float maxScale = 1.0f) :
+        Session(session),
+        FrameBudget(1.0f / ovr_GetHmdDesc(session).DisplayRefreshRate),
+        Scale(maxScale),
+        MinScale(minScale),
+        MaxScale(maxScale),
+        HighWater(0.9f),
+        LowWater(0.7f),
+        RaiseStep(0.05f),
+        FramesToRaise(45),
+        Cooldown(10),
+        FramesUnderLow(0),
+        FramesSinceChange(0),
+        LastDroppedFrameCount(-1),
+        LastAppFrameIndex(-1)
+    {
+    }
+
+    // Call once a frame, after submitting it.  Returns whether Scale changed.
+    bool Update()
+    {
+        ovrPerfStats perfStats = {};
+        if (!OVR_SUCCESS(ovr_GetPerfStats(Session, &perfStats)) || perfStats.FrameStatsCount == 0)
+            return false;
+
+        // Entries are newest first; take the worst of those since the last call
+        const ovrPerfStatsPerCompositorFrame & latest = perfStats.FrameStats[0];
+        float gpuTime = 0;
+        for (int i = 0; i < perfStats.FrameStatsCount; ++i)
+        {
+            if (perfStats.FrameStats[i].AppFrameIndex <= LastAppFrameIndex)
+                break;
+            gpuTime = std::max(gpuTime, perfStats.FrameStats[i].AppGpuElapsedTime);
+        }
+        bool dropped = (LastDroppedFrameCount >= 0) && (latest.AppDroppedFrameCount > LastDroppedFrameCount);
+        LastDroppedFrameCount = latest.AppDroppedFrameCount;
+        LastAppFrameIndex = latest.AppFrameIndex;
+
+        if ((++FramesSinceChange < Cooldown) || ((gpuTime <= 0) && !dropped))
+            return false;
+
+        float newScale = Scale;
+        if (perfStats.AdaptiveGpuPerformanceScale < 1.0f)
+        {
+            // It is for the pixel count, so the square root for each axis
+            newScale = Scale * sqrtf(perfStats.AdaptiveGpuPerformanceScale);
+        }
+        else if (dropped || (gpuTime > HighWater * FrameBudget))
+        {
+            // Aim for between the two marks, and at least one step down
+            float targetTime = 0.5f * (HighWater + LowWater) * FrameBudget;
+            FramesUnderLow = 0;
+            newScale = std::min(Scale - RaiseStep, Scale * sqrtf(targetTime / std::max(gpuTime, targetTime)));
+        }
+        else if (gpuTime < LowWater * FrameBudget)
+        {
+            if (++FramesUnderLow >= FramesToRaise)
+                newScale = Scale + RaiseStep;
+        }
+        else
+        {
+            FramesUnderLow = 0;
+        }
+
+        newScale = std::max(MinScale, std::min(MaxScale, newScale));
+        if (newScale == Scale)
+            return false;
+        Scale = newScale;
+        FramesUnderLow = 0;
+        FramesSinceChange = 0;
+        return true;
+    }
+
+    // Sets the layer's viewports to Scale of its eye textures.
+    void Apply(VRLayer * layer)
+    {
+        for (int eye = 0; eye < 2; ++eye)
+        {
+            layer->EyeRenderViewport[eye].Size.w = std::max(1, int(layer->pEyeRenderTexture[eye]->SizeW * Scale));
+            layer->EyeRenderViewport[eye].Size.h = std::max(1, int(layer->pEyeRenderTexture[eye]->SizeH * Scale));
+        }
+    }
+};
+
 //----------------------------------------------------------------------------------------
 struct BasicVR
 {
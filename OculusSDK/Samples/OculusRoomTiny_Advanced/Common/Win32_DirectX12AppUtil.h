@@ -27,10 +27,15 @@ limitations under the License.
 #include <dxgi1_4.h>
 #include <new>
 #include <stdio.h>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 #include "DirectXMath.h"
 using namespace DirectX;
 
 #include "Win32_d3dx12.h"
+#include "Win32_FrameGraph.h"
 
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "d3d12.lib")
@@ -133,6 +138,8 @@ struct DataBuffer
 };
 
 ////----------------------------------------------------------------
+// Hands out long-lived descriptors from the first handleCount slots of a heap, reusing freed ones.
+// Not thread safe; the rest of the heap may be given to a DescRingProvider.
 struct DescHandleProvider
 {
     ID3D12DescriptorHeap*         DescHeap;
@@ -140,6 +147,7 @@ struct DescHandleProvider
     UINT IncrementSize;
     UINT CurrentHandleCount;
     UINT MaxHandleCount;
+    std::vector<SIZE_T>           FreeHandles;
     DescHandleProvider() {};
     DescHandleProvider(ID3D12DescriptorHeap* descHeap, UINT incrementSize, UINT handleCount)
         : DescHeap(descHeap), IncrementSize(incrementSize)
@@ -151,6 +159,13 @@ struct DescHandleProvider
 
     CD3DX12_CPU_DESCRIPTOR_HANDLE AllocCpuHandle()
     {
+        if (!FreeHandles.empty())
+        {
+            D3D12_CPU_DESCRIPTOR_HANDLE freeHandle = { FreeHandles.back() };
+            FreeHandles.pop_back();
+            return CD3DX12_CPU_DESCRIPTOR_HANDLE(freeHandle);
+        }
+
         VALIDATE((CurrentHandleCount < MaxHandleCount), "Hit maximum number of handles available");
         CD3DX12_CPU_DESCRIPTOR_HANDLE newHandle = NextAvailableCpuHandle;
         NextAvailableCpuHandle.Offset(IncrementSize);
@@ -158,6 +173,13 @@ struct DescHandleProvider
         return newHandle;
     }
 
+    // Once the GPU is done with anything using the handle
+    void FreeCpuHandle(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle)
+    {
+        if (cpuHandle.ptr)
+            FreeHandles.push_back(cpuHandle.ptr);
+    }
+
     CD3DX12_GPU_DESCRIPTOR_HANDLE GpuHandleFromCpuHandle(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle)
     {
         int offset = (int)(cpuHandle.ptr - DescHeap->GetCPUDescriptorHandleForHeapStart().ptr);
@@ -165,6 +187,112 @@ struct DescHandleProvider
     }
 };
 
+// A ring of shader visible descriptors at the end of a heap, split evenly between the frames in flight.
+// A frame's descriptors last until BeginFrame is called for it again, which the caller does once the
+// GPU is done with that frame.  Alloc is safe to call from several threads at once.
+struct DescRingProvider
+{
+    ID3D12DescriptorHeap*         DescHeap;
+    UINT                          IncrementSize;
+    UINT                          FirstHandle;
+    UINT                          HandlesPerFrame;
+    UINT                          FrameStart;
+    volatile LONG                 FrameOffset;
+
+    DescRingProvider() : DescHeap(nullptr), IncrementSize(0), FirstHandle(0), HandlesPerFrame(0), FrameStart(0), FrameOffset(0) {}
+    DescRingProvider(ID3D12DescriptorHeap* descHeap, UINT incrementSize, UINT firstHandle, UINT handlesPerFrame)
+        : DescHeap(descHeap), IncrementSize(incrementSize), FirstHandle(firstHandle)
+        , HandlesPerFrame(handlesPerFrame), FrameStart(firstHandle), FrameOffset(0)
+    {
+        VALIDATE((descHeap), "NULL heap provided");
+    }
+
+    void BeginFrame(UINT frameIdx)
+    {
+        FrameStart = FirstHandle + frameIdx * HandlesPerFrame;
+        FrameOffset = 0;
+    }
+
+    // Returns the first of count contiguous descriptors, for filling with CopyDescriptorsSimple
+    // or Create*View through cpuHandle, and binding as a table through gpuHandle
+    void Alloc(UINT count, D3D12_CPU_DESCRIPTOR_HANDLE* cpuHandle, D3D12_GPU_DESCRIPTOR_HANDLE* gpuHandle)
+    {
+        UINT offset = (UINT)InterlockedExchangeAdd(&FrameOffset, (LONG)count);
+        VALIDATE((offset + count <= HandlesPerFrame), "Hit maximum number of frame descriptors available");
+
+        *cpuHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(DescHeap->GetCPUDescriptorHandleForHeapStart(), FrameStart + offset, IncrementSize);
+        *gpuHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(DescHeap->GetGPUDescriptorHandleForHeapStart(), FrameStart + offset, IncrementSize);
+    }
+};
+
+//---------------------------------------------------------------------
+// Persistent worker threads, each of which runs Work(threadIdx) when woken by Run
+struct WorkerThreadPool
+{
+    std::vector<std::thread>    Threads;
+    std::mutex                  Mutex;
+    std::condition_variable     WorkReady;
+    std::condition_variable     WorkDone;
+    std::function<void(int)>    Work;
+    UINT64                      Generation = 0;
+    int                         Pending = 0;
+    bool                        Quit = false;
+
+    bool IsStarted() const { return !Threads.empty(); }
+
+    void Start(int threadCount)
+    {
+        Quit = false;
+        for (int threadIdx = 0; threadIdx < threadCount; threadIdx++)
+            Threads.emplace_back(&WorkerThreadPool::ThreadMain, this, threadIdx);
+    }
+
+    // Blocks until every thread has run work
+    void Run(const std::function<void(int)>& work)
+    {
+        std::unique_lock<std::mutex> lock(Mutex);
+        Work = work;
+        Pending = (int)Threads.size();
+        Generation++;
+        WorkReady.notify_all();
+        WorkDone.wait(lock, [this] { return Pending == 0; });
+        Work = nullptr;
+    }
+
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            Quit = true;
+        }
+        WorkReady.notify_all();
+        for (auto& thread : Threads)
+            thread.join();
+        Threads.clear();
+    }
+
+    void ThreadMain(int threadIdx)
+    {
+        UINT64 seenGeneration = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(Mutex);
+                WorkReady.wait(lock, [&] { return Quit || (Generation != seenGeneration); });
+                if (Quit)
+                    return;
+                seenGeneration = Generation;
+            }
+
+            Work(threadIdx);
+
+            std::lock_guard<std::mutex> lock(Mutex);
+            if (--Pending == 0)
+                WorkDone.notify_one();
+        }
+    }
+};
+
 enum DrawContext
 {
     DrawContext_EyeRenderLeft = 0,
@@ -198,33 +326,66 @@ struct DirectX12
     DescHandleProvider          RtvHandleProvider;
     DescHandleProvider          DsvHandleProvider;
     DescHandleProvider          CbvSrvHandleProvider;
+    DescRingProvider            CbvSrvFrameRing;
+    static const UINT           FrameDescriptorCount = 1024;    // Per frame in flight, in CbvSrvFrameRing
 
     IDXGISwapChain3*            SwapChain;
     static const int            SwapChainNumFrames = 4;
     UINT                        SwapChainFrameIndex;
+    ID3D12Resource*             SwapChainBuffers[SwapChainNumFrames];
+    CD3DX12_CPU_DESCRIPTOR_HANDLE SwapChainRtvHandles[SwapChainNumFrames];
+
+    // How many frames the host may record ahead of the GPU, independent of the swap chain length
+    static const int            FramesInFlight = 3;
+    static const UINT64         UploadRingSize = 1024 * 1024;   // Per frame, for UploadConstants
+    UINT                        FrameIndex;
+
+    // For RecordParallel: each eye's scene is split into RecordPartitions, and each of the resulting
+    // command lists is recorded on its own worker thread
+    static const int            RecordPartitions = 2;
+    static const int            RecordListCount = 2 * RecordPartitions;
+    WorkerThreadPool            RecordThreads;
 
     int                         EyeMsaaRate;  // not for the back buffer, just the eye textures
     DXGI_FORMAT                 DepthFormat;
     UINT                        ActiveEyeIndex;
     DrawContext                 ActiveContext;
 
-    // per-swap-chain-frame resources
-    struct SwapChainFrameResources
+    // per-frame-in-flight resources, which the host reuses once FrameFence passes FenceValue
+    struct FrameResources
     {
         ID3D12CommandAllocator*         CommandAllocators[DrawContext_Count];
         ID3D12GraphicsCommandList*      CommandLists[DrawContext_Count];
         bool                            CommandListSubmitted[DrawContext_Count];
 
-        ID3D12Resource*                 SwapChainBuffer;
-        CD3DX12_CPU_DESCRIPTOR_HANDLE   SwapChainRtvHandle;
+        // One allocator per list, so each worker thread only touches its own
+        ID3D12CommandAllocator*         RecordAllocators[RecordListCount];
+        ID3D12GraphicsCommandList*      RecordLists[RecordListCount];
+
+        UINT64                          FenceValue;     // 0 until the frame is first submitted
 
-        // Synchronization objects.
-        HANDLE                          PresentFenceEvent;
-        ID3D12Fence*                    PresentFenceRes;
-        UINT64                          PresentFenceValue;
-        UINT64                          PresentFenceWaitValue;
+        // Linear allocator for the frame's constants, reset when the frame comes round again
+        ID3D12Resource*                 UploadBuffer;
+        UINT8*                          UploadMapPtr;
+        volatile LONG64                 UploadOffset;
     };
-    SwapChainFrameResources             PerFrameResources[SwapChainNumFrames];
+    FrameResources                      PerFrameResources[FramesInFlight];
+
+    // Synchronization objects.
+    ID3D12Fence*                        FrameFence;
+    HANDLE                              FrameFenceEvent;
+    UINT64                              FrameFenceValue;    // Last value signaled
+
+    // Host time spent blocked on the GPU
+    struct FrameWaitStats
+    {
+        UINT64                          FrameCount;
+        UINT64                          WaitCount;          // Frames that had to wait at all
+        double                          TotalWaitMs;
+        double                          MaxWaitMs;
+        double                          LastWaitMs;
+    };
+    FrameWaitStats                      WaitStats;
 
     static LRESULT CALLBACK WindowProc(_In_ HWND hWnd, _In_ UINT Msg, _In_ WPARAM wParam, _In_ LPARAM lParam)
     {
@@ -257,6 +418,11 @@ struct DirectX12
         WinSizeH(0),
         Device(nullptr),
         SwapChain(nullptr),
+        FrameIndex(0),
+        FrameFence(nullptr),
+        FrameFenceEvent(nullptr),
+        FrameFenceValue(0),
+        WaitStats(),
         //MainDepthBuffer(nullptr),
         hInstance(nullptr),
         ActiveContext(DrawContext_Count),   // require init by app
@@ -422,47 +588,65 @@ struct DirectX12
         }
 
         {
+            // Static handles first, then the per-frame ring
             UINT maxNumCbvSrvHandles = 100;
+            UINT numStaticHandles = maxNumCbvSrvHandles * 10;
             D3D12_DESCRIPTOR_HEAP_DESC cbvSrvHeapDesc = {};
-            cbvSrvHeapDesc.NumDescriptors = maxNumCbvSrvHandles * 10;
+            cbvSrvHeapDesc.NumDescriptors = numStaticHandles + FramesInFlight * FrameDescriptorCount;
             cbvSrvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
             cbvSrvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
             hr = Device->CreateDescriptorHeap(&cbvSrvHeapDesc, IID_PPV_ARGS(&CbvSrvHeap));
             VALIDATE((hr == ERROR_SUCCESS), "CreateDescriptorHeap failed");
 
-            CbvSrvHandleProvider = DescHandleProvider(
-                CbvSrvHeap,
-                Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV),
-                cbvSrvHeapDesc.NumDescriptors);
+            UINT incrementSize = Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+            CbvSrvHandleProvider = DescHandleProvider(CbvSrvHeap, incrementSize, numStaticHandles);
+            CbvSrvFrameRing = DescRingProvider(CbvSrvHeap, incrementSize, numStaticHandles, FrameDescriptorCount);
         }
 
-        // Create frame resources.
-        for (int frameIdx = 0; frameIdx < SwapChainNumFrames; frameIdx++)
+        // Create a RTV for each buffer in swap chain
+        for (int bufIdx = 0; bufIdx < SwapChainNumFrames; bufIdx++)
         {
-            SwapChainFrameResources& frameRes = PerFrameResources[frameIdx];
-
-            // Create a RTV for buffer in swap chain
-            frameRes.SwapChainRtvHandle = RtvHandleProvider.AllocCpuHandle();
+            SwapChainRtvHandles[bufIdx] = RtvHandleProvider.AllocCpuHandle();
 
-            hr = SwapChain->GetBuffer(frameIdx, IID_PPV_ARGS(&frameRes.SwapChainBuffer));
+            hr = SwapChain->GetBuffer(bufIdx, IID_PPV_ARGS(&SwapChainBuffers[bufIdx]));
             VALIDATE((hr == ERROR_SUCCESS), "SwapChain GetBuffer failed");
 
-            Device->CreateRenderTargetView(frameRes.SwapChainBuffer, nullptr, frameRes.SwapChainRtvHandle);
+            Device->CreateRenderTargetView(SwapChainBuffers[bufIdx], nullptr, SwapChainRtvHandles[bufIdx]);
+        }
+
+        // Create an event handle to use for frame synchronization.
+        FrameFenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+        hr = HRESULT_FROM_WIN32(GetLastError());
+        VALIDATE((hr == ERROR_SUCCESS), "CreateEvent failed");
+
+        FrameFenceValue = 0;
+        hr = Device->CreateFence(FrameFenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&FrameFence));
+        VALIDATE((hr == ERROR_SUCCESS), "CreateFence failed");
+
+        // Create frame resources.
+        FrameIndex = 0;
+        WaitStats = FrameWaitStats();
+        for (int frameIdx = 0; frameIdx < FramesInFlight; frameIdx++)
+        {
+            FrameResources& frameRes = PerFrameResources[frameIdx];
 
             for (int contextIdx = 0; contextIdx < DrawContext_Count; contextIdx++)
             {
                 Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&frameRes.CommandAllocators[contextIdx]));
             }
 
-            // Create an event handle to use for frame synchronization.
-            frameRes.PresentFenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-            hr = HRESULT_FROM_WIN32(GetLastError());
-            VALIDATE((hr == ERROR_SUCCESS), "CreateEvent failed");
+            frameRes.FenceValue = 0;
 
-            hr = Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&frameRes.PresentFenceRes));
-            VALIDATE((hr == ERROR_SUCCESS), "CreateFence failed");
+            // The upload ring stays mapped
+            CD3DX12_HEAP_PROPERTIES heapProp(D3D12_HEAP_TYPE_UPLOAD);
+            CD3DX12_RESOURCE_DESC resDesc = CD3DX12_RESOURCE_DESC::Buffer(UploadRingSize);
+            hr = Device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &resDesc,
+                D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&frameRes.UploadBuffer));
+            VALIDATE((hr == ERROR_SUCCESS), "CreateCommittedResource upload ring failed");
 
-            frameRes.PresentFenceWaitValue = UINT64(-1);
+            hr = frameRes.UploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&frameRes.UploadMapPtr));
+            VALIDATE((hr == ERROR_SUCCESS), "Upload ring Map failed");
+            frameRes.UploadOffset = 0;
 
             // Create the command lists
             for (int contextIdx = 0; contextIdx < DrawContext_Count; contextIdx++)
@@ -475,6 +659,17 @@ struct DirectX12
 
                 frameRes.CommandListSubmitted[contextIdx] = true;   // to make sure we reset it properly first time thru
             }
+
+            for (int listIdx = 0; listIdx < RecordListCount; listIdx++)
+            {
+                hr = Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&frameRes.RecordAllocators[listIdx]));
+                VALIDATE((hr == ERROR_SUCCESS), "CreateCommandAllocator failed");
+                hr = Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, frameRes.RecordAllocators[listIdx],
+                    nullptr, IID_PPV_ARGS(&frameRes.RecordLists[listIdx]));
+                VALIDATE((hr == ERROR_SUCCESS), "CreateCommandList failed");
+                frameRes.RecordLists[listIdx]->Close();
+                frameRes.RecordLists[listIdx]->SetName(L"ParallelCommandList");
+            }
         }
 
         // Main depth buffer
@@ -484,9 +679,62 @@ struct DirectX12
         return true;
     }
 
-    SwapChainFrameResources& CurrentFrameResources()
+    FrameResources& CurrentFrameResources()
     {
-        return PerFrameResources[SwapChainFrameIndex];
+        return PerFrameResources[FrameIndex];
+    }
+
+    ID3D12Resource* CurrentSwapChainBuffer()
+    {
+        return SwapChainBuffers[SwapChainFrameIndex];
+    }
+
+    // Copies data into the current frame's upload ring, returning its GPU address for a root CBV.
+    // It stays valid until the frame comes round again.  Safe to call from the RecordParallel workers.
+    D3D12_GPU_VIRTUAL_ADDRESS UploadConstants(const void* data, UINT size)
+    {
+        FrameResources& frameRes = CurrentFrameResources();
+
+        const UINT64 align = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+        const UINT64 alignedSize = (size + (align - 1)) & ~(align - 1);
+        UINT64 offset = (UINT64)InterlockedExchangeAdd64(&frameRes.UploadOffset, (LONG64)alignedSize);
+        VALIDATE((offset + alignedSize <= UploadRingSize), "Upload ring is full");
+
+        memcpy(frameRes.UploadMapPtr + offset, data, size);
+        return frameRes.UploadBuffer->GetGPUVirtualAddress() + offset;
+    }
+
+    // Records each of the current frame's RecordListCount lists on its own worker thread, calling
+    // record(listIdx, cmdList) with the list reset and its descriptor heap set, and then submits them
+    // all with one ExecuteCommandLists, in listIdx order.
+    void RecordParallel(const std::function<void(int listIdx, ID3D12GraphicsCommandList* cmdList)>& record)
+    {
+        if (!RecordThreads.IsStarted())
+            RecordThreads.Start(RecordListCount);
+
+        FrameResources& currFrameRes = CurrentFrameResources();
+        RecordThreads.Run([&](int listIdx)
+        {
+            HRESULT hr = currFrameRes.RecordAllocators[listIdx]->Reset();
+            VALIDATE((hr == ERROR_SUCCESS), "CommandAllocator Reset failed");
+
+            ID3D12GraphicsCommandList* cmdList = currFrameRes.RecordLists[listIdx];
+            hr = cmdList->Reset(currFrameRes.RecordAllocators[listIdx], nullptr);
+            VALIDATE((hr == ERROR_SUCCESS), "CommandList Reset failed");
+
+            ID3D12DescriptorHeap* heaps[] = { CbvSrvHeap };
+            cmdList->SetDescriptorHeaps(_countof(heaps), heaps);
+
+            record(listIdx, cmdList);
+
+            hr = cmdList->Close();
+            VALIDATE((hr == ERROR_SUCCESS), "CommandList Close failed");
+        });
+
+        ID3D12CommandList* ppCommandLists[RecordListCount];
+        for (int listIdx = 0; listIdx < RecordListCount; listIdx++)
+            ppCommandLists[listIdx] = currFrameRes.RecordLists[listIdx];
+        CommandQueue->ExecuteCommandLists(RecordListCount, ppCommandLists);
     }
 
     void SetActiveContext(DrawContext context)
@@ -499,13 +747,21 @@ struct DirectX12
         ActiveEyeIndex = eye;
     }
 
-    void SetAndClearRenderTarget(const D3D12_CPU_DESCRIPTOR_HANDLE* rendertarget, const D3D12_CPU_DESCRIPTOR_HANDLE* depthbuffer, float R = 0, float G = 0, float B = 0, float A = 1)
+    static void SetAndClearRenderTarget(ID3D12GraphicsCommandList* cmdList, const D3D12_CPU_DESCRIPTOR_HANDLE* rendertarget, const D3D12_CPU_DESCRIPTOR_HANDLE* depthbuffer,
+                                        bool clear, float R = 0, float G = 0, float B = 0, float A = 1)
     {
         float black[] = { R, G, B, A }; // Important that alpha=0, if want pixels to be transparent, for manual layers
-        CurrentFrameResources().CommandLists[ActiveContext]->OMSetRenderTargets(1, rendertarget, false, depthbuffer);
-        CurrentFrameResources().CommandLists[ActiveContext]->ClearRenderTargetView(*rendertarget, black, 0, nullptr);
+        cmdList->OMSetRenderTargets(1, rendertarget, false, depthbuffer);
+        if (!clear)
+            return;
+        cmdList->ClearRenderTargetView(*rendertarget, black, 0, nullptr);
         if (depthbuffer)
-            CurrentFrameResources().CommandLists[ActiveContext]->ClearDepthStencilView(*depthbuffer, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+            cmdList->ClearDepthStencilView(*depthbuffer, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+    }
+
+    void SetAndClearRenderTarget(const D3D12_CPU_DESCRIPTOR_HANDLE* rendertarget, const D3D12_CPU_DESCRIPTOR_HANDLE* depthbuffer, float R = 0, float G = 0, float B = 0, float A = 1)
+    {
+        SetAndClearRenderTarget(CurrentFrameResources().CommandLists[ActiveContext], rendertarget, depthbuffer, true, R, G, B, A);
     }
 
     void SetAndClearRenderTarget(const D3D12_CPU_DESCRIPTOR_HANDLE& rendertarget, const D3D12_CPU_DESCRIPTOR_HANDLE& depthbuffer, float R = 0, float G = 0, float B = 0, float A = 1)
@@ -514,12 +770,17 @@ struct DirectX12
     }
 
     void SetViewport(float vpX, float vpY, float vpW, float vpH)
+    {
+        SetViewport(CurrentFrameResources().CommandLists[ActiveContext], vpX, vpY, vpW, vpH);
+    }
+
+    static void SetViewport(ID3D12GraphicsCommandList* cmdList, float vpX, float vpY, float vpW, float vpH)
     {
         D3D12_VIEWPORT D3Dvp;
         D3Dvp.Width = vpW;    D3Dvp.Height = vpH;
         D3Dvp.MinDepth = 0;   D3Dvp.MaxDepth = 1;
         D3Dvp.TopLeftX = vpX; D3Dvp.TopLeftY = vpY;
-        CurrentFrameResources().CommandLists[ActiveContext]->RSSetViewports(1, &D3Dvp);
+        cmdList->RSSetViewports(1, &D3Dvp);
 
         D3D12_RECT scissorRect;
         scissorRect.left    = static_cast<LONG>(vpX);
@@ -527,7 +788,7 @@ struct DirectX12
         scissorRect.top     = static_cast<LONG>(vpY);
         scissorRect.bottom  = static_cast<LONG>(vpY + vpH);
 
-        CurrentFrameResources().CommandLists[ActiveContext]->RSSetScissorRects(1, &scissorRect);
+        cmdList->RSSetScissorRects(1, &scissorRect);
     }
 
     bool HandleMessages(void)
@@ -564,6 +825,12 @@ struct DirectX12
 
     void ReleaseDevice()
     {
+        // Frames may still be in flight
+        if (FrameFence)
+            WaitForGpu();
+        if (RecordThreads.IsStarted())
+            RecordThreads.Stop();
+
         if (SwapChain)
         {
             SwapChain->SetFullscreenState(FALSE, NULL);
@@ -571,15 +838,30 @@ struct DirectX12
         }
         for (int i = 0; i < SwapChainNumFrames; i++)
         {
-            SwapChainFrameResources& currFrameRes = PerFrameResources[i];
-            Release(currFrameRes.SwapChainBuffer);
+            Release(SwapChainBuffers[i]);
+        }
+        for (int i = 0; i < FramesInFlight; i++)
+        {
+            FrameResources& currFrameRes = PerFrameResources[i];
 
             for (int contextIdx = 0; contextIdx < DrawContext_Count; contextIdx++)
             {
                 Release(currFrameRes.CommandAllocators[contextIdx]);
                 Release(currFrameRes.CommandLists[contextIdx]);
             }
-            Release(currFrameRes.PresentFenceRes);
+            for (int listIdx = 0; listIdx < RecordListCount; listIdx++)
+            {
+                Release(currFrameRes.RecordAllocators[listIdx]);
+                Release(currFrameRes.RecordLists[listIdx]);
+            }
+            Release(currFrameRes.UploadBuffer);
+            currFrameRes.UploadMapPtr = nullptr;
+        }
+        Release(FrameFence);
+        if (FrameFenceEvent)
+        {
+            CloseHandle(FrameFenceEvent);
+            FrameFenceEvent = nullptr;
         }
         Release(RtvHeap);
         Release(DsvHeap);
@@ -592,7 +874,7 @@ struct DirectX12
 
     void InitCommandList(DrawContext context)
     {
-        SwapChainFrameResources& currFrameRes = CurrentFrameResources();
+        FrameResources& currFrameRes = CurrentFrameResources();
 
         if (currFrameRes.CommandListSubmitted[context])
         {
@@ -619,53 +901,73 @@ struct DirectX12
             InitCommandList((DrawContext)bufIdx);
         }
 
-        SwapChainFrameResources& currFrameRes = CurrentFrameResources();
+        FrameResources& currFrameRes = CurrentFrameResources();
 
         if (finalContextUsed)
         {
             CD3DX12_RESOURCE_BARRIER rb = CD3DX12_RESOURCE_BARRIER::Transition(
-                currFrameRes.SwapChainBuffer,
+                CurrentSwapChainBuffer(),
                 D3D12_RESOURCE_STATE_PRESENT,
                 D3D12_RESOURCE_STATE_RENDER_TARGET);
             currFrameRes.CommandLists[DrawContext_Final]->ResourceBarrier(1, &rb);
         }
     }
 
-    void WaitForPreviousFrame()
+    // Blocks until the GPU has passed fenceValue, adding any wait to WaitStats
+    void WaitForFence(UINT64 fenceValue)
     {
+        if (FrameFence->GetCompletedValue() >= fenceValue)
         {
-            DirectX12::SwapChainFrameResources& currFrameRes = CurrentFrameResources();
+            WaitStats.LastWaitMs = 0;
+            return;
+        }
 
-            // Signal and increment the fence value.
-            currFrameRes.PresentFenceWaitValue = currFrameRes.PresentFenceValue;
-            HRESULT hr = CommandQueue->Signal(currFrameRes.PresentFenceRes, currFrameRes.PresentFenceWaitValue);
-            VALIDATE((hr == ERROR_SUCCESS), "CommandQueue Signal failed");
-            currFrameRes.PresentFenceValue++;
+        LARGE_INTEGER freq, start, end;
+        QueryPerformanceFrequency(&freq);
+        QueryPerformanceCounter(&start);
 
-            currFrameRes.PresentFenceRes->SetEventOnCompletion(currFrameRes.PresentFenceWaitValue, currFrameRes.PresentFenceEvent);
-            VALIDATE((hr == ERROR_SUCCESS), "SetEventOnCompletion failed");
-        }
+        HRESULT hr = FrameFence->SetEventOnCompletion(fenceValue, FrameFenceEvent);
+        VALIDATE((hr == ERROR_SUCCESS), "SetEventOnCompletion failed");
+        WaitForSingleObject(FrameFenceEvent, 10000);
 
-        // goto next frame index and start waiting for the fence - ideally we don't wait at all
-        {
-            SwapChainFrameIndex = (SwapChainFrameIndex + 1) % SwapChainNumFrames;
-            DirectX12::SwapChainFrameResources& currFrameRes = CurrentFrameResources();
+        QueryPerformanceCounter(&end);
+        WaitStats.LastWaitMs = double(end.QuadPart - start.QuadPart) * 1000.0 / double(freq.QuadPart);
+        WaitStats.TotalWaitMs += WaitStats.LastWaitMs;
+        if (WaitStats.LastWaitMs > WaitStats.MaxWaitMs)
+            WaitStats.MaxWaitMs = WaitStats.LastWaitMs;
+        WaitStats.WaitCount++;
+    }
 
-            // Wait until the previous frame is finished.
-            if (currFrameRes.PresentFenceWaitValue != -1 && // -1 means we never kicked off this frame
-                currFrameRes.PresentFenceRes->GetCompletedValue() < currFrameRes.PresentFenceWaitValue)
-            {
-                WaitForSingleObject(currFrameRes.PresentFenceEvent, 10000);
-            }
+    // Signals the fence after everything submitted so far, and waits for it
+    void WaitForGpu()
+    {
+        HRESULT hr = CommandQueue->Signal(FrameFence, ++FrameFenceValue);
+        VALIDATE((hr == ERROR_SUCCESS), "CommandQueue Signal failed");
+        WaitForFence(FrameFenceValue);
+    }
 
-            VALIDATE((SwapChainFrameIndex == SwapChain->GetCurrentBackBufferIndex()), "Swap chain index validation failed");
-            //SwapChainFrameIndex = SwapChain->GetCurrentBackBufferIndex();
-        }
+    void WaitForPreviousFrame()
+    {
+        // Signal the end of this frame's work...
+        HRESULT hr = CommandQueue->Signal(FrameFence, ++FrameFenceValue);
+        VALIDATE((hr == ERROR_SUCCESS), "CommandQueue Signal failed");
+        CurrentFrameResources().FenceValue = FrameFenceValue;
+
+        // ...and go on to the oldest frame in flight, which only has to be waited for if the GPU
+        // has fallen FramesInFlight frames behind - ideally we don't wait at all
+        FrameIndex = (FrameIndex + 1) % FramesInFlight;
+        FrameResources& currFrameRes = CurrentFrameResources();
+        WaitForFence(currFrameRes.FenceValue);
+        WaitStats.FrameCount++;
+
+        currFrameRes.UploadOffset = 0;
+        CbvSrvFrameRing.BeginFrame(FrameIndex);
+        SwapChainFrameIndex = SwapChain->GetCurrentBackBufferIndex();
     }
 
     void SubmitCommandList(DrawContext context)
     {
-        DirectX12::SwapChainFrameResources& currFrameRes = CurrentFrameResources();
+        DirectX12::FrameResources& currFrameRes = CurrentFrameResources();
 
         HRESULT hr = currFrameRes.CommandLists[context]->Close();
         VALIDATE((hr == ERROR_SUCCESS), "CommandList Close failed");
@@ -680,13 +982,13 @@ struct DirectX12
     {
         if (finalContextUsed)
         {
-            DirectX12::SwapChainFrameResources& currFrameRes = CurrentFrameResources();
+            DirectX12::FrameResources& currFrameRes = CurrentFrameResources();
 
             VALIDATE(ActiveContext == DrawContext_Final, "Invalid context set before Present");
 
             // Indicate that the back buffer will now be used to present.
             CD3DX12_RESOURCE_BARRIER rb = CD3DX12_RESOURCE_BARRIER::Transition(
-                currFrameRes.SwapChainBuffer,
+                CurrentSwapChainBuffer(),
                 D3D12_RESOURCE_STATE_COPY_DEST,
                 D3D12_RESOURCE_STATE_PRESENT);
             currFrameRes.CommandLists[ActiveContext]->ResourceBarrier(1, &rb);
@@ -707,6 +1009,62 @@ struct DirectX12
 // global DX12 state
 static struct DirectX12 DIRECTX;
 
+//---------------------------------------------------------------------
+// Maps a FrameGraph onto D3D12: each pass's transitions go in one ResourceBarrier call on the
+// ID3D12GraphicsCommandList given as the context, and transients are committed textures
+struct FrameGraphD3D12 : public FrameGraphBackend
+{
+    static D3D12_RESOURCE_STATES State(FrameGraphUsage usage)
+    {
+        switch (usage)
+        {
+        case FrameGraphUsage_RenderTarget:  return D3D12_RESOURCE_STATE_RENDER_TARGET;
+        case FrameGraphUsage_DepthWrite:    return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+        case FrameGraphUsage_DepthRead:     return D3D12_RESOURCE_STATE_DEPTH_READ;
+        case FrameGraphUsage_ShaderRead:    return D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+        case FrameGraphUsage_CopySource:    return D3D12_RESOURCE_STATE_COPY_SOURCE;
+        case FrameGraphUsage_CopyDest:      return D3D12_RESOURCE_STATE_COPY_DEST;
+        case FrameGraphUsage_Present:       return D3D12_RESOURCE_STATE_PRESENT;
+        }
+        return D3D12_RESOURCE_STATE_COMMON;
+    }
+
+    void* CreateTransient(const FrameGraphResourceDesc& desc, FrameGraphUsage firstUsage) override
+    {
+        D3D12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(
+            (DXGI_FORMAT)desc.Format, desc.Width, desc.Height, 1, 1, desc.SampleCount, 0,
+            desc.Depth ? D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL : D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET);
+
+        D3D12_CLEAR_VALUE clearVal = {};
+        clearVal.Format = textureDesc.Format;
+        clearVal.DepthStencil.Depth = 1.0f;
+
+        ID3D12Resource* resource = nullptr;
+        CD3DX12_HEAP_PROPERTIES heapProp(D3D12_HEAP_TYPE_DEFAULT);
+        HRESULT hr = DIRECTX.Device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &textureDesc,
+            State(firstUsage), &clearVal, IID_PPV_ARGS(&resource));
+        VALIDATE((hr == ERROR_SUCCESS), "CreateCommittedResource failed");
+        return resource;
+    }
+
+    void ReleaseTransient(void* handle) override
+    {
+        ID3D12Resource* resource = (ID3D12Resource*)handle;
+        Release(resource);
+    }
+
+    void Barriers(void* context, const FrameGraphBarrier* barriers, int count) override
+    {
+        std::vector<D3D12_RESOURCE_BARRIER> resBars(count);
+        for (int i = 0; i < count; i++)
+        {
+            resBars[i] = CD3DX12_RESOURCE_BARRIER::Transition((ID3D12Resource*)barriers[i].Handle,
+                State(barriers[i].Before), State(barriers[i].After));
+        }
+        ((ID3D12GraphicsCommandList*)context)->ResourceBarrier(count, resBars.data());
+    }
+};
+
 //------------------------------------------------------------
 struct Texture
 {
@@ -720,8 +1078,10 @@ struct Texture
     enum AutoFill { AUTO_WHITE = 1, AUTO_WALL, AUTO_FLOOR, AUTO_CEILING, AUTO_GRID, AUTO_GRADE_256 };
 
 private:
-    Texture()
+    Texture() : TextureRes(nullptr)
     {
+        SrvHandle.ptr = 0;
+        RtvHandle.ptr = 0;
     }
 
 public:
@@ -730,6 +1090,8 @@ public:
         SizeW = sizeW;
         SizeH = sizeH;
         MipLevels = mipLevels;
+        SrvHandle.ptr = 0;
+        RtvHandle.ptr = 0;
 
         D3D12_RESOURCE_DESC textureDesc = {};
         textureDesc.MipLevels = UINT16(MipLevels);
@@ -787,6 +1149,8 @@ public:
 
     ~Texture()
     {
+        DIRECTX.CbvSrvHandleProvider.FreeCpuHandle(SrvHandle);
+        DIRECTX.RtvHandleProvider.FreeCpuHandle(RtvHandle);
         Release(TextureRes);
     }
 
@@ -802,7 +1166,7 @@ public:
         {
             // Push data into the texture
             {
-                DirectX12::SwapChainFrameResources& currFrameRes = DIRECTX.CurrentFrameResources();
+                DirectX12::FrameResources& currFrameRes = DIRECTX.CurrentFrameResources();
                 currFrameRes.CommandLists[DrawContext_Final]->Reset(currFrameRes.CommandAllocators[DrawContext_Final], nullptr);
 
                 {
@@ -848,27 +1212,10 @@ public:
                 ID3D12CommandList* ppCommandLists[] = { currFrameRes.CommandLists[DrawContext_Final] };
                 DIRECTX.CommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
 
-                // Create synchronization objects and wait until assets have been uploaded to the GPU.
-                {
-                    // Wait for the command list to execute; we are reusing the same command 
-                    // list in our main loop but for now, we just want to wait for setup to 
-                    // complete before continuing.
-                    {
-                        // Signal and increment the fence value.
-                        currFrameRes.PresentFenceWaitValue = currFrameRes.PresentFenceValue;
-                        hr = DIRECTX.CommandQueue->Signal(currFrameRes.PresentFenceRes, currFrameRes.PresentFenceWaitValue);
-                        VALIDATE((hr == ERROR_SUCCESS), "CommandQueue Signal failed");
-                        currFrameRes.PresentFenceValue++;
-
-                        // Wait until the copy is finished.
-                        if (currFrameRes.PresentFenceRes->GetCompletedValue() < currFrameRes.PresentFenceWaitValue)
-                        {
-                            hr = currFrameRes.PresentFenceRes->SetEventOnCompletion(currFrameRes.PresentFenceWaitValue, currFrameRes.PresentFenceEvent);
-                            VALIDATE((hr == ERROR_SUCCESS), "SetEventOnCompletion failed");
-                            WaitForSingleObject(currFrameRes.PresentFenceEvent, 10000);
-                        }
-                    }
-                }
+                // Wait for the command list to execute; we are reusing the same command 
+                // list in our main loop but for now, we just want to wait for setup to 
+                // complete before continuing.
+                DIRECTX.WaitForGpu();
             }
 
             for (int j = 0; j < (sizeH & ~1); j += 2)
@@ -994,13 +1341,13 @@ struct Material
         hr = D3DCompile(pixelShaderStr, strlen(pixelShaderStr), 0, 0, 0, "main", "ps_5_0", compileFlags, 0, &compiledPS, 0);
         VALIDATE((hr == ERROR_SUCCESS), "D3DCompile PixelShader failed");
 
-        CD3DX12_DESCRIPTOR_RANGE ranges[2];
+        CD3DX12_DESCRIPTOR_RANGE ranges[1];
         ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
-        ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 0);
 
+        // Constants come straight from the frame's upload ring (see DirectX12::UploadConstants)
         CD3DX12_ROOT_PARAMETER rootParameters[2];
         rootParameters[0].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_PIXEL);
-        rootParameters[1].InitAsDescriptorTable(1, &ranges[1], D3D12_SHADER_VISIBILITY_VERTEX);
+        rootParameters[1].InitAsConstantBufferView(0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
 
         D3D12_STATIC_SAMPLER_DESC sampler = {};
         sampler.Filter = D3D12_FILTER_ANISOTROPIC;
@@ -1188,6 +1535,7 @@ struct Model
     ID3D12PipelineState*        PipelineState;
     D3D12_VERTEX_BUFFER_VIEW    VertexBufferView;
     D3D12_INDEX_BUFFER_VIEW     IndexBufferView;
+    XMFLOAT3                    BoundsMin, BoundsMax;   // Of the vertices, in model space
 
     struct ModelConstants
     {
@@ -1195,19 +1543,20 @@ struct Model
         XMFLOAT4    MasterColor;
     };
 
-    // per-frame constant buffer data
-    struct FrameResources
-    {
-        ID3D12Resource*             ConstantBuffer;
-        D3D12_CPU_DESCRIPTOR_HANDLE ConstantBufferHandle;
-        ModelConstants              ConstantBufferData;
-        UINT8*                      ConstantBufferMapPtr;
-    };
-    FrameResources PerFrameRes[DirectX12::SwapChainNumFrames][NumEyes];
+    // Uploaded to the frame's ring for each draw
+    ModelConstants              ConstantData;
 
     void Init(TriangleSet* t)
     {
         NumIndices = t->numIndices;
+
+        BoundsMin = BoundsMax = (t->numVertices > 0) ? t->Vertices[0].Pos : XMFLOAT3(0, 0, 0);
+        for (int i = 1; i < t->numVertices; ++i)
+        {
+            XMStoreFloat3(&BoundsMin, XMVectorMin(XMLoadFloat3(&BoundsMin), XMLoadFloat3(&t->Vertices[i].Pos)));
+            XMStoreFloat3(&BoundsMax, XMVectorMax(XMLoadFloat3(&BoundsMax), XMLoadFloat3(&t->Vertices[i].Pos)));
+        }
+
         VertexBuffer = new DataBuffer(DIRECTX.Device, &t->Vertices[0], t->numVertices * sizeof(Vertex));
         IndexBuffer = new DataBuffer(DIRECTX.Device, &t->Indices[0], t->numIndices * sizeof(short));
 
@@ -1221,37 +1570,7 @@ struct Model
         IndexBufferView.Format = DXGI_FORMAT_R16_UINT;
         IndexBufferView.SizeInBytes = (UINT)IndexBuffer->BufferSize;
 
-        for (int frameIdx = 0; frameIdx < DirectX12::SwapChainNumFrames; frameIdx++)
-        {
-            for (int eye = 0; eye < NumEyes; eye++)
-            {
-                FrameResources& frameRes = PerFrameRes[frameIdx][eye];
-
-                CD3DX12_HEAP_PROPERTIES heapProp(D3D12_HEAP_TYPE_UPLOAD);
-                CD3DX12_RESOURCE_DESC resDesc = CD3DX12_RESOURCE_DESC::Buffer(1024 * 64);
-                HRESULT hr = DIRECTX.Device->CreateCommittedResource(
-                    &heapProp,
-                    D3D12_HEAP_FLAG_NONE,
-                    &resDesc,
-                    D3D12_RESOURCE_STATE_GENERIC_READ,
-                    nullptr,
-                    IID_PPV_ARGS(&frameRes.ConstantBuffer));
-                VALIDATE((hr == ERROR_SUCCESS), "CommandQueue Signal failed");
-
-                // Describe and create a constant buffer view.
-                D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
-                cbvDesc.BufferLocation = frameRes.ConstantBuffer->GetGPUVirtualAddress();
-                // CB size is required to be 256-byte aligned.
-                cbvDesc.SizeInBytes = (sizeof(ModelConstants) + (D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1)) & ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
-                frameRes.ConstantBufferHandle = DIRECTX.CbvSrvHandleProvider.AllocCpuHandle();
-                DIRECTX.Device->CreateConstantBufferView(&cbvDesc, frameRes.ConstantBufferHandle);
-
-                hr = frameRes.ConstantBuffer->Map(0, nullptr, reinterpret_cast<void**>(&frameRes.ConstantBufferMapPtr));
-                VALIDATE((hr == ERROR_SUCCESS), "Constant Buffer Map failed");
-                ZeroMemory(&frameRes.ConstantBufferData, sizeof(ModelConstants));
-                memcpy(frameRes.ConstantBufferMapPtr, &frameRes.ConstantBufferData, sizeof(ModelConstants));
-            }
-        }
+        ZeroMemory(&ConstantData, sizeof(ModelConstants));
     }
 
     Model(TriangleSet* t, XMFLOAT3 argPos, XMFLOAT4 argRot, Material* argMaterial) :
@@ -1286,29 +1605,72 @@ struct Model
 
     void Render(XMMATRIX* projView, float R, float G, float B, float A, bool standardUniforms)
     {
-        DirectX12::SwapChainFrameResources& currFrameRes = DIRECTX.CurrentFrameResources();
-        FrameResources& currConstantRes = PerFrameRes[DIRECTX.SwapChainFrameIndex][DIRECTX.ActiveEyeIndex];
-
         if (standardUniforms)
+            ConstantData = MakeConstants(projView, R, G, B, A);
+        Draw(DIRECTX.CurrentFrameResources().CommandLists[DIRECTX.ActiveContext], ConstantData);
+    }
+
+    // For recording from several threads at once: draws into cmdList, and leaves ConstantData alone
+    void Render(ID3D12GraphicsCommandList* cmdList, XMMATRIX* projView, float R, float G, float B, float A) const
+    {
+        Draw(cmdList, MakeConstants(projView, R, G, B, A));
+    }
+
+    // Whether all of the model's bounds are outside one of projView's frustum planes, so drawing it can be skipped
+    bool IsCulled(XMMATRIX* projView) const
+    {
+        XMMATRIX modelMat = XMMatrixMultiply(XMMatrixRotationQuaternion(XMLoadFloat4(&Rot)), XMMatrixTranslationFromVector(XMLoadFloat3(&Pos)));
+        XMMATRIX mat = XMMatrixMultiply(modelMat, *projView);
+
+        int outside[6] = {};
+        for (int i = 0; i < 8; ++i)
         {
-            XMMATRIX modelMat = XMMatrixMultiply(XMMatrixRotationQuaternion(XMLoadFloat4(&Rot)), XMMatrixTranslationFromVector(XMLoadFloat3(&Pos)));
-            XMMATRIX mat = XMMatrixMultiply(modelMat, *projView);
-            XMStoreFloat4x4(&currConstantRes.ConstantBufferData.WorldViewProj, mat);
-            currConstantRes.ConstantBufferData.MasterColor = XMFLOAT4(R, G, B, A);
+            XMVECTOR corner = XMVectorSet((i & 1) ? BoundsMax.x : BoundsMin.x,
+                                          (i & 2) ? BoundsMax.y : BoundsMin.y,
+                                          (i & 4) ? BoundsMax.z : BoundsMin.z, 1);
+            XMFLOAT4 clip;
+            XMStoreFloat4(&clip, XMVector4Transform(corner, mat));
+            outside[0] += (clip.x < -clip.w);
+            outside[1] += (clip.x >  clip.w);
+            outside[2] += (clip.y < -clip.w);
+            outside[3] += (clip.y >  clip.w);
+            outside[4] += (clip.z <  0);
+            outside[5] += (clip.z >  clip.w);
+        }
 
-            memcpy(currConstantRes.ConstantBufferMapPtr + 0, &currConstantRes.ConstantBufferData, sizeof(ModelConstants));
+        for (int plane = 0; plane < 6; ++plane)
+        {
+            if (outside[plane] == 8)
+                return true;
         }
+        return false;
+    }
 
-        auto activeCmdList = currFrameRes.CommandLists[DIRECTX.ActiveContext];
+    ModelConstants MakeConstants(XMMATRIX* projView, float R, float G, float B, float A) const
+    {
+        ModelConstants constants;
+        XMMATRIX modelMat = XMMatrixMultiply(XMMatrixRotationQuaternion(XMLoadFloat4(&Rot)), XMMatrixTranslationFromVector(XMLoadFloat3(&Pos)));
+        XMMATRIX mat = XMMatrixMultiply(modelMat, *projView);
+        XMStoreFloat4x4(&constants.WorldViewProj, mat);
+        constants.MasterColor = XMFLOAT4(R, G, B, A);
+        return constants;
+    }
+
+    void Draw(ID3D12GraphicsCommandList* activeCmdList, const ModelConstants& constants) const
+    {
+        Draw(activeCmdList, DIRECTX.UploadConstants(&constants, sizeof(ModelConstants)));
+    }
 
+    // Draws with the ModelConstants already at constantBufferAddress, so it can go in a bundle
+    void Draw(ID3D12GraphicsCommandList* activeCmdList, D3D12_GPU_VIRTUAL_ADDRESS constantBufferAddress) const
+    {
         activeCmdList->SetGraphicsRootSignature(MaterialState->RootSignature);
         activeCmdList->SetPipelineState(MaterialState->PipelineState);
 
         CD3DX12_GPU_DESCRIPTOR_HANDLE srvGpuHandle(DIRECTX.CbvSrvHandleProvider.GpuHandleFromCpuHandle(MaterialState->Tex->SrvHandle));
         activeCmdList->SetGraphicsRootDescriptorTable(0, srvGpuHandle);
 
-        CD3DX12_GPU_DESCRIPTOR_HANDLE constantBufferGpuhandle(DIRECTX.CbvSrvHandleProvider.GpuHandleFromCpuHandle(currConstantRes.ConstantBufferHandle));
-        activeCmdList->SetGraphicsRootDescriptorTable(1, constantBufferGpuhandle);
+        activeCmdList->SetGraphicsRootConstantBufferView(1, constantBufferAddress);
 
         activeCmdList->IASetIndexBuffer(&IndexBufferView);
         activeCmdList->IASetVertexBuffers(0, 1, &VertexBufferView);
@@ -1325,6 +1687,14 @@ struct Scene
     Model* Models[MAX_MODELS];
     int numModels;
 
+    // See RenderBundle
+    static const UINT           BundleConstantsStride = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+    ID3D12CommandAllocator*     BundleAllocator;
+    ID3D12GraphicsCommandList*  Bundles[DirectX12::FramesInFlight][Model::NumEyes];
+    ID3D12Resource*             BundleConstants;
+    UINT8*                      BundleConstantsMapPtr;
+    int                         BundleModelCount;
+
     void Add(Model* n)
     {
         if (numModels < MAX_MODELS)
@@ -1334,7 +1704,101 @@ struct Scene
     void Render(XMMATRIX* projView, float R, float G, float B, float A, bool standardUniforms)
     {
         for (int i = 0; i < numModels; ++i)
+        {
+            if (standardUniforms && Models[i]->IsCulled(projView))
+                continue;
             Models[i]->Render(projView, R, G, B, A, standardUniforms);
+        }
+    }
+
+    // Renders just this partition's share of the models, into cmdList (see DirectX12::RecordParallel)
+    void Render(ID3D12GraphicsCommandList* cmdList, XMMATRIX* projView, float R, float G, float B, float A, int partition, int partitionCount) const
+    {
+        for (int i = numModels * partition / partitionCount; i < numModels * (partition + 1) / partitionCount; ++i)
+        {
+            if (!Models[i]->IsCulled(projView))
+                Models[i]->Render(cmdList, projView, R, G, B, A);
+        }
+    }
+
+    // For static rooms: the models' draws are recorded once, into a bundle per frame in flight and
+    // eye that reads each model's constants from a fixed place, so that a frame only writes the
+    // constants.  Models can still move; adding one records the bundles again.  Call it once per eye
+    // per frame, with the command list's descriptor heap set.
+    void RenderBundle(ID3D12GraphicsCommandList* cmdList, int eye, XMMATRIX* projView, float R, float G, float B, float A)
+    {
+        if (numModels == 0)
+            return;
+        if (BundleModelCount != numModels)
+            RecordBundles();
+
+        UINT8* constants = BundleConstantsMapPtr + BundleConstantsOffset(DIRECTX.FrameIndex, eye, 0);
+        for (int i = 0; i < numModels; ++i)
+        {
+            Model::ModelConstants modelConstants = Models[i]->MakeConstants(projView, R, G, B, A);
+            memcpy(constants + i * BundleConstantsStride, &modelConstants, sizeof(modelConstants));
+        }
+
+        cmdList->ExecuteBundle(Bundles[DIRECTX.FrameIndex][eye]);
+    }
+
+    UINT64 BundleConstantsOffset(int frameIdx, int eye, int modelIdx) const
+    {
+        return UINT64((frameIdx * Model::NumEyes + eye) * BundleModelCount + modelIdx) * BundleConstantsStride;
+    }
+
+    void RecordBundles()
+    {
+        // The old bundles may still be in flight
+        if (BundleAllocator)
+            DIRECTX.WaitForGpu();
+        ReleaseBundles();
+
+        BundleModelCount = numModels;
+
+        CD3DX12_HEAP_PROPERTIES heapProp(D3D12_HEAP_TYPE_UPLOAD);
+        CD3DX12_RESOURCE_DESC buf = CD3DX12_RESOURCE_DESC::Buffer(BundleConstantsOffset(DirectX12::FramesInFlight, 0, 0));
+        HRESULT hr = DIRECTX.Device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &buf,
+            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&BundleConstants));
+        VALIDATE((hr == ERROR_SUCCESS), "CreateCommittedResource failed");
+
+        // Upload heaps can stay mapped
+        hr = BundleConstants->Map(0, nullptr, reinterpret_cast<void**>(&BundleConstantsMapPtr));
+        VALIDATE((hr == ERROR_SUCCESS), "Bundle constants map failed");
+
+        hr = DIRECTX.Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE, IID_PPV_ARGS(&BundleAllocator));
+        VALIDATE((hr == ERROR_SUCCESS), "CreateCommandAllocator failed");
+
+        for (int frameIdx = 0; frameIdx < DirectX12::FramesInFlight; ++frameIdx)
+        {
+            for (int eye = 0; eye < Model::NumEyes; ++eye)
+            {
+                ID3D12GraphicsCommandList*& bundle = Bundles[frameIdx][eye];
+                hr = DIRECTX.Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_BUNDLE, BundleAllocator, nullptr, IID_PPV_ARGS(&bundle));
+                VALIDATE((hr == ERROR_SUCCESS), "CreateCommandList failed");
+
+                // Has to match the calling command list's
+                ID3D12DescriptorHeap* heaps[] = { DIRECTX.CbvSrvHeap };
+                bundle->SetDescriptorHeaps(_countof(heaps), heaps);
+
+                for (int i = 0; i < numModels; ++i)
+                    Models[i]->Draw(bundle, BundleConstants->GetGPUVirtualAddress() + BundleConstantsOffset(frameIdx, eye, i));
+
+                hr = bundle->Close();
+                VALIDATE((hr == ERROR_SUCCESS), "CommandList Close failed");
+            }
+        }
+    }
+
+    void ReleaseBundles()
+    {
+        for (int frameIdx = 0; frameIdx < DirectX12::FramesInFlight; ++frameIdx)
+            for (int eye = 0; eye < Model::NumEyes; ++eye)
+                ::Release(Bundles[frameIdx][eye]);
+        ::Release(BundleAllocator);
+        ::Release(BundleConstants);
+        BundleConstantsMapPtr = nullptr;
+        BundleModelCount = 0;
     }
 
     void Init(bool includeIntensiveGPUobject)
@@ -1440,16 +1904,20 @@ struct Scene
         ); // Fixtures & furniture
     }
 
-    Scene() : numModels(0) {}
-    Scene(bool includeIntensiveGPUobject) :
-    numModels(0)
+    Scene() : numModels(0), BundleAllocator(nullptr), BundleConstants(nullptr), BundleConstantsMapPtr(nullptr), BundleModelCount(0)
+    {
+        ZeroMemory(Bundles, sizeof(Bundles));
+    }
+    Scene(bool includeIntensiveGPUobject) : Scene()
     {
         Init(includeIntensiveGPUobject);
     }
     void Release()
     {
+        ReleaseBundles();
         while (numModels-- > 0)
             delete Models[numModels];
+        numModels = 0;
     }
     ~Scene()
     {
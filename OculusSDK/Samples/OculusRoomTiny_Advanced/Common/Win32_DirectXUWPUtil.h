@@ -369,7 +369,7 @@ struct Texture
 
     enum { AUTO_WHITE = 1, AUTO_WALL, AUTO_FLOOR, AUTO_CEILING, AUTO_GRID, AUTO_GRADE_256 };
     Texture() : Tex(nullptr), TexSv(nullptr), TexRtv(nullptr) {};
-    void Init(int sizeW, int sizeH, bool rendertarget, int mipLevels, int sampleCount)
+    void Init(int sizeW, int sizeH, bool rendertarget, int mipLevels, int sampleCount, bool srgb = false)
     {
         SizeW = sizeW;
         SizeH = sizeH;
@@ -380,7 +380,8 @@ struct Texture
         dsDesc.Height = SizeH;
         dsDesc.MipLevels = MipLevels;
         dsDesc.ArraySize = 1;
-        dsDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        // An sRGB format has the GPU convert to linear as the texture is sampled.
+        dsDesc.Format = srgb ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
         dsDesc.SampleDesc.Count = sampleCount;
         dsDesc.SampleDesc.Quality = 0;
         dsDesc.Usage = D3D11_USAGE_DEFAULT;
@@ -388,19 +389,25 @@ struct Texture
         dsDesc.MiscFlags = 0;
         dsDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
         if (rendertarget) dsDesc.BindFlags |= D3D11_BIND_RENDER_TARGET;
+        if (MipLevels != 1 && sampleCount == 1)
+        {
+            // Let FillTexture generate the mips on the GPU, which needs a render target.
+            dsDesc.BindFlags |= D3D11_BIND_RENDER_TARGET;
+            dsDesc.MiscFlags |= D3D11_RESOURCE_MISC_GENERATE_MIPS;
+        }
 
         DIRECTX.Device->CreateTexture2D(&dsDesc, NULL, &Tex);
         DIRECTX.Device->CreateShaderResourceView(Tex, NULL, &TexSv);
         TexRtv = nullptr;
         if (rendertarget) DIRECTX.Device->CreateRenderTargetView(Tex, NULL, &TexRtv);
     }
-    Texture(int sizeW, int sizeH, bool rendertarget, int mipLevels = 1, int sampleCount = 1)
+    Texture(int sizeW, int sizeH, bool rendertarget, int mipLevels = 1, int sampleCount = 1, bool srgb = false)
     {
-        Init(sizeW, sizeH, rendertarget, mipLevels, sampleCount);
+        Init(sizeW, sizeH, rendertarget, mipLevels, sampleCount, srgb);
     }
-    Texture(bool rendertarget, int sizeW, int sizeH, int autoFillData = 0, int sampleCount = 1)
+    Texture(bool rendertarget, int sizeW, int sizeH, int autoFillData = 0, int sampleCount = 1, bool srgb = false)
     {
-        Init(sizeW, sizeH, rendertarget, autoFillData ? 8 : 1, sampleCount);
+        Init(sizeW, sizeH, rendertarget, autoFillData ? 8 : 1, sampleCount, srgb);
         if (autoFillData) AutoFillTexture(autoFillData);
     }
     ~Texture()
@@ -412,39 +419,9 @@ struct Texture
 
     void FillTexture(uint32_t * pix)
     {
-        //Make local ones, because will be reducing them
-        int sizeW = SizeW; 
-        int sizeH = SizeH;
-        for (int level = 0; level < MipLevels; level++)
-        {
-            DIRECTX.Context->UpdateSubresource(Tex, level, NULL, (unsigned char *)pix, sizeW * 4, sizeH * sizeW * 4);
-
-            for (int j = 0; j < (sizeH & ~1); j += 2)
-            {
-                uint8_t* psrc = (uint8_t *)pix + (sizeW * j * 4);
-                uint8_t* pdest = (uint8_t *)pix + (sizeW * j);
-                for (int i = 0; i < sizeW >> 1; i++, psrc += 8, pdest += 4)
-                {
-                    pdest[0] = (((int)psrc[0]) + psrc[4] + psrc[sizeW * 4 + 0] + psrc[sizeW * 4 + 4]) >> 2;
-                    pdest[1] = (((int)psrc[1]) + psrc[5] + psrc[sizeW * 4 + 1] + psrc[sizeW * 4 + 5]) >> 2;
-                    pdest[2] = (((int)psrc[2]) + psrc[6] + psrc[sizeW * 4 + 2] + psrc[sizeW * 4 + 6]) >> 2;
-                    pdest[3] = (((int)psrc[3]) + psrc[7] + psrc[sizeW * 4 + 3] + psrc[sizeW * 4 + 7]) >> 2;
-                }
-            }
-            sizeW >>= 1;  sizeH >>= 1;
-        }
-    }
-
-    static void ConvertToSRGB(uint32_t * linear)
-    {
-        uint32_t drgb[3];
-        for (int k = 0; k < 3; k++)
-        {
-            float rgb = ((float)((*linear >> (k * 8)) & 0xff)) / 255.0f;
-            rgb = pow(rgb, 2.2f);
-            drgb[k] = (uint32_t)(rgb * 255.0f);
-        }
-        *linear = (*linear & 0xff000000) + (drgb[2] << 16) + (drgb[1] << 8) + (drgb[0] << 0);
+        // Upload the top level only, and have the GPU filter the rest down from it.
+        DIRECTX.Context->UpdateSubresource(Tex, 0, nullptr, (unsigned char *)pix, SizeW * 4, SizeH * SizeW * 4);
+        if (MipLevels != 1) DIRECTX.Context->GenerateMips(TexSv);
     }
 
     void AutoFillTexture(int autoFillData)
@@ -0,0 +1,352 @@
+/************************************************************************************
+Filename    :   Win32_FrameGraph.h
+Content     :   Backend-neutral description of a frame's passes and resources for RoomTiny
+Created     :   October 14, 2026
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*************************************************************************************/
+
+// A frame is described as passes, in submission order, that each say how they use the frame's
+// resources.  Compile then works out, once for every backend:
+//  - the transitions each pass needs, batched into one call before it
+//  - which transient resources can share one physical resource, because their passes don't overlap
+//  - which passes can be skipped, because nothing reads what they write
+// A backend (see FrameGraphD3D12 in Win32_DirectX12AppUtil.h) maps the usages onto its own states
+// and creates the transients.  D3D11 and OpenGL track these hazards in the driver, so need no mapping.
+
+#ifndef OVR_Win32_FrameGraph_h
+#define OVR_Win32_FrameGraph_h
+
+#include <assert.h>
+#include <stddef.h>
+#include <functional>
+#include <vector>
+
+enum FrameGraphUsage
+{
+    FrameGraphUsage_RenderTarget,
+    FrameGraphUsage_DepthWrite,
+    FrameGraphUsage_DepthRead,
+    FrameGraphUsage_ShaderRead,
+    FrameGraphUsage_CopySource,
+    FrameGraphUsage_CopyDest,
+    FrameGraphUsage_Present
+};
+
+inline bool FrameGraphUsageWrites(FrameGraphUsage usage)
+{
+    return usage == FrameGraphUsage_RenderTarget || usage == FrameGraphUsage_DepthWrite || usage == FrameGraphUsage_CopyDest;
+}
+
+struct FrameGraphResourceDesc
+{
+    int     Width;
+    int     Height;
+    int     Format;         // The backend's own format enum
+    int     SampleCount;
+    bool    Depth;
+
+    bool operator==(const FrameGraphResourceDesc& that) const
+    {
+        return Width == that.Width && Height == that.Height && Format == that.Format &&
+               SampleCount == that.SampleCount && Depth == that.Depth;
+    }
+};
+
+struct FrameGraphBarrier
+{
+    void*           Handle;
+    FrameGraphUsage Before;
+    FrameGraphUsage After;
+};
+
+struct FrameGraphBackend
+{
+    virtual ~FrameGraphBackend() {}
+    // Created in firstUsage, so that its first pass needs no transition
+    virtual void* CreateTransient(const FrameGraphResourceDesc& desc, FrameGraphUsage firstUsage) = 0;
+    virtual void  ReleaseTransient(void* handle) = 0;
+    virtual void  Barriers(void* context, const FrameGraphBarrier* barriers, int count) = 0;
+};
+
+class FrameGraph
+{
+public:
+    // context is what Execute was given, e.g. the command list
+    typedef std::function<void(void* context)> ExecuteFunc;
+
+    FrameGraph() : Resources(), Passes(), Physical(), FinalBarriers(), Compiled(false) {}
+
+    // Brings a resource the app owns into the graph, and leaves it in finalUsage after the last pass
+    int ImportResource(void* handle, FrameGraphUsage initialUsage, FrameGraphUsage finalUsage)
+    {
+        Resource res = {};
+        res.Handle = handle;
+        res.InitialUsage = initialUsage;
+        res.FinalUsage = finalUsage;
+        res.PhysicalIdx = -1;
+        Resources.push_back(res);
+        return (int)Resources.size() - 1;
+    }
+
+    // A resource that lives within the frame; its contents don't survive between frames
+    int CreateTransient(const FrameGraphResourceDesc& desc)
+    {
+        Resource res = {};
+        res.Transient = true;
+        res.Desc = desc;
+        res.PhysicalIdx = -1;
+        Resources.push_back(res);
+        return (int)Resources.size() - 1;
+    }
+
+    // Passes with sideEffects, such as those drawing into an imported resource, are never culled
+    int AddPass(const char* name, ExecuteFunc execute, bool sideEffects = false)
+    {
+        Pass pass;
+        pass.Name = name;
+        pass.Execute = execute;
+        pass.SideEffects = sideEffects;
+        pass.Culled = false;
+        Passes.push_back(pass);
+        return (int)Passes.size() - 1;
+    }
+
+    void Use(int passIdx, int resourceIdx, FrameGraphUsage usage)
+    {
+        ResourceUse use = { resourceIdx, usage };
+        Passes[passIdx].Uses.push_back(use);
+    }
+
+    // The resource's backend handle, once compiled
+    void* GetResource(int resourceIdx) const
+    {
+        const Resource& res = Resources[resourceIdx];
+        return res.Transient ? Physical[res.PhysicalIdx].Handle : res.Handle;
+    }
+
+    void Compile(FrameGraphBackend& backend)
+    {
+        CullPasses();
+        AssignPhysical(backend);
+
+        // Follow each resource's usage through the passes, from where the last frame left it
+        std::vector<FrameGraphUsage> current(Resources.size());
+        std::vector<bool>            seen(Resources.size(), false);
+        for (size_t r = 0; r < Resources.size(); r++)
+            current[r] = Resources[r].InitialUsage;
+
+        for (auto& pass : Passes)
+        {
+            pass.Barriers.clear();
+            if (pass.Culled)
+                continue;
+
+            for (const auto& use : pass.Uses)
+            {
+                Resource& res = Resources[use.ResourceIdx];
+                if (res.Transient && !seen[use.ResourceIdx])
+                {
+                    // A shared physical resource is wherever its previous owner left it
+                    current[use.ResourceIdx] = Physical[res.PhysicalIdx].Usage;
+                }
+                seen[use.ResourceIdx] = true;
+
+                if (current[use.ResourceIdx] != use.Usage)
+                {
+                    FrameGraphBarrier barrier = { GetResource(use.ResourceIdx), current[use.ResourceIdx], use.Usage };
+                    pass.Barriers.push_back(barrier);
+                    current[use.ResourceIdx] = use.Usage;
+                }
+
+                if (res.Transient)
+                    Physical[res.PhysicalIdx].Usage = use.Usage;
+            }
+        }
+
+        FinalBarriers.clear();
+        for (size_t r = 0; r < Resources.size(); r++)
+        {
+            if (!Resources[r].Transient && current[r] != Resources[r].FinalUsage)
+            {
+                FrameGraphBarrier barrier = { Resources[r].Handle, current[r], Resources[r].FinalUsage };
+                FinalBarriers.push_back(barrier);
+            }
+        }
+
+        Compiled = true;
+    }
+
+    void Execute(FrameGraphBackend& backend, void* context)
+    {
+        assert(Compiled);
+        for (auto& pass : Passes)
+        {
+            if (pass.Culled)
+                continue;
+            if (!pass.Barriers.empty())
+                backend.Barriers(context, pass.Barriers.data(), (int)pass.Barriers.size());
+            pass.Execute(context);
+        }
+        if (!FinalBarriers.empty())
+            backend.Barriers(context, FinalBarriers.data(), (int)FinalBarriers.size());
+    }
+
+    // Forgets the passes and resources, for describing the next frame; physical transients are kept
+    void Reset()
+    {
+        Resources.clear();
+        Passes.clear();
+        for (auto& phys : Physical)
+            phys.LastPass = -1;
+        Compiled = false;
+    }
+
+    // Once the GPU is done with the transients
+    void Release(FrameGraphBackend& backend)
+    {
+        for (auto& phys : Physical)
+            backend.ReleaseTransient(phys.Handle);
+        Physical.clear();
+        Reset();
+    }
+
+    int CountCulledPasses() const
+    {
+        int count = 0;
+        for (const auto& pass : Passes)
+            count += pass.Culled ? 1 : 0;
+        return count;
+    }
+
+private:
+    struct ResourceUse
+    {
+        int             ResourceIdx;
+        FrameGraphUsage Usage;
+    };
+
+    struct Pass
+    {
+        const char*                     Name;
+        ExecuteFunc                     Execute;
+        bool                            SideEffects;
+        bool                            Culled;
+        std::vector<ResourceUse>        Uses;
+        std::vector<FrameGraphBarrier>  Barriers;
+    };
+
+    struct Resource
+    {
+        void*                   Handle;         // Imported resources only
+        FrameGraphUsage         InitialUsage;
+        FrameGraphUsage         FinalUsage;
+        bool                    Transient;
+        FrameGraphResourceDesc  Desc;
+        int                     PhysicalIdx;
+        int                     FirstPass;
+        int                     LastPass;
+    };
+
+    struct PhysicalResource
+    {
+        FrameGraphResourceDesc  Desc;
+        void*                   Handle;
+        FrameGraphUsage         Usage;          // Where the last pass using it, in any frame, left it
+        int                     LastPass;       // This frame's
+    };
+
+    // Walks back from the passes that must run, keeping those that write what a kept pass reads
+    void CullPasses()
+    {
+        std::vector<bool> needed(Resources.size(), false);
+        for (size_t r = 0; r < Resources.size(); r++)
+            needed[r] = !Resources[r].Transient;
+
+        for (int p = (int)Passes.size() - 1; p >= 0; p--)
+        {
+            Pass& pass = Passes[p];
+            bool keep = pass.SideEffects;
+            for (const auto& use : pass.Uses)
+                keep = keep || (FrameGraphUsageWrites(use.Usage) && needed[use.ResourceIdx]);
+
+            pass.Culled = !keep;
+            if (keep)
+            {
+                for (const auto& use : pass.Uses)
+                {
+                    if (!FrameGraphUsageWrites(use.Usage))
+                        needed[use.ResourceIdx] = true;
+                }
+            }
+        }
+    }
+
+    // Gives each used transient a physical resource, sharing one with any earlier transient of the
+    // same desc whose passes have all gone by
+    void AssignPhysical(FrameGraphBackend& backend)
+    {
+        for (auto& res : Resources)
+        {
+            res.FirstPass = -1;
+            res.LastPass = -1;
+        }
+        for (int p = 0; p < (int)Passes.size(); p++)
+        {
+            if (Passes[p].Culled)
+                continue;
+            for (const auto& use : Passes[p].Uses)
+            {
+                Resource& res = Resources[use.ResourceIdx];
+                if (res.FirstPass < 0)
+                    res.FirstPass = p;
+                res.LastPass = p;
+            }
+        }
+
+        for (int p = 0; p < (int)Passes.size(); p++)
+        {
+            for (const auto& use : Passes[p].Uses)
+            {
+                Resource& res = Resources[use.ResourceIdx];
+                if (!res.Transient || res.FirstPass != p || res.PhysicalIdx >= 0)
+                    continue;
+
+                for (size_t i = 0; i < Physical.size() && res.PhysicalIdx < 0; i++)
+                {
+                    if (Physical[i].Desc == res.Desc && Physical[i].LastPass < p)
+                        res.PhysicalIdx = (int)i;
+                }
+                if (res.PhysicalIdx < 0)
+                {
+                    PhysicalResource phys = {};
+                    phys.Desc = res.Desc;
+                    phys.Handle = backend.CreateTransient(res.Desc, use.Usage);
+                    phys.Usage = use.Usage;
+                    Physical.push_back(phys);
+                    res.PhysicalIdx = (int)Physical.size() - 1;
+                }
+                Physical[res.PhysicalIdx].LastPass = res.LastPass;
+            }
+        }
+    }
+
+    std::vector<Resource>           Resources;
+    std::vector<Pass>               Passes;
+    std::vector<PhysicalResource>   Physical;
+    std::vector<FrameGraphBarrier>  FinalBarriers;
+    bool                            Compiled;
+};
+
+#endif // OVR_Win32_FrameGraph_h
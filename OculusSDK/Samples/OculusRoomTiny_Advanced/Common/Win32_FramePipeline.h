@@ -0,0 +1,163 @@
+/************************************************************************************
+Filename    :   Win32_FramePipeline.h
+Content     :   Lock-free handoff of frames between pipelined stages, e.g. CPU and GPU
+Created     :   October 14, 2026
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*************************************************************************************/
+
+// Frames pass through StageCount stages in order, each stage working on one frame at a time,
+// on whichever thread drives it (or polled from one thread, as the App-rendered samples do).
+// Each frame has a slot of T, holding whatever the stages hand on, e.g. poses and a GPU query.
+// Every slot's state is the stage it's waiting for, or being worked on by, and only that stage's
+// thread moves it on, so the handoff is a release store and acquire load with no locks.
+//
+// Depth is the one knob: how many frames can be in the pipeline at once.  Depth 1 has stage 0
+// wait for the last stage to finish the previous frame, for the least latency.  Each extra
+// frame of depth lets the stages overlap, for throughput, at up to a frame more latency.
+
+#ifndef OVR_Win32_FramePipeline_h
+#define OVR_Win32_FramePipeline_h
+
+#include <assert.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+template <typename T, int MaxDepth = 4>
+class FramePipeline
+{
+public:
+    struct StageTiming
+    {
+        double  WorkMs;     // Smoothed, from Begin to End
+        double  WaitMs;     // Smoothed, blocked in Begin for the previous stage (or the depth)
+        double  LastWorkMs;
+    };
+
+    FramePipeline(int stageCount, int depth = 1) :
+        StageCount(stageCount)
+    {
+        assert(stageCount >= 1 && stageCount <= MaxStages);
+        for (int i = 0; i < MaxDepth; ++i)
+            SlotState[i].store(0, std::memory_order_relaxed);
+        for (int s = 0; s < MaxStages; ++s)
+        {
+            Cursor[s].store(0, std::memory_order_relaxed);
+            Active[s] = false;
+            Timing[s] = StageTiming();
+        }
+        SetDepth(depth);
+    }
+
+    // Takes effect from the next frame stage 0 begins; lowering it lets the frames in flight drain
+    void SetDepth(int depth)
+    {
+        Depth.store(depth < 1 ? 1 : (depth > MaxDepth ? MaxDepth : depth), std::memory_order_relaxed);
+    }
+
+    int GetDepth() const
+    {
+        return Depth.load(std::memory_order_relaxed);
+    }
+
+    // The next frame's slot for stage, if it's ready for it, else nullptr
+    T* TryBegin(int stage)
+    {
+        assert(!Active[stage]);
+        const uint64_t seq = Cursor[stage].load(std::memory_order_relaxed);
+        if (stage == 0)
+        {
+            const uint64_t retired = Cursor[StageCount - 1].load(std::memory_order_acquire);
+            if (seq - retired >= (uint64_t)GetDepth())
+                return nullptr;
+        }
+        if (SlotState[seq % MaxDepth].load(std::memory_order_acquire) != stage)
+            return nullptr;
+
+        Active[stage] = true;
+        BeginTime[stage] = Clock::now();
+        return &Slots[seq % MaxDepth];
+    }
+
+    // Spins, yielding, until the next frame is ready for stage
+    T* Begin(int stage)
+    {
+        const Clock::time_point waitStart = Clock::now();
+        T* slot;
+        while ((slot = TryBegin(stage)) == nullptr)
+            std::this_thread::yield();
+        Smooth(Timing[stage].WaitMs, Milliseconds(waitStart, BeginTime[stage]));
+        return slot;
+    }
+
+    // The slot stage has begun and not yet ended, if any
+    T* Current(int stage)
+    {
+        return Active[stage] ? &Slots[Cursor[stage].load(std::memory_order_relaxed) % MaxDepth] : nullptr;
+    }
+
+    // Hands the frame on to the next stage; after the last stage, the slot is free for stage 0
+    void End(int stage)
+    {
+        assert(Active[stage]);
+        StageTiming& timing = Timing[stage];
+        timing.LastWorkMs = Milliseconds(BeginTime[stage], Clock::now());
+        Smooth(timing.WorkMs, timing.LastWorkMs);
+
+        const uint64_t seq = Cursor[stage].load(std::memory_order_relaxed);
+        Active[stage] = false;
+        SlotState[seq % MaxDepth].store((stage + 1) % StageCount, std::memory_order_release);
+        Cursor[stage].store(seq + 1, std::memory_order_release);
+    }
+
+    // Read from other threads, so may be a frame behind
+    const StageTiming& GetTiming(int stage) const
+    {
+        return Timing[stage];
+    }
+
+    // Frames the last stage has finished
+    uint64_t GetFramesCompleted() const
+    {
+        return Cursor[StageCount - 1].load(std::memory_order_acquire);
+    }
+
+    static const int MaxStages = 8;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    static double Milliseconds(Clock::time_point from, Clock::time_point to)
+    {
+        return std::chrono::duration<double, std::milli>(to - from).count();
+    }
+
+    static void Smooth(double& average, double sample)
+    {
+        average += 0.1 * (sample - average);
+    }
+
+    const int               StageCount;
+    std::atomic<int>        Depth;
+    T                       Slots[MaxDepth];
+    std::atomic<int>        SlotState[MaxDepth];
+    std::atomic<uint64_t>   Cursor[MaxStages];      // Frames each stage has ended
+    bool                    Active[MaxStages];      // Only touched by the stage's own thread
+    Clock::time_point       BeginTime[MaxStages];
+    StageTiming             Timing[MaxStages];
+};
+
+#endif // OVR_Win32_FramePipeline_h
@@ -23,6 +23,12 @@ void Texture::Init(int sizeW, int sizeH, bool rendertarget, int mipLevels, int s
     dsDesc.MiscFlags = 0;
     dsDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
     if (rendertarget) dsDesc.BindFlags |= D3D11_BIND_RENDER_TARGET;
+    if (mipLevels != 1 && sampleCount == 1)
+    {
+        // Let FillTexture generate the mips on the GPU, which needs a render target.
+        dsDesc.BindFlags |= D3D11_BIND_RENDER_TARGET;
+        dsDesc.MiscFlags |= D3D11_RESOURCE_MISC_GENERATE_MIPS;
+    }
 
     DIRECTX.Device->CreateTexture2D(&dsDesc, NULL, &Tex);
     DIRECTX.Device->CreateShaderResourceView(Tex, NULL, &TexSv);
@@ -63,27 +69,9 @@ Texture::~Texture()
 //------------------------------------------------------------------------------
 void Texture::FillTexture(DWORD * pix, int mipLevels)
 {
-    // Make local ones, because will be reducing them
-    int sizeW = SizeW; 
-    int sizeH = SizeH;
-    for (int level = 0; level < mipLevels; level++)
-    {
-        DIRECTX.Context->UpdateSubresource(Tex, level, NULL, (unsigned char *)pix, sizeW * 4, sizeH * 4);
-
-        for (int j = 0; j < (sizeH & ~1); j += 2)
-        {
-            u_char * psrc = (u_char *)pix + (sizeW * j * 4);
-            u_char * pdest = (u_char *)pix + (sizeW * j);
-            for (int i = 0; i < sizeW >> 1; i++, psrc += 8, pdest += 4)
-            {
-                pdest[0] = (((int)psrc[0]) + psrc[4] + psrc[sizeW * 4 + 0] + psrc[sizeW * 4 + 4]) >> 2;
-                pdest[1] = (((int)psrc[1]) + psrc[5] + psrc[sizeW * 4 + 1] + psrc[sizeW * 4 + 5]) >> 2;
-                pdest[2] = (((int)psrc[2]) + psrc[6] + psrc[sizeW * 4 + 2] + psrc[sizeW * 4 + 6]) >> 2;
-                pdest[3] = (((int)psrc[3]) + psrc[7] + psrc[sizeW * 4 + 3] + psrc[sizeW * 4 + 7]) >> 2;
-            }
-        }
-        sizeW >>= 1;  sizeH >>= 1;
-    }
+    // Upload the top level only, and have the GPU filter the rest down from it.
+    DIRECTX.Context->UpdateSubresource(Tex, 0, NULL, (unsigned char *)pix, SizeW * 4, SizeH * 4);
+    if (mipLevels != 1) DIRECTX.Context->GenerateMips(TexSv);
 }
 
 //-----------------------------------------------------------------------------------------
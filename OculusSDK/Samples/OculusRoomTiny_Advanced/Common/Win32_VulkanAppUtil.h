@@ -24,6 +24,8 @@ limitations under the License.
 #include <array>
 #include <functional>
 #include <unordered_map>
+#include <set>
+#include <vector>
 #include <assert.h>
 
 #if defined(_WIN32)
@@ -263,7 +265,9 @@ public:
     bool Init(uint32_t queueFamilyIndex);
     bool Begin();
     bool End();
-    bool Exec(VkQueue queue);
+    // Optionally waits on waitSemaphore at waitStage before executing, and signals signalSemaphore after
+    bool Exec(VkQueue queue, VkSemaphore waitSemaphore = VK_NULL_HANDLE, VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+              VkSemaphore signalSemaphore = VK_NULL_HANDLE);
     bool Wait();
     bool Reset();
     void SetState(CmdBufferState newState)
@@ -274,6 +278,193 @@ public:
     void Release();
 };
 
+// A range of device memory handed out by DeviceMemoryAllocator
+struct MemoryAllocation
+{
+    VkDeviceMemory          mem;
+    VkDeviceSize            offset;
+    VkDeviceSize            size;
+    uint8_t*                mapped;     // The range's CPU address, for host visible memory
+    uint32_t                pool;
+    uint32_t                block;
+    uint32_t                order;
+
+    MemoryAllocation() :
+        mem(VK_NULL_HANDLE),
+        offset(0),
+        size(0),
+        mapped(nullptr),
+        pool(0),
+        block(0),
+        order(0)
+    {
+    }
+};
+
+// Sub-allocates buffers and images out of large device memory blocks, rather than making a
+// vkAllocateMemory call (of the few maxMemoryAllocationCount allows) for each one.
+// There is a pool of blocks per memory type, and linear resources (buffers and linear images)
+// are kept apart from optimal images so neighbours never share a bufferImageGranularity page.
+// Blocks are split buddy style: a request is rounded up to a power of two no smaller than its
+// alignment, which keeps each node's offset aligned and lets a freed node merge with its buddy.
+// Host visible blocks are mapped once, when they are allocated, and stay mapped.
+class DeviceMemoryAllocator
+{
+public:
+    static const VkDeviceSize   BlockSize = 64 * 1024 * 1024;
+    static const VkDeviceSize   MinNodeSize = 256;
+    static const uint32_t       MaxOrder = 18;          // BlockSize == MinNodeSize << MaxOrder
+    static const uint32_t       DedicatedBlock = ~0u;   // The allocation has its own VkDeviceMemory
+
+    DeviceMemoryAllocator() :
+        device(VK_NULL_HANDLE),
+        memProps{},
+        pools()
+    {
+    }
+
+    void Init(VkDevice aDevice, const VkPhysicalDeviceMemoryProperties& aMemProps)
+    {
+        device = aDevice;
+        memProps = aMemProps;
+        pools.resize(memProps.memoryTypeCount * 2);
+    }
+
+    VkResult Allocate(const VkMemoryRequirements& memReqs, uint32_t memTypeIndex, bool linear, MemoryAllocation* alloc)
+    {
+        *alloc = MemoryAllocation();
+        alloc->pool = memTypeIndex * 2 + (linear ? 0 : 1);
+
+        // Anything that would take most of a block gets memory of its own
+        if (memReqs.size > BlockSize / 2)
+        {
+            alloc->block = DedicatedBlock;
+            alloc->size = memReqs.size;
+            return AllocateDeviceMemory(memReqs.size, memTypeIndex, &alloc->mem, &alloc->mapped);
+        }
+
+        VkDeviceSize required = (memReqs.size > memReqs.alignment) ? memReqs.size : memReqs.alignment;
+        uint32_t order = 0;
+        while ((MinNodeSize << order) < required)
+            ++order;
+
+        std::vector<Block>& blocks = pools[alloc->pool];
+        uint32_t blockIdx = 0;
+        VkDeviceSize offset = 0;
+        while ((blockIdx < blocks.size()) && !blocks[blockIdx].Take(order, &offset))
+            ++blockIdx;
+
+        if (blockIdx == blocks.size())
+        {
+            Block block;
+            VkResult result = AllocateDeviceMemory(BlockSize, memTypeIndex, &block.mem, &block.mapped);
+            if (result != VK_SUCCESS)
+                return result;
+            block.freeNodes.resize(MaxOrder + 1);
+            block.freeNodes[MaxOrder].insert(0);
+            blocks.push_back(std::move(block));
+            blocks.back().Take(order, &offset);
+        }
+
+        alloc->mem = blocks[blockIdx].mem;
+        alloc->offset = offset;
+        alloc->size = MinNodeSize << order;
+        alloc->mapped = blocks[blockIdx].mapped ? blocks[blockIdx].mapped + offset : nullptr;
+        alloc->block = blockIdx;
+        alloc->order = order;
+        return VK_SUCCESS;
+    }
+
+    void Free(MemoryAllocation& alloc)
+    {
+        if (alloc.mem)
+        {
+            if (alloc.block == DedicatedBlock)
+                vkFreeMemory(device, alloc.mem, nullptr);
+            else
+                pools[alloc.pool][alloc.block].Give(alloc.order, alloc.offset);
+        }
+        alloc = MemoryAllocation();
+    }
+
+    // Every allocation must have been freed, or be done with, by now
+    void Release()
+    {
+        if (device)
+        {
+            for (auto& blocks: pools)
+            {
+                for (auto& block: blocks)
+                    vkFreeMemory(device, block.mem, nullptr);
+            }
+        }
+        pools.clear();
+        device = VK_NULL_HANDLE;
+    }
+
+private:
+    struct Block
+    {
+        VkDeviceMemory                      mem = VK_NULL_HANDLE;
+        uint8_t*                            mapped = nullptr;
+        std::vector<std::set<VkDeviceSize>> freeNodes;  // Free node offsets, by order
+
+        bool Take(uint32_t order, VkDeviceSize* offset)
+        {
+            uint32_t from = order;
+            while ((from <= MaxOrder) && freeNodes[from].empty())
+                ++from;
+            if (from > MaxOrder)
+                return false;
+
+            *offset = *freeNodes[from].begin();
+            freeNodes[from].erase(freeNodes[from].begin());
+            // Split down to the size asked for, leaving the upper halves free
+            while (from > order)
+            {
+                --from;
+                freeNodes[from].insert(*offset + (MinNodeSize << from));
+            }
+            return true;
+        }
+
+        void Give(uint32_t order, VkDeviceSize offset)
+        {
+            for (; order < MaxOrder; ++order)
+            {
+                auto buddy = freeNodes[order].find(offset ^ (MinNodeSize << order));
+                if (buddy == freeNodes[order].end())
+                    break;
+                freeNodes[order].erase(buddy);
+                offset &= ~(MinNodeSize << order);
+            }
+            freeNodes[order].insert(offset);
+        }
+    };
+
+    VkResult AllocateDeviceMemory(VkDeviceSize size, uint32_t memTypeIndex, VkDeviceMemory* mem, uint8_t** mapped)
+    {
+        VkMemoryAllocateInfo memAlloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+        memAlloc.allocationSize = size;
+        memAlloc.memoryTypeIndex = memTypeIndex;
+        VkResult result = vkAllocateMemory(device, &memAlloc, nullptr, mem);
+        if ((result == VK_SUCCESS) && (memProps.memoryTypes[memTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+        {
+            result = vkMapMemory(device, *mem, 0, VK_WHOLE_SIZE, 0, (void**)mapped);
+            if (result != VK_SUCCESS)
+            {
+                vkFreeMemory(device, *mem, nullptr);
+                *mem = VK_NULL_HANDLE;
+            }
+        }
+        return result;
+    }
+
+    VkDevice                                    device;
+    VkPhysicalDeviceMemoryProperties            memProps;
+    std::vector<std::vector<Block>>             pools;      // By memory type, linear then optimal
+};
+
 // Vulkan platform
 class Vulkan: public VulkanObject
 {
@@ -300,7 +491,18 @@ public:
     std::array<CmdBuffer, Swapchain::maxImages> drawCmd;
     int                                 currentDrawCmd;
     CmdBuffer                           xferCmd;
+    // The mirror's copy and present for each of the frames that may be in flight, so the host
+    // only waits on the one from maxImages frames ago rather than the last
+    struct PresentFrame
+    {
+        CmdBuffer                       cmd;        // On xferQueue
+        VkSemaphore                     acquired = VK_NULL_HANDLE;  // Signaled by Swapchain::Aquire, waited on by cmd
+        VkSemaphore                     copied = VK_NULL_HANDLE;    // Signaled by cmd, waited on by Swapchain::Present
+    };
+    std::array<PresentFrame, Swapchain::maxImages> presentFrame;
+    int                                 currentPresentFrame;
     Swapchain                           sc;
+    DeviceMemoryAllocator               memAllocator;
     struct found
     {
         std::string             gpuName;
@@ -366,7 +568,10 @@ public:
         drawCmd(),
         currentDrawCmd(0),
         xferCmd(),
+        presentFrame(),
+        currentPresentFrame(0),
         sc(),
+        memAllocator(),
         found({ "(not found)" })
     {
     }
@@ -388,6 +593,17 @@ public:
         drawCmd[currentDrawCmd].Wait();
     }
 
+    PresentFrame& CurrentPresentFrame()
+    {
+        return presentFrame[currentPresentFrame];
+    }
+
+    void NextPresentFrame()
+    {
+        currentPresentFrame = (currentPresentFrame + 1) % presentFrame.size();
+        presentFrame[currentPresentFrame].cmd.Wait();
+    }
+
     void DumpVkPhysicalDevice() const
     {
         VkPhysicalDeviceIDPropertiesKHR gpuDevID{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES_KHR };
@@ -890,6 +1106,7 @@ public:
 
         Debug.Log("Creating device " + found.gpuName);
         CHECKVK(vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device));
+        memAllocator.Init(device, memProps);
 
         if (!isAMD)
         {
@@ -910,6 +1127,12 @@ public:
             CHECK(cmd.Init(found.drawQueueFamilyIndex));
         }
         CHECK(xferCmd.Init(found.xferQueueFamilyIndex));
+        for (auto& frame: presentFrame)
+        {
+            CHECK(frame.cmd.Init(found.xferQueueFamilyIndex));
+            CHECKVK(vkCreateSemaphore(device, &semInfo, nullptr, &frame.acquired));
+            CHECKVK(vkCreateSemaphore(device, &semInfo, nullptr, &frame.copied));
+        }
 
         CHECK(sc.Create());
 
@@ -918,14 +1141,28 @@ public:
 
     void ReleaseDevice()
     {
+        if (device)
+        {
+            // The present frames' fences only cover the copies, not the presents waiting on their semaphores
+            vkDeviceWaitIdle(device);
+        }
         for (auto& cmd: drawCmd)
             cmd.Release();
         xferCmd.Release();
         sc.Release();
+        for (auto& frame: presentFrame)
+        {
+            frame.cmd.Release();
+            if (device && frame.acquired) vkDestroySemaphore(device, frame.acquired, nullptr);
+            if (device && frame.copied) vkDestroySemaphore(device, frame.copied, nullptr);
+            frame.acquired = VK_NULL_HANDLE;
+            frame.copied = VK_NULL_HANDLE;
+        }
         if (device)
         {
             if (drawDone) vkDestroySemaphore(device, drawDone, nullptr);
             if (xferDone) vkDestroySemaphore(device, xferDone, nullptr);
+            memAllocator.Release();
             vkDestroyDevice(device, nullptr);
         }
         if (instance)
@@ -945,39 +1182,54 @@ public:
         instance = VK_NULL_HANDLE;
     }
 
-    VkResult AllocateMemory(VkMemoryRequirements const& memReqs, VkDeviceMemory* mem, VkFlags flags = 0, const void* pNext = nullptr) const
+    // Search memtypes to find first index with those properties
+    bool FindMemoryType(uint32_t memoryTypeBits, VkFlags flags, uint32_t* memTypeIndex) const
     {
-        // Search memtypes to find first index with those properties
         for (uint32_t i = 0; i < memProps.memoryTypeCount; ++i)
         {
-            if (memReqs.memoryTypeBits & (1 << i))
+            // Type is available, does it match user properties?
+            if ((memoryTypeBits & (1 << i)) && ((memProps.memoryTypes[i].propertyFlags & flags) == flags))
             {
-                // Type is available, does it match user properties?
-                if ((memProps.memoryTypes[i].propertyFlags & flags) == flags)
-                {
-                    VkMemoryAllocateInfo memAlloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, pNext };
-                    memAlloc.allocationSize = memReqs.size;
-                    memAlloc.memoryTypeIndex = i;
-                    return vkAllocateMemory(device, &memAlloc, nullptr, mem);
-                }
+                *memTypeIndex = i;
+                return true;
             }
         }
+        return false;
+    }
 
-        return VK_ERROR_FORMAT_NOT_SUPPORTED;
+    VkResult AllocateMemory(VkMemoryRequirements const& memReqs, VkDeviceMemory* mem, VkFlags flags = 0, const void* pNext = nullptr) const
+    {
+        VkMemoryAllocateInfo memAlloc = { VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, pNext };
+        if (!FindMemoryType(memReqs.memoryTypeBits, flags, &memAlloc.memoryTypeIndex))
+            return VK_ERROR_FORMAT_NOT_SUPPORTED;
+        memAlloc.allocationSize = memReqs.size;
+        return vkAllocateMemory(device, &memAlloc, nullptr, mem);
     }
 
-    VkResult AllocateBufferMemory(VkBuffer buf, VkDeviceMemory* mem, VkFlags flags = 0) const
+    // Buffer and image memory comes from memAllocator; bind it at alloc->offset, and give it back with FreeMemory
+    VkResult AllocateBufferMemory(VkBuffer buf, MemoryAllocation* alloc, VkFlags flags = 0)
     {
         VkMemoryRequirements memReq = {};
         vkGetBufferMemoryRequirements(device, buf, &memReq);
-        return AllocateMemory(memReq, mem, flags);
+        uint32_t memTypeIndex;
+        if (!FindMemoryType(memReq.memoryTypeBits, flags, &memTypeIndex))
+            return VK_ERROR_FORMAT_NOT_SUPPORTED;
+        return memAllocator.Allocate(memReq, memTypeIndex, true, alloc);
     }
 
-    VkResult AllocateImageMemory(VkImage img, VkDeviceMemory* mem, VkFlags flags = 0) const
+    VkResult AllocateImageMemory(VkImage img, MemoryAllocation* alloc, VkFlags flags = 0, VkImageTiling tiling = VK_IMAGE_TILING_OPTIMAL)
     {
         VkMemoryRequirements memReq = {};
         vkGetImageMemoryRequirements(device, img, &memReq);
-        return AllocateMemory(memReq, mem, flags);
+        uint32_t memTypeIndex;
+        if (!FindMemoryType(memReq.memoryTypeBits, flags, &memTypeIndex))
+            return VK_ERROR_FORMAT_NOT_SUPPORTED;
+        return memAllocator.Allocate(memReq, memTypeIndex, tiling == VK_IMAGE_TILING_LINEAR, alloc);
+    }
+
+    void FreeMemory(MemoryAllocation& alloc)
+    {
+        memAllocator.Free(alloc);
     }
 
     bool HandleMessages(void)
@@ -1140,8 +1392,14 @@ bool Swapchain::Aquire(VkSemaphore readySemaphore)
     }
 
     lastResult = vkAcquireNextImageKHR(Platform.device, swapchain, UINT64_MAX, readySemaphore, presentFence, &renderImageIdx);
-    if (lastResult != VK_SUCCESS)
-        return Recreate();
+    // A suboptimal swapchain still gave us an image, Present will recreate it
+    if ((lastResult != VK_SUCCESS) && (lastResult != VK_SUBOPTIMAL_KHR))
+    {
+        // No image this time, so neither readySemaphore nor the fence will be signaled
+        presentFence = VK_NULL_HANDLE;
+        Recreate();
+        return false;
+    }
 
     return true;
 }
@@ -1179,6 +1437,9 @@ bool Swapchain::Recreate()
         return false;
     }
 
+    // Copies and presents still in flight may be using the old images
+    CHECKVK(vkDeviceWaitIdle(Platform.device));
+
     Release();
 
     // Recreate the surface destroyed by Release
@@ -1284,13 +1545,24 @@ bool CmdBuffer::End()
     return true;
 }
 
-bool CmdBuffer::Exec(VkQueue queue)
+bool CmdBuffer::Exec(VkQueue queue, VkSemaphore waitSemaphore, VkPipelineStageFlags waitStage, VkSemaphore signalSemaphore)
 {
     CHECKCBSTATE(CmdBufferState::Executable);
 
     VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    if (waitSemaphore)
+    {
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &waitSemaphore;
+        submitInfo.pWaitDstStageMask = &waitStage;
+    }
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &buf;
+    if (signalSemaphore)
+    {
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &signalSemaphore;
+    }
     CHECKVK(vkQueueSubmit(queue, 1, &submitInfo, execFence));
 
     SetState(CmdBufferState::Executing);
@@ -1352,6 +1624,218 @@ void CmdBuffer::Release()
     execFence = VK_NULL_HANDLE;
 }
 
+// Uploads buffer and image contents through a host visible staging ring on the transfer queue, so
+// streaming data in never stalls drawing.  Copies go into the current batch until Submit, which
+// returns the semaphore the draw submission using them must wait on.  Where the transfer and draw
+// queue families differ, each copy releases its destination from the transfer family and records
+// the matching acquire on the draw command buffer given, which must be submitted after Submit.
+class UploadQueue: public VulkanObject
+{
+public:
+    static const uint32_t       batchCount = 2;
+    static const VkDeviceSize   batchSize = 4 * 1024 * 1024;    // Of staging memory per batch
+
+    struct Batch
+    {
+        CmdBuffer       cmd;        // On xferQueue
+        VkSemaphore     done;
+        VkDeviceSize    used;
+    };
+    std::array<Batch, batchCount>   batch;
+    uint32_t                        current;
+    VkBuffer                        stagingBuf;
+    MemoryAllocation                stagingMem;
+
+    UploadQueue() :
+        current(0),
+        stagingBuf(VK_NULL_HANDLE),
+        stagingMem()
+    {
+        for (auto& b: batch)
+        {
+            b.done = VK_NULL_HANDLE;
+            b.used = 0;
+        }
+    }
+
+    bool Create()
+    {
+        VkBufferCreateInfo bufInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+        bufInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        bufInfo.size = batchCount * batchSize;
+        CHECKVK(vkCreateBuffer(Platform.device, &bufInfo, nullptr, &stagingBuf));
+        CHECKVK(Platform.AllocateBufferMemory(stagingBuf, &stagingMem, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+        CHECKVK(vkBindBufferMemory(Platform.device, stagingBuf, stagingMem.mem, stagingMem.offset));
+
+        VkSemaphoreCreateInfo semInfo = { VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+        for (auto& b: batch)
+        {
+            CHECK(b.cmd.Init(Platform.found.xferQueueFamilyIndex));
+            CHECKVK(vkCreateSemaphore(Platform.device, &semInfo, nullptr, &b.done));
+            b.used = 0;
+        }
+        current = 0;
+
+        return true;
+    }
+
+    // Stages size bytes of data into the stagingBuf at *offset, in the current batch
+    bool Stage(const void* data, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset)
+    {
+        CHECKMSG(size <= batchSize, "Upload of " + std::to_string(size) + " bytes is larger than a staging batch");
+
+        VkDeviceSize start = (batch[current].used + alignment - 1) & ~(alignment - 1);
+        if (start + size > batchSize)
+        {
+            // Out of staging, so finish the batch now and wait for it: the draw submission then
+            // still has just the one semaphore, from the last batch, to wait on
+            Batch& full = batch[current];
+            CHECK(full.cmd.End() && full.cmd.Exec(Platform.xferQueue) && full.cmd.Wait());
+            CHECK(NextBatch());
+            start = 0;
+        }
+
+        Batch& b = batch[current];
+        if (b.cmd.state == CmdBuffer::CmdBufferState::Initialized)
+        {
+            CHECK(b.cmd.Begin());
+        }
+
+        *offset = current * batchSize + start;
+        memcpy(stagingMem.mapped + *offset, data, (size_t)size);
+        b.used = start + size;
+
+        return true;
+    }
+
+    // Copies data into dstBuf, to be read at dstStage with dstAccess by acquireCmd and what follows it
+    bool CopyToBuffer(VkBuffer dstBuf, VkDeviceSize dstOffset, const void* data, VkDeviceSize size,
+                      VkCommandBuffer acquireCmd, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+    {
+        VkDeviceSize srcOffset;
+        CHECK(Stage(data, size, 4, &srcOffset));
+
+        VkBufferCopy region = { srcOffset, dstOffset, size };
+        vkCmdCopyBuffer(batch[current].cmd.buf, stagingBuf, dstBuf, 1, &region);
+
+        if (Platform.found.xferQueueFamilyIndex != Platform.found.drawQueueFamilyIndex)
+        {
+            VkBufferMemoryBarrier bufBarrier = { VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER };
+            bufBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            bufBarrier.dstAccessMask = 0;
+            bufBarrier.srcQueueFamilyIndex = Platform.found.xferQueueFamilyIndex;
+            bufBarrier.dstQueueFamilyIndex = Platform.found.drawQueueFamilyIndex;
+            bufBarrier.buffer = dstBuf;
+            bufBarrier.offset = dstOffset;
+            bufBarrier.size = size;
+            vkCmdPipelineBarrier(batch[current].cmd.buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &bufBarrier, 0, nullptr);
+
+            bufBarrier.srcAccessMask = 0;
+            bufBarrier.dstAccessMask = dstAccess;
+            vkCmdPipelineBarrier(acquireCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, dstStage, 0, 0, nullptr, 1, &bufBarrier, 0, nullptr);
+        }
+
+        return true;
+    }
+
+    // Copies tightly packed 32 bit texels into mip 0 of dstImg, leaving it TRANSFER_DST_OPTIMAL
+    // for acquireCmd to carry on with, e.g. blitting the mips (which the transfer queue can't do)
+    bool CopyToImage(VkImage dstImg, uint32_t width, uint32_t height, const uint32_t* data, VkCommandBuffer acquireCmd)
+    {
+        VkDeviceSize srcOffset;
+        CHECK(Stage(data, sizeof(uint32_t) * width * height, 16, &srcOffset));
+
+        VkCommandBuffer xferCmd = batch[current].cmd.buf;
+
+        VkImageMemoryBarrier imgBarrier = { VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
+        imgBarrier.srcAccessMask = 0;
+        imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imgBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imgBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        imgBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imgBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imgBarrier.image = dstImg;
+        imgBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        vkCmdPipelineBarrier(xferCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imgBarrier);
+
+        VkBufferImageCopy region = {};
+        region.bufferOffset = srcOffset;
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+        region.imageExtent = { width, height, 1 };
+        vkCmdCopyBufferToImage(xferCmd, stagingBuf, dstImg, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        if (Platform.found.xferQueueFamilyIndex != Platform.found.drawQueueFamilyIndex)
+        {
+            // The layout stays the same, so the release and acquire only hand the image over
+            imgBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            imgBarrier.dstAccessMask = 0;
+            imgBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            imgBarrier.srcQueueFamilyIndex = Platform.found.xferQueueFamilyIndex;
+            imgBarrier.dstQueueFamilyIndex = Platform.found.drawQueueFamilyIndex;
+            vkCmdPipelineBarrier(xferCmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &imgBarrier);
+
+            imgBarrier.srcAccessMask = 0;
+            imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+            vkCmdPipelineBarrier(acquireCmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imgBarrier);
+        }
+
+        return true;
+    }
+
+    // Submits the copies made since the last Submit, returning the semaphore for the next draw
+    // submission to wait on, at VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, or VK_NULL_HANDLE if there were none
+    VkSemaphore Submit()
+    {
+        Batch& b = batch[current];
+        if (b.cmd.state != CmdBuffer::CmdBufferState::Recording)
+        {
+            return VK_NULL_HANDLE;
+        }
+
+        if (!(b.cmd.End() && b.cmd.Exec(Platform.xferQueue, VK_NULL_HANDLE, VK_PIPELINE_STAGE_TRANSFER_BIT, b.done) && NextBatch()))
+        {
+            Debug.Log("Submitting uploads failed");
+            return VK_NULL_HANDLE;
+        }
+
+        return b.done;
+    }
+
+    void Release()
+    {
+        for (auto& b: batch)
+        {
+            b.cmd.Release();
+            if (Platform.device && b.done) vkDestroySemaphore(Platform.device, b.done, nullptr);
+            b.done = VK_NULL_HANDLE;
+            b.used = 0;
+        }
+        if (Platform.device)
+        {
+            if (stagingBuf) vkDestroyBuffer(Platform.device, stagingBuf, nullptr);
+            Platform.FreeMemory(stagingMem);
+        }
+        stagingBuf = VK_NULL_HANDLE;
+        stagingMem = MemoryAllocation();
+        current = 0;
+    }
+
+private:
+    // Moves on to the next batch, once the GPU is done with its last use of the staging memory
+    bool NextBatch()
+    {
+        current = (current + 1) % batchCount;
+        Batch& b = batch[current];
+        CHECK(b.cmd.Wait());
+        CHECK(b.cmd.Reset());
+        b.used = 0;
+
+        return true;
+    }
+};
+
+static UploadQueue Uploads;
+
 // RenderPass wrapper
 class RenderPass: public VulkanObject
 {
@@ -1438,7 +1922,7 @@ class UniformBufferBase: public VulkanObject
 {
 public:
     VkBuffer                buf;
-    VkDeviceMemory          mem;
+    MemoryAllocation        mem;
     VkDescriptorBufferInfo  descInfo;
 
     UniformBufferBase() :
@@ -1458,10 +1942,10 @@ public:
         if (Platform.device)
         {
             if (buf) vkDestroyBuffer(Platform.device, buf, nullptr);
-            if (mem) vkFreeMemory(Platform.device, mem, nullptr);
+            Platform.FreeMemory(mem);
         }
         buf = VK_NULL_HANDLE;
-        mem = VK_NULL_HANDLE;
+        mem = MemoryAllocation();
         descInfo = {};
     }
 };
@@ -1479,7 +1963,7 @@ public:
 
         CHECKVK(Platform.AllocateBufferMemory(buf, &mem, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
 
-        CHECKVK(vkBindBufferMemory(Platform.device, buf, mem, 0));
+        CHECKVK(vkBindBufferMemory(Platform.device, buf, mem.mem, mem.offset));
 
         descInfo.buffer = buf;
         descInfo.offset = 0;
@@ -1490,10 +1974,8 @@ public:
 
     bool Update(const T& data)
     {
-        T* map = nullptr;
-        CHECKVK(vkMapMemory(Platform.device, mem, 0, sizeof(T), 0, (void **)&map));
-        *map = data;
-        CHECKVK(vkUnmapMemory(Platform.device, mem));
+        // Uniform buffers are host visible, so stay mapped
+        *(T*)mem.mapped = data;
 
         return true;
     }
@@ -1504,9 +1986,9 @@ class VertexBufferBase: public VulkanObject
 {
 public:
     VkBuffer                                        idxBuf;
-    VkDeviceMemory                                  idxMem;
+    MemoryAllocation                                idxMem;
     VkBuffer                                        vtxBuf;
-    VkDeviceMemory                                  vtxMem;
+    MemoryAllocation                                vtxMem;
     VkVertexInputBindingDescription                 bindDesc;
     std::vector<VkVertexInputAttributeDescription>  attrDesc;
 
@@ -1532,14 +2014,14 @@ public:
         if (Platform.device)
         {
             if (idxBuf) vkDestroyBuffer(Platform.device, idxBuf, nullptr);
-            if (idxMem) vkFreeMemory(Platform.device, idxMem, nullptr);
+            Platform.FreeMemory(idxMem);
             if (vtxBuf) vkDestroyBuffer(Platform.device, vtxBuf, nullptr);
-            if (vtxMem) vkFreeMemory(Platform.device, vtxMem, nullptr);
+            Platform.FreeMemory(vtxMem);
         }
         idxBuf = VK_NULL_HANDLE;
-        idxMem = VK_NULL_HANDLE;
+        idxMem = MemoryAllocation();
         vtxBuf = VK_NULL_HANDLE;
-        vtxMem = VK_NULL_HANDLE;
+        vtxMem = MemoryAllocation();
         bindDesc = {};
         attrDesc.clear();
     }
@@ -1552,17 +2034,17 @@ public:
     bool Create(uint32_t idxCount, uint32_t vtxCount)
     {
         VkBufferCreateInfo bufInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
-        bufInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+        bufInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         bufInfo.size = sizeof(uint16_t) * idxCount;
         CHECKVK(vkCreateBuffer(Platform.device, &bufInfo, nullptr, &idxBuf));
-        CHECKVK(Platform.AllocateBufferMemory(idxBuf, &idxMem, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
-        CHECKVK(vkBindBufferMemory(Platform.device, idxBuf, idxMem, 0));
+        CHECKVK(Platform.AllocateBufferMemory(idxBuf, &idxMem, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+        CHECKVK(vkBindBufferMemory(Platform.device, idxBuf, idxMem.mem, idxMem.offset));
 
-        bufInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+        bufInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
         bufInfo.size = sizeof(T) * vtxCount;
         CHECKVK(vkCreateBuffer(Platform.device, &bufInfo, nullptr, &vtxBuf));
-        CHECKVK(Platform.AllocateBufferMemory(vtxBuf, &vtxMem, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
-        CHECKVK(vkBindBufferMemory(Platform.device, vtxBuf, vtxMem, 0));
+        CHECKVK(Platform.AllocateBufferMemory(vtxBuf, &vtxMem, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
+        CHECKVK(vkBindBufferMemory(Platform.device, vtxBuf, vtxMem.mem, vtxMem.offset));
 
         bindDesc.binding = 0;
         bindDesc.stride = sizeof(T);
@@ -1571,26 +2053,17 @@ public:
         return true;
     }
 
-    bool UpdateIndicies(const uint16_t* data, uint32_t count, uint32_t offset = 0)
+    // The buffers are device local, so updates go through Uploads, acquired by drawCmd
+    bool UpdateIndicies(const uint16_t* data, uint32_t count, uint32_t offset = 0, VkCommandBuffer drawCmd = Platform.CurrentDrawCmd().buf)
     {
-        uint16_t* map = nullptr;
-        CHECKVK(vkMapMemory(Platform.device, idxMem, sizeof(map[0]) * offset, sizeof(map[0]) * count, 0, (void **)&map));
-        for (size_t i = 0; i < count; ++i)
-            map[i] = data[i];
-        vkUnmapMemory(Platform.device, idxMem);
-
-        return true;
+        return Uploads.CopyToBuffer(idxBuf, sizeof(uint16_t) * offset, data, sizeof(uint16_t) * count,
+                                    drawCmd, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
     }
 
-    bool UpdateVertexes(const T* data, uint32_t count, uint32_t offset = 0)
+    bool UpdateVertexes(const T* data, uint32_t count, uint32_t offset = 0, VkCommandBuffer drawCmd = Platform.CurrentDrawCmd().buf)
     {
-        T* map = nullptr;
-        CHECKVK(vkMapMemory(Platform.device, vtxMem, sizeof(map[0]) * offset, sizeof(map[0]) * count, 0, (void **)&map));
-        for (size_t i = 0; i < count; ++i)
-            map[i] = data[i];
-        vkUnmapMemory(Platform.device, vtxMem);
-
-        return true;
+        return Uploads.CopyToBuffer(vtxBuf, sizeof(T) * offset, data, sizeof(T) * count,
+                                    drawCmd, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
     }
 };
 
@@ -1601,24 +2074,18 @@ public:
     enum class Style { WHITE, WALL, FLOOR, CEILING, GRID };
 
     uint32_t        w, h, mipLevels;
-    VkImage         img;
-    VkDeviceMemory  mem;
-    VkImageView     view;
-    struct
-    {
-        VkImage         img;
-        VkDeviceMemory  mem;
-    } staging;
+    VkImage             img;
+    MemoryAllocation    mem;
+    VkImageView         view;
 
     Image() :
         w(0),
         h(0),
         mipLevels(0),
         img(VK_NULL_HANDLE),
-        mem(VK_NULL_HANDLE),
+        mem(),
         view(VK_NULL_HANDLE)
     {
-        staging = { VK_NULL_HANDLE, VK_NULL_HANDLE };
     }
 
     void SetLayout(uint32_t mipLevel, VkImageLayout oldLayout, VkImageLayout newLayout)
@@ -1670,34 +2137,6 @@ public:
         h = height;
         mipLevels = 1 + (uint32_t)std::floor(std::log2(w | h));
 
-        // Create a linear staging buffer for mip 0
-
-        VkImageCreateInfo imgInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
-        imgInfo.imageType = VK_IMAGE_TYPE_2D;
-        imgInfo.format = VK_FORMAT_B8G8R8A8_UNORM;
-        imgInfo.extent = { w, h, 1 };
-        imgInfo.mipLevels = 1;
-        imgInfo.arrayLayers = 1;
-        imgInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-        imgInfo.tiling = VK_IMAGE_TILING_LINEAR;
-        imgInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-        imgInfo.initialLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
-        CHECKVK(vkCreateImage(Platform.device, &imgInfo, nullptr, &staging.img));
-
-        CHECKVK(Platform.AllocateImageMemory(staging.img, &staging.mem, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
-
-        CHECKVK(vkBindImageMemory(Platform.device, staging.img, staging.mem, 0));
-
-        VkImageSubresource imgSubRes = {};
-        imgSubRes.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        imgSubRes.mipLevel = 0;
-        imgSubRes.arrayLayer = 0;
-        VkSubresourceLayout layout = {};
-        vkGetImageSubresourceLayout(Platform.device, staging.img, &imgSubRes, &layout);
-
-        uint8_t* data = nullptr;
-        CHECKVK(vkMapMemory(Platform.device, staging.mem, layout.offset, layout.size, 0, (void**)&data));
-
         // Generate mip level 0 texture on the CPU
         std::function<uint32_t(uint32_t x, uint32_t y)> f;
         switch (style)
@@ -1735,21 +2174,24 @@ public:
             break;
         }
 
+        std::vector<uint32_t> texels(w * h);
         for (uint32_t y = 0; y < h; ++y)
         {
-            uint32_t* row = (uint32_t*)&data[layout.offset + y * layout.rowPitch];
             for (uint32_t x = 0; x < w; ++x)
             {
-                row[x] = f(x, y);
+                texels[y * w + x] = f(x, y);
             }
         }
 
-        vkUnmapMemory(Platform.device, staging.mem);
-
         // Create the device-local image
 
-        // Use same create info as staging with these changes
+        VkImageCreateInfo imgInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+        imgInfo.imageType = VK_IMAGE_TYPE_2D;
+        imgInfo.format = VK_FORMAT_B8G8R8A8_UNORM;
+        imgInfo.extent = { w, h, 1 };
         imgInfo.mipLevels = mipLevels;
+        imgInfo.arrayLayers = 1;
+        imgInfo.samples = VK_SAMPLE_COUNT_1_BIT;
         imgInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
         imgInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
         imgInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -1757,7 +2199,10 @@ public:
 
         CHECKVK(Platform.AllocateImageMemory(img, &mem, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT));
 
-        CHECKVK(vkBindImageMemory(Platform.device, img, mem, 0));
+        CHECKVK(vkBindImageMemory(Platform.device, img, mem.mem, mem.offset));
+
+        // Write the finest level on the transfer queue, and blit it down to the others here
+        CHECK(Uploads.CopyToImage(img, w, h, texels.data(), Platform.CurrentDrawCmd().buf));
 
         VkImageBlit blit =
         {
@@ -1767,20 +2212,6 @@ public:
             { { 0, 0, 0 }, { (int32_t)w, (int32_t)h, 1 } }
         };
 
-        // Switch the staging buffer from PREINITIALIZED -> TRANSFER_SRC_OPTIMAL
-        VkImageMemoryBarrier imgBarrier{ VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER };
-        imgBarrier.oldLayout = VK_IMAGE_LAYOUT_PREINITIALIZED;
-        imgBarrier.srcAccessMask = 0;
-        imgBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-        imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-        imgBarrier.image = staging.img;
-        imgBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
-        vkCmdPipelineBarrier(Platform.CurrentDrawCmd().buf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &imgBarrier);
-
-        // Switch to writing the finest level
-        SetLayout(0, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        vkCmdBlitImage(Platform.CurrentDrawCmd().buf, staging.img, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, img, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
-
         for (uint32_t mipLevel = 1; mipLevel < mipLevels; ++mipLevel)
         {
             // Switch to reading from the finer level...
@@ -1831,16 +2262,12 @@ public:
     {
         if (Platform.device)
         {
-            if (staging.img) vkDestroyImage(Platform.device, staging.img, nullptr);
-            if (staging.mem) vkFreeMemory(Platform.device, staging.mem, nullptr);
             if (view) vkDestroyImageView(Platform.device, view, nullptr);
             if (img) vkDestroyImage(Platform.device, img, nullptr);
-            if (mem) vkFreeMemory(Platform.device, mem, nullptr);
+            Platform.FreeMemory(mem);
         }
-        staging.img = VK_NULL_HANDLE;
-        staging.mem = VK_NULL_HANDLE;
         view = VK_NULL_HANDLE;
-        mem = VK_NULL_HANDLE;
+        mem = MemoryAllocation();
         img = VK_NULL_HANDLE;
     }
 };
@@ -1850,7 +2277,7 @@ class DepthBuffer: public VulkanObject
 {
 public:
     VkFormat                format;
-    VkDeviceMemory          mem;
+    MemoryAllocation        mem;
     VkImage                 img;
     VkImageView             view;
 
@@ -1879,7 +2306,7 @@ public:
 
         CHECKVK(Platform.AllocateImageMemory(img, &mem));
 
-        CHECKVK(vkBindImageMemory(Platform.device, img, mem, 0));
+        CHECKVK(vkBindImageMemory(Platform.device, img, mem.mem, mem.offset));
 
         VkImageViewCreateInfo viewInfo = { VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
         viewInfo.image = img;
@@ -1906,11 +2333,11 @@ public:
         {
             if (view) vkDestroyImageView(Platform.device, view, nullptr);
             if (img) vkDestroyImage(Platform.device, img, nullptr);
-            if (mem) vkFreeMemory(Platform.device, mem, nullptr);
+            Platform.FreeMemory(mem);
         }
         view = VK_NULL_HANDLE;
         img = VK_NULL_HANDLE;
-        mem = VK_NULL_HANDLE;
+        mem = MemoryAllocation();
     }
 };
 
@@ -2079,23 +2506,19 @@ class PipelineLayout: public VulkanObject
 {
 public:
     VkDescriptorSetLayout   descLayout;
+    VkDescriptorSetLayout   constLayout;
     VkPipelineLayout        pipeLayout;
 
     PipelineLayout() :
         descLayout(VK_NULL_HANDLE),
+        constLayout(VK_NULL_HANDLE),
         pipeLayout(VK_NULL_HANDLE)
     {
     }
 
     bool Create()
     {
-        // MVP matrix is a push_constant
-        VkPushConstantRange pcr = {};
-        pcr.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-        pcr.offset = 0;
-        pcr.size = 4 * 4 * sizeof(float);
-
-        // Texture sampler descriptor
+        // Texture sampler descriptor (set 0)
         VkDescriptorSetLayoutBinding db = {};
         db.binding = 0;
         db.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -2107,12 +2530,22 @@ public:
         descLayoutInfo.pBindings = &db;
         CHECKVK(vkCreateDescriptorSetLayout(Platform.device, &descLayoutInfo, nullptr, &descLayout));
 
+        // MVP matrix uniform buffer (set 1), at a dynamic offset per draw so that a recorded
+        // command buffer can be replayed with new matrices (see Scene)
+        VkDescriptorSetLayoutBinding cb = {};
+        cb.binding = 0;
+        cb.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        cb.descriptorCount = 1;
+        cb.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+        descLayoutInfo.pBindings = &cb;
+        CHECKVK(vkCreateDescriptorSetLayout(Platform.device, &descLayoutInfo, nullptr, &constLayout));
+
+        std::array<VkDescriptorSetLayout, 2> setLayouts = { descLayout, constLayout };
         VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
         pipelineLayoutCreateInfo.flags = 0;
-        pipelineLayoutCreateInfo.setLayoutCount = 1;
-        pipelineLayoutCreateInfo.pSetLayouts = &descLayout;
-        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
-        pipelineLayoutCreateInfo.pPushConstantRanges = &pcr;
+        pipelineLayoutCreateInfo.setLayoutCount = (uint32_t)setLayouts.size();
+        pipelineLayoutCreateInfo.pSetLayouts = setLayouts.data();
         CHECKVK(vkCreatePipelineLayout(Platform.device, &pipelineLayoutCreateInfo, nullptr, &pipeLayout));
 
         return true;
@@ -2123,9 +2556,11 @@ public:
         if (Platform.device)
         {
             if (pipeLayout) vkDestroyPipelineLayout(Platform.device, pipeLayout, nullptr);
+            if (constLayout) vkDestroyDescriptorSetLayout(Platform.device, constLayout, nullptr);
             if (descLayout) vkDestroyDescriptorSetLayout(Platform.device, descLayout, nullptr);
         }
         descLayout = VK_NULL_HANDLE;
+        constLayout = VK_NULL_HANDLE;
         pipeLayout = VK_NULL_HANDLE;
     }
 };
@@ -2181,7 +2616,12 @@ public:
 
     void Bind(const PipelineLayout& pipeLayout)
     {
-        vkCmdBindDescriptorSets(Platform.CurrentDrawCmd().buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeLayout.pipeLayout, 0, 1, &descSet, 0, nullptr);
+        Bind(Platform.CurrentDrawCmd().buf, pipeLayout);
+    }
+
+    void Bind(VkCommandBuffer buf, const PipelineLayout& pipeLayout) const
+    {
+        vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeLayout.pipeLayout, 0, 1, &descSet, 0, nullptr);
     }
 
     void Release()
@@ -2228,6 +2668,11 @@ public:
         desc.Bind(pipeLayout);
     }
 
+    void Bind(VkCommandBuffer buf, const PipelineLayout& pipeLayout) const
+    {
+        desc.Bind(buf, pipeLayout);
+    }
+
     void Release()
     {
         sampler.Release();
@@ -2380,6 +2825,8 @@ public:
     uint32_t                vtxCount;
     uint32_t                firstIdx;
     int32_t                 vtxOffset;
+    Vector3f                boundsMin;  // Of the vertices, relative to pos
+    Vector3f                boundsMax;
 
     Model(Vector3f pos, Texture& tex) :
         pos(pos),
@@ -2389,7 +2836,9 @@ public:
         idxCount(0),
         vtxCount(0),
         firstIdx(0),
-        vtxOffset(0)
+        vtxOffset(0),
+        boundsMin(),
+        boundsMax()
     {
         vtx.reserve(100);
         idx.reserve(100);
@@ -2481,6 +2930,40 @@ public:
         *runningIdxCount += idxCount;
         vtxOffset = *runningVtxCount;
         *runningVtxCount += vtxCount;
+
+        for (size_t i = 0; i < vtx.size(); ++i)
+        {
+            Vector3f p(vtx[i].pos[0], vtx[i].pos[1], vtx[i].pos[2]);
+            boundsMin = (i == 0) ? p : Vector3f::Min(boundsMin, p);
+            boundsMax = (i == 0) ? p : Vector3f::Max(boundsMax, p);
+        }
+    }
+
+    // Whether all of the model's bounds are outside one of vp's frustum planes, so drawing it can be skipped
+    bool IsCulled(const Matrix4f& vp) const
+    {
+        Matrix4f mvp = vp * Matrix4f::Translation(pos);
+
+        int outside[6] = {};
+        for (int i = 0; i < 8; ++i)
+        {
+            Vector4f clip = mvp.Transform(Vector4f((i & 1) ? boundsMax.x : boundsMin.x,
+                                                   (i & 2) ? boundsMax.y : boundsMin.y,
+                                                   (i & 4) ? boundsMax.z : boundsMin.z, 1));
+            outside[0] += (clip.x < -clip.w);
+            outside[1] += (clip.x >  clip.w);
+            outside[2] += (clip.y < -clip.w);
+            outside[3] += (clip.y >  clip.w);
+            outside[4] += (clip.z <  0);
+            outside[5] += (clip.z >  clip.w);
+        }
+
+        for (int plane = 0; plane < 6; ++plane)
+        {
+            if (outside[plane] == 8)
+                return true;
+        }
+        return false;
     }
 
     bool UploadBuffers(VertexBuffer<Vertex>& vb)
@@ -2491,26 +2974,30 @@ public:
         return true;
     }
 
-    void Render(const Matrix4f& vp, const PipelineLayout& pipeLayout, const VertexBuffer<Vertex>& vb)
+    Matrix4f MVP(const Matrix4f& vp) const
     {
         Matrix4f mvp = vp * Matrix4f::Translation(pos);
         // Get back into column-major order
         mvp.Transpose();
+        return mvp;
+    }
 
-        auto& cmd = Platform.CurrentDrawCmd();
-        vkCmdPushConstants(cmd.buf, pipeLayout.pipeLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(mvp), &mvp.M[0][0]);
+    // Draws with the MVP matrix at constOffset in constSet's buffer
+    void Draw(VkCommandBuffer buf, const PipelineLayout& pipeLayout, VkDescriptorSet constSet, uint32_t constOffset, const VertexBuffer<Vertex>& vb) const
+    {
+        vkCmdBindDescriptorSets(buf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeLayout.pipeLayout, 1, 1, &constSet, 1, &constOffset);
 
-        tex.Bind(pipeLayout);
+        tex.Bind(buf, pipeLayout);
 
         // Bind index and vertex buffers at the Model's byte offsets
         VkDeviceSize offset = firstIdx * sizeof(uint16_t);
-        vkCmdBindIndexBuffer(cmd.buf, vb.idxBuf, offset, VK_INDEX_TYPE_UINT16);
+        vkCmdBindIndexBuffer(buf, vb.idxBuf, offset, VK_INDEX_TYPE_UINT16);
 
         offset = vtxOffset * sizeof(Vertex);
-        vkCmdBindVertexBuffers(cmd.buf, 0, 1, &vb.vtxBuf, &offset);
+        vkCmdBindVertexBuffers(buf, 0, 1, &vb.vtxBuf, &offset);
 
         //Debug.Log("Drawing " + std::to_string(idxCount) + " indices at " + std::to_string(firstIdx) + " vertex offset " + std::to_string(vtxOffset));
-        vkCmdDrawIndexed(cmd.buf, idxCount, 1, 0, 0, 0);
+        vkCmdDrawIndexed(buf, idxCount, 1, 0, 0, 0);
     }
 
     void Release()
@@ -2534,6 +3021,18 @@ public:
     Texture whiteTexture;
     std::vector<Model> models;
 
+    // Every model's MVP matrix, for each draw cmd and eye, constStride apart
+    static const uint32_t       eyeCount = 2;
+    static const VkDeviceSize   constStride = 256;  // The largest minUniformBufferOffsetAlignment allowed
+    VkBuffer                    constBuf;
+    MemoryAllocation            constMem;
+    VkDescriptorPool            constPool;
+    VkDescriptorSet             constSet;
+
+    // Recorded once each, see RenderStatic
+    VkCommandPool               staticPool;
+    std::array<std::array<VkCommandBuffer, eyeCount>, Swapchain::maxImages> staticCmd;
+
     Scene() :
         floorImage(),
         wallImage(),
@@ -2543,7 +3042,13 @@ public:
         wallTexture(),
         ceilingTexture(),
         whiteTexture(),
-        models()
+        models(),
+        constBuf(VK_NULL_HANDLE),
+        constMem(),
+        constPool(VK_NULL_HANDLE),
+        constSet(VK_NULL_HANDLE),
+        staticPool(VK_NULL_HANDLE),
+        staticCmd()
     {
     }
 
@@ -2553,11 +3058,69 @@ public:
         return &models.back();
     }
 
-    void Render(const Matrix4f& view, const Matrix4f& proj, const PipelineLayout& pipeLayout, const VertexBuffer<Vertex>& vb)
+    uint32_t ConstOffset(int drawCmd, uint32_t eye, size_t modelIdx) const
+    {
+        return (uint32_t)(((drawCmd * eyeCount + eye) * models.size() + modelIdx) * constStride);
+    }
+
+    // Writes the MVP matrices the current draw cmd reads for eye
+    void UpdateConsts(uint32_t eye, const Matrix4f& vp)
+    {
+        for (size_t i = 0; i < models.size(); ++i)
+        {
+            Matrix4f mvp = models[i].MVP(vp);
+            memcpy(constMem.mapped + ConstOffset(Platform.currentDrawCmd, eye, i), &mvp.M[0][0], sizeof(mvp));
+        }
+    }
+
+    void Render(const Matrix4f& view, const Matrix4f& proj, const PipelineLayout& pipeLayout, const VertexBuffer<Vertex>& vb, uint32_t eye)
     {
         Matrix4f vp = proj * view;
-        for (auto& model: models)
-            model.Render(vp, pipeLayout, vb);
+        UpdateConsts(eye, vp);
+
+        auto& cmd = Platform.CurrentDrawCmd();
+        for (size_t i = 0; i < models.size(); ++i)
+        {
+            if (!models[i].IsCulled(vp))
+                models[i].Draw(cmd.buf, pipeLayout, constSet, ConstOffset(Platform.currentDrawCmd, eye, i), vb);
+        }
+    }
+
+    // For static rooms: the draws are recorded once into a secondary command buffer per draw cmd and
+    // eye, so that a frame only writes the MVP matrices; models can still move, but not be added.
+    // The current draw cmd must be in subpass 0 of rp, begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS,
+    // and pipe is bound for the draws
+    bool RenderStatic(const Matrix4f& view, const Matrix4f& proj, const PipelineLayout& pipeLayout, const Pipeline& pipe,
+                      const RenderPass& rp, const VertexBuffer<Vertex>& vb, uint32_t eye)
+    {
+        VkCommandBuffer& staticBuf = staticCmd[Platform.currentDrawCmd][eye];
+        if (!staticBuf)
+        {
+            VkCommandBufferAllocateInfo cmdInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+            cmdInfo.commandPool = staticPool;
+            cmdInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            cmdInfo.commandBufferCount = 1;
+            CHECKVK(vkAllocateCommandBuffers(Platform.device, &cmdInfo, &staticBuf));
+
+            VkCommandBufferInheritanceInfo inheritInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO };
+            inheritInfo.renderPass = rp.pass;
+            inheritInfo.subpass = 0;
+            VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+            beginInfo.pInheritanceInfo = &inheritInfo;
+            CHECKVK(vkBeginCommandBuffer(staticBuf, &beginInfo));
+
+            vkCmdBindPipeline(staticBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pipe.pipe);
+            for (size_t i = 0; i < models.size(); ++i)
+                models[i].Draw(staticBuf, pipeLayout, constSet, ConstOffset(Platform.currentDrawCmd, eye, i), vb);
+
+            CHECKVK(vkEndCommandBuffer(staticBuf));
+        }
+
+        UpdateConsts(eye, proj * view);
+        vkCmdExecuteCommands(Platform.CurrentDrawCmd().buf, 1, &staticBuf);
+
+        return true;
     }
 
     bool Create(const PipelineLayout& pipeLayout, VertexBuffer<Vertex>& vb, bool includeIntensiveGPUobject = false)
@@ -2642,6 +3205,40 @@ public:
         }
         Debug.Log("Loaded " + std::to_string(models.size()) + " models (" + std::to_string(idxCount) + " indices and " + std::to_string(vtxCount) + " vertexes)");
 
+        // MVP matrices, host visible so that they stay mapped
+        VkBufferCreateInfo bufInfo = { VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+        bufInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+        bufInfo.size = ConstOffset(Swapchain::maxImages, 0, 0);
+        CHECKVK(vkCreateBuffer(Platform.device, &bufInfo, nullptr, &constBuf));
+        CHECKVK(Platform.AllocateBufferMemory(constBuf, &constMem, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT));
+        CHECKVK(vkBindBufferMemory(Platform.device, constBuf, constMem.mem, constMem.offset));
+
+        VkDescriptorPoolSize constPoolSize = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1 };
+        VkDescriptorPoolCreateInfo descPoolInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+        descPoolInfo.maxSets = 1;
+        descPoolInfo.poolSizeCount = 1;
+        descPoolInfo.pPoolSizes = &constPoolSize;
+        CHECKVK(vkCreateDescriptorPool(Platform.device, &descPoolInfo, nullptr, &constPool));
+
+        VkDescriptorSetAllocateInfo descAllocInfo = { VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+        descAllocInfo.descriptorPool = constPool;
+        descAllocInfo.descriptorSetCount = 1;
+        descAllocInfo.pSetLayouts = &pipeLayout.constLayout;
+        CHECKVK(vkAllocateDescriptorSets(Platform.device, &descAllocInfo, &constSet));
+
+        VkDescriptorBufferInfo constInfo = { constBuf, 0, sizeof(Matrix4f) };
+        VkWriteDescriptorSet write = { VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+        write.dstSet = constSet;
+        write.dstBinding = 0;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        write.pBufferInfo = &constInfo;
+        vkUpdateDescriptorSets(Platform.device, 1, &write, 0, nullptr);
+
+        VkCommandPoolCreateInfo cmdPoolInfo = { VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+        cmdPoolInfo.queueFamilyIndex = Platform.found.drawQueueFamilyIndex;
+        CHECKVK(vkCreateCommandPool(Platform.device, &cmdPoolInfo, nullptr, &staticPool));
+
         return true;
     }
 
@@ -2656,6 +3253,21 @@ public:
         ceilingImage.Release();
         whiteImage.Release();
         models.clear();
+
+        if (Platform.device)
+        {
+            // Frees the static command buffers with it
+            if (staticPool) vkDestroyCommandPool(Platform.device, staticPool, nullptr);
+            if (constPool) vkDestroyDescriptorPool(Platform.device, constPool, nullptr);
+            if (constBuf) vkDestroyBuffer(Platform.device, constBuf, nullptr);
+            Platform.FreeMemory(constMem);
+        }
+        staticPool = VK_NULL_HANDLE;
+        staticCmd = {};
+        constPool = VK_NULL_HANDLE;
+        constSet = VK_NULL_HANDLE;
+        constBuf = VK_NULL_HANDLE;
+        constMem = MemoryAllocation();
     }
 };
 
@@ -28,7 +28,10 @@ namespace TESTEDGE
     /// '2' hold for debug trigger of edge coming in.
     /// '3' hold to get it not to fade out
     /// '4' hold to get different holodeck and colours of main scene
+    /// '5' hold to composite the edge as a second layer, for comparison
     /// '9' hold 9 for lurch
+    /// The inner view normally goes into a sub-viewport of Layer0, straight after the static
+    /// room, so the effect costs one eye buffer and one compositor layer, as without it.
     bool equaliseHorizFovs;  
     #define INWARD_SPEED 0.01f
     #define OUTWARD_SPEED 0.005f
@@ -128,6 +131,8 @@ int TESTEDGE_Process_And_Render()
     Layer1->ld.Fov[0] = newFov[0];
     Layer1->ld.Fov[1] = newFov[1];
 
+    bool twoLayers = DIRECTX.Key['5'];
+
     // Render Scene to Eye Buffers
     for (int eye = 0; eye < 2; ++eye)
     {
@@ -140,12 +145,32 @@ int TESTEDGE_Process_And_Render()
             holoModel->Render(&(viewMatrix * projMatrix), 1, 1, 1, 1, true);
         else
             roomModelNoFurniture->Render(&(viewMatrix * projMatrix), 1, 1, 1, 1, true);
-        Layer0->FinishRendering(session, eye);
 
-        // Layer1
-        Layer1->PrepareToRender(session, eye, currPose[eye], sensorSampleTime, 0, 0, 0, 0, true);
-        projMatrix = VRCONVERT_Matrix44(ovrMatrix4f_Projection(Layer1->ld.Fov[eye], 0.2f, 1000.0f, ovrProjection_None));
-        viewMatrix = VRCONVERT_GetViewMatrixWithEyePose(mainCam, Layer1->ld.RenderPose[eye]);
+        // Layer1, or the part of Layer0 it would cover
+        VRLayer * innerLayer = Layer1;
+        if (twoLayers)
+        {
+            Layer0->FinishRendering(session, eye);
+            Layer1->PrepareToRender(session, eye, currPose[eye], sensorSampleTime, 0, 0, 0, 0, true);
+        }
+        else
+        {
+            // The compositor would map the smaller fov onto this rectangle of Layer0,
+            // so rendering it there with the same projection gives the same picture.
+            // Only depth is cleared, so the translucent scene blends over the room directly.
+            innerLayer = Layer0;
+            ovrFovPort outer = Layer0->ld.Fov[eye];
+            ovrRecti   vp    = Layer0->ld.Viewport[eye];
+            float scaleX = vp.Size.w / (outer.LeftTan + outer.RightTan);
+            float scaleY = vp.Size.h / (outer.UpTan + outer.DownTan);
+            Layer0->ClearDepth(session, eye);
+            DIRECTX.SetViewport(vp.Pos.x + scaleX * (outer.LeftTan - newFov[eye].LeftTan),
+                                vp.Pos.y + scaleY * (outer.UpTan - newFov[eye].UpTan),
+                                scaleX * (newFov[eye].LeftTan + newFov[eye].RightTan),
+                                scaleY * (newFov[eye].UpTan + newFov[eye].DownTan));
+        }
+        projMatrix = VRCONVERT_Matrix44(ovrMatrix4f_Projection(newFov[eye], 0.2f, 1000.0f, ovrProjection_None));
+        viewMatrix = VRCONVERT_GetViewMatrixWithEyePose(mainCam, innerLayer->ld.RenderPose[eye]);
 
         float amountOfTrans = 1.0f - (amountIn);
         if ((DIRECTX.Key['3']) || (noTrans)) amountOfTrans = 1.0f;
@@ -155,14 +180,20 @@ int TESTEDGE_Process_And_Render()
 
         GAME_Render(&(viewMatrix * projMatrix));
 
-        // Output text
+        // Output text, across the whole of Layer0 if sharing it
+        if (!twoLayers)
+        {
+            DIRECTX.SetViewport((float)Layer0->ld.Viewport[eye].Pos.x, (float)Layer0->ld.Viewport[eye].Pos.y,
+                (float)Layer0->ld.Viewport[eye].Size.w, (float)Layer0->ld.Viewport[eye].Size.h);
+            projMatrix = VRCONVERT_Matrix44(ovrMatrix4f_Projection(Layer0->ld.Fov[eye], 0.2f, 1000.0f, ovrProjection_None));
+        }
         INFOTEXT_RenderWithOwnCameraAndReset(projMatrix, Layer0->ld.RenderPose[eye]);
 
-        Layer1->FinishRendering(session, eye);
+        innerLayer->FinishRendering(session, eye);
     }
 
     // Submit all the layers to the compositor
-    return(2);
+    return(twoLayers ? 2 : 1);
 
 }
 
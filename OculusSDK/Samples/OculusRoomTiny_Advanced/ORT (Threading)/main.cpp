@@ -25,6 +25,10 @@ limitations under the License.
 /// in front of you.  By varying the input parameters, it
 /// is simple to fix this into the scene if required, rather than
 /// move and rotate with the player.
+/// The quad stays up while worker threads call the API concurrently: by default a random
+/// mix of calls for a fixed number of frames, as a crash and correctness check. With
+/// -benchmark on the command line it measures instead how each call scales with the
+/// number of threads calling it, see RunBenchmark below.
 
 #define   OVR_D3D_VERSION 11
 #include "../Common/Win32_DirectXAppUtil.h" // DirectX
@@ -33,6 +37,12 @@ limitations under the License.
 #include <thread>
 #include <array>
 #include <random>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <string>
+#include <sstream>
+#include <map>
 
 
 // note: run Test_Samples with --gtest_filter=Test_Samples.WinMain_Threading to run just this test
@@ -48,7 +58,7 @@ public:
     const char  *name;
     TestFn      fn;
     NamedTest(const char *name, TestFn fn) : name(name), fn(fn) {}
-    int operator() (ThreadTestStatePtr state);
+    int operator() (ThreadTestStatePtr state) const;
 };
 
 // list of named tests
@@ -87,7 +97,7 @@ struct ThreadTestState
 };
 
 // invoke a named test
-int NamedTest::operator() (ThreadTestStatePtr state)
+int NamedTest::operator() (ThreadTestStatePtr state) const
 {
     #if 0
     WCHAR message[1024];
@@ -287,6 +297,13 @@ ThreadTest(GetTimeInSeconds)
     return (t > 0) ? 0 : 1;
 }
 
+ThreadTest(GetPerfStats)
+{
+    ovrPerfStats stats;
+    ovrResult result = ovr_GetPerfStats(state->session, &stats);
+    return OVR_SUCCESS(result) ? 0 : 1;
+}
+
 ThreadTest(BoolProperties)
 {
     std::vector<const char *> names = { LIST_BOOL_PROPERTIES(PROPERTY_NAME) };
@@ -426,12 +443,367 @@ static void TestThread(ThreadTestState *state)
     
 }
 
+//
+// Benchmark mode. RunBenchmark calls one test at a time from each thread count in turn, while
+// the main loop keeps rendering and submitting frames, and writes the rate and latency of
+// every run to a CSV file. Command-line options:
+//   -benchmark
+//   -threads 1,2,4       Thread counts, by default powers of two up to the core count
+//   -duration 500        Milliseconds per test and thread count
+//   -contention same     Every thread calls the test back to back
+//               mixed    Thread 0 calls the test, the others run random tests as background load
+//               paced    Every thread calls the test at most -rate times a second
+//   -rate 1000
+//   -tests a,b           Only the named tests, by default all of them
+//   -minscaling 0.5      Fail if a thread's rate at N threads is less than 0.5 of the rate alone
+//   -baseline file.csv   Fail if a rate is more than -maxregression (0.2) below the one in file
+//   -out file.csv        Default ThreadingBenchmark.csv
+// Any test failing also fails the run.
+//
+
+enum ContentionProfile
+{
+    Contention_Same,
+    Contention_Mixed,
+    Contention_Paced
+};
+
+static const char* contentionNames[] = { "same", "mixed", "paced" };
+
+struct BenchmarkOptions
+{
+    bool                        enabled = false;
+    std::vector<int>            threadCounts;
+    int                         durationMs = 500;
+    ContentionProfile           contention = Contention_Same;
+    int                         rate = 1000;
+    std::vector<std::string>    tests;
+    double                      minScaling = 0;
+    std::string                 baseline;
+    double                      maxRegression = 0.2;
+    std::string                 output = "ThreadingBenchmark.csv";
+};
+
+static BenchmarkOptions benchmark;
+static std::atomic<bool> benchmarkPhaseRunning(false);
+static std::atomic<bool> benchmarkAbort(false);
+
+// Calls per run are sampled for the latency percentiles, as fast calls can run millions of times
+static const size_t maxLatencySamples = 65536;
+
+struct BenchmarkThread
+{
+    ThreadTestState     state;
+    const NamedTest*    test;           // Measured, or null for background load
+    int64_t             calls;
+    std::vector<float>  latencies;      // Microseconds, a uniform sample of the calls
+};
+
+struct BenchmarkResult
+{
+    std::string name;
+    int         threads;
+    double      callsPerSecond;         // Per measured thread
+    double      scaling;                // callsPerSecond over the rate with one thread
+    double      meanUs, p50Us, p99Us, maxUs;
+    int         failures;
+};
+
+static std::vector<std::string> SplitList(const std::string& list)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+// lpCmdLine is always ANSI, whatever the project's character set
+static void ParseCommandLine(const char* cmdLine)
+{
+    std::vector<std::string> args;
+    std::stringstream stream(cmdLine ? cmdLine : "");
+    std::string arg;
+    while (stream >> arg)
+        args.push_back(arg);
+
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        const std::string& name = args[i];
+        const bool hasValue = (i + 1 < args.size());
+        if (name == "-benchmark")
+            benchmark.enabled = true;
+        else if (!hasValue)
+            break;
+        else if (name == "-threads")
+        {
+            for (const std::string& count : SplitList(args[++i]))
+                benchmark.threadCounts.push_back(std::max(1, atoi(count.c_str())));
+        }
+        else if (name == "-duration")   benchmark.durationMs = std::max(1, atoi(args[++i].c_str()));
+        else if (name == "-rate")       benchmark.rate = std::max(1, atoi(args[++i].c_str()));
+        else if (name == "-tests")      benchmark.tests = SplitList(args[++i]);
+        else if (name == "-minscaling") benchmark.minScaling = atof(args[++i].c_str());
+        else if (name == "-baseline")   benchmark.baseline = args[++i];
+        else if (name == "-maxregression") benchmark.maxRegression = atof(args[++i].c_str());
+        else if (name == "-out")        benchmark.output = args[++i];
+        else if (name == "-contention")
+        {
+            const std::string& profile = args[++i];
+            for (int p = 0; p < 3; ++p)
+                if (profile == contentionNames[p])
+                    benchmark.contention = ContentionProfile(p);
+        }
+    }
+
+    if (benchmark.threadCounts.empty())
+    {
+        const int cores = std::max(1, int(std::thread::hardware_concurrency()));
+        for (int count = 1; count < cores; count *= 2)
+            benchmark.threadCounts.push_back(count);
+        benchmark.threadCounts.push_back(cores);
+    }
+}
+
+static void BenchmarkThreadFn(BenchmarkThread* thread)
+{
+    typedef std::chrono::steady_clock Clock;
+    const TestList& all = TestInstance::list;
+    std::uniform_int_distribution<> randtest(0, int(all.size() - 1));
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / benchmark.rate));
+    Clock::time_point next = Clock::now();
+
+    while (benchmarkPhaseRunning)
+    {
+        if (!thread->test)
+        {
+            if (all[randtest(thread->state.rand)](&thread->state))
+                ++thread->state.failures;
+            continue;
+        }
+
+        if (benchmark.contention == Contention_Paced)
+        {
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+
+        const Clock::time_point begin = Clock::now();
+        if ((*thread->test)(&thread->state))
+            ++thread->state.failures;
+        const float us = std::chrono::duration<float, std::micro>(Clock::now() - begin).count();
+
+        // Reservoir sampling, so that the latencies cover the whole run
+        ++thread->calls;
+        if (thread->latencies.size() < maxLatencySamples)
+            thread->latencies.push_back(us);
+        else
+        {
+            std::uniform_int_distribution<int64_t> randslot(0, thread->calls - 1);
+            const int64_t slot = randslot(thread->state.rand);
+            if (slot < int64_t(maxLatencySamples))
+                thread->latencies[size_t(slot)] = us;
+        }
+    }
+}
+
+static BenchmarkResult RunBenchmarkPhase(ovrSession session, const NamedTest& test, int threadCount, std::mt19937& seeder)
+{
+    std::vector<BenchmarkThread> threads(threadCount);
+    std::vector<std::thread> handles(threadCount);
+
+    benchmarkPhaseRunning = true;
+    for (int i = 0; i < threadCount; ++i)
+    {
+        BenchmarkThread& thread = threads[i];
+        thread.state.id = i;
+        thread.state.session = session;
+        thread.state.rand.seed(seeder());
+        thread.state.failures = 0;
+        thread.test = ((i == 0) || (benchmark.contention != Contention_Mixed)) ? &test : nullptr;
+        thread.calls = 0;
+        thread.latencies.reserve(maxLatencySamples);
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < threadCount; ++i)
+        handles[i] = std::thread(BenchmarkThreadFn, &threads[i]);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(benchmark.durationMs));
+    benchmarkPhaseRunning = false;
+    for (std::thread& handle : handles)
+        handle.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    BenchmarkResult result = {};
+    result.name = test.name;
+    result.threads = threadCount;
+
+    int64_t calls = 0;
+    int measured = 0;
+    std::vector<float> latencies;
+    for (BenchmarkThread& thread : threads)
+    {
+        result.failures += thread.state.failures;
+        if (!thread.test)
+            continue;
+        calls += thread.calls;
+        ++measured;
+        latencies.insert(latencies.end(), thread.latencies.begin(), thread.latencies.end());
+    }
+
+    result.callsPerSecond = double(calls) / (seconds * measured);
+    if (!latencies.empty())
+    {
+        std::sort(latencies.begin(), latencies.end());
+        double sum = 0;
+        for (float us : latencies)
+            sum += us;
+        result.meanUs = sum / latencies.size();
+        result.p50Us = latencies[latencies.size() / 2];
+        result.p99Us = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        result.maxUs = latencies.back();
+    }
+    return result;
+}
+
+// Rates from an earlier -out file, keyed by test, contention and thread count
+static std::map<std::string, double> LoadBaseline(const std::string& path)
+{
+    std::map<std::string, double> rates;
+    FILE* file = fopen(path.c_str(), "r");
+    if (!file)
+        return rates;
+
+    char line[512];
+    while (fgets(line, sizeof(line), file))
+    {
+        std::vector<std::string> fields = SplitList(line);
+        if ((fields.size() >= 4) && (fields[0] != "test"))
+            rates[fields[0] + "," + fields[1] + "," + fields[2]] = atof(fields[3].c_str());
+    }
+    fclose(file);
+    return rates;
+}
+
+// Returns the number of test failures plus the number of runs below a threshold
+static int RunBenchmark(ovrSession session)
+{
+    std::mt19937 seeder(0xfeedface);
+    const std::map<std::string, double> baseline = LoadBaseline(benchmark.baseline);
+    const char* contention = contentionNames[benchmark.contention];
+
+    FILE* out = fopen(benchmark.output.c_str(), "w");
+    if (out)
+        fprintf(out, "test,contention,threads,callsPerSecond,scaling,meanUs,p50Us,p99Us,maxUs,failures,verdict\n");
+
+    int failures = 0;
+    for (const NamedTest& test : TestInstance::list)
+    {
+        if (!benchmark.tests.empty() &&
+            (std::find(benchmark.tests.begin(), benchmark.tests.end(), test.name) == benchmark.tests.end()))
+            continue;
+
+        double singleRate = 0;
+        for (int threadCount : benchmark.threadCounts)
+        {
+            if (benchmarkAbort)
+                break;
+
+            BenchmarkResult result = RunBenchmarkPhase(session, test, threadCount, seeder);
+            if (threadCount == 1)
+                singleRate = result.callsPerSecond;
+            result.scaling = (singleRate > 0) ? (result.callsPerSecond / singleRate) : 0;
+
+            const char* verdict = "ok";
+            const std::string key = std::string(test.name) + "," + contention + "," + std::to_string(threadCount);
+            std::map<std::string, double>::const_iterator base = baseline.find(key);
+            if (result.failures > 0)
+                verdict = "failed";
+            else if ((threadCount > 1) && (singleRate > 0) && (result.scaling < benchmark.minScaling))
+                verdict = "poor scaling";
+            else if ((base != baseline.end()) && (result.callsPerSecond < base->second * (1 - benchmark.maxRegression)))
+                verdict = "regressed";
+
+            if (strcmp(verdict, "ok") != 0)
+                ++failures;
+
+            char line[512];
+            snprintf(line, sizeof(line), "%s,%s,%d,%.0f,%.3f,%.2f,%.2f,%.2f,%.2f,%d,%s\n",
+                     test.name, contention, threadCount, result.callsPerSecond, result.scaling,
+                     result.meanUs, result.p50Us, result.p99Us, result.maxUs, result.failures, verdict);
+            OutputDebugStringA(line);
+            if (out)
+                fputs(line, out);
+        }
+    }
+
+    if (out)
+        fclose(out);
+    return failures;
+}
+
 struct Threading : BasicVR
 {
     int threadCode;
 
     Threading(HINSTANCE hinst) : BasicVR(hinst, L"Threading"), threadCode(0) {}
 
+    // Renders the room, with the static quad in front of it, and submits the frame. Returns
+    // false if the app should quit or the frame couldn't be submitted.
+    bool RenderFrame(OculusTexture& extraRenderTexture, const ovrPosef& zeroPose)
+    {
+        if (!HandleMessages())
+            return false;
+
+        ActionFromInput();
+        Layer[0]->GetEyePoses();
+
+        for (int eye = 0; eye < 2; eye++)
+        {
+            Layer[0]->RenderSceneToEyeBuffer(MainCam, RoomScene, eye);
+        }
+
+        Layer[0]->PrepareLayerHeader();
+
+        // Expanded distort and present from the basic sample, to allow for direct quad
+        ovrLayerHeader* layerHeaders[2];
+
+        // The standard one
+        layerHeaders[0] = &Layer[0]->ovrLayer.Header;
+
+        // ...and now the new quad
+        static ovrLayerQuad myQuad;
+        myQuad.Header.Type = ovrLayerType_Quad;
+        myQuad.Header.Flags = 0;
+        myQuad.ColorTexture = extraRenderTexture.TextureChain;
+        myQuad.Viewport.Pos.x = 0;
+        myQuad.Viewport.Pos.y = 0;
+        myQuad.Viewport.Size.w = extraRenderTexture.SizeW;
+        myQuad.Viewport.Size.h = extraRenderTexture.SizeH;
+        myQuad.QuadPoseCenter = zeroPose;
+        myQuad.QuadPoseCenter.Position.z = -1.0f;
+        myQuad.QuadSize.x = 1.0f;
+        myQuad.QuadSize.y = 2.0f;
+        layerHeaders[1] = &myQuad.Header;
+
+        // Submit them
+        presentResult = ovr_SubmitFrame(Session, 0, nullptr, layerHeaders, 2);
+        if (!OVR_SUCCESS(presentResult))
+            return false;
+
+        // Render mirror
+        ID3D11Resource* resource = nullptr;
+        ovr_GetMirrorTextureBufferDX(Session, mirrorTexture, IID_PPV_ARGS(&resource));
+        DIRECTX.Context->CopyResource(DIRECTX.BackBuffer, resource);
+        resource->Release();
+        DIRECTX.SwapChain->Present(0, 0);
+        return true;
+    }
+
     void MainLoop()
     {
         threadCode = 0;
@@ -458,6 +830,31 @@ struct Threading : BasicVR
         // Commit changes to extraRenderTexture
         extraRenderTexture.Commit();
 
+        // Benchmark mode: the runner steps through the tests while frames go on being submitted
+        if (benchmark.enabled)
+        {
+            std::atomic<bool> benchmarkDone(false);
+            int benchmarkFailures = 0;
+            std::thread runner([&]()
+            {
+                benchmarkFailures = RunBenchmark(Session);
+                benchmarkDone = true;
+            });
+
+            for (frameIndex = 0; !benchmarkDone; ++frameIndex)
+            {
+                if (!RenderFrame(extraRenderTexture, zeroPose))
+                    benchmarkAbort = true;
+                if (benchmarkAbort)
+                    break;
+            }
+
+            runner.join();
+            if (benchmarkFailures > 0)
+                throw benchmarkFailures;
+            return;
+        }
+
         ThreadTestState state[numThreads] = {};
         std::thread thread[numThreads];
 
@@ -487,51 +884,8 @@ struct Threading : BasicVR
         // main rendering loop
         for (frameIndex = 0; frameIndex < maxFrames; ++frameIndex)
         {
-            if (!HandleMessages())
+            if (!RenderFrame(extraRenderTexture, zeroPose))
                 break;
-
-            ActionFromInput();
-            Layer[0]->GetEyePoses();
-
-            for (int eye = 0; eye < 2; eye++)
-            {
-                Layer[0]->RenderSceneToEyeBuffer(MainCam, RoomScene, eye);
-            }
-
-            Layer[0]->PrepareLayerHeader();
-
-            // Expanded distort and present from the basic sample, to allow for direct quad
-            ovrLayerHeader* layerHeaders[2];
-
-            // The standard one
-            layerHeaders[0] = &Layer[0]->ovrLayer.Header;
-
-            // ...and now the new quad
-            static ovrLayerQuad myQuad;
-            myQuad.Header.Type = ovrLayerType_Quad;
-            myQuad.Header.Flags = 0;
-            myQuad.ColorTexture = extraRenderTexture.TextureChain;
-            myQuad.Viewport.Pos.x = 0;
-            myQuad.Viewport.Pos.y = 0;
-            myQuad.Viewport.Size.w = extraRenderTexture.SizeW;
-            myQuad.Viewport.Size.h = extraRenderTexture.SizeH;
-            myQuad.QuadPoseCenter = zeroPose;
-            myQuad.QuadPoseCenter.Position.z = -1.0f;
-            myQuad.QuadSize.x = 1.0f;
-            myQuad.QuadSize.y = 2.0f;
-            layerHeaders[1] = &myQuad.Header;
-
-		    // Submit them
-            presentResult = ovr_SubmitFrame(Session, 0, nullptr, layerHeaders, 2);
-            if (!OVR_SUCCESS(presentResult))
-                return;
-
-		    // Render mirror
-            ID3D11Resource* resource = nullptr;
-            ovr_GetMirrorTextureBufferDX(Session, mirrorTexture, IID_PPV_ARGS(&resource));
-		    DIRECTX.Context->CopyResource(DIRECTX.BackBuffer, resource);
-            resource->Release();
-		    DIRECTX.SwapChain->Present(0, 0);
         }
 
         running = false;
@@ -550,8 +904,9 @@ struct Threading : BasicVR
 };
 
 //-------------------------------------------------------------------------------------
-int WINAPI WinMain(HINSTANCE hinst, HINSTANCE, LPSTR, int)
+int WINAPI WinMain(HINSTANCE hinst, HINSTANCE, LPSTR args, int)
 {
+    ParseCommandLine(args);
 	Threading app(hinst);
     return app.Run();
     // XXX figure out which threads are failing...
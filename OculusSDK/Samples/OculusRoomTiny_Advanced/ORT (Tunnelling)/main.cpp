@@ -30,21 +30,83 @@ limitations under the License.
 /// Periodically the two regions are synched - thus if you aren't adding
 /// additional movements or yaws, then the scene is unaffected.
 
+/// The width of the outer margin now follows how fast you are moving and turning,
+/// growing quickly as you set off and shrinking slowly once you stop.
 /// Press 1 and 2 to vary the transparency of the outer margin
-/// Press 3,4,5 and 6 to vary the x and y widths of the outer margin.
+/// Press 3,4,5 and 6 to vary the x and y widths of the outer margin at full speed.
 /// For now, the outer part is synched with the moving frame of reference
 /// once every 60 game loops
 
+/// The margins are a family of masks, built up front for a range of widths, rather than
+/// geometry rebuilt each frame, and rebuilt only when keys 3 to 6 change the widths.
+/// Both eyes share the same symmetric fov, so one family serves both.
+/// The masks also cut the cost of the two scene renders.  The static scene is drawn
+/// behind a centre mask at the nearest depth, so only the margin is shaded, and is skipped
+/// altogether when there is no margin.  If the margin is opaque it is drawn before the
+/// moving scene, again at the nearest depth, so the moving scene is only shaded inside it.
+/// Hence a heavier tunnel costs less GPU time, rather than more.
+
 #define   OVR_D3D_VERSION 11
 #include "../Common/Win32_DirectXAppUtil.h" // DirectX
 #include "../Common/Win32_BasicVR.h"  // Basic VR
 
-
+#define TUNNEL_LEVELS 32        // Number of precomputed margin widths, level 0 being none
+#define TUNNEL_IN_SPEED 0.05f   // Change of tunnel proportion per frame, when closing in
+#define TUNNEL_OUT_SPEED 0.02f  // and when opening out
 
 struct Tunnelling : BasicVR
 {
     Tunnelling(HINSTANCE hinst) : BasicVR(hinst, L"Tunnelling") {}
 
+    // The four quads around the edge of the screen, sampling the same region of the
+    // static eye texture.  At z of zero, so they sit at the nearest depth.
+    Model * CreateMarginModel(Material * mat, float marginx, float marginy)
+    {
+        TriangleSet quad;
+        float zDepth = 0;
+        float minx, miny, maxx, maxy;
+
+        //Left side
+        minx = -1; miny = -1;  maxx = -1 + 2*marginx; maxy = 1;
+        quad.AddQuad(Vertex(XMFLOAT3(minx, miny, zDepth), 0xffffffff, 0, 1.0f),
+                     Vertex(XMFLOAT3(minx, maxy, zDepth), 0xffffffff, 0, 0),
+                     Vertex(XMFLOAT3(maxx, miny, zDepth), 0xffffffff, marginx, 1.0f),
+                     Vertex(XMFLOAT3(maxx, maxy, zDepth), 0xffffffff, marginx, 0));
+
+        //Right side
+        minx = 1 - 2*marginx; miny = -1;  maxx = 1.0f; maxy = 1;
+        quad.AddQuad(Vertex(XMFLOAT3(minx, miny, zDepth), 0xffffffff, 1-marginx, 1.0f),
+                     Vertex(XMFLOAT3(minx, maxy, zDepth), 0xffffffff, 1-marginx, 0),
+                     Vertex(XMFLOAT3(maxx, miny, zDepth), 0xffffffff, 1.0f, 1.0f),
+                     Vertex(XMFLOAT3(maxx, maxy, zDepth), 0xffffffff, 1.0f, 0));
+
+        //Top middle
+        minx = -1 + 2*marginx; miny = 1 - 2*marginy;  maxx = 1 - 2*marginx; maxy = 1;
+        quad.AddQuad(Vertex(XMFLOAT3(minx, miny, zDepth), 0xffffffff, marginx, marginy),
+                     Vertex(XMFLOAT3(minx, maxy, zDepth), 0xffffffff, marginx, 0.0f),
+                     Vertex(XMFLOAT3(maxx, miny, zDepth), 0xffffffff, 1-marginx, marginy),
+                     Vertex(XMFLOAT3(maxx, maxy, zDepth), 0xffffffff, 1-marginx, 0.0f));
+
+        //Bot middle
+        minx = -1 + 2*marginx; miny = -1.0f;  maxx = 1 - 2*marginx; maxy = -1 + 2*marginy;
+        quad.AddQuad(Vertex(XMFLOAT3(minx, miny, zDepth), 0xffffffff, marginx, 1.00f),
+                     Vertex(XMFLOAT3(minx, maxy, zDepth), 0xffffffff, marginx, 1-marginy),
+                     Vertex(XMFLOAT3(maxx, miny, zDepth), 0xffffffff, 1-marginx, 1.0f),
+                     Vertex(XMFLOAT3(maxx, maxy, zDepth), 0xffffffff, 1-marginx, 1-marginy));
+
+        return(new Model(&quad, XMFLOAT3(0, 0, 0), XMFLOAT4(0, 0, 0, 1), mat));
+    }
+
+    // The models share their materials, so we detach them before deleting
+    void DeleteMasks(Model ** marginMask, Model ** centreMask)
+    {
+        for (int level = 0; level < TUNNEL_LEVELS; level++)
+        {
+            if (marginMask[level]) { marginMask[level]->Fill = nullptr; delete marginMask[level]; marginMask[level] = nullptr; }
+            if (centreMask[level]) { centreMask[level]->Fill = nullptr; delete centreMask[level]; centreMask[level] = nullptr; }
+        }
+    }
+
     void MainLoop()
     {
 		//Ensure symmetric frustom to make simple sample work
@@ -60,16 +122,21 @@ struct Tunnelling : BasicVR
         auto width = max(Layer[0]->pEyeRenderTexture[0]->SizeW, Layer[0]->pEyeRenderTexture[1]->SizeW);
         auto height = max(Layer[0]->pEyeRenderTexture[0]->SizeH, Layer[0]->pEyeRenderTexture[1]->SizeH);
         auto staticEyeTexture = new Texture(true, width, height);
- 		TriangleSet quad;
-		Material * staticMat = new Material(staticEyeTexture);
-		Model * renderEyeTexture = 0;
-		float marginx = 0.35f;
-		float marginy = 0.35f;
-
+        Material * staticMat = new Material(staticEyeTexture);
+        Material * centreMat = new Material(new Texture(false, 8, 8, Texture::AUTO_WHITE));
+        float marginx = 0.35f;
+        float marginy = 0.35f;
 
+        // The family of masks, for each proportion of the full margins
+        Model * marginMask[TUNNEL_LEVELS] = {};
+        Model * centreMask[TUNNEL_LEVELS] = {};
+        float builtMarginx = -1, builtMarginy = -1;
 
 		//Start the static camera to match
         Camera StaticMainCam = *MainCam;
+        XMVECTOR lastPos = MainCam->Pos;
+        XMVECTOR lastRot = MainCam->Rot;
+        float tunnel = 0;
 
 	    while (HandleMessages())
 	    {
@@ -90,88 +157,88 @@ struct Tunnelling : BasicVR
 			marginy = min(1.0f,marginy);
 			marginy = max(0.0f,marginy);
 
-			//Lets make a fresh model------------------------
-			//We do it here in the game loop so we can vary its size
-			quad.numIndices = 0;
-			quad.numVertices = 0;
-			float zDepth = 0;
-			float minx,miny,maxx,maxy; 
-
-			//Left side
-			minx = -1; miny = -1;  maxx = -1 + 2*marginx; maxy = 1; 
-			quad.AddQuad(Vertex(XMFLOAT3(minx, miny, zDepth), 0xffffffff, 0, 1.0f),
-				Vertex(XMFLOAT3(minx, maxy, zDepth), 0xffffffff, 0, 0),
-				Vertex(XMFLOAT3(maxx, miny, zDepth), 0xffffffff, marginx, 1.0f),
-				Vertex(XMFLOAT3(maxx, maxy, zDepth), 0xffffffff, marginx, 0));
-        
-			//Right side
-			minx = 1- 2*marginx; miny = -1;  maxx = 1.0f; maxy = 1; 
-			quad.AddQuad(Vertex(XMFLOAT3(minx, miny, zDepth), 0xffffffff, 1-marginx, 1.0f),
-						 Vertex(XMFLOAT3(minx, maxy, zDepth), 0xffffffff, 1-marginx, 0),
-						 Vertex(XMFLOAT3(maxx, miny, zDepth), 0xffffffff, 1.0f, 1.0f),
-						 Vertex(XMFLOAT3(maxx, maxy, zDepth), 0xffffffff, 1.0f, 0));
-        
-			//Top middle
-			minx = -1 + 2*marginx; miny = 1-2*marginy;  maxx = 1-2*marginx; maxy = 1; 
-			quad.AddQuad(Vertex(XMFLOAT3(minx, miny, zDepth), 0xffffffff, marginx, marginy),
-						 Vertex(XMFLOAT3(minx, maxy, zDepth), 0xffffffff, marginx, 0.0f),
-						 Vertex(XMFLOAT3(maxx, miny, zDepth), 0xffffffff, 1-marginx, marginy),
-						 Vertex(XMFLOAT3(maxx, maxy, zDepth), 0xffffffff, 1-marginx, 0.0f));
-        
-			//Bot middle
-			minx = -1 + 2*marginx; miny = -1.0f;  maxx = 1-2*marginx; maxy = -1+2*marginy; 
-			quad.AddQuad(Vertex(XMFLOAT3(minx, miny, zDepth), 0xffffffff, marginx, 1.00f),
-						 Vertex(XMFLOAT3(minx, maxy, zDepth), 0xffffffff, marginx, 1-marginy),
-						 Vertex(XMFLOAT3(maxx, miny, zDepth), 0xffffffff, 1-marginx, 1.0f),
-						 Vertex(XMFLOAT3(maxx, maxy, zDepth), 0xffffffff, 1-marginx, 1-marginy));
- 			//Delete the vertices, leave the material intact.
-			//A little wasteful of memory, but lets not worry
-			if (renderEyeTexture)
-			{
-		        delete renderEyeTexture->VertexBuffer; renderEyeTexture->VertexBuffer = nullptr;
-			    delete renderEyeTexture->IndexBuffer; renderEyeTexture->IndexBuffer = nullptr;
-			}
-			renderEyeTexture = new Model(&quad,XMFLOAT3(0,0,0),XMFLOAT4(0,0,0,1),staticMat);
-			//----------------
-
-			
+            // Rebuild the masks only if the margins have changed
+            if ((marginx != builtMarginx) || (marginy != builtMarginy))
+            {
+                DeleteMasks(marginMask, centreMask);
+                for (int level = 0; level < TUNNEL_LEVELS; level++)
+                {
+                    float prop = level / (float)(TUNNEL_LEVELS - 1);
+                    float mx = prop * marginx, my = prop * marginy;
+                    marginMask[level] = CreateMarginModel(staticMat, mx, my);
+                    centreMask[level] = new Model(centreMat, -1 + 2*mx, -1 + 2*my, 1 - 2*mx, 1 - 2*my);
+                }
+                builtMarginx = marginx;
+                builtMarginy = marginy;
+            }
+
+            // How fast are we moving and turning, where 1 is full walking or turning speed
+            float distMoved = XMVectorGetX(XMVector3Length(XMVectorSubtract(MainCam->Pos, lastPos)));
+            float angleTurned = 2 * acos(min(1.0f, fabs(XMVectorGetX(XMQuaternionDot(MainCam->Rot, lastRot)))));
+            float targetTunnel = min(1.0f, distMoved / 0.05f + angleTurned / 0.02f);
+            lastPos = MainCam->Pos;
+            lastRot = MainCam->Rot;
+            if (targetTunnel > tunnel) tunnel = min(targetTunnel, tunnel + TUNNEL_IN_SPEED);
+            else                       tunnel = max(targetTunnel, tunnel - TUNNEL_OUT_SPEED);
+            int level = (int)(tunnel * (TUNNEL_LEVELS - 1) + 0.5f);
+
+            // Different levels of transparency on buttons '1' and '2'. 
+            static float proportionOfStatic = 1.0f;
+            if (DIRECTX.Key['1']) proportionOfStatic += 0.001f;
+            if (DIRECTX.Key['2']) proportionOfStatic -= 0.001f;
+			proportionOfStatic = min(1.0f,proportionOfStatic);
+			proportionOfStatic = max(0.0f,proportionOfStatic);
+
+			//Just change colour on a button press
+            float marginGreen = 1;
+			if ((DIRECTX.Key['1'])
+			 || (DIRECTX.Key['2']) 
+			 || (DIRECTX.Key['3']) 
+			 || (DIRECTX.Key['4']) 
+			 || (DIRECTX.Key['5']) 
+			 || (DIRECTX.Key['6'])) 
+                marginGreen = 0;
+
+            // With no margin, or an invisible one, it is just the moving scene
+            bool drawMargin = (level > 0) && (proportionOfStatic > 0);
+            bool opaqueMargin = proportionOfStatic >= 1.0f;
 
 		    for (int eye = 0; eye < 2; ++eye)
 		    {
-                // Render the scene from an unmoving, static player - to the new buffer
-                Layer[0]->RenderSceneToEyeBuffer(&StaticMainCam, RoomScene, eye, staticEyeTexture->TexRtv, 0, 1, 1, 1, 1, 1);
-
-                // Render the scene as normal
-                Layer[0]->RenderSceneToEyeBuffer(MainCam, RoomScene, eye, 0, 0, 1, 1, 1, 1, 1); 
-
-                // Render static one over the top - different levels of transparency on buttons '1' and '2'. 
-                static float proportionOfStatic = 1.0f;
-                if (DIRECTX.Key['1']) proportionOfStatic += 0.001f;
-                if (DIRECTX.Key['2']) proportionOfStatic -= 0.001f;
-				proportionOfStatic = min(1.0f,proportionOfStatic);
-				proportionOfStatic = max(0.0f,proportionOfStatic);
-
-				//Just change colour on a button press
-				if ((DIRECTX.Key['1'])
-				 || (DIRECTX.Key['2']) 
-				 || (DIRECTX.Key['3']) 
-				 || (DIRECTX.Key['4']) 
-				 || (DIRECTX.Key['5']) 
-				 || (DIRECTX.Key['6'])) 
-				{
-				    renderEyeTexture->Render(&XMMatrixIdentity(), 1, 0, 1, proportionOfStatic, true); 
-				}
-				else
-				{
-				    renderEyeTexture->Render(&XMMatrixIdentity(), 1, 1, 1, proportionOfStatic, true); 
-				}
+                if (drawMargin)
+                {
+                    // Render the scene from an unmoving, static player - to the new buffer,
+                    // with the centre masked off as it is never seen.
+                    DIRECTX.SetAndClearRenderTarget(staticEyeTexture->TexRtv, Layer[0]->pEyeDepthBuffer[eye]);
+                    DIRECTX.SetViewport((float)Layer[0]->EyeRenderViewport[eye].Pos.x, (float)Layer[0]->EyeRenderViewport[eye].Pos.y,
+                        (float)Layer[0]->EyeRenderViewport[eye].Size.w, (float)Layer[0]->EyeRenderViewport[eye].Size.h);
+                    centreMask[level]->Render(&XMMatrixIdentity(), 1, 1, 1, 1, true);
+                    Layer[0]->RenderSceneToEyeBuffer(&StaticMainCam, RoomScene, eye, staticEyeTexture->TexRtv, 0, 1, 1, 1, 1, 1,
+                        0.2f, 1000.0f, false);
+                }
+
+                // Render the scene as normal, behind an opaque margin if we have one
+                DIRECTX.SetAndClearRenderTarget(Layer[0]->pEyeRenderTexture[eye]->GetRTV(), Layer[0]->pEyeDepthBuffer[eye]);
+                DIRECTX.SetViewport((float)Layer[0]->EyeRenderViewport[eye].Pos.x, (float)Layer[0]->EyeRenderViewport[eye].Pos.y,
+                    (float)Layer[0]->EyeRenderViewport[eye].Size.w, (float)Layer[0]->EyeRenderViewport[eye].Size.h);
+                if (drawMargin && opaqueMargin)
+                    marginMask[level]->Render(&XMMatrixIdentity(), 1, marginGreen, 1, 1, true);
+                Layer[0]->RenderSceneToEyeBuffer(MainCam, RoomScene, eye, 0, 0, 1, 1, 1, 1, 1, 0.2f, 1000.0f, false);
+
+                // Or blend a translucent one over the top
+                if (drawMargin && !opaqueMargin)
+                    marginMask[level]->Render(&XMMatrixIdentity(), 1, marginGreen, 1, proportionOfStatic, true);
+
+                Layer[0]->pEyeRenderTexture[eye]->Commit();
 		    }
 
 		    Layer[0]->PrepareLayerHeader();
 		    DistortAndPresent(1);
 	    }
 
-        delete renderEyeTexture;
+        DeleteMasks(marginMask, centreMask);
+        delete staticMat;
+        delete centreMat;
     }
 };
 
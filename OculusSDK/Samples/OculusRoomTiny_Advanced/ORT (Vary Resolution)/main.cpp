@@ -21,7 +21,9 @@ limitations under the License.
 /// of the resolution of the eye buffers.  Press '1' or '2' and the resolutions
 /// cycle through low to high.  Having such dynamic resolution enables some 
 /// applications to control their frame-rate, if lower resolution buffers significantly
-/// improves performance.
+/// improves performance.  With neither key held, the resolution is picked from 
+/// the SDK's perf stats, to keep up with the display as the GPU load varies.
+/// Hold '3' to render the room many times over, giving it more to keep up with.
 
 #define   OVR_D3D_VERSION 11
 #include "../Common/Win32_DirectXAppUtil.h" // DirectX
@@ -34,6 +36,7 @@ struct VaryResolution : BasicVR
     void MainLoop()
     {
 	    Layer[0] = new VRLayer(Session);
+        AdaptiveResolution adaptiveResolution(Session);
 
 	    while (HandleMessages())
 	    {
@@ -44,6 +47,10 @@ struct VaryResolution : BasicVR
             static int clock = 0;
             ++clock;
 
+            bool manual = DIRECTX.Key['1'] || DIRECTX.Key['2'];
+            if (!manual) adaptiveResolution.Apply(Layer[0]);
+            int timesToRenderRoom = DIRECTX.Key['3'] ? 20 : 1;
+
             for (int eye = 0; eye < 2; ++eye)
             {
                 // Realtime adjustment of eye buffer resolution,
@@ -58,11 +65,14 @@ struct VaryResolution : BasicVR
                     Layer[0]->EyeRenderViewport[eye].Size.h =
                         int(Layer[0]->pEyeRenderTexture[eye]->SizeW * (1.25f + sin(0.1f * clock)) / 2.25f);
                 }
-                Layer[0]->RenderSceneToEyeBuffer(MainCam, RoomScene, eye);
+                Layer[0]->RenderSceneToEyeBuffer(MainCam, RoomScene, eye, 0, 0, timesToRenderRoom);
             }
 
 		    Layer[0]->PrepareLayerHeader();
 		    DistortAndPresent(1);
+
+            // The stats of the frames just submitted pick the next frame's resolution
+            if (!manual) adaptiveResolution.Update();
 	    }
     }
 };
@@ -146,12 +146,36 @@ OculusWorldDemoApp::OculusWorldDemoApp() :
     FPS(0.f),
     LastFpsUpdate(0.0),
     LastUpdate(0.0),
+    TimingLogFile(nullptr),
+    BenchmarkMode(false),
+    BenchmarkReportPath(),
+    BenchmarkFrames(0),
+    BenchmarkFovTan(1.0f),
+    BenchmarkEyeSize(1024, 1024),
+    ScriptPoseEnabled(false),
+    ScriptPose(),
+    PoseTraceRecorder(),
+    PoseTraceReplay(),
+    PoseTraceCurrent(),
+    PoseTraceReplaying(false),
+    PoseTraceStartTime(0.0),
+    GpuTimingRequested(false),
+    GpuTraceTrack(nullptr),
+    GpuTraceNames(),
+    FrameTraceTrack(nullptr),
+    FrameTraceStarts(),
+    FrameTraceLastVsync(-1),
+    FrameTraceAppDropped(0),
+    FrameTraceCompositorDropped(0),
+    FrameTraceAsw(-1),
 
     TouchHapticsPlayIndex(0),
 
     MainFilePath(),
     CollisionModels(),
     GroundCollisionModels(),
+    CollisionTree(),
+    GroundCollisionTree(),
 
     LoadingState(LoadingState_Frame0),
 
@@ -201,6 +225,8 @@ OculusWorldDemoApp::OculusWorldDemoApp() :
     HmdSettingsChanged(false),
 
     RendertargetIsSharedByBothEyes(false),
+    SinglePassStereoEnabled(false),
+    MainSceneRenderedStereo(false),
     FovStencilType(-1),  // -1 means disable
     FovStencilMeshes(),
     FovStencilLinesX(),
@@ -217,6 +243,7 @@ OculusWorldDemoApp::OculusWorldDemoApp() :
 
     HasInputState(false),
     ConnectedControllerTypes(0),
+    MenuLayerTexture(nullptr),
     InterAxialDistance(0.0f),
     MonoscopicRenderMode(Mono_Off),
     PositionTrackingScale(1.0f),
@@ -256,6 +283,10 @@ OculusWorldDemoApp::OculusWorldDemoApp() :
     NeverRenderedIntoEyeTextures(false),
     EnableTimewarpOnMainLayer(true),
     PredictionEnabled(true),
+    LateLatchEnabled(false),
+    LateLatchActive(false),
+    LateLatchHmdToEyePose(),
+    LateLatchPositionScale(1.0f),
     FreezeEyeUpdate(false),
 
     DiscreteHmdRotationEnable(false),
@@ -314,6 +345,7 @@ OculusWorldDemoApp::OculusWorldDemoApp() :
 #endif
     PositionTrackingEnabled(true),
     MirrorToWindow(true),
+    RecordMirror(false),
 
     DistortionClearBlue(0),
 
@@ -339,6 +371,29 @@ OculusWorldDemoApp::OculusWorldDemoApp() :
     ComfortTurnMode(ComfortTurn_Off),
     SceneAnimationEnabled(true),
     SceneAnimationTime(0.0),
+    FrustumCullingEnabled(true),
+    SceneCuller(),
+    CulledModelCount(0),
+    OcclusionCullingEnabled(false),
+    SceneOcclusion(),
+    OccludedModelCount(0),
+    LodSelectionEnabled(true),
+    LodMaxPixelError(1.0f),
+    SimplifiedModelCount(0),
+    DrawSortingEnabled(true),
+    DepthPrepassEnabled(false),
+    SceneQueue(),
+    ParallelRecordingEnabled(false),
+    SplitVertexStreams(false),
+    QuantizedVertices(false),
+    MergeStaticModels(true),
+    PackSmallTextures(true),
+    TextureStreamingEnabled(false),
+    TextureBudgetMB(256),
+    SceneTextureStreamer(),
+    AssetCacheEnabled(true),
+    AssetCacheLimitMB(512),
+    SceneAssetCache(),
     BlocksShowType(0),
     BlocksShowMeshType(0),
     BlocksSpeed(1.0f),
@@ -376,6 +431,10 @@ OculusWorldDemoApp::OculusWorldDemoApp() :
     MenuPopulated(false),
 
     Profiler(),
+    PipelinedSimulation(false),
+    SimulationPending(false),
+    PendingFrame(),
+    SimulationGroup(),
     IsVisionLogging(false),
     SensorSampleTimestamp(0.0),
     EyeLayer(),
@@ -491,6 +550,31 @@ OculusWorldDemoApp::~OculusWorldDemoApp()
     ClearScene();
     DestroyRendering();
     ovr_Shutdown();
+
+    if (!ProfileTracePath.empty())
+    {
+        ScopeProfiler::Stop();
+        if (!ScopeProfiler::WriteChromeTrace(ProfileTracePath.c_str()))
+            WriteLog("[OculusWorldDemoApp] Failed to write profile trace %s.", ProfileTracePath.c_str());
+    }
+
+    if (TimingLogFile)
+    {
+        Profiler.SetWindowHandler(nullptr);
+        fclose(TimingLogFile);
+    }
+
+    if (BenchmarkMode && !writeBenchmarkReport(BenchmarkReportPath.c_str()))
+        WriteLog("[OculusWorldDemoApp] Failed to write benchmark report %s.", BenchmarkReportPath.c_str());
+
+    if (PoseTraceRecorder.IsOpen())
+    {
+        const uint32_t frames = PoseTraceRecorder.GetFrameCount();
+        if (PoseTraceRecorder.Close())
+            WriteLog("[OculusWorldDemoApp] Recorded %u frames of pose trace.", frames);
+        else
+            WriteLog("[OculusWorldDemoApp] Failed to write pose trace.");
+    }
 }
 
 void OculusWorldDemoApp::DestroyFovStencil()
@@ -511,6 +595,7 @@ void OculusWorldDemoApp::DestroyFovStencil()
 
 void OculusWorldDemoApp::DestroyRendering()
 {
+    discardSimulatedFrame(true);
     CleanupDrawTextFont();
 
     if (Session)
@@ -532,6 +617,10 @@ void OculusWorldDemoApp::DestroyRendering()
         }
 
         MirrorTexture.Clear();
+#if defined(OVR_OS_MS)
+        MirrorRecorder.Stop();
+        RecordMirror = false;
+#endif
 
 
         // Need to explicitly clean these up because they can contain SwapTextureSets,
@@ -550,6 +639,9 @@ void OculusWorldDemoApp::DestroyRendering()
 
         PositionalTracker.Clear();
 
+        // The cached textures and buffers belong to the device.
+        SceneAssetCache.Clear();
+
         pPlatform->DestroyGraphics();
         pRender = nullptr;
 
@@ -586,6 +678,11 @@ int OculusWorldDemoApp::OnStartup(int argc, const char** argv)
 
     OVR::Thread::SetCurrentThreadName("OWDMain");
 
+    if (!FrameMemory.Init())
+    {
+        WriteLog("[OculusWorldDemoApp] Failed to reserve %u bytes of frame memory.", (unsigned)FrameMemory.GetCapacity());
+    }
+
 
 
     // *** Oculus HMD Initialization
@@ -626,6 +723,18 @@ int OculusWorldDemoApp::OnStartup(int argc, const char** argv)
             }
         }
 
+        if (!OVR_stricmp(argStrClean, "scriptcompile"))
+        {
+            if (i < argc - 1) // next arg is the compiled script file path
+            {
+                // Follows -scriptfile, whose script is written compiled.
+                bool result = OwdScript.SaveCompiledScript(argv[i + 1]);
+                if (!result)
+                    WriteLog("[OculusWorldDemoApp] Failed to save compiled script %s.", argv[i + 1]);
+                ++i; // move past the file path
+            }
+        }
+
         if (!OVR_stricmp(argStrClean, "scriptoutputpath"))
         {
           if (i <= argc - 1) // next arg is the script output path
@@ -637,11 +746,113 @@ int OculusWorldDemoApp::OnStartup(int argc, const char** argv)
           }
         }
 
+        if (!OVR_stricmp(argStrClean, "profiletrace"))
+        {
+            if (i < argc - 1) // next arg is the trace file path
+            {
+                ProfileTracePath = argv[i + 1];
+                ScopeProfiler::Start();
+                ScopeProfiler::SetThreadName("Main");
+                ++i; // move past the file path
+            }
+        }
+
+        if (!OVR_stricmp(argStrClean, "timinglog"))
+        {
+            if (i < argc - 1) // next arg is the CSV file path
+            {
+                TimingLogFile = fopen(argv[i + 1], "w");
+                if (!TimingLogFile)
+                    WriteLog("[OculusWorldDemoApp] Failed to open timing log %s.", argv[i + 1]);
+                else
+                {
+                    // One row per sample type and stage for each window of frames, times in milliseconds.
+                    fprintf(TimingLogFile, "window,sample,count,mean,p50,p95,p99,max\n");
+                    Profiler.SetWindowHandler([this](const TimingStats* stats, int windowIndex)
+                    {
+                        static const char* sampleNames[RenderProfiler::Sample_LAST] =
+                            { "FrameInterval", "AfterGameProcessing", "AfterEyeRender", "AfterPresent" };
+                        for (int sample = 0; sample < RenderProfiler::Sample_LAST; sample++)
+                        {
+                            fprintf(TimingLogFile, "%d,%s,%u,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                                    windowIndex, sampleNames[sample], stats[sample].Count,
+                                    stats[sample].Mean * 1000.0, stats[sample].P50 * 1000.0,
+                                    stats[sample].P95 * 1000.0, stats[sample].P99 * 1000.0,
+                                    stats[sample].Max * 1000.0);
+                        }
+                        for (int stage = 0; stage < RenderProfiler::Stage_LAST; stage++)
+                        {
+                            const RenderProfiler::StageType stageType = (RenderProfiler::StageType)stage;
+                            const TimingStats& stageStats = Profiler.GetWindowStageStats(stageType);
+                            fprintf(TimingLogFile, "%d,Stage%s,%u,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+                                    windowIndex, RenderProfiler::GetStageName(stageType), stageStats.Count,
+                                    stageStats.Mean * 1000.0, stageStats.P50 * 1000.0,
+                                    stageStats.P95 * 1000.0, stageStats.P99 * 1000.0,
+                                    stageStats.Max * 1000.0);
+                        }
+                        fflush(TimingLogFile);
+                    });
+                }
+                ++i; // move past the file path
+            }
+        }
+
+        if (!OVR_stricmp(argStrClean, "gputiming"))
+        {
+            GpuTimingRequested = true;
+        }
+
+        if (!OVR_stricmp(argStrClean, "timingwindow"))
+        {
+            if (i < argc - 1) // next arg is the number of frames per window
+            {
+                Profiler.SetWindowFrames(atoi(argv[i + 1]));
+                ++i; // move past the frame count
+            }
+        }
+
         if (!OVR_stricmp(argStrClean, "automation"))
         {
             InteractiveMode = false;
         }
 
+        if (!OVR_stricmp(argStrClean, "benchmark"))
+        {
+            if (i < argc - 1) // next arg is the report file path
+            {
+                BenchmarkMode         = true;
+                BenchmarkReportPath   = argv[i + 1];
+                InteractiveMode       = false;
+                ResolutionScalingMode = ResolutionScalingMode_Off;
+
+                // The head stays at the origin until the script sets its pose.
+                ScriptPoseEnabled = true;
+                ScriptPose        = Posef::Identity();
+                Timer::SetVirtualSeconds(0.0);
+                ++i; // move past the file path
+            }
+        }
+
+        if (!OVR_stricmp(argStrClean, "posetracerecord"))
+        {
+            if (i < argc - 1) // next arg is the trace file path
+            {
+                if (!PoseTraceRecorder.Open(argv[i + 1]))
+                    WriteLog("[OculusWorldDemoApp] Failed to open pose trace %s for writing.", argv[i + 1]);
+                ++i; // move past the file path
+            }
+        }
+
+        if (!OVR_stricmp(argStrClean, "posetracereplay"))
+        {
+            if (i < argc - 1) // next arg is the trace file path
+            {
+                if (!PoseTraceReplay.Open(argv[i + 1]))
+                    WriteLog("[OculusWorldDemoApp] Failed to load pose trace %s.", argv[i + 1]);
+                ++i; // move past the file path
+            }
+        }
+
         if (!OVR_stricmp(argStrClean, "replay"))
         {
             if ( i <= argc - 1 ) // next arg is the filename
@@ -979,6 +1190,10 @@ bool OculusWorldDemoApp::SetupWindowAndRendering(bool firstTime, int argc, const
 
     pRender = pPlatform->SetupGraphics(Session, OVR_DEFAULT_RENDER_DEVICE_SET,
                                        graphics, RenderParams, luid); // To do: Remove the graphics argument to SetupGraphics, as RenderParams already has this info.
+
+    if (pRender && GpuTimingRequested && !pRender->SetGpuTimingEnabled(true))
+        WriteLog("[OculusWorldDemoApp] GPU timing isn't supported by this renderer.");
+
     return (pRender != nullptr);
 }
 
@@ -1060,6 +1275,22 @@ void OculusWorldDemoApp::PopulateOptionMenu()
     Menu.AddFloat("Scene Content.Tint.B (Full=255)", &SceneBrightness.z, 0.0f, 1000.0f, 0.5f, "%.1f");
     Menu.AddBool ("Scene Content.Black screen 'Shift+B'", &SceneBlack).AddShortcutKey(Key_B, ShortcutKey::Shift_RequireOn);
     Menu.AddBool ("Scene Content.Animation Enabled", &SceneAnimationEnabled);
+    Menu.AddBool ("Scene Content.Frustum Culling", &FrustumCullingEnabled);
+    Menu.AddBool ("Scene Content.Occlusion Culling", &OcclusionCullingEnabled);
+    Menu.AddBool ("Scene Content.Level Of Detail", &LodSelectionEnabled);
+    Menu.AddFloat("Scene Content.Level Of Detail Pixel Error", &LodMaxPixelError, 0.25f, 16.0f, 0.25f, "%.2f");
+    Menu.AddBool ("Scene Content.Draw Sorting", &DrawSortingEnabled);
+    Menu.AddBool ("Scene Content.Depth Pre-pass", &DepthPrepassEnabled);
+    Menu.AddBool ("Scene Content.Parallel Recording", &ParallelRecordingEnabled);
+    Menu.AddBool ("Scene Content.Pipelined Simulation", &PipelinedSimulation);
+    Menu.AddBool ("Scene Content.Split Vertex Streams", &SplitVertexStreams).SetNotify(this, &OWD::VertexLayoutChange);
+    Menu.AddBool ("Scene Content.Quantized Vertices", &QuantizedVertices).SetNotify(this, &OWD::VertexLayoutChange);
+    Menu.AddBool ("Scene Content.Merge Static Models", &MergeStaticModels).SetNotify(this, &OWD::ForceAssetReloading);
+    Menu.AddBool ("Scene Content.Pack Small Textures", &PackSmallTextures).SetNotify(this, &OWD::ForceAssetReloading);
+    Menu.AddBool ("Scene Content.Texture Streaming.Enabled", &TextureStreamingEnabled).SetNotify(this, &OWD::ForceAssetReloading);
+    Menu.AddInt  ("Scene Content.Texture Streaming.Budget (MB)", &TextureBudgetMB, 16, 4096, 16);
+    Menu.AddBool ("Scene Content.Asset Cache.Enabled", &AssetCacheEnabled);
+    Menu.AddInt  ("Scene Content.Asset Cache.Limit (MB)", &AssetCacheLimitMB, 0, 4096, 64);
 
     // Animating blocks
     Menu.AddEnum("Scene Content.Animated Blocks.Movement Type 'B'", &BlocksShowType).
@@ -1108,6 +1339,7 @@ void OculusWorldDemoApp::PopulateOptionMenu()
     // Render target menu
     Menu.AddBool( "Render Target.Share RenderTarget",  &RendertargetIsSharedByBothEyes).
                                                         AddShortcutKey(Key_F8).SetNotify(this, &OWD::HmdSettingChangeFreeRTs);
+    Menu.AddBool( "Render Target.Single Pass Stereo",  &SinglePassStereoEnabled);
     Menu.AddEnum( "Render Target.Resolution Scaling", &ResolutionScalingMode).
                 AddEnumValue("Off",                             ResolutionScalingMode_Off).
                 AddEnumValue("Dynamic",                         ResolutionScalingMode_Dynamic).
@@ -1217,6 +1449,7 @@ void OculusWorldDemoApp::PopulateOptionMenu()
                                                              0.0001f, 1.00f, 0.0001f, "%.1f", 1.0f, &FormatTimewarp).
                                                              AddShortcutUpKey(Key_J).AddShortcutDownKey(Key_U);
     Menu.AddBool("Timewarp.Enable Prediction",              &PredictionEnabled);
+    Menu.AddBool("Timewarp.Late Latching",                  &LateLatchEnabled);
 
 
     // Layers menu
@@ -1299,6 +1532,10 @@ void OculusWorldDemoApp::PopulateOptionMenu()
 
     // Display menu
     Menu.AddBool("Display.Mirror Window.Enabled",    &MirrorToWindow).AddShortcutKey(Key_M).SetNotify(this, &OWD::MirrorSettingChange);
+#if defined(OVR_OS_MS)
+    if (RenderParams.RenderAPI == RenderAPI_D3D11)
+        Menu.AddBool("Display.Mirror Window.Record Video", &RecordMirror).SetNotify(this, &OWD::RecordMirrorChange);
+#endif
     Menu.AddInt("Display.Mirror Window.Width",       &WindowSize.w, 100, 4000).SetNotify(this, &OWD::WindowSizeChange);
     Menu.AddInt("Display.Mirror Window.Height",      &WindowSize.h, 100, 4000).SetNotify(this, &OWD::WindowSizeChange);
     Menu.AddTrigger("Display.Mirror Window.Set To Native HMD Res").SetNotify(this, &OWD::WindowSizeToNativeResChange);
@@ -1674,6 +1911,13 @@ ovrResult OculusWorldDemoApp::CalculateHmdValues()
     }
 
 
+    // The benchmark renders the same views whichever HMD there is.
+    if (BenchmarkMode)
+    {
+        g_EyeFov[0] = FovPort(BenchmarkFovTan);
+        g_EyeFov[1] = FovPort(BenchmarkFovTan);
+    }
+
     // Shutter type. Useful for debugging.
     const char *pcShutterType = ovr_GetString(Session, "server:ShutterType", "Unknown");
     ShutterType = pcShutterType;
@@ -1708,7 +1952,8 @@ ovrResult OculusWorldDemoApp::CalculateHmdValues()
         CamFovPort[0] = g_EyeFov[0];
         CamFovPort[1] = g_EyeFov[1];
 
-        Sizei recommendedTexSize = ovr_GetFovTextureSize(Session, ovrEye_Left, g_EyeFov[0], DesiredPixelDensity);
+        Sizei recommendedTexSize = BenchmarkMode ? BenchmarkEyeSize :
+                                   ovr_GetFovTextureSize(Session, ovrEye_Left, g_EyeFov[0], DesiredPixelDensity);
 
         Sizei textureSize = EnsureRendertargetAtLeastThisBig(Rendertarget_Left, recommendedTexSize, (Layer0GenMipCount != 1), Layer0GenMipCount, error);
         if (error != ovrSuccess)
@@ -1736,6 +1981,11 @@ ovrResult OculusWorldDemoApp::CalculateHmdValues()
         // Configure Stereo settings. Default pixel density is 1.0f.
         Sizei recommendedTex0Size = ovr_GetFovTextureSize(Session, ovrEye_Left, g_EyeFov[0], DesiredPixelDensity);
         Sizei recommendedTex1Size = ovr_GetFovTextureSize(Session, ovrEye_Right, g_EyeFov[1], DesiredPixelDensity);
+        if (BenchmarkMode)
+        {
+            recommendedTex0Size = BenchmarkEyeSize;
+            recommendedTex1Size = BenchmarkEyeSize;
+        }
         CamRenderPoseCount = 2;
 
         // Here, the cameras still live at the eye pos+orn.
@@ -2171,7 +2421,7 @@ void OculusWorldDemoApp::OnKey(OVR::KeyCode key, int chr, bool down, int modifie
     case Key_Num1:
         ThePlayer.SetBodyPos(Vector3f(-1.85f, 6.0f, -0.52f), true);
         ThePlayer.BodyYaw = 3.1415f / 2;
-        ThePlayer.HandleMovement(0, &CollisionModels, &GroundCollisionModels, ShiftDown);
+        ThePlayer.HandleMovement(0, &CollisionTree, &GroundCollisionTree, ShiftDown);
         break;
 
     case Key_F:
@@ -2332,7 +2582,7 @@ void OculusWorldDemoApp::HandleHaptics()
         const char* kTouchStr[] = { "LeftTouch", "RightTouch" };
         ovrControllerType touchController[] = { ovrControllerType_LTouch, ovrControllerType_RTouch };
 
-        std::vector<uint8_t> samples;
+        FrameArrayPOD<uint8_t> samples;
         ovrHapticsPlaybackState state;
         memset(&state, 0, sizeof(state));
 
@@ -2364,7 +2614,7 @@ void OculusWorldDemoApp::HandleHaptics()
             }
 
             for (int32_t i = 0; i < kLowLatencyBufferSizeInSamples; ++i)
-                samples.push_back(amplitude);
+                samples.PushBack(amplitude);
         break;
 
         // High-latency, Long-queue, per-touch amplitude sent by the Hand Trigger
@@ -2380,7 +2630,7 @@ void OculusWorldDemoApp::HandleHaptics()
             }
 
             for (int32_t i = 0; i < kLowLatencyBufferSizeInSamples; ++i)
-                samples.push_back(amplitude);
+                samples.PushBack(amplitude);
             break;
 
         // Low-latency, short-queue, both-touches increase mod amplitude
@@ -2400,38 +2650,38 @@ void OculusWorldDemoApp::HandleHaptics()
             }
 
             for (int32_t i = 0; i < kLowLatencyBufferSizeInSamples; ++i)
-                samples.push_back(amplitude);
+                samples.PushBack(amplitude);
             break;
 
         // Low latency 1 click SHORT
         case 5:
             if (!wasButtonPressed_A && buttonPressed_A)
                 for (int32_t i = 0; i < 1; ++i)
-                    samples.push_back(255);
+                    samples.PushBack(255);
             break;
 
         // Low latency 1 click LONG
         case 6:
             if (!wasButtonPressed_A && buttonPressed_A)
                 for (int32_t i = 0; i < 4; ++i)
-                    samples.push_back(255);
+                    samples.PushBack(255);
             break;
 
         // Full Package
         case 7:
             if (!wasButtonPressed_A && buttonPressed_A)
                 for (int32_t i = 0; i < 20; ++i)
-                    samples.push_back(255);
+                    samples.PushBack(255);
             break;
 
         // First and Last buffer samples
         case 8:
             if (!wasButtonPressed_A && buttonPressed_A)
             {
-                samples.push_back(255);
+                samples.PushBack(255);
                 for (int32_t i = 0; i < 254; ++i)
-                    samples.push_back(0);
-                samples.push_back(255);
+                    samples.PushBack(0);
+                samples.PushBack(255);
             }
             break;
 
@@ -2439,7 +2689,7 @@ void OculusWorldDemoApp::HandleHaptics()
         case 9:
             if (!wasButtonPressed_A && buttonPressed_A)
                 for (int32_t i = 0; i < 20; ++i)
-                    samples.push_back( (i/4 % 2) * 255 );
+                    samples.PushBack( (i/4 % 2) * 255 );
             break;
 
         // XBox gamepad rumble
@@ -2463,18 +2713,18 @@ void OculusWorldDemoApp::HandleHaptics()
             for (int32_t i = 0; i < kLowLatencyBufferSizeInSamples; ++i)
             {
                 int32_t hapticsPlayIndex = (TouchHapticsPlayIndex + i) % TouchHapticsClip.SamplesCount;
-                samples.push_back(*(hapticsSamples + hapticsPlayIndex));
+                samples.PushBack(*(hapticsSamples + hapticsPlayIndex));
             }
-            TouchHapticsPlayIndex = (TouchHapticsPlayIndex + (int32_t)samples.size()) % TouchHapticsClip.SamplesCount;
+            TouchHapticsPlayIndex = (TouchHapticsPlayIndex + (int32_t)samples.GetSize()) % TouchHapticsClip.SamplesCount;
             break;
         }
 
-        if (samples.size() > 0)
+        if (samples.GetSize() > 0)
         {
             ovrHapticsBuffer buffer;
             buffer.SubmitMode = ovrHapticsBufferSubmit_Enqueue;
-            buffer.SamplesCount = (uint32_t)samples.size();
-            buffer.Samples = samples.data();
+            buffer.SamplesCount = (uint32_t)samples.GetSize();
+            buffer.Samples = samples.GetDataPtr();
             result = ovr_SubmitControllerVibration(Session, touchController[t], &buffer);
             if (result != ovrSuccess)
             {
@@ -2493,6 +2743,11 @@ void OculusWorldDemoApp::Exit(int exitCode)
 
 void OculusWorldDemoApp::OnIdle()
 {
+    OVR_PROFILE_SCOPE("OnIdle");
+
+    // Everything allocated from FrameMemory during this frame is released upon return.
+    FrameArena::Scope frameScope(&FrameMemory);
+
     // Check to see if we are being asked to quit.
     ovrSessionStatus sessionStatus = {};
     ovr_GetSessionStatus(Session, &sessionStatus);
@@ -2532,7 +2787,7 @@ void OculusWorldDemoApp::OnIdle()
     }
 
 
-    const double curtime = ovr_GetTimeInSeconds();
+    const double curtime = BenchmarkMode ? stepBenchmarkClock() : ovr_GetTimeInSeconds();
 
     // If running slower than 10fps, clamp. Helps when debugging, because then dt can be minutes!
     const float dt = Alg::Min<float>(float(curtime - LastUpdate), 0.1f);
@@ -2543,6 +2798,13 @@ void OculusWorldDemoApp::OnIdle()
 
     Profiler.RecordSample(RenderProfiler::Sample_FrameStart);
 
+    // TotalFrameCounter moves on part way through the frame.
+    const int64_t  traceFrameIndex = TotalFrameCounter;
+    const uint64_t traceFrameBegin = ScopeProfiler::IsRunning() ? Timer::GetTicksRaw() : 0;
+
+    if (pRender->BeginGpuTimerFrame())
+        recordGpuPasses();
+
     if (HmdSettingsChanged)
     {
         ovrResult error = CalculateHmdValues();
@@ -2556,9 +2818,14 @@ void OculusWorldDemoApp::OnIdle()
     if (LoadingState == LoadingState_DoLoad)
     {
         {
+            OVR_PROFILE_SCOPE("PopulateScene");
             PopulateScene(MainFilePath.c_str());
         }
 
+        // The benchmark reports on the loaded scene only.
+        if (BenchmarkMode)
+            Profiler.ResetHistograms();
+
         LoadingState = LoadingState_Finished;
         return;
     }
@@ -2576,10 +2843,23 @@ void OculusWorldDemoApp::OnIdle()
 
     ovrResult error = ovrSuccess;
 
+    // Set when this frame was waited for, and its movement simulated, along with the last one.
+    const bool waited    = takeSimulatedFrame(TotalFrameCounter);
+    const bool simulated = waited && PendingFrame.Moved;
+
 #if USE_WAITFRAME
     int frameIndex = TotalFrameCounter;
 
-    error = ovr_WaitToBeginFrame(Session, frameIndex);
+    if (waited)
+    {
+        error = PendingFrame.Result;
+    }
+    else
+    {
+        const double waitStart = ovr_GetTimeInSeconds();
+        error = ovr_WaitToBeginFrame(Session, frameIndex);
+        Profiler.RecordStage(RenderProfiler::Stage_WaitToBeginFrame, ovr_GetTimeInSeconds() - waitStart);
+    }
     if (HandleOvrError(error))
       return;
 
@@ -2599,6 +2879,11 @@ void OculusWorldDemoApp::OnIdle()
     InterAxialDistance = ovr_GetFloat(Session, "server:InterAxialDistance", -1.0f );
 
     ovrTrackingState trackState = ovr_GetTrackingState(Session, HmdFrameTiming, ovrFalse);
+    if (ScriptPoseEnabled)
+    {
+        trackState.HeadPose.ThePose = ScriptPose;
+    }
+    replayPoseTraceFrame(trackState);
     ovrTrackerPose trackerPose = ovr_GetTrackerPose(Session, 0);
     CalibratedTrackingOrigin = trackState.CalibratedOrigin;
 
@@ -2630,6 +2915,19 @@ void OculusWorldDemoApp::OnIdle()
       HasInputState = false;
     }
 
+    // Replayed input replaces what the devices gave.
+    if (PoseTraceReplaying)
+    {
+        ThePlayer.GamepadMove   = PoseTraceCurrent.GamepadMove;
+        ThePlayer.GamepadRotate = PoseTraceCurrent.GamepadRotate;
+        ThePlayer.MoveForward   = PoseTraceCurrent.MoveForward;
+        ThePlayer.MoveBack      = PoseTraceCurrent.MoveBack;
+        ThePlayer.MoveLeft      = PoseTraceCurrent.MoveLeft;
+        ThePlayer.MoveRight     = PoseTraceCurrent.MoveRight;
+        ThePlayer.BodyYaw       = PoseTraceCurrent.BodyYaw;
+        ShiftDown               = PoseTraceCurrent.ShiftDown;
+    }
+
     HandPoses[0] = trackState.HandPoses[0].ThePose;
     HandPoses[1] = trackState.HandPoses[1].ThePose;
     HandStatus[0] = trackState.HandStatusFlags[0];
@@ -2715,10 +3013,31 @@ void OculusWorldDemoApp::OnIdle()
     {
         // Update pose based on frame.
         ThePlayer.HeadPose = trackState.HeadPose.ThePose;
+        const float bodyYaw = ThePlayer.BodyYaw.Get();
 
-        // Movement/rotation with the gamepad.
-        ThePlayer.BodyYaw -= ThePlayer.GamepadRotate.x * dt;
-        ThePlayer.HandleMovement(dt, &CollisionModels, &GroundCollisionModels, ShiftDown);
+        if (simulated)
+        {
+            // Apply the movement rather than take the copy, keeping what input changed since.
+            ThePlayer.BodyYaw += PendingFrame.BodyYawChange;
+            ThePlayer.SetBodyPos(ThePlayer.GetBodyPos(ovrTrackingOrigin_EyeLevel) + PendingFrame.BodyMove, false);
+        }
+        else
+        {
+            const double simulationStart = ovr_GetTimeInSeconds();
+            const float  stepDt          = PoseTraceReplaying ? PoseTraceCurrent.Dt : dt;
+
+            // Movement/rotation with the gamepad.
+            ThePlayer.BodyYaw -= ThePlayer.GamepadRotate.x * stepDt;
+            ThePlayer.HandleMovement(stepDt, &CollisionTree, &GroundCollisionTree, ShiftDown);
+
+            Profiler.RecordStage(RenderProfiler::Stage_Simulation, ovr_GetTimeInSeconds() - simulationStart);
+        }
+
+        // Where the recording ended up, in case collision has changed since.
+        if (PoseTraceReplaying)
+            ThePlayer.SetBodyPos(PoseTraceCurrent.BodyPos, false);
+
+        recordPoseTraceFrame(trackState, simulated ? PendingFrame.Dt : dt, bodyYaw);
     }
 
     // Find the pose of the player's torso (rather than their head) in the world.
@@ -2729,6 +3048,14 @@ void OculusWorldDemoApp::OnIdle()
 
     // Record after processing time.
     Profiler.RecordSample(RenderProfiler::Sample_AfterGameProcessing);
+    const double renderStart = ovr_GetTimeInSeconds();
+
+#if USE_WAITFRAME
+    // TotalFrameCounter has already moved on to the next frame.
+    // A replay steps by the recorded intervals, which the next frame's simulation can't know.
+    if (PipelinedSimulation && !PoseTraceReplay.IsOpen())
+        startSimulatedFrame(TotalFrameCounter);
+#endif
 
     // This scene is so simple, it really doesn't stress the GPU or CPU out like a real game would.
     // So to simulate a more complex scene, each eye buffer can get rendered lots and lots of times.
@@ -2763,7 +3090,9 @@ void OculusWorldDemoApp::OnIdle()
 
     // Determine if we are rendering this frame. Frame rendering may be
     // skipped based on FreezeEyeUpdate and Time-warp timing state.
-    bool bupdateRenderedView = FrameNeedsRendering(curtime) && (sessionStatus.IsVisible || (LoadingState == LoadingState_Frame0));
+    bool bupdateRenderedView = FrameNeedsRendering(curtime) &&
+                               (sessionStatus.IsVisible || BenchmarkMode || (LoadingState == LoadingState_Frame0));
+    LateLatchActive = false;
 
     // Pick an appropriately "big enough" size for the HUD and menu and render them their textures texture.
     Sizei hudTargetSize = Sizei ( 2048, 2048 );
@@ -2971,6 +3300,11 @@ void OculusWorldDemoApp::OnIdle()
           ovr_GetEyePoses(Session, frameIndex, ovrTrue, eyeRenderHmdToEyePose, EyeRenderPose, &SensorSampleTimestamp);
         }
 
+        if (ScriptPoseEnabled || PoseTraceReplaying)
+        {
+          ovr_CalcEyePoses2(trackState.HeadPose.ThePose, eyeRenderHmdToEyePose, EyeRenderPose);
+        }
+
         if (VisualizeSeatLevel && Sitting)
         {
             EyeRenderPose[0].Position.y += ExtraSittingAltitude;
@@ -3024,6 +3358,71 @@ void OculusWorldDemoApp::OnIdle()
             CamFromWorld[camNum] = CalculateViewFromPose(CamRenderPose[camNum]);
         }
 
+        // The main eye views are corrected as the frame is submitted, where the eye poses are
+        // those the SDK predicts without any of the adjustments above but the seat height.
+        LateLatchActive = LateLatchEnabled && pRender->SupportsLateLatch() && PredictionEnabled &&
+                          !ScriptPoseEnabled && !PoseTraceReplaying && EnableTimewarpOnMainLayer && !DiscreteHmdRotationEnable &&
+                          (MonoscopicRenderMode == Mono_Off) && (LayerCubemap == Cubemap_Off);
+        if (LateLatchActive)
+        {
+            LateLatchHmdToEyePose[0] = eyeRenderHmdToEyePose[0];
+            LateLatchHmdToEyePose[1] = eyeRenderHmdToEyePose[1];
+            LateLatchPositionScale   = localPositionTrackingScale;
+            pRender->BeginLateLatchFrame();
+        }
+
+        // Cull the main scene once against the union of all the cameras' frustums.
+        SceneCuller.Clear();
+        if (FrustumCullingEnabled)
+        {
+            for ( int camNum = 0; camNum < CamRenderPoseCount; camNum++ )
+            {
+                SceneCuller.AddFrustum(CamProjection[camNum] * CamFromWorld[camNum]);
+            }
+        }
+        CulledModelCount = MainScene.UpdateCulling(SceneCuller);
+
+        // Then skip the models the occlusion tests of a recent frame found hidden in every view.
+        if (OcclusionCullingEnabled != pRender->IsOcclusionQueriesEnabled())
+        {
+            SceneOcclusion.Clear();
+            if (!pRender->SetOcclusionQueriesEnabled(OcclusionCullingEnabled))
+                OcclusionCullingEnabled = false;
+        }
+        OccludedModelCount = OcclusionCullingEnabled ? SceneOcclusion.Update(pRender, MainScene) : 0;
+
+        // Draw the surviving models as simplified as keeps their error within a pixel or so,
+        // judged from between the eyes.
+        if (LodSelectionEnabled)
+        {
+            const Vector3f viewPos = (CamRenderPose[0].Translation + CamRenderPose[1].Translation) * 0.5f;
+            SimplifiedModelCount = MainScene.SelectLods(viewPos, CamProjection[0].M[1][1] * CamRenderViewports[0].h * 0.5f,
+                                                        LodMaxPixelError);
+        }
+        else
+        {
+            MainScene.ClearLods();
+            SimplifiedModelCount = 0;
+        }
+
+        // Stream in the texture detail the surviving models need, judged from between the eyes.
+        if (TextureStreamingEnabled)
+        {
+            const Vector3f viewPos = (CamRenderPose[0].Translation + CamRenderPose[1].Translation) * 0.5f;
+            SceneTextureStreamer.SetBudget((size_t)TextureBudgetMB << 20);
+            SceneTextureStreamer.Update(pRender, MainScene, viewPos,
+                                        CamProjection[0].M[1][1] * CamRenderViewports[0].h * 0.5f);
+        }
+
+        // Sort the surviving models once, from between the eyes, for all the eye views.
+        SceneQueue.Clear();
+        if (DrawSortingEnabled)
+        {
+            const Vector3f sortPos = (CamRenderPose[0].Translation + CamRenderPose[1].Translation) * 0.5f;
+            MainScene.BuildRenderQueue(SceneQueue, sortPos);
+        }
+        pRender->SetParallelRecordingEnabled(ParallelRecordingEnabled);
+
         int currDrawFlushCount = 0;
         int numSwapChainsUsed = 1;
         CamLayerCount = 1;
@@ -3084,11 +3483,15 @@ void OculusWorldDemoApp::OnIdle()
                     pRender->Clear(0.0f, 0.0f, 0.0f, 1.0f, (DepthModifier == NearLessThanFar ? 1.0f : 0.0f));
                 }
 
+                // With single-pass stereo, MainScene is drawn once for both eyes before the eye views.
+                MainSceneRenderedStereo = SinglePassStereoEnabled && renderMainSceneStereo();
+
                 for (int eyeIndex = 0; eyeIndex < ovrEye_Count; eyeIndex++)
                 {
                     RenderEyeView((CamRenderPoseEnum)eyeIndex, (ovrEyeType)eyeIndex);
                     FlushIfApplicable(DrawFlush_AfterEachEyeRender, currDrawFlushCount);
                 }
+                MainSceneRenderedStereo = false;
             }
             else
             {
@@ -3145,6 +3548,15 @@ void OculusWorldDemoApp::OnIdle()
             FlushIfApplicable(DrawFlush_AfterEyePairRender, currDrawFlushCount);
         }
 
+        if (OcclusionCullingEnabled)
+        {
+            SceneOcclusion.EndFrame(pRender);
+        }
+
+        // Other views of MainScene, such as the external camera, aren't covered by the culling.
+        MainScene.ClearCulling();
+        SceneQueue.Clear();
+
         pRender->SetDefaultRenderTarget();
         pRender->FinishScene();
         pRender->SetGlobalTint ( Vector4f ( 1.0f, 1.0f, 1.0f, 1.0 ) );
@@ -3697,6 +4109,13 @@ void OculusWorldDemoApp::OnIdle()
             {
                 pRender->Blt(MirrorTexture);
             }
+
+#if defined(OVR_OS_MS)
+            if (MirrorRecorder.IsRecording())
+            {
+                MirrorRecorder.AddFrame(static_cast<Render::D3D11::Texture*>(MirrorTexture.GetPtr())->GetTex());
+            }
+#endif
         }
 
         if (IsMixedRealityCaptureMode)
@@ -3739,27 +4158,253 @@ void OculusWorldDemoApp::OnIdle()
         }
 
 
+        if (LateLatchActive)
+        {
+            latchEyePoses(frameIndex);
+        }
+
+        {
+            OVR_PROFILE_SCOPE("SubmitFrame");
 #if USE_WAITFRAME
-        error = ovr_EndFrame(Session, frameIndex, &viewScaleDesc, LayerList, numLayers);
+            error = ovr_EndFrame(Session, frameIndex, &viewScaleDesc, LayerList, numLayers);
 #else
-        error = ovr_SubmitFrame(Session, 0, &viewScaleDesc, LayerList, numLayers);
+            error = ovr_SubmitFrame(Session, 0, &viewScaleDesc, LayerList, numLayers);
 #endif
+        }
 
 
         if (HandleOvrError(error))
             return;
 
-        // Result could have been ovrSuccess_NotVisible.
-        if (error == ovrSuccess_NotVisible)
+        // Result could have been ovrSuccess_NotVisible, which the benchmark renders through.
+        if ((error == ovrSuccess_NotVisible) && !BenchmarkMode)
         {
             // Don't pound on the CPU if not visible.
             Sleep(100);
         }
 
-        pRender->Present(false);
+        {
+            OVR_PROFILE_SCOPE("Present");
+            pRender->Present(false);
+        }
     }
 
     Profiler.RecordSample(RenderProfiler::Sample_AfterPresent);
+    Profiler.RecordStage(RenderProfiler::Stage_Render, ovr_GetTimeInSeconds() - renderStart);
+
+    pRender->EndGpuTimerFrame();
+    pRender->RetireFrame();
+
+    if (traceFrameBegin != 0)
+        recordTraceFrame(traceFrameIndex, traceFrameBegin);
+}
+
+void OculusWorldDemoApp::replayPoseTraceFrame(ovrTrackingState& trackState)
+{
+    PoseTraceReplaying = PoseTraceReplay.IsOpen() && PoseTraceReplay.Read(PoseTraceCurrent);
+    if (!PoseTraceReplaying)
+    {
+        if (PoseTraceReplay.GetFrameCount() && !PoseTraceReplay.IsOpen())
+        {
+            WriteLog("[OculusWorldDemoApp] Pose trace replay finished after %u frames.", PoseTraceReplay.GetFrameCount());
+            PoseTraceReplay = PoseTraceReader();
+        }
+        return;
+    }
+
+    trackState.HeadPose.ThePose       = PoseTraceCurrent.HeadPose;
+    trackState.HandPoses[0].ThePose   = PoseTraceCurrent.HandPoses[0];
+    trackState.HandPoses[1].ThePose   = PoseTraceCurrent.HandPoses[1];
+    trackState.StatusFlags            = PoseTraceCurrent.HeadStatus;
+    trackState.HandStatusFlags[0]     = PoseTraceCurrent.HandStatus[0];
+    trackState.HandStatusFlags[1]     = PoseTraceCurrent.HandStatus[1];
+}
+
+void OculusWorldDemoApp::recordPoseTraceFrame(const ovrTrackingState& trackState, float dt, float bodyYaw)
+{
+    if (!PoseTraceRecorder.IsOpen())
+        return;
+
+    const double curtime = GetAppSeconds();
+    if (PoseTraceRecorder.GetFrameCount() == 0)
+        PoseTraceStartTime = curtime;
+
+    PoseTraceFrame& frame = PoseTraceCurrent;
+    frame.Time          = curtime - PoseTraceStartTime;
+    frame.Dt            = dt;
+    frame.HeadPose      = trackState.HeadPose.ThePose;
+    frame.HandPoses[0]  = trackState.HandPoses[0].ThePose;
+    frame.HandPoses[1]  = trackState.HandPoses[1].ThePose;
+    frame.HeadStatus    = trackState.StatusFlags;
+    frame.HandStatus[0] = trackState.HandStatusFlags[0];
+    frame.HandStatus[1] = trackState.HandStatusFlags[1];
+    frame.BodyPos       = ThePlayer.GetBodyPos(ovrTrackingOrigin_EyeLevel);
+    frame.BodyYaw       = bodyYaw;
+    frame.GamepadMove   = ThePlayer.GamepadMove;
+    frame.GamepadRotate = ThePlayer.GamepadRotate;
+    frame.MoveForward   = ThePlayer.MoveForward;
+    frame.MoveBack      = ThePlayer.MoveBack;
+    frame.MoveLeft      = ThePlayer.MoveLeft;
+    frame.MoveRight     = ThePlayer.MoveRight;
+    frame.ShiftDown     = ShiftDown;
+    PoseTraceRecorder.Write(frame);
+}
+
+void OculusWorldDemoApp::startSimulatedFrame(int frameIndex)
+{
+    OVR_ASSERT(!SimulationPending);
+    SimulationPending = true;
+
+    // The worker gets copies of what the frame may change while it runs.
+    const Player              player        = ThePlayer;
+    const bool                shiftDown     = ShiftDown;
+    const double              lastDisplay   = ovr_GetPredictedDisplayTime(Session, frameIndex - 1);
+    ovrSession                session       = Session;
+    const CollisionBVH*       collision     = &CollisionTree;
+    const CollisionBVH*       ground        = &GroundCollisionTree;
+    SimulatedFrame*           result        = &PendingFrame;
+
+    SimulationGroup.Run([=]()
+    {
+        OVR_PROFILE_SCOPE("SimulateNextFrame");
+
+        SimulatedFrame frame;
+        frame.FrameIndex = frameIndex;
+
+        const double waitStart = ovr_GetTimeInSeconds();
+        frame.Result = ovr_WaitToBeginFrame(session, frameIndex);
+        const double simulationStart = ovr_GetTimeInSeconds();
+        frame.WaitSeconds = simulationStart - waitStart;
+
+        if (OVR_SUCCESS(frame.Result))
+        {
+            // Step by the display interval, as the frame will be seen that much later.
+            const double display = ovr_GetPredictedDisplayTime(session, frameIndex);
+            const float  dt      = Alg::Clamp<float>(float(display - lastDisplay), 0.0f, 0.1f);
+
+            Player         next  = player;
+            const Vector3f start = next.GetBodyPos(ovrTrackingOrigin_EyeLevel);
+            next.HeadPose = ovr_GetTrackingState(session, display, ovrFalse).HeadPose.ThePose;
+
+            frame.Dt            = dt;
+            frame.BodyYawChange = -next.GamepadRotate.x * dt;
+            next.BodyYaw += frame.BodyYawChange;
+            next.HandleMovement(dt, collision, ground, shiftDown);
+            frame.BodyMove = next.GetBodyPos(ovrTrackingOrigin_EyeLevel) - start;
+            frame.Moved    = true;
+        }
+
+        frame.SimulationSeconds = ovr_GetTimeInSeconds() - simulationStart;
+        *result = frame;
+    });
+}
+
+bool OculusWorldDemoApp::takeSimulatedFrame(int frameIndex)
+{
+    if (!SimulationPending)
+        return false;
+
+    const double joinStart = ovr_GetTimeInSeconds();
+    SimulationGroup.Wait();
+    SimulationPending = false;
+    Profiler.RecordStage(RenderProfiler::Stage_SimulationJoin, ovr_GetTimeInSeconds() - joinStart);
+
+    // Frames which returned early, as while loading, don't move the counter on.
+    if (PendingFrame.FrameIndex != frameIndex)
+        return false;
+
+    Profiler.RecordStage(RenderProfiler::Stage_WaitToBeginFrame, PendingFrame.WaitSeconds);
+    if (PendingFrame.Moved)
+        Profiler.RecordStage(RenderProfiler::Stage_Simulation, PendingFrame.SimulationSeconds);
+    return true;
+}
+
+void OculusWorldDemoApp::discardSimulatedFrame(bool sessionEnding)
+{
+    SimulationGroup.Wait();
+    PendingFrame.Moved = false;
+
+    // The frame was still waited for, unless the session it was waited on goes.
+    if (sessionEnding)
+        SimulationPending = false;
+}
+
+void OculusWorldDemoApp::recordGpuPasses()
+{
+    const std::vector<GpuPassTime>& passes = pRender->GetGpuPassTimes();
+    Profiler.RecordGpuPasses(passes);
+
+    if (!ScopeProfiler::IsRunning())
+        return;
+
+    if (!GpuTraceTrack)
+        GpuTraceTrack = ScopeProfiler::CreateTrack("GPU");
+
+    for (const GpuPassTime& pass : passes)
+    {
+        const char* name = GpuTraceNames.insert(pass.Name).first->c_str();
+        ScopeProfiler::RecordTrack(GpuTraceTrack, name, pass.BeginTicks, pass.EndTicks);
+    }
+}
+
+void OculusWorldDemoApp::recordTraceFrame(int64_t frameIndex, uint64_t beginTicks)
+{
+    if (!ScopeProfiler::IsRunning())
+        return;
+
+    if (!FrameTraceTrack)
+        FrameTraceTrack = ScopeProfiler::CreateTrack("Frames");
+
+    const uint64_t now = Timer::GetTicksRaw();
+    ScopeProfiler::RecordFrame(FrameTraceTrack, frameIndex, beginTicks, now);
+
+    FrameTraceStart& start = FrameTraceStarts[frameIndex % FrameTraceHistory];
+    start.Index      = frameIndex;
+    start.BeginTicks = beginTicks;
+
+    // Other callers may take some of the stats first; those frames just have no counters.
+    ovrPerfStats perfStats = {};
+    if (OVR_FAILURE(ovr_GetPerfStats(Session, &perfStats)))
+        return;
+
+    // A new session starts counting vsyncs again.
+    if (perfStats.FrameStatsCount > 0 && perfStats.FrameStats[0].HmdVsyncIndex < FrameTraceLastVsync)
+        FrameTraceLastVsync = -1;
+
+    // Newest first, so walk back to record them in order.
+    for (int i = perfStats.FrameStatsCount - 1; i >= 0; i--)
+    {
+        const ovrPerfStatsPerCompositorFrame& stats = perfStats.FrameStats[i];
+        if (stats.HmdVsyncIndex <= FrameTraceLastVsync)
+            continue;
+        FrameTraceLastVsync = stats.HmdVsyncIndex;
+
+        const int64_t appFrame = stats.AppFrameIndex;
+        const FrameTraceStart& appStart = FrameTraceStarts[appFrame % FrameTraceHistory];
+        const uint64_t ticks = (appStart.Index == appFrame) ? appStart.BeginTicks : now;
+
+        ScopeProfiler::RecordCounter(FrameTraceTrack, "App CPU ms", ticks, stats.AppCpuElapsedTime * 1000.0);
+        ScopeProfiler::RecordCounter(FrameTraceTrack, "App GPU ms", ticks, stats.AppGpuElapsedTime * 1000.0);
+        ScopeProfiler::RecordCounter(FrameTraceTrack, "Compositor GPU ms", ticks, stats.CompositorGpuElapsedTime * 1000.0);
+        ScopeProfiler::RecordCounter(FrameTraceTrack, "Motion to photon ms", ticks, stats.AppMotionToPhotonLatency * 1000.0);
+        ScopeProfiler::RecordCounter(FrameTraceTrack, "Queue ahead ms", ticks, stats.AppQueueAheadTime * 1000.0);
+        ScopeProfiler::RecordCounter(FrameTraceTrack, "App dropped frames", ticks, stats.AppDroppedFrameCount);
+        ScopeProfiler::RecordCounter(FrameTraceTrack, "Compositor dropped frames", ticks, stats.CompositorDroppedFrameCount);
+        ScopeProfiler::RecordCounter(FrameTraceTrack, "ASW active", ticks, stats.AswIsActive ? 1.0 : 0.0);
+
+        // The counts only grow until ovr_ResetPerfStats, after which they start again from 0.
+        if (stats.AppDroppedFrameCount > FrameTraceAppDropped)
+            ScopeProfiler::RecordInstant(FrameTraceTrack, "App dropped frame", ticks, appFrame);
+        if (stats.CompositorDroppedFrameCount > FrameTraceCompositorDropped)
+            ScopeProfiler::RecordInstant(FrameTraceTrack, "Compositor dropped frame", ticks, appFrame);
+        FrameTraceAppDropped        = stats.AppDroppedFrameCount;
+        FrameTraceCompositorDropped = stats.CompositorDroppedFrameCount;
+
+        const int asw = stats.AswIsActive ? 1 : 0;
+        if (FrameTraceAsw >= 0 && asw != FrameTraceAsw)
+            ScopeProfiler::RecordInstant(FrameTraceTrack, asw ? "ASW on" : "ASW off", ticks, appFrame);
+        FrameTraceAsw = asw;
+    }
 }
 
 bool OculusWorldDemoApp::HandleOvrError(ovrResult error)
@@ -3995,8 +4640,120 @@ void OculusWorldDemoApp::UpdateFrameRateCounter(double curtime)
     }
 }
 
+// Draws MainScene to both eyes of the shared render target in one stereo pass, as RenderEyeView
+// would for each eye. Returns false, drawing nothing, if the scene isn't shown or the device or
+// eye viewports don't allow a stereo pass. The eye views' FOV stencils are then drawn over the
+// scene rather than under it, which leaves the same image.
+bool OculusWorldDemoApp::renderMainSceneStereo()
+{
+    if ((GridDisplayMode == GridDisplay_GridOnly) || (GridDisplayMode == GridDisplay_GridDirect) ||
+        (SceneMode == Scene_OculusCubes) || (SceneMode == Scene_DistortTune) || (LayerCubemap != Cubemap_Off))
+    {
+        return false;
+    }
+
+    AutoGpuProf gpuProf(pRender, "RenderMainSceneStereo");
+
+    const Recti eyeViewports[2] = { CamRenderViewports[CamRenderPose_Left], CamRenderViewports[CamRenderPose_Right] };
+    const Matrix4f eyeProjections[2] = { CamProjection[CamRenderPose_Left], CamProjection[CamRenderPose_Right] };
+    const Matrix4f rightFromLeft = CamFromWorld[CamRenderPose_Right] * CamFromWorld[CamRenderPose_Left].Inverted();
+    if (!pRender->BeginStereoPass(eyeViewports, eyeProjections, rightFromLeft))
+    {
+        return false;
+    }
+
+    pRender->SetCullMode(RenderDevice::Cull_Back);
+    pRender->SetDepthMode(true, true, (DepthModifier == NearLessThanFar ?
+                                       RenderDevice::Compare_Less :
+                                       RenderDevice::Compare_Greater));
+
+    // Both eyes take the left eye's correction, as they do its view.
+    pRender->SetLateLatchEye(LateLatchActive ? ovrEye_Left : -1);
+    if (SceneQueue.IsBuilt())
+    {
+        renderMainSceneQueue(CamFromWorld[CamRenderPose_Left]);
+    }
+    else
+    {
+        MainScene.Render(pRender, CamFromWorld[CamRenderPose_Left]);
+    }
+    pRender->SetLateLatchEye(-1);
+
+    pRender->EndStereoPass();
+
+    // The occlusion tests are drawn for each eye, each with the view the stereo pass gave it.
+    if (OcclusionCullingEnabled)
+    {
+        const RenderDevice::CompareFunc depthFunc = (DepthModifier == NearLessThanFar ?
+                                                     RenderDevice::Compare_Less : RenderDevice::Compare_Greater);
+        pRender->SetLateLatchEye(LateLatchActive ? ovrEye_Left : -1);
+        for (int eyeNum = 0; eyeNum < 2; eyeNum++)
+        {
+            const Matrix4f eyeView = (eyeNum == 0) ? CamFromWorld[CamRenderPose_Left] :
+                                                     rightFromLeft * CamFromWorld[CamRenderPose_Left];
+            pRender->ApplyStereoParams(eyeViewports[eyeNum], eyeProjections[eyeNum]);
+            SceneOcclusion.TestView(pRender, MainScene, eyeView, depthFunc);
+        }
+        pRender->SetLateLatchEye(-1);
+    }
+    return true;
+}
+
+// The main pass passes equal depths, so once the depth pass has drawn the nearest surfaces only
+// they are shaded. The usual depth test is set again after.
+void OculusWorldDemoApp::renderMainSceneQueue(const Matrix4f& view)
+{
+    const bool nearLess = (DepthModifier == NearLessThanFar);
+    if (DepthPrepassEnabled)
+    {
+        MainScene.RenderDepth(pRender, view, SceneQueue);
+        pRender->SetDepthMode(true, true, nearLess ? RenderDevice::Compare_LessEqual : RenderDevice::Compare_GreaterEqual);
+    }
+
+    MainScene.Render(pRender, view, SceneQueue);
+
+    if (DepthPrepassEnabled)
+    {
+        pRender->SetDepthMode(true, true, nearLess ? RenderDevice::Compare_Less : RenderDevice::Compare_Greater);
+    }
+}
+
+void OculusWorldDemoApp::latchEyePoses(int frameIndex)
+{
+    OVR_PROFILE_SCOPE("LatchEyePoses");
+
+    ovrPosef latePose[2];
+    double   sampleTime = 0.0;
+    ovr_GetEyePoses(Session, frameIndex, ovrFalse, LateLatchHmdToEyePose, latePose, &sampleTime);
+
+    Matrix4f corrections[2];
+    for (int eye = 0; eye < 2; eye++)
+    {
+        if (VisualizeSeatLevel && Sitting)
+        {
+            latePose[eye].Position.y += ExtraSittingAltitude;
+        }
+        Posef localPose = latePose[eye];
+        localPose.Translation *= LateLatchPositionScale;
+
+        // From the view the eye was drawn with to the view it has now.
+        const Posef camPose = localPose * CamFromEye[eye];
+        corrections[eye] = CalculateViewFromPose(camPose) * CamFromWorld[eye].Inverted();
+
+        CamRenderPose[eye] = camPose;
+        EyeLayer[0].EyeFov.RenderPose[eye] = camPose;
+    }
+    EyeLayer[0].EyeFov.SensorSampleTime = sampleTime;
+    SensorSampleTimestamp = sampleTime;
+
+    pRender->UpdateLateLatch(corrections);
+}
+
 void OculusWorldDemoApp::RenderEyeView(CamRenderPoseEnum camNum, ovrEyeType eyeNum, const Matrix4f* optionalMatrix, bool onlyRenderWorld)
 {
+    OVR_PROFILE_SCOPE("RenderEyeView");
+    AutoGpuProf gpuProf(pRender, "RenderEyeView");
+
     Recti renderViewport = CamRenderViewports[camNum];
 
     // *** 3D - Configures Viewport/Projection and Render
@@ -4058,6 +4815,10 @@ void OculusWorldDemoApp::RenderEyeView(CamRenderPoseEnum camNum, ovrEyeType eyeN
     Matrix4f baseTranslate = Matrix4f::Translation(ThePlayer.GetBodyPos(TrackingOriginType));
     Matrix4f baseYaw       = Matrix4f::RotationY(ThePlayer.GetApparentBodyYaw().Get());
 
+    // Only the main cameras' world is late latched; the grid and the HUD below are not.
+    const bool lateLatched = LateLatchActive && !optionalMatrix && (camNum <= CamRenderPose_Right);
+    pRender->SetLateLatchEye(lateLatched ? eyeNum : -1);
+
     if ( (GridDisplayMode != GridDisplay_GridOnly) && (GridDisplayMode != GridDisplay_GridDirect) )
     {
         if (SceneMode != Scene_OculusCubes && SceneMode != Scene_DistortTune)
@@ -4066,9 +4827,23 @@ void OculusWorldDemoApp::RenderEyeView(CamRenderPoseEnum camNum, ovrEyeType eyeN
             {
                 MainScene.Render(pRender, *optionalMatrix);
             }
-            else if (LayerCubemap == Cubemap_Off)
+            else if ((LayerCubemap == Cubemap_Off) && !MainSceneRenderedStereo)
             {
-                MainScene.Render(pRender, CamFromWorld[camNum]);
+                if (SceneQueue.IsBuilt())
+                {
+                    renderMainSceneQueue(CamFromWorld[camNum]);
+                }
+                else
+                {
+                    MainScene.Render(pRender, CamFromWorld[camNum]);
+                }
+
+                if (OcclusionCullingEnabled)
+                {
+                    SceneOcclusion.TestView(pRender, MainScene, CamFromWorld[camNum],
+                                            (DepthModifier == NearLessThanFar ? RenderDevice::Compare_Less :
+                                                                                RenderDevice::Compare_Greater));
+                }
             }
 
             if (!onlyRenderWorld)
@@ -4162,6 +4937,8 @@ void OculusWorldDemoApp::RenderEyeView(CamRenderPoseEnum camNum, ovrEyeType eyeN
         }
     }
 
+    pRender->SetLateLatchEye(-1);
+
     if (GridDisplayMode != GridDisplay_None)
     {
         switch ( GridDisplayMode )
@@ -4419,11 +5196,11 @@ void OculusWorldDemoApp::RenderCamNearFarHandsView()
         }
     }
 
-    // hands view
-    ExternalCamProjection = ovrMatrix4f_Projection(ExternalCameras[CurrentCameraID].Intrinsics.FOVPort,
+    // hands view, whose projection only changes with the camera
+    ExternalCamProjection = updateCachedProjection(ExternalCamHandsProjection,
+        ExternalCameras[CurrentCameraID].Intrinsics.FOVPort,
         ExternalCameras[CurrentCameraID].Intrinsics.VirtualNearPlaneDistanceMeters,
-        ExternalCameras[CurrentCameraID].Intrinsics.VirtualFarPlaneDistanceMeters,
-        projectionModifier);
+        ExternalCameras[CurrentCameraID].Intrinsics.VirtualFarPlaneDistanceMeters);
     pRender->ApplyStereoParams(HandsRenderViewport, ExternalCamProjection);
     pRender->SetDepthMode(true, true, (DepthModifier == NearLessThanFar ?
         RenderDevice::Compare_Less :
@@ -4444,6 +5221,12 @@ void OculusWorldDemoApp::RenderCubemap()
     int cubeMapSize = 1024;
     Matrix4f currCubemapCameraView; // This will replace ViewFromWorld[eye] in RenderEyeView
 
+    // The cube faces look in all directions, so this frame's eye views are rendered unculled too.
+    MainScene.ClearCulling();
+    CulledModelCount = 0;
+    OccludedModelCount = 0;
+    SceneQueue.Clear();
+
     uint64_t format = GetRenderDeviceTextureFormatForEyeTextureFormat(EyeTextureFormat);
     Texture* color = pRender->CreateTexture(
         format | Texture_RenderTarget | Texture_Cubemap | Texture_SwapTextureSetStatic | Texture_GenMipmapsBySdk,
@@ -4566,19 +5349,29 @@ Recti OculusWorldDemoApp::RenderMenu(float textHeight)
 {
     OVR_UNUSED ( textHeight );
 
-    pRender->SetRenderTarget ( DrawEyeTargets[Rendertarget_Menu]->pColorTex, NULL);
-    pRender->Clear(0.0f, 0.0f, 0.0f, 0.0f);
-    pRender->SetDepthMode ( false, false );
+    Texture* menuTex = DrawEyeTargets[Rendertarget_Menu]->pColorTex;
     Recti vp;
     vp.x = 0;
     vp.y = 0;
-    vp.w = DrawEyeTargets[Rendertarget_Menu]->pColorTex->GetWidth();
-    vp.h = DrawEyeTargets[Rendertarget_Menu]->pColorTex->GetHeight();
-    pRender->SetViewport(vp);
+    vp.w = menuTex->GetWidth();
+    vp.h = menuTex->GetHeight();
 
     float centerX = 0.5f * (float)vp.w;
     float centerY = 0.5f * (float)vp.h;
 
+    // The layer keeps showing what was last committed, so the menu is only redrawn when it changes,
+    // or the texture does. The mirror window copy samples the texture drawn into next, so it's
+    // redrawn every frame for that.
+    bool menuChanged = Menu.UpdateLayout(pRender, "", textHeight, centerX, centerY);
+    if (!menuChanged && (menuTex == MenuLayerTexture) && !MenuHudAlwaysOnMirrorWindow)
+        return MenuRenderedSize;
+    MenuLayerTexture = menuTex;
+
+    pRender->SetRenderTarget ( menuTex, NULL);
+    pRender->Clear(0.0f, 0.0f, 0.0f, 0.0f);
+    pRender->SetDepthMode ( false, false );
+    pRender->SetViewport(vp);
+
     // This sets up a coordinate system with origin at top-left and units of a pixel.
     Matrix4f ortho;
     ortho.SetIdentity();
@@ -4657,6 +5450,7 @@ Recti OculusWorldDemoApp::RenderTextInfoHud(float textHeight)
     ortho.M[1][3] = 1.0f;                // Y offset (Y=down)
     ortho.M[2][2] = 0;
     pRender->SetProjection(ortho);
+    pRender->BeginTextBatch();
 
     switch(TextScreen)
     {
@@ -4735,7 +5529,7 @@ Recti OculusWorldDemoApp::RenderTextInfoHud(float textHeight)
                     " HMD Pos: %4.4f  %4.4f  %4.4f\n"
                     " HMD YPR: %4.2f  %4.2f  %4.2f\n"
                     " Player Pos: %3.2f  %3.2f  %3.2f  Player Yaw:%4.0f\n"
-                    " FPS: %.1f  ms/frame: %.1f  Frame: %03d %d\n\n"
+                    " FPS: %.1f  ms/frame: %.1f  Frame: %03d %d  Culled: %d  Occluded: %d  Simplified: %d  Streamed textures: %dMB  Cached: %dMB\n\n"
                     " HMD: %s\n"
                     " Shutter type: %s, IAD: %.1fmm\n"
                     " EyeHeight: %3.2f, Eyes.x: (%3.1fmm, %3.1fmm)\n"
@@ -4745,7 +5539,10 @@ Recti OculusWorldDemoApp::RenderTextInfoHud(float textHeight)
                     RadToDegree(hmdYaw), RadToDegree(hmdPitch), RadToDegree(hmdRoll),
                     bodyPosFromOrigin.x, bodyPosFromOrigin.y, bodyPosFromOrigin.z,
                     RadToDegree(ThePlayer.BodyYaw.Get()),       // deliberately not GetApparentBodyYaw()
-                    FPS, SecondsPerFrame * 1000.0f, FrameCounter, TotalFrameCounter % 2,
+                    FPS, SecondsPerFrame * 1000.0f, FrameCounter, TotalFrameCounter % 2, CulledModelCount, OccludedModelCount,
+                    SimplifiedModelCount,
+                    (int)(SceneTextureStreamer.GetResidentBytes() >> 20),
+                    (int)(SceneAssetCache.GetCachedBytes() >> 20),
                     HmdDesc.ProductName,
                     ShutterType.c_str(),
                     InterAxialDistance * 1000.0f,   // convert to millimeters
@@ -4925,6 +5722,8 @@ Recti OculusWorldDemoApp::RenderTextInfoHud(float textHeight)
         break;
     }
 
+    pRender->EndTextBatch();
+
     if (TextScreen != Text_None)
     {
         // Commit changes to the HUD swap chain
@@ -5237,6 +6036,33 @@ void OculusWorldDemoApp::MirrorSettingChange(OptionVar*)
 }
 
 
+void OculusWorldDemoApp::RecordMirrorChange(OptionVar*)
+{
+#if defined(OVR_OS_MS)
+    if (RecordMirror && !MirrorRecorder.IsRecording())
+    {
+        // NV12 needs even dimensions. We encode at the mirror window's size and the HMD's rate.
+        const uint32_t width = (uint32_t)WindowSize.w & ~1u;
+        const uint32_t height = (uint32_t)WindowSize.h & ~1u;
+        const uint32_t framesPerSecond = (uint32_t)(HmdDesc.DisplayRefreshRate + 0.5f);
+        const uint32_t bitRate = 20 * 1000 * 1000;
+
+        RecordMirror = MirrorRecorder.Start(static_cast<Render::D3D11::RenderDevice*>(pRender)->Device,
+                                            L"OculusWorldDemo_Mirror.mp4", width, height,
+                                            framesPerSecond ? framesPerSecond : 90, bitRate);
+        if (!RecordMirror)
+            WriteLog("[OculusWorldDemoApp] Failed to start recording the mirror window.");
+    }
+    else if (!RecordMirror && MirrorRecorder.IsRecording())
+    {
+        MirrorRecorder.Stop();
+        WriteLog("[OculusWorldDemoApp] Stopped recording the mirror window, %u frame(s) dropped.",
+                 MirrorRecorder.GetDroppedFrameCount());
+    }
+#endif
+}
+
+
 void OculusWorldDemoApp::DebugHudSettingQuadPropChange(OptionVar*)
 {
     switch ( DebugHudStereoPresetMode )
@@ -5400,6 +6226,20 @@ unsigned int OculusWorldDemoApp::createProjectionModifier()
     return projectionModifier;
 }
 
+// Same as ovrMatrix4f_Projection with createProjectionModifier(), but only rebuilt when the
+// inputs differ from those cache last saw.
+const Matrix4f& OculusWorldDemoApp::updateCachedProjection(CachedProjection& cache, FovPort fov,
+                                                           float zNear, float zFar)
+{
+    unsigned int projectionModifier = createProjectionModifier();
+
+    return cache.Update((projectionModifier & ovrProjection_LeftHanded) != 0,
+                        (projectionModifier & ovrProjection_ClipRangeOpenGL) != 0,
+                        fov, zNear, zFar,
+                        (projectionModifier & ovrProjection_FarLessThanNear) != 0,
+                        (projectionModifier & ovrProjection_FarClipAtInfinity) != 0);
+}
+
 //-----------------------------------------------------------------------------
 
 void OculusWorldDemoApp::ProcessDeviceNotificationQueue()
@@ -5422,6 +6262,56 @@ void OculusWorldDemoApp::DisplayLastErrorMessageBox(const char* pMessage)
 }
 
 
+double OculusWorldDemoApp::GetAppSeconds() const
+{
+    return BenchmarkMode ? Timer::GetVirtualSeconds() : ovr_GetTimeInSeconds();
+}
+
+double OculusWorldDemoApp::stepBenchmarkClock()
+{
+    const double refreshRate = (HmdDesc.DisplayRefreshRate > 0.0f) ? HmdDesc.DisplayRefreshRate : 90.0;
+    Timer::SetVirtualSeconds(BenchmarkFrames / refreshRate);
+    BenchmarkFrames++;
+    return Timer::GetVirtualSeconds();
+}
+
+bool OculusWorldDemoApp::writeBenchmarkReport(const char* path) const
+{
+    FILE* file = fopen(path, "w");
+    if (!file)
+        return false;
+
+    // Times are real ones, in milliseconds, whatever the benchmark clock says.
+    fprintf(file, "# eye %dx%d, fov tan %.3f, %lld frames\n",
+            BenchmarkEyeSize.w, BenchmarkEyeSize.h, BenchmarkFovTan, (long long)BenchmarkFrames);
+    fprintf(file, "sample,count,mean,p50,p95,p99,max\n");
+
+    auto writeStats = [file](const char* prefix, const char* name, const TimingStats& stats)
+    {
+        fprintf(file, "%s%s,%u,%.3f,%.3f,%.3f,%.3f,%.3f\n", prefix, name, stats.Count,
+                stats.Mean * 1000.0, stats.P50 * 1000.0, stats.P95 * 1000.0,
+                stats.P99 * 1000.0, stats.Max * 1000.0);
+    };
+
+    static const char* sampleNames[RenderProfiler::Sample_LAST] =
+        { "FrameInterval", "AfterGameProcessing", "AfterEyeRender", "AfterPresent" };
+    for (int sample = 0; sample < RenderProfiler::Sample_LAST; sample++)
+    {
+        writeStats("", sampleNames[sample], Profiler.GetTotalStats((RenderProfiler::SampleType)sample));
+    }
+    for (int stage = 0; stage < RenderProfiler::Stage_LAST; stage++)
+    {
+        const RenderProfiler::StageType stageType = (RenderProfiler::StageType)stage;
+        writeStats("Stage", RenderProfiler::GetStageName(stageType), Profiler.GetTotalStageStats(stageType));
+    }
+    for (const RenderProfiler::GpuPassStats& pass : Profiler.GetGpuPassStats())
+    {
+        writeStats("Gpu:", pass.Name.c_str(), TimingStats(pass.Histogram));
+    }
+
+    return fclose(file) == 0;
+}
+
 void OculusWorldDemoApp::UpdateActiveControllerState()
 {
     if (LastControllerType != ActiveControllerState.ControllerType)
@@ -27,28 +27,37 @@ limitations under the License.
 
 #include "Kernel/OVR_Types.h"
 #include "Kernel/OVR_Allocator.h"
+#include "Kernel/OVR_Array.h"
 #include "Kernel/OVR_RefCount.h"
 #include "Kernel/OVR_System.h"
 #include "Kernel/OVR_Nullptr.h"
 #include "Kernel/OVR_Timer.h"
 #include "Kernel/OVR_DebugHelp.h"
+#include "Kernel/OVR_Profiler.h"
+#include "Kernel/OVR_TaskScheduler.h"
 #include "Extras/OVR_Math.h"
+#include "Extras/OVR_StereoProjection.h"
 #include "../CommonSrc/Platform/Platform_Default.h"
 #include "../CommonSrc/Render/Render_Device.h"
 #include "../CommonSrc/Render/Render_XmlSceneLoader.h"
+#include "../CommonSrc/Render/Render_TextureStreamer.h"
+#include "../CommonSrc/Render/Render_AssetCache.h"
 #include "../CommonSrc/Platform/Gamepad.h"
 #include "../CommonSrc/Util/OptionMenu.h"
 #include "../CommonSrc/Util/RenderProfiler.h"
 #include "../CommonSrc/Util/StringHelper.h"
 #include "../CommonSrc/Util/Logger.h"
+#include "Util/Util_D3D11_VideoRecorder.h" // From OVRKernel
 
 #include "Player.h"
 #include "Tracker.h"
 #include "Script.h"
+#include "PoseTrace.h"
 
 #include <vector>
 #include <string>
 #include <array>
+#include <set>
 // Filename to be loaded by default, searching specified paths.
 #define WORLDDEMO_ASSET_FILE  "Tuscany.xml"
 
@@ -152,8 +161,19 @@ public:
     Recti        RenderControllerStateHud(float cx, float xy, float textHeight,
                                           const ovrInputState& is, unsigned controllerType);
 
+    // Passes the GPU pass times just read back to Profiler and the trace.
+    void         recordGpuPasses();
+    // Records a presented frame, and any new ovrPerfStats, in the trace.
+    void         recordTraceFrame(int64_t frameIndex, uint64_t beginTicks);
+
     // Renders full stereo scene for one eye.
     void         RenderEyeView(CamRenderPoseEnum camNum, ovrEyeType eyeType, const Matrix4f* optionalMatrix = nullptr, bool onlyRenderWorld = false);
+    bool         renderMainSceneStereo();
+    // Draws MainScene from SceneQueue with view, after its depth pass when DepthPrepassEnabled.
+    void         renderMainSceneQueue(const Matrix4f& view);
+    // Rewrites the main eye views, and the poses the eye layer is submitted with, from the
+    // poses predicted for frameIndex now.
+    void         latchEyePoses(int frameIndex);
     void         RenderAnimatedBlocks(CamRenderPoseEnum camNum, double appTime);
     void         RenderGrid(CamRenderPoseEnum camNum, Recti viewport);
     void         RenderControllers(CamRenderPoseEnum camNum, ovrEyeType eyeNum);
@@ -189,6 +209,7 @@ public:
     // These contain extra actions to be taken in addition to switching the state.
     void HmdSettingChange(OptionVar* = 0)   { HmdSettingsChanged = true; }
     void MirrorSettingChange(OptionVar* = 0);
+    void RecordMirrorChange(OptionVar* = 0);
 
     void PerfHudSettingChange(OptionVar* = 0) { ovr_SetInt(Session, OVR_PERF_HUD_MODE, (int)PerfHudMode); }
 
@@ -206,6 +227,12 @@ public:
     void RendertargetFormatChange(OptionVar* = 0);
     void RendertargetResolutionModeChange(OptionVar* = 0);
     void ForceAssetReloading(OptionVar* = 0);
+    void VertexLayoutChange(OptionVar* = 0)
+    {
+        const bool quantized = QuantizedVertices && pRender->SupportsVertexLayout(VertexLayout_Quantized);
+        MainScene.SetVertexLayout(quantized          ? VertexLayout_Quantized :
+                                  SplitVertexStreams ? VertexLayout_Split : VertexLayout_Interleaved);
+    }
     void CenterPupilDepthChange(OptionVar* = 0);
     void DistortionClearColorChange(OptionVar* = 0);
     void WindowSizeChange(OptionVar* = 0);
@@ -227,6 +254,7 @@ public:
 
 
     unsigned int createProjectionModifier();
+    const Matrix4f& updateCachedProjection(CachedProjection& cache, FovPort fov, float zNear, float zFar);
 
 protected:
     friend class OWDScript;
@@ -336,6 +364,68 @@ protected:
     // Times a single frame.
     double              LastUpdate;
 
+    // Transient memory for data which lives no longer than a frame. Reset at the end of OnIdle.
+    FrameArena          FrameMemory;
+
+    // Where the ScopeProfiler trace is written on exit, if -profiletrace was given.
+    std::string         ProfileTracePath;
+
+    // CSV of the RenderProfiler window stats, if -timinglog was given.
+    FILE*               TimingLogFile;
+
+    // With -benchmark, the demo runs unattended for a script: frames render whether or not the
+    // HMD shows them, to a fixed FOV and eye size, and the clock steps by the display interval
+    // each frame, so the script's waits and the scene's animation repeat exactly. The frame
+    // times since the scene loaded are written to BenchmarkReportPath on exit.
+    bool                BenchmarkMode;
+    std::string         BenchmarkReportPath;
+    int64_t             BenchmarkFrames;        // Clock steps so far.
+    float               BenchmarkFovTan;
+    Sizei               BenchmarkEyeSize;
+
+    // Script time: the benchmark clock, or the SDK's.
+    double              GetAppSeconds() const;
+    double              stepBenchmarkClock();
+    bool                writeBenchmarkReport(const char* path) const;
+
+    // Set by the script's SetPose: the head pose in the tracking space, used in place of the HMD's.
+    bool                ScriptPoseEnabled;
+    Posef               ScriptPose;
+
+    // With -posetracerecord, each frame's tracking and player input is written to a pose trace.
+    // With -posetracereplay, they're read back from one in place of the live ones, and the player
+    // steps by the recorded intervals, so a session replays the same at whatever frame rate.
+    PoseTraceWriter     PoseTraceRecorder;
+    PoseTraceReader     PoseTraceReplay;
+    PoseTraceFrame      PoseTraceCurrent;       // This frame's, recorded or replayed.
+    bool                PoseTraceReplaying;     // This frame is from PoseTraceReplay.
+    double              PoseTraceStartTime;
+
+    void                replayPoseTraceFrame(ovrTrackingState& trackState);
+    void                recordPoseTraceFrame(const ovrTrackingState& trackState, float dt, float bodyYaw);
+
+    // GPU pass timing, if -gputiming was given. Passes go to Profiler, and to the GPU track of
+    // the trace while -profiletrace is recording; the trace keeps names by pointer, so they're
+    // copied into GpuTraceNames, as model names don't outlive the scene.
+    bool                GpuTimingRequested;
+    ProfileTrack*       GpuTraceTrack;
+    std::set<std::string> GpuTraceNames;
+
+    // Frames and ovrPerfStats on the Frames track of the trace. Perf stats come in a few frames
+    // late, so the start of recent frames is kept to put each one's counters at its own frame.
+    enum { FrameTraceHistory = 64 };
+    struct FrameTraceStart
+    {
+        int64_t         Index;
+        uint64_t        BeginTicks;
+    };
+    ProfileTrack*       FrameTraceTrack;
+    FrameTraceStart     FrameTraceStarts[FrameTraceHistory];
+    int                 FrameTraceLastVsync;        // Newest HmdVsyncIndex recorded
+    int                 FrameTraceAppDropped;       // Dropped frame counts last recorded
+    int                 FrameTraceCompositorDropped;
+    int                 FrameTraceAsw;              // -1 until the first stats
+
     // Touch Haptics
     ovrHapticsClip      TouchHapticsClip;
     int                 TouchHapticsPlayIndex;
@@ -344,6 +434,8 @@ protected:
     std::string	                          MainFilePath;
     std::vector<Ptr<CollisionModel> >     CollisionModels;
     std::vector<Ptr<CollisionModel> >     GroundCollisionModels;
+    CollisionBVH                          CollisionTree;          // Over CollisionModels.
+    CollisionBVH                          GroundCollisionTree;    // Over GroundCollisionModels.
 
     // Loading process displays screenshot in first frame
     // and then proceeds to load until finished.
@@ -389,6 +481,7 @@ protected:
     float               NearFarOverlapInMeters = 0.1f;     // to avoid the seam between the foreground and background images
     RenderControllerType RenderControllerFlag = RenderController_Both;
     Matrix4f            ExternalCamProjection;			// External camera projection matrix
+    CachedProjection    ExternalCamHandsProjection;
     Recti               NearRenderViewport;
     Recti               FarRenderViewport;
     Recti               HandsRenderViewport;
@@ -448,6 +541,8 @@ protected:
 
     // Render Target - affecting state.
     bool                RendertargetIsSharedByBothEyes;
+    bool                SinglePassStereoEnabled;    // With a shared render target, draw MainScene to both eyes at once.
+    bool                MainSceneRenderedStereo;    // Set while the eye views are to skip MainScene.
 
     int                 FovStencilType;  // -1 is off, rest are tied to ovrFovStencilType
     enum FovStencilMeshModes
@@ -502,6 +597,7 @@ protected:
     // The size of the rendered HUD in pixels. If size==0, there's no HUD at the moment.
     Recti               HudRenderedSize;
     Recti               MenuRenderedSize;
+    Texture*            MenuLayerTexture;   // What MenuRenderedSize was last drawn into
 
     // Read from the device, not sent to it.
     float               InterAxialDistance;
@@ -616,6 +712,10 @@ protected:
     bool                NeverRenderedIntoEyeTextures;
     bool                EnableTimewarpOnMainLayer;
     bool                PredictionEnabled;
+    bool                LateLatchEnabled;       // Correct the main eye views with poses read as the frame is submitted.
+    bool                LateLatchActive;        // This frame's views are corrected.
+    ovrPosef            LateLatchHmdToEyePose[2];
+    float               LateLatchPositionScale;
 
     bool                FreezeEyeUpdate;
     bool                LayersEnabled;              // Using layers, or just rendering quads into the eye buffers?
@@ -667,6 +767,10 @@ protected:
     bool                PositionTrackingEnabled;
     bool				PixelLuminanceOverdrive;
     bool                MirrorToWindow;
+    bool                RecordMirror;           // Encodes the mirror window to OculusWorldDemo_Mirror.mp4
+#if defined(OVR_OS_MS)
+    OVR::D3DUtil::D3DVideoRecorder MirrorRecorder;
+#endif
 
     // Support toggling background color for distortion so that we can see
     // the effect on the periphery.
@@ -785,6 +889,30 @@ protected:
     bool                SceneAnimationEnabled;  // If false then animations are frozen.
     double              SceneAnimationTime;     // Specifies the time we use for animation progression.
 
+    bool                FrustumCullingEnabled;  // Skip MainScene models outside all of the frame's camera frustums.
+    FrustumCuller       SceneCuller;
+    int                 CulledModelCount;       // MainScene models culled this frame.
+    bool                OcclusionCullingEnabled; // Also skip MainScene models recent frames found hidden.
+    OcclusionCuller     SceneOcclusion;
+    int                 OccludedModelCount;     // MainScene models hidden this frame.
+    bool                LodSelectionEnabled;    // Draw MainScene models with their simplified meshes by on-screen size.
+    float               LodMaxPixelError;       // How far, in eye pixels, a simplified mesh may move the surface.
+    int                 SimplifiedModelCount;   // MainScene models drawn simplified this frame.
+    bool                DrawSortingEnabled;     // Draw MainScene models grouped by fill, near to far.
+    bool                DepthPrepassEnabled;    // Draw the sorted models' depth first, nearest first, then shade them.
+    RenderQueue         SceneQueue;
+    bool                ParallelRecordingEnabled; // Record the sorted draws on worker threads, where the device can.
+    bool                SplitVertexStreams;     // Give MainScene models VertexLayout_Split buffers.
+    bool                QuantizedVertices;      // Give them VertexLayout_Quantized ones instead, where the device can.
+    bool                MergeStaticModels;      // Merge MainScene models sharing textures at load.
+    bool                PackSmallTextures;      // Pack MainScene's small textures into arrays at load.
+    bool                TextureStreamingEnabled; // Load MainScene textures coarse, and stream in mips by on-screen size.
+    int                 TextureBudgetMB;        // For the streamed mips.
+    TextureStreamer     SceneTextureStreamer;
+    bool                AssetCacheEnabled;      // Reuse the textures and buffers of earlier scene loads.
+    int                 AssetCacheLimitMB;      // For those no loaded scene uses.
+    AssetCache          SceneAssetCache;
+
     // Whether we are displaying animated blocks and what type.
     int                 BlocksShowType;
     int                 BlocksShowMeshType;
@@ -822,6 +950,38 @@ protected:
     // Profiler for rendering - displays timing stats.
     RenderProfiler      Profiler;
 
+    // With PipelinedSimulation, once a frame's game processing is done a worker waits for the
+    // next frame to begin and moves a copy of the player for it, while this thread renders and
+    // submits the frame. The next frame then applies the copy's movement instead of simulating.
+    // Rendering still uses poses late-latched on this thread.
+    struct SimulatedFrame
+    {
+        int         FrameIndex;
+        ovrResult   Result;             // Of ovr_WaitToBeginFrame
+        bool        Moved;              // BodyMove and BodyYawChange are set
+        Vector3f    BodyMove;
+        float       BodyYawChange;
+        float       Dt;                 // The movement step
+        double      WaitSeconds;
+        double      SimulationSeconds;
+
+        SimulatedFrame() : FrameIndex(-1), Result(ovrSuccess), Moved(false), BodyMove(), BodyYawChange(0.0f),
+                           Dt(0.0f), WaitSeconds(0.0), SimulationSeconds(0.0) { }
+    };
+
+    void                startSimulatedFrame(int frameIndex);
+    // Waits for the simulation started for frameIndex; false if there is none, and the frame
+    // must still be waited for.
+    bool                takeSimulatedFrame(int frameIndex);
+    // Call before anything the simulation reads, such as the collision trees, changes, and
+    // before the session goes.
+    void                discardSimulatedFrame(bool sessionEnding = false);
+
+    bool                PipelinedSimulation;
+    bool                SimulationPending;
+    SimulatedFrame      PendingFrame;       // Written by the worker until SimulationGroup is done.
+    TaskGroup           SimulationGroup;
+
     // true if logging tracking data to file
     bool                IsVisionLogging;
 
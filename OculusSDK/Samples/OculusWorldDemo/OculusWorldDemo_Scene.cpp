@@ -77,21 +77,21 @@ void PopulateCubeFieldScene(Scene* scene, Fill* fill,
 
     Vector3f pos = corner;
 
-    for (int i = 0; i < cubeCountX; i++)
-    {
-        // Create a new model for each 'plane' of cubes so we don't exceed
-        // the vert size limit.
-        Ptr<Model> model = *new Model();
-        scene->World.Add(model);
+    // One cube, drawn at each position of the grid.
+    Ptr<InstancedModel> model = *new InstancedModel(Prim_Triangles, "CubeField");
+    model->AddBox(0xFFFFFFFF, Vector3f(0.0f, 0.0f, 0.0f), Vector3f(cubeSize, cubeSize, cubeSize));
+    scene->World.Add(model);
 
-        if (fill)
-            model->Fill = fill;
+    if (fill)
+        model->Fill = fill;
 
+    for (int i = 0; i < cubeCountX; i++)
+    {
         for (int j = 0; j < cubeCountY; j++)
         {
             for (int k = 0; k < cubeCountZ; k++)
             {
-                model->AddBox(0xFFFFFFFF, pos, Vector3f(cubeSize, cubeSize, cubeSize));
+                model->AddInstance(Matrix4f::Translation(pos));
                 pos.z += cubeSpacing;
             }
 
@@ -200,14 +200,42 @@ void OculusWorldDemoApp::PopulateScene(const char *fileName)
     bool heavyAluEnableEarlyZ = false;
 
 
+    // The compositor keeps showing the loading layer while we're busy, so just log the progress.
+    int lastLoggedTextures = 0;
+    auto textureProgress = [&lastLoggedTextures](int loaded, int total)
+    {
+        if ((loaded != lastLoggedTextures) && ((loaded == total) || (loaded - lastLoggedTextures >= 10)))
+        {
+            WriteLog("[OculusWorldDemoScene] Loaded %i of %i textures", loaded, total);
+            lastLoggedTextures = loaded;
+        }
+    };
+
     XmlHandler xmlHandlerMain;
-    if(!xmlHandlerMain.ReadFile(fileName, pRender, &MainScene, &CollisionModels, &GroundCollisionModels, SrgbRequested, AnisotropicSample, geomShader, heavyAluEnableEarlyZ))
+    xmlHandlerMain.SetMergeStaticModels(MergeStaticModels);
+    xmlHandlerMain.SetPackTextures(PackSmallTextures);
+    if (TextureStreamingEnabled)
+    {
+        xmlHandlerMain.SetTextureStreamer(&SceneTextureStreamer);
+    }
+    if (AssetCacheEnabled)
+    {
+        SceneAssetCache.SetLimit((size_t)AssetCacheLimitMB << 20);
+        xmlHandlerMain.SetAssetCache(&SceneAssetCache);
+    }
+    else
+    {
+        SceneAssetCache.Clear();
+    }
+    if(!xmlHandlerMain.ReadFile(fileName, pRender, &MainScene, &CollisionModels, &GroundCollisionModels, SrgbRequested, AnisotropicSample, geomShader, heavyAluEnableEarlyZ,
+                                &CollisionTree, &GroundCollisionTree, textureProgress))
     {
         Menu.SetPopupMessage("FILE LOAD FAILED");
         Menu.SetPopupTimeout(10.0f, true);
     }
 
     MainScene.SetAmbient(Color4f(1.0f, 1.0f, 1.0f, 1.0f));
+    VertexLayoutChange();
 
     std::string mainFilePathNoExtension = MainFilePath;
     StripExtension(mainFilePathNoExtension);
@@ -270,6 +298,10 @@ void OculusWorldDemoApp::PopulateScene(const char *fileName)
 		  CubemapLoadTexture = *LoadTextureDDSTopDown(pRender, imageFile, textureLoadFlags | Texture_Cubemap);
 
     XmlHandler xmlHandler2;
+    if (AssetCacheEnabled)
+    {
+        xmlHandler2.SetAssetCache(&SceneAssetCache);
+    }
     std::string controllerFilename = GetPath(MainFilePath) + "LeftController.xml";
     if (!xmlHandler2.ReadFile(controllerFilename.c_str(), pRender, &ControllerScene, NULL, NULL, false, false, geomShader, heavyAluEnableEarlyZ))
     {
@@ -324,6 +356,20 @@ void OculusWorldDemoApp::PopulatePreloadScene()
 
 void OculusWorldDemoApp::ClearScene()
 {
+    discardSimulatedFrame();
+
+    // The GPU may still be drawing the last frames; their resources go once it has finished.
+    if (pRender)
+    {
+        Scene* scenes[] = { &MainScene, &SmallGreenCube, &SmallOculusCube, &SmallOculusGreenCube,
+                            &SmallOculusRedCube, &GreenCubesScene, &RedCubesScene, &YellowCubesScene,
+                            &OculusCubesScene, &ControllerScene, &BoundaryScene };
+        for (Scene* scene : scenes)
+            scene->ReleaseRenderer(pRender);
+    }
+
+    SceneTextureStreamer.Clear();
+    SceneOcclusion.Clear();
     MainScene.Clear();
     SmallGreenCube.Clear();
     SmallOculusCube.Clear();
@@ -335,6 +381,9 @@ void OculusWorldDemoApp::ClearScene()
     OculusCubesScene.Clear();
     ControllerScene.Clear();
     BoundaryScene.Clear();
+
+    // Drop what the cleared scenes used over the cache's limit.
+    SceneAssetCache.Trim();
 }
 
 
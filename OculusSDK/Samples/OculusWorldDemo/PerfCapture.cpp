@@ -18,23 +18,241 @@
 #include "PerfCapture.h"
 #include "Extras/OVR_Math.h"
 #include "Kernel/OVR_System.h"
+#include "Kernel/OVR_CRC32.h"
 #include <iosfwd>
 #include <sstream>
 #include <string>
 #include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <iterator>
+
+//////////////////////////////////////////////////////////////////////////
+/// Chunk encoding
+//////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+void AppendUInt32(std::vector<uint8_t>& out, uint32_t value) {
+  for (int i = 0; i < 4; ++i)
+    out.push_back((uint8_t)(value >> (i * 8)));
+}
+
+void AppendUInt64(std::vector<uint8_t>& out, uint64_t value) {
+  AppendUInt32(out, (uint32_t)value);
+  AppendUInt32(out, (uint32_t)(value >> 32));
+}
+
+uint32_t ReadUInt32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint64_t ReadUInt64(const uint8_t* p) {
+  return (uint64_t)ReadUInt32(p) | ((uint64_t)ReadUInt32(p + 4) << 32);
+}
+
+void AppendVarint(std::vector<uint8_t>& out, size_t value) {
+  while (value >= 0x80) {
+    out.push_back((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back((uint8_t)value);
+}
+
+bool ReadVarint(const uint8_t*& p, const uint8_t* end, size_t& value) {
+  value = 0;
+  for (int shift = 0; (p < end) && (shift < 35); shift += 7) {
+    const uint8_t byte = *p++;
+    value |= (size_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+// Appends the payload for records, as described in PerfCapture.h.
+void EncodeRecords(const ovrPerfStats* records, size_t count, std::vector<uint8_t>& out) {
+  const size_t recordSize = sizeof(ovrPerfStats);
+  const size_t total = count * recordSize;
+  std::vector<uint8_t> delta(total);
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(records);
+
+  for (size_t i = 0; i < total; ++i)
+    delta[i] = (i < recordSize) ? bytes[i] : (uint8_t)(bytes[i] ^ bytes[i - recordSize]);
+
+  // A literal run ends at a run of zeros long enough to be worth its two varints.
+  const size_t minZeroRun = 3;
+
+  for (size_t pos = 0; pos < total;) {
+    const size_t zeroStart = pos;
+    while ((pos < total) && (delta[pos] == 0))
+      ++pos;
+
+    const size_t literalStart = pos;
+    size_t zeros = 0;
+    while ((pos < total) && (zeros < minZeroRun)) {
+      zeros = (delta[pos] == 0) ? (zeros + 1) : 0;
+      ++pos;
+    }
+    if (zeros == minZeroRun)
+      pos -= zeros; // Leave them for the next pair.
+
+    AppendVarint(out, literalStart - zeroStart);
+    AppendVarint(out, pos - literalStart);
+    out.insert(out.end(), delta.begin() + literalStart, delta.begin() + pos);
+  }
+}
+
+bool DecodeRecords(
+    const uint8_t* p,
+    const uint8_t* end,
+    size_t count,
+    size_t recordSize,
+    std::vector<uint8_t>& out) {
+  const size_t total = count * recordSize;
+  out.assign(total, 0);
+
+  for (size_t pos = 0; pos < total;) {
+    size_t zeros, literals;
+    if (!ReadVarint(p, end, zeros) || !ReadVarint(p, end, literals))
+      return false;
+    if ((zeros > (total - pos)) || (literals > (total - pos - zeros)) ||
+        (literals > (size_t)(end - p)))
+      return false;
+
+    pos += zeros;
+    memcpy(&out[pos], p, literals);
+    pos += literals;
+    p += literals;
+  }
+
+  for (size_t i = recordSize; i < total; ++i)
+    out[i] ^= out[i - recordSize];
+
+  return (p == end);
+}
+
+// Starts a chunk at the end of out, which EndChunk completes once its payload is appended.
+size_t BeginChunk(std::vector<uint8_t>& out, uint32_t magic, uint32_t recordCount) {
+  const size_t start = out.size();
+  AppendUInt32(out, magic);
+  AppendUInt32(out, recordCount);
+  AppendUInt32(out, 0); // EncodedSize and CRC, filled in by EndChunk.
+  AppendUInt32(out, 0);
+  return start;
+}
+
+void EndChunk(std::vector<uint8_t>& out, size_t start) {
+  const uint32_t encodedSize = (uint32_t)(out.size() - start - 16);
+  const uint32_t crc = OVR::Standard_CRC32(out.data() + start + 16, (int)encodedSize);
+  for (int i = 0; i < 4; ++i) {
+    out[start + 8 + i] = (uint8_t)(encodedSize >> (i * 8));
+    out[start + 12 + i] = (uint8_t)(crc >> (i * 8));
+  }
+}
+
+// Returns the size of the chunk at pos if it has the given magic and is intact, else 0.
+size_t IntactChunkSize(const uint8_t* data, size_t size, uint64_t pos, uint32_t magic) {
+  if ((pos > size) || ((size - pos) < 16)) {
+    return 0;
+  }
+
+  const uint8_t* chunk = data + pos;
+  const uint32_t encodedSize = ReadUInt32(chunk + 8);
+  if ((ReadUInt32(chunk) != magic) || (encodedSize > (size - pos - 16)) ||
+      (OVR::Standard_CRC32(chunk + 16, (int)encodedSize) != ReadUInt32(chunk + 12))) {
+    return 0;
+  }
+  return 16 + (size_t)encodedSize;
+}
+
+// Finds the record chunks of a version 2 capture, up to the end marker or the first chunk which
+// isn't intact. Returns the offset just past the last of them, where a footer belongs.
+uint64_t ScanChunks(
+    const uint8_t* data,
+    size_t size,
+    std::vector<PerfCaptureSerializer::ChunkIndexEntry>& index,
+    uint32_t& droppedCount) {
+  index.clear();
+  droppedCount = 0;
+
+  uint32_t records = 0;
+  uint64_t pos = 16;
+  for (;;) {
+    const size_t chunkSize =
+        IntactChunkSize(data, size, pos, PerfCaptureSerializer::PerfCaptureChunkMagic);
+    if (chunkSize == 0) {
+      break;
+    }
+
+    const uint32_t recordCount = ReadUInt32(data + pos + 4);
+    if (recordCount == 0) {
+      if (chunkSize >= 20) {
+        droppedCount = ReadUInt32(data + pos + 16);
+      }
+      break;
+    }
+
+    index.push_back({pos, records, recordCount});
+    records += recordCount;
+    pos += chunkSize;
+  }
+
+  return pos;
+}
+
+// Appends the footer, as described in PerfCapture.h, for one written at footerOffset.
+void AppendFooter(
+    std::vector<uint8_t>& out,
+    const std::vector<PerfCaptureSerializer::ChunkIndexEntry>& index,
+    uint32_t droppedCount,
+    uint64_t footerOffset) {
+  const size_t start = out.size();
+  size_t chunk = BeginChunk(out, PerfCaptureSerializer::PerfCaptureChunkMagic, 0);
+  AppendUInt32(out, droppedCount);
+  EndChunk(out, chunk);
+
+  const uint64_t indexOffset = footerOffset + (out.size() - start);
+  chunk = BeginChunk(out, PerfCaptureSerializer::PerfCaptureIndexMagic, (uint32_t)index.size());
+  for (const auto& entry : index) {
+    AppendUInt64(out, entry.Offset);
+    AppendUInt32(out, entry.FirstRecord);
+    AppendUInt32(out, entry.RecordCount);
+  }
+  EndChunk(out, chunk);
+
+  AppendUInt64(out, indexOffset);
+  AppendUInt32(out, PerfCaptureSerializer::PerfCaptureTrailerMagic);
+  AppendUInt32(out, 0);
+}
+
+} // namespace
 
 //////////////////////////////////////////////////////////////////////////
 /// PerfCaptureSerializer
 //////////////////////////////////////////////////////////////////////////
 
-PerfCaptureSerializer::PerfCaptureSerializer(double totalDuration, Units units, const std::string& filePath)
+PerfCaptureSerializer::PerfCaptureSerializer(
+    double totalDuration,
+    Units units,
+    const std::string& filePath,
+    bool resume)
   : FilePath(filePath),
     DurationUnits(units),
     TotalDuration(totalDuration),
+    Resume(resume),
     CompletionValue(0.0),
     CurrentStatus(Status::None),
-    BufferedPerfStats(),
+    PendingStats(RingCapacity),
+    WriterThread(),
+    StopWriter(false),
+    WriteFailed(false),
+    DroppedCount(0),
     SerializedFile(),
+    ChunkIndex(),
+    FileOffset(0),
+    RecordsWritten(0),
+    ResumedDroppedCount(0),
     CurrentFrame(0) 
 {}
 
@@ -51,44 +269,143 @@ void PerfCaptureSerializer::Reset() {
   FilePath.clear();
   DurationUnits = Units::none;
   TotalDuration = 0;
+  Resume = false;
   CompletionValue = 0.0;
   CurrentStatus = Status::None;
-  BufferedPerfStats.clear();
+  WriteFailed = false;
+  DroppedCount = 0;
 
   if (SerializedFile.is_open()) {
     SerializedFile.close();
-    SerializedFile.clear();
   }
+  SerializedFile.clear();
+  ChunkIndex.clear();
+  FileOffset = 0;
+  RecordsWritten = 0;
+  ResumedDroppedCount = 0;
 
   CurrentFrame = 0;
 }
 
-void PerfCaptureSerializer::SerializeBuffer() {
-  if (CurrentStatus == Status::Started) {
-    char* byteData = reinterpret_cast<char*>(&BufferedPerfStats[0]);
-    size_t dataSize = BufferedPerfStats.size() * sizeof(ovrPerfStats);
-    SerializedFile.write(byteData, dataSize);
-  } else {
-    OVR_FAIL();
+bool PerfCaptureSerializer::WriteChunk(const std::vector<ovrPerfStats>& records) {
+  std::vector<uint8_t> chunk;
+  chunk.reserve(16 + records.size() * sizeof(ovrPerfStats) / 4);
+  const size_t start = BeginChunk(chunk, PerfCaptureChunkMagic, (uint32_t)records.size());
+  EncodeRecords(records.data(), records.size(), chunk);
+  EndChunk(chunk, start);
+
+  // Flushed as it's written, which is one write per chunk, so a crash loses nothing before it.
+  SerializedFile.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+  SerializedFile.flush();
+
+  ChunkIndex.push_back({FileOffset, RecordsWritten, (uint32_t)records.size()});
+  FileOffset += chunk.size();
+  RecordsWritten += (uint32_t)records.size();
+  return SerializedFile.good();
+}
+
+bool PerfCaptureSerializer::WriteFooter() {
+  std::vector<uint8_t> footer;
+  AppendFooter(
+      footer,
+      ChunkIndex,
+      ResumedDroppedCount + DroppedCount.load(std::memory_order_relaxed),
+      FileOffset);
+
+  SerializedFile.write(reinterpret_cast<const char*>(footer.data()), footer.size());
+  SerializedFile.flush();
+  return SerializedFile.good();
+}
+
+void PerfCaptureSerializer::WriterThreadMain() {
+  OVR::Thread::SetCurrentThreadName("OWDPerfCapture");
+
+  std::vector<ovrPerfStats> records;
+  records.reserve(RecordsPerChunk);
+  double chunkStartTime = 0;
+  bool ok = true;
+
+  for (;;) {
+    // The producer sets StopWriter after its last push, so once it's seen one more empty
+    // pop means everything has been written. The short wait bounds how long EndCapture takes.
+    const bool stopping = StopWriter.load(std::memory_order_acquire);
+
+    ovrPerfStats perfStats;
+    if (PendingStats.Pop(perfStats, stopping ? 0 : 10)) {
+      if (records.empty()) {
+        chunkStartTime = ovr_GetTimeInSeconds();
+      }
+      records.push_back(perfStats);
+    } else if (stopping) {
+      break;
+    }
+
+    // A slow frame rate still gets a chunk out every interval, so that is all a crash can lose.
+    if (!records.empty() &&
+        (((int)records.size() == RecordsPerChunk) ||
+         ((ovr_GetTimeInSeconds() - chunkStartTime) * 1000 >= FlushIntervalMs))) {
+      ok = ok && WriteChunk(records);
+      records.clear();
+    }
+  }
+
+  if (!records.empty()) {
+    ok = ok && WriteChunk(records);
+    records.clear();
   }
 
-  // clear it out regardless to avoid memory bloat
-  BufferedPerfStats.clear();
+  ok = ok && WriteFooter();
+
+  WriteFailed = !ok || !SerializedFile.good();
 }
 
 void PerfCaptureSerializer::StartCapture() {
   bool success = false;
-  try {
+
+  ChunkIndex.clear();
+  RecordsWritten = 0;
+  ResumedDroppedCount = 0;
+
+  // Resuming appends in place of the recovered footer. The footer written at the end is never
+  // shorter than it, since its index only grows, so nothing of the old one is left behind.
+  uint64_t footerOffset = 0;
+  if (Resume && Recover(FilePath, &ChunkIndex, &ResumedDroppedCount, &footerOffset)) {
+    SerializedFile.open(FilePath, std::ios::in | std::ios::out | std::ios::binary);
+    if (SerializedFile.is_open()) {
+      SerializedFile.seekp((std::streamoff)footerOffset);
+      success = SerializedFile.good();
+    }
+
+    FileOffset = footerOffset;
+    for (const auto& entry : ChunkIndex) {
+      RecordsWritten += entry.RecordCount;
+    }
+  } else {
     // create/open file
-    SerializedFile.open(FilePath, std::ios::out | std::ios::binary);
+    SerializedFile.open(FilePath, std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (SerializedFile.is_open()) {
+      std::vector<uint8_t> header;
+      AppendUInt32(header, PerfCaptureMagic);
+      AppendUInt32(header, PerfCaptureVersion);
+      AppendUInt32(header, (uint32_t)sizeof(ovrPerfStats));
+      AppendUInt32(header, 0);
+      SerializedFile.write(reinterpret_cast<const char*>(header.data()), header.size());
+      success = SerializedFile.good();
+    }
+    FileOffset = 16;
+  }
 
-    // ready buffer vector
-    BufferedPerfStats.clear();
-    BufferedPerfStats.reserve(NumBufferedStatsReserve);
-    success = true;
-  } catch (std::ios_base::failure&) {
+  if (success) {
+    StopWriter = false;
+    WriteFailed = false;
+    DroppedCount = 0;
+    WriterThread = std::thread(&PerfCaptureSerializer::WriterThreadMain, this);
+  } else {
     OVR_FAIL();
-    success = false;
+    if (SerializedFile.is_open()) {
+      SerializedFile.close();
+    }
   }
 
   CurrentStatus = (success ? Status::Started : Status::Error);
@@ -96,11 +413,11 @@ void PerfCaptureSerializer::StartCapture() {
 
 void PerfCaptureSerializer::EndCapture() {
   if (CurrentStatus == Status::Started) {
-    if (BufferedPerfStats.size() > 0) {
-      SerializeBuffer();
-    }
+    // Waits for the writer to drain the ring, which is at most RingCapacity records.
+    StopWriter.store(true, std::memory_order_release);
+    WriterThread.join();
 
-    CurrentStatus = Status::Complete;
+    CurrentStatus = WriteFailed ? Status::Error : Status::Complete;
   } else {
     CurrentStatus = Status::Error; // called end before start
   }
@@ -109,7 +426,6 @@ void PerfCaptureSerializer::EndCapture() {
     SerializedFile.close();
   }
 }
-
 PerfCaptureSerializer::Status PerfCaptureSerializer::Step(ovrSession session) {
   if (CurrentStatus == Status::None) {
     StartCapture();
@@ -127,7 +443,9 @@ PerfCaptureSerializer::Status PerfCaptureSerializer::Step(ovrSession session) {
 
     // make sure we got some stats before we start
     if (CurrentFrame > 0) {
-      BufferedPerfStats.push_back(perfStats);
+      if (!PendingStats.TryPush(perfStats)) {
+        DroppedCount.fetch_add(1, std::memory_order_relaxed);
+      }
 
       if (CompletionValue == 0) // If the capture hasn't started yet...
       {
@@ -159,14 +477,155 @@ PerfCaptureSerializer::Status PerfCaptureSerializer::Step(ovrSession session) {
 
     if (timeIsUp) {
       EndCapture();
-    } else {
-      bool shouldSerialize = (int)BufferedPerfStats.size() > NumBufferedStatsSerializeTrigger;
-      if (shouldSerialize) {
-        SerializeBuffer();
-      }
     }
   }
 
   return CurrentStatus;
 }
 
+bool PerfCaptureSerializer::Deserialize(const std::string& filePath, std::vector<ovrPerfStats>& stats) {
+  stats.clear();
+
+  std::ifstream file(filePath, std::ios::in | std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  return Deserialize(data.data(), data.size(), stats);
+}
+
+bool PerfCaptureSerializer::Deserialize(
+    const uint8_t* data, size_t size, std::vector<ovrPerfStats>& stats, uint32_t* droppedCount) {
+  stats.clear();
+  if (droppedCount) {
+    *droppedCount = 0;
+  }
+  const size_t recordSize = sizeof(ovrPerfStats);
+
+  if ((size < 16) || (ReadUInt32(data) != PerfCaptureMagic)) {
+    // Version 1: a raw dump.
+    if ((size % recordSize) != 0) {
+      return false;
+    }
+    stats.resize(size / recordSize);
+    if (size) {
+      memcpy(stats.data(), data, size);
+    }
+    return true;
+  }
+
+  if ((ReadUInt32(data + 4) != PerfCaptureVersion) || (ReadUInt32(data + 8) != recordSize)) {
+    return false; // Written by an SDK with a different ovrPerfStats.
+  }
+
+  std::vector<uint8_t> decoded;
+  for (size_t pos = 16; (size - pos) >= 16;) {
+    const uint8_t* chunk = data + pos;
+    const uint32_t recordCount = ReadUInt32(chunk + 4);
+    const uint32_t encodedSize = ReadUInt32(chunk + 8);
+
+    if (IntactChunkSize(data, size, pos, PerfCaptureChunkMagic) == 0) {
+      break; // Cut short here.
+    }
+
+    if (recordCount == 0) {
+      // The end marker.
+      if (droppedCount && (encodedSize >= 4)) {
+        *droppedCount = ReadUInt32(chunk + 16);
+      }
+      break;
+    }
+
+    if (!DecodeRecords(chunk + 16, chunk + 16 + encodedSize, recordCount, recordSize, decoded)) {
+      break;
+    }
+
+    const size_t first = stats.size();
+    stats.resize(first + recordCount);
+    memcpy(&stats[first], decoded.data(), decoded.size());
+    pos += 16 + encodedSize;
+  }
+
+  return true;
+}
+
+bool PerfCaptureSerializer::ReadIndex(
+    const uint8_t* data, size_t size, std::vector<ChunkIndexEntry>& index) {
+  index.clear();
+  if ((size < 32) || (ReadUInt32(data) != PerfCaptureMagic) ||
+      (ReadUInt32(data + size - 8) != PerfCaptureTrailerMagic)) {
+    return false;
+  }
+
+  const uint64_t indexOffset = ReadUInt64(data + size - 16);
+  const size_t chunkSize = IntactChunkSize(data, size - 16, indexOffset, PerfCaptureIndexMagic);
+  const uint32_t entryCount = (chunkSize != 0) ? ReadUInt32(data + indexOffset + 4) : 0;
+  if ((chunkSize == 0) || ((chunkSize - 16) != (size_t)entryCount * 16)) {
+    return false;
+  }
+
+  const uint8_t* p = data + indexOffset + 16;
+  index.resize(entryCount);
+  for (auto& entry : index) {
+    entry.Offset = ReadUInt64(p);
+    entry.FirstRecord = ReadUInt32(p + 8);
+    entry.RecordCount = ReadUInt32(p + 12);
+    p += 16;
+  }
+  return true;
+}
+
+bool PerfCaptureSerializer::Recover(
+    const std::string& filePath,
+    std::vector<ChunkIndexEntry>* index,
+    uint32_t* droppedCount,
+    uint64_t* footerOffset) {
+  std::vector<uint8_t> data;
+  {
+    std::ifstream file(filePath, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+      return false;
+    }
+    data.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  }
+
+  if ((data.size() < 16) || (ReadUInt32(data.data()) != PerfCaptureMagic) ||
+      (ReadUInt32(data.data() + 4) != PerfCaptureVersion) ||
+      (ReadUInt32(data.data() + 8) != sizeof(ovrPerfStats))) {
+    return false;
+  }
+
+  std::vector<ChunkIndexEntry> found;
+  uint32_t dropped = 0;
+  const uint64_t end = ScanChunks(data.data(), data.size(), found, dropped);
+  data.resize((size_t)end);
+  AppendFooter(data, found, dropped, end);
+
+  // Written beside the capture and then swapped in, so a failure part way doesn't lose it.
+  const std::string tempPath = filePath + ".recover";
+  {
+    std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    file.flush();
+    if (!file.good()) {
+      file.close();
+      std::remove(tempPath.c_str());
+      return false;
+    }
+  }
+  if ((std::remove(filePath.c_str()) != 0) || (std::rename(tempPath.c_str(), filePath.c_str()) != 0)) {
+    return false;
+  }
+
+  if (index) {
+    index->swap(found);
+  }
+  if (droppedCount) {
+    *droppedCount = dropped;
+  }
+  if (footerOffset) {
+    *footerOffset = end;
+  }
+  return true;
+}
@@ -23,16 +23,60 @@
 #include <fstream>
 #include <ostream>
 #include <istream>
+#include <thread>
 
 #include "OVR_CAPI.h"
+#include "Kernel/OVR_LocklessRing.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Implements Oculus performance stats capture serializer
 //
+// Step() only copies the frame's ovrPerfStats into an SPSC ring; a writer thread encodes and
+// writes them, so a capture costs the render thread the same each frame and can run for any
+// length. If the writer falls behind until the ring is full, records are dropped and counted.
+//
+// The writer ends a chunk once it is full or FlushIntervalMs after its first record, and
+// flushes the file after each one, so a crash loses at most the last interval's records. Each
+// chunk is appended once and never rewritten. Recover() truncates a capture which was cut short
+// to its last intact chunk and rebuilds the footer, and a capture constructed with resume set
+// does so and then carries on appending to it.
+//
 // --Serialized format--
-// The serialized file format is simply a memory dump of std::vector<ovrPerfStats> to disk. 
-// It is written as if like so:
-//     file.write(statsVector.data(), statsVector.size() * sizeof(ovrPerfStats));
+// All values are little endian.
+//
+//   File header, 16 bytes:
+//     uint32_t Magic;        PerfCaptureMagic ("OPCF")
+//     uint32_t Version;      PerfCaptureVersion
+//     uint32_t RecordSize;   sizeof(ovrPerfStats) in the writing SDK
+//     uint32_t Reserved;     0
+//
+//   Then chunks of up to RecordsPerChunk records, each:
+//     uint32_t Magic;        PerfCaptureChunkMagic ("CHNK")
+//     uint32_t RecordCount;
+//     uint32_t EncodedSize;  Bytes of payload which follow
+//     uint32_t CRC;          Standard_CRC32 of the payload
+//     uint8_t  Payload[EncodedSize];
+//
+//   The payload is the chunk's records with each one XORed with the record before it (the
+//   first with zeros, so chunks decode independently), which leaves mostly zero bytes. Those
+//   are stored as pairs of LEB128 varints, a count of zero bytes and a count of literal bytes,
+//   each followed by that many literal bytes.
+//
+//   Then the footer. The first part is the end marker chunk, with a RecordCount of 0 and a
+//   4 byte payload, the number of records which were dropped. A file without it was cut short,
+//   though its complete chunks are still valid. Then the index: a chunk with a Magic of
+//   PerfCaptureIndexMagic ("INDX") and a RecordCount of the number of record chunks, whose
+//   payload is, for each of them:
+//     uint64_t Offset;       Of the chunk's Magic, from the start of the file
+//     uint32_t FirstRecord;  Index of its first record in the capture
+//     uint32_t RecordCount;
+//   Last is a 16 byte trailer, so the index can be found from the end of the file:
+//     uint64_t IndexOffset;  Of the index chunk's Magic
+//     uint32_t Magic;        PerfCaptureTrailerMagic ("OPCX")
+//     uint32_t Reserved;     0
+//
+// Version 1 files are a raw dump of ovrPerfStats records with no header; Deserialize reads
+// both.
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 class PerfCaptureSerializer {
@@ -52,10 +96,29 @@ class PerfCaptureSerializer {
     Complete // PerfCapture has completed.
   };
 
+  static const uint32_t PerfCaptureMagic = 0x4643504F; // "OPCF"
+  static const uint32_t PerfCaptureChunkMagic = 0x4B4E4843; // "CHNK"
+  static const uint32_t PerfCaptureIndexMagic = 0x58444E49; // "INDX"
+  static const uint32_t PerfCaptureTrailerMagic = 0x5843504F; // "OPCX"
+  static const uint32_t PerfCaptureVersion = 2;
+
   PerfCaptureSerializer() 
     : PerfCaptureSerializer(0.0, Units::none, std::string()) {}
 
-  PerfCaptureSerializer(double totalDuration, Units units, const std::string& filePath);
+  // An entry of the footer's index, described above.
+  struct ChunkIndexEntry {
+    uint64_t Offset;
+    uint32_t FirstRecord;
+    uint32_t RecordCount;
+  };
+
+  // With resume set, an existing capture at filePath is recovered and appended to rather than
+  // replaced. Without a capture there it starts a new one either way.
+  PerfCaptureSerializer(
+      double totalDuration,
+      Units units,
+      const std::string& filePath,
+      bool resume = false);
 
   ~PerfCaptureSerializer();
 
@@ -76,26 +139,70 @@ class PerfCaptureSerializer {
     FilePath = filePath;
   }
 
+  // Records which were dropped because the writer thread fell behind.
+  uint32_t GetDroppedCount() const {
+    return DroppedCount.load(std::memory_order_relaxed);
+  }
+
+  // Reads a capture written by any version of PerfCaptureSerializer. Returns false if the file
+  // can't be read or isn't a capture; a capture which was cut short returns its complete chunks.
+  static bool Deserialize(const std::string& filePath, std::vector<ovrPerfStats>& stats);
+
+  // As above, for a capture which is already in memory, such as a mapped file. droppedCount, if
+  // given, receives the number of records the writer dropped, or 0 if the file doesn't say.
+  static bool Deserialize(
+      const uint8_t* data,
+      size_t size,
+      std::vector<ovrPerfStats>& stats,
+      uint32_t* droppedCount = nullptr);
+
+  // Reads the index from the footer of a capture which is already in memory. Returns false if
+  // it has no intact footer, as for a capture which was cut short and not yet recovered.
+  static bool ReadIndex(const uint8_t* data, size_t size, std::vector<ChunkIndexEntry>& index);
+
+  // Truncates the capture at filePath after its last intact chunk and writes a footer for the
+  // chunks before it. This is safe to run on a complete capture, which is written back the same.
+  // Returns false if the file can't be read or written, or isn't a version 2 capture. index,
+  // droppedCount and footerOffset, if given, receive the rebuilt index, the dropped count from
+  // the old end marker if it had one, and the offset the footer was written at.
+  static bool Recover(
+      const std::string& filePath,
+      std::vector<ChunkIndexEntry>* index = nullptr,
+      uint32_t* droppedCount = nullptr,
+      uint64_t* footerOffset = nullptr);
+
  protected:
   void StartCapture();
   void EndCapture();
-  void SerializeBuffer();
+  void WriterThreadMain();
+  bool WriteChunk(const std::vector<ovrPerfStats>& records);
+  bool WriteFooter();
 
 protected:
   std::string FilePath;
   Units DurationUnits;
   double TotalDuration;
 
+  bool Resume;
+
   double CompletionValue;
   Status CurrentStatus;
 
-  const int NumBufferedStatsReserve = 16384; // at 90 Hz, enough to hold several minutes worth
-  const int NumBufferedStatsSerializeTrigger = NumBufferedStatsReserve - 100;
+  static const int RingCapacity = 1024; // at 90 Hz, over ten seconds of writer stall
+  static const int RecordsPerChunk = 256;
+  static const int FlushIntervalMs = 1000;
 
-  // Might benefit from a lockless buffer if the synchronous writer stalls things.
-  std::vector<ovrPerfStats> BufferedPerfStats;
+  OVR::BlockingRing<OVR::SPSCRing<ovrPerfStats>> PendingStats;
+  std::thread WriterThread;
+  std::atomic<bool> StopWriter;
+  std::atomic<bool> WriteFailed;
+  std::atomic<uint32_t> DroppedCount;
 
+  // Used only by the writer thread while it runs.
   std::ofstream SerializedFile;
+  std::vector<ChunkIndexEntry> ChunkIndex;
+  uint64_t FileOffset;             // Where the next chunk goes
+  uint32_t RecordsWritten;
+  uint32_t ResumedDroppedCount;    // Dropped by the capture which was resumed
   int CurrentFrame;
 };
-
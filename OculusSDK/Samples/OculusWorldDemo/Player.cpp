@@ -84,8 +84,8 @@ Posef Player::VirtualWorldTransformfromRealPose(const Posef &sensorHeadPose, ovr
                  bodyPosInOrigin + baseQ.Rotate(sensorHeadPose.Translation));
 }
 
-void Player::HandleMovement(double dt, std::vector<Ptr<CollisionModel> >* collisionModels,
-	                        std::vector<Ptr<CollisionModel> >* groundCollisionModels, bool shiftDown)
+void Player::HandleMovement(double dt, const CollisionBVH* collisionModels,
+	                        const CollisionBVH* groundCollisionModels, bool shiftDown)
 {
     if(UserFrozen)
         return;
@@ -137,16 +137,12 @@ void Player::HandleMovement(double dt, std::vector<Ptr<CollisionModel> >* collis
     Planef  collisionPlaneForward;
     bool    gotCollision = false;
 
-    for(size_t i = 0; i < collisionModels->size(); ++i)
+    // Checks for collisions at model base level, which should prevent us from
+    // slipping under walls
+    if (collisionModels->TestRay(BodyPos, orientationVector, checkLengthForward,
+                                 &collisionPlaneForward))
     {
-        // Checks for collisions at model base level, which should prevent us from
-		// slipping under walls
-        if (collisionModels->at(i)->TestRay(BodyPos, orientationVector, checkLengthForward,
-				                            &collisionPlaneForward))
-        {
-            gotCollision = true;
-            break;
-        }
+        gotCollision = true;
     }
 
     if (gotCollision)
@@ -156,14 +152,10 @@ void Player::HandleMovement(double dt, std::vector<Ptr<CollisionModel> >* collis
 			* (orientationVector.Dot(collisionPlaneForward.N));
 
         // Make sure we aren't in a corner
-        for(size_t j = 0; j < collisionModels->size(); ++j)
+        if (collisionModels->TestPoint(BodyPos - Vector3f(0.0f, RailHeight, 0.0f) +
+                                       (slideVector * (moveLength))) )
         {
-            if (collisionModels->at(j)->TestPoint(BodyPos - Vector3f(0.0f, RailHeight, 0.0f) +
-					                                (slideVector * (moveLength))) )
-            {
-                moveLength = 0;
-                break;
-            }
+            moveLength = 0;
         }
         if (moveLength != 0)
         {
@@ -179,16 +171,13 @@ void Player::HandleMovement(double dt, std::vector<Ptr<CollisionModel> >* collis
     float finalDistanceDown = adjustedUserEyeHeight + 10.0f;
 
     // Only apply down if there is collision model (otherwise we get jitter).
-    if (groundCollisionModels->size())
+    if (groundCollisionModels->GetModelCount())
     {
-        for(size_t i = 0; i < groundCollisionModels->size(); ++i)
+        float checkLengthDown = adjustedUserEyeHeight + 10;
+        if (groundCollisionModels->TestRay(BodyPos, Vector3f(0.0f, -1.0f, 0.0f),
+            checkLengthDown, &collisionPlaneDown))
         {
-            float checkLengthDown = adjustedUserEyeHeight + 10;
-            if (groundCollisionModels->at(i)->TestRay(BodyPos, Vector3f(0.0f, -1.0f, 0.0f),
-                checkLengthDown, &collisionPlaneDown))
-            {
-                finalDistanceDown = Alg::Min(finalDistanceDown, checkLengthDown);
-            }
+            finalDistanceDown = Alg::Min(finalDistanceDown, checkLengthDown);
         }
 
         // Maintain the minimum camera height
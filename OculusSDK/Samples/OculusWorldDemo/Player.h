@@ -84,8 +84,8 @@ public:
     // Handle directional movement. Returns 'true' if movement was processed.
     bool    HandleMoveKey(OVR::KeyCode key, bool down);
 
-    void    HandleMovement(double dt, std::vector<Ptr<CollisionModel> >* collisionModels,
-                                      std::vector<Ptr<CollisionModel> >* groundCollisionModels, bool shiftDown);
+    void    HandleMovement(double dt, const CollisionBVH* collisionModels,
+                                      const CollisionBVH* groundCollisionModels, bool shiftDown);
 
     // Accounts for ComfortTurn setting.
     Anglef  GetApparentBodyYaw();
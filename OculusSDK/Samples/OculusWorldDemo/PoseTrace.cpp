@@ -0,0 +1,333 @@
+/************************************************************************************
+
+Filename    :   PoseTrace.cpp
+Content     :   Records tracking and player input per frame, for replaying a session
+Created     :   October 14, 2026
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#include "PoseTrace.h"
+
+#include <math.h>
+#include <string.h>
+
+static const float  PositionScale   = 10000.0f;     // Tenths of a millimeter.
+static const float  QuatScale       = 32767.0f * 1.41421356f; // The smallest three are within 1/sqrt(2).
+static const float  YawScale        = 100000.0f;
+static const float  StickScale      = 16384.0f;
+static const size_t WriteBlockSize  = 64 * 1024;
+
+PoseTraceFrame::PoseTraceFrame()
+  : Time(0.0), Dt(0.0f), HeadPose(Posef::Identity()), HeadStatus(0), BodyPos(), BodyYaw(0.0f),
+    GamepadMove(), GamepadRotate(), MoveForward(0), MoveBack(0), MoveLeft(0), MoveRight(0), ShiftDown(false)
+{
+    HandPoses[0] = HandPoses[1] = Posef::Identity();
+    HandStatus[0] = HandStatus[1] = 0;
+}
+
+
+//-------------------------------------------------------------------------------------
+// ***** PoseTraceCodec
+
+static int32_t QuantizeValue(float value, float scale)
+{
+    return (int32_t)floorf(value * scale + 0.5f);
+}
+
+static void QuantizePose(const Posef& pose, int32_t* fields)
+{
+    fields[0] = QuantizeValue(pose.Translation.x, PositionScale);
+    fields[1] = QuantizeValue(pose.Translation.y, PositionScale);
+    fields[2] = QuantizeValue(pose.Translation.z, PositionScale);
+
+    // Leave out the largest component, made positive, which the other three give.
+    const float q[4] = { pose.Rotation.x, pose.Rotation.y, pose.Rotation.z, pose.Rotation.w };
+    int largest = 0;
+    for (int i = 1; i < 4; i++)
+    {
+        if (fabsf(q[i]) > fabsf(q[largest]))
+            largest = i;
+    }
+    const float sign = (q[largest] < 0.0f) ? -1.0f : 1.0f;
+
+    fields[3] = largest;
+    for (int i = 0, j = 4; i < 4; i++)
+    {
+        if (i != largest)
+            fields[j++] = QuantizeValue(q[i] * sign, QuatScale);
+    }
+}
+
+static void DequantizePose(const int32_t* fields, Posef& pose)
+{
+    pose.Translation = Vector3f(fields[0] / PositionScale, fields[1] / PositionScale, fields[2] / PositionScale);
+
+    float q[4];
+    float sumSq = 0.0f;
+    const int largest = fields[3] & 3;
+    for (int i = 0, j = 4; i < 4; i++)
+    {
+        if (i != largest)
+        {
+            q[i] = fields[j++] / QuatScale;
+            sumSq += q[i] * q[i];
+        }
+    }
+    q[largest] = sqrtf(OVRMath_Max(0.0f, 1.0f - sumSq));
+
+    pose.Rotation = Quatf(q[0], q[1], q[2], q[3]);
+    pose.Rotation.Normalize();
+}
+
+static void AppendVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((uint8_t)value);
+}
+
+static bool ReadVarint(const uint8_t* data, size_t size, size_t& pos, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; (pos < size) && (shift < 64); shift += 7)
+    {
+        const uint8_t byte = data[pos++];
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static uint64_t ZigZag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t UnZigZag(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+void PoseTraceCodec::Reset()
+{
+    LastTimeUs = 0;
+    memset(LastFields, 0, sizeof(LastFields));
+}
+
+void PoseTraceCodec::Quantize(const PoseTraceFrame& frame, int32_t* fields) const
+{
+    fields[0] = QuantizeValue(frame.Dt, 1000000.0f);
+    QuantizePose(frame.HeadPose, fields + 1);
+    QuantizePose(frame.HandPoses[0], fields + 8);
+    QuantizePose(frame.HandPoses[1], fields + 15);
+    fields[22] = QuantizeValue(frame.BodyPos.x, PositionScale);
+    fields[23] = QuantizeValue(frame.BodyPos.y, PositionScale);
+    fields[24] = QuantizeValue(frame.BodyPos.z, PositionScale);
+    fields[25] = QuantizeValue(frame.BodyYaw, YawScale);
+    fields[26] = QuantizeValue(frame.GamepadMove.x, StickScale);
+    fields[27] = QuantizeValue(frame.GamepadMove.y, StickScale);
+    fields[28] = QuantizeValue(frame.GamepadMove.z, StickScale);
+    fields[29] = QuantizeValue(frame.GamepadRotate.x, StickScale);
+    fields[30] = QuantizeValue(frame.GamepadRotate.y, StickScale);
+    fields[31] = QuantizeValue(frame.GamepadRotate.z, StickScale);
+    fields[32] = frame.MoveForward;
+    fields[33] = frame.MoveBack;
+    fields[34] = frame.MoveLeft;
+    fields[35] = frame.MoveRight;
+    fields[36] = frame.ShiftDown ? 1 : 0;
+    fields[37] = (int32_t)frame.HeadStatus;
+    fields[38] = (int32_t)frame.HandStatus[0];
+    fields[39] = (int32_t)frame.HandStatus[1];
+    static_assert(FieldCount == 40, "Quantize and Dequantize write every field.");
+}
+
+void PoseTraceCodec::Dequantize(const int32_t* fields, PoseTraceFrame& frame) const
+{
+    frame.Dt = fields[0] / 1000000.0f;
+    DequantizePose(fields + 1, frame.HeadPose);
+    DequantizePose(fields + 8, frame.HandPoses[0]);
+    DequantizePose(fields + 15, frame.HandPoses[1]);
+    frame.BodyPos       = Vector3f(fields[22] / PositionScale, fields[23] / PositionScale, fields[24] / PositionScale);
+    frame.BodyYaw       = fields[25] / YawScale;
+    frame.GamepadMove   = Vector3f(fields[26] / StickScale, fields[27] / StickScale, fields[28] / StickScale);
+    frame.GamepadRotate = Vector3f(fields[29] / StickScale, fields[30] / StickScale, fields[31] / StickScale);
+    frame.MoveForward   = (uint8_t)fields[32];
+    frame.MoveBack      = (uint8_t)fields[33];
+    frame.MoveLeft      = (uint8_t)fields[34];
+    frame.MoveRight     = (uint8_t)fields[35];
+    frame.ShiftDown     = (fields[36] != 0);
+    frame.HeadStatus    = (uint32_t)fields[37];
+    frame.HandStatus[0] = (uint32_t)fields[38];
+    frame.HandStatus[1] = (uint32_t)fields[39];
+}
+
+void PoseTraceCodec::Encode(const PoseTraceFrame& frame, std::vector<uint8_t>& out)
+{
+    const int64_t timeUs = (int64_t)floor(frame.Time * 1000000.0 + 0.5);
+    AppendVarint(out, ZigZag(timeUs - LastTimeUs));
+    LastTimeUs = timeUs;
+
+    int32_t fields[FieldCount];
+    Quantize(frame, fields);
+    for (int i = 0; i < FieldCount; i++)
+    {
+        AppendVarint(out, ZigZag((int64_t)fields[i] - LastFields[i]));
+        LastFields[i] = fields[i];
+    }
+}
+
+size_t PoseTraceCodec::Decode(const uint8_t* data, size_t size, PoseTraceFrame& frame)
+{
+    size_t   pos = 0;
+    uint64_t value;
+    if (!ReadVarint(data, size, pos, value))
+        return 0;
+    const int64_t timeUs = LastTimeUs + UnZigZag(value);
+
+    int32_t fields[FieldCount];
+    for (int i = 0; i < FieldCount; i++)
+    {
+        if (!ReadVarint(data, size, pos, value))
+            return 0;
+        fields[i] = (int32_t)(LastFields[i] + UnZigZag(value));
+    }
+
+    LastTimeUs = timeUs;
+    memcpy(LastFields, fields, sizeof(LastFields));
+    frame.Time = timeUs / 1000000.0;
+    Dequantize(fields, frame);
+    return pos;
+}
+
+
+//-------------------------------------------------------------------------------------
+// ***** PoseTraceWriter
+
+bool PoseTraceWriter::Open(const char* filePath)
+{
+    Close();
+
+    File = fopen(filePath, "wb");
+    if (!File)
+        return false;
+
+    Codec.Reset();
+    FrameCount = 0;
+
+    const uint32_t header[3] = { PoseTraceCodec::PoseTraceMagic, PoseTraceCodec::PoseTraceVersion,
+                                 PoseTraceCodec::FieldCount };
+    for (uint32_t value : header)
+    {
+        for (int i = 0; i < 4; ++i)
+            Buffer.push_back((uint8_t)(value >> (i * 8)));
+    }
+    return true;
+}
+
+void PoseTraceWriter::Write(const PoseTraceFrame& frame)
+{
+    if (!File)
+        return;
+
+    Codec.Encode(frame, Buffer);
+    FrameCount++;
+    if (Buffer.size() >= WriteBlockSize)
+        Flush();
+}
+
+bool PoseTraceWriter::Flush()
+{
+    const bool success = Buffer.empty() || (fwrite(Buffer.data(), 1, Buffer.size(), File) == Buffer.size());
+    Buffer.clear();
+    return success;
+}
+
+bool PoseTraceWriter::Close()
+{
+    if (!File)
+        return true;
+
+    bool success = Flush();
+    success = (fclose(File) == 0) && success;
+    File = nullptr;
+    return success;
+}
+
+
+//-------------------------------------------------------------------------------------
+// ***** PoseTraceReader
+
+bool PoseTraceReader::Open(const char* filePath)
+{
+    Close();
+
+    FILE* file = fopen(filePath, "rb");
+    if (!file)
+        return false;
+
+    uint8_t block[4096];
+    size_t  bytes;
+    while ((bytes = fread(block, 1, sizeof(block), file)) > 0)
+        Data.insert(Data.end(), block, block + bytes);
+    fclose(file);
+
+    uint32_t header[3] = {};
+    for (int h = 0; (h < 3) && (Data.size() >= 12); h++)
+    {
+        for (int i = 0; i < 4; ++i)
+            header[h] |= (uint32_t)Data[h * 4 + i] << (i * 8);
+    }
+
+    if ((header[0] != PoseTraceCodec::PoseTraceMagic) || (header[1] != PoseTraceCodec::PoseTraceVersion) ||
+        (header[2] != PoseTraceCodec::FieldCount))
+    {
+        Close();
+        return false;
+    }
+
+    Position = 12;
+    FrameCount = 0;
+    return true;
+}
+
+bool PoseTraceReader::Read(PoseTraceFrame& frame)
+{
+    if (Data.empty())
+        return false;
+
+    const size_t bytes = Codec.Decode(Data.data() + Position, Data.size() - Position, frame);
+    if (bytes == 0)
+    {
+        Close();
+        return false;
+    }
+
+    Position += bytes;
+    FrameCount++;
+    return true;
+}
+
+void PoseTraceReader::Close()
+{
+    std::vector<uint8_t>().swap(Data);
+    Position = 0;
+    Codec.Reset();
+}
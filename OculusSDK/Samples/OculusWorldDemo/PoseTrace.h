@@ -0,0 +1,139 @@
+/************************************************************************************
+
+Filename    :   PoseTrace.h
+Content     :   Records tracking and player input per frame, for replaying a session
+Created     :   October 14, 2026
+
+Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+*************************************************************************************/
+
+#ifndef OVR_PoseTrace_h
+#define OVR_PoseTrace_h
+
+#include "Kernel/OVR_Types.h"
+#include "Extras/OVR_Math.h"
+
+#include <stdio.h>
+#include <vector>
+
+using namespace OVR;
+
+//-------------------------------------------------------------------------------------
+// ***** PoseTraceFrame
+//
+// What a frame of the demo took from tracking and input, and where the player ended up.
+// Poses are in the tracking space, and BodyPos is the player's eye level body position after
+// the frame's movement.
+struct PoseTraceFrame
+{
+    double      Time;           // Seconds since the trace started.
+    float       Dt;             // The player's movement step.
+    Posef       HeadPose;
+    Posef       HandPoses[2];
+    uint32_t    HeadStatus;
+    uint32_t    HandStatus[2];
+    Vector3f    BodyPos;
+    float       BodyYaw;        // Radians, before the movement step.
+    Vector3f    GamepadMove;
+    Vector3f    GamepadRotate;
+    uint8_t     MoveForward, MoveBack, MoveLeft, MoveRight;
+    bool        ShiftDown;
+
+    PoseTraceFrame();
+};
+
+
+//-------------------------------------------------------------------------------------
+// ***** PoseTraceCodec
+//
+// Frames are quantized to integer fields, which are written as the LEB128 varint of the
+// zigzagged difference from the frame before, so a frame where little changed takes around a
+// byte per field. Positions are kept to a tenth of a millimeter and quaternions as their three
+// smallest components, at 15 bits each, plus the index of the largest.
+//
+// --Serialized format--
+//   PoseTraceMagic ("OPTR"), PoseTraceVersion and FieldCount as little endian uint32_t,
+//   then per frame the microseconds since the last frame and each field's difference.
+class PoseTraceCodec
+{
+public:
+    static const uint32_t PoseTraceMagic = 0x5254504F; // "OPTR"
+    static const uint32_t PoseTraceVersion = 1;
+
+    enum { FieldCount = 40 };
+
+    PoseTraceCodec() { Reset(); }
+
+    void Reset();
+    void Encode(const PoseTraceFrame& frame, std::vector<uint8_t>& out);
+    // Returns the bytes read from data, or 0 if the frame there is cut short.
+    size_t Decode(const uint8_t* data, size_t size, PoseTraceFrame& frame);
+
+private:
+    void Quantize(const PoseTraceFrame& frame, int32_t* fields) const;
+    void Dequantize(const int32_t* fields, PoseTraceFrame& frame) const;
+
+    int64_t LastTimeUs;
+    int32_t LastFields[FieldCount];
+};
+
+
+//-------------------------------------------------------------------------------------
+// ***** PoseTraceWriter, PoseTraceReader
+
+class PoseTraceWriter
+{
+public:
+    PoseTraceWriter() : File(nullptr), Codec(), Buffer(), FrameCount(0) {}
+    ~PoseTraceWriter() { Close(); }
+
+    bool     Open(const char* filePath);
+    bool     IsOpen() const { return File != nullptr; }
+    // Frames are buffered and written in blocks.
+    void     Write(const PoseTraceFrame& frame);
+    bool     Close();
+    uint32_t GetFrameCount() const { return FrameCount; }
+
+private:
+    bool     Flush();
+
+    FILE*                File;
+    PoseTraceCodec       Codec;
+    std::vector<uint8_t> Buffer;
+    uint32_t             FrameCount;
+};
+
+class PoseTraceReader
+{
+public:
+    PoseTraceReader() : Data(), Position(0), Codec(), FrameCount(0) {}
+
+    // Reads in the whole trace.
+    bool     Open(const char* filePath);
+    bool     IsOpen() const { return !Data.empty(); }
+    // Returns false, and closes the trace, once it has no more frames.
+    bool     Read(PoseTraceFrame& frame);
+    void     Close();
+    uint32_t GetFrameCount() const { return FrameCount; }
+
+private:
+    std::vector<uint8_t> Data;
+    size_t               Position;
+    PoseTraceCodec       Codec;
+    uint32_t             FrameCount;  // Read so far.
+};
+
+#endif // OVR_PoseTrace_h
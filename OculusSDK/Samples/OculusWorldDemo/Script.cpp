@@ -22,6 +22,8 @@ limitations under the License.
 #include "../CommonSrc/Util/Logger.h" // WriteLog
 #include "../CommonSrc/Render/Render_Device.h"
 #include "Util/Util_D3D11_Blitter.h" // From OVRKernel
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -83,11 +85,28 @@ static void TrimAndDequote(std::string& str)
 
 
 OWDScript::OWDScript(OculusWorldDemoApp* owdApp)
-    : ScriptFile(), ScriptOutputPath(), ScriptState(State::None), Commands(), CurrentCommand(), Status(), OWDApp(owdApp)
+    : ScriptFile(), ScriptOutputPath(), ScriptState(State::None), Script(), CurrentCommand(), Status(), OWDApp(owdApp),
+      CommandStarted(false), WaitCompletion(0.0), Capture(), CaptureStartPrinted(false), LoopRemaining()
 {
 }
 
 
+uint32_t OWDScript::Program::AddString(const std::string& str)
+{
+    uint32_t offset = (uint32_t)Strings.size();
+    Strings.insert(Strings.end(), str.c_str(), str.c_str() + str.size() + 1);
+    return offset;
+}
+
+
+void OWDScript::Program::Clear()
+{
+    Commands.clear();
+    Strings.clear();
+    MaxLoopDepth = 0;
+}
+
+
 // Does some checking and calls the lower level LoadScriptFile function.
 bool OWDScript::LoadScriptFile(const char* filePath)
 {
@@ -97,7 +116,10 @@ bool OWDScript::LoadScriptFile(const char* filePath)
     {
         ScriptFile = filePath; // Save this for possible use during LoadScriptFile.
         TrimAndDequote(ScriptFile);
-        success = LoadScriptFile(filePath, Commands);
+        std::vector<uint32_t> openLoops;
+        success = LoadScriptFile(filePath, Script, openLoops);
+        FinishLoad(success, Script, openLoops);
+        success = (ScriptState == State::NotStarted);
     }
 
     return success;
@@ -108,12 +130,39 @@ bool OWDScript::LoadScriptFile(const char* filePath)
 bool OWDScript::LoadScriptText(const char* scriptText)
 {
     if(ScriptState == State::None) // If not already executing script...
-        return LoadScriptText(scriptText, Commands);
+    {
+        std::vector<uint32_t> openLoops;
+        bool success = LoadScriptText(scriptText, Script, openLoops);
+        FinishLoad(success, Script, openLoops);
+        return (ScriptState == State::NotStarted);
+    }
 
     return false;
 }
 
 
+bool OWDScript::SaveCompiledScript(const char* filePath) const
+{
+    if(ScriptState == State::None)
+        return false;
+
+    CompiledHeader header = { CompiledMagic, CompiledVersion, (uint32_t)Script.Commands.size(),
+                              (uint32_t)Script.Strings.size(), Script.MaxLoopDepth };
+
+    std::ofstream file(filePath, std::ios::out | std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!Script.Commands.empty())
+        file.write(reinterpret_cast<const char*>(Script.Commands.data()), Script.Commands.size() * sizeof(Command));
+    if (!Script.Strings.empty())
+        file.write(Script.Strings.data(), Script.Strings.size());
+    file.close();
+
+    bool success = !file.fail();
+    WriteLog("[OWDScript] Save compiled script to %s %s\n", filePath, success ? "succeeded" : "failed");
+    return success;
+}
+
+
 bool OWDScript::SetScriptOutputPath(const char* directoryPath)
 {
     ScriptOutputPath = directoryPath;
@@ -132,23 +181,26 @@ void OWDScript::Shutdown()
 
     // Return to the newly constructed state.
     ScriptFile.clear();
-    Commands.clear();
+    Script.Clear();
     CurrentCommand = 0;
     ScriptState = State::None;
     Status = 0;
+    CommandStarted = false;
+    Capture.reset();
+    LoopRemaining.clear();
     // Do not clear OWDApp, as it's set on construction.
 }
 
 
-// Loads the file and calls the lower level LoadScriptText function.
-bool OWDScript::LoadScriptFile(const char* filePath, CommandVector& commands)
+// Loads the file and calls the lower level LoadScriptText or LoadCompiledScript function.
+bool OWDScript::LoadScriptFile(const char* filePath, Program& program, std::vector<uint32_t>& openLoops)
 {
     bool success = false;
 
     std::string filePathStr(filePath);
     Dequote(filePathStr);
 
-    std::ifstream file(filePathStr.c_str(), std::ios::in);
+    std::ifstream file(filePathStr.c_str(), std::ios::in | std::ios::binary);
 
     if (!file)
     {
@@ -164,7 +216,7 @@ bool OWDScript::LoadScriptFile(const char* filePath, CommandVector& commands)
             filePathStr += filePath;    // e.g. /somedir/somedir/script_2.txt
         }
 
-        file.open(filePathStr.c_str(), std::ios::in);
+        file.open(filePathStr.c_str(), std::ios::in | std::ios::binary);
     }
 
     if (file)
@@ -173,14 +225,85 @@ bool OWDScript::LoadScriptFile(const char* filePath, CommandVector& commands)
         scriptText << file.rdbuf();
         file.close();
 
-        success = LoadScriptText(scriptText.str().c_str(), commands);
+        uint32_t magic = 0;
+        const std::string& data = scriptText.str();
+        if (data.size() >= sizeof(magic))
+            memcpy(&magic, data.data(), sizeof(magic));
+
+        if (magic == CompiledMagic)
+        {
+            // A compiled script has no text to include, so it can only be loaded on its own.
+            if (program.Commands.empty() && openLoops.empty())
+                success = LoadCompiledScript(data, program);
+            else
+                WriteLog("[OWDScript] Compiled script %s can't be executed from another script\n", filePathStr.c_str());
+        }
+        else
+            success = LoadScriptText(data.c_str(), program, openLoops);
     }
     
     return success;
 }
 
 
-bool OWDScript::LoadScriptText(const char* scriptText, CommandVector& commands)
+bool OWDScript::LoadCompiledScript(const std::string& data, Program& program)
+{
+    CompiledHeader header;
+    if (data.size() < sizeof(header))
+        return false;
+    memcpy(&header, data.data(), sizeof(header));
+
+    if ((header.Version != CompiledVersion) ||
+        (data.size() != sizeof(header) + (size_t)header.CommandCount * sizeof(Command) + header.StringBytes))
+    {
+        WriteLog("[OWDScript] Invalid compiled script: version %u, %u bytes\n", header.Version, (unsigned)data.size());
+        return false;
+    }
+
+    const char* commandData = data.data() + sizeof(header);
+    program.Commands.resize(header.CommandCount);
+    if (header.CommandCount)
+        memcpy(program.Commands.data(), commandData, header.CommandCount * sizeof(Command));
+    program.Strings.assign(commandData + header.CommandCount * sizeof(Command), data.data() + data.size());
+    program.MaxLoopDepth = header.MaxLoopDepth;
+
+    // Check what stepping relies on, so a damaged file can't index out of range.
+    for (size_t i = 0; i < program.Commands.size(); i++)
+    {
+        const Command& c = program.Commands[i];
+        bool valid = (c.Type <= CommandType::EndRepeat);
+        switch (c.Type)
+        {
+            case CommandType::ExecuteMenu:
+                valid = (c.Args[0] < header.StringBytes) && (c.Args[1] < header.StringBytes);
+                break;
+            case CommandType::Screenshot:
+            case CommandType::WriteLog:
+            case CommandType::PerfCapture:
+                valid = (c.Args[0] < header.StringBytes);
+                break;
+            case CommandType::Repeat:
+                valid = (c.Flags < header.MaxLoopDepth) && (c.Args[1] > i) && (c.Args[1] < program.Commands.size());
+                break;
+            case CommandType::EndRepeat:
+                valid = (c.Flags < header.MaxLoopDepth) && (c.Args[0] <= i);
+                break;
+            default:
+                break;
+        }
+
+        if (!valid)
+        {
+            WriteLog("[OWDScript] Invalid compiled script command %u\n", (unsigned)i);
+            return false;
+        }
+    }
+
+    return program.Strings.empty() || (program.Strings.back() == '\0');
+}
+
+
+bool OWDScript::LoadScriptText(const char* scriptText, Program& program, std::vector<uint32_t>& openLoops)
 {
     bool success = true;
 
@@ -193,67 +316,88 @@ bool OWDScript::LoadScriptText(const char* scriptText, CommandVector& commands)
         {
             Trim(line);
 
-            if (!ReadCommandLine(line, commands))
-            {
+            if (!ReadCommandLine(line, program, openLoops))
                 success = false;
-                commands.clear();
-            }
         }
     }
 
-    ScriptState = (success ? State::NotStarted : State::None);
-
     return success;
 }
 
 
+void OWDScript::FinishLoad(bool success, Program& program, const std::vector<uint32_t>& openLoops)
+{
+    if (success && !openLoops.empty())
+    {
+        WriteLog("[OWDScript] Repeat without EndRepeat\n");
+        success = false;
+    }
+
+    if (success)
+    {
+        // All the stepping state there will be, so Step never allocates.
+        LoopRemaining.assign(program.MaxLoopDepth, 0);
+        CurrentCommand = 0;
+        CommandStarted = false;
+    }
+    else
+        program.Clear();
+
+    ScriptState = (success ? State::NotStarted : State::None);
+}
+
+
 // The input line is expected to be trimmed of leading and trailing whitespace.
-bool OWDScript::ReadCommandLine(const std::string& line, CommandVector& commands)
+bool OWDScript::ReadCommandLine(const std::string& line, Program& program, std::vector<uint32_t>& openLoops)
 {
     bool success = true;
     char commandName[32];
     int result = sscanf(line.c_str(), "%31s", commandName); // Get the command name (e.g. "Wait")
+    Command command = {};
 
     if(result == 1)
     {
         if(OVR_stristr(commandName, "ExecuteMenu") == commandName)
         {
-            CommandPtr commandPtr = std::make_shared<CommandExecuteMenu>();
-            CommandExecuteMenu* p = static_cast<CommandExecuteMenu*>(commandPtr.get());
-
             // We have a line like so: " ExecuteMenu   \"parent.child.size\" 100.23"
-            p->MenuPath = line;
-            p->MenuPath.erase(0, strlen("ExecuteMenu"));
-            Trim(p->MenuPath);
+            std::string menuPath = line;
+            std::string menuValue;
+            menuPath.erase(0, strlen("ExecuteMenu"));
+            Trim(menuPath);
 
             // Now we have a line like so: "\"parent.child.size\" \"some value\""
             // We implement a dequoting scheme that has limitations in its flexibility of handling
             // escaped quotes, but it should work for all our known value string use cases.
-            size_t lastLineQuote = p->MenuPath.rfind('\"');
-            size_t firstLineQuote = p->MenuPath.find('\"');
+            size_t lastLineQuote = menuPath.rfind('\"');
+            size_t firstLineQuote = menuPath.find('\"');
 
-            if(lastLineQuote == (p->MenuPath.size() - 1) &&  // If the last argument is quoted...
+            if(lastLineQuote == (menuPath.size() - 1) &&  // If the last argument is quoted...
                (firstLineQuote != lastLineQuote)) // And 
             {
-                firstLineQuote = p->MenuPath.rfind('\"', lastLineQuote - 1);
-                p->MenuValue.assign(p->MenuPath, firstLineQuote, lastLineQuote + 1 - firstLineQuote);
-                p->MenuPath.erase(firstLineQuote);
+                firstLineQuote = menuPath.rfind('\"', lastLineQuote - 1);
+                menuValue.assign(menuPath, firstLineQuote, lastLineQuote + 1 - firstLineQuote);
+                menuPath.erase(firstLineQuote);
             }
             else
             {
-                size_t lastLineSpace = p->MenuPath.find_last_of(" \t");
+                size_t lastLineSpace = menuPath.find_last_of(" \t");
                 if(lastLineSpace != std::string::npos)
                 {  
-                    p->MenuValue.assign(p->MenuPath, lastLineSpace);
-                    p->MenuPath.erase(lastLineSpace);
+                    menuValue.assign(menuPath, lastLineSpace);
+                    menuPath.erase(lastLineSpace);
                 }
             }
 
-            TrimAndDequote(p->MenuPath);
-            TrimAndDequote(p->MenuValue);
+            TrimAndDequote(menuPath);
+            TrimAndDequote(menuValue);
 
-            if (!p->MenuPath.empty() && !p->MenuValue.empty())
-                commands.push_back(commandPtr);
+            if (!menuPath.empty() && !menuValue.empty())
+            {
+                command.Type = CommandType::ExecuteMenu;
+                command.Args[0] = program.AddString(menuPath);
+                command.Args[1] = program.AddString(menuValue);
+                program.Commands.push_back(command);
+            }
             else
             {
                 WriteLog("[OWDScript] Invalid ExecuteMenu command: %s. Expect ExecuteMenu <menu path string> <value>\n", line.c_str());
@@ -265,11 +409,10 @@ bool OWDScript::ReadCommandLine(const std::string& line, CommandVector& commands
             std::string filePath = (line.c_str() + strlen("ExecuteScriptFile"));
             TrimAndDequote(filePath);
 
-            CommandVector commandsTemp;
+            // The file's commands are compiled in place. Its loops must end within it.
+            size_t openLoopCount = openLoops.size();
 
-            if (LoadScriptFile(filePath.c_str(), commandsTemp))
-                commands.insert(commands.end(), commandsTemp.begin(), commandsTemp.end());
-            else
+            if (!LoadScriptFile(filePath.c_str(), program, openLoops) || (openLoops.size() != openLoopCount))
             {
                 WriteLog("[OWDScript] Invalid or unloadable ExecuteScriptFile command: %s. Expect ExecuteScriptFile <script file path string>\n", line.c_str());
                 success = false;
@@ -277,18 +420,18 @@ bool OWDScript::ReadCommandLine(const std::string& line, CommandVector& commands
         }
         else if(OVR_stristr(commandName, "SetPose") == commandName)
         {
-            CommandPtr commandPtr = std::make_shared<CommandSetPose>();
-            CommandSetPose* p = static_cast<CommandSetPose*>(commandPtr.get());
+            command.Type = CommandType::SetPose;
             char buffer[8];
 
-            int argCount = sscanf(line.c_str(), "%*s %f %f %f %f %f %f", &p->X, &p->Y, &p->Z, &p->OriX, &p->OriY, &p->OriZ);
+            int argCount = sscanf(line.c_str(), "%*s %f %f %f %f %f %f", &command.Values[0], &command.Values[1], &command.Values[2],
+                                  &command.Values[3], &command.Values[4], &command.Values[5]);
             
             if (argCount == 6)
-                commands.push_back(commandPtr);
-            else if((sscanf(line.c_str(), "%*s %8s", buffer) == 1) && (OVR_stricmp(buffer, "off") == 0))
+                program.Commands.push_back(command);
+            else if((sscanf(line.c_str(), "%*s %7s", buffer) == 1) && (OVR_stricmp(buffer, "off") == 0))
             {
-                p->stop = true;
-                commands.push_back(commandPtr);
+                command.Flags = 1;
+                program.Commands.push_back(command);
             }
             else
             {
@@ -298,28 +441,27 @@ bool OWDScript::ReadCommandLine(const std::string& line, CommandVector& commands
         }
         else if(OVR_stristr(commandName, "Wait") == commandName)
         {
-            CommandPtr commandPtr = std::make_shared<CommandWait>();
-            CommandWait* p = static_cast<CommandWait*>(commandPtr.get());
+            command.Type = CommandType::Wait;
 
             char waitUnits[16];
-            int argCount = sscanf(line.c_str(), "%*s %lf %15s", &p->WaitAmount, waitUnits);
+            int argCount = sscanf(line.c_str(), "%*s %f %15s", &command.Values[0], waitUnits);
             
             if (argCount == 2)
             {
                 if(OVR_stristr(waitUnits, "ms") == waitUnits)
-                    p->WaitUnits = CommandWait::ms;
+                    command.Flags = Units_Ms;
                 else if(OVR_stristr(waitUnits, "s") == waitUnits)
-                    p->WaitUnits = CommandWait::s;
+                    command.Flags = Units_S;
                 else if(OVR_stristr(waitUnits, "frame") == waitUnits) // Covers both "frame" and "frames".
-                    p->WaitUnits = CommandWait::frames;
+                    command.Flags = Units_Frames;
                 else
                 {
                     WriteLog("[OWDScript] Invalid wait units: %s", waitUnits);
                     success = false;
                 }
 
-                if ((p->WaitAmount > 0) && (p->WaitUnits != CommandWait::none))
-                    commands.push_back(commandPtr);
+                if ((command.Values[0] > 0) && (command.Flags != Units_None))
+                    program.Commands.push_back(command);
             }
             else
             {
@@ -329,13 +471,14 @@ bool OWDScript::ReadCommandLine(const std::string& line, CommandVector& commands
         }
         else if(OVR_stristr(commandName, "Screenshot") == commandName)
         {
-            CommandPtr commandPtr = std::make_shared<CommandScreenshot>();
-            CommandScreenshot* p = static_cast<CommandScreenshot*>(commandPtr.get());
-
-            p->ScreenshotFilePath = line.c_str() + strlen("Screenshot");
-            TrimAndDequote(p->ScreenshotFilePath);
-            if (!p->ScreenshotFilePath.empty())
-                commands.push_back(commandPtr);
+            std::string screenshotFilePath = line.c_str() + strlen("Screenshot");
+            TrimAndDequote(screenshotFilePath);
+            if (!screenshotFilePath.empty())
+            {
+                command.Type = CommandType::Screenshot;
+                command.Args[0] = program.AddString(screenshotFilePath);
+                program.Commands.push_back(command);
+            }
             else
             {
                 WriteLog("[OWDScript] Invalid Screenshot command: %s. Expect Screenshot <output file path>\n", line.c_str());
@@ -344,49 +487,52 @@ bool OWDScript::ReadCommandLine(const std::string& line, CommandVector& commands
         }
         else if (OVR_stristr(commandName, "PerfCapture") == commandName)
         {
-          CommandPtr commandPtr = std::make_shared<CommandPerfCapture>();
-          CommandPerfCapture* p = static_cast<CommandPerfCapture*>(commandPtr.get());
+          command.Type = CommandType::PerfCapture;
+          std::string captureFilePath;
 
           char unitsStr[16];
           int cmdStrLen;
           const char* lineCStr = line.c_str();
-          int argCount = sscanf(lineCStr, "%*s %lf %15s%n", &p->CaptureTotalDuration, unitsStr, &cmdStrLen);
+          int argCount = sscanf(lineCStr, "%*s %f %15s%n", &command.Values[0], unitsStr, &cmdStrLen);
 
           // Read rest of the string into variable. We do this to pull in white spaces.
           int fileNameStartOffset = cmdStrLen + 1;
-          if ((int)strlen(lineCStr) > fileNameStartOffset)
+          if ((argCount == 2) && ((int)strlen(lineCStr) > fileNameStartOffset))
           {
-            p->CaptureFilePath = lineCStr + fileNameStartOffset;
-            TrimAndDequote(p->CaptureFilePath);
+            captureFilePath = lineCStr + fileNameStartOffset;
+            TrimAndDequote(captureFilePath);
 
-            if (!p->CaptureFilePath.empty())
+            const char* resumeStr = "resume ";
+            if (OVR_strnicmp(captureFilePath.c_str(), resumeStr, strlen(resumeStr)) == 0)
+            {
+              command.Flags |= CaptureFlag_Resume;
+              captureFilePath.erase(0, strlen(resumeStr));
+              TrimAndDequote(captureFilePath);
+            }
+
+            if (!captureFilePath.empty())
               argCount++;
           }
 
           if (argCount == 3)
           {
             if (OVR_stristr(unitsStr, "ms") == unitsStr)
-              p->CaptureDurationUnits = PerfCaptureSerializer::Units::ms;
+              command.Flags |= Units_Ms;
             else if (OVR_stristr(unitsStr, "s") == unitsStr)
-              p->CaptureDurationUnits = PerfCaptureSerializer::Units::s;
+              command.Flags |= Units_S;
             else if (OVR_stristr(unitsStr, "frame") == unitsStr) // Covers both "frame" and "frames".
-              p->CaptureDurationUnits = PerfCaptureSerializer::Units::frames;
+              command.Flags |= Units_Frames;
             else
             {
               WriteLog("OWDScript: Invalid duration units: %s", unitsStr);
               success = false;
             }
 
-            if ((p->CaptureTotalDuration > 0) && (p->CaptureDurationUnits != PerfCaptureSerializer::Units::none))
+            if ((command.Values[0] > 0) && ((command.Flags & CaptureFlag_UnitsMask) != Units_None))
             {
-              if (p->CaptureCollector == nullptr)
-              {
-                // since we need the session, we delay the capture 
-                p->CaptureCollector = std::make_shared<PerfCaptureSerializer>(
-                  p->CaptureTotalDuration, p->CaptureDurationUnits, p->CaptureFilePath);
-              }
-
-              commands.push_back(commandPtr);
+              // The capture itself is created when the command starts, since it needs the session.
+              command.Args[0] = program.AddString(captureFilePath);
+              program.Commands.push_back(command);
             }
           }
           else
@@ -398,19 +544,63 @@ bool OWDScript::ReadCommandLine(const std::string& line, CommandVector& commands
         }
         else if(OVR_stristr(commandName, "WriteLog") == commandName)
         {
-            CommandPtr commandPtr = std::make_shared<CommandWriteLog>();
-            CommandWriteLog* p = static_cast<CommandWriteLog*>(commandPtr.get());
-
-            p->LogText = line.c_str() + strlen("WriteLog");
-            TrimAndDequote(p->LogText); // Unfortunately, we don't have a way of telling if the quote char is intentional.
-            if (!p->LogText.empty())
-                commands.push_back(commandPtr);
+            std::string logText = line.c_str() + strlen("WriteLog");
+            TrimAndDequote(logText); // Unfortunately, we don't have a way of telling if the quote char is intentional.
+            if (!logText.empty())
+            {
+                command.Type = CommandType::WriteLog;
+                command.Args[0] = program.AddString(logText);
+                program.Commands.push_back(command);
+            }
             // Do we print an error that the log text was empty?
         }
         else if(OVR_stristr(commandName, "Exit") == commandName)
         {
-            CommandPtr commandPtr = std::make_shared<CommandExit>();
-            commands.push_back(commandPtr);
+            command.Type = CommandType::Exit;
+            program.Commands.push_back(command);
+        }
+        else if(OVR_stristr(commandName, "EndRepeat") == commandName)
+        {
+            if (!openLoops.empty())
+            {
+                uint32_t repeatIndex = openLoops.back();
+                openLoops.pop_back();
+
+                if (program.Commands.size() == repeatIndex + 1) // An empty loop does nothing.
+                    program.Commands.pop_back();
+                else
+                {
+                    command.Type = CommandType::EndRepeat;
+                    command.Flags = program.Commands[repeatIndex].Flags;
+                    command.Args[0] = repeatIndex + 1;
+                    program.Commands[repeatIndex].Args[1] = (uint32_t)program.Commands.size();
+                    program.Commands.push_back(command);
+                }
+            }
+            else
+            {
+                WriteLog("[OWDScript] EndRepeat without Repeat: %s\n", line.c_str());
+                success = false;
+            }
+        }
+        else if(OVR_stristr(commandName, "Repeat") == commandName)
+        {
+            unsigned count = 0;
+
+            if (sscanf(line.c_str(), "%*s %u", &count) == 1)
+            {
+                command.Type = CommandType::Repeat;
+                command.Flags = (uint16_t)openLoops.size();
+                command.Args[0] = count;
+                openLoops.push_back((uint32_t)program.Commands.size());
+                program.Commands.push_back(command);
+                program.MaxLoopDepth = std::max(program.MaxLoopDepth, (uint32_t)openLoops.size());
+            }
+            else
+            {
+                WriteLog("[OWDScript] Invalid Repeat command: %s. Expect Repeat <count>\n", line.c_str());
+                success = false;
+            }
         }
         else if(line.empty() || (line[0] == '/' && line[1] == '/'))
         {
@@ -455,174 +645,218 @@ void OWDScript::CleanupOWDState()
 
 OWDScript::State OWDScript::Step()
 {
-    // Currently we execute no more than one instruction per step. We could possibly execute
-    // multiple instructions in a step for instructions that complete during the step.
+    // Currently we execute no more than one instruction per step, not counting the Repeat and
+    // EndRepeat instructions on the way to it. We could possibly execute multiple instructions
+    // in a step for instructions that complete during the step.
 
     if((ScriptState == State::NotStarted) || (ScriptState == State::Started))
     {
         ScriptState = State::Started; // Set it started if not started already.
 
-        if (CurrentCommand < Commands.size())
+        while (CurrentCommand < Script.Commands.size())
         {
-            Command& command = *Commands[CurrentCommand].get(); // Convert shared_ptr to a reference.
+            const Command& command = Script.Commands[CurrentCommand];
 
-            switch (command.commandType)
+            if (command.Type == CommandType::Repeat)
             {
-                case CommandType::ExecuteMenu:{
-                    CommandExecuteMenu& c = static_cast<CommandExecuteMenu&>(command);
+                if (command.Args[0] == 0)
+                    NextCommand(command.Args[1] + 1); // Skip past the EndRepeat.
+                else
+                {
+                    LoopRemaining[command.Flags] = command.Args[0];
+                    NextCommand(CurrentCommand + 1);
+                }
+            }
+            else if (command.Type == CommandType::EndRepeat)
+            {
+                if (--LoopRemaining[command.Flags] > 0)
+                    NextCommand(command.Args[0]);
+                else
+                    NextCommand(CurrentCommand + 1);
+            }
+            else
+            {
+                if (ExecuteCommand(command))
+                    NextCommand(CurrentCommand + 1); // Move onto the next instruction.
+                break;
+            }
+        }
 
-                    OptionMenuItem* menuItem = OWDApp->Menu.FindMenuItem(c.MenuPath.c_str());
+        if (CurrentCommand == Script.Commands.size())
+            ScriptState = State::Complete;
+    }
 
-                    if (menuItem)
-                    {
-                        bool success = menuItem->SetValue(c.MenuValue);
-                        if(success)
-                            WriteLog("[OWDScript] ExecuteMenu: %s->%s\n", c.MenuPath.c_str(), c.MenuValue.c_str());
-                        else
-                            WriteLog("[OWDScript] ExecuteMenu: set of option failed: %s -> %s. Is the option available with this build or configuration?\n", c.MenuPath.c_str(), c.MenuValue.c_str());
-                    }
-                    else
-                        WriteLog("[OWDScript] ExecuteMenu: Menu not found: %s -> %s. Is the menu available with this build or configuration?\n", c.MenuPath.c_str(), c.MenuValue.c_str());
+    return ScriptState;
+}
 
-                    CurrentCommand++;
 
-                    break;
-                }
+void OWDScript::NextCommand(size_t index)
+{
+    CurrentCommand = index;
+    CommandStarted = false;
+}
 
-                case CommandType::ExecuteScriptFile:
-                    // This shouldn't happen because we expanded the script file on load.
-                    break;
 
-                case CommandType::SetPose:{
-                    CommandSetPose& c = static_cast<CommandSetPose&>(command);
+bool OWDScript::ExecuteCommand(const Command& command)
+{
+    bool done = true;
+    bool started = CommandStarted;
+    CommandStarted = true;
 
-                        WriteLog("[OWDScript] SetPose (not supported): x:%f y:%f z:%f OriX:%f OriY:%f OriZ:%f\n", 
-                            c.X, c.Y, c.Z, c.OriX, c.OriY, c.OriZ);
+    switch (command.Type)
+    {
+        case CommandType::ExecuteMenu:{
+            const char* menuPath = Script.GetString(command.Args[0]);
+            const char* menuValue = Script.GetString(command.Args[1]);
 
-                    CurrentCommand++; // Move onto the next instruction.
-                    break;
-                }
+            OptionMenuItem* menuItem = OWDApp->Menu.FindMenuItem(menuPath);
 
-                case CommandType::Wait:{
-                    CommandWait& c = static_cast<CommandWait&>(command);
-
-                    if(c.CompletionValue == 0) // If the wait isn't started yet...
-                    {
-                        if (c.WaitUnits == CommandWait::ms)
-                        {
-                            c.CompletionValue = (ovr_GetTimeInSeconds() + (c.WaitAmount / 1000));
-                            WriteLog("[OWDScript] Wait for %f ms started\n", c.WaitAmount);
-                        }
-                        else if(c.WaitUnits == CommandWait::s)
-                        {
-                            c.CompletionValue = (ovr_GetTimeInSeconds() + c.WaitAmount);
-                            WriteLog("[OWDScript] Wait for %f s started\n", c.WaitAmount);
-                        }
-                        else // CommandWait::frames
-                        {
-                            c.CompletionValue = (OWDApp->TotalFrameCounter + c.WaitAmount);
-                            WriteLog("[OWDScript] Wait for %f frame(s) started\n", c.WaitAmount);
-                        }
-                    }
-
-                    if ((c.WaitUnits == CommandWait::ms) || 
-                        (c.WaitUnits == CommandWait::s))
-                    {
-                        if(ovr_GetTimeInSeconds() >= c.CompletionValue) // If done waiting
-                        {
-                            WriteLog("[OWDScript] WaitMs wait for %f %s completed\n", c.WaitAmount, 
-                                (c.WaitUnits == CommandWait::ms) ? "ms" : "s");
-                            CurrentCommand++; // Move onto the next instruction.
-                        }
-                    }
-                    else // CommandWait::frames
-                    {
-                        if(OWDApp->TotalFrameCounter >= c.CompletionValue) // If done waiting
-                        {
-                            WriteLog("[OWDScript] Wait for %u frame(s) completed\n", c.WaitAmount);
-                            CurrentCommand++; // Move onto the next instruction.
-                        }
-                    }
-
-                    break;
-                }
+            if (menuItem)
+            {
+                bool success = menuItem->SetValue(menuValue);
+                if(success)
+                    WriteLog("[OWDScript] ExecuteMenu: %s->%s\n", menuPath, menuValue);
+                else
+                    WriteLog("[OWDScript] ExecuteMenu: set of option failed: %s -> %s. Is the option available with this build or configuration?\n", menuPath, menuValue);
+            }
+            else
+                WriteLog("[OWDScript] ExecuteMenu: Menu not found: %s -> %s. Is the menu available with this build or configuration?\n", menuPath, menuValue);
+            break;
+        }
 
-                case CommandType::Screenshot:{
-                    CommandScreenshot& c = static_cast<CommandScreenshot&>(command);
-                    #ifdef _WIN32
-                    std::string screenshotFilePath(ScriptOutputPath + c.ScreenshotFilePath);
-                    OVR_ASSERT(OWDApp);
-                    OVR_ASSERT(OWDApp->pRender);
-                    bool success = WriteTexture(static_cast<OVR::Render::D3D11::RenderDevice*>(OWDApp->pRender)->Device, 
-                        static_cast<OVR::Render::D3D11::Texture*>(OWDApp->MirrorTexture.GetPtr()), screenshotFilePath);
-                    #else
-                    bool success = false;
-                    #endif
-
-                    WriteLog("[OWDScript] Screenshot: Save to %s %s\n", c.ScreenshotFilePath.c_str(), success ? "succeeded" : "failed");
-                    CurrentCommand++; // Move onto the next instruction.
-                    break;
-                }
+        case CommandType::SetPose:{
+            const float* v = command.Values;
+            const bool stop = (command.Flags != 0);
+
+            // Orientation is yaw, then pitch, then roll, as the player's head turns.
+            OWDApp->ScriptPoseEnabled = !stop;
+            OWDApp->ScriptPose = OVR::Posef(OVR::Quatf(OVR::Axis_Y, OVR::DegreeToRad(v[4])) *
+                                            OVR::Quatf(OVR::Axis_X, OVR::DegreeToRad(v[3])) *
+                                            OVR::Quatf(OVR::Axis_Z, OVR::DegreeToRad(v[5])),
+                                            OVR::Vector3f(v[0], v[1], v[2]));
+            if (stop)
+                WriteLog("[OWDScript] SetPose off\n");
+            else
+                WriteLog("[OWDScript] SetPose: x:%f y:%f z:%f OriX:%f OriY:%f OriZ:%f\n",
+                    v[0], v[1], v[2], v[3], v[4], v[5]);
+            break;
+        }
+
+        case CommandType::Wait:{
+            const double waitAmount = command.Values[0];
 
-                case CommandType::PerfCapture:{
-                    CommandPerfCapture& c = static_cast<CommandPerfCapture&>(command);
-
-                    OVR_ASSERT(c.CaptureCollector);
-
-                    // Prepend the script output path to the relative file path that was specified in the script.
-                    // We do this here instead of earlier because we don't necessarily know the script output
-                    // path at the time we loaded the script.
-                    if((c.CaptureCollector->GetStatus() == PerfCaptureSerializer::Status::None) ||
-                       (c.CaptureCollector->GetStatus() == PerfCaptureSerializer::Status::NotStarted))
-                    {
-                        std::string captureFilePath(ScriptOutputPath + c.CaptureCollector->GetFilePath());
-                        c.CaptureCollector->SetFilePath(captureFilePath);
-                    }
-
-                    auto serializerStatus = c.CaptureCollector->Step(OWDApp->Session);
-
-                    if (serializerStatus == PerfCaptureSerializer::Status::Complete)
-                    {
-                        WriteLog("[OWDScript] PerfCapture to %s completed\n", c.CaptureFilePath.c_str());
-                        CurrentCommand++; // Move onto the next instruction.
-                    }
-                    else if (serializerStatus == PerfCaptureSerializer::Status::Error)
-                    {
-                        WriteLog("[OWDScript] PerfCapture to %s FAILED\n", c.CaptureFilePath.c_str());
-                        CurrentCommand++; // Move onto the next instruction.
-                    }
-                    else if (!c.CaptureStartPrinted && serializerStatus == PerfCaptureSerializer::Status::Started)
-                    {
-                        WriteLog("[OWDScript] PerfCapture to %s started\n", c.CaptureFilePath.c_str());
-                        c.CaptureStartPrinted = true;
-                    }
-
-                    break;
+            if(!started) // If the wait isn't started yet...
+            {
+                if (command.Flags == Units_Ms)
+                {
+                    WaitCompletion = (OWDApp->GetAppSeconds() + (waitAmount / 1000));
+                    WriteLog("[OWDScript] Wait for %f ms started\n", waitAmount);
                 }
+                else if(command.Flags == Units_S)
+                {
+                    WaitCompletion = (OWDApp->GetAppSeconds() + waitAmount);
+                    WriteLog("[OWDScript] Wait for %f s started\n", waitAmount);
+                }
+                else // Units_Frames
+                {
+                    WaitCompletion = (OWDApp->TotalFrameCounter + waitAmount);
+                    WriteLog("[OWDScript] Wait for %f frame(s) started\n", waitAmount);
+                }
+            }
 
-                case CommandType::WriteLog:{
-                    CommandWriteLog& c = static_cast<CommandWriteLog&>(command);
-                    //WriteLog("[OWDScript] WriteLog: %s", c.LogText.c_str()); // This would be redundant.
-                    WriteLog("[OWDScript] %s", c.LogText.c_str());
-                    CurrentCommand++; // Move onto the next instruction.
-                    break;
+            if ((command.Flags == Units_Ms) || 
+                (command.Flags == Units_S))
+            {
+                done = (OWDApp->GetAppSeconds() >= WaitCompletion);
+                if(done)
+                {
+                    WriteLog("[OWDScript] WaitMs wait for %f %s completed\n", waitAmount, 
+                        (command.Flags == Units_Ms) ? "ms" : "s");
                 }
+            }
+            else // Units_Frames
+            {
+                done = (OWDApp->TotalFrameCounter >= WaitCompletion);
+                if(done)
+                    WriteLog("[OWDScript] Wait for %f frame(s) completed\n", waitAmount);
+            }
+            break;
+        }
+
+        case CommandType::Screenshot:{
+            const char* screenshotFile = Script.GetString(command.Args[0]);
+            #ifdef _WIN32
+            std::string screenshotFilePath(ScriptOutputPath + screenshotFile);
+            OVR_ASSERT(OWDApp);
+            OVR_ASSERT(OWDApp->pRender);
+            bool success = WriteTexture(static_cast<OVR::Render::D3D11::RenderDevice*>(OWDApp->pRender)->Device, 
+                static_cast<OVR::Render::D3D11::Texture*>(OWDApp->MirrorTexture.GetPtr()), screenshotFilePath);
+            #else
+            bool success = false;
+            #endif
+
+            WriteLog("[OWDScript] Screenshot: Save to %s %s\n", screenshotFile, success ? "succeeded" : "failed");
+            break;
+        }
 
-                case CommandType::Exit:{
-                    CleanupOWDState();
-                    OWDApp->Exit(Status); // The actual exit will occur in the near future.
-                    WriteLog("[OWDScript] Exit: %d\n", Status);
-                    CurrentCommand++; // Move onto the next instruction.
-                    break;
+        case CommandType::PerfCapture:{
+            const char* captureFile = Script.GetString(command.Args[0]);
+
+            // The capture is created here rather than on load, since we don't necessarily know
+            // the script output path at the time we loaded the script, and a loop may run it again.
+            if (!started)
+            {
+                const uint16_t unitsFlag = command.Flags & CaptureFlag_UnitsMask;
+                PerfCaptureSerializer::Units units = (unitsFlag == Units_Ms) ? PerfCaptureSerializer::Units::ms :
+                                                     (unitsFlag == Units_S) ? PerfCaptureSerializer::Units::s :
+                                                                              PerfCaptureSerializer::Units::frames;
+                Capture = std::make_shared<PerfCaptureSerializer>(command.Values[0], units,
+                                                                  ScriptOutputPath + captureFile,
+                                                                  (command.Flags & CaptureFlag_Resume) != 0);
+                CaptureStartPrinted = false;
+            }
+
+            auto serializerStatus = Capture->Step(OWDApp->Session);
+
+            if (serializerStatus == PerfCaptureSerializer::Status::Complete)
+                WriteLog("[OWDScript] PerfCapture to %s completed\n", captureFile);
+            else if (serializerStatus == PerfCaptureSerializer::Status::Error)
+                WriteLog("[OWDScript] PerfCapture to %s FAILED\n", captureFile);
+            else
+            {
+                if (!CaptureStartPrinted && serializerStatus == PerfCaptureSerializer::Status::Started)
+                {
+                    WriteLog("[OWDScript] PerfCapture to %s started\n", captureFile);
+                    CaptureStartPrinted = true;
                 }
+                done = false;
             }
+
+            if (done)
+                Capture.reset();
+            break;
         }
 
-        if (CurrentCommand == Commands.size())
-            ScriptState = State::Complete;
+        case CommandType::WriteLog:{
+            //WriteLog("[OWDScript] WriteLog: %s", ...); // This would be redundant.
+            WriteLog("[OWDScript] %s", Script.GetString(command.Args[0]));
+            break;
+        }
+
+        case CommandType::Exit:{
+            CleanupOWDState();
+            OWDApp->Exit(Status); // The actual exit will occur in the near future.
+            WriteLog("[OWDScript] Exit: %d\n", Status);
+            break;
+        }
+
+        case CommandType::Repeat:
+        case CommandType::EndRepeat:
+            // Step handles loop control itself.
+            break;
     }
 
-    return ScriptState;
+    return done;
 }
 
 
@@ -24,6 +24,7 @@ limitations under the License.
 #include <stack>
 #include <memory>
 #include <vector>
+#include <stdint.h>
 #include "PerfCapture.h"
 
 class OculusWorldDemoApp;
@@ -38,14 +39,21 @@ class OculusWorldDemoApp;
 //    ExecuteScriptFile <script file path string>                                  Recursively executes another script. If path is relative, then it's relative to parent script path.
 //    SetPose           [<x pos> <y pos> <z pos> <x ori> <y ori> <z ori>] | [off]  Sets the HMD pose meters and degrees, or stops pose control and goes back to HMD-based poses.
 //    Wait              <count> [ms|s|frame|frames]                                Pauses the script until N ms or frames.
-//    PerfCapture       <count> [ms|s|frame|frames] <output file path>             Captures performance stats for specified duration and serializes them out to specified file.
+//    PerfCapture       <count> [ms|s|frame|frames] [resume] <output file path>    Captures performance stats for specified duration and serializes them out to specified file. With resume, an existing capture in the file, even one cut short by a crash, is recovered and appended to.
 //    Screenshot        <output file path>                                         Saves a mirror screenshot to disk. Currently limited to .bmp format.
 //    WriteLog          <string>                                                   Writes to the OWD log.
 //    Exit                                                                         Exits the process with a status code that reflects the script execution state: 0 or -1.
+//    Repeat            <count>                                                    Executes the commands up to the matching EndRepeat count times. Repeats may nest.
+//    EndRepeat                                                                    Ends the innermost Repeat.
 //    //                <comment>                                                  Specifies a comment line
 //
 // A wait for 1 frame results in the script continuing on the next frame (and not the 
-// next script step). Thus a one frame wait is like a single frame no-op.
+// next script step). Thus a one frame wait is like a single frame no-op. Repeat and EndRepeat
+// don't take a step of their own.
+//
+// Scripts are compiled on load into an array of fixed-size commands, with any ExecuteScriptFile
+// expanded in place, and stepping them allocates nothing. "-scriptcompile <path>" saves a loaded
+// script compiled, and a compiled script loads with -scriptfile like a text one.
 //
 // In addition to built in functions, there is some useful scripting functionality available from 
 // the OWD menu system. For example, the "ExecuteMenu Scene Content.Animation Enabled.<true/false>" 
@@ -57,6 +65,12 @@ class OculusWorldDemoApp;
 // Example command line usage:
 //     C:> OculusWorldDemo.exe -scriptfile "C:\SomeDir\SomeScript.txt"
 //
+// Benchmark usage, which also writes frame and GPU pass timing percentiles to a CSV file on exit:
+//     C:> OculusWorldDemo.exe -scriptfile "C:\SomeDir\SomeScript.txt" -benchmark "C:\SomeDir\report.csv"
+// A benchmark renders every frame at a fixed FOV and eye texture size, whatever HMD there is, and
+// its clock, which Wait ms and s go by, advances one display refresh per frame. The head stays at
+// the origin until a SetPose moves it.
+//
 // Example programmatic usage:
 //    OWDScript script;
 //
@@ -87,9 +101,13 @@ public:
     };
 
     // Must call shutdown first if you want to call while a script is already loaded.
+    // LoadScriptFile takes either a text script or one written by SaveCompiledScript.
     bool LoadScriptFile(const char* filePath);
     bool LoadScriptText(const char* scriptText);
 
+    // Writes the loaded script in its compiled form, which loads without parsing.
+    bool SaveCompiledScript(const char* filePath) const;
+
     // Specifies a base diretory path to which script output (e.g. Screenshot) is written.
     bool SetScriptOutputPath(const char* directoryPath);
 
@@ -104,93 +122,94 @@ public:
     State GetState() const;
 
 protected:
-    enum class CommandType {
+    enum class CommandType : uint16_t {
         ExecuteMenu,
-        ExecuteScriptFile,
         SetPose,
         Wait,
         Screenshot,
         WriteLog,
         PerfCapture,
-        Exit
+        Exit,
+        Repeat,
+        EndRepeat
     };
 
+    // Units of Wait and PerfCapture durations.
+    enum Units : uint16_t { Units_None, Units_Ms, Units_S, Units_Frames };
+
+    // Or'd into a PerfCapture command's Flags with its Units.
+    enum CaptureFlags : uint16_t { CaptureFlag_Resume = 0x100, CaptureFlag_UnitsMask = 0xff };
+
+    // A compiled command. Commands are POD records in one array and their strings are in one
+    // blob beside it, so a script costs no allocation per command and is saved and loaded as is.
+    //    Command      Flags              Args                                  Values
+    //    ExecuteMenu                     menu path, value string offsets
+    //    SetPose      1 for off                                                x y z, ori x y z
+    //    Wait         Units                                                    amount
+    //    Screenshot                      file path string offset
+    //    WriteLog                        text string offset
+    //    PerfCapture  Units, CaptureFlag file path string offset               duration
+    //    Exit
+    //    Repeat       loop depth         count, index of its EndRepeat
+    //    EndRepeat    loop depth         index of the loop's first command
     struct Command {
-        CommandType commandType;
+        CommandType Type;
+        uint16_t    Flags;
+        uint32_t    Args[2];
+        float       Values[6];
     };
 
-    struct CommandExecuteMenu : public Command {
-        CommandExecuteMenu() : Command{CommandType::ExecuteMenu}{}
-        std::string MenuPath;  // in a form like "parent.child.size"
-        std::string MenuValue; // in a form like "100.23"
-    };
+    struct Program {
+        std::vector<Command> Commands;
+        std::vector<char>    Strings;       // Nul-terminated, at the offsets commands give.
+        uint32_t             MaxLoopDepth;
 
-    struct CommandExecuteScriptFile : public Command {
-        CommandExecuteScriptFile() : Command{CommandType::ExecuteScriptFile}{}
-        std::string ScriptFilePath;
-    };
+        Program() : Commands(), Strings(), MaxLoopDepth(0) {}
 
-    struct CommandSetPose : public Command {
-        CommandSetPose() : Command{CommandType::SetPose}, X(), Y(), Z(), OriX{}, OriY{}, OriZ{}, stop(false){}
-        float X, Y, Z, OriX, OriY, OriZ;
-        bool stop;
+        uint32_t    AddString(const std::string& str);
+        const char* GetString(uint32_t offset) const { return &Strings[offset]; }
+        void        Clear();
     };
 
-    struct CommandWait : public Command {
-        CommandWait() : Command{CommandType::Wait}, WaitAmount(0.0), WaitUnits(none), CompletionValue(0.0){}
-        double WaitAmount; // Relative amount.
-        enum { none, ms, s, frames } WaitUnits;
-        
-        // State data
-        double CompletionValue;
+    // Compiled script files start with this header, then the commands, then the strings.
+    struct CompiledHeader {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t CommandCount;
+        uint32_t StringBytes;
+        uint32_t MaxLoopDepth;
     };
 
-    struct CommandScreenshot : public Command {
-        CommandScreenshot() : Command{CommandType::Screenshot}{}
-        std::string ScreenshotFilePath;
-    };
-
-    struct CommandPerfCapture : public Command {
-      CommandPerfCapture()
-        : Command{ CommandType::PerfCapture }
-        , CaptureTotalDuration(0.0)
-        , CaptureDurationUnits(PerfCaptureSerializer::Units::none)
-        , CaptureStartPrinted(false)
-        , CaptureCollector() {}
+    static const uint32_t CompiledMagic = 0x5344574F; // "OWDS"
+    static const uint32_t CompiledVersion = 1;
 
-      double CaptureTotalDuration;
-      PerfCaptureSerializer::Units CaptureDurationUnits;
-      std::string CaptureFilePath;
-
-      bool CaptureStartPrinted;
-      std::shared_ptr<PerfCaptureSerializer> CaptureCollector;
-    };
-
-    struct CommandWriteLog : public Command {
-        CommandWriteLog() : Command{CommandType::WriteLog}{}
-        std::string LogText;
-    };
-
-    struct CommandExit : public Command {
-        CommandExit() : Command{CommandType::Exit}{}
-    };
-
-    typedef std::shared_ptr<Command> CommandPtr;
-    typedef std::vector<CommandPtr> CommandVector;
-
-    bool LoadScriptText(const char* scriptText, CommandVector& commands);
-    bool LoadScriptFile(const char* filePath, CommandVector& commands);
-    bool ReadCommandLine(const std::string& line, CommandVector& commands);
+    // openLoops holds the index of each Repeat not yet ended, innermost last.
+    bool LoadScriptText(const char* scriptText, Program& program, std::vector<uint32_t>& openLoops);
+    bool LoadScriptFile(const char* filePath, Program& program, std::vector<uint32_t>& openLoops);
+    bool LoadCompiledScript(const std::string& data, Program& program);
+    bool ReadCommandLine(const std::string& line, Program& program, std::vector<uint32_t>& openLoops);
+    void FinishLoad(bool success, Program& program, const std::vector<uint32_t>& openLoops);
     void CleanupOWDState();
 
+    // Executes the command at CurrentCommand, returning false if it isn't done yet.
+    bool ExecuteCommand(const Command& command);
+    void NextCommand(size_t index);
+
 protected:
     std::string ScriptFile; // May be empty if the script didn't originate from a file.
     std::string ScriptOutputPath; // The base directory to where images, etc. are written.
     State ScriptState;
-    CommandVector Commands;
-    size_t CurrentCommand;  // Index into Commands.
+    Program Script;
+    size_t CurrentCommand;  // Index into Script.Commands.
     int32_t Status; // If the Exit command is called then the exit code is set to this status.
     OculusWorldDemoApp* OWDApp;
+
+    // State of the command at CurrentCommand, reset as the next one starts.
+    bool CommandStarted;
+    double WaitCompletion;
+    std::shared_ptr<PerfCaptureSerializer> Capture;
+    bool CaptureStartPrinted;
+    std::vector<uint32_t> LoopRemaining; // Iterations left per loop depth; sized on load.
 };
 
 
@@ -22,6 +22,7 @@ limitations under the License.
 #include "OculusWorldDemo.h"
 
 #include <algorithm>
+#include <float.h>
 
 // If set, pyramid sides are filled in with a pattern; else the image
 // is minimized to just have lines.
@@ -88,29 +89,25 @@ void LOCAL_AddCylinderVerts(Model* m, Vector3f centre, float radius, float heigh
 }
 
 //-----------------------------------------------------------
-float LOCAL_DistToPlane(Vector3f * p, Vector3f * p0, Vector3f * p1, Vector3f * p2)
+// The plane through p0, p1 and p2 after pose, with the normal inside.
+Vector4f LOCAL_PlaneFromPoints(const Posef& pose, const Vector3f& p0, const Vector3f& p1, const Vector3f& p2)
 {
-	Vector3f q0 = *p1 - *p0;
-	Vector3f q1 = *p2 - *p0;
-	Vector3f c = (q0.Cross(q1)).Normalized();
-	Vector3f q = *p - *p0;
-	return(c.Dot(q));
+	Vector3f normal = pose.Rotation.Rotate(((p1 - p0).Cross(p2 - p0)).Normalized());
+	Vector3f point  = pose.Transform(p0);
+	return Vector4f(normal.x, normal.y, normal.z, -normal.Dot(point));
 }
 
 //-----------------------------------------------------------
-float Tracker::DistToBoundary(Vector3f centreEyePosePos, ovrPosef cameraPose, bool includeTopAndBottom)
+float Tracker::DistToBoundary(Vector3f centreEyePosePos, bool includeTopAndBottom) const
 {
-	// Translate test point back
-	centreEyePosePos = centreEyePosePos - cameraPose.Position;
-	// Rotate test point back
-	centreEyePosePos = (((Quatf)(cameraPose.Orientation)).Inverse()).Rotate(centreEyePosePos);
-
-	float dist = LOCAL_DistToPlane(&centreEyePosePos, &v[0], &v[3], &v[1]); // Front
-	dist = OVRMath_Min(dist, LOCAL_DistToPlane(&centreEyePosePos, &v[5], &v[6], &v[4]));// Back
-	dist = OVRMath_Min(dist, LOCAL_DistToPlane(&centreEyePosePos, &v[4], &v[2], &v[0]));// Left
-	dist = OVRMath_Min(dist, LOCAL_DistToPlane(&centreEyePosePos, &v[1], &v[7], &v[5]));// Right
-	if (includeTopAndBottom) dist = OVRMath_Min(dist, LOCAL_DistToPlane(&centreEyePosePos, &v[4], &v[1], &v[5]));// Top
-	if (includeTopAndBottom) dist = OVRMath_Min(dist, LOCAL_DistToPlane(&centreEyePosePos, &v[2], &v[7], &v[3]));// Bottom
+	int planeCount = includeTopAndBottom ? 6 : 4;
+	float dist = FLT_MAX;
+	for (int i = 0; i < planeCount; i++)
+	{
+		const Vector4f& plane = BoundaryPlanes[i];
+		dist = OVRMath_Min(dist, plane.x * centreEyePosePos.x + plane.y * centreEyePosePos.y +
+		                         plane.z * centreEyePosePos.z + plane.w);
+	}
 	return(dist);
 }
 
@@ -186,6 +183,21 @@ void Tracker::AddTrackerConeVerts(ovrSession Session, Model* m, bool isItEdges)
 }
 
 
+//------------------------------------------------------
+void LOCAL_AppendModel(Model* dst, const Model* src, const Matrix4f& mat)
+{
+	uint32_t base = dst->GetNextVertexIndex();
+	for (size_t i = 0; i < src->Vertices.size(); i++)
+	{
+		Vertex vert = src->Vertices[i];
+		vert.Pos = mat.Transform(vert.Pos);
+		dst->AddVertex(vert);
+	}
+	for (size_t i = 0; i < src->Indices.size(); i++)
+		dst->Indices.push_back(base + src->Indices[i]);
+}
+
+
 //------------------------------------------------------
 void LOCAL_RenderModelWithAlpha(RenderDevice* pRender, Model * m, Matrix4f mat)
 {
@@ -251,6 +263,10 @@ void Tracker::Init(ovrSession Session, std::string mainFilePathNoExtension, Rend
 	TrackerLinesModel = *new Model(Prim_Lines);
 	TrackerLinesModel->Fill = wireFill;
 	AddTrackerConeVerts(Session, TrackerLinesModel, true);
+
+	TrackerPlacedModel.Clear();
+	TrackerPose = ovrTrackerPose();
+	Tracked = false;
 }
 
 //----------------------------------------------------------------
@@ -261,6 +277,62 @@ void Tracker::Clear(void)
 	TrackerStandModel.Clear();
 	TrackerConeModel.Clear();
 	TrackerLinesModel.Clear();
+	TrackerPlacedModel.Clear();
+}
+
+
+//----------------------------------------------------------------------
+void Tracker::UpdatePlacement(ovrTrackingOrigin TrackingOriginType)
+{
+	const ovrPosef& pose = TrackerPose.Pose;
+	if (TrackerPlacedModel && (PlacedOrigin == TrackingOriginType) &&
+	    !memcmp(&PlacedPose, &pose, sizeof(pose)))
+		return;
+
+	PlacedPose   = pose;
+	PlacedOrigin = TrackingOriginType;
+
+	// Find altitude of stand.
+    // If we are at floor level, display the tracker stand on the physical floor.
+    // If are using eye level coordinate system, just render the standard height of the stalk.
+    float altitudeOfFloorInLocalSpace;
+    if (TrackingOriginType == ovrTrackingOrigin_FloorLevel)
+        altitudeOfFloorInLocalSpace = 0.01f;
+    else
+        altitudeOfFloorInLocalSpace = pose.Position.y - 0.22f;  //0.18f;
+
+	Vector3f localStandPos = Vector3f(pose.Position.x, altitudeOfFloorInLocalSpace, pose.Position.z);
+
+	// Set position of tracker models according to pose.
+	TrackerHeadModel->SetPosition(pose.Position);
+	TrackerHeadModel->SetOrientation(pose.Orientation);
+	
+    // We scale the stalk so that it has correct physical height.
+    Matrix4f stalkScale = Matrix4f::Scaling(1.0f, pose.Position.y - altitudeOfFloorInLocalSpace - 0.0135f, 1.0f);
+    TrackerStalkModel->SetMatrix(Matrix4f::Translation(Vector3f(pose.Position) - Vector3f(0,0.0135f,0)) * stalkScale *
+                                 Matrix4f(TrackerStalkModel->GetOrientation()));
+	
+    TrackerStandModel->SetPosition(localStandPos);
+	TrackerConeModel->SetPosition(pose.Position);
+	TrackerConeModel->SetOrientation(pose.Orientation);
+	TrackerLinesModel->SetPosition(pose.Position);
+	TrackerLinesModel->SetOrientation(pose.Orientation);
+
+	// The line models share a fill, so placed together they draw at once.
+	TrackerPlacedModel = *new Model(Prim_Lines);
+	TrackerPlacedModel->Fill = TrackerLinesModel->Fill;
+	LOCAL_AppendModel(TrackerPlacedModel, TrackerStandModel, TrackerStandModel->GetMatrix());
+	LOCAL_AppendModel(TrackerPlacedModel, TrackerStalkModel, TrackerStalkModel->GetMatrix());
+	LOCAL_AppendModel(TrackerPlacedModel, TrackerHeadModel, TrackerHeadModel->GetMatrix());
+	LOCAL_AppendModel(TrackerPlacedModel, TrackerLinesModel, TrackerLinesModel->GetMatrix());
+
+	Posef trackerPose = pose;
+	BoundaryPlanes[0] = LOCAL_PlaneFromPoints(trackerPose, v[0], v[3], v[1]); // Front
+	BoundaryPlanes[1] = LOCAL_PlaneFromPoints(trackerPose, v[5], v[6], v[4]); // Back
+	BoundaryPlanes[2] = LOCAL_PlaneFromPoints(trackerPose, v[4], v[2], v[0]); // Left
+	BoundaryPlanes[3] = LOCAL_PlaneFromPoints(trackerPose, v[1], v[7], v[5]); // Right
+	BoundaryPlanes[4] = LOCAL_PlaneFromPoints(trackerPose, v[4], v[1], v[5]); // Top
+	BoundaryPlanes[5] = LOCAL_PlaneFromPoints(trackerPose, v[2], v[7], v[3]); // Bottom
 }
 
 
@@ -284,47 +356,25 @@ void Tracker::Draw(ovrSession Session, RenderDevice* pRender, Player ThePlayer,
 	Vector3f viewPos = EyeRenderPose[eye].Position;
 	Matrix4f localViewMat = Matrix4f::LookAtRH(viewPos, viewPos + forward, up);
 
-	// Get some useful values about the situation
-	Vector3f          headWorldPos  = ThePlayer.GetHeadPosition(TrackingOriginType);
-	ovrTrackerPose    trackerPose   = ovr_GetTrackerPose(Session, 0);
+	// Get some useful values about the situation.
+	// Both eyes see the same tracker, so only the first of a frame asks for it.
+	if (eye == 0 || !TrackerPlacedModel)
+	{
+		TrackerPose = ovr_GetTrackerPose(Session, 0);
+		double            ftiming       = ovr_GetPredictedDisplayTime(Session, 0);
+		ovrTrackingState  trackingState = ovr_GetTrackingState(Session, ftiming, ovrTrue);
+		Tracked = trackingState.StatusFlags & ovrStatus_PositionTracked ? true : false;
+	}
 	Vector3f          centreEyePos  = ((Vector3f)(EyeRenderPose[0].Position) + (Vector3f)(EyeRenderPose[1].Position))*0.5f;
-	double            ftiming       = ovr_GetPredictedDisplayTime(Session, 0);
-	ovrTrackingState  trackingState = ovr_GetTrackingState(Session, ftiming, ovrTrue);
-	bool              tracked       = trackingState.StatusFlags & ovrStatus_PositionTracked ? true : false;
-
-	// Find altitude of stand.
-    // If we are at floor level, display the tracker stand on the physical floor.
-    // If are using eye level coordinate system, just render the standard height of the stalk.
-    float altitudeOfFloorInLocalSpace;
-    if (TrackingOriginType == ovrTrackingOrigin_FloorLevel)
-        altitudeOfFloorInLocalSpace = 0.01f;
-    else
-        altitudeOfFloorInLocalSpace = trackerPose.Pose.Position.y - 0.22f;  //0.18f;
-
-	Vector3f localStandPos = Vector3f(trackerPose.Pose.Position.x, altitudeOfFloorInLocalSpace,
-                                      trackerPose.Pose.Position.z);
-
-	// Set position of tracker models according to pose.
-	TrackerHeadModel->SetPosition(trackerPose.Pose.Position);
-	TrackerHeadModel->SetOrientation(trackerPose.Pose.Orientation);
-	
-    // We scale the stalk so that it has correct physical height.
-    Matrix4f stalkScale = Matrix4f::Scaling(1.0f, trackerPose.Pose.Position.y - altitudeOfFloorInLocalSpace - 0.0135f, 1.0f);
-    TrackerStalkModel->SetMatrix(Matrix4f::Translation(Vector3f(trackerPose.Pose.Position) - Vector3f(0,0.0135f,0)) * stalkScale *
-                                 Matrix4f(TrackerStalkModel->GetOrientation()));
-	
-    TrackerStandModel->SetPosition(localStandPos);
-	TrackerConeModel->SetPosition(trackerPose.Pose.Position);
-	TrackerConeModel->SetOrientation(trackerPose.Pose.Orientation);
-	TrackerLinesModel->SetPosition(trackerPose.Pose.Position);
-	TrackerLinesModel->SetOrientation(trackerPose.Pose.Orientation);
+	bool              tracked       = Tracked;
 
+	UpdatePlacement(TrackingOriginType);
 
     if (trackerLinesAlwaysVisible)
         pRender->SetDepthMode(false, true);
 
 	// Set rendering tint proportional to proximity, and red if not tracked. 
-	float dist = DistToBoundary(centreEyePos, trackerPose.Pose, true);    
+	float dist = DistToBoundary(centreEyePos, true);
 	 //OVR_DEBUG_LOG(("Dist = %0.3f\n", dist));
     
     // This defines a color ramp at specified distances from the edge.
@@ -375,10 +425,7 @@ void Tracker::Draw(ovrSession Session, RenderDevice* pRender, Player ThePlayer,
         pRender->SetDepthMode(true, true);
 
         // Draw the tracker representation
-        LOCAL_RenderModelWithAlpha(pRender, TrackerStandModel, localViewMat);
-        LOCAL_RenderModelWithAlpha(pRender, TrackerStalkModel, localViewMat);
-        LOCAL_RenderModelWithAlpha(pRender, TrackerHeadModel, localViewMat);
-        LOCAL_RenderModelWithAlpha(pRender, TrackerLinesModel, localViewMat);
+        LOCAL_RenderModelWithAlpha(pRender, TrackerPlacedModel, localViewMat);
         if (drawWalls)
             LOCAL_RenderModelWithAlpha(pRender, TrackerConeModel, localViewMat);
     }
@@ -388,10 +435,7 @@ void Tracker::Draw(ovrSession Session, RenderDevice* pRender, Player ThePlayer,
         globalTint.w = 0.01f;    
     pRender->SetGlobalTint(globalTint);
     pRender->SetDepthMode(false, true);
-    LOCAL_RenderModelWithAlpha(pRender, TrackerStandModel, localViewMat);
-    LOCAL_RenderModelWithAlpha(pRender, TrackerStalkModel, localViewMat);
-    LOCAL_RenderModelWithAlpha(pRender, TrackerHeadModel, localViewMat);
-    LOCAL_RenderModelWithAlpha(pRender, TrackerLinesModel, localViewMat);
+    LOCAL_RenderModelWithAlpha(pRender, TrackerPlacedModel, localViewMat);
     if (drawWalls)
         LOCAL_RenderModelWithAlpha(pRender, TrackerConeModel, localViewMat);
 
@@ -29,13 +29,27 @@ private :
 
 	Vector3f v[9]; // Tracker cone verts, in 3D
 
+	// The head, stalk, stand and cone lines placed for the tracker pose in one model, and the
+	// cone's sides as planes in the tracking space, rebuilt only when the pose or origin changes.
+	Ptr<Model>			TrackerPlacedModel;
+	Vector4f			BoundaryPlanes[6];  // Normal, and offset; front, back, left, right, top, bottom
+	ovrPosef			PlacedPose;
+	ovrTrackingOrigin	PlacedOrigin;
+
+	// Queried for the first eye of a frame, and kept for the second.
+	ovrTrackerPose		TrackerPose;
+	bool				Tracked;
+
+	void UpdatePlacement(ovrTrackingOrigin TrackingOriginType);
+
 public :
 
 	void Init(ovrSession Session, std::string mainFilePathNoExtension, RenderDevice* pRender, bool SrgbRequested, bool AnisotropicSample);
 	void Clear(void);
 	void Draw(ovrSession Session, RenderDevice*       pRender, Player ThePlayer, ovrTrackingOrigin TrackingOriginType,
 		bool Sitting, float ExtraSittingAltitude, Matrix4f * ViewFromWorld, int eye,ovrPosef * EyeRenderPose);
-	float DistToBoundary(Vector3f centreEyePosePos, ovrPosef cameraPose, bool includeTopAndBottom);
+	// From the cached boundary planes; the tracking space position is inside while positive.
+	float DistToBoundary(Vector3f centreEyePosePos, bool includeTopAndBottom) const;
 	void AddTrackerConeVerts(ovrSession Session, Model* m, bool isItEdges);
 };
 
@@ -0,0 +1,341 @@
+/************************************************************************************
+  Filename    :   PerfCaptureAnalyzer.cpp
+  Content     :   Offline analysis of PerfCaptureSerializer captures
+  Created     :   October 14, 2026
+  Notes       :
+    Usage: PerfCaptureAnalyzer <capture> [<baseline capture>] [-csv] [-threshold <percent>]
+
+    Maps a capture written by PerfCaptureSerializer (such as OculusWorldDemo's -perfcapture),
+    and reports what it holds: dropped and compositor-missed frames, ASW activity, and the
+    distributions of app and compositor CPU and GPU times.
+
+    Given a second capture, the two are shown side by side, the second as the baseline. With
+    -threshold, any metric which is marked as gated and is worse than the baseline by more
+    than the given percentage is listed, and the exit code is 3, so that a CI perf run can
+    fail on it.
+
+  Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*************************************************************************************/
+
+#include "PerfCapture.h"
+#include "Kernel/OVR_File.h"
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////
+/// Metrics
+//////////////////////////////////////////////////////////////////////////
+
+struct Metric {
+  std::string Name;
+  double Value;
+  bool Gated; // Higher is worse, and it takes part in -threshold.
+  double Slack; // Absolute changes up to this much are never a regression.
+};
+
+struct Capture {
+  std::vector<ovrPerfStats> Records;
+  uint32_t WriterDroppedCount;
+  std::vector<Metric> Metrics;
+};
+
+// Adds the increase of a counter since the previous frame. The counters restart when another
+// app becomes visible, so a decrease is taken as a restart rather than a negative delta.
+void AddCounterDelta(int current, int& previous, bool& havePrevious, double& total) {
+  if (havePrevious && (current > previous)) {
+    total += current - previous;
+  }
+  previous = current;
+  havePrevious = true;
+}
+
+// Converts seconds to milliseconds, skipping the negative values the SDK uses for unknown.
+void AddTime(float seconds, std::vector<double>& times) {
+  if (seconds >= 0.0f) {
+    times.push_back(seconds * 1000.0);
+  }
+}
+
+// Nearest-rank percentile of sorted values.
+double Percentile(const std::vector<double>& sorted, double percent) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  size_t rank = (size_t)ceil((percent / 100.0) * (double)sorted.size());
+  rank = std::min(std::max(rank, (size_t)1), sorted.size());
+  return sorted[rank - 1];
+}
+
+void AddDistribution(std::vector<Metric>& metrics, const char* name, std::vector<double>& times) {
+  std::sort(times.begin(), times.end());
+
+  double sum = 0.0;
+  for (double time : times) {
+    sum += time;
+  }
+
+  const std::string prefix(name);
+  const double slack = 0.1; // ms
+  metrics.push_back({prefix + "_mean_ms", times.empty() ? 0.0 : (sum / times.size()), true, slack});
+  metrics.push_back({prefix + "_p50_ms", Percentile(times, 50.0), true, slack});
+  metrics.push_back({prefix + "_p90_ms", Percentile(times, 90.0), true, slack});
+  metrics.push_back({prefix + "_p99_ms", Percentile(times, 99.0), true, slack});
+  metrics.push_back({prefix + "_max_ms", times.empty() ? 0.0 : times.back(), false, slack});
+}
+
+// Walks every compositor frame in the capture once. Each record holds the frames completed
+// since the previous poll, newest first, and may repeat frames an earlier record already held.
+// App times are taken once per app frame, as a frame the compositor reprojected repeats them.
+void Analyze(Capture& capture) {
+  int lastCompositorFrame = -1;
+  int lastAppFrame = -1;
+  double frameCount = 0.0;
+  double aswActiveFrames = 0.0;
+  double lostFrameStatsRecords = 0.0;
+  double appDropped = 0.0, compositorDropped = 0.0;
+  double aswToggles = 0.0, aswPresented = 0.0, aswFailed = 0.0;
+  int previous[5] = {};
+  bool havePrevious[5] = {};
+  ovrProcessId previousProcessId = (ovrProcessId)-1;
+
+  std::vector<double> appCpu, appGpu, appLatency, compositorCpu, compositorGpu, gpuEndToVsync;
+
+  for (const ovrPerfStats& record : capture.Records) {
+    if (record.AnyFrameStatsDropped) {
+      lostFrameStatsRecords += 1.0;
+    }
+
+    // Counters of one app aren't comparable with another's.
+    if (record.VisibleProcessId != previousProcessId) {
+      std::fill(havePrevious, havePrevious + 5, false);
+      previousProcessId = record.VisibleProcessId;
+    }
+
+    const int statsCount =
+        std::min(std::max(record.FrameStatsCount, 0), (int)ovrMaxProvidedFrameStats);
+    for (int i = statsCount - 1; i >= 0; --i) {
+      const ovrPerfStatsPerCompositorFrame& frame = record.FrameStats[i];
+      if (frame.CompositorFrameIndex <= lastCompositorFrame) {
+        continue;
+      }
+      lastCompositorFrame = frame.CompositorFrameIndex;
+      frameCount += 1.0;
+
+      AddCounterDelta(frame.AppDroppedFrameCount, previous[0], havePrevious[0], appDropped);
+      AddCounterDelta(
+          frame.CompositorDroppedFrameCount, previous[1], havePrevious[1], compositorDropped);
+      AddCounterDelta(frame.AswActivatedToggleCount, previous[2], havePrevious[2], aswToggles);
+      AddCounterDelta(frame.AswPresentedFrameCount, previous[3], havePrevious[3], aswPresented);
+      AddCounterDelta(frame.AswFailedFrameCount, previous[4], havePrevious[4], aswFailed);
+
+      if (frame.AswIsActive) {
+        aswActiveFrames += 1.0;
+      }
+
+      AddTime(frame.CompositorCpuElapsedTime, compositorCpu);
+      AddTime(frame.CompositorGpuElapsedTime, compositorGpu);
+      AddTime(frame.CompositorGpuEndToVsyncElapsedTime, gpuEndToVsync);
+
+      if (frame.AppFrameIndex != lastAppFrame) {
+        lastAppFrame = frame.AppFrameIndex;
+        AddTime(frame.AppCpuElapsedTime, appCpu);
+        AddTime(frame.AppGpuElapsedTime, appGpu);
+        AddTime(frame.AppMotionToPhotonLatency, appLatency);
+      }
+    }
+  }
+
+  // Counts are also given as a percentage of frames, so captures of different lengths compare.
+  const double percentScale = (frameCount > 0.0) ? (100.0 / frameCount) : 0.0;
+  std::vector<Metric>& metrics = capture.Metrics;
+  metrics.push_back({"records", (double)capture.Records.size(), false, 0.0});
+  metrics.push_back({"records_dropped_by_writer", (double)capture.WriterDroppedCount, false, 0.0});
+  metrics.push_back({"records_with_lost_frame_stats", lostFrameStatsRecords, false, 0.0});
+  metrics.push_back({"compositor_frames", frameCount, false, 0.0});
+  metrics.push_back({"app_dropped_frames", appDropped, false, 0.0});
+  metrics.push_back({"app_dropped_pct", appDropped * percentScale, true, 0.1});
+  metrics.push_back({"compositor_missed_frames", compositorDropped, false, 0.0});
+  metrics.push_back({"compositor_missed_pct", compositorDropped * percentScale, true, 0.1});
+  metrics.push_back({"asw_active_pct", aswActiveFrames * percentScale, true, 0.1});
+  metrics.push_back({"asw_activations", aswToggles, false, 0.0});
+  metrics.push_back({"asw_presented_frames", aswPresented, false, 0.0});
+  metrics.push_back({"asw_failed_frames", aswFailed, false, 0.0});
+  metrics.push_back({"asw_failed_pct", aswFailed * percentScale, true, 0.1});
+
+  AddDistribution(metrics, "app_cpu", appCpu);
+  AddDistribution(metrics, "app_gpu", appGpu);
+  AddDistribution(metrics, "app_motion_to_photon", appLatency);
+  AddDistribution(metrics, "compositor_cpu", compositorCpu);
+  AddDistribution(metrics, "compositor_gpu", compositorGpu);
+  AddDistribution(metrics, "compositor_gpu_end_to_vsync", gpuEndToVsync);
+}
+
+bool LoadCapture(const char* path, Capture& capture) {
+  OVR::MappedFile file;
+  if (!file.Open(path)) {
+    fprintf(stderr, "Can't open %s\n", path);
+    return false;
+  }
+
+  if (!PerfCaptureSerializer::Deserialize(
+          file.GetData(),
+          (size_t)file.LGetLength(),
+          capture.Records,
+          &capture.WriterDroppedCount)) {
+    fprintf(stderr, "%s isn't a capture from this SDK version\n", path);
+    return false;
+  }
+
+  Analyze(capture);
+  return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Output
+//////////////////////////////////////////////////////////////////////////
+
+void PrintCapture(const Capture& capture, bool csv) {
+  if (csv) {
+    printf("metric,value\n");
+  }
+  for (const Metric& metric : capture.Metrics) {
+    if (csv) {
+      printf("%s,%.4f\n", metric.Name.c_str(), metric.Value);
+    } else {
+      printf("%-36s %12.3f\n", metric.Name.c_str(), metric.Value);
+    }
+  }
+}
+
+// Prints the captures side by side, and returns the number of gated metrics in which capture
+// is worse than baseline by more than threshold percent, if threshold isn't negative.
+int PrintComparison(const Capture& capture, const Capture& baseline, bool csv, double threshold) {
+  int regressionCount = 0;
+
+  if (csv) {
+    printf("metric,baseline,value,delta_pct,regressed\n");
+  } else {
+    printf("%-36s %12s %12s %9s\n", "Metric", "Baseline", "Capture", "Delta");
+  }
+
+  for (size_t i = 0; i < capture.Metrics.size(); ++i) {
+    const Metric& metric = capture.Metrics[i];
+    const double base = baseline.Metrics[i].Value;
+    const double delta = metric.Value - base;
+    const bool hasPercent = (base != 0.0);
+    const double deltaPercent = hasPercent ? (delta * 100.0 / fabs(base)) : 0.0;
+
+    const bool regressed = metric.Gated && (threshold >= 0.0) && (delta > metric.Slack) &&
+        (!hasPercent || (deltaPercent > threshold));
+    if (regressed) {
+      ++regressionCount;
+    }
+
+    if (csv) {
+      // delta_pct is left empty when the baseline is 0.
+      char deltaText[32] = "";
+      if (hasPercent) {
+        snprintf(deltaText, sizeof(deltaText), "%.2f", deltaPercent);
+      }
+      printf(
+          "%s,%.4f,%.4f,%s,%d\n",
+          metric.Name.c_str(),
+          base,
+          metric.Value,
+          deltaText,
+          regressed ? 1 : 0);
+    } else if (hasPercent) {
+      printf(
+          "%-36s %12.3f %12.3f %+8.1f%%%s\n",
+          metric.Name.c_str(),
+          base,
+          metric.Value,
+          deltaPercent,
+          regressed ? "  REGRESSED" : "");
+    } else {
+      printf(
+          "%-36s %12.3f %12.3f %9s%s\n",
+          metric.Name.c_str(),
+          base,
+          metric.Value,
+          "",
+          regressed ? "  REGRESSED" : "");
+    }
+  }
+
+  return regressionCount;
+}
+
+void PrintUsage() {
+  printf("Usage: PerfCaptureAnalyzer <capture> [<baseline capture>] [-csv] [-threshold <percent>]\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  const char* paths[2] = {nullptr, nullptr};
+  int pathCount = 0;
+  bool csv = false;
+  double threshold = -1.0;
+
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "-csv")) {
+      csv = true;
+    } else if (!strcmp(argv[i], "-threshold") && ((i + 1) < argc)) {
+      threshold = std::max(0.0, atof(argv[++i]));
+    } else if ((argv[i][0] != '-') && (pathCount < 2)) {
+      paths[pathCount++] = argv[i];
+    } else {
+      PrintUsage();
+      return 1;
+    }
+  }
+
+  if (!pathCount) {
+    PrintUsage();
+    return 1;
+  }
+
+  Capture capture = {};
+  if (!LoadCapture(paths[0], capture)) {
+    return 2;
+  }
+
+  if (pathCount == 1) {
+    PrintCapture(capture, csv);
+    return 0;
+  }
+
+  Capture baseline = {};
+  if (!LoadCapture(paths[1], baseline)) {
+    return 2;
+  }
+
+  const int regressionCount = PrintComparison(capture, baseline, csv, threshold);
+  if (regressionCount) {
+    fprintf(stderr, "%d metric(s) regressed by more than %.1f%%\n", regressionCount, threshold);
+    return 3;
+  }
+
+  return 0;
+}
@@ -0,0 +1,642 @@
+/************************************************************************************
+  Filename    :   TextureConverter.cpp
+  Content     :   Offline conversion of TGA textures to BC7 DDS files
+  Created     :   October 14, 2026
+  Notes       :
+    Usage: TextureConverter <file.tga | directory>...
+
+    Writes a DDS file next to each TGA given, or each TGA in each directory given, holding the
+    image as BC7 with its whole mip chain. The mips are box filtered the same way the renderers
+    filter them when they generate mips for a TGA at load time.
+
+    LoadTextureTgaTopDown uses the DDS in place of the TGA when it exists and the load doesn't
+    change the image (no alpha override, premultiplication or HDCP), so converting the TGAs in
+    Assets/Tuscany is all it takes for OculusWorldDemo to use them. The DDS is a quarter of the
+    RGBA size and needs no decoding or mip generation.
+
+    Each block is encoded in BC7 mode 6, one RGBA line with 16 steps, or for blocks with alpha
+    in mode 5 if that's closer, which puts alpha on a line of its own. Lines start along the
+    principal axis of the block's values and are then refit by least squares to their steps.
+
+  Copyright   :   Copyright (c) Facebook Technologies, LLC and its affiliates. All rights reserved.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*************************************************************************************/
+
+#include <algorithm>
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////
+/// Images
+//////////////////////////////////////////////////////////////////////////
+
+struct Image {
+  int Width;
+  int Height;
+  std::vector<uint8_t> Rgba; // Top row first, as LoadTextureTgaTopDown lays it out.
+};
+
+bool ReadFileBytes(const char* path, std::vector<uint8_t>& bytes) {
+  FILE* f = fopen(path, "rb");
+  if (!f) {
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  const long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  bytes.resize(size > 0 ? (size_t)size : 0);
+  const bool ok = (size > 0) && (fread(bytes.data(), 1, bytes.size(), f) == bytes.size());
+  fclose(f);
+  return ok;
+}
+
+// Reads the uncompressed 24 and 32 bit TGAs that LoadTextureTgaTopDown reads, with the same row
+// order, and alpha 255 where it would substitute its alpha argument.
+bool LoadTga(const char* path, Image& image) {
+  std::vector<uint8_t> file;
+  if (!ReadFileBytes(path, file) || (file.size() < 18)) {
+    fprintf(stderr, "%s: can't read\n", path);
+    return false;
+  }
+
+  const uint8_t* h = file.data();
+  const int descLength = h[0];
+  const int imageType = h[2];
+  const int paletteCount = h[5] | (h[6] << 8);
+  const int paletteBits = h[7];
+  const int width = h[12] | (h[13] << 8);
+  const int height = h[14] | (h[15] << 8);
+  const int bpp = h[16];
+  const int descByte = h[17];
+  const int pixelSize = bpp / 8;
+
+  if ((imageType != 2) || ((bpp != 24) && (bpp != 32)) || !width || !height) {
+    fprintf(stderr, "%s: only uncompressed 24 and 32 bit TGAs are supported\n", path);
+    return false;
+  }
+
+  const size_t offset = 18 + descLength + ((paletteCount * (paletteBits + 7)) >> 3);
+  if (file.size() < offset + (size_t)width * height * pixelSize) {
+    fprintf(stderr, "%s: truncated\n", path);
+    return false;
+  }
+
+  const bool bottomUp = (descByte & 0x10) != 0;
+  image.Width = width;
+  image.Height = height;
+  image.Rgba.resize((size_t)width * height * 4);
+
+  const uint8_t* src = file.data() + offset;
+  for (int row = 0; row < height; ++row) {
+    const int y = bottomUp ? row : (height - 1 - row);
+    uint8_t* dest = &image.Rgba[(size_t)y * width * 4];
+    for (int x = 0; x < width; ++x, src += pixelSize, dest += 4) {
+      dest[0] = src[2];
+      dest[1] = src[1];
+      dest[2] = src[0];
+      dest[3] = (pixelSize == 4) ? src[3] : 255;
+    }
+  }
+  return true;
+}
+
+// Halves the image with a 2x2 box filter, like FilterRgba2x2 in the renderers. An odd last row
+// or column is dropped, and a side of 1 stays 1.
+Image MakeMip(const Image& src) {
+  Image mip;
+  mip.Width = std::max(1, src.Width / 2);
+  mip.Height = std::max(1, src.Height / 2);
+  mip.Rgba.resize((size_t)mip.Width * mip.Height * 4);
+
+  for (int y = 0; y < mip.Height; ++y) {
+    const int y0 = std::min(y * 2, src.Height - 1);
+    const int y1 = std::min(y * 2 + 1, src.Height - 1);
+    for (int x = 0; x < mip.Width; ++x) {
+      const int x0 = std::min(x * 2, src.Width - 1);
+      const int x1 = std::min(x * 2 + 1, src.Width - 1);
+      for (int c = 0; c < 4; ++c) {
+        const int sum = src.Rgba[((size_t)y0 * src.Width + x0) * 4 + c] +
+            src.Rgba[((size_t)y0 * src.Width + x1) * 4 + c] +
+            src.Rgba[((size_t)y1 * src.Width + x0) * 4 + c] +
+            src.Rgba[((size_t)y1 * src.Width + x1) * 4 + c];
+        mip.Rgba[((size_t)y * mip.Width + x) * 4 + c] = (uint8_t)(sum >> 2);
+      }
+    }
+  }
+  return mip;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// BC7
+//////////////////////////////////////////////////////////////////////////
+
+const int Bc7Weights2[4] = {0, 21, 43, 64};
+const int Bc7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+inline int Bc7Interpolate(int e0, int e1, int weight) {
+  return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+// A line through channels [first, first + count) of a block, with the steps along it.
+struct Bc7Line {
+  int First;
+  int Count;
+  const int* Weights;
+  int StepCount;
+};
+
+// Fits a line to the pixels along their principal axis, by power iteration on the covariance.
+void Bc7PrincipalLine(const uint8_t pixels[16][4], const Bc7Line& line, float ends[2][4]) {
+  float mean[4] = {0, 0, 0, 0};
+  for (int p = 0; p < 16; ++p) {
+    for (int c = line.First; c < line.First + line.Count; ++c) {
+      mean[c] += pixels[p][c] * (1.0f / 16.0f);
+    }
+  }
+  float cov[4][4] = {};
+  for (int p = 0; p < 16; ++p) {
+    for (int i = line.First; i < line.First + line.Count; ++i) {
+      for (int j = line.First; j < line.First + line.Count; ++j) {
+        cov[i][j] += (pixels[p][i] - mean[i]) * (pixels[p][j] - mean[j]);
+      }
+    }
+  }
+  float axis[4] = {1, 1, 1, 1};
+  for (int iteration = 0; iteration < 8; ++iteration) {
+    float next[4] = {0, 0, 0, 0};
+    float length = 0.0f;
+    for (int i = line.First; i < line.First + line.Count; ++i) {
+      for (int j = line.First; j < line.First + line.Count; ++j) {
+        next[i] += cov[i][j] * axis[j];
+      }
+      length += next[i] * next[i];
+    }
+    length = sqrtf(length);
+    if (length < 1e-6f) {
+      break;
+    }
+    for (int c = line.First; c < line.First + line.Count; ++c) {
+      axis[c] = next[c] / length;
+    }
+  }
+
+  float tMin = 0.0f, tMax = 0.0f;
+  for (int p = 0; p < 16; ++p) {
+    float t = 0.0f;
+    for (int c = line.First; c < line.First + line.Count; ++c) {
+      t += (pixels[p][c] - mean[c]) * axis[c];
+    }
+    tMin = std::min(tMin, t);
+    tMax = std::max(tMax, t);
+  }
+  for (int c = line.First; c < line.First + line.Count; ++c) {
+    ends[0][c] = mean[c] + axis[c] * tMin;
+    ends[1][c] = mean[c] + axis[c] * tMax;
+  }
+}
+
+// Refits the ends by least squares to the steps chosen for each pixel.
+bool Bc7RefitLine(const uint8_t pixels[16][4], const Bc7Line& line, const int indices[16], float ends[2][4]) {
+  float aa = 0, ab = 0, bb = 0;
+  float ax[4] = {0, 0, 0, 0}, bx[4] = {0, 0, 0, 0};
+  for (int p = 0; p < 16; ++p) {
+    const float w = line.Weights[indices[p]] / 64.0f;
+    aa += (1 - w) * (1 - w);
+    ab += (1 - w) * w;
+    bb += w * w;
+    for (int c = line.First; c < line.First + line.Count; ++c) {
+      ax[c] += (1 - w) * pixels[p][c];
+      bx[c] += w * pixels[p][c];
+    }
+  }
+  const float det = aa * bb - ab * ab;
+  if (fabsf(det) < 1e-6f) {
+    return false;
+  }
+  for (int c = line.First; c < line.First + line.Count; ++c) {
+    ends[0][c] = (ax[c] * bb - bx[c] * ab) / det;
+    ends[1][c] = (bx[c] * aa - ax[c] * ab) / det;
+  }
+  return true;
+}
+
+// Picks the step nearest each pixel given the 8 bit ends, returning the total squared error.
+int Bc7FitIndices(const uint8_t pixels[16][4], const Bc7Line& line, const int ends[2][4], int indices[16]) {
+  int palette[16][4];
+  for (int s = 0; s < line.StepCount; ++s) {
+    for (int c = line.First; c < line.First + line.Count; ++c) {
+      palette[s][c] = Bc7Interpolate(ends[0][c], ends[1][c], line.Weights[s]);
+    }
+  }
+
+  int totalError = 0;
+  for (int p = 0; p < 16; ++p) {
+    int bestError = 0x7fffffff;
+    for (int s = 0; s < line.StepCount; ++s) {
+      int error = 0;
+      for (int c = line.First; c < line.First + line.Count; ++c) {
+        const int d = palette[s][c] - pixels[p][c];
+        error += d * d;
+      }
+      if (error < bestError) {
+        bestError = error;
+        indices[p] = s;
+      }
+    }
+    totalError += bestError;
+  }
+  return totalError;
+}
+
+inline int Bc7Clamp255(float v) {
+  return std::min(255, std::max(0, (int)floorf(v + 0.5f)));
+}
+
+// Quantized ends as stored, plus their 8 bit values.
+struct Bc7Ends {
+  int Stored[2][4];
+  int PBit[2];
+  int Value[2][4];
+};
+
+// Mode 6 ends: 7 bits plus a p-bit per end, choosing the p-bit that suits all its channels.
+void Bc7QuantizeMode6(const float ends[2][4], Bc7Ends& q) {
+  for (int i = 0; i < 2; ++i) {
+    int bestError = 0x7fffffff;
+    for (int p = 0; p < 2; ++p) {
+      int stored[4], error = 0;
+      for (int c = 0; c < 4; ++c) {
+        const int v = Bc7Clamp255(ends[i][c]);
+        stored[c] = std::min(127, (v - p + 1) >> 1);
+        stored[c] = std::max(0, stored[c]);
+        const int d = ((stored[c] << 1) | p) - v;
+        error += d * d;
+      }
+      if (error < bestError) {
+        bestError = error;
+        q.PBit[i] = p;
+        for (int c = 0; c < 4; ++c) {
+          q.Stored[i][c] = stored[c];
+          q.Value[i][c] = (stored[c] << 1) | p;
+        }
+      }
+    }
+  }
+}
+
+// Mode 5 ends: 7 bit color, expanded by repeating the top bit, and 8 bit alpha.
+void Bc7QuantizeMode5(const float ends[2][4], Bc7Ends& q) {
+  for (int i = 0; i < 2; ++i) {
+    q.PBit[i] = 0;
+    for (int c = 0; c < 3; ++c) {
+      q.Stored[i][c] = (Bc7Clamp255(ends[i][c]) * 127 + 127) / 255;
+      q.Value[i][c] = (q.Stored[i][c] << 1) | (q.Stored[i][c] >> 6);
+    }
+    q.Stored[i][3] = q.Value[i][3] = Bc7Clamp255(ends[i][3]);
+  }
+}
+
+// Fits a line and its steps to the block, returning the squared error over the line's channels.
+typedef void (*Bc7Quantizer)(const float ends[2][4], Bc7Ends& q);
+
+int Bc7FitLine(const uint8_t pixels[16][4], const Bc7Line& line, Bc7Quantizer quantize, Bc7Ends& ends, int indices[16]) {
+  float fit[2][4] = {};
+  Bc7PrincipalLine(pixels, line, fit);
+  quantize(fit, ends);
+  int error = Bc7FitIndices(pixels, line, ends.Value, indices);
+
+  for (int iteration = 0; (iteration < 2) && error; ++iteration) {
+    if (!Bc7RefitLine(pixels, line, indices, fit)) {
+      break;
+    }
+    Bc7Ends refit = ends;
+    quantize(fit, refit);
+    int refitIndices[16];
+    const int refitError = Bc7FitIndices(pixels, line, refit.Value, refitIndices);
+    if (refitError >= error) {
+      break;
+    }
+    ends = refit;
+    error = refitError;
+    memcpy(indices, refitIndices, sizeof(refitIndices));
+  }
+
+  // The first pixel's index is stored without its top bit, so it has to be in the lower half.
+  if (indices[0] >= line.StepCount / 2) {
+    for (int c = line.First; c < line.First + line.Count; ++c) {
+      std::swap(ends.Stored[0][c], ends.Stored[1][c]);
+      std::swap(ends.Value[0][c], ends.Value[1][c]);
+    }
+    std::swap(ends.PBit[0], ends.PBit[1]);
+    for (int p = 0; p < 16; ++p) {
+      indices[p] = line.StepCount - 1 - indices[p];
+    }
+  }
+  return error;
+}
+
+void Bc7WriteBits(uint8_t* block, int& bitPos, uint32_t value, int bitCount) {
+  for (int i = 0; i < bitCount; ++i, ++bitPos) {
+    if ((value >> i) & 1) {
+      block[bitPos >> 3] |= (uint8_t)(1 << (bitPos & 7));
+    }
+  }
+}
+
+void Bc7WriteIndices(uint8_t* block, int& bitPos, const int indices[16], int bitCount) {
+  for (int p = 0; p < 16; ++p) {
+    Bc7WriteBits(block, bitPos, indices[p], p ? bitCount : (bitCount - 1));
+  }
+}
+
+// Mode 6: one RGBA line with 16 steps, which suits most opaque blocks.
+int EncodeBc7Mode6(const uint8_t pixels[16][4], uint8_t block[16]) {
+  const Bc7Line line = {0, 4, Bc7Weights4, 16};
+  Bc7Ends ends;
+  int indices[16];
+  const int error = Bc7FitLine(pixels, line, Bc7QuantizeMode6, ends, indices);
+
+  memset(block, 0, 16);
+  int bitPos = 0;
+  Bc7WriteBits(block, bitPos, 1 << 6, 7);
+  for (int c = 0; c < 4; ++c) {
+    Bc7WriteBits(block, bitPos, ends.Stored[0][c], 7);
+    Bc7WriteBits(block, bitPos, ends.Stored[1][c], 7);
+  }
+  Bc7WriteBits(block, bitPos, ends.PBit[0], 1);
+  Bc7WriteBits(block, bitPos, ends.PBit[1], 1);
+  Bc7WriteIndices(block, bitPos, indices, 4);
+  return error;
+}
+
+// Mode 5: separate RGB and alpha lines with 4 steps each, for alpha that doesn't follow color.
+int EncodeBc7Mode5(const uint8_t pixels[16][4], uint8_t block[16]) {
+  const Bc7Line colorLine = {0, 3, Bc7Weights2, 4};
+  const Bc7Line alphaLine = {3, 1, Bc7Weights2, 4};
+  Bc7Ends ends;
+  int colorIndices[16], alphaIndices[16];
+  int error = Bc7FitLine(pixels, colorLine, Bc7QuantizeMode5, ends, colorIndices);
+  Bc7Ends alphaEnds = ends;
+  error += Bc7FitLine(pixels, alphaLine, Bc7QuantizeMode5, alphaEnds, alphaIndices);
+
+  memset(block, 0, 16);
+  int bitPos = 0;
+  Bc7WriteBits(block, bitPos, 1 << 5, 6);
+  Bc7WriteBits(block, bitPos, 0, 2); // No channel rotation
+  for (int c = 0; c < 3; ++c) {
+    Bc7WriteBits(block, bitPos, ends.Stored[0][c], 7);
+    Bc7WriteBits(block, bitPos, ends.Stored[1][c], 7);
+  }
+  Bc7WriteBits(block, bitPos, alphaEnds.Stored[0][3], 8);
+  Bc7WriteBits(block, bitPos, alphaEnds.Stored[1][3], 8);
+  Bc7WriteIndices(block, bitPos, colorIndices, 2);
+  Bc7WriteIndices(block, bitPos, alphaIndices, 2);
+  return error;
+}
+
+void EncodeBc7Block(const uint8_t pixels[16][4], uint8_t block[16]) {
+  const int error = EncodeBc7Mode6(pixels, block);
+
+  bool hasAlpha = false;
+  for (int p = 0; p < 16; ++p) {
+    hasAlpha |= (pixels[p][3] != 255);
+  }
+  if (hasAlpha && error) {
+    uint8_t mode5[16];
+    if (EncodeBc7Mode5(pixels, mode5) < error) {
+      memcpy(block, mode5, 16);
+    }
+  }
+}
+
+void EncodeBc7(const Image& image, std::vector<uint8_t>& out) {
+  const int blocksX = (image.Width + 3) / 4;
+  const int blocksY = (image.Height + 3) / 4;
+  const size_t start = out.size();
+  out.resize(start + (size_t)blocksX * blocksY * 16);
+
+  uint8_t* block = &out[start];
+  for (int by = 0; by < blocksY; ++by) {
+    for (int bx = 0; bx < blocksX; ++bx, block += 16) {
+      // Edge blocks repeat the last row and column.
+      uint8_t pixels[16][4];
+      for (int p = 0; p < 16; ++p) {
+        const int x = std::min(bx * 4 + (p & 3), image.Width - 1);
+        const int y = std::min(by * 4 + (p >> 2), image.Height - 1);
+        memcpy(pixels[p], &image.Rgba[((size_t)y * image.Width + x) * 4], 4);
+      }
+      EncodeBc7Block(pixels, block);
+    }
+  }
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// DDS output
+//////////////////////////////////////////////////////////////////////////
+
+const uint32_t DdsFlagsCaps = 0x1;
+const uint32_t DdsFlagsHeight = 0x2;
+const uint32_t DdsFlagsWidth = 0x4;
+const uint32_t DdsFlagsPixelFormat = 0x1000;
+const uint32_t DdsFlagsMipMapCount = 0x20000;
+const uint32_t DdsFlagsLinearSize = 0x80000;
+const uint32_t DdsPixelFormatFourCC = 0x4;
+const uint32_t DdsCapsComplex = 0x8;
+const uint32_t DdsCapsTexture = 0x1000;
+const uint32_t DdsCapsMipMap = 0x400000;
+const uint32_t DxgiFormatBc7Unorm = 98;
+const uint32_t D3d10ResourceDimensionTexture2D = 3;
+
+void AppendUInt32(std::vector<uint8_t>& out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out.push_back((uint8_t)(value >> (i * 8)));
+  }
+}
+
+bool WriteDds(const char* path, const Image& image) {
+  int mipCount = 1;
+  for (int w = image.Width, h = image.Height; (w > 1) || (h > 1); w = std::max(1, w / 2), h = std::max(1, h / 2)) {
+    ++mipCount;
+  }
+
+  std::vector<uint8_t> out;
+  out.push_back('D');
+  out.push_back('D');
+  out.push_back('S');
+  out.push_back(' ');
+
+  // DDS_HEADER
+  AppendUInt32(out, 124);
+  AppendUInt32(
+      out,
+      DdsFlagsCaps | DdsFlagsHeight | DdsFlagsWidth | DdsFlagsPixelFormat | DdsFlagsMipMapCount |
+          DdsFlagsLinearSize);
+  AppendUInt32(out, image.Height);
+  AppendUInt32(out, image.Width);
+  AppendUInt32(out, ((image.Width + 3) / 4) * ((image.Height + 3) / 4) * 16);
+  AppendUInt32(out, 0); // Depth
+  AppendUInt32(out, mipCount);
+  for (int i = 0; i < 11; ++i) {
+    AppendUInt32(out, 0);
+  }
+  // DDS_PIXELFORMAT
+  AppendUInt32(out, 32);
+  AppendUInt32(out, DdsPixelFormatFourCC);
+  out.push_back('D');
+  out.push_back('X');
+  out.push_back('1');
+  out.push_back('0');
+  for (int i = 0; i < 5; ++i) {
+    AppendUInt32(out, 0);
+  }
+  AppendUInt32(out, DdsCapsComplex | DdsCapsTexture | DdsCapsMipMap);
+  for (int i = 0; i < 4; ++i) {
+    AppendUInt32(out, 0);
+  }
+
+  // DDS_HEADER_DXT10
+  AppendUInt32(out, DxgiFormatBc7Unorm);
+  AppendUInt32(out, D3d10ResourceDimensionTexture2D);
+  AppendUInt32(out, 0);
+  AppendUInt32(out, 1);
+  AppendUInt32(out, 0);
+
+  Image mip = image;
+  for (int level = 0; level < mipCount; ++level) {
+    if (level) {
+      mip = MakeMip(mip);
+    }
+    EncodeBc7(mip, out);
+  }
+
+  FILE* f = fopen(path, "wb");
+  const bool ok = f && (fwrite(out.data(), 1, out.size(), f) == out.size());
+  if (f) {
+    fclose(f);
+  }
+  if (!ok) {
+    fprintf(stderr, "%s: can't write\n", path);
+  }
+  return ok;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Files
+//////////////////////////////////////////////////////////////////////////
+
+bool HasTgaExtension(const std::string& path) {
+  if (path.size() < 4) {
+    return false;
+  }
+  std::string ext = path.substr(path.size() - 4);
+  std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+  return ext == ".tga";
+}
+
+bool IsDirectory(const std::string& path) {
+  struct stat st;
+  return (stat(path.c_str(), &st) == 0) && ((st.st_mode & S_IFMT) == S_IFDIR);
+}
+
+void ListTgas(const std::string& directory, std::vector<std::string>& files) {
+  std::vector<std::string> found;
+#if defined(_WIN32)
+  _finddata_t data;
+  const intptr_t find = _findfirst((directory + "\\*.tga").c_str(), &data);
+  if (find != -1) {
+    do {
+      found.push_back(directory + "\\" + data.name);
+    } while (_findnext(find, &data) == 0);
+    _findclose(find);
+  }
+#else
+  if (DIR* dir = opendir(directory.c_str())) {
+    while (dirent* entry = readdir(dir)) {
+      if (HasTgaExtension(entry->d_name)) {
+        found.push_back(directory + "/" + entry->d_name);
+      }
+    }
+    closedir(dir);
+  }
+#endif
+  std::sort(found.begin(), found.end());
+  files.insert(files.end(), found.begin(), found.end());
+}
+
+bool ConvertTga(const std::string& path) {
+  Image image;
+  if (!LoadTga(path.c_str(), image)) {
+    return false;
+  }
+  const std::string ddsPath = path.substr(0, path.size() - 4) + ".dds";
+  if (!WriteDds(ddsPath.c_str(), image)) {
+    return false;
+  }
+  printf("%s -> %s (%dx%d)\n", path.c_str(), ddsPath.c_str(), image.Width, image.Height);
+  return true;
+}
+
+void PrintUsage() {
+  printf("Usage: TextureConverter <file.tga | directory>...\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+    const std::string path = argv[i];
+    if (path[0] == '-') {
+      PrintUsage();
+      return 1;
+    }
+    if (IsDirectory(path)) {
+      ListTgas(path, files);
+    } else if (HasTgaExtension(path)) {
+      files.push_back(path);
+    } else {
+      fprintf(stderr, "%s: not a TGA file or a directory\n", path.c_str());
+      return 2;
+    }
+  }
+
+  if (files.empty()) {
+    PrintUsage();
+    return 1;
+  }
+
+  int failedCount = 0;
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (!ConvertTga(files[i])) {
+      ++failedCount;
+    }
+  }
+  return failedCount ? 2 : 0;
+}